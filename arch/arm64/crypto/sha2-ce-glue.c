@@ -12,6 +12,7 @@
 #include <crypto/internal/simd.h>
 #include <crypto/sha.h>
 #include <crypto/sha256_base.h>
+#include <crypto/sha256_mb.h>
 #include <linux/cpufeature.h>
 #include <linux/crypto.h>
 #include <linux/module.h>
@@ -42,6 +43,9 @@ const u32 sha256_ce_offsetof_count = offsetof(struct sha256_ce_state,
 const u32 sha256_ce_offsetof_finalize = offsetof(struct sha256_ce_state,
 						 finalize);
 
+asmlinkage void sha2_ce_transform2x(u32 *state1, u32 *state2,
+				    u8 const *src1, u8 const *src2, int blocks);
+
 asmlinkage void sha256_block_data_order(u32 *digest, u8 const *src, int blocks);
 
 static void __sha256_block_data_order(struct sha256_state *sst, u8 const *src,
@@ -111,6 +115,74 @@ static int sha256_ce_final(struct shash_desc *desc, u8 *out)
 	return sha256_base_finish(desc, out);
 }
 
+/*
+ * Finish two SHA-256 hashes that share the state @sctx and continue with
+ * messages of the same length, e.g. a salt followed by two data blocks.
+ * Returns false if the NEON unit can't be used here, the caller must hash
+ * the messages one at a time then.
+ */
+bool sha256_finup2x(const struct sha256_state *sctx, const u8 *data1,
+		    const u8 *data2, unsigned int len, u8 *out1, u8 *out2)
+{
+	unsigned int partial = sctx->count % SHA256_BLOCK_SIZE;
+	u64 bits = (sctx->count + len) << 3;
+	u8 buf1[2 * SHA256_BLOCK_SIZE], buf2[2 * SHA256_BLOCK_SIZE];
+	u32 st1[SHA256_DIGEST_SIZE / 4], st2[SHA256_DIGEST_SIZE / 4];
+	unsigned int blocks, i;
+
+	if (!cpu_have_named_feature(SHA2) || !crypto_simd_usable() ||
+	    len < SHA256_BLOCK_SIZE || len > INT_MAX)
+		return false;
+
+	memcpy(st1, sctx->state, sizeof(st1));
+	memcpy(st2, sctx->state, sizeof(st2));
+
+	kernel_neon_begin();
+
+	/* complete the block the shared prefix left partially filled */
+	if (partial) {
+		unsigned int fill = SHA256_BLOCK_SIZE - partial;
+
+		memcpy(buf1, sctx->buf, partial);
+		memcpy(buf1 + partial, data1, fill);
+		memcpy(buf2, sctx->buf, partial);
+		memcpy(buf2 + partial, data2, fill);
+		sha2_ce_transform2x(st1, st2, buf1, buf2, 1);
+		data1 += fill;
+		data2 += fill;
+		len -= fill;
+	}
+
+	blocks = len / SHA256_BLOCK_SIZE;
+	if (blocks) {
+		sha2_ce_transform2x(st1, st2, data1, data2, blocks);
+		data1 += blocks * SHA256_BLOCK_SIZE;
+		data2 += blocks * SHA256_BLOCK_SIZE;
+		len %= SHA256_BLOCK_SIZE;
+	}
+
+	/* the tail, padding and bit count take one or two more blocks */
+	blocks = len + 9 > SHA256_BLOCK_SIZE ? 2 : 1;
+	memset(buf1, 0, blocks * SHA256_BLOCK_SIZE);
+	memcpy(buf1, data1, len);
+	buf1[len] = 0x80;
+	put_unaligned_be64(bits, buf1 + blocks * SHA256_BLOCK_SIZE - 8);
+	memset(buf2, 0, blocks * SHA256_BLOCK_SIZE);
+	memcpy(buf2, data2, len);
+	buf2[len] = 0x80;
+	put_unaligned_be64(bits, buf2 + blocks * SHA256_BLOCK_SIZE - 8);
+	sha2_ce_transform2x(st1, st2, buf1, buf2, blocks);
+
+	kernel_neon_end();
+
+	for (i = 0; i < SHA256_DIGEST_SIZE / 4; i++) {
+		put_unaligned_be32(st1[i], out1 + i * 4);
+		put_unaligned_be32(st2[i], out2 + i * 4);
+	}
+	return true;
+}
+EXPORT_SYMBOL_GPL(sha256_finup2x);
+
 static struct shash_alg algs[] = { {
 	.init			= sha224_base_init,
 	.update			= sha256_ce_update,
@@ -0,0 +1,669 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * App class I/O scheduler for blk-mq, aimed at UFS storage on Android.
+ *
+ * Requests are sorted into three classes when they are allocated:
+ *
+ *  - rt: IOPRIO_CLASS_RT submitters and REQ_PRIO (metadata) requests
+ *  - bg: IOPRIO_CLASS_IDLE submitters and anything issued from a blkio
+ *        cgroup other than the root one, which is where Android places
+ *        background apps
+ *  - fg: everything else
+ *
+ * Each class keeps a sync and an async FIFO. Sync requests are served
+ * ahead of async ones and within each kind the classes are served in
+ * priority order, so an app update in the background cannot push ahead
+ * of a foreground read. Every request carries a deadline (sync_expire or
+ * async_expire) and once any request has expired the one with the oldest
+ * deadline is dispatched first, which bounds how long the background
+ * class and async writes can be starved.
+ *
+ * UFS devices queue deeply and a burst of writes inside the device
+ * delays the reads behind it regardless of host side ordering. While rt
+ * or fg sync requests are in flight, at most fg_async_depth async
+ * requests are allowed in the device.
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/blk-mq.h>
+#include <linux/blk-cgroup.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/ioprio.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+#include <linux/sbitmap.h>
+
+#include "blk.h"
+#include "blk-mq.h"
+#include "blk-mq-debugfs.h"
+#include "blk-mq-tag.h"
+#include "blk-mq-sched.h"
+
+static const int sync_expire = HZ / 4;	/* max time before a sync rq is served */
+static const int async_expire = 2 * HZ;	/* ditto for async requests */
+static const int fg_async_depth = 2;	/* async rqs in flight next to fg reads */
+
+/* Async requests may use at most this share of the scheduler tags */
+#define APPIO_ASYNC_PERCENT	75
+
+enum {
+	APPIO_CLASS_RT,
+	APPIO_CLASS_FG,
+	APPIO_CLASS_BG,
+	APPIO_CLASS_NR,
+};
+
+static const char *const appio_class_names[APPIO_CLASS_NR] = {
+	[APPIO_CLASS_RT] = "rt",
+	[APPIO_CLASS_FG] = "fg",
+	[APPIO_CLASS_BG] = "bg",
+};
+
+enum {
+	APPIO_ASYNC,
+	APPIO_SYNC,
+};
+
+/* Kept in rq->elv.priv[0] */
+#define APPIO_RQ_CLASS_MASK	0x3UL
+#define APPIO_RQ_INFLIGHT	0x4UL
+
+struct appio_stat {
+	atomic64_t count;
+	atomic64_t total_ns;
+	u64 max_ns;
+};
+
+struct appio_data {
+	struct list_head fifo[APPIO_CLASS_NR][2];
+	struct list_head dispatch;
+
+	/*
+	 * settings that change how the i/o scheduler behaves
+	 */
+	int fifo_expire[2];
+	int fg_async_depth;
+
+	unsigned int async_depth;
+	atomic_t fg_sync_inflight;
+	atomic_t async_inflight;
+
+	/* protected by lock */
+	u64 expired;
+	u64 held_back;
+
+	struct appio_stat stats[APPIO_CLASS_NR][2];
+
+	spinlock_t lock;
+};
+
+static int appio_classify(unsigned int opf, struct bio *bio)
+{
+	int ioprio = bio ? bio_prio(bio) : 0;
+
+	if (!ioprio_valid(ioprio))
+		ioprio = get_current_ioprio();
+
+	if (IOPRIO_PRIO_CLASS(ioprio) == IOPRIO_CLASS_RT || (opf & REQ_PRIO))
+		return APPIO_CLASS_RT;
+	if (IOPRIO_PRIO_CLASS(ioprio) == IOPRIO_CLASS_IDLE)
+		return APPIO_CLASS_BG;
+
+#ifdef CONFIG_BLK_CGROUP
+	if (bio_blkcg(bio) && bio_blkcg(bio) != &blkcg_root)
+		return APPIO_CLASS_BG;
+#endif
+	return APPIO_CLASS_FG;
+}
+
+static inline unsigned long appio_rq_priv(struct request *rq)
+{
+	return (unsigned long)rq->elv.priv[0];
+}
+
+static inline int appio_rq_class(struct request *rq)
+{
+	if (!(rq->rq_flags & RQF_ELVPRIV))
+		return APPIO_CLASS_FG;
+	return appio_rq_priv(rq) & APPIO_RQ_CLASS_MASK;
+}
+
+static inline struct list_head *appio_rq_fifo(struct appio_data *ad,
+					      struct request *rq)
+{
+	return &ad->fifo[appio_rq_class(rq)][rq_is_sync(rq)];
+}
+
+/*
+ * remove rq from its fifo and the merge hash
+ */
+static void appio_remove_request(struct request_queue *q, struct request *rq)
+{
+	list_del_init(&rq->queuelist);
+	elv_rqhash_del(q, rq);
+	if (q->last_merge == rq)
+		q->last_merge = NULL;
+}
+
+static void appio_merged_requests(struct request_queue *q, struct request *req,
+				  struct request *next)
+{
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	/*
+	 * if next expires before rq and both sit on the same fifo, take over
+	 * its expire time and position in the fifo
+	 */
+	if (!list_empty(&req->queuelist) && !list_empty(&next->queuelist) &&
+	    appio_rq_fifo(ad, req) == appio_rq_fifo(ad, next)) {
+		if (time_before((unsigned long)next->fifo_time,
+				(unsigned long)req->fifo_time)) {
+			list_move(&req->queuelist, &next->queuelist);
+			req->fifo_time = next->fifo_time;
+		}
+	}
+
+	appio_remove_request(q, next);
+}
+
+static bool appio_allow_merge(struct request_queue *q, struct request *rq,
+			      struct bio *bio)
+{
+	return appio_rq_class(rq) == appio_classify(bio->bi_opf, bio);
+}
+
+/*
+ * Return the request to dispatch next: the one with the oldest deadline if
+ * any has expired, otherwise the head of the first non-empty fifo with
+ * sync before async and rt before fg before bg. Async fifos are only
+ * looked at if @async_ok.
+ */
+static struct request *appio_next_request(struct appio_data *ad,
+					  bool async_ok)
+{
+	int last = async_ok ? APPIO_ASYNC : APPIO_SYNC;
+	struct request *rq, *oldest = NULL;
+	int c, s;
+
+	for (s = APPIO_SYNC; s >= last; s--) {
+		for (c = 0; c < APPIO_CLASS_NR; c++) {
+			if (list_empty(&ad->fifo[c][s]))
+				continue;
+			rq = rq_entry_fifo(ad->fifo[c][s].next);
+			if (!time_after_eq(jiffies, (unsigned long)rq->fifo_time))
+				continue;
+			if (!oldest || time_before((unsigned long)rq->fifo_time,
+					(unsigned long)oldest->fifo_time))
+				oldest = rq;
+		}
+	}
+	if (oldest) {
+		ad->expired++;
+		return oldest;
+	}
+
+	for (s = APPIO_SYNC; s >= last; s--)
+		for (c = 0; c < APPIO_CLASS_NR; c++)
+			if (!list_empty(&ad->fifo[c][s]))
+				return rq_entry_fifo(ad->fifo[c][s].next);
+
+	return NULL;
+}
+
+static bool appio_async_queued(struct appio_data *ad)
+{
+	int c;
+
+	for (c = 0; c < APPIO_CLASS_NR; c++)
+		if (!list_empty(&ad->fifo[c][APPIO_ASYNC]))
+			return true;
+
+	return false;
+}
+
+static void appio_account_dispatch(struct appio_data *ad, struct request *rq)
+{
+	if (!(rq->rq_flags & RQF_ELVPRIV))
+		return;
+
+	if (!rq_is_sync(rq))
+		atomic_inc(&ad->async_inflight);
+	else if (appio_rq_class(rq) != APPIO_CLASS_BG)
+		atomic_inc(&ad->fg_sync_inflight);
+
+	rq->elv.priv[0] = (void *)(appio_rq_priv(rq) | APPIO_RQ_INFLIGHT);
+}
+
+static void appio_account_done(struct appio_data *ad, struct request *rq)
+{
+	unsigned long priv = appio_rq_priv(rq);
+
+	if (!(priv & APPIO_RQ_INFLIGHT))
+		return;
+
+	if (!rq_is_sync(rq))
+		atomic_dec(&ad->async_inflight);
+	else if (appio_rq_class(rq) != APPIO_CLASS_BG)
+		atomic_dec(&ad->fg_sync_inflight);
+
+	rq->elv.priv[0] = (void *)(priv & ~APPIO_RQ_INFLIGHT);
+}
+
+static struct request *__appio_dispatch_request(struct blk_mq_hw_ctx *hctx,
+						struct appio_data *ad)
+{
+	struct request *rq;
+	bool async_ok;
+
+	if (!list_empty(&ad->dispatch)) {
+		rq = list_first_entry(&ad->dispatch, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		goto done;
+	}
+
+	/*
+	 * Keep the device queue shallow for async requests while foreground
+	 * sync requests are in flight. Completion of any of the requests in
+	 * flight reruns the queue.
+	 */
+	async_ok = !atomic_read(&ad->fg_sync_inflight) ||
+		   atomic_read(&ad->async_inflight) < ad->fg_async_depth;
+
+	rq = appio_next_request(ad, async_ok);
+	if (!rq) {
+		if (!async_ok && appio_async_queued(ad)) {
+			ad->held_back++;
+			blk_mq_sched_mark_restart_hctx(hctx);
+		}
+		return NULL;
+	}
+
+	appio_remove_request(rq->q, rq);
+	appio_account_dispatch(ad, rq);
+done:
+	rq->rq_flags |= RQF_STARTED;
+	return rq;
+}
+
+static struct request *appio_dispatch_request(struct blk_mq_hw_ctx *hctx)
+{
+	struct appio_data *ad = hctx->queue->elevator->elevator_data;
+	struct request *rq;
+
+	spin_lock(&ad->lock);
+	rq = __appio_dispatch_request(hctx, ad);
+	spin_unlock(&ad->lock);
+
+	return rq;
+}
+
+static unsigned int appio_async_depth(struct blk_mq_hw_ctx *hctx)
+{
+	return (1U << hctx->sched_tags->bitmap_tags.sb.shift) *
+		APPIO_ASYNC_PERCENT / 100U;
+}
+
+static void appio_depth_updated(struct blk_mq_hw_ctx *hctx)
+{
+	struct appio_data *ad = hctx->queue->elevator->elevator_data;
+
+	ad->async_depth = max(appio_async_depth(hctx), 1U);
+	sbitmap_queue_min_shallow_depth(&hctx->sched_tags->bitmap_tags,
+					ad->async_depth);
+}
+
+static int appio_init_hctx(struct blk_mq_hw_ctx *hctx, unsigned int hctx_idx)
+{
+	appio_depth_updated(hctx);
+	return 0;
+}
+
+static void appio_limit_depth(unsigned int op, struct blk_mq_alloc_data *data)
+{
+	/*
+	 * Async requests must not be able to take all of the scheduler tags,
+	 * or sync requests from the foreground could not even be queued.
+	 */
+	if (!op_is_sync(op)) {
+		struct appio_data *ad = data->q->elevator->elevator_data;
+
+		data->shallow_depth = ad->async_depth;
+	}
+}
+
+static void appio_exit_queue(struct elevator_queue *e)
+{
+	struct appio_data *ad = e->elevator_data;
+	int c;
+
+	for (c = 0; c < APPIO_CLASS_NR; c++) {
+		WARN_ON(!list_empty(&ad->fifo[c][APPIO_SYNC]));
+		WARN_ON(!list_empty(&ad->fifo[c][APPIO_ASYNC]));
+	}
+
+	kfree(ad);
+}
+
+/*
+ * initialize elevator private data (appio_data).
+ */
+static int appio_init_queue(struct request_queue *q, struct elevator_type *e)
+{
+	struct appio_data *ad;
+	struct elevator_queue *eq;
+	int c;
+
+	eq = elevator_alloc(q, e);
+	if (!eq)
+		return -ENOMEM;
+
+	ad = kzalloc_node(sizeof(*ad), GFP_KERNEL, q->node);
+	if (!ad) {
+		kobject_put(&eq->kobj);
+		return -ENOMEM;
+	}
+	eq->elevator_data = ad;
+
+	for (c = 0; c < APPIO_CLASS_NR; c++) {
+		INIT_LIST_HEAD(&ad->fifo[c][APPIO_SYNC]);
+		INIT_LIST_HEAD(&ad->fifo[c][APPIO_ASYNC]);
+	}
+	INIT_LIST_HEAD(&ad->dispatch);
+	ad->fifo_expire[APPIO_SYNC] = sync_expire;
+	ad->fifo_expire[APPIO_ASYNC] = async_expire;
+	ad->fg_async_depth = fg_async_depth;
+	atomic_set(&ad->fg_sync_inflight, 0);
+	atomic_set(&ad->async_inflight, 0);
+	spin_lock_init(&ad->lock);
+
+	q->elevator = eq;
+	return 0;
+}
+
+static bool appio_bio_merge(struct request_queue *q, struct bio *bio,
+			    unsigned int nr_segs)
+{
+	struct appio_data *ad = q->elevator->elevator_data;
+	struct request *free = NULL;
+	bool ret;
+
+	spin_lock(&ad->lock);
+	ret = blk_mq_sched_try_merge(q, bio, nr_segs, &free);
+	spin_unlock(&ad->lock);
+
+	if (free)
+		blk_mq_free_request(free);
+
+	return ret;
+}
+
+static void appio_insert_request(struct blk_mq_hw_ctx *hctx,
+				 struct request *rq, bool at_head)
+{
+	struct request_queue *q = hctx->queue;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	if (blk_mq_sched_try_insert_merge(q, rq))
+		return;
+
+	blk_mq_sched_request_inserted(rq);
+
+	if (at_head || blk_rq_is_passthrough(rq)) {
+		if (at_head)
+			list_add(&rq->queuelist, &ad->dispatch);
+		else
+			list_add_tail(&rq->queuelist, &ad->dispatch);
+		return;
+	}
+
+	if (rq_mergeable(rq)) {
+		elv_rqhash_add(q, rq);
+		if (!q->last_merge)
+			q->last_merge = rq;
+	}
+
+	rq->fifo_time = jiffies + ad->fifo_expire[rq_is_sync(rq)];
+	list_add_tail(&rq->queuelist, appio_rq_fifo(ad, rq));
+}
+
+static void appio_insert_requests(struct blk_mq_hw_ctx *hctx,
+				  struct list_head *list, bool at_head)
+{
+	struct request_queue *q = hctx->queue;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	spin_lock(&ad->lock);
+	while (!list_empty(list)) {
+		struct request *rq;
+
+		rq = list_first_entry(list, struct request, queuelist);
+		list_del_init(&rq->queuelist);
+		appio_insert_request(hctx, rq, at_head);
+	}
+	spin_unlock(&ad->lock);
+}
+
+static void appio_prepare_request(struct request *rq, struct bio *bio)
+{
+	rq->elv.priv[0] = (void *)(unsigned long)appio_classify(rq->cmd_flags,
+								bio);
+}
+
+static void appio_requeue_request(struct request *rq)
+{
+	appio_account_done(rq->q->elevator->elevator_data, rq);
+}
+
+static void appio_finish_request(struct request *rq)
+{
+	appio_account_done(rq->q->elevator->elevator_data, rq);
+}
+
+static void appio_completed_request(struct request *rq, u64 now)
+{
+	struct appio_data *ad = rq->q->elevator->elevator_data;
+	struct appio_stat *st;
+	u64 lat;
+
+	if (!(rq->rq_flags & RQF_ELVPRIV) || now <= rq->start_time_ns)
+		return;
+
+	lat = now - rq->start_time_ns;
+	st = &ad->stats[appio_rq_class(rq)][rq_is_sync(rq)];
+	atomic64_inc(&st->count);
+	atomic64_add(lat, &st->total_ns);
+	if (lat > READ_ONCE(st->max_ns))
+		WRITE_ONCE(st->max_ns, lat);
+}
+
+static bool appio_has_work(struct blk_mq_hw_ctx *hctx)
+{
+	struct appio_data *ad = hctx->queue->elevator->elevator_data;
+	int c;
+
+	if (!list_empty_careful(&ad->dispatch))
+		return true;
+
+	for (c = 0; c < APPIO_CLASS_NR; c++)
+		if (!list_empty_careful(&ad->fifo[c][APPIO_SYNC]) ||
+		    !list_empty_careful(&ad->fifo[c][APPIO_ASYNC]))
+			return true;
+
+	return false;
+}
+
+/*
+ * sysfs parts below
+ */
+#define SHOW_FUNCTION(__FUNC, __VAR, __CONV)				\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct appio_data *ad = e->elevator_data;			\
+	int __data = __VAR;						\
+	if (__CONV)							\
+		__data = jiffies_to_msecs(__data);			\
+	return sprintf(page, "%d\n", __data);				\
+}
+SHOW_FUNCTION(appio_sync_expire_show, ad->fifo_expire[APPIO_SYNC], 1);
+SHOW_FUNCTION(appio_async_expire_show, ad->fifo_expire[APPIO_ASYNC], 1);
+SHOW_FUNCTION(appio_fg_async_depth_show, ad->fg_async_depth, 0);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX, __CONV)			\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct appio_data *ad = e->elevator_data;			\
+	int __data, ret;						\
+	ret = kstrtoint(page, 10, &__data);				\
+	if (ret)							\
+		return ret;						\
+	__data = clamp_t(int, __data, MIN, MAX);			\
+	if (__CONV)							\
+		*(__PTR) = msecs_to_jiffies(__data);			\
+	else								\
+		*(__PTR) = __data;					\
+	return count;							\
+}
+STORE_FUNCTION(appio_sync_expire_store, &ad->fifo_expire[APPIO_SYNC], 0, INT_MAX, 1);
+STORE_FUNCTION(appio_async_expire_store, &ad->fifo_expire[APPIO_ASYNC], 0, INT_MAX, 1);
+STORE_FUNCTION(appio_fg_async_depth_store, &ad->fg_async_depth, 1, INT_MAX, 0);
+#undef STORE_FUNCTION
+
+#define APPIO_ATTR(name) \
+	__ATTR(name, 0644, appio_##name##_show, appio_##name##_store)
+
+static struct elv_fs_entry appio_attrs[] = {
+	APPIO_ATTR(sync_expire),
+	APPIO_ATTR(async_expire),
+	APPIO_ATTR(fg_async_depth),
+	__ATTR_NULL
+};
+
+#ifdef CONFIG_BLK_DEBUG_FS
+static int appio_stats_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	struct appio_data *ad = q->elevator->elevator_data;
+	struct appio_stat *st;
+	u64 count;
+	int c, s;
+
+	for (c = 0; c < APPIO_CLASS_NR; c++) {
+		for (s = APPIO_SYNC; s >= APPIO_ASYNC; s--) {
+			st = &ad->stats[c][s];
+			count = atomic64_read(&st->count);
+			seq_printf(m, "%s %-5s count %llu avg %llu us max %llu us\n",
+				   appio_class_names[c],
+				   s == APPIO_SYNC ? "sync" : "async", count,
+				   count ? div64_u64(atomic64_read(&st->total_ns),
+						     count) / NSEC_PER_USEC : 0,
+				   READ_ONCE(st->max_ns) / NSEC_PER_USEC);
+		}
+	}
+	return 0;
+}
+
+static int appio_state_show(void *data, struct seq_file *m)
+{
+	struct request_queue *q = data;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	spin_lock(&ad->lock);
+	seq_printf(m, "fg_sync_inflight %d\n",
+		   atomic_read(&ad->fg_sync_inflight));
+	seq_printf(m, "async_inflight %d\n", atomic_read(&ad->async_inflight));
+	seq_printf(m, "async_depth %u\n", ad->async_depth);
+	seq_printf(m, "expired %llu\n", ad->expired);
+	seq_printf(m, "held_back %llu\n", ad->held_back);
+	spin_unlock(&ad->lock);
+	return 0;
+}
+
+static void *appio_dispatch_start(struct seq_file *m, loff_t *pos)
+	__acquires(&ad->lock)
+{
+	struct request_queue *q = m->private;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	spin_lock(&ad->lock);
+	return seq_list_start(&ad->dispatch, *pos);
+}
+
+static void *appio_dispatch_next(struct seq_file *m, void *v, loff_t *pos)
+{
+	struct request_queue *q = m->private;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	return seq_list_next(v, &ad->dispatch, pos);
+}
+
+static void appio_dispatch_stop(struct seq_file *m, void *v)
+	__releases(&ad->lock)
+{
+	struct request_queue *q = m->private;
+	struct appio_data *ad = q->elevator->elevator_data;
+
+	spin_unlock(&ad->lock);
+}
+
+static const struct seq_operations appio_dispatch_seq_ops = {
+	.start	= appio_dispatch_start,
+	.next	= appio_dispatch_next,
+	.stop	= appio_dispatch_stop,
+	.show	= blk_mq_debugfs_rq_show,
+};
+
+static const struct blk_mq_debugfs_attr appio_queue_debugfs_attrs[] = {
+	{"stats", 0400, appio_stats_show},
+	{"state", 0400, appio_state_show},
+	{"dispatch", 0400, .seq_ops = &appio_dispatch_seq_ops},
+	{},
+};
+#endif
+
+static struct elevator_type appio_sched = {
+	.ops = {
+		.insert_requests	= appio_insert_requests,
+		.dispatch_request	= appio_dispatch_request,
+		.prepare_request	= appio_prepare_request,
+		.requeue_request	= appio_requeue_request,
+		.finish_request		= appio_finish_request,
+		.completed_request	= appio_completed_request,
+		.limit_depth		= appio_limit_depth,
+		.depth_updated		= appio_depth_updated,
+		.init_hctx		= appio_init_hctx,
+		.bio_merge		= appio_bio_merge,
+		.allow_merge		= appio_allow_merge,
+		.requests_merged	= appio_merged_requests,
+		.has_work		= appio_has_work,
+		.init_sched		= appio_init_queue,
+		.exit_sched		= appio_exit_queue,
+	},
+
+#ifdef CONFIG_BLK_DEBUG_FS
+	.queue_debugfs_attrs = appio_queue_debugfs_attrs,
+#endif
+	.elevator_attrs = appio_attrs,
+	.elevator_name = "appio",
+	.elevator_owner = THIS_MODULE,
+};
+MODULE_ALIAS("appio-iosched");
+
+static int __init appio_init(void)
+{
+	return elv_register(&appio_sched);
+}
+
+static void __exit appio_exit(void)
+{
+	elv_unregister(&appio_sched);
+}
+
+module_init(appio_init);
+module_exit(appio_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("App class IO scheduler");
@@ -276,6 +276,34 @@ int blk_crypto_start_using_mode(enum blk_crypto_mode_num crypto_mode,
 }
 EXPORT_SYMBOL_GPL(blk_crypto_start_using_mode);
 
+/**
+ * blk_crypto_preload_key() - Program a key into inline encryption hardware
+ *			      before it is used
+ * @q: The request queue the key will be used on
+ * @key: The key to program
+ *
+ * Upper layers may call this for keys that will see IO soon, e.g. when a
+ * device-wide key is set up, so the first IO does not have to wait for the key
+ * to be programmed.  It's a hint: it does nothing if the hardware can't take
+ * the key without evicting another one, or if the key is handled by
+ * blk-crypto-fallback.
+ *
+ * Return: 0 on success or if nothing was done, -err on error.
+ */
+int blk_crypto_preload_key(struct request_queue *q,
+			   const struct blk_crypto_key *key)
+{
+	if (q->ksm &&
+	    keyslot_manager_crypto_mode_supported(q->ksm, key->crypto_mode,
+						  blk_crypto_key_dun_bytes(key),
+						  key->data_unit_size,
+						  key->is_hw_wrapped))
+		return keyslot_manager_preload_key(q->ksm, key);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(blk_crypto_preload_key);
+
 /**
  * blk_crypto_evict_key() - Evict a key from any inline encryption hardware
  *			    it may have been programmed into
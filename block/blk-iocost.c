@@ -47,7 +47,9 @@
  * device-specific coefficients.
  *
  * If needed, tools/cgroup/iocost_coef_gen.py can be used to generate
- * device-specific coefficients.
+ * device-specific coefficients.  Alternatively, writing "ctrl=calibrate"
+ * to io.cost.model measures them in the kernel with a short synthetic IO
+ * run, see ioc_calibrate().
  *
  * 2. Control Strategy
  *
@@ -180,6 +182,8 @@
 #include <linux/timer.h>
 #include <linux/time64.h>
 #include <linux/parser.h>
+#include <linux/random.h>
+#include <linux/semaphore.h>
 #include <linux/sched/signal.h>
 #include <linux/blk-cgroup.h>
 #include "blk-rq-qos.h"
@@ -332,6 +336,8 @@ enum {
 enum {
 	COST_CTRL,
 	COST_MODEL,
+	COST_CALIB_START,
+	COST_CALIB_SECTORS,
 	NR_COST_CTRL_PARAMS,
 };
 
@@ -2347,6 +2353,189 @@ static ssize_t ioc_qos_write(struct kernfs_open_file *of, char *input,
 	return ret;
 }
 
+/*
+ * In-kernel cost model calibration, a short version of what
+ * iocost_coef_gen.py does with fio.  Each pattern - 256k sequential, 4k
+ * sequential and 4k random - runs for IOC_CALIB_PHASE_MS at the device
+ * queue depth and the achieved rates become the linear model
+ * coefficients.  Reads are spread over the whole device.  Writes are only
+ * measured when a reserved region is given with calib_start= and
+ * calib_sectors=, and whatever the region holds is overwritten.
+ *
+ * The IOs are issued from the root cgroup so that iocost does not
+ * throttle its own measurement.  Other IO running at the same time skews
+ * the result, so this is meant for first boot or an idle device.
+ */
+#define IOC_CALIB_PHASE_MS	250
+#define IOC_CALIB_BIG_BS	(256 << 10)
+#define IOC_CALIB_MAX_QD	64
+#define IOC_CALIB_MIN_SECTORS	((64 << 20) >> SECTOR_SHIFT)
+
+struct ioc_calib {
+	struct block_device	*bdev;
+	struct page		*pages[IOC_CALIB_BIG_BS >> PAGE_SHIFT];
+	struct semaphore	slots;
+	unsigned int		qd;
+	sector_t		start;
+	sector_t		nr_sects;
+	int			error;
+};
+
+static DEFINE_MUTEX(ioc_calib_mutex);
+
+static void ioc_calib_endio(struct bio *bio)
+{
+	struct ioc_calib *cal = bio->bi_private;
+
+	if (bio->bi_status)
+		WRITE_ONCE(cal->error, blk_status_to_errno(bio->bi_status));
+	bio_put(bio);
+	up(&cal->slots);
+}
+
+/* run one IO pattern and return the achieved IOs per second */
+static u64 ioc_calib_run(struct ioc_calib *cal, unsigned int op,
+			 unsigned int bs, bool seq)
+{
+	unsigned int nr_pages = bs >> PAGE_SHIFT;
+	sector_t sects = bs >> SECTOR_SHIFT;
+	u64 nr_slots = min_t(u64, div_u64(cal->nr_sects, sects), U32_MAX);
+	u64 start = ktime_get_ns(), deadline, nr = 0;
+	sector_t cursor = 0, off;
+	unsigned int i;
+
+	deadline = start + IOC_CALIB_PHASE_MS * NSEC_PER_MSEC;
+
+	while (ktime_get_ns() < deadline && !READ_ONCE(cal->error) &&
+	       !fatal_signal_pending(current)) {
+		struct bio *bio;
+
+		if (seq) {
+			if (cursor + sects > cal->nr_sects)
+				cursor = 0;
+			off = cursor;
+			cursor += sects;
+		} else {
+			off = (sector_t)prandom_u32_max(nr_slots) * sects;
+		}
+
+		down(&cal->slots);
+
+		bio = bio_alloc(GFP_KERNEL, nr_pages);
+		bio_set_dev(bio, cal->bdev);
+		bio_associate_blkg_from_css(bio, blkcg_root_css);
+		bio->bi_iter.bi_sector = cal->start + off;
+		bio->bi_opf = op | REQ_SYNC;
+		bio->bi_end_io = ioc_calib_endio;
+		bio->bi_private = cal;
+		for (i = 0; i < nr_pages; i++)
+			bio_add_page(bio, cal->pages[i], PAGE_SIZE, 0);
+
+		submit_bio(bio);
+		nr++;
+	}
+
+	/* wait for everything in flight by taking all the slots */
+	for (i = 0; i < cal->qd; i++)
+		down(&cal->slots);
+	for (i = 0; i < cal->qd; i++)
+		up(&cal->slots);
+
+	return div64_u64(nr * NSEC_PER_SEC, max(ktime_get_ns() - start, 1ULL));
+}
+
+static void ioc_calib_measure(struct ioc_calib *cal, unsigned int op,
+			      u64 *bps, u64 *seqiops, u64 *randiops)
+{
+	*bps = ioc_calib_run(cal, op, IOC_CALIB_BIG_BS, true) *
+		IOC_CALIB_BIG_BS;
+	*seqiops = ioc_calib_run(cal, op, IOC_PAGE_SIZE, true);
+	*randiops = ioc_calib_run(cal, op, IOC_PAGE_SIZE, false);
+}
+
+/*
+ * Measure the linear model coefficients of @disk into @u.  The write
+ * coefficients are left alone unless a write region is given.
+ */
+static int ioc_calibrate(struct gendisk *disk, sector_t wstart,
+			 sector_t wsects, u64 *u)
+{
+	fmode_t mode = FMODE_READ | (wsects ? FMODE_WRITE : 0);
+	sector_t capacity = get_capacity(disk);
+	u64 r[NR_I_LCOEFS];
+	struct ioc_calib *cal;
+	struct block_device *bdev;
+	unsigned int i;
+	int ret;
+
+	if (wsects && (wsects < IOC_CALIB_MIN_SECTORS ||
+		       wstart + wsects > capacity ||
+		       !IS_ALIGNED(wstart, IOC_PAGE_SIZE >> SECTOR_SHIFT)))
+		return -EINVAL;
+	if (capacity < IOC_CALIB_MIN_SECTORS)
+		return -EINVAL;
+
+	cal = kzalloc(sizeof(*cal), GFP_KERNEL);
+	if (!cal)
+		return -ENOMEM;
+
+	for (i = 0; i < ARRAY_SIZE(cal->pages); i++) {
+		cal->pages[i] = alloc_page(GFP_KERNEL);
+		if (!cal->pages[i]) {
+			ret = -ENOMEM;
+			goto out_free;
+		}
+	}
+
+	bdev = bdget_disk(disk, 0);
+	if (!bdev) {
+		ret = -ENODEV;
+		goto out_free;
+	}
+	ret = blkdev_get(bdev, mode, NULL);
+	if (ret)
+		goto out_free;
+
+	cal->bdev = bdev;
+	cal->qd = clamp_t(unsigned int, blk_queue_depth(disk->queue), 1,
+			  IOC_CALIB_MAX_QD);
+	sema_init(&cal->slots, cal->qd);
+
+	cal->start = 0;
+	cal->nr_sects = capacity;
+	ioc_calib_measure(cal, REQ_OP_READ, &r[I_LCOEF_RBPS],
+			  &r[I_LCOEF_RSEQIOPS], &r[I_LCOEF_RRANDIOPS]);
+
+	if (wsects && !cal->error) {
+		cal->start = wstart;
+		cal->nr_sects = wsects;
+		ioc_calib_measure(cal, REQ_OP_WRITE, &r[I_LCOEF_WBPS],
+				  &r[I_LCOEF_WSEQIOPS], &r[I_LCOEF_WRANDIOPS]);
+	}
+
+	blkdev_put(bdev, mode);
+
+	ret = cal->error;
+	if (!ret && fatal_signal_pending(current))
+		ret = -EINTR;
+	if (ret)
+		goto out_free;
+
+	memcpy(u, r, (wsects ? NR_I_LCOEFS : I_LCOEF_WBPS) * sizeof(*u));
+
+	pr_info("iocost: %s calibrated at qd %u: rbps=%llu rseqiops=%llu rrandiops=%llu wbps=%llu wseqiops=%llu wrandiops=%llu%s\n",
+		disk->disk_name, cal->qd,
+		u[I_LCOEF_RBPS], u[I_LCOEF_RSEQIOPS], u[I_LCOEF_RRANDIOPS],
+		u[I_LCOEF_WBPS], u[I_LCOEF_WSEQIOPS], u[I_LCOEF_WRANDIOPS],
+		wsects ? "" : " (writes not measured)");
+out_free:
+	for (i = 0; i < ARRAY_SIZE(cal->pages); i++)
+		if (cal->pages[i])
+			__free_page(cal->pages[i]);
+	kfree(cal);
+	return ret;
+}
+
 static u64 ioc_cost_model_prfill(struct seq_file *sf,
 				 struct blkg_policy_data *pd, int off)
 {
@@ -2378,6 +2567,8 @@ static int ioc_cost_model_show(struct seq_file *sf, void *v)
 static const match_table_t cost_ctrl_tokens = {
 	{ COST_CTRL,		"ctrl=%s"	},
 	{ COST_MODEL,		"model=%s"	},
+	{ COST_CALIB_START,	"calib_start=%u" },
+	{ COST_CALIB_SECTORS,	"calib_sectors=%u" },
 	{ NR_COST_CTRL_PARAMS,	NULL		},
 };
 
@@ -2397,7 +2588,8 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 	struct gendisk *disk;
 	struct ioc *ioc;
 	u64 u[NR_I_LCOEFS];
-	bool user;
+	u64 calib_start = 0, calib_sectors = 0;
+	bool user, calibrate = false;
 	char *p;
 	int ret;
 
@@ -2434,6 +2626,8 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 				user = false;
 			else if (!strcmp(buf, "user"))
 				user = true;
+			else if (!strcmp(buf, "calibrate"))
+				calibrate = true;
 			else
 				goto einval;
 			continue;
@@ -2442,6 +2636,14 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 			if (strcmp(buf, "linear"))
 				goto einval;
 			continue;
+		case COST_CALIB_START:
+			if (match_u64(&args[0], &calib_start))
+				goto einval;
+			continue;
+		case COST_CALIB_SECTORS:
+			if (match_u64(&args[0], &calib_sectors))
+				goto einval;
+			continue;
 		}
 
 		tok = match_token(p, i_lcoef_tokens, args);
@@ -2453,6 +2655,15 @@ static ssize_t ioc_cost_model_write(struct kernfs_open_file *of, char *input,
 		user = true;
 	}
 
+	if (calibrate) {
+		mutex_lock(&ioc_calib_mutex);
+		ret = ioc_calibrate(disk, calib_start, calib_sectors, u);
+		mutex_unlock(&ioc_calib_mutex);
+		if (ret)
+			goto err;
+		user = true;
+	}
+
 	spin_lock_irq(&ioc->lock);
 	if (user) {
 		memcpy(ioc->params.i_lcoefs, u, sizeof(u));
@@ -369,6 +369,8 @@ static void wb_timer_fn(struct blk_stat_callback *cb)
 	 */
 	switch (status) {
 	case LAT_EXCEEDED:
+		WRITE_ONCE(rwb->rqos.q->backing_dev_info->fg_lat_exceeded,
+			   jiffies);
 		scale_down(rwb, true);
 		break;
 	case LAT_OK:
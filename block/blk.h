@@ -3,6 +3,7 @@
 #define BLK_INTERNAL_H
 
 #include <linux/idr.h>
+#include <linux/sched/topology.h>
 #include <linux/blk-mq.h>
 #include <xen/xen.h>
 #include "blk-mq.h"
@@ -253,6 +254,25 @@ static inline bool blk_do_io_stat(struct request *rq)
 		!blk_rq_is_passthrough(rq);
 }
 
+/*
+ * Whether a request submitted on @ccpu may be completed on @cpu without an
+ * IPI. Sharing the LLC is the default test, but on parts where every
+ * cluster shares one L3 it never sends completions back, leaving all of
+ * them on the single IRQ CPU. QUEUE_FLAG_SAME_CLUSTER redirects anything
+ * submitted from another CPU cluster instead.
+ */
+static inline bool blk_cpus_share_completion(struct request_queue *q,
+					     int cpu, int ccpu)
+{
+	if (test_bit(QUEUE_FLAG_SAME_FORCE, &q->queue_flags))
+		return false;
+
+	if (test_bit(QUEUE_FLAG_SAME_CLUSTER, &q->queue_flags))
+		return cpumask_test_cpu(ccpu, topology_core_cpumask(cpu));
+
+	return cpus_share_cache(cpu, ccpu);
+}
+
 static inline void req_set_nomerge(struct request_queue *q, struct request *req)
 {
 	req->cmd_flags |= REQ_NOMERGE;
@@ -24,10 +24,17 @@
  *
  * Upper layers will call keyslot_manager_get_slot_for_key() to program a
  * key into some slot in the inline encryption hardware.
+ *
+ * When no slot holds the key, empty slots are used first.  After that the
+ * least recently used idle slot is evicted, except that a slot whose key was
+ * reused since it was last looked at gets a second chance.  So a key that
+ * keeps coming back survives a burst of one-off keys.  Keys expected to be
+ * used soon can be programmed ahead of IO with keyslot_manager_preload_key().
  */
 #include <crypto/algapi.h>
 #include <linux/keyslot-manager.h>
 #include <linux/atomic.h>
+#include <linux/ktime.h>
 #include <linux/mutex.h>
 #include <linux/pm_runtime.h>
 #include <linux/wait.h>
@@ -37,6 +44,8 @@ struct keyslot {
 	atomic_t slot_refs;
 	struct list_head idle_slot_node;
 	struct hlist_node hash_node;
+	/* Key found in the slot again since the victim scan last passed it */
+	bool referenced;
 	struct blk_crypto_key key;
 };
 
@@ -70,6 +79,13 @@ struct keyslot_manager {
 	struct hlist_head *slot_hashtable;
 	unsigned int slot_hashtable_size;
 
+	/*
+	 * Usage counters.  Lookups only hold 'lock' for read so 'hits' is
+	 * atomic, the rest is updated with 'lock' held for write.
+	 */
+	atomic64_t hits;
+	struct keyslot_mgmt_stats stats;
+
 	/* Per-keyslot data */
 	struct keyslot slots[];
 };
@@ -231,6 +247,70 @@ hash_bucket_for_key(struct keyslot_manager *ksm,
 				    (ksm->slot_hashtable_size - 1)];
 }
 
+/*
+ * Pick the idle slot to program a new key into.  Empty slots sit at the front
+ * of the idle list.  A referenced slot is moved to the back once, so only keys
+ * that were not reused recently are evicted.  Called with ksm->lock held for
+ * write and the idle list not empty.
+ */
+static struct keyslot *keyslot_manager_pick_victim(struct keyslot_manager *ksm)
+{
+	struct keyslot *slotp;
+	unsigned long flags;
+	unsigned int n;
+
+	spin_lock_irqsave(&ksm->idle_slots_lock, flags);
+	for (n = 0; n < ksm->num_slots; n++) {
+		slotp = list_first_entry(&ksm->idle_slots, struct keyslot,
+					 idle_slot_node);
+		if (!slotp->referenced)
+			break;
+		slotp->referenced = false;
+		list_move_tail(&slotp->idle_slot_node, &ksm->idle_slots);
+	}
+	slotp = list_first_entry(&ksm->idle_slots, struct keyslot,
+				 idle_slot_node);
+	spin_unlock_irqrestore(&ksm->idle_slots_lock, flags);
+
+	return slotp;
+}
+
+/* Program a slot through the driver, with ksm->lock held for write */
+static int keyslot_manager_program(struct keyslot_manager *ksm,
+				   const struct blk_crypto_key *key,
+				   unsigned int slot)
+{
+	ktime_t start = ktime_get();
+	u64 delta;
+	int err;
+
+	err = ksm->ksm_ll_ops.keyslot_program(ksm, key, slot);
+	delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (err) {
+		ksm->stats.program_fail_cnt++;
+		return err;
+	}
+	ksm->stats.program_cnt++;
+	ksm->stats.program_total_ns += delta;
+	ksm->stats.program_max_ns = max(ksm->stats.program_max_ns, delta);
+	return 0;
+}
+
+/* Install a freshly programmed key in its slot's hash bucket */
+static void keyslot_manager_install_key(struct keyslot_manager *ksm,
+					struct keyslot *slotp,
+					const struct blk_crypto_key *key)
+{
+	if (slotp->key.crypto_mode != BLK_ENCRYPTION_MODE_INVALID) {
+		hlist_del(&slotp->hash_node);
+		ksm->stats.replace_cnt++;
+	}
+	hlist_add_head(&slotp->hash_node, hash_bucket_for_key(ksm, key));
+	slotp->key = *key;
+	slotp->referenced = false;
+}
+
 static void remove_slot_from_lru_list(struct keyslot_manager *ksm, int slot)
 {
 	unsigned long flags;
@@ -265,7 +345,9 @@ static int find_and_grab_keyslot(struct keyslot_manager *ksm,
 	slot = find_keyslot(ksm, key);
 	if (slot < 0)
 		return slot;
+	atomic64_inc(&ksm->hits);
 	if (atomic_inc_return(&ksm->slots[slot].slot_refs) == 1) {
+		WRITE_ONCE(ksm->slots[slot].referenced, true);
 		/* Took first reference to this slot; remove it from LRU list */
 		remove_slot_from_lru_list(ksm, slot);
 	}
@@ -316,16 +398,16 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 		if (!list_empty(&ksm->idle_slots))
 			break;
 
+		ksm->stats.wait_cnt++;
 		keyslot_manager_hw_exit(ksm);
 		wait_event(ksm->idle_slots_wait_queue,
 			   !list_empty(&ksm->idle_slots));
 	}
 
-	idle_slot = list_first_entry(&ksm->idle_slots, struct keyslot,
-					     idle_slot_node);
+	idle_slot = keyslot_manager_pick_victim(ksm);
 	slot = idle_slot - ksm->slots;
 
-	err = ksm->ksm_ll_ops.keyslot_program(ksm, key, slot);
+	err = keyslot_manager_program(ksm, key, slot);
 	if (err) {
 		wake_up(&ksm->idle_slots_wait_queue);
 		keyslot_manager_hw_exit(ksm);
@@ -333,12 +415,8 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 	}
 
 	/* Move this slot to the hash list for the new key. */
-	if (idle_slot->key.crypto_mode != BLK_ENCRYPTION_MODE_INVALID)
-		hlist_del(&idle_slot->hash_node);
-	hlist_add_head(&idle_slot->hash_node, hash_bucket_for_key(ksm, key));
-
+	keyslot_manager_install_key(ksm, idle_slot, key);
 	atomic_set(&idle_slot->slot_refs, 1);
-	idle_slot->key = *key;
 
 	remove_slot_from_lru_list(ksm, slot);
 
@@ -346,6 +424,63 @@ int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 	return slot;
 }
 
+/**
+ * keyslot_manager_preload_key() - Program a key ahead of its first IO
+ * @ksm: The keyslot manager to program the key into.
+ * @key: The key to program.
+ *
+ * Program @key into an empty keyslot without taking a reference, so the first
+ * request using it does not wait for the (possibly slow) programming.  Keys
+ * already in use are never evicted to make room; when there is no empty slot
+ * this does nothing and the key is programmed on demand as usual.
+ *
+ * Context: Process context. Takes and releases ksm->lock.
+ * Return: 0 if the key is now programmed or there was no room, else a -errno
+ *	   value from the driver.
+ */
+int keyslot_manager_preload_key(struct keyslot_manager *ksm,
+				const struct blk_crypto_key *key)
+{
+	struct keyslot *slotp;
+	unsigned long flags;
+	int err = 0;
+
+	if (keyslot_manager_is_passthrough(ksm))
+		return 0;
+
+	keyslot_manager_hw_enter(ksm);
+	if (find_keyslot(ksm, key) >= 0)
+		goto out_unlock;
+
+	spin_lock_irqsave(&ksm->idle_slots_lock, flags);
+	slotp = list_first_entry_or_null(&ksm->idle_slots, struct keyslot,
+					 idle_slot_node);
+	if (slotp && slotp->key.crypto_mode != BLK_ENCRYPTION_MODE_INVALID)
+		slotp = NULL;
+	spin_unlock_irqrestore(&ksm->idle_slots_lock, flags);
+	if (!slotp)
+		goto out_unlock;
+
+	err = keyslot_manager_program(ksm, key, slotp - ksm->slots);
+	if (err)
+		goto out_unlock;
+
+	keyslot_manager_install_key(ksm, slotp, key);
+	ksm->stats.preload_cnt++;
+
+	/* Keep the empty slots in front of it, and give it a second chance */
+	spin_lock_irqsave(&ksm->idle_slots_lock, flags);
+	if (!atomic_read(&slotp->slot_refs)) {
+		slotp->referenced = true;
+		list_move_tail(&slotp->idle_slot_node, &ksm->idle_slots);
+	}
+	spin_unlock_irqrestore(&ksm->idle_slots_lock, flags);
+out_unlock:
+	keyslot_manager_hw_exit(ksm);
+	return err;
+}
+EXPORT_SYMBOL_GPL(keyslot_manager_preload_key);
+
 /**
  * keyslot_manager_get_slot() - Increment the refcount on the specified slot.
  * @ksm: The keyslot manager that we want to modify.
@@ -454,6 +589,7 @@ int keyslot_manager_evict_key(struct keyslot_manager *ksm,
 	int slot;
 	int err;
 	struct keyslot *slotp;
+	unsigned long flags;
 
 	if (keyslot_manager_is_passthrough(ksm)) {
 		if (ksm->ksm_ll_ops.keyslot_evict) {
@@ -484,6 +620,13 @@ int keyslot_manager_evict_key(struct keyslot_manager *ksm,
 
 	hlist_del(&slotp->hash_node);
 	memzero_explicit(&slotp->key, sizeof(slotp->key));
+	ksm->stats.evict_cnt++;
+
+	/* The slot is idle, put it where the next key will look first */
+	spin_lock_irqsave(&ksm->idle_slots_lock, flags);
+	slotp->referenced = false;
+	list_move(&slotp->idle_slot_node, &ksm->idle_slots);
+	spin_unlock_irqrestore(&ksm->idle_slots_lock, flags);
 	err = 0;
 out_unlock:
 	keyslot_manager_hw_exit(ksm);
@@ -515,13 +658,30 @@ void keyslot_manager_reprogram_all_keys(struct keyslot_manager *ksm)
 		if (slotp->key.crypto_mode == BLK_ENCRYPTION_MODE_INVALID)
 			continue;
 
-		err = ksm->ksm_ll_ops.keyslot_program(ksm, &slotp->key, slot);
+		err = keyslot_manager_program(ksm, &slotp->key, slot);
 		WARN_ON(err);
 	}
 	up_write(&ksm->lock);
 }
 EXPORT_SYMBOL_GPL(keyslot_manager_reprogram_all_keys);
 
+/**
+ * keyslot_manager_get_stats() - Read the keyslot usage counters
+ * @ksm: The keyslot manager
+ * @stats: Filled with a snapshot of the counters
+ *
+ * Context: Process context. Takes and releases ksm->lock.
+ */
+void keyslot_manager_get_stats(struct keyslot_manager *ksm,
+			       struct keyslot_mgmt_stats *stats)
+{
+	down_read(&ksm->lock);
+	*stats = ksm->stats;
+	up_read(&ksm->lock);
+	stats->hit_cnt = atomic64_read(&ksm->hits);
+}
+EXPORT_SYMBOL_GPL(keyslot_manager_get_stats);
+
 /**
  * keyslot_manager_private() - return the private data stored with ksm
  * @ksm: The keyslot manager
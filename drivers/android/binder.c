@@ -42,6 +42,7 @@
 
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
+#include <linux/cgroup.h>
 #include <linux/fdtable.h>
 #include <linux/file.h>
 #include <linux/freezer.h>
@@ -121,6 +122,14 @@ static uint32_t binder_debug_mask = BINDER_DEBUG_USER_ERROR |
 	BINDER_DEBUG_FAILED_TRANSACTION | BINDER_DEBUG_DEAD_TRANSACTION;
 module_param_named(debug_mask, binder_debug_mask, uint, 0644);
 
+/*
+ * Fail synchronous transactions to a process frozen by the cgroup v2
+ * freezer with BR_FAILED_REPLY instead of blocking the caller until the
+ * target is thawed. Userspace that freezes apps must handle the error.
+ */
+static bool binder_frozen_fail_fast;
+module_param_named(frozen_fail_fast, binder_frozen_fail_fast, bool, 0644);
+
 char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, 0444);
 
@@ -2473,6 +2482,76 @@ static int binder_fixup_parent(struct binder_transaction *t,
 	return 0;
 }
 
+static inline struct binder_proc_ext *
+to_binder_proc_ext(struct binder_proc *proc)
+{
+	return container_of(proc, struct binder_proc_ext, proc);
+}
+
+/**
+ * binder_latency_record() - account a transaction latency to its code
+ * @proc:	proc the transaction was sent to
+ * @code:	transaction code
+ * @type:	which part of the transaction @start to @end covers
+ * @start:	start of the interval, nothing is recorded if 0
+ * @end:	end of the interval
+ */
+static void binder_latency_record(struct binder_proc *proc, unsigned int code,
+				  enum binder_latency_type type,
+				  ktime_t start, ktime_t end)
+{
+	struct binder_latency_stats *stats;
+	int key = code + 1;
+	int i, cur, bucket;
+	s64 us;
+
+	if (!start)
+		return;
+
+	stats = to_binder_proc_ext(proc)->latency;
+	for (i = 0; key && i < BINDER_LATENCY_CODES; i++) {
+		cur = atomic_read(&stats[i].key);
+		if (!cur) {
+			cur = atomic_cmpxchg(&stats[i].key, 0, key);
+			if (!cur)
+				cur = key;
+		}
+		if (cur == key)
+			break;
+	}
+	if (!key)
+		i = BINDER_LATENCY_CODES;
+
+	us = ktime_us_delta(end, start);
+	bucket = us > 0 ? min_t(int, fls64(us), BINDER_LATENCY_BUCKETS - 1) : 0;
+	atomic_inc(&stats[i].buckets[type][bucket]);
+}
+
+/*
+ * Work was queued to proc->todo because no looper thread was waiting, so
+ * the thread pool is saturated until one of them comes back.
+ */
+static void binder_pool_saturated_ilocked(struct binder_proc *proc)
+{
+	struct binder_proc_ext *eproc = to_binder_proc_ext(proc);
+
+	if (!eproc->saturated_since) {
+		eproc->saturated_since = ktime_get();
+		eproc->saturated_count++;
+	}
+}
+
+static void binder_pool_available_ilocked(struct binder_proc *proc)
+{
+	struct binder_proc_ext *eproc = to_binder_proc_ext(proc);
+
+	if (eproc->saturated_since) {
+		eproc->saturated_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						   eproc->saturated_since));
+		eproc->saturated_since = 0;
+	}
+}
+
 /**
  * binder_proc_transaction() - sends a transaction to a process and wakes it up
  * @t:		transaction to send
@@ -2506,6 +2585,9 @@ static bool binder_proc_transaction(struct binder_transaction *t,
 
 	if (oneway) {
 		BUG_ON(thread);
+		/* Oneway work piling up until a frozen target is thawed */
+		if (cgroup_task_frozen(proc->tsk))
+			atomic_inc(&to_binder_proc_ext(proc)->frozen_queued);
 		if (node->has_async_transaction) {
 			pending_async = true;
 		} else {
@@ -2524,11 +2606,13 @@ static bool binder_proc_transaction(struct binder_transaction *t,
 	if (!thread && !pending_async)
 		thread = binder_select_thread_ilocked(proc);
 
+	t->enqueue_ts = ktime_get();
 	if (thread) {
 		binder_transaction_priority(thread->task, t, node_prio,
 					    node->inherit_rt);
 		binder_enqueue_thread_work_ilocked(thread, &t->work);
 	} else if (!pending_async) {
+		binder_pool_saturated_ilocked(proc);
 		binder_enqueue_work_ilocked(&t->work, &proc->todo);
 	} else {
 		binder_enqueue_work_ilocked(&t->work, &node->async_todo);
@@ -2795,6 +2879,18 @@ static void binder_transaction(struct binder_proc *proc,
 			}
 		}
 		binder_inner_proc_unlock(proc);
+
+		if (binder_frozen_fail_fast && !(tr->flags & TF_ONE_WAY) &&
+		    !target_thread && cgroup_task_frozen(target_proc->tsk)) {
+			atomic_inc(&to_binder_proc_ext(target_proc)->frozen_failed);
+			binder_debug(BINDER_DEBUG_FAILED_TRANSACTION,
+				     "%d:%d transaction to frozen process %d\n",
+				     proc->pid, thread->pid, target_proc->pid);
+			return_error = BR_FAILED_REPLY;
+			return_error_param = -EAGAIN;
+			return_error_line = __LINE__;
+			goto err_frozen_target;
+		}
 	}
 	if (target_thread)
 		e->to_thread = target_thread->pid;
@@ -3190,6 +3286,9 @@ static void binder_transaction(struct binder_proc *proc,
 		wake_up_interruptible_sync(&target_thread->wait);
 		trace_android_vh_binder_restore_priority(in_reply_to, current);
 		binder_restore_priority(current, in_reply_to->saved_priority);
+		binder_latency_record(proc, in_reply_to->code,
+				      BINDER_LATENCY_REPLY,
+				      in_reply_to->pickup_ts, ktime_get());
 		binder_free_transaction(in_reply_to);
 	} else if (!(t->flags & TF_ONE_WAY)) {
 		BUG_ON(t->buffer->async_transaction != 0);
@@ -3263,6 +3362,7 @@ static void binder_transaction(struct binder_proc *proc,
 err_alloc_t_failed:
 err_bad_todo_list:
 err_bad_call_stack:
+err_frozen_target:
 err_empty_call_stack:
 err_dead_binder:
 err_invalid_target_handle:
@@ -3850,9 +3950,11 @@ static int binder_wait_for_work(struct binder_thread *thread,
 		prepare_to_wait(&thread->wait, &wait, TASK_INTERRUPTIBLE);
 		if (binder_has_work_ilocked(thread, do_proc_work))
 			break;
-		if (do_proc_work)
+		if (do_proc_work) {
 			list_add(&thread->waiting_thread_node,
 				 &proc->waiting_threads);
+			binder_pool_available_ilocked(proc);
+		}
 		binder_inner_proc_unlock(proc);
 		schedule();
 		binder_inner_proc_lock(proc);
@@ -4201,6 +4303,10 @@ static int binder_thread_read(struct binder_proc *proc,
 			node_prio.prio = target_node->min_priority;
 			binder_transaction_priority(current, t, node_prio,
 						    target_node->inherit_rt);
+			t->pickup_ts = ktime_get();
+			binder_latency_record(proc, t->code,
+					      BINDER_LATENCY_QUEUE,
+					      t->enqueue_ts, t->pickup_ts);
 			cmd = BR_TRANSACTION;
 		} else {
 			trd->target.ptr = 0;
@@ -5776,6 +5882,74 @@ int binder_stats_show(struct seq_file *m, void *unused)
 	return 0;
 }
 
+static void print_binder_proc_latency(struct seq_file *m,
+				      struct binder_proc *proc)
+{
+	static const char * const type_names[] = {
+		[BINDER_LATENCY_QUEUE] = "queue",
+		[BINDER_LATENCY_REPLY] = "reply",
+	};
+	struct binder_proc_ext *eproc = to_binder_proc_ext(proc);
+	struct binder_latency_stats *stats;
+	unsigned int saturated_count;
+	unsigned int frozen_failed, frozen_queued;
+	u64 saturated_ns;
+	int i, type, bucket, key;
+
+	binder_inner_proc_lock(proc);
+	saturated_count = eproc->saturated_count;
+	saturated_ns = eproc->saturated_ns;
+	if (eproc->saturated_since)
+		saturated_ns += ktime_to_ns(ktime_sub(ktime_get(),
+						      eproc->saturated_since));
+	binder_inner_proc_unlock(proc);
+	frozen_failed = atomic_read(&eproc->frozen_failed);
+	frozen_queued = atomic_read(&eproc->frozen_queued);
+
+	if (!saturated_count && !frozen_failed && !frozen_queued &&
+	    !atomic_read(&eproc->latency[0].key))
+		return;
+
+	seq_printf(m, "proc %d\n", proc->pid);
+	seq_printf(m, "  pool saturated: %u times, %llu ms\n",
+		   saturated_count, div_u64(saturated_ns, NSEC_PER_MSEC));
+	if (frozen_failed || frozen_queued)
+		seq_printf(m, "  while frozen: %u sync failed, %u oneway queued\n",
+			   frozen_failed, frozen_queued);
+	for (i = 0; i <= BINDER_LATENCY_CODES; i++) {
+		stats = &eproc->latency[i];
+		key = atomic_read(&stats->key);
+		if (i < BINDER_LATENCY_CODES && !key)
+			continue;
+		for (type = 0; type < BINDER_LATENCY_COUNT; type++) {
+			atomic_t *counts = stats->buckets[type];
+
+			if (i < BINDER_LATENCY_CODES)
+				seq_printf(m, "  code %u", key - 1);
+			else
+				seq_puts(m, "  code other");
+			seq_printf(m, " %s:", type_names[type]);
+			for (bucket = 0; bucket < BINDER_LATENCY_BUCKETS; bucket++)
+				seq_printf(m, " %d", atomic_read(&counts[bucket]));
+			seq_putc(m, '\n');
+		}
+	}
+}
+
+int binder_latency_show(struct seq_file *m, void *unused)
+{
+	struct binder_proc *proc;
+
+	seq_printf(m, "binder latency (log2 usec buckets, <1 .. >=%d):\n",
+		   1 << (BINDER_LATENCY_BUCKETS - 2));
+	mutex_lock(&binder_procs_lock);
+	hlist_for_each_entry(proc, &binder_procs, proc_node)
+		print_binder_proc_latency(m, proc);
+	mutex_unlock(&binder_procs_lock);
+
+	return 0;
+}
+
 int binder_transactions_show(struct seq_file *m, void *unused)
 {
 	struct binder_proc *proc;
@@ -5939,6 +6113,11 @@ static int __init binder_init(void)
 				    binder_debugfs_dir_entry_root,
 				    &binder_transaction_log_failed,
 				    &binder_transaction_log_fops);
+		debugfs_create_file("latency",
+				    0444,
+				    binder_debugfs_dir_entry_root,
+				    NULL,
+				    &binder_latency_fops);
 	}
 
 	if (!IS_ENABLED(CONFIG_ANDROID_BINDERFS) &&
@@ -41,6 +41,18 @@ static uint32_t binder_alloc_debug_mask = BINDER_DEBUG_USER_ERROR;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+/* Freed small buffers kept per size class, sampled at mmap time */
+static uint32_t binder_alloc_small_buffers = 4;
+module_param_named(small_buffers, binder_alloc_small_buffers, uint, 0644);
+
+/* KB at the start of each mapping populated with pages at mmap time */
+static uint32_t binder_alloc_prefill_kb = 16;
+module_param_named(prefill_kb, binder_alloc_prefill_kb, uint, 0644);
+
+/* KB past an allocation mapped as well while mmap_sem is held anyway */
+static uint32_t binder_alloc_map_ahead_kb = 16;
+module_param_named(map_ahead_kb, binder_alloc_map_ahead_kb, uint, 0644);
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -178,6 +190,48 @@ struct binder_buffer *binder_alloc_prepare_to_free(struct binder_alloc *alloc,
 	return buffer;
 }
 
+/*
+ * Map the unpopulated pages following @end while the caller holds mmap_sem
+ * for an allocation, so that the next allocations of this proc find their
+ * pages mapped and do not have to take mmap_sem, where they would wait
+ * behind any mmap or munmap of another thread. The pages go on the lru
+ * like unused pages, so the shrinker can still take them back.
+ */
+static void binder_alloc_map_ahead(struct binder_alloc *alloc,
+				   struct vm_area_struct *vma,
+				   void __user *end)
+{
+	struct binder_lru_page *page;
+	size_t index, last;
+
+	index = (end - alloc->buffer) / PAGE_SIZE;
+	last = min_t(size_t, alloc->buffer_size / PAGE_SIZE,
+		     index + (size_t)binder_alloc_map_ahead_kb * SZ_1K /
+		     PAGE_SIZE);
+
+	for (; index < last; index++) {
+		page = &alloc->pages[index];
+		if (page->page_ptr)
+			break;
+
+		page->page_ptr = alloc_page(GFP_KERNEL | __GFP_HIGHMEM |
+					    __GFP_ZERO | __GFP_NOWARN);
+		if (!page->page_ptr)
+			break;
+		if (vm_insert_page(vma, (uintptr_t)alloc->buffer +
+				   index * PAGE_SIZE, page->page_ptr)) {
+			__free_page(page->page_ptr);
+			page->page_ptr = NULL;
+			break;
+		}
+		page->alloc = alloc;
+		INIT_LIST_HEAD(&page->lru);
+		list_lru_add(&binder_alloc_lru, &page->lru);
+		if (index + 1 > alloc->pages_high)
+			alloc->pages_high = index + 1;
+	}
+}
+
 static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 				    void __user *start, void __user *end)
 {
@@ -270,6 +324,8 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 		trace_binder_alloc_page_end(alloc, index);
 		/* vm_insert_page does not seem to increment the refcount */
 	}
+	if (vma)
+		binder_alloc_map_ahead(alloc, vma, end);
 	if (mm) {
 		up_read(&mm->mmap_sem);
 		mmput(mm);
@@ -376,6 +432,85 @@ static void debug_low_async_space_locked(struct binder_alloc *alloc, int pid)
 	}
 }
 
+static size_t binder_small_buf_size(int class)
+{
+	return (size_t)BINDER_SMALL_BUF_MIN << class;
+}
+
+/*
+ * Return the size class a request of @size bytes is rounded up to, or -1
+ * if the request is too large or the cache is disabled for this proc.
+ */
+static int binder_small_buf_class(struct binder_alloc *alloc, size_t size)
+{
+	if (!alloc->small_buffers_max ||
+	    size > binder_small_buf_size(BINDER_SMALL_BUF_CLASSES - 1))
+		return -1;
+	if (size <= BINDER_SMALL_BUF_MIN)
+		return 0;
+	return order_base_2(size) - order_base_2(BINDER_SMALL_BUF_MIN);
+}
+
+static struct binder_buffer *binder_small_buf_get(struct binder_alloc *alloc,
+						  int class)
+{
+	struct binder_buffer *buffer;
+
+	buffer = list_first_entry_or_null(&alloc->small_buffers[class],
+					  struct binder_buffer, cache_entry);
+	if (!buffer)
+		return NULL;
+
+	list_del(&buffer->cache_entry);
+	alloc->small_buffers_count[class]--;
+	alloc->small_buffers_hits++;
+	return buffer;
+}
+
+/*
+ * Park a buffer that is being freed on its size class list instead of
+ * returning it to free_buffers. The buffer stays marked as not free so
+ * its neighbours never merge with it, and the pages it covers are left
+ * off the lru so the next user does not have to map them again.
+ */
+static bool binder_small_buf_put(struct binder_alloc *alloc,
+				 struct binder_buffer *buffer,
+				 size_t buffer_size)
+{
+	int class = binder_small_buf_class(alloc, buffer_size);
+
+	if (class < 0 || buffer_size != binder_small_buf_size(class) ||
+	    alloc->small_buffers_count[class] >= alloc->small_buffers_max ||
+	    !binder_alloc_get_vma(alloc))
+		return false;
+
+	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
+	buffer->data_size = 0;
+	buffer->offsets_size = 0;
+	buffer->extra_buffers_size = 0;
+	buffer->async_transaction = 0;
+	list_add(&buffer->cache_entry, &alloc->small_buffers[class]);
+	alloc->small_buffers_count[class]++;
+	return true;
+}
+
+/*
+ * Move every parked small buffer back to allocated_buffers so it is
+ * released through the normal free path.
+ */
+static void binder_small_buf_drain(struct binder_alloc *alloc)
+{
+	struct binder_buffer *buffer;
+	int class;
+
+	for (class = 0; class < BINDER_SMALL_BUF_CLASSES; class++) {
+		while ((buffer = binder_small_buf_get(alloc, class))) {
+			alloc->small_buffers_hits--;
+			binder_insert_allocated_buffer_locked(alloc, buffer);
+		}
+	}
+}
+
 static struct binder_buffer *binder_alloc_new_buf_locked(
 				struct binder_alloc *alloc,
 				size_t data_size,
@@ -390,7 +525,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	struct rb_node *best_fit = NULL;
 	void __user *has_page_addr;
 	void __user *end_page_addr;
-	size_t size, data_offsets_size;
+	size_t size, alloc_size, data_offsets_size;
+	int class;
 	int ret;
 
 	if (!binder_alloc_get_vma(alloc)) {
@@ -427,15 +563,33 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	/* Pad 0-size buffers so they get assigned unique addresses */
 	size = max(size, sizeof(void *));
 
+	/*
+	 * Small requests are served from, and sized for, the per class
+	 * lists so that a freed buffer fits the next request of its class.
+	 */
+	class = binder_small_buf_class(alloc, size);
+	if (class >= 0) {
+		buffer = binder_small_buf_get(alloc, class);
+		if (buffer) {
+			binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
+				     "%d: binder_alloc_buf size %zd reused %pK\n",
+				      alloc->pid, size, buffer);
+			goto found;
+		}
+		alloc_size = binder_small_buf_size(class);
+	} else {
+		alloc_size = size;
+	}
+
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
 		buffer_size = binder_alloc_buffer_size(alloc, buffer);
 
-		if (size < buffer_size) {
+		if (alloc_size < buffer_size) {
 			best_fit = n;
 			n = n->rb_left;
-		} else if (size > buffer_size)
+		} else if (alloc_size > buffer_size)
 			n = n->rb_right;
 		else {
 			best_fit = n;
@@ -489,9 +643,10 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	has_page_addr = (void __user *)
 		(((uintptr_t)buffer->user_data + buffer_size) & PAGE_MASK);
-	WARN_ON(n && buffer_size != size);
+	WARN_ON(n && buffer_size != alloc_size);
 	end_page_addr =
-		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data + size);
+		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data +
+					  alloc_size);
 	if (end_page_addr > has_page_addr)
 		end_page_addr = has_page_addr;
 	ret = binder_update_page_range(alloc, 1, (void __user *)
@@ -499,7 +654,7 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	if (ret)
 		return ERR_PTR(ret);
 
-	if (buffer_size != size) {
+	if (buffer_size != alloc_size) {
 		struct binder_buffer *new_buffer;
 
 		new_buffer = kzalloc(sizeof(*buffer), GFP_KERNEL);
@@ -508,7 +663,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			       __func__, alloc->pid);
 			goto err_alloc_buf_struct_failed;
 		}
-		new_buffer->user_data = (u8 __user *)buffer->user_data + size;
+		new_buffer->user_data = (u8 __user *)buffer->user_data +
+					alloc_size;
 		list_add(&new_buffer->entry, &buffer->entry);
 		new_buffer->free = 1;
 		binder_insert_free_buffer(alloc, new_buffer);
@@ -516,6 +672,7 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	rb_erase(best_fit, &alloc->free_buffers);
 	buffer->free = 0;
+found:
 	buffer->allow_user_free = 0;
 	binder_insert_allocated_buffer_locked(alloc, buffer);
 	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
@@ -669,6 +826,9 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 			      alloc->pid, size, alloc->free_async_space);
 	}
 
+	if (binder_small_buf_put(alloc, buffer, buffer_size))
+		return;
+
 	binder_update_page_range(alloc, 0,
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data),
 		(void __user *)(((uintptr_t)
@@ -725,6 +885,42 @@ void binder_alloc_free_buf(struct binder_alloc *alloc,
 	mutex_unlock(&alloc->mutex);
 }
 
+/*
+ * Populate the first binder_alloc_prefill_kb of a new mapping so that the
+ * first transactions to a proc do not have to allocate and map pages
+ * with alloc->mutex held. The pages go on the lru like any other unused
+ * page, so the shrinker can still take them back. This runs before the
+ * vma is published, so no allocation can race with it, and the shrinker
+ * cannot reclaim a page until mmap returns and drops mmap_sem.
+ */
+static void binder_alloc_prefill_pages(struct binder_alloc *alloc,
+				       struct vm_area_struct *vma)
+{
+	struct binder_lru_page *page;
+	size_t index, nr_pages;
+
+	nr_pages = min_t(size_t, alloc->buffer_size / PAGE_SIZE,
+			 (size_t)binder_alloc_prefill_kb * SZ_1K / PAGE_SIZE);
+
+	for (index = 0; index < nr_pages; index++) {
+		page = &alloc->pages[index];
+		page->page_ptr = alloc_page(GFP_KERNEL | __GFP_HIGHMEM |
+					    __GFP_ZERO | __GFP_NOWARN);
+		if (!page->page_ptr)
+			break;
+		if (vm_insert_page(vma, (uintptr_t)alloc->buffer +
+				   index * PAGE_SIZE, page->page_ptr)) {
+			__free_page(page->page_ptr);
+			page->page_ptr = NULL;
+			break;
+		}
+		page->alloc = alloc;
+		INIT_LIST_HEAD(&page->lru);
+		list_lru_add(&binder_alloc_lru, &page->lru);
+		alloc->pages_high = index + 1;
+	}
+}
+
 /**
  * binder_alloc_mmap_handler() - map virtual address space for proc
  * @alloc:	alloc structure for this proc
@@ -778,6 +974,10 @@ int binder_alloc_mmap_handler(struct binder_alloc *alloc,
 	buffer->free = 1;
 	binder_insert_free_buffer(alloc, buffer);
 	alloc->free_async_space = alloc->buffer_size / 2;
+	alloc->small_buffers_max = binder_alloc_small_buffers;
+	/* The shrinker looks at vma_vm_mm for pages on the lru */
+	alloc->vma_vm_mm = vma->vm_mm;
+	binder_alloc_prefill_pages(alloc, vma);
 	binder_alloc_set_vma(alloc, vma);
 	mmgrab(alloc->vma_vm_mm);
 
@@ -810,6 +1010,7 @@ void binder_alloc_deferred_release(struct binder_alloc *alloc)
 	mutex_lock(&alloc->mutex);
 	BUG_ON(alloc->vma);
 
+	binder_small_buf_drain(alloc);
 	while ((n = rb_first(&alloc->allocated_buffers))) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 
@@ -929,6 +1130,8 @@ void binder_alloc_print_pages(struct seq_file *m,
 	mutex_unlock(&alloc->mutex);
 	seq_printf(m, "  pages: %d:%d:%d\n", active, lru, free);
 	seq_printf(m, "  pages high watermark: %zu\n", alloc->pages_high);
+	seq_printf(m, "  small buffers reused: %lu\n",
+		   alloc->small_buffers_hits);
 }
 
 /**
@@ -1069,9 +1272,13 @@ static struct shrinker binder_shrinker = {
  */
 void binder_alloc_init(struct binder_alloc *alloc)
 {
+	int i;
+
 	alloc->pid = current->group_leader->pid;
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	for (i = 0; i < BINDER_SMALL_BUF_CLASSES; i++)
+		INIT_LIST_HEAD(&alloc->small_buffers[i]);
 }
 
 int binder_alloc_shrinker_init(void)
@@ -18,10 +18,19 @@
 extern struct list_lru binder_alloc_lru;
 struct binder_transaction;
 
+/*
+ * Small transactions are rounded up to one of these power of two size
+ * classes, BINDER_SMALL_BUF_MIN << 0 .. BINDER_SMALL_BUF_CLASSES - 1, so
+ * freed buffers can be handed straight back out without a tree search.
+ */
+#define BINDER_SMALL_BUF_MIN		128
+#define BINDER_SMALL_BUF_CLASSES	5
+
 /**
  * struct binder_buffer - buffer used for binder transactions
  * @entry:              entry alloc->buffers
  * @rb_node:            node for allocated_buffers/free_buffers rb trees
+ * @cache_entry:        entry in alloc->small_buffers while parked there
  * @free:               %true if buffer is free
  * @clear_on_free:      %true if buffer must be zeroed after use
  * @allow_user_free:    %true if user is allowed to free buffer
@@ -39,8 +48,11 @@ struct binder_transaction;
  */
 struct binder_buffer {
 	struct list_head entry; /* free and allocated entries by address */
-	struct rb_node rb_node; /* free entry by size or allocated entry */
-				/* by address */
+	union {
+		struct rb_node rb_node; /* free entry by size or allocated */
+					/* entry by address */
+		struct list_head cache_entry; /* parked small buffer */
+	};
 	unsigned free:1;
 	unsigned clear_on_free:1;
 	unsigned allow_user_free:1;
@@ -87,6 +99,12 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @small_buffers:      per size class lists of freed small buffers kept
+ *                      with their pages mapped for reuse
+ * @small_buffers_count: number of buffers on each @small_buffers list
+ * @small_buffers_max:  cap on each @small_buffers list, 0 disables the
+ *                      cache (invariant after mmap)
+ * @small_buffers_hits: allocations served from @small_buffers
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -107,6 +125,10 @@ struct binder_alloc {
 	uint32_t buffer_free;
 	int pid;
 	size_t pages_high;
+	struct list_head small_buffers[BINDER_SMALL_BUF_CLASSES];
+	unsigned int small_buffers_count[BINDER_SMALL_BUF_CLASSES];
+	unsigned int small_buffers_max;
+	unsigned long small_buffers_hits;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
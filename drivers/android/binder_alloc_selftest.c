@@ -283,6 +283,7 @@ static void binder_selftest_alloc_offset(struct binder_alloc *alloc,
 void binder_selftest_alloc(struct binder_alloc *alloc)
 {
 	size_t end_offset[BUFFER_NUM];
+	unsigned int small_buffers_max;
 
 	if (!binder_selftest_run)
 		return;
@@ -290,7 +291,15 @@ void binder_selftest_alloc(struct binder_alloc *alloc)
 	if (!binder_selftest_run || !alloc->vma)
 		goto done;
 	pr_info("STARTED\n");
+	/*
+	 * The tests place buffers at exact offsets, so keep small buffers
+	 * from being rounded up and start with the prefilled pages gone.
+	 */
+	small_buffers_max = alloc->small_buffers_max;
+	alloc->small_buffers_max = 0;
+	binder_selftest_free_page(alloc);
 	binder_selftest_alloc_offset(alloc, end_offset, 0);
+	alloc->small_buffers_max = small_buffers_max;
 	binder_selftest_run = false;
 	if (binder_selftest_failures > 0)
 		pr_info("%d tests FAILED\n", binder_selftest_failures);
@@ -5,6 +5,7 @@
 
 #include <linux/export.h>
 #include <linux/fs.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/miscdevice.h>
 #include <linux/mutex.h>
@@ -119,6 +120,9 @@ DEFINE_SHOW_ATTRIBUTE(binder_transactions);
 int binder_transaction_log_show(struct seq_file *m, void *unused);
 DEFINE_SHOW_ATTRIBUTE(binder_transaction_log);
 
+int binder_latency_show(struct seq_file *m, void *unused);
+DEFINE_SHOW_ATTRIBUTE(binder_latency);
+
 struct binder_transaction_log_entry {
 	int debug_id;
 	int debug_id_done;
@@ -449,12 +453,44 @@ struct binder_proc {
 	struct dentry *binderfs_entry;
 };
 
+#define BINDER_LATENCY_CODES	8
+#define BINDER_LATENCY_BUCKETS	16
+
+enum binder_latency_type {
+	BINDER_LATENCY_QUEUE,	/* queued to picked up by a thread */
+	BINDER_LATENCY_REPLY,	/* picked up to BC_REPLY */
+	BINDER_LATENCY_COUNT
+};
+
+/**
+ * struct binder_latency_stats - latency histograms for one transaction code
+ * @key:     transaction code + 1, 0 while the slot is unused
+ * @buckets: log2 microsecond buckets for each binder_latency_type. Bucket
+ *           0 counts latencies below 1us and the last bucket is open ended
+ */
+struct binder_latency_stats {
+	atomic_t key;
+	atomic_t buckets[BINDER_LATENCY_COUNT][BINDER_LATENCY_BUCKETS];
+};
+
 /**
  * struct binder_proc_ext - binder process bookkeeping
  * @proc:            element for binder_procs list
  * @cred                  struct cred associated with the `struct file`
  *                        in binder_open()
  *                        (invariant after initialized)
+ * @latency:         per transaction code latency histograms, the first
+ *                   BINDER_LATENCY_CODES codes seen get a slot and the
+ *                   remaining ones share the last entry
+ * @saturated_since: time work was last queued to @proc->todo with no
+ *                   looper thread waiting, 0 while one is available
+ *                   (protected by @proc->inner_lock)
+ * @saturated_ns:    total time spent with no looper thread waiting
+ *                   (protected by @proc->inner_lock)
+ * @saturated_count: number of times the thread pool became saturated
+ *                   (protected by @proc->inner_lock)
+ * @frozen_failed:   sync transactions refused because @proc was frozen
+ * @frozen_queued:   oneway transactions queued while @proc was frozen
  *
  * Extended binder_proc -- needed to add the "cred" field without
  * changing the KMI for binder_proc.
@@ -462,6 +498,12 @@ struct binder_proc {
 struct binder_proc_ext {
 	struct binder_proc proc;
 	const struct cred *cred;
+	struct binder_latency_stats latency[BINDER_LATENCY_CODES + 1];
+	ktime_t saturated_since;
+	u64 saturated_ns;
+	unsigned int saturated_count;
+	atomic_t frozen_failed;
+	atomic_t frozen_queued;
 };
 
 static inline const struct cred *binder_get_cred(struct binder_proc *proc)
@@ -573,6 +615,9 @@ struct binder_transaction {
 	 */
 	spinlock_t lock;
 	ANDROID_VENDOR_DATA(1);
+	/* For the binder_latency_stats of the target proc */
+	ktime_t enqueue_ts;
+	ktime_t pickup_ts;
 };
 
 /**
@@ -23,6 +23,12 @@
 #include <trace/hooks/cgroup.h>
 #include <trace/hooks/sys.h>
 
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS_STATS
+#include <linux/debugfs.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+#endif
+
 /*
  * Export tracepoints that act as a bare tracehook (ie: have no trace event
  * associated with them) to allow external modules to probe them.
@@ -73,3 +79,57 @@ EXPORT_TRACEPOINT_SYMBOL_GPL(android_vh_map_util_freq);
 EXPORT_TRACEPOINT_SYMBOL_GPL(android_vh_em_pd_energy);
 EXPORT_TRACEPOINT_SYMBOL_GPL(android_vh_cgroup_set_task);
 EXPORT_TRACEPOINT_SYMBOL_GPL(android_vh_syscall_prctl_finished);
+
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS_STATS
+extern struct vendor_hook_stats __start___vendor_hook_stats[];
+extern struct vendor_hook_stats __stop___vendor_hook_stats[];
+
+void vendor_hook_stats_sample(struct vendor_hook_stats *stats, u64 start)
+{
+	u64 delta = local_clock() - start;
+
+	stats->samples++;
+	stats->total_ns += delta;
+	if (delta > stats->max_ns)
+		stats->max_ns = delta;
+}
+
+/*
+ * The estimated cost is the average sampled call time times the number
+ * of calls, which is what ranks the hooks by their impact.
+ */
+static int vendor_hook_stats_show(struct seq_file *m, void *v)
+{
+	struct vendor_hook_stats *stats;
+	u64 avg;
+
+	seq_printf(m, "%-48s %8s %12s %8s %8s %12s\n", "hook", "attached",
+		   "calls", "avg_ns", "max_ns", "est_ms");
+
+	for (stats = __start___vendor_hook_stats;
+	     stats < __stop___vendor_hook_stats; stats++) {
+		bool attached = static_key_enabled(&stats->tp->key);
+
+		if (!attached && !stats->calls)
+			continue;
+
+		avg = stats->samples ?
+			div64_u64(stats->total_ns, stats->samples) : 0;
+		seq_printf(m, "%-48s %8d %12lu %8llu %8llu %12llu\n",
+			   stats->tp->name, attached, stats->calls, avg,
+			   stats->max_ns,
+			   div64_u64(avg * stats->calls, NSEC_PER_MSEC));
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vendor_hook_stats);
+
+static int __init vendor_hook_stats_init(void)
+{
+	debugfs_create_file("vendor_hook_stats", 0400, NULL, NULL,
+			    &vendor_hook_stats_fops);
+	return 0;
+}
+late_initcall(vendor_hook_stats_init);
+#endif
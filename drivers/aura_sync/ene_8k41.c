@@ -119,6 +119,81 @@ static int ene_8k41_write_bytes(struct i2c_client *client, short addr, char valu
 	return err;
 }
 
+/*
+ * Burst write to consecutive registers with the block write command, so a
+ * color update costs one address and one data transaction instead of a pair
+ * for every register.
+ */
+static int ene_8k41_write_block(struct i2c_client *client, short addr, const u8 *data, int len)
+{
+	int err = 0;
+	unsigned char buf[16] = {0};
+
+	if (len > sizeof(buf) - 2)
+		return -EINVAL;
+
+	buf[0] = 0x00;
+	buf[1] = (addr >> 8) & 0xFF;
+	buf[2] = addr & 0xFF;
+
+	err = i2c_write_bytes(client, buf, 3);	//set register address
+	if (err !=1)
+		return err;
+
+	buf[0] = 0x03;
+	buf[1] = len;
+	memcpy(&buf[2], data, len);
+
+	return i2c_write_bytes(client, buf, len + 2);
+}
+
+// Write a calibrated RGB color and apply it, call with ene_mutex held
+static int ene_8k41_write_color(struct ene_8k41_platform_data *pdata, u8 red, u8 green, u8 blue)
+{
+	struct i2c_client *client = pdata->client;
+	u8 data[3];
+	int err = -EIO;
+
+	if (pdata->last_rgb_valid && pdata->last_rgb[0] == red &&
+	    pdata->last_rgb[1] == green && pdata->last_rgb[2] == blue)
+		return 1;
+
+	// 0x8010 red, 0x8011 blue, 0x8012 green
+	data[0] = DIV_ROUND_CLOSEST(red * pdata->RED_MAX, 255);
+	data[1] = DIV_ROUND_CLOSEST(blue * pdata->BLUE_MAX, 255);
+	data[2] = DIV_ROUND_CLOSEST(green * pdata->GREEN_MAX, 255);
+
+	if (!pdata->no_block_write) {
+		err = ene_8k41_write_block(client, 0x8010, data, sizeof(data));
+		if (err != 1) {
+			printk("[AURA_SYNC] block write unsupported, err %d\n", err);
+			pdata->no_block_write = true;
+		}
+	}
+
+	if (pdata->no_block_write) {
+		err = ene_8k41_write_bytes(client, 0x8010, data[0]);
+		if (err == 1)
+			err = ene_8k41_write_bytes(client, 0x8011, data[1]);
+		if (err == 1)
+			err = ene_8k41_write_bytes(client, 0x8012, data[2]);
+	}
+
+	if (err == 1)
+		err = ene_8k41_write_bytes(client, 0x802F, 0x1);
+
+	pdata->last_rgb[0] = red;
+	pdata->last_rgb[1] = green;
+	pdata->last_rgb[2] = blue;
+	pdata->last_rgb_valid = (err == 1);
+
+	g_red = red;
+	g_green = green;
+	g_blue = blue;
+
+	return err;
+}
+
 static int ene_GetFirmwareSize(char *firmware_name)
 {
 	struct file *pfile = NULL;
@@ -1471,6 +1546,182 @@ static ssize_t emulate_show(struct device *dev, struct device_attribute *attr,ch
 	return snprintf(buf, PAGE_SIZE,"Emulate %d\n", platform_data->emulate);
 }
 
+static ssize_t color_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev->parent);
+	struct ene_8k41_platform_data *platform_data = i2c_get_clientdata(client);
+	u32 rgb;
+	int err = 0;
+	ssize_t ret;
+
+	if (platform_data->emulate){
+		printk("[AURA_SYNC] emulate processing, block normal control\n");
+		return count;
+	}
+
+	ret = kstrtou32(buf, 16, &rgb);
+	if (ret)
+		return ret;
+	if (rgb > 0xFFFFFF)
+		return -EINVAL;
+
+	mutex_lock(&platform_data->ene_mutex);
+	platform_data->last_rgb_valid = false;
+	err = ene_8k41_write_color(platform_data, (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+	if (err != 1)
+		printk("[AURA_SYNC] ene_8k41_write_color:err %d\n", err);
+	mutex_unlock(&platform_data->ene_mutex);
+
+	return count;
+}
+
+static ssize_t color_show(struct device *dev, struct device_attribute *attr,char *buf)
+{
+	return snprintf(buf, PAGE_SIZE,"%02x%02x%02x\n", g_red & 0xFF, g_green & 0xFF, g_blue & 0xFF);
+}
+
+/*
+ * Kernel side effect engine. Userspace uploads the keyframes once and the
+ * engine replays them in a loop, holding each color for its duration or
+ * fading linearly into the next one in AURA_EFFECT_STEP_MS steps. Holds are
+ * a single timer expiry, and every step is one burst write plus apply, so
+ * animated lighting causes no userspace wakeups.
+ */
+static void aura_effect_work(struct work_struct *work)
+{
+	struct ene_8k41_platform_data *pdata = container_of(to_delayed_work(work),
+			struct ene_8k41_platform_data, effect_work);
+	struct aura_keyframe *cur, *next;
+	unsigned int elapsed, delay;
+	u8 red, green, blue;
+	int err = 0;
+
+	mutex_lock(&pdata->ene_mutex);
+	if (!pdata->nr_keyframes || pdata->suspend_state)
+		goto out;
+
+	cur = &pdata->keyframes[pdata->cur_keyframe];
+	elapsed = jiffies_to_msecs(jiffies - pdata->keyframe_start);
+	if (pdata->nr_keyframes > 1 && elapsed >= cur->ms) {
+		pdata->cur_keyframe = (pdata->cur_keyframe + 1) % pdata->nr_keyframes;
+		pdata->keyframe_start = jiffies;
+		cur = &pdata->keyframes[pdata->cur_keyframe];
+		elapsed = 0;
+	}
+	next = &pdata->keyframes[(pdata->cur_keyframe + 1) % pdata->nr_keyframes];
+
+	red = cur->red;
+	green = cur->green;
+	blue = cur->blue;
+	delay = cur->ms - elapsed;
+	if (cur->fade) {
+		red += ((int)next->red - cur->red) * (int)elapsed / cur->ms;
+		green += ((int)next->green - cur->green) * (int)elapsed / cur->ms;
+		blue += ((int)next->blue - cur->blue) * (int)elapsed / cur->ms;
+		delay = min_t(unsigned int, delay, AURA_EFFECT_STEP_MS);
+	}
+
+	err = ene_8k41_write_color(pdata, red, green, blue);
+	if (err != 1)
+		printk("[AURA_SYNC] ene_8k41_write_color:err %d\n", err);
+
+	// A single keyframe is a static color
+	if (pdata->nr_keyframes > 1)
+		queue_delayed_work(system_power_efficient_wq, &pdata->effect_work,
+				msecs_to_jiffies(delay));
+out:
+	mutex_unlock(&pdata->ene_mutex);
+}
+
+static ssize_t effect_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev->parent);
+	struct ene_8k41_platform_data *platform_data = i2c_get_clientdata(client);
+	struct aura_keyframe frames[AURA_MAX_KEYFRAMES];
+	char *str, *cur, *tok;
+	u32 rgb, ms;
+	char fade;
+	int n = 0;
+	int err = 0;
+
+	if (!sysfs_streq(buf, "0")) {
+		str = kstrndup(buf, count, GFP_KERNEL);
+		if (!str)
+			return -ENOMEM;
+
+		// "RRGGBB:ms[:f] ..." where f fades into the next keyframe
+		cur = str;
+		while ((tok = strsep(&cur, " ,\n"))) {
+			if (!*tok)
+				continue;
+			fade = 0;
+			if (n == AURA_MAX_KEYFRAMES ||
+			    sscanf(tok, "%6x:%u:%c", &rgb, &ms, &fade) < 2 ||
+			    !ms || ms > U16_MAX || (fade && fade != 'f')) {
+				kfree(str);
+				return -EINVAL;
+			}
+			frames[n].red = (rgb >> 16) & 0xFF;
+			frames[n].green = (rgb >> 8) & 0xFF;
+			frames[n].blue = rgb & 0xFF;
+			frames[n].fade = fade == 'f';
+			frames[n].ms = ms;
+			n++;
+		}
+		kfree(str);
+		if (!n)
+			return -EINVAL;
+	}
+
+	cancel_delayed_work_sync(&platform_data->effect_work);
+
+	mutex_lock(&platform_data->ene_mutex);
+	memcpy(platform_data->keyframes, frames, n * sizeof(frames[0]));
+	platform_data->nr_keyframes = n;
+	platform_data->cur_keyframe = 0;
+	platform_data->keyframe_start = jiffies;
+	platform_data->last_rgb_valid = false;
+
+	// The engine drives the color registers in the static mode
+	if (n) {
+		err = ene_8k41_write_bytes(client, 0x8021, 0x1);
+		if (err !=1)
+			printk("[AURA_SYNC] ene_8k41_write_bytes:err %d\n", err);
+		g_mode = 1;
+		platform_data->current_mode = 1;
+	}
+	mutex_unlock(&platform_data->ene_mutex);
+
+	printk("[AURA_SYNC] effect_store, %d keyframes\n", n);
+	if (n)
+		queue_delayed_work(system_power_efficient_wq, &platform_data->effect_work, 0);
+
+	return count;
+}
+
+static ssize_t effect_show(struct device *dev, struct device_attribute *attr,char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev->parent);
+	struct ene_8k41_platform_data *platform_data = i2c_get_clientdata(client);
+	struct aura_keyframe *frame;
+	int i, len = 0;
+
+	mutex_lock(&platform_data->ene_mutex);
+	for (i = 0; i < platform_data->nr_keyframes; i++) {
+		frame = &platform_data->keyframes[i];
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%02x%02x%02x:%u%s ",
+				frame->red, frame->green, frame->blue, frame->ms,
+				frame->fade ? ":f" : "");
+	}
+	mutex_unlock(&platform_data->ene_mutex);
+
+	if (!len)
+		len = scnprintf(buf, PAGE_SIZE, "0");
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
 static ssize_t suspend_vdd_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
 	ssize_t ret;
@@ -1669,6 +1920,8 @@ static DEVICE_ATTR(PB_HL, 0664, pb_hl_show, pb_hl_store);
 static DEVICE_ATTR(led2_on, 0664, led2_on_show, led2_on_store);
 static DEVICE_ATTR(REG, 0664, register_show, register_store);
 static DEVICE_ATTR(CSCmode, 0664, CSCmode_show, CSCmode_store);
+static DEVICE_ATTR(color, 0664, color_show, color_store);
+static DEVICE_ATTR(effect, 0664, effect_show, effect_store);
 
 static struct attribute *pwm_attrs[] = {
 	&dev_attr_red_pwm.attr,
@@ -1693,6 +1946,8 @@ static struct attribute *pwm_attrs[] = {
 	&dev_attr_led2_on.attr,
 	&dev_attr_REG.attr,
 	&dev_attr_CSCmode.attr,
+	&dev_attr_color.attr,
+	&dev_attr_effect.attr,
 	NULL
 };
 
@@ -1787,6 +2042,14 @@ static void aura_resume_work(struct work_struct *work)
 			//bumper_vdd_switch(1);
 	}
 	//wake_unlock(&g_pdata->aura_wake_lock);
+
+	// Restart the effect stopped in suspend
+	if (g_pdata->nr_keyframes) {
+		mutex_lock(&g_pdata->ene_mutex);
+		g_pdata->last_rgb_valid = false;
+		mutex_unlock(&g_pdata->ene_mutex);
+		queue_delayed_work(system_power_efficient_wq, &g_pdata->effect_work, 0);
+	}
 }
 
 // Check FW work
@@ -2021,6 +2284,7 @@ if (platform_data->aura_front_en != -ENOENT )
 		goto unled;
 	}
 	INIT_WORK(&platform_data->aura_work, aura_blink_work);
+	INIT_DELAYED_WORK(&platform_data->effect_work, aura_effect_work);
 
 	// set default
 	platform_data->on_ms = 100;
@@ -2097,6 +2361,7 @@ static int ene_8k41_remove(struct i2c_client *client)
 // unregister
 	printk("[AURA_SYNC] sysfs_remove_group\n");
 	sysfs_remove_group(&platform_data->led.dev->kobj, &pwm_attr_group);
+	cancel_delayed_work_sync(&platform_data->effect_work);
 
 	printk("[AURA_SYNC] aura_sync_unregister\n");
 	aura_sync_unregister(platform_data);
@@ -2158,6 +2423,7 @@ int ene_8k41_suspend(struct device *dev)
 		g_led2_on = 0;
 	}
 
+	cancel_delayed_work_sync(&g_pdata->effect_work);
 	g_pdata->suspend_state = true;
 
 	return err;
@@ -2186,10 +2452,11 @@ int ene_8k41_resume(struct device *dev)
 		}
 	}
 */
-	queue_work(g_pdata->resume_workqueue, &g_pdata->resume_aura_work);
-
+	// Cleared first so that the effect restarted by the resume work runs
 	g_pdata->suspend_state = false;
 
+	queue_work(g_pdata->resume_workqueue, &g_pdata->resume_aura_work);
+
 	return err;
 }
 
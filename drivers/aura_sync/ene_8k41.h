@@ -20,6 +20,18 @@ static u32 g_mode;
 static u32 g_speed;
 static u32 g_led_on;
 static u32 g_led2_on;
+// Kernel side lighting effect
+#define AURA_MAX_KEYFRAMES	16
+#define AURA_EFFECT_STEP_MS	40
+
+struct aura_keyframe {
+	u8 red;
+	u8 green;
+	u8 blue;
+	bool fade;	// fade into the next keyframe
+	u16 ms;
+};
+
 struct ene_8k41_platform_data {
 
 	u8 fw_version;
@@ -82,5 +94,15 @@ struct ene_8k41_platform_data {
 	int off_ms;
 	bool emulate;
 
+// Kernel side lighting effect
+	struct delayed_work		effect_work;
+	struct aura_keyframe		keyframes[AURA_MAX_KEYFRAMES];
+	int				nr_keyframes;
+	int				cur_keyframe;
+	unsigned long			keyframe_start;
+	u8				last_rgb[3];
+	bool				last_rgb_valid;
+	bool				no_block_write;
+
 	uint8_t reg;
 };
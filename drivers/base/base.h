@@ -65,6 +65,8 @@ struct driver_private {
  *	binding of drivers which were unable to get all the resources needed by
  *	the device; typically because it depends on another driver getting
  *	probed first.
+ * @defer_on_supplier - the last probe deferred on a device link supplier that
+ *	was not bound yet, so retrying is pointless until a supplier binds.
  * @async_driver - pointer to device driver awaiting probe via async_probe
  * @device - pointer back to the struct device that this structure is
  * associated with.
@@ -81,6 +83,7 @@ struct device_private {
 	struct klist_node knode_bus;
 	struct klist_node knode_class;
 	struct list_head deferred_probe;
+	bool defer_on_supplier;
 	struct device_driver *async_driver;
 	struct device *device;
 	u8 dead:1;
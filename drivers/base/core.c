@@ -913,6 +913,8 @@ int device_links_check_suppliers(struct device *dev)
 		if (link->status != DL_STATE_AVAILABLE &&
 		    !(link->flags & DL_FLAG_SYNC_STATE_ONLY)) {
 			device_links_missing_supplier(dev);
+			/* Cleared by device_links_driver_bound() of a supplier */
+			WRITE_ONCE(dev->p->defer_on_supplier, true);
 			ret = -EPROBE_DEFER;
 			break;
 		}
@@ -1119,6 +1121,7 @@ void device_links_driver_bound(struct device *dev)
 
 		WARN_ON(link->status != DL_STATE_DORMANT);
 		WRITE_ONCE(link->status, DL_STATE_AVAILABLE);
+		WRITE_ONCE(link->consumer->p->defer_on_supplier, false);
 
 		if (link->flags & DL_FLAG_AUTOPROBE_CONSUMER)
 			driver_deferred_probe_add(link->consumer);
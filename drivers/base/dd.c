@@ -45,7 +45,8 @@
  * list.  A driver returning -EPROBE_DEFER causes the device to be added to the
  * pending list.  A successful driver probe will trigger moving all devices
  * from the pending to the active list so that the workqueue will eventually
- * retry them.
+ * retry them.  Devices that deferred because a device link supplier was not
+ * bound stay pending until one of their suppliers binds.
  *
  * The deferred_probe_mutex must be held any time the deferred_probe_*_list
  * of the (struct device*)->p->deferred_probe pointers are manipulated
@@ -55,11 +56,13 @@ static LIST_HEAD(deferred_probe_pending_list);
 static LIST_HEAD(deferred_probe_active_list);
 static atomic_t deferred_trigger_count = ATOMIC_INIT(0);
 static struct dentry *deferred_devices;
+static struct dentry *probe_timeline_file;
 static bool initcalls_done;
 
 /* Save the async probe drivers' name from kernel cmdline */
 #define ASYNC_DRV_NAMES_MAX_LEN	256
 static char async_probe_drv_names[ASYNC_DRV_NAMES_MAX_LEN];
+static bool async_probe_default;
 
 /*
  * In some cases, like suspend to RAM or hibernation, It might be reasonable
@@ -142,11 +145,16 @@ void driver_deferred_probe_del(struct device *dev)
 
 static bool driver_deferred_probe_enable = false;
 /**
- * driver_deferred_probe_trigger() - Kick off re-probing deferred devices
+ * __driver_deferred_probe_trigger() - Kick off re-probing deferred devices
+ * @all: also retry devices still waiting for a device link supplier
  *
- * This functions moves all devices from the pending list to the active
- * list and schedules the deferred probe workqueue to process them.  It
- * should be called anytime a driver is successfully bound to a device.
+ * This functions moves devices from the pending list to the active list
+ * and schedules the deferred probe workqueue to process them.  It should
+ * be called anytime a driver is successfully bound to a device.
+ *
+ * A device whose last probe deferred on a supplier that was not bound would
+ * defer again the same way, so unless @all is set it is left pending until
+ * device_links_driver_bound() of one of its suppliers clears the mark.
  *
  * Note, there is a race condition in multi-threaded probe. In the case where
  * more than one device is probing at the same time, it is possible for one
@@ -159,20 +167,28 @@ static bool driver_deferred_probe_enable = false;
  * changes in the midst of a probe, then deferred processing should be triggered
  * again.
  */
-static void driver_deferred_probe_trigger(void)
+static void __driver_deferred_probe_trigger(bool all)
 {
+	struct device_private *p, *n;
+
 	if (!driver_deferred_probe_enable)
 		return;
 
 	/*
-	 * A successful probe means that all the devices in the pending list
-	 * should be triggered to be reprobed.  Move all the deferred devices
-	 * into the active list so they can be retried by the workqueue
+	 * A successful probe means that the devices in the pending list
+	 * should be triggered to be reprobed.  Move them into the active
+	 * list so they can be retried by the workqueue
 	 */
 	mutex_lock(&deferred_probe_mutex);
 	atomic_inc(&deferred_trigger_count);
-	list_splice_tail_init(&deferred_probe_pending_list,
-			      &deferred_probe_active_list);
+	list_for_each_entry_safe(p, n, &deferred_probe_pending_list,
+				 deferred_probe) {
+		if (all)
+			WRITE_ONCE(p->defer_on_supplier, false);
+		else if (READ_ONCE(p->defer_on_supplier))
+			continue;
+		list_move_tail(&p->deferred_probe, &deferred_probe_active_list);
+	}
 	mutex_unlock(&deferred_probe_mutex);
 
 	/*
@@ -182,6 +198,11 @@ static void driver_deferred_probe_trigger(void)
 	queue_work(system_unbound_wq, &deferred_probe_work);
 }
 
+static void driver_deferred_probe_trigger(void)
+{
+	__driver_deferred_probe_trigger(false);
+}
+
 /**
  * device_block_probing() - Block/defer device's probes
  *
@@ -203,9 +224,77 @@ void device_block_probing(void)
 void device_unblock_probing(void)
 {
 	defer_all_probes = false;
-	driver_deferred_probe_trigger();
+	__driver_deferred_probe_trigger(true);
+}
+
+/*
+ * The last PROBE_TIMELINE_SIZE probe attempts, including deferrals, with
+ * their start time since boot and duration.
+ */
+#define PROBE_TIMELINE_SIZE	512
+
+struct probe_record {
+	u64 start_us;
+	u32 duration_us;
+	const char *result;
+	bool async;
+	char drv[24];
+	char dev[40];
+};
+
+static struct probe_record probe_timeline[PROBE_TIMELINE_SIZE];
+static unsigned int probe_timeline_count;
+static DEFINE_SPINLOCK(probe_timeline_lock);
+
+static void probe_timeline_add(struct device *dev, struct device_driver *drv,
+			       ktime_t start, int ret)
+{
+	struct probe_record *rec;
+	s64 duration = ktime_us_delta(ktime_get(), start);
+
+	spin_lock(&probe_timeline_lock);
+	rec = &probe_timeline[probe_timeline_count++ % PROBE_TIMELINE_SIZE];
+	rec->start_us = ktime_to_us(start);
+	rec->duration_us = min_t(s64, duration, U32_MAX);
+	if (ret > 0)
+		rec->result = "bound";
+	else if (!list_empty(&dev->p->deferred_probe))
+		rec->result = "defer";
+	else
+		rec->result = "none";
+	rec->async = current_is_async();
+	strlcpy(rec->drv, drv->name, sizeof(rec->drv));
+	strlcpy(rec->dev, dev_name(dev), sizeof(rec->dev));
+	spin_unlock(&probe_timeline_lock);
 }
 
+static int probe_timeline_show(struct seq_file *s, void *data)
+{
+	struct probe_record rec;
+	unsigned int i, first = 0, count;
+
+	spin_lock(&probe_timeline_lock);
+	count = probe_timeline_count;
+	spin_unlock(&probe_timeline_lock);
+
+	if (count > PROBE_TIMELINE_SIZE)
+		first = count - PROBE_TIMELINE_SIZE;
+
+	seq_puts(s, "start_us duration_us result mode driver device\n");
+	for (i = first; i < count; i++) {
+		spin_lock(&probe_timeline_lock);
+		rec = probe_timeline[i % PROBE_TIMELINE_SIZE];
+		spin_unlock(&probe_timeline_lock);
+
+		seq_printf(s, "%llu %u %s %s %s %s\n", rec.start_us,
+			   rec.duration_us, rec.result,
+			   rec.async ? "async" : "sync", rec.drv, rec.dev);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(probe_timeline);
+
 /*
  * deferred_devs_show() - Show the devices in the deferred probe pending list.
  */
@@ -216,7 +305,8 @@ static int deferred_devs_show(struct seq_file *s, void *data)
 	mutex_lock(&deferred_probe_mutex);
 
 	list_for_each_entry(curr, &deferred_probe_pending_list, deferred_probe)
-		seq_printf(s, "%s\n", dev_name(curr->device));
+		seq_printf(s, "%s%s\n", dev_name(curr->device),
+			   curr->defer_on_supplier ? " (supplier)" : "");
 
 	mutex_unlock(&deferred_probe_mutex);
 
@@ -303,7 +393,7 @@ static void deferred_probe_timeout_work_func(struct work_struct *work)
 	struct device_private *p;
 
 	deferred_probe_timeout = 0;
-	driver_deferred_probe_trigger();
+	__driver_deferred_probe_trigger(true);
 	flush_work(&deferred_probe_work);
 
 	mutex_lock(&deferred_probe_mutex);
@@ -324,6 +414,8 @@ static int deferred_probe_initcall(void)
 {
 	deferred_devices = debugfs_create_file("devices_deferred", 0444, NULL,
 					       NULL, &deferred_devs_fops);
+	probe_timeline_file = debugfs_create_file("probe_timeline", 0444, NULL,
+						  NULL, &probe_timeline_fops);
 
 	driver_deferred_probe_enable = true;
 	driver_deferred_probe_trigger();
@@ -335,7 +427,7 @@ static int deferred_probe_initcall(void)
 	 * Trigger deferred probe again, this time we won't defer anything
 	 * that is optional
 	 */
-	driver_deferred_probe_trigger();
+	__driver_deferred_probe_trigger(true);
 	flush_work(&deferred_probe_work);
 
 	if (deferred_probe_timeout > 0) {
@@ -349,6 +441,7 @@ late_initcall(deferred_probe_initcall);
 static void __exit deferred_probe_exit(void)
 {
 	debugfs_remove_recursive(deferred_devices);
+	debugfs_remove(probe_timeline_file);
 }
 __exitcall(deferred_probe_exit);
 
@@ -521,6 +614,8 @@ static int really_probe(struct device *dev, struct device_driver *drv)
 		return ret;
 	}
 
+	/* Set again by device_links_check_suppliers() if still missing one */
+	WRITE_ONCE(dev->p->defer_on_supplier, false);
 	ret = device_links_check_suppliers(dev);
 	if (ret == -EPROBE_DEFER)
 		driver_deferred_probe_add_trigger(dev, local_trigger_count);
@@ -729,6 +824,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
  */
 int driver_probe_device(struct device_driver *drv, struct device *dev)
 {
+	ktime_t calltime;
 	int ret = 0;
 
 	if (!device_is_registered(dev))
@@ -742,10 +838,12 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
+	calltime = ktime_get();
 	if (initcall_debug)
 		ret = really_probe_debug(dev, drv);
 	else
 		ret = really_probe(dev, drv);
+	probe_timeline_add(dev, drv, calltime, ret);
 	pm_request_idle(dev);
 
 	if (dev->parent)
@@ -757,10 +855,19 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 
 static inline bool cmdline_requested_async_probing(const char *drv_name)
 {
-	return parse_option_str(async_probe_drv_names, drv_name);
+	bool async_drv;
+
+	async_drv = parse_option_str(async_probe_drv_names, drv_name);
+
+	return (async_probe_default != async_drv);
 }
 
-/* The option format is "driver_async_probe=drv_name1,drv_name2,..." */
+/*
+ * The option format is "driver_async_probe=drv_name1,drv_name2,...".
+ * A "*" entry makes asynchronous probing the default for every driver that
+ * does not set a probe_type, and the drivers named next to it are the ones
+ * kept synchronous.
+ */
 static int __init save_async_options(char *buf)
 {
 	if (strlen(buf) >= ASYNC_DRV_NAMES_MAX_LEN)
@@ -768,6 +875,8 @@ static int __init save_async_options(char *buf)
 			"Too long list of driver names for 'driver_async_probe'!\n");
 
 	strlcpy(async_probe_drv_names, buf, ASYNC_DRV_NAMES_MAX_LEN);
+	async_probe_default = parse_option_str(async_probe_drv_names, "*");
+
 	return 0;
 }
 __setup("driver_async_probe=", save_async_options);
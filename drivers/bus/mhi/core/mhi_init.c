@@ -1308,6 +1308,12 @@ static int of_parse_ev_cfg(struct mhi_controller *mhi_cntrl,
 				mhi_event->request_irq = true;
 		}
 
+		/* only rings serviced by mhi_ev_task() can be moderated */
+		mhi_event->irq_moderation = mhi_event->request_irq &&
+			!mhi_event->cl_manage &&
+			mhi_event->data_type == MHI_ER_DATA_ELEMENT_TYPE &&
+			of_property_read_bool(child, "mhi,irq-moderation");
+
 		mhi_event++;
 	}
 
@@ -1628,6 +1634,10 @@ int of_register_mhi_controller(struct mhi_controller *mhi_cntrl)
 		else
 			tasklet_init(&mhi_event->task, mhi_ev_task,
 				     (ulong)mhi_event);
+
+		hrtimer_init(&mhi_event->mod_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		mhi_event->mod_timer.function = mhi_ev_mod_timer_fn;
 	}
 
 	mhi_chan = mhi_cntrl->mhi_chan;
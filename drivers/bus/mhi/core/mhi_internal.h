@@ -640,7 +640,10 @@ struct mhi_buf_info {
 	void *cb_buf;
 	bool used; /* indicate element is free to use */
 	bool pre_mapped; /* already pre-mapped by client */
+	bool chained; /* inner element of a sclist chain, no completion */
 	enum dma_data_direction dir;
+	struct scatterlist *sgl; /* set on the last element of a sclist chain */
+	int nents;
 };
 
 struct mhi_event {
@@ -667,6 +670,16 @@ struct mhi_event {
 	struct mhi_tre last_cached_tre;
 	u64 last_dev_rp;
 	bool force_uncached;
+
+	/* adaptive interrupt moderation, data event rings only */
+	bool irq_moderation;
+	bool irq_masked;
+	struct hrtimer mod_timer;
+	u64 msi_count;
+	u64 ev_count;
+	u64 mod_masks;
+	u64 mod_polls;
+	u32 max_batch;
 };
 
 struct mhi_chan {
@@ -983,6 +996,8 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev);
 irqreturn_t mhi_intvec_threaded_handlr(int irq_number, void *dev);
 irqreturn_t mhi_intvec_handlr(int irq_number, void *dev);
 void mhi_ev_task(unsigned long data);
+enum hrtimer_restart mhi_ev_mod_timer_fn(struct hrtimer *timer);
+void mhi_ev_mod_stop(struct mhi_event *mhi_event);
 
 #define MHI_ASSERT(cond, fmt, ...) do { \
 	if (cond) \
@@ -9,6 +9,7 @@
 #include <linux/list.h>
 #include <linux/of.h>
 #include <linux/module.h>
+#include <linux/scatterlist.h>
 #include <linux/skbuff.h>
 #include <linux/slab.h>
 #include <linux/mhi.h>
@@ -16,6 +17,14 @@
 
 static char *mhi_generic_sfr = "unknown reason";
 
+/*
+ * Event rings with interrupt moderation enabled stay masked and are polled
+ * every MHI_EV_MOD_POLL_NS while each pass finds at least MHI_EV_MOD_BATCH
+ * events.
+ */
+#define MHI_EV_MOD_BATCH (32)
+#define MHI_EV_MOD_POLL_NS (100 * NSEC_PER_USEC)
+
 static void __mhi_unprepare_channel(struct mhi_controller *mhi_cntrl,
 				    struct mhi_chan *mhi_chan);
 
@@ -279,15 +288,6 @@ void mhi_soc_reset(struct mhi_controller *mhi_cntrl)
 }
 EXPORT_SYMBOL(mhi_soc_reset);
 
-int mhi_queue_sclist(struct mhi_device *mhi_dev,
-		     struct mhi_chan *mhi_chan,
-		     void *buf,
-		     size_t len,
-		     enum MHI_FLAGS mflags)
-{
-	return -EINVAL;
-}
-
 int mhi_queue_nop(struct mhi_device *mhi_dev,
 		  struct mhi_chan *mhi_chan,
 		  void *buf,
@@ -523,6 +523,107 @@ int mhi_queue_skb(struct mhi_device *mhi_dev,
 	return ret;
 }
 
+/*
+ * Queue a scatterlist as one chained transfer. @buf is the struct scatterlist
+ * and @len the number of entries in it. Every entry gets its own TRE with the
+ * chain bit set on all but the last one, so the device sees a single transfer
+ * and the client gets a single completion carrying the scatterlist back.
+ */
+int mhi_queue_sclist(struct mhi_device *mhi_dev,
+		     struct mhi_chan *mhi_chan,
+		     void *buf,
+		     size_t len,
+		     enum MHI_FLAGS mflags)
+{
+	struct mhi_controller *mhi_cntrl = mhi_dev->mhi_cntrl;
+	struct mhi_ring *tre_ring = &mhi_chan->tre_ring;
+	struct mhi_ring *buf_ring = &mhi_chan->buf_ring;
+	struct scatterlist *sgl = buf, *sg;
+	struct mhi_buf_info *buf_info;
+	struct mhi_tre *mhi_tre;
+	int nents = len, mapped, i;
+	int eot, eob;
+
+	/* bounce buffers are per TRE, there's nothing to bounce a list into */
+	if (unlikely(!nents || mhi_cntrl->bounce_buf))
+		return -EINVAL;
+
+	if (get_nr_avail_ring_elements(mhi_cntrl, tre_ring) < nents)
+		return -ENOMEM;
+
+	mapped = dma_map_sg(mhi_cntrl->dev, sgl, nents, mhi_chan->dir);
+	if (unlikely(!mapped)) {
+		MHI_ERR("Failed to map sclist for chan:%d\n", mhi_chan->chan);
+		return -ENOMEM;
+	}
+
+	read_lock_bh(&mhi_cntrl->pm_lock);
+	if (unlikely(MHI_PM_IN_ERROR_STATE(mhi_cntrl->pm_state))) {
+		MHI_VERB("MHI is not in activate state, pm_state:%s\n",
+			 to_mhi_pm_state_str(mhi_cntrl->pm_state));
+		read_unlock_bh(&mhi_cntrl->pm_lock);
+		dma_unmap_sg(mhi_cntrl->dev, sgl, nents, mhi_chan->dir);
+
+		return -EIO;
+	}
+
+	/* we're in M3 or transitioning to M3 */
+	if (MHI_PM_IN_SUSPEND_STATE(mhi_cntrl->pm_state))
+		mhi_trigger_resume(mhi_cntrl);
+
+	/* toggle wake to exit out of M2 */
+	mhi_cntrl->wake_toggle(mhi_cntrl);
+
+	eot = !!(mflags & MHI_EOT);
+	eob = !!(mflags & MHI_EOB);
+
+	/* generate one tre per mapped segment, only the last one completes */
+	for_each_sg(sgl, sg, mapped, i) {
+		bool last = (i == mapped - 1);
+
+		buf_info = buf_ring->wp;
+		buf_info->v_addr = NULL;
+		buf_info->p_addr = sg_dma_address(sg);
+		buf_info->len = sg_dma_len(sg);
+		buf_info->pre_mapped = true;
+		buf_info->wp = tre_ring->wp;
+		buf_info->dir = mhi_chan->dir;
+		buf_info->chained = !last;
+		buf_info->cb_buf = last ? sgl : NULL;
+		buf_info->sgl = last ? sgl : NULL;
+		buf_info->nents = last ? nents : 0;
+
+		mhi_tre = tre_ring->wp;
+		mhi_tre->ptr = MHI_TRE_DATA_PTR(buf_info->p_addr);
+		mhi_tre->dword[0] = MHI_TRE_DATA_DWORD0(buf_info->len);
+		mhi_tre->dword[1] = last ?
+			MHI_TRE_DATA_DWORD1(mhi_chan->bei, eot, eob, 0) :
+			MHI_TRE_DATA_DWORD1(1, 0, 0, 1);
+
+		MHI_VERB("chan:%d WP:0x%llx TRE:0x%llx 0x%08x 0x%08x\n",
+			 mhi_chan->chan,
+			 (u64)mhi_to_physical(tre_ring, mhi_tre),
+			 mhi_tre->ptr, mhi_tre->dword[0], mhi_tre->dword[1]);
+
+		mhi_add_ring_element(mhi_cntrl, tre_ring);
+		mhi_add_ring_element(mhi_cntrl, buf_ring);
+	}
+
+	if (mhi_chan->dir == DMA_TO_DEVICE)
+		atomic_inc(&mhi_cntrl->pending_pkts);
+
+	/* one doorbell for the whole chain */
+	if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl))) {
+		read_lock_bh(&mhi_chan->lock);
+		mhi_ring_chan_db(mhi_cntrl, mhi_chan);
+		read_unlock_bh(&mhi_chan->lock);
+	}
+
+	read_unlock_bh(&mhi_cntrl->pm_lock);
+
+	return 0;
+}
+
 int mhi_queue_dma(struct mhi_device *mhi_dev,
 		  struct mhi_chan *mhi_chan,
 		  void *buf,
@@ -917,6 +1018,7 @@ static int parse_xfer_event(struct mhi_controller *mhi_cntrl,
 	bool ring_db = true;
 	int n_free_tre, n_queued_tre;
 	unsigned long rflags;
+	int recycled = 0;
 
 	ev_code = MHI_TRE_GET_EV_CODE(event);
 	buf_ring = &mhi_chan->buf_ring;
@@ -948,6 +1050,7 @@ static int parse_xfer_event(struct mhi_controller *mhi_cntrl,
 		struct mhi_tre *local_rp, *ev_tre;
 		void *dev_rp;
 		struct mhi_buf_info *buf_info;
+		size_t chain_len = 0;
 		u16 xfer_len;
 
 		/* Get the TRB this event points to */
@@ -974,9 +1077,30 @@ static int parse_xfer_event(struct mhi_controller *mhi_cntrl,
 			if (likely(!buf_info->pre_mapped))
 				mhi_cntrl->unmap_single(mhi_cntrl, buf_info);
 
+			/*
+			 * middle of a sclist chain, account the bytes and let
+			 * the last TRE of the chain notify the client
+			 */
+			if (buf_info->chained) {
+				chain_len += min_t(u16, xfer_len,
+						   buf_info->len);
+				buf_info->chained = false;
+				mhi_del_ring_element(mhi_cntrl, buf_ring);
+				mhi_del_ring_element(mhi_cntrl, tre_ring);
+				local_rp = tre_ring->rp;
+				continue;
+			}
+
+			if (buf_info->sgl) {
+				dma_unmap_sg(mhi_cntrl->dev, buf_info->sgl,
+					     buf_info->nents, buf_info->dir);
+				buf_info->sgl = NULL;
+			}
+
 			result.buf_addr = buf_info->cb_buf;
-			result.bytes_xferd = min_t(u16, xfer_len,
-					buf_info->len);
+			result.bytes_xferd = chain_len +
+				min_t(u16, xfer_len, buf_info->len);
+			chain_len = 0;
 			mhi_del_ring_element(mhi_cntrl, buf_ring);
 			mhi_del_ring_element(mhi_cntrl, tre_ring);
 			local_rp = tre_ring->rp;
@@ -993,16 +1117,31 @@ static int parse_xfer_event(struct mhi_controller *mhi_cntrl,
 			 * dropping the packet
 			 */
 			if (mhi_chan->pre_alloc) {
-				if (mhi_queue_buf(mhi_chan->mhi_dev, mhi_chan,
-						  buf_info->cb_buf,
-						  buf_info->len, MHI_EOT)) {
+				if (mhi_is_ring_full(mhi_cntrl, tre_ring) ||
+				    mhi_chan->gen_tre(mhi_cntrl, mhi_chan,
+						      buf_info->cb_buf,
+						      buf_info->cb_buf,
+						      buf_info->len, MHI_EOT)) {
 					MHI_ERR(
 						"Error recycling buffer for chan:%d\n",
 						mhi_chan->chan);
 					kfree(buf_info->cb_buf);
+				} else {
+					recycled++;
 				}
 			}
 		}
+
+		/* ring the doorbell once for all recycled buffers */
+		if (recycled) {
+			read_lock_irqsave(&mhi_cntrl->pm_lock, rflags);
+			if (MHI_PM_IN_SUSPEND_STATE(mhi_cntrl->pm_state))
+				mhi_trigger_resume(mhi_cntrl);
+			mhi_cntrl->wake_toggle(mhi_cntrl);
+			if (likely(MHI_DB_ACCESS_VALID(mhi_cntrl)))
+				mhi_ring_chan_db(mhi_cntrl, mhi_chan);
+			read_unlock_irqrestore(&mhi_cntrl->pm_lock, rflags);
+		}
 		break;
 	} /* CC_EOT */
 	case MHI_EV_CC_OOB:
@@ -1349,6 +1488,12 @@ int mhi_process_data_event_ring(struct mhi_controller *mhi_cntrl,
 
 	while (dev_rp != local_rp && event_quota > 0) {
 		enum MHI_PKT_TYPE type = MHI_TRE_GET_EV_TYPE(local_rp);
+		struct mhi_tre *next_rp = local_rp + 1;
+
+		/* pull in the next element while this one is processed */
+		if ((void *)next_rp >= ev_ring->base + ev_ring->len)
+			next_rp = ev_ring->base;
+		prefetch(next_rp);
 
 		MHI_VERB("Processing Event:0x%llx 0x%08x 0x%08x\n",
 			local_rp->ptr, local_rp->dword[0], local_rp->dword[1]);
@@ -1583,18 +1728,94 @@ void mhi_special_dbs_pending(struct mhi_controller *mhi_cntrl)
 	}
 }
 
+static void mhi_ev_schedule(struct mhi_event *mhi_event)
+{
+	if (IS_MHI_ER_PRIORITY_HIGH(mhi_event))
+		tasklet_hi_schedule(&mhi_event->task);
+	else
+		tasklet_schedule(&mhi_event->task);
+}
+
+enum hrtimer_restart mhi_ev_mod_timer_fn(struct hrtimer *timer)
+{
+	struct mhi_event *mhi_event = container_of(timer, struct mhi_event,
+						   mod_timer);
+
+	mhi_event->mod_polls++;
+	mhi_ev_schedule(mhi_event);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Keep the MSI masked and poll the ring while events keep arriving in
+ * large batches, unmask it again once the rate drops. Any MSI raised
+ * while masked is replayed by enable_irq().
+ */
+static void mhi_ev_moderate(struct mhi_event *mhi_event, int count)
+{
+	struct mhi_controller *mhi_cntrl = mhi_event->mhi_cntrl;
+	int irq = mhi_cntrl->irq[mhi_event->msi];
+
+	if (count >= MHI_EV_MOD_BATCH &&
+	    !MHI_EVENT_ACCESS_INVALID(mhi_cntrl->pm_state)) {
+		if (!mhi_event->irq_masked) {
+			disable_irq_nosync(irq);
+			mhi_event->irq_masked = true;
+			mhi_event->mod_masks++;
+		}
+
+		hrtimer_start(&mhi_event->mod_timer,
+			      ns_to_ktime(MHI_EV_MOD_POLL_NS),
+			      HRTIMER_MODE_REL);
+		return;
+	}
+
+	if (mhi_event->irq_masked) {
+		mhi_event->irq_masked = false;
+		enable_irq(irq);
+	}
+}
+
+void mhi_ev_mod_stop(struct mhi_event *mhi_event)
+{
+	struct mhi_controller *mhi_cntrl = mhi_event->mhi_cntrl;
+
+	if (!mhi_event->irq_moderation)
+		return;
+
+	/* a running pass may have armed the timer, flush it out as well */
+	hrtimer_cancel(&mhi_event->mod_timer);
+	tasklet_kill(&mhi_event->task);
+
+	if (mhi_event->irq_masked) {
+		mhi_event->irq_masked = false;
+		enable_irq(mhi_cntrl->irq[mhi_event->msi]);
+	}
+}
+
 void mhi_ev_task(unsigned long data)
 {
 	struct mhi_event *mhi_event = (struct mhi_event *)data;
 	struct mhi_controller *mhi_cntrl = mhi_event->mhi_cntrl;
 	unsigned long flags;
+	int count;
 
 	MHI_VERB("Enter for ev_index:%d\n", mhi_event->er_index);
 
 	/* process all pending events */
 	spin_lock_irqsave(&mhi_event->lock, flags);
-	mhi_event->process_event(mhi_cntrl, mhi_event, U32_MAX);
+	count = mhi_event->process_event(mhi_cntrl, mhi_event, U32_MAX);
 	spin_unlock_irqrestore(&mhi_event->lock, flags);
+
+	if (count > 0) {
+		mhi_event->ev_count += count;
+		if (count > mhi_event->max_batch)
+			mhi_event->max_batch = count;
+	}
+
+	if (mhi_event->irq_moderation)
+		mhi_ev_moderate(mhi_event, count);
 }
 
 void mhi_ctrl_ev_task(unsigned long data)
@@ -1652,6 +1873,8 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev)
 	struct mhi_ring *ev_ring = &mhi_event->ring;
 	void *dev_rp = mhi_to_virtual(ev_ring, er_ctxt->rp);
 
+	mhi_event->msi_count++;
+
 	/* confirm ER has pending events to process before scheduling work */
 	if (ev_ring->rp == dev_rp)
 		return IRQ_HANDLED;
@@ -1667,10 +1890,7 @@ irqreturn_t mhi_msi_handlr(int irq_number, void *dev)
 		return IRQ_HANDLED;
 	}
 
-	if (IS_MHI_ER_PRIORITY_HIGH(mhi_event))
-		tasklet_hi_schedule(&mhi_event->task);
-	else
-		tasklet_schedule(&mhi_event->task);
+	mhi_ev_schedule(mhi_event);
 
 	return IRQ_HANDLED;
 }
@@ -2023,14 +2243,26 @@ static void mhi_reset_data_chan(struct mhi_controller *mhi_cntrl,
 	while (tre_ring->rp != tre_ring->wp) {
 		struct mhi_buf_info *buf_info = buf_ring->rp;
 
-		if (mhi_chan->dir == DMA_TO_DEVICE)
-			atomic_dec(&mhi_cntrl->pending_pkts);
-
 		if (!buf_info->pre_mapped)
 			mhi_cntrl->unmap_single(mhi_cntrl, buf_info);
 		mhi_del_ring_element(mhi_cntrl, buf_ring);
 		mhi_del_ring_element(mhi_cntrl, tre_ring);
 
+		/* sclist chains only hand back the last element */
+		if (buf_info->chained) {
+			buf_info->chained = false;
+			continue;
+		}
+
+		if (mhi_chan->dir == DMA_TO_DEVICE)
+			atomic_dec(&mhi_cntrl->pending_pkts);
+
+		if (buf_info->sgl) {
+			dma_unmap_sg(mhi_cntrl->dev, buf_info->sgl,
+				     buf_info->nents, buf_info->dir);
+			buf_info->sgl = NULL;
+		}
+
 		if (mhi_chan->pre_alloc) {
 			kfree(buf_info->cb_buf);
 		} else {
@@ -2267,6 +2499,12 @@ int mhi_debugfs_mhi_event_show(struct seq_file *m, void *d)
 				   er_ctxt->rp, er_ctxt->wp,
 				   mhi_to_physical(ring, ring->rp),
 				   mhi_event->db_cfg.db_val);
+			seq_printf(m,
+				   " msi:%llu events:%llu max_batch:%u masks:%llu polls:%llu%s\n",
+				   mhi_event->msi_count, mhi_event->ev_count,
+				   mhi_event->max_batch, mhi_event->mod_masks,
+				   mhi_event->mod_polls,
+				   mhi_event->irq_masked ? " (masked)" : "");
 		}
 	}
 
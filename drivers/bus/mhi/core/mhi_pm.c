@@ -657,6 +657,7 @@ static void mhi_pm_disable_transition(struct mhi_controller *mhi_cntrl,
 		if (!mhi_event->request_irq)
 			continue;
 		tasklet_kill(&mhi_event->task);
+		mhi_ev_mod_stop(mhi_event);
 	}
 
 	mutex_unlock(&mhi_cntrl->pm_mutex);
@@ -94,9 +94,17 @@ struct clk_core {
 	struct hlist_node	child_node;
 	struct hlist_head	clks;
 	unsigned int		notifier_count;
+	/* last request that was settled, see clk_core_set_rate_cached() */
+	unsigned long		cached_req_rate;
+	unsigned long		cached_rate;
+	unsigned long		cached_parent_rate;
+	struct clk_core		*cached_parent;
 #ifdef CONFIG_DEBUG_FS
 	struct dentry		*dentry;
 	struct hlist_node	debug_node;
+	/* clk_set_rate() latency, log2 buckets of usecs */
+	u64			set_rate_hist[16];
+	u64			set_rate_max_us;
 #endif
 	struct kref		ref;
 };
@@ -2218,6 +2226,34 @@ static unsigned long clk_core_req_round_rate_nolock(struct clk_core *core,
 	return ret ? 0 : req.rate;
 }
 
+/*
+ * DVFS clients keep asking for the rate they already have. Rounding such a
+ * request walks the parents just to find out there is nothing to do, so
+ * remember the last settled request and skip it when neither the clock nor
+ * its parent moved since. Consumer rate ranges also feed the rounding, so
+ * clk_set_rate_range() drops the cache.
+ */
+static bool clk_core_set_rate_cached(struct clk_core *core,
+				     unsigned long req_rate)
+{
+	if (core->flags & CLK_GET_RATE_NOCACHE)
+		return false;
+
+	return req_rate && req_rate == core->cached_req_rate &&
+	       core->rate == core->cached_rate &&
+	       core->parent == core->cached_parent &&
+	       (!core->parent || core->parent->rate == core->cached_parent_rate);
+}
+
+static void clk_core_set_rate_cache(struct clk_core *core,
+				    unsigned long req_rate)
+{
+	core->cached_req_rate = req_rate;
+	core->cached_rate = core->rate;
+	core->cached_parent = core->parent;
+	core->cached_parent_rate = core->parent ? core->parent->rate : 0;
+}
+
 static int clk_core_set_rate_nolock(struct clk_core *core,
 				    unsigned long req_rate)
 {
@@ -2228,11 +2264,16 @@ static int clk_core_set_rate_nolock(struct clk_core *core,
 	if (!core)
 		return 0;
 
+	if (clk_core_set_rate_cached(core, req_rate))
+		return 0;
+
 	rate = clk_core_req_round_rate_nolock(core, req_rate);
 
 	/* bail early if nothing to do */
-	if (rate == clk_core_get_rate_nolock(core))
+	if (rate == clk_core_get_rate_nolock(core)) {
+		clk_core_set_rate_cache(core, req_rate);
 		return 0;
+	}
 
 	/* fail on a direct rate set of a protected provider */
 	if (clk_core_rate_is_protected(core))
@@ -2261,12 +2302,24 @@ static int clk_core_set_rate_nolock(struct clk_core *core,
 	clk_change_rate(top);
 
 	core->req_rate = req_rate;
+	clk_core_set_rate_cache(core, req_rate);
 err:
 	clk_pm_runtime_put(core);
 
 	return ret;
 }
 
+static void clk_debug_account_set_rate(struct clk_core *core, ktime_t start)
+{
+#ifdef CONFIG_DEBUG_FS
+	u64 us = ktime_us_delta(ktime_get(), start);
+	int bucket = min_t(int, fls64(us), ARRAY_SIZE(core->set_rate_hist) - 1);
+
+	core->set_rate_hist[bucket]++;
+	core->set_rate_max_us = max(core->set_rate_max_us, us);
+#endif
+}
+
 /**
  * clk_set_rate - specify a new rate for clk
  * @clk: the clk whose rate is being changed
@@ -2290,11 +2343,14 @@ static int clk_core_set_rate_nolock(struct clk_core *core,
  */
 int clk_set_rate(struct clk *clk, unsigned long rate)
 {
+	ktime_t start;
 	int ret;
 
 	if (!clk)
 		return 0;
 
+	start = ktime_get();
+
 	/* prevent racing with updates to the clock topology */
 	clk_prepare_lock();
 
@@ -2306,6 +2362,7 @@ int clk_set_rate(struct clk *clk, unsigned long rate)
 	if (clk->exclusive_count)
 		clk_core_rate_protect(clk->core);
 
+	clk_debug_account_set_rate(clk->core, start);
 	clk_prepare_unlock();
 
 	return ret;
@@ -2392,6 +2449,7 @@ int clk_set_rate_range(struct clk *clk, unsigned long min, unsigned long max)
 	old_max = clk->max_rate;
 	clk->min_rate = min;
 	clk->max_rate = max;
+	clk->core->cached_req_rate = 0;
 
 	rate = clk_core_get_rate_nolock(clk->core);
 	if (rate < min || rate > max) {
@@ -3301,6 +3359,25 @@ static int clock_debug_enable_get(void *data, u64 *val)
 DEFINE_DEBUGFS_ATTRIBUTE(clock_enable_fops, clock_debug_enable_get,
 			clock_debug_enable_set, "%lld\n");
 
+static int clk_set_rate_latency_show(struct seq_file *s, void *data)
+{
+	struct clk_core *core = s->private;
+	int i;
+
+	clk_prepare_lock();
+	for (i = 0; i < ARRAY_SIZE(core->set_rate_hist); i++)
+		seq_printf(s, "%s%llu us: %llu\n",
+			   i == ARRAY_SIZE(core->set_rate_hist) - 1 ? ">=" : "<",
+			   i == ARRAY_SIZE(core->set_rate_hist) - 1 ?
+			   1ULL << (i - 1) : 1ULL << i,
+			   core->set_rate_hist[i]);
+	seq_printf(s, "max: %llu us\n", core->set_rate_max_us);
+	clk_prepare_unlock();
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(clk_set_rate_latency);
+
 static void clk_debug_create_one(struct clk_core *core, struct dentry *pdentry)
 {
 	struct dentry *root;
@@ -3324,6 +3401,8 @@ static void clk_debug_create_one(struct clk_core *core, struct dentry *pdentry)
 	debugfs_create_u32("clk_notifier_count", 0444, root, &core->notifier_count);
 	debugfs_create_file("clk_duty_cycle", 0444, root, core,
 			    &clk_duty_cycle_fops);
+	debugfs_create_file("clk_set_rate_latency", 0444, root, core,
+			    &clk_set_rate_latency_fops);
 
 	if (core->num_parents > 0)
 		debugfs_create_file("clk_parent", 0444, root, core,
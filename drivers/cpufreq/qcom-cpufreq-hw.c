@@ -6,6 +6,7 @@
 #include <linux/bitfield.h>
 #include <linux/cpufreq.h>
 #include <linux/cpu_cooling.h>
+#include <linux/ktime.h>
 #include <linux/energy_model.h>
 #include <linux/init.h>
 #include <linux/interrupt.h>
@@ -57,6 +58,21 @@ static unsigned int lut_max_entries = LUT_MAX_ENTRIES;
 static bool accumulative_counter;
 static bool perf_lock_support;
 
+/*
+ * Fast switch accounting, per frequency domain. Updated without locking
+ * from the governor's update path, so readers may see a torn snapshot.
+ */
+struct cpufreq_qcom_stats {
+	u64 requests;
+	u64 writes;
+	u64 same_index;
+	u64 rate_limited;
+	u64 above_limit;
+	u64 limited_ns;
+	unsigned int req_freq;
+	unsigned int applied_freq;
+};
+
 struct cpufreq_qcom {
 	struct cpufreq_frequency_table *table;
 	void __iomem *base;
@@ -72,6 +88,11 @@ struct cpufreq_qcom {
 	char dcvsh_irq_name[MAX_FN_SIZE];
 	bool is_irq_enabled;
 	bool is_irq_requested;
+	int last_index;
+	u64 last_write_ns;
+	u64 limited_since_ns;
+	unsigned int down_rate_limit_us;
+	struct cpufreq_qcom_stats stats;
 };
 
 struct cpufreq_counter {
@@ -137,6 +158,13 @@ static unsigned long limits_mitigation_notify(struct cpufreq_qcom *c,
 	trace_dcvsh_freq(cpumask_first(&c->related_cpus), freq);
 	c->dcvsh_freq_limit = freq;
 
+	if (limit && !c->limited_since_ns) {
+		c->limited_since_ns = ktime_get_ns();
+	} else if (!limit && c->limited_since_ns) {
+		c->stats.limited_ns += ktime_get_ns() - c->limited_since_ns;
+		c->limited_since_ns = 0;
+	}
+
 	return freq;
 }
 
@@ -255,6 +283,11 @@ qcom_cpufreq_hw_target_index(struct cpufreq_policy *policy,
 	arch_set_freq_scale(policy->related_cpus, freq,
 			    policy->cpuinfo.max_freq);
 
+	c->last_index = index;
+	c->last_write_ns = ktime_get_ns();
+	c->stats.writes++;
+	c->stats.applied_freq = freq;
+
 	for (i = 0; i < c->sdpm_base_count && freq < policy->cur; i++)
 		writel_relaxed(freq / 1000, c->sdpm_base[i]);
 
@@ -276,20 +309,48 @@ static unsigned int qcom_cpufreq_hw_get(unsigned int cpu)
 	return policy->freq_table[index].frequency;
 }
 
+/*
+ * The governor can resolve to the same index several times a window, skip
+ * the MMIO when the domain is already there. Decreases arriving within
+ * down_rate_limit_us of the last write are held off as well, the governor
+ * asks again on its next update. Increases always go through.
+ */
 static unsigned int
 qcom_cpufreq_hw_fast_switch(struct cpufreq_policy *policy,
 			    unsigned int target_freq)
 {
+	struct cpufreq_qcom *c = qcom_freq_domain_map[policy->cpu];
+	unsigned int freq, last_freq;
 	int index;
 
 	index = policy->cached_resolved_idx;
 	if (index < 0)
 		return 0;
 
+	c->stats.requests++;
+	c->stats.req_freq = target_freq;
+	if (target_freq > c->dcvsh_freq_limit)
+		c->stats.above_limit++;
+
+	freq = policy->freq_table[index].frequency;
+	if (index == c->last_index) {
+		c->stats.same_index++;
+		return freq;
+	}
+
+	if (c->last_index >= 0 && c->down_rate_limit_us) {
+		last_freq = policy->freq_table[c->last_index].frequency;
+		if (freq < last_freq && ktime_get_ns() - c->last_write_ns <
+				(u64)c->down_rate_limit_us * NSEC_PER_USEC) {
+			c->stats.rate_limited++;
+			return last_freq;
+		}
+	}
+
 	if (qcom_cpufreq_hw_target_index(policy, index))
 		return 0;
 
-	return policy->freq_table[index].frequency;
+	return freq;
 }
 
 static int qcom_cpufreq_hw_cpu_init(struct cpufreq_policy *policy)
@@ -320,6 +381,7 @@ static int qcom_cpufreq_hw_cpu_init(struct cpufreq_policy *policy)
 	policy->freq_table = c->table;
 	policy->driver_data = c->base;
 	policy->fast_switch_possible = true;
+	c->last_index = -1;
 	policy->dvfs_possible_from_any_cpu = true;
 
 	dev_pm_opp_of_register_em(policy->cpus);
@@ -355,9 +417,55 @@ static int qcom_cpufreq_hw_cpu_init(struct cpufreq_policy *policy)
 	return 0;
 }
 
+static ssize_t show_fast_switch_stats(struct cpufreq_policy *policy,
+		char *buf)
+{
+	struct cpufreq_qcom *c = qcom_freq_domain_map[policy->cpu];
+	u64 limited_ns = c->stats.limited_ns;
+	u64 since = READ_ONCE(c->limited_since_ns);
+
+	if (since)
+		limited_ns += ktime_get_ns() - since;
+
+	return scnprintf(buf, PAGE_SIZE,
+		"requests %llu\nwrites %llu\nsame_index %llu\n"
+		"rate_limited %llu\nabove_limit %llu\nlimited_ms %llu\n"
+		"req_freq %u\napplied_freq %u\nlimit_freq %lu\n",
+		c->stats.requests, c->stats.writes, c->stats.same_index,
+		c->stats.rate_limited, c->stats.above_limit,
+		div_u64(limited_ns, NSEC_PER_MSEC), c->stats.req_freq,
+		c->stats.applied_freq, c->dcvsh_freq_limit);
+}
+cpufreq_freq_attr_ro(fast_switch_stats);
+
+static ssize_t show_fast_switch_down_rate_limit_us(
+		struct cpufreq_policy *policy, char *buf)
+{
+	struct cpufreq_qcom *c = qcom_freq_domain_map[policy->cpu];
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", c->down_rate_limit_us);
+}
+
+static ssize_t store_fast_switch_down_rate_limit_us(
+		struct cpufreq_policy *policy, const char *buf, size_t count)
+{
+	struct cpufreq_qcom *c = qcom_freq_domain_map[policy->cpu];
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	WRITE_ONCE(c->down_rate_limit_us, val);
+
+	return count;
+}
+cpufreq_freq_attr_rw(fast_switch_down_rate_limit_us);
+
 static struct freq_attr *qcom_cpufreq_hw_attr[] = {
 	&cpufreq_freq_attr_scaling_available_freqs,
 	&cpufreq_freq_attr_scaling_boost_freqs,
+	&fast_switch_stats,
+	&fast_switch_down_rate_limit_us,
 	NULL
 };
 
@@ -408,6 +516,9 @@ static int qcom_cpufreq_hw_resume(struct cpufreq_policy *policy)
 	unsigned long freq = policy->cur;
 	int i;
 
+	/* the perf state may have been lost, do not skip the next write */
+	c->last_index = -1;
+
 	for (i = 0; i < c->sdpm_base_count; i++)
 		writel_relaxed(freq / 1000, c->sdpm_base[i]);
 
@@ -551,6 +662,8 @@ static int qcom_cpu_resources_init(struct platform_device *pdev,
 	accumulative_counter = !of_property_read_bool(dev->of_node,
 						"qcom,no-accumulative-counter");
 	c->base = base;
+	c->last_index = -1;
+	c->dcvsh_freq_limit = U32_MAX;
 
 	qcom_get_related_cpus(index, &c->related_cpus);
 	if (!cpumask_weight(&c->related_cpus)) {
@@ -39,6 +39,8 @@
 #include <asm/arch_timer.h>
 #include <asm/suspend.h>
 #include <asm/cpuidle.h>
+#include <asm/cpufeature.h>
+#include <asm/sysreg.h>
 #include "lpm-levels.h"
 #include <trace/events/power.h>
 #include <linux/clk.h>
@@ -86,6 +88,9 @@ module_param_named(lpm_prediction, lpm_prediction, bool, 0664);
 static bool lpm_ipi_prediction = true;
 module_param_named(lpm_ipi_prediction, lpm_ipi_prediction, bool, 0664);
 
+static bool lpm_irq_prediction = true;
+module_param_named(lpm_irq_prediction, lpm_irq_prediction, bool, 0664);
+
 struct lpm_history {
 	uint32_t resi[MAXSAMPLES];
 	int mode[MAXSAMPLES];
@@ -102,8 +107,47 @@ struct ipi_history {
 	ktime_t cpu_idle_resched_ts;
 };
 
+enum lpm_wake_src {
+	LPM_WAKE_UNKNOWN,
+	LPM_WAKE_TIMER,
+	LPM_WAKE_IPI,
+	LPM_WAKE_IRQ,
+	LPM_WAKE_NR,
+};
+
+/* GIC INTIDs a wakeup can be pinned on */
+#define LPM_HWIRQ_PPI_START	16
+#define LPM_HWIRQ_SPI_START	32
+#define LPM_HWIRQ_SPURIOUS	1020
+
+/*
+ * Periodicity of one device interrupt, learned from the wakeups it
+ * caused. @stable counts consecutive wakeups landing on a multiple of
+ * @period, within an eighth of it.
+ */
+struct lpm_irq_history {
+	uint32_t hwirq;
+	uint32_t period;
+	uint32_t stable;
+	uint64_t last_us;
+};
+
+struct lpm_pred_stats {
+	uint32_t hit;
+	uint32_t early;
+	uint32_t late;
+};
+
+struct wake_history {
+	struct lpm_irq_history irqs[LPM_WAKE_IRQS];
+	struct lpm_pred_stats stats[NR_LPM_LEVELS];
+	uint32_t src_cnt[LPM_WAKE_NR];
+	uint32_t victim;
+};
+
 static DEFINE_PER_CPU(ktime_t, next_hrtimer);
 static DEFINE_PER_CPU(struct lpm_history, hist);
+static DEFINE_PER_CPU(struct wake_history, wake_hist);
 static DEFINE_PER_CPU(struct ipi_history, cpu_ipi_history);
 static DEFINE_PER_CPU(struct lpm_cpu*, cpu_lpm);
 static bool suspend_in_progress;
@@ -519,7 +563,7 @@ static uint64_t find_deviation(int *interval, uint32_t ref_stddev,
 	return 0;
 }
 
-static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
+static uint64_t lpm_residency_predict(struct cpuidle_device *dev,
 		struct lpm_cpu *cpu, int *idx_restrict,
 		uint32_t *idx_restrict_time, uint32_t *ipi_predicted)
 {
@@ -528,9 +572,6 @@ static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
 	struct lpm_history *history = &per_cpu(hist, dev->cpu);
 	struct ipi_history *ipi_history = &per_cpu(cpu_ipi_history, dev->cpu);
 
-	if (!lpm_prediction || !cpu->lpm_prediction)
-		return 0;
-
 	/*
 	 * Samples are marked invalid when woken-up due to timer,
 	 * so donot predict.
@@ -617,6 +658,68 @@ static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
 	return 0;
 }
 
+/*
+ * Earliest wakeup expected from a device interrupt that has been waking
+ * this CPU periodically, if it comes before @sleep_us.
+ */
+static uint32_t lpm_irq_predict(int cpu, uint64_t now_us, uint32_t sleep_us)
+{
+	struct wake_history *wh = &per_cpu(wake_hist, cpu);
+	uint32_t elapsed, next, best = 0;
+	int i;
+
+	for (i = 0; i < LPM_WAKE_IRQS; i++) {
+		struct lpm_irq_history *ih = &wh->irqs[i];
+
+		if (!ih->hwirq || !ih->period ||
+		    ih->stable < LPM_IRQ_STABLE_CNT)
+			continue;
+
+		if (now_us - ih->last_us > LPM_IRQ_PERIOD_MAX_US)
+			continue;
+
+		elapsed = now_us - ih->last_us;
+		next = ih->period - (elapsed % ih->period);
+		if (next < sleep_us && (!best || next < best))
+			best = next;
+	}
+
+	return best;
+}
+
+static uint64_t lpm_cpuidle_predict(struct cpuidle_device *dev,
+		struct lpm_cpu *cpu, int *idx_restrict,
+		uint32_t *idx_restrict_time, uint32_t *ipi_predicted,
+		uint32_t *irq_predicted, uint32_t sleep_us)
+{
+	struct lpm_history *history = &per_cpu(hist, dev->cpu);
+	uint64_t now_us, predicted;
+	uint32_t irq_us;
+
+	if (!lpm_prediction || !cpu->lpm_prediction)
+		return 0;
+
+	predicted = lpm_residency_predict(dev, cpu, idx_restrict,
+					  idx_restrict_time, ipi_predicted);
+	if (!lpm_irq_prediction)
+		return predicted;
+
+	/*
+	 * A periodic device interrupt (display, touch) due before both the
+	 * timer and the residency based guess decides the sleep length.
+	 */
+	now_us = ktime_to_us(ktime_get());
+	irq_us = lpm_irq_predict(dev->cpu, now_us, sleep_us);
+	if (!irq_us || (predicted && predicted <= irq_us))
+		return predicted;
+
+	*ipi_predicted = 0;
+	*irq_predicted = 1;
+	history->stime = now_us + irq_us;
+
+	return irq_us;
+}
+
 static inline void invalidate_predict_history(struct cpuidle_device *dev)
 {
 	struct lpm_history *history = &per_cpu(hist, dev->cpu);
@@ -704,6 +807,7 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	uint32_t lvl_latency_us = 0;
 	uint64_t predicted = 0;
 	uint32_t htime = 0, idx_restrict_time = 0, ipi_predicted = 0;
+	uint32_t irq_predicted = 0;
 	uint32_t next_wakeup_us = (uint32_t)sleep_us;
 	uint32_t min_residency, max_residency;
 	struct power_params *pwr_params;
@@ -734,7 +838,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 			if (next_wakeup_us > max_residency) {
 				predicted = lpm_cpuidle_predict(dev, cpu,
 					&idx_restrict, &idx_restrict_time,
-					&ipi_predicted);
+					&ipi_predicted, &irq_predicted,
+					next_wakeup_us);
 				if (predicted && (predicted < min_residency))
 					predicted = min_residency;
 			} else
@@ -779,7 +884,8 @@ static int cpu_power_select(struct cpuidle_device *dev,
 	trace_cpu_power_select(best_level, sleep_us, latency_us, 0);
 
 	trace_cpu_pred_select(idx_restrict_time ? 2 : (ipi_predicted ?
-				3 : (predicted ? 1 : 0)), predicted, htime);
+				3 : (irq_predicted ? 4 : (predicted ? 1 : 0))),
+				predicted, htime);
 
 	return best_level;
 }
@@ -1457,6 +1563,147 @@ static void update_history(struct cpuidle_device *dev, int idx)
 		history->hptr = 0;
 }
 
+static uint32_t lpm_pending_hwirq(void)
+{
+#ifdef CONFIG_ARM64
+	if (cpus_have_const_cap(ARM64_HAS_SYSREG_GIC_CPUIF))
+		return read_sysreg_s(SYS_ICC_HPPIR1_EL1) & GENMASK(23, 0);
+#endif
+	return LPM_HWIRQ_SPURIOUS;
+}
+
+static void update_irq_history(struct wake_history *wh, uint32_t hwirq,
+		uint64_t now_us)
+{
+	struct lpm_irq_history *ih = NULL;
+	uint32_t interval, mult, period;
+	int i;
+
+	for (i = 0; i < LPM_WAKE_IRQS; i++) {
+		if (wh->irqs[i].hwirq == hwirq) {
+			ih = &wh->irqs[i];
+			break;
+		}
+		if (!ih && (!wh->irqs[i].hwirq || !wh->irqs[i].stable))
+			ih = &wh->irqs[i];
+	}
+
+	if (!ih || ih->hwirq != hwirq) {
+		if (!ih) {
+			ih = &wh->irqs[wh->victim];
+			wh->victim = (wh->victim + 1) % LPM_WAKE_IRQS;
+		}
+		ih->hwirq = hwirq;
+		ih->period = 0;
+		ih->stable = 0;
+		ih->last_us = now_us;
+		return;
+	}
+
+	if (now_us - ih->last_us > LPM_IRQ_PERIOD_MAX_US) {
+		ih->period = 0;
+		ih->stable = 0;
+		ih->last_us = now_us;
+		return;
+	}
+
+	interval = now_us - ih->last_us;
+	ih->last_us = now_us;
+	if (!ih->period) {
+		ih->period = interval;
+		return;
+	}
+
+	/*
+	 * Occurrences taken while the CPU was already awake are not seen,
+	 * so a wakeup a few periods later still matches.
+	 */
+	mult = DIV_ROUND_CLOSEST(interval, ih->period);
+	if (mult && mult <= LPM_IRQ_MAX_MULT) {
+		period = interval / mult;
+		if (abs((int)(period - ih->period)) <= (ih->period >> 3)) {
+			ih->stable++;
+			ih->period = ih->period - (ih->period >> 2)
+					+ (period >> 2);
+			return;
+		}
+	}
+
+	ih->stable = 0;
+	ih->period = interval;
+}
+
+/*
+ * Runs on idle exit with interrupts still masked, so the interrupt that
+ * ended the sleep is still the highest pending one at the GIC.
+ */
+static void update_wake_history(struct cpuidle_device *dev,
+		struct lpm_cpu *cpu, int idx, uint64_t end_ns)
+{
+	struct wake_history *wh = &per_cpu(wake_hist, dev->cpu);
+	struct power_params *pwr = &cpu->levels[idx].pwr;
+	uint32_t hwirq = lpm_pending_hwirq();
+	enum lpm_wake_src src;
+
+	if (hwirq < LPM_HWIRQ_PPI_START)
+		src = LPM_WAKE_IPI;
+	else if (hwirq < LPM_HWIRQ_SPI_START)
+		src = LPM_WAKE_TIMER;
+	else if (hwirq < LPM_HWIRQ_SPURIOUS)
+		src = LPM_WAKE_IRQ;
+	else if (ktime_after(ns_to_ktime(end_ns),
+			     per_cpu(next_hrtimer, dev->cpu)))
+		src = LPM_WAKE_TIMER;
+	else
+		src = LPM_WAKE_UNKNOWN;
+
+	wh->src_cnt[src]++;
+	if (src == LPM_WAKE_IRQ)
+		update_irq_history(wh, hwirq, div_u64(end_ns, NSEC_PER_USEC));
+
+	if (dev->last_residency < pwr->min_residency)
+		wh->stats[idx].early++;
+	else if (idx < cpu->nlevels - 1 &&
+		 dev->last_residency > pwr->max_residency)
+		wh->stats[idx].late++;
+	else
+		wh->stats[idx].hit++;
+}
+
+static int pred_stats_get(char *buf, const struct kernel_param *kp)
+{
+	struct wake_history *wh;
+	struct lpm_cpu *lpm_cpu;
+	int cpu, i, cnt = 0;
+
+	for_each_possible_cpu(cpu) {
+		lpm_cpu = per_cpu(cpu_lpm, cpu);
+		if (!lpm_cpu)
+			continue;
+
+		wh = &per_cpu(wake_hist, cpu);
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"cpu%d timer:%u ipi:%u irq:%u unknown:%u\n",
+				cpu, wh->src_cnt[LPM_WAKE_TIMER],
+				wh->src_cnt[LPM_WAKE_IPI],
+				wh->src_cnt[LPM_WAKE_IRQ],
+				wh->src_cnt[LPM_WAKE_UNKNOWN]);
+		for (i = 0; i < lpm_cpu->nlevels; i++)
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+					"  %s hit:%u early:%u late:%u\n",
+					lpm_cpu->levels[i].name,
+					wh->stats[i].hit, wh->stats[i].early,
+					wh->stats[i].late);
+	}
+
+	return cnt;
+}
+
+static const struct kernel_param_ops pred_stats_ops = {
+	.get = pred_stats_get,
+};
+module_param_cb(pred_stats, &pred_stats_ops, NULL, 0444);
+
 static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 		struct cpuidle_driver *drv, int idx)
 {
@@ -1495,6 +1742,8 @@ static int lpm_cpuidle_enter(struct cpuidle_device *dev,
 	cpu_unprepare(cpu, idx, true);
 	dev->last_residency = ktime_us_delta(ktime_get(), start);
 	update_history(dev, idx);
+	if (success)
+		update_wake_history(dev, cpu, idx, end_time);
 	RCU_NONIDLE(trace_cpu_idle_exit(idx, ret));
 	if (lpm_prediction && cpu->lpm_prediction) {
 		histtimer_cancel();
@@ -23,6 +23,10 @@
 #define STDDEV_HIGH 1000
 #define PREMATURE_CNT_LOW 1
 #define PREMATURE_CNT_HIGH 5
+#define LPM_WAKE_IRQS 8
+#define LPM_IRQ_STABLE_CNT 3
+#define LPM_IRQ_MAX_MULT 4
+#define LPM_IRQ_PERIOD_MAX_US 1000000
 
 /* RIMPS registers */
 #define TIMER_CTRL		0x0
@@ -23,11 +23,11 @@
 #include <linux/of_fdt.h>
 #include "governor.h"
 #include "governor_memlat.h"
-#include <linux/perf_event.h>
 #include <linux/of_device.h>
 #include <linux/mutex.h>
 #include <linux/cpu.h>
 #include <linux/spinlock.h>
+#include <soc/qcom/pmu_lib.h>
 
 enum common_ev_idx {
 	INST_IDX,
@@ -46,10 +46,9 @@ enum mon_type {
 };
 
 struct event_data {
-	struct perf_event	*pevent;
+	unsigned int		event_id;
 	unsigned long		prev_count;
 	unsigned long		last_delta;
-	u64			cached_total_count;
 };
 
 struct cpu_data {
@@ -160,27 +159,21 @@ struct memlat_mon_spec {
 
 static struct workqueue_struct *memlat_wq;
 static DEFINE_PER_CPU(struct memlat_cpu_grp *, per_cpu_grp);
-static DEFINE_MUTEX(notify_lock);
-static int hp_idle_register_cnt;
-static DEFINE_PER_CPU(bool, cpu_is_idle);
-static DEFINE_PER_CPU(bool, cpu_is_hp);
 
-#define MAX_COUNT_LIM 0xFFFFFFFFFFFFFFFF
-static inline void read_event(struct event_data *event)
+/*
+ * Counters are owned by the shared PMU library, which also caches them on
+ * idle entry and hotplug, so reading an idle or offline CPU never wakes it.
+ */
+static inline void read_event(struct event_data *event, int cpu)
 {
-	u64 total, enabled, running;
+	u64 total;
 
-	if (!event->pevent)
+	if (!event->event_id)
+		return;
+
+	if (qcom_pmu_read(cpu, event->event_id, &total))
 		return;
 
-	if (!per_cpu(cpu_is_idle, event->pevent->cpu) &&
-			!per_cpu(cpu_is_hp, event->pevent->cpu)) {
-		total = perf_event_read_value(event->pevent, &enabled,
-								&running);
-		event->cached_total_count = total;
-	} else {
-		total = event->cached_total_count;
-	}
 	event->last_delta = total - event->prev_count;
 	event->prev_count = total;
 }
@@ -201,11 +194,11 @@ static void update_counts(struct memlat_cpu_grp *cpu_grp)
 
 		for (i = 0; i < NUM_COMMON_EVS; i++) {
 			cpu_grp->read_event_cpu = cpu;
-			read_event(&common_evs[i]);
+			read_event(&common_evs[i], cpu);
 			cpu_grp->read_event_cpu = -1;
 		}
 
-		if (!common_evs[STALL_IDX].pevent)
+		if (!common_evs[STALL_IDX].event_id)
 			common_evs[STALL_IDX].last_delta =
 				common_evs[CYC_IDX].last_delta;
 
@@ -225,10 +218,10 @@ static void update_counts(struct memlat_cpu_grp *cpu_grp)
 			unsigned int mon_idx =
 				cpu - cpumask_first(&mon->cpus);
 			cpu_grp->read_event_cpu = cpu;
-			read_event(&mon->miss_ev[mon_idx]);
+			read_event(&mon->miss_ev[mon_idx], cpu);
 			if (mon->wb_ev_id && mon->access_ev_id) {
-				read_event(&mon->wb_ev[mon_idx]);
-				read_event(&mon->access_ev[mon_idx]);
+				read_event(&mon->wb_ev[mon_idx], cpu);
+				read_event(&mon->access_ev[mon_idx], cpu);
 			}
 			cpu_grp->read_event_cpu = -1;
 		}
@@ -272,53 +265,37 @@ static unsigned long get_cnt(struct memlat_hwmon *hw)
 	return 0;
 }
 
-static void delete_event(struct event_data *event)
+static void delete_event(struct event_data *event, int cpu)
 {
+	if (event->event_id)
+		qcom_pmu_event_put(cpu, event->event_id);
+	event->event_id = 0;
 	event->prev_count = 0;
 	event->last_delta = 0;
-	event->cached_total_count = 0;
-	if (event->pevent) {
-		perf_event_release_kernel(event->pevent);
-		event->pevent = NULL;
-	}
 }
 
-static struct perf_event_attr *alloc_attr(void)
+static int set_event(struct event_data *ev, int cpu, unsigned int event_id)
 {
-	struct perf_event_attr *attr;
-
-	attr = kzalloc(sizeof(struct perf_event_attr), GFP_KERNEL);
-	if (!attr)
-		return attr;
-
-	attr->type = PERF_TYPE_RAW;
-	attr->size = sizeof(struct perf_event_attr);
-	attr->pinned = 1;
-
-	return attr;
-}
-
-static int set_event(struct event_data *ev, int cpu, unsigned int event_id,
-		     struct perf_event_attr *attr)
-{
-	struct perf_event *pevent;
+	u64 total = 0;
+	int ret;
 
 	if (!event_id)
 		return 0;
 
-	attr->config = event_id;
-	pevent = perf_event_create_kernel_counter(attr, cpu, NULL, NULL, NULL);
-	if (IS_ERR(pevent))
-		return PTR_ERR(pevent);
+	ret = qcom_pmu_event_get(cpu, event_id);
+	if (ret < 0)
+		return ret;
 
-	ev->pevent = pevent;
-	perf_event_enable(pevent);
+	/* The counter may already be running for another client */
+	qcom_pmu_read(cpu, event_id, &total);
+	ev->event_id = event_id;
+	ev->prev_count = total;
+	ev->last_delta = 0;
 
 	return 0;
 }
 
-static int init_common_evs(struct memlat_cpu_grp *cpu_grp,
-			   struct perf_event_attr *attr)
+static int init_common_evs(struct memlat_cpu_grp *cpu_grp)
 {
 	unsigned int cpu, i;
 	int ret = 0;
@@ -326,11 +303,9 @@ static int init_common_evs(struct memlat_cpu_grp *cpu_grp,
 	for_each_cpu(cpu, &cpu_grp->cpus) {
 		struct event_data *common_evs = to_common_evs(cpu_grp, cpu);
 
-		if (per_cpu(cpu_is_hp, cpu))
-			continue;
 		for (i = 0; i < NUM_COMMON_EVS; i++) {
 			ret = set_event(&common_evs[i], cpu,
-					cpu_grp->common_ev_ids[i], attr);
+					cpu_grp->common_ev_ids[i]);
 			if (ret < 0)
 				break;
 		}
@@ -347,7 +322,7 @@ static void free_common_evs(struct memlat_cpu_grp *cpu_grp)
 		struct event_data *common_evs = to_common_evs(cpu_grp, cpu);
 
 		for (i = 0; i < NUM_COMMON_EVS; i++)
-			delete_event(&common_evs[i]);
+			delete_event(&common_evs[i], cpu);
 	}
 }
 
@@ -386,180 +361,6 @@ static void memlat_monitor_work(struct work_struct *work)
 	mutex_unlock(&cpu_grp->mons_lock);
 }
 
-static int memlat_idle_read_events(unsigned int cpu)
-{
-	struct memlat_mon *mon;
-	struct memlat_cpu_grp *cpu_grp = per_cpu(per_cpu_grp, cpu);
-	int i, ret = 0;
-	unsigned int idx;
-	struct event_data *common_evs;
-	unsigned long flags;
-
-	if (!cpu_grp)
-		return 0;
-
-	spin_lock_irqsave(&cpu_grp->mon_active_lock, flags);
-	if (!cpu_grp->num_active_mons)
-		goto exit;
-
-	common_evs = to_common_evs(cpu_grp, cpu);
-	for (i = 0; i < NUM_COMMON_EVS; i++) {
-		if (common_evs[i].pevent)
-			ret = perf_event_read_local(common_evs[i].pevent,
-				&common_evs[i].cached_total_count, NULL, NULL);
-	}
-
-	for (i = 0; i < cpu_grp->num_mons; i++) {
-		mon = &cpu_grp->mons[i];
-		if (!mon->is_active || !mon->miss_ev ||
-				!cpumask_test_cpu(cpu, &mon->cpus)) {
-			continue;
-		}
-
-		idx = cpu - cpumask_first(&mon->cpus);
-		if (mon->miss_ev[idx].pevent)
-			ret = perf_event_read_local(mon->miss_ev[idx].pevent,
-			&mon->miss_ev[idx].cached_total_count, NULL, NULL);
-	}
-exit:
-	spin_unlock_irqrestore(&cpu_grp->mon_active_lock, flags);
-	return ret;
-}
-
-#ifdef CONFIG_HOTPLUG_CPU
-static int memlat_hp_restart_events(unsigned int cpu, bool cpu_up)
-{
-	struct perf_event_attr *attr = alloc_attr();
-	struct memlat_mon *mon;
-	struct memlat_cpu_grp *cpu_grp = per_cpu(per_cpu_grp, cpu);
-	int i, ret = 0;
-	unsigned int idx;
-	struct event_data *common_evs;
-
-	if (!attr)
-		return -ENOMEM;
-
-	if (!cpu_grp)
-		goto exit;
-
-	common_evs = to_common_evs(cpu_grp, cpu);
-	for (i = 0; i < NUM_COMMON_EVS; i++) {
-		if (cpu_up) {
-			ret = set_event(&common_evs[i], cpu,
-					cpu_grp->common_ev_ids[i], attr);
-			if (ret) {
-				pr_err("event %d not set for cpu %d ret %d\n",
-					cpu_grp->common_ev_ids[i], cpu, ret);
-				goto exit;
-			}
-		} else {
-			delete_event(&common_evs[i]);
-		}
-	}
-
-	for (i = 0; i < cpu_grp->num_mons; i++) {
-		mon = &cpu_grp->mons[i];
-		if (!mon->is_active || !mon->miss_ev ||
-				!cpumask_test_cpu(cpu, &mon->cpus))
-			continue;
-
-		idx = cpu - cpumask_first(&mon->cpus);
-		if (cpu_up) {
-			ret = set_event(&mon->miss_ev[idx], cpu,
-							mon->miss_ev_id, attr);
-			if (ret) {
-				pr_err("event %d not set for cpu %d ret %d\n",
-					mon->miss_ev[idx], cpu, ret);
-				goto exit;
-			}
-		} else {
-			delete_event(&mon->miss_ev[idx]);
-		}
-	}
-
-exit:
-	kfree(attr);
-	return ret;
-}
-
-static int memlat_event_hotplug_coming_up(unsigned int cpu)
-{
-	int ret = 0;
-	struct memlat_cpu_grp *cpu_grp = per_cpu(per_cpu_grp, cpu);
-
-	if (!cpu_grp)
-		return -ENODEV;
-	mutex_lock(&cpu_grp->mons_lock);
-	if (cpu_grp->num_active_mons) {
-		ret = memlat_hp_restart_events(cpu, true);
-		per_cpu(cpu_is_hp, cpu) = false;
-	}
-	mutex_unlock(&cpu_grp->mons_lock);
-
-	return ret;
-}
-
-static int memlat_event_hotplug_going_down(unsigned int cpu)
-{
-	struct memlat_cpu_grp *cpu_grp = per_cpu(per_cpu_grp, cpu);
-	unsigned int ret = 0;
-
-	if (!cpu_grp)
-		return -ENODEV;
-	/* avoid race between cpu hotplug and update_counts */
-	mutex_lock(&cpu_grp->mons_lock);
-	if (cpu_grp->num_active_mons) {
-		per_cpu(cpu_is_hp, cpu) = true;
-		ret = memlat_hp_restart_events(cpu, false);
-	}
-	mutex_unlock(&cpu_grp->mons_lock);
-
-	return ret;
-}
-
-static int memlat_event_cpu_hp_init(void)
-{
-	int ret = 0;
-
-	ret = cpuhp_setup_state_nocalls(CPUHP_AP_ONLINE_DYN,
-				"MEMLAT_EVENT",
-				memlat_event_hotplug_coming_up,
-				memlat_event_hotplug_going_down);
-	if (ret < 0)
-		pr_err("memlat: failed to register CPU hotplug notifier: %d\n",
-									ret);
-	else
-		ret = 0;
-	return ret;
-}
-#else
-static int memlat_event_cpu_hp_init(void) { return 0; }
-#endif
-static int memlat_idle_notif(struct notifier_block *nb, unsigned long action,
-							void *data)
-{
-	int ret = NOTIFY_OK;
-	int cpu = smp_processor_id();
-
-	switch (action) {
-	case IDLE_START:
-		__this_cpu_write(cpu_is_idle, true);
-		if (per_cpu(cpu_is_hp, cpu))
-			goto idle_exit;
-		else
-			ret = memlat_idle_read_events(cpu);
-		break;
-	case IDLE_END:
-		__this_cpu_write(cpu_is_idle, false);
-		break;
-	}
-idle_exit:
-	return ret;
-}
-static struct notifier_block memlat_event_idle_nb = {
-	.notifier_call = memlat_idle_notif,
-};
-
 static int start_hwmon(struct memlat_hwmon *hw)
 {
 	int ret = 0;
@@ -567,33 +368,12 @@ static int start_hwmon(struct memlat_hwmon *hw)
 	struct memlat_mon *mon = to_mon(hw);
 	struct memlat_cpu_grp *cpu_grp = mon->cpu_grp;
 	bool should_init_cpu_grp;
-	struct perf_event_attr *attr = alloc_attr();
 	unsigned long flags;
 
-	if (!attr)
-		return -ENOMEM;
-
 	mutex_lock(&cpu_grp->mons_lock);
 	should_init_cpu_grp = !(cpu_grp->num_active_mons);
 	if (should_init_cpu_grp) {
-		mutex_lock(&notify_lock);
-		if (!hp_idle_register_cnt) {
-			get_online_cpus();
-			for_each_cpu(cpu, cpu_possible_mask) {
-				if (!cpumask_test_cpu(cpu, cpu_online_mask))
-					per_cpu(cpu_is_hp, cpu) = true;
-			}
-			ret = memlat_event_cpu_hp_init();
-			put_online_cpus();
-			if (ret < 0) {
-				mutex_unlock(&notify_lock);
-				goto unlock_out;
-			}
-			idle_notifier_register(&memlat_event_idle_nb);
-		}
-		hp_idle_register_cnt++;
-		mutex_unlock(&notify_lock);
-		ret = init_common_evs(cpu_grp, attr);
+		ret = init_common_evs(cpu_grp);
 		if (ret < 0)
 			goto unlock_out;
 
@@ -604,21 +384,19 @@ static int start_hwmon(struct memlat_hwmon *hw)
 		for_each_cpu(cpu, &mon->cpus) {
 			unsigned int idx = cpu - cpumask_first(&mon->cpus);
 
-			if (per_cpu(cpu_is_hp, cpu))
-				continue;
 			ret = set_event(&mon->miss_ev[idx], cpu,
-					mon->miss_ev_id, attr);
+					mon->miss_ev_id);
 			if (ret < 0)
 				goto unlock_out;
 
 			if (mon->access_ev_id && mon->wb_ev_id) {
 				ret = set_event(&mon->access_ev[idx], cpu,
-						mon->access_ev_id, attr);
+						mon->access_ev_id);
 				if (ret)
 					goto unlock_out;
 
 				ret = set_event(&mon->wb_ev[idx], cpu,
-						mon->wb_ev_id, attr);
+						mon->wb_ev_id);
 				if (ret)
 					goto unlock_out;
 			}
@@ -637,7 +415,6 @@ static int start_hwmon(struct memlat_hwmon *hw)
 
 unlock_out:
 	mutex_unlock(&cpu_grp->mons_lock);
-	kfree(attr);
 
 	return ret;
 }
@@ -660,11 +437,11 @@ static void stop_hwmon(struct memlat_hwmon *hw)
 		struct dev_stats *devstats = to_devstats(mon, cpu);
 
 		if (mon->miss_ev) {
-			delete_event(&mon->miss_ev[idx]);
+			delete_event(&mon->miss_ev[idx], cpu);
 			if (mon->wb_ev)
-				delete_event(&mon->wb_ev[idx]);
+				delete_event(&mon->wb_ev[idx], cpu);
 			if (mon->access_ev)
-				delete_event(&mon->access_ev[idx]);
+				delete_event(&mon->access_ev[idx], cpu);
 		}
 		devstats->inst_count = 0;
 		devstats->mem_count = 0;
@@ -676,21 +453,8 @@ static void stop_hwmon(struct memlat_hwmon *hw)
 	if (!cpu_grp->num_active_mons) {
 		cancel_delayed_work(&cpu_grp->work);
 		free_common_evs(cpu_grp);
-		mutex_lock(&notify_lock);
-		hp_idle_register_cnt--;
-		mutex_unlock(&notify_lock);
 	}
 	mutex_unlock(&cpu_grp->mons_lock);
-	mutex_lock(&notify_lock);
-	if (!hp_idle_register_cnt) {
-		cpuhp_remove_state_nocalls(CPUHP_AP_ONLINE_DYN);
-		idle_notifier_unregister(&memlat_event_idle_nb);
-		for_each_cpu(cpu, cpu_possible_mask) {
-			per_cpu(cpu_is_hp, cpu) = false;
-			per_cpu(cpu_is_idle, cpu) = false;
-		}
-	}
-	mutex_unlock(&notify_lock);
 }
 
 /**
@@ -916,6 +680,8 @@ static int memlat_mon_probe(struct platform_device *pdev, bool is_compute)
 		ret = -ENODEV;
 		goto unlock_out;
 	}
+	hw->bw_of_node = of_parse_phandle(dev->of_node,
+					  "qcom,bw-target-dev", 0);
 	hw->dev = dev;
 	hw->num_cores = num_cpus;
 	hw->should_ignore_df_monitor = true;
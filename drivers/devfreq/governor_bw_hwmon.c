@@ -455,6 +455,8 @@ static unsigned long get_bw_and_set_irq(struct hwmon_node *node,
 		*ab = 0;
 
 	*freq = (new_bw * 100) / io_percent;
+	WRITE_ONCE(hw->meas_mbps, meas_mbps);
+	WRITE_ONCE(hw->vote, *freq);
 	trace_bw_hwmon_update(dev_name(node->hw->df->dev.parent),
 				new_bw,
 				*freq,
@@ -489,6 +491,34 @@ static struct hwmon_node *find_hwmon_node(struct devfreq *df)
 	return found;
 }
 
+/*
+ * Lets other governors voting for the same memory level (memlat) see what
+ * this governor measured and voted in its last decision window, so the two
+ * don't have to sample the traffic again or fight each other's votes.
+ */
+int bw_hwmon_get_last(struct device_node *of_node, unsigned long *meas_mbps,
+		      unsigned long *vote)
+{
+	struct hwmon_node *node;
+	int ret = -ENODEV;
+
+	mutex_lock(&list_lock);
+	list_for_each_entry(node, &hwmon_list, list) {
+		if (node->hw->of_node != of_node)
+			continue;
+		if (node->mon_started) {
+			*meas_mbps = READ_ONCE(node->hw->meas_mbps);
+			*vote = READ_ONCE(node->hw->vote);
+			ret = 0;
+		}
+		break;
+	}
+	mutex_unlock(&list_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(bw_hwmon_get_last);
+
 int update_bw_hwmon(struct bw_hwmon *hwmon)
 {
 	struct devfreq *df;
@@ -29,6 +29,8 @@
  * @df:				Devfreq node that this HW monitor is being
  *				used for. NULL when not actively in use and
  *				non-NULL when in use.
+ * @meas_mbps:			Bandwidth measured in the last decision window.
+ * @vote:			Frequency voted by the last decision.
  *
  * One of dev, of_node or governor_name needs to be specified for a
  * successful registration.
@@ -55,12 +57,16 @@ struct bw_hwmon {
 	unsigned long		down_wake_mbps;
 	unsigned int		down_cnt;
 	struct devfreq		*df;
+	unsigned long		meas_mbps;
+	unsigned long		vote;
 };
 
 #if IS_ENABLED(CONFIG_DEVFREQ_GOV_QCOM_BW_HWMON)
 int register_bw_hwmon(struct device *dev, struct bw_hwmon *hwmon);
 int update_bw_hwmon(struct bw_hwmon *hwmon);
 int bw_hwmon_sample_end(struct bw_hwmon *hwmon);
+int bw_hwmon_get_last(struct device_node *of_node, unsigned long *meas_mbps,
+		      unsigned long *vote);
 #else
 static inline int register_bw_hwmon(struct device *dev,
 					struct bw_hwmon *hwmon)
@@ -75,6 +81,12 @@ static inline int bw_hwmon_sample_end(struct bw_hwmon *hwmon)
 {
 	return 0;
 }
+static inline int bw_hwmon_get_last(struct device_node *of_node,
+				    unsigned long *meas_mbps,
+				    unsigned long *vote)
+{
+	return -ENODEV;
+}
 #endif
 
 #endif /* _GOVERNOR_BW_HWMON_H */
@@ -23,6 +23,7 @@
 #include <linux/devfreq.h>
 #include "governor.h"
 #include "governor_memlat.h"
+#include "governor_bw_hwmon.h"
 
 #include <trace/events/power.h>
 
@@ -31,6 +32,7 @@ struct memlat_node {
 	unsigned int		stall_floor;
 	unsigned int		wb_pct_thres;
 	unsigned int		wb_filter_ratio;
+	unsigned int		joint_stall_pct;
 	bool			mon_started;
 	bool			already_zero;
 	struct list_head	list;
@@ -261,6 +263,34 @@ static void gov_stop(struct devfreq *df)
 	hw->df = NULL;
 }
 
+/*
+ * When the memory level is also bandwidth governed, a latency vote above what
+ * the bandwidth governor already asked for only pays off if the CPU is really
+ * stalling on memory. Otherwise it over-votes the level and the two governors
+ * keep undoing each other's decisions.
+ */
+static unsigned long memlat_joint_vote(struct devfreq *df,
+				       struct memlat_node *node,
+				       struct dev_stats *stats,
+				       unsigned int ratio,
+				       unsigned long lat_vote)
+{
+	struct memlat_hwmon *hw = node->hw;
+	unsigned long meas_mbps = 0, bw_vote = 0, vote = lat_vote;
+
+	bw_hwmon_get_last(hw->bw_of_node, &meas_mbps, &bw_vote);
+
+	if (lat_vote > bw_vote && stats->stall_pct < node->joint_stall_pct)
+		vote = min(lat_vote, max_t(unsigned long, bw_vote,
+					   hw->freq_map[0].target_freq));
+
+	trace_memlat_joint_update(dev_name(df->dev.parent), stats->id,
+				  stats->stall_pct, ratio, meas_mbps,
+				  bw_vote, lat_vote, vote);
+
+	return vote;
+}
+
 static int devfreq_memlat_get_freq(struct devfreq *df,
 					unsigned long *freq)
 {
@@ -268,7 +298,7 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 	struct memlat_node *node = df->data;
 	struct memlat_hwmon *hw = node->hw;
 	unsigned long max_freq = 0;
-	unsigned int ratio;
+	unsigned int ratio, lat_ratio = 0;
 
 	/*
 	 * node->resume_freq is set to 0 at the end of resume (after the update)
@@ -307,6 +337,7 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 		      && ratio <= node->wb_filter_ratio))
 		      && (hw->core_stats[i].freq > max_freq)) {
 			lat_dev = i;
+			lat_ratio = ratio;
 			max_freq = hw->core_stats[i].freq;
 		}
 	}
@@ -314,7 +345,11 @@ static int devfreq_memlat_get_freq(struct devfreq *df,
 	if (max_freq)
 		max_freq = core_to_dev_freq(node, max_freq);
 
-	if (max_freq || !node->already_zero) {
+	if (max_freq && hw->bw_of_node && node->joint_stall_pct) {
+		max_freq = memlat_joint_vote(df, node,
+					     &hw->core_stats[lat_dev],
+					     lat_ratio, max_freq);
+	} else if (max_freq || !node->already_zero) {
 		trace_memlat_dev_update(dev_name(df->dev.parent),
 					hw->core_stats[lat_dev].id,
 					hw->core_stats[lat_dev].inst_count,
@@ -341,6 +376,9 @@ static DEVICE_ATTR_RW(wb_pct_thres);
 show_attr(wb_filter_ratio);
 store_attr(wb_filter_ratio, 0U, 50000U);
 static DEVICE_ATTR_RW(wb_filter_ratio);
+show_attr(joint_stall_pct);
+store_attr(joint_stall_pct, 0U, 100U);
+static DEVICE_ATTR_RW(joint_stall_pct);
 
 static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_ratio_ceil.attr,
@@ -348,6 +386,7 @@ static struct attribute *memlat_dev_attr[] = {
 	&dev_attr_freq_map.attr,
 	&dev_attr_wb_pct_thres.attr,
 	&dev_attr_wb_filter_ratio.attr,
+	&dev_attr_joint_stall_pct.attr,
 	NULL,
 };
 
@@ -520,6 +559,7 @@ static struct memlat_node *register_common(struct device *dev,
 	node->ratio_ceil = 10;
 	node->wb_pct_thres = 100;
 	node->wb_filter_ratio = 25000;
+	node->joint_stall_pct = 50;
 	node->hw = hw;
 
 	if (hw->get_child_of_node)
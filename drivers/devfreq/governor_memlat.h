@@ -50,6 +50,10 @@ struct core_dev_map {
  *				hardware monitor.
  * @core_stats:			Array containing instruction count, memory
  *				accesses and effective frequency for each core.
+ * @bw_of_node:			Optional OF node of the bandwidth governed
+ *				device for the same memory level. When set,
+ *				latency votes are made jointly with the last
+ *				bw_hwmon decision for that device.
  *
  * One of dev or of_node needs to be specified for a successful registration.
  *
@@ -69,6 +73,7 @@ struct memlat_hwmon {
 
 	struct devfreq		*df;
 	struct core_dev_map	*freq_map;
+	struct device_node	*bw_of_node;
 	bool			should_ignore_df_monitor;
 };
 
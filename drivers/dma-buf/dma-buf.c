@@ -157,6 +157,116 @@ static struct file_system_type dma_buf_fs_type = {
 	.kill_sb = kill_anon_super,
 };
 
+/*
+ * The CPU may access the buffer from here on. Device mappings that were made
+ * CPU-clean before this can no longer skip their cache maintenance.
+ */
+static void dma_buf_mark_cpu_access(struct dma_buf *dmabuf)
+{
+	struct msm_dma_buf *msm_dma_buf = to_msm_dma_buf(dmabuf);
+
+	spin_lock(&msm_dma_buf->cpu_lock);
+	msm_dma_buf->cpu_full_gen = atomic_inc_return(&msm_dma_buf->cpu_gen);
+	msm_dma_buf->nr_cpu_ranges = 0;
+	spin_unlock(&msm_dma_buf->cpu_lock);
+}
+
+/*
+ * Same as dma_buf_mark_cpu_access(), for when the CPU only accesses part of
+ * the buffer. The ranges are kept sorted and coalesced; when they don't fit
+ * anymore the two closest ones are merged, which only ever grows them.
+ */
+static void dma_buf_mark_cpu_access_range(struct dma_buf *dmabuf,
+					  unsigned int offset,
+					  unsigned int len)
+{
+	struct msm_dma_buf *msm_dma_buf = to_msm_dma_buf(dmabuf);
+	struct dma_buf_range *r = msm_dma_buf->cpu_ranges;
+	struct dma_buf_range tmp[DMA_BUF_CPU_RANGES_MAX + 1];
+	unsigned int start, end, gap, min_gap;
+	int i, j, k, nr;
+
+	if (offset >= dmabuf->size || !len) {
+		dma_buf_mark_cpu_access(dmabuf);
+		return;
+	}
+
+	start = offset;
+	end = offset + min_t(size_t, len, dmabuf->size - offset);
+
+	spin_lock(&msm_dma_buf->cpu_lock);
+	atomic_inc(&msm_dma_buf->cpu_gen);
+	nr = msm_dma_buf->nr_cpu_ranges;
+
+	/* skip the ranges that end before the new one, absorb the next ones */
+	for (i = 0; i < nr && r[i].offset + r[i].len < start; i++)
+		;
+	for (j = i; j < nr && r[j].offset <= end; j++) {
+		start = min(start, r[j].offset);
+		end = max(end, r[j].offset + r[j].len);
+	}
+
+	memcpy(tmp, r, i * sizeof(*r));
+	tmp[i].offset = start;
+	tmp[i].len = end - start;
+	memcpy(&tmp[i + 1], &r[j], (nr - j) * sizeof(*r));
+	nr = i + 1 + nr - j;
+
+	if (nr > DMA_BUF_CPU_RANGES_MAX) {
+		min_gap = UINT_MAX;
+		for (i = 0, k = 0; i < nr - 1; i++) {
+			gap = tmp[i + 1].offset - (tmp[i].offset + tmp[i].len);
+			if (gap < min_gap) {
+				min_gap = gap;
+				k = i;
+			}
+		}
+		tmp[k].len = tmp[k + 1].offset + tmp[k + 1].len - tmp[k].offset;
+		memmove(&tmp[k + 1], &tmp[k + 2], (nr - k - 2) * sizeof(*tmp));
+		nr--;
+	}
+
+	memcpy(r, tmp, nr * sizeof(*r));
+	msm_dma_buf->nr_cpu_ranges = nr;
+	spin_unlock(&msm_dma_buf->cpu_lock);
+}
+
+/**
+ * dma_buf_cpu_dirty_ranges - Get the parts of a buffer the CPU may have
+ * dirtied in its caches.
+ * @dmabuf:	[in]	buffer to check.
+ * @since:	[in]	CPU access generation at which the caller last cleaned
+ *			the caches for the buffer.
+ * @ranges:	[out]	up to DMA_BUF_CPU_RANGES_MAX ranges the CPU accessed.
+ * @gen:	[out]	current CPU access generation, to be passed as @since
+ *			once the caller has cleaned @ranges.
+ *
+ * Returns the number of entries filled in @ranges, 0 if the CPU didn't access
+ * the buffer since @since, or -ERANGE if it may have dirtied all of it.
+ */
+int dma_buf_cpu_dirty_ranges(struct dma_buf *dmabuf, int since,
+			     struct dma_buf_range *ranges, int *gen)
+{
+	struct msm_dma_buf *msm_dma_buf = to_msm_dma_buf(dmabuf);
+	int nr;
+
+	spin_lock(&msm_dma_buf->cpu_lock);
+	*gen = atomic_read(&msm_dma_buf->cpu_gen);
+	if (since == *gen) {
+		nr = 0;
+	} else if ((int)(since - msm_dma_buf->cpu_full_gen) < 0 ||
+		   !msm_dma_buf->nr_cpu_ranges) {
+		nr = -ERANGE;
+	} else {
+		nr = msm_dma_buf->nr_cpu_ranges;
+		memcpy(ranges, msm_dma_buf->cpu_ranges, nr * sizeof(*ranges));
+	}
+	spin_unlock(&msm_dma_buf->cpu_lock);
+
+	return nr;
+}
+EXPORT_SYMBOL_GPL(dma_buf_cpu_dirty_ranges);
+
 static int dma_buf_mmap_internal(struct file *file, struct vm_area_struct *vma)
 {
 	struct dma_buf *dmabuf;
@@ -175,6 +285,8 @@ static int dma_buf_mmap_internal(struct file *file, struct vm_area_struct *vma)
 	    dmabuf->size >> PAGE_SHIFT)
 		return -EINVAL;
 
+	dma_buf_mark_cpu_access(dmabuf);
+
 	return dmabuf->ops->mmap(dmabuf, vma);
 }
 
@@ -606,6 +718,7 @@ struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info)
 		goto err_dmabuf;
 	}
 	msm_dma_buf->i_ino = file_inode(file)->i_ino;
+	spin_lock_init(&msm_dma_buf->cpu_lock);
 
 	file->f_mode |= FMODE_LSEEK;
 	dmabuf->file = file;
@@ -846,6 +959,7 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 		    attach->dir != DMA_BIDIRECTIONAL)
 			return ERR_PTR(-EBUSY);
 
+		atomic_inc(&to_msm_dma_buf(attach->dmabuf)->map_hits);
 		return attach->sgt;
 	}
 
@@ -856,6 +970,7 @@ struct sg_table *dma_buf_map_attachment(struct dma_buf_attachment *attach,
 	if (!IS_ERR(sg_table) && attach->dmabuf->ops->cache_sgt_mapping) {
 		attach->sgt = sg_table;
 		attach->dir = direction;
+		atomic_inc(&to_msm_dma_buf(attach->dmabuf)->map_misses);
 	}
 
 	return sg_table;
@@ -1031,6 +1146,8 @@ int dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 	if (WARN_ON(!dmabuf))
 		return -EINVAL;
 
+	dma_buf_mark_cpu_access(dmabuf);
+
 	if (dmabuf->ops->begin_cpu_access)
 		ret = dmabuf->ops->begin_cpu_access(dmabuf, direction);
 
@@ -1054,6 +1171,8 @@ int dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 	if (WARN_ON(!dmabuf))
 		return -EINVAL;
 
+	dma_buf_mark_cpu_access_range(dmabuf, offset, len);
+
 	if (dmabuf->ops->begin_cpu_access_partial)
 		ret = dmabuf->ops->begin_cpu_access_partial(dmabuf, direction,
 							    offset, len);
@@ -1088,6 +1207,8 @@ int dma_buf_end_cpu_access(struct dma_buf *dmabuf,
 
 	WARN_ON(!dmabuf);
 
+	dma_buf_mark_cpu_access(dmabuf);
+
 	if (dmabuf->ops->end_cpu_access)
 		ret = dmabuf->ops->end_cpu_access(dmabuf, direction);
 
@@ -1103,6 +1224,8 @@ int dma_buf_end_cpu_access_partial(struct dma_buf *dmabuf,
 
 	WARN_ON(!dmabuf);
 
+	dma_buf_mark_cpu_access_range(dmabuf, offset, len);
+
 	if (dmabuf->ops->end_cpu_access_partial)
 		ret = dmabuf->ops->end_cpu_access_partial(dmabuf, direction,
 							  offset, len);
@@ -1191,6 +1314,8 @@ int dma_buf_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma,
 	vma->vm_file = dmabuf->file;
 	vma->vm_pgoff = pgoff;
 
+	dma_buf_mark_cpu_access(dmabuf);
+
 	ret = dmabuf->ops->mmap(dmabuf, vma);
 	if (ret) {
 		/* restore old parameters on failure */
@@ -1237,6 +1362,8 @@ void *dma_buf_vmap(struct dma_buf *dmabuf)
 
 	BUG_ON(dmabuf->vmap_ptr);
 
+	dma_buf_mark_cpu_access(dmabuf);
+
 	ptr = dmabuf->ops->vmap(dmabuf);
 	if (WARN_ON_ONCE(IS_ERR(ptr)))
 		ptr = NULL;
@@ -1378,9 +1505,14 @@ static int dma_buf_debug_show(struct seq_file *s, void *unused)
 			attach_count++;
 		}
 
-		seq_printf(s, "Total %d devices attached\n\n",
+		seq_printf(s, "Total %d devices attached\n",
 				attach_count);
 
+		seq_printf(s, "Mapping cache: %d hits %d misses %d cache ops skipped\n\n",
+			   atomic_read(&to_msm_dma_buf(buf_obj)->map_hits),
+			   atomic_read(&to_msm_dma_buf(buf_obj)->map_misses),
+			   atomic_read(&to_msm_dma_buf(buf_obj)->cmo_skips));
+
 		dma_buf_ref_show(s, to_msm_dma_buf(buf_obj));
 
 		count++;
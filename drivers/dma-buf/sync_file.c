@@ -14,16 +14,31 @@
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/anon_inodes.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/sort.h>
 #include <linux/sync_file.h>
 #include <uapi/linux/sync_file.h>
 
+/* Nested fence arrays deeper than this are kept as they are */
+#define SYNC_FILE_MAX_FLATTEN_DEPTH	4
+
 static const struct file_operations sync_file_fops;
+static struct kmem_cache *sync_file_cache;
+
+static struct {
+	atomic_long_t merges;
+	atomic_long_t fences_in;
+	atomic_long_t fences_out;
+	atomic_long_t nested;
+	int max_depth;
+} sync_file_stats;
 
 static struct sync_file *sync_file_alloc(void)
 {
 	struct sync_file *sync_file;
 
-	sync_file = kzalloc(sizeof(*sync_file), GFP_KERNEL);
+	sync_file = kmem_cache_zalloc(sync_file_cache, GFP_KERNEL);
 	if (!sync_file)
 		return NULL;
 
@@ -39,7 +54,7 @@ static struct sync_file *sync_file_alloc(void)
 	return sync_file;
 
 err:
-	kfree(sync_file);
+	kmem_cache_free(sync_file_cache, sync_file);
 	return NULL;
 }
 
@@ -186,15 +201,58 @@ static struct dma_fence **get_fences(struct sync_file *sync_file,
 	return &sync_file->fence;
 }
 
-static void add_fence(struct dma_fence **fences,
-		      int *i, struct dma_fence *fence)
+/*
+ * Count the unsignaled leaf fences below @fence, looking through nested
+ * fence arrays up to SYNC_FILE_MAX_FLATTEN_DEPTH.
+ */
+static int sync_file_count_fences(struct dma_fence *fence, int depth,
+				  int *max_depth)
+{
+	struct dma_fence_array *array;
+	int i, num = 0;
+
+	if (depth > *max_depth)
+		*max_depth = depth;
+
+	if (!dma_fence_is_array(fence) || depth >= SYNC_FILE_MAX_FLATTEN_DEPTH)
+		return dma_fence_is_signaled(fence) ? 0 : 1;
+
+	array = to_dma_fence_array(fence);
+	for (i = 0; i < array->num_fences; i++)
+		num += sync_file_count_fences(array->fences[i], depth + 1,
+					      max_depth);
+	return num;
+}
+
+static void sync_file_collect_fences(struct dma_fence *fence, int depth,
+				     struct dma_fence **fences, int *i)
 {
-	fences[*i] = fence;
+	struct dma_fence_array *array;
+	int j;
 
-	if (!dma_fence_is_signaled(fence)) {
-		dma_fence_get(fence);
-		(*i)++;
+	if (!dma_fence_is_array(fence) ||
+	    depth >= SYNC_FILE_MAX_FLATTEN_DEPTH) {
+		if (!dma_fence_is_signaled(fence))
+			fences[(*i)++] = fence;
+		return;
 	}
+
+	array = to_dma_fence_array(fence);
+	for (j = 0; j < array->num_fences; j++)
+		sync_file_collect_fences(array->fences[j], depth + 1,
+					 fences, i);
+}
+
+static int sync_file_fence_cmp(const void *a, const void *b)
+{
+	const struct dma_fence *fa = *(const struct dma_fence **)a;
+	const struct dma_fence *fb = *(const struct dma_fence **)b;
+
+	if (fa->context < fb->context)
+		return -1;
+	if (fa->context > fb->context)
+		return 1;
+	return 0;
 }
 
 /**
@@ -206,68 +264,63 @@ static void add_fence(struct dma_fence **fences,
  * Creates a new sync_file which contains copies of all the fences in both
  * @a and @b.  @a and @b remain valid, independent sync_file. Returns the
  * new merged sync_file or NULL in case of error.
+ *
+ * Fence arrays below @a and @b are flattened, so merging the result again
+ * never nests, and only the latest fence of each context is kept.
  */
 static struct sync_file *sync_file_merge(const char *name, struct sync_file *a,
 					 struct sync_file *b)
 {
 	struct sync_file *sync_file;
-	struct dma_fence **fences = NULL, **nfences, **a_fences, **b_fences;
-	int i = 0, i_a, i_b, num_fences, a_num_fences, b_num_fences;
+	struct dma_fence **fences = NULL, **nfences;
+	int i = 0, j, num_fences, a_num_fences, b_num_fences, depth = 0;
 
 	sync_file = sync_file_alloc();
 	if (!sync_file)
 		return NULL;
 
-	a_fences = get_fences(a, &a_num_fences);
-	b_fences = get_fences(b, &b_num_fences);
+	a_num_fences = sync_file_count_fences(a->fence, 0, &depth);
+	b_num_fences = sync_file_count_fences(b->fence, 0, &depth);
 	if (a_num_fences > INT_MAX - b_num_fences)
 		goto err;
 
-	num_fences = a_num_fences + b_num_fences;
+	num_fences = max(a_num_fences + b_num_fences, 1);
 
 	fences = kcalloc(num_fences, sizeof(*fences), GFP_KERNEL);
 	if (!fences)
 		goto err;
 
 	/*
-	 * Assume sync_file a and b are both ordered and have no
-	 * duplicates with the same context.
-	 *
-	 * If a sync_file can only be created with sync_file_merge
-	 * and sync_file_create, this is a reasonable assumption.
+	 * Fences may have signaled since they were counted, the collected
+	 * set can only be smaller.
 	 */
-	for (i_a = i_b = 0; i_a < a_num_fences && i_b < b_num_fences; ) {
-		struct dma_fence *pt_a = a_fences[i_a];
-		struct dma_fence *pt_b = b_fences[i_b];
-
-		if (pt_a->context < pt_b->context) {
-			add_fence(fences, &i, pt_a);
-
-			i_a++;
-		} else if (pt_a->context > pt_b->context) {
-			add_fence(fences, &i, pt_b);
-
-			i_b++;
-		} else {
-			if (__dma_fence_is_later(pt_a->seqno, pt_b->seqno,
-						 pt_a->ops))
-				add_fence(fences, &i, pt_a);
-			else
-				add_fence(fences, &i, pt_b);
-
-			i_a++;
-			i_b++;
+	sync_file_collect_fences(a->fence, 0, fences, &i);
+	sync_file_collect_fences(b->fence, 0, fences, &i);
+	sort(fences, i, sizeof(*fences), sync_file_fence_cmp, NULL);
+
+	/* Keep the latest fence of each context */
+	num_fences = i;
+	for (i = 0, j = 0; j < num_fences; j++) {
+		if (i && fences[i - 1]->context == fences[j]->context) {
+			if (dma_fence_is_later(fences[j], fences[i - 1]))
+				fences[i - 1] = fences[j];
+			continue;
 		}
+		fences[i++] = fences[j];
 	}
+	for (j = 0; j < i; j++)
+		dma_fence_get(fences[j]);
 
-	for (; i_a < a_num_fences; i_a++)
-		add_fence(fences, &i, a_fences[i_a]);
-
-	for (; i_b < b_num_fences; i_b++)
-		add_fence(fences, &i, b_fences[i_b]);
+	atomic_long_inc(&sync_file_stats.merges);
+	atomic_long_add(a_num_fences + b_num_fences, &sync_file_stats.fences_in);
+	atomic_long_add(i, &sync_file_stats.fences_out);
+	if (depth > 1)
+		atomic_long_inc(&sync_file_stats.nested);
+	if (depth > READ_ONCE(sync_file_stats.max_depth))
+		WRITE_ONCE(sync_file_stats.max_depth, depth);
 
 	if (i == 0)
-		fences[i++] = dma_fence_get(a_fences[0]);
+		fences[i++] = dma_fence_get(a->fence);
 
 	if (num_fences > i) {
 		nfences = krealloc(fences, i * sizeof(*fences),
@@ -300,7 +353,7 @@ static int sync_file_release(struct inode *inode, struct file *file)
 	if (test_bit(POLL_ENABLED, &sync_file->flags))
 		dma_fence_remove_callback(sync_file->fence, &sync_file->cb);
 	dma_fence_put(sync_file->fence);
-	kfree(sync_file);
+	kmem_cache_free(sync_file_cache, sync_file);
 
 	return 0;
 }
@@ -483,3 +536,28 @@ static const struct file_operations sync_file_fops = {
 	.unlocked_ioctl = sync_file_ioctl,
 	.compat_ioctl = sync_file_ioctl,
 };
+
+static int sync_file_stats_show(struct seq_file *s, void *unused)
+{
+	seq_printf(s, "merges: %ld\n",
+		   atomic_long_read(&sync_file_stats.merges));
+	seq_printf(s, "fences in: %ld\n",
+		   atomic_long_read(&sync_file_stats.fences_in));
+	seq_printf(s, "fences out: %ld\n",
+		   atomic_long_read(&sync_file_stats.fences_out));
+	seq_printf(s, "nested arrays flattened: %ld\n",
+		   atomic_long_read(&sync_file_stats.nested));
+	seq_printf(s, "max array depth: %d\n",
+		   READ_ONCE(sync_file_stats.max_depth));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(sync_file_stats);
+
+static int __init sync_file_init(void)
+{
+	sync_file_cache = KMEM_CACHE(sync_file, SLAB_PANIC);
+	debugfs_create_file("sync_file_stats", 0444, NULL, NULL,
+			    &sync_file_stats_fops);
+	return 0;
+}
+subsys_initcall(sync_file_init);
@@ -78,6 +78,48 @@ void anakin_drm_notify(int var, int value)
 }
 EXPORT_SYMBOL(anakin_drm_notify);
 
+// vsync for input batching
+static ATOMIC_NOTIFIER_HEAD(anakin_vsync_notifier_list);
+
+int anakin_drm_register_vsync_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&anakin_vsync_notifier_list, nb);
+}
+EXPORT_SYMBOL(anakin_drm_register_vsync_notifier);
+
+int anakin_drm_unregister_vsync_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&anakin_vsync_notifier_list, nb);
+}
+EXPORT_SYMBOL(anakin_drm_unregister_vsync_notifier);
+
+void anakin_drm_notify_vsync(ktime_t timestamp)
+{
+	atomic_notifier_call_chain(&anakin_vsync_notifier_list, 0, &timestamp);
+}
+EXPORT_SYMBOL(anakin_drm_notify_vsync);
+
+// wake hint from input drivers, lets the display start powering up early
+static ATOMIC_NOTIFIER_HEAD(anakin_wake_notifier_list);
+
+int anakin_drm_register_wake_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&anakin_wake_notifier_list, nb);
+}
+EXPORT_SYMBOL(anakin_drm_register_wake_notifier);
+
+int anakin_drm_unregister_wake_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&anakin_wake_notifier_list, nb);
+}
+EXPORT_SYMBOL(anakin_drm_unregister_wake_notifier);
+
+void anakin_drm_notify_wake(unsigned int hold_ms)
+{
+	atomic_notifier_call_chain(&anakin_wake_notifier_list, 0, &hold_ms);
+}
+EXPORT_SYMBOL(anakin_drm_notify_wake);
+
 static ssize_t ghbm_on_requested_show(struct class *class,
 					struct class_attribute *attr,
 					char *buf)
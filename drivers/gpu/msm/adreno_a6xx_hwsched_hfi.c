@@ -151,6 +151,36 @@ static void a6xx_receive_ack_async(struct adreno_device *adreno_dev, void *rcvd)
 			MSG_HDR_GET_SEQNUM(waiters[i]));
 }
 
+/* Convert always on counter ticks to a log2 microsecond histogram bucket */
+static int gpu_hist_bucket(u64 start, u64 end)
+{
+	u64 usecs;
+
+	if (end <= start)
+		return 0;
+
+	usecs = (end - start) * 10;
+	do_div(usecs, 192);
+
+	return min_t(int, fls64(usecs), KGSL_GPU_HIST_BUCKETS - 1);
+}
+
+/*
+ * Fold the retire timestamps from the GMU into the per-process histograms.
+ * Only the f2h thread updates these buckets so no locking is needed.
+ */
+static void update_retire_stats(struct kgsl_context *context,
+		struct hfi_ts_retire_cmd *cmd)
+{
+	struct kgsl_gpu_latency_stats *stats = &context->proc_priv->gpu_stats;
+
+	atomic_dec_if_positive(&stats->inflight);
+
+	stats->submit_to_start[gpu_hist_bucket(cmd->submitted_to_rb,
+						cmd->sop)]++;
+	stats->start_to_retire[gpu_hist_bucket(cmd->sop, cmd->eop)]++;
+}
+
 static void log_profiling_info(struct adreno_device *adreno_dev, u32 *rcvd)
 {
 	struct hfi_ts_retire_cmd *cmd = (struct hfi_ts_retire_cmd *)rcvd;
@@ -170,6 +200,7 @@ static void log_profiling_info(struct adreno_device *adreno_dev, u32 *rcvd)
 	info.retired_on_gmu = cmd->retired_on_gmu;
 
 	trace_adreno_cmdbatch_retired(context, &info, 0, 0, 0);
+	update_retire_stats(context, cmd);
 	kgsl_context_put(context);
 }
 
@@ -1170,6 +1201,15 @@ static int hfi_context_register(struct adreno_device *adreno_dev,
 	return 0;
 }
 
+/* Submissions are serialized by the hwsched dispatcher mutex */
+static void update_submit_stats(struct kgsl_context *context)
+{
+	struct kgsl_gpu_latency_stats *stats = &context->proc_priv->gpu_stats;
+	int depth = atomic_inc_return(&stats->inflight) - 1;
+
+	stats->queue_depth[min_t(int, depth, KGSL_GPU_HIST_BUCKETS - 1)]++;
+}
+
 #define HFI_DSP_IRQ_BASE 2
 
 #define DISPQ_IRQ_BIT(_idx) BIT((_idx) + HFI_DSP_IRQ_BASE)
@@ -1260,6 +1300,10 @@ int a6xx_hwsched_submit_cmdobj(struct adreno_device *adreno_dev,
 
 	cmdobj->submit_ticks = time.ticks;
 
+	/* A replay after recovery is still waiting on its original retire */
+	if (!test_bit(KGSL_FT_REPLAY, &cmdobj->fault_policy))
+		update_submit_stats(drawobj->context);
+
 	/* Send interrupt to GMU to receive the message */
 	gmu_core_regwrite(KGSL_DEVICE(adreno_dev), A6XX_GMU_HOST2GMU_INTR_SET,
 		DISPQ_IRQ_BIT(drawobj->context->gmu_dispatch_queue));
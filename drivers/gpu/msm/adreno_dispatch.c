@@ -50,6 +50,18 @@ unsigned int adreno_drawobj_timeout = 2000;
 /* Interval for reading and comparing fault detection registers */
 static unsigned int _fault_timer_interval = 200;
 
+/*
+ * Queue to submit delay (in microseconds) of a command that counts as a
+ * priority inversion if a lower priority ringbuffer held the GPU meanwhile
+ */
+static unsigned int _prio_inversion_threshold_us = 2000;
+
+/* Number of priority inversions seen since boot */
+static unsigned int _prio_inversion_count;
+
+/* Number of commands issued directly from the submitting thread */
+static unsigned int _fastpath_count;
+
 /* Use a kmem cache to speed up allocations for dispatcher jobs */
 static struct kmem_cache *jobs_cache;
 
@@ -304,8 +316,10 @@ static void _retire_timestamp(struct kgsl_drawobj *drawobj)
 				context->id, drawobj->timestamp,
 				!!(drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME));
 
-	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME)
+	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME) {
 		atomic64_inc(&context->proc_priv->frame_count);
+		kgsl_pwrscale_frame_retired(device);
+	}
 
 	/*
 	 * For A3xx we still get the rptr from the CP_RB_RPTR instead of
@@ -562,6 +576,32 @@ static int dispatcher_queue_context(struct adreno_device *adreno_dev,
 	return 0;
 }
 
+/*
+ * A command that sat in its context queue for longer than the threshold
+ * while a lower priority ringbuffer still had work on the GPU was starved
+ * by that ringbuffer. This typically means preemption is disabled or could
+ * not kick in. Must be called with the device mutex held.
+ */
+static void _check_prio_inversion(struct kgsl_drawobj_cmd *cmdobj,
+		struct adreno_ringbuffer *rb, struct adreno_ringbuffer *cur_rb)
+{
+	s64 wait_us;
+
+	if (!cur_rb || cur_rb == rb || cur_rb->id < rb->id)
+		return;
+
+	if (!cur_rb->dispatch_q.inflight)
+		return;
+
+	wait_us = ktime_us_delta(ktime_get(), cmdobj->queue_time);
+	if (wait_us < _prio_inversion_threshold_us)
+		return;
+
+	_prio_inversion_count++;
+	trace_dispatch_prio_inversion(DRAWOBJ(cmdobj), rb->id, cur_rb->id,
+		cur_rb->dispatch_q.inflight, wait_us);
+}
+
 /**
  * sendcmd() - Send a drawobj to the GPU hardware
  * @dispatcher: Pointer to the adreno dispatcher struct
@@ -581,6 +621,7 @@ static int sendcmd(struct adreno_device *adreno_dev,
 	struct adreno_dispatcher_drawqueue *dispatch_q =
 				ADRENO_DRAWOBJ_DISPATCH_DRAWQUEUE(drawobj);
 	struct adreno_submit_time time;
+	struct adreno_ringbuffer *cur_rb;
 	uint64_t secs = 0;
 	unsigned long nsecs = 0;
 	int ret;
@@ -594,6 +635,9 @@ static int sendcmd(struct adreno_device *adreno_dev,
 
 	memset(&time, 0x0, sizeof(time));
 
+	/* The ringbuffer the GPU was busy with while this command waited */
+	cur_rb = adreno_dev->cur_rb;
+
 	dispatcher->inflight++;
 	dispatch_q->inflight++;
 
@@ -708,6 +752,8 @@ static int sendcmd(struct adreno_device *adreno_dev,
 			time.ticks, (unsigned long) secs, nsecs / 1000,
 			dispatch_q->inflight);
 
+	_check_prio_inversion(cmdobj, drawctxt->rb, cur_rb);
+
 	mutex_unlock(&device->mutex);
 
 	cmdobj->submit_ticks = time.ticks;
@@ -996,6 +1042,81 @@ static void adreno_dispatcher_issuecmds(struct adreno_device *adreno_dev)
 	adreno_dispatcher_schedule(device);
 }
 
+/* Return true if a context of higher priority than @priority is pending */
+static bool _higher_prio_pending(struct adreno_dispatcher *dispatcher,
+		int priority)
+{
+	int i;
+
+	for (i = 0; i < priority; i++)
+		if (!llist_empty(&dispatcher->requeue[i]) ||
+			!llist_empty(&dispatcher->jobs[i]))
+			return true;
+
+	return false;
+}
+
+/**
+ * adreno_dispatcher_fastpath() - Issue commands directly from the submitter
+ * @adreno_dev: Pointer to the adreno device struct
+ * @drawctxt: Pointer to the context that just queued commands
+ *
+ * If the context's ringbuffer is idle, no preemption is in flight and no
+ * higher priority context is waiting, there is nothing for the dispatcher
+ * to arbitrate. Send the context's commands from the calling thread rather
+ * than queueing a job and waking the dispatcher. Returns true if the
+ * context queue was drained and no dispatcher job is needed.
+ */
+static bool adreno_dispatcher_fastpath(struct adreno_device *adreno_dev,
+		struct adreno_context *drawctxt)
+{
+	struct adreno_dispatcher *dispatcher = &adreno_dev->dispatcher;
+	struct kgsl_device *device = KGSL_DEVICE(adreno_dev);
+	struct adreno_dispatcher_drawqueue *dispatch_q =
+					&drawctxt->rb->dispatch_q;
+	bool drained = false;
+	int ret;
+
+	if (READ_ONCE(dispatch_q->inflight) ||
+		!adreno_in_preempt_state(adreno_dev, ADRENO_PREEMPT_NONE) ||
+		adreno_gpu_stopped(adreno_dev) ||
+		_higher_prio_pending(dispatcher, drawctxt->base.priority))
+		return false;
+
+	spin_lock(&device->submit_lock);
+	if (device->slumber) {
+		spin_unlock(&device->submit_lock);
+		return false;
+	}
+	device->submit_now++;
+	spin_unlock(&device->submit_lock);
+
+	if (!mutex_trylock(&dispatcher->mutex)) {
+		_decrement_submit_now(device);
+		return false;
+	}
+
+	/* Recheck now that the dispatcher can't change underneath us */
+	if (!dispatch_q->inflight) {
+		ret = dispatcher_context_sendcmds(adreno_dev, drawctxt);
+
+		if (ret > 0) {
+			spin_lock(&drawctxt->lock);
+			drained = (drawctxt->drawqueue_head ==
+					drawctxt->drawqueue_tail);
+			spin_unlock(&drawctxt->lock);
+
+			_fastpath_count++;
+			trace_dispatch_fastpath(drawctxt);
+		}
+	}
+
+	mutex_unlock(&dispatcher->mutex);
+	_decrement_submit_now(device);
+
+	return drained;
+}
+
 /**
  * get_timestamp() - Return the next timestamp for the context
  * @drawctxt - Pointer to an adreno draw context struct
@@ -1277,6 +1398,7 @@ static int drawctxt_queue_markerobj(struct adreno_device *adreno_dev,
 
 	markerobj->marker_timestamp = drawctxt->queued_timestamp;
 	drawctxt->queued_timestamp = *timestamp;
+	markerobj->queue_time = ktime_get();
 	_set_ft_policy(adreno_dev, drawctxt, markerobj);
 	_cmdobj_set_flags(drawctxt, markerobj);
 
@@ -1315,6 +1437,7 @@ static int drawctxt_queue_cmdobj(struct adreno_device *adreno_dev,
 	}
 
 	drawctxt->queued_timestamp = *timestamp;
+	cmdobj->queue_time = ktime_get();
 	_set_ft_policy(adreno_dev, drawctxt, cmdobj);
 	_cmdobj_set_flags(drawctxt, cmdobj);
 
@@ -1461,6 +1584,11 @@ int adreno_dispatcher_queue_cmds(struct kgsl_device_private *dev_priv,
 
 	spin_unlock(&drawctxt->lock);
 
+	if (adreno_dispatcher_fastpath(adreno_dev, drawctxt)) {
+		kmem_cache_free(jobs_cache, job);
+		goto done;
+	}
+
 	/* Add the context to the dispatcher pending list */
 	if (_kgsl_context_get(&drawctxt->base)) {
 		trace_dispatch_queue_context(drawctxt);
@@ -2358,8 +2486,10 @@ static void retire_cmdobj(struct adreno_device *adreno_dev,
 			       context->id, drawobj->timestamp,
 			       !!(drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME));
 
-	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME)
+	if (drawobj->flags & KGSL_DRAWOBJ_END_OF_FRAME) {
 		atomic64_inc(&context->proc_priv->frame_count);
+		kgsl_pwrscale_frame_retired(KGSL_DEVICE(adreno_dev));
+	}
 
 	/*
 	 * For A3xx we still get the rptr from the CP_RB_RPTR instead of
@@ -2918,6 +3048,11 @@ static DISPATCHER_UINT_ATTR(fault_throttle_time, 0644, 0,
 	_fault_throttle_time);
 static DISPATCHER_UINT_ATTR(fault_throttle_burst, 0644, 0,
 	_fault_throttle_burst);
+static DISPATCHER_UINT_ATTR(prio_inversion_threshold_us, 0644, 0,
+	_prio_inversion_threshold_us);
+static DISPATCHER_UINT_ATTR(prio_inversion_count, 0444, 0,
+	_prio_inversion_count);
+static DISPATCHER_UINT_ATTR(fastpath_count, 0444, 0, _fastpath_count);
 
 static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_inflight.attr,
@@ -2929,6 +3064,9 @@ static struct attribute *dispatcher_attrs[] = {
 	&dispatcher_attr_fault_detect_interval.attr,
 	&dispatcher_attr_fault_throttle_time.attr,
 	&dispatcher_attr_fault_throttle_burst.attr,
+	&dispatcher_attr_prio_inversion_threshold_us.attr,
+	&dispatcher_attr_prio_inversion_count.attr,
+	&dispatcher_attr_fastpath_count.attr,
 	NULL,
 };
 
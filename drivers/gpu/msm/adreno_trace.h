@@ -290,6 +290,42 @@ DEFINE_EVENT(adreno_drawctxt_template, dispatch_queue_context,
 	TP_ARGS(drawctxt)
 );
 
+DEFINE_EVENT(adreno_drawctxt_template, dispatch_fastpath,
+	TP_PROTO(struct adreno_context *drawctxt),
+	TP_ARGS(drawctxt)
+);
+
+TRACE_EVENT(dispatch_prio_inversion,
+	TP_PROTO(struct kgsl_drawobj *drawobj, unsigned int rb_id,
+		unsigned int cur_rb_id, unsigned int cur_rb_inflight,
+		s64 wait_us),
+	TP_ARGS(drawobj, rb_id, cur_rb_id, cur_rb_inflight, wait_us),
+	TP_STRUCT__entry(
+		__field(unsigned int, id)
+		__field(unsigned int, prio)
+		__field(unsigned int, timestamp)
+		__field(unsigned int, rb_id)
+		__field(unsigned int, cur_rb_id)
+		__field(unsigned int, cur_rb_inflight)
+		__field(s64, wait_us)
+	),
+	TP_fast_assign(
+		__entry->id = drawobj->context->id;
+		__entry->prio = drawobj->context->priority;
+		__entry->timestamp = drawobj->timestamp;
+		__entry->rb_id = rb_id;
+		__entry->cur_rb_id = cur_rb_id;
+		__entry->cur_rb_inflight = cur_rb_inflight;
+		__entry->wait_us = wait_us;
+	),
+	TP_printk(
+		"ctx=%u ctx_prio=%u ts=%u rb=%u starved_by_rb=%u starved_by_inflight=%u wait_us=%lld",
+			__entry->id, __entry->prio, __entry->timestamp,
+			__entry->rb_id, __entry->cur_rb_id,
+			__entry->cur_rb_inflight, __entry->wait_us
+	)
+);
+
 DEFINE_EVENT(adreno_drawctxt_template, adreno_drawctxt_invalidate,
 	TP_PROTO(struct adreno_context *drawctxt),
 	TP_ARGS(drawctxt)
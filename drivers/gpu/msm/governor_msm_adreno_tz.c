@@ -66,6 +66,8 @@ static void do_partner_resume_event(struct work_struct *work);
 
 static struct workqueue_struct *workqueue;
 
+static struct devfreq_governor msm_adreno_frame;
+
 /*
  * Returns GPU suspend time in millisecond.
  */
@@ -429,6 +431,9 @@ static int tz_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
 	return 0;
 }
 
+/* Set by the notifier when a frame retires, consumed by frame_get_target_freq */
+static bool frame_end_pending;
+
 static int tz_notify(struct notifier_block *nb, unsigned long type, void *devp)
 {
 	int result = 0;
@@ -447,6 +452,15 @@ static int tz_notify(struct notifier_block *nb, unsigned long type, void *devp)
 			mutex_unlock(&partner_gpu_profile->bus_devfreq->lock);
 		}
 		break;
+	case ADRENO_DEVFREQ_NOTIFY_FRAME:
+		/* Only the frame aware governor cares about frame boundaries */
+		if (devfreq->governor != &msm_adreno_frame)
+			break;
+		mutex_lock(&devfreq->lock);
+		frame_end_pending = true;
+		result = update_devfreq(devfreq);
+		mutex_unlock(&devfreq->lock);
+		break;
 	/* ignored by this governor */
 	case ADRENO_DEVFREQ_NOTIFY_SUBMIT:
 	default:
@@ -649,26 +663,282 @@ static void do_partner_resume_event(struct work_struct *work)
 }
 
 
+/*
+ * Frame aware governor
+ *
+ * The dispatcher notifies us every time a command marked end of frame
+ * retires. The GPU work done in between two of those notifications, scaled
+ * to what it would have taken at the maximum frequency, is the cost of that
+ * frame. The next frame is assumed to cost as much as the heaviest of the
+ * last FRAME_HISTORY frames and the governor picks the lowest frequency that
+ * finishes that much work in the time left before the frame is due. If the
+ * current frame turns out heavier than predicted the prediction is raised
+ * as soon as the accumulated work crosses it so a heavy frame after a run of
+ * light ones does not miss its deadline.
+ *
+ * Without a steady stream of frames (compute, UI that only redraws on
+ * damage, or the first few frames of an app) the TZ algorithm is used.
+ */
+#define FRAME_HISTORY		4
+/* Fall back to TZ if there has been no frame for this long (usec) */
+#define FRAME_TIMEOUT		100000
+/* Grow the prediction by this much (percent) when a frame overruns it */
+#define FRAME_OVERRUN_BOOST	125
+
+static struct {
+	/* GPU busy time at fmax (usec) accumulated for the current frame */
+	u64 work;
+	/* Expected work for the current frame */
+	u64 predicted;
+	u64 history[FRAME_HISTORY];
+	unsigned int nr_history;
+	unsigned int index;
+	/* Smoothed interval between frames (usec) */
+	u64 period;
+	ktime_t last;
+	/* Tunables */
+	unsigned int target_fps;
+	unsigned int headroom;
+} frame = {
+	.headroom = 90,
+};
+
+static void frame_reset(void)
+{
+	frame.work = 0;
+	frame.predicted = 0;
+	frame.nr_history = 0;
+	frame.index = 0;
+	frame.period = 0;
+	frame.last = 0;
+	frame_end_pending = false;
+}
+
+static void frame_close(ktime_t now)
+{
+	u64 delta = ktime_us_delta(now, frame.last);
+	int i;
+
+	if (!frame.last || delta > FRAME_TIMEOUT) {
+		/* Frames stopped for a while, start over */
+		frame.nr_history = 0;
+		frame.period = 0;
+	} else {
+		frame.history[frame.index] = frame.work;
+		frame.index = (frame.index + 1) % FRAME_HISTORY;
+		if (frame.nr_history < FRAME_HISTORY)
+			frame.nr_history++;
+
+		frame.period = frame.period ?
+			(frame.period * 3 + delta) >> 2 : delta;
+	}
+
+	frame.predicted = 0;
+	for (i = 0; i < frame.nr_history; i++)
+		frame.predicted = max(frame.predicted, frame.history[i]);
+
+	frame.work = 0;
+	frame.last = now;
+}
+
+static int frame_get_target_freq(struct devfreq *devfreq, unsigned long *freq)
+{
+	struct devfreq_dev_status *stats = &devfreq->last_status;
+	unsigned long *table = devfreq->profile->freq_table;
+	u64 busy, budget, elapsed, remaining, needed;
+	ktime_t now = ktime_get();
+	int level, ret;
+
+	/*
+	 * Let TZ run first. It fetches the new sample and keeps its own
+	 * state current so it can take over without a transient whenever the
+	 * frame stream stops.
+	 */
+	ret = tz_get_target_freq(devfreq, freq);
+	if (ret)
+		return ret;
+
+	if (stats->current_frequency) {
+		busy = (u64)stats->busy_time * stats->current_frequency;
+		do_div(busy, table[0]);
+		frame.work += busy;
+	}
+
+	if (frame_end_pending) {
+		frame_end_pending = false;
+		frame_close(now);
+	}
+
+	if (frame.nr_history < FRAME_HISTORY ||
+		ktime_us_delta(now, frame.last) > FRAME_TIMEOUT)
+		return 0;
+
+	if (frame.work > frame.predicted)
+		frame.predicted = div_u64(frame.work * FRAME_OVERRUN_BOOST,
+				100);
+
+	if (frame.target_fps)
+		budget = div_u64(USEC_PER_SEC, frame.target_fps);
+	else
+		budget = frame.period;
+
+	budget = div_u64(budget * frame.headroom, 100);
+	elapsed = ktime_us_delta(now, frame.last);
+
+	/* Already late, nothing to save */
+	if (elapsed >= budget) {
+		*freq = table[0];
+		return 0;
+	}
+
+	remaining = frame.predicted - min(frame.work, frame.predicted);
+	needed = div64_u64(remaining * table[0], budget - elapsed);
+
+	/* The table runs from the fastest to the slowest level */
+	for (level = devfreq->profile->max_state - 1; level > 0; level--)
+		if (table[level] >= needed)
+			break;
+
+	*freq = table[level];
+	return 0;
+}
+
+static ssize_t frame_target_fps_store(struct device *dev,
+			struct device_attribute *attr,
+			const char *buf, size_t count)
+{
+	int ret;
+	unsigned int val;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	/* 0 means track the measured frame rate */
+	frame.target_fps = min_t(u32, val, 240);
+
+	return count;
+}
+
+static ssize_t frame_target_fps_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", frame.target_fps);
+}
+
+static ssize_t frame_headroom_store(struct device *dev,
+			struct device_attribute *attr,
+			const char *buf, size_t count)
+{
+	int ret;
+	unsigned int val;
+
+	ret = kstrtou32(buf, 0, &val);
+	if (ret)
+		return ret;
+
+	frame.headroom = clamp_t(u32, val, 10, 100);
+
+	return count;
+}
+
+static ssize_t frame_headroom_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", frame.headroom);
+}
+
+static ssize_t frame_period_show(struct device *dev,
+			struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%llu\n", frame.period);
+}
+
+static DEVICE_ATTR_RW(frame_target_fps);
+static DEVICE_ATTR_RW(frame_headroom);
+static DEVICE_ATTR_RO(frame_period);
+
+static const struct device_attribute *adreno_frame_attr_list[] = {
+		&dev_attr_frame_target_fps,
+		&dev_attr_frame_headroom,
+		&dev_attr_frame_period,
+		NULL
+};
+
+static int frame_handler(struct devfreq *devfreq, unsigned int event,
+		void *data)
+{
+	int i, result;
+
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		frame_reset();
+		result = tz_handler(devfreq, event, data);
+		if (!result)
+			for (i = 0; adreno_frame_attr_list[i] != NULL; i++)
+				device_create_file(&devfreq->dev,
+					adreno_frame_attr_list[i]);
+		break;
+	case DEVFREQ_GOV_STOP:
+		for (i = 0; adreno_frame_attr_list[i] != NULL; i++)
+			device_remove_file(&devfreq->dev,
+				adreno_frame_attr_list[i]);
+		result = tz_handler(devfreq, event, data);
+		break;
+	case DEVFREQ_GOV_SUSPEND:
+		/* The frame stream is broken across a suspend */
+		frame_reset();
+		/* fallthrough */
+	default:
+		result = tz_handler(devfreq, event, data);
+		break;
+	}
+
+	return result;
+}
+
 static struct devfreq_governor msm_adreno_tz = {
 	.name = "msm-adreno-tz",
 	.get_target_freq = tz_get_target_freq,
 	.event_handler = tz_handler,
 };
 
+static struct devfreq_governor msm_adreno_frame = {
+	.name = "msm-adreno-frame",
+	.get_target_freq = frame_get_target_freq,
+	.event_handler = frame_handler,
+};
+
 static int __init msm_adreno_tz_init(void)
 {
+	int ret;
+
 	workqueue = create_freezable_workqueue("governor_msm_adreno_tz_wq");
 
 	if (workqueue == NULL)
 		return -ENOMEM;
 
-	return devfreq_add_governor(&msm_adreno_tz);
+	ret = devfreq_add_governor(&msm_adreno_tz);
+	if (ret)
+		return ret;
+
+	ret = devfreq_add_governor(&msm_adreno_frame);
+	if (ret)
+		pr_err(TAG "failed to add frame governor %d\n", ret);
+
+	/* The TZ governor works on its own */
+	return 0;
 }
 subsys_initcall(msm_adreno_tz_init);
 
 static void __exit msm_adreno_tz_exit(void)
 {
-	int ret = devfreq_remove_governor(&msm_adreno_tz);
+	int ret = devfreq_remove_governor(&msm_adreno_frame);
+
+	if (ret)
+		pr_err(TAG "failed to remove frame governor %d\n", ret);
+
+	ret = devfreq_remove_governor(&msm_adreno_tz);
 
 	if (ret)
 		pr_err(TAG "failed to remove governor %d\n", ret);
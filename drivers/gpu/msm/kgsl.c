@@ -29,6 +29,7 @@
 #include "kgsl_pool.h"
 #include "kgsl_sync.h"
 #include "kgsl_sysfs.h"
+#include "kgsl_timeline.h"
 #include "kgsl_trace.h"
 
 #ifndef arch_mmap_check
@@ -79,6 +80,7 @@ static inline struct kgsl_pagetable *_get_memdesc_pagetable(
 }
 
 static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry);
+static void kgsl_mem_entry_remove_id(struct kgsl_mem_entry *entry);
 
 static const struct file_operations kgsl_fops;
 
@@ -409,6 +411,64 @@ static void kgsl_process_sub_stats(struct kgsl_process_private *priv,
 	atomic64_sub(size, &priv->stats[type].cur);
 }
 
+/*
+ * Entries waiting for their GPU mapping to be torn down. Unmapping each
+ * entry on its own costs a full TLB invalidate and sync per entry, which
+ * adds up to hundreds of milliseconds when a process frees thousands of
+ * buffers at once. Instead the entries are queued here and unmapped as a
+ * batch with a single invalidate per pagetable. The pages and the GPU
+ * address are only released once the invalidate has completed so the GPU
+ * can never reach memory that has been handed out again.
+ */
+static LLIST_HEAD(unmap_list);
+
+static void _deferred_unmap(struct work_struct *work)
+{
+	struct llist_node *list = llist_del_all(&unmap_list);
+	struct kgsl_mem_entry *entry, *tmp;
+	struct kgsl_pagetable *pagetable = NULL;
+
+	list = llist_reverse_order(list);
+
+	llist_for_each_entry(entry, list, unmap_node) {
+		if (entry->memdesc.pagetable != pagetable) {
+			if (pagetable)
+				kgsl_mmu_flush_tlb(pagetable);
+			pagetable = entry->memdesc.pagetable;
+		}
+
+		kgsl_mmu_unmap_nosync(pagetable, &entry->memdesc);
+	}
+
+	if (pagetable)
+		kgsl_mmu_flush_tlb(pagetable);
+
+	llist_for_each_entry_safe(entry, tmp, list, unmap_node) {
+		kgsl_mem_entry_detach_process(entry);
+		kgsl_sharedmem_free(&entry->memdesc);
+		kfree(entry);
+	}
+}
+
+static DECLARE_WORK(unmap_ws, _deferred_unmap);
+
+/*
+ * Queue the entry for a batched unmap. The entry keeps its reference on the
+ * process, and through it on the pagetable, until the batch completes.
+ */
+static bool kgsl_mem_entry_defer_unmap(struct kgsl_mem_entry *entry)
+{
+	if (!kgsl_mmu_can_unmap_nosync(&entry->memdesc))
+		return false;
+
+	kgsl_mem_entry_remove_id(entry);
+
+	if (llist_add(&entry->unmap_node, &unmap_list))
+		queue_work(kgsl_driver.mem_workqueue, &unmap_ws);
+
+	return true;
+}
+
 void
 kgsl_mem_entry_destroy(struct kref *kref)
 {
@@ -425,13 +485,16 @@ kgsl_mem_entry_destroy(struct kref *kref)
 
 	kgsl_process_sub_stats(entry->priv, memtype, entry->memdesc.size);
 
-	/* Detach from process list */
-	kgsl_mem_entry_detach_process(entry);
-
 	if (memtype != KGSL_MEM_ENTRY_KERNEL)
 		atomic_long_sub(entry->memdesc.size,
 			&kgsl_driver.stats.mapped);
 
+	if (kgsl_mem_entry_defer_unmap(entry))
+		return;
+
+	/* Detach from process list */
+	kgsl_mem_entry_detach_process(entry);
+
 	kgsl_sharedmem_free(&entry->memdesc);
 
 	kfree(entry);
@@ -526,6 +589,17 @@ static int kgsl_mem_entry_attach_process(struct kgsl_device *device,
 }
 
 /* Detach a memory entry from a process and unmap it from the MMU */
+/* Remove the entry from mem_idr so that no one can operate on it anymore */
+static void kgsl_mem_entry_remove_id(struct kgsl_mem_entry *entry)
+{
+	spin_lock(&entry->priv->mem_lock);
+	if (entry->id != 0)
+		idr_remove(&entry->priv->mem_idr, entry->id);
+	entry->id = 0;
+
+	spin_unlock(&entry->priv->mem_lock);
+}
+
 static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
 {
 	if (entry == NULL)
@@ -535,12 +609,7 @@ static void kgsl_mem_entry_detach_process(struct kgsl_mem_entry *entry)
 	 * First remove the entry from mem_idr list
 	 * so that no one can operate on obsolete values
 	 */
-	spin_lock(&entry->priv->mem_lock);
-	if (entry->id != 0)
-		idr_remove(&entry->priv->mem_idr, entry->id);
-	entry->id = 0;
-
-	spin_unlock(&entry->priv->mem_lock);
+	kgsl_mem_entry_remove_id(entry);
 
 	kgsl_mmu_put_gpuaddr(&entry->memdesc);
 
@@ -1547,6 +1616,27 @@ static long kgsl_prop_secure_ctxt_support(struct kgsl_device_private *dev_priv,
 	return 0;
 }
 
+static long kgsl_prop_timeline_shadow(struct kgsl_device_private *dev_priv,
+		struct kgsl_device_getproperty *param)
+{
+	struct kgsl_shadowprop shadowprop = { 0 };
+
+	if (param->sizebytes != sizeof(shadowprop))
+		return -EINVAL;
+
+	if (dev_priv->device->timeline_shadow) {
+		/* Pass a dummy address to identify the timeline shadow */
+		shadowprop.gpuaddr = KGSL_TIMELINE_SHADOW_TOKEN_ADDRESS;
+		shadowprop.size = PAGE_SIZE;
+		shadowprop.flags = KGSL_FLAGS_INITIALIZED;
+	}
+
+	if (copy_to_user(param->value, &shadowprop, sizeof(shadowprop)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static int kgsl_query_caps_properties(struct kgsl_device *device,
 		struct kgsl_capabilities *caps)
 {
@@ -1658,6 +1748,7 @@ static const struct {
 	{ KGSL_PROP_SECURE_CTXT_SUPPORT, kgsl_prop_secure_ctxt_support },
 	{ KGSL_PROP_QUERY_CAPABILITIES, kgsl_prop_query_capabilities },
 	{ KGSL_PROP_CONTEXT_PROPERTY, kgsl_get_ctxt_properties },
+	{ KGSL_PROP_TIMELINE_SHADOW, kgsl_prop_timeline_shadow },
 };
 
 /*call all ioctl sub functions with driver locked*/
@@ -3549,7 +3640,8 @@ struct kgsl_mem_entry *gpumem_alloc_entry(
 		| KGSL_MEMFLAGS_SECURE
 		| KGSL_MEMFLAGS_FORCE_32BIT
 		| KGSL_MEMFLAGS_IOCOHERENT
-		| KGSL_MEMFLAGS_GUARD_PAGE;
+		| KGSL_MEMFLAGS_GUARD_PAGE
+		| KGSL_MEMFLAGS_PREFAULT;
 
 	/* Return not supported error if secure memory isn't enabled */
 	if (!kgsl_mmu_is_secured(mmu) &&
@@ -3878,6 +3970,30 @@ kgsl_mmap_memstore(struct file *file, struct kgsl_device *device,
 	return 0;
 }
 
+static int
+kgsl_mmap_timeline_shadow(struct kgsl_device *device,
+		struct vm_area_struct *vma)
+{
+	u64 *shadow = device->timeline_shadow;
+
+	if (!shadow)
+		return -ENODEV;
+
+	/* The timeline shadow can only be mapped as read only */
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	if (vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+
+	vma->vm_flags |= VM_DONTEXPAND | VM_DONTDUMP | VM_DONTCOPY;
+
+	return remap_pfn_range(vma, vma->vm_start, virt_to_pfn(shadow),
+		PAGE_SIZE, vma->vm_page_prot);
+}
+
 /*
  * kgsl_gpumem_vm_open is called whenever a vma region is copied or split.
  * Increase the refcount to make sure that the accounting stays correct
@@ -4136,7 +4252,8 @@ kgsl_get_unmapped_area(struct file *file, unsigned long addr,
 	struct kgsl_device *device = dev_priv->device;
 	struct kgsl_mem_entry *entry = NULL;
 
-	if (vma_offset == (unsigned long) KGSL_MEMSTORE_TOKEN_ADDRESS)
+	if (vma_offset == (unsigned long) KGSL_MEMSTORE_TOKEN_ADDRESS ||
+		vma_offset == (unsigned long) KGSL_TIMELINE_SHADOW_TOKEN_ADDRESS)
 		return get_unmapped_area(NULL, addr, len, pgoff, flags);
 
 	val = get_mmap_entry(private, &entry, pgoff, len);
@@ -4169,6 +4286,29 @@ kgsl_get_unmapped_area(struct file *file, unsigned long addr,
 	return val;
 }
 
+/*
+ * Populate the whole CPU mapping of a buffer at mmap time. CPU accesses
+ * then never fault, so they do not have to take the mmap_sem and wait
+ * behind another thread's mmap or munmap.
+ */
+static void kgsl_gpumem_prefault(struct vm_area_struct *vma,
+		struct kgsl_memdesc *m)
+{
+	unsigned long addr = vma->vm_start;
+	unsigned long size = min_t(u64, m->size, vma->vm_end - vma->vm_start);
+	int i;
+
+	if (m->pages) {
+		for (i = 0; i < m->page_count && addr < vma->vm_end; i++) {
+			vm_insert_page(vma, addr, m->pages[i]);
+			addr += PAGE_SIZE;
+		}
+	} else if (m->physaddr && (vma->vm_flags & VM_PFNMAP)) {
+		remap_pfn_range(vma, addr, m->physaddr >> PAGE_SHIFT,
+				PAGE_ALIGN(size), vma->vm_page_prot);
+	}
+}
+
 static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 {
 	unsigned int cache;
@@ -4184,6 +4324,9 @@ static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 	if (vma_offset == (unsigned long) KGSL_MEMSTORE_TOKEN_ADDRESS)
 		return kgsl_mmap_memstore(file, device, vma);
 
+	if (vma_offset == (unsigned long) KGSL_TIMELINE_SHADOW_TOKEN_ADDRESS)
+		return kgsl_mmap_timeline_shadow(device, vma);
+
 	/*
 	 * The reference count on the entry that we get from
 	 * get_mmap_entry() will be held until kgsl_gpumem_vm_close().
@@ -4221,18 +4364,9 @@ static int kgsl_mmap(struct file *file, struct vm_area_struct *vma)
 	vma->vm_ops = &kgsl_gpumem_vm_ops;
 
 	if (cache == KGSL_CACHEMODE_WRITEBACK
-		|| cache == KGSL_CACHEMODE_WRITETHROUGH) {
-		int i;
-		unsigned long addr = vma->vm_start;
-		struct kgsl_memdesc *m = &entry->memdesc;
-
-		for (i = 0; i < m->page_count; i++) {
-			struct page *page = m->pages[i];
-
-			vm_insert_page(vma, addr, page);
-			addr += PAGE_SIZE;
-		}
-	}
+		|| cache == KGSL_CACHEMODE_WRITETHROUGH
+		|| (entry->memdesc.flags & KGSL_MEMFLAGS_PREFAULT))
+		kgsl_gpumem_prefault(vma, &entry->memdesc);
 
 	vma->vm_file = file;
 
@@ -4496,6 +4630,9 @@ int kgsl_device_platform_probe(struct kgsl_device *device)
 	idr_init(&device->timelines);
 	spin_lock_init(&device->timelines_lock);
 
+	/* Timelines fall back to the query ioctl if this isn't available */
+	device->timeline_shadow = (u64 *) get_zeroed_page(GFP_KERNEL);
+
 	device->events_wq = alloc_workqueue("kgsl-events",
 		WQ_UNBOUND | WQ_MEM_RECLAIM | WQ_SYSFS | WQ_HIGHPRI, 0);
 
@@ -4528,6 +4665,9 @@ int kgsl_device_platform_probe(struct kgsl_device *device)
 		device->events_wq = NULL;
 	}
 
+	free_page((unsigned long) device->timeline_shadow);
+	device->timeline_shadow = NULL;
+
 	kgsl_pwrctrl_close(device);
 error:
 	_unregister_device(device);
@@ -4548,6 +4688,8 @@ void kgsl_device_platform_remove(struct kgsl_device *device)
 
 	idr_destroy(&device->context_idr);
 	idr_destroy(&device->timelines);
+	free_page((unsigned long) device->timeline_shadow);
+	device->timeline_shadow = NULL;
 
 	kgsl_device_events_remove(device);
 
@@ -10,6 +10,7 @@
 #include <linux/compat.h>
 #include <linux/interrupt.h>
 #include <linux/kthread.h>
+#include <linux/llist.h>
 #include <linux/mm.h>
 #include <linux/uaccess.h>
 
@@ -272,6 +273,8 @@ struct kgsl_mem_entry {
 	 * debugfs accounting
 	 */
 	atomic_t map_count;
+	/** @unmap_node: Node in the list of entries waiting to be unmapped */
+	struct llist_node unmap_node;
 };
 
 struct kgsl_device_private;
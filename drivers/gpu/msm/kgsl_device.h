@@ -285,6 +285,10 @@ struct kgsl_device {
 	bool snapshot_crashdumper;
 	/* Use HOST side register reads to get GPU snapshot*/
 	bool snapshot_legacy;
+	/* Hand snapshots to devcoredump and read GPU objects on demand */
+	bool snapshot_stream;
+	/* Mask of snapshot section classes (id >> 8) to leave out */
+	u32 snapshot_section_filter;
 
 	struct kobject snapshot_kobj;
 
@@ -324,6 +328,11 @@ struct kgsl_device {
 	struct idr timelines;
 	/** @timelines_lock: Spinlock to protect the timelines idr */
 	spinlock_t timelines_lock;
+	/**
+	 * @timeline_shadow: Page mapped read only to userspace that mirrors
+	 * the current value of each timeline, indexed by the timeline id
+	 */
+	u64 *timeline_shadow;
 };
 
 #define KGSL_MMU_DEVICE(_mmu) \
@@ -418,6 +427,26 @@ struct kgsl_context {
 		_context_comm((_c)), \
 		pid_nr((_c)->proc_priv->pid), ##args)
 
+/* Number of buckets in the per-process GPU latency histograms */
+#define KGSL_GPU_HIST_BUCKETS 16
+
+/**
+ * struct kgsl_gpu_latency_stats - GPU timing histograms for a process
+ * @inflight: Number of submissions that have not retired yet
+ * @queue_depth: Histogram of @inflight at submit time, one bucket per
+ * submission in flight with the last bucket collecting the rest
+ * @submit_to_start: Histogram of the time from the GMU submitting to the
+ * ringbuffer to the GPU starting the command, in log2 microsecond buckets
+ * @start_to_retire: Histogram of the time from the GPU starting the command
+ * to it retiring, in log2 microsecond buckets
+ */
+struct kgsl_gpu_latency_stats {
+	atomic_t inflight;
+	u64 queue_depth[KGSL_GPU_HIST_BUCKETS];
+	u64 submit_to_start[KGSL_GPU_HIST_BUCKETS];
+	u64 start_to_retire[KGSL_GPU_HIST_BUCKETS];
+};
+
 /**
  * struct kgsl_process_private -  Private structure for a KGSL process (across
  * all devices)
@@ -438,6 +467,7 @@ struct kgsl_context {
  * @ctxt_count: Count for the number of contexts for this process
  * @ctxt_count_lock: Spinlock to protect ctxt_count
  * @frame_count: Count for the number of frames processed
+ * @gpu_stats: GPU queueing and execution time histograms for this process
  */
 struct kgsl_process_private {
 	unsigned long priv;
@@ -462,6 +492,7 @@ struct kgsl_process_private {
 	atomic_t ctxt_count;
 	spinlock_t ctxt_count_lock;
 	atomic64_t frame_count;
+	struct kgsl_gpu_latency_stats gpu_stats;
 };
 
 /**
@@ -500,6 +531,9 @@ struct kgsl_device_private {
  * @sysfs_read: Count of current reads via sysfs
  * @first_read: True until the snapshot read is started
  * @recovered: True if GPU was recovered after previous snapshot
+ * @stream: True if GPU objects are read out of their memory entries on demand
+ * instead of being copied into @mempool. @mempool_size is then the size of the
+ * object sections that will be generated.
  */
 struct kgsl_snapshot {
 	uint64_t ib1base;
@@ -523,6 +557,7 @@ struct kgsl_snapshot {
 	unsigned int sysfs_read;
 	bool first_read;
 	bool recovered;
+	bool stream;
 	struct kgsl_device *device;
 };
 
@@ -67,6 +67,7 @@ struct kgsl_drawobj {
  * buffer
  * @submit_ticks: Variable to hold ticks at the time of
  *     command obj submit.
+ * @queue_time: Time at which the command obj was queued in the context
 
  */
 struct kgsl_drawobj_cmd {
@@ -82,6 +83,7 @@ struct kgsl_drawobj_cmd {
 	uint64_t profiling_buffer_gpuaddr;
 	unsigned int profile_index;
 	uint64_t submit_ticks;
+	ktime_t queue_time;
 };
 
 /**
@@ -383,6 +383,101 @@ static int _iommu_unmap(struct kgsl_pagetable *pt,
 	return 0;
 }
 
+/*
+ * Work out which pagetable entry sizes the SMMU will use for a physically
+ * contiguous run. This mirrors the choices made by io-pgtable-arm.
+ */
+static void _iommu_account_run(struct kgsl_pagetable *pt, u64 iova,
+		phys_addr_t phys, u64 len, long *blocks)
+{
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
+
+	while (len) {
+		u64 size = PAGE_SIZE;
+		enum kgsl_pt_block block = KGSL_PT_BLOCK_4K;
+
+		if (IS_ALIGNED(iova | phys, SZ_2M) && len >= SZ_2M) {
+			size = SZ_2M;
+			block = KGSL_PT_BLOCK_2M;
+		} else if (iommu_pt->contig_hint &&
+			IS_ALIGNED(iova | phys, SZ_64K) && len >= SZ_64K) {
+			size = SZ_64K;
+			block = KGSL_PT_BLOCK_64K;
+		}
+
+		blocks[block] += size;
+		iova += size;
+		phys += size;
+		len -= size;
+	}
+}
+
+static void _iommu_account_blocks(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc, bool map)
+{
+	long blocks[KGSL_PT_BLOCK_MAX] = { 0 };
+	u64 iova = memdesc->gpuaddr;
+	int i;
+
+	if (memdesc->pages != NULL) {
+		for (i = 0; i < memdesc->page_count; ) {
+			phys_addr_t phys = page_to_phys(memdesc->pages[i]);
+			u64 len = PAGE_SIZE;
+
+			for (i++; i < memdesc->page_count; i++) {
+				if (page_to_phys(memdesc->pages[i]) !=
+					phys + len)
+					break;
+				len += PAGE_SIZE;
+			}
+
+			_iommu_account_run(pt, iova, phys, len, blocks);
+			iova += len;
+		}
+	} else if (memdesc->sgt != NULL) {
+		struct scatterlist *sg;
+
+		for_each_sg(memdesc->sgt->sgl, sg, memdesc->sgt->nents, i) {
+			_iommu_account_run(pt, iova, sg_phys(sg), sg->length,
+				blocks);
+			iova += sg->length;
+		}
+	}
+
+	for (i = 0; i < KGSL_PT_BLOCK_MAX; i++)
+		atomic_long_add(map ? blocks[i] : -blocks[i],
+			&pt->stats.block_mapped[i]);
+}
+
+/*
+ * Like _iommu_unmap() but leave the TLB alone. The caller must invalidate
+ * the pagetable with kgsl_iommu_flush_tlb() before the pages or the IOVA
+ * range are reused.
+ */
+static int _iommu_unmap_nosync(struct kgsl_pagetable *pt,
+		uint64_t addr, uint64_t size)
+{
+	struct kgsl_device *device = KGSL_MMU_DEVICE(pt->mmu);
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
+	struct iommu_iotlb_gather gather;
+	size_t unmapped = 0;
+
+	/* Sign extend TTBR1 addresses all the way to avoid warning */
+	if (addr & (1ULL << 48))
+		addr |= 0xffff000000000000;
+
+	iommu_iotlb_gather_init(&gather);
+	unmapped = iommu_unmap_fast(iommu_pt->domain, addr, size, &gather);
+
+	if (unmapped != size) {
+		dev_err(device->dev, "unmap err: 0x%016llx, 0x%llx, %zd\n",
+			addr, size, unmapped);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
 static int _iommu_map_sg(struct kgsl_pagetable *pt,
 		uint64_t addr, struct scatterlist *sg, int nents,
 		unsigned int flags)
@@ -1055,6 +1150,26 @@ static void _enable_gpuhtw_llc(struct kgsl_mmu *mmu,
 			"System cache no-write-alloc is disabled for GPU pagetables\n");
 }
 
+static void _enable_contig_hint(struct kgsl_mmu *mmu,
+		struct kgsl_iommu_pt *iommu_pt)
+{
+	struct kgsl_device *device = KGSL_MMU_DEVICE(mmu);
+	int ret, val = 1;
+
+	if (!test_bit(KGSL_MMU_LARGE_PAGES, &mmu->features))
+		return;
+
+	ret = iommu_domain_set_attr(iommu_pt->domain,
+		DOMAIN_ATTR_CONTIG_HINT, &val);
+
+	/* 2M blocks still work without the hint, only 64K runs are lost */
+	if (ret)
+		dev_err_once(device->dev,
+			"64K contiguous GPU mappings are not supported\n");
+	else
+		iommu_pt->contig_hint = true;
+}
+
 static int set_smmu_aperture(struct kgsl_device *device, int cb_num)
 {
 	int ret;
@@ -1109,6 +1224,7 @@ static int _init_global_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 	}
 
 	_enable_gpuhtw_llc(mmu, iommu_pt->domain);
+	_enable_contig_hint(mmu, iommu_pt);
 
 	if (test_bit(KGSL_MMU_64BIT, &mmu->features))
 		iommu_domain_set_attr(iommu_pt->domain,
@@ -1338,6 +1454,7 @@ static int _init_per_process_pt(struct kgsl_mmu *mmu, struct kgsl_pagetable *pt)
 	}
 
 	_enable_gpuhtw_llc(mmu, iommu_pt->domain);
+	_enable_contig_hint(mmu, iommu_pt);
 
 	ret = _attach_pt(iommu_pt, ctx);
 	if (ret)
@@ -1595,11 +1712,41 @@ static int kgsl_iommu_start(struct kgsl_mmu *mmu)
 static int
 kgsl_iommu_unmap(struct kgsl_pagetable *pt, struct kgsl_memdesc *memdesc)
 {
+	int ret;
+
+	if (memdesc->size == 0 || memdesc->gpuaddr == 0)
+		return -EINVAL;
+
+	ret = _iommu_unmap(pt, memdesc->gpuaddr,
+		kgsl_memdesc_footprint(memdesc));
+	if (!ret)
+		_iommu_account_blocks(pt, memdesc, false);
+
+	return ret;
+}
+
+static int
+kgsl_iommu_unmap_nosync(struct kgsl_pagetable *pt,
+		struct kgsl_memdesc *memdesc)
+{
+	int ret;
+
 	if (memdesc->size == 0 || memdesc->gpuaddr == 0)
 		return -EINVAL;
 
-	return _iommu_unmap(pt, memdesc->gpuaddr,
+	ret = _iommu_unmap_nosync(pt, memdesc->gpuaddr,
 		kgsl_memdesc_footprint(memdesc));
+	if (!ret)
+		_iommu_account_blocks(pt, memdesc, false);
+
+	return ret;
+}
+
+static void kgsl_iommu_flush_tlb(struct kgsl_pagetable *pt)
+{
+	struct kgsl_iommu_pt *iommu_pt = pt->priv;
+
+	iommu_flush_tlb_all(iommu_pt->domain);
 }
 
 /**
@@ -1722,6 +1869,8 @@ kgsl_iommu_map(struct kgsl_pagetable *pt,
 	ret = _iommu_map_guard_page(pt, memdesc, addr + size, flags);
 	if (ret)
 		_iommu_unmap(pt, addr, size);
+	else
+		_iommu_account_blocks(pt, memdesc, true);
 
 done:
 	if (memdesc->pages != NULL)
@@ -2497,6 +2646,9 @@ int kgsl_iommu_probe(struct kgsl_device *device)
 	if (of_property_read_bool(node, "qcom,global_pt"))
 		set_bit(KGSL_MMU_GLOBAL_PAGETABLE, &mmu->features);
 
+	if (of_property_read_bool(node, "qcom,large-pages"))
+		set_bit(KGSL_MMU_LARGE_PAGES, &mmu->features);
+
 	/* Fill out the rest of the devices in the node */
 	of_platform_populate(node, NULL, NULL, &pdev->dev);
 
@@ -2560,6 +2712,8 @@ static const struct kgsl_mmu_ops kgsl_iommu_ops = {
 static const struct kgsl_mmu_pt_ops iommu_pt_ops = {
 	.mmu_map = kgsl_iommu_map,
 	.mmu_unmap = kgsl_iommu_unmap,
+	.mmu_unmap_nosync = kgsl_iommu_unmap_nosync,
+	.mmu_flush_tlb = kgsl_iommu_flush_tlb,
 	.mmu_destroy_pagetable = kgsl_iommu_destroy_pagetable,
 	.get_ttbr0 = kgsl_iommu_get_ttbr0,
 	.get_contextidr = kgsl_iommu_get_contextidr,
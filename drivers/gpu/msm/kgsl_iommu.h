@@ -150,12 +150,14 @@ struct kgsl_iommu {
  * @svm_end: End of the shared virtual memory range.
  * @svm_start: 32 bit compatible range, for old clients who lack bits
  * @svm_end: end of 32 bit compatible range
+ * @contig_hint: The pagetable maps aligned 64K runs with the contiguous hint
  */
 struct kgsl_iommu_pt {
 	struct iommu_domain *domain;
 	u64 ttbr0;
 	u32 contextidr;
 	bool attached;
+	bool contig_hint;
 
 	struct rb_root rbtree;
 
@@ -124,6 +124,48 @@ sysfs_show_max_mapped(struct kobject *kobj,
 	return ret;
 }
 
+static ssize_t
+_show_block_mapped(struct kobject *kobj, char *buf, enum kgsl_pt_block block)
+{
+	struct kgsl_pagetable *pt;
+	int ret = 0;
+
+	pt = _get_pt_from_kobj(kobj);
+
+	if (pt) {
+		long val = atomic_long_read(&pt->stats.block_mapped[block]);
+
+		ret += scnprintf(buf, PAGE_SIZE, "%ld\n", val);
+		kref_put(&pt->refcount, kgsl_destroy_pagetable);
+	}
+
+	return ret;
+}
+
+static ssize_t
+sysfs_show_mapped_4k(struct kobject *kobj,
+		      struct kobj_attribute *attr,
+		      char *buf)
+{
+	return _show_block_mapped(kobj, buf, KGSL_PT_BLOCK_4K);
+}
+
+static ssize_t
+sysfs_show_mapped_64k(struct kobject *kobj,
+		      struct kobj_attribute *attr,
+		      char *buf)
+{
+	return _show_block_mapped(kobj, buf, KGSL_PT_BLOCK_64K);
+}
+
+static ssize_t
+sysfs_show_mapped_2m(struct kobject *kobj,
+		      struct kobj_attribute *attr,
+		      char *buf)
+{
+	return _show_block_mapped(kobj, buf, KGSL_PT_BLOCK_2M);
+}
+
 static struct kobj_attribute attr_entries = {
 	.attr = { .name = "entries", .mode = 0444 },
 	.show = sysfs_show_entries,
@@ -142,10 +184,31 @@ static struct kobj_attribute attr_max_mapped = {
 	.store = NULL,
 };
 
+static struct kobj_attribute attr_mapped_4k = {
+	.attr = { .name = "mapped_4k", .mode = 0444 },
+	.show = sysfs_show_mapped_4k,
+	.store = NULL,
+};
+
+static struct kobj_attribute attr_mapped_64k = {
+	.attr = { .name = "mapped_64k", .mode = 0444 },
+	.show = sysfs_show_mapped_64k,
+	.store = NULL,
+};
+
+static struct kobj_attribute attr_mapped_2m = {
+	.attr = { .name = "mapped_2m", .mode = 0444 },
+	.show = sysfs_show_mapped_2m,
+	.store = NULL,
+};
+
 static struct attribute *pagetable_attrs[] = {
 	&attr_entries.attr,
 	&attr_mapped.attr,
 	&attr_max_mapped.attr,
+	&attr_mapped_4k.attr,
+	&attr_mapped_64k.attr,
+	&attr_mapped_2m.attr,
 	NULL,
 };
 
@@ -498,6 +561,79 @@ kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 	return ret;
 }
 
+/**
+ * kgsl_mmu_can_unmap_nosync() - Check if a memdesc can be unmapped in a batch
+ * @memdesc: Memory descriptor about to be freed
+ *
+ * Return: True if @memdesc is mapped into a pagetable that supports
+ * unmapping without an immediate TLB invalidate.
+ */
+bool kgsl_mmu_can_unmap_nosync(struct kgsl_memdesc *memdesc)
+{
+	struct kgsl_pagetable *pagetable = memdesc->pagetable;
+
+	if (!pagetable || !memdesc->size || !memdesc->gpuaddr)
+		return false;
+
+	if (kgsl_memdesc_is_global(memdesc) ||
+		kgsl_memdesc_is_secured(memdesc) ||
+		!(KGSL_MEMDESC_MAPPED & memdesc->priv))
+		return false;
+
+	return PT_OP_VALID(pagetable, mmu_unmap_nosync) &&
+		PT_OP_VALID(pagetable, mmu_flush_tlb);
+}
+
+/**
+ * kgsl_mmu_unmap_nosync() - Unmap a memdesc without invalidating the TLB
+ * @pagetable: Pagetable the memdesc is mapped in
+ * @memdesc: Memory descriptor to unmap
+ *
+ * The GPU may keep using stale translations for the range until
+ * kgsl_mmu_flush_tlb() is called on @pagetable, so neither the pages nor the
+ * GPU address may be released before then. On failure the memdesc is left
+ * marked as mapped so that kgsl_mmu_put_gpuaddr() retries the unmap and keeps
+ * the GPU address reserved if it fails again.
+ *
+ * Return: 0 on success or negative on failure
+ */
+int kgsl_mmu_unmap_nosync(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc)
+{
+	struct kgsl_device *device = KGSL_MMU_DEVICE(pagetable->mmu);
+	uint64_t size;
+	int ret;
+
+	if (!(KGSL_MEMDESC_MAPPED & memdesc->priv))
+		return -EINVAL;
+
+	size = kgsl_memdesc_footprint(memdesc);
+
+	ret = pagetable->pt_ops->mmu_unmap_nosync(pagetable, memdesc);
+	if (ret)
+		return ret;
+
+	atomic_dec(&pagetable->stats.entries);
+	atomic_long_sub(size, &pagetable->stats.mapped);
+	kgsl_mmu_trace_gpu_mem_pagetable(pagetable);
+
+	memdesc->priv &= ~KGSL_MEMDESC_MAPPED;
+	if (!(memdesc->flags & KGSL_MEMFLAGS_USERMEM_ION))
+		kgsl_trace_gpu_mem_total(device, -(size));
+
+	return 0;
+}
+
+/**
+ * kgsl_mmu_flush_tlb() - Invalidate all GPU TLB entries for a pagetable
+ * @pagetable: Pagetable to invalidate
+ */
+void kgsl_mmu_flush_tlb(struct kgsl_pagetable *pagetable)
+{
+	if (PT_OP_VALID(pagetable, mmu_flush_tlb))
+		pagetable->pt_ops->mmu_flush_tlb(pagetable);
+}
+
 void kgsl_mmu_map_global(struct kgsl_device *device,
 		struct kgsl_memdesc *memdesc, u32 padding)
 {
@@ -33,6 +33,15 @@ enum kgsl_mmutype {
 
 #define KGSL_IOMMU_SMMU_V500 1
 
+/* Sizes of GPU pagetable entries tracked in the pagetable statistics */
+enum kgsl_pt_block {
+	KGSL_PT_BLOCK_4K = 0,
+	/* 16 4K entries with the contiguous hint set */
+	KGSL_PT_BLOCK_64K,
+	KGSL_PT_BLOCK_2M,
+	KGSL_PT_BLOCK_MAX,
+};
+
 struct kgsl_pagetable {
 	spinlock_t lock;
 	struct kref refcount;
@@ -45,6 +54,8 @@ struct kgsl_pagetable {
 		atomic_t entries;
 		atomic_long_t mapped;
 		atomic_long_t max_mapped;
+		/* Bytes mapped with each GPU pagetable entry size */
+		atomic_long_t block_mapped[KGSL_PT_BLOCK_MAX];
 	} stats;
 	const struct kgsl_mmu_pt_ops *pt_ops;
 	uint64_t fault_addr;
@@ -78,6 +89,9 @@ struct kgsl_mmu_pt_ops {
 			struct kgsl_memdesc *memdesc);
 	int (*mmu_unmap)(struct kgsl_pagetable *pt,
 			struct kgsl_memdesc *memdesc);
+	int (*mmu_unmap_nosync)(struct kgsl_pagetable *pt,
+			struct kgsl_memdesc *memdesc);
+	void (*mmu_flush_tlb)(struct kgsl_pagetable *pt);
 	void (*mmu_destroy_pagetable)(struct kgsl_pagetable *pt);
 	u64 (*get_ttbr0)(struct kgsl_pagetable *pt);
 	u32 (*get_contextidr)(struct kgsl_pagetable *pt);
@@ -124,6 +138,11 @@ enum kgsl_mmu_feature {
 	 * @KGSL_MMU_SPLIT_TABLES_LPAC: Split pagetables are enabled for LPAC
 	 */
 	KGSL_MMU_SPLIT_TABLES_LPAC,
+	/**
+	 * @KGSL_MMU_LARGE_PAGES: Align large buffers so they can be mapped
+	 * with 64K and 2M GPU pagetable entries
+	 */
+	KGSL_MMU_LARGE_PAGES,
 };
 
 /**
@@ -171,6 +190,10 @@ int kgsl_mmu_map(struct kgsl_pagetable *pagetable,
 int kgsl_mmu_unmap(struct kgsl_pagetable *pagetable,
 		    struct kgsl_memdesc *memdesc);
 void kgsl_mmu_put_gpuaddr(struct kgsl_memdesc *memdesc);
+bool kgsl_mmu_can_unmap_nosync(struct kgsl_memdesc *memdesc);
+int kgsl_mmu_unmap_nosync(struct kgsl_pagetable *pagetable,
+		struct kgsl_memdesc *memdesc);
+void kgsl_mmu_flush_tlb(struct kgsl_pagetable *pagetable);
 unsigned int kgsl_virtaddr_to_physaddr(void *virtaddr);
 unsigned int kgsl_mmu_log_fault_addr(struct kgsl_mmu *mmu,
 		u64 ttbr0, uint64_t addr);
@@ -4,15 +4,46 @@
  */
 
 #include <asm/cacheflush.h>
+#include <linux/debugfs.h>
 #include <linux/highmem.h>
 #include <linux/of.h>
+#include <linux/page_reservoir.h>
+#include <linux/percpu.h>
 #include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 
+#include "kgsl_debugfs.h"
 #include "kgsl_device.h"
 #include "kgsl_pool.h"
 #include "kgsl_sharedmem.h"
 #include "kgsl_trace.h"
 
+/* Maximum number of entries in a per-cpu magazine */
+#define KGSL_POOL_MAG_SIZE 32
+/* Maximum number of base pages a single per-cpu magazine may hold */
+#define KGSL_POOL_MAG_PAGES 64
+
+/**
+ * struct kgsl_pool_magazine - Per-cpu cache of pages in front of a pool
+ * @lock: Protects the magazine. Only contended when the shrinker or the
+ * exit path drains the magazine of another CPU.
+ * @count: Number of pages currently held in @pages
+ * @pages: Cached pages of the pool order, most recently freed last
+ * @hits: Allocations served from the magazine
+ * @misses: Allocations that found both the magazine and the pool empty
+ * @refills: Number of batches moved from the pool into the magazine
+ * @drains: Number of batches moved from the magazine back to the pool
+ */
+struct kgsl_pool_magazine {
+	spinlock_t lock;
+	unsigned int count;
+	struct page *pages[KGSL_POOL_MAG_SIZE];
+	u64 hits;
+	u64 misses;
+	u64 refills;
+	u64 drains;
+};
+
 /**
  * struct kgsl_page_pool - Structure to hold information for the pool
  * @pool_order: Page order describing the size of the page
@@ -20,6 +51,9 @@
  * @reserved_pages: Number of pages reserved at init for the pool
  * @list_lock: Spinlock for page list in the pool
  * @page_list: List of pages held/reserved in this pool
+ * @mag_size: Capacity of each per-cpu magazine, 0 if magazines are disabled
+ * @mag_batch: Number of pages moved per magazine refill or drain
+ * @mags: Per-cpu magazines in front of @page_list
  */
 struct kgsl_page_pool {
 	unsigned int pool_order;
@@ -27,11 +61,16 @@ struct kgsl_page_pool {
 	unsigned int reserved_pages;
 	spinlock_t list_lock;
 	struct list_head page_list;
+	unsigned int mag_size;
+	unsigned int mag_batch;
+	struct kgsl_pool_magazine __percpu *mags;
 };
 
 static struct kgsl_page_pool kgsl_pools[6];
 static int kgsl_num_pools;
 static int kgsl_pool_max_pages;
+/* Number of base pages held in all pools, including the magazines */
+static atomic_t kgsl_pool_pages = ATOMIC_INIT(0);
 
 static void kgsl_pool_free_page(struct page *page);
 
@@ -89,6 +128,15 @@ _kgsl_pool_zero_page(struct page *p, unsigned int pool_order,
 	kgsl_pool_sync_for_device(dev, p, PAGE_SIZE << pool_order);
 }
 
+/* Account a page entering (nr > 0) or leaving (nr < 0) the pools */
+static void
+_kgsl_pool_account_page(struct kgsl_page_pool *pool, struct page *p, int nr)
+{
+	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
+				nr << pool->pool_order);
+	atomic_add(nr << pool->pool_order, &kgsl_pool_pages);
+}
+
 /* Add a page to specified pool */
 static void
 _kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
@@ -111,8 +159,7 @@ _kgsl_pool_add_page(struct kgsl_page_pool *pool, struct page *p)
 	spin_unlock(&pool->list_lock);
 
 	trace_kgsl_pool_add_page(pool->pool_order, pool->page_count);
-	mod_node_page_state(page_pgdat(p),  NR_KERNEL_MISC_RECLAIMABLE,
-				(1 << pool->pool_order));
+	_kgsl_pool_account_page(pool, p, 1);
 }
 
 /* Returns a page from specified pool */
@@ -133,26 +180,148 @@ _kgsl_pool_get_page(struct kgsl_page_pool *pool)
 	spin_unlock(&pool->list_lock);
 
 	trace_kgsl_pool_get_page(pool->pool_order, pool->page_count);
-	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
-				-(1 << pool->pool_order));
+	_kgsl_pool_account_page(pool, p, -1);
 	return p;
 }
 
-/* Returns the number of pages in all kgsl page pools */
-static int kgsl_pool_size_total(void)
+/*
+ * Move the @nr oldest pages of the magazine back to the pool in one
+ * list_lock section. The caller must hold the magazine lock.
+ */
+static void _kgsl_pool_mag_drain(struct kgsl_page_pool *pool,
+		struct kgsl_pool_magazine *mag, unsigned int nr)
 {
-	int i;
-	int total = 0;
+	unsigned int i;
 
-	for (i = 0; i < kgsl_num_pools; i++) {
-		struct kgsl_page_pool *kgsl_pool = &kgsl_pools[i];
+	nr = min(nr, mag->count);
+	if (!nr)
+		return;
+
+	spin_lock(&pool->list_lock);
+	for (i = 0; i < nr; i++)
+		list_add_tail(&mag->pages[i]->lru, &pool->page_list);
+	pool->page_count += nr;
+	spin_unlock(&pool->list_lock);
+
+	mag->count -= nr;
+	memmove(&mag->pages[0], &mag->pages[nr],
+		mag->count * sizeof(mag->pages[0]));
+	mag->drains++;
+
+	trace_kgsl_pool_add_page(pool->pool_order, pool->page_count);
+}
+
+/*
+ * Refill an empty magazine with up to mag_batch pages from the pool in
+ * one list_lock section. The caller must hold the magazine lock.
+ */
+static void _kgsl_pool_mag_refill(struct kgsl_page_pool *pool,
+		struct kgsl_pool_magazine *mag)
+{
+	struct page *p;
+
+	spin_lock(&pool->list_lock);
+	while (mag->count < pool->mag_batch) {
+		p = list_first_entry_or_null(&pool->page_list, struct page,
+				lru);
+		if (p == NULL)
+			break;
+
+		list_del(&p->lru);
+		mag->pages[mag->count++] = p;
+	}
+	pool->page_count -= mag->count;
+	spin_unlock(&pool->list_lock);
+
+	if (mag->count) {
+		mag->refills++;
+		trace_kgsl_pool_get_page(pool->pool_order, pool->page_count);
+	}
+}
+
+/* Returns a page from the local magazine, refilling it from the pool */
+static struct page *
+kgsl_pool_get_page(struct kgsl_page_pool *pool)
+{
+	struct kgsl_pool_magazine *mag;
+	struct page *p = NULL;
+
+	if (!pool->mags)
+		return _kgsl_pool_get_page(pool);
+
+	mag = get_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+
+	if (!mag->count)
+		_kgsl_pool_mag_refill(pool, mag);
+
+	if (mag->count) {
+		p = mag->pages[--mag->count];
+		mag->hits++;
+	} else
+		mag->misses++;
+
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mags);
+
+	if (p)
+		_kgsl_pool_account_page(pool, p, -1);
+
+	return p;
+}
+
+/* Returns a page to the local magazine, draining it to the pool if full */
+static void
+kgsl_pool_put_page(struct kgsl_page_pool *pool, struct page *p)
+{
+	struct kgsl_pool_magazine *mag;
+
+	if (!pool->mags) {
+		_kgsl_pool_add_page(pool, p);
+		return;
+	}
+
+	/* Same sanity check as _kgsl_pool_add_page() */
+	if (WARN_ON(unlikely(page_count(p) > 1))) {
+		__free_pages(p, pool->pool_order);
+		return;
+	}
+
+	mag = get_cpu_ptr(pool->mags);
+	spin_lock(&mag->lock);
+
+	if (mag->count == pool->mag_size)
+		_kgsl_pool_mag_drain(pool, mag, pool->mag_batch);
+
+	mag->pages[mag->count++] = p;
+
+	spin_unlock(&mag->lock);
+	put_cpu_ptr(pool->mags);
+
+	_kgsl_pool_account_page(pool, p, 1);
+}
+
+/* Return the pages cached in every magazine of the pool to the pool */
+static void kgsl_pool_drain_magazines(struct kgsl_page_pool *pool)
+{
+	int cpu;
+
+	if (!pool->mags)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		struct kgsl_pool_magazine *mag = per_cpu_ptr(pool->mags, cpu);
 
-		spin_lock(&kgsl_pool->list_lock);
-		total += kgsl_pool->page_count * (1 << kgsl_pool->pool_order);
-		spin_unlock(&kgsl_pool->list_lock);
+		spin_lock(&mag->lock);
+		_kgsl_pool_mag_drain(pool, mag, mag->count);
+		spin_unlock(&mag->lock);
 	}
+}
 
-	return total;
+/* Returns the number of pages in all kgsl page pools */
+static int kgsl_pool_size_total(void)
+{
+	return atomic_read(&kgsl_pool_pages);
 }
 
 /*
@@ -179,8 +348,7 @@ _kgsl_pool_get_nonreserved_page(struct kgsl_page_pool *pool)
 	pool->page_count--;
 	list_del(&p->lru);
 	spin_unlock(&pool->list_lock);
-	mod_node_page_state(page_pgdat(p), NR_KERNEL_MISC_RECLAIMABLE,
-			-(1 << pool->pool_order));
+	_kgsl_pool_account_page(pool, p, -1);
 	return p;
 }
 
@@ -200,6 +368,9 @@ _kgsl_pool_shrink(struct kgsl_page_pool *pool,
 	if (pool == NULL || num_pages == 0)
 		return pcount;
 
+	/* Pages parked in the per-cpu magazines are reclaimable too */
+	kgsl_pool_drain_magazines(pool);
+
 	num_pages = (num_pages + (1 << pool->pool_order) - 1) >>
 				pool->pool_order;
 
@@ -337,8 +508,9 @@ static bool kgsl_pool_available(unsigned int page_size)
 {
 	int order = ilog2(page_size >> PAGE_SHIFT);
 
+	/* Only go past 1M when a pool has been set up for it */
 	if (!kgsl_num_pools)
-		return true;
+		return page_size <= SZ_1M;
 
 	return (kgsl_get_pool_index(order) >= 0);
 }
@@ -347,7 +519,7 @@ static int kgsl_get_page_size(size_t size, unsigned int align)
 {
 	size_t pool;
 
-	for (pool = SZ_1M; pool > PAGE_SIZE; pool >>= 1)
+	for (pool = SZ_2M; pool > PAGE_SIZE; pool >>= 1)
 		if ((align >= ilog2(pool)) && (size >= pool) &&
 			kgsl_pool_available(pool))
 			return pool;
@@ -376,6 +548,7 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	int order = get_order(*page_size);
 	int pool_idx;
 	size_t size = 0;
+	bool zeroed = false;
 
 	if ((pages == NULL) || pages_len < (*page_size >> PAGE_SHIFT))
 		return -EINVAL;
@@ -420,12 +593,19 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	}
 
 	pool_idx = kgsl_get_pool_index(order);
-	page = _kgsl_pool_get_page(pool);
+	page = kgsl_pool_get_page(pool);
 
 	/* Allocate a new page if not allocated from pool */
 	if (page == NULL) {
 		gfp_t gfp_mask = kgsl_gfp_mask(order);
 
+		/* Reservoir pages are already zeroed and clean */
+		page = page_reservoir_alloc(order, gfp_mask);
+		if (page) {
+			zeroed = true;
+			goto done;
+		}
+
 		page = alloc_pages(gfp_mask, order);
 
 		if (!page) {
@@ -442,7 +622,8 @@ static int kgsl_pool_alloc_page(int *page_size, struct page **pages,
 	}
 
 done:
-	_kgsl_pool_zero_page(page, order, dev);
+	if (!zeroed)
+		_kgsl_pool_zero_page(page, order, dev);
 
 	for (j = 0; j < (*page_size >> PAGE_SHIFT); j++) {
 		p = nth_page(page, j);
@@ -475,8 +656,8 @@ int kgsl_pool_alloc_pages(u64 size, struct page ***pages, struct device *dev)
 	if (!local)
 		return -ENOMEM;
 
-	/* Start with 1MB alignment to get the biggest page we can */
-	align = ilog2(SZ_1M);
+	/* Start with 2MB alignment to get the biggest page we can */
+	align = ilog2(SZ_2M);
 
 	page_size = kgsl_get_page_size(len, align);
 
@@ -535,7 +716,7 @@ static void kgsl_pool_free_page(struct page *page)
 			(kgsl_pool_size_total() < kgsl_pool_max_pages)) {
 		pool = _kgsl_get_pool_from_order(page_order);
 		if (pool != NULL) {
-			_kgsl_pool_add_page(pool, page);
+			kgsl_pool_put_page(pool, page);
 			return;
 		}
 	}
@@ -591,6 +772,31 @@ static void kgsl_pool_reserve_pages(struct kgsl_page_pool *pool,
 	}
 }
 
+/*
+ * Set up the per-cpu magazines for a pool. Magazines are sized so that a
+ * single CPU never caches more than KGSL_POOL_MAG_PAGES base pages, which
+ * leaves them disabled for the largest orders where there is little lock
+ * traffic to begin with.
+ */
+static void kgsl_pool_init_magazines(struct kgsl_page_pool *pool)
+{
+	int cpu;
+
+	pool->mag_size = min_t(unsigned int, KGSL_POOL_MAG_SIZE,
+			KGSL_POOL_MAG_PAGES >> pool->pool_order);
+	if (!pool->mag_size)
+		return;
+
+	pool->mag_batch = max_t(unsigned int, pool->mag_size / 2, 1);
+
+	pool->mags = alloc_percpu(struct kgsl_pool_magazine);
+	if (!pool->mags)
+		return;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(pool->mags, cpu)->lock);
+}
+
 static int kgsl_of_parse_mempool(struct kgsl_page_pool *pool,
 		struct device_node *node)
 {
@@ -602,7 +808,8 @@ static int kgsl_of_parse_mempool(struct kgsl_page_pool *pool,
 
 	order = ilog2(size >> PAGE_SHIFT);
 
-	if (order > 8) {
+	/* Up to 2M so that large buffers can be mapped with 2M blocks */
+	if (order > 9) {
 		pr_err("kgsl: %pOF: pool order %d is too big\n", node, order);
 		return -EINVAL;
 	}
@@ -612,11 +819,52 @@ static int kgsl_of_parse_mempool(struct kgsl_page_pool *pool,
 	spin_lock_init(&pool->list_lock);
 	INIT_LIST_HEAD(&pool->page_list);
 
+	kgsl_pool_init_magazines(pool);
 	kgsl_pool_reserve_pages(pool, node);
 
 	return 0;
 }
 
+static int kgsl_pool_stats_show(struct seq_file *s, void *unused)
+{
+	int i, cpu;
+
+	seq_printf(s, "%5s %10s %10s %10s %12s %12s %12s %12s\n",
+		"order", "pages", "reserved", "mag_pages", "mag_hits",
+		"mag_misses", "mag_refills", "mag_drains");
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		struct kgsl_page_pool *pool = &kgsl_pools[i];
+		unsigned int mag_pages = 0;
+		u64 hits = 0, misses = 0, refills = 0, drains = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct kgsl_pool_magazine *mag;
+
+			if (!pool->mags)
+				break;
+
+			mag = per_cpu_ptr(pool->mags, cpu);
+			spin_lock(&mag->lock);
+			mag_pages += mag->count;
+			hits += mag->hits;
+			misses += mag->misses;
+			refills += mag->refills;
+			drains += mag->drains;
+			spin_unlock(&mag->lock);
+		}
+
+		seq_printf(s, "%5u %10u %10u %10u %12llu %12llu %12llu %12llu\n",
+			pool->pool_order, READ_ONCE(pool->page_count),
+			pool->reserved_pages, mag_pages, hits, misses,
+			refills, drains);
+	}
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(kgsl_pool_stats);
+
 void kgsl_probe_page_pools(void)
 {
 	struct device_node *node, *child;
@@ -645,14 +893,25 @@ void kgsl_probe_page_pools(void)
 
 	/* Initialize shrinker */
 	register_shrinker(&kgsl_pool_shrinker);
+
+	if (!IS_ERR_OR_NULL(kgsl_get_debugfs_dir()))
+		debugfs_create_file("page_pools", 0444, kgsl_get_debugfs_dir(),
+			NULL, &kgsl_pool_stats_fops);
 }
 
 void kgsl_exit_page_pools(void)
 {
+	int i;
+
 	/* Release all pages in pools, if any.*/
 	kgsl_pool_reduce(INT_MAX, true);
 
 	/* Unregister shrinker */
 	unregister_shrinker(&kgsl_pool_shrinker);
+
+	for (i = 0; i < kgsl_num_pools; i++) {
+		free_percpu(kgsl_pools[i].mags);
+		kgsl_pools[i].mags = NULL;
+	}
 }
 
@@ -5,6 +5,7 @@
 
 #include <linux/devfreq_cooling.h>
 #include <linux/slab.h>
+#include <linux/thermal_frame.h>
 
 #include "kgsl_bus.h"
 #include "kgsl_device.h"
@@ -34,6 +35,7 @@ static struct kgsl_midframe_info {
 static void do_devfreq_suspend(struct work_struct *work);
 static void do_devfreq_resume(struct work_struct *work);
 static void do_devfreq_notify(struct work_struct *work);
+static void do_devfreq_frame(struct work_struct *work);
 
 /*
  * These variables are used to keep the latest data
@@ -168,6 +170,23 @@ void kgsl_pwrscale_update(struct kgsl_device *device)
 	kgsl_pwrscale_midframe_timer_restart(device);
 }
 
+/*
+ * kgsl_pwrscale_frame_retired() - tell the governor a frame has retired
+ * @device: The device
+ *
+ * Called by the dispatcher when a command marked with
+ * KGSL_DRAWOBJ_END_OF_FRAME retires. Frame aware governors use this to
+ * close out the GPU work accumulated for the frame.
+ */
+void kgsl_pwrscale_frame_retired(struct kgsl_device *device)
+{
+	if (!device->pwrscale.enabled)
+		return;
+
+	queue_work(device->pwrscale.devfreq_wq,
+		&device->pwrscale.devfreq_frame_ws);
+}
+
 void kgsl_pwrscale_midframe_timer_restart(struct kgsl_device *device)
 {
 	if (kgsl_midframe) {
@@ -400,6 +419,7 @@ int kgsl_devfreq_get_dev_status(struct device *dev,
 	}
 
 	kgsl_pwrctrl_busy_time(device, stat->total_time, stat->busy_time);
+	thermal_frame_gpu_busy(stat->busy_time, stat->total_time);
 	trace_kgsl_pwrstats(device, stat->total_time,
 		&pwrscale->accum_stats, device->active_context_count);
 	memset(&pwrscale->accum_stats, 0, sizeof(pwrscale->accum_stats));
@@ -891,6 +911,7 @@ int kgsl_pwrscale_init(struct kgsl_device *device, struct platform_device *pdev,
 	INIT_WORK(&pwrscale->devfreq_suspend_ws, do_devfreq_suspend);
 	INIT_WORK(&pwrscale->devfreq_resume_ws, do_devfreq_resume);
 	INIT_WORK(&pwrscale->devfreq_notify_ws, do_devfreq_notify);
+	INIT_WORK(&pwrscale->devfreq_frame_ws, do_devfreq_frame);
 	if (kgsl_midframe)
 		INIT_WORK(&kgsl_midframe->timer_check_ws,
 				kgsl_pwrscale_midframe_timer_check);
@@ -977,3 +998,14 @@ static void do_devfreq_notify(struct work_struct *work)
 				 ADRENO_DEVFREQ_NOTIFY_RETIRE,
 				 devfreq);
 }
+
+static void do_devfreq_frame(struct work_struct *work)
+{
+	struct kgsl_pwrscale *pwrscale = container_of(work,
+			struct kgsl_pwrscale, devfreq_frame_ws);
+	struct devfreq *devfreq = pwrscale->devfreqptr;
+
+	srcu_notifier_call_chain(&pwrscale->nh,
+				 ADRENO_DEVFREQ_NOTIFY_FRAME,
+				 devfreq);
+}
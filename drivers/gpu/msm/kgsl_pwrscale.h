@@ -34,6 +34,7 @@ struct kgsl_power_stats {
  * @devfreq_suspend_ws - Pass device suspension to devfreq
  * @devfreq_resume_ws - Pass device resume to devfreq
  * @devfreq_notify_ws - Notify devfreq to update sampling
+ * @devfreq_frame_ws - Notify devfreq that a frame has retired
  * @next_governor_call - Timestamp after which the governor may be notified of
  * a new sample
  * @cooling_dev - Thermal cooling device handle
@@ -58,6 +59,7 @@ struct kgsl_pwrscale {
 	struct work_struct devfreq_suspend_ws;
 	struct work_struct devfreq_resume_ws;
 	struct work_struct devfreq_notify_ws;
+	struct work_struct devfreq_frame_ws;
 	ktime_t next_governor_call;
 	struct thermal_cooling_device *cooling_dev;
 	bool ctxt_aware_enable;
@@ -81,6 +83,7 @@ void kgsl_pwrscale_close(struct kgsl_device *device);
 
 void kgsl_pwrscale_update(struct kgsl_device *device);
 void kgsl_pwrscale_update_stats(struct kgsl_device *device);
+void kgsl_pwrscale_frame_retired(struct kgsl_device *device);
 void kgsl_pwrscale_busy(struct kgsl_device *device);
 void kgsl_pwrscale_sleep(struct kgsl_device *device);
 void kgsl_pwrscale_wake(struct kgsl_device *device);
@@ -176,11 +176,49 @@ gpumem_unmapped_show(struct kgsl_process_private *priv, int type, char *buf)
 			gpumem_total - gpumem_mapped);
 }
 
+static ssize_t gpu_hist_show(const u64 *hist, char *buf)
+{
+	ssize_t count = 0;
+	int i;
+
+	for (i = 0; i < KGSL_GPU_HIST_BUCKETS; i++)
+		count += scnprintf(buf + count, PAGE_SIZE - count, "%llu%c",
+			READ_ONCE(hist[i]),
+			i == KGSL_GPU_HIST_BUCKETS - 1 ? '\n' : ' ');
+
+	return count;
+}
+
+static ssize_t
+gpu_queue_depth_show(struct kgsl_process_private *priv, int type, char *buf)
+{
+	return gpu_hist_show(priv->gpu_stats.queue_depth, buf);
+}
+
+static ssize_t
+gpu_submit_to_start_show(struct kgsl_process_private *priv, int type,
+		char *buf)
+{
+	return gpu_hist_show(priv->gpu_stats.submit_to_start, buf);
+}
+
+static ssize_t
+gpu_start_to_retire_show(struct kgsl_process_private *priv, int type,
+		char *buf)
+{
+	return gpu_hist_show(priv->gpu_stats.start_to_retire, buf);
+}
+
 static struct kgsl_mem_entry_attribute debug_memstats[] = {
 	__MEM_ENTRY_ATTR(0, imported_mem, imported_mem_show),
 	__MEM_ENTRY_ATTR(0, gpumem_mapped, gpumem_mapped_show),
 	__MEM_ENTRY_ATTR(KGSL_MEM_ENTRY_KERNEL, gpumem_unmapped,
 				gpumem_unmapped_show),
+	__MEM_ENTRY_ATTR(0, gpu_queue_depth_hist, gpu_queue_depth_show),
+	__MEM_ENTRY_ATTR(0, gpu_submit_to_start_hist,
+				gpu_submit_to_start_show),
+	__MEM_ENTRY_ATTR(0, gpu_start_to_retire_hist,
+				gpu_start_to_retire_show),
 };
 
 /**
@@ -1204,6 +1242,28 @@ static int kgsl_alloc_secure_pages(struct kgsl_device *device,
 }
 #endif
 
+/*
+ * Align the GPU address of large buffers to the biggest pagetable entry they
+ * can use. kgsl_pool_alloc_pages() hands out chunks from the largest size
+ * down so every chunk then lands on a GPU address aligned to its own size
+ * and the SMMU can map it with 2M blocks or 64K contiguous runs.
+ */
+static void kgsl_memdesc_large_page_align(struct kgsl_device *device,
+		struct kgsl_memdesc *memdesc, u64 size)
+{
+	unsigned int align = kgsl_memdesc_get_align(memdesc);
+
+	if (!kgsl_mmu_has_feature(device, KGSL_MMU_LARGE_PAGES))
+		return;
+
+	if (size >= SZ_2M)
+		align = max_t(unsigned int, align, ilog2(SZ_2M));
+	else if (size >= SZ_64K)
+		align = max_t(unsigned int, align, ilog2(SZ_64K));
+
+	kgsl_memdesc_set_align(memdesc, align);
+}
+
 static int kgsl_alloc_pages(struct kgsl_device *device,
 		struct kgsl_memdesc *memdesc, u64 size, u64 flags, u32 priv)
 {
@@ -1218,6 +1278,8 @@ static int kgsl_alloc_pages(struct kgsl_device *device,
 	kgsl_memdesc_init(device, memdesc, flags);
 	memdesc->priv |= priv;
 
+	kgsl_memdesc_large_page_align(device, memdesc, size);
+
 	if (priv & KGSL_MEMDESC_SYSMEM) {
 		memdesc->ops = &kgsl_system_ops;
 		count = kgsl_system_alloc_pages(size, &pages, device->dev);
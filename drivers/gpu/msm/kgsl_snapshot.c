@@ -3,6 +3,8 @@
  * Copyright (c) 2012-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/devcoredump.h>
+#include <linux/module.h>
 #include <linux/notifier.h>
 #include <linux/of.h>
 #include <linux/slab.h>
@@ -532,6 +534,17 @@ void kgsl_snapshot_indexed_registers(struct kgsl_device *device,
 		snapshot, kgsl_snapshot_dump_indexed_regs, &iregs);
 }
 
+static bool kgsl_snapshot_section_filtered(struct kgsl_device *device, u16 id)
+{
+	u16 class = id >> 8;
+
+	/* The OS section is what tools key off, so always keep it */
+	if (id == KGSL_SNAPSHOT_SECTION_OS || class >= 32)
+		return false;
+
+	return device->snapshot_section_filter & BIT(class);
+}
+
 /**
  * kgsl_snapshot_add_section() - Add a new section to the GPU snapshot
  * @device: the KGSL device being snapshotted
@@ -541,7 +554,8 @@ void kgsl_snapshot_indexed_registers(struct kgsl_device *device,
  * @priv: Private pointer to pass to the function
  *
  * Set up a KGSL snapshot header by filling the memory with the callback
- * function and adding the standard section header
+ * function and adding the standard section header. Sections whose class is
+ * set in the snapshot section_filter are skipped without calling @func.
  */
 void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	struct kgsl_snapshot *snapshot,
@@ -563,6 +577,9 @@ void kgsl_snapshot_add_section(struct kgsl_device *device, u16 id,
 	if (snapshot->remain < sizeof(*header))
 		return;
 
+	if (kgsl_snapshot_section_filtered(device, id))
+		return;
+
 	/* It is legal to have no function (i.e. - make an empty section) */
 	if (func) {
 		ret = func(device, data, snapshot->remain - sizeof(*header),
@@ -839,6 +856,15 @@ void kgsl_device_snapshot(struct kgsl_device *device,
 	snapshot->first_read = true;
 	snapshot->sysfs_read = 0;
 
+	/*
+	 * A streamed snapshot is handed to devcoredump once the dump worker
+	 * is done. devcoredump counts as a reader until it lets go of it.
+	 */
+	if (device->snapshot_stream) {
+		snapshot->stream = true;
+		snapshot->sysfs_read = 1;
+	}
+
 	header = (struct kgsl_snapshot_header *) snapshot->ptr;
 
 	header->magic = SNAPSHOT_MAGIC;
@@ -961,6 +987,132 @@ static int snapshot_release(struct kgsl_device *device,
 	return ret;
 }
 
+/*
+ * Drop a reader reference once it has seen the whole snapshot. The last
+ * reader out frees the snapshot so the next fault can be captured.
+ */
+static void snapshot_read_done(struct kgsl_device *device,
+	struct kgsl_snapshot *snapshot)
+{
+	bool snapshot_free = false;
+
+	mutex_lock(&device->mutex);
+	if (--snapshot->sysfs_read == 0) {
+		if (device->snapshot == snapshot)
+			device->snapshot = NULL;
+		snapshot_free = true;
+	}
+	mutex_unlock(&device->mutex);
+
+	if (snapshot_free)
+		kgsl_free_snapshot(snapshot);
+}
+
+/*
+ * Build the GPU object sections of a streamed snapshot straight from the
+ * frozen memory entries. Objects that end before the read offset are stepped
+ * over without being mapped.
+ */
+static int snapshot_stream_objects(struct snapshot_obj_itr *itr,
+	struct kgsl_snapshot *snapshot)
+{
+	struct kgsl_snapshot_section_header section;
+	struct kgsl_snapshot_gpu_object_v2 header;
+	struct kgsl_snapshot_object *obj;
+	void *zero = page_address(ZERO_PAGE(0));
+	int size, len;
+
+	list_for_each_entry(obj, &snapshot->obj_list, node) {
+		size = obj->size + sizeof(header) + sizeof(section);
+
+		if (itr->remain == 0)
+			return 0;
+
+		if ((itr->pos + size) <= itr->offset) {
+			itr->pos += size;
+			continue;
+		}
+
+		section.magic = SNAPSHOT_SECTION_MAGIC;
+		section.id = KGSL_SNAPSHOT_SECTION_GPU_OBJECT_V2;
+		section.size = size;
+
+		memset(&header, 0, sizeof(header));
+		header.size = obj->size >> 2;
+		header.gpuaddr = obj->gpuaddr;
+		header.ptbase =
+			kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
+		header.type = obj->type;
+
+		obj_itr_out(itr, &section, sizeof(section));
+		obj_itr_out(itr, &header, sizeof(header));
+
+		if (itr->remain == 0)
+			return 0;
+
+		if (kgsl_memdesc_map(&obj->entry->memdesc)) {
+			obj_itr_out(itr, obj->entry->memdesc.hostptr +
+				obj->offset, obj->size);
+			kgsl_memdesc_unmap(&obj->entry->memdesc);
+			continue;
+		}
+
+		/* The size is already in the header so pad out with zeros */
+		for (len = obj->size; len > 0; len -= PAGE_SIZE)
+			obj_itr_out(itr, zero, min_t(int, len, PAGE_SIZE));
+	}
+
+	return 1;
+}
+
+/*
+ * Copy the snapshot out starting at @off. Returns the number of bytes written,
+ * which is zero once @off is past the end of the snapshot.
+ */
+static size_t snapshot_read(struct kgsl_snapshot *snapshot, char *buf,
+	loff_t off, size_t count)
+{
+	struct kgsl_snapshot_section_header head;
+	struct snapshot_obj_itr itr;
+
+	obj_itr_init(&itr, buf, off, count);
+
+	if (obj_itr_out(&itr, snapshot->start, snapshot->size) == 0)
+		goto done;
+
+	/* Dump the memory pool if it exists */
+	if (snapshot->mempool) {
+		if (obj_itr_out(&itr, snapshot->mempool,
+				snapshot->mempool_size) == 0)
+			goto done;
+	} else if (snapshot->stream && snapshot->mempool_size) {
+		if (snapshot_stream_objects(&itr, snapshot) == 0)
+			goto done;
+	}
+
+	head.magic = SNAPSHOT_SECTION_MAGIC;
+	head.id = KGSL_SNAPSHOT_SECTION_END;
+	head.size = sizeof(head);
+
+	obj_itr_out(&itr, &head, sizeof(head));
+
+done:
+	return itr.write;
+}
+
+static ssize_t snapshot_stream_read(char *buffer, loff_t offset, size_t count,
+	void *data, size_t datalen)
+{
+	return snapshot_read(data, buffer, offset, count);
+}
+
+static void snapshot_stream_free(void *data)
+{
+	struct kgsl_snapshot *snapshot = data;
+
+	snapshot_read_done(snapshot->device, snapshot);
+}
+
 /* Dump the sysfs binary data to the user */
 static ssize_t snapshot_show(struct file *filep, struct kobject *kobj,
 	struct bin_attribute *attr, char *buf, loff_t off,
@@ -968,8 +1120,7 @@ static ssize_t snapshot_show(struct file *filep, struct kobject *kobj,
 {
 	struct kgsl_device *device = kobj_to_device(kobj);
 	struct kgsl_snapshot *snapshot;
-	struct kgsl_snapshot_section_header head;
-	struct snapshot_obj_itr itr;
+	size_t written;
 	int ret = 0;
 
 	mutex_lock(&device->mutex);
@@ -1008,54 +1159,21 @@ static ssize_t snapshot_show(struct file *filep, struct kobject *kobj,
 		return ret;
 	}
 
-	obj_itr_init(&itr, buf, off, count);
-
-	ret = obj_itr_out(&itr, snapshot->start, snapshot->size);
-	if (ret == 0)
-		goto done;
-
-	/* Dump the memory pool if it exists */
-	if (snapshot->mempool) {
-		ret = obj_itr_out(&itr, snapshot->mempool,
-				snapshot->mempool_size);
-		if (ret == 0)
-			goto done;
-	}
-
-	{
-		head.magic = SNAPSHOT_SECTION_MAGIC;
-		head.id = KGSL_SNAPSHOT_SECTION_END;
-		head.size = sizeof(head);
-
-		obj_itr_out(&itr, &head, sizeof(head));
-	}
+	written = snapshot_read(snapshot, buf, off, count);
 
 	/*
 	 * Make sure everything has been written out before destroying things.
 	 * The best way to confirm this is to go all the way through without
 	 * writing any bytes - so only release if we get this far and
-	 * itr->write is 0 and there are no concurrent reads pending
+	 * nothing was written and there are no concurrent reads pending
 	 */
-
-	if (itr.write == 0) {
-		bool snapshot_free = false;
-
-		mutex_lock(&device->mutex);
-		if (--snapshot->sysfs_read == 0) {
-			if (device->snapshot == snapshot)
-				device->snapshot = NULL;
-			snapshot_free = true;
-		}
-		mutex_unlock(&device->mutex);
-
-		if (snapshot_free)
-			kgsl_free_snapshot(snapshot);
+	if (written == 0) {
+		snapshot_read_done(device, snapshot);
 		return 0;
 	}
 
-done:
 	ret = snapshot_release(device, snapshot);
-	return (ret < 0) ? ret : itr.write;
+	return (ret < 0) ? ret : written;
 }
 
 /* Show the total number of hangs since device boot */
@@ -1164,6 +1282,36 @@ static ssize_t snapshot_legacy_store(struct kgsl_device *device,
 	return count;
 }
 
+static ssize_t snapshot_stream_show(struct kgsl_device *device, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%d\n", device->snapshot_stream);
+}
+
+static ssize_t snapshot_stream_store(struct kgsl_device *device,
+	const char *buf, size_t count)
+{
+	if (strtobool(buf, &device->snapshot_stream))
+		return -EINVAL;
+
+	return count;
+}
+
+/* Show the mask of section classes left out of the snapshot */
+static ssize_t section_filter_show(struct kgsl_device *device, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "0x%x\n",
+			device->snapshot_section_filter);
+}
+
+static ssize_t section_filter_store(struct kgsl_device *device,
+	const char *buf, size_t count)
+{
+	int ret;
+
+	ret = kstrtou32(buf, 0, &device->snapshot_section_filter);
+	return ret ? ret : count;
+}
+
 static struct bin_attribute snapshot_attr = {
 	.attr.name = "dump",
 	.attr.mode = 0444,
@@ -1189,6 +1337,10 @@ static SNAPSHOT_ATTR(snapshot_legacy, 0644, snapshot_legacy_show,
 	snapshot_legacy_store);
 static SNAPSHOT_ATTR(skip_ib_capture, 0644, skip_ib_capture_show,
 		skip_ib_capture_store);
+static SNAPSHOT_ATTR(snapshot_stream, 0644, snapshot_stream_show,
+	snapshot_stream_store);
+static SNAPSHOT_ATTR(section_filter, 0644, section_filter_show,
+	section_filter_store);
 
 static ssize_t snapshot_sysfs_show(struct kobject *kobj,
 	struct attribute *attr, char *buf)
@@ -1235,6 +1387,8 @@ static const struct attribute *snapshot_attrs[] = {
 	&attr_snapshot_crashdumper.attr,
 	&attr_snapshot_legacy.attr,
 	&attr_skip_ib_capture.attr,
+	&attr_snapshot_stream.attr,
+	&attr_section_filter.attr,
 	NULL,
 };
 
@@ -1280,6 +1434,9 @@ void kgsl_device_snapshot_probe(struct kgsl_device *device, u32 size)
 	device->force_panic = false;
 	device->snapshot_crashdumper = true;
 	device->snapshot_legacy = false;
+	device->snapshot_stream = of_property_read_bool(device->pdev->dev.of_node,
+		"qcom,snapshot-stream");
+	device->snapshot_section_filter = 0;
 
 	device->snapshot_atomic = false;
 	device->panic_nb.notifier_call = kgsl_panic_notifier_callback;
@@ -1355,6 +1512,18 @@ int kgsl_snapshot_add_ib_obj_list(struct kgsl_snapshot *snapshot,
 	return 0;
 }
 
+static void _snapshot_check_ib_dumped(struct kgsl_snapshot *snapshot,
+		struct kgsl_snapshot_object *obj)
+{
+	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
+				snapshot->ib1base, snapshot->ib1size))
+		snapshot->ib1dumped = true;
+
+	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
+				snapshot->ib2base, snapshot->ib2size))
+		snapshot->ib2dumped = true;
+}
+
 static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 		struct kgsl_snapshot_object *obj)
 {
@@ -1383,13 +1552,7 @@ static size_t _mempool_add_object(struct kgsl_snapshot *snapshot, u8 *data,
 		kgsl_mmu_pagetable_get_ttbr0(obj->entry->priv->pagetable);
 	header->type = obj->type;
 
-	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
-				snapshot->ib1base, snapshot->ib1size))
-		snapshot->ib1dumped = true;
-
-	if (kgsl_addr_range_overlap(obj->gpuaddr, obj->size,
-				snapshot->ib2base, snapshot->ib2size))
-		snapshot->ib2dumped = true;
+	_snapshot_check_ib_dumped(snapshot, obj);
 
 	memcpy(dest, obj->entry->memdesc.hostptr + obj->offset, size);
 	kgsl_memdesc_unmap(&obj->entry->memdesc);
@@ -1416,18 +1579,37 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 
 	kgsl_snapshot_process_ib_obj_list(snapshot);
 
+	if (kgsl_snapshot_section_filtered(snapshot->device,
+			KGSL_SNAPSHOT_SECTION_GPU_OBJECT_V2)) {
+		list_for_each_entry_safe(obj, tmp, &snapshot->obj_list, node)
+			kgsl_snapshot_put_object(obj);
+		goto done;
+	}
+
 	list_for_each_entry(obj, &snapshot->obj_list, node) {
 		obj->size = ALIGN(obj->size, 4);
 
 		size += ((size_t) obj->size +
 			sizeof(struct kgsl_snapshot_gpu_object_v2) +
 			sizeof(struct kgsl_snapshot_section_header));
+
+		if (snapshot->stream)
+			_snapshot_check_ib_dumped(snapshot, obj);
 	}
 
 	if (size == 0)
 		goto done;
 
-	snapshot->mempool = vmalloc(size);
+	/*
+	 * A streamed snapshot keeps its references on the objects and reads
+	 * them out when the dump is read instead of copying them all here.
+	 */
+	if (snapshot->stream) {
+		snapshot->mempool_size = size;
+		goto done;
+	}
+
+	snapshot->mempool = vmalloc_huge(size, GFP_KERNEL);
 
 	ptr = snapshot->mempool;
 	snapshot->mempool_size = 0;
@@ -1464,4 +1646,10 @@ static void kgsl_snapshot_save_frozen_objs(struct work_struct *work)
 	BUG_ON(!snapshot->device->skip_ib_capture &&
 				snapshot->device->force_panic);
 	complete_all(&snapshot->dump_gate);
+
+	if (snapshot->stream)
+		dev_coredumpm(snapshot->device->dev, THIS_MODULE, snapshot,
+			snapshot->size + snapshot->mempool_size +
+			sizeof(struct kgsl_snapshot_section_header),
+			GFP_KERNEL, snapshot_stream_read, snapshot_stream_free);
 }
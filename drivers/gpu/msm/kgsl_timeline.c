@@ -93,6 +93,13 @@ struct dma_fence *kgsl_timelines_to_fence_array(struct kgsl_device *device,
 	return ERR_PTR(ret);
 }
 
+/* Publish the current value to userspace. Called with timeline->lock held */
+static void kgsl_timeline_shadow_update(struct kgsl_timeline *timeline)
+{
+	if (timeline->shadow)
+		WRITE_ONCE(*timeline->shadow, timeline->value);
+}
+
 void kgsl_timeline_destroy(struct kref *kref)
 {
 	struct kgsl_timeline *timeline = container_of(kref,
@@ -152,6 +159,11 @@ static struct kgsl_timeline *kgsl_timeline_alloc(struct kgsl_device_private *dev
 	spin_lock_init(&timeline->lock);
 	spin_lock_init(&timeline->fence_lock);
 
+	if (device->timeline_shadow && id < KGSL_TIMELINE_SHADOW_SLOTS) {
+		timeline->shadow = &device->timeline_shadow[id];
+		kgsl_timeline_shadow_update(timeline);
+	}
+
 	kref_init(&timeline->ref);
 
 	return timeline;
@@ -268,6 +280,7 @@ void kgsl_timeline_signal(struct kgsl_timeline *timeline, u64 seqno)
 	trace_kgsl_timeline_signal(timeline->id, seqno);
 
 	timeline->value = seqno;
+	kgsl_timeline_shadow_update(timeline);
 
 	spin_lock(&timeline->fence_lock);
 	list_for_each_entry_safe(fence, tmp, &timeline->fences, node)
@@ -539,6 +552,17 @@ long kgsl_ioctl_timeline_destroy(struct kgsl_device_private *dev_priv,
 		return -EINVAL;
 	}
 
+	/*
+	 * Give up the shadow slot before the id can be handed out again so a
+	 * late signal can't write over the next owner of the slot.
+	 */
+	spin_lock_irq(&timeline->lock);
+	if (timeline->shadow) {
+		WRITE_ONCE(*timeline->shadow, 0);
+		timeline->shadow = NULL;
+	}
+	spin_unlock_irq(&timeline->lock);
+
 	idr_remove(&device->timelines, timeline->id);
 	spin_unlock(&device->timelines_lock);
 
@@ -6,6 +6,12 @@
 #ifndef __KGSL_TIMELINE_H
 #define __KGSL_TIMELINE_H
 
+/* mmap() offset used to identify the timeline shadow page */
+#define KGSL_TIMELINE_SHADOW_TOKEN_ADDRESS 0xffe00000
+
+/* Number of timelines that have a slot in the timeline shadow page */
+#define KGSL_TIMELINE_SHADOW_SLOTS (PAGE_SIZE / sizeof(u64))
+
 /**
  * struct kgsl_timeline - Container for a timeline object
  */
@@ -28,6 +34,11 @@ struct kgsl_timeline {
 	const char name[32];
 	/** @dev_priv: pointer to the owning device instance */
 	struct kgsl_device_private *dev_priv;
+	/**
+	 * @shadow: Slot in the timeline shadow page that mirrors @value or
+	 * NULL if the timeline doesn't have one. Protected by @lock.
+	 */
+	u64 *shadow;
 };
 
 /**
@@ -51,12 +51,16 @@ MODULE_PARM_DESC(mousepoll, "Polling interval of mice");
 
 static unsigned int hid_jspoll_interval;
 module_param_named(jspoll, hid_jspoll_interval, uint, 0644);
-MODULE_PARM_DESC(jspoll, "Polling interval of joysticks");
+MODULE_PARM_DESC(jspoll, "Polling interval of joysticks and gamepads");
 
 static unsigned int hid_kbpoll_interval;
 module_param_named(kbpoll, hid_kbpoll_interval, uint, 0644);
 MODULE_PARM_DESC(kbpoll, "Polling interval of keyboards");
 
+static bool hid_lowlat;
+module_param_named(lowlat, hid_lowlat, bool, 0644);
+MODULE_PARM_DESC(lowlat, "Low latency mode for joysticks and gamepads");
+
 static unsigned int ignoreled;
 module_param_named(ignoreled, ignoreled, uint, 0644);
 MODULE_PARM_DESC(ignoreled, "Autosuspend with active leds");
@@ -268,6 +272,36 @@ static int usbhid_restart_ctrl_queue(struct usbhid_device *usbhid)
  * Input interrupt completion handler.
  */
 
+static void usbhid_lat_account(unsigned int *hist, s64 us)
+{
+	unsigned int bucket = us > 1 ? ilog2(us) : 0;
+
+	hist[min(bucket, USBHID_LAT_BUCKETS - 1U)]++;
+}
+
+/*
+ * Input reports are handled in URB completion context, which for xHCI
+ * is the controller's hard IRQ, so the events reach the input core
+ * without any deferral. In low latency mode the events are stamped with
+ * the URB completion time rather than with the time of input_sync().
+ */
+static void usbhid_report_begin(struct hid_device *hid, ktime_t now)
+{
+	struct usbhid_device *usbhid = hid->driver_data;
+	struct hid_input *hidinput;
+
+	if (usbhid->reports++)
+		usbhid_lat_account(usbhid->interval_hist,
+				   ktime_us_delta(now, usbhid->last_in));
+	usbhid->last_in = now;
+
+	if (!usbhid->lowlat || !(hid->claimed & HID_CLAIMED_INPUT))
+		return;
+
+	list_for_each_entry(hidinput, &hid->inputs, list)
+		input_set_timestamp(hidinput->input, now);
+}
+
 #if defined CONFIG_MACH_ASUS_ZS673KS
 extern u8 key_state;
 #endif
@@ -276,6 +310,7 @@ static void hid_irq_in(struct urb *urb)
 	struct hid_device	*hid = urb->context;
 	struct usbhid_device	*usbhid = hid->driver_data;
 	int			status;
+	ktime_t			now;
 #if defined CONFIG_MACH_ASUS_ZS673KS
 	u8	buffer_ret[2];
 #endif
@@ -287,9 +322,13 @@ static void hid_irq_in(struct urb *urb)
 			break;
 		usbhid_mark_busy(usbhid);
 		if (!test_bit(HID_RESUME_RUNNING, &usbhid->iofl)) {
+			now = ktime_get();
+			usbhid_report_begin(hid, now);
 			hid_input_report(urb->context, HID_INPUT_REPORT,
 					 urb->transfer_buffer,
 					 urb->actual_length, 1);
+			usbhid_lat_account(usbhid->handle_hist,
+					   ktime_us_delta(ktime_get(), now));
 			/*
 			 * autosuspend refused while keys are pressed
 			 * because most keyboards don't wake up when
@@ -303,7 +342,7 @@ static void hid_irq_in(struct urb *urb)
 #if defined CONFIG_MACH_ASUS_ZS673KS
 		if ( (hid->vendor == 0x0BDA) && (hid->product == 0x4BF0) ){
 			memcpy(buffer_ret, urb->transfer_buffer, sizeof(buffer_ret));
-			pr_info("%s(%d)buf0:%x,buf1:%x\n",__func__, __LINE__, buffer_ret[0], buffer_ret[1]);
+			pr_debug("%s(%d)buf0:%x,buf1:%x\n",__func__, __LINE__, buffer_ret[0], buffer_ret[1]);
 			key_state = buffer_ret[1];
 		}
 #endif
@@ -1140,6 +1179,13 @@ static int usbhid_start(struct hid_device *hid)
 
 	clear_bit(HID_DISCONNECTED, &usbhid->iofl);
 
+	usbhid->lowlat = hid_lowlat &&
+		(hid->collection->usage == HID_GD_JOYSTICK ||
+		 hid->collection->usage == HID_GD_GAMEPAD);
+	/* A runtime resume would delay the first report by tens of ms */
+	if (usbhid->lowlat)
+		usb_disable_autosuspend(dev);
+
 	usbhid->bufsize = HID_MIN_BUFFER_SIZE;
 	hid_find_max_report(hid, HID_INPUT_REPORT, &usbhid->bufsize);
 	hid_find_max_report(hid, HID_OUTPUT_REPORT, &usbhid->bufsize);
@@ -1186,8 +1232,11 @@ static int usbhid_start(struct hid_device *hid)
 				interval = hid_mousepoll_interval;
 			break;
 		case HID_GD_JOYSTICK:
+		case HID_GD_GAMEPAD:
 			if (hid_jspoll_interval > 0)
 				interval = hid_jspoll_interval;
+			else if (usbhid->lowlat)
+				interval = 1;
 			break;
 		case HID_GD_KEYBOARD:
 			if (hid_kbpoll_interval > 0)
@@ -1385,6 +1434,28 @@ struct hid_ll_driver usb_hid_driver = {
 };
 EXPORT_SYMBOL_GPL(usb_hid_driver);
 
+static ssize_t latency_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct hid_device *hid = to_hid_device(dev);
+	struct usbhid_device *usbhid = hid->driver_data;
+	int i, len;
+
+	len = scnprintf(buf, PAGE_SIZE, "reports: %lu lowlat: %d\n",
+			usbhid->reports, usbhid->lowlat);
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			 "%8s %10s %10s\n", "us", "handling", "interval");
+	for (i = 0; i < USBHID_LAT_BUCKETS; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%7u%c %10u %10u\n", 1U << i,
+				 i == USBHID_LAT_BUCKETS - 1 ? '+' : ' ',
+				 usbhid->handle_hist[i],
+				 usbhid->interval_hist[i]);
+
+	return len;
+}
+static DEVICE_ATTR_RO(latency);
+
 static int usbhid_probe(struct usb_interface *intf, const struct usb_device_id *id)
 {
 	struct usb_host_interface *interface = intf->cur_altsetting;
@@ -1479,9 +1550,13 @@ static int usbhid_probe(struct usb_interface *intf, const struct usb_device_id *
 		goto err_free;
 	}
 
+	if (device_create_file(&hid->dev, &dev_attr_latency))
+		hid_warn(intf, "can't create latency attribute\n");
+
 #if defined CONFIG_MACH_ASUS_ZS673KS
 	/* enable suspend/resume support for HID devices. */
 	if ((le16_to_cpu(dev->descriptor.idVendor) == 0x0BDA) &&
+	 !usbhid->lowlat &&
 	 ((le16_to_cpu(dev->descriptor.idProduct) == 0x480F)
 	||(le16_to_cpu(dev->descriptor.idProduct) == 0x4A41)
 	||(le16_to_cpu(dev->descriptor.idProduct) == 0x4A43)
@@ -1512,6 +1587,7 @@ static void usbhid_disconnect(struct usb_interface *intf)
 	spin_lock_irq(&usbhid->lock);	/* Sync with error and led handlers */
 	set_bit(HID_DISCONNECTED, &usbhid->iofl);
 	spin_unlock_irq(&usbhid->lock);
+	device_remove_file(&hid->dev, &dev_attr_latency);
 	hid_destroy_device(hid);
 	kfree(usbhid);
 }
@@ -15,6 +15,7 @@
 #include <linux/slab.h>
 #include <linux/list.h>
 #include <linux/mutex.h>
+#include <linux/ktime.h>
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
@@ -48,6 +49,9 @@ struct usb_interface *usbhid_find_interface(int minor);
  */
 #define HID_IN_POLLING		14
 
+/* Latency histograms: bucket n counts [2^n, 2^(n+1)) us, the last is open */
+#define USBHID_LAT_BUCKETS	16
+
 /*
  * USB-specific HID struct, to be pointed to
  * from struct hid_device->driver_data
@@ -88,6 +92,12 @@ struct usbhid_device {
 	unsigned int retry_delay;                                       /* Delay length in ms */
 	struct work_struct reset_work;                                  /* Task context for resets */
 	wait_queue_head_t wait;						/* For sleeping */
+
+	bool lowlat;							/* Low latency gamepad mode */
+	ktime_t last_in;						/* Completion time of last input report */
+	unsigned long reports;						/* Input reports handled */
+	unsigned int handle_hist[USBHID_LAT_BUCKETS];			/* Report handling time, log2 us */
+	unsigned int interval_hist[USBHID_LAT_BUCKETS];			/* Report interval, log2 us */
 };
 
 #define	hid_to_usb_dev(hid_dev) \
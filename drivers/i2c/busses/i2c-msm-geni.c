@@ -135,6 +135,12 @@ struct geni_i2c_dev {
 	bool gpi_reset;
 	bool disable_dma_mode;
 	bool prev_cancel_pending; //Halt cancel till IOS in good state
+	int cur_mode; /* SE mode programmed in this FIFO/SE DMA transfer */
+	/* Completion latency of whole i2c_transfer() batches */
+	u64 xfers;
+	u64 xfer_msgs;
+	u64 xfer_lat_us;
+	u64 xfer_lat_max_us;
 };
 
 static struct geni_i2c_dev *gi2c_dev_dbg[MAX_SE];
@@ -176,6 +182,21 @@ static struct geni_i2c_clk_fld geni_i2c_clk_map[] = {
 	{KHz(1000), 1, 3,  9, 18},
 };
 
+static ssize_t xfer_stats_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct geni_i2c_dev *gi2c = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE,
+			 "%s xfers:%llu msgs:%llu avg_us:%llu max_us:%llu\n",
+			 gi2c->se_mode == GSI_ONLY ? "gsi" : "fifo",
+			 gi2c->xfers, gi2c->xfer_msgs,
+			 div64_u64(gi2c->xfer_lat_us, max_t(u64, gi2c->xfers, 1)),
+			 gi2c->xfer_lat_max_us);
+}
+
+static DEVICE_ATTR_RO(xfer_stats);
+
 static int geni_i2c_clk_map_idx(struct geni_i2c_dev *gi2c)
 {
 	int i;
@@ -1032,6 +1053,8 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 {
 	struct geni_i2c_dev *gi2c = i2c_get_adapdata(adap);
 	int i, ret = 0, timeout = 0;
+	ktime_t start = ktime_get();
+	u64 lat_us;
 
 	gi2c->err = 0;
 
@@ -1078,6 +1101,13 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 	} else {
 		/* Don't set shared flag in non-GSI mode */
 		gi2c->is_shared = false;
+		/*
+		 * The SE mode is programmed once per batch and only switched
+		 * again when a message needs the other mode, so a run of
+		 * small messages does not rewrite the mode registers each
+		 * time.
+		 */
+		gi2c->cur_mode = -1;
 	}
 
 	for (i = 0; i < num; i++) {
@@ -1106,11 +1136,15 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 					"Disable DMA mode\n");
 			mode = FIFO_MODE;
 		}
-		ret = geni_se_select_mode(gi2c->base, mode);
-		if (ret) {
-			dev_err(gi2c->dev, "%s: Error mode init %d:%d:%d\n",
-				__func__, mode, i, msgs[i].len);
-			break;
+		if (mode != gi2c->cur_mode) {
+			ret = geni_se_select_mode(gi2c->base, mode);
+			if (ret) {
+				dev_err(gi2c->dev,
+					"%s: Error mode init %d:%d:%d\n",
+					__func__, mode, i, msgs[i].len);
+				break;
+			}
+			gi2c->cur_mode = mode;
 		}
 
 		if (mode == SE_DMA) {
@@ -1138,6 +1172,7 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 					mode = FIFO_MODE;
 					ret = geni_se_select_mode(gi2c->base,
 								  mode);
+					gi2c->cur_mode = mode;
 				} else if (gi2c->dbg_buf_ptr) {
 					gi2c->dbg_buf_ptr[i].virt_buf =
 								(void *)dma_buf;
@@ -1162,6 +1197,7 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 					mode = FIFO_MODE;
 					ret = geni_se_select_mode(gi2c->base,
 								  mode);
+					gi2c->cur_mode = mode;
 				} else if (gi2c->dbg_buf_ptr) {
 					gi2c->dbg_buf_ptr[i].virt_buf =
 								(void *)dma_buf;
@@ -1240,6 +1276,12 @@ static int geni_i2c_xfer(struct i2c_adapter *adap,
 	if (ret == 0)
 		ret = num;
 
+	lat_us = ktime_us_delta(ktime_get(), start);
+	gi2c->xfers++;
+	gi2c->xfer_msgs += num;
+	gi2c->xfer_lat_us += lat_us;
+	gi2c->xfer_lat_max_us = max(gi2c->xfer_lat_max_us, lat_us);
+
 	if (!gi2c->is_le_vm) {
 		pm_runtime_mark_last_busy(gi2c->dev);
 		pm_runtime_put_autosuspend(gi2c->dev);
@@ -1443,6 +1485,9 @@ static int geni_i2c_probe(struct platform_device *pdev)
 		return ret;
 	}
 
+	if (device_create_file(gi2c->dev, &dev_attr_xfer_stats))
+		dev_warn(gi2c->dev, "Failed to create xfer_stats\n");
+
 	snprintf(boot_marker, sizeof(boot_marker),
 				"M - DRIVER GENI_I2C_%d Ready", gi2c->adap.nr);
 	place_marker(boot_marker);
@@ -1456,6 +1501,7 @@ static int geni_i2c_remove(struct platform_device *pdev)
 	struct geni_i2c_dev *gi2c = platform_get_drvdata(pdev);
 	int i;
 
+	device_remove_file(gi2c->dev, &dev_attr_xfer_stats);
 	pm_runtime_disable(gi2c->dev);
 	i2c_del_adapter(&gi2c->adap);
 
@@ -22,6 +22,7 @@
 
 #include <linux/types.h>
 #include <linux/notifier.h>
+#include <linux/ktime.h>
 /**********************************************************/
 enum FP_MODE {
 	GF_IMAGE_MODE = 0,
@@ -125,6 +126,17 @@ struct gf_ioc_chip_info {
 #define GF_NET_EVENT_FB_UNBLACK 3
 #define NETLINK_TEST 25
 
+/* unlock path stages timed from the finger down interrupt */
+enum gf_lat_stage {
+	GF_LAT_IRQ = 0,
+	GF_LAT_THREAD,
+	GF_LAT_NOTIFY,
+	GF_LAT_BOOST,
+	GF_LAT_IOCTL,
+	GF_LAT_UNBLANK,
+	GF_LAT_STAGES
+};
+
 struct gf_dev {
 	dev_t devt;
 	struct list_head device_entry;
@@ -152,6 +164,7 @@ struct gf_dev {
 	char device_available;
 	char fb_black;
 	struct regulator *vcc;
+	ktime_t lat_ts[GF_LAT_STAGES];
 };
 
 int gf_parse_dts(struct gf_dev *gf_dev);
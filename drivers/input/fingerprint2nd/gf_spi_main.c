@@ -45,6 +45,9 @@
 //#include <linux/fb.h>
 #include <linux/pm_qos.h>
 #include <linux/cpufreq.h>
+#include <linux/sched.h>
+#include <linux/ufs_boost.h>
+#include <drm/drm_anakin.h>
 //#include <linux/wakelock.h>
 #include "gf_spi.h"
 
@@ -84,6 +87,23 @@ static DEFINE_MUTEX(device_list_lock);
 //static struct wake_lock fp_wakelock;
 static struct gf_dev gf;
 
+/*
+ * Finger down starts an unlock: the HAL wakes up, the TEE matches and the
+ * panel is turned on. Get the CPUs, UFS and display going from the
+ * interrupt instead of waiting for userspace to ask. 0 disables each.
+ */
+static unsigned int boost_ms = 500;
+module_param(boost_ms, uint, 0644);
+MODULE_PARM_DESC(boost_ms, "sched boost held after a finger down irq, ms");
+
+static unsigned int ufs_boost_ms = 300;
+module_param(ufs_boost_ms, uint, 0644);
+MODULE_PARM_DESC(ufs_boost_ms, "UFS clock scaling hold after a finger down irq, ms");
+
+static unsigned int display_wake_ms = 500;
+module_param(display_wake_ms, uint, 0644);
+MODULE_PARM_DESC(display_wake_ms, "display power up hint after a finger down irq, ms");
+
 static struct gf_key_map maps[] = {
 	{ EV_KEY, GF_KEY_INPUT_HOME },
 	{ EV_KEY, GF_KEY_INPUT_MENU },
@@ -368,6 +388,9 @@ static long gf_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 	u8 netlink_route = NETLINK_TEST;
 	struct gf_ioc_chip_info info;
 
+	if (gf_dev->lat_ts[GF_LAT_IRQ] && !gf_dev->lat_ts[GF_LAT_IOCTL])
+		gf_dev->lat_ts[GF_LAT_IOCTL] = ktime_get();
+
 	if (_IOC_TYPE(cmd) != GF_IOC_MAGIC)
 		return -ENODEV;
 
@@ -498,19 +521,43 @@ static long gf_compat_ioctl(struct file *filp, unsigned int cmd, unsigned long a
 }
 #endif /*CONFIG_COMPAT*/
 
+static irqreturn_t gf_irq_primary(int irq, void *handle)
+{
+	struct gf_dev *gf_dev = handle;
+
+	memset(gf_dev->lat_ts, 0, sizeof(gf_dev->lat_ts));
+	gf_dev->lat_ts[GF_LAT_IRQ] = ktime_get();
+
+	return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t gf_irq(int irq, void *handle)
 {
+	struct gf_dev *gf_dev = handle;
 #if defined(GF_NETLINK_ENABLE)
 	char msg = GF_NET_EVENT_IRQ;
+#endif
+
+	gf_dev->lat_ts[GF_LAT_THREAD] = ktime_get();
+
+	/* both only queue work, get them going before the HAL wakes up */
+	if (display_wake_ms)
+		anakin_drm_notify_wake(display_wake_ms);
+	if (ufs_boost_ms)
+		ufshcd_boost_hint(ufs_boost_ms);
 
+#if defined(GF_NETLINK_ENABLE)
 	//wake_lock_timeout(&fp_wakelock, msecs_to_jiffies(WAKELOCK_HOLD_TIME));
 	sendnlmsg(&msg);
 #elif defined(GF_FASYNC)
-	struct gf_dev *gf_dev = &gf;
-
 	if (gf_dev->async)
 		kill_fasync(&gf_dev->async, SIGIO, POLL_IN);
 #endif
+	gf_dev->lat_ts[GF_LAT_NOTIFY] = ktime_get();
+
+	if (boost_ms)
+		sched_boost_timed(boost_ms);
+	gf_dev->lat_ts[GF_LAT_BOOST] = ktime_get();
 
 	return IRQ_HANDLED;
 }
@@ -630,6 +677,9 @@ static int goodix_fb_state_chg_callback(struct notifier_block *nb,
 			}
 			break;
 		case FB_BLANK_UNBLANK:
+			if (gf_dev->lat_ts[GF_LAT_IRQ] &&
+					!gf_dev->lat_ts[GF_LAT_UNBLANK])
+				gf_dev->lat_ts[GF_LAT_UNBLANK] = ktime_get();
 			if (gf_dev->device_available == 1) {
 				gf_dev->fb_black = 0;
 #if defined(GF_NETLINK_ENABLE)
@@ -653,6 +703,38 @@ static struct notifier_block goodix_noti_block = {
 	.notifier_call = goodix_fb_state_chg_callback,
 };
 
+static const char * const gf_lat_names[GF_LAT_STAGES] = {
+	[GF_LAT_THREAD]		= "thread",
+	[GF_LAT_NOTIFY]		= "notify",
+	[GF_LAT_BOOST]		= "boost",
+	[GF_LAT_IOCTL]		= "hal",
+	[GF_LAT_UNBLANK]	= "unblank",
+};
+
+/* microseconds from the last finger down irq to each stage, -1 if not reached */
+static ssize_t unlock_latency_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct gf_dev *gf_dev = dev_get_drvdata(dev);
+	ktime_t irq = gf_dev->lat_ts[GF_LAT_IRQ];
+	ssize_t count = 0;
+	int i;
+
+	for (i = GF_LAT_THREAD; i < GF_LAT_STAGES; i++)
+		count += scnprintf(buf + count, PAGE_SIZE - count, "%s: %lld\n",
+				gf_lat_names[i], gf_dev->lat_ts[i] && irq ?
+				ktime_us_delta(gf_dev->lat_ts[i], irq) : -1LL);
+
+	return count;
+}
+static DEVICE_ATTR_RO(unlock_latency);
+
+static struct attribute *gf_attrs[] = {
+	&dev_attr_unlock_latency.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(gf);
+
 static struct class *gf_class;
 #if defined(USE_SPI_BUS)
 static int gf_probe(struct spi_device *spi)
@@ -691,8 +773,8 @@ static int gf_probe(struct platform_device *pdev)
 		struct device *dev;
 
 		gf_dev->devt = MKDEV(SPIDEV_MAJOR, minor);
-		dev = device_create(gf_class, &gf_dev->spi->dev, gf_dev->devt,
-				gf_dev, GF_DEV_NAME);
+		dev = device_create_with_groups(gf_class, &gf_dev->spi->dev,
+				gf_dev->devt, gf_dev, gf_groups, GF_DEV_NAME);
 		status = IS_ERR(dev) ? PTR_ERR(dev) : 0;
 	} else {
 		dev_dbg(&gf_dev->spi->dev, "no minor number available!\n");
@@ -753,7 +835,7 @@ static int gf_probe(struct platform_device *pdev)
 	gf_dev->irq = gf_irq_num(gf_dev);
 
 	//wake_lock_init(&fp_wakelock, WAKE_LOCK_SUSPEND, "fp_wakelock");
-	status = request_threaded_irq(gf_dev->irq, NULL, gf_irq,
+	status = request_threaded_irq(gf_dev->irq, gf_irq_primary, gf_irq,
 			IRQF_TRIGGER_RISING | IRQF_ONESHOT,
 			"gf", gf_dev);
 
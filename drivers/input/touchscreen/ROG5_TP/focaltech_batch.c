@@ -0,0 +1,377 @@
+/*
+ *
+ * FocalTech TouchScreen driver.
+ *
+ * Copyright (c) 2012-2020, FocalTech Systems, Ltd., all rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*****************************************************************************
+*
+* File Name: focaltech_batch.c
+*
+* Abstract: vsync aligned touch report batching
+*
+* At 360/720Hz sampling every interrupt used to wake InputReader several
+* times per display frame. With fts_vsync_batch set, parsed samples are
+* queued instead, and delivered back to back, each with its own input_sync
+* and IRQ timestamp, fts_vsync_batch_lead_us before the next vsync
+* predicted from the display vblank. InputReader then consumes a frame
+* worth of samples as one event plus history. Without a recent vsync, e.g.
+* while the panel is idle, samples are delivered right away, and writing
+* 0 restores the raw rate path for games that want it.
+*
+*****************************************************************************/
+
+/*****************************************************************************
+* Included header files
+*****************************************************************************/
+#include <linux/hrtimer.h>
+#include <drm/drm_anakin.h>
+#include "focaltech_core.h"
+
+#if FTS_VSYNC_BATCH_EN
+/*****************************************************************************
+* Private constant and macro definitions using #define
+*****************************************************************************/
+#define FTS_BATCH_SAMPLES                   16
+#define FTS_BATCH_LEAD_US                   1500
+#define FTS_BATCH_MIN_PERIOD_NS             (4 * NSEC_PER_MSEC)
+#define FTS_BATCH_MAX_PERIOD_NS             (50 * NSEC_PER_MSEC)
+
+/*****************************************************************************
+* Private enumerations, structures and unions using typedef
+*****************************************************************************/
+struct fts_batch_sample {
+    struct ts_event events[FTS_MAX_POINTS_SUPPORT];
+    int touch_point;
+    int point_num;
+    ktime_t time;
+};
+
+struct fts_batch_st {
+    bool enable;
+    int lead_us;
+    struct fts_ts_data *ts_data;
+    struct mutex lock;      /* parse and queue vs delivery, then report_mutex */
+    struct fts_batch_sample samples[FTS_BATCH_SAMPLES];
+    int count;
+    ktime_t last_vsync;
+    s64 period_ns;
+    struct hrtimer timer;
+    struct work_struct work;
+    struct notifier_block vsync_nb;
+    u64 queued;
+    u64 flushes;
+};
+
+/*****************************************************************************
+* Static variables
+*****************************************************************************/
+static struct fts_batch_st fts_batch_data;
+
+/*****************************************************************************
+* functions body
+*****************************************************************************/
+static int fts_batch_vsync(struct notifier_block *nb, unsigned long event,
+                           void *data)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    ktime_t ts = *(ktime_t *)data;
+    s64 period = ktime_to_ns(ktime_sub(ts, batch->last_vsync));
+
+    if (period >= FTS_BATCH_MIN_PERIOD_NS && period <= FTS_BATCH_MAX_PERIOD_NS)
+        WRITE_ONCE(batch->period_ns, period);
+    WRITE_ONCE(batch->last_vsync, ts);
+
+    return NOTIFY_OK;
+}
+
+/*
+ * Delivery time for a sample queued at @now: the lead time before the
+ * next predicted vsync, or 0 to deliver right away when that point has
+ * already passed or the display is not producing vsyncs.
+ */
+static ktime_t fts_batch_deadline(struct fts_batch_st *batch, ktime_t now)
+{
+    s64 period = READ_ONCE(batch->period_ns);
+    s64 since = ktime_to_ns(ktime_sub(now, READ_ONCE(batch->last_vsync)));
+    s64 next;
+
+    if (!period || since < 0 || since > FTS_BATCH_MAX_PERIOD_NS)
+        return 0;
+
+    next = (div64_s64(since, period) + 1) * period;
+    if (next - since <= (s64)batch->lead_us * NSEC_PER_USEC)
+        return 0;
+
+    return ktime_add_ns(now, next - since - (s64)batch->lead_us * NSEC_PER_USEC);
+}
+
+/* Call with batch->lock held */
+static void fts_batch_flush(struct fts_batch_st *batch)
+{
+    struct fts_ts_data *ts_data = batch->ts_data;
+    struct fts_batch_sample *s;
+    int i;
+
+    if (!batch->count)
+        return;
+
+    mutex_lock(&ts_data->report_mutex);
+    for (i = 0; i < batch->count; i++) {
+        s = &batch->samples[i];
+        memcpy(ts_data->events, s->events,
+               sizeof(s->events[0]) * s->touch_point);
+        ts_data->touch_point = s->touch_point;
+        ts_data->point_num = s->point_num;
+        input_set_timestamp(ts_data->input_dev, s->time);
+        fts_input_report(ts_data);
+    }
+    mutex_unlock(&ts_data->report_mutex);
+
+    batch->count = 0;
+    batch->flushes++;
+
+#if FTS_LOW_LATENCY_EN
+    fts_latency_report(ts_data);
+#endif
+}
+
+static enum hrtimer_restart fts_batch_timer_fn(struct hrtimer *timer)
+{
+    queue_work(system_highpri_wq, &fts_batch_data.work);
+    return HRTIMER_NORESTART;
+}
+
+static void fts_batch_work_fn(struct work_struct *work)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+
+    mutex_lock(&batch->lock);
+    fts_batch_flush(batch);
+    mutex_unlock(&batch->lock);
+}
+
+/*****************************************************************************
+*  Name: fts_batch_begin
+*  Brief: called by the IRQ thread before parsing touch data. When batching
+*         is on, takes the batch lock and returns true, the caller then
+*         parses and calls fts_batch_end() instead of reporting
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+bool fts_batch_begin(struct fts_ts_data *ts_data)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+
+    if (!READ_ONCE(batch->enable))
+        return false;
+
+    mutex_lock(&batch->lock);
+    if (!batch->enable) {
+        mutex_unlock(&batch->lock);
+        return false;
+    }
+
+    return true;
+}
+
+/*****************************************************************************
+*  Name: fts_batch_end
+*  Brief: queue the parsed touch data if @valid, then drop the batch lock
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+void fts_batch_end(struct fts_ts_data *ts_data, bool valid)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    struct fts_batch_sample *s;
+    ktime_t deadline;
+
+    if (!valid)
+        goto out;
+
+    s = &batch->samples[batch->count++];
+    memcpy(s->events, ts_data->events,
+           sizeof(s->events[0]) * ts_data->touch_point);
+    s->touch_point = ts_data->touch_point;
+    s->point_num = ts_data->point_num;
+    s->time = ts_data->irq_hard_time;
+    batch->queued++;
+
+    deadline = fts_batch_deadline(batch, ktime_get());
+    if (!deadline || batch->count == FTS_BATCH_SAMPLES) {
+        hrtimer_try_to_cancel(&batch->timer);
+        fts_batch_flush(batch);
+    } else if (batch->count == 1) {
+        hrtimer_start(&batch->timer, deadline, HRTIMER_MODE_ABS);
+    }
+
+out:
+    mutex_unlock(&batch->lock);
+}
+
+static ssize_t fts_vsync_batch_show(struct device *dev,
+                                    struct device_attribute *attr, char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, "%d\n", fts_batch_data.enable);
+}
+
+static ssize_t fts_vsync_batch_store(struct device *dev,
+                                     struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    bool enable;
+
+    if (kstrtobool(buf, &enable))
+        return -EINVAL;
+
+    mutex_lock(&batch->lock);
+    batch->enable = enable;
+    if (!enable) {
+        hrtimer_cancel(&batch->timer);
+        fts_batch_flush(batch);
+    }
+    mutex_unlock(&batch->lock);
+    FTS_INFO("vsync batching %s", enable ? "on" : "off");
+
+    return count;
+}
+
+static ssize_t fts_vsync_batch_lead_show(struct device *dev,
+                                         struct device_attribute *attr, char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, "%d\n", fts_batch_data.lead_us);
+}
+
+static ssize_t fts_vsync_batch_lead_store(struct device *dev,
+                                          struct device_attribute *attr,
+                                          const char *buf, size_t count)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    int lead_us;
+
+    if (kstrtoint(buf, 0, &lead_us) || lead_us < 0 ||
+        lead_us > FTS_BATCH_MAX_PERIOD_NS / NSEC_PER_USEC)
+        return -EINVAL;
+
+    mutex_lock(&batch->lock);
+    batch->lead_us = lead_us;
+    mutex_unlock(&batch->lock);
+
+    return count;
+}
+
+static ssize_t fts_vsync_batch_stats_show(struct device *dev,
+                                          struct device_attribute *attr, char *buf)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    u64 queued, flushes;
+
+    mutex_lock(&batch->lock);
+    queued = batch->queued;
+    flushes = batch->flushes;
+    mutex_unlock(&batch->lock);
+
+    return snprintf(buf, PAGE_SIZE, "samples:%llu deliveries:%llu vsync_period_us:%lld\n",
+                    queued, flushes,
+                    div_s64(READ_ONCE(batch->period_ns), NSEC_PER_USEC));
+}
+
+static DEVICE_ATTR(fts_vsync_batch, S_IRUGO | S_IWUSR, fts_vsync_batch_show, fts_vsync_batch_store);
+static DEVICE_ATTR(fts_vsync_batch_lead_us, S_IRUGO | S_IWUSR, fts_vsync_batch_lead_show, fts_vsync_batch_lead_store);
+static DEVICE_ATTR(fts_vsync_batch_stats, S_IRUGO, fts_vsync_batch_stats_show, NULL);
+
+static struct attribute *fts_batch_attributes[] = {
+    &dev_attr_fts_vsync_batch.attr,
+    &dev_attr_fts_vsync_batch_lead_us.attr,
+    &dev_attr_fts_vsync_batch_stats.attr,
+    NULL
+};
+
+static struct attribute_group fts_batch_attribute_group = {
+    .attrs = fts_batch_attributes
+};
+
+/*****************************************************************************
+*  Name: fts_batch_init
+*  Brief:
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+int fts_batch_init(struct fts_ts_data *ts_data)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+    int ret = 0;
+
+    FTS_FUNC_ENTER();
+    memset(batch, 0, sizeof(*batch));
+    batch->ts_data = ts_data;
+    batch->lead_us = FTS_BATCH_LEAD_US;
+    mutex_init(&batch->lock);
+    hrtimer_init(&batch->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+    batch->timer.function = fts_batch_timer_fn;
+    INIT_WORK(&batch->work, fts_batch_work_fn);
+
+    batch->vsync_nb.notifier_call = fts_batch_vsync;
+    ret = anakin_drm_register_vsync_notifier(&batch->vsync_nb);
+    if (ret) {
+        FTS_ERROR("[BATCH]: no vsync source, ret=%d", ret);
+        batch->ts_data = NULL;
+        return ret;
+    }
+
+    ret = sysfs_create_group(&ts_data->dev->kobj, &fts_batch_attribute_group);
+    if (ret) {
+        FTS_ERROR("[BATCH]: sysfs_create_group() failed!!");
+        anakin_drm_unregister_vsync_notifier(&batch->vsync_nb);
+        batch->ts_data = NULL;
+        return ret;
+    }
+
+    FTS_FUNC_EXIT();
+    return 0;
+}
+
+/*****************************************************************************
+*  Name: fts_batch_exit
+*  Brief: call it after the IRQ was freed
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+int fts_batch_exit(struct fts_ts_data *ts_data)
+{
+    struct fts_batch_st *batch = &fts_batch_data;
+
+    FTS_FUNC_ENTER();
+    if (!batch->ts_data)
+        return 0;
+
+    sysfs_remove_group(&ts_data->dev->kobj, &fts_batch_attribute_group);
+    anakin_drm_unregister_vsync_notifier(&batch->vsync_nb);
+
+    mutex_lock(&batch->lock);
+    batch->enable = false;
+    batch->count = 0;
+    mutex_unlock(&batch->lock);
+    hrtimer_cancel(&batch->timer);
+    cancel_work_sync(&batch->work);
+    FTS_FUNC_EXIT();
+    return 0;
+}
+#endif /* FTS_VSYNC_BATCH_EN */
@@ -196,6 +196,18 @@
  */
 #define FTS_ESDCHECK_EN                         0
 
+/*
+ * Low latency touch report mode and report latency histogram
+ * default: enable
+ */
+#define FTS_LOW_LATENCY_EN                      1
+
+/*
+ * Vsync aligned touch report batching, off until enabled in sysfs
+ * default: enable
+ */
+#define FTS_VSYNC_BATCH_EN                      1
+
 /*
  * Production test enable
  * 1: enable, 0:disable(default)
@@ -735,6 +735,16 @@ static int fts_input_report_a(struct fts_ts_data *data)
 }
 #endif
 
+/* Report the parsed touch data, call with report_mutex held */
+int fts_input_report(struct fts_ts_data *data)
+{
+#if FTS_MT_PROTOCOL_B_EN
+    return fts_input_report_b(data);
+#else
+    return fts_input_report_a(data);
+#endif
+}
+
 static int fts_read_touchdata(struct fts_ts_data *data)
 {
     int ret = 0;
@@ -869,22 +879,40 @@ static void fts_irq_read_report(void)
     fts_prc_queue_work(ts_data);
 #endif
 
+#if FTS_VSYNC_BATCH_EN
+    if (fts_batch_begin(ts_data)) {
+        ret = fts_read_parse_touchdata(ts_data);
+        fts_batch_end(ts_data, ret == 0);
+        goto out;
+    }
+#endif
+
     ret = fts_read_parse_touchdata(ts_data);
     if (ret == 0) {
         mutex_lock(&ts_data->report_mutex);
-#if FTS_MT_PROTOCOL_B_EN
-        fts_input_report_b(ts_data);
-#else
-        fts_input_report_a(ts_data);
-#endif
+        fts_input_report(ts_data);
         mutex_unlock(&ts_data->report_mutex);
+#if FTS_LOW_LATENCY_EN
+        fts_latency_report(ts_data);
+#endif
     }
 
+#if FTS_VSYNC_BATCH_EN
+out:
+#endif
 #if FTS_ESDCHECK_EN
     fts_esdcheck_set_intr(0);
 #endif
 }
 
+static irqreturn_t fts_irq_hard_handler(int irq, void *data)
+{
+    struct fts_ts_data *ts_data = data;
+
+    ts_data->irq_hard_time = ktime_get();
+    return IRQ_WAKE_THREAD;
+}
+
 static irqreturn_t fts_irq_handler(int irq, void *data)
 {
 #if defined(CONFIG_PM) && FTS_PATCH_COMERR_PM
@@ -902,6 +930,10 @@ static irqreturn_t fts_irq_handler(int irq, void *data)
     }
 #endif
 
+#if FTS_LOW_LATENCY_EN
+    fts_latency_irq(fts_data);
+#endif
+
     if ((fts_data->perftime == 1) || (fts_data->realtime == 1) ) {
 	fts_data->irq_received = ktime_get();
 //	FTS_INFO("irq time %llu",fts_data->irq_received);
@@ -919,7 +951,8 @@ static int fts_irq_registration(struct fts_ts_data *ts_data)
     ts_data->irq = gpio_to_irq(pdata->irq_gpio);
     pdata->irq_gpio_flags = IRQF_TRIGGER_FALLING | IRQF_ONESHOT;
     FTS_INFO("irq:%d, flag:%x", ts_data->irq, pdata->irq_gpio_flags);
-    ret = request_threaded_irq(ts_data->irq, NULL, fts_irq_handler,
+    ret = request_threaded_irq(ts_data->irq, fts_irq_hard_handler,
+                               fts_irq_handler,
                                pdata->irq_gpio_flags,
                                FTS_DRIVER_NAME, ts_data);
 
@@ -1837,6 +1870,20 @@ static int fts_ts_probe_entry(struct fts_ts_data *ts_data)
         FTS_ERROR("request irq failed");
         goto err_irq_req;
     }
+
+#if FTS_LOW_LATENCY_EN
+    ret = fts_latency_init(ts_data);
+    if (ret) {
+        FTS_ERROR("init low latency mode fail");
+    }
+#endif
+
+#if FTS_VSYNC_BATCH_EN
+    ret = fts_batch_init(ts_data);
+    if (ret) {
+        FTS_ERROR("init vsync batching fail");
+    }
+#endif
     
     if (!tp3518u) {
 	ret = fts_fwupg_init(ts_data);
@@ -1946,6 +1993,12 @@ static int fts_ts_remove_entry(struct fts_ts_data *ts_data)
     fts_bus_exit(ts_data);
 
     free_irq(ts_data->irq, ts_data);
+#if FTS_VSYNC_BATCH_EN
+    fts_batch_exit(ts_data);
+#endif
+#if FTS_LOW_LATENCY_EN
+    fts_latency_exit(ts_data);
+#endif
     input_unregister_device(ts_data->input_dev);
 
     if (ts_data->ts_workqueue)
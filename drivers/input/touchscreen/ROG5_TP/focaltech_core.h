@@ -212,6 +212,7 @@ struct fts_ts_data {
     int init_success;
     struct mutex reg_lock;
     ktime_t irq_received;
+    ktime_t irq_hard_time;  /* hard IRQ time of the report being handled */
     int perftime;
     struct workqueue_struct *init_workqueue;
     struct work_struct init_work;
@@ -306,6 +307,22 @@ int fts_point_report_check_exit(struct fts_ts_data *ts_data);
 void fts_prc_queue_work(struct fts_ts_data *ts_data);
 #endif
 
+/* Low latency mode */
+#if FTS_LOW_LATENCY_EN
+int fts_latency_init(struct fts_ts_data *ts_data);
+int fts_latency_exit(struct fts_ts_data *ts_data);
+void fts_latency_irq(struct fts_ts_data *ts_data);
+void fts_latency_report(struct fts_ts_data *ts_data);
+#endif
+
+/* Vsync batching */
+#if FTS_VSYNC_BATCH_EN
+int fts_batch_init(struct fts_ts_data *ts_data);
+int fts_batch_exit(struct fts_ts_data *ts_data);
+bool fts_batch_begin(struct fts_ts_data *ts_data);
+void fts_batch_end(struct fts_ts_data *ts_data, bool valid);
+#endif
+
 /* FW upgrade */
 int fts_fwupg_init(struct fts_ts_data *ts_data);
 int fts_fwupg_exit(struct fts_ts_data *ts_data);
@@ -316,6 +333,7 @@ int fts_enter_test_environment(bool test_state);
 int fts_reset_proc(int hdelayms);
 int fts_wait_tp_to_valid(void);
 void fts_release_all_finger(void);
+int fts_input_report(struct fts_ts_data *data);
 void fts_tp_state_recovery(struct fts_ts_data *ts_data);
 int fts_ex_mode_init(struct fts_ts_data *ts_data);
 int fts_ex_mode_exit(struct fts_ts_data *ts_data);
@@ -0,0 +1,389 @@
+/*
+ *
+ * FocalTech TouchScreen driver.
+ *
+ * Copyright (c) 2012-2020, FocalTech Systems, Ltd., all rights reserved.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*****************************************************************************
+*
+* File Name: focaltech_latency.c
+*
+* Abstract: low latency touch report mode and IRQ to input_sync latency
+*           histogram
+*
+* In low latency mode the IRQ thread runs at a raised SCHED_FIFO priority,
+* the touch IRQ is pinned to the fastest unisolated CPU (or the one set in
+* fts_latency_cpu), and a CPU latency PM QoS request is held while any
+* finger is down, so the bus read is not delayed by deep idle exit.
+*
+* The histogram is always collected, log2 buckets in us from the hard IRQ
+* to the input_sync of the report. Writing fts_latency_hist clears it.
+*
+*****************************************************************************/
+
+/*****************************************************************************
+* Included header files
+*****************************************************************************/
+#include <linux/cpufreq.h>
+#include <linux/cpumask.h>
+#include <linux/log2.h>
+#include <linux/pm_qos.h>
+#include <uapi/linux/sched/types.h>
+#include "focaltech_core.h"
+
+#if FTS_LOW_LATENCY_EN
+/*****************************************************************************
+* Private constant and macro definitions using #define
+*****************************************************************************/
+#define FTS_LATENCY_BUCKETS                 16
+#define FTS_LATENCY_RT_PRIO                 (MAX_USER_RT_PRIO - 2)
+#define FTS_LATENCY_DEFAULT_PRIO            (MAX_USER_RT_PRIO / 2)
+#define FTS_LATENCY_QOS_US                  44
+
+/*****************************************************************************
+* Private enumerations, structures and unions using typedef
+*****************************************************************************/
+struct fts_latency_st {
+    bool enable;
+    bool sched_dirty;
+    bool qos_active;
+    int cpu;                /* -1: pick the fastest unisolated CPU */
+    int irq_cpu;            /* CPU the IRQ is currently pinned to */
+    int qos_us;
+    struct pm_qos_request qos_req;
+    struct mutex lock;
+    spinlock_t hist_lock;
+    u64 count;
+    u64 sum_us;
+    u64 max_us;
+    u64 buckets[FTS_LATENCY_BUCKETS];
+};
+
+/*****************************************************************************
+* Static variables
+*****************************************************************************/
+static struct fts_latency_st fts_latency_data;
+
+/*****************************************************************************
+* functions body
+*****************************************************************************/
+static int fts_latency_pick_cpu(void)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    unsigned int freq, best_freq = 0;
+    int cpu, best = -1;
+
+    if (lat->cpu >= 0) {
+        if (cpu_online(lat->cpu) && !cpu_isolated(lat->cpu))
+            return lat->cpu;
+        return -1;
+    }
+
+    for_each_online_cpu(cpu) {
+        if (cpu_isolated(cpu))
+            continue;
+        freq = cpufreq_quick_get_max(cpu);
+        if (best < 0 || freq >= best_freq) {
+            best = cpu;
+            best_freq = freq;
+        }
+    }
+
+    return best;
+}
+
+/* Pin the IRQ, the IRQ thread follows it on its next wakeup */
+static void fts_latency_set_affinity(struct fts_ts_data *ts_data)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    int cpu = lat->enable ? fts_latency_pick_cpu() : -1;
+
+    if (cpu == lat->irq_cpu)
+        return;
+
+    if (cpu < 0)
+        irq_set_affinity(ts_data->irq, cpu_online_mask);
+    else
+        irq_set_affinity(ts_data->irq, cpumask_of(cpu));
+    lat->irq_cpu = cpu;
+}
+
+/*****************************************************************************
+*  Name: fts_latency_irq
+*  Brief: called first in the IRQ thread, applies pending scheduling changes
+*         to the thread itself
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+void fts_latency_irq(struct fts_ts_data *ts_data)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    struct sched_param param;
+
+    if (likely(!READ_ONCE(lat->sched_dirty)))
+        return;
+
+    mutex_lock(&lat->lock);
+    param.sched_priority = lat->enable ? FTS_LATENCY_RT_PRIO :
+                           FTS_LATENCY_DEFAULT_PRIO;
+    sched_setscheduler_nocheck(current, SCHED_FIFO, &param);
+    lat->sched_dirty = false;
+    mutex_unlock(&lat->lock);
+}
+
+/*****************************************************************************
+*  Name: fts_latency_report
+*  Brief: called after the report was synced, accounts the IRQ to input_sync
+*         latency and holds the PM QoS request while fingers are down
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+void fts_latency_report(struct fts_ts_data *ts_data)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    u64 us = ktime_us_delta(ktime_get(), ts_data->irq_hard_time);
+    unsigned long flags;
+    bool down;
+    int idx;
+
+    idx = us ? min_t(int, ilog2(us) + 1, FTS_LATENCY_BUCKETS - 1) : 0;
+
+    spin_lock_irqsave(&lat->hist_lock, flags);
+    lat->count++;
+    lat->sum_us += us;
+    lat->max_us = max(lat->max_us, us);
+    lat->buckets[idx]++;
+    spin_unlock_irqrestore(&lat->hist_lock, flags);
+
+    if (!READ_ONCE(lat->enable) && !lat->qos_active)
+        return;
+
+    down = !!ts_data->touchs;
+    if (down == lat->qos_active)
+        return;
+
+    mutex_lock(&lat->lock);
+    if (down && lat->enable) {
+        pm_qos_update_request(&lat->qos_req, lat->qos_us);
+        /* The picked CPU may have been isolated since */
+        fts_latency_set_affinity(ts_data);
+        lat->qos_active = true;
+    } else if (!down) {
+        pm_qos_update_request(&lat->qos_req, PM_QOS_DEFAULT_VALUE);
+        lat->qos_active = false;
+    }
+    mutex_unlock(&lat->lock);
+}
+
+static ssize_t fts_low_latency_show(struct device *dev,
+                                    struct device_attribute *attr, char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, "%d\n", fts_latency_data.enable);
+}
+
+static ssize_t fts_low_latency_store(struct device *dev,
+                                     struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    bool enable;
+
+    if (kstrtobool(buf, &enable))
+        return -EINVAL;
+
+    mutex_lock(&lat->lock);
+    if (enable != lat->enable) {
+        lat->enable = enable;
+        WRITE_ONCE(lat->sched_dirty, true);
+        fts_latency_set_affinity(fts_data);
+        if (!enable && lat->qos_active) {
+            pm_qos_update_request(&lat->qos_req, PM_QOS_DEFAULT_VALUE);
+            lat->qos_active = false;
+        }
+        FTS_INFO("low latency mode %s", enable ? "on" : "off");
+    }
+    mutex_unlock(&lat->lock);
+
+    return count;
+}
+
+static ssize_t fts_latency_cpu_show(struct device *dev,
+                                    struct device_attribute *attr, char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, "%d (irq on %d)\n",
+                    fts_latency_data.cpu, fts_latency_data.irq_cpu);
+}
+
+static ssize_t fts_latency_cpu_store(struct device *dev,
+                                     struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    int cpu;
+
+    if (kstrtoint(buf, 0, &cpu) || cpu < -1 || cpu >= nr_cpu_ids)
+        return -EINVAL;
+
+    mutex_lock(&lat->lock);
+    lat->cpu = cpu;
+    fts_latency_set_affinity(fts_data);
+    mutex_unlock(&lat->lock);
+
+    return count;
+}
+
+static ssize_t fts_latency_qos_show(struct device *dev,
+                                    struct device_attribute *attr, char *buf)
+{
+    return snprintf(buf, PAGE_SIZE, "%d\n", fts_latency_data.qos_us);
+}
+
+static ssize_t fts_latency_qos_store(struct device *dev,
+                                     struct device_attribute *attr,
+                                     const char *buf, size_t count)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    int qos_us;
+
+    if (kstrtoint(buf, 0, &qos_us) || qos_us < 0)
+        return -EINVAL;
+
+    mutex_lock(&lat->lock);
+    lat->qos_us = qos_us;
+    if (lat->qos_active)
+        pm_qos_update_request(&lat->qos_req, qos_us);
+    mutex_unlock(&lat->lock);
+
+    return count;
+}
+
+static ssize_t fts_latency_hist_show(struct device *dev,
+                                     struct device_attribute *attr, char *buf)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    u64 buckets[FTS_LATENCY_BUCKETS];
+    u64 count, sum_us, max_us;
+    ssize_t len;
+    int i;
+
+    spin_lock_irq(&lat->hist_lock);
+    memcpy(buckets, lat->buckets, sizeof(buckets));
+    count = lat->count;
+    sum_us = lat->sum_us;
+    max_us = lat->max_us;
+    spin_unlock_irq(&lat->hist_lock);
+
+    len = snprintf(buf, PAGE_SIZE, "reports:%llu avg_us:%llu max_us:%llu\n",
+                   count, count ? div64_u64(sum_us, count) : 0, max_us);
+    for (i = 0; i < FTS_LATENCY_BUCKETS; i++) {
+        if (!buckets[i])
+            continue;
+        if (i == FTS_LATENCY_BUCKETS - 1)
+            len += snprintf(buf + len, PAGE_SIZE - len, ">= %8lu us: %llu\n",
+                            1UL << (i - 1), buckets[i]);
+        else
+            len += snprintf(buf + len, PAGE_SIZE - len, "<  %8lu us: %llu\n",
+                            1UL << i, buckets[i]);
+    }
+
+    return len;
+}
+
+static ssize_t fts_latency_hist_store(struct device *dev,
+                                      struct device_attribute *attr,
+                                      const char *buf, size_t count)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+
+    spin_lock_irq(&lat->hist_lock);
+    lat->count = 0;
+    lat->sum_us = 0;
+    lat->max_us = 0;
+    memset(lat->buckets, 0, sizeof(lat->buckets));
+    spin_unlock_irq(&lat->hist_lock);
+
+    return count;
+}
+
+static DEVICE_ATTR(fts_low_latency, S_IRUGO | S_IWUSR, fts_low_latency_show, fts_low_latency_store);
+static DEVICE_ATTR(fts_latency_cpu, S_IRUGO | S_IWUSR, fts_latency_cpu_show, fts_latency_cpu_store);
+static DEVICE_ATTR(fts_latency_qos_us, S_IRUGO | S_IWUSR, fts_latency_qos_show, fts_latency_qos_store);
+static DEVICE_ATTR(fts_latency_hist, S_IRUGO | S_IWUSR, fts_latency_hist_show, fts_latency_hist_store);
+
+static struct attribute *fts_latency_attributes[] = {
+    &dev_attr_fts_low_latency.attr,
+    &dev_attr_fts_latency_cpu.attr,
+    &dev_attr_fts_latency_qos_us.attr,
+    &dev_attr_fts_latency_hist.attr,
+    NULL
+};
+
+static struct attribute_group fts_latency_attribute_group = {
+    .attrs = fts_latency_attributes
+};
+
+/*****************************************************************************
+*  Name: fts_latency_init
+*  Brief: call it after the IRQ was requested
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+int fts_latency_init(struct fts_ts_data *ts_data)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+    int ret = 0;
+
+    FTS_FUNC_ENTER();
+    memset(lat, 0, sizeof(*lat));
+    mutex_init(&lat->lock);
+    spin_lock_init(&lat->hist_lock);
+    lat->cpu = -1;
+    lat->irq_cpu = -1;
+    lat->qos_us = FTS_LATENCY_QOS_US;
+    pm_qos_add_request(&lat->qos_req, PM_QOS_CPU_DMA_LATENCY,
+                       PM_QOS_DEFAULT_VALUE);
+
+    ret = sysfs_create_group(&ts_data->dev->kobj, &fts_latency_attribute_group);
+    if (ret) {
+        FTS_ERROR("[LATENCY]: sysfs_create_group() failed!!");
+        pm_qos_remove_request(&lat->qos_req);
+        return ret;
+    }
+
+    FTS_FUNC_EXIT();
+    return 0;
+}
+
+/*****************************************************************************
+*  Name: fts_latency_exit
+*  Brief:
+*  Input:
+*  Output:
+*  Return:
+*****************************************************************************/
+int fts_latency_exit(struct fts_ts_data *ts_data)
+{
+    struct fts_latency_st *lat = &fts_latency_data;
+
+    FTS_FUNC_ENTER();
+    sysfs_remove_group(&ts_data->dev->kobj, &fts_latency_attribute_group);
+    if (pm_qos_request_active(&lat->qos_req))
+        pm_qos_remove_request(&lat->qos_req);
+    FTS_FUNC_EXIT();
+    return 0;
+}
+#endif /* FTS_LOW_LATENCY_EN */
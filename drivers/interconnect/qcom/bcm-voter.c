@@ -3,12 +3,16 @@
  * Copyright (c) 2019-2020, The Linux Foundation. All rights reserved.
  *
  */
+#include <linux/debugfs.h>
 #include <linux/interconnect-provider.h>
 #include <linux/list_sort.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_platform.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 
 #include <soc/qcom/rpmh.h>
 #include <soc/qcom/tcs.h>
@@ -16,7 +20,10 @@
 #include "bcm-voter.h"
 #include "icc-rpmh.h"
 
+#define BCM_VOTER_DEFAULT_HYST_MS	10
+
 static LIST_HEAD(bcm_voters);
+static struct dentry *bcm_voter_debugfs_dir;
 
 /**
  * struct bcm_voter - Bus Clock Manager voter
@@ -26,8 +33,14 @@ static LIST_HEAD(bcm_voters);
  * @commit_list: list containing bcms to be committed to hardware
  * @ws_list: list containing bcms that have different wake/sleep votes
  * @voter_node: list of bcm voters
+ * @bcm_list: list of every bcm voted through this voter, for statistics
+ * @hyst_work: commits vote decreases once @hyst_ms has elapsed
+ * @hyst_ms: time vote decreases are held back to combine them with others
  * @tcs_wait: mask for which buckets require TCS completion
  * @init: flag to determine when init has completed.
+ * @commits: number of AMC requests sent to RPMh
+ * @deferred: number of commits folded into a later request
+ * @start: time at which statistics collection started
  */
 struct bcm_voter {
 	struct device *dev;
@@ -36,8 +49,14 @@ struct bcm_voter {
 	struct list_head commit_list;
 	struct list_head ws_list;
 	struct list_head voter_node;
+	struct list_head bcm_list;
+	struct delayed_work hyst_work;
+	u32 hyst_ms;
 	u32 tcs_wait;
 	bool init;
+	u64 commits;
+	u64 deferred;
+	ktime_t start;
 };
 
 static int cmp_vcd(void *priv, struct list_head *a, struct list_head *b)
@@ -245,23 +264,14 @@ void qcom_icc_bcm_voter_add(struct bcm_voter *voter, struct qcom_icc_bcm *bcm)
 	if (list_empty(&bcm->ws_list))
 		list_add_tail(&bcm->ws_list, &voter->ws_list);
 
+	if (list_empty(&bcm->stats_list))
+		list_add_tail(&bcm->stats_list, &voter->bcm_list);
+
 	mutex_unlock(&voter->lock);
 }
 EXPORT_SYMBOL(qcom_icc_bcm_voter_add);
 
-/**
- * qcom_icc_bcm_voter_commit - generates and commits tcs cmds based on bcms
- * @voter: voter that needs flushing
- *
- * This function generates a set of AMC commands and flushes to the BCM device
- * associated with the voter. It conditionally generate WAKE and SLEEP commands
- * based on deltas between WAKE/SLEEP requirements. The ws_list persists
- * through multiple commit requests and bcm nodes are removed only when the
- * requirements for WAKE matches SLEEP.
- *
- * Returns 0 on success, or an appropriate error code otherwise.
- */
-int qcom_icc_bcm_voter_commit(struct bcm_voter *voter)
+static int __bcm_voter_commit(struct bcm_voter *voter)
 {
 	struct qcom_icc_bcm *bcm;
 	struct qcom_icc_bcm *bcm_tmp;
@@ -269,13 +279,6 @@ int qcom_icc_bcm_voter_commit(struct bcm_voter *voter)
 	struct tcs_cmd cmds[MAX_BCMS];
 	int ret = 0;
 
-	if (!voter)
-		return 0;
-
-	mutex_lock(&voter->lock);
-	list_for_each_entry(bcm, &voter->commit_list, list)
-		bcm_aggregate(bcm, voter->init);
-
 	/*
 	 * Pre sort the BCMs based on VCD for ease of generating a command list
 	 * that groups the BCMs with the same VCD together. VCDs are numbered
@@ -319,6 +322,17 @@ int qcom_icc_bcm_voter_commit(struct bcm_voter *voter)
 		goto out;
 	}
 
+	voter->commits++;
+	list_for_each_entry(bcm, &voter->commit_list, list) {
+		if (bcm->vote_x[QCOM_ICC_BUCKET_AMC] !=
+		    bcm->sent_x[QCOM_ICC_BUCKET_AMC] ||
+		    bcm->vote_y[QCOM_ICC_BUCKET_AMC] !=
+		    bcm->sent_y[QCOM_ICC_BUCKET_AMC])
+			bcm->changes++;
+		memcpy(bcm->sent_x, bcm->vote_x, sizeof(bcm->sent_x));
+		memcpy(bcm->sent_y, bcm->vote_y, sizeof(bcm->sent_y));
+	}
+
 	list_for_each_entry_safe(bcm, bcm_tmp, &voter->commit_list, list)
 		list_del_init(&bcm->list);
 
@@ -366,6 +380,78 @@ int qcom_icc_bcm_voter_commit(struct bcm_voter *voter)
 		list_del_init(&bcm->list);
 
 	INIT_LIST_HEAD(&voter->commit_list);
+	return ret;
+}
+
+static bool bcm_voter_raises(struct bcm_voter *voter)
+{
+	struct qcom_icc_bcm *bcm;
+	size_t bucket;
+
+	list_for_each_entry(bcm, &voter->commit_list, list)
+		for (bucket = 0; bucket < QCOM_ICC_NUM_BUCKETS; bucket++)
+			if (bcm->vote_x[bucket] > bcm->sent_x[bucket] ||
+			    bcm->vote_y[bucket] > bcm->sent_y[bucket])
+				return true;
+
+	return false;
+}
+
+static void bcm_voter_hyst_work(struct work_struct *work)
+{
+	struct bcm_voter *voter = container_of(to_delayed_work(work),
+					       struct bcm_voter, hyst_work);
+
+	mutex_lock(&voter->lock);
+	if (!list_empty(&voter->commit_list))
+		__bcm_voter_commit(voter);
+	mutex_unlock(&voter->lock);
+}
+
+/**
+ * qcom_icc_bcm_voter_commit - generates and commits tcs cmds based on bcms
+ * @voter: voter that needs flushing
+ *
+ * This function generates a set of AMC commands and flushes to the BCM device
+ * associated with the voter. It conditionally generate WAKE and SLEEP commands
+ * based on deltas between WAKE/SLEEP requirements. The ws_list persists
+ * through multiple commit requests and bcm nodes are removed only when the
+ * requirements for WAKE matches SLEEP.
+ *
+ * Any commit that raises a vote is sent right away. A commit that only lowers
+ * votes is held back for hyst_ms. Every other client vote that lands in that
+ * window is then folded into a single request, so the bus and DDR frequency
+ * are not stepped down once per client.
+ *
+ * Returns 0 on success, or an appropriate error code otherwise.
+ */
+int qcom_icc_bcm_voter_commit(struct bcm_voter *voter)
+{
+	struct qcom_icc_bcm *bcm;
+	int ret;
+
+	if (!voter)
+		return 0;
+
+	mutex_lock(&voter->lock);
+	if (list_empty(&voter->commit_list)) {
+		mutex_unlock(&voter->lock);
+		return 0;
+	}
+
+	list_for_each_entry(bcm, &voter->commit_list, list)
+		bcm_aggregate(bcm, voter->init);
+
+	if (voter->hyst_ms && !voter->init && !bcm_voter_raises(voter)) {
+		voter->deferred++;
+		queue_delayed_work(system_unbound_wq, &voter->hyst_work,
+				   msecs_to_jiffies(voter->hyst_ms));
+		mutex_unlock(&voter->lock);
+		return 0;
+	}
+
+	cancel_delayed_work(&voter->hyst_work);
+	ret = __bcm_voter_commit(voter);
 	mutex_unlock(&voter->lock);
 	return ret;
 }
@@ -386,6 +472,45 @@ void qcom_icc_bcm_voter_clear_init(struct bcm_voter *voter)
 }
 EXPORT_SYMBOL(qcom_icc_bcm_voter_clear_init);
 
+static int bcm_voter_stats_show(struct seq_file *s, void *unused)
+{
+	struct bcm_voter *voter = s->private;
+	struct qcom_icc_bcm *bcm;
+	u64 elapsed_ms, rate;
+
+	mutex_lock(&voter->lock);
+	elapsed_ms = max_t(u64, ktime_ms_delta(ktime_get(), voter->start), 1);
+
+	seq_printf(s, "commits: %llu deferred: %llu elapsed_ms: %llu\n",
+		   voter->commits, voter->deferred, elapsed_ms);
+	seq_printf(s, "%-12s %10s %12s %12s %12s\n",
+		   "bcm", "changes", "changes/s", "vote_x", "vote_y");
+
+	list_for_each_entry(bcm, &voter->bcm_list, stats_list) {
+		rate = div64_u64(bcm->changes * 100000, elapsed_ms);
+		seq_printf(s, "%-12s %10llu %9llu.%02llu %12llu %12llu\n",
+			   bcm->name, bcm->changes, rate / 100, rate % 100,
+			   bcm->sent_x[QCOM_ICC_BUCKET_AMC],
+			   bcm->sent_y[QCOM_ICC_BUCKET_AMC]);
+	}
+	mutex_unlock(&voter->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(bcm_voter_stats);
+
+static void bcm_voter_debugfs_init(struct bcm_voter *voter)
+{
+	struct dentry *dir;
+
+	if (!bcm_voter_debugfs_dir)
+		bcm_voter_debugfs_dir = debugfs_create_dir("bcm_voter", NULL);
+
+	dir = debugfs_create_dir(dev_name(voter->dev), bcm_voter_debugfs_dir);
+	debugfs_create_u32("hysteresis_ms", 0644, dir, &voter->hyst_ms);
+	debugfs_create_file("stats", 0444, dir, voter, &bcm_voter_stats_fops);
+}
+
 static int qcom_icc_bcm_voter_probe(struct platform_device *pdev)
 {
 	struct device_node *np = pdev->dev.of_node;
@@ -402,11 +527,20 @@ static int qcom_icc_bcm_voter_probe(struct platform_device *pdev)
 	if (of_property_read_u32(np, "qcom,tcs-wait", &voter->tcs_wait))
 		voter->tcs_wait = QCOM_ICC_TAG_ACTIVE_ONLY;
 
+	if (of_property_read_u32(np, "qcom,vote-hysteresis-ms",
+				 &voter->hyst_ms))
+		voter->hyst_ms = BCM_VOTER_DEFAULT_HYST_MS;
+
 	mutex_init(&voter->lock);
 	INIT_LIST_HEAD(&voter->commit_list);
 	INIT_LIST_HEAD(&voter->ws_list);
+	INIT_LIST_HEAD(&voter->bcm_list);
+	INIT_DELAYED_WORK(&voter->hyst_work, bcm_voter_hyst_work);
+	voter->start = ktime_get();
 	list_add_tail(&voter->voter_node, &bcm_voters);
 
+	bcm_voter_debugfs_init(voter);
+
 	return 0;
 }
 
@@ -160,6 +160,7 @@ int qcom_icc_bcm_init(struct qcom_icc_bcm *bcm, struct device *dev)
 	bcm->aux_data.reserved = data->reserved;
 	INIT_LIST_HEAD(&bcm->list);
 	INIT_LIST_HEAD(&bcm->ws_list);
+	INIT_LIST_HEAD(&bcm->stats_list);
 
 	if (!bcm->vote_scale)
 		bcm->vote_scale = 1000;
@@ -96,6 +96,10 @@ struct qcom_icc_node {
  * communicating with RPMh
  * @list: used to link to other bcms when compiling lists for commit
  * @ws_list: used to keep track of bcms that may transition between wake/sleep
+ * @stats_list: used to link the bcm into its voter's statistics list
+ * @sent_x: vote_x values last sent to RPMh
+ * @sent_y: vote_y values last sent to RPMh
+ * @changes: number of AMC commits that changed this bcm's active vote
  * @num_nodes: total number of @num_nodes
  * @nodes: list of qcom_icc_nodes that this BCM encapsulates
  */
@@ -111,6 +115,10 @@ struct qcom_icc_bcm {
 	struct bcm_db aux_data;
 	struct list_head list;
 	struct list_head ws_list;
+	struct list_head stats_list;
+	u64 sent_x[QCOM_ICC_NUM_BUCKETS];
+	u64 sent_y[QCOM_ICC_NUM_BUCKETS];
+	u64 changes;
 	int voter_idx;
 	size_t num_nodes;
 	struct qcom_icc_node *nodes[];
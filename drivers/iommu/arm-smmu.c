@@ -2006,6 +2006,8 @@ static void arm_smmu_domain_get_qcom_quirks(struct arm_smmu_domain *smmu_domain,
 		*quirks |= IO_PGTABLE_QUIRK_QCOM_USE_UPSTREAM_HINT;
 	if (test_bit(DOMAIN_ATTR_USE_LLC_NWA, smmu_domain->attributes))
 		*quirks |= IO_PGTABLE_QUIRK_QCOM_USE_LLC_NWA;
+	if (test_bit(DOMAIN_ATTR_CONTIG_HINT, smmu_domain->attributes))
+		*quirks |= IO_PGTABLE_QUIRK_CONT_HINT;
 }
 
 static int arm_smmu_setup_context_bank(struct arm_smmu_domain *smmu_domain,
@@ -2199,6 +2201,8 @@ static int arm_smmu_init_domain_context(struct iommu_domain *domain,
 
 	if (smmu_domain->non_strict)
 		quirks |= IO_PGTABLE_QUIRK_NON_STRICT;
+	/* arm_smmu_iotlb_sync() flushes whatever unmap left in the gather */
+	quirks |= IO_PGTABLE_QUIRK_DEFER_FLUSH;
 	arm_smmu_domain_get_qcom_quirks(smmu_domain, smmu, &quirks);
 
 	ret = arm_smmu_alloc_cb(domain, smmu, dev);
@@ -3346,7 +3350,11 @@ static void arm_smmu_iotlb_sync(struct iommu_domain *domain,
 			arm_smmu_rpm_put(smmu);
 			return;
 		}
-		smmu_domain->flush_ops->tlb_sync(smmu_domain);
+		/* A non-empty gather means unmap deferred its flush to us */
+		if (gather && gather->end)
+			smmu_domain->flush_ops->tlb.tlb_flush_all(smmu_domain);
+		else
+			smmu_domain->flush_ops->tlb_sync(smmu_domain);
 		arm_smmu_domain_power_off(domain, smmu);
 		arm_smmu_rpm_put(smmu);
 	}
@@ -3887,6 +3895,11 @@ static int arm_smmu_domain_get_attr(struct iommu_domain *domain,
 					  smmu_domain->attributes);
 		ret = 0;
 		break;
+	case DOMAIN_ATTR_CONTIG_HINT:
+		*((int *)data) = test_bit(DOMAIN_ATTR_CONTIG_HINT,
+					  smmu_domain->attributes);
+		ret = 0;
+		break;
 	default:
 		ret = -ENODEV;
 		break;
@@ -4106,6 +4119,20 @@ static int __arm_smmu_domain_set_attr2(struct iommu_domain *domain,
 			set_bit(attr, smmu_domain->attributes);
 		ret = 0;
 		break;
+	case DOMAIN_ATTR_CONTIG_HINT:
+		/* can't be changed while attached */
+		if (smmu_domain->smmu != NULL) {
+			ret = -EBUSY;
+		} else if (*((int *)data)) {
+			set_bit(DOMAIN_ATTR_CONTIG_HINT,
+				smmu_domain->attributes);
+			ret = 0;
+		} else {
+			clear_bit(DOMAIN_ATTR_CONTIG_HINT,
+				  smmu_domain->attributes);
+			ret = 0;
+		}
+		break;
 	case DOMAIN_ATTR_PAGE_TABLE_FORCE_COHERENT: {
 		int force_coherent = *((int *)data);
 
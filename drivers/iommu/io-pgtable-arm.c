@@ -81,6 +81,7 @@
 #define ARM_LPAE_PTE_SH_MASK		(((arm_lpae_iopte)0x3) << 8)
 #define ARM_LPAE_PTE_NSTABLE		(((arm_lpae_iopte)1) << 63)
 #define ARM_LPAE_PTE_XN			(((arm_lpae_iopte)3) << 53)
+#define ARM_LPAE_PTE_CONT		(((arm_lpae_iopte)1) << 52)
 #define ARM_LPAE_PTE_AF			(((arm_lpae_iopte)1) << 10)
 #define ARM_LPAE_PTE_SH_NS		(((arm_lpae_iopte)0) << 8)
 #define ARM_LPAE_PTE_SH_OS		(((arm_lpae_iopte)2) << 8)
@@ -96,6 +97,10 @@
 /* Software bit for solving coherency races */
 #define ARM_LPAE_PTE_SW_SYNC		(((arm_lpae_iopte)1) << 55)
 
+/* Contiguous hint: 16 page entries at the last level with a 4K granule */
+#define ARM_LPAE_CONT_PTES		16
+#define ARM_LPAE_CONT_SIZE		(ARM_LPAE_CONT_PTES * SZ_4K)
+
 /* Stage-1 PTE */
 #define ARM_LPAE_PTE_AP_PRIV_RW		(((arm_lpae_iopte)0) << 6)
 #define ARM_LPAE_PTE_AP_UNPRIV		(((arm_lpae_iopte)1) << 6)
@@ -452,6 +457,41 @@ static arm_lpae_iopte arm_lpae_install_table(arm_lpae_iopte *table,
 	return old;
 }
 
+static bool arm_lpae_use_cont(struct arm_lpae_io_pgtable *data)
+{
+	return (data->iop.cfg.quirks & IO_PGTABLE_QUIRK_CONT_HINT) &&
+		data->iop.fmt != ARM_MALI_LPAE &&
+		ARM_LPAE_GRANULE(data) == SZ_4K;
+}
+
+/*
+ * Drop the contiguous hint from the run of page entries containing @idx if
+ * the run is only partly being unmapped. A run where some entries are
+ * invalid is misprogrammed and the walker would be free to use a live
+ * entry's translation for an address that is no longer mapped.
+ */
+static void arm_lpae_break_cont(struct arm_lpae_io_pgtable *data,
+				arm_lpae_iopte *table, int idx, int max)
+{
+	int i, start = round_down(idx, ARM_LPAE_CONT_PTES);
+	bool dirty = false;
+
+	if (idx == start || idx >= max)
+		return;
+
+	for (i = start; i < start + ARM_LPAE_CONT_PTES; i++) {
+		if (table[i] & ARM_LPAE_PTE_CONT) {
+			table[i] &= ~ARM_LPAE_PTE_CONT;
+			dirty = true;
+		}
+	}
+
+	if (dirty)
+		pgtable_dma_sync_single_for_device(&data->iop.cfg,
+			__arm_lpae_dma_addr(&table[start]),
+			ARM_LPAE_CONT_PTES * sizeof(*table), DMA_TO_DEVICE);
+}
+
 struct map_state {
 	unsigned long iova_end;
 	unsigned int pgsize;
@@ -649,6 +689,8 @@ static int arm_lpae_map_sg(struct io_pgtable_ops *ops, unsigned long iova,
 	unsigned int min_pagesz;
 	struct io_pgtable_cfg *cfg = &data->iop.cfg;
 	struct map_state ms;
+	bool use_cont = arm_lpae_use_cont(data);
+	unsigned int cont_left = 0;
 
 	/* If no access, then nothing to do */
 	if (!(iommu_prot & (IOMMU_READ | IOMMU_WRITE)))
@@ -676,18 +718,35 @@ static int arm_lpae_map_sg(struct io_pgtable_ops *ops, unsigned long iova,
 		while (size) {
 			size_t pgsize = iommu_pgsize(
 				cfg->pgsize_bitmap, iova | phys, size);
+			arm_lpae_iopte pte_prot = prot;
+
+			/*
+			 * Start a contiguous run only where all 16 pages
+			 * come from this segment so the run can't straddle
+			 * two unrelated physical ranges.
+			 */
+			if (cont_left) {
+				pte_prot |= ARM_LPAE_PTE_CONT;
+				cont_left--;
+			} else if (use_cont && pgsize == SZ_4K &&
+				   IS_ALIGNED(iova | phys, ARM_LPAE_CONT_SIZE) &&
+				   size >= ARM_LPAE_CONT_SIZE) {
+				pte_prot |= ARM_LPAE_PTE_CONT;
+				cont_left = ARM_LPAE_CONT_PTES - 1;
+			}
 
 			if (ms.pgtable && (iova < ms.iova_end)) {
 				arm_lpae_iopte *ptep = ms.pgtable +
 					ARM_LPAE_LVL_IDX(iova, MAP_STATE_LVL,
 							 data);
 				arm_lpae_init_pte(
-					data, iova, phys, prot, MAP_STATE_LVL,
-					ptep, ms.prev_pgtable, false);
+					data, iova, phys, pte_prot,
+					MAP_STATE_LVL, ptep, ms.prev_pgtable,
+					false);
 				ms.num_pte++;
 			} else {
 				ret = __arm_lpae_map(data, iova, phys, pgsize,
-						prot, lvl, ptep, NULL, &ms);
+						pte_prot, lvl, ptep, NULL, &ms);
 				if (ret)
 					goto out_err;
 			}
@@ -882,6 +941,13 @@ static size_t __arm_lpae_unmap(struct arm_lpae_io_pgtable *data,
 					   __arm_lpae_dma_addr(table),
 					   table_len, DMA_TO_DEVICE);
 
+		if (arm_lpae_use_cont(data)) {
+			arm_lpae_break_cont(data, table_base, tl_offset,
+					    max_entries);
+			arm_lpae_break_cont(data, table_base,
+					    tl_offset + entries, max_entries);
+		}
+
 		iopte_tblcnt_sub(ptep, entries);
 		if (!iopte_tblcnt(*ptep)) {
 			/* no valid mappings left under this table. free it. */
@@ -933,8 +999,16 @@ static size_t arm_lpae_unmap(struct io_pgtable_ops *ops, unsigned long iova,
 		iova += ret;
 	}
 
-	if (unmapped)
+	if (!unmapped)
+		return 0;
+
+	if (gather && (data->iop.cfg.quirks & IO_PGTABLE_QUIRK_DEFER_FLUSH)) {
+		/* Leave the invalidate to the iotlb_sync that follows */
+		gather->start = min(gather->start, iova - unmapped);
+		gather->end = max(gather->end, iova);
+	} else {
 		io_pgtable_tlb_flush_all(&data->iop);
+	}
 
 	return unmapped;
 }
@@ -26,10 +26,22 @@
  * @ref - for reference counting this mapping
  * @attrs - dma mapping attributes
  * @buf_start_addr - address of start of buffer
+ * @cpu_clean - the CPU caches were cleaned for this mapping when the buffer's
+ *		CPU access generation was @cpu_gen
+ * @cpu_gen - CPU access generation of the buffer at the last clean
+ * @dev_dirty - the device may have written to the buffer since the CPU caches
+ *		were last invalidated for it
  *
  * Represents a mapping of one dma_buf buffer to a particular device
  * and address range. There may exist other mappings of this buffer in
  * different devices. All mappings will have the same cacheability and security.
+ *
+ * The ownership state lets a buffer bounce between devices without cache
+ * maintenance: the clean on map is skipped while the CPU hasn't accessed the
+ * buffer since the last one, or limited to the ranges it accessed through
+ * dma_buf_begin/end_cpu_access_partial(). The invalidate on unmap is deferred
+ * until the CPU asks for the buffer through msm_dma_buf_sync_for_cpu() or the
+ * mapping is released.
  */
 struct msm_iommu_map {
 	struct list_head lnode;
@@ -42,6 +54,9 @@ struct msm_iommu_map {
 	struct kref ref;
 	unsigned long attrs;
 	dma_addr_t buf_start_addr;
+	bool cpu_clean;
+	int cpu_gen;
+	bool dev_dirty;
 };
 
 struct msm_iommu_meta {
@@ -158,6 +173,68 @@ static struct scatterlist *clone_sgl(struct scatterlist *sg, int nents)
 	return table.sgl;
 }
 
+/*
+ * Clean the CPU caches for the parts of @map the CPU accessed since the last
+ * clean, if any. A range that straddles scatterlist entries is cleaned one
+ * physically contiguous piece at a time.
+ */
+static void msm_iommu_map_sync_ranges(struct msm_iommu_map *map,
+				      const struct dma_buf_range *ranges,
+				      int nr_ranges)
+{
+	struct scatterlist *sg, piece;
+	unsigned long pos, start, end;
+	int i, r;
+
+	for (r = 0; r < nr_ranges; r++) {
+		pos = 0;
+		for_each_sg(map->sgl, sg, map->nents, i) {
+			start = max_t(unsigned long, ranges[r].offset, pos);
+			end = min_t(unsigned long,
+				    ranges[r].offset + ranges[r].len,
+				    pos + sg->length);
+			if (start < end) {
+				sg_init_table(&piece, 1);
+				sg_set_page(&piece, sg_page(sg), end - start,
+					    sg->offset + start - pos);
+				/* as in ion_pages_sync_for_device() */
+				sg_dma_address(&piece) = sg_phys(&piece);
+				dma_sync_sg_for_device(map->dev, &piece, 1,
+						       map->dir);
+			}
+			pos += sg->length;
+			if (pos >= ranges[r].offset + ranges[r].len)
+				break;
+		}
+	}
+}
+
+static void msm_iommu_map_sync_for_device(struct msm_iommu_map *map,
+					  struct dma_buf *dma_buf)
+{
+	struct msm_dma_buf *msm_dma_buf = to_msm_dma_buf(dma_buf);
+	struct dma_buf_range ranges[DMA_BUF_CPU_RANGES_MAX];
+	int nr = -ERANGE, gen;
+
+	if (map->cpu_clean)
+		nr = dma_buf_cpu_dirty_ranges(dma_buf, map->cpu_gen, ranges,
+					      &gen);
+	else
+		gen = atomic_read(&msm_dma_buf->cpu_gen);
+
+	if (nr > 0)
+		msm_iommu_map_sync_ranges(map, ranges, nr);
+	else if (nr < 0)
+		dma_sync_sg_for_device(map->dev, map->sgl, map->nents,
+				       map->dir);
+
+	if (nr >= 0)
+		atomic_inc(&msm_dma_buf->cmo_skips);
+
+	map->cpu_clean = true;
+	map->cpu_gen = gen;
+}
+
 static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 				   int nents, enum dma_data_direction dir,
 				   struct dma_buf *dma_buf,
@@ -165,9 +242,11 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 {
 	struct msm_iommu_map *iommu_map;
 	struct msm_iommu_meta *iommu_meta = NULL;
+	struct msm_dma_buf *msm_dma_buf = to_msm_dma_buf(dma_buf);
 	int ret = 0;
 	bool extra_meta_ref_taken = false;
 	int late_unmap = !(attrs & DMA_ATTR_NO_DELAYED_UNMAP);
+	int cpu_gen;
 
 	mutex_lock(&msm_iommu_map_mutex);
 	iommu_meta = msm_iommu_meta_lookup(dma_buf->priv);
@@ -191,8 +270,10 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 	mutex_unlock(&msm_iommu_map_mutex);
 
 	mutex_lock(&iommu_meta->lock);
+	cpu_gen = atomic_read(&msm_dma_buf->cpu_gen);
 	iommu_map = msm_iommu_lookup(iommu_meta, dev);
 	if (!iommu_map) {
+		atomic_inc(&msm_dma_buf->map_misses);
 		iommu_map = kmalloc(sizeof(*iommu_map), GFP_KERNEL);
 
 		if (!iommu_map) {
@@ -217,6 +298,9 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 		iommu_map->dir = dir;
 		iommu_map->attrs = attrs;
 		iommu_map->buf_start_addr = sg_phys(sg);
+		iommu_map->cpu_clean = !(attrs & DMA_ATTR_SKIP_CPU_SYNC);
+		iommu_map->cpu_gen = cpu_gen;
+		iommu_map->dev_dirty = false;
 
 		kref_init(&iommu_map->ref);
 		if (late_unmap)
@@ -246,10 +330,11 @@ static inline int __msm_dma_map_sg(struct device *dev, struct scatterlist *sg,
 			}
 
 			kref_get(&iommu_map->ref);
+			atomic_inc(&msm_dma_buf->map_hits);
 
 			if ((attrs & DMA_ATTR_SKIP_CPU_SYNC) == 0)
-				dma_sync_sg_for_device(dev, iommu_map->sgl,
-					iommu_map->nents, iommu_map->dir);
+				msm_iommu_map_sync_for_device(iommu_map,
+							      dma_buf);
 
 			if (dev_is_dma_coherent(dev) ||
 			    (attrs & DMA_ATTR_FORCE_COHERENT))
@@ -355,6 +440,10 @@ static void msm_iommu_map_release(struct kref *kref)
 	table.sgl = map->sgl;
 	list_del(&map->lnode);
 
+	/* the invalidate deferred by msm_dma_unmap_sg_attrs() is due now */
+	if (map->dev_dirty)
+		dma_sync_sg_for_cpu(map->dev, map->sgl, map->nents, map->dir);
+
 	/* Skip an additional cache maintenance on the dma unmap path */
 	if (!(map->attrs & DMA_ATTR_SKIP_CPU_SYNC))
 		map->attrs |= DMA_ATTR_SKIP_CPU_SYNC;
@@ -395,8 +484,14 @@ void msm_dma_unmap_sg_attrs(struct device *dev, struct scatterlist *sgl,
 		WARN(1, "%s: (%pK) dir:%d differs from original dir:%d\n",
 		     __func__, dma_buf, dir, iommu_map->dir);
 
-	if (attrs && ((attrs & DMA_ATTR_SKIP_CPU_SYNC) == 0))
-		dma_sync_sg_for_cpu(dev, iommu_map->sgl, iommu_map->nents, dir);
+	/*
+	 * Only the CPU needs the caches invalidated for what the device wrote,
+	 * another device mapping the buffer next doesn't. Leave it to
+	 * msm_dma_buf_sync_for_cpu() or to the release of the mapping.
+	 */
+	if (attrs && ((attrs & DMA_ATTR_SKIP_CPU_SYNC) == 0) &&
+	    iommu_map->dir != DMA_TO_DEVICE)
+		iommu_map->dev_dirty = true;
 
 	iommu_map->attrs = attrs;
 	kref_put(&iommu_map->ref, msm_iommu_map_release);
@@ -441,6 +536,38 @@ int msm_dma_unmap_all_for_dev(struct device *dev)
 }
 EXPORT_SYMBOL(msm_dma_unmap_all_for_dev);
 
+/*
+ * Only to be called by ION code before the CPU accesses a buffer
+ */
+void msm_dma_buf_sync_for_cpu(struct dma_buf *dma_buf)
+{
+	struct msm_iommu_map *iommu_map;
+	struct msm_iommu_meta *meta;
+
+	mutex_lock(&msm_iommu_map_mutex);
+	meta = msm_iommu_meta_lookup(dma_buf->priv);
+	if (!meta) {
+		mutex_unlock(&msm_iommu_map_mutex);
+		return;
+	}
+	kref_get(&meta->ref);
+	mutex_unlock(&msm_iommu_map_mutex);
+
+	mutex_lock(&meta->lock);
+	list_for_each_entry(iommu_map, &meta->iommu_maps, lnode) {
+		if (!iommu_map->dev_dirty)
+			continue;
+
+		dma_sync_sg_for_cpu(iommu_map->dev, iommu_map->sgl,
+				    iommu_map->nents, iommu_map->dir);
+		iommu_map->dev_dirty = false;
+	}
+	mutex_unlock(&meta->lock);
+
+	msm_iommu_meta_put(meta);
+}
+EXPORT_SYMBOL(msm_dma_buf_sync_for_cpu);
+
 /*
  * Only to be called by ION code when a buffer is freed
  */
@@ -92,6 +92,15 @@ struct bow_context {
 	struct log_sector *log_sector;
 	struct list_head trimmed_list;
 	bool forward_trims;
+
+	/* Checkpoint statistics, protected by ranges_lock */
+	u64 write_sectors;	/* sectors written by the filesystem */
+	u64 backup_sectors;	/* sectors copied to backup ranges */
+	u64 log_writes;		/* log sector updates */
+	u64 fast_writes;	/* writes remapped without a backup */
+	u64 queued_writes;	/* writes that went through the workqueue */
+	u64 queued_ns;		/* total time from map to submit */
+	u64 queued_max_ns;
 };
 
 sector_t range_top(struct bow_range *br)
@@ -253,13 +262,43 @@ static void set_type(struct bow_context *bc, struct bow_range **br, int type)
 	*br = NULL;
 }
 
-static struct bow_range *find_free_range(struct bow_context *bc)
+/*
+ * How many free ranges to look at for one that can take a backup of size
+ * bytes in one piece. Every piece costs a copy flush and a log entry, so a
+ * fit is worth a short walk, but the list can be long on a fragmented
+ * device. A size of 0 takes the most recently freed range.
+ */
+#define FREE_RANGE_SCAN 16
+
+static struct bow_range *find_free_range(struct bow_context *bc, u64 size)
 {
+	struct bow_range *br, *best = NULL;
+	int scanned = 0;
+
 	if (list_empty(&bc->trimmed_list)) {
 		DMERR("Unable to find free space to back up to");
 		return NULL;
 	}
 
+	if (!size)
+		goto first;
+
+	list_for_each_entry(br, &bc->trimmed_list, trimmed_list) {
+		u64 br_size = range_size(br);
+
+		if (br_size >= size && (!best || br_size < range_size(best))) {
+			best = br;
+			if (br_size == size)
+				break;
+		}
+
+		if (++scanned >= FREE_RANGE_SCAN)
+			break;
+	}
+
+	if (best)
+		return best;
+first:
 	return list_first_entry(&bc->trimmed_list, struct bow_range,
 				trimmed_list);
 }
@@ -271,7 +310,7 @@ static sector_t sector_to_page(struct bow_context const *bc, sector_t sector)
 	return sector >> (bc->block_shift - SECTOR_SHIFT);
 }
 
-static int copy_data(struct bow_context const *bc,
+static int copy_data(struct bow_context *bc,
 		     struct bow_range *source, struct bow_range *dest,
 		     u32 *checksum)
 {
@@ -285,6 +324,10 @@ static int copy_data(struct bow_context const *bc,
 	if (checksum)
 		*checksum = sector_to_page(bc, source->sector);
 
+	/* Issue all the reads up front rather than one block at a time */
+	dm_bufio_prefetch(bc->bufio, sector_to_page(bc, source->sector),
+			  range_size(source) >> bc->block_shift);
+
 	for (i = 0; i < range_size(source) >> bc->block_shift; ++i) {
 		struct dm_buffer *read_buffer, *write_buffer;
 		u8 *read, *write;
@@ -317,6 +360,7 @@ static int copy_data(struct bow_context const *bc,
 	}
 
 	dm_bufio_write_dirty_buffers(bc->bufio);
+	bc->backup_sectors += range_size(source) >> SECTOR_SHIFT;
 	return BLK_STS_OK;
 }
 
@@ -344,7 +388,7 @@ static int backup_log_sector(struct bow_context *bc)
 		return BLK_STS_IOERR;
 	}
 
-	free_br = find_free_range(bc);
+	free_br = find_free_range(bc, 0);
 	/* No space left - return this error to userspace */
 	if (!free_br)
 		return BLK_STS_NOSPC;
@@ -405,6 +449,7 @@ static int add_log_entry(struct bow_context *bc, sector_t source, sector_t dest,
 	dm_bufio_mark_buffer_dirty(sector_buffer);
 	dm_bufio_release(sector_buffer);
 	dm_bufio_write_dirty_buffers(bc->bufio);
+	bc->log_writes++;
 	return BLK_STS_OK;
 }
 
@@ -438,7 +483,7 @@ static int prepare_log(struct bow_context *bc)
 	}
 
 	/* Find free sector for active sector0 reads/writes */
-	free_br = find_free_range(bc);
+	free_br = find_free_range(bc, 0);
 	if (!free_br)
 		return BLK_STS_NOSPC;
 	bi_iter.bi_sector = free_br->sector;
@@ -456,7 +501,7 @@ static int prepare_log(struct bow_context *bc)
 	bc->log_sector->sector0 = free_br->sector;
 
 	/* Find free sector to back up original sector zero */
-	free_br = find_free_range(bc);
+	free_br = find_free_range(bc, 0);
 	if (!free_br)
 		return BLK_STS_NOSPC;
 	bi_iter.bi_sector = free_br->sector;
@@ -813,7 +858,7 @@ static int prepare_unchanged_range(struct bow_context *bc, struct bow_range *br,
 	sector_t sector0;
 
 	/* Find a free range */
-	backup_br = find_free_range(bc);
+	backup_br = find_free_range(bc, bi_iter->bi_size);
 	if (!backup_br)
 		return BLK_STS_NOSPC;
 
@@ -935,6 +980,7 @@ struct write_work {
 	struct work_struct work;
 	struct bow_context *bc;
 	struct bio *bio;
+	u64 start;
 };
 
 static void bow_write(struct work_struct *work)
@@ -943,6 +989,7 @@ static void bow_write(struct work_struct *work)
 	struct bow_context *bc = ww->bc;
 	struct bio *bio = ww->bio;
 	struct bvec_iter bi_iter = bio->bi_iter;
+	u64 start = ww->start, delta;
 	int ret = BLK_STS_OK;
 
 	kfree(ww);
@@ -956,6 +1003,10 @@ static void bow_write(struct work_struct *work)
 			  * SECTOR_SIZE;
 	} while (!ret && bi_iter.bi_size);
 
+	delta = ktime_get_ns() - start;
+	bc->queued_writes++;
+	bc->queued_ns += delta;
+	bc->queued_max_ns = max(bc->queued_max_ns, delta);
 	mutex_unlock(&bc->ranges_lock);
 
 	if (!ret) {
@@ -980,6 +1031,7 @@ static int queue_write(struct bow_context *bc, struct bio *bio)
 	INIT_WORK(&ww->work, bow_write);
 	ww->bc = bc;
 	ww->bio = bio;
+	ww->start = ktime_get_ns();
 	queue_work(bc->workqueue, &ww->work);
 	return DM_MAPIO_SUBMITTED;
 }
@@ -1091,6 +1143,30 @@ static int remove_trim(struct bow_context *bc, struct bio *bio)
 	return DM_MAPIO_REMAPPED;
 }
 
+/*
+ * Blocks that were already backed up, or were free at checkpoint time, can
+ * be overwritten freely. Writes that only touch such blocks need no copy
+ * and skip the trip through the workqueue. Called with ranges_lock held.
+ */
+static bool write_needs_backup(struct bow_context *bc, struct bio *bio)
+{
+	struct bow_range *br;
+	struct bvec_iter bi_iter = bio->bi_iter;
+
+	while (bi_iter.bi_size) {
+		br = find_first_overlapping_range(&bc->ranges, &bi_iter);
+		if (!br || br->type != CHANGED)
+			return true;
+
+		bi_iter.bi_sector += bi_iter.bi_size / SECTOR_SIZE;
+		bi_iter.bi_size = bio->bi_iter.bi_size
+			- (bi_iter.bi_sector - bio->bi_iter.bi_sector)
+			  * SECTOR_SIZE;
+	}
+
+	return false;
+}
+
 int remap_unless_illegal_trim(struct bow_context *bc, struct bio *bio)
 {
 	if (!bc->forward_trims && bio_op(bio) == REQ_OP_DISCARD) {
@@ -1129,10 +1205,16 @@ static int dm_bow_map(struct dm_target *ti, struct bio *bio)
 			else
 				/* pass-through */;
 		} else if (state == CHECKPOINT) {
+			if (bio_data_dir(bio) == WRITE)
+				bc->write_sectors += bio_sectors(bio);
+
 			if (bio->bi_iter.bi_sector == 0)
 				ret = handle_sector0(bc, bio);
-			else if (bio_data_dir(bio) == WRITE)
+			else if (bio_data_dir(bio) == WRITE &&
+				 write_needs_backup(bc, bio))
 				ret = queue_write(bc, bio);
+			else if (bio_data_dir(bio) == WRITE)
+				bc->fast_writes++;
 			else
 				/* pass-through */;
 		} else {
@@ -1230,14 +1312,29 @@ static void dm_bow_tablestatus(struct dm_target *ti, char *result,
 			  "\nERROR: not all trimmed ranges in trimmed list");
 }
 
+/*
+ * Info status: <write sectors> <backup sectors> <log writes> <fast writes>
+ * <queued writes> <avg queued us> <max queued us>
+ * Backup sectors plus log writes over write sectors is the write
+ * amplification of the checkpoint so far.
+ */
 static void dm_bow_status(struct dm_target *ti, status_type_t type,
 			  unsigned int status_flags, char *result,
 			  unsigned int maxlen)
 {
+	struct bow_context *bc = ti->private;
+	unsigned int sz = 0;
+
 	switch (type) {
 	case STATUSTYPE_INFO:
-		if (maxlen)
-			result[0] = 0;
+		mutex_lock(&bc->ranges_lock);
+		DMEMIT("%llu %llu %llu %llu %llu %llu %llu",
+		       bc->write_sectors, bc->backup_sectors, bc->log_writes,
+		       bc->fast_writes, bc->queued_writes,
+		       div64_u64(bc->queued_ns,
+				 max_t(u64, bc->queued_writes, 1)) / NSEC_PER_USEC,
+		       bc->queued_max_ns / NSEC_PER_USEC);
+		mutex_unlock(&bc->ranges_lock);
 		break;
 
 	case STATUSTYPE_TABLE:
@@ -1266,7 +1363,7 @@ static int dm_bow_iterate_devices(struct dm_target *ti,
 
 static struct target_type bow_target = {
 	.name   = "bow",
-	.version = {1, 2, 0},
+	.version = {1, 3, 0},
 	.module = THIS_MODULE,
 	.ctr    = dm_bow_ctr,
 	.dtr    = dm_bow_dtr,
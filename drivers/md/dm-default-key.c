@@ -253,6 +253,9 @@ static int default_key_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 		goto bad;
 	}
 
+	/* Every IO through the target uses this key, program it now */
+	blk_crypto_preload_key(dkc->dev->bdev->bd_queue, &dkc->key);
+
 	ti->num_flush_bios = 1;
 
 	ti->may_passthrough_inline_crypto = true;
@@ -20,6 +20,11 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/reboot.h>
+#include <crypto/sha.h>
+#include <crypto/sha256_mb.h>
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+#include <soc/qcom/boot_stats.h>
+#endif
 
 #define DM_MSG_PREFIX			"verity"
 
@@ -30,6 +35,12 @@
 
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
+/* bios up to this many blocks are verified on the CPU that completed them */
+#define DM_VERITY_LOCAL_MAX_BLOCKS	8
+
+#define DM_VERITY_DEFAULT_PINNED_LEVELS	2
+#define DM_VERITY_MAX_PINNED_SIZE	(4 << 20)
+
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
 #define DM_VERITY_OPT_RESTART		"restart_on_corruption"
 #define DM_VERITY_OPT_IGN_ZEROES	"ignore_zero_blocks"
@@ -42,6 +53,15 @@ static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
 
+/*
+ * The top "pinned_levels" levels of the hash tree of a target are kept in
+ * memory once verified, so they survive dm-bufio reclaim and need neither a
+ * lock nor a hash to be used.  Applies to targets created after a change.
+ */
+static unsigned dm_verity_pinned_levels = DM_VERITY_DEFAULT_PINNED_LEVELS;
+
+module_param_named(pinned_levels, dm_verity_pinned_levels, uint, S_IRUGO | S_IWUSR);
+
 /*
  * If rootwait parameter defined, wait for root device to be available
  * before continuing with verity target
@@ -228,6 +248,40 @@ static void verity_hash_at_level(struct dm_verity *v, sector_t block, int level,
 		*offset = idx << (v->hash_dev_block_bits - v->hash_per_block_bits);
 }
 
+/*
+ * Return the verified copy of a pinned hash block, or NULL if the block is
+ * not pinned or not verified yet.  Copies are never dropped or changed once
+ * valid, so no lock is needed.
+ */
+static u8 *verity_pinned_block(struct dm_verity *v, sector_t hash_block)
+{
+	sector_t idx = hash_block - v->hash_start;
+
+	if (idx >= v->pinned_blocks || !test_bit(idx, v->pinned_valid))
+		return NULL;
+
+	/* pairs with smp_wmb() in verity_pin_block() */
+	smp_rmb();
+	return v->pinned + (idx << v->hash_dev_block_bits);
+}
+
+/*
+ * Keep a copy of a verified hash block if it belongs to a pinned level.
+ */
+static void verity_pin_block(struct dm_verity *v, sector_t hash_block,
+			     const u8 *data)
+{
+	sector_t idx = hash_block - v->hash_start;
+
+	if (idx >= v->pinned_blocks || test_and_set_bit(idx, v->pinned_busy))
+		return;
+
+	memcpy(v->pinned + (idx << v->hash_dev_block_bits), data,
+	       1 << v->hash_dev_block_bits);
+	smp_wmb();
+	set_bit(idx, v->pinned_valid);
+}
+
 /*
  * Handle verification errors.
  */
@@ -307,6 +361,12 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 
 	verity_hash_at_level(v, block, level, &hash_block, &offset);
 
+	data = verity_pinned_block(v, hash_block);
+	if (data) {
+		memcpy(want_digest, data + offset, v->digest_size);
+		return 0;
+	}
+
 	data = dm_bufio_read(v->bufio, hash_block, &buf);
 	if (IS_ERR(data))
 		return PTR_ERR(data);
@@ -340,6 +400,9 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 		}
 	}
 
+	if (aux->hash_verified)
+		verity_pin_block(v, hash_block, data);
+
 	data += offset;
 	memcpy(want_digest, data, v->digest_size);
 	r = 0;
@@ -430,6 +493,27 @@ static int verity_for_io_block(struct dm_verity *v, struct dm_verity_io *io,
 	return 0;
 }
 
+/*
+ * Calculates the digest of the data block at iter through the ahash API.
+ */
+static int verity_hash_data_block(struct dm_verity *v, struct dm_verity_io *io,
+				  struct bvec_iter *iter, u8 *digest)
+{
+	struct ahash_request *req = verity_io_hash_req(v, io);
+	struct crypto_wait wait;
+	int r;
+
+	r = verity_hash_init(v, req, &wait);
+	if (unlikely(r < 0))
+		return r;
+
+	r = verity_for_io_block(v, io, iter, &wait);
+	if (unlikely(r < 0))
+		return r;
+
+	return verity_hash_final(v, req, digest, &wait);
+}
+
 /*
  * Calls function process for 1 << v->data_dev_block_bits bytes in the bio_vec
  * starting from iter.
@@ -487,6 +571,118 @@ static inline void verity_bv_skip_block(struct dm_verity *v,
 	bio_advance_iter(bio, iter, 1 << v->data_dev_block_bits);
 }
 
+/*
+ * Compare the digest of a data block against the hash tree, and try to
+ * correct or report the block if they don't match.
+ */
+static int verity_check_data_block(struct dm_verity *v,
+				   struct dm_verity_io *io, sector_t cur_block,
+				   struct bvec_iter *start)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+
+	if (likely(memcmp(verity_io_real_digest(v, io),
+			  verity_io_want_digest(v, io), v->digest_size) == 0)) {
+		if (v->validated_blocks)
+			set_bit(cur_block, v->validated_blocks);
+		return 0;
+	}
+
+	if (verity_fec_decode(v, io, DM_VERITY_BLOCK_TYPE_DATA,
+			      cur_block, NULL, start) == 0)
+		return 0;
+
+	if (bio->bi_status) {
+		/*
+		 * Error correction failed; Just return error
+		 */
+		return -EIO;
+	}
+	if (verity_handle_err(v, DM_VERITY_BLOCK_TYPE_DATA, cur_block))
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * A data block waiting for a second one to be hashed together with.
+ */
+struct verity_pending_block {
+	sector_t block;
+	struct bvec_iter start;
+	u8 want_digest[SHA256_DIGEST_SIZE];
+};
+
+/*
+ * Whether the data block at iter can go through sha256_finup2x(): that
+ * needs the whole block in a single page.
+ */
+static bool verity_can_hash_2x(struct dm_verity *v, struct dm_verity_io *io,
+			       struct bvec_iter *iter)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+
+	return v->mb_state &&
+	       bio_iter_iovec(bio, *iter).bv_len >= 1 << v->data_dev_block_bits;
+}
+
+/*
+ * Hash the pending block together with the data block at start, or on its
+ * own if start is NULL, and check the digests.  On entry
+ * verity_io_want_digest() holds the digest wanted for the block at start.
+ */
+static int verity_verify_2x(struct dm_verity *v, struct dm_verity_io *io,
+			    struct verity_pending_block *pb,
+			    sector_t cur_block, struct bvec_iter *start)
+{
+	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	unsigned int len = 1 << v->data_dev_block_bits;
+	u8 digest1[SHA256_DIGEST_SIZE], digest2[SHA256_DIGEST_SIZE];
+	u8 want2[SHA256_DIGEST_SIZE];
+	struct bio_vec bv1, bv2;
+	struct bvec_iter iter;
+	u8 *data1, *data2;
+	bool done;
+	int r;
+
+	memcpy(want2, verity_io_want_digest(v, io), v->digest_size);
+
+	bv1 = bio_iter_iovec(bio, pb->start);
+	bv2 = start ? bio_iter_iovec(bio, *start) : bv1;
+	data1 = kmap_atomic(bv1.bv_page);
+	data2 = kmap_atomic(bv2.bv_page);
+	done = sha256_finup2x(v->mb_state, data1 + bv1.bv_offset,
+			      data2 + bv2.bv_offset, len, digest1, digest2);
+	kunmap_atomic(data2);
+	kunmap_atomic(data1);
+
+	if (unlikely(!done)) {
+		/* no NEON here, hash the blocks one by one */
+		iter = pb->start;
+		r = verity_hash_data_block(v, io, &iter, digest1);
+		if (unlikely(r < 0))
+			return r;
+		if (start) {
+			iter = *start;
+			r = verity_hash_data_block(v, io, &iter, digest2);
+			if (unlikely(r < 0))
+				return r;
+		}
+	}
+
+	memcpy(verity_io_real_digest(v, io), digest1, v->digest_size);
+	memcpy(verity_io_want_digest(v, io), pb->want_digest, v->digest_size);
+	iter = pb->start;
+	r = verity_check_data_block(v, io, pb->block, &iter);
+	if (r || !start)
+		return r;
+
+	memcpy(verity_io_real_digest(v, io), digest2, v->digest_size);
+	memcpy(verity_io_want_digest(v, io), want2, v->digest_size);
+	iter = *start;
+	return verity_check_data_block(v, io, cur_block, &iter);
+}
+
 /*
  * Verify one "dm_verity_io" structure.
  */
@@ -496,13 +692,12 @@ static int verity_verify_io(struct dm_verity_io *io)
 	struct dm_verity *v = io->v;
 	struct bvec_iter start;
 	unsigned b;
-	struct crypto_wait wait;
-	struct bio *bio = dm_bio_from_per_bio_data(io, v->ti->per_io_data_size);
+	struct verity_pending_block pending;
+	bool has_pending = false;
 
 	for (b = 0; b < io->n_blocks; b++) {
 		int r;
 		sector_t cur_block = io->block + b;
-		struct ahash_request *req = verity_io_hash_req(v, io);
 
 		if (v->validated_blocks &&
 		    likely(test_bit(cur_block, v->validated_blocks))) {
@@ -529,42 +724,40 @@ static int verity_verify_io(struct dm_verity_io *io)
 			continue;
 		}
 
-		r = verity_hash_init(v, req, &wait);
-		if (unlikely(r < 0))
-			return r;
-
 		start = io->iter;
-		r = verity_for_io_block(v, io, &io->iter, &wait);
+
+		if (verity_can_hash_2x(v, io, &io->iter)) {
+			verity_bv_skip_block(v, io, &io->iter);
+			if (!has_pending) {
+				pending.block = cur_block;
+				pending.start = start;
+				memcpy(pending.want_digest,
+				       verity_io_want_digest(v, io),
+				       v->digest_size);
+				has_pending = true;
+				continue;
+			}
+
+			has_pending = false;
+			r = verity_verify_2x(v, io, &pending, cur_block, &start);
+			if (unlikely(r < 0))
+				return r;
+			continue;
+		}
+
+		r = verity_hash_data_block(v, io, &io->iter,
+					   verity_io_real_digest(v, io));
 		if (unlikely(r < 0))
 			return r;
 
-		r = verity_hash_final(v, req, verity_io_real_digest(v, io),
-					&wait);
+		r = verity_check_data_block(v, io, cur_block, &start);
 		if (unlikely(r < 0))
 			return r;
-
-		if (likely(memcmp(verity_io_real_digest(v, io),
-				  verity_io_want_digest(v, io), v->digest_size) == 0)) {
-			if (v->validated_blocks)
-				set_bit(cur_block, v->validated_blocks);
-			continue;
-		}
-		else if (verity_fec_decode(v, io, DM_VERITY_BLOCK_TYPE_DATA,
-					   cur_block, NULL, &start) == 0)
-			continue;
-		else {
-			if (bio->bi_status) {
-				/*
-				 * Error correction failed; Just return error
-				 */
-				return -EIO;
-			}
-			if (verity_handle_err(v, DM_VERITY_BLOCK_TYPE_DATA,
-					   cur_block))
-				return -EIO;
-		}
 	}
 
+	if (has_pending)
+		return verity_verify_2x(v, io, &pending, 0, NULL);
+
 	return 0;
 }
 
@@ -587,8 +780,15 @@ static void verity_finish_io(struct dm_verity_io *io, blk_status_t status)
 static void verity_work(struct work_struct *w)
 {
 	struct dm_verity_io *io = container_of(w, struct dm_verity_io, work);
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	u64 boot_ev = boot_event_start();
+	int r = verity_verify_io(io);
 
+	boot_event_record(BOOT_EVENT_VERITY, "verify", boot_ev);
+	verity_finish_io(io, errno_to_blk_status(r));
+#else
 	verity_finish_io(io, errno_to_blk_status(verity_verify_io(io)));
+#endif
 }
 
 static void verity_end_io(struct bio *bio)
@@ -602,7 +802,16 @@ static void verity_end_io(struct bio *bio)
 	}
 
 	INIT_WORK(&io->work, verity_work);
-	queue_work(io->v->verify_wq, &io->work);
+	/*
+	 * Small reads, the bulk of what an app launch does, are verified
+	 * on the completion CPU where the data is still cache hot.  They
+	 * can't be verified in the completion context itself, looking up
+	 * the hash tree may have to sleep.
+	 */
+	if (io->n_blocks <= DM_VERITY_LOCAL_MAX_BLOCKS)
+		queue_work(io->v->verify_local_wq, &io->work);
+	else
+		queue_work(io->v->verify_wq, &io->work);
 }
 
 /*
@@ -820,13 +1029,20 @@ static void verity_dtr(struct dm_target *ti)
 	if (v->verify_wq)
 		destroy_workqueue(v->verify_wq);
 
+	if (v->verify_local_wq)
+		destroy_workqueue(v->verify_local_wq);
+
 	if (v->bufio)
 		dm_bufio_client_destroy(v->bufio);
 
 	kvfree(v->validated_blocks);
+	kvfree(v->pinned);
+	bitmap_free(v->pinned_valid);
+	bitmap_free(v->pinned_busy);
 	kfree(v->salt);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
+	kfree(v->mb_state);
 
 	if (v->tfm)
 		crypto_free_ahash(v->tfm);
@@ -867,6 +1083,38 @@ static int verity_alloc_most_once(struct dm_verity *v)
 	return 0;
 }
 
+/*
+ * Set up the copies of the top tree levels.  The levels are stored top
+ * first from hash_start, so the pinned blocks are a single range.  Fewer
+ * levels are pinned if they would take too much memory.
+ */
+static int verity_alloc_pinned(struct dm_verity *v)
+{
+	unsigned int n = min_t(unsigned int, dm_verity_pinned_levels, v->levels);
+	sector_t blocks;
+
+	for (; n; n--) {
+		if (n == v->levels)
+			blocks = v->hash_blocks - v->hash_start;
+		else
+			blocks = v->hash_level_block[v->levels - n - 1] -
+				 v->hash_start;
+		if (blocks << v->hash_dev_block_bits <= DM_VERITY_MAX_PINNED_SIZE)
+			break;
+	}
+	if (!n)
+		return 0;
+
+	v->pinned = kvmalloc(blocks << v->hash_dev_block_bits, GFP_KERNEL);
+	v->pinned_valid = bitmap_zalloc(blocks, GFP_KERNEL);
+	v->pinned_busy = bitmap_zalloc(blocks, GFP_KERNEL);
+	if (!v->pinned || !v->pinned_valid || !v->pinned_busy)
+		return -ENOMEM;	/* verity_dtr will free them */
+
+	v->pinned_blocks = blocks;
+	return 0;
+}
+
 static int verity_alloc_zero_digest(struct dm_verity *v)
 {
 	int r = -ENOMEM;
@@ -898,6 +1146,28 @@ static int verity_alloc_zero_digest(struct dm_verity *v)
 	return r;
 }
 
+/*
+ * With SHA-256 and a CPU that can interleave two SHA-256 computations, data
+ * blocks are hashed two at a time.  The salt is hashed once here and its
+ * state shared by all blocks, which needs the salt to come first.
+ */
+static int verity_alloc_mb_state(struct dm_verity *v)
+{
+	if (!sha256_finup2x_supported() || strcmp(v->alg_name, "sha256") ||
+	    (!v->version && v->salt_size))
+		return 0;
+
+	v->mb_state = kmalloc(sizeof(*v->mb_state), GFP_KERNEL);
+	if (!v->mb_state)
+		return -ENOMEM;
+
+	sha256_init(v->mb_state);
+	if (v->salt_size)
+		sha256_update(v->mb_state, v->salt, v->salt_size);
+
+	return 0;
+}
+
 static int verity_parse_opt_args(struct dm_arg_set *as, struct dm_verity *v,
 				 struct dm_verity_sig_opts *verify_args)
 {
@@ -1154,6 +1424,12 @@ static int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		}
 	}
 
+	r = verity_alloc_mb_state(v);
+	if (r) {
+		ti->error = "Cannot allocate SHA-256 state";
+		goto bad;
+	}
+
 	argv += 10;
 	argc -= 10;
 
@@ -1207,6 +1483,12 @@ static int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 	}
 	v->hash_blocks = hash_position;
 
+	r = verity_alloc_pinned(v);
+	if (r) {
+		ti->error = "Cannot allocate pinned hash blocks";
+		goto bad;
+	}
+
 	v->bufio = dm_bufio_client_create(v->hash_dev->bdev,
 		1 << v->hash_dev_block_bits, 1, sizeof(struct buffer_aux),
 		dm_bufio_alloc_callback, NULL);
@@ -1231,6 +1513,14 @@ static int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		goto bad;
 	}
 
+	v->verify_local_wq = alloc_workqueue("kverityd_local",
+					     WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+	if (!v->verify_local_wq) {
+		ti->error = "Cannot allocate workqueue";
+		r = -ENOMEM;
+		goto bad;
+	}
+
 	ti->per_io_data_size = sizeof(struct dm_verity_io) +
 				v->ahash_reqsize + v->digest_size * 2;
 
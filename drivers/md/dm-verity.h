@@ -40,6 +40,7 @@ struct dm_verity {
 	u8 *root_digest;	/* digest of the root block */
 	u8 *salt;		/* salt: its size is salt_size */
 	u8 *zero_digest;	/* digest for a zero block */
+	struct sha256_state *mb_state; /* salted state for sha256_finup2x() */
 	unsigned salt_size;
 	sector_t data_start;	/* data offset in 512-byte sectors */
 	sector_t hash_start;	/* hash start in blocks */
@@ -57,11 +58,18 @@ struct dm_verity {
 	unsigned corrupted_errs;/* Number of errors for corrupted blocks */
 
 	struct workqueue_struct *verify_wq;
+	struct workqueue_struct *verify_local_wq; /* bound, for small bios */
 
 	/* starting blocks for each tree level. 0 is the lowest level. */
 	sector_t hash_level_block[DM_VERITY_MAX_LEVELS];
 
 	struct dm_verity_fec *fec;	/* forward error correction */
+
+	/* verified copies of the hash blocks of the top tree levels */
+	u8 *pinned;
+	unsigned long *pinned_valid;	/* bitset: copy is filled in */
+	unsigned long *pinned_busy;	/* bitset: copy is being filled in */
+	sector_t pinned_blocks;	/* hash blocks from hash_start that are pinned */
 	unsigned long *validated_blocks; /* bitset blocks validated */
 
 	char *signature_key_desc; /* signature keyring reference */
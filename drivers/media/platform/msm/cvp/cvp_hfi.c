@@ -2503,6 +2503,64 @@ static int iris_hfi_session_send(void *sess,
 	return rc;
 }
 
+/*
+ * Writes @num_pkts packets to the command queue under one lock and raises
+ * a single interrupt for all of them. Returns the number of packets the
+ * queue took, which is less than @num_pkts only if it filled up part way,
+ * or a negative error if none was written.
+ */
+static int iris_hfi_session_send_batch(void *sess,
+		struct cvp_kmd_hfi_packet **in_pkts, u32 num_pkts)
+{
+	int rc = 0;
+	u32 i;
+	bool needs_interrupt, raise = false;
+	struct cvp_kmd_hfi_packet pkt;
+	struct cvp_hal_session *session = sess;
+	struct iris_hfi_device *device;
+
+	if (!session || !session->device || !in_pkts) {
+		dprintk(CVP_ERR, "invalid session");
+		return -ENODEV;
+	}
+
+	device = session->device;
+	mutex_lock(&device->lock);
+
+	if (!__is_session_valid(device, session, __func__)) {
+		rc = -ECONNRESET;
+		goto err_send_pkt;
+	}
+
+	for (i = 0; i < num_pkts; i++) {
+		rc = call_hfi_pkt_op(device, session_send,
+				&pkt, session, in_pkts[i]);
+		if (rc) {
+			dprintk(CVP_ERR, "failed to create pkt %u\n", i);
+			break;
+		}
+
+		needs_interrupt = false;
+		if (__iface_cmdq_write_relaxed(device, &pkt,
+				&needs_interrupt)) {
+			rc = -ENOTEMPTY;
+			break;
+		}
+		raise |= needs_interrupt;
+	}
+
+	/* Consumer of cmdq prefers that we raise an interrupt */
+	if (raise)
+		__write_register(device, CVP_CPU_CS_H2ASOFTINT, 1);
+
+	if (i)
+		rc = i;
+
+err_send_pkt:
+	mutex_unlock(&device->lock);
+	return rc;
+}
+
 static int iris_hfi_session_flush(void *sess)
 {
 	struct cvp_hal_session *session = sess;
@@ -4715,6 +4773,7 @@ static void iris_init_hfi_callbacks(struct cvp_hfi_device *hdev)
 	hdev->session_set_buffers = iris_hfi_session_set_buffers;
 	hdev->session_release_buffers = iris_hfi_session_release_buffers;
 	hdev->session_send = iris_hfi_session_send;
+	hdev->session_send_batch = iris_hfi_session_send_batch;
 	hdev->session_flush = iris_hfi_session_flush;
 	hdev->scale_clocks = iris_hfi_scale_clocks;
 	hdev->vote_bus = iris_hfi_vote_buses;
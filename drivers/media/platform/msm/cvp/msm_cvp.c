@@ -8,6 +8,9 @@
 #include "cvp_core_hfi.h"
 #include "msm_cvp_buf.h"
 
+/* Fence commands sent to the fw in one queue write */
+#define CVP_FENCE_BATCH_MAX 8
+
 struct cvp_power_level {
 	unsigned long core_sum;
 	unsigned long op_core_sum;
@@ -443,40 +446,27 @@ static int cvp_check_clock(struct msm_cvp_inst *inst,
 	return rc;
 }
 
-static int cvp_fence_proc(struct msm_cvp_inst *inst,
-			struct cvp_fence_command *fc,
-			struct cvp_hfi_cmd_session_hdr *pkt)
+/*
+ * Waits for the response to one fence command already sent to the fw and
+ * signals its output fences. @synx_state other than success means the
+ * command never reached the fw and the outputs only carry that state.
+ */
+static int cvp_fence_complete(struct msm_cvp_inst *inst,
+			struct cvp_fence_command *fc, u32 synx_state)
 {
 	int rc = 0;
 	unsigned long timeout;
 	u64 ktid;
-	int synx_state = SYNX_STATE_SIGNALED_SUCCESS;
-	struct cvp_hfi_device *hdev;
 	struct cvp_session_queue *sq;
 	u32 hfi_err = HFI_ERR_NONE;
 	struct cvp_hfi_msg_session_hdr_ext hdr;
 	bool clock_check = false;
 
-	dprintk(CVP_SYNX, "%s %s\n", current->comm, __func__);
-
-	hdev = inst->core->device;
-	sq = &inst->session_queue_fence;
-	ktid = pkt->client_data.kdata;
-
-	rc = cvp_synx_ops(inst, CVP_INPUT_SYNX, fc, &synx_state);
-	if (rc) {
-		msm_cvp_unmap_frame(inst, pkt->client_data.kdata);
+	if (synx_state != SYNX_STATE_SIGNALED_SUCCESS)
 		goto exit;
-	}
 
-	rc = call_hfi_op(hdev, session_send, (void *)inst->session,
-			(struct cvp_kmd_hfi_packet *)pkt);
-	if (rc) {
-		dprintk(CVP_ERR, "%s %s: Failed in call_hfi_op %d, %x\n",
-			current->comm, __func__, pkt->size, pkt->packet_type);
-		synx_state = SYNX_STATE_SIGNALED_ERROR;
-		goto exit;
-	}
+	sq = &inst->session_queue_fence;
+	ktid = fc->pkt->client_data.kdata;
 
 	timeout = msecs_to_jiffies(CVP_MAX_WAIT_TIME);
 	rc = cvp_wait_process_message(inst, sq, &ktid, timeout,
@@ -518,6 +508,77 @@ static int cvp_fence_proc(struct msm_cvp_inst *inst,
 	return rc;
 }
 
+/*
+ * Pulls the commands queued behind the one being sent whose input fences
+ * have all signaled, so they go to the fw in the same queue write. Stops
+ * at the first command that is not ready to keep submission order.
+ */
+static u32 cvp_fence_gather(struct msm_cvp_inst *inst,
+			struct cvp_fence_command **batch, u32 max)
+{
+	struct cvp_fence_queue *q = &inst->fence_cmd_queue;
+	struct cvp_fence_command *f, *next;
+	u32 n = 0;
+
+	mutex_lock(&q->lock);
+	if (q->state != QUEUE_ACTIVE)
+		goto unlock;
+
+	list_for_each_entry_safe(f, next, &q->wait_list, list) {
+		if (n >= max || !cvp_synx_inputs_ready(inst, f))
+			break;
+		list_move_tail(&f->list, &q->sched_list);
+		batch[n++] = f;
+	}
+unlock:
+	mutex_unlock(&q->lock);
+
+	return n;
+}
+
+static int cvp_fence_proc(struct msm_cvp_inst *inst,
+			struct cvp_fence_command **batch, u32 *num)
+{
+	int rc = 0, sent;
+	u32 i, n = 1;
+	u32 synx_state = SYNX_STATE_SIGNALED_SUCCESS;
+	struct cvp_hfi_device *hdev;
+	struct cvp_kmd_hfi_packet *pkts[CVP_FENCE_BATCH_MAX];
+	struct cvp_fence_command *fc = batch[0];
+
+	dprintk(CVP_SYNX, "%s %s\n", current->comm, __func__);
+
+	hdev = inst->core->device;
+
+	rc = cvp_synx_ops(inst, CVP_INPUT_SYNX, fc, &synx_state);
+	if (rc) {
+		msm_cvp_unmap_frame(inst, fc->pkt->client_data.kdata);
+		if (synx_state == SYNX_STATE_SIGNALED_SUCCESS)
+			synx_state = SYNX_STATE_SIGNALED_ERROR;
+		*num = 1;
+		return cvp_fence_complete(inst, fc, synx_state);
+	}
+
+	n += cvp_fence_gather(inst, &batch[1], CVP_FENCE_BATCH_MAX - 1);
+	for (i = 0; i < n; i++)
+		pkts[i] = (struct cvp_kmd_hfi_packet *)batch[i]->pkt;
+
+	sent = call_hfi_op(hdev, session_send_batch, (void *)inst->session,
+			pkts, n);
+	if (sent < (int)n)
+		dprintk(CVP_ERR, "%s %s: sent %d of %u, %d, %x\n",
+			current->comm, __func__, sent, n, fc->pkt->size,
+			fc->pkt->packet_type);
+
+	for (i = 0; i < n; i++)
+		rc = cvp_fence_complete(inst, batch[i], (int)i < sent ?
+			SYNX_STATE_SIGNALED_SUCCESS :
+			SYNX_STATE_SIGNALED_ERROR);
+
+	*num = n;
+	return rc;
+}
+
 static int cvp_alloc_fence_data(struct cvp_fence_command **f, u32 size)
 {
 	struct cvp_fence_command *fcmd;
@@ -553,8 +614,10 @@ static int cvp_fence_thread(void *data)
 	struct cvp_fence_queue *q;
 	enum queue_state state;
 	struct cvp_fence_command *f;
+	struct cvp_fence_command *batch[CVP_FENCE_BATCH_MAX];
 	struct cvp_hfi_cmd_session_hdr *pkt;
 	u32 *synx;
+	u32 i, num;
 	u64 ktid;
 
 	dprintk(CVP_SYNX, "Enter %s\n", current->comm);
@@ -586,18 +649,25 @@ static int cvp_fence_thread(void *data)
 	dprintk(CVP_SYNX, "%s pkt type %d on ktid %llu frameID %llu\n",
 		current->comm, pkt->packet_type, ktid, f->frame_id);
 
-	rc = cvp_fence_proc(inst, f, pkt);
+	batch[0] = f;
+	rc = cvp_fence_proc(inst, batch, &num);
 
-	mutex_lock(&q->lock);
-	cvp_release_synx(inst, f);
-	list_del_init(&f->list);
-	state = q->state;
-	mutex_unlock(&q->lock);
+	for (i = 0; i < num; i++) {
+		f = batch[i];
+		mutex_lock(&q->lock);
+		cvp_release_synx(inst, f);
+		list_del_init(&f->list);
+		state = q->state;
+		mutex_unlock(&q->lock);
 
-	dprintk(CVP_SYNX, "%s done with %d ktid %llu frameID %llu rc %d\n",
-		current->comm, pkt->packet_type, ktid, f->frame_id, rc);
+		dprintk(CVP_SYNX,
+			"%s done with %d ktid %llu frameID %llu rc %d\n",
+			current->comm, f->pkt->packet_type,
+			f->pkt->client_data.kdata & (FENCE_BIT - 1),
+			f->frame_id, rc);
 
-	cvp_free_fence_data(f);
+		cvp_free_fence_data(f);
+	}
 
 	if (rc && state != QUEUE_ACTIVE)
 		goto exit;
@@ -218,6 +218,26 @@ static int cvp_signal_synx(struct synx_session ssid, u32 *synx, u32 num_synx,
 	return rc;
 }
 
+/* True when every input fence of @fc has already signaled success */
+bool cvp_synx_inputs_ready(struct msm_cvp_inst *inst,
+		struct cvp_fence_command *fc)
+{
+	struct synx_session ssid;
+	u32 i;
+
+	if (fc->signature != 0xFEEDFACE)
+		return false;
+
+	ssid = inst->synx_session_id;
+	for (i = 0; i < fc->output_index; ++i) {
+		if (fc->synx[i] && synx_get_status(ssid, fc->synx[i]) !=
+				SYNX_STATE_SIGNALED_SUCCESS)
+			return false;
+	}
+
+	return true;
+}
+
 int cvp_synx_ops(struct msm_cvp_inst *inst, enum cvp_synx_type type,
 		struct cvp_fence_command *fc, u32 *synx_state)
 {
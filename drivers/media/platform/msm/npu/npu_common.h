@@ -68,6 +68,12 @@ struct npu_smmu_ctx {
 	int32_t attach_cnt;
 };
 
+/*
+ * Buffers unmapped by the client stay mapped up to this many per client,
+ * so a ring of camera output buffers shared every frame maps only once.
+ */
+#define NPU_MAX_PARKED_BUFS 32
+
 struct npu_ion_buf {
 	int fd;
 	struct dma_buf *dma_buf;
@@ -78,6 +84,7 @@ struct npu_ion_buf {
 	void *phys_addr;
 	void *buf;
 	struct list_head list;
+	bool parked;
 };
 
 struct npu_clk {
@@ -256,6 +263,7 @@ struct npu_client {
 	struct mutex list_lock;
 	struct list_head evt_list;
 	struct list_head mapped_buffer_list;
+	uint32_t num_parked;
 };
 
 /* -------------------------------------------------------------------------
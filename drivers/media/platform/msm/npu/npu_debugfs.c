@@ -428,6 +428,12 @@ int npu_debugfs_init(struct npu_device *npu_dev)
 		goto err;
 	}
 
+	if (!debugfs_create_u32("exec_inflight_max", 0644,
+		debugfs->root, &(host_ctx->exec_inflight_max))) {
+		pr_err("debugfs_create_u32 fail for exec_inflight_max\n");
+		goto err;
+	}
+
 	debugfs->log_num_bytes_buffered = 0;
 	debugfs->log_read_index = 0;
 	debugfs->log_write_index = 0;
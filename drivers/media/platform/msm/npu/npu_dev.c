@@ -1219,6 +1219,7 @@ static int npu_open(struct inode *inode, struct file *file)
 	mutex_init(&client->list_lock);
 	INIT_LIST_HEAD(&client->evt_list);
 	INIT_LIST_HEAD(&(client->mapped_buffer_list));
+	client->num_parked = 0;
 	file->private_data = client;
 
 	return 0;
@@ -1235,6 +1236,7 @@ static int npu_close(struct inode *inode, struct file *file)
 		kevent = list_first_entry(&client->evt_list,
 			struct npu_kevent, list);
 		list_del(&kevent->list);
+		kfree((void *)kevent->reserved[2]);
 		kfree(kevent);
 	}
 
@@ -1603,6 +1605,7 @@ static int npu_receive_event(struct npu_client *client,
 			pr_err("fail to copy to user\n");
 			ret = -EFAULT;
 		}
+		kfree((void *)kevt->reserved[2]);
 		kfree(kevt);
 	}
 	mutex_unlock(&client->list_lock);
@@ -231,7 +231,7 @@ static struct npu_ion_buf *npu_alloc_npu_ion_buffer(struct npu_client
 	mutex_lock(&client->list_lock);
 	list_for_each(pos, &(client->mapped_buffer_list)) {
 		tmp = list_entry(pos, struct npu_ion_buf, list);
-		if (tmp->fd == buf_hdl) {
+		if (!tmp->parked && tmp->fd == buf_hdl) {
 			ret_val = tmp;
 			break;
 		}
@@ -265,7 +265,7 @@ static struct npu_ion_buf *npu_get_npu_ion_buffer(struct npu_client
 	mutex_lock(&client->list_lock);
 	list_for_each(pos, &(client->mapped_buffer_list)) {
 		tmp = list_entry(pos, struct npu_ion_buf, list);
-		if (tmp->fd == buf_hdl) {
+		if (!tmp->parked && tmp->fd == buf_hdl) {
 			ret_val = tmp;
 			break;
 		}
@@ -275,22 +275,53 @@ static struct npu_ion_buf *npu_get_npu_ion_buffer(struct npu_client
 	return ret_val;
 }
 
-static void npu_free_npu_ion_buffer(struct npu_client
-	*client, int buf_hdl)
+/*
+ * Hand a parked mapping of @dma_buf back to the client under its new
+ * handle instead of mapping the buffer again.
+ */
+static struct npu_ion_buf *npu_unpark_npu_ion_buffer(struct npu_client
+	*client, struct dma_buf *dma_buf, int buf_hdl)
 {
-	struct list_head *pos = NULL;
-	struct npu_ion_buf *npu_ion_buf = NULL;
+	struct npu_ion_buf *ret_val = NULL, *tmp;
 
 	mutex_lock(&client->list_lock);
-	list_for_each(pos, &(client->mapped_buffer_list)) {
-		npu_ion_buf = list_entry(pos, struct npu_ion_buf, list);
-		if (npu_ion_buf->fd == buf_hdl) {
-			list_del(&npu_ion_buf->list);
-			kfree(npu_ion_buf);
+	list_for_each_entry(tmp, &client->mapped_buffer_list, list) {
+		if (tmp->parked && tmp->dma_buf == dma_buf) {
+			tmp->parked = false;
+			tmp->fd = buf_hdl;
+			client->num_parked--;
+			ret_val = tmp;
 			break;
 		}
 	}
 	mutex_unlock(&client->list_lock);
+
+	return ret_val;
+}
+
+static void npu_release_npu_ion_buffer(struct npu_client *client,
+	struct npu_ion_buf *ion_buf)
+{
+	struct npu_device *npu_dev = client->npu_dev;
+
+	if (ion_buf->table)
+		dma_buf_unmap_attachment(ion_buf->attachment, ion_buf->table,
+			DMA_BIDIRECTIONAL);
+	if (ion_buf->dma_buf && ion_buf->attachment)
+		dma_buf_detach(ion_buf->dma_buf, ion_buf->attachment);
+	if (ion_buf->dma_buf)
+		dma_buf_put(ion_buf->dma_buf);
+	npu_dev->smmu_ctx.attach_cnt--;
+
+	pr_debug("unmapped mem addr:0x%llx size:0x%x\n", ion_buf->iova,
+		ion_buf->size);
+
+	mutex_lock(&client->list_lock);
+	list_del(&ion_buf->list);
+	if (ion_buf->parked)
+		client->num_parked--;
+	mutex_unlock(&client->list_lock);
+	kfree(ion_buf);
 }
 
 int npu_mem_map(struct npu_client *client, int buf_hdl, uint32_t size,
@@ -300,10 +331,24 @@ int npu_mem_map(struct npu_client *client, int buf_hdl, uint32_t size,
 	struct npu_device *npu_dev = client->npu_dev;
 	struct npu_ion_buf *ion_buf = NULL;
 	struct npu_smmu_ctx *smmu_ctx = &npu_dev->smmu_ctx;
+	struct dma_buf *dma_buf;
 
 	if (buf_hdl == 0)
 		return -EINVAL;
 
+	dma_buf = dma_buf_get(buf_hdl);
+	if (!IS_ERR_OR_NULL(dma_buf)) {
+		ion_buf = npu_unpark_npu_ion_buffer(client, dma_buf, buf_hdl);
+		/* the parked mapping still holds its own reference */
+		dma_buf_put(dma_buf);
+		if (ion_buf) {
+			*addr = ion_buf->iova;
+			pr_debug("reused mem addr:0x%llx size:0x%x\n",
+				ion_buf->iova, ion_buf->size);
+			return 0;
+		}
+	}
+
 	ion_buf = npu_alloc_npu_ion_buffer(client, buf_hdl, size);
 	if (!ion_buf) {
 		pr_err("%s fail to alloc npu_ion_buffer\n", __func__);
@@ -374,7 +419,7 @@ bool npu_mem_verify_addr(struct npu_client *client, uint64_t addr)
 	mutex_lock(&client->list_lock);
 	list_for_each(pos, &(client->mapped_buffer_list)) {
 		ion_buf = list_entry(pos, struct npu_ion_buf, list);
-		if (ion_buf->iova == addr) {
+		if (!ion_buf->parked && ion_buf->iova == addr) {
 			valid = true;
 			break;
 		}
@@ -386,7 +431,6 @@ bool npu_mem_verify_addr(struct npu_client *client, uint64_t addr)
 
 void npu_mem_unmap(struct npu_client *client, int buf_hdl,  uint64_t addr)
 {
-	struct npu_device *npu_dev = client->npu_dev;
 	struct npu_ion_buf *ion_buf = 0;
 
 	/* clear entry and retrieve the corresponding buffer */
@@ -400,18 +444,60 @@ void npu_mem_unmap(struct npu_client *client, int buf_hdl,  uint64_t addr)
 		pr_warn("unmap address %llu doesn't match %llu\n", addr,
 			ion_buf->iova);
 
-	if (ion_buf->table)
-		dma_buf_unmap_attachment(ion_buf->attachment, ion_buf->table,
-			DMA_BIDIRECTIONAL);
-	if (ion_buf->dma_buf && ion_buf->attachment)
-		dma_buf_detach(ion_buf->dma_buf, ion_buf->attachment);
-	if (ion_buf->dma_buf)
-		dma_buf_put(ion_buf->dma_buf);
-	npu_dev->smmu_ctx.attach_cnt--;
+	npu_release_npu_ion_buffer(client, ion_buf);
+}
 
-	pr_debug("unmapped mem addr:0x%llx size:0x%x\n", ion_buf->iova,
-		ion_buf->size);
-	npu_free_npu_ion_buffer(client, buf_hdl);
+/*
+ * Client side unmap: keep the mapping around so the next map of the same
+ * dma_buf is free. The oldest parked buffer is released once the client
+ * has parked NPU_MAX_PARKED_BUFS of them.
+ */
+void npu_mem_park(struct npu_client *client, int buf_hdl, uint64_t addr)
+{
+	struct npu_ion_buf *ion_buf, *tmp, *oldest = NULL;
+
+	ion_buf = npu_get_npu_ion_buffer(client, buf_hdl);
+	if (!ion_buf) {
+		pr_err("%s could not find buffer\n", __func__);
+		return;
+	}
+
+	if (ion_buf->iova != addr)
+		pr_warn("unmap address %llu doesn't match %llu\n", addr,
+			ion_buf->iova);
+
+	mutex_lock(&client->list_lock);
+	if (client->num_parked >= NPU_MAX_PARKED_BUFS) {
+		list_for_each_entry(tmp, &client->mapped_buffer_list, list) {
+			if (tmp->parked) {
+				oldest = tmp;
+				break;
+			}
+		}
+	}
+	ion_buf->parked = true;
+	ion_buf->fd = -1;
+	client->num_parked++;
+	/* parked buffers sit at the tail in the order they were parked */
+	list_move_tail(&ion_buf->list, &client->mapped_buffer_list);
+	mutex_unlock(&client->list_lock);
+
+	if (oldest)
+		npu_release_npu_ion_buffer(client, oldest);
+}
+
+void npu_mem_unmap_all(struct npu_client *client)
+{
+	struct npu_ion_buf *ion_buf;
+
+	while (!list_empty(&client->mapped_buffer_list)) {
+		ion_buf = list_first_entry(&client->mapped_buffer_list,
+			struct npu_ion_buf, list);
+		if (!ion_buf->parked)
+			pr_warn("unmap buffer %x:%llx\n", ion_buf->fd,
+				ion_buf->iova);
+		npu_release_npu_ion_buffer(client, ion_buf);
+	}
 }
 
 /* -------------------------------------------------------------------------
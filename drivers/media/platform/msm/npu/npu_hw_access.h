@@ -63,6 +63,8 @@ uint32_t npu_qfprom_reg_read(struct npu_device *npu_dev, uint32_t off);
 int npu_mem_map(struct npu_client *client, int buf_hdl, uint32_t size,
 	uint64_t *addr);
 void npu_mem_unmap(struct npu_client *client, int buf_hdl, uint64_t addr);
+void npu_mem_park(struct npu_client *client, int buf_hdl, uint64_t addr);
+void npu_mem_unmap_all(struct npu_client *client);
 void npu_mem_invalidate(struct npu_client *client, int buf_hdl);
 bool npu_mem_verify_addr(struct npu_client *client, uint64_t addr);
 
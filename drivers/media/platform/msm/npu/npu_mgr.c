@@ -61,6 +61,9 @@ static int npu_notify_dsp(struct npu_device *npu_dev, bool pwr_up);
 static int npu_notify_aop(struct npu_device *npu_dev, bool on);
 static int update_dcvs_activity(struct npu_device *npu_dev, uint32_t activity);
 static void npu_destroy_wq(struct npu_host_ctx *host_ctx);
+static void npu_exec_dispatch(struct npu_device *npu_dev);
+static void npu_exec_flush(struct npu_host_ctx *host_ctx,
+	struct npu_network *network, bool notify);
 static struct workqueue_struct *npu_create_wq(struct npu_host_ctx *host_ctx,
 	const char *name);
 
@@ -298,6 +301,8 @@ int npu_host_init(struct npu_device *npu_dev)
 	mutex_init(&host_ctx->lock);
 	atomic_set(&host_ctx->ipc_trans_id, 1);
 	host_ctx->npu_dev = npu_dev;
+	INIT_LIST_HEAD(&host_ctx->exec_queue);
+	host_ctx->exec_inflight_max = NPU_EXEC_INFLIGHT_DEFAULT;
 
 	host_ctx->wq = npu_create_wq(host_ctx, "npu_wq");
 	if (!host_ctx->wq)
@@ -355,6 +360,8 @@ static int host_error_hdlr(struct npu_device *npu_dev, bool force)
 		&& !force)
 		return 0;
 
+	memset(&kevt, 0, sizeof(kevt));
+
 	if (host_ctx->wdg_irq_sts)
 		pr_info("watchdog irq triggered\n");
 
@@ -382,6 +389,7 @@ static int host_error_hdlr(struct npu_device *npu_dev, bool force)
 			}
 		}
 	}
+	npu_exec_flush(host_ctx, NULL, true);
 	complete_all(&host_ctx->loopback_done);
 	mutex_unlock(&host_ctx->lock);
 
@@ -828,8 +836,23 @@ static void app_msg_proc(struct npu_host_ctx *host_ctx, uint32_t *msg)
 			kevt.evt.u.exec_v2_done.stats_buf_size = stats_size;
 			kevt.reserved[0] = (uint64_t)network->stats_buf;
 			kevt.reserved[1] = (uint64_t)network->stats_buf_u;
-			if (npu_queue_event(network->client, &kevt))
+			/*
+			 * the next queued execution reuses stats_buf before
+			 * this event is read, hand the event its own copy
+			 */
+			if (network->exec_queued && stats_size) {
+				void *stats = kmemdup(network->stats_buf,
+					stats_size, GFP_KERNEL);
+
+				if (stats) {
+					kevt.reserved[0] = (uint64_t)stats;
+					kevt.reserved[2] = (uint64_t)stats;
+				}
+			}
+			if (npu_queue_event(network->client, &kevt)) {
 				pr_err("queue npu event failed\n");
+				kfree((void *)kevt.reserved[2]);
+			}
 		} else {
 			complete(&network->cmd_done);
 		}
@@ -1022,6 +1045,9 @@ static void host_session_msg_hdlr(struct npu_device *npu_dev)
 		app_msg_proc(host_ctx, msg);
 	}
 
+	/* completions free up networks and slots for queued executions */
+	npu_exec_dispatch(npu_dev);
+
 skip_read_msg:
 	mutex_unlock(&host_ctx->lock);
 	kfree(msg);
@@ -1117,7 +1143,7 @@ int32_t npu_host_unmap_buf(struct npu_client *client,
 		pr_warn("npu: wait for fw_deinit_done time out\n");
 
 	mutex_lock(&host_ctx->lock);
-	npu_mem_unmap(client, unmap_ioctl->buf_ion_hdl,
+	npu_mem_park(client, unmap_ioctl->buf_ion_hdl,
 		unmap_ioctl->npu_phys_addr);
 	mutex_unlock(&host_ctx->lock);
 	return 0;
@@ -1218,7 +1244,7 @@ static void host_copy_patch_data_v2(struct npu_patch_tuple_v2 *param,
 static uint32_t find_networks_perf_mode(struct npu_host_ctx *host_ctx)
 {
 	struct npu_network *network;
-	uint32_t max_perf_mode = 0;
+	uint32_t max_perf_mode = 0, busy_perf_mode = 0;
 	int i = 0;
 
 	network = host_ctx->networks;
@@ -1227,14 +1253,25 @@ static uint32_t find_networks_perf_mode(struct npu_host_ctx *host_ctx)
 		/* if no network exists, set to the lowest level */
 		max_perf_mode = 1;
 	} else {
-		/* find the max level among all the networks */
+		/*
+		 * find the max level among all the networks, or among the
+		 * ones running or queued if there are any, so idle loaded
+		 * networks don't hold the level up
+		 */
 		for (i = 0; i < MAX_LOADED_NETWORK; i++) {
 			if ((network->id != 0) &&
-				(network->cur_perf_mode != 0) &&
-				(network->cur_perf_mode > max_perf_mode))
-				max_perf_mode = network->cur_perf_mode;
+				(network->cur_perf_mode != 0)) {
+				max_perf_mode = max(max_perf_mode,
+					network->cur_perf_mode);
+				if (network->cmd_pending ||
+					network->exec_queued)
+					busy_perf_mode = max(busy_perf_mode,
+						network->cur_perf_mode);
+			}
 			network++;
 		}
+		if (busy_perf_mode)
+			max_perf_mode = busy_perf_mode;
 	}
 	pr_debug("max perf mode for networks: %d\n", max_perf_mode);
 
@@ -1248,6 +1285,7 @@ static int set_perf_mode(struct npu_device *npu_dev)
 	struct npu_host_ctx *host_ctx = &npu_dev->host_ctx;
 
 	networks_perf_mode = find_networks_perf_mode(host_ctx);
+	host_ctx->networks_perf_mode = networks_perf_mode;
 
 	if (npu_dev->pwrctrl.perf_mode_override)
 		networks_perf_mode = npu_dev->pwrctrl.perf_mode_override;
@@ -1668,6 +1706,9 @@ int32_t npu_host_unload_network(struct npu_client *client,
 		return -EINVAL;
 	}
 
+	/* executions still queued on the host never reach the fw */
+	npu_exec_flush(host_ctx, network, false);
+
 	if (network->fw_error) {
 		pr_err("fw in error state, skip unload network in fw\n");
 		goto free_network;
@@ -1882,6 +1923,150 @@ int32_t npu_host_exec_network(struct npu_client *client,
 	return ret;
 }
 
+static uint32_t npu_exec_inflight(struct npu_host_ctx *host_ctx)
+{
+	uint32_t i, inflight = 0;
+
+	for (i = 0; i < MAX_LOADED_NETWORK; i++)
+		if (host_ctx->networks[i].is_valid &&
+			host_ctx->networks[i].cmd_pending)
+			inflight++;
+
+	return inflight;
+}
+
+static void npu_exec_free(struct npu_exec_cmd *cmd)
+{
+	cmd->network->exec_queued--;
+	network_put(cmd->network);
+	kfree(cmd->pkt);
+	kfree(cmd);
+}
+
+/*
+ * Send queued executions, highest priority first, to every network that
+ * is idle while the fw has fewer than exec_inflight_max executions.
+ * Called with host_ctx->lock held.
+ */
+static void npu_exec_dispatch(struct npu_device *npu_dev)
+{
+	struct npu_host_ctx *host_ctx = &npu_dev->host_ctx;
+	struct npu_exec_cmd *cmd, *tmp;
+	struct npu_network *network;
+	struct npu_kevent kevt;
+	uint32_t inflight;
+	int ret;
+
+	if (list_empty(&host_ctx->exec_queue))
+		goto update_perf;
+
+	inflight = npu_exec_inflight(host_ctx);
+	list_for_each_entry_safe(cmd, tmp, &host_ctx->exec_queue, list) {
+		if (host_ctx->exec_inflight_max &&
+			(inflight >= host_ctx->exec_inflight_max))
+			break;
+
+		network = cmd->network;
+		if (network->cmd_pending)
+			continue;
+
+		list_del(&cmd->list);
+		cmd->pkt->header.trans_id =
+			atomic_add_return(1, &host_ctx->ipc_trans_id);
+		network->stats_buf_u = cmd->stats_buf_u;
+		network->stats_buf_size = cmd->stats_buf_size;
+		ret = npu_send_network_cmd(npu_dev, network, cmd->pkt, true);
+		if (ret) {
+			pr_err("queued NPU_IPC_CMD_EXECUTE_V2 failed: %d\n",
+				ret);
+			memset(&kevt, 0, sizeof(kevt));
+			kevt.evt.type = MSM_NPU_EVENT_TYPE_EXEC_V2_DONE;
+			kevt.evt.u.exec_v2_done.network_hdl =
+				network->network_hdl;
+			kevt.evt.u.exec_v2_done.exec_result = ret;
+			if (npu_queue_event(network->client, &kevt))
+				pr_err("queue npu event failed\n");
+		} else {
+			inflight++;
+		}
+		npu_exec_free(cmd);
+	}
+
+update_perf:
+	if (host_ctx->fw_state == FW_ENABLED &&
+		find_networks_perf_mode(host_ctx) !=
+		host_ctx->networks_perf_mode)
+		set_perf_mode(npu_dev);
+}
+
+/*
+ * Drop queued executions of @network, or all of them when it is NULL,
+ * telling the client through an SSR event if @notify is set.
+ * Called with host_ctx->lock held.
+ */
+static void npu_exec_flush(struct npu_host_ctx *host_ctx,
+	struct npu_network *network, bool notify)
+{
+	struct npu_exec_cmd *cmd, *tmp;
+	struct npu_kevent kevt;
+
+	list_for_each_entry_safe(cmd, tmp, &host_ctx->exec_queue, list) {
+		if (network && (cmd->network != network))
+			continue;
+
+		list_del(&cmd->list);
+		if (notify) {
+			memset(&kevt, 0, sizeof(kevt));
+			kevt.evt.type = MSM_NPU_EVENT_TYPE_SSR;
+			kevt.evt.u.ssr.network_hdl =
+				cmd->network->network_hdl;
+			if (npu_queue_event(cmd->network->client, &kevt))
+				pr_err("queue npu event failed\n");
+		}
+		npu_exec_free(cmd);
+	}
+}
+
+/*
+ * Queue an async execution instead of failing it while the network is
+ * still running the previous one. The queue owns @pkt on success.
+ */
+static int npu_exec_queue(struct npu_device *npu_dev,
+	struct npu_network *network, struct ipc_cmd_execute_pkt_v2 *pkt,
+	struct msm_npu_exec_network_ioctl_v2 *exec_ioctl)
+{
+	struct npu_host_ctx *host_ctx = &npu_dev->host_ctx;
+	struct npu_exec_cmd *cmd, *pos;
+
+	if (network->fw_error || host_ctx->fw_error ||
+		(host_ctx->fw_state == FW_DISABLED))
+		return -EIO;
+
+	if (network->exec_queued >= NPU_EXEC_QUEUE_DEPTH)
+		return -EBUSY;
+
+	cmd = kzalloc(sizeof(*cmd), GFP_KERNEL);
+	if (!cmd)
+		return -ENOMEM;
+
+	cmd->network = network;
+	cmd->pkt = pkt;
+	cmd->stats_buf_u = (void __user *)exec_ioctl->stats_buf_addr;
+	cmd->stats_buf_size = exec_ioctl->stats_buf_size;
+	network_get(network);
+	network->exec_queued++;
+
+	/* higher priority first, submission order within a priority */
+	list_for_each_entry(pos, &host_ctx->exec_queue, list)
+		if (pos->network->priority < network->priority)
+			break;
+	list_add_tail(&cmd->list, &pos->list);
+
+	npu_exec_dispatch(npu_dev);
+
+	return 0;
+}
+
 int32_t npu_host_exec_network_v2(struct npu_client *client,
 	struct msm_npu_exec_network_ioctl_v2 *exec_ioctl,
 	struct msm_npu_patch_buf_info *patch_buf_info)
@@ -1957,12 +2142,21 @@ int32_t npu_host_exec_network_v2(struct npu_client *client,
 	exec_packet->network_hdl = network->network_hdl;
 	exec_packet->num_patch_params = num_patch_params;
 
-	network->stats_buf_u = (void __user *)exec_ioctl->stats_buf_addr;
-	network->stats_buf_size = exec_ioctl->stats_buf_size;
-
 	pr_debug("Execute_v2 flags %x stats_buf_size %d\n",
 		exec_packet->header.flags, exec_ioctl->stats_buf_size);
 
+	if (async_ioctl) {
+		ret = npu_exec_queue(npu_dev, network, exec_packet,
+			exec_ioctl);
+		if (ret) {
+			pr_err("NPU_IPC_CMD_EXECUTE_V2 queue failed: %d\n",
+				ret);
+			goto free_exec_packet;
+		}
+		pr_debug("Async ioctl, return now\n");
+		goto exec_v2_done;
+	}
+
 	/* Send it on the high priority queue */
 	reinit_completion(&network->cmd_done);
 	ret = npu_send_network_cmd(npu_dev, network, exec_packet, async_ioctl);
@@ -1972,10 +2166,9 @@ int32_t npu_host_exec_network_v2(struct npu_client *client,
 		goto free_exec_packet;
 	}
 
-	if (async_ioctl) {
-		pr_debug("Async ioctl, return now\n");
-		goto free_exec_packet;
-	}
+	/* the response is handled under host_ctx->lock, still held here */
+	network->stats_buf_u = (void __user *)exec_ioctl->stats_buf_addr;
+	network->stats_buf_size = exec_ioctl->stats_buf_size;
 
 	mutex_unlock(&host_ctx->lock);
 
@@ -2084,9 +2277,7 @@ void npu_host_cleanup_networks(struct npu_client *client)
 	struct npu_device *npu_dev = client->npu_dev;
 	struct npu_host_ctx *host_ctx = &npu_dev->host_ctx;
 	struct msm_npu_unload_network_ioctl unload_req;
-	struct msm_npu_unmap_buf_ioctl unmap_req;
 	struct npu_network *network;
-	struct npu_ion_buf *ion_buf;
 
 	for (i = 0; i < MAX_LOADED_NETWORK; i++) {
 		network = &host_ctx->networks[i];
@@ -2098,15 +2289,18 @@ void npu_host_cleanup_networks(struct npu_client *client)
 		}
 	}
 
-	/* unmap all remaining buffers */
-	while (!list_empty(&client->mapped_buffer_list)) {
-		ion_buf = list_first_entry(&client->mapped_buffer_list,
-			struct npu_ion_buf, list);
-		pr_warn("unmap buffer %x:%llx\n", ion_buf->fd, ion_buf->iova);
-		unmap_req.buf_ion_hdl = ion_buf->fd;
-		unmap_req.npu_phys_addr = ion_buf->iova;
-		npu_host_unmap_buf(client, &unmap_req);
-	}
+	if (list_empty(&client->mapped_buffer_list))
+		return;
+
+	if (host_ctx->fw_error && (host_ctx->fw_state == FW_ENABLED) &&
+		!wait_for_completion_timeout(
+		&host_ctx->fw_deinit_done, NW_CMD_TIMEOUT))
+		pr_warn("npu: wait for fw_deinit_done time out\n");
+
+	/* unmap all remaining buffers, parked ones included */
+	mutex_lock(&host_ctx->lock);
+	npu_mem_unmap_all(client);
+	mutex_unlock(&host_ctx->lock);
 }
 
 /*
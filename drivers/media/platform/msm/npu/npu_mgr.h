@@ -25,6 +25,10 @@
 #define FIRMWARE_VERSION 0x00001000
 #define MAX_LOADED_NETWORK 32
 #define NPU_IPC_BUF_LENGTH 512
+/* async executions a network can have waiting behind the running one */
+#define NPU_EXEC_QUEUE_DEPTH 8
+/* executions in flight in the firmware before the host queue holds back */
+#define NPU_EXEC_INFLIGHT_DEFAULT 2
 
 #define FW_DBG_MODE_PAUSE        (1 << 0)
 #define FW_DBG_MODE_INC_TIMEOUT  (1 << 1)
@@ -58,6 +62,19 @@ struct npu_network {
 	int cmd_ret_status;
 	struct completion cmd_done;
 	struct npu_client *client;
+	uint32_t exec_queued;
+};
+
+/*
+ * Async execute_v2 waiting on the host for its network to go idle or
+ * for an execution slot, ordered by network priority
+ */
+struct npu_exec_cmd {
+	struct list_head list;
+	struct npu_network *network;
+	struct ipc_cmd_execute_pkt_v2 *pkt;
+	void __user *stats_buf_u;
+	uint32_t stats_buf_size;
 };
 
 enum fw_state {
@@ -90,6 +107,9 @@ struct npu_host_ctx {
 	atomic_t ipc_trans_id;
 	atomic_t network_execute_cnt;
 	int cmd_ret_status;
+	struct list_head exec_queue;
+	uint32_t exec_inflight_max;
+	uint32_t networks_perf_mode;
 
 	uint32_t err_irq_sts;
 	uint32_t wdg_irq_sts;
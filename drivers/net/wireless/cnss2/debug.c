@@ -158,6 +158,55 @@ static const struct file_operations cnss_stats_fops = {
 	.llseek		= seq_lseek,
 };
 
+static ssize_t cnss_link_policy_write(struct file *fp,
+				      const char __user *user_buf,
+				      size_t count, loff_t *off)
+{
+	struct cnss_plat_data *plat_priv =
+		((struct seq_file *)fp->private_data)->private;
+	struct cnss_pci_data *pci_priv = plat_priv->bus_priv;
+	bool enable;
+	int ret;
+
+	if (!pci_priv)
+		return -ENODEV;
+
+	ret = kstrtobool_from_user(user_buf, count, &enable);
+	if (ret)
+		return ret;
+
+	cnss_pci_link_policy_enable(pci_priv, enable);
+
+	return count;
+}
+
+static int cnss_link_policy_show(struct seq_file *s, void *data)
+{
+	struct cnss_plat_data *plat_priv = s->private;
+	struct cnss_pci_data *pci_priv = plat_priv->bus_priv;
+
+	if (!pci_priv)
+		return -ENODEV;
+
+	cnss_pci_link_policy_show(s, pci_priv);
+
+	return 0;
+}
+
+static int cnss_link_policy_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cnss_link_policy_show, inode->i_private);
+}
+
+static const struct file_operations cnss_link_policy_fops = {
+	.read		= seq_read,
+	.write		= cnss_link_policy_write,
+	.release	= single_release,
+	.open		= cnss_link_policy_open,
+	.owner		= THIS_MODULE,
+	.llseek		= seq_lseek,
+};
+
 static ssize_t cnss_dev_boot_debug_write(struct file *fp,
 					 const char __user *user_buf,
 					 size_t count, loff_t *off)
@@ -852,6 +901,8 @@ int cnss_debugfs_create(struct cnss_plat_data *plat_priv)
 			    &cnss_pin_connect_fops);
 	debugfs_create_file("stats", 0644, root_dentry, plat_priv,
 			    &cnss_stats_fops);
+	debugfs_create_file("link_policy", 0644, root_dentry, plat_priv,
+			    &cnss_link_policy_fops);
 
 	cnss_create_debug_only_node(plat_priv);
 
@@ -187,6 +187,7 @@ struct cnss_bus_bw_info {
  * @list_head: List of interconnect path bandwidth configs
  * @path_count: Count of interconnect path configured in device tree
  * @current_bw_vote: WLAN driver provided bandwidth vote
+ * @policy_bw_vote: Bandwidth floor chosen by the PCIe link policy engine
  * @bus_bw_cfg_count: Number of bandwidth configs for voting. It is the array
  *                    size of struct cnss_bus_bw_info.cfg_table
  */
@@ -194,6 +195,7 @@ struct cnss_interconnect_cfg {
 	struct list_head list_head;
 	u32 path_count;
 	int current_bw_vote;
+	u32 policy_bw_vote;
 	u32 bus_bw_cfg_count;
 };
 
@@ -844,6 +844,11 @@ static int cnss_setup_bus_bandwidth(struct cnss_plat_data *plat_priv,
 	if (!plat_priv->icc.path_count)
 		return -EOPNOTSUPP;
 
+	/* Link policy engine only raises votes of a powered up device */
+	if (bw != CNSS_BUS_WIDTH_NONE && plat_priv->icc.policy_bw_vote > bw)
+		bw = min(plat_priv->icc.policy_bw_vote,
+			 plat_priv->icc.bus_bw_cfg_count - 1);
+
 	if (bw >= plat_priv->icc.bus_bw_cfg_count) {
 		cnss_pr_err("Invalid bus bandwidth Type: %d", bw);
 		return -EINVAL;
@@ -1299,6 +1304,382 @@ void cnss_pci_allow_l1(struct device *dev)
 }
 EXPORT_SYMBOL(cnss_pci_allow_l1);
 
+/* Throughput thresholds between link policy levels, in kbps */
+#define CNSS_LINK_LOW_KBPS		1000
+#define CNSS_LINK_MEDIUM_KBPS		50000
+#define CNSS_LINK_HIGH_KBPS		400000
+#define CNSS_LINK_LATENCY_HOLD_MS	2000
+#define CNSS_LINK_DOWN_SAMPLES		3
+#define CNSS_LINK_MIN_SAMPLE_US		1000
+
+/**
+ * struct cnss_link_level_cfg - Link and bus state of a link policy level
+ * @name: Level name for debugfs
+ * @link_status: PCIe link gen and width
+ * @prevent_l1: Keep PCIe link out of L1 and L1 sub-states
+ * @bus_bw: Interconnect bandwidth floor, enum cnss_bus_width_type
+ */
+struct cnss_link_level_cfg {
+	const char *name;
+	enum pci_link_status link_status;
+	bool prevent_l1;
+	u32 bus_bw;
+};
+
+static const struct cnss_link_level_cfg cnss_link_levels[] = {
+	[CNSS_LINK_LEVEL_IDLE] = {
+		"idle", PCI_GEN1, false, CNSS_BUS_WIDTH_IDLE },
+	[CNSS_LINK_LEVEL_LOW] = {
+		"low", PCI_GEN1, false, CNSS_BUS_WIDTH_LOW },
+	[CNSS_LINK_LEVEL_MEDIUM] = {
+		"medium", PCI_GEN2, false, CNSS_BUS_WIDTH_MEDIUM },
+	[CNSS_LINK_LEVEL_HIGH] = {
+		"high", PCI_DEF, false, CNSS_BUS_WIDTH_HIGH },
+	[CNSS_LINK_LEVEL_LOW_LATENCY] = {
+		"low_latency", PCI_DEF, true, CNSS_BUS_WIDTH_LOW_LATENCY },
+};
+
+static enum cnss_link_level cnss_link_level_for_kbps(u64 kbps)
+{
+	if (kbps >= CNSS_LINK_HIGH_KBPS)
+		return CNSS_LINK_LEVEL_HIGH;
+	if (kbps >= CNSS_LINK_MEDIUM_KBPS)
+		return CNSS_LINK_LEVEL_MEDIUM;
+	if (kbps >= CNSS_LINK_LOW_KBPS)
+		return CNSS_LINK_LEVEL_LOW;
+	return CNSS_LINK_LEVEL_IDLE;
+}
+
+/* Never ask for a reduced link speed the link could not train down to. */
+static enum pci_link_status
+cnss_link_policy_status(struct cnss_pci_data *pci_priv,
+			enum pci_link_status status)
+{
+	switch (status) {
+	case PCI_GEN1:
+		if (pci_priv->def_link_speed <= PCI_EXP_LNKSTA_CLS_2_5GB)
+			return PCI_DEF;
+		break;
+	case PCI_GEN2:
+		if (pci_priv->def_link_speed <= PCI_EXP_LNKSTA_CLS_5_0GB)
+			return PCI_DEF;
+		break;
+	default:
+		break;
+	}
+
+	return status;
+}
+
+static void cnss_link_policy_account(struct cnss_link_policy *policy,
+				     ktime_t now)
+{
+	if (policy->cur < CNSS_LINK_LEVEL_MAX)
+		policy->residency_ms[policy->cur] +=
+			ktime_ms_delta(now, policy->since);
+	policy->since = now;
+}
+
+static void cnss_link_policy_release(struct cnss_pci_data *pci_priv)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+	struct cnss_plat_data *plat_priv = pci_priv->plat_priv;
+
+	if (policy->l1_prevented) {
+		_cnss_pci_allow_l1(pci_priv);
+		policy->l1_prevented = false;
+	}
+
+	if (policy->link_status != -1 && policy->link_status != PCI_DEF &&
+	    pci_priv->def_link_speed)
+		cnss_set_pci_link_status(pci_priv, PCI_DEF);
+	policy->link_status = -1;
+
+	if (plat_priv->icc.policy_bw_vote) {
+		plat_priv->icc.policy_bw_vote = 0;
+		cnss_setup_bus_bandwidth(plat_priv,
+					 plat_priv->icc.current_bw_vote, false);
+	}
+
+	cnss_link_policy_account(policy, ktime_get());
+	policy->cur = CNSS_LINK_LEVEL_MAX;
+}
+
+static void cnss_link_policy_work(struct work_struct *work)
+{
+	struct cnss_link_policy *policy =
+		container_of(work, struct cnss_link_policy, work);
+	struct cnss_pci_data *pci_priv =
+		container_of(policy, struct cnss_pci_data, link_policy);
+	struct cnss_plat_data *plat_priv = pci_priv->plat_priv;
+	const struct cnss_link_level_cfg *cfg;
+	enum cnss_link_level level;
+	enum pci_link_status status;
+	unsigned long flags;
+	ktime_t decided, now;
+	bool enabled;
+	s64 latency;
+	int ret;
+
+	spin_lock_irqsave(&policy->lock, flags);
+	enabled = policy->enabled;
+	level = policy->target;
+	decided = policy->decided;
+	spin_unlock_irqrestore(&policy->lock, flags);
+
+	mutex_lock(&pci_priv->bus_lock);
+	if (pci_priv->pci_link_state == PCI_LINK_DOWN ||
+	    pci_priv->pci_link_down_ind)
+		goto unlock;
+
+	if (!enabled) {
+		cnss_link_policy_release(pci_priv);
+		goto unlock;
+	}
+
+	if (level == policy->cur)
+		goto unlock;
+
+	cfg = &cnss_link_levels[level];
+
+	if (cfg->prevent_l1 && !policy->l1_prevented) {
+		ret = _cnss_pci_prevent_l1(pci_priv);
+		if (ret)
+			policy->failures++;
+		else
+			policy->l1_prevented = true;
+	} else if (!cfg->prevent_l1 && policy->l1_prevented) {
+		_cnss_pci_allow_l1(pci_priv);
+		policy->l1_prevented = false;
+	}
+
+	status = cnss_link_policy_status(pci_priv, cfg->link_status);
+	if (pci_priv->def_link_speed && status != policy->link_status) {
+		ret = cnss_set_pci_link_status(pci_priv, status);
+		if (ret) {
+			policy->failures++;
+			policy->link_status = -1;
+		} else {
+			policy->link_status = status;
+		}
+	}
+
+	if (plat_priv->icc.policy_bw_vote != cfg->bus_bw) {
+		plat_priv->icc.policy_bw_vote = cfg->bus_bw;
+		ret = cnss_setup_bus_bandwidth(plat_priv,
+					       plat_priv->icc.current_bw_vote,
+					       false);
+		if (ret && ret != -EOPNOTSUPP)
+			policy->failures++;
+	}
+
+	now = ktime_get();
+	if (policy->cur == CNSS_LINK_LEVEL_MAX || level > policy->cur) {
+		latency = ktime_us_delta(now, decided);
+		policy->wake_count++;
+		policy->wake_total_us += latency;
+		policy->wake_max_us = max_t(u64, policy->wake_max_us, latency);
+	}
+
+	cnss_link_policy_account(policy, now);
+	policy->transitions[level]++;
+	policy->cur = level;
+	cnss_pr_vdbg("PCIe link policy level: %s\n", cfg->name);
+
+unlock:
+	mutex_unlock(&pci_priv->bus_lock);
+}
+
+/**
+ * cnss_pci_report_traffic() - Feed traffic to the PCIe link policy engine
+ * @dev: PCI device
+ * @tx_bytes: Total bytes transmitted since WLAN driver start
+ * @rx_bytes: Total bytes received since WLAN driver start
+ * @low_latency: Latency sensitive traffic was seen since the last report
+ *
+ * The WLAN host driver is expected to call this periodically, e.g. from its
+ * bus bandwidth timer. Throughput is predicted from the history of reports;
+ * the link gen and width, L1 allowance and interconnect bandwidth follow the
+ * prediction together. Rising demand is applied at once, falling demand only
+ * after CNSS_LINK_DOWN_SAMPLES consecutive reports. Latency sensitive traffic
+ * keeps the link out of L1 at full speed for CNSS_LINK_LATENCY_HOLD_MS.
+ *
+ * May be called from atomic context.
+ *
+ * Return: 0 for success, negative value for error
+ */
+int cnss_pci_report_traffic(struct device *dev, u64 tx_bytes, u64 rx_bytes,
+			    bool low_latency)
+{
+	struct pci_dev *pci_dev = to_pci_dev(dev);
+	struct cnss_pci_data *pci_priv = cnss_get_pci_priv(pci_dev);
+	struct cnss_link_policy *policy;
+	enum cnss_link_level level;
+	u64 bytes = tx_bytes + rx_bytes, kbps, trend;
+	unsigned long flags;
+	ktime_t now;
+	s64 delta_us;
+	bool queue = false;
+
+	if (!pci_priv)
+		return -ENODEV;
+
+	policy = &pci_priv->link_policy;
+	now = ktime_get();
+
+	spin_lock_irqsave(&policy->lock, flags);
+	if (!policy->enabled)
+		goto unlock;
+
+	if (low_latency)
+		policy->latency_until = jiffies +
+			msecs_to_jiffies(CNSS_LINK_LATENCY_HOLD_MS);
+
+	delta_us = ktime_us_delta(now, policy->last_sample);
+	if (!policy->last_sample || bytes < policy->last_bytes) {
+		policy->last_sample = now;
+		policy->last_bytes = bytes;
+		goto unlock;
+	}
+	if (delta_us < CNSS_LINK_MIN_SAMPLE_US && !low_latency)
+		goto unlock;
+
+	kbps = div64_u64((bytes - policy->last_bytes) * 8000,
+			 max_t(s64, delta_us, 1));
+	policy->last_sample = now;
+	policy->last_bytes = bytes;
+
+	if (kbps > policy->ewma_kbps)
+		policy->ewma_kbps = kbps;
+	else
+		policy->ewma_kbps = (policy->ewma_kbps * 7 + kbps) >> 3;
+
+	/* Extrapolate one report ahead while throughput is ramping up */
+	trend = kbps > policy->last_kbps ? kbps - policy->last_kbps : 0;
+	policy->last_kbps = kbps;
+	policy->pred_kbps = policy->ewma_kbps + trend;
+
+	if (time_before(jiffies, policy->latency_until))
+		level = CNSS_LINK_LEVEL_LOW_LATENCY;
+	else
+		level = cnss_link_level_for_kbps(policy->pred_kbps);
+
+	if (level > policy->target) {
+		policy->target = level;
+		policy->decided = now;
+		policy->below_count = 0;
+		queue = true;
+	} else if (level < policy->target) {
+		if (++policy->below_count >= CNSS_LINK_DOWN_SAMPLES) {
+			policy->target = level;
+			policy->below_count = 0;
+			queue = true;
+		}
+	} else {
+		policy->below_count = 0;
+		/* Re-apply after the link was suspended */
+		queue = READ_ONCE(policy->cur) == CNSS_LINK_LEVEL_MAX;
+		if (queue)
+			policy->decided = now;
+	}
+
+unlock:
+	spin_unlock_irqrestore(&policy->lock, flags);
+
+	if (queue)
+		queue_work(system_highpri_wq, &policy->work);
+
+	return 0;
+}
+EXPORT_SYMBOL(cnss_pci_report_traffic);
+
+void cnss_pci_link_policy_enable(struct cnss_pci_data *pci_priv, bool enable)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+	unsigned long flags;
+
+	spin_lock_irqsave(&policy->lock, flags);
+	policy->enabled = enable;
+	policy->last_sample = 0;
+	policy->ewma_kbps = 0;
+	policy->last_kbps = 0;
+	policy->below_count = 0;
+	spin_unlock_irqrestore(&policy->lock, flags);
+
+	queue_work(system_highpri_wq, &policy->work);
+}
+
+void cnss_pci_link_policy_show(struct seq_file *s,
+			       struct cnss_pci_data *pci_priv)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+	int i;
+
+	mutex_lock(&pci_priv->bus_lock);
+	cnss_link_policy_account(policy, ktime_get());
+	seq_printf(s, "enabled: %d\n", policy->enabled);
+	seq_printf(s, "level: %s\n", policy->cur < CNSS_LINK_LEVEL_MAX ?
+		   cnss_link_levels[policy->cur].name : "none");
+	seq_printf(s, "predicted_kbps: %llu, average_kbps: %llu\n",
+		   policy->pred_kbps, policy->ewma_kbps);
+	seq_printf(s, "l1_prevented: %d, bus_bw_vote: %u, failures: %u\n",
+		   policy->l1_prevented, pci_priv->plat_priv->icc.policy_bw_vote,
+		   policy->failures);
+	seq_printf(s, "wake latency: count %u, avg %llu us, max %llu us\n",
+		   policy->wake_count,
+		   policy->wake_count ?
+		   div_u64(policy->wake_total_us, policy->wake_count) : 0,
+		   policy->wake_max_us);
+	for (i = 0; i < CNSS_LINK_LEVEL_MAX; i++)
+		seq_printf(s, "%-12s transitions: %u, residency: %llu ms\n",
+			   cnss_link_levels[i].name, policy->transitions[i],
+			   policy->residency_ms[i]);
+	mutex_unlock(&pci_priv->bus_lock);
+}
+
+static void cnss_pci_link_policy_init(struct cnss_pci_data *pci_priv)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+
+	spin_lock_init(&policy->lock);
+	INIT_WORK(&policy->work, cnss_link_policy_work);
+	policy->enabled = true;
+	policy->target = CNSS_LINK_LEVEL_IDLE;
+	policy->cur = CNSS_LINK_LEVEL_MAX;
+	policy->link_status = -1;
+}
+
+static void cnss_pci_link_policy_deinit(struct cnss_pci_data *pci_priv)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+	unsigned long flags;
+
+	spin_lock_irqsave(&policy->lock, flags);
+	policy->enabled = false;
+	spin_unlock_irqrestore(&policy->lock, flags);
+
+	cancel_work_sync(&policy->work);
+	mutex_lock(&pci_priv->bus_lock);
+	if (pci_priv->pci_link_state == PCI_LINK_UP &&
+	    !pci_priv->pci_link_down_ind)
+		cnss_link_policy_release(pci_priv);
+	mutex_unlock(&pci_priv->bus_lock);
+}
+
+/* Link state is lost over suspend: drop the L1 vote, re-apply on resume. */
+static void cnss_pci_link_policy_suspend(struct cnss_pci_data *pci_priv)
+{
+	struct cnss_link_policy *policy = &pci_priv->link_policy;
+
+	if (policy->l1_prevented) {
+		_cnss_pci_allow_l1(pci_priv);
+		policy->l1_prevented = false;
+	}
+	policy->link_status = -1;
+	cnss_link_policy_account(policy, ktime_get());
+	WRITE_ONCE(policy->cur, CNSS_LINK_LEVEL_MAX);
+}
+
 static void cnss_pci_update_link_event(struct cnss_pci_data *pci_priv,
 				       enum cnss_bus_event_type type,
 				       void *data)
@@ -3229,6 +3610,8 @@ int cnss_pci_suspend_bus(struct cnss_pci_data *pci_priv)
 		goto out;
 	}
 
+	cnss_pci_link_policy_suspend(pci_priv);
+
 	if (pci_priv->drv_connected_last)
 		goto skip_disable_pci;
 
@@ -5883,6 +6266,7 @@ static int cnss_pci_probe(struct pci_dev *pci_dev,
 	plat_priv->device_id = pci_dev->device;
 	plat_priv->bus_priv = pci_priv;
 	mutex_init(&pci_priv->bus_lock);
+	cnss_pci_link_policy_init(pci_priv);
 	if (plat_priv->use_pm_domain)
 		dev->pm_domain = &cnss_pm_domain;
 
@@ -5996,6 +6380,7 @@ static void cnss_pci_remove(struct pci_dev *pci_dev)
 	struct cnss_plat_data *plat_priv =
 		cnss_bus_dev_to_plat_priv(&pci_dev->dev);
 
+	cnss_pci_link_policy_deinit(pci_priv);
 	cnss_pci_free_m3_mem(pci_priv);
 	cnss_pci_free_fw_mem(pci_priv);
 	cnss_pci_free_qdss_mem(pci_priv);
@@ -10,6 +10,7 @@
 #include <linux/msm_pcie.h>
 #endif
 #include <linux/pci.h>
+#include <linux/seq_file.h>
 
 #include "main.h"
 
@@ -83,6 +84,65 @@ struct cnss_pm_stats {
 	u64 runtime_put_timestamp_id[RTPM_ID_MAX];
 };
 
+enum cnss_link_level {
+	CNSS_LINK_LEVEL_IDLE,
+	CNSS_LINK_LEVEL_LOW,
+	CNSS_LINK_LEVEL_MEDIUM,
+	CNSS_LINK_LEVEL_HIGH,
+	CNSS_LINK_LEVEL_LOW_LATENCY,
+	CNSS_LINK_LEVEL_MAX,
+};
+
+/**
+ * struct cnss_link_policy - PCIe link and bus bandwidth policy state
+ * @lock: Protects the prediction state against concurrent reports
+ * @work: Applies @target to the link and the interconnect
+ * @enabled: Policy engine is in control of link state
+ * @last_sample: Time of the previous traffic report
+ * @last_bytes: Byte count of the previous traffic report
+ * @last_kbps: Throughput measured at the previous report
+ * @ewma_kbps: Smoothed throughput, rising instantly and decaying slowly
+ * @pred_kbps: Throughput predicted for the next report
+ * @latency_until: Low latency level is held until this time (jiffies)
+ * @below_count: Consecutive reports predicting a level below @target
+ * @target: Level chosen by the predictor
+ * @decided: Time @target was last raised
+ * @cur: Level applied by @work, CNSS_LINK_LEVEL_MAX if not applied
+ * @link_status: PCIe link status applied by @work, -1 if unknown
+ * @l1_prevented: Policy engine holds a PCIe L1 prevent vote
+ * @since: Time @cur was entered
+ * @transitions: Number of transitions into each level
+ * @residency_ms: Time spent in each level
+ * @wake_count: Number of level raises applied
+ * @wake_total_us: Sum of raise latencies, from prediction to applied
+ * @wake_max_us: Longest raise latency
+ * @failures: Number of link or bus vote changes that failed
+ */
+struct cnss_link_policy {
+	spinlock_t lock; /* protects prediction state */
+	struct work_struct work;
+	bool enabled;
+	ktime_t last_sample;
+	u64 last_bytes;
+	u64 last_kbps;
+	u64 ewma_kbps;
+	u64 pred_kbps;
+	unsigned long latency_until;
+	u8 below_count;
+	enum cnss_link_level target;
+	ktime_t decided;
+	enum cnss_link_level cur;
+	int link_status;
+	bool l1_prevented;
+	ktime_t since;
+	u32 transitions[CNSS_LINK_LEVEL_MAX];
+	u64 residency_ms[CNSS_LINK_LEVEL_MAX];
+	u32 wake_count;
+	u64 wake_total_us;
+	u64 wake_max_us;
+	u32 failures;
+};
+
 struct cnss_pci_data {
 	struct pci_dev *pci_dev;
 	struct cnss_plat_data *plat_priv;
@@ -136,6 +196,7 @@ struct cnss_pci_data {
 	unsigned long misc_reg_dev_mask;
 	u8 iommu_geometry;
 	bool drv_supported;
+	struct cnss_link_policy link_policy;
 };
 
 static inline void cnss_set_pci_priv(struct pci_dev *pci_dev, void *data)
@@ -247,6 +308,9 @@ int cnss_pci_update_status(struct cnss_pci_data *pci_priv,
 int cnss_pci_call_driver_uevent(struct cnss_pci_data *pci_priv,
 				enum cnss_driver_status status, void *data);
 int cnss_pcie_is_device_down(struct cnss_pci_data *pci_priv);
+void cnss_pci_link_policy_enable(struct cnss_pci_data *pci_priv, bool enable);
+void cnss_pci_link_policy_show(struct seq_file *s,
+			       struct cnss_pci_data *pci_priv);
 int cnss_pci_suspend_bus(struct cnss_pci_data *pci_priv);
 int cnss_pci_resume_bus(struct cnss_pci_data *pci_priv);
 int cnss_pci_debug_reg_read(struct cnss_pci_data *pci_priv, u32 offset,
@@ -7,6 +7,9 @@
 #include <linux/stacktrace.h>
 #include <linux/spinlock.h>
 #include <linux/sysfs.h>
+#include <linux/shrinker.h>
+#include <linux/workqueue.h>
+#include <linux/math64.h>
 #ifdef CONFIG_WCNSS_SKB_PRE_ALLOC
 #include <linux/skbuff.h>
 #endif
@@ -18,6 +21,9 @@ static DEFINE_SPINLOCK(alloc_lock);
 #define WCNSS_MAX_STACK_TRACE			64
 #endif
 
+/* Headroom kept above the observed high-water mark of a size class */
+#define WCNSS_PREALLOC_MARGIN(hw)		(((hw) + 3) / 4 + 1)
+
 static struct kobject  *prealloc_kobject;
 
 struct wcnss_prealloc {
@@ -30,87 +36,126 @@ struct wcnss_prealloc {
 #endif
 };
 
+/**
+ * struct wcnss_prealloc_class - Pre-allocated buffers of one size
+ * @size: Size of each buffer
+ * @def_count: Buffers allocated at boot when no profile is given
+ * @max_count: Maximum number of buffers, size of @slots
+ * @target: Number of buffers the resize work keeps allocated
+ * @populated: Number of slots holding a buffer
+ * @in_use: Number of buffers handed out
+ * @high_water: Highest demand seen, including requests that missed
+ * @requests: Requests for which this is the smallest fitting size
+ * @hits: Requests served from this class
+ * @fallbacks: Requests that missed the pool and fell back to kmalloc
+ * @grown: Buffers allocated after boot
+ * @shrunk: Buffers released by the shrinker
+ * @slots: Buffer slots, the first @populated are allocated
+ */
+struct wcnss_prealloc_class {
+	size_t size;
+	int def_count;
+	int max_count;
+	int target;
+	int populated;
+	int in_use;
+	int high_water;
+	unsigned long requests;
+	unsigned long hits;
+	unsigned long fallbacks;
+	unsigned long grown;
+	unsigned long shrunk;
+	struct wcnss_prealloc *slots;
+};
+
 /* pre-alloced mem for WLAN driver */
-static struct wcnss_prealloc wcnss_allocs[] = {
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 8  * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 16 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 32 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 64 * 1024, NULL},
-	{0, 128 * 1024, NULL},
-	{0, 128 * 1024, NULL},
-	{0, 128 * 1024, NULL},
+static struct wcnss_prealloc_class wcnss_classes[] = {
+	{ .size = 8  * 1024, .def_count = 27, .max_count = 64 },
+	{ .size = 16 * 1024, .def_count = 16, .max_count = 32 },
+	{ .size = 32 * 1024, .def_count = 8,  .max_count = 16 },
+	{ .size = 64 * 1024, .def_count = 14, .max_count = 28 },
+	{ .size = 128 * 1024, .def_count = 3, .max_count = 8 },
 };
 
+/* Requests larger than the largest class, always served by kmalloc */
+static unsigned long wcnss_oversize_requests;
+static u64 wcnss_fallback_count;
+static u64 wcnss_fallback_total_ns;
+static u64 wcnss_fallback_max_ns;
+
+/*
+ * Boot profile, as read back from the "profile" sysfs file of a previous
+ * boot: the number of buffers of each size, e.g. "8192:20,65536:10".
+ */
+static char *profile;
+module_param(profile, charp, 0444);
+MODULE_PARM_DESC(profile, "Buffers per size, <size>:<count>[,...]");
+
+static void wcnss_prealloc_resize_work(struct work_struct *work);
+static DECLARE_WORK(wcnss_resize_work, wcnss_prealloc_resize_work);
+
+static int wcnss_prealloc_parse_profile(const char *buf)
+{
+	char *str, *cur, *tok;
+	unsigned long size;
+	int i, count, ret = 0;
+
+	str = kstrdup(buf, GFP_KERNEL);
+	if (!str)
+		return -ENOMEM;
+
+	cur = strim(str);
+	while ((tok = strsep(&cur, ",")) != NULL) {
+		if (!*tok)
+			continue;
+
+		if (sscanf(tok, "%lu:%d", &size, &count) != 2 || count < 0) {
+			ret = -EINVAL;
+			break;
+		}
+
+		for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++)
+			if (wcnss_classes[i].size == size)
+				break;
+		if (i == ARRAY_SIZE(wcnss_classes)) {
+			ret = -EINVAL;
+			break;
+		}
+
+		WRITE_ONCE(wcnss_classes[i].target,
+			   min(count, wcnss_classes[i].max_count));
+	}
+
+	kfree(str);
+	return ret;
+}
+
 int wcnss_prealloc_init(void)
 {
+	struct wcnss_prealloc_class *c;
+	void *ptr;
 	int i;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		wcnss_allocs[i].occupied = 0;
-		wcnss_allocs[i].ptr = kmalloc(wcnss_allocs[i].size, GFP_KERNEL);
-		if (!wcnss_allocs[i].ptr)
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		c->slots = kcalloc(c->max_count, sizeof(*c->slots), GFP_KERNEL);
+		if (!c->slots)
 			return -ENOMEM;
+		c->target = c->def_count;
+	}
+
+	if (profile && wcnss_prealloc_parse_profile(profile))
+		pr_err("wcnss_prealloc: Invalid profile \"%s\"\n", profile);
+
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		while (c->populated < c->target) {
+			ptr = kmalloc(c->size, GFP_KERNEL);
+			if (!ptr)
+				return -ENOMEM;
+			c->slots[c->populated].size = c->size;
+			c->slots[c->populated++].ptr = ptr;
+		}
 	}
 
 	return 0;
@@ -118,11 +163,21 @@ int wcnss_prealloc_init(void)
 
 void wcnss_prealloc_deinit(void)
 {
-	int i = 0;
+	struct wcnss_prealloc_class *c;
+	int i, j;
+
+	cancel_work_sync(&wcnss_resize_work);
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		kfree(wcnss_allocs[i].ptr);
-		wcnss_allocs[i].ptr = NULL;
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		if (!c->slots)
+			continue;
+
+		for (j = 0; j < c->populated; j++)
+			kfree(c->slots[j].ptr);
+		kfree(c->slots);
+		c->slots = NULL;
+		c->populated = 0;
 	}
 }
 
@@ -144,24 +199,86 @@ static inline
 void wcnss_prealloc_save_stack_trace(struct wcnss_prealloc *entry) {}
 #endif
 
+/* Allocate buffers up to the target of each class; process context only. */
+static void wcnss_prealloc_resize_work(struct work_struct *work)
+{
+	struct wcnss_prealloc_class *c;
+	unsigned long flags;
+	void *ptr;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		while (READ_ONCE(c->populated) < READ_ONCE(c->target)) {
+			ptr = kmalloc(c->size, GFP_KERNEL | __GFP_NOWARN);
+			if (!ptr)
+				return;
+
+			spin_lock_irqsave(&alloc_lock, flags);
+			if (c->populated < c->target) {
+				c->slots[c->populated].size = c->size;
+				c->slots[c->populated].occupied = 0;
+				c->slots[c->populated++].ptr = ptr;
+				c->grown++;
+				ptr = NULL;
+			}
+			spin_unlock_irqrestore(&alloc_lock, flags);
+			kfree(ptr);
+		}
+	}
+}
+
 void *wcnss_prealloc_get(size_t size)
 {
-	int i = 0;
+	struct wcnss_prealloc_class *c;
+	bool first = true;
 	unsigned long flags;
+	int i, j, demand;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].occupied)
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		if (c->size < size)
 			continue;
 
-		if (wcnss_allocs[i].size >= size) {
+		if (first) {
+			c->requests++;
+			first = false;
+		}
+
+		for (j = 0; j < c->populated; j++) {
+			if (c->slots[j].occupied)
+				continue;
+
 			/* we found the slot */
-			wcnss_allocs[i].occupied = 1;
+			c->slots[j].occupied = 1;
+			c->in_use++;
+			c->hits++;
+			c->high_water = max(c->high_water, c->in_use);
 			spin_unlock_irqrestore(&alloc_lock, flags);
-			wcnss_prealloc_save_stack_trace(&wcnss_allocs[i]);
-			return wcnss_allocs[i].ptr;
+			wcnss_prealloc_save_stack_trace(&c->slots[j]);
+			return c->slots[j].ptr;
 		}
 	}
+
+	/* Missed: charge the demand to the smallest fitting class and grow */
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		if (c->size < size)
+			continue;
+
+		c->fallbacks++;
+		demand = c->in_use + 1;
+		c->high_water = max(c->high_water, demand);
+		if (c->target < c->max_count) {
+			c->target = min(c->max_count,
+					demand + WCNSS_PREALLOC_MARGIN(demand));
+			schedule_work(&wcnss_resize_work);
+		}
+		break;
+	}
+	if (i == ARRAY_SIZE(wcnss_classes))
+		wcnss_oversize_requests++;
 	spin_unlock_irqrestore(&alloc_lock, flags);
 
 	return NULL;
@@ -170,15 +287,21 @@ EXPORT_SYMBOL(wcnss_prealloc_get);
 
 int wcnss_prealloc_put(void *ptr)
 {
-	int i = 0;
+	struct wcnss_prealloc_class *c;
 	unsigned long flags;
+	int i, j;
 
 	spin_lock_irqsave(&alloc_lock, flags);
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (wcnss_allocs[i].ptr == ptr) {
-			wcnss_allocs[i].occupied = 0;
-			spin_unlock_irqrestore(&alloc_lock, flags);
-			return 1;
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		for (j = 0; j < c->populated; j++) {
+			if (c->slots[j].ptr == ptr) {
+				if (c->slots[j].occupied)
+					c->in_use--;
+				c->slots[j].occupied = 0;
+				spin_unlock_irqrestore(&alloc_lock, flags);
+				return 1;
+			}
 		}
 	}
 	spin_unlock_irqrestore(&alloc_lock, flags);
@@ -187,25 +310,127 @@ int wcnss_prealloc_put(void *ptr)
 }
 EXPORT_SYMBOL(wcnss_prealloc_put);
 
+void wcnss_prealloc_fallback_done(size_t size, u64 latency_ns)
+{
+	unsigned long flags;
+
+	if (size <= WCNSS_PRE_ALLOC_GET_THRESHOLD)
+		return;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	wcnss_fallback_count++;
+	wcnss_fallback_total_ns += latency_ns;
+	wcnss_fallback_max_ns = max(wcnss_fallback_max_ns, latency_ns);
+	spin_unlock_irqrestore(&alloc_lock, flags);
+}
+EXPORT_SYMBOL(wcnss_prealloc_fallback_done);
+
+/* Buffers worth keeping for a class: its high-water mark plus headroom */
+static int wcnss_prealloc_recommended(struct wcnss_prealloc_class *c)
+{
+	if (!c->high_water)
+		return 0;
+
+	return min(c->max_count,
+		   c->high_water + WCNSS_PREALLOC_MARGIN(c->high_water));
+}
+
+static unsigned long wcnss_prealloc_shrink_count(struct shrinker *shrink,
+						 struct shrink_control *sc)
+{
+	struct wcnss_prealloc_class *c;
+	unsigned long count = 0;
+	unsigned long flags;
+	int i, keep;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		keep = max(wcnss_prealloc_recommended(c), c->in_use);
+		if (c->populated > keep)
+			count += c->populated - keep;
+	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
+
+	return count ? count : SHRINK_EMPTY;
+}
+
+/*
+ * Release free buffers beyond the recommended count of each class, largest
+ * sizes first. Occupied slots are swapped to the front so that the populated
+ * slots stay contiguous.
+ */
+static unsigned long wcnss_prealloc_shrink_scan(struct shrinker *shrink,
+						struct shrink_control *sc)
+{
+	struct wcnss_prealloc_class *c;
+	struct wcnss_prealloc tmp;
+	unsigned long freed = 0;
+	unsigned long flags;
+	void *ptr;
+	int i, j, keep;
+
+	for (i = ARRAY_SIZE(wcnss_classes) - 1; i >= 0; i--) {
+		c = &wcnss_classes[i];
+		while (freed < sc->nr_to_scan) {
+			ptr = NULL;
+			spin_lock_irqsave(&alloc_lock, flags);
+			keep = max(wcnss_prealloc_recommended(c), c->in_use);
+			if (c->populated > keep) {
+				for (j = c->populated - 1; j >= 0; j--)
+					if (!c->slots[j].occupied)
+						break;
+				tmp = c->slots[j];
+				c->slots[j] = c->slots[c->populated - 1];
+				c->slots[--c->populated] = tmp;
+				ptr = tmp.ptr;
+				c->slots[c->populated].ptr = NULL;
+				c->target = min(c->target, keep);
+				c->shrunk++;
+			}
+			spin_unlock_irqrestore(&alloc_lock, flags);
+
+			if (!ptr)
+				break;
+			kfree(ptr);
+			freed++;
+		}
+	}
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker wcnss_prealloc_shrinker = {
+	.count_objects = wcnss_prealloc_shrink_count,
+	.scan_objects = wcnss_prealloc_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
 #ifdef CONFIG_SLUB_DEBUG
 void wcnss_prealloc_check_memory_leak(void)
 {
-	int i, j = 0;
+	struct wcnss_prealloc_class *c;
+	int i, j, k = 0;
 	struct stack_trace *trace = NULL;
 
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (!wcnss_allocs[i].occupied)
-			continue;
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		for (j = 0; j < c->populated; j++) {
+			if (!c->slots[j].occupied)
+				continue;
 
-		if (j == 0) {
-			pr_err("wcnss_prealloc: Memory leak detected\n");
-			j++;
-		}
+			if (k == 0) {
+				pr_err("wcnss_prealloc: Memory leak detected\n");
+				k++;
+			}
 
-		pr_err("Size: %zu, addr: %pK, backtrace:\n",
-		       wcnss_allocs[i].size, wcnss_allocs[i].ptr);
-		trace = &wcnss_allocs[i].trace;
-		stack_trace_print(trace->entries, trace->nr_entries, 1);
+			pr_err("Size: %zu, addr: %pK, backtrace:\n",
+			       c->slots[j].size, c->slots[j].ptr);
+			/* Slots move when shrinking, trace->entries may be stale */
+			trace = &c->slots[j].trace;
+			stack_trace_print(c->slots[j].stack_trace,
+					  trace->nr_entries, 1);
+		}
 	}
 }
 #else
@@ -215,15 +440,24 @@ EXPORT_SYMBOL(wcnss_prealloc_check_memory_leak);
 
 int wcnss_pre_alloc_reset(void)
 {
-	int i, n = 0;
-
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		if (!wcnss_allocs[i].occupied)
-			continue;
+	struct wcnss_prealloc_class *c;
+	unsigned long flags;
+	int i, j, n = 0;
 
-		wcnss_allocs[i].occupied = 0;
-		n++;
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		for (j = 0; j < c->populated; j++) {
+			if (!c->slots[j].occupied)
+				continue;
+
+			c->slots[j].occupied = 0;
+			n++;
+		}
+		c->in_use = 0;
 	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
+
 	return n;
 }
 EXPORT_SYMBOL(wcnss_pre_alloc_reset);
@@ -231,42 +465,23 @@ EXPORT_SYMBOL(wcnss_pre_alloc_reset);
 static ssize_t status_show(struct kobject *kobj, struct kobj_attribute *attr,
 			   char *buffer)
 {
+	struct wcnss_prealloc_class *c;
 	int i = 0;
-	int used_slots = 0, free_slots = 0;
-	unsigned int tsize = 0, tused = 0, size = 0;
+	unsigned int tsize = 0, tused = 0;
 	int len = 0;
 	char *buf;
 
 	buf = buffer;
 	len += scnprintf(&buf[len], PAGE_SIZE - len,
 			"\nSlot_Size(Kb)\t\t[Used : Free]\n");
-	for (i = 0; i < ARRAY_SIZE(wcnss_allocs); i++) {
-		tsize += wcnss_allocs[i].size;
-		if (size != wcnss_allocs[i].size) {
-			if (size) {
-				len += scnprintf(&buf[len], PAGE_SIZE - len,
-						"[%d : %d]\n", used_slots,
-						free_slots);
-
-			}
-
-			size = wcnss_allocs[i].size;
-			used_slots = 0;
-			free_slots = 0;
-			len += scnprintf(&buf[len], PAGE_SIZE - len,
-					"%d Kb\t\t\t", size / 1024);
-
-		}
-
-		if (wcnss_allocs[i].occupied) {
-			tused += wcnss_allocs[i].size;
-			++used_slots;
-		} else {
-			++free_slots;
-		}
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		tsize += c->populated * c->size;
+		tused += c->in_use * c->size;
+		len += scnprintf(&buf[len], PAGE_SIZE - len,
+				"%zu Kb\t\t\t[%d : %d]\n", c->size / 1024,
+				c->in_use, c->populated - c->in_use);
 	}
-	len += scnprintf(&buf[len], PAGE_SIZE - len,
-			"[%d : %d]\n", used_slots, free_slots);
 
 	/* Convert byte to Kb */
 	if (tsize)
@@ -283,7 +498,94 @@ static ssize_t status_show(struct kobject *kobj, struct kobj_attribute *attr,
 	return len;
 }
 
+static ssize_t stats_show(struct kobject *kobj, struct kobj_attribute *attr,
+			  char *buf)
+{
+	struct wcnss_prealloc_class *c;
+	unsigned long flags;
+	int i, len = 0;
+	u64 avg_ns;
+
+	len += scnprintf(&buf[len], PAGE_SIZE - len,
+			"%-8s %5s %6s %6s %4s %9s %9s %9s %6s %6s\n",
+			"size", "slots", "target", "in_use", "hw",
+			"requests", "hits", "fallback", "grown", "shrunk");
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		len += scnprintf(&buf[len], PAGE_SIZE - len,
+				"%-8zu %5d %6d %6d %4d %9lu %9lu %9lu %6lu %6lu\n",
+				c->size, c->populated, c->target, c->in_use,
+				c->high_water, c->requests, c->hits,
+				c->fallbacks, c->grown, c->shrunk);
+	}
+
+	avg_ns = wcnss_fallback_count ?
+		div64_u64(wcnss_fallback_total_ns, wcnss_fallback_count) : 0;
+	len += scnprintf(&buf[len], PAGE_SIZE - len,
+			"\nOversize requests: %lu\n", wcnss_oversize_requests);
+	len += scnprintf(&buf[len], PAGE_SIZE - len,
+			"Fallback kmalloc: %llu, avg %llu ns, max %llu ns\n",
+			wcnss_fallback_count, avg_ns, wcnss_fallback_max_ns);
+	spin_unlock_irqrestore(&alloc_lock, flags);
+
+	return len;
+}
+
+/*
+ * The recommended profile, to be saved by userspace and passed back through
+ * the "profile" module parameter, or written here, on the next boot.
+ */
+static ssize_t profile_show(struct kobject *kobj, struct kobj_attribute *attr,
+			    char *buf)
+{
+	struct wcnss_prealloc_class *c;
+	unsigned long flags;
+	int i, len = 0;
+
+	spin_lock_irqsave(&alloc_lock, flags);
+	for (i = 0; i < ARRAY_SIZE(wcnss_classes); i++) {
+		c = &wcnss_classes[i];
+		len += scnprintf(&buf[len], PAGE_SIZE - len, "%s%zu:%d",
+				i ? "," : "", c->size,
+				wcnss_prealloc_recommended(c));
+	}
+	spin_unlock_irqrestore(&alloc_lock, flags);
+	len += scnprintf(&buf[len], PAGE_SIZE - len, "\n");
+
+	return len;
+}
+
+static ssize_t profile_store(struct kobject *kobj, struct kobj_attribute *attr,
+			     const char *buf, size_t count)
+{
+	int ret;
+
+	ret = wcnss_prealloc_parse_profile(buf);
+	if (ret)
+		return ret;
+
+	/* Only grows here; excess free buffers go to the shrinker */
+	schedule_work(&wcnss_resize_work);
+
+	return count;
+}
+
 static struct kobj_attribute status_attribute = __ATTR_RO(status);
+static struct kobj_attribute stats_attribute = __ATTR_RO(stats);
+static struct kobj_attribute profile_attribute = __ATTR_RW(profile);
+
+static struct attribute *prealloc_attrs[] = {
+	&status_attribute.attr,
+	&stats_attribute.attr,
+	&profile_attribute.attr,
+	NULL,
+};
+
+static const struct attribute_group prealloc_attr_group = {
+	.attrs = prealloc_attrs,
+};
 
 static int create_prealloc_status_sysfs(void)
 {
@@ -296,8 +598,7 @@ static int create_prealloc_status_sysfs(void)
 		return -ENOMEM;
 	}
 
-	ret = sysfs_create_file(prealloc_kobject,
-				&status_attribute.attr);
+	ret = sysfs_create_group(prealloc_kobject, &prealloc_attr_group);
 	if (ret) {
 		pr_err("%s: Failed to create sysfs cnss-prealloc file\n",
 		       __func__);
@@ -310,8 +611,7 @@ static int create_prealloc_status_sysfs(void)
 static void remove_prealloc_status_sysfs(void)
 {
 	if (prealloc_kobject) {
-		sysfs_remove_file(prealloc_kobject,
-				  &status_attribute.attr);
+		sysfs_remove_group(prealloc_kobject, &prealloc_attr_group);
 		kobject_put(prealloc_kobject);
 	}
 }
@@ -323,9 +623,13 @@ static int __init wcnss_pre_alloc_init(void)
 	ret = wcnss_prealloc_init();
 	if (ret) {
 		pr_err("%s: Failed to init the prealloc pool\n", __func__);
+		wcnss_prealloc_deinit();
 		return ret;
 	}
 
+	if (register_shrinker(&wcnss_prealloc_shrinker))
+		pr_err("%s: Failed to register shrinker\n", __func__);
+
 	create_prealloc_status_sysfs();
 
 	return ret;
@@ -333,8 +637,9 @@ static int __init wcnss_pre_alloc_init(void)
 
 static void __exit wcnss_pre_alloc_exit(void)
 {
-	wcnss_prealloc_deinit();
 	remove_prealloc_status_sysfs();
+	unregister_shrinker(&wcnss_prealloc_shrinker);
+	wcnss_prealloc_deinit();
 }
 
 module_init(wcnss_pre_alloc_init);
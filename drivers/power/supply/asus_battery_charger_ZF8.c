@@ -21,6 +21,9 @@
 #include <linux/reboot.h>
 #include <linux/syscalls.h>
 #include <linux/rtc.h>
+#include <linux/kfifo.h>
+#include <linux/poll.h>
+#include <linux/uaccess.h>
 //ASUS BSP ---
 
 #include "../../thermal/qcom/adc-tm.h"
@@ -1219,6 +1222,159 @@ static ssize_t in_call_show(struct class *c,
 }
 static CLASS_ATTR_RW(in_call);
 
+//ASUS_BSP battery telemetry +++
+/*
+ * Buffered telemetry: instead of a glink round trip per reading, the ADSP
+ * samples current/voltage/temperature at telemetry_rate_hz and pushes them
+ * in batches of up to OEM_TELEMETRY_MAX_BATCH samples, so at 10Hz the AP is
+ * woken about once a second. Samples are kept in a ring that userspace
+ * drains in bulk from /proc/batt_telemetry; on overflow the oldest samples
+ * are dropped and counted in telemetry_dropped.
+ */
+#define TELEMETRY_RING_SIZE          1024
+#define TELEMETRY_MAX_RATE_HZ        50
+#define TELEMETRY_READ_MAX           256
+
+struct batt_telemetry_record {
+    u64 timestamp_ns;   /* CLOCK_BOOTTIME */
+    s32 current_ua;
+    u32 voltage_uv;
+    s32 temp_dc;
+    u32 reserved;
+};
+
+static DEFINE_KFIFO(telemetry_fifo, struct batt_telemetry_record, TELEMETRY_RING_SIZE);
+static DEFINE_SPINLOCK(telemetry_lock);
+static DECLARE_WAIT_QUEUE_HEAD(telemetry_wq);
+static u32 telemetry_rate_hz;
+static u32 telemetry_dropped;
+
+static void asus_telemetry_push(struct oem_batt_telemetry_msg *msg)
+{
+    struct batt_telemetry_record rec = { 0 };
+    u64 now = ktime_get_boottime_ns();
+    unsigned long flags;
+    u32 i, count;
+
+    count = min_t(u32, msg->count, OEM_TELEMETRY_MAX_BATCH);
+
+    spin_lock_irqsave(&telemetry_lock, flags);
+    for (i = 0; i < count; i++) {
+        rec.timestamp_ns = now - (u64)msg->samples[i].age_ms * NSEC_PER_MSEC;
+        rec.current_ua = msg->samples[i].current_ua;
+        rec.voltage_uv = msg->samples[i].voltage_uv;
+        rec.temp_dc = msg->samples[i].temp_dc;
+        if (kfifo_is_full(&telemetry_fifo)) {
+            kfifo_skip(&telemetry_fifo);
+            telemetry_dropped++;
+        }
+        kfifo_put(&telemetry_fifo, rec);
+    }
+    spin_unlock_irqrestore(&telemetry_lock, flags);
+
+    if (count)
+        wake_up_interruptible(&telemetry_wq);
+}
+
+static int asus_telemetry_set_rate(u32 rate_hz)
+{
+    u32 tmp[2];
+    int rc;
+
+    /* period_ms, samples per glink message (0 stops the stream) */
+    tmp[0] = rate_hz ? MSEC_PER_SEC / rate_hz : 0;
+    tmp[1] = rate_hz ? clamp_t(u32, rate_hz, 1, OEM_TELEMETRY_MAX_BATCH) : 0;
+
+    rc = oem_prop_write(BATTMAN_OEM_TELEMETRY_PERIOD, tmp, 2);
+    if (rc < 0) {
+        pr_err("Failed to set BATTMAN_OEM_TELEMETRY_PERIOD rc=%d\n", rc);
+        return rc;
+    }
+
+    telemetry_rate_hz = rate_hz;
+    return 0;
+}
+
+static ssize_t telemetry_rate_hz_store(struct class *c,
+                    struct class_attribute *attr,
+                    const char *buf, size_t count)
+{
+    u32 tmp;
+    int rc;
+
+    if (kstrtou32(buf, 0, &tmp) || tmp > TELEMETRY_MAX_RATE_HZ)
+        return -EINVAL;
+
+    CHG_DBG_E("%s. set telemetry rate : %d Hz", __func__, tmp);
+    rc = asus_telemetry_set_rate(tmp);
+    if (rc < 0)
+        return rc;
+
+    return count;
+}
+
+static ssize_t telemetry_rate_hz_show(struct class *c,
+                    struct class_attribute *attr, char *buf)
+{
+    return scnprintf(buf, PAGE_SIZE, "%u\n", telemetry_rate_hz);
+}
+static CLASS_ATTR_RW(telemetry_rate_hz);
+
+static ssize_t telemetry_dropped_show(struct class *c,
+                    struct class_attribute *attr, char *buf)
+{
+    return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(telemetry_dropped));
+}
+static CLASS_ATTR_RO(telemetry_dropped);
+
+static ssize_t batt_telemetry_proc_read(struct file *file, char __user *ubuf,
+                    size_t count, loff_t *ppos)
+{
+    struct batt_telemetry_record *recs;
+    unsigned int n;
+    ssize_t rc;
+
+    n = min_t(size_t, count / sizeof(*recs), TELEMETRY_READ_MAX);
+    if (!n)
+        return -EINVAL;
+
+    if (kfifo_is_empty(&telemetry_fifo)) {
+        if (file->f_flags & O_NONBLOCK)
+            return -EAGAIN;
+        rc = wait_event_interruptible(telemetry_wq,
+                    !kfifo_is_empty(&telemetry_fifo));
+        if (rc)
+            return rc;
+    }
+
+    recs = kmalloc_array(n, sizeof(*recs), GFP_KERNEL);
+    if (!recs)
+        return -ENOMEM;
+
+    n = kfifo_out_spinlocked(&telemetry_fifo, recs, n, &telemetry_lock);
+    rc = n * sizeof(*recs);
+    if (copy_to_user(ubuf, recs, rc))
+        rc = -EFAULT;
+
+    kfree(recs);
+    return rc;
+}
+
+static __poll_t batt_telemetry_proc_poll(struct file *file, poll_table *wait)
+{
+    poll_wait(file, &telemetry_wq, wait);
+
+    return kfifo_is_empty(&telemetry_fifo) ? 0 : EPOLLIN | EPOLLRDNORM;
+}
+
+static const struct file_operations batt_telemetry_fops = {
+    .owner = THIS_MODULE,
+    .read = batt_telemetry_proc_read,
+    .poll = batt_telemetry_proc_poll,
+    .llseek = no_llseek,
+};
+//ASUS_BSP battery telemetry ---
+
 bool fix_time = false;
 static ssize_t launchedtime_store(struct class *c,
                     struct class_attribute *attr,
@@ -1264,6 +1420,8 @@ static struct attribute *asuslib_class_attrs[] = {
     &class_attr_boot_completed.attr,
     &class_attr_in_call.attr,
     &class_attr_launchedtime.attr,
+    &class_attr_telemetry_rate_hz.attr,
+    &class_attr_telemetry_dropped.attr,
     NULL,
 };
 ATTRIBUTE_GROUPS(asuslib_class);
@@ -1374,6 +1532,7 @@ static void handle_notification(struct battery_chg_dev *bcdev, void *data,
     struct asus_notify_work_event_msg *work_event_msg;
     struct oem_asus_adaptervid_msg *adaptervid_msg;
     struct oem_jeita_cc_state_msg *jeita_cc_state_msg;
+    struct oem_batt_telemetry_msg *telemetry_msg;
     struct pmic_glink_hdr *hdr = data;
     int rc;
     static int pre_chg_type = 0;
@@ -1525,6 +1684,15 @@ static void handle_notification(struct battery_chg_dev *bcdev, void *data,
                 len);
         }
         break;
+    case OEM_BATT_TELEMETRY_IND:
+        if (len == sizeof(*telemetry_msg)) {
+            telemetry_msg = data;
+            asus_telemetry_push(telemetry_msg);
+        } else {
+            pr_err("Incorrect response length %zu for OEM_BATT_TELEMETRY_IND\n",
+                len);
+        }
+        break;
     default:
         pr_err("Unknown opcode: %u\n", hdr->opcode);
         break;
@@ -3503,6 +3671,8 @@ int asuslib_init(void) {
     init_battery_safety(&safety_cond);
     // //init_batt_cycle_count_data();
     create_batt_cycle_count_proc_file();
+    if (!proc_create("batt_telemetry", 0444, NULL, &batt_telemetry_fops))
+        CHG_DBG_E("%s. batt_telemetry proc file create failed!\n", __func__);
     register_reboot_notifier(&reboot_blk);
     schedule_delayed_work(&battery_safety_work, 30 * HZ);
 
@@ -3525,6 +3695,9 @@ int asuslib_init(void) {
 
 int asuslib_deinit(void) {
     g_asuslib_init = false;
+    if (telemetry_rate_hz)
+        asus_telemetry_set_rate(0);
+    remove_proc_entry("batt_telemetry", NULL);
     class_unregister(&asuslib_class);
     wakeup_source_unregister(slowchg_ws);
     return 0;
@@ -43,6 +43,7 @@ struct battery_charger_ship_mode_req_msg {
 #define OEM_ASUS_WORK_EVENT_REQ              0x2110
 #define OEM_ASUS_AdapterVID_REQ              0x2111
 #define OEM_JEITA_CC_STATE_REQ               0x2112
+#define OEM_BATT_TELEMETRY_IND               0x2113
 
 
 #define MAX_OEM_PROPERTY_DATA_SIZE           16
@@ -134,6 +135,25 @@ struct oem_jeita_cc_state_msg {
     struct pmic_glink_hdr header;
     u32 state;
 };
+
+/*
+ * Batched telemetry pushed by the ADSP once BATTMAN_OEM_TELEMETRY_PERIOD is
+ * set. age_ms is how long before the message was sent the sample was taken.
+ */
+#define OEM_TELEMETRY_MAX_BATCH              16
+
+struct oem_batt_telemetry_sample {
+    s32 current_ua;
+    u32 voltage_uv;
+    s32 temp_dc;
+    u32 age_ms;
+};
+
+struct oem_batt_telemetry_msg {
+    struct pmic_glink_hdr header;
+    u32 count;
+    struct oem_batt_telemetry_sample samples[OEM_TELEMETRY_MAX_BATCH];
+};
 //Add the structure ---
 
 //Add oem property
@@ -165,6 +185,7 @@ enum battman_oem_property {
     BATTMAN_OEM_THERMAL_SENSOR,
     BATTMAN_OEM_FV,
     BATTMAN_OEM_In_Call,
+    BATTMAN_OEM_TELEMETRY_PERIOD,
     BATTMAN_OEM_PROPERTY_MAX,
 };
 
@@ -7,7 +7,9 @@
 #include <linux/idr.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 #include <linux/mfd/syscon.h>
 #include <linux/module.h>
 #include <linux/of.h>
@@ -55,6 +57,15 @@ do {									     \
 #define RPM_GLINK_CID_MIN	1
 #define RPM_GLINK_CID_MAX	65536
 
+/*
+ * Intents allocated in response to a remote intent request are rounded up
+ * to a power of two and kept as reusable, up to these per-channel limits,
+ * so that the next message of a similar size finds one already advertised
+ * instead of costing another request round trip.
+ */
+#define GLINK_INTENT_POOL_MAX		8
+#define GLINK_INTENT_POOL_BYTES		SZ_128K
+
 static int should_wake;
 int glink_resume_pkt;
 EXPORT_SYMBOL(glink_resume_pkt);
@@ -202,6 +213,14 @@ enum {
  * @intent_req_completed: Status of intent request completion
  * @intent_req_ack: Waitqueue for @intent_req_acked
  * @intent_req_comp: Waitqueue for @intent_req_completed
+ * @pool_count:	number of reusable intents allocated on remote request
+ * @pool_bytes:	total size of those intents
+ * @intent_reqs_tx: intent requests sent to the remote
+ * @intent_reqs_rx: intent requests received from the remote
+ * @intent_reqs_pooled: received requests served with a new pooled intent
+ * @intent_busy: trysend calls that failed for lack of a remote intent
+ * @intent_wait_ns: total time spent waiting for requested intents
+ * @intent_wait_max_ns: longest wait for a requested intent
  * @lsigs:	local side signals
  * @rsigs:	remote side signals
  */
@@ -240,6 +259,15 @@ struct glink_channel {
 	wait_queue_head_t intent_req_ack;
 	wait_queue_head_t intent_req_comp;
 
+	unsigned int pool_count;
+	size_t pool_bytes;
+	u32 intent_reqs_tx;
+	u32 intent_reqs_rx;
+	u32 intent_reqs_pooled;
+	u32 intent_busy;
+	u64 intent_wait_ns;
+	u64 intent_wait_max_ns;
+
 	unsigned int lsigs;
 	unsigned int rsigs;
 };
@@ -855,6 +883,30 @@ qcom_glink_alloc_intent(struct qcom_glink *glink,
 	return NULL;
 }
 
+static struct glink_core_rx_intent *
+qcom_glink_alloc_pool_intent(struct qcom_glink *glink,
+			     struct glink_channel *channel,
+			     size_t size)
+{
+	struct glink_core_rx_intent *intent;
+	size_t pool_size;
+
+	pool_size = roundup_pow_of_two(max_t(size_t, size, SZ_1K));
+	if (channel->pool_count >= GLINK_INTENT_POOL_MAX ||
+	    channel->pool_bytes + pool_size > GLINK_INTENT_POOL_BYTES)
+		return NULL;
+
+	intent = qcom_glink_alloc_intent(glink, channel, pool_size, true);
+	if (!intent)
+		return NULL;
+
+	channel->pool_count++;
+	channel->pool_bytes += pool_size;
+	channel->intent_reqs_pooled++;
+
+	return intent;
+}
+
 static void qcom_glink_handle_rx_done(struct qcom_glink *glink,
 				      u32 cid, uint32_t iid,
 				      bool reuse)
@@ -919,6 +971,8 @@ static void qcom_glink_handle_intent_req(struct qcom_glink *glink,
 		return;
 	}
 
+	channel->intent_reqs_rx++;
+
 	spin_lock_irqsave(&channel->intent_lock, flags);
 	idr_for_each_entry(&channel->liids, tmp, iid) {
 		if (tmp->size >= size && tmp->reuse) {
@@ -933,7 +987,9 @@ static void qcom_glink_handle_intent_req(struct qcom_glink *glink,
 	}
 
 	ept = &channel->ept;
-	intent = qcom_glink_alloc_intent(glink, channel, size, false);
+	intent = qcom_glink_alloc_pool_intent(glink, channel, size);
+	if (!intent)
+		intent = qcom_glink_alloc_intent(glink, channel, size, false);
 	if (intent && channel->channel_ready)
 		qcom_glink_advertise_intent(glink, channel, intent);
 
@@ -1596,6 +1652,8 @@ static int __qcom_glink_send(struct glink_channel *channel,
 	unsigned long flags;
 	int chunk_size = len;
 	int left_size = 0;
+	ktime_t start;
+	u64 delta;
 
 	if (!glink->intentless) {
 		while (!intent) {
@@ -1621,9 +1679,13 @@ static int __qcom_glink_send(struct glink_channel *channel,
 			if (atomic_read(&glink->in_reset))
 				return -ECONNRESET;
 
-			if (!wait)
+			if (!wait) {
+				channel->intent_busy++;
 				return -EBUSY;
+			}
 
+			start = ktime_get();
+			channel->intent_reqs_tx++;
 			ret = qcom_glink_request_intent(glink, channel, len);
 			if (ret < 0)
 				return ret;
@@ -1644,6 +1706,11 @@ static int __qcom_glink_send(struct glink_channel *channel,
 				ret = channel->intent_req_result ? 0 : -ECANCELED;
 			}
 
+			delta = ktime_to_ns(ktime_sub(ktime_get(), start));
+			channel->intent_wait_ns += delta;
+			if (delta > channel->intent_wait_max_ns)
+				channel->intent_wait_max_ns = delta;
+
 			if (ret < 0)
 				return ret;
 		}
@@ -2001,8 +2068,25 @@ static ssize_t rpmsg_name_show(struct device *dev,
 }
 static DEVICE_ATTR_RO(rpmsg_name);
 
+static ssize_t intent_stats_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct rpmsg_device *rpdev = to_rpmsg_device(dev);
+	struct glink_channel *channel = to_glink_channel(rpdev->ept);
+
+	return scnprintf(buf, PAGE_SIZE,
+			 "req_tx:%u req_rx:%u pooled:%u busy:%u wait_us:%llu max_wait_us:%llu pool:%u/%zu\n",
+			 channel->intent_reqs_tx, channel->intent_reqs_rx,
+			 channel->intent_reqs_pooled, channel->intent_busy,
+			 div_u64(channel->intent_wait_ns, NSEC_PER_USEC),
+			 div_u64(channel->intent_wait_max_ns, NSEC_PER_USEC),
+			 channel->pool_count, channel->pool_bytes);
+}
+static DEVICE_ATTR_RO(intent_stats);
+
 static struct attribute *qcom_glink_attrs[] = {
 	&dev_attr_rpmsg_name.attr,
+	&dev_attr_intent_stats.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(qcom_glink);
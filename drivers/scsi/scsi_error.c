@@ -1086,6 +1086,8 @@ static int scsi_send_eh_cmnd(struct scsi_cmnd *scmd, unsigned char *cmnd,
 		msleep(jiffies_to_msecs(delay));
 		mutex_lock(&sdev->state_mutex);
 	}
+	/* EH issues one command at a time, there is no ->commit_rqs() */
+	scmd->flags |= SCMD_LAST;
 	if (sdev->sdev_state != SDEV_BLOCK)
 		rtn = shost->hostt->queuecommand(shost, scmd);
 	else
@@ -1937,6 +1937,8 @@ static void ufs_qcom_set_caps(struct ufs_hba *hba)
 		hba->caps |= UFSHCD_CAP_WB_EN;
 	}
 
+	hba->caps |= UFSHCD_CAP_CLUSTER_COMPLETION;
+
 	if (host->hw_ver.major >= 0x2) {
 #ifdef CONFIG_SCSI_UFSHCD_QTI
 		if (!host->disable_lpm)
@@ -2545,6 +2547,32 @@ static void ufs_qcom_qos(struct ufs_hba *hba, int tag, bool is_scsi_cmd)
 	dev_dbg(hba->dev, "Queued QoS work- cpu: %d\n", cpu);
 }
 
+/*
+ * Steer the UFS interrupt to the cluster doing the IO while it is the only
+ * one, so its completions stay local. Once several clusters submit, the
+ * interrupt stays put and the block layer sends completions back to the
+ * other clusters' CPUs.
+ */
+static void ufs_qcom_irq_follow_group(struct qos_cpu_group *qcg)
+{
+	struct ufs_qcom_qos_req *qr = qcg->host->ufs_qos;
+	struct ufs_hba *hba = qcg->host->hba;
+	struct qos_cpu_group *g = qr->qcg;
+	int i;
+
+	for (i = 0; i < qr->num_groups; i++, g++) {
+		if (g != qcg && g->voted)
+			return;
+	}
+
+	if (qr->irq_group == qcg || !cpumask_intersects(&qcg->mask,
+							cpu_online_mask))
+		return;
+
+	if (!irq_set_affinity_hint(hba->irq, &qcg->mask))
+		qr->irq_group = qcg;
+}
+
 static void ufs_qcom_vote_work(struct work_struct *work)
 {
 	int err;
@@ -2552,9 +2580,13 @@ static void ufs_qcom_vote_work(struct work_struct *work)
 						 vwork);
 
 	err = ufs_qcom_update_qos_constraints(qcg, QOS_PERF);
-	if (err)
+	if (err) {
 		dev_err(qcg->host->hba->dev, "%s: update qos - failed: %d\n",
 			__func__, err);
+		return;
+	}
+
+	ufs_qcom_irq_follow_group(qcg);
 }
 
 static int ufs_qcom_setup_qos(struct ufs_hba *hba)
@@ -3751,6 +3783,7 @@ static int ufs_qcom_remove(struct platform_device *pdev)
 	pm_runtime_get_sync(&(pdev)->dev);
 	for (i = 0; i < r->num_groups; i++, qcg++)
 		remove_group_qos(qcg);
+	irq_set_affinity_hint(hba->irq, NULL);
 	ufshcd_remove(hba);
 	return 0;
 }
@@ -293,6 +293,8 @@ struct ufs_qcom_qos_req {
 	struct qos_cpu_group *qcg;
 	unsigned int num_groups;
 	struct workqueue_struct *workq;
+	/* group the UFS interrupt was last steered to */
+	struct qos_cpu_group *irq_group;
 };
 
 /* Check for QOS_POWER when added to DT */
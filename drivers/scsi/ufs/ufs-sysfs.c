@@ -4,10 +4,12 @@
 #include <linux/err.h>
 #include <linux/string.h>
 #include <linux/bitfield.h>
+#include <linux/keyslot-manager.h>
 #include <asm/unaligned.h>
 
 #include "ufs.h"
 #include "ufs-sysfs.h"
+#include "ufshpb.h"
 
 static const char *ufschd_uic_link_state_to_string(
 			enum uic_link_state state)
@@ -182,6 +184,121 @@ static ssize_t auto_hibern8_store(struct device *dev,
 	return count;
 }
 
+static ssize_t wb_flush_reserve_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", hba->wb_policy.reserve * 10);
+}
+
+static ssize_t wb_flush_reserve_store(struct device *dev,
+				      struct device_attribute *attr,
+				      const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	unsigned int percent;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	if (kstrtouint(buf, 0, &percent) || percent > 100)
+		return -EINVAL;
+
+	hba->wb_policy.reserve = UFS_WB_BUF_REMAIN_PERCENT(percent);
+
+	pm_runtime_get_sync(hba->dev);
+	ufshcd_wb_policy_update(hba);
+	pm_runtime_put_sync(hba->dev);
+
+	return count;
+}
+
+static ssize_t wb_flush_idle_hint_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n", hba->wb_policy.idle_hint);
+}
+
+static ssize_t wb_flush_idle_hint_store(struct device *dev,
+					struct device_attribute *attr,
+					const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	bool idle;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	if (kstrtobool(buf, &idle))
+		return -EINVAL;
+
+	hba->wb_policy.idle_hint = idle;
+
+	pm_runtime_get_sync(hba->dev);
+	ufshcd_wb_policy_update(hba);
+	pm_runtime_put_sync(hba->dev);
+
+	return count;
+}
+
+/* Last sampled value, reading it does not wake the device up */
+static ssize_t wb_policy_avail_buf_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return -EOPNOTSUPP;
+
+	return sprintf(buf, "%u\n", hba->wb_policy.avail_buf * 10);
+}
+
+static ssize_t doorbell_batches_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	static const char * const label[UFSHCD_DB_BATCH_BUCKETS] = {
+		"1", "2", "3-4", "5-8", "9-16", "17+",
+	};
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < UFSHCD_DB_BATCH_BUCKETS; i++)
+		len += snprintf(buf + len, PAGE_SIZE - len, "%s: %llu\n",
+				label[i], hba->ufs_stats.db_batch_hist[i]);
+
+	return len;
+}
+
+#ifdef CONFIG_SCSI_UFS_CRYPTO
+static ssize_t keyslot_stats_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	struct keyslot_mgmt_stats st;
+
+	if (!hba->ksm)
+		return -EOPNOTSUPP;
+
+	keyslot_manager_get_stats(hba->ksm, &st);
+	return snprintf(buf, PAGE_SIZE,
+			"hit: %llu\nprogram: %llu\nprogram_fail: %llu\n"
+			"program_avg_us: %llu\nprogram_max_us: %llu\n"
+			"replace: %llu\nevict: %llu\npreload: %llu\nwait: %llu\n",
+			st.hit_cnt, st.program_cnt, st.program_fail_cnt,
+			st.program_cnt ? div64_u64(st.program_total_ns,
+					st.program_cnt) / NSEC_PER_USEC : 0,
+			div_u64(st.program_max_ns, NSEC_PER_USEC),
+			st.replace_cnt, st.evict_cnt, st.preload_cnt,
+			st.wait_cnt);
+}
+static DEVICE_ATTR_RO(keyslot_stats);
+#endif
+
 static DEVICE_ATTR_RW(rpm_lvl);
 static DEVICE_ATTR_RO(rpm_target_dev_state);
 static DEVICE_ATTR_RO(rpm_target_link_state);
@@ -189,6 +306,10 @@ static DEVICE_ATTR_RW(spm_lvl);
 static DEVICE_ATTR_RO(spm_target_dev_state);
 static DEVICE_ATTR_RO(spm_target_link_state);
 static DEVICE_ATTR_RW(auto_hibern8);
+static DEVICE_ATTR_RW(wb_flush_reserve);
+static DEVICE_ATTR_RW(wb_flush_idle_hint);
+static DEVICE_ATTR_RO(wb_policy_avail_buf);
+static DEVICE_ATTR_RO(doorbell_batches);
 
 static struct attribute *ufs_sysfs_ufshcd_attrs[] = {
 	&dev_attr_rpm_lvl.attr,
@@ -198,6 +319,13 @@ static struct attribute *ufs_sysfs_ufshcd_attrs[] = {
 	&dev_attr_spm_target_dev_state.attr,
 	&dev_attr_spm_target_link_state.attr,
 	&dev_attr_auto_hibern8.attr,
+	&dev_attr_wb_flush_reserve.attr,
+	&dev_attr_wb_flush_idle_hint.attr,
+	&dev_attr_wb_policy_avail_buf.attr,
+	&dev_attr_doorbell_batches.attr,
+#ifdef CONFIG_SCSI_UFS_CRYPTO
+	&dev_attr_keyslot_stats.attr,
+#endif
 	NULL
 };
 
@@ -864,6 +992,103 @@ const struct attribute_group ufs_sysfs_lun_attributes_group = {
 	.attrs = ufs_sysfs_lun_attributes,
 };
 
+#define UFS_HPB_STAT(_name)						\
+static ssize_t _name##_show(struct device *dev,				\
+	struct device_attribute *attr, char *buf)			\
+{									\
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));	\
+									\
+	return sprintf(buf, "%llu\n", READ_ONCE(hpb->stats._name));	\
+}									\
+static DEVICE_ATTR_RO(_name)
+
+UFS_HPB_STAT(hit_cnt);
+UFS_HPB_STAT(miss_cnt);
+UFS_HPB_STAT(map_load_cnt);
+UFS_HPB_STAT(map_load_fail_cnt);
+UFS_HPB_STAT(evict_cnt);
+UFS_HPB_STAT(rgn_inactivate_cnt);
+
+static ssize_t active_subregions_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));
+
+	return sprintf(buf, "%u\n", READ_ONCE(hpb->nr_active_srgns));
+}
+static DEVICE_ATTR_RO(active_subregions);
+
+static ssize_t active_regions_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));
+
+	return sprintf(buf, "%u\n", READ_ONCE(hpb->nr_active_rgns));
+}
+static DEVICE_ATTR_RO(active_regions);
+
+static ssize_t mem_used_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));
+
+	return sprintf(buf, "%llu\n", (u64)READ_ONCE(hpb->nr_active_srgns) *
+		       ufshpb_srgn_mem_size(hpb));
+}
+static DEVICE_ATTR_RO(mem_used);
+
+static ssize_t mem_budget_show(struct device *dev,
+	struct device_attribute *attr, char *buf)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));
+
+	return sprintf(buf, "%llu\n", (u64)READ_ONCE(hpb->max_active_srgns) *
+		       ufshpb_srgn_mem_size(hpb));
+}
+
+static ssize_t mem_budget_store(struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(to_scsi_device(dev));
+	u64 bytes;
+
+	if (kstrtou64(buf, 0, &bytes))
+		return -EINVAL;
+
+	ufshpb_set_mem_budget(hpb, bytes);
+
+	return count;
+}
+static DEVICE_ATTR_RW(mem_budget);
+
+static struct attribute *ufs_sysfs_hpb_stats[] = {
+	&dev_attr_hit_cnt.attr,
+	&dev_attr_miss_cnt.attr,
+	&dev_attr_map_load_cnt.attr,
+	&dev_attr_map_load_fail_cnt.attr,
+	&dev_attr_evict_cnt.attr,
+	&dev_attr_rgn_inactivate_cnt.attr,
+	&dev_attr_active_subregions.attr,
+	&dev_attr_active_regions.attr,
+	&dev_attr_mem_used.attr,
+	&dev_attr_mem_budget.attr,
+	NULL,
+};
+
+static umode_t ufs_sysfs_hpb_is_visible(struct kobject *kobj,
+	struct attribute *attr, int n)
+{
+	struct scsi_device *sdev = to_scsi_device(kobj_to_dev(kobj));
+
+	return ufshpb_get_lu(sdev) ? attr->mode : 0;
+}
+
+const struct attribute_group ufs_sysfs_hpb_stats_group = {
+	.name = "hpb_stats",
+	.attrs = ufs_sysfs_hpb_stats,
+	.is_visible = ufs_sysfs_hpb_is_visible,
+};
+
 void ufs_sysfs_add_nodes(struct device *dev)
 {
 	int ret;
@@ -45,6 +45,8 @@
 #include <linux/blk-pm.h>
 #include <asm/unaligned.h>
 #include <linux/blkdev.h>
+#include <linux/sizes.h>
+#include <linux/ufs_boost.h>
 #ifdef CONFIG_MACH_ASUS
 #include <scsi/fc_frame.h>	//ASUS_Deeo : include to use ntohll API +++
 #endif
@@ -54,6 +56,7 @@
 #include "ufs-sysfs.h"
 #include "ufs_bsg.h"
 #include "ufshcd-crypto.h"
+#include "ufshpb.h"
 
 #ifdef CONFIG_MACH_ASUS
 static  u8 pre_Pre_EOL;
@@ -121,6 +124,16 @@ static bool init_ufs_health_flag = false;
 /* Polling time to wait for fDeviceInit  */
 #define FDEVICEINIT_COMPL_TIMEOUT 5000 /* millisecs */
 
+/* Outstanding requests that scale up ahead of the devfreq polling window */
+#define UFSHCD_CLK_BOOST_QDEPTH	8
+/* How long a queue depth boost holds the high gear */
+#define UFSHCD_CLK_BOOST_QD_HOLD_MS	100
+/* Longest hold a boost hint may ask for */
+#define UFSHCD_CLK_BOOST_MAX_HOLD_MS	5000
+
+/* Bytes written between two reads of the available WriteBooster buffer */
+#define UFSHCD_WB_SAMPLE_BYTES		SZ_64M
+
 #define ufshcd_toggle_vreg(_dev, _vreg, _on)				\
 	({                                                              \
 		int _ret;                                               \
@@ -303,6 +316,8 @@ static int ufshcd_wb_buf_flush_disable(struct ufs_hba *hba);
 int ufshcd_wb_ctrl(struct ufs_hba *hba, bool enable);
 static int ufshcd_wb_toggle_flush_during_h8(struct ufs_hba *hba, bool set);
 static inline void ufshcd_wb_toggle_flush(struct ufs_hba *hba, bool enable);
+static inline void ufshcd_wb_account_write(struct ufs_hba *hba,
+					   unsigned int bytes);
 #ifdef CONFIG_MACH_ASUS
 static void ufs_asusevent_log(struct ufs_hba *hba);
 #endif
@@ -347,11 +362,8 @@ static inline void ufshcd_wb_config(struct ufs_hba *hba)
 		dev_err(hba->dev, "%s: Enable WB failed: %d\n", __func__, ret);
 	else
 		dev_info(hba->dev, "%s: Write Booster Configured\n", __func__);
-	ret = ufshcd_wb_toggle_flush_during_h8(hba, true);
-	if (ret)
-		dev_err(hba->dev, "%s: En WB flush during H8: failed: %d\n",
-			__func__, ret);
-	ufshcd_wb_toggle_flush(hba, true);
+	/* flushing is left to the policy, which starts from a fresh sample */
+	ufshcd_wb_policy_update(hba);
 }
 
 static void ufshcd_scsi_unblock_requests(struct ufs_hba *hba)
@@ -1164,7 +1176,9 @@ static int ufshcd_wait_for_doorbell_clr(struct ufs_hba *hba,
 		}
 
 		tm_doorbell = ufshcd_readl(hba, REG_UTP_TASK_REQ_DOOR_BELL);
-		tr_doorbell = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+		/* a batch still being dispatched is about to hit the doorbell */
+		tr_doorbell = ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL) |
+			      hba->pending_reqs;
 		if (!tm_doorbell && !tr_doorbell) {
 			timeout = false;
 			break;
@@ -1361,12 +1375,114 @@ static void ufshcd_clk_scaling_resume_work(struct work_struct *work)
 	devfreq_resume_device(hba->devfreq);
 }
 
+/*
+ * Must be called with host lock acquired. Extends the boost hold to @until
+ * and scales up right away if we are not there yet.
+ */
+static void __ufshcd_clkscale_boost(struct ufs_hba *hba, ktime_t until,
+				    const char *trigger)
+{
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+
+	if (ktime_after(until, scaling->boost_until))
+		scaling->boost_until = until;
+
+	if (!scaling->is_allowed || !hba->devfreq ||
+	    !ufshcd_is_devfreq_scaling_required(hba, true))
+		return;
+
+	if (queue_work(scaling->workq, &scaling->boost_work)) {
+		scaling->boost_trigger_t = ktime_get();
+		scaling->boost_trigger = trigger;
+	}
+}
+
+/**
+ * ufshcd_clkscale_boost - scale up ahead of an expected IO burst
+ * @hba: per adapter instance
+ * @hold_ms: time devfreq is kept from scaling down again
+ *
+ * Meant for hints like app launches, where waiting for the busy time of a
+ * whole polling window scales up too late to help.
+ */
+void ufshcd_clkscale_boost(struct ufs_hba *hba, unsigned int hold_ms)
+{
+	unsigned long flags;
+
+	if (!ufshcd_is_clkscaling_supported(hba))
+		return;
+
+	hold_ms = min_t(unsigned int, hold_ms, UFSHCD_CLK_BOOST_MAX_HOLD_MS);
+	spin_lock_irqsave(hba->host->host_lock, flags);
+	__ufshcd_clkscale_boost(hba, ktime_add_ms(ktime_get(), hold_ms), "hint");
+	spin_unlock_irqrestore(hba->host->host_lock, flags);
+}
+EXPORT_SYMBOL_GPL(ufshcd_clkscale_boost);
+
+static LIST_HEAD(ufshcd_boost_list);
+static DEFINE_SPINLOCK(ufshcd_boost_lock);
+
+/**
+ * ufshcd_boost_hint - scale up every host ahead of an expected IO burst
+ * @hold_ms: time devfreq is kept from scaling down again
+ *
+ * For callers outside the SCSI stack that have no hba at hand, like input
+ * drivers seeing the user start an unlock. Safe from any context.
+ */
+void ufshcd_boost_hint(unsigned int hold_ms)
+{
+	struct ufs_clk_scaling *scaling;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ufshcd_boost_lock, flags);
+	list_for_each_entry(scaling, &ufshcd_boost_list, boost_node)
+		ufshcd_clkscale_boost(container_of(scaling, struct ufs_hba,
+						   clk_scaling), hold_ms);
+	spin_unlock_irqrestore(&ufshcd_boost_lock, flags);
+}
+EXPORT_SYMBOL_GPL(ufshcd_boost_hint);
+
+static void ufshcd_clk_scaling_boost_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   clk_scaling.boost_work);
+	struct ufs_clk_scaling *scaling = &hba->clk_scaling;
+	const char *trigger;
+	unsigned long irq_flags;
+	ktime_t trigger_t;
+	int active_reqs, ret;
+	s64 scale_us;
+
+	spin_lock_irqsave(hba->host->host_lock, irq_flags);
+	trigger = scaling->boost_trigger;
+	trigger_t = scaling->boost_trigger_t;
+	active_reqs = scaling->active_reqs;
+	spin_unlock_irqrestore(hba->host->host_lock, irq_flags);
+
+	/* a suspended link comes back through the regular devfreq path */
+	if (pm_runtime_get_if_in_use(hba->dev) <= 0)
+		return;
+
+	/* goes through devfreq so its state and statistics stay coherent */
+	mutex_lock(&hba->devfreq->lock);
+	scaling->boost_scale_us = 0;
+	ret = update_devfreq(hba->devfreq);
+	scale_us = scaling->boost_scale_us;
+	mutex_unlock(&hba->devfreq->lock);
+
+	pm_runtime_put(hba->dev);
+
+	trace_ufshcd_clk_scaling_boost(dev_name(hba->dev), trigger, active_reqs,
+			ktime_us_delta(ktime_get(), trigger_t), scale_us, ret);
+}
+
 static int ufshcd_devfreq_target(struct device *dev,
 				unsigned long *freq, u32 flags)
 {
 	int ret = 0;
 	struct ufs_hba *hba = dev_get_drvdata(dev);
 	ktime_t start;
+	s64 scale_us;
 	bool scale_up, sched_clk_scaling_suspend_work = false;
 	struct list_head *clk_list = &hba->clk_list_head;
 	struct ufs_clk_info *clki;
@@ -1394,6 +1510,12 @@ static int ufshcd_devfreq_target(struct device *dev,
 
 	/* Decide based on the rounded-off frequency and update */
 	scale_up = (*freq == clki->max_freq) ? true : false;
+	/* hold the high gear until a predicted burst is over */
+	if (!scale_up &&
+	    ktime_before(ktime_get(), hba->clk_scaling.boost_until)) {
+		scale_up = true;
+		*freq = clki->max_freq;
+	}
 	if (!scale_up)
 		*freq = clki->min_freq;
 	/* Update the frequency */
@@ -1417,10 +1539,12 @@ static int ufshcd_devfreq_target(struct device *dev,
 #if defined(CONFIG_SCSI_UFSHCD_QTI)
 	pm_runtime_put(hba->dev);
 #endif
+	scale_us = ktime_to_us(ktime_sub(ktime_get(), start));
+	if (scale_up)
+		hba->clk_scaling.boost_scale_us = scale_us;
 
 	trace_ufshcd_profile_clk_scaling(dev_name(hba->dev),
-		(scale_up ? "up" : "down"),
-		ktime_to_us(ktime_sub(ktime_get(), start)), ret);
+		(scale_up ? "up" : "down"), scale_us, ret);
 
 out:
 	if (sched_clk_scaling_suspend_work)
@@ -1605,6 +1729,7 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 
 	cancel_work_sync(&hba->clk_scaling.suspend_work);
 	cancel_work_sync(&hba->clk_scaling.resume_work);
+	cancel_work_sync(&hba->clk_scaling.boost_work);
 
 	hba->clk_scaling.is_allowed = value;
 
@@ -1624,6 +1749,50 @@ static ssize_t ufshcd_clkscale_enable_store(struct device *dev,
 	return count;
 }
 
+static ssize_t ufshcd_clkscale_boost_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	s64 left = ktime_ms_delta(hba->clk_scaling.boost_until, ktime_get());
+
+	return snprintf(buf, PAGE_SIZE, "%lld\n", max_t(s64, left, 0));
+}
+
+static ssize_t ufshcd_clkscale_boost_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value))
+		return -EINVAL;
+
+	ufshcd_clkscale_boost(hba, value);
+	return count;
+}
+
+static ssize_t ufshcd_clkscale_boost_qdepth_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+			hba->clk_scaling.boost_qdepth);
+}
+
+static ssize_t ufshcd_clkscale_boost_qdepth_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct ufs_hba *hba = dev_get_drvdata(dev);
+	u32 value;
+
+	if (kstrtou32(buf, 0, &value) || value > hba->nutrs)
+		return -EINVAL;
+
+	hba->clk_scaling.boost_qdepth = value;
+	return count;
+}
+
 static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 {
 	hba->clk_scaling.enable_attr.show = ufshcd_clkscale_enable_show;
@@ -1633,6 +1802,24 @@ static void ufshcd_clkscaling_init_sysfs(struct ufs_hba *hba)
 	hba->clk_scaling.enable_attr.attr.mode = 0644;
 	if (device_create_file(hba->dev, &hba->clk_scaling.enable_attr))
 		dev_err(hba->dev, "Failed to create sysfs for clkscale_enable\n");
+
+	hba->clk_scaling.boost_attr.show = ufshcd_clkscale_boost_show;
+	hba->clk_scaling.boost_attr.store = ufshcd_clkscale_boost_store;
+	sysfs_attr_init(&hba->clk_scaling.boost_attr.attr);
+	hba->clk_scaling.boost_attr.attr.name = "clkscale_boost";
+	hba->clk_scaling.boost_attr.attr.mode = 0644;
+	if (device_create_file(hba->dev, &hba->clk_scaling.boost_attr))
+		dev_err(hba->dev, "Failed to create sysfs for clkscale_boost\n");
+
+	hba->clk_scaling.boost_qdepth_attr.show =
+		ufshcd_clkscale_boost_qdepth_show;
+	hba->clk_scaling.boost_qdepth_attr.store =
+		ufshcd_clkscale_boost_qdepth_store;
+	sysfs_attr_init(&hba->clk_scaling.boost_qdepth_attr.attr);
+	hba->clk_scaling.boost_qdepth_attr.attr.name = "clkscale_boost_qdepth";
+	hba->clk_scaling.boost_qdepth_attr.attr.mode = 0644;
+	if (device_create_file(hba->dev, &hba->clk_scaling.boost_qdepth_attr))
+		dev_err(hba->dev, "Failed to create sysfs for clkscale_boost_qdepth\n");
 }
 
 static void ufshcd_ungate_work(struct work_struct *work)
@@ -1944,12 +2131,19 @@ static void ufshcd_init_clk_scaling(struct ufs_hba *hba)
 		  ufshcd_clk_scaling_suspend_work);
 	INIT_WORK(&hba->clk_scaling.resume_work,
 		  ufshcd_clk_scaling_resume_work);
+	INIT_WORK(&hba->clk_scaling.boost_work,
+		  ufshcd_clk_scaling_boost_work);
+	hba->clk_scaling.boost_qdepth = UFSHCD_CLK_BOOST_QDEPTH;
 
 	snprintf(wq_name, sizeof(wq_name), "ufs_clkscaling_%d",
 		 hba->host->host_no);
 	hba->clk_scaling.workq = create_singlethread_workqueue(wq_name);
 
 	ufshcd_clkscaling_init_sysfs(hba);
+
+	spin_lock_irq(&ufshcd_boost_lock);
+	list_add_tail(&hba->clk_scaling.boost_node, &ufshcd_boost_list);
+	spin_unlock_irq(&ufshcd_boost_lock);
 }
 
 static void ufshcd_exit_clk_scaling(struct ufs_hba *hba)
@@ -1957,6 +2151,10 @@ static void ufshcd_exit_clk_scaling(struct ufs_hba *hba)
 	if (!ufshcd_is_clkscaling_supported(hba))
 		return;
 
+	spin_lock_irq(&ufshcd_boost_lock);
+	list_del_init(&hba->clk_scaling.boost_node);
+	spin_unlock_irq(&ufshcd_boost_lock);
+
 	destroy_workqueue(hba->clk_scaling.workq);
 	ufshcd_devfreq_remove(hba);
 }
@@ -2038,6 +2236,14 @@ static void ufshcd_clk_scaling_start_busy(struct ufs_hba *hba)
 		hba->clk_scaling.busy_start_t = curr_t;
 		hba->clk_scaling.is_busy_started = true;
 	}
+
+	/* a deep queue is a burst the busy time of the window only sees late */
+	if (hba->clk_scaling.boost_qdepth &&
+	    hba->clk_scaling.active_reqs >= hba->clk_scaling.boost_qdepth)
+		__ufshcd_clkscale_boost(hba, ktime_add_ms(curr_t,
+					UFSHCD_CLK_BOOST_QD_HOLD_MS), "qdepth");
+	else if (ktime_before(curr_t, hba->clk_scaling.boost_until))
+		__ufshcd_clkscale_boost(hba, 0, "hold");
 }
 
 static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
@@ -2055,12 +2261,39 @@ static void ufshcd_clk_scaling_update_busy(struct ufs_hba *hba)
 	}
 }
 /**
- * ufshcd_send_command - Send SCSI or device management commands
+ * ufshcd_ring_doorbell - issue the pending requests of a dispatch batch
+ * @hba: per adapter instance
+ *
+ * Must be called with host lock acquired. Requests only become outstanding
+ * here, so the completion path never mistakes a prepared request for one
+ * the controller finished.
+ */
+static inline void ufshcd_ring_doorbell(struct ufs_hba *hba)
+{
+	unsigned long pending = hba->pending_reqs;
+	int nr;
+
+	if (!pending)
+		return;
+
+	hba->pending_reqs = 0;
+	hba->outstanding_reqs |= pending;
+	ufshcd_writel(hba, pending, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+	/* Make sure that doorbell is committed immediately */
+	wmb();
+
+	nr = hweight_long(pending);
+	hba->ufs_stats.db_batch_hist[min(fls(nr - 1),
+					 UFSHCD_DB_BATCH_BUCKETS - 1)]++;
+}
+
+/**
+ * __ufshcd_send_command - prepare a request for the next doorbell write
  * @hba: per adapter instance
  * @task_tag: Task tag of the command
  */
 static inline
-void ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
+void __ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 {
 	struct ufshcd_lrb *lrbp = &hba->lrb[task_tag];
 
@@ -2069,10 +2302,19 @@ void ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 	ufshcd_vops_setup_xfer_req(hba, task_tag, (lrbp->cmd ? true : false));
 	ufshcd_add_command_trace(hba, task_tag, "send");
 	ufshcd_clk_scaling_start_busy(hba);
-	__set_bit(task_tag, &hba->outstanding_reqs);
-	ufshcd_writel(hba, 1 << task_tag, REG_UTP_TRANSFER_REQ_DOOR_BELL);
-	/* Make sure that doorbell is committed immediately */
-	wmb();
+	__set_bit(task_tag, &hba->pending_reqs);
+}
+
+/**
+ * ufshcd_send_command - Send SCSI or device management commands
+ * @hba: per adapter instance
+ * @task_tag: Task tag of the command
+ */
+static inline
+void ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
+{
+	__ufshcd_send_command(hba, task_tag);
+	ufshcd_ring_doorbell(hba);
 }
 
 /**
@@ -2669,6 +2911,8 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 	}
 	lrbp->req_abort_skip = false;
 
+	ufshpb_prep(hba, lrbp);
+
 	ufshcd_comp_scsi_upiu(hba, lrbp);
 
 	err = ufshcd_map_sg(hba, lrbp);
@@ -2715,7 +2959,16 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 		set_host_byte(cmd, DID_BAD_TARGET);
 		goto out_compl_cmd;
 	}
-	ufshcd_send_command(hba, tag);
+	if (cmd->sc_data_direction == DMA_TO_DEVICE)
+		ufshcd_wb_account_write(hba, scsi_bufflen(cmd));
+	/*
+	 * blk-mq flags the last request of a dispatch batch and calls
+	 * ->commit_rqs() if the batch ends early, one doorbell write covers
+	 * the whole batch.
+	 */
+	__ufshcd_send_command(hba, tag);
+	if (cmd->flags & SCMD_LAST)
+		ufshcd_ring_doorbell(hba);
 	spin_unlock_irqrestore(hba->host->host_lock, flags);
 	goto out;
 
@@ -2723,6 +2976,9 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 	scsi_dma_unmap(lrbp->cmd);
 	lrbp->cmd = NULL;
 	clear_bit_unlock(tag, &hba->lrb_in_use);
+	/* no ->commit_rqs() follows a last request that completes here */
+	if (cmd->flags & SCMD_LAST)
+		ufshcd_ring_doorbell(hba);
 	spin_unlock_irqrestore(hba->host->host_lock, flags);
 	ufshcd_release(hba);
 	if (!err)
@@ -2732,6 +2988,16 @@ static int ufshcd_queuecommand(struct Scsi_Host *host, struct scsi_cmnd *cmd)
 	return err;
 }
 
+static void ufshcd_commit_rqs(struct Scsi_Host *host, u16 hwq)
+{
+	struct ufs_hba *hba = shost_priv(host);
+	unsigned long flags;
+
+	spin_lock_irqsave(host->host_lock, flags);
+	ufshcd_ring_doorbell(hba);
+	spin_unlock_irqrestore(host->host_lock, flags);
+}
+
 static int ufshcd_compose_dev_cmd(struct ufs_hba *hba,
 		struct ufshcd_lrb *lrbp, enum dev_cmd_type cmd_type, int tag)
 {
@@ -4988,6 +5254,11 @@ static int ufshcd_slave_configure(struct scsi_device *sdev)
 
 	ufshcd_crypto_setup_rq_keyslot_manager(hba, q);
 
+	ufshpb_init_lu(hba, sdev);
+
+	if (ufshcd_is_cluster_completion_allowed(hba))
+		blk_queue_flag_set(QUEUE_FLAG_SAME_CLUSTER, q);
+
 	if (ufshcd_is_rpm_autosuspend_allowed(hba))
 		sdev->rpm_autosuspend = 1;
 
@@ -5013,6 +5284,8 @@ static void ufshcd_slave_destroy(struct scsi_device *sdev)
 		spin_unlock_irqrestore(hba->host->host_lock, flags);
 	}
 
+	ufshpb_destroy_lu(hba, sdev);
+
 #if defined(CONFIG_SCSI_UFSHCD_QTI)
 	return;
 #endif
@@ -5592,18 +5865,25 @@ EXPORT_SYMBOL_GPL(ufshcd_wb_ctrl);
 
 static int ufshcd_wb_toggle_flush_during_h8(struct ufs_hba *hba, bool set)
 {
-	int val;
+	int val, ret;
 	u8 index;
 
+	if (hba->wb_policy.flush_h8_enabled == set)
+		return 0;
+
 	if (set)
 		val =  UPIU_QUERY_OPCODE_SET_FLAG;
 	else
 		val = UPIU_QUERY_OPCODE_CLEAR_FLAG;
 
 	index = ufshcd_wb_get_query_index(hba);
-	return ufshcd_query_flag_retry(hba, val,
+	ret = ufshcd_query_flag_retry(hba, val,
 				QUERY_FLAG_IDN_WB_BUFF_FLUSH_DURING_HIBERN8,
 				index, NULL);
+	if (!ret)
+		hba->wb_policy.flush_h8_enabled = set;
+
+	return ret;
 }
 
 static inline void ufshcd_wb_toggle_flush(struct ufs_hba *hba, bool enable)
@@ -5663,6 +5943,100 @@ static int ufshcd_wb_buf_flush_disable(struct ufs_hba *hba)
 	return ret;
 }
 
+static int ufshcd_wb_read_avail_buf(struct ufs_hba *hba, u32 *avail_buf)
+{
+	int ret;
+	u8 index;
+
+	index = ufshcd_wb_get_query_index(hba);
+	ret = ufshcd_query_attr_retry(hba, UPIU_QUERY_OPCODE_READ_ATTR,
+				      QUERY_ATTR_IDN_AVAIL_WB_BUFF_SIZE,
+				      index, 0, avail_buf);
+	if (ret) {
+		dev_warn(hba->dev, "%s dAvailableWriteBoosterBufferSize read failed %d\n",
+			 __func__, ret);
+		return ret;
+	}
+
+	hba->wb_policy.avail_buf = *avail_buf;
+	return 0;
+}
+
+/*
+ * Flushing costs power and competes with foreground IO for the gaps it
+ * runs in, and data rewritten while still in the buffer never has to go
+ * to the normal storage at all. So only flush once the room kept for
+ * foreground bursts is eaten into, or drain the buffer completely when a
+ * long idle period is expected anyway.
+ */
+static bool ufshcd_wb_policy_wants_flush(struct ufs_hba *hba, u32 avail_buf)
+{
+	struct ufs_wb_policy *policy = &hba->wb_policy;
+
+	if (policy->idle_hint)
+		return avail_buf < UFS_WB_BUF_REMAIN_PERCENT(100);
+
+	return avail_buf <= policy->reserve;
+}
+
+/**
+ * ufshcd_wb_policy_update - apply the flush policy to a fresh sample
+ * @hba: per adapter instance
+ *
+ * Reads the available buffer and turns explicit and hibern8 flushing on or
+ * off accordingly.
+ */
+void ufshcd_wb_policy_update(struct ufs_hba *hba)
+{
+	u32 avail_buf;
+	bool flush;
+	int ret;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return;
+
+	if (ufshcd_wb_read_avail_buf(hba, &avail_buf))
+		return;
+
+	flush = ufshcd_wb_policy_wants_flush(hba, avail_buf);
+	ret = ufshcd_wb_toggle_flush_during_h8(hba, flush);
+	if (ret)
+		dev_err(hba->dev, "%s: %s WB flush during H8 failed: %d\n",
+			__func__, flush ? "En" : "Dis", ret);
+	ufshcd_wb_toggle_flush(hba, flush);
+}
+EXPORT_SYMBOL_GPL(ufshcd_wb_policy_update);
+
+static void ufshcd_wb_sample_work(struct work_struct *work)
+{
+	struct ufs_hba *hba = container_of(work, struct ufs_hba,
+					   wb_policy.sample_work);
+
+	/* an idle device is sampled again on its way into runtime suspend */
+	if (pm_runtime_get_if_in_use(hba->dev) <= 0)
+		return;
+
+	ufshcd_wb_policy_update(hba);
+	pm_runtime_put(hba->dev);
+}
+
+/* Must be called with host lock acquired */
+static inline void ufshcd_wb_account_write(struct ufs_hba *hba,
+					   unsigned int bytes)
+{
+	struct ufs_wb_policy *policy = &hba->wb_policy;
+
+	if (!ufshcd_is_wb_allowed(hba))
+		return;
+
+	policy->written += bytes;
+	if (policy->written < UFSHCD_WB_SAMPLE_BYTES)
+		return;
+
+	policy->written = 0;
+	queue_work(system_freezable_wq, &policy->sample_work);
+}
+
 static bool ufshcd_wb_presrv_usrspc_keep_vcc_on(struct ufs_hba *hba,
 						u32 avail_buf)
 {
@@ -5685,11 +6059,8 @@ static bool ufshcd_wb_presrv_usrspc_keep_vcc_on(struct ufs_hba *hba,
 			 cur_buf);
 		return false;
 	}
-	/* Let it continue to flush when available buffer exceeds threshold */
-	if (avail_buf < hba->vps->wb_flush_threshold)
-		return true;
 
-	return false;
+	return ufshcd_wb_policy_wants_flush(hba, avail_buf);
 }
 
 static bool ufshcd_wb_need_flush(struct ufs_hba *hba)
@@ -5703,29 +6074,19 @@ static bool ufshcd_wb_need_flush(struct ufs_hba *hba)
 	/*
 	 * The ufs device needs the vcc to be ON to flush.
 	 * With user-space reduction enabled, it's enough to enable flush
-	 * by checking only the available buffer. The threshold
-	 * defined here is > 90% full.
+	 * by checking only the available buffer against the flush policy.
 	 * With user-space preserved enabled, the current-buffer
 	 * should be checked too because the wb buffer size can reduce
 	 * when disk tends to be full. This info is provided by current
 	 * buffer (dCurrentWriteBoosterBufferSize). There's no point in
 	 * keeping vcc on when current buffer is empty.
 	 */
-	index = ufshcd_wb_get_query_index(hba);
-	ret = ufshcd_query_attr_retry(hba, UPIU_QUERY_OPCODE_READ_ATTR,
-				      QUERY_ATTR_IDN_AVAIL_WB_BUFF_SIZE,
-				      index, 0, &avail_buf);
-	if (ret) {
-		dev_warn(hba->dev, "%s dAvailableWriteBoosterBufferSize read failed %d\n",
-			 __func__, ret);
+	ret = ufshcd_wb_read_avail_buf(hba, &avail_buf);
+	if (ret)
 		return false;
-	}
 
-	if (!hba->dev_info.b_presrv_uspc_en) {
-		if (avail_buf <= UFS_WB_BUF_REMAIN_PERCENT(10))
-			return true;
-		return false;
-	}
+	if (!hba->dev_info.b_presrv_uspc_en)
+		return ufshcd_wb_policy_wants_flush(hba, avail_buf);
 
 	return ufshcd_wb_presrv_usrspc_keep_vcc_on(hba, avail_buf);
 }
@@ -7456,6 +7817,8 @@ static int ufs_get_device_desc(struct ufs_hba *hba)
 
 	ufshcd_wb_probe(hba, desc_buf);
 
+	ufshpb_get_dev_info(hba, desc_buf);
+
 	/*
 	 * ufshcd_read_string_desc returns size of the string
 	 * reset the error value
@@ -7942,6 +8305,7 @@ static int ufshcd_probe_hba(struct ufs_hba *hba, bool async)
 	ufshcd_set_active_icc_lvl(hba);
 
 	ufshcd_wb_config(hba);
+	ufshpb_config(hba);
 	/* Enable Auto-Hibernate if configured */
 	ufshcd_auto_hibern8_enable(hba);
 
@@ -8026,6 +8390,7 @@ static enum blk_eh_timer_return ufshcd_eh_timed_out(struct scsi_cmnd *scmd)
 static const struct attribute_group *ufshcd_driver_groups[] = {
 	&ufs_sysfs_unit_descriptor_group,
 	&ufs_sysfs_lun_attributes_group,
+	&ufs_sysfs_hpb_stats_group,
 	NULL,
 };
 
@@ -8044,6 +8409,7 @@ static struct scsi_host_template ufshcd_driver_template = {
 	.name			= UFSHCD,
 	.proc_name		= UFSHCD,
 	.queuecommand		= ufshcd_queuecommand,
+	.commit_rqs		= ufshcd_commit_rqs,
 	.slave_alloc		= ufshcd_slave_alloc,
 	.slave_configure	= ufshcd_slave_configure,
 	.slave_destroy		= ufshcd_slave_destroy,
@@ -9706,14 +10072,19 @@ void ufshcd_remove(struct ufs_hba *hba)
 	ufs_sysfs_remove_nodes(hba->dev);
 	scsi_remove_host(hba->host);
 	destroy_workqueue(hba->eh_wq);
+	cancel_work_sync(&hba->wb_policy.sample_work);
 	/* disable interrupts */
 	ufshcd_disable_intr(hba, hba->intr_mask);
 	ufshcd_hba_stop(hba, true);
 
 	ufshcd_exit_clk_scaling(hba);
 	ufshcd_exit_clk_gating(hba);
-	if (ufshcd_is_clkscaling_supported(hba))
+	if (ufshcd_is_clkscaling_supported(hba)) {
 		device_remove_file(hba->dev, &hba->clk_scaling.enable_attr);
+		device_remove_file(hba->dev, &hba->clk_scaling.boost_attr);
+		device_remove_file(hba->dev,
+				   &hba->clk_scaling.boost_qdepth_attr);
+	}
 	ufshcd_hba_exit(hba);
 }
 EXPORT_SYMBOL_GPL(ufshcd_remove);
@@ -9984,6 +10355,8 @@ int ufshcd_init(struct ufs_hba *hba, void __iomem *mmio_base, unsigned int irq)
 
 	INIT_DELAYED_WORK(&hba->rpm_dev_flush_recheck_work,
 			  ufshcd_rpm_dev_flush_recheck_work);
+	INIT_WORK(&hba->wb_policy.sample_work, ufshcd_wb_sample_work);
+	hba->wb_policy.reserve = hba->vps->wb_flush_threshold;
 
 	/* Set the default auto-hiberate idle timer value to 150 ms */
 	if (ufshcd_is_auto_hibern8_supported(hba) && !hba->ahit) {
@@ -491,6 +491,15 @@ struct ufs_saved_pwr_info {
  * @is_allowed: tracks if scaling is currently allowed or not
  * @is_busy_started: tracks if busy period has started or not
  * @is_suspended: tracks if devfreq is suspended or not
+ * @boost_attr: sysfs attribute to request a boost for a number of ms
+ * @boost_qdepth_attr: sysfs attribute to tune @boost_qdepth
+ * @boost_work: worker scaling up ahead of the devfreq polling window
+ * @boost_until: devfreq is not allowed to scale down before this time
+ * @boost_trigger_t: time the pending boost was requested
+ * @boost_trigger: what requested the pending boost
+ * @boost_qdepth: outstanding requests that trigger a boost, 0 disables
+ * @boost_scale_us: duration of the last scale up done by devfreq target
+ * @boost_node: entry in the list of hosts reached by ufshcd_boost_hint()
  */
 struct ufs_clk_scaling {
 	int active_reqs;
@@ -505,6 +514,15 @@ struct ufs_clk_scaling {
 	bool is_allowed;
 	bool is_busy_started;
 	bool is_suspended;
+	struct device_attribute boost_attr;
+	struct device_attribute boost_qdepth_attr;
+	struct work_struct boost_work;
+	ktime_t boost_until;
+	ktime_t boost_trigger_t;
+	const char *boost_trigger;
+	int boost_qdepth;
+	s64 boost_scale_us;
+	struct list_head boost_node;
 };
 
 #ifdef CONFIG_SCSI_UFSHCD_QTI
@@ -619,6 +637,8 @@ struct ufs_err_reg_hist {
  *		reset this after link-startup.
  * @last_hibern8_exit_tstamp: Set time after the hibern8 exit.
  *		Clear after the first successful command completion.
+ * @db_batch_hist: doorbell writes by the number of requests they issued,
+ *		in log2 buckets: 1, 2, 3-4, 5-8, ...
  * @pa_err: tracks pa-uic errors
  * @dl_err: tracks dl-uic errors
  * @nl_err: tracks nl-uic errors
@@ -640,6 +660,9 @@ struct ufs_stats {
 	u32 hibern8_exit_cnt;
 	ktime_t last_hibern8_exit_tstamp;
 
+#define UFSHCD_DB_BATCH_BUCKETS	6
+	u64 db_batch_hist[UFSHCD_DB_BATCH_BUCKETS];
+
 #ifdef CONFIG_SCSI_UFSHCD_QTI
 #ifdef CONFIG_DEBUG_FS
 	bool enabled;
@@ -678,6 +701,25 @@ struct ufs_stats {
 	struct ufs_err_reg_hist task_abort;
 };
 
+/**
+ * struct ufs_wb_policy - WriteBooster flush policy state
+ * @sample_work: re-reads the available buffer after a burst of writes
+ * @written: bytes written since the available buffer was last read
+ * @avail_buf: last dAvailableWriteBoosterBufferSize, in 10% units
+ * @reserve: available buffer, in 10% units, kept free for foreground bursts
+ * @idle_hint: a long idle period is expected (screen off, charging), flush
+ *	the whole buffer instead of only defending @reserve
+ * @flush_h8_enabled: fWriteBoosterBufferFlushDuringHibernate is set
+ */
+struct ufs_wb_policy {
+	struct work_struct sample_work;
+	u64 written;
+	u32 avail_buf;
+	u32 reserve;
+	bool idle_hint;
+	bool flush_h8_enabled;
+};
+
 struct ufs_hba_variant_params {
 	struct devfreq_dev_profile devfreq_profile;
 	struct devfreq_simple_ondemand_data ondemand_data;
@@ -700,6 +742,8 @@ struct ufs_hba_variant_params {
  * @lrb_in_use: lrb in use
  * @outstanding_tasks: Bits representing outstanding task requests
  * @outstanding_reqs: Bits representing outstanding transfer requests
+ * @pending_reqs: transfer requests of the current dispatch batch, prepared
+ *	but not yet issued through the doorbell
  * @capabilities: UFS Controller Capabilities
  * @nutrs: Transfer Request Queue depth supported by controller
  * @nutmrs: Task Management Queue depth supported by controller
@@ -800,6 +844,7 @@ struct ufs_hba {
 
 	unsigned long outstanding_tasks;
 	unsigned long outstanding_reqs;
+	unsigned long pending_reqs;
 
 	u32 capabilities;
 	int nutrs;
@@ -991,6 +1036,11 @@ struct ufs_hba {
 	 * provisioned to be used. This would increase the write performance.
 	 */
 #define	UFSHCD_CAP_WB_EN (1 << 8)
+	/*
+	 * Complete requests submitted from another CPU cluster on the
+	 * submitting CPU instead of the CPU taking the UFS interrupt.
+	 */
+#define UFSHCD_CAP_CLUSTER_COMPLETION (1 << 11)
 
 #ifdef CONFIG_SCSI_UFSHCD_QTI
 #define UFSHCD_CAP_POWER_COLLAPSE_DURING_HIBERN8 (1 << 9)
@@ -1042,6 +1092,7 @@ struct ufs_hba {
 
 	bool wb_buf_flush_enabled;
 	bool wb_enabled;
+	struct ufs_wb_policy wb_policy;
 	struct delayed_work rpm_dev_flush_recheck_work;
 	ANDROID_KABI_RESERVE(1);
 	ANDROID_KABI_RESERVE(2);
@@ -1107,6 +1158,11 @@ static inline bool ufshcd_is_power_collapse_during_hibern8_allowed(
 	return !!(hba->caps & UFSHCD_CAP_POWER_COLLAPSE_DURING_HIBERN8);
 }
 
+static inline bool ufshcd_is_cluster_completion_allowed(struct ufs_hba *hba)
+{
+	return hba->caps & UFSHCD_CAP_CLUSTER_COMPLETION;
+}
+
 static inline bool ufshcd_is_hibern8_on_idle_allowed(struct ufs_hba *hba)
 {
 	return hba->caps & UFSHCD_CAP_HIBERN8_ENTER_ON_IDLE;
@@ -1316,6 +1372,7 @@ void ufshcd_fixup_dev_quirks(struct ufs_hba *hba, struct ufs_dev_fix *fixups);
 
 int ufshcd_hold(struct ufs_hba *hba, bool async);
 void ufshcd_release(struct ufs_hba *hba);
+void ufshcd_clkscale_boost(struct ufs_hba *hba, unsigned int hold_ms);
 
 int ufshcd_map_desc_id_to_length(struct ufs_hba *hba, enum desc_idn desc_id,
 	int *desc_length);
@@ -1324,6 +1381,7 @@ u32 ufshcd_get_local_unipro_ver(struct ufs_hba *hba);
 
 int ufshcd_send_uic_cmd(struct ufs_hba *hba, struct uic_command *uic_cmd);
 int ufshcd_wb_ctrl(struct ufs_hba *hba, bool enable);
+void ufshcd_wb_policy_update(struct ufs_hba *hba);
 
 int ufshcd_exec_raw_upiu_cmd(struct ufs_hba *hba,
 			     struct utp_upiu_req *req_upiu,
@@ -1487,6 +1545,7 @@ static inline void ufshcd_vops_device_reset(struct ufs_hba *hba)
 		if (ufshcd_is_wb_allowed(hba)) {
 			hba->wb_enabled = false;
 			hba->wb_buf_flush_enabled = false;
+			hba->wb_policy.flush_h8_enabled = false;
 		}
 		ufshcd_update_reg_hist(&hba->ufs_stats.dev_reset, 0);
 	}
@@ -0,0 +1,694 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * UFS Host Performance Booster, host control mode
+ *
+ * The host keeps part of the device's logical to physical (L2P) table in
+ * DRAM and sends the physical address along with small reads, which saves
+ * the device a map lookup that would otherwise miss its SRAM cache on a
+ * large, aged partition. In host control mode the host picks what to cache;
+ * a subregion is loaded once it sees enough reads and evicted in LRU order
+ * when the memory budget or the device's active region limit is reached.
+ */
+
+#include <asm/unaligned.h>
+#include <linux/bitmap.h>
+#include <linux/blkdev.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <scsi/scsi_device.h>
+
+#include "ufshcd.h"
+#include "ufshpb.h"
+
+/* Reads within HPB_HEAT_WINDOW that make a subregion worth caching */
+#define HPB_HEAT_THRESH			4
+#define HPB_HEAT_WINDOW			HZ
+
+#define HPB_DEFAULT_MEM_BUDGET		SZ_16M
+#define HPB_CMD_TIMEOUT			(10 * HZ)
+#define HPB_CMD_RETRIES			3
+#define HPB_RESET_TIMEOUT_MS		1000
+
+#define HPB_NO_RGN			U32_MAX
+
+static u32 ufshpb_srgn_entries(struct ufshpb_lu *hpb, u32 idx)
+{
+	u64 start = (u64)idx << hpb->srgn_shift;
+
+	return min_t(u64, 1U << hpb->srgn_shift, hpb->lu_blocks - start);
+}
+
+static inline bool ufshpb_range_dirty(struct ufshpb_subregion *srgn,
+				      u32 entry, u32 len)
+{
+	return find_next_bit(srgn->dirty, entry + len, entry) < entry + len;
+}
+
+/* Needs hpb->lock */
+static void ufshpb_mark_dirty(struct ufshpb_lu *hpb, u64 lba, u32 len)
+{
+	struct ufshpb_subregion *srgn;
+	u32 idx, entry, cnt;
+
+	while (len) {
+		idx = lba >> hpb->srgn_shift;
+		if (idx >= hpb->nr_srgns)
+			return;
+
+		entry = lba & ((1U << hpb->srgn_shift) - 1);
+		if (entry >= ufshpb_srgn_entries(hpb, idx))
+			return;
+		cnt = min(len, ufshpb_srgn_entries(hpb, idx) - entry);
+
+		srgn = &hpb->srgns[idx];
+		if (srgn->state != HPB_SRGN_INACTIVE && srgn->dirty)
+			bitmap_set(srgn->dirty, entry, cnt);
+
+		lba += cnt;
+		len -= cnt;
+	}
+}
+
+static void ufshpb_set_hpb_read(struct scsi_cmnd *cmd, u32 lba, u32 len,
+				u64 ppn)
+{
+	unsigned char *cdb = cmd->cmnd;
+
+	/* cdb[1] keeps the DPO/FUA bits of the original READ */
+	cdb[0] = UFSHPB_READ;
+	put_unaligned_be32(lba, &cdb[2]);
+	/* the entry is passed back exactly as the device gave it to us */
+	memcpy(&cdb[6], &ppn, sizeof(ppn));
+	cdb[14] = len;
+	cdb[15] = 0;
+	cmd->cmd_len = UFS_CDB_SIZE;
+}
+
+/**
+ * ufshpb_prep - turn a cached read into an HPB READ
+ * @hba: per adapter instance
+ * @lrbp: local reference block of the command, before the UPIU is composed
+ *
+ * Writes and discards invalidate the entries they cover. Reads that miss
+ * heat up their subregion and queue a map load once it is hot enough.
+ */
+void ufshpb_prep(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
+{
+	struct scsi_cmnd *cmd = lrbp->cmd;
+	struct ufshpb_lu *hpb = ufshpb_get_lu(cmd->device);
+	struct request *rq = cmd->request;
+	struct ufshpb_subregion *srgn;
+	bool queue_load = false;
+	unsigned long flags;
+	u32 idx, entry, len;
+	u64 lba, ppn;
+
+	if (!hpb || blk_rq_is_passthrough(rq))
+		return;
+
+	lba = blk_rq_pos(rq) >> (HPB_ENTRY_BLOCK_SHIFT - SECTOR_SHIFT);
+	len = blk_rq_bytes(rq) >> HPB_ENTRY_BLOCK_SHIFT;
+	if (!len)
+		return;
+
+	if (op_is_write(req_op(rq))) {
+		spin_lock_irqsave(&hpb->lock, flags);
+		ufshpb_mark_dirty(hpb, lba, len);
+		spin_unlock_irqrestore(&hpb->lock, flags);
+		return;
+	}
+
+	if (cmd->cmnd[0] != READ_10 && cmd->cmnd[0] != READ_16)
+		return;
+
+	idx = lba >> hpb->srgn_shift;
+	if (idx >= hpb->nr_srgns)
+		return;
+
+	srgn = &hpb->srgns[idx];
+	entry = lba & ((1U << hpb->srgn_shift) - 1);
+
+	spin_lock_irqsave(&hpb->lock, flags);
+
+	if (srgn->state == HPB_SRGN_VALID && !hpb->reset_pending &&
+	    len <= hpb->max_single_cmd && lba + len <= U32_MAX &&
+	    entry + len <= ufshpb_srgn_entries(hpb, idx) &&
+	    !ufshpb_range_dirty(srgn, entry, len)) {
+		ppn = srgn->map[entry];
+		if (!srgn->pinned)
+			list_move_tail(&srgn->list, &hpb->lru);
+		hpb->stats.hit_cnt++;
+		spin_unlock_irqrestore(&hpb->lock, flags);
+
+		ufshpb_set_hpb_read(cmd, lba, len, ppn);
+		return;
+	}
+
+	hpb->stats.miss_cnt++;
+
+	/* a valid but dirty subregion heats up for a reload */
+	if (srgn->state == HPB_SRGN_LOADING || hpb->reset_pending)
+		goto out;
+
+	if (time_after(jiffies, srgn->last_read + HPB_HEAT_WINDOW))
+		srgn->reads = 0;
+	srgn->last_read = jiffies;
+
+	if (++srgn->reads >= HPB_HEAT_THRESH) {
+		srgn->reads = 0;
+		srgn->state = HPB_SRGN_LOADING;
+		list_move_tail(&srgn->list, &hpb->load_list);
+		queue_load = true;
+	}
+
+out:
+	spin_unlock_irqrestore(&hpb->lock, flags);
+
+	if (queue_load)
+		queue_work(hpb->map_wq, &hpb->map_work);
+}
+
+static int ufshpb_issue_read_buffer(struct ufshpb_lu *hpb,
+				    struct ufshpb_subregion *srgn, u32 len)
+{
+	unsigned char cdb[10] = { 0 };
+	struct scsi_sense_hdr sshdr;
+	int ret;
+
+	cdb[0] = UFSHPB_READ_BUFFER;
+	cdb[1] = UFSHPB_READ_BUFFER_ID;
+	put_unaligned_be16(srgn->rgn_idx, &cdb[2]);
+	put_unaligned_be16(srgn->srgn_idx, &cdb[4]);
+	cdb[6] = len >> 16;
+	cdb[7] = len >> 8;
+	cdb[8] = len;
+
+	ret = scsi_execute(hpb->sdev, cdb, DMA_FROM_DEVICE, srgn->map, len,
+			   NULL, &sshdr, HPB_CMD_TIMEOUT, HPB_CMD_RETRIES,
+			   0, 0, NULL);
+	if (ret)
+		sdev_printk(KERN_DEBUG, hpb->sdev,
+			    "HPB READ BUFFER %u:%u failed %d, sense %x/%x/%x\n",
+			    srgn->rgn_idx, srgn->srgn_idx, ret, sshdr.sense_key,
+			    sshdr.asc, sshdr.ascq);
+
+	return ret;
+}
+
+static void ufshpb_issue_inactivate(struct ufshpb_lu *hpb, u32 rgn_idx)
+{
+	unsigned char cdb[10] = { 0 };
+	int ret;
+
+	cdb[0] = UFSHPB_WRITE_BUFFER;
+	cdb[1] = UFSHPB_WRITE_BUFFER_INACT_ID;
+	put_unaligned_be16(rgn_idx, &cdb[2]);
+
+	ret = scsi_execute(hpb->sdev, cdb, DMA_NONE, NULL, 0, NULL, NULL,
+			   HPB_CMD_TIMEOUT, HPB_CMD_RETRIES, 0, 0, NULL);
+	if (ret)
+		sdev_printk(KERN_DEBUG, hpb->sdev,
+			    "HPB region %u inactivation failed %d\n",
+			    rgn_idx, ret);
+}
+
+/* Needs hpb->lock */
+static u32 ufshpb_release_srgn(struct ufshpb_lu *hpb,
+			       struct ufshpb_subregion *srgn)
+{
+	u32 rgn_idx = srgn->rgn_idx;
+
+	kfree(srgn->map);
+	bitmap_free(srgn->dirty);
+	srgn->map = NULL;
+	srgn->dirty = NULL;
+	srgn->state = HPB_SRGN_INACTIVE;
+	srgn->reads = 0;
+
+	hpb->nr_active_srgns--;
+	if (--hpb->rgn_active[rgn_idx])
+		return HPB_NO_RGN;
+
+	hpb->nr_active_rgns--;
+	return rgn_idx;
+}
+
+/*
+ * Needs hpb->lock. Drops the least recently read subregion and returns the
+ * region that went idle with it, if any.
+ */
+static bool ufshpb_evict_lru(struct ufshpb_lu *hpb, u32 *inact_rgn)
+{
+	struct ufshpb_subregion *victim;
+
+	victim = list_first_entry_or_null(&hpb->lru, struct ufshpb_subregion,
+					  list);
+	if (!victim)
+		return false;
+
+	list_del_init(&victim->list);
+	*inact_rgn = ufshpb_release_srgn(hpb, victim);
+	hpb->stats.evict_cnt++;
+
+	return true;
+}
+
+static bool ufshpb_over_budget(struct ufshpb_lu *hpb,
+			       struct ufshpb_subregion *srgn)
+{
+	if (srgn->pinned)
+		return false;
+
+	if (hpb->nr_active_srgns >= hpb->max_active_srgns)
+		return true;
+
+	return !hpb->rgn_active[srgn->rgn_idx] &&
+	       hpb->nr_active_rgns >= hpb->max_active_rgns;
+}
+
+/* Evict until @srgn fits, then account it as active */
+static int ufshpb_make_room(struct ufshpb_lu *hpb,
+			    struct ufshpb_subregion *srgn)
+{
+	u32 inact_rgn;
+	int ret = 0;
+
+	spin_lock_irq(&hpb->lock);
+	while (ufshpb_over_budget(hpb, srgn)) {
+		if (!ufshpb_evict_lru(hpb, &inact_rgn)) {
+			ret = -ENOSPC;
+			goto out;
+		}
+
+		if (inact_rgn == HPB_NO_RGN)
+			continue;
+
+		hpb->stats.rgn_inactivate_cnt++;
+		spin_unlock_irq(&hpb->lock);
+		ufshpb_issue_inactivate(hpb, inact_rgn);
+		spin_lock_irq(&hpb->lock);
+	}
+
+	hpb->nr_active_srgns++;
+	if (!hpb->rgn_active[srgn->rgn_idx]++)
+		hpb->nr_active_rgns++;
+out:
+	spin_unlock_irq(&hpb->lock);
+	return ret;
+}
+
+static void ufshpb_load_srgn(struct ufshpb_lu *hpb,
+			     struct ufshpb_subregion *srgn)
+{
+	u32 idx = srgn - hpb->srgns;
+	u32 entries = ufshpb_srgn_entries(hpb, idx);
+	u32 inact_rgn = HPB_NO_RGN;
+	u64 *map = NULL;
+	unsigned long *dirty = NULL;
+	int ret;
+
+	/* a reload reuses the map the subregion already holds */
+	if (!srgn->map) {
+		map = kmalloc_array(entries, HPB_ENTRY_SIZE,
+				    GFP_KERNEL | __GFP_NOWARN);
+		dirty = bitmap_zalloc(entries, GFP_KERNEL | __GFP_NOWARN);
+		if (!map || !dirty || ufshpb_make_room(hpb, srgn)) {
+			kfree(map);
+			bitmap_free(dirty);
+			spin_lock_irq(&hpb->lock);
+			srgn->state = HPB_SRGN_INACTIVE;
+			hpb->stats.map_load_fail_cnt++;
+			spin_unlock_irq(&hpb->lock);
+			return;
+		}
+	}
+
+	/* writes from here on mark the new map dirty */
+	spin_lock_irq(&hpb->lock);
+	if (map) {
+		srgn->map = map;
+		srgn->dirty = dirty;
+	} else {
+		bitmap_zero(srgn->dirty, entries);
+	}
+	spin_unlock_irq(&hpb->lock);
+
+	ret = ufshpb_issue_read_buffer(hpb, srgn, entries * HPB_ENTRY_SIZE);
+
+	spin_lock_irq(&hpb->lock);
+	if (ret) {
+		hpb->stats.map_load_fail_cnt++;
+		inact_rgn = ufshpb_release_srgn(hpb, srgn);
+	} else {
+		hpb->stats.map_load_cnt++;
+		srgn->state = HPB_SRGN_VALID;
+		if (!srgn->pinned)
+			list_add_tail(&srgn->list, &hpb->lru);
+	}
+	spin_unlock_irq(&hpb->lock);
+
+	if (inact_rgn != HPB_NO_RGN)
+		ufshpb_issue_inactivate(hpb, inact_rgn);
+}
+
+/* Needs hpb->lock */
+static void ufshpb_queue_pinned(struct ufshpb_lu *hpb)
+{
+	struct ufshpb_subregion *srgn;
+	u32 i;
+
+	for (i = 0; i < hpb->nr_srgns; i++) {
+		srgn = &hpb->srgns[i];
+		if (!srgn->pinned || srgn->state != HPB_SRGN_INACTIVE)
+			continue;
+
+		srgn->state = HPB_SRGN_LOADING;
+		list_add_tail(&srgn->list, &hpb->load_list);
+	}
+}
+
+/*
+ * The device forgot every active region across a reset. Only the map work
+ * loads maps, so nothing is in flight while this runs.
+ */
+static void ufshpb_drop_all(struct ufshpb_lu *hpb)
+{
+	struct ufshpb_subregion *srgn;
+	u32 i;
+
+	spin_lock_irq(&hpb->lock);
+	for (i = 0; i < hpb->nr_srgns; i++) {
+		srgn = &hpb->srgns[i];
+		list_del_init(&srgn->list);
+		if (srgn->map)
+			ufshpb_release_srgn(hpb, srgn);
+		srgn->state = HPB_SRGN_INACTIVE;
+	}
+
+	WARN_ON(hpb->nr_active_srgns || hpb->nr_active_rgns);
+	hpb->reset_pending = false;
+	ufshpb_queue_pinned(hpb);
+	spin_unlock_irq(&hpb->lock);
+}
+
+static void ufshpb_map_work_handler(struct work_struct *work)
+{
+	struct ufshpb_lu *hpb = container_of(work, struct ufshpb_lu, map_work);
+	struct ufshpb_subregion *srgn;
+	u32 inact_rgn;
+
+	if (READ_ONCE(hpb->reset_pending))
+		ufshpb_drop_all(hpb);
+
+	/* the budget may have been lowered through sysfs */
+	spin_lock_irq(&hpb->lock);
+	while (hpb->nr_active_srgns > hpb->max_active_srgns &&
+	       ufshpb_evict_lru(hpb, &inact_rgn)) {
+		if (inact_rgn == HPB_NO_RGN)
+			continue;
+
+		hpb->stats.rgn_inactivate_cnt++;
+		spin_unlock_irq(&hpb->lock);
+		ufshpb_issue_inactivate(hpb, inact_rgn);
+		spin_lock_irq(&hpb->lock);
+	}
+	spin_unlock_irq(&hpb->lock);
+
+	for (;;) {
+		spin_lock_irq(&hpb->lock);
+		srgn = list_first_entry_or_null(&hpb->load_list,
+						struct ufshpb_subregion, list);
+		if (srgn)
+			list_del_init(&srgn->list);
+		spin_unlock_irq(&hpb->lock);
+
+		if (!srgn)
+			break;
+
+		ufshpb_load_srgn(hpb, srgn);
+	}
+}
+
+void ufshpb_set_mem_budget(struct ufshpb_lu *hpb, u64 bytes)
+{
+	u64 srgns = div_u64(bytes, ufshpb_srgn_mem_size(hpb));
+
+	spin_lock_irq(&hpb->lock);
+	hpb->max_active_srgns = clamp_t(u64, srgns, 1, hpb->nr_srgns);
+	spin_unlock_irq(&hpb->lock);
+
+	queue_work(hpb->map_wq, &hpb->map_work);
+}
+
+static int ufshpb_reset_dev(struct ufs_hba *hba)
+{
+	ktime_t timeout;
+	bool flag_res = true;
+	int err;
+
+	err = ufshcd_query_flag(hba, UPIU_QUERY_OPCODE_SET_FLAG,
+				QUERY_FLAG_IDN_HPB_RESET, 0, NULL);
+	if (err)
+		return err;
+
+	timeout = ktime_add_ms(ktime_get(), HPB_RESET_TIMEOUT_MS);
+	do {
+		err = ufshcd_query_flag(hba, UPIU_QUERY_OPCODE_READ_FLAG,
+					QUERY_FLAG_IDN_HPB_RESET, 0, &flag_res);
+		if (err || !flag_res)
+			break;
+		usleep_range(1000, 1100);
+	} while (ktime_before(ktime_get(), timeout));
+
+	if (!err && flag_res)
+		err = -ETIMEDOUT;
+
+	return err;
+}
+
+/**
+ * ufshpb_get_dev_info - probe device wide HPB support
+ * @hba: per adapter instance
+ * @desc_buf: device descriptor
+ *
+ * Only HPB 2.0 devices provisioned for host control mode are used, the
+ * device control flow of HPB 1.0 is not implemented.
+ */
+void ufshpb_get_dev_info(struct ufs_hba *hba, u8 *desc_buf)
+{
+	struct ufs_dev_info *dev_info = &hba->dev_info;
+	struct ufshpb_dev_info *hpb_dev = &dev_info->hpb_dev;
+	u8 geo[GEOMETRY_DESC_PARAM_HPB_MAX_ACTIVE_REGS + 2 -
+	       GEOMETRY_DESC_PARAM_HPB_REGION_SIZE];
+	u32 max_single_cmd;
+	u16 version;
+	int err;
+
+	dev_info->hpb_enabled = false;
+
+	if (hba->desc_size.dev_desc < DEVICE_DESC_PARAM_HPB_CONTROL + 1 ||
+	    !(desc_buf[DEVICE_DESC_PARAM_UFS_FEAT] & UFS_DEV_HPB_SUPPORT))
+		return;
+
+	version = get_unaligned_be16(desc_buf + DEVICE_DESC_PARAM_HPB_VER);
+	if (version < HPB_SUPPORT_VERSION ||
+	    desc_buf[DEVICE_DESC_PARAM_HPB_CONTROL] != HPB_HOST_CONTROL) {
+		dev_info(hba->dev, "HPB %x in %s control mode not supported\n",
+			 version, desc_buf[DEVICE_DESC_PARAM_HPB_CONTROL] ==
+			 HPB_HOST_CONTROL ? "host" : "device");
+		return;
+	}
+
+	if (hba->desc_size.geom_desc <
+	    GEOMETRY_DESC_PARAM_HPB_MAX_ACTIVE_REGS + 2)
+		return;
+
+	err = ufshcd_read_desc_param(hba, QUERY_DESC_IDN_GEOMETRY, 0,
+				     GEOMETRY_DESC_PARAM_HPB_REGION_SIZE,
+				     geo, sizeof(geo));
+	if (err)
+		return;
+
+	hpb_dev->rgn_size = geo[0];
+	hpb_dev->num_lu = geo[1];
+	hpb_dev->srgn_size = geo[2];
+	hpb_dev->max_active_rgns = get_unaligned_be16(&geo[3]);
+
+	/* a subregion holds at least one 4KB entry */
+	if (!hpb_dev->num_lu || !hpb_dev->max_active_rgns ||
+	    hpb_dev->srgn_size > hpb_dev->rgn_size ||
+	    hpb_dev->srgn_size + SECTOR_SHIFT < HPB_ENTRY_BLOCK_SHIFT) {
+		dev_err(hba->dev, "invalid HPB geometry %u/%u/%u/%u\n",
+			hpb_dev->rgn_size, hpb_dev->srgn_size,
+			hpb_dev->num_lu, hpb_dev->max_active_rgns);
+		return;
+	}
+
+	hpb_dev->max_single_cmd = 1;
+	if (!ufshcd_query_attr(hba, UPIU_QUERY_OPCODE_READ_ATTR,
+			       QUERY_ATTR_IDN_MAX_HPB_SINGLE_CMD, 0, 0,
+			       &max_single_cmd))
+		hpb_dev->max_single_cmd = min_t(u32, max_single_cmd + 1,
+						HPB_SINGLE_CMD_MAX);
+
+	err = ufshpb_reset_dev(hba);
+	if (err) {
+		dev_err(hba->dev, "HPB reset failed %d\n", err);
+		return;
+	}
+
+	dev_info->hpb_enabled = true;
+}
+
+/**
+ * ufshpb_config - (re)enable HPB after the device was initialized
+ * @hba: per adapter instance
+ *
+ * Called on every device (re)initialization. Any map the host holds is
+ * stale once the device went through a reset, so every LU drops its cache.
+ */
+void ufshpb_config(struct ufs_hba *hba)
+{
+	struct scsi_device *sdev;
+	struct ufshpb_lu *hpb;
+	int err;
+
+	if (!hba->dev_info.hpb_enabled)
+		return;
+
+	err = ufshcd_query_flag(hba, UPIU_QUERY_OPCODE_SET_FLAG,
+				QUERY_FLAG_IDN_HPB_EN, 0, NULL);
+	if (err)
+		dev_warn(hba->dev, "setting fHPBEn failed %d\n", err);
+
+	shost_for_each_device(sdev, hba->host) {
+		hpb = ufshpb_get_lu(sdev);
+		if (!hpb)
+			continue;
+
+		spin_lock_irq(&hpb->lock);
+		hpb->reset_pending = true;
+		spin_unlock_irq(&hpb->lock);
+		queue_work(hpb->map_wq, &hpb->map_work);
+	}
+}
+
+void ufshpb_init_lu(struct ufs_hba *hba, struct scsi_device *sdev)
+{
+	struct ufshpb_dev_info *hpb_dev = &hba->dev_info.hpb_dev;
+	u8 lun = ufshcd_scsi_to_upiu_lun(sdev->lun);
+	u16 lu_max_active, pin_start, num_pin;
+	u8 desc[UNIT_DESC_PARAM_HPB_NUM_PIN_RGNS + 2];
+	struct ufshpb_subregion *srgn;
+	struct ufshpb_lu *hpb;
+	u32 srgn_shift, i;
+
+	if (!hba->dev_info.hpb_enabled || lun >= UFS_UPIU_MAX_GENERAL_LUN ||
+	    hba->desc_size.unit_desc < sizeof(desc))
+		return;
+
+	if (ufshcd_read_desc_param(hba, QUERY_DESC_IDN_UNIT, lun, 0,
+				   desc, sizeof(desc)))
+		return;
+
+	/* HPB entries map 4KB blocks, nothing else can be looked up */
+	if (desc[UNIT_DESC_PARAM_LU_ENABLE] != LU_ENABLED_HPB_FUNC ||
+	    desc[UNIT_DESC_PARAM_LOGICAL_BLK_SIZE] != HPB_ENTRY_BLOCK_SHIFT)
+		return;
+
+	hpb = kzalloc(sizeof(*hpb), GFP_KERNEL);
+	if (!hpb)
+		return;
+
+	srgn_shift = hpb_dev->srgn_size + SECTOR_SHIFT - HPB_ENTRY_BLOCK_SHIFT;
+	hpb->sdev = sdev;
+	hpb->srgn_shift = srgn_shift;
+	hpb->srgns_per_rgn = 1U << (hpb_dev->rgn_size - hpb_dev->srgn_size);
+	hpb->lu_blocks = get_unaligned_be64(&desc[UNIT_DESC_PARAM_LOGICAL_BLK_COUNT]);
+	hpb->nr_srgns = DIV_ROUND_UP_ULL(hpb->lu_blocks, 1ULL << srgn_shift);
+	hpb->nr_rgns = DIV_ROUND_UP(hpb->nr_srgns, hpb->srgns_per_rgn);
+	hpb->max_single_cmd = hpb_dev->max_single_cmd;
+
+	lu_max_active = get_unaligned_be16(
+			&desc[UNIT_DESC_PARAM_HPB_LU_MAX_ACTIVE_RGNS]);
+	hpb->max_active_rgns = lu_max_active ?: hpb_dev->max_active_rgns;
+	hpb->max_active_srgns = clamp_t(u32, HPB_DEFAULT_MEM_BUDGET >>
+					(srgn_shift + ilog2(HPB_ENTRY_SIZE)),
+					1, hpb->nr_srgns);
+
+	if (!hpb->nr_srgns || hpb->nr_rgns > U16_MAX + 1)
+		goto free_hpb;
+
+	spin_lock_init(&hpb->lock);
+	INIT_LIST_HEAD(&hpb->lru);
+	INIT_LIST_HEAD(&hpb->load_list);
+	INIT_WORK(&hpb->map_work, ufshpb_map_work_handler);
+
+	hpb->srgns = vzalloc(array_size(hpb->nr_srgns, sizeof(*hpb->srgns)));
+	hpb->rgn_active = vzalloc(array_size(hpb->nr_rgns,
+					     sizeof(*hpb->rgn_active)));
+	if (!hpb->srgns || !hpb->rgn_active)
+		goto free_arrays;
+
+	pin_start = get_unaligned_be16(
+			&desc[UNIT_DESC_PARAM_HPB_PIN_RGN_START_OFF]);
+	num_pin = get_unaligned_be16(&desc[UNIT_DESC_PARAM_HPB_NUM_PIN_RGNS]);
+
+	for (i = 0; i < hpb->nr_srgns; i++) {
+		srgn = &hpb->srgns[i];
+		INIT_LIST_HEAD(&srgn->list);
+		srgn->rgn_idx = i / hpb->srgns_per_rgn;
+		srgn->srgn_idx = i % hpb->srgns_per_rgn;
+		srgn->pinned = srgn->rgn_idx >= pin_start &&
+			       srgn->rgn_idx < pin_start + num_pin;
+	}
+
+	hpb->map_wq = alloc_ordered_workqueue("ufshpb_lu%d", WQ_MEM_RECLAIM,
+					      lun);
+	if (!hpb->map_wq)
+		goto free_arrays;
+
+	sdev->hostdata = hpb;
+
+	spin_lock_irq(&hpb->lock);
+	ufshpb_queue_pinned(hpb);
+	spin_unlock_irq(&hpb->lock);
+	queue_work(hpb->map_wq, &hpb->map_work);
+
+	sdev_printk(KERN_INFO, sdev,
+		    "HPB enabled: %u regions, %u subregions of %u KB, cache %u subregions\n",
+		    hpb->nr_rgns, hpb->nr_srgns,
+		    (1U << (srgn_shift + HPB_ENTRY_BLOCK_SHIFT)) / SZ_1K,
+		    hpb->max_active_srgns);
+	return;
+
+free_arrays:
+	vfree(hpb->srgns);
+	vfree(hpb->rgn_active);
+free_hpb:
+	kfree(hpb);
+}
+
+void ufshpb_destroy_lu(struct ufs_hba *hba, struct scsi_device *sdev)
+{
+	struct ufshpb_lu *hpb = ufshpb_get_lu(sdev);
+	u32 i;
+
+	if (!hpb)
+		return;
+
+	sdev->hostdata = NULL;
+	destroy_workqueue(hpb->map_wq);
+
+	for (i = 0; i < hpb->nr_srgns; i++) {
+		kfree(hpb->srgns[i].map);
+		bitmap_free(hpb->srgns[i].dirty);
+	}
+
+	vfree(hpb->srgns);
+	vfree(hpb->rgn_active);
+	kfree(hpb);
+}
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * UFS Host Performance Booster, host control mode
+ */
+
+#ifndef _UFSHPB_H
+#define _UFSHPB_H
+
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#include "ufshcd.h"
+
+/* HPB commands */
+#define UFSHPB_READ			0xF8
+#define UFSHPB_READ_BUFFER		0xF9
+#define UFSHPB_WRITE_BUFFER		0xFA
+
+#define UFSHPB_READ_BUFFER_ID		0x01
+#define UFSHPB_WRITE_BUFFER_INACT_ID	0x01
+
+#define HPB_SUPPORT_VERSION		0x200
+#define HPB_HOST_CONTROL		0x0
+#define LU_ENABLED_HPB_FUNC		0x02
+
+/* One L2P entry maps one 4KB logical block */
+#define HPB_ENTRY_SIZE			8
+#define HPB_ENTRY_BLOCK_SHIFT		12
+#define HPB_SINGLE_CMD_MAX		255
+
+enum ufshpb_srgn_state {
+	HPB_SRGN_INACTIVE,
+	/* queued for, or in the middle of, a map load */
+	HPB_SRGN_LOADING,
+	HPB_SRGN_VALID,
+};
+
+/**
+ * struct ufshpb_subregion - L2P cache unit
+ * @map: L2P entries as read from the device, in device byte order
+ * @dirty: one bit per entry written since the map was loaded
+ * @list: link on the LU's LRU while valid, or load list while loading
+ * @last_read: jiffies of the last read that touched the subregion
+ * @reads: reads seen in the current heat window
+ * @rgn_idx: region the subregion belongs to
+ * @srgn_idx: subregion index inside the region
+ * @state: enum ufshpb_srgn_state
+ * @pinned: part of a pinned region, never evicted
+ */
+struct ufshpb_subregion {
+	u64 *map;
+	unsigned long *dirty;
+	struct list_head list;
+	unsigned long last_read;
+	u32 reads;
+	u32 rgn_idx;
+	u16 srgn_idx;
+	u8 state;
+	bool pinned;
+};
+
+struct ufshpb_stats {
+	u64 hit_cnt;
+	u64 miss_cnt;
+	u64 map_load_cnt;
+	u64 map_load_fail_cnt;
+	u64 evict_cnt;
+	u64 rgn_inactivate_cnt;
+};
+
+/**
+ * struct ufshpb_lu - per LU HPB state
+ * @sdev: SCSI device of the LU
+ * @lock: protects the subregion states, lists and counters
+ * @srgns: all subregions of the LU, indexed by LBA
+ * @rgn_active: number of loaded or loading subregions per region
+ * @lru: valid, unpinned subregions in least recently read order
+ * @load_list: subregions waiting for a map load
+ * @map_work: loads, evicts and inactivates in process context
+ * @map_wq: ordered queue running @map_work
+ * @nr_srgns: number of subregions
+ * @srgn_shift: log2 of the entries in a subregion
+ * @srgns_per_rgn: subregions in a region
+ * @lu_blocks: number of logical blocks of the LU
+ * @nr_active_srgns: subregions holding or loading a map
+ * @nr_active_rgns: regions with at least one active subregion
+ * @max_active_srgns: memory budget expressed in subregion maps
+ * @max_active_rgns: device limit on active regions for the LU
+ * @max_single_cmd: largest HPB READ in logical blocks
+ * @reset_pending: device lost its HPB state, drop every map
+ * @stats: counters exposed through sysfs
+ */
+struct ufshpb_lu {
+	struct scsi_device *sdev;
+	spinlock_t lock;
+	struct ufshpb_subregion *srgns;
+	u16 *rgn_active;
+	struct list_head lru;
+	struct list_head load_list;
+	struct work_struct map_work;
+	struct workqueue_struct *map_wq;
+	u32 nr_srgns;
+	u32 nr_rgns;
+	u32 srgn_shift;
+	u32 srgns_per_rgn;
+	u64 lu_blocks;
+	u32 nr_active_srgns;
+	u32 nr_active_rgns;
+	u32 max_active_srgns;
+	u32 max_active_rgns;
+	u32 max_single_cmd;
+	bool reset_pending;
+	struct ufshpb_stats stats;
+};
+
+static inline struct ufshpb_lu *ufshpb_get_lu(struct scsi_device *sdev)
+{
+	return sdev->hostdata;
+}
+
+/* Bytes of cache a single subregion map takes */
+static inline u32 ufshpb_srgn_mem_size(struct ufshpb_lu *hpb)
+{
+	return HPB_ENTRY_SIZE << hpb->srgn_shift;
+}
+
+#ifdef CONFIG_SCSI_UFS_HPB
+void ufshpb_get_dev_info(struct ufs_hba *hba, u8 *desc_buf);
+void ufshpb_config(struct ufs_hba *hba);
+void ufshpb_init_lu(struct ufs_hba *hba, struct scsi_device *sdev);
+void ufshpb_destroy_lu(struct ufs_hba *hba, struct scsi_device *sdev);
+void ufshpb_prep(struct ufs_hba *hba, struct ufshcd_lrb *lrbp);
+void ufshpb_set_mem_budget(struct ufshpb_lu *hpb, u64 bytes);
+#else
+static inline void ufshpb_get_dev_info(struct ufs_hba *hba, u8 *desc_buf)
+{
+}
+
+static inline void ufshpb_config(struct ufs_hba *hba)
+{
+}
+
+static inline void ufshpb_init_lu(struct ufs_hba *hba,
+				  struct scsi_device *sdev)
+{
+}
+
+static inline void ufshpb_destroy_lu(struct ufs_hba *hba,
+				     struct scsi_device *sdev)
+{
+}
+
+static inline void ufshpb_prep(struct ufs_hba *hba, struct ufshcd_lrb *lrbp)
+{
+}
+
+static inline void ufshpb_set_mem_budget(struct ufshpb_lu *hpb, u64 bytes)
+{
+}
+#endif /* CONFIG_SCSI_UFS_HPB */
+
+#endif /* _UFSHPB_H */
@@ -0,0 +1,128 @@
+/* 
+ * Copyright (C) 2015 ASUSTek Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*****************************************/
+/* Sensor Report Batching Module */
+/***************************************/
+
+/*
+ * Matches the sensor HAL batch() semantics on top of the input devices:
+ * with a max report latency set, samples are kept in a ring together with
+ * the time they were reported, and delivered in bulk once the oldest one
+ * reaches the latency or the ring fills up. Each delivered sample keeps
+ * its own input timestamp, so the HAL sees the original sample times.
+ * The flush runs from deferrable work, so an idle AP is not woken only
+ * to deliver a batch, the samples go out with the next wakeup instead.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/input.h>
+#include <linux/input/ASH.h>
+#include "ASH_batch_Report.h"
+
+/**************************/
+/* Debug and Log System */
+/************************/
+#define MODULE_NAME			"ASH_Report"
+#define SENSOR_TYPE_NAME		"batch"
+
+#undef dbg
+#ifdef ASH_REPORT_DEBUG
+	#define dbg(fmt, args...) printk(KERN_DEBUG "[%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,##args)
+#else
+	#define dbg(fmt, args...)
+#endif
+#define log(fmt, args...) printk(KERN_INFO "[%s][%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,__func__,##args)
+#define err(fmt, args...) printk(KERN_ERR "[%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,##args)
+
+static void ASH_batch_emit(struct ASH_batch *batch, ktime_t ts, const int *value)
+{
+	input_set_timestamp(batch->input, ts);
+	batch->emit(batch->input, value);
+	input_sync(batch->input);
+}
+
+/* Call with batch->lock held */
+static void ASH_batch_flush(struct ASH_batch *batch)
+{
+	int i;
+
+	for (i = 0; i < batch->count; i++)
+		ASH_batch_emit(batch, batch->samples[i].ts, batch->samples[i].value);
+
+	dbg("%s: delivered %d samples\n", __FUNCTION__, batch->count);
+	batch->count = 0;
+}
+
+static void ASH_batch_work(struct work_struct *work)
+{
+	struct ASH_batch *batch = container_of(to_delayed_work(work),
+					       struct ASH_batch, work);
+	unsigned long flags;
+
+	spin_lock_irqsave(&batch->lock, flags);
+	ASH_batch_flush(batch);
+	spin_unlock_irqrestore(&batch->lock, flags);
+}
+
+void ASH_batch_init(struct ASH_batch *batch)
+{
+	spin_lock_init(&batch->lock);
+	batch->count = 0;
+	INIT_DEFERRABLE_WORK(&batch->work, ASH_batch_work);
+}
+EXPORT_SYMBOL(ASH_batch_init);
+
+void ASH_batch_report(struct ASH_batch *batch, const int *value)
+{
+	unsigned int latency_ms = READ_ONCE(*batch->latency_ms);
+	ktime_t now = ktime_get();
+	struct ASH_batch_sample *sample;
+	unsigned long flags;
+
+	spin_lock_irqsave(&batch->lock, flags);
+
+	/* Not batching, deliver what was queued before that first */
+	if (!latency_ms) {
+		ASH_batch_flush(batch);
+		ASH_batch_emit(batch, now, value);
+		goto out;
+	}
+
+	sample = &batch->samples[batch->count++];
+	sample->ts = now;
+	memcpy(sample->value, value, sizeof(int) * batch->nr_values);
+
+	if (batch->count == ASH_BATCH_MAX_SAMPLES)
+		ASH_batch_flush(batch);
+	else if (batch->count == 1)
+		queue_delayed_work(system_power_efficient_wq, &batch->work,
+				   msecs_to_jiffies(latency_ms));
+out:
+	spin_unlock_irqrestore(&batch->lock, flags);
+}
+EXPORT_SYMBOL(ASH_batch_report);
+
+void ASH_batch_exit(struct ASH_batch *batch)
+{
+	unsigned long flags;
+
+	cancel_delayed_work_sync(&batch->work);
+
+	spin_lock_irqsave(&batch->lock, flags);
+	ASH_batch_flush(batch);
+	spin_unlock_irqrestore(&batch->lock, flags);
+}
+EXPORT_SYMBOL(ASH_batch_exit);
@@ -0,0 +1,71 @@
+/* 
+ * Copyright (C) 2015 ASUSTek Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+#ifndef __LINUX_ASH_BATCH_REPORT_H
+#define __LINUX_ASH_BATCH_REPORT_H
+
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#define ASH_BATCH_MAX_VALUES	5
+#define ASH_BATCH_MAX_SAMPLES	64
+
+/**
+ * struct ASH_batch_sample - One queued sample
+ * @ts : time the sample was reported by the hardware layer.
+ * @value : sensor specific values, handed back to emit().
+ */
+struct ASH_batch_sample {
+	ktime_t ts;
+	int value[ASH_BATCH_MAX_VALUES];
+};
+
+/**
+ * struct ASH_batch - Report batching of one sensor input device
+ * @input : the input device, set before the first report.
+ * @nr_values : number of values per sample.
+ * @latency_ms : max report latency, 0 reports every sample at once.
+ * @emit : report one sample to @input, without the input_sync().
+ */
+struct ASH_batch {
+	struct input_dev *input;
+	int nr_values;
+	unsigned int *latency_ms;
+	void (*emit)(struct input_dev *input, const int *value);
+
+	spinlock_t lock;
+	struct ASH_batch_sample samples[ASH_BATCH_MAX_SAMPLES];
+	int count;
+	struct delayed_work work;
+};
+
+/**
+ * ASH_batch_init - initialize the batch before the first report.
+ */
+extern void ASH_batch_init(struct ASH_batch *batch);
+
+/**
+ * ASH_batch_report - report or queue one sample of nr_values values.
+ */
+extern void ASH_batch_report(struct ASH_batch *batch, const int *value);
+
+/**
+ * ASH_batch_exit - deliver the queued samples and stop the batch,
+ * call it before the input device is unregistered.
+ */
+extern void ASH_batch_exit(struct ASH_batch *batch);
+
+#endif
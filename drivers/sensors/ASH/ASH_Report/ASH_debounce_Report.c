@@ -0,0 +1,177 @@
+/* 
+ * Copyright (C) 2015 ASUSTek Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+/*****************************************/
+/* Sensor Report Debounce Module */
+/***************************************/
+
+/*
+ * Filters the state reports of switch like sensors (hall, SAR) before they
+ * reach the input device. A new state is only reported once it has held
+ * for the debounce time, a transition that flips back within that window
+ * is dropped, and a report of the state userspace already has is dropped
+ * at once. While a change is pending a wakeup source keeps the AP from
+ * suspending, so a real change is never held back until the next wakeup,
+ * and its statistics account for the wakeups the sensor caused.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/input.h>
+#include <linux/input/ASH.h>
+#include "ASH_debounce_Report.h"
+
+/**************************/
+/* Debug and Log System */
+/************************/
+#define MODULE_NAME			"ASH_Report"
+#define SENSOR_TYPE_NAME		"debounce"
+
+#undef dbg
+#ifdef ASH_REPORT_DEBUG
+	#define dbg(fmt, args...) printk(KERN_DEBUG "[%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,##args)
+#else
+	#define dbg(fmt, args...)
+#endif
+#define log(fmt, args...) printk(KERN_INFO "[%s][%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,__func__,##args)
+#define err(fmt, args...) printk(KERN_ERR "[%s][%s]"fmt,MODULE_NAME,SENSOR_TYPE_NAME,##args)
+
+/* Call with db->lock held */
+static void ASH_debounce_emit(struct ASH_debounce *db, ktime_t ts, int state)
+{
+	if (state != db->reported) {
+		input_set_timestamp(db->input, ts);
+		db->emit(db->input, state);
+		input_sync(db->input);
+		db->reported = state;
+		db->report_cnt++;
+		dbg("%s: %s reported %d\n", __FUNCTION__, db->name, state);
+	}
+	db->pending = ASH_DEBOUNCE_NO_STATE;
+}
+
+static void ASH_debounce_work(struct work_struct *work)
+{
+	struct ASH_debounce *db = container_of(to_delayed_work(work),
+					       struct ASH_debounce, work);
+	unsigned long flags;
+
+	spin_lock_irqsave(&db->lock, flags);
+	if (db->pending != ASH_DEBOUNCE_NO_STATE)
+		ASH_debounce_emit(db, db->pending_ts, db->pending);
+	__pm_relax(db->ws);
+	spin_unlock_irqrestore(&db->lock, flags);
+}
+
+static ssize_t report_stats_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct ASH_debounce *db = input_get_drvdata(to_input_dev(dev));
+	unsigned long raw, reported, flags;
+
+	spin_lock_irqsave(&db->lock, flags);
+	raw = db->raw_cnt;
+	reported = db->report_cnt;
+	spin_unlock_irqrestore(&db->lock, flags);
+
+	return scnprintf(buf, PAGE_SIZE, "raw: %lu\nreported: %lu\nsuppressed: %lu\n",
+			 raw, reported, raw - reported);
+}
+static DEVICE_ATTR_RO(report_stats);
+
+static struct attribute *ASH_debounce_attrs[] = {
+	&dev_attr_report_stats.attr,
+	NULL,
+};
+
+static const struct attribute_group ASH_debounce_group = {
+	.attrs = ASH_debounce_attrs,
+};
+
+int ASH_debounce_init(struct ASH_debounce *db)
+{
+	int ret;
+
+	spin_lock_init(&db->lock);
+	db->reported = ASH_DEBOUNCE_NO_STATE;
+	db->pending = ASH_DEBOUNCE_NO_STATE;
+	db->raw_cnt = 0;
+	db->report_cnt = 0;
+	INIT_DELAYED_WORK(&db->work, ASH_debounce_work);
+
+	db->ws = wakeup_source_register(NULL, db->name);
+	if (!db->ws) {
+		err("%s: wakeup_source_register ERROR.\n", __FUNCTION__);
+		return -ENOMEM;
+	}
+
+	input_set_drvdata(db->input, db);
+	ret = sysfs_create_group(&db->input->dev.kobj, &ASH_debounce_group);
+	if (ret)
+		err("%s: sysfs_create_group ERROR(%d).\n", __FUNCTION__, ret);
+
+	return 0;
+}
+EXPORT_SYMBOL(ASH_debounce_init);
+
+void ASH_debounce_report(struct ASH_debounce *db, int state)
+{
+	unsigned int debounce_ms = READ_ONCE(*db->debounce_ms);
+	ktime_t now = ktime_get();
+	unsigned long flags;
+
+	spin_lock_irqsave(&db->lock, flags);
+	db->raw_cnt++;
+
+	if (!debounce_ms || state == db->fast_state) {
+		cancel_delayed_work(&db->work);
+		ASH_debounce_emit(db, now, state);
+		__pm_relax(db->ws);
+	} else if (state == db->reported) {
+		/* Flipped back before the change was reported, or a repeat */
+		if (db->pending != ASH_DEBOUNCE_NO_STATE) {
+			cancel_delayed_work(&db->work);
+			db->pending = ASH_DEBOUNCE_NO_STATE;
+			__pm_relax(db->ws);
+		}
+	} else if (state != db->pending) {
+		db->pending = state;
+		db->pending_ts = now;
+		__pm_stay_awake(db->ws);
+		mod_delayed_work(system_power_efficient_wq, &db->work,
+				 msecs_to_jiffies(debounce_ms));
+	}
+
+	spin_unlock_irqrestore(&db->lock, flags);
+}
+EXPORT_SYMBOL(ASH_debounce_report);
+
+void ASH_debounce_reset(struct ASH_debounce *db)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&db->lock, flags);
+	db->reported = ASH_DEBOUNCE_NO_STATE;
+	spin_unlock_irqrestore(&db->lock, flags);
+}
+EXPORT_SYMBOL(ASH_debounce_reset);
+
+void ASH_debounce_exit(struct ASH_debounce *db)
+{
+	sysfs_remove_group(&db->input->dev.kobj, &ASH_debounce_group);
+	cancel_delayed_work_sync(&db->work);
+	__pm_relax(db->ws);
+	wakeup_source_unregister(db->ws);
+}
+EXPORT_SYMBOL(ASH_debounce_exit);
@@ -0,0 +1,78 @@
+/* 
+ * Copyright (C) 2015 ASUSTek Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ */
+
+
+#ifndef __LINUX_ASH_DEBOUNCE_REPORT_H
+#define __LINUX_ASH_DEBOUNCE_REPORT_H
+
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/pm_wakeup.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
+#define ASH_DEBOUNCE_NO_STATE	INT_MIN
+
+/**
+ * struct ASH_debounce - State change filter of one switch like sensor
+ * @input : the input device, set before ASH_debounce_init().
+ * @name : name of the wakeup source held while a change is pending.
+ * @debounce_ms : time a new state must hold before it is reported,
+ *	0 reports every change at once.
+ * @fast_state : state reported without debounce, ASH_DEBOUNCE_NO_STATE
+ *	for none. Used where reporting late is worse than a spurious event.
+ * @emit : report one state to @input, without the input_sync().
+ */
+struct ASH_debounce {
+	struct input_dev *input;
+	const char *name;
+	unsigned int *debounce_ms;
+	int fast_state;
+	void (*emit)(struct input_dev *input, int state);
+
+	spinlock_t lock;
+	int reported;
+	int pending;
+	ktime_t pending_ts;
+	struct delayed_work work;
+	struct wakeup_source *ws;
+	unsigned long raw_cnt;
+	unsigned long report_cnt;
+	unsigned long drop_cnt;
+};
+
+/**
+ * ASH_debounce_init - initialize the filter after the input device is
+ * registered. Adds a report_stats attribute to the input device.
+ */
+extern int ASH_debounce_init(struct ASH_debounce *db);
+
+/**
+ * ASH_debounce_report - feed one state read from the hardware.
+ */
+extern void ASH_debounce_report(struct ASH_debounce *db, int state);
+
+/**
+ * ASH_debounce_reset - forget the reported state, so the next one is
+ * reported even if it did not change. Call it when the sensor is enabled.
+ */
+extern void ASH_debounce_reset(struct ASH_debounce *db);
+
+/**
+ * ASH_debounce_exit - drop a pending change and stop the filter,
+ * call it before the input device is unregistered.
+ */
+extern void ASH_debounce_exit(struct ASH_debounce *db);
+
+#endif
@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_batch_Report.h"
 
 /**************************/
 /* Debug and Log System */
@@ -41,6 +42,25 @@
 /********************/
 static struct input_dev *input_dev_frgb = NULL;
 
+/* Max report latency in ms, 0 reports every sample at once */
+static unsigned int FRGBsensor_batch_latency_ms;
+module_param(FRGBsensor_batch_latency_ms, uint, 0644);
+
+static void FRGBsensor_report_emit(struct input_dev *input, const int *value)
+{
+	input_report_abs(input, ABS_HAT0X, value[0]);	/* R */
+	input_report_abs(input, ABS_HAT0Y, value[1]);	/* G */
+	input_report_abs(input, ABS_HAT1X, value[2]);	/* B */
+	input_report_abs(input, ABS_HAT1Y, value[3]);	/* IR */
+	input_event(input, EV_SYN, SYN_REPORT, 4);
+}
+
+static struct ASH_batch frgb_batch = {
+	.nr_values = 4,
+	.latency_ms = &FRGBsensor_batch_latency_ms,
+	.emit = FRGBsensor_report_emit,
+};
+
 int FRGBsensor_report_register(void)
 {
 	int ret = 0;
@@ -83,6 +103,9 @@ int FRGBsensor_report_register(void)
 		return -1;
 	}
 
+	frgb_batch.input = input_dev_frgb;
+	ASH_batch_init(&frgb_batch);
+
 	dbg("Input Event Success Registration\n");
 	return 0;
 }
@@ -90,6 +113,7 @@ EXPORT_SYMBOL(FRGBsensor_report_register);
 
 void FRGBsensor_report_unregister(void)
 {	
+	ASH_batch_exit(&frgb_batch);
 	input_unregister_device(input_dev_frgb);
 	input_free_device(input_dev_frgb);
 }
@@ -97,11 +121,6 @@ EXPORT_SYMBOL(FRGBsensor_report_unregister);
 
 void FRGBsensor_report_raw(int *data, int size)
 {
-	input_report_abs(input_dev_frgb, ABS_HAT0X, data[0]);	/* R */
-	input_report_abs(input_dev_frgb, ABS_HAT0Y, data[1]);	/* G */
-	input_report_abs(input_dev_frgb, ABS_HAT1X, data[2]);	/* B */
-	input_report_abs(input_dev_frgb, ABS_HAT1Y, data[3]);	/* IR */
-	input_event(input_dev_frgb, EV_SYN, SYN_REPORT, 4);
-	input_sync(input_dev_frgb);
+	ASH_batch_report(&frgb_batch, data);
 }
 EXPORT_SYMBOL(FRGBsensor_report_raw);
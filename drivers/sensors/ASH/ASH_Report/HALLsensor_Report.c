@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_debounce_Report.h"
 
 /**************************/
 /* Debug and Log System */
@@ -41,6 +42,22 @@
 /*****************/
 static struct input_dev *input_dev_hall = NULL;
 
+/* Time a lid state must hold before it is reported, 0 reports every change */
+static unsigned int hall_debounce_ms = 50;
+module_param(hall_debounce_ms, uint, 0644);
+
+static void hallsensor_report_emit(struct input_dev *input, int state)
+{
+	input_report_switch(input, SW_LID, state);
+}
+
+static struct ASH_debounce hall_debounce = {
+	.name = "ASH_hall",
+	.debounce_ms = &hall_debounce_ms,
+	.fast_state = ASH_DEBOUNCE_NO_STATE,
+	.emit = hallsensor_report_emit,
+};
+
 int HALLsensor_report_register(void)
 {
 	int ret = 0;
@@ -61,6 +78,13 @@ int HALLsensor_report_register(void)
 		err("%s: input_register_device ERROR(%d). \n", __FUNCTION__, ret);
 		return -1;		
 	}
+
+	hall_debounce.input = input_dev_hall;
+	ret = ASH_debounce_init(&hall_debounce);
+	if (ret < 0) {
+		input_unregister_device(input_dev_hall);
+		return ret;
+	}
 		
 	dbg("Input Event Success Registration\n");
 	return 0;
@@ -69,6 +93,7 @@ EXPORT_SYMBOL(HALLsensor_report_register);
 
 void HALLsensor_report_unregister(void)
 {	
+	ASH_debounce_exit(&hall_debounce);
 	input_unregister_device(input_dev_hall);
 	input_free_device(input_dev_hall);
 }
@@ -81,7 +106,6 @@ void hallsensor_report_lid(int lid)
 			err("%s: Hall Sensor Detect Magnetic ERROR.\n", __FUNCTION__);
 	}
 
-	input_report_switch(input_dev_hall, SW_LID, lid);
-	input_sync(input_dev_hall);
+	ASH_debounce_report(&hall_debounce, lid);
 }
 EXPORT_SYMBOL(hallsensor_report_lid);
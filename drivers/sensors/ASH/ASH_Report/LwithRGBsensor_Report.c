@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_batch_Report.h"
 
 /*******************************/
 /* Debug and Log System */
@@ -43,6 +44,26 @@ static struct input_dev *input_dev_als = NULL;
 static int report_data[5] = {-1};
 void lrgbsensor_report_lux(void);
 
+/* Max report latency in ms, 0 reports every sample at once */
+static unsigned int lsensor_batch_latency_ms;
+module_param(lsensor_batch_latency_ms, uint, 0644);
+
+static void lrgbsensor_report_emit(struct input_dev *input, const int *value)
+{
+	input_report_abs(input, ABS_MISC, value[0]);		/* LUX */
+	input_report_abs(input, ABS_HAT0X, value[1]);	/* R */
+	input_report_abs(input, ABS_HAT0Y, value[2]);	/* G */
+	input_report_abs(input, ABS_HAT1X, value[3]);	/* B */
+	input_report_abs(input, ABS_HAT1Y, value[4]);	/* IR */
+	input_event(input, EV_SYN, SYN_REPORT, 5);
+}
+
+static struct ASH_batch als_batch = {
+	.nr_values = 5,
+	.latency_ms = &lsensor_batch_latency_ms,
+	.emit = lrgbsensor_report_emit,
+};
+
 int lsensor_report_register(void)
 {
 	int ret = 0;
@@ -91,6 +112,9 @@ int lsensor_report_register(void)
 		return -1;
 	}
 
+	als_batch.input = input_dev_als;
+	ASH_batch_init(&als_batch);
+
 	dbg("Input Event Success Registration\n");
 	return 0;
 }
@@ -98,6 +122,7 @@ EXPORT_SYMBOL(lsensor_report_register);
 
 void lsensor_report_unregister(void)
 {	
+	ASH_batch_exit(&als_batch);
 	input_unregister_device(input_dev_als);
 	input_free_device(input_dev_als);
 }
@@ -123,14 +148,15 @@ EXPORT_SYMBOL(FRGBsensor_report_raw);
 void lrgbsensor_report_lux(void)
 {
 	static int count = 0;
+	int value[5];
+
 	log("report lux=%d, count=%d", report_data[0], count);
-	input_report_abs(input_dev_als, ABS_MISC, report_data[0]);		/* LUX */
-	input_report_abs(input_dev_als, ABS_HAT0X, count);	/* R */
-	input_report_abs(input_dev_als, ABS_HAT0Y, report_data[2]);	/* G */
-	input_report_abs(input_dev_als, ABS_HAT1X, report_data[3]);	/* B */
-	input_report_abs(input_dev_als, ABS_HAT1Y, report_data[4]);	/* IR */
-	input_event(input_dev_als, EV_SYN, SYN_REPORT, 5);
-	input_sync(input_dev_als);
+	value[0] = report_data[0];	/* LUX */
+	value[1] = count;		/* R */
+	value[2] = report_data[2];	/* G */
+	value[3] = report_data[3];	/* B */
+	value[4] = report_data[4];	/* IR */
+	ASH_batch_report(&als_batch, value);
 	count++;
 }
 
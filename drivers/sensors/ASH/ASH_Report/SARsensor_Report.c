@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_debounce_Report.h"
 
 /**************************/
 /* Debug and Log System */
@@ -42,6 +43,26 @@
 /*****************/
 static struct input_dev *input_dev_sar = NULL;
 
+/*
+ * Time AWAY must hold before it is reported, 0 reports every change.
+ * CLOSE is always reported at once, the modem has to back off its TX
+ * power as soon as a body is near.
+ */
+static unsigned int sar_away_debounce_ms = 200;
+module_param(sar_away_debounce_ms, uint, 0644);
+
+static void SAR_sensor_report_emit(struct input_dev *input, int state)
+{
+	input_report_abs(input, ABS_DISTANCE, state);
+}
+
+static struct ASH_debounce sar_debounce = {
+	.name = "ASH_SAR",
+	.debounce_ms = &sar_away_debounce_ms,
+	.fast_state = SAR_SENSOR_REPORT_CLOSE,
+	.emit = SAR_sensor_report_emit,
+};
+
 int SAR_sensor_report_register(void)
 {
 	int ret = 0;
@@ -69,6 +90,13 @@ int SAR_sensor_report_register(void)
 		return -1;
 	}
 
+	sar_debounce.input = input_dev_sar;
+	ret = ASH_debounce_init(&sar_debounce);
+	if (ret < 0) {
+		input_unregister_device(input_dev_sar);
+		return ret;
+	}
+
 	dbg("Input Event Success Registration\n");
 	return 0;
 }
@@ -76,6 +104,7 @@ EXPORT_SYMBOL(SAR_sensor_report_register);
 
 void SAR_sensor_report_unregister(void)
 {	
+	ASH_debounce_exit(&sar_debounce);
 	input_unregister_device(input_dev_sar);
 	input_free_device(input_dev_sar);	
 }
@@ -89,9 +118,13 @@ void SAR_sensor_report_abs(int abs)
 		if (abs != SAR_SENSOR_INIT) {
 			err("%s: Sar Detect Object ERROR.\n", __FUNCTION__);
 		}
+		/* Sensor (re)enabled, the next state goes out even if unchanged */
+		ASH_debounce_reset(&sar_debounce);
+		input_report_abs(input_dev_sar, ABS_DISTANCE, abs);
+		input_sync(input_dev_sar);
+		return;
 	}
-	input_report_abs(input_dev_sar, ABS_DISTANCE, abs);
-	input_sync(input_dev_sar);
+	ASH_debounce_report(&sar_debounce, abs);
 }
 EXPORT_SYMBOL(SAR_sensor_report_abs);
 
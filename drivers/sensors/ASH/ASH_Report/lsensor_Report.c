@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_batch_Report.h"
 
 /*******************************/
 /* Debug and Log System */
@@ -41,6 +42,22 @@
 /********************/
 static struct input_dev *input_dev_als = NULL;
 
+/* Max report latency in ms, 0 reports every sample at once */
+static unsigned int lsensor_batch_latency_ms;
+module_param(lsensor_batch_latency_ms, uint, 0644);
+
+static void lsensor_report_emit(struct input_dev *input, const int *value)
+{
+	input_report_abs(input, ABS_MISC, value[0]);
+	input_event(input, EV_SYN, SYN_REPORT, 1);
+}
+
+static struct ASH_batch als_batch = {
+	.nr_values = 1,
+	.latency_ms = &lsensor_batch_latency_ms,
+	.emit = lsensor_report_emit,
+};
+
 int lsensor_report_register(void)
 {
 	int ret = 0;
@@ -69,6 +86,9 @@ int lsensor_report_register(void)
 		return -1;
 	}
 
+	als_batch.input = input_dev_als;
+	ASH_batch_init(&als_batch);
+
 	dbg("Input Event Success Registration\n");
 	return 0;
 }
@@ -76,6 +96,7 @@ EXPORT_SYMBOL(lsensor_report_register);
 
 void lsensor_report_unregister(void)
 {	
+	ASH_batch_exit(&als_batch);
 	input_unregister_device(input_dev_als);
 	input_free_device(input_dev_als);
 }
@@ -83,8 +104,6 @@ EXPORT_SYMBOL(lsensor_report_unregister);
 
 void lsensor_report_lux(int lux)
 {
-	input_report_abs(input_dev_als, ABS_MISC, lux);
-	input_event(input_dev_als, EV_SYN, SYN_REPORT, 1);
-	input_sync(input_dev_als);
+	ASH_batch_report(&als_batch, &lux);
 }
 EXPORT_SYMBOL(lsensor_report_lux);
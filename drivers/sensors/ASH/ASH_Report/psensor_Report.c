@@ -20,6 +20,7 @@
 #include <linux/kernel.h>
 #include <linux/input.h>
 #include <linux/input/ASH.h>
+#include "ASH_batch_Report.h"
 
 /**************************/
 /* Debug and Log System */
@@ -42,6 +43,22 @@
 /*****************/
 static struct input_dev *input_dev_ps = NULL;
 static bool g_input_dev_reg_status = false;
+
+/* Max report latency in ms, 0 reports every event at once */
+static unsigned int psensor_batch_latency_ms;
+module_param(psensor_batch_latency_ms, uint, 0644);
+
+static void psensor_report_emit(struct input_dev *input, const int *value)
+{
+	input_report_abs(input, ABS_DISTANCE, value[0]);
+}
+
+static struct ASH_batch ps_batch = {
+	.nr_values = 1,
+	.latency_ms = &psensor_batch_latency_ms,
+	.emit = psensor_report_emit,
+};
+
 int psensor_report_register(void)
 {
 	int ret = 0;
@@ -76,6 +93,9 @@ __FUNCTION__);
 		return -1;
 	}
 
+	ps_batch.input = input_dev_ps;
+	ASH_batch_init(&ps_batch);
+
 	g_input_dev_reg_status = true;
 	dbg("Input Event Success Registration\n");
 	return 0;
@@ -85,6 +105,7 @@ EXPORT_SYMBOL(psensor_report_register);
 void psensor_report_unregister(void)
 {
 	if(true == g_input_dev_reg_status){
+		ASH_batch_exit(&ps_batch);
 		input_unregister_device(input_dev_ps);
 		input_free_device(input_dev_ps);
 	}
@@ -116,8 +137,7 @@ void psensor_report_abs(int abs)
 		}
 	}
 #endif
-	input_report_abs(input_dev_ps, ABS_DISTANCE, abs);
-	input_sync(input_dev_ps);
+	ASH_batch_report(&ps_batch, &abs);
 }
 EXPORT_SYMBOL(psensor_report_abs);
 
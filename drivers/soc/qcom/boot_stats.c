@@ -17,7 +17,11 @@
 #include <linux/of_address.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/sched/clock.h>
 #include <soc/qcom/boot_stats.h>
+#include <soc/qcom/minidump.h>
 
 #define MAX_STRING_LEN 256
 #define BOOT_MARKER_MAX_LEN 50
@@ -53,6 +57,149 @@ static struct boot_marker boot_marker_list;
 static struct kobject *bootkpi_obj;
 static struct attribute_group *attr_grp;
 
+/*
+ * Boot timeline: the boot phases that take time, in a fixed buffer that
+ * starts filling with the first initcall and is sealed when it is read
+ * from debugfs. It is also registered with minidump. Initcalls and module
+ * inits shorter than BOOT_EVENT_MIN_NS and dm-verity verification only
+ * add to the per-type totals.
+ */
+#define BOOT_EVENT_RECORDS	256
+#define BOOT_EVENT_MIN_NS	NSEC_PER_MSEC
+
+struct boot_event {
+	u32 start_us;
+	u32 duration_us;
+	u8 type;
+	char name[23];
+};
+
+static struct {
+	struct boot_event ev[BOOT_EVENT_RECORDS];
+	u64 total_ns[BOOT_EVENT_MAX];
+	u32 count[BOOT_EVENT_MAX];
+	u32 nr;
+	bool sealed;
+} boot_timeline;
+static DEFINE_SPINLOCK(boot_timeline_lock);
+static struct dentry *boot_timeline_file;
+
+static const char * const boot_event_names[BOOT_EVENT_MAX] = {
+	[BOOT_EVENT_INITCALL] = "initcall",
+	[BOOT_EVENT_MODULE] = "module",
+	[BOOT_EVENT_FIRMWARE] = "firmware",
+	[BOOT_EVENT_DISPLAY] = "display",
+	[BOOT_EVENT_MOUNT] = "mount",
+	[BOOT_EVENT_VERITY] = "verity",
+};
+
+u64 boot_event_start(void)
+{
+	return READ_ONCE(boot_timeline.sealed) ? 0 : local_clock();
+}
+EXPORT_SYMBOL(boot_event_start);
+
+void boot_event_record(enum boot_event_type type, const char *name,
+		u64 start)
+{
+	struct boot_event *ev;
+	unsigned long flags;
+	u64 delta;
+
+	if (!start || type >= BOOT_EVENT_MAX)
+		return;
+
+	delta = local_clock() - start;
+
+	spin_lock_irqsave(&boot_timeline_lock, flags);
+	if (boot_timeline.sealed)
+		goto unlock;
+
+	boot_timeline.total_ns[type] += delta;
+	boot_timeline.count[type]++;
+
+	if (type == BOOT_EVENT_VERITY)
+		goto unlock;
+	if ((type == BOOT_EVENT_INITCALL || type == BOOT_EVENT_MODULE) &&
+	    delta < BOOT_EVENT_MIN_NS)
+		goto unlock;
+	if (boot_timeline.nr >= BOOT_EVENT_RECORDS)
+		goto unlock;
+
+	ev = &boot_timeline.ev[boot_timeline.nr++];
+	ev->start_us = div_u64(start, NSEC_PER_USEC);
+	ev->duration_us = min_t(u64, div_u64(delta, NSEC_PER_USEC), U32_MAX);
+	ev->type = type;
+	strlcpy(ev->name, name, sizeof(ev->name));
+unlock:
+	spin_unlock_irqrestore(&boot_timeline_lock, flags);
+}
+EXPORT_SYMBOL(boot_event_record);
+
+/* Called from do_one_initcall(), also for the init of loadable modules */
+void boot_event_initcall(void *fn, u64 start)
+{
+	char name[sizeof(boot_timeline.ev[0].name)];
+	struct module *mod;
+
+	if (!start)
+		return;
+
+	preempt_disable();
+	mod = __module_address((unsigned long)fn);
+	if (mod)
+		strlcpy(name, mod->name, sizeof(name));
+	preempt_enable();
+
+	if (mod) {
+		boot_event_record(BOOT_EVENT_MODULE, name, start);
+	} else {
+		snprintf(name, sizeof(name), "%ps", fn);
+		boot_event_record(BOOT_EVENT_INITCALL, name, start);
+	}
+}
+
+static int boot_timeline_show(struct seq_file *s, void *data)
+{
+	struct boot_event *ev;
+	int i;
+
+	spin_lock_irq(&boot_timeline_lock);
+	boot_timeline.sealed = true;
+	spin_unlock_irq(&boot_timeline_lock);
+
+	seq_puts(s, "# type count total_us\n");
+	for (i = 0; i < BOOT_EVENT_MAX; i++)
+		seq_printf(s, "%s %u %llu\n", boot_event_names[i],
+			   boot_timeline.count[i],
+			   div_u64(boot_timeline.total_ns[i], NSEC_PER_USEC));
+
+	seq_puts(s, "# start_us duration_us type name\n");
+	for (i = 0; i < boot_timeline.nr; i++) {
+		ev = &boot_timeline.ev[i];
+		seq_printf(s, "%u %u %s %s\n", ev->start_us, ev->duration_us,
+			   boot_event_names[ev->type], ev->name);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(boot_timeline);
+
+static void boot_timeline_init(void)
+{
+	struct md_region md_entry;
+
+	boot_timeline_file = debugfs_create_file("boot_timeline", 0400, NULL,
+						 NULL, &boot_timeline_fops);
+
+	strlcpy(md_entry.name, "KBOOTTL", sizeof(md_entry.name));
+	md_entry.virt_addr = (uintptr_t)&boot_timeline;
+	md_entry.phys_addr = virt_to_phys(&boot_timeline);
+	md_entry.size = sizeof(boot_timeline);
+	if (msm_minidump_add_region(&md_entry) < 0)
+		pr_debug("boot_stats: failed to add boot timeline to minidump\n");
+}
+
 unsigned long long msm_timer_get_sclk_ticks(void)
 {
 	unsigned long long t1, t2;
@@ -289,11 +436,13 @@ static int init_bootkpi(void)
 
 	INIT_LIST_HEAD(&boot_marker_list.list);
 	spin_lock_init(&boot_marker_list.slock);
+	boot_timeline_init();
 	return 0;
 }
 
 static void exit_bootkpi(void)
 {
+	debugfs_remove(boot_timeline_file);
 	boot_marker_cleanup();
 	sysfs_remove_group(bootkpi_obj, attr_grp);
 	kobject_del(bootkpi_obj);
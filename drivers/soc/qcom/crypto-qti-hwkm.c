@@ -10,6 +10,7 @@
 #include <linux/hwkm.h>
 #include <linux/module.h>
 #include <linux/kernel.h>
+#include <linux/bitmap.h>
 
 #include "crypto-qti-ice-regs.h"
 #include "crypto-qti-platform.h"
@@ -25,6 +26,7 @@
 #define RAW_SECRET_CTX			"raw secret"
 #define BYTE_ORDER_VAL			8
 #define KEY_WRAPPED_SIZE		68
+#define HWKM_MAX_SLOTS			256
 
 union crypto_cfg {
 	__le32 regval[2];
@@ -37,17 +39,47 @@ union crypto_cfg {
 	};
 };
 
+/*
+ * HWKM slots known to be empty. Callers are serialized by the keyslot
+ * manager, as they already are for the shared GP_KEYSLOT. After HWKM
+ * init the state is unknown and every slot is treated as dirty.
+ */
+static DECLARE_BITMAP(hwkm_clean_slots, HWKM_MAX_SLOTS);
+
+static void crypto_qti_hwkm_mark_dirty(unsigned int slot)
+{
+	if (slot < HWKM_MAX_SLOTS)
+		clear_bit(slot, hwkm_clean_slots);
+}
+
 static int crypto_qti_hwkm_evict_slot(unsigned int slot, bool double_key)
 {
 	struct hwkm_cmd cmd_clear;
 	struct hwkm_rsp rsp_clear;
+	int err;
 
 	memset(&cmd_clear, 0, sizeof(cmd_clear));
 	cmd_clear.op = KEY_SLOT_CLEAR;
 	cmd_clear.clear.dks = slot;
 	if (double_key)
 		cmd_clear.clear.is_double_key = true;
-	return qti_hwkm_handle_cmd(&cmd_clear, &rsp_clear);
+	err = qti_hwkm_handle_cmd(&cmd_clear, &rsp_clear);
+
+	if (slot < HWKM_MAX_SLOTS) {
+		if (!err || err == SLOT_EMPTY_ERROR)
+			set_bit(slot, hwkm_clean_slots);
+		else
+			clear_bit(slot, hwkm_clean_slots);
+	}
+	return err;
+}
+
+/* Failsafe clear, skipped when the slot was left empty by us */
+static int crypto_qti_hwkm_failsafe_evict(unsigned int slot, bool double_key)
+{
+	if (slot < HWKM_MAX_SLOTS && test_bit(slot, hwkm_clean_slots))
+		return 0;
+	return crypto_qti_hwkm_evict_slot(slot, double_key);
 }
 
 int crypto_qti_program_key(struct crypto_vops_qti_entry *ice_entry,
@@ -97,11 +129,12 @@ int crypto_qti_program_key(struct crypto_vops_qti_entry *ice_entry,
 			qti_hwkm_clocks(false);
 			return -EINVAL;
 		}
+		bitmap_zero(hwkm_clean_slots, HWKM_MAX_SLOTS);
 		ice_entry->flags |= QTI_HWKM_INIT_DONE;
 	}
 
 	//Failsafe, clear GP_KEYSLOT incase it is not empty for any reason
-	err_clear = crypto_qti_hwkm_evict_slot(GP_KEYSLOT, false);
+	err_clear = crypto_qti_hwkm_failsafe_evict(GP_KEYSLOT, false);
 	if (err_clear && (err_clear != SLOT_EMPTY_ERROR)) {
 		pr_err("%s: Error clearing ICE slot %d, err %d\n",
 			__func__, GP_KEYSLOT, err_clear);
@@ -123,6 +156,7 @@ int crypto_qti_program_key(struct crypto_vops_qti_entry *ice_entry,
 				cmd_unwrap.unwrap.sz);
 	}
 
+	crypto_qti_hwkm_mark_dirty(GP_KEYSLOT);
 	err_program = qti_hwkm_handle_cmd(&cmd_unwrap, &rsp_unwrap);
 	if (err_program) {
 		pr_err("%s: Error with key unwrap %d\n", __func__,
@@ -132,8 +166,8 @@ int crypto_qti_program_key(struct crypto_vops_qti_entry *ice_entry,
 	}
 
 	//Failsafe, clear ICE keyslot incase it is not empty for any reason
-	err_clear = crypto_qti_hwkm_evict_slot(KEYMANAGER_ICE_MAP_SLOT(slot),
-						true);
+	err_clear = crypto_qti_hwkm_failsafe_evict(
+				KEYMANAGER_ICE_MAP_SLOT(slot), true);
 	if (err_clear && (err_clear != SLOT_EMPTY_ERROR)) {
 		pr_err("%s: Error clearing ICE slot %d, err %d\n",
 			__func__, KEYMANAGER_ICE_MAP_SLOT(slot), err_clear);
@@ -161,6 +195,7 @@ int crypto_qti_program_key(struct crypto_vops_qti_entry *ice_entry,
 	/* Make sure CFGE is cleared */
 	wmb();
 
+	crypto_qti_hwkm_mark_dirty(KEYMANAGER_ICE_MAP_SLOT(slot));
 	err_program = qti_hwkm_handle_cmd(&cmd_kdf, &rsp_kdf);
 	if (err_program) {
 		pr_err("%s: Error programming key %d, slot %d\n", __func__,
@@ -221,6 +256,7 @@ EXPORT_SYMBOL(crypto_qti_invalidate_key);
 void crypto_qti_disable_platform(struct crypto_vops_qti_entry *ice_entry)
 {
 	ice_entry->flags &= ~QTI_HWKM_INIT_DONE;
+	bitmap_zero(hwkm_clean_slots, HWKM_MAX_SLOTS);
 }
 EXPORT_SYMBOL(crypto_qti_disable_platform);
 
@@ -274,11 +310,12 @@ int crypto_qti_derive_raw_secret_platform(
 			qti_hwkm_clocks(false);
 			return -EINVAL;
 		}
+		bitmap_zero(hwkm_clean_slots, HWKM_MAX_SLOTS);
 		ice_entry->flags |= QTI_HWKM_INIT_DONE;
 	}
 
 	//Failsafe, clear GP_KEYSLOT incase it is not empty for any reason
-	err_clear = crypto_qti_hwkm_evict_slot(GP_KEYSLOT, false);
+	err_clear = crypto_qti_hwkm_failsafe_evict(GP_KEYSLOT, false);
 	if (err_clear && (err_clear != SLOT_EMPTY_ERROR)) {
 		pr_err("%s: Error clearing GP slot %d, err %d\n",
 			__func__, GP_KEYSLOT, err_clear);
@@ -294,6 +331,7 @@ int crypto_qti_derive_raw_secret_platform(
 	memcpy(cmd_unwrap.unwrap.wkb, wrapped_key,
 			cmd_unwrap.unwrap.sz);
 
+	crypto_qti_hwkm_mark_dirty(GP_KEYSLOT);
 	err_program = qti_hwkm_handle_cmd(&cmd_unwrap, &rsp_unwrap);
 	if (err_program) {
 		pr_err("%s: Error with key unwrap %d\n", __func__,
@@ -303,7 +341,7 @@ int crypto_qti_derive_raw_secret_platform(
 	}
 
 	//Failsafe, clear RAW_SECRET_KEYSLOT incase it is not empty
-	err_clear = crypto_qti_hwkm_evict_slot(RAW_SECRET_KEYSLOT, false);
+	err_clear = crypto_qti_hwkm_failsafe_evict(RAW_SECRET_KEYSLOT, false);
 	if (err_clear && (err_clear != SLOT_EMPTY_ERROR)) {
 		pr_err("%s: Error clearing raw secret slot %d, err %d\n",
 			__func__, RAW_SECRET_KEYSLOT, err_clear);
@@ -321,6 +359,7 @@ int crypto_qti_derive_raw_secret_platform(
 	memset(cmd_kdf.kdf.ctx, 0, HWKM_MAX_CTX_SIZE);
 	memcpy(cmd_kdf.kdf.ctx, RAW_SECRET_CTX, strlen(RAW_SECRET_CTX));
 
+	crypto_qti_hwkm_mark_dirty(RAW_SECRET_KEYSLOT);
 	err_program = qti_hwkm_handle_cmd(&cmd_kdf, &rsp_kdf);
 	if (err_program) {
 		pr_err("%s: Error deriving secret %d, slot %d\n", __func__,
@@ -228,6 +228,7 @@ struct hab_message {
 	struct list_head node;
 	size_t sizebytes;
 	uint32_t sequence_rx;
+	ktime_t rx_time; /* queued to the vchan */
 	uint32_t data[];
 };
 
@@ -319,6 +320,8 @@ struct hab_driver {
 	void *hab_vmm_handle;
 };
 
+#define HAB_RX_LAT_BUCKETS 12
+
 struct virtual_channel {
 	struct list_head node; /* for ctx */
 	struct list_head pnode; /* for pchan */
@@ -349,6 +352,12 @@ struct virtual_channel {
 	uint64_t tx_cnt; /* total succeeded tx */
 	uint64_t rx_cnt; /* total succeeded rx */
 	int rx_inflight; /* rx in progress/blocking */
+	/* queued to dequeued latency, bucket n is below 2^n us */
+	uint32_t rx_lat_hist[HAB_RX_LAT_BUCKETS];
+	/* adaptive polling before blocking in recv */
+	uint32_t rx_poll_ns;
+	uint64_t rx_poll_hit;
+	uint64_t rx_poll_miss;
 };
 
 /*
@@ -572,6 +581,7 @@ int hab_stat_deinit(struct hab_driver *drv);
 int hab_stat_show_vchan(struct hab_driver *drv, char *buf, int sz);
 int hab_stat_show_ctx(struct hab_driver *drv, char *buf, int sz);
 int hab_stat_show_expimp(struct hab_driver *drv, int pid, char *buf, int sz);
+int hab_stat_show_latency(struct hab_driver *drv, char *buf, int sz);
 
 int hab_stat_init_sub(struct hab_driver *drv);
 int hab_stat_deinit_sub(struct hab_driver *drv);
@@ -610,6 +620,7 @@ static inline void hab_write_unlock(rwlock_t *lock, int irqs_disabled)
 
 /* Global singleton HAB instance */
 extern struct hab_driver hab_driver;
+extern unsigned int hab_rx_poll_us;
 
 int dump_hab_get_file_name(char *file_time, int ft_size);
 int dump_hab_open(void);
@@ -367,5 +367,9 @@ static void __exit hab_exit(void)
 subsys_initcall(hab_init);
 module_exit(hab_exit);
 
+/* upper bound of the time a blocking recv polls before it sleeps */
+unsigned int hab_rx_poll_us = 20;
+module_param(hab_rx_poll_us, uint, 0644);
+
 MODULE_DESCRIPTION("Hypervisor abstraction layer");
 MODULE_LICENSE("GPL v2");
@@ -44,6 +44,51 @@ void hab_msg_free(struct hab_message *message)
 	kfree(message);
 }
 
+#define HAB_RX_POLL_MIN_NS 1000
+
+/*
+ * Spin for a short while before blocking, so that a reply arriving within a
+ * few microseconds does not pay for a sleep and wakeup. The budget doubles
+ * when polling catches a message and halves when it does not, bounded by
+ * hab_rx_poll_us, so channels with slow peers quickly stop spinning.
+ */
+static bool hab_rx_poll(struct virtual_channel *vchan)
+{
+	u32 max_ns = READ_ONCE(hab_rx_poll_us) * NSEC_PER_USEC;
+	u32 budget = vchan->rx_poll_ns;
+	u64 start;
+
+	if (!max_ns)
+		return false;
+
+	if (!budget || budget > max_ns)
+		budget = max_ns;
+
+	start = ktime_get_ns();
+	while (!need_resched() && ktime_get_ns() - start < budget) {
+		if (!list_empty(&vchan->rx_list) ||
+		    READ_ONCE(vchan->otherend_closed)) {
+			vchan->rx_poll_ns = min(budget * 2, max_ns);
+			vchan->rx_poll_hit++;
+			return true;
+		}
+		cpu_relax();
+	}
+
+	vchan->rx_poll_ns = max_t(u32, budget / 2, HAB_RX_POLL_MIN_NS);
+	vchan->rx_poll_miss++;
+	return false;
+}
+
+static void hab_rx_lat_update(struct virtual_channel *vchan,
+		struct hab_message *message)
+{
+	s64 us = ktime_us_delta(ktime_get(), message->rx_time);
+	int idx = us > 0 ? min_t(int, fls64(us), HAB_RX_LAT_BUCKETS - 1) : 0;
+
+	vchan->rx_lat_hist[idx]++;
+}
+
 int
 hab_msg_dequeue(struct virtual_channel *vchan, struct hab_message **msg,
 		int *rsize, unsigned int flags)
@@ -55,7 +100,7 @@ hab_msg_dequeue(struct virtual_channel *vchan, struct hab_message **msg,
 	int irqs_disabled = irqs_disabled();
 
 	if (wait) {
-		if (hab_rx_queue_empty(vchan)) {
+		if (hab_rx_queue_empty(vchan) && !hab_rx_poll(vchan)) {
 			if (interruptible)
 				ret = wait_event_interruptible(vchan->rx_queue,
 					!hab_rx_queue_empty(vchan) ||
@@ -83,6 +128,7 @@ hab_msg_dequeue(struct virtual_channel *vchan, struct hab_message **msg,
 				list_del(&message->node);
 				ret = 0;
 				*rsize = message->sizebytes;
+				hab_rx_lat_update(vchan, message);
 			} else {
 				pr_err("vcid %x rcv buf too small %d < %zd\n",
 					   vchan->id, *rsize,
@@ -107,6 +153,8 @@ static void hab_msg_queue(struct virtual_channel *vchan,
 {
 	int irqs_disabled = irqs_disabled();
 
+	message->rx_time = ktime_get();
+
 	hab_spin_lock(&vchan->rx_lock, irqs_disabled);
 	list_add_tail(&message->node, &vchan->rx_list);
 	hab_spin_unlock(&vchan->rx_lock, irqs_disabled);
@@ -77,6 +77,42 @@ int hab_stat_show_vchan(struct hab_driver *driver,
 	return ret;
 }
 
+int hab_stat_show_latency(struct hab_driver *driver,
+		char *buf, int size)
+{
+	int i, j, ret = 0;
+
+	ret = strlcpy(buf, "", size);
+	for (i = 0; i < driver->ndevices; i++) {
+		struct hab_device *dev = &driver->devp[i];
+		struct physical_channel *pchan;
+		struct virtual_channel *vc;
+
+		spin_lock_bh(&dev->pchan_lock);
+		list_for_each_entry(pchan, &dev->pchannels, node) {
+			if (!pchan->vcnt)
+				continue;
+
+			read_lock(&pchan->vchans_lock);
+			list_for_each_entry(vc, &pchan->vchannels, pnode) {
+				ret = hab_stat_buffer_print(buf, size,
+					"%s %08X poll %u ns hit %lu miss %lu lat:",
+					pchan->name, vc->id, vc->rx_poll_ns,
+					(unsigned long)vc->rx_poll_hit,
+					(unsigned long)vc->rx_poll_miss);
+				for (j = 0; j < HAB_RX_LAT_BUCKETS; j++)
+					ret = hab_stat_buffer_print(buf, size,
+						" %u", vc->rx_lat_hist[j]);
+				ret = hab_stat_buffer_print(buf, size, "\n");
+			}
+			read_unlock(&pchan->vchans_lock);
+		}
+		spin_unlock_bh(&dev->pchan_lock);
+	}
+
+	return ret;
+}
+
 int hab_stat_show_ctx(struct hab_driver *driver,
 		char *buf, int size)
 {
@@ -333,6 +333,12 @@ static ssize_t expimp_store(struct kobject *kobj, struct kobj_attribute *attr,
 	return -EEXIST;
 }
 
+static ssize_t latency_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	return hab_stat_show_latency(&hab_driver, buf, PAGE_SIZE);
+}
+
 static struct kobj_attribute vchan_attribute = __ATTR(vchan_stat, 0660,
 								vchan_show,
 								vchan_store);
@@ -345,6 +351,10 @@ static struct kobj_attribute expimp_attribute = __ATTR(pid_stat, 0660,
 								expimp_show,
 								expimp_store);
 
+static struct kobj_attribute latency_attribute = __ATTR(latency_stat, 0440,
+								latency_show,
+								NULL);
+
 int hab_stat_init_sub(struct hab_driver *driver)
 {
 	int result;
@@ -365,6 +375,10 @@ int hab_stat_init_sub(struct hab_driver *driver)
 	if (result)
 		pr_debug("cannot add expimp in /sys/kernel/hab %d\n", result);
 
+	result = sysfs_create_file(hab_kobject, &latency_attribute.attr);
+	if (result)
+		pr_debug("cannot add latency in /sys/kernel/hab %d\n", result);
+
 	return result;
 }
 
@@ -373,6 +387,7 @@ int hab_stat_deinit_sub(struct hab_driver *driver)
 	sysfs_remove_file(hab_kobject, &vchan_attribute.attr);
 	sysfs_remove_file(hab_kobject, &ctx_attribute.attr);
 	sysfs_remove_file(hab_kobject, &expimp_attribute.attr);
+	sysfs_remove_file(hab_kobject, &latency_attribute.attr);
 	kobject_put(hab_kobject);
 
 	return 0;
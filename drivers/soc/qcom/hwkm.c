@@ -22,6 +22,11 @@
 #include <crypto/hash.h>
 #include <crypto/sha.h>
 #include <linux/iommu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/sched/clock.h>
 
 #include <linux/hwkm.h>
 #include "hwkmregs.h"
@@ -51,6 +56,21 @@ for (retries = 0; !(cond) && (retries < MAX_RETRIES); retries++)
 #define KM_MASTER_TPKEY_SLOT	10
 #define BYTE_ORDER_VAL		8
 
+/*
+ * Keep the clocks on for a while after the last user so that back to
+ * back key operations, like the keyslot programming burst after unlock,
+ * share one clock enable.
+ */
+#define HWKM_CLK_IDLE_MS	50
+#define HWKM_NUM_OPS		(SET_TPKEY + 1)
+
+struct hwkm_cmd_stats {
+	unsigned long count;
+	unsigned long errors;
+	u64 total_ns;
+	u64 max_ns;
+};
+
 struct hwkm_clk_info {
 	struct list_head list;
 	struct clk *clk;
@@ -70,10 +90,28 @@ struct hwkm_device {
 	struct list_head clk_list_head;
 	bool is_hwkm_clk_available;
 	bool is_hwkm_enabled;
+	struct mutex clk_lock;
+	int clk_users;
+	bool clk_on;
+	unsigned long clk_enables;
+	struct delayed_work clk_off_work;
+	struct hwkm_cmd_stats stats[HWKM_NUM_OPS];
+	struct dentry *debugfs;
 };
 
 static struct hwkm_device *km_device;
 
+static const char * const hwkm_op_names[HWKM_NUM_OPS] = {
+	[NIST_KEYGEN] = "keygen",
+	[SYSTEM_KDF] = "kdf",
+	[QFPROM_KEY_RDWR] = "qfprom_rdwr",
+	[KEY_WRAP_EXPORT] = "wrap",
+	[KEY_UNWRAP_IMPORT] = "unwrap",
+	[KEY_SLOT_CLEAR] = "clear",
+	[KEY_SLOT_RDWR] = "rdwr",
+	[SET_TPKEY] = "set_tpkey",
+};
+
 #define qti_hwkm_readl(hwkm, reg, dest)				\
 	(((dest) == KM_MASTER) ?				\
 	(readl_relaxed((void __iomem *)((hwkm)->km_base + (reg)))) :	\
@@ -999,11 +1037,41 @@ static int qti_hwkm_enable_disable_clocks(struct hwkm_device *hwkm_dev,
 	return ret;
 }
 
+static void qti_hwkm_clk_off_work(struct work_struct *work)
+{
+	struct hwkm_device *hwkm_dev = container_of(to_delayed_work(work),
+					struct hwkm_device, clk_off_work);
+
+	mutex_lock(&hwkm_dev->clk_lock);
+	if (!hwkm_dev->clk_users && hwkm_dev->clk_on) {
+		qti_hwkm_enable_disable_clocks(hwkm_dev, false);
+		hwkm_dev->clk_on = false;
+	}
+	mutex_unlock(&hwkm_dev->clk_lock);
+}
+
 int qti_hwkm_clocks(bool on)
 {
 	int ret = 0;
 
-	ret = qti_hwkm_enable_disable_clocks(km_device, on);
+	mutex_lock(&km_device->clk_lock);
+	if (on) {
+		if (!km_device->clk_on) {
+			ret = qti_hwkm_enable_disable_clocks(km_device, true);
+			if (!ret) {
+				km_device->clk_on = true;
+				km_device->clk_enables++;
+			}
+		}
+		if (!ret)
+			km_device->clk_users++;
+	} else if (!WARN_ON(!km_device->clk_users) &&
+		   !--km_device->clk_users) {
+		mod_delayed_work(system_wq, &km_device->clk_off_work,
+				 msecs_to_jiffies(HWKM_CLK_IDLE_MS));
+	}
+	mutex_unlock(&km_device->clk_lock);
+
 	if (ret) {
 		pr_err("%s:%pK Could not enable/disable clocks\n",
 				__func__, km_device);
@@ -1051,7 +1119,7 @@ static int qti_hwkm_get_device_tree_data(struct platform_device *pdev,
 	return ret;
 }
 
-int qti_hwkm_handle_cmd(struct hwkm_cmd *cmd, struct hwkm_rsp *rsp)
+static int __qti_hwkm_handle_cmd(struct hwkm_cmd *cmd, struct hwkm_rsp *rsp)
 {
 	switch (cmd->op) {
 	case SYSTEM_KDF:
@@ -1073,8 +1141,55 @@ int qti_hwkm_handle_cmd(struct hwkm_cmd *cmd, struct hwkm_rsp *rsp)
 
 	return 0;
 }
+
+int qti_hwkm_handle_cmd(struct hwkm_cmd *cmd, struct hwkm_rsp *rsp)
+{
+	struct hwkm_cmd_stats *stats;
+	u64 start, delta;
+	int ret;
+
+	if (cmd->op >= HWKM_NUM_OPS)
+		return -EINVAL;
+
+	start = local_clock();
+	ret = __qti_hwkm_handle_cmd(cmd, rsp);
+	delta = local_clock() - start;
+
+	/* Callers serialize on the shared GP keyslot, no extra locking */
+	stats = &km_device->stats[cmd->op];
+	stats->count++;
+	if (ret)
+		stats->errors++;
+	stats->total_ns += delta;
+	if (delta > stats->max_ns)
+		stats->max_ns = delta;
+
+	return ret;
+}
 EXPORT_SYMBOL(qti_hwkm_handle_cmd);
 
+static int qti_hwkm_stats_show(struct seq_file *s, void *data)
+{
+	struct hwkm_device *hwkm_dev = s->private;
+	struct hwkm_cmd_stats *stats;
+	int i;
+
+	seq_printf(s, "clock enables: %lu\n", hwkm_dev->clk_enables);
+	seq_puts(s, "op count errors avg_ns max_ns\n");
+	for (i = 0; i < HWKM_NUM_OPS; i++) {
+		stats = &hwkm_dev->stats[i];
+		if (!stats->count)
+			continue;
+		seq_printf(s, "%s %lu %lu %llu %llu\n", hwkm_op_names[i],
+			   stats->count, stats->errors,
+			   div64_u64(stats->total_ns, stats->count),
+			   stats->max_ns);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(qti_hwkm_stats);
+
 static void qti_hwkm_configure_slot_access(struct hwkm_device *dev)
 {
 	qti_hwkm_writel(dev, 0xffffffff,
@@ -1280,6 +1395,12 @@ static int qti_hwkm_probe(struct platform_device *pdev)
 		goto err_hwkm_dev;
 	}
 
+	mutex_init(&hwkm_dev->clk_lock);
+	INIT_DELAYED_WORK(&hwkm_dev->clk_off_work, qti_hwkm_clk_off_work);
+	hwkm_dev->debugfs = debugfs_create_dir("hwkm", NULL);
+	debugfs_create_file("stats", 0400, hwkm_dev->debugfs, hwkm_dev,
+			    &qti_hwkm_stats_fops);
+
 	hwkm_dev->is_hwkm_enabled = true;
 	km_device = hwkm_dev;
 	platform_set_drvdata(pdev, hwkm_dev);
@@ -1296,10 +1417,23 @@ static int qti_hwkm_probe(struct platform_device *pdev)
 
 static int qti_hwkm_remove(struct platform_device *pdev)
 {
+	debugfs_remove_recursive(km_device->debugfs);
+	flush_delayed_work(&km_device->clk_off_work);
 	kfree(km_device);
 	return 0;
 }
 
+/* Don't carry the idle clock vote into suspend */
+static int qti_hwkm_suspend(struct device *dev)
+{
+	struct hwkm_device *hwkm_dev = dev_get_drvdata(dev);
+
+	flush_delayed_work(&hwkm_dev->clk_off_work);
+	return 0;
+}
+
+static SIMPLE_DEV_PM_OPS(qti_hwkm_pm_ops, qti_hwkm_suspend, NULL);
+
 static const struct of_device_id qti_hwkm_match[] = {
 	{ .compatible = "qcom,hwkm"},
 	{},
@@ -1312,6 +1446,7 @@ static struct platform_driver qti_hwkm_driver = {
 	.driver		= {
 		.name	= "qti_hwkm",
 		.of_match_table	= qti_hwkm_match,
+		.pm	= &qti_hwkm_pm_ops,
 	},
 };
 module_platform_driver(qti_hwkm_driver);
@@ -65,6 +65,14 @@ struct hyp_core_ctl_cpu_map {
  * @our_isolated_cpus: The CPUs isolated by hyp_core_ctl driver. output.
  * @final_reserved_cpus: The CPUs reserved for the Hypervisor. output.
  * @cpumap: The vcpu to pcpu mapping table
+ * @idle_release_ms: How long the guest vcpus must stay suspended before
+ *                   the reserved CPUs are handed back to the host
+ *                   scheduler. 0 keeps the reservation static.
+ * @idle_timer: Fires @idle_release_ms after the guest vcpus suspended
+ * @guest_idle: The VPM group reported all guest vcpus suspended
+ * @released: The reserved CPUs are currently given back to the host
+ * @nr_releases: Number of times the reservation was released
+ * @nr_reclaims: Number of times a released reservation was taken back
  */
 struct hyp_core_ctl_data {
 	spinlock_t lock;
@@ -76,6 +84,12 @@ struct hyp_core_ctl_data {
 	cpumask_t our_isolated_cpus;
 	cpumask_t final_reserved_cpus;
 	struct hyp_core_ctl_cpu_map cpumap[NR_CPUS];
+	unsigned int idle_release_ms;
+	struct timer_list idle_timer;
+	bool guest_idle;
+	bool released;
+	unsigned long nr_releases;
+	unsigned long nr_reclaims;
 };
 
 #define CREATE_TRACE_POINTS
@@ -422,6 +436,7 @@ static int hyp_core_ctl_thread(void *data)
 {
 	struct hyp_core_ctl_data *hcd = data;
 	unsigned long flags;
+	bool released;
 
 	while (1) {
 		spin_lock_irqsave(&hcd->lock, flags);
@@ -435,6 +450,7 @@ static int hyp_core_ctl_thread(void *data)
 			set_current_state(TASK_RUNNING);
 		}
 		hcd->pending = false;
+		released = hcd->released;
 		spin_unlock_irqrestore(&hcd->lock, flags);
 
 		if (kthread_should_stop())
@@ -448,7 +464,7 @@ static int hyp_core_ctl_thread(void *data)
 		 * not enabled, since there is no need for isolating.
 		 */
 		mutex_lock(&hcd->reservation_mutex);
-		if (hcd->reservation_enabled)
+		if (hcd->reservation_enabled && !released)
 			hyp_core_ctl_do_reservation(hcd);
 		else
 			hyp_core_ctl_undo_reservation(hcd);
@@ -735,6 +751,63 @@ static inline void hh_start_suspend_timer(void)
 			msecs_to_jiffies(sysctl_hh_suspend_timeout_ms));
 }
 
+/*
+ * Demand driven reservation. The guest vcpus keep their pcpu affinity,
+ * only the isolation of the reserved CPUs is dropped while the guest is
+ * suspended, so the host scheduler, and with it WALT and core_ctl which
+ * follow cpu_isolated_mask, can use them. The reservation is taken back
+ * as soon as the guest runs again.
+ *
+ * Called with hcd->lock held.
+ */
+static void hyp_core_ctl_reclaim(struct hyp_core_ctl_data *hcd)
+{
+	if (!hcd->released)
+		return;
+
+	hcd->released = false;
+	hcd->nr_reclaims++;
+	if (hcd->reservation_enabled) {
+		hcd->pending = true;
+		wake_up_process(hcd->task);
+	}
+}
+
+static void hyp_core_ctl_guest_active(struct hyp_core_ctl_data *hcd)
+{
+	hcd->guest_idle = false;
+	del_timer(&hcd->idle_timer);
+	hyp_core_ctl_reclaim(hcd);
+}
+
+static void hyp_core_ctl_guest_idle(struct hyp_core_ctl_data *hcd)
+{
+	hcd->guest_idle = true;
+
+	if (hcd->reservation_enabled && hcd->idle_release_ms &&
+	    !hcd->released)
+		mod_timer(&hcd->idle_timer, jiffies +
+			  msecs_to_jiffies(hcd->idle_release_ms));
+}
+
+static void hyp_core_ctl_idle_timer_fn(struct timer_list *t)
+{
+	struct hyp_core_ctl_data *hcd = from_timer(hcd, t, idle_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&hcd->lock, flags);
+	if (hcd->guest_idle && hcd->reservation_enabled &&
+	    hcd->idle_release_ms && !hcd->released) {
+		hcd->released = true;
+		hcd->nr_releases++;
+		hcd->pending = true;
+		wake_up_process(hcd->task);
+		trace_hyp_core_ctl_demand(SVM_STATE_CPUS_SUSPENDED,
+					  hcd->guest_idle, hcd->released);
+	}
+	spin_unlock_irqrestore(&hcd->lock, flags);
+}
+
 static irqreturn_t hh_susp_res_irq_handler(int irq, void *data)
 {
 	int err;
@@ -753,11 +826,17 @@ static irqreturn_t hh_susp_res_irq_handler(int irq, void *data)
 	if (vpmg_state == SVM_STATE_RUNNING) {
 		if (!the_hcd->reservation_enabled)
 			pr_err_ratelimited("Reservation not enabled,unexpected SVM wake up\n");
+		hyp_core_ctl_guest_active(the_hcd);
+	} else if (vpmg_state == SVM_STATE_CPUS_SUSPENDED) {
+		hyp_core_ctl_guest_idle(the_hcd);
 	} else if (vpmg_state == SVM_STATE_SYSTEM_SUSPENDED) {
 		hh_del_suspend_timer();
+		hyp_core_ctl_guest_idle(the_hcd);
 	} else {
 		pr_err("VPM Group state invalid/non-existent\n");
 	}
+	trace_hyp_core_ctl_demand(vpmg_state, the_hcd->guest_idle,
+				  the_hcd->released);
 	spin_unlock_irqrestore(&the_hcd->lock, flags);
 	return IRQ_HANDLED;
 }
@@ -811,12 +890,18 @@ static void hyp_core_ctl_enable(bool enable)
 			hh_start_suspend_timer();
 	}
 
+	/* Start from a full reservation, an idle guest releases it again */
+	the_hcd->released = false;
+	del_timer(&the_hcd->idle_timer);
+
 	trace_hyp_core_ctl_enable(enable);
 	pr_debug("reservation %s\n", enable ? "enabled" : "disabled");
 
 	the_hcd->reservation_enabled = enable;
 	the_hcd->pending = true;
 	wake_up_process(the_hcd->task);
+	if (enable && the_hcd->guest_idle)
+		hyp_core_ctl_guest_idle(the_hcd);
 out:
 	spin_unlock_irqrestore(&the_hcd->lock, flags);
 err_out:
@@ -858,6 +943,11 @@ static ssize_t status_show(struct device *dev, struct device_attribute *attr,
 	count = scnprintf(buf, PAGE_SIZE, "enabled=%d\n",
 			  hcd->reservation_enabled);
 
+	count += scnprintf(buf + count, PAGE_SIZE - count,
+			   "guest_idle=%d released=%d releases=%lu reclaims=%lu\n",
+			   hcd->guest_idle, hcd->released, hcd->nr_releases,
+			   hcd->nr_reclaims);
+
 	count += scnprintf(buf + count, PAGE_SIZE - count,
 			   "reserve_cpus=%*pbl\n",
 			   cpumask_pr_args(&hcd->reserve_cpus));
@@ -902,6 +992,39 @@ static ssize_t status_show(struct device *dev, struct device_attribute *attr,
 
 static DEVICE_ATTR_RO(status);
 
+static ssize_t idle_release_ms_store(struct device *dev,
+				     struct device_attribute *attr,
+				     const char *buf, size_t count)
+{
+	unsigned int val;
+	unsigned long flags;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&the_hcd->lock, flags);
+	the_hcd->idle_release_ms = val;
+	if (!val) {
+		del_timer(&the_hcd->idle_timer);
+		hyp_core_ctl_reclaim(the_hcd);
+	} else if (the_hcd->guest_idle) {
+		hyp_core_ctl_guest_idle(the_hcd);
+	}
+	spin_unlock_irqrestore(&the_hcd->lock, flags);
+
+	return count;
+}
+
+static ssize_t idle_release_ms_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", the_hcd->idle_release_ms);
+}
+
+static DEVICE_ATTR_RW(idle_release_ms);
+
 static int init_freq_qos_req(void)
 {
 	int cpu, ret;
@@ -1008,6 +1131,7 @@ static struct attribute *hyp_core_ctl_attrs[] = {
 	&dev_attr_enable.attr,
 	&dev_attr_status.attr,
 	&dev_attr_hcc_min_freq.attr,
+	&dev_attr_idle_release_ms.attr,
 	NULL
 };
 
@@ -1114,6 +1238,7 @@ static int hyp_core_ctl_probe(struct platform_device *pdev)
 
 	spin_lock_init(&hcd->lock);
 	mutex_init(&hcd->reservation_mutex);
+	timer_setup(&hcd->idle_timer, hyp_core_ctl_idle_timer_fn, 0);
 	hcd->task = kthread_run(hyp_core_ctl_thread, (void *) hcd,
 				"hyp_core_ctl");
 
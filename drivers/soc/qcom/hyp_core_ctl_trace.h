@@ -70,6 +70,28 @@ TRACE_EVENT(hyp_core_ctl_status,
 		  __entry->thermal)
 );
 
+TRACE_EVENT(hyp_core_ctl_demand,
+
+	TP_PROTO(u64 vpmg_state, bool guest_idle, bool released),
+
+	TP_ARGS(vpmg_state, guest_idle, released),
+
+	TP_STRUCT__entry(
+		__field(u64, vpmg_state)
+		__field(bool, guest_idle)
+		__field(bool, released)
+	),
+
+	TP_fast_assign(
+		__entry->vpmg_state = vpmg_state;
+		__entry->guest_idle = guest_idle;
+		__entry->released = released;
+	),
+
+	TP_printk("vpmg_state=%llu guest_idle=%d released=%d",
+		  __entry->vpmg_state, __entry->guest_idle, __entry->released)
+);
+
 #endif /* _TRACE_HYP_CORE_CTL_H */
 
 /* This part must be outside protection */
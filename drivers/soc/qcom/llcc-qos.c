@@ -0,0 +1,495 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#define pr_fmt(fmt) "llcc-qos: " fmt
+
+#include <linux/platform_device.h>
+#include <linux/math64.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
+
+#include <linux/soc/qcom/llcc-qcom.h>
+#include <linux/soc/qcom/llcc-qos.h>
+
+#define LLCC_QOS_STEP_KB		256
+#define LLCC_QOS_HI_MISS_PCT		30
+#define LLCC_QOS_LO_MISS_PCT		10
+#define LLCC_QOS_MIN_ACCESSES		10000
+#define LLCC_QOS_DEF_PERIOD_MS		200
+
+enum llcc_qos_class {
+	LLCC_QOS_CPU,
+	LLCC_QOS_GPU,
+	LLCC_QOS_DISP,
+	LLCC_QOS_CAMERA,
+	LLCC_QOS_CLASS_MAX,
+};
+
+static const u32 qos_class_uid[LLCC_QOS_CLASS_MAX] = {
+	[LLCC_QOS_CPU] = LLCC_CPUSS,
+	[LLCC_QOS_GPU] = LLCC_GPU,
+	[LLCC_QOS_DISP] = LLCC_DISP,
+	[LLCC_QOS_CAMERA] = LLCC_CVP,
+};
+
+static const char * const qos_class_name[LLCC_QOS_CLASS_MAX] = {
+	[LLCC_QOS_CPU] = "cpu",
+	[LLCC_QOS_GPU] = "gpu",
+	[LLCC_QOS_DISP] = "disp",
+	[LLCC_QOS_CAMERA] = "camera",
+};
+
+static const char * const qos_profile_name[LLCC_QOS_PROFILE_MAX] = {
+	[LLCC_QOS_PROFILE_DEFAULT] = "default",
+	[LLCC_QOS_PROFILE_GAME] = "game",
+	[LLCC_QOS_PROFILE_CAMERA] = "camera",
+	[LLCC_QOS_PROFILE_VIDEO] = "video",
+};
+
+/*
+ * Percentage of the managed capacity given to each class. The default
+ * profile has no entry and keeps the sizes from the SCT.
+ */
+static const u32 qos_profile_share[LLCC_QOS_PROFILE_MAX][LLCC_QOS_CLASS_MAX] = {
+	[LLCC_QOS_PROFILE_GAME] = { 25, 55, 15, 5 },
+	[LLCC_QOS_PROFILE_CAMERA] = { 20, 10, 15, 55 },
+	[LLCC_QOS_PROFILE_VIDEO] = { 25, 15, 45, 15 },
+};
+
+/**
+ * struct llcc_qos_slice - a slice managed by the partition manager
+ * @cfg: SCT entry of the slice, NULL if the target has no such slice
+ * @size: capacity currently programmed, in KB
+ * @target: capacity asked for by the profile, in KB
+ * @bias: capacity moved to or from this slice by miss feedback, in KB
+ * @accesses: accesses in the last sample of this slice
+ * @misses: misses in the last sample of this slice
+ * @fresh: a sample was reported since the last rebalance
+ */
+struct llcc_qos_slice {
+	const struct llcc_slice_config *cfg;
+	u32 size;
+	u32 target;
+	int bias;
+	u64 accesses;
+	u64 misses;
+	bool fresh;
+};
+
+/**
+ * struct llcc_qos_drv_data - llcc partition manager
+ * @dev: the llcc device
+ * @slice: managed slices, indexed by enum llcc_qos_class
+ * @budget: sum of the SCT capacity of the managed slices, in KB
+ * @profile: current foreground profile
+ * @enabled: the manager owns the capacity of the managed slices
+ * @period_ms: rebalance period
+ * @work: periodic rebalance
+ * @lock: protects this structure
+ */
+struct llcc_qos_drv_data {
+	struct device *dev;
+	struct llcc_qos_slice slice[LLCC_QOS_CLASS_MAX];
+	u32 budget;
+	enum llcc_qos_profile profile;
+	bool enabled;
+	unsigned int period_ms;
+	struct delayed_work work;
+	struct mutex lock;
+};
+
+static struct llcc_qos_drv_data *drv_data = (void *) -EPROBE_DEFER;
+
+static u32 qos_miss_pct(const struct llcc_qos_slice *slice)
+{
+	if (!slice->accesses)
+		return 0;
+
+	return div64_u64(slice->misses * 100, slice->accesses);
+}
+
+static void qos_apply(void)
+{
+	struct llcc_qos_slice *slice;
+	u32 size;
+	int i, ret;
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		if (!slice->cfg)
+			continue;
+
+		size = drv_data->enabled ? slice->target + slice->bias :
+					   slice->cfg->max_cap;
+		if (size == slice->size)
+			continue;
+
+		ret = llcc_slice_set_max_cap(slice->cfg->slice_id, size);
+		if (ret) {
+			dev_err(drv_data->dev, "Failed to resize %s slice to %uKB: %d\n",
+				qos_class_name[i], size, ret);
+			continue;
+		}
+		slice->size = size;
+	}
+}
+
+static void qos_set_targets(void)
+{
+	const u32 *share = qos_profile_share[drv_data->profile];
+	struct llcc_qos_slice *slice;
+	u32 target;
+	int i;
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		if (!slice->cfg)
+			continue;
+
+		if (drv_data->profile == LLCC_QOS_PROFILE_DEFAULT) {
+			target = slice->cfg->max_cap;
+		} else {
+			target = drv_data->budget * share[i] / 100;
+			target = rounddown(target, LLCC_QOS_STEP_KB);
+			target = max_t(u32, target, LLCC_QOS_STEP_KB);
+		}
+
+		slice->target = target;
+		slice->bias = 0;
+	}
+}
+
+/*
+ * Move one step of capacity from the slice with the lowest miss ratio to
+ * the one with the highest, if the first barely misses and the second
+ * misses a lot. Feedback may move at most half of a slice's profile
+ * target so that the split stays recognisably the profile's.
+ */
+static void qos_rebalance(void)
+{
+	struct llcc_qos_slice *slice, *needy = NULL, *donor = NULL;
+	u32 pct, needy_pct = LLCC_QOS_HI_MISS_PCT;
+	u32 donor_pct = LLCC_QOS_LO_MISS_PCT;
+	int i;
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		if (!slice->cfg || !slice->fresh ||
+		    slice->accesses < LLCC_QOS_MIN_ACCESSES)
+			continue;
+
+		pct = qos_miss_pct(slice);
+		if (pct > needy_pct &&
+		    slice->bias + LLCC_QOS_STEP_KB <= (int)(slice->target / 2)) {
+			needy = slice;
+			needy_pct = pct;
+		}
+
+		if (pct < donor_pct &&
+		    slice->bias - LLCC_QOS_STEP_KB >= -(int)(slice->target / 2)) {
+			donor = slice;
+			donor_pct = pct;
+		}
+	}
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++)
+		drv_data->slice[i].fresh = false;
+
+	if (!needy || !donor)
+		return;
+
+	needy->bias += LLCC_QOS_STEP_KB;
+	donor->bias -= LLCC_QOS_STEP_KB;
+}
+
+static void qos_work_fn(struct work_struct *work)
+{
+	mutex_lock(&drv_data->lock);
+	if (!drv_data->enabled) {
+		mutex_unlock(&drv_data->lock);
+		return;
+	}
+
+	qos_rebalance();
+	qos_apply();
+	schedule_delayed_work(&drv_data->work,
+			      msecs_to_jiffies(drv_data->period_ms));
+	mutex_unlock(&drv_data->lock);
+}
+
+/**
+ * llcc_qos_set_profile - Split the managed slices for a foreground use case
+ * @profile: the foreground profile
+ *
+ * Miss feedback gathered for the previous profile is dropped. Returns 0 on
+ * success and a negative error code on failure
+ */
+int llcc_qos_set_profile(enum llcc_qos_profile profile)
+{
+	if (IS_ERR(drv_data))
+		return PTR_ERR(drv_data);
+
+	if (profile >= LLCC_QOS_PROFILE_MAX)
+		return -EINVAL;
+
+	mutex_lock(&drv_data->lock);
+	drv_data->profile = profile;
+	qos_set_targets();
+	qos_apply();
+	mutex_unlock(&drv_data->lock);
+
+	return 0;
+}
+EXPORT_SYMBOL(llcc_qos_set_profile);
+
+/**
+ * llcc_qos_next_slice - Iterate the slices that want miss feedback
+ * @slice_id: the previous slice id, or a negative value to start over
+ *
+ * Returns the id of the managed slice after @slice_id, wrapping around,
+ * or -ENODEV if the manager is not enabled
+ */
+int llcc_qos_next_slice(int slice_id)
+{
+	int i, pos = -1, next = -ENODEV;
+
+	if (IS_ERR(drv_data))
+		return PTR_ERR(drv_data);
+
+	mutex_lock(&drv_data->lock);
+	if (!drv_data->enabled)
+		goto unlock;
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		if (drv_data->slice[i].cfg &&
+		    drv_data->slice[i].cfg->slice_id == slice_id)
+			pos = i;
+	}
+
+	for (i = 1; i <= LLCC_QOS_CLASS_MAX; i++) {
+		const struct llcc_slice_config *cfg =
+			drv_data->slice[(pos + i) % LLCC_QOS_CLASS_MAX].cfg;
+
+		if (!cfg)
+			continue;
+
+		next = cfg->slice_id;
+		break;
+	}
+
+unlock:
+	mutex_unlock(&drv_data->lock);
+	return next;
+}
+EXPORT_SYMBOL(llcc_qos_next_slice);
+
+/**
+ * llcc_qos_report_stats - Feed a hit/miss sample of a slice to the manager
+ * @slice_id: the sampled slice
+ * @accesses: number of accesses seen on the slice during the sample
+ * @misses: number of those that missed
+ */
+void llcc_qos_report_stats(u32 slice_id, u64 accesses, u64 misses)
+{
+	struct llcc_qos_slice *slice;
+	int i;
+
+	if (IS_ERR(drv_data))
+		return;
+
+	mutex_lock(&drv_data->lock);
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		if (!slice->cfg || slice->cfg->slice_id != slice_id)
+			continue;
+
+		slice->accesses = accesses;
+		slice->misses = misses;
+		slice->fresh = true;
+		break;
+	}
+	mutex_unlock(&drv_data->lock);
+}
+EXPORT_SYMBOL(llcc_qos_report_stats);
+
+static ssize_t qos_enable_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%d\n", drv_data->enabled);
+}
+
+static ssize_t qos_enable_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	mutex_lock(&drv_data->lock);
+	if (enable != drv_data->enabled) {
+		drv_data->enabled = enable;
+		qos_set_targets();
+		qos_apply();
+		if (enable)
+			schedule_delayed_work(&drv_data->work,
+				msecs_to_jiffies(drv_data->period_ms));
+	}
+	mutex_unlock(&drv_data->lock);
+
+	return count;
+}
+
+static ssize_t qos_profile_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%s\n",
+			 qos_profile_name[drv_data->profile]);
+}
+
+static ssize_t qos_profile_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	int profile, ret;
+
+	profile = sysfs_match_string(qos_profile_name, buf);
+	if (profile < 0)
+		return profile;
+
+	ret = llcc_qos_set_profile(profile);
+
+	return ret ? ret : count;
+}
+
+static ssize_t qos_period_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", drv_data->period_ms);
+}
+
+static ssize_t qos_period_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int period_ms;
+
+	if (kstrtouint(buf, 0, &period_ms) || !period_ms)
+		return -EINVAL;
+
+	mutex_lock(&drv_data->lock);
+	drv_data->period_ms = period_ms;
+	mutex_unlock(&drv_data->lock);
+
+	return count;
+}
+
+static ssize_t qos_slices_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_qos_slice *slice;
+	ssize_t cnt = 0;
+	int i;
+
+	mutex_lock(&drv_data->lock);
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		if (!slice->cfg)
+			continue;
+
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt,
+				"%-6s SCID %02u size %5uKB target %5uKB bias %5dKB miss %3u%%\n",
+				qos_class_name[i], slice->cfg->slice_id,
+				slice->size, slice->target, slice->bias,
+				qos_miss_pct(slice));
+	}
+	mutex_unlock(&drv_data->lock);
+
+	return cnt;
+}
+
+static DEVICE_ATTR_RW(qos_enable);
+static DEVICE_ATTR_RW(qos_profile);
+static DEVICE_ATTR_RW(qos_period_ms);
+static DEVICE_ATTR_RO(qos_slices);
+
+static struct attribute *llcc_qos_attrs[] = {
+	&dev_attr_qos_enable.attr,
+	&dev_attr_qos_profile.attr,
+	&dev_attr_qos_period_ms.attr,
+	&dev_attr_qos_slices.attr,
+	NULL,
+};
+
+static const struct attribute_group llcc_qos_group = {
+	.attrs	= llcc_qos_attrs,
+};
+
+/**
+ * qcom_llcc_qos_probe - Probes the slice partition manager
+ * @pdev: the platform device for the llcc driver
+ * @table: the llcc slice table
+ * @size: the size of the llcc slice table
+ *
+ * Returns 0 on success and a negative error code on failure
+ */
+int qcom_llcc_qos_probe(struct platform_device *pdev,
+		const struct llcc_slice_config *table, size_t size)
+{
+	struct llcc_qos_slice *slice;
+	size_t i, j;
+	int ret;
+
+	drv_data = devm_kzalloc(&pdev->dev, sizeof(*drv_data), GFP_KERNEL);
+	if (!drv_data) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	drv_data->dev = &pdev->dev;
+	drv_data->period_ms = LLCC_QOS_DEF_PERIOD_MS;
+	drv_data->profile = LLCC_QOS_PROFILE_DEFAULT;
+	mutex_init(&drv_data->lock);
+	INIT_DELAYED_WORK(&drv_data->work, qos_work_fn);
+
+	for (i = 0; i < LLCC_QOS_CLASS_MAX; i++) {
+		slice = &drv_data->slice[i];
+		for (j = 0; j < size; j++) {
+			if (table[j].usecase_id != qos_class_uid[i])
+				continue;
+
+			slice->cfg = &table[j];
+			slice->size = table[j].max_cap;
+			drv_data->budget += table[j].max_cap;
+			break;
+		}
+	}
+	qos_set_targets();
+
+	ret = devm_device_add_group(&pdev->dev, &llcc_qos_group);
+	if (ret)
+		goto err;
+
+	return 0;
+
+err:
+	drv_data = ERR_PTR(-ENODEV);
+	return ret;
+}
+
+/**
+ * qcom_llcc_qos_remove - Stops the slice partition manager
+ * @pdev: the platform device for the llcc driver
+ */
+void qcom_llcc_qos_remove(struct platform_device *pdev)
+{
+	if (IS_ERR(drv_data))
+		return;
+
+	mutex_lock(&drv_data->lock);
+	drv_data->enabled = false;
+	mutex_unlock(&drv_data->lock);
+	cancel_delayed_work_sync(&drv_data->work);
+	drv_data = ERR_PTR(-ENODEV);
+}
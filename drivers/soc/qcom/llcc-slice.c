@@ -15,6 +15,7 @@
 #include <linux/regmap.h>
 #include <linux/sizes.h>
 #include <linux/slab.h>
+#include <linux/soc/qcom/llcc-qos.h>
 #include <linux/soc/qcom/llcc-tcm.h>
 
 #define ACTIVATE                      BIT(0)
@@ -27,6 +28,7 @@
 #define ATTR1_FIXED_SIZE_SHIFT        0x03
 #define ATTR1_PRIORITY_SHIFT          0x04
 #define ATTR1_MAX_CAP_SHIFT           0x10
+#define ATTR1_MAX_CAP_MASK            GENMASK(31, 16)
 #define ATTR0_RES_WAYS_MASK           GENMASK(11, 0)
 #define ATTR0_BONUS_WAYS_MASK         GENMASK(27, 16)
 #define ATTR0_BONUS_WAYS_SHIFT        0x10
@@ -252,6 +254,47 @@ size_t llcc_get_slice_size(struct llcc_slice_desc *desc)
 }
 EXPORT_SYMBOL_GPL(llcc_get_slice_size);
 
+static u32 llcc_max_cap_to_cachelines(u32 max_cap)
+{
+	u32 max_cap_cacheline = MAX_CAP_TO_BYTES(max_cap);
+
+	/* LLCC instances can vary for each target.
+	 * The SW writes to broadcast register which gets propagated
+	 * to each llcc instace (llcc0,.. llccN).
+	 * Since the size of the memory is divided equally amongst the
+	 * llcc instances, we need to configure the max cap accordingly.
+	 */
+	max_cap_cacheline = max_cap_cacheline / drv_data->num_banks;
+	return max_cap_cacheline >> CACHE_LINE_SIZE_SHIFT;
+}
+
+/**
+ * llcc_slice_set_max_cap - Reprogram the capacity of a slice
+ * @slice_id: llcc slice id
+ * @max_cap: new capacity of the slice in KB
+ *
+ * A value of zero will be returned on success and a negative errno will
+ * be returned in error cases
+ */
+int llcc_slice_set_max_cap(u32 slice_id, u32 max_cap)
+{
+	u32 attr1_val;
+	int ret;
+
+	if (IS_ERR(drv_data))
+		return PTR_ERR(drv_data);
+
+	attr1_val = llcc_max_cap_to_cachelines(max_cap) << ATTR1_MAX_CAP_SHIFT;
+
+	mutex_lock(&drv_data->lock);
+	ret = regmap_update_bits(drv_data->bcast_regmap,
+				 LLCC_TRP_ATTR1_CFGn(slice_id),
+				 ATTR1_MAX_CAP_MASK, attr1_val);
+	mutex_unlock(&drv_data->lock);
+
+	return ret;
+}
+
 static int qcom_llcc_cfg_program(struct platform_device *pdev)
 {
 	int i;
@@ -259,7 +302,6 @@ static int qcom_llcc_cfg_program(struct platform_device *pdev)
 	u32 attr0_cfg;
 	u32 attr1_val;
 	u32 attr0_val;
-	u32 max_cap_cacheline;
 	u32 sz;
 	u32 pcb = 0;
 	u32 cad = 0;
@@ -287,17 +329,8 @@ static int qcom_llcc_cfg_program(struct platform_device *pdev)
 		attr1_val |= llcc_table[i].priority <<
 				ATTR1_PRIORITY_SHIFT;
 
-		max_cap_cacheline = MAX_CAP_TO_BYTES(llcc_table[i].max_cap);
-
-		/* LLCC instances can vary for each target.
-		 * The SW writes to broadcast register which gets propagated
-		 * to each llcc instace (llcc0,.. llccN).
-		 * Since the size of the memory is divided equally amongst the
-		 * llcc instances, we need to configure the max cap accordingly.
-		 */
-		max_cap_cacheline = max_cap_cacheline / drv_data->num_banks;
-		max_cap_cacheline >>= CACHE_LINE_SIZE_SHIFT;
-		attr1_val |= max_cap_cacheline << ATTR1_MAX_CAP_SHIFT;
+		attr1_val |= llcc_max_cap_to_cachelines(llcc_table[i].max_cap) <<
+				ATTR1_MAX_CAP_SHIFT;
 
 		attr0_val = llcc_table[i].res_ways & ATTR0_RES_WAYS_MASK;
 		attr0_val |= llcc_table[i].bonus_ways << ATTR0_BONUS_WAYS_SHIFT;
@@ -346,6 +379,8 @@ static int qcom_llcc_cfg_program(struct platform_device *pdev)
 
 int qcom_llcc_remove(struct platform_device *pdev)
 {
+	qcom_llcc_qos_remove(pdev);
+
 	/* Set the global pointer to a error code to avoid referencing it */
 	drv_data = ERR_PTR(-ENODEV);
 	return 0;
@@ -469,6 +504,12 @@ int qcom_llcc_probe(struct platform_device *pdev,
 		}
 	}
 
+	ret = qcom_llcc_qos_probe(pdev, llcc_cfg, sz);
+	if (ret) {
+		dev_err(dev, "Failed to probe QoS manager\n");
+		goto err_dereg;
+	}
+
 	return 0;
 
 err_dereg:
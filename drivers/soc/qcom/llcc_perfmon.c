@@ -13,8 +13,10 @@
 #include <linux/hrtimer.h>
 #include <linux/regmap.h>
 #include <linux/soc/qcom/llcc-qcom.h>
+#include <linux/soc/qcom/llcc-qos.h>
 #include <linux/module.h>
 #include <linux/clk.h>
+#include <linux/workqueue.h>
 #include "llcc_events.h"
 #include "llcc_perfmon.h"
 
@@ -70,6 +72,10 @@ struct event_port_ops {
  * @num_mc:		number of MCS
  * @version:		Version information of llcc block
  * @clk:		clock node to enable qdss
+ * @qos_sampling:	QoS sampler owns the counters and the clock
+ * @qos_scid:		SCID being sampled for the QoS manager, or -1
+ * @qos_period_ms:	QoS sample length, 0 to stop sampling
+ * @qos_work:		QoS sample rotation
  */
 struct llcc_perfmon_private {
 	struct regmap *llcc_map;
@@ -88,6 +94,17 @@ struct llcc_perfmon_private {
 	unsigned int num_mc;
 	unsigned int version;
 	struct clk *clock;
+	bool qos_sampling;
+	int qos_scid;
+	unsigned int qos_period_ms;
+	struct delayed_work qos_work;
+};
+
+/* TRP events counted for each SCID sampled for the LLCC QoS manager */
+static const unsigned int qos_sample_events[] = {
+	TRP_ANY_ACCESS,
+	TRP_RD_MISS,
+	TRP_WR_MISS,
 };
 
 static inline void llcc_bcast_write(struct llcc_perfmon_private *llcc_priv,
@@ -204,7 +221,7 @@ static ssize_t perfmon_configure_store(struct device *dev,
 	char *token, *delim = DELIM_CHAR;
 
 	mutex_lock(&llcc_priv->mutex);
-	if (llcc_priv->configured_cntrs) {
+	if (llcc_priv->configured_cntrs || llcc_priv->qos_sampling) {
 		pr_err("Counters configured already, remove & try again\n");
 		mutex_unlock(&llcc_priv->mutex);
 		return -EINVAL;
@@ -276,6 +293,12 @@ static ssize_t perfmon_remove_store(struct device *dev,
 	char *token, *delim = DELIM_CHAR;
 
 	mutex_lock(&llcc_priv->mutex);
+	if (llcc_priv->qos_sampling) {
+		pr_err("Counters in use by QoS sampling\n");
+		mutex_unlock(&llcc_priv->mutex);
+		return -EBUSY;
+	}
+
 	if (!llcc_priv->configured_cntrs) {
 		pr_err("Counters not configured\n");
 		mutex_unlock(&llcc_priv->mutex);
@@ -364,7 +387,7 @@ static ssize_t perfmon_filter_config_store(struct device *dev,
 	char *token, *delim = DELIM_CHAR;
 	enum filter_type filter = UNKNOWN;
 
-	if (llcc_priv->configured_cntrs) {
+	if (llcc_priv->configured_cntrs || llcc_priv->qos_sampling) {
 		pr_err("remove configured events and try\n");
 		return count;
 	}
@@ -508,6 +531,12 @@ static ssize_t perfmon_start_store(struct device *dev,
 		return -EINVAL;
 
 	mutex_lock(&llcc_priv->mutex);
+	if (llcc_priv->qos_sampling) {
+		pr_err("Counters in use by QoS sampling\n");
+		mutex_unlock(&llcc_priv->mutex);
+		return -EBUSY;
+	}
+
 	if (start) {
 		if (!llcc_priv->configured_cntrs) {
 			pr_err("start failed. perfmon not configured\n");
@@ -612,6 +641,156 @@ static ssize_t perfmon_scid_status_show(struct device *dev,
 	return cnt;
 }
 
+static void perfmon_qos_sample_start(struct llcc_perfmon_private *llcc_priv,
+		u32 scid)
+{
+	struct event_port_ops *port_ops = llcc_priv->port_ops[EVENT_PORT_TRP];
+	struct llcc_perfmon_counter_map *counter_map;
+	unsigned int i, j;
+	uint32_t val;
+
+	llcc_priv->filtered_ports |= 1 << EVENT_PORT_TRP;
+	port_ops->event_filter_config(llcc_priv, SCID, scid, SCID_MAX - 1,
+			true);
+
+	for (i = 0; i < ARRAY_SIZE(qos_sample_events); i++) {
+		counter_map = &llcc_priv->configured[i];
+		counter_map->port_sel = EVENT_PORT_TRP;
+		counter_map->event_sel = qos_sample_events[i];
+		for (j = 0; j < llcc_priv->num_banks; j++)
+			counter_map->counter_dump[j] = 0;
+
+		port_ops->event_config(llcc_priv, qos_sample_events[i], &i,
+				true);
+	}
+
+	/* configure clock event */
+	val = COUNT_CLOCK_EVENT | CLEAR_ON_ENABLE | CLEAR_ON_DUMP;
+	llcc_bcast_write(llcc_priv, PERFMON_COUNTER_n_CONFIG(i++), val);
+	llcc_priv->configured_cntrs = i;
+
+	llcc_bcast_modify(llcc_priv, PERFMON_MODE, MANUAL_MODE | MONITOR_EN,
+			PERFMON_MODE_MONITOR_MODE_MASK |
+			PERFMON_MODE_MONITOR_EN_MASK);
+}
+
+static void perfmon_qos_sample_stop(struct llcc_perfmon_private *llcc_priv,
+		u32 scid, u64 *accesses, u64 *misses)
+{
+	struct event_port_ops *port_ops = llcc_priv->port_ops[EVENT_PORT_TRP];
+	struct llcc_perfmon_counter_map *counter_map;
+	unsigned int i, j;
+
+	perfmon_counter_dump(llcc_priv);
+	llcc_bcast_modify(llcc_priv, PERFMON_MODE, 0,
+			PERFMON_MODE_MONITOR_MODE_MASK |
+			PERFMON_MODE_MONITOR_EN_MASK);
+
+	*accesses = 0;
+	*misses = 0;
+	for (i = 0; i < ARRAY_SIZE(qos_sample_events); i++) {
+		counter_map = &llcc_priv->configured[i];
+		for (j = 0; j < llcc_priv->num_banks; j++) {
+			if (qos_sample_events[i] == TRP_ANY_ACCESS)
+				*accesses += counter_map->counter_dump[j];
+			else
+				*misses += counter_map->counter_dump[j];
+		}
+
+		counter_map->port_sel = MAX_NUMBER_OF_PORTS;
+		counter_map->event_sel = 0;
+		port_ops->event_config(llcc_priv, qos_sample_events[i], &i,
+				false);
+	}
+
+	/* remove clock event */
+	llcc_bcast_write(llcc_priv, PERFMON_COUNTER_n_CONFIG(i), 0);
+	llcc_priv->configured_cntrs = 0;
+
+	port_ops->event_filter_config(llcc_priv, SCID, scid, SCID_MAX - 1,
+			false);
+	llcc_priv->filtered_ports &= ~(1 << EVENT_PORT_TRP);
+}
+
+/*
+ * Sample the TRP accesses and misses of one managed slice per period and
+ * hand them to the LLCC QoS manager, rotating over its slices. The port
+ * has a single SCID filter, so the slices take turns.
+ */
+static void perfmon_qos_sample_work(struct work_struct *work)
+{
+	struct llcc_perfmon_private *llcc_priv = container_of(to_delayed_work(work),
+			struct llcc_perfmon_private, qos_work);
+	u64 accesses, misses;
+	int scid;
+
+	mutex_lock(&llcc_priv->mutex);
+	scid = llcc_priv->qos_scid;
+	if (scid >= 0) {
+		perfmon_qos_sample_stop(llcc_priv, scid, &accesses, &misses);
+		llcc_qos_report_stats(scid, accesses, misses);
+	}
+
+	if (!llcc_priv->qos_period_ms) {
+		llcc_priv->qos_scid = -1;
+		llcc_priv->qos_sampling = false;
+		clk_disable_unprepare(llcc_priv->clock);
+		mutex_unlock(&llcc_priv->mutex);
+		return;
+	}
+
+	scid = llcc_qos_next_slice(scid);
+	llcc_priv->qos_scid = scid < 0 ? -1 : scid;
+	if (scid >= 0)
+		perfmon_qos_sample_start(llcc_priv, scid);
+
+	schedule_delayed_work(&llcc_priv->qos_work,
+			msecs_to_jiffies(llcc_priv->qos_period_ms));
+	mutex_unlock(&llcc_priv->mutex);
+}
+
+static ssize_t perfmon_qos_sample_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", llcc_priv->qos_period_ms);
+}
+
+static ssize_t perfmon_qos_sample_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf,
+		size_t count)
+{
+	struct llcc_perfmon_private *llcc_priv = dev_get_drvdata(dev);
+	unsigned int period_ms;
+	int ret;
+
+	if (kstrtouint(buf, 0, &period_ms))
+		return -EINVAL;
+
+	mutex_lock(&llcc_priv->mutex);
+	if (period_ms && !llcc_priv->qos_sampling) {
+		if (llcc_priv->configured_cntrs) {
+			pr_err("remove configured events and try\n");
+			mutex_unlock(&llcc_priv->mutex);
+			return -EBUSY;
+		}
+
+		ret = clk_prepare_enable(llcc_priv->clock);
+		if (ret) {
+			mutex_unlock(&llcc_priv->mutex);
+			return -EINVAL;
+		}
+
+		llcc_priv->qos_sampling = true;
+		schedule_delayed_work(&llcc_priv->qos_work, 0);
+	}
+
+	llcc_priv->qos_period_ms = period_ms;
+	mutex_unlock(&llcc_priv->mutex);
+	return count;
+}
+
 static DEVICE_ATTR_RO(perfmon_counter_dump);
 static DEVICE_ATTR_WO(perfmon_configure);
 static DEVICE_ATTR_WO(perfmon_remove);
@@ -620,6 +799,7 @@ static DEVICE_ATTR_WO(perfmon_filter_remove);
 static DEVICE_ATTR_WO(perfmon_start);
 static DEVICE_ATTR_RO(perfmon_scid_status);
 static DEVICE_ATTR_WO(perfmon_ns_periodic_dump);
+static DEVICE_ATTR_RW(perfmon_qos_sample_ms);
 
 static struct attribute *llcc_perfmon_attrs[] = {
 	&dev_attr_perfmon_counter_dump.attr,
@@ -630,6 +810,7 @@ static struct attribute *llcc_perfmon_attrs[] = {
 	&dev_attr_perfmon_start.attr,
 	&dev_attr_perfmon_scid_status.attr,
 	&dev_attr_perfmon_ns_periodic_dump.attr,
+	&dev_attr_perfmon_qos_sample_ms.attr,
 	NULL,
 };
 
@@ -1307,6 +1488,8 @@ static int llcc_perfmon_probe(struct platform_device *pdev)
 	hrtimer_init(&llcc_priv->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	llcc_priv->hrtimer.function = llcc_perfmon_timer_handler;
 	llcc_priv->expires = 0;
+	llcc_priv->qos_scid = -1;
+	INIT_DELAYED_WORK(&llcc_priv->qos_work, perfmon_qos_sample_work);
 	pr_info("Revision %d, has %d memory controllers connected with LLCC\n",
 			llcc_priv->version, llcc_priv->num_mc);
 	return 0;
@@ -1319,6 +1502,13 @@ static int llcc_perfmon_remove(struct platform_device *pdev)
 	while (hrtimer_active(&llcc_priv->hrtimer))
 		hrtimer_cancel(&llcc_priv->hrtimer);
 
+	mutex_lock(&llcc_priv->mutex);
+	llcc_priv->qos_period_ms = 0;
+	mutex_unlock(&llcc_priv->mutex);
+	cancel_delayed_work_sync(&llcc_priv->qos_work);
+	if (llcc_priv->qos_sampling)
+		perfmon_qos_sample_work(&llcc_priv->qos_work.work);
+
 	mutex_destroy(&llcc_priv->mutex);
 	sysfs_remove_group(&pdev->dev.kobj, &llcc_perfmon_group);
 	platform_set_drvdata(pdev, NULL);
@@ -84,6 +84,16 @@ static struct device *mem_buf_dev;
 static DEFINE_MUTEX(mem_buf_xfer_mem_list_lock);
 static LIST_HEAD(mem_buf_xfer_mem_list);
 
+/*
+ * Buffers relinquished by other VMs, waiting to be assigned back to HLOS.
+ * Buffers lent with the same ACL are reclaimed with one batched assignment.
+ */
+#define MEM_BUF_RECLAIM_BATCH 16
+static DEFINE_MUTEX(mem_buf_reclaim_list_lock);
+static LIST_HEAD(mem_buf_reclaim_list);
+static void mem_buf_reclaim_work(struct work_struct *work);
+static DECLARE_WORK(mem_buf_reclaim_work_struct, mem_buf_reclaim_work);
+
 /**
  * struct mem_buf_rmt_msg: Represents a message sent from a remote VM
  * @msg: A pointer to the message buffer
@@ -701,6 +711,66 @@ static void mem_buf_alloc_req_work(struct work_struct *work)
 	kfree(rmt_msg);
 }
 
+static bool mem_buf_xfer_mem_same_acl(struct mem_buf_xfer_mem *a,
+				      struct mem_buf_xfer_mem *b)
+{
+	return a->nr_acl_entries == b->nr_acl_entries &&
+	       !memcmp(a->dst_vmids, b->dst_vmids,
+		       a->nr_acl_entries * sizeof(*a->dst_vmids));
+}
+
+static void mem_buf_reclaim_work(struct work_struct *work)
+{
+	struct mem_buf_xfer_mem *xfer_mem, *tmp, *first;
+	struct sg_table *sgts[MEM_BUF_RECLAIM_BATCH];
+	int dst_vmid = VMID_HLOS;
+	int dst_perms = PERM_READ | PERM_WRITE | PERM_EXEC;
+	LIST_HEAD(pending);
+	LIST_HEAD(batch);
+	int nr, ret;
+
+	mutex_lock(&mem_buf_reclaim_list_lock);
+	list_splice_init(&mem_buf_reclaim_list, &pending);
+	mutex_unlock(&mem_buf_reclaim_list_lock);
+
+	while (!list_empty(&pending)) {
+		first = list_first_entry(&pending, struct mem_buf_xfer_mem,
+					 entry);
+		if (first->secure_alloc) {
+			list_del(&first->entry);
+			mem_buf_cleanup_alloc_req(first);
+			continue;
+		}
+
+		nr = 0;
+		list_for_each_entry_safe(xfer_mem, tmp, &pending, entry) {
+			if (xfer_mem->secure_alloc ||
+			    !mem_buf_xfer_mem_same_acl(first, xfer_mem))
+				continue;
+			sgts[nr++] = xfer_mem->mem_sgt;
+			list_move_tail(&xfer_mem->entry, &batch);
+			if (nr == MEM_BUF_RECLAIM_BATCH)
+				break;
+		}
+
+		pr_debug("%s: Unassigning %d buffers to HLOS\n", __func__, nr);
+		ret = hyp_assign_tables(sgts, nr, first->dst_vmids,
+					first->nr_acl_entries, &dst_vmid,
+					&dst_perms, 1);
+		list_for_each_entry_safe(xfer_mem, tmp, &batch, entry) {
+			list_del(&xfer_mem->entry);
+			/* The state of the memory is unknown, leak it */
+			if (ret < 0)
+				continue;
+			mem_buf_rmt_free_mem(xfer_mem);
+			mem_buf_free_xfer_mem(xfer_mem);
+		}
+		if (ret < 0)
+			pr_err("%s: failed to assign memory from rmt allocation rc: %d\n",
+			       __func__, ret);
+	}
+}
+
 static void mem_buf_relinquish_work(struct work_struct *work)
 {
 	struct mem_buf_xfer_mem *xfer_mem_iter, *tmp, *xfer_mem = NULL;
@@ -719,11 +789,19 @@ static void mem_buf_relinquish_work(struct work_struct *work)
 		}
 	mutex_unlock(&mem_buf_xfer_mem_list_lock);
 
-	if (xfer_mem)
-		mem_buf_cleanup_alloc_req(xfer_mem);
-	else
+	if (xfer_mem) {
+		/*
+		 * The reclaim work is queued behind any relinquish messages
+		 * already pending, so a burst of them is reclaimed together.
+		 */
+		mutex_lock(&mem_buf_reclaim_list_lock);
+		list_add_tail(&xfer_mem->entry, &mem_buf_reclaim_list);
+		mutex_unlock(&mem_buf_reclaim_list_lock);
+		queue_work(mem_buf_wq, &mem_buf_reclaim_work_struct);
+	} else {
 		pr_err("%s: transferred memory with handle 0x%x not found\n",
 		       __func__, hdl);
+	}
 
 	kfree(rmt_msg->msg);
 	kfree(rmt_msg);
@@ -143,6 +143,18 @@ static DEFINE_SPINLOCK(md_modules_lock);
 #endif	/* CONFIG_MODULES */
 #endif
 
+/* Until log_buf wraps, only dump the part holding records */
+static int md_logbuf_panic_handler(struct notifier_block *this,
+				   unsigned long event, void *ptr)
+{
+	msm_minidump_trim_region("KLOGBUF", log_buf_used_get());
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block md_logbuf_panic_blk = {
+	.notifier_call = md_logbuf_panic_handler,
+};
+
 static void __init register_log_buf(void)
 {
 	char *log_bufp;
@@ -161,8 +173,15 @@ static void __init register_log_buf(void)
 	md_entry.virt_addr = (uintptr_t) log_bufp;
 	md_entry.phys_addr = virt_to_phys(log_bufp);
 	md_entry.size = log_buf_len;
-	if (msm_minidump_add_region(&md_entry) < 0)
+	if (msm_minidump_add_region(&md_entry) < 0) {
 		pr_err("Failed to add logbuf in Minidump\n");
+		return;
+	}
+
+	msm_minidump_set_region_attr("KLOGBUF", MD_PRIO_CRITICAL,
+				     MD_REGION_COMPRESS);
+	atomic_notifier_chain_register(&panic_notifier_list,
+				       &md_logbuf_panic_blk);
 }
 
 static int register_stack_entry(struct md_region *ksp_entry, u64 sp, u64 size)
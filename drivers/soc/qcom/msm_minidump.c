@@ -11,8 +11,13 @@
 #include <linux/err.h>
 #include <linux/elf.h>
 #include <linux/errno.h>
+#include <linux/gfp.h>
+#include <linux/moduleparam.h>
+#include <linux/sizes.h>
 #include <linux/string.h>
 #include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/zlib.h>
 #include <linux/soc/qcom/smem.h>
 #include <soc/qcom/minidump.h>
 #include "minidump_private.h"
@@ -53,11 +58,60 @@ struct md_elfhdr {
 	u64			strtable_idx;
 };
 
+/**
+ * md_region_attr: Panic time handling of a registered region
+ * @prio: enum md_region_prio, used to drop regions over the dump budget
+ * @flags: MD_REGION_* flags
+ * @dump_size: Number of bytes dumped from the start of the region
+ */
+struct md_region_attr {
+	u32			prio;
+	u32			flags;
+	u64			dump_size;
+};
+
+#ifdef CONFIG_QCOM_MINIDUMP_COMPRESS
+/* Not in uapi elf.h yet, see the gABI "Section Compression" */
+#define SHF_COMPRESSED		(1 << 11)
+#define ELFCOMPRESS_ZLIB	1
+
+#ifdef CONFIG_64BIT
+struct md_elf_chdr {
+	u32			ch_type;
+	u32			ch_reserved;
+	u64			ch_size;
+	u64			ch_addralign;
+};
+#else
+struct md_elf_chdr {
+	u32			ch_type;
+	u32			ch_size;
+	u32			ch_addralign;
+};
+#endif
+
+/* Compressed copies of MD_REGION_COMPRESS regions are written here */
+static unsigned int bounce_kb = 2048;
+module_param(bounce_kb, uint, 0444);
+
+static void *md_bounce;
+static struct z_stream_s md_zstream;
+#endif
+
+/*
+ * Upper bound of the dump size in KB, 0 means unlimited. When the
+ * registered regions add up to more, the least important ones are
+ * dropped at panic time.
+ */
+static unsigned int dump_budget_kb;
+module_param(dump_budget_kb, uint, 0644);
+
 /* Protect elfheader and smem table from deferred calls contention */
 static DEFINE_SPINLOCK(mdt_lock);
 static DEFINE_RWLOCK(mdt_remove_lock);
 static struct md_table		minidump_table;
 static struct md_elfhdr		minidump_elfheader;
+static struct md_region_attr	md_attr[MAX_NUM_ENTRIES];
 static int first_removed_entry = INT_MAX;
 static bool md_init_done;
 
@@ -118,19 +172,24 @@ static inline int md_region_num(const char *name, int *seqno)
 	return ret;
 }
 
-static inline int md_entry_num(const struct md_region *entry)
+static inline int md_entry_num_by_name(const char *name)
 {
 	struct md_region *mdr;
 	int i, regno = minidump_table.num_regions;
 
 	for (i = 0; i < regno; i++) {
 		mdr = &minidump_table.entry[i];
-		if (!strcmp(mdr->name, entry->name))
+		if (!strcmp(mdr->name, name))
 			return i;
 	}
 	return -EINVAL;
 }
 
+static inline int md_entry_num(const struct md_region *entry)
+{
+	return md_entry_num_by_name(entry->name);
+}
+
 /* Update Mini dump table in SMEM */
 static void md_update_ss_toc(const struct md_region *entry)
 {
@@ -292,6 +351,10 @@ int msm_minidump_add_region(const struct md_region *entry)
 	mdr->size = entry->size;
 	mdr->id = entry->id;
 
+	md_attr[entries].prio = MD_PRIO_DEFAULT;
+	md_attr[entries].flags = 0;
+	md_attr[entries].dump_size = entry->size;
+
 	minidump_table.num_regions = entries + 1;
 
 	if (toc_init)
@@ -412,7 +475,9 @@ int msm_minidump_remove_region(const struct md_region *entry)
 		&minidump_table.entry[entryno + 1],
 		((ecount - entryno - 1) * sizeof(struct md_region)));
 	memset(&minidump_table.entry[ecount - 1], 0, sizeof(struct md_region));
-
+	memmove(&md_attr[entryno], &md_attr[entryno + 1],
+		((ecount - entryno - 1) * sizeof(struct md_region_attr)));
+	memset(&md_attr[ecount - 1], 0, sizeof(struct md_region_attr));
 
 	memmove(&minidump_table.md_regions[rgno],
 		&minidump_table.md_regions[rgno + 1],
@@ -440,6 +505,250 @@ int msm_minidump_remove_region(const struct md_region *entry)
 }
 EXPORT_SYMBOL(msm_minidump_remove_region);
 
+int msm_minidump_set_region_attr(const char *name, enum md_region_prio prio,
+				 u32 flags)
+{
+	unsigned long flags_irq;
+	int entryno;
+
+	if (!name || prio > MD_PRIO_LOW)
+		return -EINVAL;
+
+	spin_lock_irqsave(&mdt_lock, flags_irq);
+	entryno = md_entry_num_by_name(name);
+	if (entryno >= 0) {
+		md_attr[entryno].prio = prio;
+		md_attr[entryno].flags = flags;
+	}
+	spin_unlock_irqrestore(&mdt_lock, flags_irq);
+
+	return entryno < 0 ? -EINVAL : 0;
+}
+EXPORT_SYMBOL(msm_minidump_set_region_attr);
+
+int msm_minidump_trim_region(const char *name, u64 size)
+{
+	unsigned long flags;
+	int entryno;
+
+	if (!name)
+		return -EINVAL;
+
+	/* Other CPUs may have been stopped with the lock held on panic */
+	if (!spin_trylock_irqsave(&mdt_lock, flags))
+		return -EBUSY;
+
+	entryno = md_entry_num_by_name(name);
+	if (entryno >= 0)
+		md_attr[entryno].dump_size = min_t(u64, ALIGN(size, 4),
+					minidump_table.entry[entryno].size);
+	spin_unlock_irqrestore(&mdt_lock, flags);
+
+	return entryno < 0 ? -EINVAL : 0;
+}
+EXPORT_SYMBOL(msm_minidump_trim_region);
+
+/* Point the smem region and elf headers of entry @i at @base, @size */
+static void md_set_dump(int i, u64 base, u64 size)
+{
+	struct md_ss_region *mdr = &minidump_table.md_regions[i + 1];
+	struct elfhdr *hdr = minidump_elfheader.ehdr;
+	struct elf_shdr *shdr = elf_section(hdr, i + 4);
+	struct elf_phdr *phdr = elf_program(hdr, i + 1);
+
+	mdr->region_base_address = base;
+	mdr->region_size = size;
+	shdr->sh_size = size;
+	phdr->p_filesz = phdr->p_memsz = size;
+}
+
+#ifdef CONFIG_QCOM_MINIDUMP_COMPRESS
+static int md_deflate(const void *src, size_t len, void *dst, size_t room)
+{
+	struct z_stream_s *zs = &md_zstream;
+	int ret;
+
+	if (zlib_deflateInit(zs, Z_BEST_SPEED) != Z_OK)
+		return -EINVAL;
+
+	zs->next_in = src;
+	zs->avail_in = len;
+	zs->next_out = dst;
+	zs->avail_out = room;
+
+	ret = zlib_deflate(zs, Z_FINISH);
+	zlib_deflateEnd(zs);
+
+	return ret == Z_STREAM_END ? zs->total_out : -ENOSPC;
+}
+
+/*
+ * Replace the MD_REGION_COMPRESS regions by zlib streams in the bounce
+ * area, each prefixed by an ELF compression header and marked
+ * SHF_COMPRESSED. The program header keeps the original physical range
+ * and memory size. A region that does not shrink is dumped as is.
+ */
+static void md_compress_regions(int n)
+{
+	struct elfhdr *hdr = minidump_elfheader.ehdr;
+	size_t bounce_size = (size_t)bounce_kb * SZ_1K;
+	struct md_elf_chdr *chdr;
+	size_t used = 0, room, len;
+	u64 size;
+	int i, ret;
+
+	if (!md_bounce)
+		return;
+
+	for (i = 0; i < n; i++) {
+		size = md_attr[i].dump_size;
+		if (!(md_attr[i].flags & MD_REGION_COMPRESS) || size < PAGE_SIZE)
+			continue;
+		if (used + sizeof(*chdr) >= bounce_size)
+			break;
+
+		chdr = md_bounce + used;
+		room = min_t(size_t, bounce_size - used - sizeof(*chdr), size);
+		ret = md_deflate((void *)(uintptr_t)minidump_table.entry[i].virt_addr,
+				 size, chdr + 1, room);
+		if (ret < 0)
+			continue;
+
+		chdr->ch_type = ELFCOMPRESS_ZLIB;
+		chdr->ch_size = size;
+		chdr->ch_addralign = 1;
+		len = ALIGN(sizeof(*chdr) + ret, 4);
+		memset((void *)(chdr + 1) + ret, 0, len - sizeof(*chdr) - ret);
+
+		md_set_dump(i, virt_to_phys(chdr), len);
+		elf_section(hdr, i + 4)->sh_flags |= SHF_COMPRESSED;
+		elf_program(hdr, i + 1)->p_memsz = size;
+		used += len;
+	}
+}
+
+static void __init md_compress_init(void)
+{
+	size_t bounce_size = (size_t)bounce_kb * SZ_1K;
+
+	if (!bounce_size)
+		return;
+
+	md_zstream.workspace = vmalloc(zlib_deflate_workspacesize(MAX_WBITS,
+							DEF_MEM_LEVEL));
+	if (!md_zstream.workspace)
+		return;
+
+	md_bounce = alloc_pages_exact(bounce_size, GFP_KERNEL);
+	if (!md_bounce) {
+		vfree(md_zstream.workspace);
+		md_zstream.workspace = NULL;
+		pr_err("Unable to allocate %u KB compression area\n", bounce_kb);
+	}
+}
+#else
+static inline void md_compress_regions(int n) {}
+static inline void md_compress_init(void) {}
+#endif
+
+/*
+ * Drop the least important regions, largest first within a priority,
+ * until the dump fits dump_budget_kb. MD_PRIO_CRITICAL regions stay.
+ */
+static void md_apply_budget(int n)
+{
+	struct md_ss_region *mdr = minidump_table.md_regions;
+	u64 budget = (u64)dump_budget_kb * SZ_1K, total;
+	int i, victim;
+
+	if (!budget)
+		return;
+
+	total = mdr[0].region_size;
+	for (i = 0; i < n; i++)
+		total += mdr[i + 1].region_size;
+
+	while (total > budget) {
+		victim = -1;
+		for (i = 0; i < n; i++) {
+			if (!mdr[i + 1].region_size ||
+			    md_attr[i].prio == MD_PRIO_CRITICAL)
+				continue;
+			if (victim < 0 || md_attr[i].prio > md_attr[victim].prio ||
+			    (md_attr[i].prio == md_attr[victim].prio &&
+			     mdr[i + 1].region_size > mdr[victim + 1].region_size))
+				victim = i;
+		}
+		if (victim < 0)
+			break;
+
+		total -= mdr[victim + 1].region_size;
+		md_set_dump(victim, minidump_table.entry[victim].phys_addr, 0);
+		mdr[victim + 1].md_valid = MD_REGION_INVALID;
+	}
+}
+
+/* Region data follows the elf header region back to back in the dump */
+static void md_update_offsets(int n)
+{
+	struct elfhdr *hdr = minidump_elfheader.ehdr;
+	u64 offset = minidump_table.md_regions[0].region_size;
+	struct elf_shdr *shdr;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		shdr = elf_section(hdr, i + 4);
+		shdr->sh_offset = offset;
+		elf_program(hdr, i + 1)->p_offset = offset;
+		offset += shdr->sh_size;
+	}
+	minidump_elfheader.elf_offset = offset;
+}
+
+/*
+ * Runs after every other panic notifier, so that their panic time
+ * registrations and msm_minidump_trim_region() calls are accounted.
+ */
+static int md_panic_finalize(struct notifier_block *nb, unsigned long event,
+			     void *unused)
+{
+	struct md_region *entry;
+	unsigned long flags;
+	int i, n;
+
+	if (!smp_load_acquire(&md_init_done) ||
+	    !spin_trylock_irqsave(&mdt_lock, flags))
+		return NOTIFY_DONE;
+
+	if (!write_trylock(&mdt_remove_lock)) {
+		spin_unlock_irqrestore(&mdt_lock, flags);
+		return NOTIFY_DONE;
+	}
+
+	minidump_table.md_ss_toc->md_ss_toc_init = 0;
+	n = minidump_table.num_regions;
+	for (i = 0; i < n; i++) {
+		entry = &minidump_table.entry[i];
+		if (md_attr[i].dump_size != entry->size)
+			md_set_dump(i, entry->phys_addr, md_attr[i].dump_size);
+	}
+
+	md_compress_regions(n);
+	md_apply_budget(n);
+	md_update_offsets(n);
+	minidump_table.md_ss_toc->md_ss_toc_init = 1;
+
+	write_unlock(&mdt_remove_lock);
+	spin_unlock_irqrestore(&mdt_lock, flags);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block md_finalize_blk = {
+	.notifier_call = md_panic_finalize,
+	.priority = INT_MIN,
+};
+
 static int msm_minidump_add_header(void)
 {
 	struct md_ss_region *mdreg = &minidump_table.md_regions[0];
@@ -598,6 +907,9 @@ static int __init msm_minidump_init(void)
 	pendings = 0;
 	spin_unlock_irqrestore(&mdt_lock, flags);
 
+	md_compress_init();
+	atomic_notifier_chain_register(&panic_notifier_list, &md_finalize_blk);
+
 	pr_info("Enabled with max number of regions %d\n",
 		CONFIG_MINIDUMP_MAX_ENTRIES);
 
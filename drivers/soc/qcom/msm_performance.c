@@ -19,10 +19,10 @@
 #include <linux/kthread.h>
 #include <linux/sched/core_ctl.h>
 #include <soc/qcom/msm_performance.h>
+#include <soc/qcom/pmu_lib.h>
 #include <linux/spinlock.h>
 #include <linux/circ_buf.h>
 #include <linux/ktime.h>
-#include <linux/perf_event.h>
 #include <linux/errno.h>
 #include <linux/topology.h>
 #include <linux/scmi_protocol.h>
@@ -36,12 +36,6 @@
 #define INIT "Init"
 #define CPU_CYCLE_THRESHOLD 650000
 
-#ifdef CONFIG_MSM_PERFORMANCE_QGKI
-static DEFINE_PER_CPU(bool, cpu_is_idle);
-static DEFINE_PER_CPU(bool, cpu_is_hp);
-static DEFINE_MUTEX(perfevent_lock);
-#endif
-
 enum event_idx {
 	INST_EVENT,
 	CYC_EVENT,
@@ -89,12 +83,15 @@ static struct queue_indicies curr_pos;
 static DEFINE_SPINLOCK(gfx_circ_buff_lock);
 
 static struct event_data {
-	struct perf_event *pevent;
 	u64 prev_count;
 	u64 cur_delta;
-	u64 cached_total_count;
 } pmu_events[NO_OF_EVENT][NR_CPUS];
 
+static const u32 pmu_event_ids[NO_OF_EVENT] = {
+	[INST_EVENT] = INST_EV,
+	[CYC_EVENT] = CYC_EV,
+};
+
 struct events {
 	spinlock_t cpu_hotplug_lock;
 	bool cpu_hotplug;
@@ -466,72 +463,25 @@ static struct kobject *notify_kobj;
 /*******************************sysfs ends************************************/
 
 /*****************PMU Data Collection*****************/
-static struct perf_event_attr attr;
-static void msm_perf_init_attr(void)
-{
-	memset(&attr, 0, sizeof(struct perf_event_attr));
-
-	attr.type = PERF_TYPE_RAW;
-	attr.size = sizeof(struct perf_event_attr);
-	attr.pinned = 1;
-}
-
-static int set_event(struct event_data *ev, int cpu)
-{
-	struct perf_event *pevent;
-
-	pevent = perf_event_create_kernel_counter(&attr,
-				cpu, NULL, NULL, NULL);
-	if (IS_ERR(pevent)) {
-		pr_err("msm_perf: %s failed, eventId:0x%x, cpu:%d, error code:%ld\n",
-				__func__, attr.config, cpu, PTR_ERR(pevent));
-		return PTR_ERR(pevent);
-	}
-	ev->pevent = pevent;
-	perf_event_enable(pevent);
-
-	return 0;
-}
-
-static void free_pmu_counters(unsigned int cpu)
-{
-	int i = 0;
-
-	for (i = 0; i < NO_OF_EVENT; i++) {
-		pmu_events[i][cpu].prev_count = 0;
-		pmu_events[i][cpu].cur_delta = 0;
-		pmu_events[i][cpu].cached_total_count = 0;
-		if (pmu_events[i][cpu].pevent) {
-			perf_event_disable(pmu_events[i][cpu].pevent);
-			perf_event_release_kernel(pmu_events[i][cpu].pevent);
-			pmu_events[i][cpu].pevent = NULL;
-		}
-	}
-}
-
 static int init_pmu_counter(void)
 {
-	int cpu;
+	int cpu, i;
 	unsigned long cpu_capacity[NR_CPUS] = {0};
 	unsigned long min_cpu_capacity = ULONG_MAX;
 	int ret = 0;
 
-	msm_perf_init_attr();
-
-	/* Create events per CPU */
+	/* Take the shared events per CPU */
 	for_each_possible_cpu(cpu) {
-		/* create Instruction event */
-		attr.config = INST_EV;
-		ret = set_event(&pmu_events[INST_EVENT][cpu], cpu);
-		if (ret < 0) {
-			return ret;
-		}
-		/* create cycle event */
-		attr.config = CYC_EV;
-		ret = set_event(&pmu_events[CYC_EVENT][cpu], cpu);
-		if (ret < 0) {
-			free_pmu_counters(cpu);
-			return ret;
+		for (i = 0; i < NO_OF_EVENT; i++) {
+			ret = qcom_pmu_event_get(cpu, pmu_event_ids[i]);
+			if (ret < 0) {
+				pr_err("msm_perf: eventId:0x%x, cpu:%d, error code:%d\n",
+					pmu_event_ids[i], cpu, ret);
+				while (i--)
+					qcom_pmu_event_put(cpu,
+							   pmu_event_ids[i]);
+				return ret;
+			}
 		}
 		/* find capacity per cpu */
 		cpu_capacity[cpu] = arch_scale_cpu_capacity(cpu);
@@ -548,29 +498,16 @@ static int init_pmu_counter(void)
 	return 0;
 }
 
-static inline void msm_perf_read_event(struct event_data *event)
+static inline void msm_perf_read_event(int cpu, enum event_idx idx)
 {
-	u64 ev_count = 0;
-	u64 total, enabled, running;
+	struct event_data *event = &pmu_events[idx][cpu];
+	u64 total;
 
-	mutex_lock(&perfevent_lock);
-	if (!event->pevent) {
-		mutex_unlock(&perfevent_lock);
+	if (qcom_pmu_read(cpu, pmu_event_ids[idx], &total))
 		return;
-	}
 
-	if (!per_cpu(cpu_is_idle, event->pevent->cpu) &&
-				!per_cpu(cpu_is_hp, event->pevent->cpu)) {
-		total = perf_event_read_value(event->pevent, &enabled, &running);
-		event->cached_total_count = total;
-	} else {
-		total = event->cached_total_count;
-	}
-
-	ev_count = total - event->prev_count;
+	event->cur_delta = total - event->prev_count;
 	event->prev_count = total;
-	event->cur_delta = ev_count;
-	mutex_unlock(&perfevent_lock);
 }
 
 static int get_cpu_total_instruction(char *buf, const struct kernel_param *kp)
@@ -585,9 +522,9 @@ static int get_cpu_total_instruction(char *buf, const struct kernel_param *kp)
 
 	for_each_possible_cpu(cpu) {
 		/* Read Instruction event */
-		msm_perf_read_event(&pmu_events[INST_EVENT][cpu]);
+		msm_perf_read_event(cpu, INST_EVENT);
 		/* Read Cycle event */
-		msm_perf_read_event(&pmu_events[CYC_EVENT][cpu]);
+		msm_perf_read_event(cpu, CYC_EVENT);
 		instruction = pmu_events[INST_EVENT][cpu].cur_delta;
 		cycles = pmu_events[CYC_EVENT][cpu].cur_delta;
 		/* collecting max inst and ipc for max cap and min cap cpus */
@@ -618,52 +555,10 @@ static const struct kernel_param_ops param_ops_cpu_total_instruction = {
 module_param_cb(inst, &param_ops_cpu_total_instruction, NULL, 0444);
 
 
-static int restart_events(unsigned int cpu, bool cpu_up)
-{
-	int ret = 0;
-
-	msm_perf_init_attr();
-
-	if (cpu_up) {
-		/* create Instruction event */
-		attr.config = INST_EV;
-		ret = set_event(&pmu_events[INST_EVENT][cpu], cpu);
-		if (ret < 0) {
-			return ret;
-		}
-		/* create cycle event */
-		attr.config = CYC_EV;
-		ret = set_event(&pmu_events[CYC_EVENT][cpu], cpu);
-		if (ret < 0) {
-			free_pmu_counters(cpu);
-			return ret;
-		}
-	} else {
-		free_pmu_counters(cpu);
-	}
-
-	return 0;
-}
-
-static int hotplug_notify_down(unsigned int cpu)
-{
-	mutex_lock(&perfevent_lock);
-	per_cpu(cpu_is_hp, cpu) = true;
-	restart_events(cpu, false);
-	mutex_unlock(&perfevent_lock);
-
-	return 0;
-}
-
 static int hotplug_notify_up(unsigned int cpu)
 {
 	unsigned long flags;
 
-	mutex_lock(&perfevent_lock);
-	restart_events(cpu, true);
-	per_cpu(cpu_is_hp, cpu) = false;
-	mutex_unlock(&perfevent_lock);
-
 	if (events_group.init_success) {
 		spin_lock_irqsave(&(events_group.cpu_hotplug_lock), flags);
 		events_group.cpu_hotplug = true;
@@ -674,42 +569,6 @@ static int hotplug_notify_up(unsigned int cpu)
 	return 0;
 }
 
-static int msm_perf_idle_read_events(unsigned int cpu)
-{
-	int ret = 0, i;
-
-	for (i = 0; i < NO_OF_EVENT; i++) {
-		if (pmu_events[i][cpu].pevent)
-			ret = perf_event_read_local(pmu_events[i][cpu].pevent,
-					&pmu_events[i][cpu].cached_total_count, NULL, NULL);
-	}
-
-	return ret;
-}
-
-static int msm_perf_idle_notif(struct notifier_block *nb, unsigned long action,
-							void *data)
-{
-	int ret = NOTIFY_OK;
-	int cpu = smp_processor_id();
-
-	switch (action) {
-	case IDLE_START:
-		__this_cpu_write(cpu_is_idle, true);
-		if (!per_cpu(cpu_is_hp, cpu))
-			ret = msm_perf_idle_read_events(cpu);
-		break;
-	case IDLE_END:
-		__this_cpu_write(cpu_is_idle, false);
-		break;
-	}
-	return NOTIFY_OK;
-}
-
-static struct notifier_block msm_perf_event_idle_nb = {
-	.notifier_call = msm_perf_idle_notif,
-};
-
 static int events_notify_userspace(void *data)
 {
 	unsigned long flags;
@@ -1139,7 +998,6 @@ module_param_cb(splh_notif, &param_ops_splh_notification, &splh_notif, 0644);
 static int __init msm_performance_init(void)
 {
 #ifdef CONFIG_MSM_PERFORMANCE_QGKI
-	unsigned int cpu;
 	int ret;
 #endif
 	if (!alloc_cpumask_var(&limit_mask_min, GFP_KERNEL))
@@ -1150,24 +1008,14 @@ static int __init msm_performance_init(void)
 		return -ENOMEM;
 	}
 #ifdef CONFIG_MSM_PERFORMANCE_QGKI
-	get_online_cpus();
-	for_each_possible_cpu(cpu) {
-		if (!cpumask_test_cpu(cpu, cpu_online_mask))
-			per_cpu(cpu_is_hp, cpu) = true;
-	}
-
 	ret = cpuhp_setup_state_nocalls(CPUHP_AP_ONLINE_DYN,
 		"msm_performance_cpu_hotplug",
 		hotplug_notify_up,
-		hotplug_notify_down);
-
-	put_online_cpus();
+		NULL);
 
 	init_events_group();
 	init_notify_group();
 	init_pmu_counter();
-
-	idle_notifier_register(&msm_perf_event_idle_nb);
 #endif
 	return 0;
 }
@@ -118,6 +118,23 @@ static const char * const restart_levels[] = {
 	[RESET_SUBSYS_COUPLED] = "RELATED",
 };
 
+enum ssr_phase {
+	SSR_PHASE_SHUTDOWN,
+	SSR_PHASE_RAMDUMP,
+	SSR_PHASE_POWERUP,
+	SSR_PHASE_NOTIFY,
+	SSR_PHASE_TOTAL,
+	SSR_PHASE_MAX,
+};
+
+static const char * const ssr_phases[] = {
+	[SSR_PHASE_SHUTDOWN] = "shutdown",
+	[SSR_PHASE_RAMDUMP] = "ramdump",
+	[SSR_PHASE_POWERUP] = "powerup",
+	[SSR_PHASE_NOTIFY] = "notify",
+	[SSR_PHASE_TOTAL] = "total",
+};
+
 /**
  * struct subsys_tracking - track state of a subsystem or restart order
  * @p_state: private state of subsystem/order
@@ -177,6 +194,7 @@ struct restart_log {
  * @do_ramdump_on_put: ramdump on subsystem_put() if true
  * @crashed: indicates if subsystem has crashed
  * @notif_state: current state of subsystem in terms of subsys notifications
+ * @restart_us: time spent in each phase of the last completed restart
  */
 struct subsys_device {
 	struct subsys_desc *desc;
@@ -201,6 +219,7 @@ struct subsys_device {
 	enum crash_status crashed;
 	int notif_state;
 	struct list_head list;
+	u32 restart_us[SSR_PHASE_MAX];
 };
 
 static struct subsys_device *to_subsys(struct device *d)
@@ -330,6 +349,20 @@ static ssize_t system_debug_store(struct device *dev,
 	return orig_count;
 }
 static DEVICE_ATTR_RW(system_debug);
+
+static ssize_t restart_time_show(struct device *dev,
+				 struct device_attribute *attr, char *buf)
+{
+	struct subsys_device *subsys = to_subsys(dev);
+	ssize_t len = 0;
+	int i;
+
+	for (i = 0; i < SSR_PHASE_MAX; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s: %u us\n",
+				 ssr_phases[i], subsys->restart_us[i]);
+	return len;
+}
+static DEVICE_ATTR_RO(restart_time);
 #ifdef CONFIG_MACH_ASUS
 /*AS-K ASUS SSR and Debug - devpath+++*/
 static ssize_t devpath_show(struct device *dev, struct device_attribute *attr, char *buf)
@@ -368,6 +401,7 @@ static struct attribute *subsys_attrs[] = {
 	&dev_attr_restart_level.attr,
 	&dev_attr_firmware_name.attr,
 	&dev_attr_system_debug.attr,
+	&dev_attr_restart_time.attr,
 #ifdef CONFIG_MACH_ASUS
 	&dev_attr_devpath.attr,/*AS-K ASUS SSR and Debug - devpath+*/
 #endif
@@ -989,6 +1023,8 @@ static void subsystem_restart_wq_func(struct work_struct *work)
 	struct subsys_tracking *track;
 	unsigned int count;
 	unsigned long flags;
+	u32 us[SSR_PHASE_MAX] = { };
+	ktime_t start, t;
 	int ret;
 #ifdef CONFIG_MACH_ASUS
 	/*AS-K ASUS SSR and Debug+++*/
@@ -1051,14 +1087,21 @@ static void subsystem_restart_wq_func(struct work_struct *work)
 
 	pr_debug("[%s:%d]: Starting restart sequence for %s\n",
 			current->comm, current->pid, desc->name);
+	start = t = ktime_get();
 	notify_each_subsys_device(list, count, SUBSYS_BEFORE_SHUTDOWN, NULL);
+	us[SSR_PHASE_NOTIFY] += ktime_us_delta(ktime_get(), t);
+	t = ktime_get();
 	ret = for_each_subsys_device(list, count, NULL, subsystem_shutdown);
 	if (ret)
 		goto err;
+	us[SSR_PHASE_SHUTDOWN] = ktime_us_delta(ktime_get(), t);
+	t = ktime_get();
 	notify_each_subsys_device(list, count, SUBSYS_AFTER_SHUTDOWN, NULL);
 
 	notify_each_subsys_device(list, count, SUBSYS_RAMDUMP_NOTIFICATION,
 									NULL);
+	us[SSR_PHASE_NOTIFY] += ktime_us_delta(ktime_get(), t);
+	t = ktime_get();
 
 	spin_lock_irqsave(&track->s_lock, flags);
 	track->p_state = SUBSYS_RESTARTING;
@@ -1068,6 +1111,7 @@ static void subsystem_restart_wq_func(struct work_struct *work)
 	for_each_subsys_device(list, count, NULL, subsystem_ramdump);
 
 	for_each_subsys_device(list, count, NULL, subsystem_free_memory);
+	us[SSR_PHASE_RAMDUMP] = ktime_us_delta(ktime_get(), t);
 #ifdef CONFIG_MACH_ASUS
 	/*AS-K ASUS SSR and Debug+++*/
 	/*Subsys Crash Reason*/
@@ -1077,14 +1121,25 @@ static void subsystem_restart_wq_func(struct work_struct *work)
 	/*AS-K ASUS SSR and Debug---*/
 #endif
 
+	t = ktime_get();
 	notify_each_subsys_device(list, count, SUBSYS_BEFORE_POWERUP, NULL);
+	us[SSR_PHASE_NOTIFY] += ktime_us_delta(ktime_get(), t);
+	t = ktime_get();
 	ret = for_each_subsys_device(list, count, NULL, subsystem_powerup);
 	if (ret)
 		goto err;
+	us[SSR_PHASE_POWERUP] = ktime_us_delta(ktime_get(), t);
+	t = ktime_get();
 	notify_each_subsys_device(list, count, SUBSYS_AFTER_POWERUP, NULL);
-
-	pr_info("[%s:%d]: Restart sequence for %s completed.\n",
-			current->comm, current->pid, desc->name);
+	us[SSR_PHASE_NOTIFY] += ktime_us_delta(ktime_get(), t);
+	us[SSR_PHASE_TOTAL] = ktime_us_delta(ktime_get(), start);
+	memcpy(dev->restart_us, us, sizeof(us));
+
+	pr_info("[%s:%d]: Restart sequence for %s completed in %u ms (shutdown %u ramdump %u powerup %u notify %u us)\n",
+			current->comm, current->pid, desc->name,
+			us[SSR_PHASE_TOTAL] / USEC_PER_MSEC,
+			us[SSR_PHASE_SHUTDOWN], us[SSR_PHASE_RAMDUMP],
+			us[SSR_PHASE_POWERUP], us[SSR_PHASE_NOTIFY]);
 
 err:
 	/* Reset subsys count */
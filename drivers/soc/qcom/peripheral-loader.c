@@ -32,6 +32,8 @@
 #include <linux/kthread.h>
 
 #include <linux/uaccess.h>
+#include <linux/xz.h>
+#include <linux/vmalloc.h>
 #include <asm/setup.h>
 #define CREATE_TRACE_POINTS
 #include <trace/events/trace_msm_pil_event.h>
@@ -959,6 +961,158 @@ static void unmap_fw_mem(void __iomem *vaddr, size_t size, void *data)
 	iounmap(vaddr);
 }
 
+#if IS_ENABLED(CONFIG_MSM_PIL_COMPRESSED_FW)
+/*
+ * Load an xz compressed blob, <fw_name>.xz, decompressing it straight into
+ * the segment so the uncompressed image never needs a staging buffer.
+ *
+ * Returns -ENOENT if there is no compressed blob for the segment.
+ */
+static int pil_load_seg_xz(struct pil_desc *desc, const char *fw_name,
+			   void __iomem *firmware_buf, size_t filesz)
+{
+	char xz_name[40];
+	const struct firmware *fw;
+	struct xz_dec *xz;
+	struct xz_buf b;
+	enum xz_ret xz_ret;
+	int ret;
+
+	snprintf(xz_name, ARRAY_SIZE(xz_name), "%s.xz", fw_name);
+	/* No fallback: a missing compressed blob must fail fast */
+	ret = request_firmware_direct(&fw, xz_name, desc->dev);
+	if (ret)
+		return -ENOENT;
+
+	xz = xz_dec_init(XZ_SINGLE, 0);
+	if (!xz) {
+		release_firmware(fw);
+		return -ENOMEM;
+	}
+
+	b.in = fw->data;
+	b.in_pos = 0;
+	b.in_size = fw->size;
+	b.out = (u8 __force *)firmware_buf;
+	b.out_pos = 0;
+	b.out_size = filesz;
+
+	xz_ret = xz_dec_run(xz, &b);
+	xz_dec_end(xz);
+	release_firmware(fw);
+
+	if (xz_ret != XZ_STREAM_END) {
+		pil_err(desc, "Failed to decompress blob %s(rc:%d)\n",
+			xz_name, xz_ret);
+		return -EINVAL;
+	}
+
+	if (b.out_pos != filesz) {
+		pil_err(desc, "Blob size %zu doesn't match %zu\n",
+			b.out_pos, filesz);
+		return -EPERM;
+	}
+
+	return 0;
+}
+#else
+static int pil_load_seg_xz(struct pil_desc *desc, const char *fw_name,
+			   void __iomem *firmware_buf, size_t filesz)
+{
+	return -ENOENT;
+}
+#endif
+
+/*
+ * With qcom,pil-fw-cache set, the mdt and the segment blobs read from
+ * storage are kept in memory once the image boots, and the next boot of
+ * the same image (a subsystem restart) copies them from there. Only the
+ * filesystem reads and the decompression are skipped; init_image() and
+ * auth_and_reset() still have TZ authenticate the image every time.
+ */
+static void pil_fw_cache_drop(struct pil_priv *priv)
+{
+	int i;
+
+	for (i = 0; priv->cache_segs && i < priv->cache_nsegs; i++)
+		vfree(priv->cache_segs[i]);
+	kfree(priv->cache_segs);
+	vfree(priv->cache_mdt);
+	priv->cache_segs = NULL;
+	priv->cache_mdt = NULL;
+	priv->cache_nsegs = 0;
+	priv->cache_valid = false;
+}
+
+static bool pil_fw_cache_hit(struct pil_desc *desc)
+{
+	struct pil_priv *priv = desc->priv;
+
+	return desc->fw_cache && priv->cache_valid &&
+		!strcmp(priv->cache_name, desc->fw_name);
+}
+
+/* Start filling the cache from the mdt of a boot from storage */
+static void pil_fw_cache_begin(struct pil_desc *desc,
+			       const struct firmware *fw)
+{
+	struct pil_priv *priv = desc->priv;
+	const struct pil_mdt *mdt = (const struct pil_mdt *)fw->data;
+
+	pil_fw_cache_drop(priv);
+	if (!desc->fw_cache)
+		return;
+
+	priv->cache_mdt = vmalloc(fw->size);
+	priv->cache_segs = kcalloc(mdt->hdr.e_phnum, sizeof(void *),
+				   GFP_KERNEL);
+	if (!priv->cache_mdt || !priv->cache_segs) {
+		/* Not fatal, this boot just won't be cached */
+		pil_fw_cache_drop(priv);
+		return;
+	}
+
+	memcpy(priv->cache_mdt, fw->data, fw->size);
+	priv->cache_mdt_size = fw->size;
+	priv->cache_nsegs = mdt->hdr.e_phnum;
+	strlcpy(priv->cache_name, desc->fw_name, sizeof(priv->cache_name));
+}
+
+static void pil_fw_cache_save(struct pil_desc *desc, struct pil_seg *seg,
+			      const void __iomem *buf)
+{
+	struct pil_priv *priv = desc->priv;
+	void *copy;
+
+	if (!priv->cache_segs || seg->num >= priv->cache_nsegs)
+		return;
+
+	copy = vmalloc(seg->filesz);
+	if (!copy)
+		return;
+	memcpy_fromio(copy, buf, seg->filesz);
+	priv->cache_segs[seg->num] = copy;
+}
+
+/* Mark the cache usable once every blob of a successful boot is in it */
+static void pil_fw_cache_commit(struct pil_desc *desc)
+{
+	struct pil_priv *priv = desc->priv;
+	struct pil_seg *seg;
+
+	if (!priv->cache_segs)
+		return;
+
+	list_for_each_entry(seg, &priv->segs, list) {
+		if (seg->filesz && (seg->num >= priv->cache_nsegs ||
+				    !priv->cache_segs[seg->num])) {
+			pil_fw_cache_drop(priv);
+			return;
+		}
+	}
+	priv->cache_valid = true;
+}
+
 static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 {
 	int ret = 0, count;
@@ -984,8 +1138,28 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 			return -ENOMEM;
 		}
 
+		if (desc->priv->cache_in_use) {
+			memcpy_toio(firmware_buf, desc->priv->cache_segs[num],
+				    seg->filesz);
+			desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
+			goto zero_trailing;
+		}
+
+		ret = pil_load_seg_xz(desc, fw_name, firmware_buf,
+				      seg->filesz);
+		if (ret != -ENOENT) {
+			if (!ret)
+				pil_fw_cache_save(desc, seg, firmware_buf);
+			desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
+			if (ret)
+				return ret;
+			goto zero_trailing;
+		}
+
 		ret = request_firmware_into_buf(&fw, fw_name, desc->dev,
 						firmware_buf, seg->filesz);
+		if (!ret && fw->size == seg->filesz)
+			pil_fw_cache_save(desc, seg, firmware_buf);
 		desc->unmap_fw_mem(firmware_buf, seg->filesz, map_data);
 
 		if (ret) {
@@ -1004,6 +1178,7 @@ static int pil_load_seg(struct pil_desc *desc, struct pil_seg *seg)
 		release_firmware(fw);
 	}
 
+zero_trailing:
 	/* Zero out trailing memory */
 	paddr = seg->paddr + seg->filesz;
 	count = seg->sz - seg->filesz;
@@ -1184,9 +1359,13 @@ int pil_boot(struct pil_desc *desc)
 	const struct pil_mdt *mdt;
 	const struct elf32_hdr *ehdr;
 	const struct firmware *fw;
+	struct firmware cached_mdt = { };
 	struct pil_priv *priv = desc->priv;
 	bool mem_protect = false;
 	bool hyp_assign = false;
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	u64 boot_ev = boot_event_start();
+#endif
 
 	ret = pil_notify_aop(desc, "on");
 	if (ret < 0) {
@@ -1203,10 +1382,18 @@ int pil_boot(struct pil_desc *desc)
 
 	down_read(&pil_pm_rwsem);
 	snprintf(fw_name, sizeof(fw_name), "%s.mdt", desc->fw_name);
-	ret = request_firmware(&fw, fw_name, desc->dev);
-	if (ret) {
-		pil_err(desc, "Failed to locate %s(rc:%d)\n", fw_name, ret);
-		goto out;
+	priv->cache_in_use = pil_fw_cache_hit(desc);
+	if (priv->cache_in_use) {
+		cached_mdt.data = priv->cache_mdt;
+		cached_mdt.size = priv->cache_mdt_size;
+		fw = &cached_mdt;
+	} else {
+		ret = request_firmware(&fw, fw_name, desc->dev);
+		if (ret) {
+			pil_err(desc, "Failed to locate %s(rc:%d)\n",
+				fw_name, ret);
+			goto out;
+		}
 	}
 
 	if (fw->size < sizeof(*ehdr)) {
@@ -1236,6 +1423,9 @@ int pil_boot(struct pil_desc *desc)
 		goto release_fw;
 	}
 
+	if (!priv->cache_in_use)
+		pil_fw_cache_begin(desc, fw);
+
 	ret = pil_init_mmap(desc, mdt);
 	if (ret)
 		goto release_fw;
@@ -1337,9 +1527,13 @@ int pil_boot(struct pil_desc *desc)
 #ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
 	if (!strcmp(desc->name, "modem"))
 		place_marker("M - Modem out of reset");
+	boot_event_record(BOOT_EVENT_FIRMWARE, desc->name, boot_ev);
 #endif
 
-	pil_info(desc, "Brought out of reset\n");
+	pil_info(desc, "Brought out of reset%s\n",
+		 priv->cache_in_use ? " (cached firmware)" : "");
+	if (!priv->cache_in_use)
+		pil_fw_cache_commit(desc);
 	desc->modem_ssr = false;
 err_auth_and_reset:
 	if (ret && desc->subsys_vmid > 0) {
@@ -1355,10 +1549,13 @@ int pil_boot(struct pil_desc *desc)
 		disable_irq(desc->proxy_unvote_irq);
 	pil_proxy_unvote(desc, ret);
 release_fw:
-	release_firmware(fw);
+	if (fw != &cached_mdt)
+		release_firmware(fw);
 out:
 	up_read(&pil_pm_rwsem);
 	if (ret) {
+		/* Next boot goes back to storage */
+		pil_fw_cache_drop(priv);
 		if (priv->is_region_allocated) {
 			if (desc->subsys_vmid > 0 && !mem_protect &&
 					hyp_assign) {
@@ -1587,6 +1784,7 @@ int pil_desc_init(struct pil_desc *desc)
 
 	desc->minidump_as_elf32 = of_property_read_bool(
 					ofnode, "qcom,minidump-as-elf32");
+	desc->fw_cache = of_property_read_bool(ofnode, "qcom,pil-fw-cache");
 
 	return 0;
 err_parse_dt:
@@ -1611,6 +1809,7 @@ void pil_desc_release(struct pil_desc *desc)
 		ida_simple_remove(&pil_ida, priv->id);
 		flush_delayed_work(&priv->proxy);
 		wakeup_source_unregister(priv->ws);
+		pil_fw_cache_drop(priv);
 	}
 	desc->priv = NULL;
 	kfree(priv);
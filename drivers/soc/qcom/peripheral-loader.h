@@ -29,6 +29,13 @@ struct module;
  * non-relocatable images
  * @region: region allocated for relocatable images
  * @unvoted_flag: flag to keep track if we have unvoted or not.
+ * @cache_name: fw_name the firmware cache was filled for
+ * @cache_mdt: cached copy of the mdt
+ * @cache_mdt_size: size of @cache_mdt
+ * @cache_segs: cached copy of each segment blob, indexed by segment number
+ * @cache_nsegs: number of entries in @cache_segs
+ * @cache_valid: the cache holds a complete image that booted successfully
+ * @cache_in_use: the current boot loads from the cache instead of storage
  *
  * This struct contains data for a pil_desc that should not be exposed outside
  * of this file. This structure points to the descriptor and the descriptor
@@ -51,6 +58,13 @@ struct pil_priv {
 	int id;
 	int unvoted_flag;
 	size_t region_size;
+	char cache_name[30];
+	void *cache_mdt;
+	size_t cache_mdt_size;
+	void **cache_segs;
+	int cache_nsegs;
+	bool cache_valid;
+	bool cache_in_use;
 };
 
 /**
@@ -74,6 +88,8 @@ struct pil_priv {
  * @modem_ssr: true if modem is restarting, false if booting for first time.
  * @clear_fw_region: Clear fw region on failure in loading.
  * @subsys_vmid: memprot id for the subsystem.
+ * @fw_cache: keep the firmware read from storage in memory so that a
+ * restart of the subsystem reloads it from there.
  */
 struct pil_desc {
 	const char *name;
@@ -105,6 +121,7 @@ struct pil_desc {
 	int num_aux_minidump_ids;
 	u32 extra_size;
 	bool minidump_as_elf32;
+	bool fw_cache;
 };
 
 /**
@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#define pr_fmt(fmt) "qcom-pmu: " fmt
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/cpu.h>
+#include <linux/cpuhotplug.h>
+#include <linux/err.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/perf_event.h>
+#include <linux/spinlock.h>
+#include <soc/qcom/pmu_lib.h>
+
+/*
+ * Reads of the same counter closer together than this are served from the
+ * last value, so every client sampling on the same tick shares one read.
+ */
+#define QCOM_PMU_READ_NS	(NSEC_PER_MSEC / 2)
+
+/**
+ * struct qcom_pmu_ev - raw event shared by all clients of a CPU
+ * @event_id:		Raw event code. 0 when the slot is free.
+ * @refcnt:		Number of clients using the event.
+ * @pevent:		The perf event. NULL while the CPU is offline.
+ * @base:		Count accumulated by perf events released on hotplug,
+ *			so @total keeps increasing across hotplug.
+ * @total:		Last count read, including @base.
+ * @read_ns:		When @total was last read from the counter.
+ */
+struct qcom_pmu_ev {
+	u32			event_id;
+	unsigned int		refcnt;
+	struct perf_event	*pevent;
+	u64			base;
+	u64			total;
+	u64			read_ns;
+};
+
+/**
+ * struct qcom_pmu_cpu - shared events of a CPU
+ * @evs:		Event slots.
+ * @nr_evs:		Number of slots in use.
+ * @lock:		Protects @pevent and @total against the idle path.
+ * @is_idle:		The CPU is in idle and its counters are cached.
+ * @is_hp:		The CPU is offline and has no perf events.
+ */
+struct qcom_pmu_cpu {
+	struct qcom_pmu_ev	evs[QCOM_PMU_MAX_EVS];
+	unsigned int		nr_evs;
+	spinlock_t		lock;
+	bool			is_idle;
+	bool			is_hp;
+};
+
+static DEFINE_PER_CPU(struct qcom_pmu_cpu, pmu_cpus);
+/* Serializes event creation, release, hotplug and remote reads */
+static DEFINE_MUTEX(pmu_lock);
+static enum cpuhp_state pmu_hp_state;
+
+static struct qcom_pmu_ev *find_ev(struct qcom_pmu_cpu *pc, u32 event_id)
+{
+	int i;
+
+	for (i = 0; i < QCOM_PMU_MAX_EVS; i++)
+		if (pc->evs[i].event_id == event_id)
+			return &pc->evs[i];
+
+	return NULL;
+}
+
+static int create_ev(struct qcom_pmu_cpu *pc, struct qcom_pmu_ev *ev, int cpu)
+{
+	struct perf_event_attr attr = {
+		.type = PERF_TYPE_RAW,
+		.size = sizeof(attr),
+		.pinned = 1,
+		.config = ev->event_id,
+	};
+	struct perf_event *pevent;
+	unsigned long flags;
+
+	pevent = perf_event_create_kernel_counter(&attr, cpu, NULL, NULL, NULL);
+	if (IS_ERR(pevent)) {
+		pr_err("event 0x%x not set for cpu %d: %ld\n", ev->event_id,
+		       cpu, PTR_ERR(pevent));
+		return PTR_ERR(pevent);
+	}
+	perf_event_enable(pevent);
+
+	spin_lock_irqsave(&pc->lock, flags);
+	ev->pevent = pevent;
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	return 0;
+}
+
+static void release_ev(struct qcom_pmu_cpu *pc, struct qcom_pmu_ev *ev)
+{
+	struct perf_event *pevent = ev->pevent;
+	u64 count, enabled, running;
+	unsigned long flags;
+
+	if (!pevent)
+		return;
+
+	count = perf_event_read_value(pevent, &enabled, &running);
+
+	spin_lock_irqsave(&pc->lock, flags);
+	ev->pevent = NULL;
+	ev->base += count;
+	ev->total = ev->base;
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+	perf_event_release_kernel(pevent);
+}
+
+/**
+ * qcom_pmu_event_get() - start sharing a raw event on a CPU
+ * @cpu:	CPU to count on.
+ * @event_id:	Raw PMU event code.
+ *
+ * The counter is created by the first client and shared by later ones.
+ * Every successful call must be paired with qcom_pmu_event_put().
+ */
+int qcom_pmu_event_get(int cpu, u32 event_id)
+{
+	struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+	struct qcom_pmu_ev *ev;
+	int ret = 0;
+
+	if (!event_id)
+		return -EINVAL;
+
+	mutex_lock(&pmu_lock);
+	ev = find_ev(pc, event_id);
+	if (ev) {
+		ev->refcnt++;
+		goto unlock;
+	}
+
+	ev = find_ev(pc, 0);
+	if (!ev) {
+		ret = -ENOSPC;
+		goto unlock;
+	}
+
+	ev->event_id = event_id;
+	ev->base = 0;
+	ev->total = 0;
+	ev->read_ns = 0;
+	if (!pc->is_hp) {
+		ret = create_ev(pc, ev, cpu);
+		if (ret < 0) {
+			ev->event_id = 0;
+			goto unlock;
+		}
+	}
+	ev->refcnt = 1;
+	pc->nr_evs++;
+
+unlock:
+	mutex_unlock(&pmu_lock);
+	return ret;
+}
+EXPORT_SYMBOL(qcom_pmu_event_get);
+
+void qcom_pmu_event_put(int cpu, u32 event_id)
+{
+	struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+	struct qcom_pmu_ev *ev;
+
+	if (!event_id)
+		return;
+
+	mutex_lock(&pmu_lock);
+	ev = find_ev(pc, event_id);
+	if (ev && !--ev->refcnt) {
+		release_ev(pc, ev);
+		ev->event_id = 0;
+		pc->nr_evs--;
+	}
+	mutex_unlock(&pmu_lock);
+}
+EXPORT_SYMBOL(qcom_pmu_event_put);
+
+/**
+ * qcom_pmu_read() - read the running count of a shared event
+ * @cpu:	CPU the event counts on.
+ * @event_id:	Raw PMU event code previously taken with qcom_pmu_event_get().
+ * @count:	Returns the count since the event was first taken.
+ *
+ * Idle and offline CPUs are not woken up: the count cached when they went
+ * down is returned instead.
+ */
+int qcom_pmu_read(int cpu, u32 event_id, u64 *count)
+{
+	struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+	struct qcom_pmu_ev *ev;
+	u64 total, enabled, running, now;
+	unsigned long flags;
+	int ret = 0;
+
+	if (!event_id)
+		return -EINVAL;
+
+	mutex_lock(&pmu_lock);
+	ev = find_ev(pc, event_id);
+	if (!ev) {
+		ret = -ENOENT;
+		goto unlock;
+	}
+
+	now = ktime_get_ns();
+	if (ev->pevent && !pc->is_idle && !pc->is_hp &&
+	    now - ev->read_ns >= QCOM_PMU_READ_NS) {
+		total = perf_event_read_value(ev->pevent, &enabled, &running);
+		spin_lock_irqsave(&pc->lock, flags);
+		ev->total = ev->base + total;
+		ev->read_ns = now;
+		spin_unlock_irqrestore(&pc->lock, flags);
+	}
+
+	spin_lock_irqsave(&pc->lock, flags);
+	*count = ev->total;
+	spin_unlock_irqrestore(&pc->lock, flags);
+
+unlock:
+	mutex_unlock(&pmu_lock);
+	return ret;
+}
+EXPORT_SYMBOL(qcom_pmu_read);
+
+static int qcom_pmu_idle_notif(struct notifier_block *nb,
+			       unsigned long action, void *data)
+{
+	struct qcom_pmu_cpu *pc = this_cpu_ptr(&pmu_cpus);
+	struct qcom_pmu_ev *ev;
+	u64 count;
+	int i;
+
+	switch (action) {
+	case IDLE_START:
+		pc->is_idle = true;
+		if (!pc->nr_evs || pc->is_hp)
+			break;
+
+		spin_lock(&pc->lock);
+		for (i = 0; i < QCOM_PMU_MAX_EVS; i++) {
+			ev = &pc->evs[i];
+			if (!ev->pevent)
+				continue;
+			if (!perf_event_read_local(ev->pevent, &count,
+						   NULL, NULL))
+				ev->total = ev->base + count;
+		}
+		spin_unlock(&pc->lock);
+		break;
+	case IDLE_END:
+		pc->is_idle = false;
+		break;
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block qcom_pmu_idle_nb = {
+	.notifier_call = qcom_pmu_idle_notif,
+};
+
+static int qcom_pmu_hotplug_coming_up(unsigned int cpu)
+{
+	struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+	int i;
+
+	mutex_lock(&pmu_lock);
+	for (i = 0; i < QCOM_PMU_MAX_EVS; i++)
+		if (pc->evs[i].refcnt)
+			create_ev(pc, &pc->evs[i], cpu);
+	pc->is_hp = false;
+	mutex_unlock(&pmu_lock);
+
+	return 0;
+}
+
+static int qcom_pmu_hotplug_going_down(unsigned int cpu)
+{
+	struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+	int i;
+
+	mutex_lock(&pmu_lock);
+	pc->is_hp = true;
+	for (i = 0; i < QCOM_PMU_MAX_EVS; i++)
+		release_ev(pc, &pc->evs[i]);
+	mutex_unlock(&pmu_lock);
+
+	return 0;
+}
+
+static int __init qcom_pmu_lib_init(void)
+{
+	unsigned int cpu;
+	int ret;
+
+	get_online_cpus();
+	for_each_possible_cpu(cpu) {
+		struct qcom_pmu_cpu *pc = &per_cpu(pmu_cpus, cpu);
+
+		spin_lock_init(&pc->lock);
+		pc->is_hp = !cpu_online(cpu);
+	}
+
+	ret = cpuhp_setup_state_nocalls_cpuslocked(CPUHP_AP_ONLINE_DYN,
+					"qcom_pmu_lib",
+					qcom_pmu_hotplug_coming_up,
+					qcom_pmu_hotplug_going_down);
+	put_online_cpus();
+	if (ret < 0) {
+		pr_err("failed to register CPU hotplug notifier: %d\n", ret);
+		return ret;
+	}
+	pmu_hp_state = ret;
+
+	idle_notifier_register(&qcom_pmu_idle_nb);
+
+	return 0;
+}
+subsys_initcall(qcom_pmu_lib_init);
+
+static void __exit qcom_pmu_lib_exit(void)
+{
+	idle_notifier_unregister(&qcom_pmu_idle_nb);
+	cpuhp_remove_state_nocalls(pmu_hp_state);
+}
+module_exit(qcom_pmu_lib_exit);
+
+MODULE_DESCRIPTION("Qualcomm Technologies, Inc. shared CPU PMU counters");
+MODULE_LICENSE("GPL v2");
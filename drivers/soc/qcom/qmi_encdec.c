@@ -9,6 +9,12 @@
 #include <linux/kernel.h>
 #include <linux/errno.h>
 #include <linux/string.h>
+#include <linux/debugfs.h>
+#include <linux/hashtable.h>
+#include <linux/math64.h>
+#include <linux/rculist.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
 #include <linux/soc/qcom/qmi.h>
 
 #define QMI_ENCDEC_ENCODE_TLV(type, length, p_dst) do { \
@@ -57,11 +63,69 @@ do { \
 #define TLV_TYPE_SIZE sizeof(u8)
 #define OPTIONAL_TLV_TYPE_START 0x10
 
+#define QMI_PLAN_HASH_BITS	7
+#define QMI_PLAN_MAX_OPS	32
+#define QMI_PLAN_MAX_DEPTH	4
+
+/**
+ * struct qmi_ei_op - Contiguous run of a fixed-size structure
+ * @offset: Offset of the run in the C structure.
+ * @size: Size of the run, identical in the C structure and on the wire.
+ */
+struct qmi_ei_op {
+	u32 offset;
+	u32 size;
+};
+
+/**
+ * struct qmi_ei_plan - Compiled form of a struct info array
+ * @node: Link in qmi_plan_table, hashed on @ei.
+ * @rcu: Used to free the plan when the module owning @ei goes away.
+ * @ei: Struct info array the plan was compiled from.
+ * @tlv_first: One plus the index of the first element carrying each TLV
+ *             type, or 0 if the type is not in @ei.
+ * @indexed: @tlv_first is valid, i.e. @ei has fewer than U8_MAX elements.
+ * @flat: @ei describes a fixed-size structure made only of basic elements,
+ *        static arrays and such structures, so it can be encoded and
+ *        decoded by copying @ops.
+ * @wire_size: Encoded size of a @flat structure.
+ * @enc_count: Number of top level messages encoded with @ei.
+ * @enc_ns: Time spent encoding them.
+ * @dec_count: Number of top level messages decoded with @ei.
+ * @dec_ns: Time spent decoding them.
+ * @nr_ops: Number of entries in @ops.
+ * @ops: Copy list of a @flat structure, adjacent fields merged.
+ *
+ * Plans are built the first time an array is used and then looked up by
+ * address, so that decoding does not need to walk the array again to
+ * find the element for each TLV, and fixed-size nested structures are
+ * moved with a few memcpy() calls instead of recursing per field.
+ */
+struct qmi_ei_plan {
+	struct hlist_node node;
+	struct rcu_head rcu;
+	struct qmi_elem_info *ei;
+	u8 tlv_first[U8_MAX + 1];
+	bool indexed;
+	bool flat;
+	u32 wire_size;
+	atomic64_t enc_count;
+	atomic64_t enc_ns;
+	atomic64_t dec_count;
+	atomic64_t dec_ns;
+	unsigned int nr_ops;
+	struct qmi_ei_op ops[];
+};
+
+static DEFINE_HASHTABLE(qmi_plan_table, QMI_PLAN_HASH_BITS);
+static DEFINE_SPINLOCK(qmi_plan_lock);
+
 static int qmi_encode(struct qmi_elem_info *ei_array, void *out_buf,
 		      const void *in_c_struct, u32 out_buf_len,
 		      int enc_level);
 
-static int qmi_decode(struct qmi_elem_info *ei_array, void *out_c_struct,
+static int qmi_decode(struct qmi_elem_info *ei_array,
+		      const struct qmi_ei_plan *plan, void *out_c_struct,
 		      const void *in_buf, u32 in_buf_len, int dec_level);
 
 /**
@@ -148,6 +212,193 @@ static int qmi_calc_min_msg_len(struct qmi_elem_info *ei_array,
 	return min_msg_len;
 }
 
+static int qmi_ei_add_op(struct qmi_ei_op *ops, unsigned int *nr_ops,
+			 u32 offset, u32 size)
+{
+	struct qmi_ei_op *last = *nr_ops ? &ops[*nr_ops - 1] : NULL;
+
+	if (!size)
+		return 0;
+
+	if (last && last->offset + last->size == offset) {
+		last->size += size;
+		return 0;
+	}
+
+	if (*nr_ops >= QMI_PLAN_MAX_OPS)
+		return -E2BIG;
+
+	ops[*nr_ops].offset = offset;
+	ops[*nr_ops].size = size;
+	(*nr_ops)++;
+
+	return 0;
+}
+
+/**
+ * qmi_ei_flatten() - Build the copy list of a fixed-size structure
+ * @ei_array: Struct info array describing the structure.
+ * @base: Offset of the structure within the outermost one.
+ * @ops: Copy list being built.
+ * @nr_ops: Number of entries in @ops.
+ * @wire_size: Accumulated encoded size.
+ * @depth: Nesting depth, to bound the recursion.
+ *
+ * Return: 0 if the structure is fixed-size, negative errno otherwise.
+ */
+static int qmi_ei_flatten(struct qmi_elem_info *ei_array, u32 base,
+			  struct qmi_ei_op *ops, unsigned int *nr_ops,
+			  u32 *wire_size, int depth)
+{
+	struct qmi_elem_info *temp_ei;
+	u32 i, count, size;
+	int ret;
+
+	if (!ei_array || depth > QMI_PLAN_MAX_DEPTH)
+		return -EINVAL;
+
+	for (temp_ei = ei_array; temp_ei->data_type != QMI_EOTI; temp_ei++) {
+		if (temp_ei->array_type == NO_ARRAY)
+			count = 1;
+		else if (temp_ei->array_type == STATIC_ARRAY)
+			count = temp_ei->elem_len;
+		else
+			return -EINVAL;
+
+		switch (temp_ei->data_type) {
+		case QMI_UNSIGNED_1_BYTE:
+		case QMI_UNSIGNED_2_BYTE:
+		case QMI_UNSIGNED_4_BYTE:
+		case QMI_UNSIGNED_8_BYTE:
+		case QMI_SIGNED_2_BYTE_ENUM:
+		case QMI_SIGNED_4_BYTE_ENUM:
+			size = count * temp_ei->elem_size;
+			ret = qmi_ei_add_op(ops, nr_ops,
+					    base + temp_ei->offset, size);
+			if (ret)
+				return ret;
+			*wire_size += size;
+			break;
+
+		case QMI_STRUCT:
+			for (i = 0; i < count; i++) {
+				ret = qmi_ei_flatten(temp_ei->ei_array,
+						     base + temp_ei->offset +
+						     i * temp_ei->elem_size,
+						     ops, nr_ops, wire_size,
+						     depth + 1);
+				if (ret)
+					return ret;
+			}
+			break;
+
+		default:
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static struct qmi_ei_plan *qmi_ei_plan_build(struct qmi_elem_info *ei_array)
+{
+	struct qmi_ei_op ops[QMI_PLAN_MAX_OPS];
+	struct qmi_elem_info *temp_ei;
+	struct qmi_ei_plan *plan, *tmp;
+	unsigned int nr_ops = 0;
+	u32 wire_size = 0;
+	unsigned long flags;
+	bool flat;
+	int i;
+
+	flat = !qmi_ei_flatten(ei_array, 0, ops, &nr_ops, &wire_size, 0);
+	if (!flat)
+		nr_ops = 0;
+
+	plan = kzalloc(struct_size(plan, ops, nr_ops), GFP_ATOMIC);
+	if (!plan)
+		return NULL;
+
+	plan->ei = ei_array;
+	plan->flat = flat;
+	plan->wire_size = wire_size;
+	plan->nr_ops = nr_ops;
+	memcpy(plan->ops, ops, nr_ops * sizeof(*ops));
+
+	plan->indexed = true;
+	for (i = 0, temp_ei = ei_array; temp_ei->data_type != QMI_EOTI;
+	     i++, temp_ei++) {
+		if (i >= U8_MAX) {
+			plan->indexed = false;
+			break;
+		}
+		if (!plan->tlv_first[temp_ei->tlv_type])
+			plan->tlv_first[temp_ei->tlv_type] = i + 1;
+	}
+
+	spin_lock_irqsave(&qmi_plan_lock, flags);
+	hash_for_each_possible(qmi_plan_table, tmp, node,
+			       (unsigned long)ei_array) {
+		if (tmp->ei == ei_array) {
+			spin_unlock_irqrestore(&qmi_plan_lock, flags);
+			kfree(plan);
+			return tmp;
+		}
+	}
+	hash_add_rcu(qmi_plan_table, &plan->node, (unsigned long)ei_array);
+	spin_unlock_irqrestore(&qmi_plan_lock, flags);
+
+	return plan;
+}
+
+/**
+ * qmi_ei_plan_get() - Look up, or build, the plan of a struct info array
+ * @ei_array: Struct info array to get the plan for.
+ *
+ * Must be called under rcu_read_lock(), which also covers the use of the
+ * returned plan.
+ *
+ * Return: The plan, or NULL if it could not be allocated.
+ */
+static struct qmi_ei_plan *qmi_ei_plan_get(struct qmi_elem_info *ei_array)
+{
+	struct qmi_ei_plan *plan;
+
+	if (!ei_array)
+		return NULL;
+
+	hash_for_each_possible_rcu(qmi_plan_table, plan, node,
+				   (unsigned long)ei_array)
+		if (plan->ei == ei_array)
+			return plan;
+
+	return qmi_ei_plan_build(ei_array);
+}
+
+static void qmi_ei_plan_encode(const struct qmi_ei_plan *plan, void *buf_dst,
+			       const void *buf_src)
+{
+	unsigned int i;
+
+	for (i = 0; i < plan->nr_ops; i++) {
+		memcpy(buf_dst, buf_src + plan->ops[i].offset,
+		       plan->ops[i].size);
+		buf_dst += plan->ops[i].size;
+	}
+}
+
+static void qmi_ei_plan_decode(const struct qmi_ei_plan *plan, void *buf_dst,
+			       const void *buf_src)
+{
+	unsigned int i;
+
+	for (i = 0; i < plan->nr_ops; i++) {
+		memcpy(buf_dst + plan->ops[i].offset, buf_src,
+		       plan->ops[i].size);
+		buf_src += plan->ops[i].size;
+	}
+}
+
 /**
  * qmi_encode_basic_elem() - Encodes elements of basic/primary data type
  * @buf_dst: Buffer to store the encoded information.
@@ -201,8 +452,23 @@ static int qmi_encode_struct_elem(struct qmi_elem_info *ei_array,
 {
 	int i, rc, encoded_bytes = 0;
 	struct qmi_elem_info *temp_ei = ei_array;
+	const struct qmi_ei_plan *plan = qmi_ei_plan_get(temp_ei->ei_array);
 
 	for (i = 0; i < elem_len; i++) {
+		if (plan && plan->flat) {
+			if (plan->wire_size + TLV_LEN_SIZE + TLV_TYPE_SIZE >
+			    out_buf_len - encoded_bytes) {
+				pr_err("%s: Too Small Buffer @STRUCT\n",
+				       __func__);
+				return -ETOOSMALL;
+			}
+			qmi_ei_plan_encode(plan, buf_dst, buf_src);
+			buf_dst = buf_dst + plan->wire_size;
+			buf_src = buf_src + temp_ei->elem_size;
+			encoded_bytes += plan->wire_size;
+			continue;
+		}
+
 		rc = qmi_encode(temp_ei->ei_array, buf_dst, buf_src,
 				out_buf_len - encoded_bytes, enc_level);
 		if (rc < 0) {
@@ -475,9 +741,19 @@ static int qmi_decode_struct_elem(struct qmi_elem_info *ei_array,
 {
 	int i, rc, decoded_bytes = 0;
 	struct qmi_elem_info *temp_ei = ei_array;
+	const struct qmi_ei_plan *plan = qmi_ei_plan_get(temp_ei->ei_array);
 
 	for (i = 0; i < elem_len && decoded_bytes < tlv_len; i++) {
-		rc = qmi_decode(temp_ei->ei_array, buf_dst, buf_src,
+		if (plan && plan->flat &&
+		    plan->wire_size <= tlv_len - decoded_bytes) {
+			qmi_ei_plan_decode(plan, buf_dst, buf_src);
+			buf_src = buf_src + plan->wire_size;
+			buf_dst = buf_dst + temp_ei->elem_size;
+			decoded_bytes += plan->wire_size;
+			continue;
+		}
+
+		rc = qmi_decode(temp_ei->ei_array, NULL, buf_dst, buf_src,
 				tlv_len - decoded_bytes, dec_level);
 		if (rc < 0)
 			return rc;
@@ -555,6 +831,7 @@ static int qmi_decode_string_elem(struct qmi_elem_info *ei_array,
 /**
  * find_ei() - Find element info corresponding to TLV Type
  * @ei_array: Struct info array of the message being decoded.
+ * @plan: Compiled form of @ei_array, may be NULL.
  * @type: TLV Type of the element being searched.
  *
  * Every element that got encoded in the QMI message will have a type
@@ -565,10 +842,15 @@ static int qmi_decode_string_elem(struct qmi_elem_info *ei_array,
  * Return: Pointer to struct info, if found
  */
 static struct qmi_elem_info *find_ei(struct qmi_elem_info *ei_array,
+				     const struct qmi_ei_plan *plan,
 				     u32 type)
 {
 	struct qmi_elem_info *temp_ei = ei_array;
 
+	if (plan && plan->indexed)
+		return plan->tlv_first[(u8)type] ?
+		       &ei_array[plan->tlv_first[(u8)type] - 1] : NULL;
+
 	while (temp_ei->data_type != QMI_EOTI) {
 		if (temp_ei->tlv_type == (u8)type)
 			return temp_ei;
@@ -581,6 +863,7 @@ static struct qmi_elem_info *find_ei(struct qmi_elem_info *ei_array,
 /**
  * qmi_decode() - Core Decode Function
  * @ei_array: Struct info array describing the structure to be decoded.
+ * @plan: Compiled form of @ei_array, used to find TLVs at level 1. May be NULL.
  * @out_c_struct: Buffer to hold the decoded C struct
  * @in_buf: Buffer containing the QMI message to be decoded
  * @in_buf_len: Length of the QMI message to be decoded
@@ -590,7 +873,8 @@ static struct qmi_elem_info *find_ei(struct qmi_elem_info *ei_array,
  * Return: The number of bytes of decoded information on success, negative
  * errno on error.
  */
-static int qmi_decode(struct qmi_elem_info *ei_array, void *out_c_struct,
+static int qmi_decode(struct qmi_elem_info *ei_array,
+		      const struct qmi_ei_plan *plan, void *out_c_struct,
 		      const void *in_buf, u32 in_buf_len,
 		      int dec_level)
 {
@@ -615,7 +899,7 @@ static int qmi_decode(struct qmi_elem_info *ei_array, void *out_c_struct,
 					      &tlv_len, tlv_pointer);
 			buf_src += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
 			decoded_bytes += (TLV_TYPE_SIZE + TLV_LEN_SIZE);
-			temp_ei = find_ei(ei_array, tlv_type);
+			temp_ei = find_ei(ei_array, plan, tlv_type);
 			if (!temp_ei && tlv_type < OPTIONAL_TLV_TYPE_START) {
 				pr_err("%s: Inval element info\n", __func__);
 				return -EINVAL;
@@ -716,8 +1000,10 @@ void *qmi_encode_message(int type, unsigned int msg_id, size_t *len,
 			 unsigned int txn_id, struct qmi_elem_info *ei,
 			 const void *c_struct)
 {
+	struct qmi_ei_plan *plan;
 	struct qmi_header *hdr;
 	ssize_t msglen = 0;
+	u64 start;
 	void *msg;
 	int ret;
 
@@ -737,7 +1023,15 @@ void *qmi_encode_message(int type, unsigned int msg_id, size_t *len,
 
 	/* Encode message, if we have a message */
 	if (c_struct) {
+		rcu_read_lock();
+		plan = qmi_ei_plan_get(ei);
+		start = local_clock();
 		msglen = qmi_encode(ei, msg + sizeof(*hdr), c_struct, *len, 1);
+		if (plan) {
+			atomic64_inc(&plan->enc_count);
+			atomic64_add(local_clock() - start, &plan->enc_ns);
+		}
+		rcu_read_unlock();
 		if (msglen < 0) {
 			kfree(msg);
 			return ERR_PTR(msglen);
@@ -769,14 +1063,28 @@ EXPORT_SYMBOL(qmi_encode_message);
 int qmi_decode_message(const void *buf, size_t len,
 		       struct qmi_elem_info *ei, void *c_struct)
 {
+	struct qmi_ei_plan *plan;
+	u64 start;
+	int ret;
+
 	if (!ei)
 		return -EINVAL;
 
 	if (!c_struct || !buf || !len)
 		return -EINVAL;
 
-	return qmi_decode(ei, c_struct, buf + sizeof(struct qmi_header),
-			  len - sizeof(struct qmi_header), 1);
+	rcu_read_lock();
+	plan = qmi_ei_plan_get(ei);
+	start = local_clock();
+	ret = qmi_decode(ei, plan, c_struct, buf + sizeof(struct qmi_header),
+			 len - sizeof(struct qmi_header), 1);
+	if (plan) {
+		atomic64_inc(&plan->dec_count);
+		atomic64_add(local_clock() - start, &plan->dec_ns);
+	}
+	rcu_read_unlock();
+
+	return ret;
 }
 EXPORT_SYMBOL(qmi_decode_message);
 
@@ -812,5 +1120,93 @@ struct qmi_elem_info qmi_response_type_v01_ei[] = {
 };
 EXPORT_SYMBOL(qmi_response_type_v01_ei);
 
+/* Plans are keyed by address, drop those of a module's arrays on unload. */
+static int qmi_plan_module_notify(struct notifier_block *nb,
+				  unsigned long action, void *data)
+{
+	struct module *mod = data;
+	struct qmi_ei_plan *plan;
+	struct hlist_node *tmp;
+	unsigned long flags;
+	int bkt;
+
+	if (action != MODULE_STATE_GOING)
+		return NOTIFY_DONE;
+
+	spin_lock_irqsave(&qmi_plan_lock, flags);
+	hash_for_each_safe(qmi_plan_table, bkt, tmp, plan, node) {
+		if (within_module((unsigned long)plan->ei, mod)) {
+			hash_del_rcu(&plan->node);
+			kfree_rcu(plan, rcu);
+		}
+	}
+	spin_unlock_irqrestore(&qmi_plan_lock, flags);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block qmi_plan_module_nb = {
+	.notifier_call = qmi_plan_module_notify,
+};
+
+static int qmi_plan_stats_show(struct seq_file *s, void *unused)
+{
+	struct qmi_ei_plan *plan;
+	u64 enc_count, dec_count;
+	int bkt;
+
+	seq_printf(s, "%-48s %4s %10s %8s %10s %8s\n", "ei", "flat",
+		   "encoded", "avg_ns", "decoded", "avg_ns");
+
+	rcu_read_lock();
+	hash_for_each_rcu(qmi_plan_table, bkt, plan, node) {
+		enc_count = atomic64_read(&plan->enc_count);
+		dec_count = atomic64_read(&plan->dec_count);
+		if (!enc_count && !dec_count)
+			continue;
+
+		seq_printf(s, "%-48ps %4d %10llu %8llu %10llu %8llu\n",
+			   plan->ei, plan->flat, enc_count,
+			   enc_count ? div64_u64(atomic64_read(&plan->enc_ns),
+						 enc_count) : 0,
+			   dec_count,
+			   dec_count ? div64_u64(atomic64_read(&plan->dec_ns),
+						 dec_count) : 0);
+	}
+	rcu_read_unlock();
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(qmi_plan_stats);
+
+static struct dentry *qmi_encdec_debugfs;
+
+static int __init qmi_encdec_init(void)
+{
+	qmi_encdec_debugfs = debugfs_create_dir("qmi_encdec", NULL);
+	debugfs_create_file("stats", 0444, qmi_encdec_debugfs, NULL,
+			    &qmi_plan_stats_fops);
+
+	return register_module_notifier(&qmi_plan_module_nb);
+}
+module_init(qmi_encdec_init);
+
+static void __exit qmi_encdec_exit(void)
+{
+	struct qmi_ei_plan *plan;
+	struct hlist_node *tmp;
+	int bkt;
+
+	unregister_module_notifier(&qmi_plan_module_nb);
+	debugfs_remove_recursive(qmi_encdec_debugfs);
+
+	synchronize_rcu();
+	hash_for_each_safe(qmi_plan_table, bkt, tmp, plan, node) {
+		hash_del(&plan->node);
+		kfree(plan);
+	}
+}
+module_exit(qmi_encdec_exit);
+
 MODULE_DESCRIPTION("QMI encoder/decoder helper");
 MODULE_LICENSE("GPL v2");
@@ -5,6 +5,10 @@
 #define __RPM_INTERNAL_H__
 
 #include <linux/bitmap.h>
+#include <linux/hashtable.h>
+#include <linux/hrtimer.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 #include <soc/qcom/tcs.h>
 
 #define TCS_TYPE_NR			4
@@ -12,8 +16,10 @@
 #define MAX_TCS_PER_TYPE		3
 #define MAX_TCS_NR			(MAX_TCS_PER_TYPE * TCS_TYPE_NR)
 #define MAX_TCS_SLOTS			(MAX_CMDS_PER_TCS * MAX_TCS_PER_TYPE)
+#define RPMH_CACHE_HASH_BITS		6
 
 struct rsc_drv;
+struct rpmh_coalesce_req;
 
 /**
  * struct tcs_group: group of Trigger Command Sets (TCS) to send state requests
@@ -52,6 +58,9 @@ struct tcs_group {
  * @dev: the device making the request
  * @err: err return from the controller
  * @needs_free: check to free dynamically allocated request object
+ * @coalesced: request is the merged payload of a coalescing window
+ * @stats: latency stats of the requesting client, if accounted
+ * @issued: time the request was handed to rpmh
  */
 struct rpmh_request {
 	struct tcs_request msg;
@@ -60,23 +69,61 @@ struct rpmh_request {
 	const struct device *dev;
 	int err;
 	bool needs_free;
+	bool coalesced;
+	struct rpmh_client_stats *stats;
+	ktime_t issued;
+};
+
+/**
+ * struct rpmh_client_stats: per client active request latency
+ *
+ * @list:      entry in the controller's client list
+ * @dev:       the client device
+ * @count:     number of completed active requests
+ * @coalesced: number of those that were merged into a coalesced request
+ * @total_ns:  sum of request to completion latency
+ * @max_ns:    worst request to completion latency
+ */
+struct rpmh_client_stats {
+	struct list_head list;
+	const struct device *dev;
+	u64 count;
+	u64 coalesced;
+	u64 total_ns;
+	u64 max_ns;
 };
 
 /**
  * struct rpmh_ctrlr: our representation of the controller
  *
  * @cache: the list of cached requests
+ * @cache_hash: @cache indexed by resource address
  * @cache_lock: synchronize access to the cache data
  * @dirty: was the cache updated since flush
  * @batch_cache: Cache sleep and wake requests sent as batch
  * @in_solver_mode: Controller is busy in solver mode
+ * @coalesce_us: active async coalescing window, 0 to send immediately
+ * @coalesce_lock: synchronize access to @pending
+ * @pending: active async request collecting votes in the current window
+ * @coalesce_timer: closes the coalescing window
+ * @coalesce_work: sends @pending once the window is closed
+ * @clients: list of per client latency stats
+ * @stats_lock: synchronize access to @clients
  */
 struct rpmh_ctrlr {
 	struct list_head cache;
+	DECLARE_HASHTABLE(cache_hash, RPMH_CACHE_HASH_BITS);
 	spinlock_t cache_lock;
 	bool dirty;
 	struct list_head batch_cache;
 	bool in_solver_mode;
+	u32 coalesce_us;
+	spinlock_t coalesce_lock;
+	struct rpmh_coalesce_req *pending;
+	struct hrtimer coalesce_timer;
+	struct work_struct coalesce_work;
+	struct list_head clients;
+	spinlock_t stats_lock;
 };
 
 /**
@@ -122,6 +169,7 @@ bool rpmh_rsc_ctrlr_is_idle(struct rsc_drv *drv);
 int rpmh_rsc_write_pdc_data(struct rsc_drv *drv, const struct tcs_request *msg);
 
 void rpmh_tx_done(const struct tcs_request *msg, int r);
+void rpmh_ctrlr_init(struct rpmh_ctrlr *ctrlr);
 
 void rpmh_rsc_debug(struct rsc_drv *drv, struct completion *compl);
 #endif /* __RPM_INTERNAL_H__ */
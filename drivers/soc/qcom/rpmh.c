@@ -3,13 +3,16 @@
 
 #include <linux/atomic.h>
 #include <linux/bug.h>
+#include <linux/debugfs.h>
 #include <linux/interrupt.h>
 #include <linux/jiffies.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
+#include <linux/math64.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/types.h>
@@ -46,12 +49,14 @@
  * @sleep_val: the sleep vote
  * @wake_val: the wake vote
  * @list: linked list obj
+ * @hnode: hash table node, keyed by @addr
  */
 struct cache_req {
 	u32 addr;
 	u32 sleep_val;
 	u32 wake_val;
 	struct list_head list;
+	struct hlist_node hnode;
 };
 
 /**
@@ -68,6 +73,23 @@ struct batch_cache_req {
 	struct rpmh_request *rpm_msgs;
 };
 
+/**
+ * struct rpmh_coalesce_req - Active votes merged within one coalescing window
+ *
+ * @rpm_msg: the merged request sent to the controller
+ * @nr_src: number of client requests merged into @rpm_msg
+ * @src: latency stats of each merged client request
+ * @src_issued: time each merged client request was made
+ */
+struct rpmh_coalesce_req {
+	struct rpmh_request rpm_msg;
+	int nr_src;
+	struct rpmh_client_stats *src[MAX_RPMH_PAYLOAD];
+	ktime_t src_issued[MAX_RPMH_PAYLOAD];
+};
+
+static struct dentry *rpmh_debugfs_root;
+
 static struct rpmh_ctrlr *get_rpmh_ctrlr(const struct device *dev)
 {
 	struct rsc_drv *drv = dev_get_drvdata(dev->parent);
@@ -89,6 +111,132 @@ static int check_ctrlr_state(struct rpmh_ctrlr *ctrlr, enum rpmh_state state)
 	return ret;
 }
 
+static struct rpmh_client_stats *get_client_stats(struct rpmh_ctrlr *ctrlr,
+						  const struct device *dev)
+{
+	struct rpmh_client_stats *p, *stats = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ctrlr->stats_lock, flags);
+	list_for_each_entry(p, &ctrlr->clients, list) {
+		if (p->dev == dev) {
+			stats = p;
+			goto unlock;
+		}
+	}
+
+	stats = kzalloc(sizeof(*stats), GFP_ATOMIC);
+	if (stats) {
+		stats->dev = dev;
+		list_add_tail(&stats->list, &ctrlr->clients);
+	}
+
+unlock:
+	spin_unlock_irqrestore(&ctrlr->stats_lock, flags);
+
+	return stats;
+}
+
+static void account_latency(struct rpmh_ctrlr *ctrlr,
+			    struct rpmh_client_stats *stats, ktime_t issued,
+			    ktime_t now, bool coalesced)
+{
+	u64 ns = ktime_to_ns(ktime_sub(now, issued));
+	unsigned long flags;
+
+	if (!stats)
+		return;
+
+	spin_lock_irqsave(&ctrlr->stats_lock, flags);
+	stats->count++;
+	if (coalesced)
+		stats->coalesced++;
+	stats->total_ns += ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+	spin_unlock_irqrestore(&ctrlr->stats_lock, flags);
+}
+
+static void account_request(struct rpmh_request *rpm_msg)
+{
+	struct rpmh_coalesce_req *creq;
+	struct rpmh_ctrlr *ctrlr;
+	ktime_t now;
+	int i;
+
+	if (!rpm_msg->stats && !rpm_msg->coalesced)
+		return;
+
+	ctrlr = get_rpmh_ctrlr(rpm_msg->dev);
+	now = ktime_get();
+
+	if (!rpm_msg->coalesced) {
+		account_latency(ctrlr, rpm_msg->stats, rpm_msg->issued, now,
+				false);
+		return;
+	}
+
+	creq = container_of(rpm_msg, struct rpmh_coalesce_req, rpm_msg);
+	for (i = 0; i < creq->nr_src; i++)
+		account_latency(ctrlr, creq->src[i], creq->src_issued[i], now,
+				creq->nr_src > 1);
+}
+
+static void coalesce_send(struct rpmh_ctrlr *ctrlr,
+			  struct rpmh_coalesce_req *creq)
+{
+	int ret;
+
+	ipc_log_string(ctrlr_to_ctx(ctrlr), "coalesced send: reqs:%d num-cmds:%d",
+		       creq->nr_src, creq->rpm_msg.msg.num_cmds);
+
+	ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr), &creq->rpm_msg.msg);
+	if (ret) {
+		pr_err("Error(%d) sending coalesced RPMH message addr=%#x\n",
+		       ret, creq->rpm_msg.msg.cmds[0].addr);
+		kfree(creq);
+	}
+}
+
+/**
+ * rpmh_coalesce_flush: Send the votes of the open coalescing window
+ *
+ * @ctrlr: the controller
+ *
+ * The coalescing lock is held while sending so that a request that
+ * flushes the window before going out itself can't overtake the votes
+ * of a window that is being sent by the window timer.
+ */
+static void rpmh_coalesce_flush(struct rpmh_ctrlr *ctrlr)
+{
+	struct rpmh_coalesce_req *creq;
+
+	spin_lock_bh(&ctrlr->coalesce_lock);
+	creq = ctrlr->pending;
+	ctrlr->pending = NULL;
+	if (creq)
+		coalesce_send(ctrlr, creq);
+	spin_unlock_bh(&ctrlr->coalesce_lock);
+}
+
+static void rpmh_coalesce_work(struct work_struct *work)
+{
+	struct rpmh_ctrlr *ctrlr = container_of(work, struct rpmh_ctrlr,
+						coalesce_work);
+
+	rpmh_coalesce_flush(ctrlr);
+}
+
+static enum hrtimer_restart rpmh_coalesce_timer_fn(struct hrtimer *timer)
+{
+	struct rpmh_ctrlr *ctrlr = container_of(timer, struct rpmh_ctrlr,
+						coalesce_timer);
+
+	queue_work(system_highpri_wq, &ctrlr->coalesce_work);
+
+	return HRTIMER_NORESTART;
+}
+
 /**
  * rpmh_mode_solver_set: Indicate that the RSC controller hardware has
  * been configured to be in solver mode
@@ -104,6 +252,9 @@ int rpmh_mode_solver_set(const struct device *dev, bool enable)
 	struct rpmh_ctrlr *ctrlr = get_rpmh_ctrlr(dev);
 	unsigned long flags;
 
+	if (enable)
+		rpmh_coalesce_flush(ctrlr);
+
 	spin_lock_irqsave(&ctrlr->cache_lock, flags);
 	rpmh_rsc_mode_solver_set(ctrlr_to_drv(ctrlr), enable);
 	ctrlr->in_solver_mode = enable;
@@ -126,6 +277,8 @@ void rpmh_tx_done(const struct tcs_request *msg, int r)
 	if (r)
 		dev_err(rpm_msg->dev, "RPMH TX fail in msg addr=%#x, err=%d\n",
 			rpm_msg->msg.cmds[0].addr, r);
+	else
+		account_request(rpm_msg);
 
 	if (!compl)
 		goto exit;
@@ -134,7 +287,9 @@ void rpmh_tx_done(const struct tcs_request *msg, int r)
 	complete(compl);
 
 exit:
-	if (free)
+	if (free && rpm_msg->coalesced)
+		kfree(container_of(rpm_msg, struct rpmh_coalesce_req, rpm_msg));
+	else if (free)
 		kfree(rpm_msg);
 }
 
@@ -142,7 +297,7 @@ static struct cache_req *__find_req(struct rpmh_ctrlr *ctrlr, u32 addr)
 {
 	struct cache_req *p, *req = NULL;
 
-	list_for_each_entry(p, &ctrlr->cache, list) {
+	hash_for_each_possible(ctrlr->cache_hash, p, hnode, addr) {
 		if (p->addr == addr) {
 			req = p;
 			break;
@@ -154,7 +309,7 @@ static struct cache_req *__find_req(struct rpmh_ctrlr *ctrlr, u32 addr)
 
 static struct cache_req *cache_rpm_request(struct rpmh_ctrlr *ctrlr,
 					   enum rpmh_state state,
-					   struct tcs_cmd *cmd)
+					   const struct tcs_cmd *cmd)
 {
 	struct cache_req *req;
 	unsigned long flags;
@@ -174,6 +329,7 @@ static struct cache_req *cache_rpm_request(struct rpmh_ctrlr *ctrlr,
 	req->sleep_val = req->wake_val = UINT_MAX;
 	INIT_LIST_HEAD(&req->list);
 	list_add_tail(&req->list, &ctrlr->cache);
+	hash_add(ctrlr->cache_hash, &req->hnode, req->addr);
 
 existing:
 	switch (state) {
@@ -241,6 +397,10 @@ static int __rpmh_write(const struct device *dev, enum rpmh_state state,
 
 	if (state == RPMH_ACTIVE_ONLY_STATE) {
 		WARN_ON(irqs_disabled());
+		rpm_msg->dev = dev;
+		rpm_msg->stats = get_client_stats(ctrlr, dev);
+		rpm_msg->issued = ktime_get();
+		rpmh_coalesce_flush(ctrlr);
 		ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr), &rpm_msg->msg);
 	} else {
 		/* Clean up our call by spoofing tx_done */
@@ -266,6 +426,115 @@ static int __fill_rpmh_msg(struct rpmh_request *req, enum rpmh_state state,
 	return 0;
 }
 
+static bool cmds_need_ordering(const struct tcs_cmd *cmd, u32 n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		if (cmd[i].wait)
+			return true;
+	}
+
+	return false;
+}
+
+static int coalesce_find(const struct tcs_request *msg, u32 addr)
+{
+	int i;
+
+	for (i = 0; i < msg->num_cmds; i++) {
+		if (msg->cmds[i].addr == addr)
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+static bool coalesce_fits(const struct rpmh_coalesce_req *creq,
+			  const struct tcs_cmd *cmd, u32 n)
+{
+	u32 num_cmds = creq->rpm_msg.msg.num_cmds;
+	int i;
+
+	if (creq->nr_src == MAX_RPMH_PAYLOAD)
+		return false;
+
+	for (i = 0; i < n; i++) {
+		if (coalesce_find(&creq->rpm_msg.msg, cmd[i].addr) < 0)
+			num_cmds++;
+	}
+
+	return num_cmds <= MAX_RPMH_PAYLOAD;
+}
+
+/**
+ * rpmh_coalesce_write: Merge an active async request into the open window
+ *
+ * @ctrlr: the controller
+ * @dev: The device making the request
+ * @cmd: The payload data
+ * @n: The number of elements in payload
+ *
+ * The first request opens a window of ctrlr->coalesce_us; requests made
+ * until it closes are merged into one TCS transaction, with a later vote
+ * to an address replacing the earlier one. A request that does not fit
+ * in the remaining payload sends the window early and opens a new one.
+ */
+static int rpmh_coalesce_write(struct rpmh_ctrlr *ctrlr,
+			       const struct device *dev,
+			       const struct tcs_cmd *cmd, u32 n)
+{
+	struct rpmh_client_stats *stats = get_client_stats(ctrlr, dev);
+	struct rpmh_coalesce_req *creq;
+	struct tcs_request *msg;
+	struct cache_req *req;
+	int i, j;
+
+	for (i = 0; i < n; i++) {
+		req = cache_rpm_request(ctrlr, RPMH_ACTIVE_ONLY_STATE, &cmd[i]);
+		if (IS_ERR(req))
+			return PTR_ERR(req);
+	}
+
+	spin_lock_bh(&ctrlr->coalesce_lock);
+	creq = ctrlr->pending;
+	if (creq && !coalesce_fits(creq, cmd, n)) {
+		ctrlr->pending = NULL;
+		coalesce_send(ctrlr, creq);
+		creq = NULL;
+	}
+
+	if (!creq) {
+		creq = kzalloc(sizeof(*creq), GFP_ATOMIC);
+		if (!creq) {
+			spin_unlock_bh(&ctrlr->coalesce_lock);
+			return -ENOMEM;
+		}
+		creq->rpm_msg.msg.state = RPMH_ACTIVE_ONLY_STATE;
+		creq->rpm_msg.msg.cmds = creq->rpm_msg.cmd;
+		creq->rpm_msg.dev = dev;
+		creq->rpm_msg.needs_free = true;
+		creq->rpm_msg.coalesced = true;
+		ctrlr->pending = creq;
+		hrtimer_start(&ctrlr->coalesce_timer,
+			      ns_to_ktime((u64)ctrlr->coalesce_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	}
+
+	msg = &creq->rpm_msg.msg;
+	for (i = 0; i < n; i++) {
+		j = coalesce_find(msg, cmd[i].addr);
+		if (j < 0)
+			j = msg->num_cmds++;
+		msg->cmds[j] = cmd[i];
+	}
+	creq->src[creq->nr_src] = stats;
+	creq->src_issued[creq->nr_src++] = ktime_get();
+	spin_unlock_bh(&ctrlr->coalesce_lock);
+
+	return 0;
+}
+
 /**
  * rpmh_write_async: Write a set of RPMH commands
  *
@@ -276,6 +545,10 @@ static int __fill_rpmh_msg(struct rpmh_request *req, enum rpmh_state state,
  *
  * Write a set of RPMH commands, the order of commands is maintained
  * and will be sent as a single shot.
+ *
+ * If the controller has a coalescing window, active requests that don't
+ * need per command completion may be merged with other clients' votes
+ * and sent as one shot at the end of the window.
  */
 int rpmh_write_async(const struct device *dev, enum rpmh_state state,
 		     const struct tcs_cmd *cmd, u32 n)
@@ -291,6 +564,10 @@ int rpmh_write_async(const struct device *dev, enum rpmh_state state,
 	if (ret)
 		return ret;
 
+	if (state == RPMH_ACTIVE_ONLY_STATE && READ_ONCE(ctrlr->coalesce_us) &&
+	    cmd && n && n <= MAX_RPMH_PAYLOAD && !cmds_need_ordering(cmd, n))
+		return rpmh_coalesce_write(ctrlr, dev, cmd, n);
+
 	rpm_msg = kzalloc(sizeof(*rpm_msg), GFP_ATOMIC);
 	if (!rpm_msg)
 		return -ENOMEM;
@@ -489,11 +766,16 @@ int rpmh_write_batch(const struct device *dev, enum rpmh_state state,
 		return 0;
 	}
 
+	rpmh_coalesce_flush(ctrlr);
+
 	for (i = 0; i < count; i++) {
 		struct completion *compl = &compls[i];
 
 		init_completion(compl);
 		rpm_msgs[i].completion = compl;
+		rpm_msgs[i].dev = dev;
+		rpm_msgs[i].stats = get_client_stats(ctrlr, dev);
+		rpm_msgs[i].issued = ktime_get();
 		ret = rpmh_rsc_send_data(ctrlr_to_drv(ctrlr), &rpm_msgs[i].msg);
 		if (ret) {
 			pr_err("Error(%d) sending RPMH message addr=%#x\n",
@@ -685,3 +967,58 @@ int rpmh_ctrlr_idle(const struct device *dev)
 	return rpmh_rsc_ctrlr_is_idle(ctrlr_to_drv(ctrlr));
 }
 EXPORT_SYMBOL(rpmh_ctrlr_idle);
+
+static int client_stats_show(struct seq_file *s, void *unused)
+{
+	struct rpmh_ctrlr *ctrlr = s->private;
+	struct rpmh_client_stats *stats;
+	unsigned long flags;
+	u64 avg;
+
+	seq_printf(s, "%-32s %10s %10s %10s %10s\n", "client", "requests",
+		   "coalesced", "avg_us", "max_us");
+
+	spin_lock_irqsave(&ctrlr->stats_lock, flags);
+	list_for_each_entry(stats, &ctrlr->clients, list) {
+		avg = stats->count ? div64_u64(stats->total_ns, stats->count) : 0;
+		seq_printf(s, "%-32s %10llu %10llu %10llu %10llu\n",
+			   dev_name(stats->dev), stats->count, stats->coalesced,
+			   div_u64(avg, NSEC_PER_USEC),
+			   div_u64(stats->max_ns, NSEC_PER_USEC));
+	}
+	spin_unlock_irqrestore(&ctrlr->stats_lock, flags);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(client_stats);
+
+/**
+ * rpmh_ctrlr_init: Initialize the client side state of the controller
+ *
+ * @ctrlr: the controller
+ */
+void rpmh_ctrlr_init(struct rpmh_ctrlr *ctrlr)
+{
+	struct dentry *dir;
+
+	spin_lock_init(&ctrlr->cache_lock);
+	INIT_LIST_HEAD(&ctrlr->cache);
+	hash_init(ctrlr->cache_hash);
+	INIT_LIST_HEAD(&ctrlr->batch_cache);
+
+	spin_lock_init(&ctrlr->coalesce_lock);
+	hrtimer_init(&ctrlr->coalesce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ctrlr->coalesce_timer.function = rpmh_coalesce_timer_fn;
+	INIT_WORK(&ctrlr->coalesce_work, rpmh_coalesce_work);
+
+	spin_lock_init(&ctrlr->stats_lock);
+	INIT_LIST_HEAD(&ctrlr->clients);
+
+	if (!rpmh_debugfs_root)
+		rpmh_debugfs_root = debugfs_create_dir("rpmh", NULL);
+
+	dir = debugfs_create_dir(ctrlr_to_drv(ctrlr)->name, rpmh_debugfs_root);
+	debugfs_create_u32("coalesce_us", 0644, dir, &ctrlr->coalesce_us);
+	debugfs_create_file("client_stats", 0444, dir, ctrlr,
+			    &client_stats_fops);
+}
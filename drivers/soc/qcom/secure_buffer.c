@@ -50,13 +50,33 @@ populate_dest_info(int *dest_vmids, int nelements, int *dest_perms,
 	return dest_info;
 }
 
+/*
+ * Cursor over the entries of one or more sg tables that are assigned with the
+ * same ACL, so that a batch may span the end of one table and the start of
+ * the next.
+ */
+struct hyp_assign_cursor {
+	struct sg_table **tables;
+	int nr_tables;
+	int table;
+	struct scatterlist *sgl;
+};
+
+static struct scatterlist *hyp_assign_cursor_next(struct hyp_assign_cursor *c)
+{
+	c->sgl = sg_next(c->sgl);
+	if (!c->sgl && ++c->table < c->nr_tables)
+		c->sgl = c->tables[c->table]->sgl;
+
+	return c->sgl;
+}
+
 static unsigned int get_batches_from_sgl(struct qcom_scm_mem_map_info *sgt_copy,
-					 struct scatterlist *sgl,
-					 struct scatterlist **next_sgl)
+					 struct hyp_assign_cursor *cursor)
 {
 	u64 batch_size = 0;
 	unsigned int i = 0;
-	struct scatterlist *curr_sgl = sgl;
+	struct scatterlist *curr_sgl = cursor->sgl;
 
 	/* Ensure no zero size batches */
 	do {
@@ -64,26 +84,27 @@ static unsigned int get_batches_from_sgl(struct qcom_scm_mem_map_info *sgt_copy,
 					       page_to_phys(sg_page(curr_sgl)),
 					       curr_sgl->length);
 		batch_size += curr_sgl->length;
-		curr_sgl = sg_next(curr_sgl);
+		curr_sgl = hyp_assign_cursor_next(cursor);
 		i++;
 	} while (curr_sgl && i < BATCH_MAX_SECTIONS &&
 		 curr_sgl->length + batch_size < BATCH_MAX_SIZE);
 
-	*next_sgl = curr_sgl;
 	return i;
 }
 
-static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
-			      size_t source_size,
+static int batched_hyp_assign(struct sg_table **tables, int nr_tables,
+			      u32 *source_vmids, size_t source_size,
 			      struct qcom_scm_current_perm_info *destvms,
 			      size_t destvms_size)
 {
-	unsigned int batch_start = 0;
 	unsigned int batches_processed;
 	unsigned int i = 0;
 	u64 total_delta;
-	struct scatterlist *curr_sgl = table->sgl;
-	struct scatterlist *next_sgl;
+	struct hyp_assign_cursor cursor = {
+		.tables = tables,
+		.nr_tables = nr_tables,
+		.sgl = tables[0]->sgl,
+	};
 	int ret = 0;
 	ktime_t batch_assign_start_ts;
 	ktime_t first_assign_ts;
@@ -97,10 +118,9 @@ static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
 		return -ENOMEM;
 
 	first_assign_ts = ktime_get();
-	while (batch_start < table->nents) {
+	while (cursor.sgl) {
 		batches_processed = get_batches_from_sgl(mem_regions_buf,
-							 curr_sgl, &next_sgl);
-		curr_sgl = next_sgl;
+							 &cursor);
 		mem_regions_buf_size = batches_processed *
 				       sizeof(*mem_regions_buf);
 		entries_dma_addr = dma_map_single(qcom_secure_buffer_dev,
@@ -137,8 +157,6 @@ static int batched_hyp_assign(struct sg_table *table, u32 *source_vmids,
 			ret = -EADDRNOTAVAIL;
 			break;
 		}
-
-		batch_start += batches_processed;
 	}
 	total_delta = ktime_us_delta(ktime_get(), first_assign_ts);
 	trace_hyp_assign_end(total_delta, div64_u64(total_delta, i));
@@ -175,13 +193,16 @@ int page_accessible(unsigned long pfn)
 /*
  *  When -EADDRNOTAVAIL is returned the memory may no longer be in
  *  a usable state and should no longer be accessed by the HLOS.
+ *
+ *  All tables are assigned with the same ACL, and entries of consecutive
+ *  tables share hypervisor calls.
  */
-int hyp_assign_table(struct sg_table *table,
+int hyp_assign_tables(struct sg_table **tables, int nr_tables,
 			u32 *source_vm_list, int source_nelems,
 			int *dest_vmids, int *dest_perms,
 			int dest_nelems)
 {
-	int ret = 0;
+	int i, ret = 0;
 	u32 *source_vm_copy;
 	size_t source_vm_copy_size;
 	struct qcom_scm_current_perm_info *dest_vm_copy;
@@ -191,10 +212,14 @@ int hyp_assign_table(struct sg_table *table,
 	if (!qcom_secure_buffer_dev)
 		return -EPROBE_DEFER;
 
-	if (!table || !table->sgl || !source_vm_list || !source_nelems ||
-	    !dest_vmids || !dest_perms || !dest_nelems || !table->nents)
+	if (!tables || nr_tables <= 0 || !source_vm_list || !source_nelems ||
+	    !dest_vmids || !dest_perms || !dest_nelems)
 		return -EINVAL;
 
+	for (i = 0; i < nr_tables; i++)
+		if (!tables[i] || !tables[i]->sgl || !tables[i]->nents)
+			return -EINVAL;
+
 	/*
 	 * We can only pass cache-aligned sizes to hypervisor, so we need
 	 * to kmalloc and memcpy the source_vm_list here.
@@ -230,8 +255,9 @@ int hyp_assign_table(struct sg_table *table,
 			      dest_perms, dest_nelems);
 
 
-	ret = batched_hyp_assign(table, source_vm_copy, source_vm_copy_size,
-				 dest_vm_copy, dest_vm_copy_size);
+	ret = batched_hyp_assign(tables, nr_tables, source_vm_copy,
+				 source_vm_copy_size, dest_vm_copy,
+				 dest_vm_copy_size);
 
 	if (!ret) {
 		while (dest_nelems--) {
@@ -239,10 +265,9 @@ int hyp_assign_table(struct sg_table *table,
 				break;
 		}
 
-		if (dest_nelems == -1)
-			set_each_page_of_sg(table, SECURE_PAGE_MAGIC);
-		else
-			set_each_page_of_sg(table, 0);
+		for (i = 0; i < nr_tables; i++)
+			set_each_page_of_sg(tables[i], dest_nelems == -1 ?
+					    SECURE_PAGE_MAGIC : 0);
 	}
 
 
@@ -257,6 +282,16 @@ int hyp_assign_table(struct sg_table *table,
 	kfree(source_vm_copy);
 	return ret;
 }
+EXPORT_SYMBOL(hyp_assign_tables);
+
+int hyp_assign_table(struct sg_table *table,
+			u32 *source_vm_list, int source_nelems,
+			int *dest_vmids, int *dest_perms,
+			int dest_nelems)
+{
+	return hyp_assign_tables(&table, 1, source_vm_list, source_nelems,
+				 dest_vmids, dest_perms, dest_nelems);
+}
 EXPORT_SYMBOL(hyp_assign_table);
 
 int hyp_assign_phys(phys_addr_t addr, u64 size, u32 *source_vm_list,
@@ -23,6 +23,10 @@
 #include <linux/signal.h>
 #include <linux/msm_ion.h>
 #include <linux/of_platform.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 
 #include <linux/qcom_scm.h>
 #include <asm/cacheflush.h>
@@ -52,6 +56,8 @@
 #define SMCINVOKE_MEM_PERM_RW           6
 #define SMCINVOKE_SCM_EBUSY_WAIT_MS 30
 #define SMCINVOKE_SCM_EBUSY_MAX_RETRY 67
+#define SMCINVOKE_SHM_SLOTS             4
+#define SMCINVOKE_LAT_BUCKETS           16
 
 
 /* TZ defined values - Start */
@@ -265,6 +271,36 @@ struct smcinvoke_mem_obj {
 	uint64_t shmbridge_handle;
 };
 
+/*
+ * Marshalling buffers kept across invokes. Keymaster, fingerprint and DRM
+ * issue long runs of small invokes, and each of them used to take two
+ * buffers from the shmbridge pool and give them back. A free slot is
+ * reused instead, an invoke that finds all slots busy falls back to the
+ * pool.
+ */
+struct smcinvoke_shm_slot {
+	bool busy;
+	struct qtee_shm in_shm;
+	struct qtee_shm out_shm;
+};
+
+static struct smcinvoke_shm_slot g_shm_slots[SMCINVOKE_SHM_SLOTS];
+static DEFINE_SPINLOCK(g_shm_slots_lock);
+
+/*
+ * Invoke statistics, latencies are log2 buckets in us: bucket 0 counts
+ * calls under 2us and the last one everything from 32ms up.
+ */
+struct smcinvoke_stats {
+	atomic_long_t invoke_lat[SMCINVOKE_LAT_BUCKETS];
+	atomic_long_t smc_lat[SMCINVOKE_LAT_BUCKETS];
+	atomic_long_t shm_hits;
+	atomic_long_t shm_misses;
+};
+
+static struct smcinvoke_stats g_stats;
+static struct dentry *smcinvoke_debugfs;
+
 #define IPC_LOG_PAGE_COUNT 50
 static void *ipc_logging_context;
 #define IPC_LOG(fmt, args...) \
@@ -1870,6 +1906,96 @@ static long process_accept_req(struct file *filp, unsigned int cmd,
 	return ret;
 }
 
+static void smcinvoke_lat_add(atomic_long_t *hist, ktime_t start)
+{
+	u64 us = ktime_us_delta(ktime_get(), start);
+	int bucket = us ? min(ilog2(us), SMCINVOKE_LAT_BUCKETS - 1) : 0;
+
+	atomic_long_inc(&hist[bucket]);
+}
+
+/* Make @shm at least @size bytes, keeping it if it already is */
+static int smcinvoke_fit_shm(struct qtee_shm *shm, size_t size)
+{
+	if (shm->vaddr && shm->size >= size)
+		return 0;
+
+	qtee_shmbridge_free_shm(shm);
+	memset(shm, 0, sizeof(*shm));
+	return qtee_shmbridge_allocate_shm(size, shm);
+}
+
+/*
+ * Get the in and out buffers of an invoke, from a cache slot if one is
+ * free. *slotp is set to the slot, or NULL if the buffers came from the
+ * pool and must be freed by the caller.
+ */
+static int smcinvoke_get_shm(size_t in_size, size_t out_size,
+			     struct qtee_shm *in_shm, struct qtee_shm *out_shm,
+			     struct smcinvoke_shm_slot **slotp)
+{
+	struct smcinvoke_shm_slot *slot = NULL;
+	int i, ret;
+
+	spin_lock(&g_shm_slots_lock);
+	for (i = 0; i < SMCINVOKE_SHM_SLOTS; i++) {
+		if (!g_shm_slots[i].busy) {
+			slot = &g_shm_slots[i];
+			slot->busy = true;
+			break;
+		}
+	}
+	spin_unlock(&g_shm_slots_lock);
+
+	*slotp = slot;
+	if (slot) {
+		ret = smcinvoke_fit_shm(&slot->in_shm, in_size);
+		if (!ret)
+			ret = smcinvoke_fit_shm(&slot->out_shm, out_size);
+		if (!ret) {
+			atomic_long_inc(&g_stats.shm_hits);
+			*in_shm = slot->in_shm;
+			*out_shm = slot->out_shm;
+			/* Pool buffers come back zeroed, keep it that way */
+			memset(in_shm->vaddr, 0, in_size);
+			memset(out_shm->vaddr, 0, out_size);
+			return 0;
+		}
+
+		spin_lock(&g_shm_slots_lock);
+		slot->busy = false;
+		spin_unlock(&g_shm_slots_lock);
+		*slotp = NULL;
+	}
+
+	atomic_long_inc(&g_stats.shm_misses);
+	ret = qtee_shmbridge_allocate_shm(in_size, in_shm);
+	if (ret)
+		return ret;
+
+	ret = qtee_shmbridge_allocate_shm(out_size, out_shm);
+	if (ret) {
+		qtee_shmbridge_free_shm(in_shm);
+		memset(in_shm, 0, sizeof(*in_shm));
+	}
+
+	return ret;
+}
+
+static void smcinvoke_put_shm(struct smcinvoke_shm_slot *slot,
+			      struct qtee_shm *in_shm, struct qtee_shm *out_shm)
+{
+	if (!slot) {
+		qtee_shmbridge_free_shm(in_shm);
+		qtee_shmbridge_free_shm(out_shm);
+		return;
+	}
+
+	spin_lock(&g_shm_slots_lock);
+	slot->busy = false;
+	spin_unlock(&g_shm_slots_lock);
+}
+
 static long process_invoke_req(struct file *filp, unsigned int cmd,
 						unsigned long arg)
 {
@@ -1880,6 +2006,8 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	union  smcinvoke_arg *args_buf = NULL;
 	struct smcinvoke_file_data *tzobj = filp->private_data;
 	struct qtee_shm in_shm = {0}, out_shm = {0};
+	struct smcinvoke_shm_slot *slot = NULL;
+	ktime_t start = ktime_get(), smc_start;
 
 	/*
 	 * Hold reference to remote object until invoke op is not
@@ -1932,23 +2060,19 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	}
 
 	inmsg_size = compute_in_msg_size(&req, args_buf);
-	ret = qtee_shmbridge_allocate_shm(inmsg_size, &in_shm);
-	if (ret) {
-		ret = -ENOMEM;
-		pr_err("shmbridge alloc failed for in msg in invoke req\n");
-		goto out;
-	}
-	in_msg = in_shm.vaddr;
 
 	mutex_lock(&g_smcinvoke_lock);
 	outmsg_size = PAGE_ALIGN(g_max_cb_buf_size);
 	mutex_unlock(&g_smcinvoke_lock);
-	ret = qtee_shmbridge_allocate_shm(outmsg_size, &out_shm);
+
+	ret = smcinvoke_get_shm(inmsg_size, outmsg_size, &in_shm, &out_shm,
+				&slot);
 	if (ret) {
 		ret = -ENOMEM;
-		pr_err("shmbridge alloc failed for out msg in invoke req\n");
+		pr_err("shmbridge alloc failed for msgs in invoke req\n");
 		goto out;
 	}
+	in_msg = in_shm.vaddr;
 	out_msg = out_shm.vaddr;
 
 	IPC_LOG("tzhandle=0x%08x op=0x%02x counts=0x%04x",
@@ -1961,9 +2085,11 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 		goto out;
 	}
 
+	smc_start = ktime_get();
 	ret = prepare_send_scm_msg(in_msg, in_shm.paddr, inmsg_size,
 					out_msg, out_shm.paddr, outmsg_size,
 					&req, args_buf, &tz_acked, &in_shm, &out_shm);
+	smcinvoke_lat_add(g_stats.smc_lat, smc_start);
 
 	/*
 	 * If scm_call is success, TZ owns responsibility to release
@@ -2004,12 +2130,12 @@ static long process_invoke_req(struct file *filp, unsigned int cmd,
 	release_filp(filp_to_release, OBJECT_COUNTS_MAX_OO);
 	if (ret)
 		release_tzhandles(tzhandles_to_release, OBJECT_COUNTS_MAX_OO);
-	qtee_shmbridge_free_shm(&in_shm);
-	qtee_shmbridge_free_shm(&out_shm);
+	smcinvoke_put_shm(slot, &in_shm, &out_shm);
 	kfree(args_buf);
 
 	if (ret)
 		pr_err("invoke thread returning with ret = %d\n", ret);
+	smcinvoke_lat_add(g_stats.invoke_lat, start);
 
 	return ret;
 }
@@ -2156,6 +2282,41 @@ static int smcinvoke_release(struct inode *nodp, struct file *filp)
 	return ret;
 }
 
+static void smcinvoke_show_hist(struct seq_file *m, const char *name,
+				atomic_long_t *hist)
+{
+	int i;
+
+	seq_printf(m, "%s:\n", name);
+	for (i = 0; i < SMCINVOKE_LAT_BUCKETS; i++)
+		seq_printf(m, "  %s%6uus %lu\n",
+			   i == SMCINVOKE_LAT_BUCKETS - 1 ? ">=" : "< ",
+			   i == SMCINVOKE_LAT_BUCKETS - 1 ? 1U << i : 2U << i,
+			   atomic_long_read(&hist[i]));
+}
+
+static int smcinvoke_stats_show(struct seq_file *m, void *v)
+{
+	smcinvoke_show_hist(m, "invoke", g_stats.invoke_lat);
+	smcinvoke_show_hist(m, "smc", g_stats.smc_lat);
+	seq_printf(m, "shm_hits: %lu\nshm_misses: %lu\n",
+		   atomic_long_read(&g_stats.shm_hits),
+		   atomic_long_read(&g_stats.shm_misses));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(smcinvoke_stats);
+
+static void smcinvoke_free_shm_slots(void)
+{
+	int i;
+
+	for (i = 0; i < SMCINVOKE_SHM_SLOTS; i++) {
+		qtee_shmbridge_free_shm(&g_shm_slots[i].in_shm);
+		qtee_shmbridge_free_shm(&g_shm_slots[i].out_shm);
+		memset(&g_shm_slots[i], 0, sizeof(g_shm_slots[i]));
+	}
+}
+
 static int smcinvoke_probe(struct platform_device *pdev)
 {
 	unsigned int baseminor = 0;
@@ -2201,6 +2362,10 @@ static int smcinvoke_probe(struct platform_device *pdev)
 			"qcom,support-legacy_smc");
 	invoke_cmd = legacy_smc_call ? SMCINVOKE_INVOKE_CMD_LEGACY : SMCINVOKE_INVOKE_CMD;
 
+	smcinvoke_debugfs = debugfs_create_dir(SMCINVOKE_DEV, NULL);
+	debugfs_create_file("stats", 0400, smcinvoke_debugfs, NULL,
+			    &smcinvoke_stats_fops);
+
 	return  0;
 
 exit_destroy_device:
@@ -2216,6 +2381,8 @@ static int smcinvoke_remove(struct platform_device *pdev)
 {
 	int count = 1;
 
+	debugfs_remove_recursive(smcinvoke_debugfs);
+	smcinvoke_free_shm_slots();
 	cdev_del(&smcinvoke_cdev);
 	device_destroy(driver_class, smcinvoke_device_no);
 	class_destroy(driver_class);
@@ -162,6 +162,15 @@ struct spi_geni_master {
 	int num_tx_eot;
 	int num_rx_eot;
 	int num_xfers;
+	ktime_t batch_start;
+	/* Completion latency, per GSI batch and per FIFO/SE DMA transfer */
+	u64 gsi_batches;
+	u64 gsi_xfers;
+	u64 gsi_lat_us;
+	u64 gsi_lat_max_us;
+	u64 fifo_xfers;
+	u64 fifo_lat_us;
+	u64 fifo_lat_max_us;
 	void *ipc;
 	bool gsi_mode; /* GSI Mode */
 	bool shared_ee; /* Dual EE use case */
@@ -208,6 +217,24 @@ static ssize_t spi_slave_state_store(struct device *dev,
 
 static DEVICE_ATTR_RW(spi_slave_state);
 
+static ssize_t spi_xfer_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct spi_master *spi = dev_get_drvdata(dev);
+	struct spi_geni_master *mas = spi_master_get_devdata(spi);
+
+	return scnprintf(buf, PAGE_SIZE,
+		"gsi_batches:%llu gsi_xfers:%llu avg_us:%llu max_us:%llu\n"
+		"fifo_xfers:%llu avg_us:%llu max_us:%llu\n",
+		mas->gsi_batches, mas->gsi_xfers,
+		div64_u64(mas->gsi_lat_us, max_t(u64, mas->gsi_batches, 1)),
+		mas->gsi_lat_max_us, mas->fifo_xfers,
+		div64_u64(mas->fifo_lat_us, max_t(u64, mas->fifo_xfers, 1)),
+		mas->fifo_lat_max_us);
+}
+
+static DEVICE_ATTR_RO(spi_xfer_stats);
+
 static void spi_slv_setup(struct spi_geni_master *mas)
 {
 	geni_write_reg(SPI_SLAVE_EN, mas->base, SE_SPI_SLAVE_EN);
@@ -1073,6 +1100,7 @@ static int spi_geni_prepare_message(struct spi_master *spi,
 	} else if (mas->cur_xfer_mode == GSI_DMA) {
 		memset(mas->gsi, 0,
 				(sizeof(struct spi_geni_gsi) * NUM_SPI_XFER));
+		mas->num_xfers = 0;
 		geni_se_select_mode(mas->base, GSI_DMA);
 		ret = spi_geni_map_buf(mas, spi_msg);
 	} else {
@@ -1685,6 +1713,9 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 	}
 
 	if (mas->cur_xfer_mode != GSI_DMA) {
+		ktime_t start = ktime_get();
+		u64 lat_us;
+
 		reinit_completion(&mas->xfer_done);
 			ret = setup_fifo_xfer(xfer, mas, slv->mode, spi);
 		if (ret) {
@@ -1720,12 +1751,24 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 				geni_se_rx_dma_unprep(mas->wrapper_dev,
 					xfer->rx_dma, xfer->len);
 		}
+
+		lat_us = ktime_us_delta(ktime_get(), start);
+		mas->fifo_xfers++;
+		mas->fifo_lat_us += lat_us;
+		mas->fifo_lat_max_us = max(mas->fifo_lat_max_us, lat_us);
 	} else {
-		mas->num_tx_eot = 0;
-		mas->num_rx_eot = 0;
-		mas->num_xfers = 0;
-		reinit_completion(&mas->tx_cb);
-		reinit_completion(&mas->rx_cb);
+		/*
+		 * Queue up to NUM_SPI_XFER transfers of a message back to
+		 * back on the GSI channels and wait for their completions
+		 * once, instead of round tripping to the CPU per transfer.
+		 */
+		if (!mas->num_xfers) {
+			mas->num_tx_eot = 0;
+			mas->num_rx_eot = 0;
+			reinit_completion(&mas->tx_cb);
+			reinit_completion(&mas->rx_cb);
+			mas->batch_start = ktime_get();
+		}
 
 		ret = setup_gsi_xfer(xfer, mas, slv, spi);
 		if (ret) {
@@ -1737,6 +1780,7 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 		if ((mas->num_xfers >= NUM_SPI_XFER) ||
 			(list_is_last(&xfer->transfer_list,
 					&spi->cur_msg->transfers))) {
+			u64 lat_us;
 			int i;
 
 			for (i = 0 ; i < mas->num_tx_eot; i++) {
@@ -1766,10 +1810,18 @@ static int spi_geni_transfer_one(struct spi_master *spi,
 				mas->qn_err = false;
 				goto err_gsi_geni_transfer_one;
 			}
+
+			lat_us = ktime_us_delta(ktime_get(), mas->batch_start);
+			mas->gsi_batches++;
+			mas->gsi_xfers += mas->num_xfers;
+			mas->gsi_lat_us += lat_us;
+			mas->gsi_lat_max_us = max(mas->gsi_lat_max_us, lat_us);
+			mas->num_xfers = 0;
 		}
 	}
 	return ret;
 err_gsi_geni_transfer_one:
+	mas->num_xfers = 0;
 	geni_se_dump_dbg_regs(&mas->spi_rsc, mas->base, mas->ipc);
 	if (!mas->is_le_vm) {
 		dmaengine_terminate_all(mas->tx);
@@ -2211,6 +2263,9 @@ static int spi_geni_probe(struct platform_device *pdev)
 	}
 	ret = sysfs_create_file(&(geni_mas->dev->kobj),
 			&dev_attr_spi_slave_state.attr);
+	if (!ret)
+		ret = sysfs_create_file(&(geni_mas->dev->kobj),
+				&dev_attr_spi_xfer_stats.attr);
 
 	snprintf(boot_marker, sizeof(boot_marker),
 			"M - DRIVER GENI_SPI_%d Ready", spi->bus_num);
@@ -2230,6 +2285,7 @@ static int spi_geni_remove(struct platform_device *pdev)
 	struct spi_master *master = platform_get_drvdata(pdev);
 	struct spi_geni_master *geni_mas = spi_master_get_devdata(master);
 
+	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_spi_xfer_stats.attr);
 	sysfs_remove_file(&pdev->dev.kobj, &dev_attr_spi_slave_state.attr);
 	se_geni_resources_off(&geni_mas->spi_rsc);
 	spi_unregister_master(master);
@@ -6,6 +6,7 @@
  */
 
 #include <linux/list.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/sched/signal.h>
@@ -45,6 +46,107 @@ static void ion_msm_page_pool_add(struct ion_msm_page_pool *pool,
 	mutex_unlock(&pool->mutex);
 }
 
+/*
+ * Take a page from this CPU's cache. Pages in the cache are still counted
+ * as part of the pool until they are handed out here.
+ */
+static struct page *ion_msm_page_pool_pcp_get(struct ion_msm_page_pool *pool)
+{
+	struct ion_msm_page_pool_pcp *pcp;
+	struct page *page = NULL;
+
+	if (!pool->pcp)
+		return NULL;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count)
+		page = pcp->pages[--pcp->count];
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (page) {
+		atomic_dec(&pool->count);
+		mod_node_page_state(page_pgdat(page),
+				    NR_KERNEL_MISC_RECLAIMABLE,
+				    -(1 << pool->order));
+	}
+
+	return page;
+}
+
+/*
+ * Put a freed page in this CPU's cache. When the cache is full the oldest
+ * half of it is moved to the pool lists under a single lock acquisition.
+ */
+static bool ion_msm_page_pool_pcp_put(struct ion_msm_page_pool *pool,
+				      struct page *page)
+{
+	struct page *flush[ION_POOL_PCP_MAX];
+	struct ion_msm_page_pool_pcp *pcp;
+	int i, nr = 0;
+
+	if (!pool->pcp || PageHighMem(page))
+		return false;
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (pcp->count == pool->pcp_high) {
+		nr = pool->pcp_high / 2;
+		memcpy(flush, pcp->pages, nr * sizeof(*flush));
+		pcp->count -= nr;
+		memmove(pcp->pages, pcp->pages + nr,
+			pcp->count * sizeof(*pcp->pages));
+	}
+	pcp->pages[pcp->count++] = page;
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	atomic_inc(&pool->count);
+	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+			    (1 << pool->order));
+
+	if (nr) {
+		mutex_lock(&pool->mutex);
+		for (i = 0; i < nr; i++)
+			list_add_tail(&flush[i]->lru, &pool->low_items);
+		pool->low_count += nr;
+		mutex_unlock(&pool->mutex);
+	}
+
+	return true;
+}
+
+/* Move every per-CPU cached page back to the pool lists */
+static void ion_msm_page_pool_pcp_drain(struct ion_msm_page_pool *pool)
+{
+	struct ion_msm_page_pool_pcp *pcp;
+	LIST_HEAD(pages);
+	int cpu, i, nr = 0;
+
+	if (!pool->pcp)
+		return;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+
+		spin_lock(&pcp->lock);
+		for (i = 0; i < pcp->count; i++)
+			list_add_tail(&pcp->pages[i]->lru, &pages);
+		nr += pcp->count;
+		pcp->count = 0;
+		spin_unlock(&pcp->lock);
+	}
+
+	if (!nr)
+		return;
+
+	mutex_lock(&pool->mutex);
+	list_splice_tail(&pages, &pool->low_items);
+	pool->low_count += nr;
+	mutex_unlock(&pool->mutex);
+}
+
 #ifdef CONFIG_ION_POOL_AUTO_REFILL
 /* do a simple check to see if we are in any low memory situation */
 static bool pool_refill_ok(struct ion_msm_page_pool *pool)
@@ -91,7 +193,8 @@ void ion_msm_page_pool_refill(struct ion_msm_page_pool *pool)
 	if (!pool->order)
 		return;
 
-	while (!pool_fillmark_reached(pool) && pool_refill_ok(pool)) {
+	while ((!pool_fillmark_reached(pool) || pool_prefill_pending(pool)) &&
+	       pool_refill_ok(pool)) {
 		page = alloc_pages(gfp_refill, pool->order);
 		if (!page)
 			break;
@@ -101,6 +204,39 @@ void ion_msm_page_pool_refill(struct ion_msm_page_pool *pool)
 						  DMA_BIDIRECTIONAL);
 		ion_msm_page_pool_add(pool, page);
 	}
+
+	/* the hint has been met or has gone stale, either way it's done */
+	if (!pool_prefill_pending(pool))
+		atomic_set(&pool->prefill_target, 0);
+}
+
+/**
+ * ion_msm_page_pool_prefill - raise the refill target of a pool
+ * @pool:		the pool
+ * @nr:			number of pages the pool is about to be asked for
+ *
+ * The next refill of @pool keeps going until the pool holds @nr pages on top
+ * of its fill mark, or of what an earlier hint still pending asked for. The
+ * target is dropped once it's reached or after ION_POOL_PREFILL_TIMEOUT_MS.
+ * The caller is responsible for waking up the refill worker.
+ */
+void ion_msm_page_pool_prefill(struct ion_msm_page_pool *pool, int nr)
+{
+	int max = totalram_pages() >> (pool->order + ION_POOL_PREFILL_RAM_SHIFT);
+	int target;
+
+	/* order 0 pools are never refilled */
+	if (!pool->order || nr <= 0)
+		return;
+
+	target = get_pool_fillmark(pool);
+	if (pool_prefill_pending(pool))
+		target = max(target, atomic_read(&pool->prefill_target));
+	target = min(target + nr, max);
+
+	WRITE_ONCE(pool->prefill_expires,
+		   jiffies + msecs_to_jiffies(ION_POOL_PREFILL_TIMEOUT_MS));
+	atomic_set(&pool->prefill_target, target);
 }
 #endif /* CONFIG_ION_PAGE_POOL_REFILL */
 
@@ -136,7 +272,10 @@ struct page *ion_msm_page_pool_alloc(struct ion_msm_page_pool *pool,
 	if (fatal_signal_pending(current))
 		return ERR_PTR(-EINTR);
 
-	if (*from_pool && mutex_trylock(&pool->mutex)) {
+	if (*from_pool)
+		page = ion_msm_page_pool_pcp_get(pool);
+
+	if (*from_pool && !page && mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_msm_page_pool_remove(pool, true);
 		else if (pool->low_count)
@@ -163,6 +302,10 @@ struct page *ion_msm_page_pool_alloc_pool_only(struct ion_msm_page_pool *pool)
 	if (!pool)
 		return ERR_PTR(-EINVAL);
 
+	page = ion_msm_page_pool_pcp_get(pool);
+	if (page)
+		return page;
+
 	if (mutex_trylock(&pool->mutex)) {
 		if (pool->high_count)
 			page = ion_msm_page_pool_remove(pool, true);
@@ -176,9 +319,50 @@ struct page *ion_msm_page_pool_alloc_pool_only(struct ion_msm_page_pool *pool)
 	return page;
 }
 
+/**
+ * ion_msm_page_pool_alloc_bulk - take several pages from a pool at once
+ * @pool:		the pool
+ * @nr:			maximum number of pages to take
+ * @pages:		list the pages are added to, linked through page->lru
+ *
+ * Empties the local CPU cache first and then takes the rest from the pool
+ * lists with a single acquisition of the pool mutex. Like
+ * ion_msm_page_pool_alloc_pool_only() this never falls back to buddy.
+ *
+ * returns the number of pages added to @pages
+ */
+int ion_msm_page_pool_alloc_bulk(struct ion_msm_page_pool *pool, int nr,
+				 struct list_head *pages)
+{
+	struct page *page;
+	int count = 0;
+
+	while (count < nr) {
+		page = ion_msm_page_pool_pcp_get(pool);
+		if (!page)
+			break;
+		list_add_tail(&page->lru, pages);
+		count++;
+	}
+
+	if (count == nr)
+		return count;
+
+	mutex_lock(&pool->mutex);
+	while (count < nr && (pool->high_count || pool->low_count)) {
+		page = ion_msm_page_pool_remove(pool, pool->high_count > 0);
+		list_add_tail(&page->lru, pages);
+		count++;
+	}
+	mutex_unlock(&pool->mutex);
+
+	return count;
+}
+
 void ion_msm_page_pool_free(struct ion_msm_page_pool *pool, struct page *page)
 {
-	ion_msm_page_pool_add(pool, page);
+	if (!ion_msm_page_pool_pcp_put(pool, page))
+		ion_msm_page_pool_add(pool, page);
 }
 
 void ion_msm_page_pool_free_immediate(struct ion_msm_page_pool *pool,
@@ -189,7 +373,11 @@ void ion_msm_page_pool_free_immediate(struct ion_msm_page_pool *pool,
 
 int ion_msm_page_pool_total(struct ion_msm_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	/* whatever isn't on the lists is in the per-CPU caches, all lowmem */
+	int count = atomic_read(&pool->count) - pool->high_count;
+
+	if (count < pool->low_count)
+		count = pool->low_count;
 
 	if (high)
 		count += pool->high_count;
@@ -211,6 +399,8 @@ int ion_msm_page_pool_shrink(struct ion_msm_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_msm_page_pool_total(pool, high);
 
+	ion_msm_page_pool_pcp_drain(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -248,10 +438,28 @@ struct ion_msm_page_pool *ion_msm_page_pool_create(gfp_t gfp_mask,
 	if (cached)
 		pool->cached = true;
 
+	pool->pcp_high = min_t(int, ION_POOL_PCP_MAX,
+			       ION_POOL_PCP_BYTES >> (PAGE_SHIFT + order));
+	if (pool->pcp_high > 1) {
+		struct ion_msm_page_pool_pcp *pcp;
+		int cpu;
+
+		/* the pool works without the caches, just slower */
+		pool->pcp = __alloc_percpu(struct_size(pcp, pages,
+						       pool->pcp_high),
+					   __alignof__(*pcp));
+		if (pool->pcp)
+			for_each_possible_cpu(cpu)
+				spin_lock_init(&per_cpu_ptr(pool->pcp,
+							    cpu)->lock);
+	}
+
 	return pool;
 }
 
 void ion_msm_page_pool_destroy(struct ion_msm_page_pool *pool)
 {
+	ion_msm_page_pool_pcp_drain(pool);
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
@@ -8,6 +8,7 @@
 #ifndef _ION_MSM_PAGE_POOL_H
 #define _ION_MSM_PAGE_POOL_H
 
+#include <linux/jiffies.h>
 #include <linux/mm_types.h>
 #include <linux/mutex.h>
 #include <linux/shrinker.h>
@@ -26,6 +27,17 @@
 /* if low watermark of zones have reached, defer the refill in this window */
 #define ION_POOL_REFILL_DEFER_WINDOW_MS	10
 
+/*
+ * a prefill hint raises the refill target of a pool for this long, and never
+ * past 1/(2^ION_POOL_PREFILL_RAM_SHIFT) of RAM
+ */
+#define ION_POOL_PREFILL_TIMEOUT_MS	2000
+#define ION_POOL_PREFILL_RAM_SHIFT	4
+
+/* per-CPU page cache limits, pools of larger orders don't get a cache */
+#define ION_POOL_PCP_BYTES	SZ_128K
+#define ION_POOL_PCP_MAX	32
+
 /**
  * functions for creating and destroying a heap pool -- allows you
  * to keep a pool of pre allocated memory to use from your heap.  Keeping
@@ -34,11 +46,25 @@
  * many systems
  */
 
+/**
+ * struct ion_msm_page_pool_pcp - per-CPU cache of pool pages
+ * @lock:		lock protecting the cache, only contended when the pool
+ *			is being drained
+ * @count:		number of pages in the cache
+ * @pages:		the cached pages, lowmem only
+ */
+struct ion_msm_page_pool_pcp {
+	spinlock_t lock;
+	int count;
+	struct page *pages[];
+};
+
 /**
  * struct ion_msm_page_pool - pagepool struct
  * @high_count:		number of highmem items in the pool
  * @low_count:		number of lowmem items in the pool
- * @count:		total number of pages/items in the pool
+ * @count:		total number of pages/items in the pool, including
+ *			the ones held in the per-CPU caches
  * @high_items:		list of highmem items
  * @low_items:		list of lowmem items
  * @last_low_watermark_ktime: most recent time at which the zone watermarks were
@@ -50,6 +76,12 @@
  * @list:		plist node for list of pools
  * @cached:		it's cached pool or not
  * @heap_dev:		device for the ion heap associated with this pool
+ * @pcp:		per-CPU caches that free and alloc go through before
+ *			taking @mutex, NULL if the pool doesn't have them
+ * @pcp_high:		number of pages each per-CPU cache can hold
+ * @prefill_target:	number of pages a prefill hint asked the pool to be
+ *			refilled to, 0 if no hint is pending
+ * @prefill_expires:	jiffies after which @prefill_target is ignored
  *
  * Allows you to keep a pool of pre allocated pages to use from your heap.
  * Keeping a pool of pages that is ready for dma, ie any cached mapping have
@@ -69,6 +101,10 @@ struct ion_msm_page_pool {
 	struct plist_node list;
 	bool cached;
 	struct device *heap_dev;
+	struct ion_msm_page_pool_pcp __percpu *pcp;
+	int pcp_high;
+	atomic_t prefill_target;
+	unsigned long prefill_expires;
 };
 
 struct ion_msm_page_pool *ion_msm_page_pool_create(gfp_t gfp_mask,
@@ -79,6 +115,8 @@ struct page *ion_msm_page_pool_alloc(struct ion_msm_page_pool *pool,
 				     bool *from_pool);
 void ion_msm_page_pool_free(struct ion_msm_page_pool *pool, struct page *page);
 struct page *ion_msm_page_pool_alloc_pool_only(struct ion_msm_page_pool *a);
+int ion_msm_page_pool_alloc_bulk(struct ion_msm_page_pool *pool, int nr,
+				 struct list_head *pages);
 void ion_msm_page_pool_free_immediate(struct ion_msm_page_pool *pool,
 				      struct page *page);
 int ion_msm_page_pool_total(struct ion_msm_page_pool *pool, bool high);
@@ -96,6 +134,7 @@ int ion_msm_page_pool_shrink(struct ion_msm_page_pool *pool, gfp_t gfp_mask,
 
 #ifdef CONFIG_ION_POOL_AUTO_REFILL
 void ion_msm_page_pool_refill(struct ion_msm_page_pool *pool);
+void ion_msm_page_pool_prefill(struct ion_msm_page_pool *pool, int nr);
 
 static __always_inline int get_pool_fillmark(struct ion_msm_page_pool *pool)
 {
@@ -118,11 +157,25 @@ pool_fillmark_reached(struct ion_msm_page_pool *pool)
 {
 	return atomic_read(&pool->count) >= get_pool_fillmark(pool);
 }
+
+static __always_inline bool
+pool_prefill_pending(struct ion_msm_page_pool *pool)
+{
+	int target = atomic_read(&pool->prefill_target);
+
+	return target && atomic_read(&pool->count) < target &&
+	       time_before(jiffies, READ_ONCE(pool->prefill_expires));
+}
 #else
 static inline void ion_msm_page_pool_refill(struct ion_msm_page_pool *pool)
 {
 }
 
+static inline void ion_msm_page_pool_prefill(struct ion_msm_page_pool *pool,
+					     int nr)
+{
+}
+
 static __always_inline int get_pool_fillmark(struct ion_msm_page_pool *pool)
 {
 	return 0;
@@ -144,5 +197,11 @@ pool_fillmark_reached(struct ion_msm_page_pool *pool)
 {
 	return false;
 }
+
+static __always_inline bool
+pool_prefill_pending(struct ion_msm_page_pool *pool)
+{
+	return false;
+}
 #endif /* CONFIG_ION_POOL_AUTO_REFILL */
 #endif /* _ION_MSM_PAGE_POOL_H */
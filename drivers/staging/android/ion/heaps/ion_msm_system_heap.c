@@ -14,6 +14,7 @@
 #include <linux/ion.h>
 #include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/page_reservoir.h>
 #include <linux/scatterlist.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
@@ -113,7 +114,24 @@ static struct page *alloc_buffer_page(struct ion_msm_system_heap *sys_heap,
 	}
 
 normal_alloc:
-	page = ion_msm_page_pool_alloc(pool, from_pool);
+	page = ERR_PTR(-ENOMEM);
+
+	/*
+	 * Reservoir pages are zeroed and clean just like pool pages, so
+	 * take one before going to buddy. Secure pools are excluded, a
+	 * page counted as from_pool there is assumed to be hyp-assigned.
+	 */
+	if (*from_pool && vmid <= 0) {
+		page = ion_msm_page_pool_alloc_pool_only(pool);
+		if (IS_ERR(page)) {
+			page = page_reservoir_alloc(order, pool->gfp_mask);
+			if (!page)
+				page = ERR_PTR(-ENOMEM);
+		}
+	}
+
+	if (IS_ERR(page))
+		page = ion_msm_page_pool_alloc(pool, from_pool);
 
 	if (pool_auto_refill_en && pool->order &&
 	    pool_count_below_lowmark(pool) && vmid <= 0)
@@ -170,6 +188,70 @@ void free_buffer_page(struct ion_msm_system_heap *heap,
 	}
 }
 
+/*
+ * Take as much of the buffer as the pools can cover up front, one batch per
+ * order, so a large allocation doesn't go through the pool lock page by
+ * page. Whatever is left is allocated by alloc_largest_available().
+ * Returns the number of entries added to @list.
+ */
+static int alloc_bulk_from_pools(struct ion_msm_system_heap *heap,
+				 struct ion_buffer *buffer,
+				 unsigned long *size_remaining,
+				 struct list_head *list)
+{
+	bool cached = ion_buffer_cached(buffer);
+	struct device *dev = heap->heap.dev;
+	struct ion_msm_page_pool *pool;
+	struct page *page, *tmp;
+	struct page_info *info;
+	LIST_HEAD(pages);
+	int i, nr = 0;
+
+	for (i = 0; i < NUM_ORDERS; i++) {
+		unsigned long want = *size_remaining / order_to_size(orders[i]);
+
+		if (!want)
+			continue;
+
+		pool = cached ? heap->cached_pools[i] : heap->uncached_pools[i];
+		if (!ion_msm_page_pool_alloc_bulk(pool, want, &pages))
+			continue;
+
+		list_for_each_entry_safe(page, tmp, &pages, lru) {
+			list_del(&page->lru);
+
+			info = kmalloc(sizeof(*info), GFP_KERNEL);
+			if (!info) {
+				ion_msm_page_pool_free(pool, page);
+				continue;
+			}
+
+			if (MAKE_ION_ALLOC_DMA_READY)
+				ion_pages_sync_for_device(dev, page,
+							  order_to_size(orders[i]),
+							  DMA_BIDIRECTIONAL);
+
+#ifdef CONFIG_MM_STAT_UNRECLAIMABLE_PAGES
+			mod_node_page_state(page_pgdat(page),
+					    NR_UNRECLAIMABLE_PAGES,
+					    (1 << orders[i]));
+#endif
+			info->page = page;
+			info->order = orders[i];
+			info->from_pool = true;
+			list_add_tail(&info->list, list);
+			*size_remaining -= order_to_size(orders[i]);
+			nr++;
+		}
+
+		if (pool_auto_refill_en && pool->order &&
+		    pool_count_below_lowmark(pool))
+			wake_up_process(heap->kworker[cached]);
+	}
+
+	return nr;
+}
+
 static struct
 page_info *alloc_largest_available(struct ion_msm_system_heap *heap,
 				   struct ion_buffer *buffer,
@@ -361,6 +443,10 @@ static int ion_msm_system_heap_allocate(struct ion_heap *heap,
 	INIT_LIST_HEAD(&pages);
 	INIT_LIST_HEAD(&pages_from_pool);
 
+	if (vmid <= 0 && !(buffer->flags & ION_FLAG_POOL_FORCE_ALLOC))
+		i = alloc_bulk_from_pools(sys_heap, buffer, &size_remaining,
+					  &pages_from_pool);
+
 	while (size_remaining > 0) {
 		if (is_secure_vmid_valid(vmid))
 			info = alloc_from_pool_preferred(sys_heap, buffer,
@@ -723,7 +809,58 @@ static int ion_msm_system_heap_debug_show(struct ion_heap *heap,
 	return 0;
 }
 
+static int ion_msm_system_heap_prefill(struct ion_heap *heap,
+				       struct ion_prefill_hint *hints,
+				       int nr_hints)
+{
+	struct ion_msm_system_heap *sys_heap = to_msm_system_heap(heap);
+	int nr_pages[2][NUM_ORDERS] = { { 0 } };
+	int i, j, cached;
+
+	if (!pool_auto_refill_en)
+		return -EOPNOTSUPP;
+
+	if (!hints || nr_hints <= 0)
+		return -EINVAL;
+
+	/*
+	 * Split each buffer the way ion_msm_system_heap_allocate() would
+	 * when nothing stands in its way: largest orders first. Whatever is
+	 * left over for order 0 is not worth a refill.
+	 */
+	for (i = 0; i < nr_hints; i++) {
+		u64 remaining = PAGE_ALIGN(hints[i].size);
+
+		cached = !!hints[i].cached;
+		for (j = 0; j < NUM_ORDERS && orders[j]; j++) {
+			u64 n = div_u64(remaining, order_to_size(orders[j]));
+
+			nr_pages[cached][j] += min_t(u64, n * hints[i].count,
+						     INT_MAX);
+			remaining -= n * order_to_size(orders[j]);
+		}
+	}
+
+	for (cached = 0; cached < 2; cached++) {
+		struct ion_msm_page_pool **pools = cached ?
+			sys_heap->cached_pools : sys_heap->uncached_pools;
+		bool wake = false;
+
+		for (j = 0; j < NUM_ORDERS; j++) {
+			if (!nr_pages[cached][j])
+				continue;
+			ion_msm_page_pool_prefill(pools[j], nr_pages[cached][j]);
+			wake |= pool_prefill_pending(pools[j]);
+		}
+		if (wake)
+			wake_up_process(sys_heap->kworker[cached]);
+	}
+
+	return 0;
+}
+
 static struct msm_ion_heap_ops msm_system_heap_ops = {
+	.heap_prefill = ion_msm_system_heap_prefill,
 	.debug_show = ion_msm_system_heap_debug_show,
 };
 
@@ -780,7 +917,8 @@ static int ion_msm_sys_heap_worker(void *data)
 
 	for (;;) {
 		for (i = 0; i < NUM_ORDERS; i++) {
-			if (pool_count_below_lowmark(pools[i]))
+			if (pool_count_below_lowmark(pools[i]) ||
+			    pool_prefill_pending(pools[i]))
 				ion_msm_page_pool_refill(pools[i]);
 		}
 		set_current_state(TASK_INTERRUPTIBLE);
@@ -297,6 +297,35 @@ int msm_ion_heap_drain(int heap_id, struct ion_prefetch_region *regions,
 }
 EXPORT_SYMBOL(msm_ion_heap_drain);
 
+/**
+ * msm_ion_heap_prefill - announce buffers that are about to be allocated
+ * @heap_id: heap the buffers will be allocated from
+ * @hints: sizes and counts of the expected buffers
+ * @nr_hints: number of entries in @hints
+ *
+ * Lets a client such as a camera or video session tell the heap what it is
+ * going to allocate so the heap can fill its pools in the background
+ * beforehand. This is only a hint; nothing is reserved for the caller.
+ */
+int msm_ion_heap_prefill(int heap_id, struct ion_prefill_hint *hints,
+			 int nr_hints)
+{
+	struct ion_heap *heap = ion_heap_by_id(heap_id);
+	struct msm_ion_heap *msm_heap;
+
+	if (IS_ERR(heap))
+		return PTR_ERR(heap);
+
+	msm_heap = to_msm_ion_heap(heap);
+
+	if (msm_heap->msm_heap_ops && msm_heap->msm_heap_ops->heap_prefill)
+		return msm_heap->msm_heap_ops->heap_prefill(heap, hints,
+							    nr_hints);
+
+	return -ENOTSUPP;
+}
+EXPORT_SYMBOL(msm_ion_heap_prefill);
+
 int msm_ion_heap_add_memory(int heap_id, struct sg_table *sgt)
 {
 	struct ion_heap *heap = ion_heap_by_id(heap_id);
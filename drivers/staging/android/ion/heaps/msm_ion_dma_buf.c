@@ -564,6 +564,9 @@ static int msm_ion_dma_buf_begin_cpu_access(struct dma_buf *dmabuf,
 		goto out;
 	}
 
+	/* pick up invalidates the lazy mappings deferred at unmap time */
+	msm_dma_buf_sync_for_cpu(dmabuf);
+
 
 	if (IS_ENABLED(CONFIG_ION_FORCE_DMA_SYNC)) {
 		struct device *dev = msm_ion_heap_device(buffer->heap);
@@ -677,6 +680,9 @@ static int msm_ion_dma_buf_begin_cpu_access_partial(struct dma_buf *dmabuf,
 		goto out;
 	}
 
+	/* pick up invalidates the lazy mappings deferred at unmap time */
+	msm_dma_buf_sync_for_cpu(dmabuf);
+
 	if (IS_ENABLED(CONFIG_ION_FORCE_DMA_SYNC)) {
 		struct device *dev = msm_ion_heap_device(buffer->heap);
 		struct sg_table *table = buffer->sg_table;
@@ -91,6 +91,9 @@ struct ion_platform_heap {
  * @heap_drain:		called to asynchronously drain a certain amount of
  *			memory that was prefetched for the heap at an earlier
  *			point in time.
+ * @heap_prefill:	called to hint that buffers of the given sizes are
+ *			about to be allocated, so the heap can fill its page
+ *			pools in the background.
  * @add_memory:		called to add memory to an ION heap. Subsequent
  *			allocations may be satisfied utilizing newly added
  *			memory.
@@ -106,6 +109,9 @@ struct msm_ion_heap_ops {
 	int (*heap_drain)(struct ion_heap *heap,
 			  struct ion_prefetch_region *regions,
 			  int nr_regions);
+	int (*heap_prefill)(struct ion_heap *heap,
+			    struct ion_prefill_hint *hints,
+			    int nr_hints);
 	int (*add_memory)(struct ion_heap *heap, struct sg_table *sgt);
 	int (*remove_memory)(struct ion_heap *heap, struct sg_table *sgt);
 	int (*debug_show)(struct ion_heap *heap, struct seq_file *s,
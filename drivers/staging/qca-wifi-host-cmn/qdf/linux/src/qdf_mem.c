@@ -34,6 +34,7 @@
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
 #include <linux/string.h>
+#include <linux/ktime.h>
 #include <qdf_list.h>
 
 #if IS_ENABLED(CONFIG_WCNSS_MEM_PRE_ALLOC)
@@ -1264,6 +1265,18 @@ static inline bool qdf_mem_prealloc_put(void *ptr)
 {
 	return wcnss_prealloc_put(ptr);
 }
+
+/**
+ * qdf_mem_prealloc_fallback() - report a pre-allocation miss served by kmalloc
+ * @size: the number of bytes allocated
+ * @start_ns: ktime_get_ns() before the allocation
+ *
+ * Return: None
+ */
+static inline void qdf_mem_prealloc_fallback(size_t size, u64 start_ns)
+{
+	wcnss_prealloc_fallback_done(size, ktime_get_ns() - start_ns);
+}
 #else
 static inline void *qdf_mem_prealloc_get(size_t size)
 {
@@ -1274,6 +1287,10 @@ static inline bool qdf_mem_prealloc_put(void *ptr)
 {
 	return false;
 }
+
+static inline void qdf_mem_prealloc_fallback(size_t size, u64 start_ns)
+{
+}
 #endif /* CONFIG_WCNSS_MEM_PRE_ALLOC */
 
 static int qdf_mem_malloc_flags(void)
@@ -1402,6 +1419,7 @@ void *qdf_mem_malloc_debug(size_t size, const char *func, uint32_t line,
 	struct qdf_mem_header *header;
 	void *ptr;
 	unsigned long start, duration;
+	u64 start_ns;
 
 	if (is_initial_mem_debug_disabled)
 		return __qdf_mem_malloc(size, func, line);
@@ -1418,9 +1436,11 @@ void *qdf_mem_malloc_debug(size_t size, const char *func, uint32_t line,
 	if (!flag)
 		flag = qdf_mem_malloc_flags();
 
+	start_ns = ktime_get_ns();
 	start = qdf_mc_timer_get_system_time();
 	header = kzalloc(size + QDF_MEM_DEBUG_SIZE, flag);
 	duration = qdf_mc_timer_get_system_time() - start;
+	qdf_mem_prealloc_fallback(size, start_ns);
 
 	if (duration > QDF_MEM_WARN_THRESHOLD)
 		qdf_warn("Malloc slept; %lums, %zuB @ %s:%d",
@@ -1891,6 +1911,7 @@ qdf_export_symbol(__qdf_mem_free);
 void *__qdf_mem_malloc(size_t size, const char *func, uint32_t line)
 {
 	void *ptr;
+	u64 start_ns;
 
 	if (!size || size > QDF_MEM_MAX_MALLOC) {
 		qdf_nofl_err("Cannot malloc %zu bytes @ %s:%d", size, func,
@@ -1902,7 +1923,9 @@ void *__qdf_mem_malloc(size_t size, const char *func, uint32_t line)
 	if (ptr)
 		return ptr;
 
+	start_ns = ktime_get_ns();
 	ptr = kzalloc(size, qdf_mem_malloc_flags());
+	qdf_mem_prealloc_fallback(size, start_ns);
 	if (!ptr)
 		return NULL;
 
@@ -0,0 +1,436 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * gov_frame_pacing.c - Coordinated skin temperature governor
+ *
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Throttling Logic: A single throttle level, in percent, is driven from the
+ * skin temperature of the zone and spread over every cooling device bound
+ * to the control trip, instead of each device backing off on its own. The
+ * GPU busy ratio reported by kgsl and the frame rate retired by SDE decide
+ * which of CPU or GPU gives up more of the level, so the device that the
+ * frame is not waiting on is throttled first. Display brightness is only
+ * touched at high levels. While the zone is hot, a frame rate cap equal to
+ * the user target is published so that the compositor can drop refresh
+ * rate ahead of time rather than have the frame rate collapse later.
+ */
+
+#define pr_fmt(fmt) "frame_pacing: " fmt
+
+#include <linux/kobject.h>
+#include <linux/math64.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/string.h>
+#include <linux/sysfs.h>
+#include <linux/thermal.h>
+#include <linux/thermal_frame.h>
+
+#include "thermal_core.h"
+
+#define INVALID_TRIP			-1
+
+#define FP_LEVEL_MAX			100
+#define FP_DEADBAND_MC			500
+#define FP_MC_PER_LEVEL			250
+#define FP_LEVEL_STEP_MAX		5
+#define FP_CAP_HYST_MC			2000
+#define FP_DISPLAY_LEVEL		60
+#define FP_GPU_BOUND_PCT		85
+#define FP_CPU_BOUND_PCT		50
+#define FP_FRAME_WINDOW_NS		NSEC_PER_SEC
+#define FP_FRAME_STALE_NS		(2 * NSEC_PER_SEC)
+
+enum fp_role {
+	FP_ROLE_CPU,
+	FP_ROLE_GPU,
+	FP_ROLE_DISPLAY,
+	FP_ROLE_OTHER,
+	FP_ROLE_MAX,
+};
+
+enum fp_bound {
+	FP_BOUND_NONE,
+	FP_BOUND_GPU,
+	FP_BOUND_CPU,
+	FP_BOUND_MAX,
+};
+
+/*
+ * Percentage of the throttle level applied to each role, depending on
+ * which device the frame is waiting on.
+ */
+static const unsigned int fp_share[FP_BOUND_MAX][FP_ROLE_MAX] = {
+	[FP_BOUND_NONE] = { 100, 100, 100, 100 },
+	[FP_BOUND_GPU] = { 150, 60, 100, 100 },
+	[FP_BOUND_CPU] = { 60, 150, 100, 100 },
+};
+
+/**
+ * struct frame_pacing_params - parameters of the frame pacing governor
+ * @trip_switch_on:	first passive trip point, the governor starts
+ *			throttling above it. INVALID_TRIP if the zone has a
+ *			single passive trip point.
+ * @trip_control:	last passive trip point, the skin limit
+ * @level:		current throttle level, 0 to FP_LEVEL_MAX
+ */
+struct frame_pacing_params {
+	int trip_switch_on;
+	int trip_control;
+	int level;
+};
+
+/**
+ * struct frame_telemetry - frame rate and GPU load seen by the governor
+ * @lock:		protects this structure
+ * @window_start:	start of the current frame counting window
+ * @last_frame:		time of the last retired frame
+ * @frames:		frames retired in the current window
+ * @fps:		frame rate over the last complete window
+ * @gpu_busy:		GPU busy percentage over the last devfreq sample
+ * @target_fps:		frame rate the user wants held, 0 for none
+ * @fps_cap:		frame rate cap published to the compositor, 0 for none
+ * @kobj:		/sys/kernel/thermal_frame
+ */
+static struct frame_telemetry {
+	spinlock_t lock;
+	ktime_t window_start;
+	ktime_t last_frame;
+	u32 frames;
+	u32 fps;
+	u32 gpu_busy;
+	u32 target_fps;
+	u32 fps_cap;
+	struct kobject *kobj;
+} telemetry = {
+	.lock = __SPIN_LOCK_UNLOCKED(telemetry.lock),
+};
+
+/**
+ * thermal_frame_retired() - account a frame retired by the display
+ * @ts:	time the frame was retired
+ *
+ * May be called from atomic context.
+ */
+void thermal_frame_retired(ktime_t ts)
+{
+	unsigned long flags;
+	s64 delta;
+
+	spin_lock_irqsave(&telemetry.lock, flags);
+	delta = ktime_to_ns(ktime_sub(ts, telemetry.window_start));
+	if (delta >= FP_FRAME_STALE_NS || delta < 0) {
+		telemetry.window_start = ts;
+		telemetry.frames = 0;
+	} else if (delta >= FP_FRAME_WINDOW_NS) {
+		telemetry.fps = div64_s64((s64)telemetry.frames * NSEC_PER_SEC,
+					  delta);
+		telemetry.window_start = ts;
+		telemetry.frames = 0;
+	}
+	telemetry.frames++;
+	telemetry.last_frame = ts;
+	spin_unlock_irqrestore(&telemetry.lock, flags);
+}
+EXPORT_SYMBOL(thermal_frame_retired);
+
+/**
+ * thermal_frame_gpu_busy() - account a GPU load sample
+ * @busy_us:	time the GPU was busy during the sample
+ * @total_us:	length of the sample
+ */
+void thermal_frame_gpu_busy(u64 busy_us, u64 total_us)
+{
+	unsigned long flags;
+
+	if (!total_us)
+		return;
+
+	spin_lock_irqsave(&telemetry.lock, flags);
+	telemetry.gpu_busy = div64_u64(min(busy_us, total_us) * 100, total_us);
+	spin_unlock_irqrestore(&telemetry.lock, flags);
+}
+EXPORT_SYMBOL(thermal_frame_gpu_busy);
+
+static enum fp_bound get_frame_bound(u32 *fps, u32 *target_fps)
+{
+	enum fp_bound bound = FP_BOUND_NONE;
+	unsigned long flags;
+	s64 since_frame;
+
+	spin_lock_irqsave(&telemetry.lock, flags);
+	since_frame = ktime_to_ns(ktime_sub(ktime_get(), telemetry.last_frame));
+	*fps = since_frame < FP_FRAME_STALE_NS ? telemetry.fps : 0;
+	*target_fps = telemetry.target_fps;
+
+	if (telemetry.gpu_busy >= FP_GPU_BOUND_PCT)
+		bound = FP_BOUND_GPU;
+	else if (*fps && *fps < *target_fps &&
+		 telemetry.gpu_busy <= FP_CPU_BOUND_PCT)
+		bound = FP_BOUND_CPU;
+	spin_unlock_irqrestore(&telemetry.lock, flags);
+
+	return bound;
+}
+
+static void set_fps_cap(u32 fps_cap)
+{
+	unsigned long flags;
+	bool changed;
+
+	spin_lock_irqsave(&telemetry.lock, flags);
+	changed = telemetry.fps_cap != fps_cap;
+	telemetry.fps_cap = fps_cap;
+	spin_unlock_irqrestore(&telemetry.lock, flags);
+
+	if (changed && telemetry.kobj)
+		sysfs_notify(telemetry.kobj, NULL, "fps_cap");
+}
+
+static enum fp_role get_cdev_role(struct thermal_cooling_device *cdev)
+{
+	if (strnstr(cdev->type, "gpu", THERMAL_NAME_LENGTH))
+		return FP_ROLE_GPU;
+	if (strnstr(cdev->type, "cpu", THERMAL_NAME_LENGTH))
+		return FP_ROLE_CPU;
+	if (strnstr(cdev->type, "backlight", THERMAL_NAME_LENGTH))
+		return FP_ROLE_DISPLAY;
+
+	return FP_ROLE_OTHER;
+}
+
+static unsigned int get_role_pct(enum fp_role role, enum fp_bound bound,
+				 int level)
+{
+	unsigned int pct;
+
+	if (role == FP_ROLE_DISPLAY) {
+		if (level <= FP_DISPLAY_LEVEL)
+			return 0;
+		return (level - FP_DISPLAY_LEVEL) * 100 /
+			(FP_LEVEL_MAX - FP_DISPLAY_LEVEL);
+	}
+
+	pct = level * fp_share[bound][role] / 100;
+
+	return min_t(unsigned int, pct, 100);
+}
+
+static void apply_level(struct thermal_zone_device *tz, enum fp_bound bound)
+{
+	struct frame_pacing_params *params = tz->governor_data;
+	struct thermal_instance *instance;
+	unsigned long target;
+	unsigned int pct;
+
+	mutex_lock(&tz->lock);
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node) {
+		if (instance->trip != params->trip_control)
+			continue;
+
+		pct = get_role_pct(get_cdev_role(instance->cdev), bound,
+				   params->level);
+		if (pct)
+			target = instance->lower +
+				DIV_ROUND_UP((instance->upper - instance->lower) *
+					     pct, 100);
+		else
+			target = THERMAL_NO_TARGET;
+
+		if (instance->initialized && instance->target == target)
+			continue;
+
+		instance->target = target;
+		instance->initialized = true;
+		mutex_lock(&instance->cdev->lock);
+		instance->cdev->updated = false;
+		mutex_unlock(&instance->cdev->lock);
+		thermal_cdev_update(instance->cdev);
+	}
+	mutex_unlock(&tz->lock);
+}
+
+static void get_governor_trips(struct thermal_zone_device *tz,
+			       struct frame_pacing_params *params)
+{
+	enum thermal_trip_type type;
+	int i;
+
+	params->trip_switch_on = INVALID_TRIP;
+	params->trip_control = INVALID_TRIP;
+
+	for (i = 0; i < tz->trips; i++) {
+		if (tz->ops->get_trip_type(tz, i, &type) ||
+		    type != THERMAL_TRIP_PASSIVE)
+			continue;
+
+		if (params->trip_control == INVALID_TRIP) {
+			params->trip_control = i;
+		} else {
+			if (params->trip_switch_on == INVALID_TRIP)
+				params->trip_switch_on = params->trip_control;
+			params->trip_control = i;
+		}
+	}
+}
+
+static int frame_pacing_bind(struct thermal_zone_device *tz)
+{
+	struct frame_pacing_params *params;
+
+	params = kzalloc(sizeof(*params), GFP_KERNEL);
+	if (!params)
+		return -ENOMEM;
+
+	get_governor_trips(tz, params);
+	if (params->trip_control == INVALID_TRIP)
+		dev_warn(&tz->device, "frame_pacing: no passive trip point\n");
+
+	tz->governor_data = params;
+
+	return 0;
+}
+
+static void frame_pacing_unbind(struct thermal_zone_device *tz)
+{
+	kfree(tz->governor_data);
+	tz->governor_data = NULL;
+}
+
+static int frame_pacing_throttle(struct thermal_zone_device *tz, int trip)
+{
+	struct frame_pacing_params *params = tz->governor_data;
+	int switch_on_temp, control_temp, err, step;
+	u32 fps, target_fps;
+	enum fp_bound bound;
+
+	/* We get called for every trip point but only act once */
+	if (trip != params->trip_control)
+		return 0;
+
+	if (tz->ops->get_trip_temp(tz, params->trip_control, &control_temp))
+		return -EINVAL;
+
+	if (params->trip_switch_on == INVALID_TRIP ||
+	    tz->ops->get_trip_temp(tz, params->trip_switch_on,
+				   &switch_on_temp))
+		switch_on_temp = control_temp;
+
+	bound = get_frame_bound(&fps, &target_fps);
+
+	if (tz->temperature >= switch_on_temp)
+		set_fps_cap(target_fps);
+	else if (tz->temperature < switch_on_temp - FP_CAP_HYST_MC)
+		set_fps_cap(0);
+
+	err = tz->temperature - control_temp;
+	if (err > FP_DEADBAND_MC) {
+		step = min(err / FP_MC_PER_LEVEL, FP_LEVEL_STEP_MAX);
+	} else if (tz->temperature < switch_on_temp) {
+		step = -FP_LEVEL_STEP_MAX;
+	} else if (err < -FP_DEADBAND_MC) {
+		/* Give back faster while the frame rate misses the target */
+		step = (fps && fps < target_fps) ? -2 : -1;
+	} else {
+		step = 0;
+	}
+
+	params->level = clamp(params->level + step, 0, FP_LEVEL_MAX);
+	tz->passive = params->level ? 1 : 0;
+
+	dev_dbg(&tz->device, "temp=%d control=%d level=%d fps=%u/%u bound=%d\n",
+		tz->temperature, control_temp, params->level, fps, target_fps,
+		bound);
+
+	apply_level(tz, bound);
+
+	return 0;
+}
+
+static struct thermal_governor thermal_gov_frame_pacing = {
+	.name		= "frame_pacing",
+	.bind_to_tz	= frame_pacing_bind,
+	.unbind_from_tz	= frame_pacing_unbind,
+	.throttle	= frame_pacing_throttle,
+};
+THERMAL_GOVERNOR_DECLARE(thermal_gov_frame_pacing);
+
+static ssize_t target_fps_show(struct kobject *kobj,
+			       struct kobj_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(telemetry.target_fps));
+}
+
+static ssize_t target_fps_store(struct kobject *kobj,
+				struct kobj_attribute *attr, const char *buf,
+				size_t count)
+{
+	u32 target_fps;
+
+	if (kstrtou32(buf, 0, &target_fps))
+		return -EINVAL;
+
+	WRITE_ONCE(telemetry.target_fps, target_fps);
+
+	return count;
+}
+
+static ssize_t fps_show(struct kobject *kobj, struct kobj_attribute *attr,
+			char *buf)
+{
+	u32 fps, target_fps;
+
+	get_frame_bound(&fps, &target_fps);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", fps);
+}
+
+static ssize_t gpu_busy_show(struct kobject *kobj,
+			     struct kobj_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(telemetry.gpu_busy));
+}
+
+static ssize_t fps_cap_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", READ_ONCE(telemetry.fps_cap));
+}
+
+static struct kobj_attribute target_fps_attr = __ATTR_RW(target_fps);
+static struct kobj_attribute fps_attr = __ATTR_RO(fps);
+static struct kobj_attribute gpu_busy_attr = __ATTR_RO(gpu_busy);
+static struct kobj_attribute fps_cap_attr = __ATTR_RO(fps_cap);
+
+static struct attribute *frame_pacing_attrs[] = {
+	&target_fps_attr.attr,
+	&fps_attr.attr,
+	&gpu_busy_attr.attr,
+	&fps_cap_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group frame_pacing_attr_group = {
+	.attrs = frame_pacing_attrs,
+};
+
+static int __init frame_pacing_sysfs_init(void)
+{
+	struct kobject *kobj;
+	int ret;
+
+	kobj = kobject_create_and_add("thermal_frame", kernel_kobj);
+	if (!kobj)
+		return -ENOMEM;
+
+	ret = sysfs_create_group(kobj, &frame_pacing_attr_group);
+	if (ret) {
+		kobject_put(kobj);
+		return ret;
+	}
+
+	telemetry.kobj = kobj;
+
+	return 0;
+}
+late_initcall(frame_pacing_sysfs_init);
@@ -17,12 +17,31 @@
 
 LIST_HEAD(tsens_device_list);
 
+/*
+ * Thermal zones on the same controller are usually polled back to back,
+ * serve them from one register sweep as long as it is fresh enough.
+ */
 static int tsens_get_temp(void *data, int *temp)
 {
 	struct tsens_sensor *s = data;
 	struct tsens_device *tmdev = s->tmdev;
+	struct tsens_snapshot *snap = &tmdev->snap;
+	int rc = 0;
+
+	if (!snap->ttl_ns || !(snap->mask & BIT(s->hw_id)))
+		return tmdev->ops->get_temp(s, temp);
 
-	return tmdev->ops->get_temp(s, temp);
+	mutex_lock(&snap->lock);
+	if (ktime_to_ns(ktime_sub(ktime_get(), snap->stamp)) >= snap->ttl_ns) {
+		rc = tmdev->ops->get_all_temps(tmdev, snap->mask, snap->temp);
+		if (!rc)
+			snap->stamp = ktime_get();
+	}
+	if (!rc)
+		*temp = snap->temp[s->hw_id];
+	mutex_unlock(&snap->lock);
+
+	return rc;
 }
 
 static int tsens_get_zeroc_status(void *data, int *status)
@@ -119,7 +138,7 @@ static int get_device_tree_data(struct platform_device *pdev,
 	const struct tsens_data *data;
 	int rc = 0;
 	struct resource *res_tsens_mem;
-	u32 zeroc_id;
+	u32 zeroc_id, cache_ms;
 
 	if (!of_match_node(tsens_table, of_node)) {
 		pr_err("Need to read SoC specific fuse map\n");
@@ -202,6 +221,11 @@ static int get_device_tree_data(struct platform_device *pdev,
 
 	tmdev->tsens_reinit_wa =
 		of_property_read_bool(of_node, "tsens-reinit-wa");
+
+	mutex_init(&tmdev->snap.lock);
+	if (tmdev->ops->get_all_temps &&
+	    !of_property_read_u32(of_node, "tsens-temp-cache-ms", &cache_ms))
+		tmdev->snap.ttl_ns = (u64)cache_ms * NSEC_PER_MSEC;
 	return rc;
 }
 
@@ -222,6 +246,7 @@ static int tsens_thermal_zone_register(struct tsens_device *tmdev)
 				sensor_missing++;
 				continue;
 			}
+			tmdev->snap.mask |= BIT(i);
 		} else {
 			pr_debug("Sensor not enabled:%d\n", i);
 		}
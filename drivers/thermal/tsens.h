@@ -13,6 +13,8 @@
 #include <linux/workqueue.h>
 #include <linux/io.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
 #include <linux/ipc_logging.h>
 
 #define DEBUG_SIZE					10
@@ -150,10 +152,14 @@ struct tsens_sensor {
  * struct tsens_ops - operations as supported by the tsens device
  * @init: Function to initialize the tsens device
  * @get_temp: Function which returns the temp in millidegC
+ * @get_all_temps: Reads all sensors in a mask in one register sweep,
+ * temps are indexed by hw_id
  */
 struct tsens_ops {
 	int (*hw_init)(struct tsens_device *tmdev);
 	int (*get_temp)(struct tsens_sensor *tm_sensor, int *temp);
+	int (*get_all_temps)(struct tsens_device *tmdev, unsigned long mask,
+							int *temps);
 	int (*set_trips)(struct tsens_sensor *tm_sensor, int low, int high);
 	int (*interrupts_reg)(struct tsens_device *tmdev);
 	int (*dbg)(struct tsens_device *tmdev, u32 id, u32 dbg_type,
@@ -196,6 +202,22 @@ struct tsens_mtc_sysfs {
 	u32			zone_hist;
 };
 
+/**
+ * struct tsens_snapshot - temperatures of all sensors from one sweep
+ * @lock: serializes sweeps against readers
+ * @temp: last temperature of each sensor in millidegC, indexed by hw_id
+ * @mask: sensors enabled on the controller
+ * @stamp: time of the sweep that filled @temp
+ * @ttl_ns: how long thermal zones are served from @temp, 0 to disable
+ */
+struct tsens_snapshot {
+	struct mutex			lock;
+	int				temp[TSENS_MAX_SENSORS];
+	unsigned long			mask;
+	ktime_t				stamp;
+	u64				ttl_ns;
+};
+
 struct tsens_device {
 	struct device			*dev;
 	struct platform_device		*pdev;
@@ -222,6 +244,7 @@ struct tsens_device {
 	struct work_struct		therm_fwk_notify;
 	bool				tsens_reinit_wa;
 	int                             tsens_reinit_cnt;
+	struct tsens_snapshot		snap;
 	struct tsens_sensor             sensor[0];
 };
 
@@ -136,20 +136,21 @@ static int __tsens2xxx_hw_init(struct tsens_device *tmdev)
 	return 0;
 }
 
-static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
+static atomic_t in_tsens_reinit;
+
+/*
+ * Make sure the controller completed its first measurement round before
+ * the status registers are read, re-initializing it through TZ if it
+ * doesn't recover.
+ */
+static int tsens2xxx_wait_trdy(struct tsens_device *tmdev)
 {
-	struct tsens_device *tmdev = NULL, *tmdev_itr;
+	struct tsens_device *tmdev_itr;
 	unsigned int code, ret;
-	void __iomem *sensor_addr, *trdy;
-	int rc = 0, last_temp = 0, last_temp2 = 0, last_temp3 = 0, count = 0;
+	void __iomem *trdy;
+	int rc = 0, count = 0;
 	int tsens_ret;
-	static atomic_t in_tsens_reinit;
-
-	if (!sensor)
-		return -EINVAL;
 
-	tmdev = sensor->tmdev;
-	sensor_addr = TSENS_TM_SN_STATUS(tmdev->tsens_tm_addr);
 	trdy = TSENS_TM_TRDY(tmdev->tsens_tm_addr);
 
 	code = readl_relaxed_no_log(trdy);
@@ -171,7 +172,7 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 			if (code & TSENS_TM_TRDY_FIRST_ROUND_COMPLETE) {
 				TSENS_DUMP(tmdev, "%s",
 					"tsens controller recovered\n");
-				goto sensor_read;
+				goto trdy_done;
 			}
 		} while (++count < TSENS_RECOVERY_LOOP_COUNT);
 
@@ -284,36 +285,44 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 		return -EAGAIN;
 	}
 
-sensor_read:
-
+trdy_done:
 	tmdev->trdy_fail_ctr = 0;
 
+	return 0;
+}
+
+static void tsens2xxx_read_sensor(struct tsens_device *tmdev, u32 hw_id,
+				  int *temp)
+{
+	void __iomem *sensor_addr = TSENS_TM_SN_STATUS(tmdev->tsens_tm_addr);
+	unsigned int code;
+	int last_temp = 0, last_temp2 = 0, last_temp3 = 0;
+
 	code = readl_relaxed_no_log(sensor_addr +
-			(sensor->hw_id << TSENS_STATUS_ADDR_OFFSET));
+			(hw_id << TSENS_STATUS_ADDR_OFFSET));
 	last_temp = code & TSENS_TM_SN_LAST_TEMP_MASK;
 
 	if (code & TSENS_TM_SN_STATUS_VALID_BIT) {
 		msm_tsens_convert_temp(last_temp, temp);
-		goto dbg;
+		return;
 	}
 
 	code = readl_relaxed_no_log(sensor_addr +
-		(sensor->hw_id << TSENS_STATUS_ADDR_OFFSET));
+		(hw_id << TSENS_STATUS_ADDR_OFFSET));
 	last_temp2 = code & TSENS_TM_SN_LAST_TEMP_MASK;
 	if (code & TSENS_TM_SN_STATUS_VALID_BIT) {
 		last_temp = last_temp2;
 		msm_tsens_convert_temp(last_temp, temp);
-		goto dbg;
+		return;
 	}
 
 	code = readl_relaxed_no_log(sensor_addr +
-			(sensor->hw_id <<
-			TSENS_STATUS_ADDR_OFFSET));
+			(hw_id << TSENS_STATUS_ADDR_OFFSET));
 	last_temp3 = code & TSENS_TM_SN_LAST_TEMP_MASK;
 	if (code & TSENS_TM_SN_STATUS_VALID_BIT) {
 		last_temp = last_temp3;
 		msm_tsens_convert_temp(last_temp, temp);
-		goto dbg;
+		return;
 	}
 
 	if (last_temp == last_temp2)
@@ -322,8 +331,23 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 		last_temp = last_temp3;
 
 	msm_tsens_convert_temp(last_temp, temp);
+}
+
+static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
+{
+	struct tsens_device *tmdev;
+	int rc;
+
+	if (!sensor)
+		return -EINVAL;
+
+	tmdev = sensor->tmdev;
+	rc = tsens2xxx_wait_trdy(tmdev);
+	if (rc)
+		return rc;
+
+	tsens2xxx_read_sensor(tmdev, sensor->hw_id, temp);
 
-dbg:
 	if (tmdev->ops->dbg)
 		tmdev->ops->dbg(tmdev, (u32) sensor->hw_id,
 					TSENS_DBG_LOG_TEMP_READS, temp);
@@ -331,6 +355,30 @@ static int tsens2xxx_get_temp(struct tsens_sensor *sensor, int *temp)
 	return 0;
 }
 
+/*
+ * Read every sensor in @mask with a single TRDY check, instead of one
+ * per sensor as separate tsens2xxx_get_temp() calls would do.
+ */
+static int tsens2xxx_get_all_temps(struct tsens_device *tmdev,
+				   unsigned long mask, int *temps)
+{
+	int rc, i;
+
+	rc = tsens2xxx_wait_trdy(tmdev);
+	if (rc)
+		return rc;
+
+	for_each_set_bit(i, &mask, TSENS_MAX_SENSORS) {
+		tsens2xxx_read_sensor(tmdev, i, &temps[i]);
+		if (tmdev->ops->dbg)
+			tmdev->ops->dbg(tmdev, i, TSENS_DBG_LOG_TEMP_READS,
+					&temps[i]);
+	}
+
+	return 0;
+}
+
+
 int tsens_2xxx_get_zeroc_status(struct tsens_sensor *sensor, int *status)
 {
 	struct tsens_device *tmdev = NULL;
@@ -605,11 +653,13 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 {
 	struct tsens_device *tm = data;
 	unsigned int i, status, threshold, temp;
-	unsigned long flags;
+	unsigned long flags, mask = 0;
+	int temps[TSENS_MAX_SENSORS];
 	void __iomem *sensor_status_addr;
 	void __iomem *sensor_int_mask_addr;
 	void __iomem *sensor_upper_lower_addr;
 	u32 addr_offset = 0;
+	int rc;
 
 	sensor_status_addr = TSENS_TM_SN_STATUS(tm->tsens_tm_addr);
 	sensor_int_mask_addr =
@@ -617,18 +667,21 @@ static irqreturn_t tsens_tm_irq_thread(int irq, void *data)
 	sensor_upper_lower_addr =
 		TSENS_TM_SN_UPPER_LOWER_THRESHOLD(tm->tsens_tm_addr);
 
-	for (i = 0; i < TSENS_MAX_SENSORS; i++) {
-		bool upper_thr = false, lower_thr = false;
-		int int_mask, int_mask_val = 0, rc;
+	for (i = 0; i < TSENS_MAX_SENSORS; i++)
+		if (!IS_ERR(tm->sensor[i].tzd))
+			mask |= BIT(i);
 
-		if (IS_ERR(tm->sensor[i].tzd))
-			continue;
+	rc = tsens2xxx_get_all_temps(tm, mask, temps);
+	if (rc) {
+		pr_debug("Error:%d reading temp sensors\n", rc);
+		mask = 0;
+	}
 
-		rc = tsens2xxx_get_temp(&tm->sensor[i], &temp);
-		if (rc) {
-			pr_debug("Error:%d reading temp sensor:%d\n", rc, i);
-			continue;
-		}
+	for_each_set_bit(i, &mask, TSENS_MAX_SENSORS) {
+		bool upper_thr = false, lower_thr = false;
+		int int_mask, int_mask_val = 0;
+
+		temp = temps[i];
 
 		spin_lock_irqsave(&tm->tsens_upp_low_lock, flags);
 		addr_offset = tm->sensor[i].hw_id *
@@ -831,6 +884,7 @@ static int tsens2xxx_register_interrupts(struct tsens_device *tmdev)
 static const struct tsens_ops ops_tsens2xxx = {
 	.hw_init	= tsens2xxx_hw_init,
 	.get_temp	= tsens2xxx_get_temp,
+	.get_all_temps	= tsens2xxx_get_all_temps,
 	.set_trips	= tsens2xxx_set_trip_temp,
 	.interrupts_reg	= tsens2xxx_register_interrupts,
 	.dbg		= tsens2xxx_dbg,
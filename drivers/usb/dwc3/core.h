@@ -713,6 +713,13 @@ struct dwc3_ep_events {
 	unsigned int	total;
 };
 
+struct dwc3_ep_xfer_stats {
+	u64		bytes;
+	unsigned int	requests;
+	unsigned int	sg_requests;
+	unsigned int	sg_entries;
+};
+
 #define DWC3_EP_FLAG_STALLED	BIT(0)
 #define DWC3_EP_FLAG_WEDGED	BIT(1)
 
@@ -753,6 +760,8 @@ struct dwc3_ep_events {
  * @dbg_ep_events: different events counter for endpoint
  * @dbg_ep_events_diff: differential events counter for endpoint
  * @dbg_ep_events_ts: timestamp for previous event counters
+ * @dbg_xfer: completed transfer counters for endpoint
+ * @dbg_xfer_diff: completed transfer counters at @dbg_ep_events_kt
  * @fifo_depth: allocated TXFIFO depth
  */
 struct dwc3_ep {
@@ -815,6 +824,8 @@ struct dwc3_ep {
 	struct dwc3_ep_events	dbg_ep_events;
 	struct dwc3_ep_events	dbg_ep_events_diff;
 	ktime_t			dbg_ep_events_kt;
+	struct dwc3_ep_xfer_stats dbg_xfer;
+	struct dwc3_ep_xfer_stats dbg_xfer_diff;
 	int			fifo_depth;
 };
 
@@ -1163,6 +1174,7 @@ struct dwc3_scratchpad_array {
  * @tx_fifo_size: Available RAM size for TX fifo allocation
  * @last_fifo_depth: total TXFIFO depth of all enabled USB IN/INT endpoints
  * @irq_cnt: total irq count
+ * @xfer_bytes: total bytes completed on device mode endpoints
  * @bh_completion_time: time taken for taklet completion
  * @bh_handled_evt_cnt: no. of events handled by tasklet per interrupt
  * @bh_dbg_index: index for capturing bh_completion_time and bh_handled_evt_cnt
@@ -1393,6 +1405,7 @@ struct dwc3 {
 	/* IRQ timing statistics */
 	int			irq;
 	atomic_t		irq_cnt;
+	u64			xfer_bytes;
 	ktime_t			bh_start_time[MAX_INTR_STATS];
 	unsigned int		bh_completion_time[MAX_INTR_STATS];
 	unsigned int		bh_handled_evt_cnt[MAX_INTR_STATS];
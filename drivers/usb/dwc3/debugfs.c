@@ -1069,6 +1069,8 @@ static ssize_t dwc3_gadget_int_events_store(struct file *file,
 		dep = dwc->eps[i];
 		memset(&dep->dbg_ep_events, 0, sizeof(dep->dbg_ep_events));
 		memset(&dep->dbg_ep_events_diff, 0, sizeof(dep->dbg_ep_events));
+		memset(&dep->dbg_xfer, 0, sizeof(dep->dbg_xfer));
+		memset(&dep->dbg_xfer_diff, 0, sizeof(dep->dbg_xfer));
 		dep->dbg_ep_events_kt = kt;
 	}
 	memset(&dwc->dbg_gadget_events, 0, sizeof(dwc->dbg_gadget_events));
@@ -1085,12 +1087,22 @@ static inline u64 calc_evt_rate(unsigned int c, unsigned int p, s64 dt)
 	return ev_val;
 }
 
+static inline u64 calc_xfer_rate(u64 c, u64 p, s64 dt)
+{
+	if (!dt)
+		return 0;
+
+	return div64_u64((c - p) * MSEC_PER_SEC, (u64)dt * 1024);
+}
+
 static int dwc3_gadget_int_events_show(struct seq_file *s, void *unused)
 {
 	unsigned long   flags;
 	struct dwc3 *dwc = s->private;
 	struct dwc3_gadget_events *dbg_gadget_events;
+	struct dwc3_ep_xfer_stats *xfer;
 	struct dwc3_ep *dep;
+	unsigned int events;
 	int i;
 	ktime_t now;
 	s64 delta_ms;
@@ -1150,8 +1162,26 @@ static int dwc3_gadget_int_events_show(struct seq_file *s, void *unused)
 			ep_event_rate(total, dep->dbg_ep_events,
 				dep->dbg_ep_events_diff, delta_ms));
 
+		xfer = &dep->dbg_xfer;
+		events = dep->dbg_ep_events.xfercomplete +
+			dep->dbg_ep_events.xferinprogress;
+		seq_printf(s, "requests:%u @ %lldHz\n", xfer->requests,
+			ep_event_rate(requests, dep->dbg_xfer,
+				dep->dbg_xfer_diff, delta_ms));
+		seq_printf(s, "bytes:%llu @ %lluKB/s\n", xfer->bytes,
+			calc_xfer_rate(xfer->bytes, dep->dbg_xfer_diff.bytes,
+				delta_ms));
+		seq_printf(s, "sg_requests:%u sg_entries:%u\n",
+			xfer->sg_requests, xfer->sg_entries);
+		seq_printf(s, "bytes/request:%llu requests/event:%u.%02u\n",
+			xfer->requests ?
+				div_u64(xfer->bytes, xfer->requests) : 0,
+			events ? xfer->requests / events : 0,
+			events ? (xfer->requests % events) * 100 / events : 0);
+
 		dep->dbg_ep_events_kt = now;
 		dep->dbg_ep_events_diff = dep->dbg_ep_events;
+		dep->dbg_xfer_diff = dep->dbg_xfer;
 	}
 
 	seq_puts(s, "\n=== dbg_gadget events ==\n");
@@ -37,6 +37,7 @@
 #include <linux/qti_power_supply.h>
 #include <linux/cdev.h>
 #include <linux/completion.h>
+#include <linux/cpufreq.h>
 #include <linux/interconnect.h>
 #include <linux/irq.h>
 #include <linux/extcon.h>
@@ -472,6 +473,31 @@ struct extcon_nb {
 #define PM_QOS_SAMPLE_SEC	2
 #define PM_QOS_THRESHOLD	400
 
+/*
+ * Device mode bus vote levels, lowest first. The top level is the
+ * default_bus_vote from DT.
+ */
+enum dyn_bus_vote_level {
+	DYN_BV_IDLE,
+	DYN_BV_LOW,
+	DYN_BV_HIGH,
+	DYN_BV_LEVELS,
+};
+
+#define DYN_BV_DOWN_SAMPLES	2
+
+static bool dyn_bus_vote = true;
+module_param(dyn_bus_vote, bool, 0644);
+MODULE_PARM_DESC(dyn_bus_vote, "Scale device mode bus vote with throughput");
+
+static unsigned int dyn_bus_vote_low_kbps = 1024;
+module_param(dyn_bus_vote_low_kbps, uint, 0644);
+MODULE_PARM_DESC(dyn_bus_vote_low_kbps, "Throughput in KB/s for the low level");
+
+static unsigned int dyn_bus_vote_high_kbps = 65536;
+module_param(dyn_bus_vote_high_kbps, uint, 0644);
+MODULE_PARM_DESC(dyn_bus_vote_high_kbps, "Throughput in KB/s for the high level");
+
 struct dwc3_msm {
 	struct device *dev;
 	void __iomem *base;
@@ -584,6 +610,14 @@ struct dwc3_msm {
 	bool			dual_port;
 
 	bool			perf_mode;
+
+	enum dyn_bus_vote_level	dyn_bv_level;
+	unsigned int		dyn_bv_down_cnt;
+	u64			xfer_bytes_prev;
+	u32			xfer_kbps;
+	bool			gsi_active;
+	int			irq_cpu;
+	struct cpumask		irq_saved_mask;
 };
 
 #define USB_HSPHY_3P3_VOL_MIN		3050000 /* uV */
@@ -3091,6 +3125,7 @@ static void dwc3_set_ssphy_orientation_flag(struct dwc3_msm *mdwc)
 
 static void msm_dwc3_perf_vote_update(struct dwc3_msm *mdwc,
 						bool perf_mode);
+static void dwc3_msm_irq_boost(struct dwc3_msm *mdwc, bool boost);
 
 static void configure_usb_wakeup_interrupt(struct dwc3_msm *mdwc,
 	struct usb_irq *uirq, unsigned int polarity, bool enable)
@@ -3291,6 +3326,7 @@ static int dwc3_msm_suspend(struct dwc3_msm *mdwc, bool force_power_collapse,
 
 	cancel_delayed_work_sync(&mdwc->perf_vote_work);
 	msm_dwc3_perf_vote_update(mdwc, false);
+	dwc3_msm_irq_boost(mdwc, false);
 
 	if (!mdwc->in_host_mode) {
 		evt = dwc->ev_buf;
@@ -3529,6 +3565,9 @@ static int dwc3_msm_resume(struct dwc3_msm *mdwc)
 		dwc3_msm_update_bus_bw(mdwc, BUS_VOTE_SVS);
 	else
 		dwc3_msm_update_bus_bw(mdwc, mdwc->default_bus_vote);
+	mdwc->dyn_bv_level = DYN_BV_HIGH;
+	mdwc->dyn_bv_down_cnt = 0;
+	mdwc->xfer_bytes_prev = dwc->xfer_bytes;
 
 	/* Vote for TCXO while waking up USB HSPHY */
 	ret = clk_prepare_enable(mdwc->xo_clk);
@@ -4668,20 +4707,35 @@ static ssize_t speed_store(struct device *dev, struct device_attribute *attr,
 }
 static DEVICE_ATTR_RW(speed);
 
+static const char * const dyn_bv_level_strings[] = {
+	[DYN_BV_IDLE]	= "idle",
+	[DYN_BV_LOW]	= "low",
+	[DYN_BV_HIGH]	= "high",
+};
+
 static ssize_t bus_vote_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
 	struct dwc3_msm *mdwc = dev_get_drvdata(dev);
+	int len;
 
 	if (mdwc->override_bus_vote == BUS_VOTE_MIN)
-		return scnprintf(buf, PAGE_SIZE, "%s\n",
+		len = scnprintf(buf, PAGE_SIZE, "%s\n",
 			"Fixed bus vote: min");
 	else if (mdwc->override_bus_vote == BUS_VOTE_MAX)
-		return scnprintf(buf, PAGE_SIZE, "%s\n",
+		len = scnprintf(buf, PAGE_SIZE, "%s\n",
 			"Fixed bus vote: max");
 	else
-		return scnprintf(buf, PAGE_SIZE, "%s\n",
+		len = scnprintf(buf, PAGE_SIZE, "%s\n",
 			"Do not have fixed bus vote");
+
+	len += scnprintf(buf + len, PAGE_SIZE - len,
+			"Dynamic bus vote: %s level:%s throughput:%uKB/s gsi:%d irq_cpu:%d\n",
+			dyn_bus_vote ? "on" : "off",
+			dyn_bv_level_strings[mdwc->dyn_bv_level],
+			mdwc->xfer_kbps, mdwc->gsi_active, mdwc->irq_cpu);
+
+	return len;
 }
 
 static ssize_t bus_vote_store(struct device *dev,
@@ -4702,6 +4756,7 @@ static ssize_t bus_vote_store(struct device *dev,
 	} else if (sysfs_streq(buf, "cancel")) {
 		bv_fixed = false;
 		mdwc->override_bus_vote = BUS_VOTE_NONE;
+		mdwc->dyn_bv_level = DYN_BV_HIGH;
 	} else {
 		dev_err(dev, "min/max/cancel only.\n");
 		return -EINVAL;
@@ -4724,6 +4779,48 @@ static ssize_t bus_vote_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(bus_vote);
 
+/* DEV_IMOD counts in 250ns steps */
+#define DWC3_IMOD_UNIT_NS	250
+
+static void dwc3_msm_set_imod(struct dwc3 *dwc, u32 ns)
+{
+	dwc->imod_interval = min_t(u32, DIV_ROUND_UP(ns, DWC3_IMOD_UNIT_NS),
+				DWC3_DEV_IMOD_INTERVAL_MASK);
+}
+
+static ssize_t imod_interval_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct dwc3_msm *mdwc = dev_get_drvdata(dev);
+	struct dwc3 *dwc = platform_get_drvdata(mdwc->dwc3);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			dwc->imod_interval * DWC3_IMOD_UNIT_NS);
+}
+
+/*
+ * Device mode interrupt moderation interval in ns. Moderation lets the
+ * controller coalesce the completions of back to back TRBs into one
+ * interrupt, which matters for high rate bulk traffic such as f_fs AIO
+ * and GSI. The new value is applied on the next gadget start.
+ */
+static ssize_t imod_interval_store(struct device *dev,
+		struct device_attribute *attr, const char *buf,
+		size_t count)
+{
+	struct dwc3_msm *mdwc = dev_get_drvdata(dev);
+	struct dwc3 *dwc = platform_get_drvdata(mdwc->dwc3);
+	u32 ns;
+
+	if (kstrtou32(buf, 0, &ns))
+		return -EINVAL;
+
+	dwc3_msm_set_imod(dwc, ns);
+
+	return count;
+}
+static DEVICE_ATTR_RW(imod_interval);
+
 #if defined ASUS_ZS673KS_PROJECT
 static ssize_t redriver_eq_show(struct device *dev,
 	struct device_attribute *attr, char *buf)
@@ -5158,6 +5255,8 @@ static int dwc3_msm_probe(struct platform_device *pdev)
 	INIT_WORK(&mdwc->vbus_draw_work, dwc3_msm_vbus_draw_work);
 	INIT_DELAYED_WORK(&mdwc->sm_work, dwc3_otg_sm_work);
 	INIT_DELAYED_WORK(&mdwc->perf_vote_work, msm_dwc3_perf_vote_work);
+	mdwc->dyn_bv_level = DYN_BV_HIGH;
+	mdwc->irq_cpu = -1;
 	INIT_DELAYED_WORK(&mdwc->sdp_check, check_for_sdp_connection);
 #if defined ASUS_ZS673KS_PROJECT
 	redriver_init(mdwc);
@@ -5457,6 +5556,10 @@ static int dwc3_msm_probe(struct platform_device *pdev)
 	if (of_property_read_bool(node, "qcom,disable-dev-mode-pm"))
 		pm_runtime_get_noresume(mdwc->dev);
 
+	if (!of_property_read_u32(node, "qcom,gadget-imod-interval-ns",
+				&val))
+		dwc3_msm_set_imod(dwc, val);
+
 	ret = of_property_read_u32(node, "qcom,pm-qos-latency",
 				&mdwc->pm_qos_latency);
 	if (ret) {
@@ -5582,6 +5685,7 @@ static int dwc3_msm_probe(struct platform_device *pdev)
 #endif
 	device_create_file(&pdev->dev, &dev_attr_speed);
 	device_create_file(&pdev->dev, &dev_attr_bus_vote);
+	device_create_file(&pdev->dev, &dev_attr_imod_interval);
 #if defined ASUS_ZS673KS_PROJECT
 	device_create_file(&pdev->dev, &dev_attr_redriver_eq);
 	device_create_file(&pdev->dev, &dev_attr_redriver_reset);
@@ -5614,6 +5718,7 @@ static int dwc3_msm_remove(struct platform_device *pdev)
 	device_remove_file(&pdev->dev, &dev_attr_mode);
 	device_remove_file(&pdev->dev, &dev_attr_speed);
 	device_remove_file(&pdev->dev, &dev_attr_bus_vote);
+	device_remove_file(&pdev->dev, &dev_attr_imod_interval);
 
 	if (mdwc->dpdm_nb.notifier_call) {
 		regulator_unregister_notifier(mdwc->dpdm_reg, &mdwc->dpdm_nb);
@@ -5771,6 +5876,152 @@ static void msm_dwc3_perf_vote_update(struct dwc3_msm *mdwc, bool perf_mode)
 			perf_mode ? latency : PM_QOS_DEFAULT_VALUE);
 }
 
+/*
+ * Pick the slowest unisolated CPU that is faster than the little
+ * cluster, i.e. a gold core rather than the prime one, so that the
+ * controller interrupt does not compete with the foreground task.
+ */
+static int dwc3_msm_pick_irq_cpu(void)
+{
+	unsigned int little = UINT_MAX, best_freq = UINT_MAX, freq;
+	int cpu, best = -1;
+
+	for_each_online_cpu(cpu) {
+		freq = cpufreq_quick_get_max(cpu);
+		if (freq && freq < little)
+			little = freq;
+	}
+
+	for_each_online_cpu(cpu) {
+		if (cpu_isolated(cpu))
+			continue;
+		freq = cpufreq_quick_get_max(cpu);
+		if (freq <= little || freq >= best_freq)
+			continue;
+		best = cpu;
+		best_freq = freq;
+	}
+
+	return best;
+}
+
+static void dwc3_msm_irq_boost(struct dwc3_msm *mdwc, bool boost)
+{
+	struct dwc3 *dwc = platform_get_drvdata(mdwc->dwc3);
+	const struct cpumask *mask;
+	int cpu;
+
+	if (!dwc->irq)
+		return;
+
+	if (!boost) {
+		if (mdwc->irq_cpu < 0)
+			return;
+		irq_set_affinity_hint(dwc->irq, &mdwc->irq_saved_mask);
+		irq_set_affinity_hint(dwc->irq, NULL);
+		mdwc->irq_cpu = -1;
+		return;
+	}
+
+	/* The chosen CPU may have been isolated since */
+	if (mdwc->irq_cpu >= 0 && cpu_online(mdwc->irq_cpu) &&
+			!cpu_isolated(mdwc->irq_cpu))
+		return;
+
+	cpu = dwc3_msm_pick_irq_cpu();
+	if (cpu < 0)
+		return;
+
+	if (mdwc->irq_cpu < 0) {
+		mask = irq_get_affinity_mask(dwc->irq);
+		if (!mask)
+			return;
+		cpumask_copy(&mdwc->irq_saved_mask, mask);
+	}
+
+	if (!irq_set_affinity_hint(dwc->irq, cpumask_of(cpu)))
+		mdwc->irq_cpu = cpu;
+	irq_set_affinity_hint(dwc->irq, NULL);
+}
+
+static bool dwc3_msm_gsi_active(struct dwc3 *dwc)
+{
+	struct dwc3_ep *dep;
+	int i;
+
+	for (i = 0; i < DWC3_ENDPOINTS_NUM; i++) {
+		dep = dwc->eps[i];
+		if (dep && dep->gsi && (dep->flags & DWC3_EP_ENABLED))
+			return true;
+	}
+
+	return false;
+}
+
+static const enum bus_vote dyn_bv_votes[DYN_BV_LEVELS] = {
+	[DYN_BV_IDLE]	= BUS_VOTE_MIN,
+	[DYN_BV_LOW]	= BUS_VOTE_SVS,
+	[DYN_BV_HIGH]	= BUS_VOTE_NONE,	/* default_bus_vote */
+};
+
+static u32 dyn_bv_up_kbps(enum dyn_bus_vote_level level)
+{
+	return level == DYN_BV_LOW ? dyn_bus_vote_low_kbps :
+				     dyn_bus_vote_high_kbps;
+}
+
+/*
+ * Select the device mode bus vote from the throughput of the last
+ * sample. A level is entered as soon as its threshold is reached and
+ * left only after DYN_BV_DOWN_SAMPLES samples below half of it. Data
+ * moved by IPA over GSI endpoints is not seen by the controller driver,
+ * so an active GSI function keeps the top level.
+ */
+static void dwc3_msm_dyn_bus_vote(struct dwc3_msm *mdwc)
+{
+	struct dwc3 *dwc = platform_get_drvdata(mdwc->dwc3);
+	enum dyn_bus_vote_level level = mdwc->dyn_bv_level;
+	u64 bytes = READ_ONCE(dwc->xfer_bytes);
+	enum bus_vote bv;
+
+	mdwc->xfer_kbps = div_u64(bytes - mdwc->xfer_bytes_prev,
+				  1024 * PM_QOS_SAMPLE_SEC);
+	mdwc->xfer_bytes_prev = bytes;
+	mdwc->gsi_active = dwc3_msm_gsi_active(dwc);
+
+	if (!dyn_bus_vote || mdwc->gsi_active ||
+			mdwc->xfer_kbps >= dyn_bv_up_kbps(DYN_BV_HIGH))
+		level = DYN_BV_HIGH;
+	else if (mdwc->xfer_kbps >= dyn_bv_up_kbps(DYN_BV_LOW) &&
+			level < DYN_BV_LOW)
+		level = DYN_BV_LOW;
+
+	if (dyn_bus_vote && !mdwc->gsi_active && level > DYN_BV_IDLE &&
+			level == mdwc->dyn_bv_level &&
+			mdwc->xfer_kbps < dyn_bv_up_kbps(level) / 2) {
+		if (++mdwc->dyn_bv_down_cnt >= DYN_BV_DOWN_SAMPLES)
+			level--;
+	} else {
+		mdwc->dyn_bv_down_cnt = 0;
+	}
+
+	dwc3_msm_irq_boost(mdwc, dyn_bus_vote && level == DYN_BV_HIGH &&
+				 mdwc->xfer_kbps >= dyn_bv_up_kbps(DYN_BV_HIGH));
+
+	if (level == mdwc->dyn_bv_level)
+		return;
+
+	pr_debug("%s: %s -> %s, %uKB/s gsi:%d\n", __func__,
+		 dyn_bv_level_strings[mdwc->dyn_bv_level],
+		 dyn_bv_level_strings[level], mdwc->xfer_kbps,
+		 mdwc->gsi_active);
+
+	mdwc->dyn_bv_level = level;
+	mdwc->dyn_bv_down_cnt = 0;
+	bv = dyn_bv_votes[level] ?: mdwc->default_bus_vote;
+	dwc3_msm_update_bus_bw(mdwc, bv);
+}
+
 static void msm_dwc3_perf_vote_work(struct work_struct *w)
 {
 	struct dwc3_msm *mdwc = container_of(w, struct dwc3_msm,
@@ -5786,6 +6037,8 @@ static void msm_dwc3_perf_vote_work(struct work_struct *w)
 		 __func__, in_perf_mode, irq_cnt);
 
 	msm_dwc3_perf_vote_update(mdwc, in_perf_mode);
+	if (!mdwc->in_host_mode)
+		dwc3_msm_dyn_bus_vote(mdwc);
 	schedule_delayed_work(&mdwc->perf_vote_work,
 			msecs_to_jiffies(1000 * PM_QOS_SAMPLE_SEC));
 }
@@ -5971,6 +6224,7 @@ static int dwc3_otg_start_host(struct dwc3_msm *mdwc, int on)
 
 		cancel_delayed_work_sync(&mdwc->perf_vote_work);
 		msm_dwc3_perf_vote_update(mdwc, false);
+		dwc3_msm_irq_boost(mdwc, false);
 		pm_qos_remove_request(&mdwc->pm_qos_req_dma);
 
 		pm_runtime_get_sync(mdwc->dev);
@@ -6098,6 +6352,7 @@ static int dwc3_otg_start_peripheral(struct dwc3_msm *mdwc, int on)
 					__func__, dwc->gadget.name);
 		cancel_delayed_work_sync(&mdwc->perf_vote_work);
 		msm_dwc3_perf_vote_update(mdwc, false);
+		dwc3_msm_irq_boost(mdwc, false);
 		pm_qos_remove_request(&mdwc->pm_qos_req_dma);
 
 		mdwc->in_device_mode = false;
@@ -2780,8 +2780,14 @@ static int __dwc3_gadget_start(struct dwc3 *dwc)
 
 	/*
 	 * Use IMOD if enabled via dwc->imod_interval. Otherwise, if
-	 * the core supports IMOD, disable it.
+	 * the core supports IMOD, disable it. The glue driver may have
+	 * changed the interval since dwc3_check_params() ran.
 	 */
+	if (dwc->imod_interval && !dwc3_has_imod(dwc)) {
+		dev_warn(dwc->dev, "Interrupt moderation not supported\n");
+		dwc->imod_interval = 0;
+	}
+
 	if (dwc->imod_interval) {
 		dwc3_writel(dwc->regs, DWC3_DEV_IMOD(0), dwc->imod_interval);
 		dwc3_writel(dwc->regs, DWC3_GEVNTCOUNT(0), DWC3_GEVNTCOUNT_EHB);
@@ -3336,6 +3342,16 @@ static int dwc3_gadget_ep_cleanup_completed_request(struct dwc3_ep *dep,
 		req->needs_extra_trb = false;
 	}
 
+	if (!status) {
+		dep->dwc->xfer_bytes += req->request.actual;
+		dep->dbg_xfer.bytes += req->request.actual;
+		dep->dbg_xfer.requests++;
+		if (req->request.num_mapped_sgs) {
+			dep->dbg_xfer.sg_requests++;
+			dep->dbg_xfer.sg_entries += req->request.num_mapped_sgs;
+		}
+	}
+
 	dwc3_gadget_giveback(dep, req, status);
 
 out:
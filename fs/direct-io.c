@@ -425,6 +425,22 @@ void dio_end_io(struct bio *bio)
 }
 EXPORT_SYMBOL_GPL(dio_end_io);
 
+/**
+ * dio_set_bio_cookie - record the cookie of a bio sent by a dio_submit_t
+ * @private: the bi_private the bio had when it was passed to dio_submit_t
+ * @cookie: what submit_bio() returned for it
+ *
+ * A filesystem that submits the bios itself calls this so that IOCB_HIPRI
+ * requests can still poll for their completion.
+ */
+void dio_set_bio_cookie(void *private, unsigned int cookie)
+{
+	struct dio *dio = private;
+
+	dio->bio_cookie = cookie;
+}
+EXPORT_SYMBOL_GPL(dio_set_bio_cookie);
+
 static inline void
 dio_bio_alloc(struct dio *dio, struct dio_submit *sdio,
 	      struct block_device *bdev,
@@ -480,8 +496,8 @@ static inline void dio_bio_submit(struct dio *dio, struct dio_submit *sdio)
 	dio->bio_disk = bio->bi_disk;
 
 	if (sdio->submit_io) {
-		sdio->submit_io(bio, dio->inode, sdio->logical_offset_in_bio);
 		dio->bio_cookie = BLK_QC_T_NONE;
+		sdio->submit_io(bio, dio->inode, sdio->logical_offset_in_bio);
 	} else
 		dio->bio_cookie = submit_bio(bio);
 
@@ -1391,9 +1407,11 @@ do_blockdev_direct_IO(struct kiocb *iocb, struct inode *inode,
 	 */
 	BUG_ON(retval == -EIOCBQUEUED);
 	if (dio->is_async && retval == 0 && dio->result &&
-	    (iov_iter_rw(iter) == READ || dio->result == count))
+	    (iov_iter_rw(iter) == READ || dio->result == count)) {
+		/* lets ->iopoll() of the filesystem poll for the last bio */
+		WRITE_ONCE(iocb->ki_cookie, dio->bio_cookie);
 		retval = -EIOCBQUEUED;
-	else
+	} else
 		dio_await_completion(dio);
 
 	if (drop_refcount(dio) == 0) {
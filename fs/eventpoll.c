@@ -221,6 +221,15 @@ struct eventpoll {
 	/* used to optimize loop detection check */
 	u64 gen;
 
+	/*
+	 * Wakeup statistics, reported through fdinfo. The first two are
+	 * updated from ep_poll_callback() under the read side of ->lock,
+	 * the contention counter only while holding it for writing.
+	 */
+	atomic_long_t nr_wakeups;
+	atomic_long_t nr_coalesced;
+	unsigned long nr_contended;
+
 #ifdef CONFIG_NET_RX_BUSY_POLL
 	/* used to track busy poll napi_id */
 	unsigned int napi_id;
@@ -366,6 +375,19 @@ static void ep_nested_calls_init(struct nested_calls *ncalls)
 	spin_lock_init(&ncalls->lock);
 }
 
+/*
+ * Take ->lock for writing with interrupts disabled, counting the times
+ * it had to wait behind a wakeup callback or another writer.
+ */
+static inline void ep_write_lock_irq(struct eventpoll *ep)
+{
+	local_irq_disable();
+	if (!write_trylock(&ep->lock)) {
+		write_lock(&ep->lock);
+		ep->nr_contended++;
+	}
+}
+
 /**
  * ep_events_available - Checks if ready events might be available.
  *
@@ -692,7 +714,7 @@ static __poll_t ep_scan_ready_list(struct eventpoll *ep,
 	 * because we want the "sproc" callback to be able to do it
 	 * in a lockless way.
 	 */
-	write_lock_irq(&ep->lock);
+	ep_write_lock_irq(ep);
 	list_splice_init(&ep->rdllist, &txlist);
 	WRITE_ONCE(ep->ovflist, NULL);
 	write_unlock_irq(&ep->lock);
@@ -702,7 +724,7 @@ static __poll_t ep_scan_ready_list(struct eventpoll *ep,
 	 */
 	res = (*sproc)(ep, &txlist, priv);
 
-	write_lock_irq(&ep->lock);
+	ep_write_lock_irq(ep);
 	/*
 	 * During the time we spent inside the "sproc" callback, some
 	 * other events might have been queued by the poll callback.
@@ -788,7 +810,7 @@ static int ep_remove(struct eventpoll *ep, struct epitem *epi)
 
 	rb_erase_cached(&epi->rbn, &ep->rbr);
 
-	write_lock_irq(&ep->lock);
+	ep_write_lock_irq(ep);
 	if (ep_is_linked(epi))
 		list_del_init(&epi->rdllink);
 	write_unlock_irq(&ep->lock);
@@ -962,6 +984,10 @@ static void ep_show_fdinfo(struct seq_file *m, struct file *f)
 		if (seq_has_overflowed(m))
 			break;
 	}
+	seq_printf(m, "wakeups: %lu coalesced: %lu contended: %lu\n",
+		   atomic_long_read(&ep->nr_wakeups),
+		   atomic_long_read(&ep->nr_coalesced),
+		   READ_ONCE(ep->nr_contended));
 	mutex_unlock(&ep->mtx);
 }
 #endif
@@ -1214,6 +1240,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	struct eventpoll *ep = epi->ep;
 	__poll_t pollflags = key_to_poll(key);
 	unsigned long flags;
+	bool queued = true;
 	int ewake = 0;
 
 	read_lock_irqsave(&ep->lock, flags);
@@ -1247,10 +1274,27 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
 		if (chain_epi_lockless(epi))
 			ep_pm_stay_awake_rcu(epi);
-	} else if (!ep_is_linked(epi)) {
+	} else if (ep_is_linked(epi) ||
+		   !list_add_tail_lockless(&epi->rdllink, &ep->rdllist)) {
+		queued = false;
+	} else {
 		/* In the usual case, add event to ready list. */
-		if (list_add_tail_lockless(&epi->rdllink, &ep->rdllist))
-			ep_pm_stay_awake_rcu(epi);
+		ep_pm_stay_awake_rcu(epi);
+	}
+
+	/*
+	 * An item that was already on the ready list got there through a
+	 * caller that issued (or is about to issue) a wakeup, and whoever
+	 * consumes that wakeup will harvest this event too. Waking another
+	 * waiter would only have it find an empty list, so a burst of
+	 * events on one fd costs a single wakeup. Exclusive items still
+	 * wake, their return value tells the source whether we took the
+	 * event.
+	 */
+	if (!queued && !(epi->event.events & EPOLLEXCLUSIVE) &&
+	    !(pollflags & POLLFREE)) {
+		atomic_long_inc(&ep->nr_coalesced);
+		goto out_unlock;
 	}
 
 	/*
@@ -1274,6 +1318,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 				break;
 			}
 		}
+		atomic_long_inc(&ep->nr_wakeups);
 		wake_up(&ep->wq);
 	}
 	if (waitqueue_active(&ep->poll_wait))
@@ -1566,7 +1611,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 		goto error_unregister;
 
 	/* We have to drop the new item inside our item list to keep track of it */
-	write_lock_irq(&ep->lock);
+	ep_write_lock_irq(ep);
 
 	/* record NAPI ID of new item if present */
 	ep_set_busy_poll_napi_id(epi);
@@ -1608,7 +1653,7 @@ static int ep_insert(struct eventpoll *ep, const struct epoll_event *event,
 	 * list, since that is used/cleaned only inside a section bound by "mtx".
 	 * And ep_insert() is called with "mtx" held.
 	 */
-	write_lock_irq(&ep->lock);
+	ep_write_lock_irq(ep);
 	if (ep_is_linked(epi))
 		list_del_init(&epi->rdllink);
 	write_unlock_irq(&ep->lock);
@@ -1676,7 +1721,7 @@ static int ep_modify(struct eventpoll *ep, struct epitem *epi,
 	 * list, push it inside.
 	 */
 	if (ep_item_poll(epi, &pt, 1)) {
-		write_lock_irq(&ep->lock);
+		ep_write_lock_irq(ep);
 		if (!ep_is_linked(epi)) {
 			list_add_tail(&epi->rdllink, &ep->rdllist);
 			ep_pm_stay_awake(epi);
@@ -1847,7 +1892,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 */
 		timed_out = 1;
 
-		write_lock_irq(&ep->lock);
+		ep_write_lock_irq(ep);
 		eavail = ep_events_available(ep);
 		write_unlock_irq(&ep->lock);
 
@@ -1883,7 +1928,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 * event delivery.
 		 */
 		init_wait(&wait);
-		write_lock_irq(&ep->lock);
+		ep_write_lock_irq(ep);
 		__add_wait_queue_exclusive(&ep->wq, &wait);
 		write_unlock_irq(&ep->lock);
 
@@ -1926,7 +1971,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 	__set_current_state(TASK_RUNNING);
 
 	if (!list_empty_careful(&wait.entry)) {
-		write_lock_irq(&ep->lock);
+		ep_write_lock_irq(ep);
 		__remove_wait_queue(&ep->wq, &wait);
 		write_unlock_irq(&ep->lock);
 	}
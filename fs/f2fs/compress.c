@@ -13,6 +13,7 @@
 #include <linux/lz4.h>
 #include <linux/zstd.h>
 #include <linux/moduleparam.h>
+#include <linux/vmalloc.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -371,6 +372,57 @@ static int zstd_compress_pages(struct compress_ctx *cc)
 	return 0;
 }
 
+/*
+ * A ZSTD decompression workspace for MAX_COMPRESS_WINDOW_SIZE is over a
+ * megabyte, too much to vmalloc and free again for every cluster read.  Up to
+ * one idle workspace per online CPU is kept for reuse; while idle, its first
+ * bytes hold the list linkage.
+ */
+static LIST_HEAD(zstd_dworkspace_list);
+static DEFINE_SPINLOCK(zstd_dworkspace_lock);
+static unsigned int zstd_dworkspace_idle;
+
+static void *zstd_get_dworkspace(struct f2fs_sb_info *sbi, unsigned int size)
+{
+	struct list_head *ws = NULL;
+
+	spin_lock(&zstd_dworkspace_lock);
+	if (!list_empty(&zstd_dworkspace_list)) {
+		ws = zstd_dworkspace_list.next;
+		list_del(ws);
+		zstd_dworkspace_idle--;
+	}
+	spin_unlock(&zstd_dworkspace_lock);
+
+	if (ws)
+		return ws;
+	return f2fs_kvmalloc(sbi, size, GFP_NOFS);
+}
+
+static void zstd_put_dworkspace(void *workspace)
+{
+	spin_lock(&zstd_dworkspace_lock);
+	if (zstd_dworkspace_idle < num_online_cpus()) {
+		list_add(workspace, &zstd_dworkspace_list);
+		zstd_dworkspace_idle++;
+		workspace = NULL;
+	}
+	spin_unlock(&zstd_dworkspace_lock);
+
+	kvfree(workspace);
+}
+
+static void zstd_drain_dworkspaces(void)
+{
+	struct list_head *ws, *tmp;
+
+	list_for_each_safe(ws, tmp, &zstd_dworkspace_list) {
+		list_del(ws);
+		kvfree(ws);
+	}
+	zstd_dworkspace_idle = 0;
+}
+
 static int zstd_init_decompress_ctx(struct decompress_io_ctx *dic)
 {
 	ZSTD_DStream *stream;
@@ -379,8 +431,7 @@ static int zstd_init_decompress_ctx(struct decompress_io_ctx *dic)
 
 	workspace_size = ZSTD_DStreamWorkspaceBound(MAX_COMPRESS_WINDOW_SIZE);
 
-	workspace = f2fs_kvmalloc(F2FS_I_SB(dic->inode),
-					workspace_size, GFP_NOFS);
+	workspace = zstd_get_dworkspace(F2FS_I_SB(dic->inode), workspace_size);
 	if (!workspace)
 		return -ENOMEM;
 
@@ -390,7 +441,7 @@ static int zstd_init_decompress_ctx(struct decompress_io_ctx *dic)
 		printk_ratelimited("%sF2FS-fs (%s): %s ZSTD_initDStream failed\n",
 				KERN_ERR, F2FS_I_SB(dic->inode)->sb->s_id,
 				__func__);
-		kvfree(workspace);
+		zstd_put_dworkspace(workspace);
 		return -EIO;
 	}
 
@@ -402,7 +453,7 @@ static int zstd_init_decompress_ctx(struct decompress_io_ctx *dic)
 
 static void zstd_destroy_decompress_ctx(struct decompress_io_ctx *dic)
 {
-	kvfree(dic->private);
+	zstd_put_dworkspace(dic->private);
 	dic->private = NULL;
 	dic->private2 = NULL;
 }
@@ -525,6 +576,31 @@ int f2fs_init_compress_mempool(void)
 void f2fs_destroy_compress_mempool(void)
 {
 	mempool_destroy(compress_page_pool);
+#ifdef CONFIG_F2FS_FS_ZSTD
+	zstd_drain_dworkspaces();
+#endif
+}
+
+#define MAX_VMAP_RETRIES	3
+
+/*
+ * Map a cluster with vm_map_ram(), which serves small mappings from per-cpu
+ * vmap blocks instead of taking the global vmap_area lock and allocating a
+ * vm_struct on every call like vmap() does.  Lazily freed aliases can leave no
+ * room, so purge them and retry before giving up.
+ */
+static void *f2fs_vmap(struct page **pages, unsigned int count, pgprot_t prot)
+{
+	void *buf = NULL;
+	int i;
+
+	for (i = 0; i < MAX_VMAP_RETRIES; i++) {
+		buf = vm_map_ram(pages, count, -1, prot);
+		if (buf)
+			break;
+		vm_unmap_aliases();
+	}
+	return buf;
 }
 
 static struct page *f2fs_compress_alloc_page(void)
@@ -584,13 +660,13 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 		}
 	}
 
-	cc->rbuf = vmap(cc->rpages, cc->cluster_size, VM_MAP, PAGE_KERNEL_RO);
+	cc->rbuf = f2fs_vmap(cc->rpages, cc->cluster_size, PAGE_KERNEL_RO);
 	if (!cc->rbuf) {
 		ret = -ENOMEM;
 		goto out_free_cpages;
 	}
 
-	cc->cbuf = vmap(cc->cpages, cc->nr_cpages, VM_MAP, PAGE_KERNEL);
+	cc->cbuf = f2fs_vmap(cc->cpages, cc->nr_cpages, PAGE_KERNEL);
 	if (!cc->cbuf) {
 		ret = -ENOMEM;
 		goto out_vunmap_rbuf;
@@ -618,8 +694,8 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	memset(&cc->cbuf->cdata[cc->clen], 0,
 	       (nr_cpages * PAGE_SIZE) - (cc->clen + COMPRESS_HEADER_SIZE));
 
-	vunmap(cc->cbuf);
-	vunmap(cc->rbuf);
+	vm_unmap_ram(cc->cbuf, cc->nr_cpages);
+	vm_unmap_ram(cc->rbuf, cc->cluster_size);
 
 	for (i = nr_cpages; i < cc->nr_cpages; i++) {
 		f2fs_compress_free_page(cc->cpages[i]);
@@ -636,9 +712,9 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	return 0;
 
 out_vunmap_cbuf:
-	vunmap(cc->cbuf);
+	vm_unmap_ram(cc->cbuf, cc->nr_cpages);
 out_vunmap_rbuf:
-	vunmap(cc->rbuf);
+	vm_unmap_ram(cc->rbuf, cc->cluster_size);
 out_free_cpages:
 	for (i = 0; i < cc->nr_cpages; i++) {
 		if (cc->cpages[i])
@@ -655,23 +731,60 @@ static int f2fs_compress_pages(struct compress_ctx *cc)
 	return ret;
 }
 
-void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
+/*
+ * Account a compressed page read by @bio.  Returns its cluster when this was
+ * the last compressed page of it to complete, so it can be decompressed.
+ */
+struct decompress_io_ctx *f2fs_end_compressed_page(struct bio *bio,
+							struct page *page)
 {
 	struct decompress_io_ctx *dic =
 			(struct decompress_io_ctx *)page_private(page);
-	struct f2fs_sb_info *sbi = F2FS_I_SB(dic->inode);
-	struct f2fs_inode_info *fi= F2FS_I(dic->inode);
-	const struct f2fs_compress_ops *cops =
-			f2fs_cops[fi->i_compress_algorithm];
-	int ret;
 
-	dec_page_count(sbi, F2FS_RD_DATA);
+	dec_page_count(F2FS_I_SB(dic->inode), F2FS_RD_DATA);
 
 	if (bio->bi_status || PageError(page))
 		dic->failed = true;
 
 	if (refcount_dec_not_one(&dic->ref))
-		return;
+		return NULL;
+	return dic;
+}
+
+void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
+{
+	struct decompress_io_ctx *dic = f2fs_end_compressed_page(bio, page);
+
+	if (dic)
+		f2fs_decompress_cluster(dic, verity);
+}
+
+static void f2fs_decompress_cluster_work(struct work_struct *work)
+{
+	struct decompress_io_ctx *dic =
+		container_of(work, struct decompress_io_ctx, work);
+
+	f2fs_decompress_cluster(dic, false);
+}
+
+/*
+ * Clusters are independent once all their compressed pages are read, so a
+ * bio spanning several of them hands them to the post read workers instead of
+ * decompressing them one after the other.  Only for reads without verity,
+ * which has to see the whole bio decompressed before it runs.
+ */
+void f2fs_queue_decompress_cluster(struct decompress_io_ctx *dic)
+{
+	INIT_WORK(&dic->work, f2fs_decompress_cluster_work);
+	queue_work(F2FS_I_SB(dic->inode)->post_read_wq, &dic->work);
+}
+
+void f2fs_decompress_cluster(struct decompress_io_ctx *dic, bool verity)
+{
+	struct f2fs_inode_info *fi = F2FS_I(dic->inode);
+	const struct f2fs_compress_ops *cops =
+			f2fs_cops[fi->i_compress_algorithm];
+	int ret;
 
 	trace_f2fs_decompress_pages_start(dic->inode, dic->cluster_idx,
 				dic->cluster_size, fi->i_compress_algorithm);
@@ -688,13 +801,13 @@ void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
 			goto out_free_dic;
 	}
 
-	dic->rbuf = vmap(dic->tpages, dic->cluster_size, VM_MAP, PAGE_KERNEL);
+	dic->rbuf = f2fs_vmap(dic->tpages, dic->cluster_size, PAGE_KERNEL);
 	if (!dic->rbuf) {
 		ret = -ENOMEM;
 		goto destroy_decompress_ctx;
 	}
 
-	dic->cbuf = vmap(dic->cpages, dic->nr_cpages, VM_MAP, PAGE_KERNEL_RO);
+	dic->cbuf = f2fs_vmap(dic->cpages, dic->nr_cpages, PAGE_KERNEL_RO);
 	if (!dic->cbuf) {
 		ret = -ENOMEM;
 		goto out_vunmap_rbuf;
@@ -711,9 +824,9 @@ void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity)
 	ret = cops->decompress_pages(dic);
 
 out_vunmap_cbuf:
-	vunmap(dic->cbuf);
+	vm_unmap_ram(dic->cbuf, dic->nr_cpages);
 out_vunmap_rbuf:
-	vunmap(dic->rbuf);
+	vm_unmap_ram(dic->rbuf, dic->cluster_size);
 destroy_decompress_ctx:
 	if (cops->destroy_decompress_ctx)
 		cops->destroy_decompress_ctx(dic);
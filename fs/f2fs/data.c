@@ -132,13 +132,31 @@ static void __read_end_io(struct bio *bio, bool compr, bool verity)
 	struct page *page;
 	struct bio_vec *bv;
 	struct bvec_iter_all iter_all;
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	struct decompress_io_ctx *dic, *local_dic = NULL;
+#endif
 
 	bio_for_each_segment_all(bv, bio, iter_all) {
 		page = bv->bv_page;
 
 #ifdef CONFIG_F2FS_FS_COMPRESSION
 		if (compr && f2fs_is_compressed_page(page)) {
-			f2fs_decompress_pages(bio, page, verity);
+			if (verity) {
+				f2fs_decompress_pages(bio, page, verity);
+				continue;
+			}
+			dic = f2fs_end_compressed_page(bio, page);
+			if (!dic)
+				continue;
+			/*
+			 * Keep the first completed cluster for this worker and
+			 * fan out the others, a single cluster read never pays
+			 * for the extra work hop.
+			 */
+			if (!local_dic)
+				local_dic = dic;
+			else
+				f2fs_queue_decompress_cluster(dic);
 			continue;
 		}
 		if (verity)
@@ -156,6 +174,11 @@ static void __read_end_io(struct bio *bio, bool compr, bool verity)
 		dec_page_count(F2FS_P_SB(page), __read_io_type(page));
 		unlock_page(page);
 	}
+
+#ifdef CONFIG_F2FS_FS_COMPRESSION
+	if (local_dic)
+		f2fs_decompress_cluster(local_dic, false);
+#endif
 }
 
 static void f2fs_release_read_bio(struct bio *bio);
@@ -744,6 +767,25 @@ static bool page_is_mergeable(struct f2fs_sb_info *sbi, struct bio *bio,
 	return __same_bdev(sbi, cur_blkaddr, bio);
 }
 
+/*
+ * Whether the next page of a data read can go into @bio; if not, account the
+ * reason the bio is split there.
+ */
+static bool read_page_is_mergeable(struct f2fs_sb_info *sbi, struct bio *bio,
+				block_t last_blkaddr, block_t cur_blkaddr,
+				const struct inode *inode, pgoff_t index)
+{
+	if (!page_is_mergeable(sbi, bio, last_blkaddr, cur_blkaddr)) {
+		stat_inc_bio_split(sbi, BIO_SPLIT_BLKADDR);
+		return false;
+	}
+	if (!f2fs_crypt_mergeable_bio(bio, inode, index, NULL)) {
+		stat_inc_bio_split(sbi, BIO_SPLIT_CRYPT);
+		return false;
+	}
+	return true;
+}
+
 static bool io_type_is_mergeable(struct f2fs_bio_info *io,
 						struct f2fs_io_info *fio)
 {
@@ -820,13 +862,16 @@ static int add_ipu_page(struct f2fs_io_info *fio, struct bio **bio,
 			f2fs_bug_on(sbi, !page_is_mergeable(sbi, *bio,
 							    *fio->last_block,
 							    fio->new_blkaddr));
-			if (f2fs_crypt_mergeable_bio(*bio,
+			if (!f2fs_crypt_mergeable_bio(*bio,
 					fio->page->mapping->host,
-					fio->page->index, fio) &&
-			    bio_add_page(*bio, page, PAGE_SIZE, 0) ==
+					fio->page->index, fio)) {
+				stat_inc_bio_split(sbi, BIO_SPLIT_CRYPT);
+			} else if (bio_add_page(*bio, page, PAGE_SIZE, 0) ==
 					PAGE_SIZE) {
 				ret = 0;
 				break;
+			} else {
+				stat_inc_bio_split(sbi, BIO_SPLIT_FULL);
 			}
 
 			/* page can't be merged into bio; submit the bio */
@@ -915,8 +960,10 @@ int f2fs_merge_page_bio(struct f2fs_io_info *fio)
 	f2fs_trace_ios(fio, 0);
 
 	if (bio && !page_is_mergeable(fio->sbi, bio, *fio->last_block,
-				       fio->new_blkaddr))
+				       fio->new_blkaddr)) {
+		stat_inc_bio_split(fio->sbi, BIO_SPLIT_BLKADDR);
 		f2fs_submit_merged_ipu_write(fio->sbi, &bio, NULL);
+	}
 alloc_new:
 	if (!bio) {
 		bio = __bio_alloc(fio, BIO_MAX_PAGES);
@@ -980,12 +1027,16 @@ void f2fs_submit_page_write(struct f2fs_io_info *fio)
 
 	inc_page_count(sbi, WB_DATA_TYPE(bio_page));
 
-	if (io->bio &&
-	    (!io_is_mergeable(sbi, io->bio, io, fio, io->last_block_in_bio,
-			      fio->new_blkaddr) ||
-	     !f2fs_crypt_mergeable_bio(io->bio, fio->page->mapping->host,
-				       fio->page->index, fio)))
+	if (io->bio && !io_is_mergeable(sbi, io->bio, io, fio,
+				io->last_block_in_bio, fio->new_blkaddr)) {
+		stat_inc_bio_split(sbi, BIO_SPLIT_BLKADDR);
 		__submit_merged_bio(io);
+	} else if (io->bio &&
+		   !f2fs_crypt_mergeable_bio(io->bio, fio->page->mapping->host,
+					     fio->page->index, fio)) {
+		stat_inc_bio_split(sbi, BIO_SPLIT_CRYPT);
+		__submit_merged_bio(io);
+	}
 alloc_new:
 	if (io->bio == NULL) {
 		if (F2FS_IO_ALIGNED(sbi) &&
@@ -1003,6 +1054,7 @@ void f2fs_submit_page_write(struct f2fs_io_info *fio)
 	}
 
 	if (bio_add_page(io->bio, bio_page, PAGE_SIZE, 0) < PAGE_SIZE) {
+		stat_inc_bio_split(sbi, BIO_SPLIT_FULL);
 		__submit_merged_bio(io);
 		goto alloc_new;
 	}
@@ -2126,9 +2178,8 @@ static int f2fs_read_single_page(struct inode *inode, struct page *page,
 	 * This page will go to BIO.  Do we need to send this
 	 * BIO off first?
 	 */
-	if (bio && (!page_is_mergeable(F2FS_I_SB(inode), bio,
-				       *last_block_in_bio, block_nr) ||
-		    !f2fs_crypt_mergeable_bio(bio, inode, page->index, NULL))) {
+	if (bio && !read_page_is_mergeable(F2FS_I_SB(inode), bio,
+				*last_block_in_bio, block_nr, inode, page->index)) {
 submit_and_realloc:
 		__submit_bio(F2FS_I_SB(inode), bio, DATA);
 		bio = NULL;
@@ -2150,8 +2201,10 @@ static int f2fs_read_single_page(struct inode *inode, struct page *page,
 	 */
 	f2fs_wait_on_block_writeback(inode, block_nr);
 
-	if (bio_add_page(bio, page, blocksize, 0) < blocksize)
+	if (bio_add_page(bio, page, blocksize, 0) < blocksize) {
+		stat_inc_bio_split(F2FS_I_SB(inode), BIO_SPLIT_FULL);
 		goto submit_and_realloc;
+	}
 
 	inc_page_count(F2FS_I_SB(inode), F2FS_RD_DATA);
 	f2fs_update_iostat(F2FS_I_SB(inode), FS_DATA_READ_IO, F2FS_BLKSIZE);
@@ -2183,6 +2236,8 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 	const unsigned blkbits = inode->i_blkbits;
 	const unsigned blocksize = 1 << blkbits;
 	struct decompress_io_ctx *dic = NULL;
+	struct extent_info ei = {0, };
+	bool from_ec = false, contig = true;
 	int i;
 	int ret = 0;
 
@@ -2213,6 +2268,12 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 	if (f2fs_cluster_is_empty(cc))
 		goto out;
 
+	if (f2fs_lookup_cluster_extent(inode, start_idx, &ei)) {
+		from_ec = true;
+		cc->nr_cpages = ei.c_len;
+		goto alloc_dic;
+	}
+
 	set_new_dnode(&dn, inode, NULL, NULL, 0);
 	ret = f2fs_get_dnode_of_data(&dn, start_idx, LOOKUP_NODE);
 	if (ret)
@@ -2235,6 +2296,9 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 			ret = -EFAULT;
 			goto out_put_dnode;
 		}
+		if (cc->nr_cpages && blkaddr != data_blkaddr(dn.inode,
+				dn.node_page, dn.ofs_in_node + i - 1) + 1)
+			contig = false;
 		cc->nr_cpages++;
 	}
 
@@ -2244,6 +2308,13 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 		goto out_put_dnode;
 	}
 
+	if (contig)
+		f2fs_update_cluster_extent(inode, start_idx,
+				data_blkaddr(dn.inode, dn.node_page,
+						dn.ofs_in_node + 1),
+				cc->nr_cpages);
+
+alloc_dic:
 	dic = f2fs_alloc_dic(cc);
 	if (IS_ERR(dic)) {
 		ret = PTR_ERR(dic);
@@ -2255,12 +2326,12 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 		block_t blkaddr;
 		struct bio_post_read_ctx *ctx;
 
-		blkaddr = data_blkaddr(dn.inode, dn.node_page,
+		blkaddr = from_ec ? ei.blk + i :
+				data_blkaddr(dn.inode, dn.node_page,
 						dn.ofs_in_node + i + 1);
 
-		if (bio && (!page_is_mergeable(sbi, bio,
-					*last_block_in_bio, blkaddr) ||
-		    !f2fs_crypt_mergeable_bio(bio, inode, page->index, NULL))) {
+		if (bio && !read_page_is_mergeable(sbi, bio,
+				*last_block_in_bio, blkaddr, inode, page->index)) {
 submit_and_realloc:
 			__submit_bio(sbi, bio, DATA);
 			bio = NULL;
@@ -2280,7 +2351,8 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 							false);
 					f2fs_free_dic(dic);
 				}
-				f2fs_put_dnode(&dn);
+				if (!from_ec)
+					f2fs_put_dnode(&dn);
 				*bio_ret = NULL;
 				return ret;
 			}
@@ -2288,8 +2360,10 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 
 		f2fs_wait_on_block_writeback(inode, blkaddr);
 
-		if (bio_add_page(bio, page, blocksize, 0) < blocksize)
+		if (bio_add_page(bio, page, blocksize, 0) < blocksize) {
+			stat_inc_bio_split(sbi, BIO_SPLIT_FULL);
 			goto submit_and_realloc;
+		}
 
 		/* tag STEP_DECOMPRESS to handle IO in wq */
 		ctx = bio->bi_private;
@@ -2303,13 +2377,15 @@ int f2fs_read_multi_pages(struct compress_ctx *cc, struct bio **bio_ret,
 		*last_block_in_bio = blkaddr;
 	}
 
-	f2fs_put_dnode(&dn);
+	if (!from_ec)
+		f2fs_put_dnode(&dn);
 
 	*bio_ret = bio;
 	return 0;
 
 out_put_dnode:
-	f2fs_put_dnode(&dn);
+	if (!from_ec)
+		f2fs_put_dnode(&dn);
 out:
 	f2fs_decompress_end_io(cc->rpages, cc->cluster_size, true, false);
 	*bio_ret = bio;
@@ -2432,6 +2508,65 @@ int f2fs_mpage_readpages(struct address_space *mapping,
 	return pages ? 0 : ret;
 }
 
+/* chunk of one readahead call, matches force_page_cache_readahead() */
+#define F2FS_RA_RANGE_CHUNK	((2 * 1024 * 1024) / PAGE_SIZE)
+
+static void f2fs_readahead_pages(struct address_space *mapping,
+			struct list_head *pages, unsigned int nr_pages)
+{
+	if (!nr_pages)
+		return;
+	mapping->a_ops->readpages(NULL, mapping, pages, nr_pages);
+	/* whatever ->readpages() did not take */
+	put_pages_list(pages);
+}
+
+/*
+ * Read [index, index + nr) of @inode ahead of use without a struct file, for
+ * readahead hints from userspace.  Pages already cached are skipped.  The
+ * caller is expected to hold a plug, so the reads of consecutive ranges get
+ * merged.
+ */
+void f2fs_readahead_range(struct inode *inode, pgoff_t index,
+			unsigned long nr)
+{
+	struct address_space *mapping = inode->i_mapping;
+	loff_t isize = i_size_read(inode);
+	unsigned int nr_pages = 0;
+	LIST_HEAD(pages);
+	pgoff_t end;
+
+	if (!isize || !nr)
+		return;
+
+	end = min_t(pgoff_t, index + nr - 1, (isize - 1) >> PAGE_SHIFT);
+
+	for (; index <= end; index++) {
+		struct page *page;
+
+		rcu_read_lock();
+		page = xa_load(&mapping->i_pages, index);
+		rcu_read_unlock();
+		if (page && !xa_is_value(page)) {
+			f2fs_readahead_pages(mapping, &pages, nr_pages);
+			nr_pages = 0;
+			continue;
+		}
+
+		page = __page_cache_alloc(readahead_gfp_mask(mapping));
+		if (!page)
+			break;
+		page->index = index;
+		list_add(&page->lru, &pages);
+
+		if (++nr_pages == F2FS_RA_RANGE_CHUNK) {
+			f2fs_readahead_pages(mapping, &pages, nr_pages);
+			nr_pages = 0;
+		}
+	}
+	f2fs_readahead_pages(mapping, &pages, nr_pages);
+}
+
 static int f2fs_read_data_page(struct file *file, struct page *page)
 {
 	struct inode *inode = page_file_mapping(page)->host;
@@ -3577,6 +3712,7 @@ static void f2fs_dio_submit_bio(struct bio *bio, struct inode *inode,
 							loff_t file_offset)
 {
 	struct f2fs_private_dio *dio;
+	void *dio_private = bio->bi_private;
 	bool write = (bio_op(bio) == REQ_OP_WRITE);
 
 	dio = f2fs_kzalloc(F2FS_I_SB(inode),
@@ -3595,7 +3731,8 @@ static void f2fs_dio_submit_bio(struct bio *bio, struct inode *inode,
 	inc_page_count(F2FS_I_SB(inode),
 			write ? F2FS_DIO_WRITE : F2FS_DIO_READ);
 
-	submit_bio(bio);
+	/* dio may already be freed once the bio is submitted */
+	dio_set_bio_cookie(dio_private, submit_bio(bio));
 	return;
 out:
 	bio->bi_status = BLK_STS_IOERR;
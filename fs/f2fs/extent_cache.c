@@ -549,13 +549,16 @@ static void f2fs_update_extent_tree_range(struct inode *inode,
 		org_end = dei.fofs + dei.len;
 		f2fs_bug_on(sbi, pos >= org_end);
 
-		if (pos > dei.fofs &&	pos - dei.fofs >= F2FS_MIN_EXTENT_LEN) {
+		/* a compressed cluster is cached whole or not at all */
+		if (!dei.c_len && pos > dei.fofs &&
+				pos - dei.fofs >= F2FS_MIN_EXTENT_LEN) {
 			en->ei.len = pos - en->ei.fofs;
 			prev_en = en;
 			parts = 1;
 		}
 
-		if (end < org_end && org_end - end >= F2FS_MIN_EXTENT_LEN) {
+		if (!dei.c_len && end < org_end &&
+				org_end - end >= F2FS_MIN_EXTENT_LEN) {
 			if (parts) {
 				set_extent_info(&ei, end,
 						end - dei.fofs + dei.blk,
@@ -779,12 +782,86 @@ void f2fs_destroy_extent_tree(struct inode *inode)
 bool f2fs_lookup_extent_cache(struct inode *inode, pgoff_t pgofs,
 					struct extent_info *ei)
 {
-	if (!f2fs_may_extent_tree(inode))
+	/* extents of compressed files only map whole clusters */
+	if (!f2fs_may_extent_tree(inode) || f2fs_compressed_file(inode))
 		return false;
 
 	return f2fs_lookup_extent_tree(inode, pgofs, ei);
 }
 
+/*
+ * Compressed clusters whose compressed blocks are contiguous are cached as
+ * one extent covering the cluster, with c_len telling the number of
+ * compressed blocks starting at blk.  That saves the dnode lookup when the
+ * cluster is read again.
+ */
+bool f2fs_lookup_cluster_extent(struct inode *inode, pgoff_t start_idx,
+					struct extent_info *ei)
+{
+	if (!f2fs_may_extent_tree(inode) || !f2fs_compressed_file(inode))
+		return false;
+
+	if (!f2fs_lookup_extent_tree(inode, start_idx, ei))
+		return false;
+
+	return ei->c_len && ei->fofs == start_idx;
+}
+
+/*
+ * Called with the dnode of the cluster locked, like every update of the block
+ * addresses, so the extent can't go stale before it is inserted.
+ */
+void f2fs_update_cluster_extent(struct inode *inode, pgoff_t start_idx,
+					block_t blkaddr, unsigned int c_len)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+	struct extent_tree *et = F2FS_I(inode)->extent_tree;
+	unsigned int cluster_size = F2FS_I(inode)->i_cluster_size;
+	struct extent_node *en, *prev_en = NULL, *next_en = NULL;
+	struct rb_node **insert_p = NULL, *insert_parent = NULL;
+	struct extent_info ei;
+	bool leftmost = false;
+
+	if (!et || !f2fs_may_extent_tree(inode) ||
+			!f2fs_compressed_file(inode))
+		return;
+
+	trace_f2fs_update_extent_tree_range(inode, start_idx, blkaddr,
+							cluster_size);
+
+	write_lock(&et->lock);
+
+	if (is_inode_flag_set(inode, FI_NO_EXTENT))
+		goto out;
+
+	en = (struct extent_node *)f2fs_lookup_rb_tree_ret(&et->root,
+					(struct rb_entry *)et->cached_en,
+					start_idx,
+					(struct rb_entry **)&prev_en,
+					(struct rb_entry **)&next_en,
+					&insert_p, &insert_parent, false,
+					&leftmost);
+	if (en || (next_en && next_en->ei.fofs < start_idx + cluster_size))
+		goto out;
+
+	set_extent_info(&ei, start_idx, blkaddr, cluster_size);
+	ei.c_len = c_len;
+	__insert_extent_tree(sbi, et, &ei, insert_p, insert_parent, leftmost);
+out:
+	write_unlock(&et->lock);
+}
+
+/* any change inside a compressed cluster drops the cluster's extent */
+static void f2fs_drop_cluster_extents(struct inode *inode, pgoff_t fofs,
+							unsigned int len)
+{
+	unsigned int cluster_size = F2FS_I(inode)->i_cluster_size;
+	pgoff_t start = round_down(fofs, cluster_size);
+
+	f2fs_update_extent_tree_range(inode, start, NULL_ADDR,
+				round_up(fofs + len, cluster_size) - start);
+}
+
 void f2fs_update_extent_cache(struct dnode_of_data *dn)
 {
 	pgoff_t fofs;
@@ -800,7 +877,10 @@ void f2fs_update_extent_cache(struct dnode_of_data *dn)
 
 	fofs = f2fs_start_bidx_of_node(ofs_of_node(dn->node_page), dn->inode) +
 								dn->ofs_in_node;
-	f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, 1);
+	if (f2fs_compressed_file(dn->inode))
+		f2fs_drop_cluster_extents(dn->inode, fofs, 1);
+	else
+		f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, 1);
 }
 
 void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
@@ -810,7 +890,10 @@ void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 	if (!f2fs_may_extent_tree(dn->inode))
 		return;
 
-	f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, len);
+	if (f2fs_compressed_file(dn->inode))
+		f2fs_drop_cluster_extents(dn->inode, fofs, len);
+	else
+		f2fs_update_extent_tree_range(dn->inode, fofs, blkaddr, len);
 }
 
 void f2fs_init_extent_cache_info(struct f2fs_sb_info *sbi)
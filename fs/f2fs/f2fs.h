@@ -437,6 +437,8 @@ static inline bool __has_cursum_space(struct f2fs_journal *journal,
 					_IOR(F2FS_IOCTL_MAGIC, 18, __u64)
 #define F2FS_IOC_RESERVE_COMPRESS_BLOCKS				\
 					_IOR(F2FS_IOCTL_MAGIC, 19, __u64)
+#define F2FS_IOC_RA_HINTS		_IOW(F2FS_IOCTL_MAGIC, 20,	\
+						struct f2fs_ra_hints)
 
 #define F2FS_IOC_GET_VOLUME_NAME	FS_IOC_GETFSLABEL
 #define F2FS_IOC_SET_VOLUME_NAME	FS_IOC_SETFSLABEL
@@ -491,6 +493,22 @@ struct f2fs_flush_device {
 	u32 segments;		/* # of segments to flush */
 };
 
+/* a range of an inode to be read ahead, e.g. before an app launch */
+struct f2fs_ra_hint {
+	u32 ino;		/* inode number */
+	u32 generation;		/* i_generation, 0: don't check */
+	u64 start;		/* start offset in bytes */
+	u64 len;		/* length in bytes */
+};
+
+#define F2FS_RA_HINTS_MAX	4096
+
+struct f2fs_ra_hints {
+	u64 hints;		/* user pointer to an array of f2fs_ra_hint */
+	u32 count;		/* # of entries in the array */
+	u32 flags;		/* must be zero */
+};
+
 /* for inline stuff */
 #define DEF_INLINE_RESERVED_SIZE	1
 static inline int get_extra_isize(struct inode *inode);
@@ -633,6 +651,7 @@ struct extent_info {
 	unsigned int fofs;		/* start offset in a file */
 	unsigned int len;		/* length of the extent */
 	u32 blk;			/* start block address of the extent */
+	unsigned int c_len;		/* compressed blocks, 0: not a cluster */
 };
 
 struct extent_node {
@@ -825,6 +844,7 @@ static inline void get_extent_info(struct extent_info *ext,
 	ext->fofs = le32_to_cpu(i_ext->fofs);
 	ext->blk = le32_to_cpu(i_ext->blk);
 	ext->len = le32_to_cpu(i_ext->len);
+	ext->c_len = 0;
 }
 
 static inline void set_raw_extent(struct extent_info *ext,
@@ -841,6 +861,7 @@ static inline void set_extent_info(struct extent_info *ei, unsigned int fofs,
 	ei->fofs = fofs;
 	ei->blk = blk;
 	ei->len = len;
+	ei->c_len = 0;
 }
 
 static inline bool __is_discard_mergeable(struct discard_info *back,
@@ -865,6 +886,9 @@ static inline bool __is_discard_front_mergeable(struct discard_info *cur,
 static inline bool __is_extent_mergeable(struct extent_info *back,
 						struct extent_info *front)
 {
+	/* a compressed cluster maps to its own blocks only */
+	if (back->c_len || front->c_len)
+		return false;
 	return (back->fofs + back->len == front->fofs &&
 			back->blk + back->len == front->blk);
 }
@@ -885,6 +909,9 @@ extern void f2fs_mark_inode_dirty_sync(struct inode *inode, bool sync);
 static inline void __try_update_largest_extent(struct extent_tree *et,
 						struct extent_node *en)
 {
+	/* the largest extent goes to disk, which knows no clusters */
+	if (en->ei.c_len)
+		return;
 	if (en->ei.len > et->largest.len) {
 		et->largest = en->ei;
 		et->largest_updated = true;
@@ -1120,6 +1147,14 @@ enum temp_type {
 	NR_TEMP_TYPE,
 };
 
+/* why a bio was submitted before the next page could join it */
+enum bio_split_type {
+	BIO_SPLIT_BLKADDR,	/* not contiguous, other device or IO type */
+	BIO_SPLIT_CRYPT,	/* other key or discontiguous DUN */
+	BIO_SPLIT_FULL,		/* no room left in the bio */
+	NR_BIO_SPLIT,
+};
+
 enum need_lock_type {
 	LOCK_REQ = 0,
 	LOCK_DONE,
@@ -1278,6 +1313,7 @@ enum {
 	GC_NORMAL,
 	GC_IDLE_CB,
 	GC_IDLE_GREEDY,
+	GC_IDLE_AT,
 	GC_URGENT,
 };
 
@@ -1398,6 +1434,7 @@ struct decompress_io_ctx {
 	bool failed;			/* indicate IO error during decompression */
 	void *private;			/* payload buffer for specified decompression algorithm */
 	void *private2;			/* extra payload buffer */
+	struct work_struct work;	/* for decompressing the cluster in parallel */
 };
 
 #define NULL_CLUSTER			((unsigned int)(~0))
@@ -1534,9 +1571,20 @@ struct f2fs_sb_info {
 
 	/* maximum # of trials to find a victim segment for SSR and GC */
 	unsigned int max_victim_search;
+	/* GC_AT: sections younger than this are not moved, unit: second */
+	unsigned int gc_age_threshold;
+	/* GC_AT: weight of age against free space in the benefit, in % */
+	unsigned int gc_age_weight;
 	/* migration granularity of garbage collection, unit: segment */
 	unsigned int migration_granularity;
 
+	/* background maintenance scheduling */
+	unsigned int user_active;		/* set by userspace, e.g. screen on */
+	unsigned int bg_budget_mb;		/* GC budget per hour, 0: no limit */
+	spinlock_t bg_budget_lock;		/* protects the two below */
+	long long bg_tokens;			/* blocks GC may still move */
+	unsigned long bg_refill_time;		/* jiffies of the last refill */
+
 	/*
 	 * for stat information.
 	 * one is for the LFS mode, and the other is for the SSR mode.
@@ -1551,6 +1599,7 @@ struct f2fs_sb_info {
 	atomic64_t read_hit_rbtree;		/* # of hit rbtree extent node */
 	atomic64_t read_hit_largest;		/* # of hit largest extent node */
 	atomic64_t read_hit_cached;		/* # of hit cached extent node */
+	atomic64_t bio_split[NR_BIO_SPLIT];	/* # of bios ended early */
 	atomic_t inline_xattr;			/* # of inline_xattr inodes */
 	atomic_t inline_inode;			/* # of inline_data inodes */
 	atomic_t inline_dir;			/* # of inline_dentry inodes */
@@ -2988,8 +3037,7 @@ static inline bool f2fs_may_extent_tree(struct inode *inode)
 	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
 
 	if (!test_opt(sbi, EXTENT_CACHE) ||
-			is_inode_flag_set(inode, FI_NO_EXTENT) ||
-			is_inode_flag_set(inode, FI_COMPRESSED_FILE))
+			is_inode_flag_set(inode, FI_NO_EXTENT))
 		return false;
 
 	/*
@@ -3459,6 +3507,8 @@ int f2fs_reserve_block(struct dnode_of_data *dn, pgoff_t index);
 int f2fs_mpage_readpages(struct address_space *mapping,
 			struct list_head *pages, struct page *page,
 			unsigned nr_pages, bool is_readahead);
+void f2fs_readahead_range(struct inode *inode, pgoff_t index,
+			unsigned long nr);
 struct page *f2fs_get_read_data_page(struct inode *inode, pgoff_t index,
 			int op_flags, bool for_write);
 struct page *f2fs_find_data_page(struct inode *inode, pgoff_t index);
@@ -3504,6 +3554,9 @@ int f2fs_gc(struct f2fs_sb_info *sbi, bool sync, bool background,
 			unsigned int segno);
 void f2fs_build_gc_manager(struct f2fs_sb_info *sbi);
 int f2fs_resize_fs(struct f2fs_sb_info *sbi, __u64 block_count);
+bool f2fs_bg_maint_allowed(struct f2fs_sb_info *sbi, bool budget);
+void f2fs_bg_maint_charge(struct f2fs_sb_info *sbi, block_t blocks);
+void f2fs_bg_maint_reset_budget(struct f2fs_sb_info *sbi);
 
 /*
  * recovery.c
@@ -3522,6 +3575,7 @@ struct f2fs_stat_info {
 	int main_area_segs, main_area_sections, main_area_zones;
 	unsigned long long hit_largest, hit_cached, hit_rbtree;
 	unsigned long long hit_total, total_ext;
+	unsigned long long bio_split[NR_BIO_SPLIT];
 	int ext_tree, zombie_tree, ext_node;
 	int ndirty_node, ndirty_dent, ndirty_meta, ndirty_imeta;
 	int ndirty_data, ndirty_qdata;
@@ -3580,6 +3634,7 @@ static inline struct f2fs_stat_info *F2FS_STAT(struct f2fs_sb_info *sbi)
 #define stat_inc_rbtree_node_hit(sbi)	(atomic64_inc(&(sbi)->read_hit_rbtree))
 #define stat_inc_largest_node_hit(sbi)	(atomic64_inc(&(sbi)->read_hit_largest))
 #define stat_inc_cached_node_hit(sbi)	(atomic64_inc(&(sbi)->read_hit_cached))
+#define stat_inc_bio_split(sbi, type)	(atomic64_inc(&(sbi)->bio_split[type]))
 #define stat_inc_inline_xattr(inode)					\
 	do {								\
 		if (f2fs_has_inline_xattr(inode))			\
@@ -3709,6 +3764,7 @@ void f2fs_update_sit_info(struct f2fs_sb_info *sbi);
 #define stat_inc_rbtree_node_hit(sbi)			do { } while (0)
 #define stat_inc_largest_node_hit(sbi)			do { } while (0)
 #define stat_inc_cached_node_hit(sbi)			do { } while (0)
+#define stat_inc_bio_split(sbi, type)			do { } while (0)
 #define stat_inc_inline_xattr(inode)			do { } while (0)
 #define stat_dec_inline_xattr(inode)			do { } while (0)
 #define stat_inc_inline_inode(inode)			do { } while (0)
@@ -3817,6 +3873,10 @@ unsigned int f2fs_destroy_extent_node(struct inode *inode);
 void f2fs_destroy_extent_tree(struct inode *inode);
 bool f2fs_lookup_extent_cache(struct inode *inode, pgoff_t pgofs,
 			struct extent_info *ei);
+bool f2fs_lookup_cluster_extent(struct inode *inode, pgoff_t start_idx,
+			struct extent_info *ei);
+void f2fs_update_cluster_extent(struct inode *inode, pgoff_t start_idx,
+			block_t blkaddr, unsigned int c_len);
 void f2fs_update_extent_cache(struct dnode_of_data *dn);
 void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 			pgoff_t fofs, block_t blkaddr, unsigned int len);
@@ -3877,6 +3937,10 @@ bool f2fs_is_compress_backend_ready(struct inode *inode);
 int f2fs_init_compress_mempool(void);
 void f2fs_destroy_compress_mempool(void);
 void f2fs_decompress_pages(struct bio *bio, struct page *page, bool verity);
+struct decompress_io_ctx *f2fs_end_compressed_page(struct bio *bio,
+							struct page *page);
+void f2fs_decompress_cluster(struct decompress_io_ctx *dic, bool verity);
+void f2fs_queue_decompress_cluster(struct decompress_io_ctx *dic);
 bool f2fs_cluster_is_empty(struct compress_ctx *cc);
 bool f2fs_cluster_can_merge_page(struct compress_ctx *cc, pgoff_t index);
 void f2fs_compress_ctx_add_page(struct compress_ctx *cc, struct page *page);
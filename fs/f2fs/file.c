@@ -21,6 +21,7 @@
 #include <linux/uuid.h>
 #include <linux/file.h>
 #include <linux/nls.h>
+#include <linux/sort.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -2965,6 +2966,7 @@ static int f2fs_ioc_flush_device(struct file *filp, unsigned long arg)
 		}
 		sm->last_victim[GC_CB] = end_segno + 1;
 		sm->last_victim[GC_GREEDY] = end_segno + 1;
+		sm->last_victim[GC_AT] = end_segno + 1;
 		sm->last_victim[ALLOC_NEXT] = end_segno + 1;
 		ret = f2fs_gc(sbi, true, true, start_segno);
 		if (ret == -EAGAIN)
@@ -3773,6 +3775,132 @@ static int f2fs_reserve_compress_blocks(struct file *filp, unsigned long arg)
 	return ret;
 }
 
+static int f2fs_ra_hint_cmp(const void *a, const void *b)
+{
+	const struct f2fs_ra_hint *ha = a, *hb = b;
+
+	if (ha->ino != hb->ino)
+		return ha->ino < hb->ino ? -1 : 1;
+	if (ha->start != hb->start)
+		return ha->start < hb->start ? -1 : 1;
+	return 0;
+}
+
+static struct inode *f2fs_ra_hint_iget(struct f2fs_sb_info *sbi,
+						struct f2fs_ra_hint *hint)
+{
+	struct inode *inode;
+
+	if (hint->ino < F2FS_ROOT_INO(sbi) || hint->ino >= NM_I(sbi)->max_nid)
+		return NULL;
+
+	inode = f2fs_iget(sbi->sb, hint->ino);
+	if (IS_ERR(inode))
+		return NULL;
+
+	if (is_bad_inode(inode) || !S_ISREG(inode->i_mode) ||
+		(hint->generation &&
+			hint->generation != inode->i_generation) ||
+		(IS_ENCRYPTED(inode) && !fscrypt_has_encryption_key(inode))) {
+		iput(inode);
+		return NULL;
+	}
+	return inode;
+}
+
+/*
+ * Read ahead a batch of (inode, range) hints in one call, e.g. the files an
+ * app touches while launching.  Hints are sorted and overlapping ranges of an
+ * inode are merged, so every range is read once and in file order, and all of
+ * them are issued under a single plug.  Hints naming inodes that no longer
+ * exist or were reused are ignored.
+ */
+static int f2fs_ioc_ra_hints(struct file *filp, unsigned long arg)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(file_inode(filp));
+	struct f2fs_ra_hints req;
+	struct f2fs_ra_hint *hints;
+	struct blk_plug plug;
+	unsigned int i = 0;
+	size_t size;
+	int ret = 0;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (copy_from_user(&req, (struct f2fs_ra_hints __user *)arg,
+							sizeof(req)))
+		return -EFAULT;
+
+	if (req.flags || !req.count || req.count > F2FS_RA_HINTS_MAX)
+		return -EINVAL;
+
+	size = sizeof(struct f2fs_ra_hint) * req.count;
+	hints = f2fs_kvmalloc(sbi, size, GFP_KERNEL);
+	if (!hints)
+		return -ENOMEM;
+
+	if (copy_from_user(hints, u64_to_user_ptr(req.hints), size)) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	for (i = 0; i < req.count; i++) {
+		if (!hints[i].len || hints[i].start + hints[i].len <
+							hints[i].start) {
+			ret = -EINVAL;
+			goto out;
+		}
+	}
+
+	sort(hints, req.count, sizeof(*hints), f2fs_ra_hint_cmp, NULL);
+
+	blk_start_plug(&plug);
+	i = 0;
+	while (i < req.count) {
+		u32 ino = hints[i].ino;
+		struct inode *inode = f2fs_ra_hint_iget(sbi, &hints[i]);
+		pgoff_t start = 0, end = 0;
+		bool pending = false;
+
+		for (; i < req.count && hints[i].ino == ino; i++) {
+			pgoff_t s = hints[i].start >> PAGE_SHIFT;
+			pgoff_t e = (hints[i].start + hints[i].len - 1) >>
+								PAGE_SHIFT;
+
+			if (!inode)
+				continue;
+
+			if (pending && s <= end + 1) {
+				end = max(end, e);
+				continue;
+			}
+			if (pending)
+				f2fs_readahead_range(inode, start,
+							end - start + 1);
+			start = s;
+			end = e;
+			pending = true;
+		}
+
+		if (inode) {
+			if (pending)
+				f2fs_readahead_range(inode, start,
+							end - start + 1);
+			iput(inode);
+		}
+
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+	}
+	blk_finish_plug(&plug);
+out:
+	kvfree(hints);
+	return ret;
+}
+
 long f2fs_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 {
 	if (unlikely(f2fs_cp_error(F2FS_I_SB(file_inode(filp)))))
@@ -3859,6 +3987,8 @@ long f2fs_ioctl(struct file *filp, unsigned int cmd, unsigned long arg)
 		return f2fs_release_compress_blocks(filp, arg);
 	case F2FS_IOC_RESERVE_COMPRESS_BLOCKS:
 		return f2fs_reserve_compress_blocks(filp, arg);
+	case F2FS_IOC_RA_HINTS:
+		return f2fs_ioc_ra_hints(filp, arg);
 	default:
 		return -ENOTTY;
 	}
@@ -4027,6 +4157,7 @@ long f2fs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case F2FS_IOC_GET_COMPRESS_BLOCKS:
 	case F2FS_IOC_RELEASE_COMPRESS_BLOCKS:
 	case F2FS_IOC_RESERVE_COMPRESS_BLOCKS:
+	case F2FS_IOC_RA_HINTS:
 		break;
 	default:
 		return -ENOIOCTLCMD;
@@ -4035,6 +4166,23 @@ long f2fs_compat_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 }
 #endif
 
+/*
+ * Polled completion for IORING_SETUP_IOPOLL direct IO.  The cookie is the
+ * last bio the DIO submitted; on a multi-device filesystem it may belong to
+ * another queue than s_bdev's, so completions are then left to the interrupt.
+ */
+static int f2fs_file_iopoll(struct kiocb *iocb, bool spin)
+{
+	struct inode *inode = file_inode(iocb->ki_filp);
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+
+	if (f2fs_is_multi_device(sbi))
+		return 0;
+
+	return blk_poll(bdev_get_queue(sbi->sb->s_bdev),
+			READ_ONCE(iocb->ki_cookie), spin);
+}
+
 const struct file_operations f2fs_file_operations = {
 	.llseek		= f2fs_llseek,
 	.read_iter	= f2fs_file_read_iter,
@@ -4051,4 +4199,5 @@ const struct file_operations f2fs_file_operations = {
 #endif
 	.splice_read	= generic_file_splice_read,
 	.splice_write	= iter_file_splice_write,
+	.iopoll		= f2fs_file_iopoll,
 };
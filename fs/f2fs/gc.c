@@ -97,6 +97,13 @@ static int gc_thread_func(void *data)
 			goto next;
 		}
 
+		if (!f2fs_bg_maint_allowed(sbi, true)) {
+			wait_ms = gc_th->max_sleep_time;
+			up_write(&sbi->gc_lock);
+			stat_other_skip_bggc_count(sbi);
+			goto next;
+		}
+
 		if (has_enough_invalid_blocks(sbi))
 			decrease_sleep_time(gc_th, &wait_ms);
 		else
@@ -164,6 +171,66 @@ void f2fs_stop_gc_thread(struct f2fs_sb_info *sbi)
 	sbi->gc_thread = NULL;
 }
 
+/* one hour worth of budget, in blocks */
+static long long bg_budget_blocks(struct f2fs_sb_info *sbi)
+{
+	return (long long)sbi->bg_budget_mb <<
+				(20 - sbi->log_blocksize);
+}
+
+void f2fs_bg_maint_reset_budget(struct f2fs_sb_info *sbi)
+{
+	spin_lock(&sbi->bg_budget_lock);
+	sbi->bg_tokens = bg_budget_blocks(sbi);
+	sbi->bg_refill_time = jiffies;
+	spin_unlock(&sbi->bg_budget_lock);
+}
+
+/*
+ * Background GC, discard and checkpoint all ask here before doing work on
+ * their own.  Maintenance is held back while the user interacts with the
+ * device, and background GC is limited to bg_budget_mb of migrated data per
+ * hour.  Running out of free space overrides both.
+ */
+bool f2fs_bg_maint_allowed(struct f2fs_sb_info *sbi, bool budget)
+{
+	long long hourly, added;
+	unsigned long now;
+	bool allowed;
+
+	if (sbi->gc_mode == GC_URGENT || !free_user_blocks(sbi))
+		return true;
+	if (READ_ONCE(sbi->user_active))
+		return false;
+	if (!budget || !sbi->bg_budget_mb)
+		return true;
+
+	hourly = bg_budget_blocks(sbi);
+	now = jiffies;
+
+	spin_lock(&sbi->bg_budget_lock);
+	added = div_u64((u64)hourly * (now - sbi->bg_refill_time),
+						3600 * HZ);
+	if (added) {
+		sbi->bg_tokens = min(sbi->bg_tokens + added, hourly);
+		sbi->bg_refill_time = now;
+	}
+	allowed = sbi->bg_tokens > 0;
+	spin_unlock(&sbi->bg_budget_lock);
+
+	return allowed;
+}
+
+void f2fs_bg_maint_charge(struct f2fs_sb_info *sbi, block_t blocks)
+{
+	if (!sbi->bg_budget_mb)
+		return;
+
+	spin_lock(&sbi->bg_budget_lock);
+	sbi->bg_tokens -= blocks;
+	spin_unlock(&sbi->bg_budget_lock);
+}
+
 static int select_gc_type(struct f2fs_sb_info *sbi, int gc_type)
 {
 	int gc_mode = (gc_type == BG_GC) ? GC_CB : GC_GREEDY;
@@ -176,6 +243,9 @@ static int select_gc_type(struct f2fs_sb_info *sbi, int gc_type)
 	case GC_URGENT:
 		gc_mode = GC_GREEDY;
 		break;
+	case GC_IDLE_AT:
+		gc_mode = GC_AT;
+		break;
 	}
 	return gc_mode;
 }
@@ -222,7 +292,7 @@ static unsigned int get_max_cost(struct f2fs_sb_info *sbi,
 		return sbi->blocks_per_seg;
 	if (p->gc_mode == GC_GREEDY)
 		return 2 * sbi->blocks_per_seg * p->ofs_unit;
-	else if (p->gc_mode == GC_CB)
+	else if (p->gc_mode == GC_CB || p->gc_mode == GC_AT)
 		return UINT_MAX;
 	else /* No other gc_mode */
 		return 0;
@@ -247,40 +317,110 @@ static unsigned int check_bg_victims(struct f2fs_sb_info *sbi)
 	return NULL_SEGNO;
 }
 
-static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
+static unsigned long long get_section_mtime(struct f2fs_sb_info *sbi,
+						unsigned int segno)
 {
-	struct sit_info *sit_i = SIT_I(sbi);
-	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
-	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+	unsigned int start = GET_SEG_FROM_SEC(sbi,
+					GET_SEC_FROM_SEG(sbi, segno));
 	unsigned long long mtime = 0;
-	unsigned int vblocks;
-	unsigned char age = 0;
-	unsigned char u;
 	unsigned int i;
 
 	for (i = 0; i < sbi->segs_per_sec; i++)
 		mtime += get_seg_entry(sbi, start + i)->mtime;
-	vblocks = get_valid_blocks(sbi, segno, true);
 
-	mtime = div_u64(mtime, sbi->segs_per_sec);
+	return div_u64(mtime, sbi->segs_per_sec);
+}
+
+/* utilization of the section in percentage */
+static unsigned char get_section_usage(struct f2fs_sb_info *sbi,
+						unsigned int segno)
+{
+	unsigned int vblocks = get_valid_blocks(sbi, segno, true);
+
 	vblocks = div_u64(vblocks, sbi->segs_per_sec);
+	return (vblocks * 100) >> sbi->log_blocks_per_seg;
+}
 
-	u = (vblocks * 100) >> sbi->log_blocks_per_seg;
+/* age of mtime in percentage of the current mtime distribution */
+static unsigned char get_section_age(struct f2fs_sb_info *sbi,
+						unsigned long long mtime)
+{
+	struct sit_info *sit_i = SIT_I(sbi);
 
 	/* Handle if the system time has changed by the user */
 	if (mtime < sit_i->min_mtime)
 		sit_i->min_mtime = mtime;
 	if (mtime > sit_i->max_mtime)
 		sit_i->max_mtime = mtime;
-	if (sit_i->max_mtime != sit_i->min_mtime)
-		age = 100 - div64_u64(100 * (mtime - sit_i->min_mtime),
+	if (sit_i->max_mtime == sit_i->min_mtime)
+		return 0;
+	return 100 - div64_u64(100 * (mtime - sit_i->min_mtime),
 				sit_i->max_mtime - sit_i->min_mtime);
+}
+
+static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	unsigned long long mtime = get_section_mtime(sbi, segno);
+	unsigned char age = get_section_age(sbi, mtime);
+	unsigned char u = get_section_usage(sbi, segno);
 
 	return UINT_MAX - ((100 * (100 - u) * age) / (100 + u));
 }
 
+/*
+ * Hot data outlives its age less often than cold data, so scale the age of a
+ * section by the temperature of the log that wrote it.
+ */
+static unsigned int get_temp_weight(struct f2fs_sb_info *sbi,
+						unsigned int segno)
+{
+	switch (get_seg_entry(sbi, segno)->type) {
+	case CURSEG_HOT_DATA:
+	case CURSEG_HOT_NODE:
+		return 50;
+	case CURSEG_COLD_DATA:
+	case CURSEG_COLD_NODE:
+		return 150;
+	default:
+		return 100;
+	}
+}
+
+static unsigned int get_at_cost(struct f2fs_sb_info *sbi, unsigned int segno,
+						int gc_type)
+{
+	unsigned long long mtime = get_section_mtime(sbi, segno);
+	unsigned long long now = get_mtime(sbi, false);
+	unsigned int weight = get_temp_weight(sbi, segno);
+	unsigned char u = get_section_usage(sbi, segno);
+	unsigned long long age_sec;
+	unsigned int age, benefit;
+
+	age_sec = now > mtime ? now - mtime : 0;
+	age_sec = div_u64(age_sec * weight, 100);
+
+	/*
+	 * Young data is likely to be invalidated by the user soon, moving it
+	 * is mostly wasted writes.  Background GC leaves it alone, foreground
+	 * GC only takes it when nothing older is dirty, emptiest first.
+	 */
+	if (age_sec < sbi->gc_age_threshold) {
+		if (gc_type == BG_GC)
+			return UINT_MAX;
+		return UINT_MAX - 1 - (100 - u);
+	}
+
+	age = min_t(unsigned int,
+		    div_u64(get_section_age(sbi, mtime) * weight, 100), 100);
+	benefit = sbi->gc_age_weight * age +
+		  (100 - sbi->gc_age_weight) * (100 - u);
+
+	return UINT_MAX - 102 - benefit;
+}
+
 static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
-			unsigned int segno, struct victim_sel_policy *p)
+			unsigned int segno, struct victim_sel_policy *p,
+			int gc_type)
 {
 	if (p->alloc_mode == SSR)
 		return get_seg_entry(sbi, segno)->ckpt_valid_blocks;
@@ -288,6 +428,8 @@ static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
 	/* alloc_mode == LFS */
 	if (p->gc_mode == GC_GREEDY)
 		return get_valid_blocks(sbi, segno, true);
+	else if (p->gc_mode == GC_AT)
+		return get_at_cost(sbi, segno, gc_type);
 	else
 		return get_cb_cost(sbi, segno);
 }
@@ -412,7 +554,7 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 		if (gc_type == BG_GC && test_bit(secno, dirty_i->victim_secmap))
 			goto next;
 
-		cost = get_gc_cost(sbi, segno, &p);
+		cost = get_gc_cost(sbi, segno, &p, gc_type);
 
 		if (p.min_cost > cost) {
 			p.min_segno = segno;
@@ -1242,6 +1384,10 @@ static int do_garbage_collect(struct f2fs_sb_info *sbi,
 		 *   - down_read(sentry_lock)     - change_curseg()
 		 *                                  - lock_page(sum_page)
 		 */
+		if (gc_type == BG_GC)
+			f2fs_bg_maint_charge(sbi,
+					get_valid_blocks(sbi, segno, false));
+
 		if (type == SUM_TYPE_NODE)
 			submitted += gc_node_segment(sbi, sum->entries, segno,
 								gc_type);
@@ -539,7 +539,8 @@ void f2fs_balance_fs_bg(struct f2fs_sb_info *sbi, bool from_bg)
 			excess_prefree_segs(sbi) ||
 			excess_dirty_nats(sbi) ||
 			excess_dirty_nodes(sbi) ||
-			f2fs_time_over(sbi, CP_TIME)) {
+			(f2fs_time_over(sbi, CP_TIME) &&
+			 (!from_bg || f2fs_bg_maint_allowed(sbi, false)))) {
 		if (test_opt(sbi, DATA_FLUSH) && from_bg) {
 			struct blk_plug plug;
 
@@ -1736,6 +1737,10 @@ static int issue_discard_thread(void *data)
 		if (sbi->gc_mode == GC_URGENT ||
 			!f2fs_available_free_memory(sbi, DISCARD_CACHE))
 			__init_discard_policy(sbi, &dpolicy, DPOLICY_FORCE, 1);
+		else if (!f2fs_bg_maint_allowed(sbi, false)) {
+			wait_ms = dpolicy.max_interval;
+			continue;
+		}
 
 		sb_start_intwrite(sbi->sb);
 
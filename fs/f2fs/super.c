@@ -31,6 +31,9 @@
 #include "xattr.h"
 #include "gc.h"
 #include "trace.h"
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+#include <soc/qcom/boot_stats.h>
+#endif
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/f2fs.h>
@@ -3036,6 +3039,10 @@ static void init_sb_info(struct f2fs_sb_info *sbi)
 	sbi->next_victim_seg[BG_GC] = NULL_SEGNO;
 	sbi->next_victim_seg[FG_GC] = NULL_SEGNO;
 	sbi->max_victim_search = DEF_MAX_VICTIM_SEARCH;
+	sbi->gc_age_threshold = DEF_GC_AGE_THRESHOLD;
+	sbi->gc_age_weight = DEF_GC_AGE_WEIGHT;
+	spin_lock_init(&sbi->bg_budget_lock);
+	sbi->bg_refill_time = jiffies;
 	sbi->migration_granularity = sbi->segs_per_sec;
 
 	sbi->dir_level = DEF_DIR_LEVEL;
@@ -3876,7 +3883,18 @@ static int f2fs_fill_super(struct super_block *sb, void *data, int silent)
 static struct dentry *f2fs_mount(struct file_system_type *fs_type, int flags,
 			const char *dev_name, void *data)
 {
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	u64 boot_ev = boot_event_start();
+	struct dentry *root;
+
+	root = mount_bdev(fs_type, flags, dev_name, data, f2fs_fill_super);
+	if (!IS_ERR(root))
+		boot_event_record(BOOT_EVENT_MOUNT, kbasename(dev_name),
+				  boot_ev);
+	return root;
+#else
 	return mount_bdev(fs_type, flags, dev_name, data, f2fs_fill_super);
+#endif
 }
 
 static void kill_f2fs_super(struct super_block *sb)
@@ -351,6 +351,9 @@ static ssize_t __sbi_store(struct f2fs_attr *a,
 	if (!strcmp(a->attr.name, "trim_sections"))
 		return -EINVAL;
 
+	if (!strcmp(a->attr.name, "gc_age_weight") && t > 100)
+		return -EINVAL;
+
 	if (!strcmp(a->attr.name, "gc_urgent")) {
 		if (t >= 1) {
 			sbi->gc_mode = GC_URGENT;
@@ -365,11 +368,32 @@ static ssize_t __sbi_store(struct f2fs_attr *a,
 		}
 		return count;
 	}
+	if (!strcmp(a->attr.name, "user_active")) {
+		sbi->user_active = !!t;
+		/* catch up with the maintenance held back meanwhile */
+		if (!t && sbi->gc_thread) {
+			sbi->gc_thread->gc_wake = 1;
+			wake_up_interruptible_all(
+				&sbi->gc_thread->gc_wait_queue_head);
+		}
+		if (!t)
+			wake_up_discard_thread(sbi, true);
+		return count;
+	}
+
+	if (!strcmp(a->attr.name, "bg_budget_mb")) {
+		sbi->bg_budget_mb = t;
+		f2fs_bg_maint_reset_budget(sbi);
+		return count;
+	}
+
 	if (!strcmp(a->attr.name, "gc_idle")) {
 		if (t == GC_IDLE_CB)
 			sbi->gc_mode = GC_IDLE_CB;
 		else if (t == GC_IDLE_GREEDY)
 			sbi->gc_mode = GC_IDLE_GREEDY;
+		else if (t == GC_IDLE_AT)
+			sbi->gc_mode = GC_IDLE_AT;
 		else
 			sbi->gc_mode = GC_NORMAL;
 		return count;
@@ -402,6 +426,7 @@ static ssize_t f2fs_sbi_store(struct f2fs_attr *a,
 {
 	ssize_t ret;
 	bool gc_entry = (!strcmp(a->attr.name, "gc_urgent") ||
+			!strcmp(a->attr.name, "user_active") ||
 					a->struct_type == GC_THREAD);
 
 	if (gc_entry) {
@@ -541,6 +566,10 @@ F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, ram_thresh, ram_thresh);
 F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, ra_nid_pages, ra_nid_pages);
 F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, dirty_nats_ratio, dirty_nats_ratio);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, max_victim_search, max_victim_search);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, gc_age_threshold, gc_age_threshold);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, gc_age_weight, gc_age_weight);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, user_active, user_active);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, bg_budget_mb, bg_budget_mb);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, migration_granularity, migration_granularity);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, dir_level, dir_level);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, cp_interval, interval_time[CP_TIME]);
@@ -628,6 +657,10 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(min_hot_blocks),
 	ATTR_LIST(min_ssr_sections),
 	ATTR_LIST(max_victim_search),
+	ATTR_LIST(gc_age_threshold),
+	ATTR_LIST(gc_age_weight),
+	ATTR_LIST(user_active),
+	ATTR_LIST(bg_budget_mb),
 	ATTR_LIST(migration_granularity),
 	ATTR_LIST(dir_level),
 	ATTR_LIST(ram_thresh),
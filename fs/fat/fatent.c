@@ -461,6 +461,27 @@ static void fat_collect_bhs(struct buffer_head **bhs, int *nr_bhs,
 	}
 }
 
+/* 128kb is the whole sectors for FAT12 and FAT16 */
+#define FAT_READA_SIZE		(128 * 1024)
+
+static void fat_ent_reada(struct super_block *sb, struct fat_entry *fatent,
+			  unsigned long reada_blocks)
+{
+	struct msdos_sb_info *sbi = MSDOS_SB(sb);
+	const struct fatent_operations *ops = sbi->fatent_ops;
+	sector_t blocknr;
+	int i, offset;
+
+	ops->ent_blocknr(sb, fatent->entry, &offset, &blocknr);
+
+	/* don't read past the end of the first FAT */
+	if (blocknr + reada_blocks > sbi->fat_start + sbi->fat_length)
+		reada_blocks = sbi->fat_start + sbi->fat_length - blocknr;
+
+	for (i = 0; i < reada_blocks; i++)
+		sb_breadahead(sb, blocknr + i);
+}
+
 int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 {
 	struct super_block *sb = inode->i_sb;
@@ -468,6 +489,7 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 	const struct fatent_operations *ops = sbi->fatent_ops;
 	struct fat_entry fatent, prev_ent;
 	struct buffer_head *bhs[MAX_BUF_PER_PAGE];
+	unsigned long reada_blocks, nr_blocks = 0;
 	int i, count, err, nr_bhs, idx_clus;
 
 	BUG_ON(nr_cluster > (MAX_BUF_PER_PAGE / 2));	/* fixed limit */
@@ -481,6 +503,7 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 
 	err = nr_bhs = idx_clus = 0;
 	count = FAT_START_ENT;
+	reada_blocks = FAT_READA_SIZE >> sb->s_blocksize_bits;
 	fatent_init(&prev_ent);
 	fatent_init(&fatent);
 	fatent_set_entry(&fatent, sbi->prev_free + 1);
@@ -488,6 +511,15 @@ int fat_alloc_clusters(struct inode *inode, int *cluster, int nr_cluster)
 		if (fatent.entry >= sbi->max_cluster)
 			fatent.entry = FAT_START_ENT;
 		fatent_set_entry(&fatent, fatent.entry);
+		/*
+		 * The FAT block after prev_free almost always has a free entry.
+		 * If the scan has to go on, the area is full (e.g. a card that
+		 * was filled up and partly emptied); read the FAT ahead rather
+		 * than waiting for it one block at a time.
+		 */
+		if (nr_blocks % reada_blocks == 1)
+			fat_ent_reada(sb, &fatent, reada_blocks);
+		nr_blocks++;
 		err = fat_ent_read_block(sb, &fatent);
 		if (err)
 			goto out;
@@ -632,22 +664,6 @@ int fat_free_clusters(struct inode *inode, int cluster)
 }
 EXPORT_SYMBOL_GPL(fat_free_clusters);
 
-/* 128kb is the whole sectors for FAT12 and FAT16 */
-#define FAT_READA_SIZE		(128 * 1024)
-
-static void fat_ent_reada(struct super_block *sb, struct fat_entry *fatent,
-			  unsigned long reada_blocks)
-{
-	const struct fatent_operations *ops = MSDOS_SB(sb)->fatent_ops;
-	sector_t blocknr;
-	int i, offset;
-
-	ops->ent_blocknr(sb, fatent->entry, &offset, &blocknr);
-
-	for (i = 0; i < reada_blocks; i++)
-		sb_breadahead(sb, blocknr + i);
-}
-
 int fat_count_free_clusters(struct super_block *sb)
 {
 	struct msdos_sb_info *sbi = MSDOS_SB(sb);
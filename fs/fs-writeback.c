@@ -1832,6 +1832,52 @@ static long writeback_inodes_wb(struct bdi_writeback *wb, long nr_pages,
 	return nr_pages - work.nr_pages;
 }
 
+/*
+ * How long a foreground latency miss reported by wbt keeps background
+ * writeback held back, and how often a held back wb checks again
+ */
+#define WB_DEFER_WINDOW		(HZ / 5)
+
+/*
+ * Background and periodic writeback compete with foreground reads and sync
+ * writes for the device. Hold them back while foreground IO misses its
+ * latency target, but for no longer than dirty_defer_interval in a row and
+ * not at all once dirty memory is halfway from the background to the
+ * dirty threshold, so dirty pages cannot pile up behind the deferral.
+ */
+static bool wb_defer_for_foreground(struct bdi_writeback *wb)
+{
+	unsigned long stamp = READ_ONCE(wb->bdi->fg_lat_exceeded);
+	unsigned long bg_thresh, thresh, nr_dirty;
+
+	if (!dirty_defer_interval || !stamp ||
+	    time_after(jiffies, stamp + WB_DEFER_WINDOW)) {
+		wb->defer_start = 0;
+		return false;
+	}
+
+	/* Once the budget is used up, wait for latency to recover */
+	if (!wb->defer_start)
+		wb->defer_start = jiffies;
+	else if (time_after(jiffies, wb->defer_start +
+			    msecs_to_jiffies(dirty_defer_interval * 10)))
+		return false;
+
+	global_dirty_limits(&bg_thresh, &thresh);
+	nr_dirty = global_node_page_state(NR_FILE_DIRTY) +
+		   global_node_page_state(NR_UNSTABLE_NFS);
+
+	return nr_dirty <= bg_thresh + (thresh - bg_thresh) / 2;
+}
+
+static void wb_wakeup_deferred(struct bdi_writeback *wb)
+{
+	spin_lock_bh(&wb->work_lock);
+	if (test_bit(WB_registered, &wb->state))
+		mod_delayed_work(bdi_wq, &wb->dwork, WB_DEFER_WINDOW);
+	spin_unlock_bh(&wb->work_lock);
+}
+
 /*
  * Explicit flushing or periodic writeback of "old" data.
  *
@@ -1855,6 +1901,7 @@ static long wb_writeback(struct bdi_writeback *wb,
 	unsigned long dirtied_before = jiffies;
 	struct inode *inode;
 	long progress;
+	bool deferred = false;
 	struct blk_plug plug;
 
 	blk_start_plug(&plug);
@@ -1883,6 +1930,18 @@ static long wb_writeback(struct bdi_writeback *wb,
 		if (work->for_background && !wb_over_bg_thresh(wb))
 			break;
 
+		/*
+		 * Let foreground IO that is missing its latency target go
+		 * first. We get kicked again to check whether it recovered.
+		 */
+		if ((work->for_background || work->for_kupdate) &&
+		    wb_defer_for_foreground(wb)) {
+			wb->nr_deferred++;
+			trace_writeback_defer(wb, work);
+			deferred = true;
+			break;
+		}
+
 		/*
 		 * Kupdate and background works are special and we want to
 		 * include all inodes that need writing. Livelock avoidance is
@@ -1937,6 +1996,9 @@ static long wb_writeback(struct bdi_writeback *wb,
 	spin_unlock(&wb->list_lock);
 	blk_finish_plug(&plug);
 
+	if (deferred)
+		wb_wakeup_deferred(wb);
+
 	return nr_pages - work->nr_pages;
 }
 
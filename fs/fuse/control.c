@@ -11,6 +11,7 @@
 #include <linux/init.h>
 #include <linux/module.h>
 #include <linux/fs_context.h>
+#include <linux/slab.h>
 
 #define FUSE_CTL_SUPER_MAGIC 0x65735543
 
@@ -191,6 +192,58 @@ static ssize_t fuse_conn_congestion_threshold_write(struct file *file,
 	return ret;
 }
 
+static ssize_t fuse_conn_latency_read(struct file *file, char __user *buf,
+				      size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc;
+	char *tmp;
+	size_t size;
+	ssize_t ret;
+	int i;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	tmp = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!tmp) {
+		fuse_conn_put(fc);
+		return -ENOMEM;
+	}
+
+	size = scnprintf(tmp, PAGE_SIZE, "%8s %10s %10s\n",
+			 "us", "queue", "reply");
+	for (i = 0; i < FUSE_LAT_BUCKETS; i++)
+		size += scnprintf(tmp + size, PAGE_SIZE - size,
+				  "%7u%c %10d %10d\n", 1U << i,
+				  i == FUSE_LAT_BUCKETS - 1 ? '+' : ' ',
+				  atomic_read(&fc->lat_queue[i]),
+				  atomic_read(&fc->lat_reply[i]));
+	fuse_conn_put(fc);
+
+	ret = simple_read_from_buffer(buf, len, ppos, tmp, size);
+	kfree(tmp);
+	return ret;
+}
+
+/* Any write clears the histograms */
+static ssize_t fuse_conn_latency_write(struct file *file,
+				       const char __user *buf,
+				       size_t count, loff_t *ppos)
+{
+	struct fuse_conn *fc = fuse_ctl_file_conn_get(file);
+	int i;
+
+	if (fc) {
+		for (i = 0; i < FUSE_LAT_BUCKETS; i++) {
+			atomic_set(&fc->lat_queue[i], 0);
+			atomic_set(&fc->lat_reply[i], 0);
+		}
+		fuse_conn_put(fc);
+	}
+	return count;
+}
+
 static const struct file_operations fuse_ctl_abort_ops = {
 	.open = nonseekable_open,
 	.write = fuse_conn_abort_write,
@@ -217,6 +270,13 @@ static const struct file_operations fuse_conn_congestion_threshold_ops = {
 	.llseek = no_llseek,
 };
 
+static const struct file_operations fuse_conn_latency_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_latency_read,
+	.write = fuse_conn_latency_write,
+	.llseek = no_llseek,
+};
+
 static struct dentry *fuse_ctl_add_dentry(struct dentry *parent,
 					  struct fuse_conn *fc,
 					  const char *name,
@@ -285,7 +345,9 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "latency", S_IFREG | 0600, 1,
+				 NULL, &fuse_conn_latency_ops))
 		goto err;
 
 	return 0;
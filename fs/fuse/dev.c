@@ -22,6 +22,7 @@
 #include <linux/swap.h>
 #include <linux/splice.h>
 #include <linux/sched.h>
+#include <linux/log2.h>
 
 MODULE_ALIAS_MISCDEV(FUSE_MINOR);
 MODULE_ALIAS("devname:fuse");
@@ -229,10 +230,18 @@ __releases(fiq->lock)
 	req->in.h.len = sizeof(struct fuse_in_header) +
 		fuse_len_args(req->args->in_numargs,
 			      (struct fuse_arg *) req->args->in_args);
+	req->queue_time = ktime_get();
 	list_add_tail(&req->list, &fiq->pending);
 	fiq->ops->wake_pending_and_unlock(fiq, sync);
 }
 
+static void fuse_lat_account(atomic_t *hist, s64 us)
+{
+	unsigned int bucket = us > 1 ? ilog2(us) : 0;
+
+	atomic_inc(&hist[min(bucket, FUSE_LAT_BUCKETS - 1U)]);
+}
+
 void fuse_queue_forget(struct fuse_conn *fc, struct fuse_forget_link *forget,
 		       u64 nodeid, u64 nlookup)
 {
@@ -1255,6 +1264,10 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	list_del_init(&req->list);
 	spin_unlock(&fiq->lock);
 
+	req->send_time = ktime_get();
+	fuse_lat_account(fc->lat_queue,
+			 ktime_us_delta(req->send_time, req->queue_time));
+
 	args = req->args;
 	reqsize = req->in.h.len;
 
@@ -1905,6 +1918,8 @@ static ssize_t fuse_dev_do_write(struct fuse_dev *fud,
 		goto copy_finish;
 	}
 
+	fuse_lat_account(fc->lat_reply,
+			 ktime_us_delta(ktime_get(), req->send_time));
 	clear_bit(FR_SENT, &req->flags);
 	list_move(&req->list, &fpq->io);
 	req->out.h = oh;
@@ -663,6 +663,30 @@ static int proc_pid_syscall(struct seq_file *m, struct pid_namespace *ns,
 }
 #endif /* CONFIG_HAVE_ARCH_TRACEHOOK */
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+/*
+ * Speculative page faults of the mm: attempts, the ones handled without
+ * the mmap_sem, and the success ratio in per-mille.
+ */
+static int proc_pid_spf(struct seq_file *m, struct pid_namespace *ns,
+			struct pid *pid, struct task_struct *task)
+{
+	struct mm_struct *mm = get_task_mm(task);
+	unsigned long attempt = 0, success = 0;
+
+	if (mm) {
+		attempt = atomic_long_read(&mm->spf_attempt);
+		success = atomic_long_read(&mm->spf_success);
+		mmput(mm);
+	}
+
+	seq_printf(m, "attempt %lu\nsuccess %lu\nratio %lu\n", attempt,
+		   success, attempt ? success * 1000 / attempt : 0);
+
+	return 0;
+}
+#endif /* CONFIG_SPECULATIVE_PAGE_FAULT */
+
 /************************************************************************/
 /*                       Here the fs part begins                        */
 /************************************************************************/
@@ -3303,6 +3327,9 @@ static const struct pid_entry tgid_base_stuff[] = {
 	REG("cmdline",    S_IRUGO, proc_pid_cmdline_ops),
 	ONE("stat",       S_IRUGO, proc_tgid_stat),
 	ONE("statm",      S_IRUGO, proc_pid_statm),
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+	ONE("spf",        S_IRUGO, proc_pid_spf),
+#endif
 	REG("maps",       S_IRUGO, proc_pid_maps_operations),
 #ifdef CONFIG_NUMA
 	REG("numa_maps",  S_IRUGO, proc_pid_numa_maps_operations),
@@ -1718,10 +1718,18 @@ const struct file_operations proc_pagemap_operations = {
 #endif /* CONFIG_PROC_PAGE_MONITOR */
 
 #ifdef CONFIG_PROCESS_RECLAIM
+struct reclaim_param {
+	struct vm_area_struct *vma;
+	/* Number of pages still to be reclaimed, 0 means no limit */
+	unsigned long nr_to_reclaim;
+	unsigned long nr_reclaimed;
+};
+
 static int reclaim_pte_range(pmd_t *pmd, unsigned long addr,
 				unsigned long end, struct mm_walk *walk)
 {
-	struct vm_area_struct *vma = walk->private;
+	struct reclaim_param *rp = walk->private;
+	struct vm_area_struct *vma = rp->vma;
 	pte_t *pte, ptent;
 	spinlock_t *ptl;
 	struct page *page;
@@ -1764,9 +1772,15 @@ static int reclaim_pte_range(pmd_t *pmd, unsigned long addr,
 		isolated++;
 		if (isolated >= SWAP_CLUSTER_MAX)
 			break;
+		if (rp->nr_to_reclaim &&
+		    rp->nr_reclaimed + isolated >= rp->nr_to_reclaim)
+			break;
 	}
 	pte_unmap_unlock(pte - 1, ptl);
-	reclaim_pages_from_list(&page_list, vma);
+	rp->nr_reclaimed += reclaim_pages_from_list(&page_list, vma);
+	/* A positive return stops the walk once the budget is met */
+	if (rp->nr_to_reclaim && rp->nr_reclaimed >= rp->nr_to_reclaim)
+		return 1;
 	if (addr != end)
 		goto cont;
 
@@ -1774,6 +1788,14 @@ static int reclaim_pte_range(pmd_t *pmd, unsigned long addr,
 	return 0;
 }
 
+static int reclaim_vma_range(struct vm_area_struct *vma, unsigned long start,
+			     unsigned long end, struct reclaim_param *rp,
+			     const struct mm_walk_ops *ops)
+{
+	rp->vma = vma;
+	return walk_page_range(vma->vm_mm, start, end, ops, rp);
+}
+
 enum reclaim_type {
 	RECLAIM_FILE,
 	RECLAIM_ANON,
@@ -1789,9 +1811,10 @@ static ssize_t reclaim_write(struct file *file, const char __user *buf,
 	struct mm_struct *mm;
 	struct vm_area_struct *vma;
 	enum reclaim_type type;
-	char *type_buf;
+	char *type_buf, *token;
 	unsigned long start = 0;
 	unsigned long end = 0;
+	struct reclaim_param rp = { };
 	const struct mm_walk_ops reclaim_walk_ops = {
 		.pmd_entry = reclaim_pte_range,
 	};
@@ -1804,19 +1827,26 @@ static ssize_t reclaim_write(struct file *file, const char __user *buf,
 		return -EFAULT;
 
 	type_buf = strstrip(buffer);
-	if (!strcmp(type_buf, "file"))
-		type = RECLAIM_FILE;
-	else if (!strcmp(type_buf, "anon"))
-		type = RECLAIM_ANON;
-	else if (!strcmp(type_buf, "all"))
-		type = RECLAIM_ALL;
-	else if (isdigit(*type_buf))
+	if (isdigit(*type_buf)) {
 		type = RECLAIM_RANGE;
-	else
-		goto out_err;
+	} else {
+		token = strsep(&type_buf, " ");
+		if (!strcmp(token, "file"))
+			type = RECLAIM_FILE;
+		else if (!strcmp(token, "anon"))
+			type = RECLAIM_ANON;
+		else if (!strcmp(token, "all"))
+			type = RECLAIM_ALL;
+		else
+			goto out_err;
+
+		/* Optional budget: "<type> <nr_pages>" */
+		if (type_buf && kstrtoul(skip_spaces(type_buf), 0,
+					 &rp.nr_to_reclaim))
+			goto out_err;
+	}
 
 	if (type == RECLAIM_RANGE) {
-		char *token;
 		unsigned long long len, len_in, tmp;
 
 		token = strsep(&type_buf, " ");
@@ -1856,17 +1886,15 @@ static ssize_t reclaim_write(struct file *file, const char __user *buf,
 
 	down_read(&mm->mmap_sem);
 	if (type == RECLAIM_RANGE) {
-		vma = find_vma(mm, start);
-		while (vma) {
+		for (vma = find_vma(mm, start); vma; vma = vma->vm_next) {
 			if (vma->vm_start > end)
 				break;
 			if (is_vm_hugetlb_page(vma))
 				continue;
 
-			walk_page_range(mm, max(vma->vm_start, start),
-					min(vma->vm_end, end),
-					&reclaim_walk_ops, vma);
-			vma = vma->vm_next;
+			reclaim_vma_range(vma, max(vma->vm_start, start),
+					  min(vma->vm_end, end), &rp,
+					  &reclaim_walk_ops);
 		}
 	} else {
 		for (vma = mm->mmap; vma; vma = vma->vm_next) {
@@ -1879,8 +1907,9 @@ static ssize_t reclaim_write(struct file *file, const char __user *buf,
 			if (type == RECLAIM_FILE && !vma->vm_file)
 				continue;
 
-			walk_page_range(mm, vma->vm_start, vma->vm_end,
-					&reclaim_walk_ops, vma);
+			if (reclaim_vma_range(vma, vma->vm_start, vma->vm_end,
+					      &rp, &reclaim_walk_ops))
+				break;
 		}
 	}
 
@@ -66,6 +66,32 @@ static inline int cmp_hashes(const struct fsverity_info *vi,
 	return -EBADMSG;
 }
 
+/*
+ * The leaf-level hash page most recently used while verifying a batch of data
+ * pages, with a reference held.  Consecutive data pages of a bio almost always
+ * share it, so all but the first can skip the Merkle tree page lookup.
+ */
+struct hpage_cache {
+	struct page *hpage;
+	pgoff_t hindex;
+};
+
+static void hpage_cache_set(struct hpage_cache *cache, struct page *hpage,
+			    pgoff_t hindex)
+{
+	if (cache->hpage)
+		put_page(cache->hpage);
+	cache->hpage = hpage;
+	cache->hindex = hindex;
+}
+
+static void hpage_cache_release(struct hpage_cache *cache)
+{
+	if (cache->hpage)
+		put_page(cache->hpage);
+	cache->hpage = NULL;
+}
+
 /*
  * Verify a single data page against the file's Merkle tree.
  *
@@ -81,11 +107,14 @@ static inline int cmp_hashes(const struct fsverity_info *vi,
  * Note that multiple processes may race to verify a hash page and mark it
  * Checked, but it doesn't matter; the result will be the same either way.
  *
+ * If @cache is given, the leaf-level hash page is taken from it when it is the
+ * one needed, and is left in it once known to be Checked.
+ *
  * Return: true if the page is valid, else false.
  */
 static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 			struct ahash_request *req, struct page *data_page,
-			unsigned long level0_ra_pages)
+			unsigned long level0_ra_pages, struct hpage_cache *cache)
 {
 	const struct merkle_tree_params *params = &vi->tree_params;
 	const unsigned int hsize = params->digest_size;
@@ -96,6 +125,7 @@ static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 	u8 real_hash[FS_VERITY_MAX_DIGEST_SIZE];
 	struct page *hpages[FS_VERITY_MAX_LEVELS];
 	unsigned int hoffsets[FS_VERITY_MAX_LEVELS];
+	pgoff_t leaf_hindex = 0;
 	int err;
 
 	if (WARN_ON_ONCE(!PageLocked(data_page) || PageUptodate(data_page)))
@@ -118,6 +148,16 @@ static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 		pr_debug_ratelimited("Level %d: hindex=%lu, hoffset=%u\n",
 				     level, hindex, hoffset);
 
+		if (level == 0) {
+			leaf_hindex = hindex;
+			if (cache && cache->hpage && cache->hindex == hindex) {
+				extract_hash(cache->hpage, hoffset, hsize,
+					     _want_hash);
+				want_hash = _want_hash;
+				goto descend;
+			}
+		}
+
 		hpage = inode->i_sb->s_vop->read_merkle_tree_page(inode, hindex,
 				level == 0 ? level0_ra_pages : 0);
 		if (IS_ERR(hpage)) {
@@ -131,7 +171,10 @@ static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 		if (PageChecked(hpage)) {
 			extract_hash(hpage, hoffset, hsize, _want_hash);
 			want_hash = _want_hash;
-			put_page(hpage);
+			if (level == 0 && cache)
+				hpage_cache_set(cache, hpage, hindex);
+			else
+				put_page(hpage);
 			pr_debug_ratelimited("Hash page already checked, want %s:%*phN\n",
 					     params->hash_alg->name,
 					     hsize, want_hash);
@@ -160,7 +203,10 @@ static bool verify_page(struct inode *inode, const struct fsverity_info *vi,
 		SetPageChecked(hpage);
 		extract_hash(hpage, hoffset, hsize, _want_hash);
 		want_hash = _want_hash;
-		put_page(hpage);
+		if (level == 1 && cache)
+			hpage_cache_set(cache, hpage, leaf_hindex);
+		else
+			put_page(hpage);
 		pr_debug("Verified hash page at level %d, now want %s:%*phN\n",
 			 level - 1, params->hash_alg->name, hsize, want_hash);
 	}
@@ -196,7 +242,7 @@ bool fsverity_verify_page(struct page *page)
 	/* This allocation never fails, since it's mempool-backed. */
 	req = fsverity_alloc_hash_request(vi->tree_params.hash_alg, GFP_NOFS);
 
-	valid = verify_page(inode, vi, req, page, 0);
+	valid = verify_page(inode, vi, req, page, 0, NULL);
 
 	fsverity_free_hash_request(vi->tree_params.hash_alg, req);
 
@@ -228,6 +274,7 @@ void fsverity_verify_bio(struct bio *bio)
 	struct ahash_request *req;
 	struct bio_vec *bv;
 	struct bvec_iter_all iter_all;
+	struct hpage_cache cache = { };
 	unsigned long max_ra_pages = 0;
 
 	/* This allocation never fails, since it's mempool-backed. */
@@ -255,10 +302,12 @@ void fsverity_verify_bio(struct bio *bio)
 			min(max_ra_pages, params->level0_blocks - level0_index);
 
 		if (!PageError(page) &&
-		    !verify_page(inode, vi, req, page, level0_ra_pages))
+		    !verify_page(inode, vi, req, page, level0_ra_pages,
+				 &cache))
 			SetPageError(page);
 	}
 
+	hpage_cache_release(&cache);
 	fsverity_free_hash_request(params->hash_alg, req);
 }
 EXPORT_SYMBOL_GPL(fsverity_verify_bio);
@@ -146,6 +146,15 @@
 #define BRANCH_PROFILE()
 #endif
 
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS_STATS
+#define VENDOR_HOOK_STATS()	. = ALIGN(8);				\
+				__start___vendor_hook_stats = .;	\
+				KEEP(*(__vendor_hook_stats))		\
+				__stop___vendor_hook_stats = .;
+#else
+#define VENDOR_HOOK_STATS()
+#endif
+
 #ifdef CONFIG_KPROBES
 #define KPROBE_BLACKLIST()	. = ALIGN(8);				      \
 				__start_kprobe_blacklist = .;		      \
@@ -295,6 +304,7 @@
 	__stop___verbose = .;						\
 	LIKELY_PROFILE()		       				\
 	BRANCH_PROFILE()						\
+	VENDOR_HOOK_STATS()						\
 	TRACE_PRINTKS()							\
 	BPF_RAW_TP()							\
 	TRACEPOINT_STR()
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Hashing several SHA-256 messages of the same length at once
+ */
+
+#ifndef _CRYPTO_SHA256_MB_H
+#define _CRYPTO_SHA256_MB_H
+
+#include <linux/types.h>
+
+struct sha256_state;
+
+/*
+ * Only a built-in implementation is used: a module would refuse to load on
+ * CPUs without the instructions and take its users down with it.
+ */
+#if IS_BUILTIN(CONFIG_CRYPTO_SHA2_ARM64_CE)
+#include <asm/cpufeature.h>
+
+static inline bool sha256_finup2x_supported(void)
+{
+	return cpu_have_named_feature(SHA2);
+}
+
+bool sha256_finup2x(const struct sha256_state *sctx, const u8 *data1,
+		    const u8 *data2, unsigned int len, u8 *out1, u8 *out2);
+#else
+static inline bool sha256_finup2x_supported(void)
+{
+	return false;
+}
+
+static inline bool sha256_finup2x(const struct sha256_state *sctx,
+				  const u8 *data1, const u8 *data2,
+				  unsigned int len, u8 *out1, u8 *out2)
+{
+	return false;
+}
+#endif
+
+#endif /* _CRYPTO_SHA256_MB_H */
@@ -4,6 +4,10 @@
 #ifndef _DRM_ANAKIN_H_
 #define _DRM_ANAKIN_H_
 
+#include <linux/errno.h>
+#include <linux/ktime.h>
+#include <linux/notifier.h>
+
 #if defined ASUS_ZS673KS_PROJECT || defined ASUS_PICASSO_PROJECT
 #define ASUS_NOTIFY_GHBM_ON_REQ        0
 #define ASUS_NOTIFY_GHBM_ON_READY      1
@@ -15,6 +19,14 @@ void drm_anakin_sysfs_destroy(void);
 int drm_anakin_sysfs_init(void);
 bool is_DSI_mode(int,int);
 bool refreshrate_match(int,int);
+/* vsync notifiers are called from the vblank irq with a ktime_t * */
+int anakin_drm_register_vsync_notifier(struct notifier_block *nb);
+int anakin_drm_unregister_vsync_notifier(struct notifier_block *nb);
+void anakin_drm_notify_vsync(ktime_t timestamp);
+/* wake notifiers may be called from any context with an unsigned int * hold in ms */
+int anakin_drm_register_wake_notifier(struct notifier_block *nb);
+int anakin_drm_unregister_wake_notifier(struct notifier_block *nb);
+void anakin_drm_notify_wake(unsigned int hold_ms);
 
 #else
 static inline void anakin_drm_notify(int var, int value) {}
@@ -22,6 +34,12 @@ static inline void drm_anakin_sysfs_destroy(void) {}
 static inline int drm_anakin_sysfs_init(void) { return 0; }
 static inline bool is_DSI_mode(int vdisplay, int vtotal) { return false; }
 static inline bool refreshrate_match(int refresh1, int refresh2) { return true; }
+static inline int anakin_drm_register_vsync_notifier(struct notifier_block *nb) { return -ENODEV; }
+static inline int anakin_drm_unregister_vsync_notifier(struct notifier_block *nb) { return 0; }
+static inline void anakin_drm_notify_vsync(ktime_t timestamp) {}
+static inline int anakin_drm_register_wake_notifier(struct notifier_block *nb) { return -ENODEV; }
+static inline int anakin_drm_unregister_wake_notifier(struct notifier_block *nb) { return 0; }
+static inline void anakin_drm_notify_wake(unsigned int hold_ms) {}
 
 #endif
 #endif /* _DRM_ANAKIN_H_ */
@@ -167,6 +167,8 @@ struct bdi_writeback {
 	struct delayed_work dwork;	/* work item used for writeback */
 
 	unsigned long dirty_sleep;	/* last wait */
+	unsigned long defer_start;	/* start of background deferral */
+	unsigned long nr_deferred;	/* background passes deferred */
 
 	struct list_head bdi_node;	/* anchored at bdi->wb_list */
 
@@ -207,6 +209,9 @@ struct backing_dev_info {
 	 */
 	atomic_long_t tot_write_bandwidth;
 
+	/* last wbt window in which foreground IO missed its latency target */
+	unsigned long fg_lat_exceeded;
+
 	struct bdi_writeback wb;  /* the root writeback info for this bdi */
 	struct list_head wb_list; /* list of all wbs */
 #ifdef CONFIG_CGROUP_WRITEBACK
@@ -620,6 +620,7 @@ struct request_queue {
 #define QUEUE_FLAG_PCI_P2PDMA	25	/* device supports PCI p2p requests */
 #define QUEUE_FLAG_ZONE_RESETALL 26	/* supports Zone Reset All */
 #define QUEUE_FLAG_RQ_ALLOC_TIME 27	/* record rq->alloc_time_ns */
+#define QUEUE_FLAG_SAME_CLUSTER	28	/* complete on same CPU cluster */
 
 #define QUEUE_FLAG_MQ_DEFAULT	((1 << QUEUE_FLAG_IO_STAT) |		\
 				 (1 << QUEUE_FLAG_SAME_COMP))
@@ -1709,8 +1710,14 @@ struct block_device_operations {
 	void (*unlock_native_capacity) (struct gendisk *);
 	int (*revalidate_disk) (struct gendisk *);
 	int (*getgeo)(struct block_device *, struct hd_geometry *);
-	/* this callback is with swap_lock and sometimes page table lock held */
+	/* this callback may be called with swap_lock and page table lock held */
 	void (*swap_slot_free_notify) (struct block_device *, unsigned long);
+	/*
+	 * Batched variant for slots whose swap count already dropped to zero,
+	 * called without the swap_lock held.
+	 */
+	void (*swap_slots_free_notify) (struct block_device *,
+					unsigned long *offsets, unsigned int nr);
 	int (*report_zones)(struct gendisk *, sector_t sector,
 			unsigned int nr_zones, report_zones_cb cb, void *data);
 	struct module *owner;
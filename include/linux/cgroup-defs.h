@@ -347,6 +347,15 @@ struct cgroup_freezer_state {
 	 * frozen, SIGSTOPped, and PTRACEd.
 	 */
 	int nr_frozen_tasks;
+
+	/* Freeze/thaw latency, reported in cgroup.freeze.stat */
+	u64 freeze_start_ns;
+	unsigned long nr_freezes;
+	unsigned long nr_thaws;
+	u64 freeze_total_ns;
+	u64 freeze_max_ns;
+	u64 thaw_total_ns;
+	u64 thaw_max_ns;
 };
 
 struct cgroup {
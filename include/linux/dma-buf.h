@@ -423,16 +423,50 @@ struct dma_buf {
 	} cb_excl, cb_shared;
 };
 
+#define DMA_BUF_CPU_RANGES_MAX	8
+
+/**
+ * struct dma_buf_range - byte range within a dma_buf
+ * @offset: start of the range
+ * @len: length of the range
+ */
+struct dma_buf_range {
+	unsigned int offset;
+	unsigned int len;
+};
+
 /**
  * struct msm_dma_buf - Holds the meta data associated with a shared buffer
  * object, as well as the buffer object.
  * @refs: list entry for dma-buf reference tracking
  * @i_ino: inode number
+ * @cpu_gen: bumped every time the CPU may have accessed the buffer, so that
+ * device mappings can tell whether the CPU caches still hold nothing dirty
+ * for it since they last cleaned them.
+ * @cpu_full_gen: value of @cpu_gen when the CPU last accessed the buffer as a
+ * whole, rather than through dma_buf_begin/end_cpu_access_partial().
+ * @cpu_ranges: sorted, coalesced ranges of the buffer the CPU accessed
+ * partially since @cpu_full_gen.
+ * @nr_cpu_ranges: number of entries in @cpu_ranges.
+ * @cpu_lock: protects @cpu_full_gen and @cpu_ranges, and the updates of
+ * @cpu_gen.
+ * @map_hits: device mappings that were served from a mapping cache.
+ * @map_misses: device mappings that had to be created.
+ * @cmo_skips: cache maintenance operations skipped on cached mappings because
+ * the CPU did not access the buffer in between.
  * @dma_buf: the shared buffer object
  */
 struct msm_dma_buf {
 	struct list_head refs;
 	unsigned long i_ino;
+	atomic_t cpu_gen;
+	int cpu_full_gen;
+	struct dma_buf_range cpu_ranges[DMA_BUF_CPU_RANGES_MAX];
+	int nr_cpu_ranges;
+	spinlock_t cpu_lock;
+	atomic_t map_hits;
+	atomic_t map_misses;
+	atomic_t cmo_skips;
 	struct dma_buf dma_buf;
 };
 
@@ -528,6 +562,9 @@ void dma_buf_detach(struct dma_buf *dmabuf,
 
 struct dma_buf *dma_buf_export(const struct dma_buf_export_info *exp_info);
 
+int dma_buf_cpu_dirty_ranges(struct dma_buf *dmabuf, int since,
+			     struct dma_buf_range *ranges, int *gen);
+
 int dma_buf_fd(struct dma_buf *dmabuf, int flags);
 struct dma_buf *dma_buf_get(int fd);
 void dma_buf_put(struct dma_buf *dmabuf);
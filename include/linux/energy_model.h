@@ -82,6 +82,8 @@ struct em_data_callback {
 struct em_perf_domain *em_cpu_get(int cpu);
 int em_register_perf_domain(cpumask_t *span, unsigned int nr_states,
 						struct em_data_callback *cb);
+int em_update_perf_domain_power(struct em_perf_domain *pd,
+				const unsigned long *power);
 
 /**
  * em_pd_energy() - Estimates the energy consumed by the CPUs of a perf. domain
@@ -164,7 +166,7 @@ static inline unsigned long em_pd_energy(struct em_perf_domain *pd,
 	 *   pd_nrg = ------------------------                       (4)
 	 *                  scale_cpu
 	 */
-	return cs->cost * sum_util / scale_cpu;
+	return READ_ONCE(cs->cost) * sum_util / scale_cpu;
 }
 
 /**
@@ -192,6 +194,11 @@ static inline struct em_perf_domain *em_cpu_get(int cpu)
 {
 	return NULL;
 }
+static inline int em_update_perf_domain_power(struct em_perf_domain *pd,
+				const unsigned long *power)
+{
+	return -EINVAL;
+}
 static inline unsigned long em_pd_energy(struct em_perf_domain *pd,
 			unsigned long max_util, unsigned long sum_util)
 {
@@ -3240,6 +3240,7 @@ enum {
 };
 
 void dio_end_io(struct bio *bio);
+void dio_set_bio_cookie(void *private, unsigned int cookie);
 void dio_warn_stale_pagecache(struct file *filp);
 
 ssize_t __blockdev_direct_IO(struct kiocb *iocb, struct inode *inode,
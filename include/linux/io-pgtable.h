@@ -115,6 +115,16 @@ struct io_pgtable_cfg {
 	 *	set in TCR for the page table walker with Write-Back,
 	 *	no Write-Allocate cacheable encoding.
 	 *
+	 * IO_PGTABLE_QUIRK_DEFER_FLUSH: (ARM LPAE format) Do not flush the
+	 *	TLB at the end of an unmap that was given a gather, only record
+	 *	the range in it. The driver's iotlb_sync() must invalidate the
+	 *	context when the gather is not empty.
+	 *
+	 * IO_PGTABLE_QUIRK_CONT_HINT: (ARM LPAE format, 4K granule) Set the
+	 *	contiguous bit on runs of 16 page entries that map a naturally
+	 *	aligned, physically contiguous 64K region so the walker can
+	 *	cache them as a single TLB entry.
+	 *
 	 */
 	#define IO_PGTABLE_QUIRK_ARM_NS		BIT(0)
 	#define IO_PGTABLE_QUIRK_NO_PERMS	BIT(1)
@@ -123,6 +133,8 @@ struct io_pgtable_cfg {
 	#define IO_PGTABLE_QUIRK_NON_STRICT	BIT(4)
 	#define IO_PGTABLE_QUIRK_QCOM_USE_UPSTREAM_HINT	BIT(5)
 	#define IO_PGTABLE_QUIRK_QCOM_USE_LLC_NWA	BIT(6)
+	#define IO_PGTABLE_QUIRK_DEFER_FLUSH	BIT(7)
+	#define IO_PGTABLE_QUIRK_CONT_HINT	BIT(8)
 	unsigned long			quirks;
 	unsigned long			pgsize_bitmap;
 	unsigned int			ias;
@@ -196,7 +196,8 @@ enum iommu_attr {
 #define DOMAIN_ATTR_FAULT_MODEL_NO_CFRE		(EXTENDED_ATTR_BASE + 18)
 #define DOMAIN_ATTR_FAULT_MODEL_NO_STALL	(EXTENDED_ATTR_BASE + 19)
 #define DOMAIN_ATTR_FAULT_MODEL_HUPCF		(EXTENDED_ATTR_BASE + 20)
-#define DOMAIN_ATTR_EXTENDED_MAX		(EXTENDED_ATTR_BASE + 21)
+#define DOMAIN_ATTR_CONTIG_HINT			(EXTENDED_ATTR_BASE + 21)
+#define DOMAIN_ATTR_EXTENDED_MAX		(EXTENDED_ATTR_BASE + 22)
 
 /* These are the possible reserved region types */
 enum iommu_resv_type {
@@ -15,7 +15,8 @@ enum {
 	TSV_TYPE_MSG_START = 1,
 	TSV_TYPE_SKB = TSV_TYPE_MSG_START,
 	TSV_TYPE_STRING,
-	TSV_TYPE_MSG_END = TSV_TYPE_STRING,
+	TSV_TYPE_BIN_STRING,
+	TSV_TYPE_MSG_END = TSV_TYPE_BIN_STRING,
 };
 
 struct tsv_header {
@@ -43,7 +44,8 @@ struct decode_context {
  * @max_num_pages: Number of pages of logging space required (max. 10)
  * @mod_name     : Name of the directory entry under DEBUGFS
  * @feature_version : First 16 bit for version number of user-defined message
- *		      formats and next 16 bit for enabling minidump
+ *		      formats and next 16 bit for enabling minidump (bit 16)
+ *		      and deferred string formatting (bit 17)
  *
  * returns context id on success, NULL on failure
  */
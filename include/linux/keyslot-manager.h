@@ -50,6 +50,30 @@ struct keyslot_mgmt_ll_ops {
 				 u8 *secret, unsigned int secret_size);
 };
 
+/**
+ * struct keyslot_mgmt_stats - keyslot usage counters
+ * @hit_cnt: lookups that found the key already programmed
+ * @program_cnt: keys programmed into a slot
+ * @program_fail_cnt: programming attempts the driver failed
+ * @program_total_ns: time spent programming keys
+ * @program_max_ns: longest single programming
+ * @replace_cnt: programmings that evicted another key
+ * @evict_cnt: keys evicted on request of the upper layers
+ * @preload_cnt: keys programmed ahead of their first IO
+ * @wait_cnt: times a lookup had to wait for a slot to become idle
+ */
+struct keyslot_mgmt_stats {
+	u64 hit_cnt;
+	u64 program_cnt;
+	u64 program_fail_cnt;
+	u64 program_total_ns;
+	u64 program_max_ns;
+	u64 replace_cnt;
+	u64 evict_cnt;
+	u64 preload_cnt;
+	u64 wait_cnt;
+};
+
 struct keyslot_manager *keyslot_manager_create(
 	struct device *dev,
 	unsigned int num_slots,
@@ -64,6 +88,9 @@ void keyslot_manager_set_max_dun_bytes(struct keyslot_manager *ksm,
 int keyslot_manager_get_slot_for_key(struct keyslot_manager *ksm,
 				     const struct blk_crypto_key *key);
 
+int keyslot_manager_preload_key(struct keyslot_manager *ksm,
+				const struct blk_crypto_key *key);
+
 void keyslot_manager_get_slot(struct keyslot_manager *ksm, unsigned int slot);
 
 void keyslot_manager_put_slot(struct keyslot_manager *ksm, unsigned int slot);
@@ -79,6 +106,9 @@ int keyslot_manager_evict_key(struct keyslot_manager *ksm,
 
 void keyslot_manager_reprogram_all_keys(struct keyslot_manager *ksm);
 
+void keyslot_manager_get_stats(struct keyslot_manager *ksm,
+			       struct keyslot_mgmt_stats *stats);
+
 void *keyslot_manager_private(struct keyslot_manager *ksm);
 
 void keyslot_manager_destroy(struct keyslot_manager *ksm);
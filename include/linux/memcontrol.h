@@ -199,6 +199,19 @@ struct memcg_cgwb_frn {
 	struct wb_completion done;	/* tracks in-flight foreign writebacks */
 };
 
+/*
+ * Working set estimate, refreshed by each aging pass over the LRU lists.
+ * See mem_cgroup_age_working_set().
+ */
+struct memcg_working_set {
+	struct mutex lock;		/* serialises aging passes */
+	unsigned long last_age;		/* jiffies of the last pass */
+	unsigned long refaults;		/* WORKINGSET_REFAULT at last pass */
+	unsigned long refault_rate;	/* refaults per second between passes */
+	unsigned long ws[2];		/* anon/file pages referenced */
+	unsigned long scanned;		/* pages scanned by the last pass */
+};
+
 /*
  * The memory controller data structure. The memory controller controls both
  * page cache and RSS per cgroup. We would eventually like to provide
@@ -330,6 +343,10 @@ struct mem_cgroup {
 	struct list_head event_list;
 	spinlock_t event_list_lock;
 
+#ifdef CONFIG_MEMCG_WORKINGSET
+	struct memcg_working_set working_set;
+#endif
+
 #if defined(CONFIG_TRANSPARENT_HUGEPAGE) || defined(CONFIG_GKI_OPT_FEATURES)
 	struct deferred_split deferred_split_queue;
 #endif
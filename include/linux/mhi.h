@@ -549,8 +549,9 @@ static inline void *mhi_device_get_devdata(struct mhi_device *mhi_dev)
  * All transfers are asyncronous transfers
  * @mhi_dev: Device associated with the channels
  * @dir: Data direction
- * @buf: Data buffer (skb for hardware channels)
- * @len: Size in bytes
+ * @buf: Data buffer (skb for hardware channels, struct scatterlist for
+ * sclist channels)
+ * @len: Size in bytes, or number of scatterlist entries for sclist channels
  * @mflags: Interrupt flags for the device
  */
 static inline int mhi_queue_transfer(struct mhi_device *mhi_dev,
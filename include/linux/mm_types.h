@@ -480,6 +480,12 @@ struct mm_struct {
 		 */
 		struct mm_rss_stat rss_stat;
 
+#ifdef CONFIG_SPECULATIVE_PAGE_FAULT
+		/* Speculative page faults tried and handled without mmap_sem */
+		atomic_long_t spf_attempt;
+		atomic_long_t spf_success;
+#endif
+
 		struct linux_binfmt *binfmt;
 
 		/* Architecture-specific MM context */
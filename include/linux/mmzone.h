@@ -340,6 +340,10 @@ enum zone_watermarks {
 #define high_wmark_pages(z) (z->_watermark[WMARK_HIGH] + z->watermark_boost)
 #define wmark_pages(z, i) (z->_watermark[i] + z->watermark_boost)
 
+#ifdef CONFIG_PCP_HIGH_ORDER
+#define PCP_HIGH_ORDER	CONFIG_PCP_HIGH_ORDER_NR
+#endif
+
 struct per_cpu_pages {
 	int count;		/* number of pages in the list */
 	int high;		/* high watermark, emptying needed */
@@ -347,6 +351,11 @@ struct per_cpu_pages {
 
 	/* Lists of pages, one per migrate type stored on the pcp-lists */
 	struct list_head lists[MIGRATE_PCPTYPES];
+#ifdef CONFIG_PCP_HIGH_ORDER
+	/* Blocks of PCP_HIGH_ORDER pages, same layout as above */
+	int high_order_count;	/* number of blocks in the lists */
+	struct list_head high_order_lists[MIGRATE_PCPTYPES];
+#endif
 };
 
 struct per_cpu_pageset {
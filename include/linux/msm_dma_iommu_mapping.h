@@ -66,6 +66,8 @@ int msm_dma_unmap_all_for_dev(struct device *dev);
  */
 void msm_dma_buf_freed(void *buffer);
 
+void msm_dma_buf_sync_for_cpu(struct dma_buf *dma_buf);
+
 #else /*CONFIG_QCOM_LAZY_MAPPING*/
 
 static inline int msm_dma_map_sg_attrs(struct device *dev,
@@ -104,6 +106,8 @@ static inline int msm_dma_unmap_all_for_dev(struct device *dev)
 }
 
 static inline void msm_dma_buf_freed(void *buffer) {}
+
+static inline void msm_dma_buf_sync_for_cpu(struct dma_buf *dma_buf) {}
 #endif /*CONFIG_QCOM_LAZY_MAPPING*/
 
 #endif
@@ -17,6 +17,18 @@ struct ion_prefetch_region {
 	u32 vmid;
 };
 
+/**
+ * struct ion_prefill_hint - buffers a client expects to allocate soon
+ * @size:	size of each buffer in bytes
+ * @count:	number of buffers of @size
+ * @cached:	true if the buffers will be allocated with ION_FLAG_CACHED
+ */
+struct ion_prefill_hint {
+	u64 size;
+	u32 count;
+	bool cached;
+};
+
 #if IS_ENABLED(CONFIG_ION_MSM_HEAPS)
 
 struct device *msm_ion_heap_device_by_id(int heap_id);
@@ -37,6 +49,9 @@ int msm_ion_heap_prefetch(int heap_id, struct ion_prefetch_region *regions,
 int msm_ion_heap_drain(int heap_id, struct ion_prefetch_region *regions,
 		       int nr_regions);
 
+int msm_ion_heap_prefill(int heap_id, struct ion_prefill_hint *hints,
+			 int nr_hints);
+
 int get_ion_flags(u32 vmid);
 
 bool msm_ion_heap_is_secure(int heap_id);
@@ -81,6 +96,13 @@ static inline int msm_ion_heap_drain(int heap_id,
 	return -ENODEV;
 }
 
+static inline int msm_ion_heap_prefill(int heap_id,
+				       struct ion_prefill_hint *hints,
+				       int nr_hints)
+{
+	return -ENODEV;
+}
+
 static inline int get_ion_flags(u32 vmid)
 {
 	return -EINVAL;
@@ -1722,6 +1722,9 @@ enum netdev_priv_flags {
  *	@num_rx_queues:		Number of RX queues
  *				allocated at register_netdev() time
  *	@real_num_rx_queues: 	Number of RX queues currently active in device
+ *	@link_capacity_kbps:	Current receive capacity of the link as
+ *				estimated by the driver or userspace, 0 if
+ *				unknown; seeds TCP receive buffers
  *
  *	@rx_handler:		handler for received packets
  *	@rx_handler_data: 	XXX: need comments on this one
@@ -1980,6 +1983,7 @@ struct net_device {
 
 	struct bpf_prog __rcu	*xdp_prog;
 	unsigned long		gro_flush_timeout;
+	unsigned int		link_capacity_kbps;
 	rx_handler_func_t __rcu	*rx_handler;
 	void __rcu		*rx_handler_data;
 
@@ -3036,6 +3040,8 @@ struct softnet_data {
 	unsigned int		processed;
 	unsigned int		time_squeeze;
 	unsigned int		received_rps;
+	unsigned int		skb_recycle_hit;
+	unsigned int		skb_recycle_miss;
 #ifdef CONFIG_RPS
 	struct softnet_data	*rps_ipi_list;
 #endif
@@ -4602,6 +4608,20 @@ static inline bool netif_needs_gso(struct sk_buff *skb,
 			 (skb->ip_summed != CHECKSUM_UNNECESSARY)));
 }
 
+/**
+ *	netif_set_link_capacity - publish the receive capacity of a link
+ *	@dev: network device
+ *	@kbps: current capacity estimate in kbit/s, 0 if unknown
+ *
+ *	TCP connections established over @dev size their initial receive
+ *	buffer and window for this rate instead of growing them from scratch.
+ */
+static inline void netif_set_link_capacity(struct net_device *dev,
+					   unsigned int kbps)
+{
+	WRITE_ONCE(dev->link_capacity_kbps, kbps);
+}
+
 static inline void netif_set_gso_max_size(struct net_device *dev,
 					  unsigned int size)
 {
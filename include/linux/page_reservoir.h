@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef _LINUX_PAGE_RESERVOIR_H
+#define _LINUX_PAGE_RESERVOIR_H
+
+#include <linux/gfp.h>
+#include <linux/mm_types.h>
+
+#ifdef CONFIG_PAGE_RESERVOIR
+/**
+ * page_reservoir_alloc - Take a pre-zeroed page from the reservoir
+ * @order: Order of the page, only orders 0, 4 and 8 are held
+ * @gfp_mask: Allocation flags the caller would have used. Only __GFP_COMP
+ * and __GFP_HIGHMEM are looked at.
+ *
+ * The returned page is zeroed and has been cleaned out of the CPU caches,
+ * so the caller must not zero it again or perform cache maintenance before
+ * handing it to a non-coherent device. The reservoir never blocks and never
+ * falls back to the buddy allocator.
+ *
+ * Return: A page of @order, or NULL if the reservoir has none to give.
+ */
+struct page *page_reservoir_alloc(unsigned int order, gfp_t gfp_mask);
+#else
+static inline struct page *page_reservoir_alloc(unsigned int order,
+		gfp_t gfp_mask)
+{
+	return NULL;
+}
+#endif /* CONFIG_PAGE_RESERVOIR */
+
+#endif /* _LINUX_PAGE_RESERVOIR_H */
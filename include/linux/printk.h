@@ -202,6 +202,7 @@ extern void wake_up_klogd(void);
 
 char *log_buf_addr_get(void);
 u32 log_buf_len_get(void);
+u32 log_buf_used_get(void);
 void log_buf_vmcoreinfo_setup(void);
 void __init setup_log_buf(int early);
 __printf(1, 2) void dump_stack_set_arch_desc(const char *fmt, ...);
@@ -250,6 +251,11 @@ static inline u32 log_buf_len_get(void)
 	return 0;
 }
 
+static inline u32 log_buf_used_get(void)
+{
+	return 0;
+}
+
 static inline void log_buf_vmcoreinfo_setup(void)
 {
 }
@@ -561,6 +561,9 @@ extern void
 sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin, u32 fmax);
 extern void free_task_load_ptrs(struct task_struct *p);
 extern int set_task_boost(int boost, u64 period);
+extern void set_task_boost_inherit(struct task_struct *p, int boost,
+				   u64 period_ns);
+extern bool task_latency_sensitive(struct task_struct *p);
 extern void walt_update_cluster_topology(void);
 
 #define RAVG_HIST_SIZE_MAX  5
@@ -602,6 +605,19 @@ struct walt_task_struct {
 	 * used for prediction
 	 *
 	 * 'demand_scaled' represents task's demand scaled to 1024
+	 *
+	 * 'demand_class' is the cgroup demand class the task's demand was
+	 * accounted in when it was last enqueued
+	 *
+	 * 'pred_ewma' is the moving average of busy time per window, used by
+	 * the EWMA predictor
+	 *
+	 * 'pred_burst' and 'pred_period' are the moving averages of busy time
+	 * per activation and of the time between wakeups, used by the
+	 * periodic predictor. 'pred_nr_wakeups' counts wakeups in the
+	 * current window.
+	 *
+	 * 'nr_cluster_migrations' counts migrations across frequency domains
 	 */
 	u64				mark_start;
 	u32				sum, demand;
@@ -611,6 +627,10 @@ struct walt_task_struct {
 	u32				curr_window, prev_window;
 	u32				pred_demand;
 	u8				busy_buckets[NUM_BUSY_BUCKETS];
+	u32				pred_ewma;
+	u32				pred_burst;
+	u32				pred_period;
+	u16				pred_nr_wakeups;
 	u16				demand_scaled;
 	u16				pred_demand_scaled;
 	u64				active_time;
@@ -619,6 +639,7 @@ struct walt_task_struct {
 	bool				misfit;
 	bool				rtg_high_prio;
 	u8				low_latency;
+	u8				demand_class;
 	u64				boost_period;
 	u64				boost_expires;
 	u64				last_sleep_ts;
@@ -631,6 +652,7 @@ struct walt_task_struct {
 	u64				cpu_cycles;
 	cpumask_t			cpus_requested;
 	bool				iowaited;
+	u32				nr_cluster_migrations;
 };
 
 #else
@@ -648,6 +670,12 @@ static inline void sched_update_cpu_freq_min_max(const cpumask_t *cpus,
 					u32 fmin, u32 fmax) { }
 
 static inline void set_task_boost(int boost, u64 period) { }
+static inline void set_task_boost_inherit(struct task_struct *p, int boost,
+					  u64 period_ns) { }
+static inline bool task_latency_sensitive(struct task_struct *p)
+{
+	return false;
+}
 static inline void walt_update_cluster_topology(void) { }
 #endif /* CONFIG_SCHED_WALT */
 
@@ -2243,4 +2271,13 @@ static inline int sched_set_wake_up_idle(struct task_struct *p,
 static inline void set_wake_up_idle(bool enabled) {}
 #endif
 
+#ifdef CONFIG_SCHED_WALT
+extern int sched_boost_timed(unsigned int ms);
+#else
+static inline int sched_boost_timed(unsigned int ms)
+{
+	return 0;
+}
+#endif
+
 #endif
@@ -24,6 +24,7 @@ extern unsigned long nr_iowait_cpu(int cpu);
 #ifdef CONFIG_SCHED_WALT
 extern void sched_update_nr_prod(int cpu, long delta, bool inc);
 extern unsigned int sched_get_cpu_util(int cpu);
+extern unsigned int sched_get_cpu_pred_util(int cpu);
 extern void sched_update_hyst_times(void);
 extern u64 sched_lpm_disallowed_time(int cpu);
 
@@ -51,6 +52,10 @@ static inline unsigned int sched_get_cpu_util(int cpu)
 {
 	return 0;
 }
+static inline unsigned int sched_get_cpu_pred_util(int cpu)
+{
+	return 0;
+}
 static inline void sched_update_hyst_times(void) {}
 static inline u64 sched_lpm_disallowed_time(int cpu)
 {
@@ -43,6 +43,10 @@ extern unsigned int sysctl_sched_group_upmigrate_pct;
 extern unsigned int sysctl_sched_group_downmigrate_pct;
 extern unsigned int sysctl_sched_conservative_pl;
 extern unsigned int sysctl_sched_walt_rotate_big_tasks;
+extern unsigned int sysctl_sched_walt_lockless_rollover;
+extern unsigned int sysctl_sched_walt_deferred_subs;
+extern unsigned int sysctl_sched_walt_psi_mem_thresh_pct;
+extern unsigned int sysctl_sched_walt_psi_mem_floor_pct;
 extern unsigned int sysctl_sched_min_task_util_for_boost;
 extern unsigned int sysctl_sched_min_task_util_for_colocation;
 extern unsigned int sysctl_sched_asym_cap_sibling_freq_match_pct;
@@ -63,6 +67,10 @@ extern unsigned int sysctl_walt_rtg_cfs_boost_prio;
 extern unsigned int sysctl_walt_low_latency_task_threshold;
 extern unsigned int sysctl_sched_sync_hint_enable;
 extern unsigned int sysctl_walt_cpu_high_irqload;
+extern unsigned int sysctl_sched_walt_irq_balance;
+extern unsigned int sysctl_sched_walt_irq_balance_ms;
+extern unsigned int sysctl_sched_walt_irq_balance_min_rate;
+extern unsigned int sysctl_sched_walt_irq_balance_avoid_prime;
 extern unsigned int sysctl_sched_asym_cap_sibling_freq_match_en;
 
 extern int
@@ -93,6 +101,9 @@ extern int sched_busy_hyst_handler(struct ctl_table *table, int write,
 extern int walt_high_irqload_handler(struct ctl_table *table, int write,
 			void __user *buffer, size_t *lenp, loff_t *ppos);
 
+extern int walt_irq_balance_handler(struct ctl_table *table, int write,
+			void __user *buffer, size_t *lenp, loff_t *ppos);
+
 #endif
 
 enum sched_tunable_scaling {
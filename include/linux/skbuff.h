@@ -909,6 +909,7 @@ struct sk_buff {
 #define SKB_ALLOC_FCLONE	0x01
 #define SKB_ALLOC_RX		0x02
 #define SKB_ALLOC_NAPI		0x04
+#define SKB_ALLOC_RECYCLE	0x08
 
 /**
  * skb_pfmemalloc - Test if the skb was allocated from PFMEMALLOC reserves
@@ -2793,6 +2794,10 @@ void *netdev_alloc_frag(unsigned int fragsz);
 
 struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int length,
 				   gfp_t gfp_mask);
+struct sk_buff *__netdev_alloc_skb_recycle(struct net_device *dev,
+					   unsigned int length, gfp_t gfp_mask);
+void skb_recycle_register(void);
+void skb_recycle_unregister(void);
 
 /**
  *	netdev_alloc_skb - allocate an skbuff for rx on a specific device
@@ -2820,6 +2825,12 @@ static inline struct sk_buff *__dev_alloc_skb(unsigned int length,
 	return __netdev_alloc_skb(NULL, length, gfp_mask);
 }
 
+static inline struct sk_buff *__dev_alloc_skb_recycle(unsigned int length,
+						      gfp_t gfp_mask)
+{
+	return __netdev_alloc_skb_recycle(NULL, length, gfp_mask);
+}
+
 /* legacy helper around netdev_alloc_skb() */
 static inline struct sk_buff *dev_alloc_skb(unsigned int length)
 {
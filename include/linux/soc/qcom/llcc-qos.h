@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef _LLCC_QOS_H_
+#define _LLCC_QOS_H_
+
+#include <linux/soc/qcom/llcc-qcom.h>
+
+/**
+ * enum llcc_qos_profile - foreground use case the slices are split for
+ * @LLCC_QOS_PROFILE_DEFAULT: static split of the SCT
+ * @LLCC_QOS_PROFILE_GAME: large GPU slice
+ * @LLCC_QOS_PROFILE_CAMERA: large camera (CVP/IPE) slice
+ * @LLCC_QOS_PROFILE_VIDEO: large display slice
+ */
+enum llcc_qos_profile {
+	LLCC_QOS_PROFILE_DEFAULT,
+	LLCC_QOS_PROFILE_GAME,
+	LLCC_QOS_PROFILE_CAMERA,
+	LLCC_QOS_PROFILE_VIDEO,
+	LLCC_QOS_PROFILE_MAX,
+};
+
+int qcom_llcc_qos_probe(struct platform_device *pdev,
+		const struct llcc_slice_config *table, size_t size);
+
+void qcom_llcc_qos_remove(struct platform_device *pdev);
+
+int llcc_slice_set_max_cap(u32 slice_id, u32 max_cap);
+
+#if IS_ENABLED(CONFIG_QCOM_LLCC)
+
+int llcc_qos_set_profile(enum llcc_qos_profile profile);
+
+int llcc_qos_next_slice(int slice_id);
+
+void llcc_qos_report_stats(u32 slice_id, u64 accesses, u64 misses);
+#else
+static __maybe_unused int llcc_qos_set_profile(enum llcc_qos_profile profile)
+{ return -ENODEV; }
+
+static __maybe_unused int llcc_qos_next_slice(int slice_id)
+{ return -ENODEV; }
+
+static __maybe_unused void llcc_qos_report_stats(u32 slice_id, u64 accesses,
+						 u64 misses)
+{ }
+#endif
+
+#endif //_LLCC_QOS_H_
@@ -229,6 +229,20 @@ struct swap_cluster_list {
 	struct swap_cluster_info tail;
 };
 
+/*
+ * Time si->lock was held by the slot allocation and free paths. Updated
+ * with si->lock held, read locklessly.
+ */
+struct swap_lock_stat {
+	u64 alloc_nr;		/* # of lock holds to allocate slots */
+	u64 alloc_ns;		/* total time held */
+	u64 alloc_max_ns;	/* longest hold */
+	u64 free_nr;		/* # of lock holds to free slots */
+	u64 free_ns;
+	u64 free_max_ns;
+	u64 free_slots;		/* # of slots freed under those holds */
+};
+
 /*
  * The in-memory structure used to track swap areas.
  */
@@ -275,6 +289,7 @@ struct swap_info_struct {
 					 */
 	struct work_struct discard_work; /* discard worker */
 	struct swap_cluster_list discard_clusters; /* discard clusters list */
+	struct swap_lock_stat lock_stat;	/* si->lock hold times */
 	struct plist_node avail_lists[0]; /*
 					   * entries in swap_avail_heads, one
 					   * entry per node.
@@ -362,6 +377,9 @@ extern unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *memcg,
 						  unsigned long nr_pages,
 						  gfp_t gfp_mask,
 						  bool may_swap);
+extern void mem_cgroup_age_working_set(struct mem_cgroup *memcg,
+				       unsigned long *ws,
+				       unsigned long *scanned);
 extern unsigned long mem_cgroup_shrink_node(struct mem_cgroup *mem,
 						gfp_t gfp_mask, bool noswap,
 						pg_data_t *pgdat,
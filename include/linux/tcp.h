@@ -357,6 +357,7 @@ struct tcp_sock {
 #endif
 
 	u32 rcv_ooopack; /* Received out-of-order packets, for tcpinfo */
+	u32 rcv_link_kbps; /* Link capacity that seeded rcvbuf, for tcpinfo */
 
 /* Receiver side RTT estimation */
 	u32 rcv_rtt_last_tsecr;
@@ -0,0 +1,22 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef __THERMAL_FRAME_H__
+#define __THERMAL_FRAME_H__
+
+#include <linux/ktime.h>
+#include <linux/types.h>
+
+#ifdef CONFIG_THERMAL_GOV_FRAME_PACING
+void thermal_frame_retired(ktime_t ts);
+void thermal_frame_gpu_busy(u64 busy_us, u64 total_us);
+#else
+static inline void thermal_frame_retired(ktime_t ts)
+{ }
+static inline void thermal_frame_gpu_busy(u64 busy_us, u64 total_us)
+{ }
+#endif
+
+#endif /* __THERMAL_FRAME_H__ */
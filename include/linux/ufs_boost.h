@@ -0,0 +1,15 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef __UFS_BOOST_H
+#define __UFS_BOOST_H
+
+#if IS_REACHABLE(CONFIG_SCSI_UFSHCD)
+extern void ufshcd_boost_hint(unsigned int hold_ms);
+#else
+static inline void ufshcd_boost_hint(unsigned int hold_ms) {}
+#endif
+
+#endif
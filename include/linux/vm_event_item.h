@@ -63,6 +63,7 @@ enum vm_event_item { PGPGIN, PGPGOUT,
 		COMPACTSTALL, COMPACTFAIL, COMPACTSUCCESS,
 		KCOMPACTD_WAKE,
 		KCOMPACTD_MIGRATE_SCANNED, KCOMPACTD_FREE_SCANNED,
+		KCOMPACTD_PROACTIVE_WAKE, KCOMPACTD_PROACTIVE_ABORT,
 #endif
 #ifdef CONFIG_HUGETLB_PAGE
 		HTLB_BUDDY_PGALLOC, HTLB_BUDDY_PGALLOC_FAIL,
@@ -117,6 +118,18 @@ enum vm_event_item { PGPGIN, PGPGOUT,
 #ifdef CONFIG_SPECULATIVE_PAGE_FAULT
 		SPECULATIVE_PGFAULT_ANON,
 		SPECULATIVE_PGFAULT_FILE,
+		SPECULATIVE_PGFAULT_ABORT_VMA,
+		SPECULATIVE_PGFAULT_ABORT_SEQ,
+		SPECULATIVE_PGFAULT_ABORT_ANON_VMA,
+		SPECULATIVE_PGFAULT_ABORT_FILE,
+		SPECULATIVE_PGFAULT_ABORT_WALK,
+		SPECULATIVE_PGFAULT_ABORT_FAULT,
+		SPECULATIVE_PGFAULT_ABORT_OTHER,
+#endif
+#ifdef CONFIG_PCP_HIGH_ORDER
+		PCP_HIGH_ORDER_ALLOC,
+		PCP_HIGH_ORDER_REFILL,
+		PCP_HIGH_ORDER_DRAIN,
 #endif
 		NR_VM_EVENT_ITEMS
 };
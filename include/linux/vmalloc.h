@@ -28,6 +28,7 @@ struct notifier_block;		/* in notifier.h */
  */
 #define VM_FLUSH_RESET_PERMS	0x00000100      /* Reset direct map and flush TLB on unmap */
 #define VM_LOWMEM	0x00000200      /* Tracking of direct mapped lowmem */
+#define VM_HUGE_PMD		0x00000400	/* PMD block mappings where possible */
 
 /* bits [20..32] reserved for arch specific ioremap internals */
 
@@ -92,6 +93,7 @@ static inline unsigned long vmalloc_nr_pages(void) { return 0; }
 extern void *vmalloc(unsigned long size);
 extern void *vzalloc(unsigned long size);
 extern void *vmalloc_user(unsigned long size);
+extern void *vmalloc_huge(unsigned long size, gfp_t gfp_mask);
 extern void *vmalloc_node(unsigned long size, int node);
 extern void *vzalloc_node(unsigned long size, int node);
 extern void *vmalloc_exec(unsigned long size);
@@ -232,6 +232,8 @@ extern int cnss_smmu_map(struct device *dev,
 extern int cnss_smmu_unmap(struct device *dev, uint32_t iova_addr, size_t size);
 extern int cnss_get_soc_info(struct device *dev, struct cnss_soc_info *info);
 extern int cnss_request_bus_bandwidth(struct device *dev, int bandwidth);
+extern int cnss_pci_report_traffic(struct device *dev, u64 tx_bytes,
+				   u64 rx_bytes, bool low_latency);
 extern int cnss_power_up(struct device *dev);
 extern int cnss_power_down(struct device *dev);
 extern int cnss_idle_restart(struct device *dev);
@@ -10,6 +10,7 @@
 
 extern void *wcnss_prealloc_get(size_t size);
 extern int wcnss_prealloc_put(void *ptr);
+extern void wcnss_prealloc_fallback_done(size_t size, u64 latency_ns);
 extern int wcnss_pre_alloc_reset(void);
 void wcnss_prealloc_check_memory_leak(void);
 
@@ -4,11 +4,25 @@
 #ifndef __QCOM_BOOT_STATS_H__
 #define __QCOM_BOOT_STATS_H__
 
+enum boot_event_type {
+	BOOT_EVENT_INITCALL,
+	BOOT_EVENT_MODULE,
+	BOOT_EVENT_FIRMWARE,
+	BOOT_EVENT_DISPLAY,
+	BOOT_EVENT_MOUNT,
+	BOOT_EVENT_VERITY,
+	BOOT_EVENT_MAX,
+};
+
 #ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
 void place_marker(const char *name);
 void destroy_marker(const char *name);
 unsigned long long msm_timer_get_sclk_ticks(void);
 static inline int boot_marker_enabled(void) { return 1; }
+u64 boot_event_start(void);
+void boot_event_record(enum boot_event_type type, const char *name,
+		u64 start);
+void boot_event_initcall(void *fn, u64 start);
 #else
 static inline int init_bootkpi(void) { return 0; }
 static inline void exit_bootkpi(void) { };
@@ -16,5 +30,9 @@ static inline void place_marker(char *name) { };
 static inline void destroy_marker(const char *name) { };
 static inline int boot_marker_enabled(void) { return 0; }
 static inline unsigned long long msm_timer_get_sclk_ticks(void) { return -EINVAL; }
+static inline u64 boot_event_start(void) { return 0; }
+static inline void boot_event_record(enum boot_event_type type,
+		const char *name, u64 start) { }
+static inline void boot_event_initcall(void *fn, u64 start) { }
 #endif
 #endif /* __QCOM_BOOT_STATS_H__ */
@@ -6,6 +6,7 @@
 #ifndef __MINIDUMP_H
 #define __MINIDUMP_H
 
+#include <linux/bits.h>
 #include <linux/types.h>
 
 #define MAX_NAME_LENGTH		12
@@ -25,6 +26,21 @@ struct md_region {
 	u64	size;
 };
 
+/*
+ * Region priorities, lower is more important. When the dump does not fit
+ * the dump budget, the least important regions are dropped first at
+ * panic time. MD_PRIO_CRITICAL regions are never dropped.
+ */
+enum md_region_prio {
+	MD_PRIO_CRITICAL,
+	MD_PRIO_HIGH,
+	MD_PRIO_DEFAULT,
+	MD_PRIO_LOW,
+};
+
+/* Region may be compressed into the bounce area at panic time */
+#define MD_REGION_COMPRESS	BIT(0)
+
 /*
  * Register an entry in Minidump table
  * Returns:
@@ -46,6 +62,19 @@ extern int msm_minidump_remove_region(const struct md_region *entry);
  */
 extern int msm_minidump_update_region(int regno, const struct md_region *entry);
 extern bool msm_minidump_enabled(void);
+/*
+ * Set the priority and MD_REGION_* flags of a registered region.
+ * Returns zero on success, negative error number on failures.
+ */
+extern int msm_minidump_set_region_attr(const char *name,
+					enum md_region_prio prio, u32 flags);
+/*
+ * Dump only the first @size bytes of a registered region. Meant to be
+ * called from panic notifiers with a priority above INT_MIN, so that
+ * large dynamic regions are dumped up to their used part only. Passing
+ * the registered size, or more, dumps the whole region again.
+ */
+extern int msm_minidump_trim_region(const char *name, u64 size);
 extern struct md_region *md_get_region(char *name);
 extern void dump_stack_minidump(u64 sp);
 extern void md_dump_meminfo(void);
@@ -61,6 +90,15 @@ static inline int msm_minidump_remove_region(const struct md_region *entry)
 	return 0;
 }
 static inline bool msm_minidump_enabled(void) { return false; }
+static inline int msm_minidump_set_region_attr(const char *name,
+					enum md_region_prio prio, u32 flags)
+{
+	return 0;
+}
+static inline int msm_minidump_trim_region(const char *name, u64 size)
+{
+	return 0;
+}
 static inline struct md_region *md_get_region(char *name) { return NULL; }
 static inline void dump_stack_minidump(u64 sp) {}
 static inline void add_trace_event(char *buf, size_t size) {}
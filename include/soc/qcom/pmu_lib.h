@@ -0,0 +1,35 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+
+#ifndef _QCOM_PMU_LIB_H
+#define _QCOM_PMU_LIB_H
+
+#include <linux/types.h>
+#include <linux/errno.h>
+
+/* Distinct raw events a single CPU can share between all clients */
+#define QCOM_PMU_MAX_EVS	16
+
+#if IS_ENABLED(CONFIG_QCOM_PMU_LIB)
+int qcom_pmu_event_get(int cpu, u32 event_id);
+void qcom_pmu_event_put(int cpu, u32 event_id);
+int qcom_pmu_read(int cpu, u32 event_id, u64 *count);
+#else
+static inline int qcom_pmu_event_get(int cpu, u32 event_id)
+{
+	return -ENODEV;
+}
+
+static inline void qcom_pmu_event_put(int cpu, u32 event_id)
+{
+}
+
+static inline int qcom_pmu_read(int cpu, u32 event_id, u64 *count)
+{
+	return -ENODEV;
+}
+#endif
+
+#endif /* _QCOM_PMU_LIB_H */
@@ -32,6 +32,7 @@ TRACE_DEFINE_ENUM(CURSEG_COLD_NODE);
 TRACE_DEFINE_ENUM(NO_CHECK_TYPE);
 TRACE_DEFINE_ENUM(GC_GREEDY);
 TRACE_DEFINE_ENUM(GC_CB);
+TRACE_DEFINE_ENUM(GC_AT);
 TRACE_DEFINE_ENUM(FG_GC);
 TRACE_DEFINE_ENUM(BG_GC);
 TRACE_DEFINE_ENUM(LFS);
@@ -117,7 +118,8 @@ TRACE_DEFINE_ENUM(CP_RESIZE);
 #define show_victim_policy(type)					\
 	__print_symbolic(type,						\
 		{ GC_GREEDY,	"Greedy" },				\
-		{ GC_CB,	"Cost-Benefit" })
+		{ GC_CB,	"Cost-Benefit" },			\
+		{ GC_AT,	"Age-Threshold" })
 
 #define show_cpreason(type)						\
 	__print_flags(type, "|",					\
@@ -813,6 +813,48 @@ TRACE_EVENT(memlat_dev_update,
 		__entry->vote)
 );
 
+TRACE_EVENT(memlat_joint_update,
+
+	TP_PROTO(const char *name, unsigned int dev_id, unsigned int stall,
+		 unsigned int ratio, unsigned long meas_mbps,
+		 unsigned long bw_vote, unsigned long lat_vote,
+		 unsigned long vote),
+
+	TP_ARGS(name, dev_id, stall, ratio, meas_mbps, bw_vote, lat_vote, vote),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(unsigned int, dev_id)
+		__field(unsigned int, stall)
+		__field(unsigned int, ratio)
+		__field(unsigned long, meas_mbps)
+		__field(unsigned long, bw_vote)
+		__field(unsigned long, lat_vote)
+		__field(unsigned long, vote)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->dev_id = dev_id;
+		__entry->stall = stall;
+		__entry->ratio = ratio;
+		__entry->meas_mbps = meas_mbps;
+		__entry->bw_vote = bw_vote;
+		__entry->lat_vote = lat_vote;
+		__entry->vote = vote;
+	),
+
+	TP_printk("dev: %s, id=%u, stall=%u, ratio=%u, mbps=%lu, bw_vote=%lu, lat_vote=%lu, vote=%lu",
+		__get_str(name),
+		__entry->dev_id,
+		__entry->stall,
+		__entry->ratio,
+		__entry->meas_mbps,
+		__entry->bw_vote,
+		__entry->lat_vote,
+		__entry->vote)
+);
+
 TRACE_EVENT(sugov_util_update,
 	    TP_PROTO(int cpu,
 		     unsigned long util, unsigned long avg_cap,
@@ -95,6 +95,36 @@ TRACE_EVENT(ufshcd_clk_scaling,
 		__entry->prev_state, __entry->curr_state)
 );
 
+TRACE_EVENT(ufshcd_clk_scaling_boost,
+
+	TP_PROTO(const char *dev_name, const char *trigger, int active_reqs,
+		 s64 lead_us, s64 scale_us, int err),
+
+	TP_ARGS(dev_name, trigger, active_reqs, lead_us, scale_us, err),
+
+	TP_STRUCT__entry(
+		__string(dev_name, dev_name)
+		__string(trigger, trigger)
+		__field(int, active_reqs)
+		__field(s64, lead_us)
+		__field(s64, scale_us)
+		__field(int, err)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev_name, dev_name);
+		__assign_str(trigger, trigger);
+		__entry->active_reqs = active_reqs;
+		__entry->lead_us = lead_us;
+		__entry->scale_us = scale_us;
+		__entry->err = err;
+	),
+
+	TP_printk("%s: boost on %s, active_reqs %d, raised after %lld us (scaling %lld us), err %d",
+		__get_str(dev_name), __get_str(trigger), __entry->active_reqs,
+		__entry->lead_us, __entry->scale_us, __entry->err)
+);
+
 TRACE_EVENT(ufshcd_auto_bkops_state,
 
 	TP_PROTO(const char *dev_name, const char *state),
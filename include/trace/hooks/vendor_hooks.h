@@ -11,13 +11,128 @@
 
 #if defined(CONFIG_TRACEPOINTS) && defined(CONFIG_ANDROID_VENDOR_HOOKS)
 
+#if defined(CONFIG_ANDROID_VENDOR_HOOKS_STATS) && !defined(_VENDOR_HOOK_STATS)
+#define _VENDOR_HOOK_STATS
+#include <linux/sched/clock.h>
+
+/*
+ * Call count and sampled cost of a hook, only updated while a probe is
+ * attached. Like the branch profiler the updates are not atomic, the
+ * numbers are statistics.
+ */
+struct vendor_hook_stats {
+	struct tracepoint	*tp;
+	unsigned long		calls;
+	unsigned long		samples;
+	u64			total_ns;
+	u64			max_ns;
+};
+
+/* Time one in every 1 << VENDOR_HOOK_SAMPLE_SHIFT calls */
+#define VENDOR_HOOK_SAMPLE_SHIFT	6
+#define VENDOR_HOOK_SAMPLE_MASK		((1UL << VENDOR_HOOK_SAMPLE_SHIFT) - 1)
+
+extern void vendor_hook_stats_sample(struct vendor_hook_stats *stats,
+				     u64 start);
+
+#define VENDOR_HOOK_STATS_DECLARE(name)					\
+	extern struct vendor_hook_stats __vh_stats_##name;
+
+#define VENDOR_HOOK_STATS_DEFINE(name)					\
+	struct vendor_hook_stats __vh_stats_##name			\
+	__used __section(__vendor_hook_stats) =				\
+		{ .tp = &__tracepoint_##name };
+
+#define VENDOR_HOOK_CALL(name, call)					\
+	do {								\
+		struct vendor_hook_stats *__stats = &__vh_stats_##name;	\
+		u64 __start;						\
+									\
+		if (++__stats->calls & VENDOR_HOOK_SAMPLE_MASK) {	\
+			call;						\
+			break;						\
+		}							\
+		__start = local_clock();				\
+		call;							\
+		vendor_hook_stats_sample(__stats, __start);		\
+	} while (0)
+
+/*
+ * DECLARE_TRACE() with the probe call wrapped in VENDOR_HOOK_CALL(), the
+ * rest of the API is the same so hook users build unchanged.
+ */
+#define __DECLARE_HOOK_STATS(name, proto, args, data_proto, data_args)	\
+	extern struct tracepoint __tracepoint_##name;			\
+	VENDOR_HOOK_STATS_DECLARE(name)					\
+	static inline void trace_##name(proto)				\
+	{								\
+		if (static_key_false(&__tracepoint_##name.key))		\
+			VENDOR_HOOK_CALL(name,				\
+				__DO_TRACE(&__tracepoint_##name,	\
+					TP_PROTO(data_proto),		\
+					TP_ARGS(data_args),		\
+					TP_CONDITION(1), 0));		\
+	}								\
+	static inline int						\
+	register_trace_##name(void (*probe)(data_proto), void *data)	\
+	{								\
+		return tracepoint_probe_register(&__tracepoint_##name,	\
+						(void *)probe, data);	\
+	}								\
+	static inline int						\
+	register_trace_prio_##name(void (*probe)(data_proto), void *data,\
+				   int prio)				\
+	{								\
+		return tracepoint_probe_register_prio(&__tracepoint_##name, \
+					      (void *)probe, data, prio); \
+	}								\
+	static inline int						\
+	unregister_trace_##name(void (*probe)(data_proto), void *data)	\
+	{								\
+		return tracepoint_probe_unregister(&__tracepoint_##name,\
+						(void *)probe, data);	\
+	}								\
+	static inline void						\
+	check_trace_callback_type_##name(void (*cb)(data_proto))	\
+	{								\
+	}								\
+	static inline bool						\
+	trace_##name##_enabled(void)					\
+	{								\
+		return static_key_false(&__tracepoint_##name.key);	\
+	}
+#elif !defined(CONFIG_ANDROID_VENDOR_HOOKS_STATS)
+#undef VENDOR_HOOK_STATS_DECLARE
+#define VENDOR_HOOK_STATS_DECLARE(name)
+#undef VENDOR_HOOK_STATS_DEFINE
+#define VENDOR_HOOK_STATS_DEFINE(name)
+#undef VENDOR_HOOK_CALL
+#define VENDOR_HOOK_CALL(name, call)	call
+#endif
+
+#undef DECLARE_HOOK
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS_STATS
+#define DECLARE_HOOK(name, proto, args)					\
+	__DECLARE_HOOK_STATS(name, PARAMS(proto), PARAMS(args),		\
+			PARAMS(void *__data, proto),			\
+			PARAMS(__data, args))
+#else
 #define DECLARE_HOOK DECLARE_TRACE
+#endif
 
 #ifdef TRACE_HEADER_MULTI_READ
 
+#ifdef CONFIG_ANDROID_VENDOR_HOOKS_STATS
+#undef DECLARE_HOOK
+#define DECLARE_HOOK(name, proto, args)					\
+	DEFINE_TRACE(name)						\
+	VENDOR_HOOK_STATS_DEFINE(name)
+#endif
+
 #undef DECLARE_RESTRICTED_HOOK
 #define DECLARE_RESTRICTED_HOOK(name, proto, args, cond) \
-	DEFINE_TRACE(name)
+	DEFINE_TRACE(name)						\
+	VENDOR_HOOK_STATS_DEFINE(name)
 
 
 /* prevent additional recursion */
@@ -44,13 +159,15 @@
 
 #define __DECLARE_HOOK(name, proto, args, cond, data_proto, data_args)	\
 	extern struct tracepoint __tracepoint_##name;			\
+	VENDOR_HOOK_STATS_DECLARE(name)					\
 	static inline void trace_##name(proto)				\
 	{								\
 		if (static_key_false(&__tracepoint_##name.key))		\
-			DO_HOOK(&__tracepoint_##name,			\
-				TP_PROTO(data_proto),			\
-				TP_ARGS(data_args),			\
-				TP_CONDITION(cond));			\
+			VENDOR_HOOK_CALL(name,				\
+				DO_HOOK(&__tracepoint_##name,		\
+					TP_PROTO(data_proto),		\
+					TP_ARGS(data_args),		\
+					TP_CONDITION(cond)));		\
 	}								\
 	static inline bool						\
 	trace_##name##_enabled(void)					\
@@ -151,6 +151,8 @@
 #define KGSL_MEMFLAGS_SPARSE_VIRT (1ULL << 30)
 #define KGSL_MEMFLAGS_IOCOHERENT  (1ULL << 31)
 #define KGSL_MEMFLAGS_GUARD_PAGE  (1ULL << 33)
+/* Map all pages into the CPU mapping at mmap() instead of on fault */
+#define KGSL_MEMFLAGS_PREFAULT    (1ULL << 34)
 
 /* Memory types for which allocations are made */
 #define KGSL_MEMTYPE_MASK		0x0000FF00
@@ -343,6 +345,7 @@ enum kgsl_timestamp_type {
 #define KGSL_PROP_CONTEXT_PROPERTY	0x28
 #define KGSL_PROP_GPU_MODEL		0x29
 #define KGSL_PROP_VK_DEVICE_ID		0x2A
+#define KGSL_PROP_TIMELINE_SHADOW	0x2B
 
 /*
  * kgsl_capabilities_properties returns a list of supported properties.
@@ -526,6 +529,10 @@ struct kgsl_cmdbatch_profiling_buffer {
  * for KGSL_PROP_DEVICE_SHADOW, use struct kgsl_shadowprop
  * this is used to find mmap() offset and sizes for mapping
  * struct kgsl_memstore into userspace.
+ * for KGSL_PROP_TIMELINE_SHADOW, use struct kgsl_shadowprop
+ * this is used to find the mmap() offset and size of the read only
+ * timeline shadow page. The page is an array of __u64 values and entry N
+ * holds the current value of timeline N, for timelines whose id fits.
  */
 struct kgsl_device_getproperty {
 	unsigned int type;
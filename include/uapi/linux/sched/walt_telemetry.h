@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0-only WITH Linux-syscall-note */
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+#ifndef _UAPI_LINUX_SCHED_WALT_TELEMETRY_H
+#define _UAPI_LINUX_SCHED_WALT_TELEMETRY_H
+
+#include <linux/types.h>
+
+/*
+ * Layout of the read-only area exported by mmap() on /dev/walt_telemetry.
+ *
+ * The area starts with a struct walt_telemetry_header, followed by
+ * nr_cpus rings of ring_size records each, starting at ring_offset and
+ * ring_stride bytes apart. Each CPU writes only its own ring, once per
+ * scheduler tick. head counts the records written so far; the latest one
+ * is at index (head - 1) % ring_size.
+ *
+ * A record is stable when seq is even and unchanged across the read:
+ *
+ *	do {
+ *		seq = READ_ONCE(rec->seq);
+ *		rmb();
+ *		copy = *rec;
+ *		rmb();
+ *	} while ((seq & 1) || seq != READ_ONCE(rec->seq));
+ */
+#define WALT_TELEMETRY_VERSION		1
+
+struct walt_telemetry_header {
+	__u32	version;
+	__u32	nr_cpus;
+	__u32	ring_size;
+	__u32	record_size;
+	__u32	ring_offset;
+	__u32	ring_stride;
+	__u32	window_size_ns;
+	__u32	reserved;
+};
+
+struct walt_telemetry_record {
+	__u32	seq;
+	__u32	cpu;
+	__u64	timestamp_ns;		/* sched_clock() of the sample */
+	__u64	window_start_ns;
+	__u64	prev_window_busy_ns;	/* CPU busy time in the last window */
+	__u64	curr_window_busy_ns;	/* CPU busy time in the current window */
+	__u32	pred_demand;		/* in capacity units */
+	__u32	nr_running_avg;		/* x100, since the previous record */
+	__u32	nr_big_tasks;
+	__u32	cur_freq_khz;
+};
+
+struct walt_telemetry_ring {
+	__u32	head;
+	__u32	reserved;
+	struct walt_telemetry_record records[];
+};
+
+#endif /* _UAPI_LINUX_SCHED_WALT_TELEMETRY_H */
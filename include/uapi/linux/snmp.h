@@ -285,6 +285,8 @@ enum
 	LINUX_MIB_TCPRCVQDROP,			/* TCPRcvQDrop */
 	LINUX_MIB_TCPWQUEUETOOBIG,		/* TCPWqueueTooBig */
 	LINUX_MIB_TCPFASTOPENPASSIVEALTKEY,	/* TCPFastOpenPassiveAltKey */
+	LINUX_MIB_TCPPACINGTIMER,		/* TCPPacingTimer */
+	LINUX_MIB_TCPPACINGTIMERDELAYUS,	/* TCPPacingTimerDelayUs */
 	__LINUX_MIB_MAX
 };
 
@@ -276,6 +276,9 @@ struct tcp_info {
 	__u32	tcpi_snd_wnd;	     /* peer's advertised receive window after
 				      * scaling (bytes)
 				      */
+	__u32	tcpi_rcv_link_kbps;  /* link capacity hint that seeded the
+				      * receive buffer (kbit/s), 0 if none
+				      */
 };
 
 /* netlink attributes types for SCM_TIMESTAMPING_OPT_STATS */
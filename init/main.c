@@ -1670,13 +1670,22 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	int count = preempt_count();
 	char msgbuf[64];
 	int ret;
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	u64 boot_ev;
+#endif
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	boot_ev = boot_event_start();
+#endif
 	do_trace_initcall_start(fn);
 	ret = fn();
 	do_trace_initcall_finish(fn, ret);
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	boot_event_initcall(fn, boot_ev);
+#endif
 
 	msgbuf[0] = 0;
 
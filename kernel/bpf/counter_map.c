@@ -0,0 +1,438 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * counter_map.c: BPF per CPU counter map
+ *
+ * A hash of per CPU counters for per packet accounting. Keys are added and
+ * removed from userspace only, typically when a UID is registered, so a
+ * program never allocates: it looks up the counters of an existing key and
+ * updates its own CPU's copy without taking any lock, and gets -ENOENT for
+ * keys that were never added. Userspace reads the counters of many keys at
+ * once with BPF_MAP_LOOKUP_BATCH.
+ */
+#include <linux/bpf.h>
+#include <linux/jhash.h>
+#include <linux/mm.h>
+#include <linux/random.h>
+#include <linux/rculist.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+
+#define COUNTER_CREATE_FLAG_MASK \
+	(BPF_F_NUMA_NODE | BPF_F_ACCESS_MASK)
+
+struct counter_elem {
+	struct hlist_node node;
+	struct rcu_head rcu;
+	void __percpu *value;
+	u32 hash;
+	char key[0] __aligned(8);
+};
+
+struct bpf_counter_map {
+	struct bpf_map map;
+	raw_spinlock_t lock;	/* serialises insertion and removal */
+	struct hlist_head *buckets;
+	u32 n_buckets;
+	u32 count;
+	u32 hashrnd;
+};
+
+static struct bpf_counter_map *bpf_counter_map(struct bpf_map *map)
+{
+	return container_of(map, struct bpf_counter_map, map);
+}
+
+static struct hlist_head *counter_bucket(struct bpf_counter_map *cmap,
+					 u32 hash)
+{
+	return &cmap->buckets[hash & (cmap->n_buckets - 1)];
+}
+
+/* Called from syscall */
+static int counter_map_alloc_check(union bpf_attr *attr)
+{
+	if (attr->max_entries == 0 || attr->key_size == 0 ||
+	    attr->value_size == 0 || attr->value_size % sizeof(u64) ||
+	    attr->map_flags & ~COUNTER_CREATE_FLAG_MASK ||
+	    !bpf_map_flags_access_ok(attr->map_flags))
+		return -EINVAL;
+
+	if (attr->key_size > MAX_BPF_STACK ||
+	    attr->value_size > PCPU_MIN_UNIT_SIZE)
+		return -E2BIG;
+
+	return 0;
+}
+
+static struct bpf_map *counter_map_alloc(union bpf_attr *attr)
+{
+	int ret, numa_node = bpf_map_attr_numa_node(attr);
+	struct bpf_map_memory mem = {0};
+	struct bpf_counter_map *cmap;
+	u32 n_buckets, i;
+	u64 cost;
+
+	n_buckets = roundup_pow_of_two(attr->max_entries);
+	if (!n_buckets || n_buckets > U32_MAX / sizeof(struct hlist_head))
+		return ERR_PTR(-E2BIG);
+
+	cost = sizeof(*cmap) + (u64)n_buckets * sizeof(struct hlist_head);
+	cost += (u64)attr->max_entries *
+		(sizeof(struct counter_elem) + round_up(attr->key_size, 8) +
+		 (u64)attr->value_size * num_possible_cpus());
+
+	ret = bpf_map_charge_init(&mem, cost);
+	if (ret < 0)
+		return ERR_PTR(ret);
+
+	cmap = kzalloc_node(sizeof(*cmap), GFP_USER, numa_node);
+	if (!cmap)
+		goto free_charge;
+
+	cmap->buckets = bpf_map_area_alloc(n_buckets *
+					   sizeof(struct hlist_head),
+					   numa_node);
+	if (!cmap->buckets)
+		goto free_cmap;
+
+	for (i = 0; i < n_buckets; i++)
+		INIT_HLIST_HEAD(&cmap->buckets[i]);
+
+	bpf_map_init_from_attr(&cmap->map, attr);
+	bpf_map_charge_move(&cmap->map.memory, &mem);
+	raw_spin_lock_init(&cmap->lock);
+	cmap->n_buckets = n_buckets;
+	cmap->hashrnd = get_random_int();
+
+	return &cmap->map;
+
+free_cmap:
+	kfree(cmap);
+free_charge:
+	bpf_map_charge_finish(&mem);
+	return ERR_PTR(-ENOMEM);
+}
+
+static void counter_elem_free(struct counter_elem *e)
+{
+	free_percpu(e->value);
+	kfree(e);
+}
+
+static void counter_elem_free_rcu(struct rcu_head *head)
+{
+	counter_elem_free(container_of(head, struct counter_elem, rcu));
+}
+
+/* Called when map->refcnt goes to zero, either from workqueue or from syscall */
+static void counter_map_free(struct bpf_map *map)
+{
+	struct bpf_counter_map *cmap = bpf_counter_map(map);
+	struct counter_elem *e;
+	struct hlist_node *n;
+	u32 i;
+
+	/* Wait for programs still using the map, and for elements deleted
+	 * before it went away.
+	 */
+	synchronize_rcu();
+	rcu_barrier();
+
+	for (i = 0; i < cmap->n_buckets; i++)
+		hlist_for_each_entry_safe(e, n, &cmap->buckets[i], node)
+			counter_elem_free(e);
+
+	bpf_map_area_free(cmap->buckets);
+	kfree(cmap);
+}
+
+static struct counter_elem *__counter_map_lookup(struct bpf_counter_map *cmap,
+						 void *key)
+{
+	u32 key_size = cmap->map.key_size;
+	u32 hash = jhash(key, key_size, cmap->hashrnd);
+	struct counter_elem *e;
+
+	hlist_for_each_entry_rcu(e, counter_bucket(cmap, hash), node)
+		if (e->hash == hash && !memcmp(e->key, key, key_size))
+			return e;
+
+	return NULL;
+}
+
+/* Called from syscall or from eBPF program */
+static void *counter_map_lookup_elem(struct bpf_map *map, void *key)
+{
+	struct counter_elem *e = __counter_map_lookup(bpf_counter_map(map),
+						      key);
+
+	return e ? this_cpu_ptr(e->value) : NULL;
+}
+
+/* Called from eBPF program: only the counters of this CPU are set, and
+ * only for keys added by userspace.
+ */
+static int counter_map_update_elem(struct bpf_map *map, void *key,
+				   void *value, u64 map_flags)
+{
+	struct counter_elem *e;
+
+	if (unlikely(map_flags > BPF_EXIST))
+		return -EINVAL;
+
+	e = __counter_map_lookup(bpf_counter_map(map), key);
+	if (!e)
+		return -ENOENT;
+	if (map_flags == BPF_NOEXIST)
+		return -EEXIST;
+
+	memcpy(this_cpu_ptr(e->value), value, map->value_size);
+	return 0;
+}
+
+/* Called from syscall or from eBPF program */
+static int counter_map_delete_elem(struct bpf_map *map, void *key)
+{
+	struct bpf_counter_map *cmap = bpf_counter_map(map);
+	struct counter_elem *e;
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&cmap->lock, flags);
+	e = __counter_map_lookup(cmap, key);
+	if (e) {
+		hlist_del_rcu(&e->node);
+		cmap->count--;
+	}
+	raw_spin_unlock_irqrestore(&cmap->lock, flags);
+
+	if (!e)
+		return -ENOENT;
+
+	call_rcu(&e->rcu, counter_elem_free_rcu);
+	return 0;
+}
+
+/* Called from syscall */
+static int counter_map_get_next_key(struct bpf_map *map, void *key,
+				    void *next_key)
+{
+	struct bpf_counter_map *cmap = bpf_counter_map(map);
+	struct counter_elem *e = NULL;
+	struct hlist_node *node;
+	u32 i = 0;
+
+	if (key)
+		e = __counter_map_lookup(cmap, key);
+
+	if (e) {
+		/* The next key in this bucket, else in the following ones */
+		i = (e->hash & (cmap->n_buckets - 1)) + 1;
+		node = rcu_dereference_raw(hlist_next_rcu(&e->node));
+		e = hlist_entry_safe(node, struct counter_elem, node);
+	}
+
+	for (; !e && i < cmap->n_buckets; i++) {
+		node = rcu_dereference_raw(hlist_first_rcu(&cmap->buckets[i]));
+		e = hlist_entry_safe(node, struct counter_elem, node);
+	}
+
+	if (!e)
+		return -ENOENT;
+
+	memcpy(next_key, e->key, map->key_size);
+	return 0;
+}
+
+int bpf_percpu_counter_copy(struct bpf_map *map, void *key, void *value)
+{
+	u32 size = round_up(map->value_size, 8);
+	struct counter_elem *e;
+	int cpu, off = 0;
+
+	rcu_read_lock();
+	e = __counter_map_lookup(bpf_counter_map(map), key);
+	if (e) {
+		for_each_possible_cpu(cpu) {
+			bpf_long_memcpy(value + off,
+					per_cpu_ptr(e->value, cpu), size);
+			off += size;
+		}
+	}
+	rcu_read_unlock();
+
+	return e ? 0 : -ENOENT;
+}
+
+static void counter_elem_set(struct bpf_map *map, struct counter_elem *e,
+			     void *value)
+{
+	u32 size = round_up(map->value_size, 8);
+	int cpu, off = 0;
+
+	for_each_possible_cpu(cpu) {
+		bpf_long_memcpy(per_cpu_ptr(e->value, cpu), value + off, size);
+		off += size;
+	}
+}
+
+/* Called from syscall: this is where keys are added, with the counters of
+ * every CPU as value.
+ */
+int bpf_percpu_counter_update(struct bpf_map *map, void *key, void *value,
+			      u64 map_flags)
+{
+	struct bpf_counter_map *cmap = bpf_counter_map(map);
+	struct counter_elem *e, *new;
+	unsigned long flags;
+	int ret = 0;
+
+	if (unlikely(map_flags > BPF_EXIST))
+		return -EINVAL;
+
+	rcu_read_lock();
+	e = __counter_map_lookup(cmap, key);
+	if (e) {
+		if (map_flags == BPF_NOEXIST)
+			ret = -EEXIST;
+		else
+			counter_elem_set(map, e, value);
+	}
+	rcu_read_unlock();
+	if (e)
+		return ret;
+	if (map_flags == BPF_EXIST)
+		return -ENOENT;
+
+	new = kzalloc_node(sizeof(*new) + round_up(map->key_size, 8),
+			   GFP_ATOMIC | __GFP_NOWARN, map->numa_node);
+	if (!new)
+		return -ENOMEM;
+
+	new->value = __alloc_percpu_gfp(round_up(map->value_size, 8), 8,
+					GFP_ATOMIC | __GFP_NOWARN);
+	if (!new->value) {
+		kfree(new);
+		return -ENOMEM;
+	}
+
+	memcpy(new->key, key, map->key_size);
+	new->hash = jhash(key, map->key_size, cmap->hashrnd);
+	counter_elem_set(map, new, value);
+
+	raw_spin_lock_irqsave(&cmap->lock, flags);
+	if (__counter_map_lookup(cmap, key)) {
+		ret = -EEXIST;
+	} else if (cmap->count >= map->max_entries) {
+		ret = -E2BIG;
+	} else {
+		hlist_add_head_rcu(&new->node, counter_bucket(cmap, new->hash));
+		cmap->count++;
+		new = NULL;
+	}
+	raw_spin_unlock_irqrestore(&cmap->lock, flags);
+
+	if (new)
+		counter_elem_free(new);
+
+	return ret;
+}
+
+/* Called from syscall. The batch cursor is a bucket index; a bucket is
+ * returned whole or not at all, so every key is seen exactly once per walk
+ * unless it is added or removed meanwhile.
+ */
+static int counter_map_lookup_batch(struct bpf_map *map,
+				    const union bpf_attr *attr,
+				    union bpf_attr __user *uattr)
+{
+	void __user *uvalues = u64_to_user_ptr(attr->batch.values);
+	void __user *ukeys = u64_to_user_ptr(attr->batch.keys);
+	void __user *ubatch = u64_to_user_ptr(attr->batch.in_batch);
+	struct bpf_counter_map *cmap = bpf_counter_map(map);
+	u32 size = round_up(map->value_size, 8);
+	u32 value_size = size * num_possible_cpus();
+	u32 max_count, total = 0, start, bucket = 0;
+	struct counter_elem *e;
+	void *keys, *values;
+	int cpu, off, ret = 0;
+
+	if (attr->batch.elem_flags || attr->batch.flags)
+		return -EINVAL;
+
+	max_count = min(attr->batch.count, map->max_entries);
+	if (!max_count)
+		return 0;
+
+	if (ubatch && copy_from_user(&bucket, ubatch, sizeof(bucket)))
+		return -EFAULT;
+	if (bucket >= cmap->n_buckets)
+		return -ENOENT;
+
+	keys = kvmalloc_array(max_count, map->key_size, GFP_USER | __GFP_NOWARN);
+	values = kvmalloc_array(max_count, value_size, GFP_USER | __GFP_NOWARN);
+	if (!keys || !values) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (; bucket < cmap->n_buckets; bucket++) {
+		bool full = false;
+
+		start = total;
+		rcu_read_lock();
+		hlist_for_each_entry_rcu(e, &cmap->buckets[bucket], node) {
+			if (total == max_count) {
+				full = true;
+				break;
+			}
+
+			memcpy(keys + total * map->key_size, e->key,
+			       map->key_size);
+			off = total * value_size;
+			for_each_possible_cpu(cpu) {
+				bpf_long_memcpy(values + off,
+						per_cpu_ptr(e->value, cpu),
+						size);
+				off += size;
+			}
+			total++;
+		}
+		rcu_read_unlock();
+
+		if (full) {
+			total = start;
+			break;
+		}
+		cond_resched();
+	}
+
+	if (!total && bucket < cmap->n_buckets) {
+		ret = -ENOSPC;
+		goto out;
+	}
+	if (bucket >= cmap->n_buckets)
+		ret = -ENOENT;
+
+	if (copy_to_user(ukeys, keys, total * map->key_size) ||
+	    copy_to_user(uvalues, values, total * value_size) ||
+	    put_user(total, &uattr->batch.count) ||
+	    copy_to_user(u64_to_user_ptr(attr->batch.out_batch), &bucket,
+			 sizeof(bucket)))
+		ret = -EFAULT;
+
+out:
+	kvfree(keys);
+	kvfree(values);
+	return ret;
+}
+
+const struct bpf_map_ops counter_map_ops = {
+	.map_alloc_check = counter_map_alloc_check,
+	.map_alloc = counter_map_alloc,
+	.map_free = counter_map_free,
+	.map_get_next_key = counter_map_get_next_key,
+	.map_lookup_elem = counter_map_lookup_elem,
+	.map_update_elem = counter_map_update_elem,
+	.map_delete_elem = counter_map_delete_elem,
+	.map_lookup_batch = counter_map_lookup_batch,
+};
@@ -3824,6 +3824,29 @@ static int cgroup_freeze_show(struct seq_file *seq, void *v)
 	return 0;
 }
 
+static int cgroup_freeze_stat_show(struct seq_file *seq, void *v)
+{
+	struct cgroup *cgrp = seq_css(seq)->cgroup;
+	struct cgroup_freezer_state fs;
+
+	spin_lock_irq(&css_set_lock);
+	fs = cgrp->freezer;
+	spin_unlock_irq(&css_set_lock);
+
+	seq_printf(seq, "nr_freezes %lu\n", fs.nr_freezes);
+	seq_printf(seq, "freeze_usec %llu\n",
+		   div_u64(fs.freeze_total_ns, NSEC_PER_USEC));
+	seq_printf(seq, "freeze_max_usec %llu\n",
+		   div_u64(fs.freeze_max_ns, NSEC_PER_USEC));
+	seq_printf(seq, "nr_thaws %lu\n", fs.nr_thaws);
+	seq_printf(seq, "thaw_usec %llu\n",
+		   div_u64(fs.thaw_total_ns, NSEC_PER_USEC));
+	seq_printf(seq, "thaw_max_usec %llu\n",
+		   div_u64(fs.thaw_max_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+
 static ssize_t cgroup_freeze_write(struct kernfs_open_file *of,
 				   char *buf, size_t nbytes, loff_t off)
 {
@@ -5050,6 +5073,11 @@ static struct cftype cgroup_base_files[] = {
 		.seq_show = cgroup_freeze_show,
 		.write = cgroup_freeze_write,
 	},
+	{
+		.name = "cgroup.freeze.stat",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cgroup_freeze_stat_show,
+	},
 	{
 		.name = "cpu.stat",
 		.flags = CFTYPE_NOT_ON_ROOT,
@@ -3,6 +3,7 @@
 #include <linux/sched.h>
 #include <linux/sched/task.h>
 #include <linux/sched/signal.h>
+#include <linux/timekeeping.h>
 
 #include "cgroup-internal.h"
 
@@ -69,6 +70,16 @@ void cgroup_update_frozen(struct cgroup *cgrp)
 			return;
 
 		set_bit(CGRP_FROZEN, &cgrp->flags);
+
+		if (cgrp->freezer.freeze_start_ns) {
+			u64 delta = ktime_get_ns() - cgrp->freezer.freeze_start_ns;
+
+			cgrp->freezer.freeze_start_ns = 0;
+			cgrp->freezer.nr_freezes++;
+			cgrp->freezer.freeze_total_ns += delta;
+			if (delta > cgrp->freezer.freeze_max_ns)
+				cgrp->freezer.freeze_max_ns = delta;
+		}
 	} else {
 		/* Already there? */
 		if (!test_bit(CGRP_FROZEN, &cgrp->flags))
@@ -160,14 +171,26 @@ static void cgroup_freeze_task(struct task_struct *task, bool freeze)
 	if (!lock_task_sighand(task, &flags))
 		return;
 
+	/*
+	 * Only kick tasks whose state actually changes. A task that already
+	 * has JOBCTL_TRAP_FREEZE set keeps TIF_SIGPENDING until it traps, so
+	 * signalling it again on a refreeze or a migration between frozen
+	 * cgroups only costs a wakeup. Likewise a task that was never asked
+	 * to freeze doesn't need waking on thaw.
+	 */
 	if (freeze) {
+		if (task->jobctl & JOBCTL_TRAP_FREEZE)
+			goto out;
 		task->jobctl |= JOBCTL_TRAP_FREEZE;
 		signal_wake_up(task, false);
 	} else {
+		if (!(task->jobctl & JOBCTL_TRAP_FREEZE) && !task->frozen)
+			goto out;
 		task->jobctl &= ~JOBCTL_TRAP_FREEZE;
 		wake_up_process(task);
 	}
 
+out:
 	unlock_task_sighand(task, &flags);
 }
 
@@ -178,14 +201,19 @@ static void cgroup_do_freeze(struct cgroup *cgrp, bool freeze)
 {
 	struct css_task_iter it;
 	struct task_struct *task;
+	u64 start = ktime_get_ns();
 
 	lockdep_assert_held(&cgroup_mutex);
 
 	spin_lock_irq(&css_set_lock);
-	if (freeze)
+	if (freeze) {
 		set_bit(CGRP_FREEZE, &cgrp->flags);
-	else
+		cgrp->freezer.freeze_start_ns = start;
+	} else {
 		clear_bit(CGRP_FREEZE, &cgrp->flags);
+		/* Never reached the frozen state, don't count it */
+		cgrp->freezer.freeze_start_ns = 0;
+	}
 	spin_unlock_irq(&css_set_lock);
 
 	if (freeze)
@@ -212,6 +240,14 @@ static void cgroup_do_freeze(struct cgroup *cgrp, bool freeze)
 	spin_lock_irq(&css_set_lock);
 	if (cgrp->nr_descendants == cgrp->freezer.nr_frozen_descendants)
 		cgroup_update_frozen(cgrp);
+	if (!freeze) {
+		u64 delta = ktime_get_ns() - start;
+
+		cgrp->freezer.nr_thaws++;
+		cgrp->freezer.thaw_total_ns += delta;
+		if (delta > cgrp->freezer.thaw_max_ns)
+			cgrp->freezer.thaw_max_ns = delta;
+	}
 	spin_unlock_irq(&css_set_lock);
 }
 
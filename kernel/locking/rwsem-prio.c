@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Latency aware rwsem spinning: tunables and contention statistics.
+ *
+ * Contention is accounted per lock class. With lockdep the class is the
+ * lockdep key, so e.g. all mmap_sems share one entry; without it the mm's
+ * mmap_sem still gets its own class and every other rwsem is accounted
+ * by address. Once the table is full, new classes land in "<other>".
+ *
+ * Interface, <debugfs>/rwsem_prio/:
+ *   stats    - per class optimistic spin acquisitions, sleeping waits,
+ *              sleeping waits of latency sensitive tasks, owner boosts
+ *              and the total and maximum sleeping wait time. Writing
+ *              anything clears the table.
+ *   spin_us  - extra time a latency sensitive writer spins on a reader
+ *              owned rwsem, 0 disables
+ *   boost_ms - WALT boost lent to the writer that blocks a latency
+ *              sensitive waiter, 0 disables
+ */
+
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/log2.h>
+#include <linux/mm_types.h>
+#include <linux/rwsem.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/string.h>
+
+#include "rwsem.h"
+
+#define RWSEM_STAT_ENTRIES	128
+
+struct rwsem_stat {
+	void *key;
+	const char *name;
+	atomic64_t spin[2];
+	atomic64_t wait[2];
+	atomic64_t prio_wait;
+	atomic64_t boost;
+	atomic64_t wait_ns;
+	atomic64_t wait_max_ns;
+};
+
+unsigned int rwsem_prio_spin_us = 20;
+unsigned int rwsem_prio_boost_ms = 5;
+
+static struct rwsem_stat rwsem_stats[RWSEM_STAT_ENTRIES + 1];
+static struct rwsem_stat *const rwsem_stat_other =
+	&rwsem_stats[RWSEM_STAT_ENTRIES];
+static char rwsem_mmap_sem_key;
+
+static void *rwsem_stat_key(struct rw_semaphore *sem, const char **name)
+{
+#ifdef CONFIG_DEBUG_LOCK_ALLOC
+	if (sem->dep_map.key) {
+		*name = sem->dep_map.name;
+		return sem->dep_map.key;
+	}
+#endif
+	if (current->mm && sem == &current->mm->mmap_sem) {
+		*name = "mmap_sem";
+		return &rwsem_mmap_sem_key;
+	}
+
+	*name = NULL;
+	return sem;
+}
+
+static struct rwsem_stat *rwsem_stat_get(struct rw_semaphore *sem)
+{
+	struct rwsem_stat *st;
+	const char *name;
+	void *key;
+	int i, idx;
+
+	key = rwsem_stat_key(sem, &name);
+	idx = hash_ptr(key, ilog2(RWSEM_STAT_ENTRIES));
+
+	for (i = 0; i < RWSEM_STAT_ENTRIES; i++) {
+		st = &rwsem_stats[(idx + i) % RWSEM_STAT_ENTRIES];
+
+		if (READ_ONCE(st->key) == key)
+			return st;
+		if (!READ_ONCE(st->key) && !cmpxchg(&st->key, NULL, key)) {
+			WRITE_ONCE(st->name, name);
+			return st;
+		}
+	}
+
+	return rwsem_stat_other;
+}
+
+void rwsem_stat_spin(struct rw_semaphore *sem, bool write)
+{
+	atomic64_inc(&rwsem_stat_get(sem)->spin[write]);
+}
+
+void rwsem_stat_wait(struct rw_semaphore *sem, bool write, bool prio,
+		     u64 start)
+{
+	struct rwsem_stat *st = rwsem_stat_get(sem);
+	s64 delta = sched_clock() - start;
+	s64 max = atomic64_read(&st->wait_max_ns);
+
+	atomic64_inc(&st->wait[write]);
+	if (prio)
+		atomic64_inc(&st->prio_wait);
+	atomic64_add(delta, &st->wait_ns);
+
+	while (delta > max) {
+		s64 old = atomic64_cmpxchg(&st->wait_max_ns, max, delta);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+}
+
+void rwsem_stat_boost(struct rw_semaphore *sem)
+{
+	atomic64_inc(&rwsem_stat_get(sem)->boost);
+}
+
+static int rwsem_stat_show(struct seq_file *s, void *unused)
+{
+	struct rwsem_stat *st;
+	char name[48];
+	int i;
+
+	seq_printf(s, "%-40s %10s %10s %10s %10s %10s %10s %12s %10s\n",
+		   "class", "rd_spin", "wr_spin", "rd_wait", "wr_wait",
+		   "prio_wait", "boost", "wait_us", "max_us");
+
+	for (i = 0; i <= RWSEM_STAT_ENTRIES; i++) {
+		st = &rwsem_stats[i];
+
+		if (st == rwsem_stat_other)
+			strlcpy(name, "<other>", sizeof(name));
+		else if (!READ_ONCE(st->key))
+			continue;
+		else if (READ_ONCE(st->name))
+			strlcpy(name, st->name, sizeof(name));
+		else
+			snprintf(name, sizeof(name), "%ps", st->key);
+
+		seq_printf(s, "%-40s %10lld %10lld %10lld %10lld %10lld %10lld %12lld %10lld\n",
+			   name,
+			   atomic64_read(&st->spin[0]),
+			   atomic64_read(&st->spin[1]),
+			   atomic64_read(&st->wait[0]),
+			   atomic64_read(&st->wait[1]),
+			   atomic64_read(&st->prio_wait),
+			   atomic64_read(&st->boost),
+			   div_s64(atomic64_read(&st->wait_ns), NSEC_PER_USEC),
+			   div_s64(atomic64_read(&st->wait_max_ns),
+				   NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int rwsem_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, rwsem_stat_show, NULL);
+}
+
+/*
+ * Clearing races with concurrent updates, which may leave a few counts
+ * behind; good enough to mark the start of a measurement.
+ */
+static ssize_t rwsem_stat_write(struct file *file, const char __user *ubuf,
+				size_t count, loff_t *ppos)
+{
+	memset(rwsem_stats, 0, sizeof(rwsem_stats));
+
+	return count;
+}
+
+static const struct file_operations rwsem_stat_fops = {
+	.open		= rwsem_stat_open,
+	.read		= seq_read,
+	.write		= rwsem_stat_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init rwsem_prio_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("rwsem_prio", NULL);
+	debugfs_create_file("stats", 0600, dir, NULL, &rwsem_stat_fops);
+	debugfs_create_u32("spin_us", 0600, dir, &rwsem_prio_spin_us);
+	debugfs_create_u32("boost_ms", 0600, dir, &rwsem_prio_boost_ms);
+
+	return 0;
+}
+late_initcall(rwsem_prio_init);
@@ -795,9 +795,17 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem, bool wlock)
 	int prev_owner_state = OWNER_NULL;
 	int loop = 0;
 	u64 rspin_threshold = 0;
+	u64 rspin_extra = 0;
 	unsigned long nonspinnable = wlock ? RWSEM_WR_NONSPINNABLE
 					   : RWSEM_RD_NONSPINNABLE;
 
+	/*
+	 * A latency sensitive writer would rather burn a few more cycles
+	 * than sleep behind readers and miss its frame.
+	 */
+	if (wlock && rwsem_prio_waiter())
+		rspin_extra = rwsem_prio_spin_ns();
+
 	preempt_disable();
 
 	/* sem->wait_lock should not be held when doing optimistic spinning */
@@ -840,7 +848,8 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem, bool wlock)
 			if (prev_owner_state != OWNER_READER) {
 				if (rwsem_test_oflags(sem, nonspinnable))
 					break;
-				rspin_threshold = rwsem_rspin_threshold(sem);
+				rspin_threshold = rwsem_rspin_threshold(sem) +
+						  rspin_extra;
 				loop = 0;
 			}
 
@@ -910,6 +919,8 @@ static bool rwsem_optimistic_spin(struct rw_semaphore *sem, bool wlock)
 done:
 	preempt_enable();
 	lockevent_cond_inc(rwsem_opt_fail, !taken);
+	if (taken)
+		rwsem_stat_spin(sem, wlock);
 	return taken;
 }
 
@@ -992,6 +1003,36 @@ rwsem_spin_on_owner(struct rw_semaphore *sem, unsigned long nonspinnable)
 #define OWNER_NULL	1
 #endif
 
+#ifdef CONFIG_RWSEM_PRIO_SPIN
+/*
+ * A latency sensitive task is about to sleep on @sem. Lend the writer
+ * owning it a short WALT boost so that it finishes its critical section
+ * on a big CPU instead of being left runnable on a little one. Reader
+ * owners are only a hint and may be long gone, so they are left alone.
+ */
+static void rwsem_boost_owner(struct rw_semaphore *sem)
+{
+	unsigned int boost_ms = READ_ONCE(rwsem_prio_boost_ms);
+	struct task_struct *owner;
+	unsigned long flags;
+
+	if (!boost_ms)
+		return;
+
+	rcu_read_lock();
+	owner = rwsem_owner_flags(sem, &flags);
+	if (owner && owner != current && !(flags & RWSEM_READER_OWNED) &&
+	    atomic_long_read(&sem->owner) != RWSEM_OWNER_UNKNOWN) {
+		set_task_boost_inherit(owner, TASK_BOOST_ON_MID,
+				       (u64)boost_ms * NSEC_PER_MSEC);
+		rwsem_stat_boost(sem);
+	}
+	rcu_read_unlock();
+}
+#else
+static inline void rwsem_boost_owner(struct rw_semaphore *sem) { }
+#endif
+
 /*
  * Wait for the read lock to be granted
  */
@@ -1003,6 +1044,8 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, int state)
 	DEFINE_WAKE_Q(wake_q);
 	bool wake = false;
 	bool already_on_list = false;
+	bool prio;
+	u64 wait_start;
 
 	/*
 	 * Save the current read-owner of rwsem, if available, and the
@@ -1094,6 +1137,11 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, int state)
 	raw_spin_unlock_irq(&sem->wait_lock);
 	wake_up_q(&wake_q);
 
+	prio = rwsem_prio_waiter();
+	if (prio)
+		rwsem_boost_owner(sem);
+	wait_start = rwsem_stat_clock();
+
 	/* wait to be given the lock */
 	trace_android_vh_rwsem_read_wait_start(sem);
 	for (;;) {
@@ -1116,6 +1164,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, int state)
 
 	__set_current_state(TASK_RUNNING);
 	trace_android_vh_rwsem_read_wait_finish(sem);
+	rwsem_stat_wait(sem, false, prio, wait_start);
 	lockevent_inc(rwsem_rlock);
 	return sem;
 
@@ -1158,6 +1207,8 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	struct rw_semaphore *ret = sem;
 	DEFINE_WAKE_Q(wake_q);
 	bool already_on_list = false;
+	bool prio;
+	u64 wait_start;
 
 	/* do optimistic spinning and steal lock if possible */
 	if (rwsem_can_spin_on_owner(sem, RWSEM_WR_NONSPINNABLE) &&
@@ -1227,6 +1278,11 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 
 wait:
 	trace_android_vh_rwsem_wake(sem);
+	prio = rwsem_prio_waiter();
+	if (prio)
+		rwsem_boost_owner(sem);
+	wait_start = rwsem_stat_clock();
+
 	/* wait until we successfully acquire the lock */
 	trace_android_vh_rwsem_write_wait_start(sem);
 	set_current_state(state);
@@ -1292,6 +1348,7 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	list_del(&waiter.list);
 	rwsem_disable_reader_optspin(sem, disable_rspin);
 	raw_spin_unlock_irq(&sem->wait_lock);
+	rwsem_stat_wait(sem, true, prio, wait_start);
 	lockevent_inc(rwsem_wlock);
 
 	return ret;
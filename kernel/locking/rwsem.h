@@ -3,8 +3,55 @@
 #ifndef __INTERNAL_RWSEM_H
 #define __INTERNAL_RWSEM_H
 #include <linux/rwsem.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
 
 extern void __down_read(struct rw_semaphore *sem);
 extern void __up_read(struct rw_semaphore *sem);
 
+#ifdef CONFIG_RWSEM_PRIO_SPIN
+extern unsigned int rwsem_prio_spin_us;
+extern unsigned int rwsem_prio_boost_ms;
+
+extern void rwsem_stat_spin(struct rw_semaphore *sem, bool write);
+extern void rwsem_stat_wait(struct rw_semaphore *sem, bool write, bool prio,
+			    u64 start);
+extern void rwsem_stat_boost(struct rw_semaphore *sem);
+
+static inline bool rwsem_prio_waiter(void)
+{
+	return task_latency_sensitive(current);
+}
+
+static inline u64 rwsem_prio_spin_ns(void)
+{
+	return (u64)READ_ONCE(rwsem_prio_spin_us) * NSEC_PER_USEC;
+}
+
+static inline u64 rwsem_stat_clock(void)
+{
+	return sched_clock();
+}
+#else
+static inline void rwsem_stat_spin(struct rw_semaphore *sem, bool write) { }
+static inline void rwsem_stat_wait(struct rw_semaphore *sem, bool write,
+				   bool prio, u64 start) { }
+static inline void rwsem_stat_boost(struct rw_semaphore *sem) { }
+
+static inline bool rwsem_prio_waiter(void)
+{
+	return false;
+}
+
+static inline u64 rwsem_prio_spin_ns(void)
+{
+	return 0;
+}
+
+static inline u64 rwsem_stat_clock(void)
+{
+	return 0;
+}
+#endif
+
 #endif /* __INTERNAL_RWSEM_H */
@@ -0,0 +1,373 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Energy Model calibration
+ *
+ * The power values of the Energy Model come from the firmware and describe a
+ * typical part, not the one the kernel runs on. This measures the active
+ * power of each capacity state instead: the performance domain is pinned to
+ * the frequency of the capacity state, and the power drawn from the battery
+ * is compared with one of its CPUs idle and busy-looping. The measured
+ * values can then replace the firmware ones.
+ *
+ * Interface, /sys/kernel/debug/energy_model/calibration:
+ *   echo "run <cpu>"   - measure the performance domain of <cpu>
+ *   echo "apply <cpu>" - load the measured values into the Energy Model
+ *   echo "reset <cpu>" - restore the firmware values
+ *   cat                - per capacity state firmware, current and measured
+ *                        power and the measured efficiency in kHz/mW
+ *
+ * The device must run from its battery while measuring, and should be
+ * otherwise quiet; the result is only as good as the fuel gauge.
+ */
+
+#define pr_fmt(fmt) "em_calibrate: " fmt
+
+#include <linux/cpufreq.h>
+#include <linux/cpumask.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/energy_model.h>
+#include <linux/kthread.h>
+#include <linux/list.h>
+#include <linux/pm_qos.h>
+#include <linux/power_supply.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+
+#define EM_CALIB_SUPPLY		"battery"
+#define EM_CALIB_SETTLE_MS	200
+#define EM_CALIB_SAMPLE_MS	20
+#define EM_CALIB_WINDOW_MS	2000
+
+/**
+ * em_calib_pd - Calibration state of a performance domain
+ * @node:	Link in em_calib_list
+ * @pd:		The performance domain
+ * @orig:	Power of each capacity state as registered, in milli-watts
+ * @measured:	Measured power of each capacity state, 0 if not measured
+ */
+struct em_calib_pd {
+	struct list_head node;
+	struct em_perf_domain *pd;
+	unsigned long *orig;
+	unsigned long *measured;
+};
+
+static LIST_HEAD(em_calib_list);
+static DEFINE_MUTEX(em_calib_mutex);
+static u32 em_calib_window_ms = EM_CALIB_WINDOW_MS;
+
+static struct em_calib_pd *em_calib_get(int cpu)
+{
+	struct em_perf_domain *pd = em_cpu_get(cpu);
+	struct em_calib_pd *c;
+	int i;
+
+	if (!pd)
+		return ERR_PTR(-ENODEV);
+
+	list_for_each_entry(c, &em_calib_list, node)
+		if (c->pd == pd)
+			return c;
+
+	c = kzalloc(sizeof(*c), GFP_KERNEL);
+	if (!c)
+		return ERR_PTR(-ENOMEM);
+
+	c->orig = kcalloc(pd->nr_cap_states, sizeof(*c->orig), GFP_KERNEL);
+	c->measured = kcalloc(pd->nr_cap_states, sizeof(*c->measured),
+			      GFP_KERNEL);
+	if (!c->orig || !c->measured) {
+		kfree(c->orig);
+		kfree(c->measured);
+		kfree(c);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	c->pd = pd;
+	for (i = 0; i < pd->nr_cap_states; i++)
+		c->orig[i] = pd->table[i].power;
+	list_add_tail(&c->node, &em_calib_list);
+
+	return c;
+}
+
+/* Battery power in micro-watts, whatever the sign convention of the gauge. */
+static int em_calib_read_power(struct power_supply *psy, s64 *uw)
+{
+	union power_supply_propval val;
+	s64 ua;
+	int ret;
+
+	ret = power_supply_get_property(psy, POWER_SUPPLY_PROP_POWER_NOW, &val);
+	if (!ret) {
+		*uw = abs(val.intval);
+		return 0;
+	}
+
+	ret = power_supply_get_property(psy, POWER_SUPPLY_PROP_CURRENT_NOW,
+					&val);
+	if (ret)
+		return ret;
+	ua = abs(val.intval);
+
+	ret = power_supply_get_property(psy, POWER_SUPPLY_PROP_VOLTAGE_NOW,
+					&val);
+	if (ret)
+		return ret;
+
+	*uw = div_s64(ua * val.intval, USEC_PER_SEC);
+	return 0;
+}
+
+static int em_calib_average_power(struct power_supply *psy, s64 *uw)
+{
+	unsigned long end = jiffies + msecs_to_jiffies(em_calib_window_ms);
+	s64 sum = 0, sample;
+	int n = 0, ret;
+
+	do {
+		ret = em_calib_read_power(psy, &sample);
+		if (ret)
+			return ret;
+		sum += sample;
+		n++;
+		msleep(EM_CALIB_SAMPLE_MS);
+	} while (time_before(jiffies, end));
+
+	*uw = div_s64(sum, n);
+	return 0;
+}
+
+static int em_calib_busy_fn(void *unused)
+{
+	while (!kthread_should_stop()) {
+		cpu_relax();
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int em_calib_run(struct em_calib_pd *c)
+{
+	struct em_perf_domain *pd = c->pd;
+	struct freq_qos_request min_req, max_req;
+	struct cpufreq_policy *policy;
+	union power_supply_propval val;
+	struct power_supply *psy;
+	struct task_struct *busy;
+	s64 idle_uw, busy_uw;
+	int i, cpu, ret;
+
+	cpu = cpumask_any_and(to_cpumask(pd->cpus), cpu_online_mask);
+	if (cpu >= nr_cpu_ids)
+		return -ENODEV;
+
+	psy = power_supply_get_by_name(EM_CALIB_SUPPLY);
+	if (!psy)
+		return -ENODEV;
+
+	/* Charging current would swamp the contribution of a single CPU. */
+	ret = power_supply_get_property(psy, POWER_SUPPLY_PROP_STATUS, &val);
+	if (!ret && (val.intval == POWER_SUPPLY_STATUS_CHARGING ||
+		     val.intval == POWER_SUPPLY_STATUS_FULL))
+		ret = -EBUSY;
+	if (ret)
+		goto put_psy;
+
+	policy = cpufreq_cpu_get(cpu);
+	if (!policy) {
+		ret = -ENODEV;
+		goto put_psy;
+	}
+
+	ret = freq_qos_add_request(&policy->constraints, &min_req,
+				   FREQ_QOS_MIN, FREQ_QOS_MIN_DEFAULT_VALUE);
+	if (ret < 0)
+		goto put_policy;
+
+	ret = freq_qos_add_request(&policy->constraints, &max_req,
+				   FREQ_QOS_MAX, FREQ_QOS_MAX_DEFAULT_VALUE);
+	if (ret < 0)
+		goto remove_min;
+
+	for (i = 0; i < pd->nr_cap_states; i++) {
+		unsigned long freq = pd->table[i].frequency;
+
+		c->measured[i] = 0;
+
+		/* States are visited in ascending order, so raise max first. */
+		ret = freq_qos_update_request(&max_req, freq);
+		if (ret >= 0)
+			ret = freq_qos_update_request(&min_req, freq);
+		if (ret < 0)
+			break;
+
+		msleep(EM_CALIB_SETTLE_MS);
+		ret = em_calib_average_power(psy, &idle_uw);
+		if (ret)
+			break;
+
+		busy = kthread_create(em_calib_busy_fn, NULL, "em_calib/%d",
+				      cpu);
+		if (IS_ERR(busy)) {
+			ret = PTR_ERR(busy);
+			break;
+		}
+		kthread_bind(busy, cpu);
+		wake_up_process(busy);
+
+		msleep(EM_CALIB_SETTLE_MS);
+		ret = em_calib_average_power(psy, &busy_uw);
+		kthread_stop(busy);
+		if (ret)
+			break;
+
+		if (busy_uw > idle_uw)
+			c->measured[i] = clamp_t(s64,
+					div_s64(busy_uw - idle_uw, 1000),
+					1, EM_CPU_MAX_POWER);
+
+		pr_info("pd%d: %lu kHz: idle %lld uW, busy %lld uW\n",
+			cpumask_first(to_cpumask(pd->cpus)), freq,
+			idle_uw, busy_uw);
+	}
+
+	freq_qos_remove_request(&max_req);
+remove_min:
+	freq_qos_remove_request(&min_req);
+put_policy:
+	cpufreq_cpu_put(policy);
+put_psy:
+	power_supply_put(psy);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int em_calib_apply(struct em_calib_pd *c)
+{
+	struct em_perf_domain *pd = c->pd;
+	unsigned long *power;
+	int i, ret;
+
+	power = kcalloc(pd->nr_cap_states, sizeof(*power), GFP_KERNEL);
+	if (!power)
+		return -ENOMEM;
+
+	for (i = 0; i < pd->nr_cap_states; i++) {
+		if (!c->measured[i]) {
+			ret = -ENODATA;
+			goto out;
+		}
+
+		/* Smooth out noise: power never drops as frequency rises. */
+		power[i] = c->measured[i];
+		if (i > 0 && power[i] < power[i - 1])
+			power[i] = power[i - 1];
+	}
+
+	ret = em_update_perf_domain_power(pd, power);
+out:
+	kfree(power);
+	return ret;
+}
+
+static int em_calib_show(struct seq_file *s, void *unused)
+{
+	struct em_calib_pd *c;
+	unsigned long eff;
+	int i;
+
+	mutex_lock(&em_calib_mutex);
+	list_for_each_entry(c, &em_calib_list, node) {
+		seq_printf(s, "pd%d: cpus %*pbl\n",
+			   cpumask_first(to_cpumask(c->pd->cpus)),
+			   cpumask_pr_args(to_cpumask(c->pd->cpus)));
+		seq_printf(s, "%12s %10s %10s %12s %12s\n", "freq_khz",
+			   "fw_mw", "em_mw", "measured_mw", "khz_per_mw");
+
+		for (i = 0; i < c->pd->nr_cap_states; i++) {
+			eff = c->measured[i] ?
+				c->pd->table[i].frequency / c->measured[i] : 0;
+			seq_printf(s, "%12lu %10lu %10lu %12lu %12lu\n",
+				   c->pd->table[i].frequency, c->orig[i],
+				   READ_ONCE(c->pd->table[i].power),
+				   c->measured[i], eff);
+		}
+	}
+	mutex_unlock(&em_calib_mutex);
+
+	return 0;
+}
+
+static int em_calib_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, em_calib_show, inode->i_private);
+}
+
+static ssize_t em_calib_write(struct file *file, const char __user *ubuf,
+			      size_t count, loff_t *ppos)
+{
+	struct em_calib_pd *c;
+	char buf[32], cmd[8];
+	int cpu, ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, ubuf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sscanf(buf, "%7s %d", cmd, &cpu) != 2)
+		return -EINVAL;
+	if (cpu < 0 || cpu >= nr_cpu_ids)
+		return -EINVAL;
+
+	mutex_lock(&em_calib_mutex);
+	c = em_calib_get(cpu);
+	if (IS_ERR(c)) {
+		ret = PTR_ERR(c);
+		goto unlock;
+	}
+
+	if (!strcmp(cmd, "run"))
+		ret = em_calib_run(c);
+	else if (!strcmp(cmd, "apply"))
+		ret = em_calib_apply(c);
+	else if (!strcmp(cmd, "reset"))
+		ret = em_update_perf_domain_power(c->pd, c->orig);
+	else
+		ret = -EINVAL;
+unlock:
+	mutex_unlock(&em_calib_mutex);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations em_calib_fops = {
+	.open		= em_calib_open,
+	.read		= seq_read,
+	.write		= em_calib_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init em_calib_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_lookup("energy_model", NULL);
+	if (!dir)
+		return -ENOENT;
+
+	debugfs_create_file("calibration", 0600, dir, NULL, &em_calib_fops);
+	debugfs_create_u32("calibration_window_ms", 0600, dir,
+			   &em_calib_window_ms);
+	dput(dir);
+
+	return 0;
+}
+late_initcall(em_calib_init);
@@ -108,6 +108,28 @@ fs_initcall(em_debug_init);
 #else /* CONFIG_DEBUG_FS */
 static void em_debug_create_pd(struct em_perf_domain *pd, int cpu) {}
 #endif
+
+/* Compute the cost of each capacity_state from its power and frequency. */
+static void em_compute_costs(struct em_cap_state *table, int nr_states)
+{
+	u64 fmax = (u64) table[nr_states - 1].frequency;
+	unsigned long cost;
+	int i;
+
+	for (i = 0; i < nr_states; i++) {
+		unsigned long power_res = em_scale_power(table[i].power);
+
+		cost = div64_u64(fmax * power_res, table[i].frequency);
+		if (i > 0 && (cost < table[i - 1].cost) &&
+				(table[i].power > table[i - 1].power)) {
+			cost = table[i - 1].cost;
+		}
+
+		/* The table may be read concurrently by the scheduler. */
+		WRITE_ONCE(table[i].cost, cost);
+	}
+}
+
 static struct em_perf_domain *em_create_pd(cpumask_t *span, int nr_states,
 						struct em_data_callback *cb)
 {
@@ -116,7 +138,6 @@ static struct em_perf_domain *em_create_pd(cpumask_t *span, int nr_states,
 	int i, ret, cpu = cpumask_first(span);
 	struct em_cap_state *table;
 	struct em_perf_domain *pd;
-	u64 fmax;
 
 	if (!cb->active_power)
 		return NULL;
@@ -176,18 +197,7 @@ static struct em_perf_domain *em_create_pd(cpumask_t *span, int nr_states,
 		prev_opp_eff = opp_eff;
 	}
 
-	/* Compute the cost of each capacity_state. */
-	fmax = (u64) table[nr_states - 1].frequency;
-	for (i = 0; i < nr_states; i++) {
-		unsigned long power_res = em_scale_power(table[i].power);
-
-		table[i].cost = div64_u64(fmax * power_res,
-					  table[i].frequency);
-		if (i > 0 && (table[i].cost < table[i - 1].cost) &&
-				(table[i].power > table[i - 1].power)) {
-			table[i].cost = table[i - 1].cost;
-		}
-	}
+	em_compute_costs(table, nr_states);
 
 	pd->table = table;
 	pd->nr_cap_states = nr_states;
@@ -292,3 +302,41 @@ int em_register_perf_domain(cpumask_t *span, unsigned int nr_states,
 	return ret;
 }
 EXPORT_SYMBOL_GPL(em_register_perf_domain);
+
+/**
+ * em_update_perf_domain_power() - Replace the power values of a perf. domain
+ * @pd		: performance domain to update
+ * @power	: new active power of each capacity state, in milli-watts
+ *
+ * Overwrite the power of every capacity state of @pd, e.g. with values
+ * measured at runtime, and recompute the associated costs. The table is
+ * updated in place so that readers never see it go away. A concurrent
+ * energy estimation may see a mix of old and new values for a short time,
+ * which is no worse than the estimate itself.
+ *
+ * Return 0 on success
+ */
+int em_update_perf_domain_power(struct em_perf_domain *pd,
+				const unsigned long *power)
+{
+	int i;
+
+	if (!pd || !power)
+		return -EINVAL;
+
+	for (i = 0; i < pd->nr_cap_states; i++)
+		if (!power[i] || power[i] > EM_CPU_MAX_POWER)
+			return -EINVAL;
+
+	mutex_lock(&em_pd_mutex);
+	for (i = 0; i < pd->nr_cap_states; i++)
+		WRITE_ONCE(pd->table[i].power, power[i]);
+	em_compute_costs(pd->table, pd->nr_cap_states);
+	mutex_unlock(&em_pd_mutex);
+
+	pr_debug("Updated power of perf domain %*pbl\n",
+		 cpumask_pr_args(to_cpumask(pd->cpus)));
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(em_update_perf_domain_power);
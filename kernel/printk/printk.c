@@ -556,6 +556,18 @@ u32 log_buf_len_get(void)
 	return log_buf_len;
 }
 
+/*
+ * Return the number of bytes at the start of log_buf that hold records.
+ * Until the first record is dropped the ring has never wrapped and only
+ * [0, log_next_idx) was written. Lockless, meant for panic time dumpers.
+ */
+u32 log_buf_used_get(void)
+{
+	if (READ_ONCE(log_first_seq))
+		return log_buf_len;
+	return READ_ONCE(log_next_idx);
+}
+
 /* human readable text of the record */
 static char *log_text(const struct printk_log *msg)
 {
@@ -575,7 +575,8 @@ int get_nohz_timer_target(void)
 	int i, cpu = smp_processor_id();
 	struct sched_domain *sd;
 
-	if (!idle_cpu(cpu) && housekeeping_cpu(cpu, HK_FLAG_TIMER))
+	if (!idle_cpu(cpu) && housekeeping_cpu(cpu, HK_FLAG_TIMER) &&
+	    !cpu_isolated(cpu))
 		return cpu;
 
 	rcu_read_lock();
@@ -584,7 +585,8 @@ int get_nohz_timer_target(void)
 			if (cpu == i)
 				continue;
 
-			if (!idle_cpu(i) && housekeeping_cpu(i, HK_FLAG_TIMER)) {
+			if (!idle_cpu(i) && housekeeping_cpu(i, HK_FLAG_TIMER) &&
+			    !cpu_isolated(i)) {
 				cpu = i;
 				goto unlock;
 			}
@@ -593,6 +595,20 @@ int get_nohz_timer_target(void)
 
 	if (!housekeeping_cpu(cpu, HK_FLAG_TIMER))
 		cpu = housekeeping_any_cpu(HK_FLAG_TIMER);
+
+	/*
+	 * Timers armed from an isolated CPU would keep waking it up after
+	 * sched_isolate_cpu() quiesced its timer bases, hand them to an
+	 * unisolated one instead.
+	 */
+	if (cpu_isolated(cpu)) {
+		for_each_online_cpu(i) {
+			if (!cpu_isolated(i)) {
+				cpu = i;
+				break;
+			}
+		}
+	}
 unlock:
 	rcu_read_unlock();
 	return cpu;
@@ -2919,6 +2935,7 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->wts.boost_period		= 0;
 	p->wts.low_latency		= 0;
 	p->wts.iowaited			= false;
+	p->wts.nr_cluster_migrations	= 0;
 #endif
 	INIT_LIST_HEAD(&p->se.group_node);
 
@@ -3865,6 +3882,7 @@ void scheduler_tick(void)
 		flag = SCHED_CPUFREQ_WALT | SCHED_CPUFREQ_EARLY_DET;
 
 	cpufreq_update_util(rq, flag);
+	walt_telemetry_tick(rq);
 	rq_unlock(rq, &rf);
 
 	perf_event_task_tick();
@@ -6818,6 +6836,7 @@ int sched_cpu_activate(unsigned int cpu)
 		static_branch_inc_cpuslocked(&sched_smt_present);
 #endif
 	set_cpu_active(cpu, true);
+	walt_placement_cache_invalidate();
 
 	if (sched_smp_initialized) {
 		sched_domains_numa_masks_set(cpu);
@@ -6848,6 +6867,7 @@ int sched_cpu_deactivate(unsigned int cpu)
 	int ret;
 
 	set_cpu_active(cpu, false);
+	walt_placement_cache_invalidate();
 	/*
 	 * We've cleared cpu_active_mask, wait for all preempt-disabled and RCU
 	 * users of this state to go away such that all new such users will
@@ -6871,6 +6891,7 @@ int sched_cpu_deactivate(unsigned int cpu)
 	ret = cpuset_cpu_inactive(cpu);
 	if (ret) {
 		set_cpu_active(cpu, true);
+		walt_placement_cache_invalidate();
 		return ret;
 	}
 	sched_domains_numa_masks_clear(cpu);
@@ -7422,6 +7443,46 @@ static int sched_colocate_write(struct cgroup_subsys_state *css,
 	tg->wtg.colocate_update_disabled = true;
 	return 0;
 }
+
+static u64 sched_demand_class_read(struct cgroup_subsys_state *css,
+						struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return (u64) tg->wtg.demand_class;
+}
+
+static int sched_demand_class_write(struct cgroup_subsys_state *css,
+				struct cftype *cft, u64 demand_class)
+{
+	struct task_group *tg = css_tg(css);
+
+	if (demand_class >= NR_WALT_DEMAND_CLASSES)
+		return -EINVAL;
+
+	tg->wtg.demand_class = demand_class;
+	return 0;
+}
+
+static u64 sched_predictor_read(struct cgroup_subsys_state *css,
+						struct cftype *cft)
+{
+	struct task_group *tg = css_tg(css);
+
+	return (u64) tg->wtg.predictor;
+}
+
+static int sched_predictor_write(struct cgroup_subsys_state *css,
+				struct cftype *cft, u64 predictor)
+{
+	struct task_group *tg = css_tg(css);
+
+	if (predictor >= NR_WALT_PREDICTORS)
+		return -EINVAL;
+
+	tg->wtg.predictor = predictor;
+	return 0;
+}
 #else
 static void walt_schedgp_attach(struct cgroup_taskset *tset) { }
 #endif /* CONFIG_SCHED_WALT */
@@ -8279,6 +8340,18 @@ static struct cftype cpu_legacy_files[] = {
 		.read_u64 = sched_colocate_read,
 		.write_u64 = sched_colocate_write,
 	},
+	{
+		.name = "uclamp.demand_class",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_demand_class_read,
+		.write_u64 = sched_demand_class_write,
+	},
+	{
+		.name = "uclamp.predictor",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_predictor_read,
+		.write_u64 = sched_predictor_write,
+	},
 #endif /* CONFIG_SCHED_WALT */
 #endif /* CONFIG_UCLAMP_TASK_GROUP */
 	{ }	/* Terminate */
@@ -8480,6 +8553,18 @@ static struct cftype cpu_files[] = {
 		.read_u64 = sched_colocate_read,
 		.write_u64 = sched_colocate_write,
 	},
+	{
+		.name = "uclamp.demand_class",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_demand_class_read,
+		.write_u64 = sched_demand_class_write,
+	},
+	{
+		.name = "uclamp.predictor",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = sched_predictor_read,
+		.write_u64 = sched_predictor_write,
+	},
 #endif /* CONFIG_SCHED_WALT */
 #endif /* CONFIG_UCLAMP_TASK_GROUP */
 	{ }	/* terminate */
@@ -8584,4 +8669,44 @@ int set_task_boost(int boost, u64 period)
 	}
 	return 0;
 }
+
+/*
+ * Lend @boost to @p for @period_ns, e.g. to a lock owner that blocks a
+ * latency sensitive waiter. A stronger boost already held by @p is kept.
+ * The caller must keep @p alive, typically with rcu_read_lock().
+ */
+void set_task_boost_inherit(struct task_struct *p, int boost, u64 period_ns)
+{
+	u64 expires = sched_clock() + period_ns;
+
+	if (boost <= TASK_BOOST_NONE || boost >= TASK_BOOST_END)
+		return;
+	if (per_task_boost(p) > boost)
+		return;
+	if (p->wts.boost == boost && p->wts.boost_expires >= expires)
+		return;
+
+	WRITE_ONCE(p->wts.boost_expires, expires);
+	WRITE_ONCE(p->wts.boost_period, period_ns);
+	WRITE_ONCE(p->wts.boost, boost);
+}
+
+/*
+ * Whether @p is a task whose waits are user visible: RT, boosted through
+ * uclamp or WALT, or in a latency sensitive cgroup.
+ */
+bool task_latency_sensitive(struct task_struct *p)
+{
+	bool ret;
+
+	if (rt_task(p) || uclamp_boosted(p) || walt_low_latency_task(p) ||
+	    per_task_boost(p) > TASK_BOOST_NONE)
+		return true;
+
+	rcu_read_lock();
+	ret = uclamp_latency_sensitive(p);
+	rcu_read_unlock();
+
+	return ret;
+}
 #endif
@@ -913,6 +913,9 @@ void proc_sched_show_task(struct task_struct *p, struct pid_namespace *ns,
 	nr_switches = p->nvcsw + p->nivcsw;
 
 	P(se.nr_migrations);
+#ifdef CONFIG_SCHED_WALT
+	P(wts.nr_cluster_migrations);
+#endif
 
 	if (schedstat_enabled()) {
 		u64 avg_atom, avg_per_cpu;
@@ -6638,6 +6638,7 @@ static void walt_find_best_target(struct sched_domain *sd, cpumask_t *cpus,
 	int cluster;
 	unsigned int target_nr_rtg_high_prio = UINT_MAX;
 	bool rtg_high_prio_task = task_rtg_high_prio(p);
+	const struct walt_placement_cache *pcache;
 	cpumask_t visit_cpus;
 
 	/* Find start CPU based on boost value */
@@ -6674,9 +6675,15 @@ static void walt_find_best_target(struct sched_domain *sd, cpumask_t *cpus,
 			goto out;
 		}
 	}
+	pcache = walt_placement_cache_get();
 	for (cluster = 0; cluster < num_sched_clusters; cluster++) {
 		cpumask_and(&visit_cpus, &p->cpus_mask,
 				&cpu_array[order_index][cluster]);
+		cpumask_and(&visit_cpus, &visit_cpus, &pcache->usable_cpus);
+		if (unisolated_candidate == -1 && !cpumask_empty(&visit_cpus))
+			unisolated_candidate = cpumask_first(&visit_cpus);
+		cpumask_and(&visit_cpus, &visit_cpus, &pcache->candidate_cpus);
+
 		for_each_cpu(i, &visit_cpus) {
 			unsigned long capacity_orig = capacity_orig_of(i);
 			unsigned long wake_util, new_util, new_util_cuml;
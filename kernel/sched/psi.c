@@ -241,6 +241,31 @@ static bool test_state(unsigned int *tasks, enum psi_states state)
 	}
 }
 
+/*
+ * Running total of the system-wide memory 'some' stall time on @cpu,
+ * including a stall that is still in progress. Wraps like the per-cpu
+ * times it is derived from; callers are expected to work with deltas.
+ */
+u32 psi_cpu_memstall_time(int cpu)
+{
+	struct psi_group_cpu *groupc;
+	unsigned int seq;
+	u32 time;
+
+	if (static_branch_likely(&psi_disabled))
+		return 0;
+
+	groupc = per_cpu_ptr(psi_system.pcpu, cpu);
+	do {
+		seq = read_seqcount_begin(&groupc->seq);
+		time = groupc->times[PSI_MEM_SOME];
+		if (groupc->state_mask & (1 << PSI_MEM_SOME))
+			time += cpu_clock(cpu) - groupc->state_start;
+	} while (read_seqcount_retry(&groupc->seq, seq));
+
+	return time;
+}
+
 static void get_recent_times(struct psi_group *group, int cpu,
 			     enum psi_aggregators aggregator, u32 *times,
 			     u32 *pchanged_states)
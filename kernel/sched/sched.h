@@ -93,6 +93,7 @@ struct walt_cpu_load {
 	unsigned long pl;
 	bool rtgb_active;
 	u64 ws;
+	unsigned long ta;
 };
 
 #ifdef CONFIG_SCHED_WALT
@@ -101,11 +102,36 @@ struct walt_cpu_load {
 
 extern unsigned int sched_ravg_window;
 
+/*
+ * Demand classes a cpu cgroup can be tagged with. Runnable demand of the
+ * tasks in each class is accumulated per rq so that the frequency path can
+ * weight e.g. top-app demand without walking the tasks.
+ */
+enum walt_demand_class {
+	WALT_DEMAND_CLASS_OTHER,
+	WALT_DEMAND_CLASS_BG,
+	WALT_DEMAND_CLASS_FG,
+	WALT_DEMAND_CLASS_TA,
+	NR_WALT_DEMAND_CLASSES,
+};
+
+/*
+ * Predictors available for a task's predicted demand (pred_demand). The
+ * predictor is selected per cpu cgroup.
+ */
+enum walt_predictor {
+	WALT_PREDICTOR_BUCKETS,
+	WALT_PREDICTOR_EWMA,
+	WALT_PREDICTOR_PERIODIC,
+	NR_WALT_PREDICTORS,
+};
+
 struct walt_sched_stats {
 	int nr_big_tasks;
 	u64 cumulative_runnable_avg_scaled;
 	u64 pred_demands_sum_scaled;
 	unsigned int nr_rtg_high_prio_tasks;
+	u64 class_demand_scaled[NR_WALT_DEMAND_CLASSES];
 };
 
 struct walt_task_group {
@@ -124,6 +150,10 @@ struct walt_task_group {
 	bool colocate;
 	/* Controls whether further updates are allowed to the colocate flag */
 	bool colocate_update_disabled;
+	/* enum walt_demand_class the tasks of this cgroup are accounted in */
+	u8 demand_class;
+	/* enum walt_predictor used for the pred_demand of this cgroup's tasks */
+	u8 predictor;
 };
 
 struct walt_root_domain {
@@ -150,6 +180,37 @@ struct load_subtractions {
 	u64			new_subs;
 };
 
+/*
+ * Cluster load subtraction recorded on the source rq of a migration and
+ * applied to the target cpu's load_subs at the next WALT irq work.
+ */
+#define WALT_MAX_DEFERRED_SUBS	16
+
+struct walt_deferred_sub {
+	u64			window_start;
+	u64			subs;
+	u64			new_subs;
+	int			cpu;
+};
+
+/*
+ * Copy of the per-cpu window signals published at every window rollover.
+ * Readers on other CPUs use walt_read_window_snapshot() to get a consistent
+ * view without taking the rq lock of the CPU that owns it.
+ */
+struct walt_window_snapshot {
+	u64			window_start;
+	u64			prev_runnable_sum;
+	u64			nt_prev_runnable_sum;
+	u64			grp_prev_runnable_sum;
+	u64			grp_nt_prev_runnable_sum;
+	u64			pred_demands_sum_scaled;
+	u64			class_demand_scaled[NR_WALT_DEMAND_CLASSES];
+	u32			top_task_load;
+	u32			ksoftirqd_load;
+	bool			ed_task;
+};
+
 struct walt_rq {
 	struct task_struct	*push_task;
 	struct walt_sched_cluster *cluster;
@@ -174,8 +235,12 @@ struct walt_rq {
 	u64			cum_window_demand_scaled;
 	struct group_cpu_time	grp_time;
 	struct load_subtractions load_subs[NUM_TRACKED_WINDOWS];
+	struct walt_deferred_sub deferred_subs[WALT_MAX_DEFERRED_SUBS];
+	int			nr_deferred_subs;
 	DECLARE_BITMAP_ARRAY(top_tasks_bitmap,
 			NUM_TRACKED_WINDOWS, NUM_LOAD_INDICES);
+	/* One bit per non-empty word of the matching top_tasks_bitmap */
+	unsigned long		top_tasks_summary[NUM_TRACKED_WINDOWS];
 	u8			*top_tasks[NUM_TRACKED_WINDOWS];
 	u8			curr_table;
 	int			prev_top;
@@ -184,6 +249,9 @@ struct walt_rq {
 	bool			high_irqload;
 	u64			last_cc_update;
 	u64			cycles;
+	seqcount_t		snap_seq;
+	struct walt_window_snapshot snap;
+	u32			last_memstall_time;
 };
 
 struct walt_sched_cluster {
@@ -197,6 +265,8 @@ struct walt_sched_cluster {
 	unsigned int		cur_freq;
 	unsigned int		max_possible_freq;
 	u64			aggr_grp_load;
+	u64			class_demand_scaled[NR_WALT_DEMAND_CLASSES];
+	bool			psi_floor;
 };
 
 extern cpumask_t asym_cap_sibling_cpus;
@@ -5,6 +5,7 @@
 #include "qc_vas.h"
 #include <linux/of.h>
 #include <linux/sched/core_ctl.h>
+#include <linux/workqueue.h>
 #include <trace/events/sched.h>
 
 /*
@@ -317,3 +318,235 @@ int sched_boost_handler(struct ctl_table *table, int write,
 	mutex_unlock(&boost_mutex);
 	return ret;
 }
+
+/*
+ * Timed boost
+ *
+ * For kernel drivers that see a burst of work coming before userspace
+ * does, e.g. a finger landing on the fingerprint sensor ahead of the
+ * unlock. The full throttle boost is held as one more reference next to
+ * any userspace request and dropped by itself @ms after the last call.
+ */
+static DEFINE_MUTEX(timed_boost_mutex);
+static bool timed_boost_active;
+
+static void timed_boost_expire(struct work_struct *work)
+{
+	mutex_lock(&timed_boost_mutex);
+	if (timed_boost_active) {
+		sched_set_boost(FULL_THROTTLE_BOOST_DISABLE);
+		timed_boost_active = false;
+	}
+	mutex_unlock(&timed_boost_mutex);
+}
+static DECLARE_DELAYED_WORK(timed_boost_work, timed_boost_expire);
+
+int sched_boost_timed(unsigned int ms)
+{
+	int ret = 0;
+
+	if (!ms)
+		return -EINVAL;
+
+	mutex_lock(&timed_boost_mutex);
+	if (!timed_boost_active) {
+		ret = sched_set_boost(FULL_THROTTLE_BOOST);
+		if (ret)
+			goto unlock;
+		timed_boost_active = true;
+	}
+	mod_delayed_work(system_highpri_wq, &timed_boost_work,
+			 msecs_to_jiffies(ms));
+unlock:
+	mutex_unlock(&timed_boost_mutex);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(sched_boost_timed);
+
+/*
+ * Frame boost
+ *
+ * Userspace registers the threads of its frame pipeline (UI thread,
+ * RenderThread, SurfaceFlinger) and marks the start of every frame with
+ * its budget. Frames that complete in time are left alone. Once
+ * frame_boost_risk_pct of the budget has elapsed without the frame being
+ * queued, the pipeline threads are boosted on to the max capacity CPUs and
+ * their predicted demand is raised to frame_boost_pred_pct of a window,
+ * until the frame is queued or its budget runs out.
+ */
+#define MAX_FRAME_BOOST_TASKS	8
+
+unsigned int frame_boost_risk_pct = 50;
+unsigned int frame_boost_pred_pct = 80;
+
+static struct task_struct *frame_boost_tasks[MAX_FRAME_BOOST_TASKS];
+static int nr_frame_boost_tasks;
+static u64 frame_boost_deadline;
+static bool frame_boost_active;
+static DEFINE_RAW_SPINLOCK(frame_boost_lock);
+static DEFINE_MUTEX(frame_boost_mutex);
+static struct hrtimer frame_boost_timer;
+
+static void frame_boost_task(struct task_struct *p, u64 now)
+{
+	p->wts.boost = TASK_BOOST_ON_MAX;
+	p->wts.boost_period = frame_boost_deadline - now;
+	p->wts.boost_expires = frame_boost_deadline;
+
+	walt_boost_pred_demand(p, frame_boost_pred_pct);
+}
+
+static void frame_boost_unboost_locked(void)
+{
+	struct task_struct *p;
+	int i;
+
+	if (!frame_boost_active)
+		return;
+
+	for (i = 0; i < nr_frame_boost_tasks; i++) {
+		p = frame_boost_tasks[i];
+		if (p->wts.boost != TASK_BOOST_ON_MAX ||
+				p->wts.boost_expires != frame_boost_deadline)
+			continue;
+
+		p->wts.boost = 0;
+		p->wts.boost_period = 0;
+		p->wts.boost_expires = 0;
+	}
+	frame_boost_active = false;
+}
+
+static enum hrtimer_restart frame_boost_timer_fn(struct hrtimer *timer)
+{
+	unsigned long flags;
+	u64 now = sched_clock();
+	bool boosted = false;
+	int i;
+
+	raw_spin_lock_irqsave(&frame_boost_lock, flags);
+	if (!nr_frame_boost_tasks || now >= frame_boost_deadline)
+		goto unlock;
+
+	for (i = 0; i < nr_frame_boost_tasks; i++)
+		frame_boost_task(frame_boost_tasks[i], now);
+	frame_boost_active = boosted = true;
+	trace_sched_frame_boost(nr_frame_boost_tasks,
+				frame_boost_deadline - now);
+unlock:
+	raw_spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+	if (boosted)
+		walt_kick_cpufreq();
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Replace the set of frame pipeline tasks. Passing nr == 0 unregisters
+ * the pipeline.
+ */
+int sched_frame_boost_set_tasks(const pid_t *pids, int nr)
+{
+	struct task_struct *tasks[MAX_FRAME_BOOST_TASKS];
+	struct task_struct *old[MAX_FRAME_BOOST_TASKS];
+	struct task_struct *p;
+	unsigned long flags;
+	int i, nr_old;
+
+	if (nr < 0 || nr > MAX_FRAME_BOOST_TASKS)
+		return -EINVAL;
+
+	rcu_read_lock();
+	for (i = 0; i < nr; i++) {
+		p = find_task_by_vpid(pids[i]);
+		if (!p) {
+			rcu_read_unlock();
+			while (i--)
+				put_task_struct(tasks[i]);
+			return -ESRCH;
+		}
+		get_task_struct(p);
+		tasks[i] = p;
+	}
+	rcu_read_unlock();
+
+	mutex_lock(&frame_boost_mutex);
+	hrtimer_cancel(&frame_boost_timer);
+
+	raw_spin_lock_irqsave(&frame_boost_lock, flags);
+	frame_boost_unboost_locked();
+	nr_old = nr_frame_boost_tasks;
+	memcpy(old, frame_boost_tasks, nr_old * sizeof(*old));
+	memcpy(frame_boost_tasks, tasks, nr * sizeof(*tasks));
+	nr_frame_boost_tasks = nr;
+	raw_spin_unlock_irqrestore(&frame_boost_lock, flags);
+	mutex_unlock(&frame_boost_mutex);
+
+	for (i = 0; i < nr_old; i++)
+		put_task_struct(old[i]);
+
+	return 0;
+}
+
+int sched_frame_boost_get_tasks(pid_t *pids, int max)
+{
+	unsigned long flags;
+	int i, nr;
+
+	raw_spin_lock_irqsave(&frame_boost_lock, flags);
+	nr = min(nr_frame_boost_tasks, max);
+	for (i = 0; i < nr; i++)
+		pids[i] = task_pid_vnr(frame_boost_tasks[i]);
+	raw_spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+	return nr;
+}
+
+/*
+ * A new frame has started and must be queued within @budget_ns. Any boost
+ * left over from the previous frame is dropped.
+ */
+void sched_frame_boost_start(u64 budget_ns)
+{
+	unsigned long flags;
+	u64 risk_ns;
+
+	mutex_lock(&frame_boost_mutex);
+	hrtimer_cancel(&frame_boost_timer);
+
+	raw_spin_lock_irqsave(&frame_boost_lock, flags);
+	frame_boost_unboost_locked();
+	frame_boost_deadline = sched_clock() + budget_ns;
+	raw_spin_unlock_irqrestore(&frame_boost_lock, flags);
+
+	if (nr_frame_boost_tasks && budget_ns) {
+		risk_ns = mult_frac(budget_ns,
+				    min(frame_boost_risk_pct, 100U), 100);
+		hrtimer_start(&frame_boost_timer, ns_to_ktime(risk_ns),
+			      HRTIMER_MODE_REL);
+	}
+	mutex_unlock(&frame_boost_mutex);
+}
+
+/* The frame has been queued; relax the pipeline. */
+void sched_frame_boost_end(void)
+{
+	unsigned long flags;
+
+	mutex_lock(&frame_boost_mutex);
+	hrtimer_cancel(&frame_boost_timer);
+
+	raw_spin_lock_irqsave(&frame_boost_lock, flags);
+	frame_boost_unboost_locked();
+	raw_spin_unlock_irqrestore(&frame_boost_lock, flags);
+	mutex_unlock(&frame_boost_mutex);
+}
+
+static int __init sched_frame_boost_init(void)
+{
+	hrtimer_init(&frame_boost_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	frame_boost_timer.function = frame_boost_timer_fn;
+	return 0;
+}
+late_initcall(sched_frame_boost_init);
@@ -49,11 +49,13 @@ struct cluster_data {
 	unsigned int boost;
 	struct kobject kobj;
 	unsigned int strict_nrrun;
+	bool predictive;
 };
 
 struct cpu_data {
 	bool is_busy;
 	unsigned int busy;
+	unsigned int pred_busy;
 	unsigned int cpu;
 	bool not_preferred;
 	struct cluster_data *cluster;
@@ -275,6 +277,29 @@ static ssize_t show_enable(const struct cluster_data *state, char *buf)
 	return scnprintf(buf, PAGE_SIZE, "%u\n", state->enable);
 }
 
+static ssize_t store_predictive(struct cluster_data *state,
+				const char *buf, size_t count)
+{
+	unsigned int val;
+	bool bval;
+
+	if (sscanf(buf, "%u\n", &val) != 1)
+		return -EINVAL;
+
+	bval = !!val;
+	if (bval != state->predictive) {
+		state->predictive = bval;
+		apply_need(state);
+	}
+
+	return count;
+}
+
+static ssize_t show_predictive(const struct cluster_data *state, char *buf)
+{
+	return scnprintf(buf, PAGE_SIZE, "%u\n", state->predictive);
+}
+
 static ssize_t show_need_cpus(const struct cluster_data *state, char *buf)
 {
 	return snprintf(buf, PAGE_SIZE, "%u\n", state->need_cpus);
@@ -409,6 +434,7 @@ core_ctl_attr_ro(active_cpus);
 core_ctl_attr_ro(global_state);
 core_ctl_attr_rw(not_preferred);
 core_ctl_attr_rw(enable);
+core_ctl_attr_rw(predictive);
 
 static struct attribute *default_attrs[] = {
 	&min_cpus.attr,
@@ -419,6 +445,7 @@ static struct attribute *default_attrs[] = {
 	&task_thres.attr,
 	&nr_prev_assist_thresh.attr,
 	&enable.attr,
+	&predictive.attr,
 	&need_cpus.attr,
 	&active_cpus.attr,
 	&global_state.attr,
@@ -796,10 +823,11 @@ static bool eval_need(struct cluster_data *cluster)
 	unsigned long flags;
 	struct cpu_data *c;
 	unsigned int need_cpus = 0, last_need, thres_idx;
+	unsigned int busy_need = 0, pred_need = 0;
 	bool adj_now = false;
 	bool adj_possible = false;
 	unsigned int new_need;
-	s64 now, elapsed;
+	s64 now, elapsed = 0;
 
 	if (unlikely(!cluster->inited))
 		return 0;
@@ -822,9 +850,20 @@ static bool eval_need(struct cluster_data *cluster)
 
 			trace_core_ctl_set_busy(c->cpu, c->busy, old_is_busy,
 						c->is_busy);
-			need_cpus += c->is_busy;
+			busy_need += c->is_busy;
+
+			/*
+			 * In predictive mode a CPU whose queued tasks are
+			 * predicted to cross the up threshold in the next
+			 * window counts as busy already, so that the
+			 * unisolation happens before the burst lands.
+			 */
+			if (cluster->predictive && (c->is_busy ||
+			    c->pred_busy >= cluster->busy_up_thres[thres_idx]))
+				pred_need++;
 		}
-		need_cpus = apply_task_need(cluster, need_cpus);
+		need_cpus = apply_task_need(cluster,
+					    max(busy_need, pred_need));
 	}
 	new_need = apply_limits(cluster, need_cpus);
 
@@ -856,6 +895,12 @@ static bool eval_need(struct cluster_data *cluster)
 	}
 
 unlock:
+	trace_core_ctl_eval_inputs(cluster->first_cpu, busy_need, pred_need,
+				   need_cpus, cluster->nrrun,
+				   cluster->nr_prev_assist,
+				   cluster->strict_nrrun, cluster->max_nr,
+				   cluster->boost, elapsed,
+				   cluster->offline_delay_ms);
 	trace_core_ctl_eval_need(cluster->first_cpu, last_need, new_need,
 				 cluster->active_cpus, adj_now, adj_possible,
 				 adj_now && adj_possible, cluster->need_ts);
@@ -986,6 +1031,8 @@ void core_ctl_check(u64 window_start)
 			continue;
 
 		c->busy = sched_get_cpu_util(cpu);
+		if (cluster->predictive)
+			c->pred_busy = sched_get_cpu_pred_util(cpu);
 	}
 	spin_unlock_irqrestore(&state_lock, flags);
 
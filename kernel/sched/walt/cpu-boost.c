@@ -14,6 +14,7 @@
 #include <linux/time.h>
 #include <linux/sysfs.h>
 #include <linux/pm_qos.h>
+#include <linux/log2.h>
 
 #include "qc_vas.h"
 
@@ -69,6 +70,83 @@ static u64 last_input_time;
 
 static DEFINE_PER_CPU(struct freq_qos_request, qos_req);
 
+/*
+ * Input latency histograms, log2 buckets in us. Per device: from the
+ * event timestamp (the driver's IRQ time when it sets one) to delivery
+ * of the frame to the input handlers, which is also when evdev queues it.
+ * Global: from the boost request to the boost being in place.
+ */
+#define INPUT_LAT_BUCKETS	16
+
+struct cpuboost_handle {
+	struct input_handle handle;
+	struct list_head node;
+	unsigned long frames;
+	unsigned int irq_hist[INPUT_LAT_BUCKETS];
+};
+
+static LIST_HEAD(cpuboost_handles);
+static DEFINE_MUTEX(cpuboost_handles_lock);
+static unsigned long boost_requests;
+static unsigned int boost_apply_hist[INPUT_LAT_BUCKETS];
+static ktime_t boost_request_ts;
+
+static void input_lat_account(unsigned int *hist, s64 us)
+{
+	unsigned int bucket = us > 1 ? ilog2(us) : 0;
+
+	hist[min(bucket, INPUT_LAT_BUCKETS - 1U)]++;
+}
+
+static ssize_t show_input_latency(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	struct cpuboost_handle *h;
+	int i, cnt;
+
+	cnt = scnprintf(buf, PAGE_SIZE, "boost requests: %lu\n",
+			boost_requests);
+	for (i = 0; i < INPUT_LAT_BUCKETS; i++)
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "%u ",
+				 boost_apply_hist[i]);
+	cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "\n");
+
+	mutex_lock(&cpuboost_handles_lock);
+	list_for_each_entry(h, &cpuboost_handles, node) {
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "%s: %lu\n",
+				 dev_name(&h->handle.dev->dev), h->frames);
+		for (i = 0; i < INPUT_LAT_BUCKETS; i++)
+			cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "%u ",
+					 h->irq_hist[i]);
+		cnt += scnprintf(buf + cnt, PAGE_SIZE - cnt, "\n");
+	}
+	mutex_unlock(&cpuboost_handles_lock);
+
+	return cnt;
+}
+
+/* Any write clears the histograms */
+static ssize_t store_input_latency(struct kobject *kobj,
+				   struct kobj_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct cpuboost_handle *h;
+
+	boost_requests = 0;
+	memset(boost_apply_hist, 0, sizeof(boost_apply_hist));
+
+	mutex_lock(&cpuboost_handles_lock);
+	list_for_each_entry(h, &cpuboost_handles, node) {
+		h->frames = 0;
+		memset(h->irq_hist, 0, sizeof(h->irq_hist));
+	}
+	mutex_unlock(&cpuboost_handles_lock);
+
+	return count;
+}
+
+cpu_boost_attr_rw(input_latency);
+
 static ssize_t store_input_boost_freq(struct kobject *kobj,
 				      struct kobj_attribute *attr,
 				      const char *buf, size_t count)
@@ -135,6 +213,71 @@ static ssize_t show_input_boost_freq(struct kobject *kobj,
 
 cpu_boost_attr_rw(input_boost_freq);
 
+show_one(frame_boost_risk_pct);
+store_one(frame_boost_risk_pct);
+cpu_boost_attr_rw(frame_boost_risk_pct);
+
+show_one(frame_boost_pred_pct);
+store_one(frame_boost_pred_pct);
+cpu_boost_attr_rw(frame_boost_pred_pct);
+
+#define MAX_FRAME_BOOST_TIDS	8
+
+/* Space separated list of the frame pipeline TIDs, empty to unregister */
+static ssize_t store_frame_boost_tids(struct kobject *kobj,
+				      struct kobj_attribute *attr,
+				      const char *buf, size_t count)
+{
+	pid_t pids[MAX_FRAME_BOOST_TIDS];
+	const char *cp = buf;
+	int nr = 0, len, ret;
+
+	while (nr < MAX_FRAME_BOOST_TIDS &&
+			sscanf(cp, "%d%n", &pids[nr], &len) == 1) {
+		nr++;
+		cp += len;
+	}
+
+	ret = sched_frame_boost_set_tasks(pids, nr);
+	return ret ? ret : count;
+}
+
+static ssize_t show_frame_boost_tids(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	pid_t pids[MAX_FRAME_BOOST_TIDS];
+	int i, nr, cnt = 0;
+
+	nr = sched_frame_boost_get_tasks(pids, MAX_FRAME_BOOST_TIDS);
+	for (i = 0; i < nr; i++)
+		cnt += snprintf(buf + cnt, PAGE_SIZE - cnt, "%d ", pids[i]);
+	cnt += snprintf(buf + cnt, PAGE_SIZE - cnt, "\n");
+	return cnt;
+}
+
+cpu_boost_attr_rw(frame_boost_tids);
+
+/* Frame start, written with the frame budget in usec; 0 ends the frame */
+static ssize_t store_frame_boost_budget_us(struct kobject *kobj,
+					   struct kobj_attribute *attr,
+					   const char *buf, size_t count)
+{
+	unsigned int val;
+
+	if (kstrtouint(buf, 0, &val))
+		return -EINVAL;
+
+	if (val)
+		sched_frame_boost_start((u64)val * NSEC_PER_USEC);
+	else
+		sched_frame_boost_end();
+
+	return count;
+}
+
+static struct kobj_attribute frame_boost_budget_us_attr =
+__ATTR(frame_boost_budget_us, 0200, NULL, store_frame_boost_budget_us);
+
 static void boost_adjust_notify(struct cpufreq_policy *policy)
 {
 	unsigned int cpu = policy->cpu;
@@ -209,6 +352,7 @@ static void do_input_boost(struct work_struct *work)
 {
 	unsigned int i, ret;
 	struct cpu_sync *i_sync_info;
+	s64 delta;
 
 	cancel_delayed_work_sync(&input_boost_rem);
 	if (sched_boost_active) {
@@ -237,6 +381,22 @@ static void do_input_boost(struct work_struct *work)
 
 	queue_delayed_work(cpu_boost_wq, &input_boost_rem,
 					msecs_to_jiffies(input_boost_ms));
+
+	delta = ktime_us_delta(ktime_get(), READ_ONCE(boost_request_ts));
+	input_lat_account(boost_apply_hist, delta);
+	trace_cpu_boost_apply_latency(delta, sched_boost_active);
+}
+
+static void cpuboost_input_account(struct input_handle *handle)
+{
+	struct cpuboost_handle *h = container_of(handle,
+					struct cpuboost_handle, handle);
+	ktime_t *ts = input_get_timestamp(handle->dev);
+	s64 delta = ktime_us_delta(ktime_get(), ts[INPUT_CLK_MONO]);
+
+	h->frames++;
+	input_lat_account(h->irq_hist, delta);
+	trace_cpu_boost_input_latency(dev_name(&handle->dev->dev), delta);
 }
 
 static void cpuboost_input_event(struct input_handle *handle,
@@ -244,6 +404,9 @@ static void cpuboost_input_event(struct input_handle *handle,
 {
 	u64 now;
 
+	if (type == EV_SYN && code == SYN_REPORT)
+		cpuboost_input_account(handle);
+
 	if (!input_boost_enabled)
 		return;
 
@@ -254,6 +417,8 @@ static void cpuboost_input_event(struct input_handle *handle,
 	if (work_pending(&input_boost_work))
 		return;
 
+	WRITE_ONCE(boost_request_ts, ktime_get());
+	boost_requests++;
 	queue_work(cpu_boost_wq, &input_boost_work);
 	last_input_time = ktime_to_us(ktime_get());
 }
@@ -261,12 +426,14 @@ static void cpuboost_input_event(struct input_handle *handle,
 static int cpuboost_input_connect(struct input_handler *handler,
 		struct input_dev *dev, const struct input_device_id *id)
 {
+	struct cpuboost_handle *h;
 	struct input_handle *handle;
 	int error;
 
-	handle = kzalloc(sizeof(struct input_handle), GFP_KERNEL);
-	if (!handle)
+	h = kzalloc(sizeof(*h), GFP_KERNEL);
+	if (!h)
 		return -ENOMEM;
+	handle = &h->handle;
 
 	handle->dev = dev;
 	handle->handler = handler;
@@ -280,19 +447,30 @@ static int cpuboost_input_connect(struct input_handler *handler,
 	if (error)
 		goto err1;
 
+	mutex_lock(&cpuboost_handles_lock);
+	list_add_tail(&h->node, &cpuboost_handles);
+	mutex_unlock(&cpuboost_handles_lock);
+
 	return 0;
 err1:
 	input_unregister_handle(handle);
 err2:
-	kfree(handle);
+	kfree(h);
 	return error;
 }
 
 static void cpuboost_input_disconnect(struct input_handle *handle)
 {
+	struct cpuboost_handle *h = container_of(handle,
+					struct cpuboost_handle, handle);
+
+	mutex_lock(&cpuboost_handles_lock);
+	list_del(&h->node);
+	mutex_unlock(&cpuboost_handles_lock);
+
 	input_close_device(handle);
 	input_unregister_handle(handle);
-	kfree(handle);
+	kfree(h);
 }
 
 static const struct input_device_id cpuboost_ids[] = {
@@ -383,6 +561,29 @@ int cpu_boost_init(void)
 	if (ret)
 		pr_err("Failed to create sched_boost_on_input node: %d\n", ret);
 
+	ret = sysfs_create_file(cpu_boost_kobj, &frame_boost_tids_attr.attr);
+	if (ret)
+		pr_err("Failed to create frame_boost_tids node: %d\n", ret);
+
+	ret = sysfs_create_file(cpu_boost_kobj,
+				&frame_boost_budget_us_attr.attr);
+	if (ret)
+		pr_err("Failed to create frame_boost_budget_us node: %d\n", ret);
+
+	ret = sysfs_create_file(cpu_boost_kobj,
+				&frame_boost_risk_pct_attr.attr);
+	if (ret)
+		pr_err("Failed to create frame_boost_risk_pct node: %d\n", ret);
+
+	ret = sysfs_create_file(cpu_boost_kobj,
+				&frame_boost_pred_pct_attr.attr);
+	if (ret)
+		pr_err("Failed to create frame_boost_pred_pct node: %d\n", ret);
+
+	ret = sysfs_create_file(cpu_boost_kobj, &input_latency_attr.attr);
+	if (ret)
+		pr_err("Failed to create input_latency node: %d\n", ret);
+
 	ret = input_register_handler(&cpuboost_input_handler);
 	return 0;
 }
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+#define pr_fmt(fmt) "walt_irq_balance: " fmt
+
+#include <linux/interrupt.h>
+#include <linux/irq.h>
+#include <linux/irqdesc.h>
+#include <linux/irqnr.h>
+#include <linux/kernel_stat.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/workqueue.h>
+
+#include "qc_vas.h"
+
+/*
+ * In-kernel balancer for high rate device interrupts. Every period the
+ * rate of each balanceable IRQ is sampled from its kstat counts. IRQs
+ * above sysctl_sched_walt_irq_balance_min_rate are placed, busiest
+ * first, on the unisolated CPU with the lowest sum of WALT utilization
+ * and interrupt rate already placed on it. The max capacity CPUs are
+ * skipped while sysctl_sched_walt_irq_balance_avoid_prime is set and
+ * any other CPU is available. An IRQ is only moved when its CPU became
+ * unusable or another CPU scores better by more than the hysteresis,
+ * so a settled system sees no affinity churn. core_ctl isolation kicks
+ * an immediate pass instead of leaving the bulk migration done by
+ * irq_migrate_all_off_this_cpu() in place.
+ */
+#define IRQ_BALANCE_HYST_PCT	10
+
+unsigned int sysctl_sched_walt_irq_balance;
+unsigned int sysctl_sched_walt_irq_balance_ms = 1000;
+unsigned int sysctl_sched_walt_irq_balance_min_rate = 1000;
+unsigned int sysctl_sched_walt_irq_balance_avoid_prime = 1;
+
+struct irq_balance_irq {
+	unsigned int irq;
+	unsigned int rate;
+};
+
+static DEFINE_MUTEX(irq_balance_mutex);
+static unsigned int *irq_balance_prev;
+static struct irq_balance_irq *irq_balance_hot;
+static unsigned int irq_balance_nr;
+static unsigned int irq_balance_score[NR_CPUS];
+static u64 irq_balance_last;
+
+static void irq_balance_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(irq_balance_work, irq_balance_fn);
+
+static bool irq_balance_candidate(unsigned int irq)
+{
+	struct irq_data *d = irq_get_irq_data(irq);
+
+	if (!d || !irq_has_action(irq))
+		return false;
+
+	return irqd_can_balance(d) && !irqd_is_per_cpu(d) &&
+	       !irqd_affinity_is_managed(d);
+}
+
+static int irq_balance_cmp(const void *a, const void *b)
+{
+	const struct irq_balance_irq *ia = a, *ib = b;
+
+	if (ia->rate == ib->rate)
+		return 0;
+	return ia->rate > ib->rate ? -1 : 1;
+}
+
+static void irq_balance_allowed(struct cpumask *allowed)
+{
+	cpumask_t non_prime;
+	int cpu;
+
+	cpumask_andnot(allowed, cpu_active_mask, cpu_isolated_mask);
+
+	if (!sysctl_sched_walt_irq_balance_avoid_prime || !hmp_capable())
+		return;
+
+	cpumask_clear(&non_prime);
+	for_each_cpu(cpu, allowed)
+		if (!is_max_capacity_cpu(cpu))
+			cpumask_set_cpu(cpu, &non_prime);
+
+	if (!cpumask_empty(&non_prime))
+		cpumask_copy(allowed, &non_prime);
+}
+
+/*
+ * Sample the IRQ rates since the last pass into irq_balance_hot and
+ * return the number of IRQs above the rate threshold.
+ */
+static unsigned int irq_balance_sample(u64 now)
+{
+	u64 elapsed_ms = div64_u64(now - irq_balance_last, NSEC_PER_MSEC);
+	unsigned int irq, count, nr_hot = 0;
+	u64 rate;
+
+	irq_balance_last = now;
+
+	for_each_active_irq(irq) {
+		if (irq >= irq_balance_nr)
+			break;
+
+		count = kstat_irqs_usr(irq);
+		rate = count - irq_balance_prev[irq];
+		irq_balance_prev[irq] = count;
+
+		if (!elapsed_ms || !irq_balance_candidate(irq))
+			continue;
+
+		rate = div64_u64(rate * MSEC_PER_SEC, elapsed_ms);
+		if (rate < sysctl_sched_walt_irq_balance_min_rate)
+			continue;
+
+		irq_balance_hot[nr_hot].irq = irq;
+		irq_balance_hot[nr_hot].rate = min_t(u64, rate, UINT_MAX);
+		nr_hot++;
+	}
+
+	return nr_hot;
+}
+
+static void irq_balance_place(unsigned int nr_hot,
+			      const struct cpumask *allowed)
+{
+	unsigned int *score = irq_balance_score;
+	unsigned int total = 0, share, i;
+	const struct cpumask *eff;
+	struct irq_data *d;
+	int cpu, cur, best;
+
+	for (i = 0; i < nr_hot; i++)
+		total += irq_balance_hot[i].rate;
+
+	/*
+	 * Both terms are percentages: the WALT utilization of the CPU over
+	 * its original capacity, and the share of all hot interrupts that
+	 * was placed on it during this pass.
+	 */
+	for_each_cpu(cpu, allowed)
+		score[cpu] = cpu_util(cpu) * 100 / capacity_orig_of(cpu);
+
+	sort(irq_balance_hot, nr_hot, sizeof(*irq_balance_hot),
+	     irq_balance_cmp, NULL);
+
+	for (i = 0; i < nr_hot; i++) {
+		d = irq_get_irq_data(irq_balance_hot[i].irq);
+		if (!d)
+			continue;
+
+		share = irq_balance_hot[i].rate * 100ULL / max(total, 1U);
+		eff = irq_data_get_effective_affinity_mask(d);
+		if (cpumask_empty(eff))
+			eff = irq_data_get_affinity_mask(d);
+		cur = cpumask_first(eff);
+
+		best = -1;
+		for_each_cpu(cpu, allowed)
+			if (best < 0 || score[cpu] < score[best])
+				best = cpu;
+		if (best < 0)
+			return;
+
+		if (cur < nr_cpu_ids && cpumask_test_cpu(cur, allowed) &&
+		    score[cur] <= score[best] + IRQ_BALANCE_HYST_PCT) {
+			score[cur] += share;
+			continue;
+		}
+
+		if (irq_set_affinity(irq_balance_hot[i].irq, cpumask_of(best)))
+			continue;
+
+		trace_sched_walt_irq_balance(irq_balance_hot[i].irq,
+					     irq_balance_hot[i].rate, cur, best);
+		score[best] += share;
+	}
+}
+
+static void irq_balance_fn(struct work_struct *work)
+{
+	cpumask_t allowed;
+	unsigned int nr_hot;
+
+	mutex_lock(&irq_balance_mutex);
+	if (!sysctl_sched_walt_irq_balance)
+		goto out;
+
+	nr_hot = irq_balance_sample(ktime_get_ns());
+
+	irq_balance_allowed(&allowed);
+	if (nr_hot && !cpumask_empty(&allowed))
+		irq_balance_place(nr_hot, &allowed);
+
+	queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+			   msecs_to_jiffies(sysctl_sched_walt_irq_balance_ms));
+out:
+	mutex_unlock(&irq_balance_mutex);
+}
+
+/*
+ * Called after a CPU was isolated or unisolated. The rates measured so
+ * far are still valid, so rebalance right away rather than waiting for
+ * the next period.
+ */
+void walt_irq_balance_kick(void)
+{
+	if (READ_ONCE(sysctl_sched_walt_irq_balance))
+		mod_delayed_work(system_power_efficient_wq,
+				 &irq_balance_work, 0);
+}
+
+static int irq_balance_alloc(void)
+{
+	if (irq_balance_prev)
+		return 0;
+
+	irq_balance_prev = kcalloc(nr_irqs, sizeof(*irq_balance_prev),
+				   GFP_KERNEL);
+	irq_balance_hot = kcalloc(nr_irqs, sizeof(*irq_balance_hot),
+				  GFP_KERNEL);
+	if (!irq_balance_prev || !irq_balance_hot) {
+		kfree(irq_balance_prev);
+		kfree(irq_balance_hot);
+		irq_balance_prev = NULL;
+		irq_balance_hot = NULL;
+		return -ENOMEM;
+	}
+	irq_balance_nr = nr_irqs;
+
+	return 0;
+}
+
+int walt_irq_balance_handler(struct ctl_table *table, int write,
+			     void __user *buffer, size_t *lenp, loff_t *ppos)
+{
+	unsigned int old;
+	int ret;
+
+	mutex_lock(&irq_balance_mutex);
+	old = sysctl_sched_walt_irq_balance;
+
+	ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+	if (ret || !write || old == sysctl_sched_walt_irq_balance)
+		goto out;
+
+	if (sysctl_sched_walt_irq_balance) {
+		ret = irq_balance_alloc();
+		if (ret) {
+			sysctl_sched_walt_irq_balance = old;
+			goto out;
+		}
+		/* The first pass only establishes the baseline counts */
+		irq_balance_sample(ktime_get_ns());
+		queue_delayed_work(system_power_efficient_wq, &irq_balance_work,
+				   msecs_to_jiffies(sysctl_sched_walt_irq_balance_ms));
+	}
+out:
+	mutex_unlock(&irq_balance_mutex);
+
+	/* Disabling lets a queued pass run and drop out without rearming */
+	if (!ret && write && !sysctl_sched_walt_irq_balance)
+		cancel_delayed_work_sync(&irq_balance_work);
+
+	return ret;
+}
@@ -646,6 +646,7 @@ int sched_isolate_cpu(int cpu)
 	}
 
 	set_cpu_isolated(cpu, true);
+	walt_placement_cache_invalidate();
 	cpumask_clear_cpu(cpu, &avail_cpus);
 
 	/* Migrate timers */
@@ -660,6 +661,7 @@ int sched_isolate_cpu(int cpu)
 	calc_load_migrate(rq);
 	update_max_interval();
 	sched_update_group_capacities(cpu);
+	walt_irq_balance_kick();
 
 out:
 	cpu_maps_update_done();
@@ -697,6 +699,7 @@ int sched_unisolate_cpu_unlocked(int cpu)
 		goto out;
 
 	set_cpu_isolated(cpu, false);
+	walt_placement_cache_invalidate();
 	update_max_interval();
 	sched_update_group_capacities(cpu);
 
@@ -707,6 +710,7 @@ int sched_unisolate_cpu_unlocked(int cpu)
 		if (!atomic_fetch_or(NOHZ_KICK_MASK, nohz_flags(cpu)))
 			smp_send_reschedule(cpu);
 	}
+	walt_irq_balance_kick();
 
 out:
 	trace_sched_isolate(cpu, cpumask_bits(cpu_isolated_mask)[0],
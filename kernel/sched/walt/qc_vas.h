@@ -29,6 +29,7 @@
 extern int num_sched_clusters;
 
 extern unsigned int walt_big_tasks(int cpu);
+extern unsigned int sched_get_nr_running_avg_cpu(int cpu);
 extern void reset_task_stats(struct task_struct *p);
 extern void walt_rotate_work_init(void);
 extern void walt_rotation_checkpoint(int nr_big);
@@ -39,6 +40,15 @@ extern int sched_set_init_task_load(struct task_struct *p, int init_load_pct);
 extern u32 sched_get_init_task_load(struct task_struct *p);
 extern void core_ctl_check(u64 wallclock);
 extern int sched_set_boost(int enable);
+extern void walt_boost_pred_demand(struct task_struct *p, unsigned int pct);
+extern void walt_kick_cpufreq(void);
+
+extern unsigned int frame_boost_risk_pct;
+extern unsigned int frame_boost_pred_pct;
+extern int sched_frame_boost_set_tasks(const pid_t *pids, int nr);
+extern int sched_frame_boost_get_tasks(pid_t *pids, int max);
+extern void sched_frame_boost_start(u64 budget_ns);
+extern void sched_frame_boost_end(void);
 extern int sched_isolate_count(const cpumask_t *mask, bool include_offline);
 
 extern struct list_head cluster_head;
@@ -78,4 +88,17 @@ static inline int sched_set_boost(int enable)
 {
 	return -EINVAL;
 }
+
+static inline int sched_frame_boost_set_tasks(const pid_t *pids, int nr)
+{
+	return -EINVAL;
+}
+
+static inline int sched_frame_boost_get_tasks(pid_t *pids, int max)
+{
+	return 0;
+}
+
+static inline void sched_frame_boost_start(u64 budget_ns) { }
+static inline void sched_frame_boost_end(void) { }
 #endif
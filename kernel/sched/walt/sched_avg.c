@@ -19,6 +19,8 @@ static DEFINE_PER_CPU(u64, last_time);
 static DEFINE_PER_CPU(u64, nr_big_prod_sum);
 static DEFINE_PER_CPU(u64, nr);
 static DEFINE_PER_CPU(u64, nr_max);
+static DEFINE_PER_CPU(u64, nr_tele_prod_sum);
+static DEFINE_PER_CPU(u64, nr_tele_last_get);
 
 static DEFINE_PER_CPU(spinlock_t, nr_lock) = __SPIN_LOCK_UNLOCKED(nr_lock);
 static s64 last_get_time;
@@ -219,11 +221,38 @@ void sched_update_nr_prod(int cpu, long delta, bool inc)
 	update_busy_hyst_end_time(cpu, !inc, nr_running, curr_time);
 
 	per_cpu(nr_prod_sum, cpu) += nr_running * diff;
+	per_cpu(nr_tele_prod_sum, cpu) += nr_running * diff;
 	per_cpu(nr_big_prod_sum, cpu) += walt_big_tasks(cpu) * diff;
 	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
 }
 EXPORT_SYMBOL(sched_update_nr_prod);
 
+/*
+ * Average nr_running * 100 on @cpu since the previous call. This keeps its
+ * own accumulator so that it does not disturb sched_get_nr_running_avg().
+ */
+unsigned int sched_get_nr_running_avg_cpu(int cpu)
+{
+	unsigned long flags;
+	u64 curr_time, period, sum;
+
+	spin_lock_irqsave(&per_cpu(nr_lock, cpu), flags);
+	curr_time = sched_clock();
+	sum = per_cpu(nr_tele_prod_sum, cpu) +
+		per_cpu(nr, cpu) * (curr_time - per_cpu(last_time, cpu));
+	period = curr_time - per_cpu(nr_tele_last_get, cpu);
+	/*
+	 * The next sched_update_nr_prod() accounts from last_time again;
+	 * pre-subtract the part of that interval consumed here.
+	 */
+	per_cpu(nr_tele_prod_sum, cpu) = -(per_cpu(nr, cpu) *
+				(curr_time - per_cpu(last_time, cpu)));
+	per_cpu(nr_tele_last_get, cpu) = curr_time;
+	spin_unlock_irqrestore(&per_cpu(nr_lock, cpu), flags);
+
+	return period ? div64_u64(sum * 100, period) : 0;
+}
+
 /*
  * Returns the CPU utilization % in the last window.
  *
@@ -247,6 +276,21 @@ unsigned int sched_get_cpu_util(int cpu)
 	busy = div64_ul((util * 100), capacity);
 	return busy;
 }
+EXPORT_SYMBOL(sched_get_cpu_util);
+
+/*
+ * Predicted busy percentage of @cpu for the upcoming window, based on the
+ * predicted demand of the tasks queued on it.
+ */
+unsigned int sched_get_cpu_pred_util(int cpu)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned long capacity = capacity_orig_of(cpu);
+	u64 util = READ_ONCE(rq->wrq.walt_stats.pred_demands_sum_scaled);
+
+	util = (util >= capacity) ? capacity : util;
+	return div64_ul((util * 100), capacity);
+}
 
 u64 sched_lpm_disallowed_time(int cpu)
 {
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ */
+#define pr_fmt(fmt) "walt_telemetry: " fmt
+
+#include <linux/fs.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <uapi/linux/sched/walt_telemetry.h>
+
+#include "qc_vas.h"
+
+/*
+ * Per-CPU telemetry rings for userspace perf daemons. Each CPU publishes a
+ * record from its own scheduler tick, so every ring has a single writer
+ * and readers only need the per-record sequence count. See the uapi header
+ * for the layout and the read protocol.
+ */
+#define WALT_TELEMETRY_RING_SIZE	16
+
+static void *telemetry_area;
+static size_t telemetry_size;
+static size_t telemetry_ring_stride;
+static bool telemetry_ready;
+
+static inline struct walt_telemetry_ring *telemetry_ring(int cpu)
+{
+	return telemetry_area + sizeof(struct walt_telemetry_header) +
+		cpu * telemetry_ring_stride;
+}
+
+void walt_telemetry_tick(struct rq *rq)
+{
+	struct walt_telemetry_ring *ring;
+	struct walt_telemetry_record *rec;
+	int cpu = cpu_of(rq);
+	u32 seq;
+
+	if (!READ_ONCE(telemetry_ready))
+		return;
+
+	ring = telemetry_ring(cpu);
+	rec = &ring->records[ring->head % WALT_TELEMETRY_RING_SIZE];
+
+	seq = rec->seq + 1;
+	WRITE_ONCE(rec->seq, seq);
+	smp_wmb();
+
+	rec->cpu = cpu;
+	rec->timestamp_ns = sched_clock();
+	rec->window_start_ns = rq->wrq.window_start;
+	rec->prev_window_busy_ns = rq->wrq.prev_runnable_sum +
+				   rq->wrq.grp_time.prev_runnable_sum;
+	rec->curr_window_busy_ns = rq->wrq.curr_runnable_sum +
+				   rq->wrq.grp_time.curr_runnable_sum;
+	rec->pred_demand = rq->wrq.walt_stats.pred_demands_sum_scaled;
+	rec->nr_running_avg = sched_get_nr_running_avg_cpu(cpu);
+	rec->nr_big_tasks = walt_big_tasks(cpu);
+	rec->cur_freq_khz = rq->wrq.cluster->cur_freq;
+
+	smp_wmb();
+	WRITE_ONCE(rec->seq, seq + 1);
+	smp_store_release(&ring->head, ring->head + 1);
+}
+
+static int telemetry_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start > telemetry_size)
+		return -EINVAL;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+	return remap_vmalloc_range(vma, telemetry_area, 0);
+}
+
+static const struct file_operations telemetry_fops = {
+	.owner		= THIS_MODULE,
+	.mmap		= telemetry_mmap,
+};
+
+static struct miscdevice telemetry_dev = {
+	.minor		= MISC_DYNAMIC_MINOR,
+	.name		= "walt_telemetry",
+	.fops		= &telemetry_fops,
+	.mode		= 0444,
+};
+
+static int __init walt_telemetry_init(void)
+{
+	struct walt_telemetry_header *hdr;
+	int ret;
+
+	telemetry_ring_stride = ALIGN(sizeof(struct walt_telemetry_ring) +
+			WALT_TELEMETRY_RING_SIZE *
+			sizeof(struct walt_telemetry_record), SMP_CACHE_BYTES);
+	telemetry_size = PAGE_ALIGN(sizeof(*hdr) +
+			nr_cpu_ids * telemetry_ring_stride);
+
+	telemetry_area = vmalloc_user(telemetry_size);
+	if (!telemetry_area)
+		return -ENOMEM;
+
+	hdr = telemetry_area;
+	hdr->version = WALT_TELEMETRY_VERSION;
+	hdr->nr_cpus = nr_cpu_ids;
+	hdr->ring_size = WALT_TELEMETRY_RING_SIZE;
+	hdr->record_size = sizeof(struct walt_telemetry_record);
+	hdr->ring_offset = sizeof(*hdr);
+	hdr->ring_stride = telemetry_ring_stride;
+	hdr->window_size_ns = sched_ravg_window;
+
+	ret = misc_register(&telemetry_dev);
+	if (ret) {
+		pr_err("Failed to register device: %d\n", ret);
+		vfree(telemetry_area);
+		telemetry_area = NULL;
+		return ret;
+	}
+
+	smp_store_release(&telemetry_ready, true);
+	return 0;
+}
+late_initcall(walt_telemetry_init);
@@ -382,6 +382,117 @@ TRACE_EVENT(sched_set_boost,
 	TP_printk("type %d", __entry->type)
 );
 
+TRACE_EVENT(sched_walt_psi_floor,
+
+	TP_PROTO(int cluster_id, unsigned int stall_pct, bool floor,
+		 unsigned int floor_pct),
+
+	TP_ARGS(cluster_id, stall_pct, floor, floor_pct),
+
+	TP_STRUCT__entry(
+		__field(int, cluster_id)
+		__field(unsigned int, stall_pct)
+		__field(bool, floor)
+		__field(unsigned int, floor_pct)
+	),
+
+	TP_fast_assign(
+		__entry->cluster_id = cluster_id;
+		__entry->stall_pct = stall_pct;
+		__entry->floor = floor;
+		__entry->floor_pct = floor_pct;
+	),
+
+	TP_printk("cluster=%d stall_pct=%u floor=%d floor_pct=%u",
+		__entry->cluster_id, __entry->stall_pct, __entry->floor,
+		__entry->floor_pct)
+);
+
+TRACE_EVENT(sched_walt_irq_balance,
+
+	TP_PROTO(unsigned int irq, unsigned int rate, int src_cpu, int dst_cpu),
+
+	TP_ARGS(irq, rate, src_cpu, dst_cpu),
+
+	TP_STRUCT__entry(
+		__field(unsigned int, irq)
+		__field(unsigned int, rate)
+		__field(int, src_cpu)
+		__field(int, dst_cpu)
+	),
+
+	TP_fast_assign(
+		__entry->irq = irq;
+		__entry->rate = rate;
+		__entry->src_cpu = src_cpu;
+		__entry->dst_cpu = dst_cpu;
+	),
+
+	TP_printk("irq=%u rate=%u src_cpu=%d dst_cpu=%d",
+		__entry->irq, __entry->rate, __entry->src_cpu,
+		__entry->dst_cpu)
+);
+
+TRACE_EVENT(cpu_boost_input_latency,
+
+	TP_PROTO(const char *name, s64 irq_us),
+
+	TP_ARGS(name, irq_us),
+
+	TP_STRUCT__entry(
+		__string(name, name)
+		__field(s64, irq_us)
+	),
+
+	TP_fast_assign(
+		__assign_str(name, name);
+		__entry->irq_us = irq_us;
+	),
+
+	TP_printk("dev=%s irq_to_deliver=%lld us",
+		__get_str(name), __entry->irq_us)
+);
+
+TRACE_EVENT(cpu_boost_apply_latency,
+
+	TP_PROTO(s64 apply_us, int sched_boost),
+
+	TP_ARGS(apply_us, sched_boost),
+
+	TP_STRUCT__entry(
+		__field(s64, apply_us)
+		__field(int, sched_boost)
+	),
+
+	TP_fast_assign(
+		__entry->apply_us = apply_us;
+		__entry->sched_boost = sched_boost;
+	),
+
+	TP_printk("request_to_apply=%lld us sched_boost=%d",
+		__entry->apply_us, __entry->sched_boost)
+);
+
+TRACE_EVENT(sched_frame_boost,
+
+	TP_PROTO(int nr_tasks, u64 remaining),
+
+	TP_ARGS(nr_tasks, remaining),
+
+	TP_STRUCT__entry(
+		__field(int, nr_tasks)
+		__field(u64, remaining)
+	),
+
+	TP_fast_assign(
+		__entry->nr_tasks = nr_tasks;
+		__entry->remaining = remaining;
+	),
+
+	TP_printk("nr_tasks=%d remaining_ns=%llu",
+		__entry->nr_tasks, __entry->remaining)
+);
+
 TRACE_EVENT(sched_load_to_gov,
 
 	TP_PROTO(struct rq *rq, u64 aggr_grp_load, u32 tt_load,
@@ -468,6 +579,49 @@ TRACE_EVENT(core_ctl_eval_need,
 		  __entry->updated, __entry->need_ts)
 );
 
+TRACE_EVENT(core_ctl_eval_inputs,
+
+	TP_PROTO(unsigned int cpu, unsigned int busy_need,
+		unsigned int pred_need, unsigned int task_need,
+		int nrrun, unsigned int nr_prev_assist,
+		unsigned int strict_nrrun, unsigned int max_nr,
+		unsigned int boost, s64 elapsed,
+		unsigned int offline_delay_ms),
+	TP_ARGS(cpu, busy_need, pred_need, task_need, nrrun, nr_prev_assist,
+		strict_nrrun, max_nr, boost, elapsed, offline_delay_ms),
+	TP_STRUCT__entry(
+		__field(u32, cpu)
+		__field(u32, busy_need)
+		__field(u32, pred_need)
+		__field(u32, task_need)
+		__field(int, nrrun)
+		__field(u32, nr_prev_assist)
+		__field(u32, strict_nrrun)
+		__field(u32, max_nr)
+		__field(u32, boost)
+		__field(s64, elapsed)
+		__field(u32, offline_delay_ms)
+	),
+	TP_fast_assign(
+		__entry->cpu			= cpu;
+		__entry->busy_need		= busy_need;
+		__entry->pred_need		= pred_need;
+		__entry->task_need		= task_need;
+		__entry->nrrun			= nrrun;
+		__entry->nr_prev_assist		= nr_prev_assist;
+		__entry->strict_nrrun		= strict_nrrun;
+		__entry->max_nr			= max_nr;
+		__entry->boost			= boost;
+		__entry->elapsed		= elapsed;
+		__entry->offline_delay_ms	= offline_delay_ms;
+	),
+	TP_printk("cpu=%u busy_need=%u pred_need=%u task_need=%u nrrun=%d nr_prev_assist=%u strict_nrrun=%u max_nr=%u boost=%u elapsed=%lld offline_delay_ms=%u",
+		  __entry->cpu, __entry->busy_need, __entry->pred_need,
+		  __entry->task_need, __entry->nrrun, __entry->nr_prev_assist,
+		  __entry->strict_nrrun, __entry->max_nr, __entry->boost,
+		  __entry->elapsed, __entry->offline_delay_ms)
+);
+
 TRACE_EVENT(core_ctl_set_busy,
 
 	TP_PROTO(unsigned int cpu, unsigned int busy,
@@ -7,6 +7,9 @@
 #include <linux/list_sort.h>
 #include <linux/jiffies.h>
 #include <linux/sched/stat.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/psi.h>
 #include <trace/events/sched.h>
 #include "qc_vas.h"
 
@@ -118,6 +121,29 @@ static unsigned int walt_cpu_high_irqload;
 unsigned int sysctl_sched_walt_rotate_big_tasks;
 unsigned int walt_rotation_enabled;
 
+/*
+ * When set, window rollover does not take all rq locks at once. See
+ * walt_irq_work_lockless().
+ */
+unsigned int sysctl_sched_walt_lockless_rollover;
+
+/*
+ * When set, the cluster load subtractions of a cross-cluster migration are
+ * queued on the source rq and applied at the next WALT irq work instead of
+ * under the cluster load_lock on the migration path.
+ */
+unsigned int sysctl_sched_walt_deferred_subs;
+
+/*
+ * A cluster whose CPUs spent more than sysctl_sched_walt_psi_mem_thresh_pct
+ * of the last window in a memory stall keeps its frequency request at or
+ * above sysctl_sched_walt_psi_mem_floor_pct of its capacity for the next
+ * window, so that reclaim and the stalled tasks are not slowed down further.
+ * A threshold of 0 disables the floor.
+ */
+unsigned int sysctl_sched_walt_psi_mem_thresh_pct;
+unsigned int sysctl_sched_walt_psi_mem_floor_pct = 50;
+
 __read_mostly unsigned int sysctl_sched_asym_cap_sibling_freq_match_pct = 100;
 __read_mostly unsigned int sysctl_sched_asym_cap_sibling_freq_match_en;
 static cpumask_t asym_freq_match_cpus = CPU_MASK_NONE;
@@ -320,6 +346,7 @@ static void fixup_walt_sched_stats_common(struct rq *rq, struct task_struct *p,
 
 	fixup_cumulative_runnable_avg(&rq->wrq.walt_stats, task_load_delta,
 				      pred_demand_delta);
+	fixup_class_demand(&rq->wrq.walt_stats, p, task_load_delta);
 
 	walt_fixup_cum_window_demand(rq, task_load_delta);
 }
@@ -554,29 +581,80 @@ should_apply_suh_freq_boost(struct walt_sched_cluster *cluster)
 	return is_cluster_hosting_top_app(cluster);
 }
 
-static inline u64 freq_policy_load(struct rq *rq)
+/*
+ * Fill @snap with the current window signals of @rq. Caller must hold
+ * rq->lock.
+ */
+static void walt_fill_window_snapshot(struct rq *rq,
+				      struct walt_window_snapshot *snap)
+{
+	struct task_struct *cpu_ksoftirqd = per_cpu(ksoftirqd, cpu_of(rq));
+
+	snap->window_start = rq->wrq.window_start;
+	snap->prev_runnable_sum = rq->wrq.prev_runnable_sum;
+	snap->nt_prev_runnable_sum = rq->wrq.nt_prev_runnable_sum;
+	snap->grp_prev_runnable_sum = rq->wrq.grp_time.prev_runnable_sum;
+	snap->grp_nt_prev_runnable_sum = rq->wrq.grp_time.nt_prev_runnable_sum;
+	snap->pred_demands_sum_scaled =
+		rq->wrq.walt_stats.pred_demands_sum_scaled;
+	memcpy(snap->class_demand_scaled,
+	       rq->wrq.walt_stats.class_demand_scaled,
+	       sizeof(snap->class_demand_scaled));
+	snap->top_task_load = top_task_load(rq);
+	snap->ksoftirqd_load = 0;
+	if (cpu_ksoftirqd && cpu_ksoftirqd->state == TASK_RUNNING)
+		snap->ksoftirqd_load = task_load(cpu_ksoftirqd);
+	snap->ed_task = rq->wrq.ed_task != NULL;
+}
+
+/*
+ * Publish the window signals of @rq for lock-free readers. Caller must hold
+ * rq->lock, which also serializes the writers of the seqcount.
+ */
+static void walt_publish_window_snapshot(struct rq *rq)
+{
+	write_seqcount_begin(&rq->wrq.snap_seq);
+	walt_fill_window_snapshot(rq, &rq->wrq.snap);
+	write_seqcount_end(&rq->wrq.snap_seq);
+}
+
+/*
+ * Read the window signals last published by @cpu without taking its rq
+ * lock. The snapshot is refreshed at every window rollover and migration
+ * fixup.
+ */
+void walt_read_window_snapshot(int cpu, struct walt_window_snapshot *snap)
+{
+	struct rq *rq = cpu_rq(cpu);
+	unsigned int seq;
+
+	do {
+		seq = read_seqcount_begin(&rq->wrq.snap_seq);
+		*snap = rq->wrq.snap;
+	} while (read_seqcount_retry(&rq->wrq.snap_seq, seq));
+}
+
+static inline u64 freq_policy_load(struct rq *rq,
+				   const struct walt_window_snapshot *snap)
 {
 	unsigned int reporting_policy = sysctl_sched_freq_reporting_policy;
 	struct walt_sched_cluster *cluster = rq->wrq.cluster;
 	u64 aggr_grp_load = cluster->aggr_grp_load;
 	u64 load, tt_load = 0;
-	struct task_struct *cpu_ksoftirqd = per_cpu(ksoftirqd, cpu_of(rq));
 
-	if (rq->wrq.ed_task != NULL) {
+	if (snap->ed_task) {
 		load = sched_ravg_window;
 		goto done;
 	}
 
 	if (sched_freq_aggr_en)
-		load = rq->wrq.prev_runnable_sum + aggr_grp_load;
+		load = snap->prev_runnable_sum + aggr_grp_load;
 	else
-		load = rq->wrq.prev_runnable_sum +
-					rq->wrq.grp_time.prev_runnable_sum;
+		load = snap->prev_runnable_sum + snap->grp_prev_runnable_sum;
 
-	if (cpu_ksoftirqd && cpu_ksoftirqd->state == TASK_RUNNING)
-		load = max_t(u64, load, task_load(cpu_ksoftirqd));
+	load = max_t(u64, load, snap->ksoftirqd_load);
 
-	tt_load = top_task_load(rq);
+	tt_load = snap->top_task_load;
 	switch (reporting_policy) {
 	case FREQ_REPORT_MAX_CPU_LOAD_TOP_TASK:
 		load = max_t(u64, load, tt_load);
@@ -598,6 +676,12 @@ static inline u64 freq_policy_load(struct rq *rq)
 					 (u64)100);
 	}
 
+	if (cluster->psi_floor)
+		load = max_t(u64, load, div64_u64((u64)sched_ravg_window *
+				capacity_orig_of(cpu_of(rq)) *
+				sysctl_sched_walt_psi_mem_floor_pct,
+				SCHED_CAPACITY_SCALE * 100));
+
 done:
 	trace_sched_load_to_gov(rq, aggr_grp_load, tt_load, sched_freq_aggr_en,
 				load, reporting_policy, walt_rotation_enabled,
@@ -607,29 +691,41 @@ static inline u64 freq_policy_load(struct rq *rq)
 
 static bool rtgb_active;
 
+/*
+ * @remote is set when @cpu's rq lock is not held by the caller, in which
+ * case the signals are taken from the CPU's published window snapshot.
+ */
 static inline unsigned long
-__cpu_util_freq_walt(int cpu, struct walt_cpu_load *walt_load)
+__cpu_util_freq_walt(int cpu, struct walt_cpu_load *walt_load, bool remote)
 {
 	u64 util, util_unboosted;
 	struct rq *rq = cpu_rq(cpu);
 	unsigned long capacity = capacity_orig_of(cpu);
+	struct walt_window_snapshot snap;
 	int boost;
 
+	if (remote)
+		walt_read_window_snapshot(cpu, &snap);
+	else
+		walt_fill_window_snapshot(rq, &snap);
+
 	boost = per_cpu(sched_load_boost, cpu);
-	util_unboosted = util = freq_policy_load(rq);
+	util_unboosted = util = freq_policy_load(rq, &snap);
 	util = div64_u64(util * (100 + boost),
 			walt_cpu_util_freq_divisor);
 
 	if (walt_load) {
-		u64 nl = cpu_rq(cpu)->wrq.nt_prev_runnable_sum +
-				rq->wrq.grp_time.nt_prev_runnable_sum;
-		u64 pl = rq->wrq.walt_stats.pred_demands_sum_scaled;
+		u64 nl = snap.nt_prev_runnable_sum +
+				snap.grp_nt_prev_runnable_sum;
+		u64 pl = snap.pred_demands_sum_scaled;
 
 		/* do_pl_notif() needs unboosted signals */
-		rq->wrq.old_busy_time = div64_u64(util_unboosted,
+		if (!remote) {
+			rq->wrq.old_busy_time = div64_u64(util_unboosted,
 						sched_ravg_window >>
 						SCHED_CAPACITY_SHIFT);
-		rq->wrq.old_estimated_time = pl;
+			rq->wrq.old_estimated_time = pl;
+		}
 
 		nl = div64_u64(nl * (100 + boost), walt_cpu_util_freq_divisor);
 
@@ -637,6 +733,8 @@ __cpu_util_freq_walt(int cpu, struct walt_cpu_load *walt_load)
 		walt_load->pl = pl;
 		walt_load->ws = walt_load_reported_window;
 		walt_load->rtgb_active = rtgb_active;
+		walt_load->ta = rq->wrq.cluster->class_demand_scaled[
+						WALT_DEMAND_CLASS_TA];
 	}
 
 	return (util >= capacity) ? capacity : util;
@@ -658,16 +756,17 @@ cpu_util_freq_walt(int cpu, struct walt_cpu_load *walt_load)
 	if (!cpumask_test_cpu(cpu, &asym_cap_sibling_cpus) &&
 		!(sysctl_sched_asym_cap_sibling_freq_match_en &&
 		cpumask_test_cpu(cpu, &asym_freq_match_cpus)))
-		return __cpu_util_freq_walt(cpu, walt_load);
+		return __cpu_util_freq_walt(cpu, walt_load, false);
 
 	/* FIXME: Prime always last cpu */
 	max_cap_cpu = cpumask_last(&asym_freq_match_cpus);
-	util = __cpu_util_freq_walt(cpu, walt_load);
+	util = __cpu_util_freq_walt(cpu, walt_load, false);
 
 	if (cpu != max_cap_cpu) {
 		if (cpumask_first(&asym_freq_match_cpus) == cpu)
 			util_other =
-				__cpu_util_freq_walt(max_cap_cpu, &wl_other);
+				__cpu_util_freq_walt(max_cap_cpu, &wl_other,
+					sysctl_sched_walt_lockless_rollover);
 		else
 			goto out;
 	} else {
@@ -736,11 +835,56 @@ static inline void create_subtraction_entry(struct rq *rq, u64 ws, int index)
 	rq->wrq.load_subs[index].new_subs = 0;
 }
 
-static int get_top_index(unsigned long *bitmap, unsigned long old_top)
+/*
+ * The top task bitmaps are stored in reverse order: bit (NUM_LOAD_INDICES -
+ * index - 1) is set when the table has tasks at load index 'index'. Bit
+ * NUM_LOAD_INDICES is a sentinel that is always set. In addition every table
+ * keeps a summary word with one bit per non-empty bitmap word, so that the
+ * next highest index can be found with two find-first-set operations rather
+ * than a linear scan of the bitmap.
+ */
+#define TOP_TASKS_BITMAP_WORDS	BITS_TO_LONGS(NUM_LOAD_INDICES + 1)
+
+static inline void top_tasks_set_bit(struct rq *rq, u8 table, int index)
 {
-	int index = find_next_bit(bitmap, NUM_LOAD_INDICES, old_top);
+	int pos = NUM_LOAD_INDICES - index - 1;
 
-	if (index == NUM_LOAD_INDICES)
+	__set_bit(pos, rq->wrq.top_tasks_bitmap[table]);
+	__set_bit(BIT_WORD(pos), &rq->wrq.top_tasks_summary[table]);
+}
+
+static inline void top_tasks_clear_bit(struct rq *rq, u8 table, int index)
+{
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+	int pos = NUM_LOAD_INDICES - index - 1;
+
+	__clear_bit(pos, bitmap);
+	if (!bitmap[BIT_WORD(pos)])
+		__clear_bit(BIT_WORD(pos), &rq->wrq.top_tasks_summary[table]);
+}
+
+/*
+ * Return the highest load index that is at or below old_top and still has
+ * tasks in the table, or 0 if the table is empty.
+ */
+static int get_top_index(struct rq *rq, u8 table, unsigned long old_top)
+{
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+	unsigned long pos = NUM_LOAD_INDICES - 1 - old_top;
+	unsigned long word = BIT_WORD(pos);
+	unsigned long bits;
+	int index;
+
+	bits = bitmap[word] & BITMAP_FIRST_WORD_MASK(pos);
+	if (!bits) {
+		/* The sentinel word is never empty, so this always hits */
+		word = __ffs(rq->wrq.top_tasks_summary[table] &
+			     ~(BIT(word + 1) - 1));
+		bits = bitmap[word];
+	}
+
+	index = word * BITS_PER_LONG + __ffs(bits);
+	if (index >= NUM_LOAD_INDICES)
 		return 0;
 
 	return NUM_LOAD_INDICES - 1 - index;
@@ -781,6 +925,106 @@ static inline struct walt_sched_cluster *cpu_cluster(int cpu)
 	return cpu_rq(cpu)->wrq.cluster;
 }
 
+static struct walt_deferred_sub *
+find_deferred_sub(struct rq *rq, int cpu, u64 ws)
+{
+	int i;
+
+	for (i = 0; i < rq->wrq.nr_deferred_subs; i++) {
+		struct walt_deferred_sub *ds = &rq->wrq.deferred_subs[i];
+
+		if (ds->cpu == cpu && ds->window_start == ws)
+			return ds;
+	}
+
+	return NULL;
+}
+
+static void queue_deferred_sub(struct rq *rq, int cpu, u64 ws,
+			       u32 sub_load, bool new_task)
+{
+	struct walt_deferred_sub *ds = find_deferred_sub(rq, cpu, ws);
+
+	if (!ds) {
+		ds = &rq->wrq.deferred_subs[rq->wrq.nr_deferred_subs++];
+		ds->cpu = cpu;
+		ds->window_start = ws;
+		ds->subs = 0;
+		ds->new_subs = 0;
+	}
+
+	ds->subs += sub_load;
+	if (new_task)
+		ds->new_subs += sub_load;
+}
+
+/*
+ * Queue @p's contribution on the siblings of @cpu on @cpu's rq instead of
+ * updating their load_subs under the cluster load_lock. Falls back to the
+ * immediate update when the queue can't take all of it.
+ */
+static bool defer_cluster_load_subtractions(struct task_struct *p,
+					    int cpu, u64 ws, bool new_task,
+					    const struct cpumask *cluster_cpus)
+{
+	struct rq *rq = cpu_rq(cpu);
+	u64 prev_ws = ws - rq->wrq.prev_window_size;
+	int i, needed = 0;
+
+	for_each_cpu(i, cluster_cpus) {
+		if (p->wts.curr_window_cpu[i] && !find_deferred_sub(rq, i, ws))
+			needed++;
+		if (p->wts.prev_window_cpu[i] &&
+				!find_deferred_sub(rq, i, prev_ws))
+			needed++;
+	}
+
+	if (rq->wrq.nr_deferred_subs + needed > WALT_MAX_DEFERRED_SUBS)
+		return false;
+
+	for_each_cpu(i, cluster_cpus) {
+		if (p->wts.curr_window_cpu[i]) {
+			queue_deferred_sub(rq, i, ws,
+					   p->wts.curr_window_cpu[i], new_task);
+			p->wts.curr_window_cpu[i] = 0;
+		}
+
+		if (p->wts.prev_window_cpu[i]) {
+			queue_deferred_sub(rq, i, prev_ws,
+					   p->wts.prev_window_cpu[i], new_task);
+			p->wts.prev_window_cpu[i] = 0;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Apply the subtractions queued on @rq. Called with @rq's lock and its
+ * cluster load_lock held. Entries older than the previous window no longer
+ * have a busy time to subtract from and are dropped.
+ */
+static void flush_deferred_subtractions(struct rq *rq)
+{
+	u64 oldest_ws = rq->wrq.window_start - rq->wrq.prev_window_size;
+	int i;
+
+	for (i = 0; i < rq->wrq.nr_deferred_subs; i++) {
+		struct walt_deferred_sub *ds = &rq->wrq.deferred_subs[i];
+		struct rq *dst_rq = cpu_rq(ds->cpu);
+		int index;
+
+		if (ds->window_start < oldest_ws)
+			continue;
+
+		index = get_subtraction_index(dst_rq, ds->window_start);
+		dst_rq->wrq.load_subs[index].subs += ds->subs;
+		dst_rq->wrq.load_subs[index].new_subs += ds->new_subs;
+	}
+
+	rq->wrq.nr_deferred_subs = 0;
+}
+
 void update_cluster_load_subtractions(struct task_struct *p,
 					int cpu, u64 ws, bool new_task)
 {
@@ -790,6 +1034,12 @@ void update_cluster_load_subtractions(struct task_struct *p,
 	int i;
 
 	cpumask_clear_cpu(cpu, &cluster_cpus);
+
+	if (sysctl_sched_walt_deferred_subs &&
+	    defer_cluster_load_subtractions(p, cpu, ws, new_task,
+					    &cluster_cpus))
+		return;
+
 	raw_spin_lock(&cluster->load_lock);
 
 	for_each_cpu(i, &cluster_cpus) {
@@ -912,20 +1162,18 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->wrq.top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->wrq.top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->wrq.curr_top)
 			dst_rq->wrq.curr_top = index;
 
 		top_index = src_rq->wrq.curr_top;
 		if (index == top_index && !src_table[index])
-			src_rq->wrq.curr_top = get_top_index(
-				src_rq->wrq.top_tasks_bitmap[src], top_index);
+			src_rq->wrq.curr_top = get_top_index(src_rq, src,
+							     top_index);
 	}
 
 	if (prev_window) {
@@ -938,20 +1186,18 @@ migrate_top_tasks(struct task_struct *p, struct rq *src_rq, struct rq *dst_rq)
 		dst_table[index] += 1;
 
 		if (!src_table[index])
-			__clear_bit(NUM_LOAD_INDICES - index - 1,
-				src_rq->wrq.top_tasks_bitmap[src]);
+			top_tasks_clear_bit(src_rq, src, index);
 
 		if (dst_table[index] == 1)
-			__set_bit(NUM_LOAD_INDICES - index - 1,
-				dst_rq->wrq.top_tasks_bitmap[dst]);
+			top_tasks_set_bit(dst_rq, dst, index);
 
 		if (index > dst_rq->wrq.prev_top)
 			dst_rq->wrq.prev_top = index;
 
 		top_index = src_rq->wrq.prev_top;
 		if (index == top_index && !src_table[index])
-			src_rq->wrq.prev_top = get_top_index(
-				src_rq->wrq.top_tasks_bitmap[src], top_index);
+			src_rq->wrq.prev_top = get_top_index(src_rq, src,
+							     top_index);
 	}
 }
 
@@ -960,6 +1206,39 @@ static inline bool is_new_task(struct task_struct *p)
 	return p->wts.active_time < NEW_TASK_ACTIVE_TIME;
 }
 
+/*
+ * Cost of the busy time fixup of cross-cluster migrations, per source and
+ * destination cluster. Bucket i of the histogram counts fixups that took
+ * less than 2^(i + WALT_MIG_COST_MIN_SHIFT) ns; the last one is open ended.
+ */
+#define WALT_MIG_COST_BUCKETS	16
+#define WALT_MIG_COST_MIN_SHIFT	8
+
+struct walt_migration_stats {
+	u64	nr[MAX_CLUSTERS][MAX_CLUSTERS];
+	u64	cost_ns[MAX_CLUSTERS][MAX_CLUSTERS];
+	u32	hist[MAX_CLUSTERS][MAX_CLUSTERS][WALT_MIG_COST_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct walt_migration_stats, walt_mig_stats);
+
+static void account_migration_cost(int src_cpu, int dst_cpu, u64 cost)
+{
+	struct walt_migration_stats *ms = this_cpu_ptr(&walt_mig_stats);
+	int src = cpu_cluster(src_cpu)->id, dst = cpu_cluster(dst_cpu)->id;
+	int bucket;
+
+	if (src >= MAX_CLUSTERS || dst >= MAX_CLUSTERS)
+		return;
+
+	bucket = fls64(cost >> WALT_MIG_COST_MIN_SHIFT);
+	bucket = min(bucket, WALT_MIG_COST_BUCKETS - 1);
+
+	ms->nr[src][dst]++;
+	ms->cost_ns[src][dst] += cost;
+	ms->hist[src][dst][bucket]++;
+}
+
 void fixup_busy_time(struct task_struct *p, int new_cpu)
 {
 	struct rq *src_rq = task_rq(p);
@@ -969,14 +1248,17 @@ void fixup_busy_time(struct task_struct *p, int new_cpu)
 	u64 *src_prev_runnable_sum, *dst_prev_runnable_sum;
 	u64 *src_nt_curr_runnable_sum, *dst_nt_curr_runnable_sum;
 	u64 *src_nt_prev_runnable_sum, *dst_nt_prev_runnable_sum;
-	bool new_task;
+	bool new_task, cross_cluster;
 	struct walt_related_thread_group *grp;
 	long pstate;
+	u64 start;
 
 	if (!p->on_rq && p->state != TASK_WAKING)
 		return;
 
+	start = sched_clock();
 	pstate = p->state;
+	cross_cluster = !same_freq_domain(new_cpu, task_cpu(p));
 
 	if (pstate == TASK_WAKING)
 		double_rq_lock(src_rq, dest_rq);
@@ -1058,7 +1340,8 @@ void fixup_busy_time(struct task_struct *p, int new_cpu)
 
 	migrate_top_tasks(p, src_rq, dest_rq);
 
-	if (!same_freq_domain(new_cpu, task_cpu(p))) {
+	if (cross_cluster) {
+		p->wts.nr_cluster_migrations++;
 		src_rq->wrq.notif_pending = true;
 		dest_rq->wrq.notif_pending = true;
 		walt_irq_work_queue(&walt_migration_irq_work);
@@ -1073,9 +1356,63 @@ void fixup_busy_time(struct task_struct *p, int new_cpu)
 		}
 	}
 
+	if (sysctl_sched_walt_lockless_rollover) {
+		walt_publish_window_snapshot(src_rq);
+		walt_publish_window_snapshot(dest_rq);
+	}
+
 	if (pstate == TASK_WAKING)
 		double_rq_unlock(src_rq, dest_rq);
+
+	if (cross_cluster)
+		account_migration_cost(task_cpu(p), new_cpu,
+				       sched_clock() - start);
+}
+
+static int walt_migration_cost_show(struct seq_file *m, void *v)
+{
+	struct walt_migration_stats *ms;
+	u64 nr, cost, hist[WALT_MIG_COST_BUCKETS];
+	int nr_clusters = min(num_sched_clusters, MAX_CLUSTERS);
+	int src, dst, cpu, i;
+
+	for (src = 0; src < nr_clusters; src++) {
+		for (dst = 0; dst < nr_clusters; dst++) {
+			nr = cost = 0;
+			memset(hist, 0, sizeof(hist));
+
+			for_each_possible_cpu(cpu) {
+				ms = &per_cpu(walt_mig_stats, cpu);
+				nr += ms->nr[src][dst];
+				cost += ms->cost_ns[src][dst];
+				for (i = 0; i < WALT_MIG_COST_BUCKETS; i++)
+					hist[i] += ms->hist[src][dst][i];
+			}
+
+			if (!nr)
+				continue;
+
+			seq_printf(m, "cluster%d->cluster%d nr=%llu avg_ns=%llu",
+				   src, dst, nr, div64_u64(cost, nr));
+			for (i = 0; i < WALT_MIG_COST_BUCKETS; i++)
+				seq_printf(m, " %llu", hist[i]);
+			seq_putc(m, '\n');
+		}
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(walt_migration_cost);
+
+static int __init walt_migration_debugfs_init(void)
+{
+	struct dentry *dir = debugfs_create_dir("walt", NULL);
+
+	debugfs_create_file("migration_cost", 0444, dir, NULL,
+			    &walt_migration_cost_fops);
+	return 0;
 }
+late_initcall(walt_migration_debugfs_init);
 
 void set_window_start(struct rq *rq)
 {
@@ -1244,13 +1581,146 @@ static u32 get_pred_busy(struct task_struct *p,
 	return ret;
 }
 
+static u32 buckets_update(struct task_struct *p, u32 runtime)
+{
+	int bidx;
+	u32 pred_demand;
+
+	bidx = busy_to_bucket(runtime);
+	pred_demand = get_pred_busy(p, bidx, runtime);
+	bucket_increase(p->wts.busy_buckets, bidx);
+
+	return pred_demand;
+}
+
+static u32 buckets_pred_busy(struct task_struct *p, u32 curr_window)
+{
+	return get_pred_busy(p, busy_to_bucket(curr_window), curr_window);
+}
+
+/*
+ * EWMA predictor: the prediction is a moving average of the busy time of
+ * past windows where the most recent window has a weight of
+ * 1 / (1 << WALT_PRED_EWMA_SHIFT).
+ */
+#define WALT_PRED_EWMA_SHIFT	2
+
+static u32 ewma_update(struct task_struct *p, u32 runtime)
+{
+	s64 delta = (s64)runtime - p->wts.pred_ewma;
+
+	p->wts.pred_ewma += delta / (1 << WALT_PRED_EWMA_SHIFT);
+
+	return max(runtime, p->wts.pred_ewma);
+}
+
+/*
+ * Periodic predictor: for tasks that wake up at a steady rate (e.g. once
+ * per vsync) the busy time of the next window is the average busy time per
+ * activation times the number of activations expected in the window. This
+ * does not depend on how the last bursts happened to line up with the window
+ * boundaries.
+ */
+static u32 periodic_update(struct task_struct *p, u32 runtime)
+{
+	u16 nr_wakeups = p->wts.pred_nr_wakeups;
+	u64 pred;
+
+	p->wts.pred_nr_wakeups = 0;
+	if (nr_wakeups) {
+		s64 delta = (s64)(runtime / nr_wakeups) - p->wts.pred_burst;
+
+		p->wts.pred_burst += delta / (1 << WALT_PRED_EWMA_SHIFT);
+	}
+
+	if (!p->wts.pred_period || !p->wts.pred_burst)
+		return runtime;
+
+	pred = div64_u64((u64)p->wts.pred_burst * sched_ravg_window,
+			 p->wts.pred_period);
+	pred = min_t(u64, pred, sched_ravg_window);
+
+	return max(runtime, (u32)pred);
+}
+
+/*
+ * Both EWMA and periodic predictors only learn at window rollover. Within a
+ * window the best they can do is follow the task's busy time.
+ */
+static u32 follow_pred_busy(struct task_struct *p, u32 curr_window)
+{
+	return curr_window;
+}
+
+struct walt_predictor_ops {
+	/* Learn from the busy time of the window that just ended */
+	u32 (*update)(struct task_struct *p, u32 runtime);
+	/* Re-predict when the busy time in the current window exceeded it */
+	u32 (*pred_busy)(struct task_struct *p, u32 curr_window);
+};
+
+static const struct walt_predictor_ops walt_predictors[NR_WALT_PREDICTORS] = {
+	[WALT_PREDICTOR_BUCKETS] = {
+		.update		= buckets_update,
+		.pred_busy	= buckets_pred_busy,
+	},
+	[WALT_PREDICTOR_EWMA] = {
+		.update		= ewma_update,
+		.pred_busy	= follow_pred_busy,
+	},
+	[WALT_PREDICTOR_PERIODIC] = {
+		.update		= periodic_update,
+		.pred_busy	= follow_pred_busy,
+	},
+};
+
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+static inline const struct walt_predictor_ops *
+task_predictor(struct task_struct *p)
+{
+	struct task_group *tg = task_group(p);
+
+	return &walt_predictors[tg ? tg->wtg.predictor :
+				WALT_PREDICTOR_BUCKETS];
+}
+#else
+static inline const struct walt_predictor_ops *
+task_predictor(struct task_struct *p)
+{
+	return &walt_predictors[WALT_PREDICTOR_BUCKETS];
+}
+#endif /* CONFIG_UCLAMP_TASK_GROUP */
+
+/*
+ * Only wakeups that are close enough to be part of a periodic pattern are
+ * fed to the periodic predictor.
+ */
+#define WALT_PRED_MAX_PERIOD_WINDOWS	4
+
+static void update_pred_period(struct task_struct *p, u64 wallclock)
+{
+	u64 period = wallclock - p->wts.last_wake_ts;
+
+	if (p->wts.pred_nr_wakeups < U16_MAX)
+		p->wts.pred_nr_wakeups++;
+
+	if (!p->wts.last_wake_ts ||
+	    period >= (u64)WALT_PRED_MAX_PERIOD_WINDOWS * sched_ravg_window)
+		return;
+
+	if (!p->wts.pred_period)
+		p->wts.pred_period = period;
+	else
+		p->wts.pred_period += ((s64)period - p->wts.pred_period) /
+				      (1 << WALT_PRED_EWMA_SHIFT);
+}
+
 static inline u32 calc_pred_demand(struct task_struct *p)
 {
 	if (p->wts.pred_demand >= p->wts.curr_window)
 		return p->wts.pred_demand;
 
-	return get_pred_busy(p, busy_to_bucket(p->wts.curr_window),
-			     p->wts.curr_window);
+	return task_predictor(p)->pred_busy(p, p->wts.curr_window);
 }
 
 /*
@@ -1301,15 +1771,116 @@ void update_task_pred_demand(struct rq *rq, struct task_struct *p, int event)
 	p->wts.pred_demand_scaled = new_scaled;
 }
 
+/*
+ * Raise the predicted demand of @p to at least @pct percent of a window
+ * and kick a frequency re-evaluation. The next window rollover recomputes
+ * pred_demand from the task's history, so the raise is self-limiting.
+ */
+void walt_boost_pred_demand(struct task_struct *p, unsigned int pct)
+{
+	struct rq_flags rf;
+	struct rq *rq;
+	u32 new;
+	u16 new_scaled;
+
+	new = mult_frac(sched_ravg_window, min(pct, 100U), 100);
+
+	rq = task_rq_lock(p, &rf);
+	if (p->exit_state || p->wts.pred_demand >= new)
+		goto unlock;
+
+	new_scaled = scale_demand(new);
+	if (task_on_rq_queued(p) && (!task_has_dl_policy(p) ||
+				!p->dl.dl_throttled))
+		fixup_walt_sched_stats_common(rq, p,
+				p->wts.demand_scaled,
+				new_scaled);
+
+	p->wts.pred_demand = new;
+	p->wts.pred_demand_scaled = new_scaled;
+unlock:
+	task_rq_unlock(rq, p, &rf);
+}
+
+void walt_kick_cpufreq(void)
+{
+	walt_irq_work_queue(&walt_migration_irq_work);
+}
+
+/*
+ * Whether a CPU can take a wakeup at all only changes at window rollover
+ * (irqload), on isolation and on frequency changes, so the wakeup path
+ * rebuilds the candidate masks lazily on first use after an invalidation
+ * instead of re-deriving them for every CPU on every wakeup. Readers may
+ * race with a rebuild; walt_find_best_target() keeps the per-CPU checks,
+ * so a stale mask can only cost a suboptimal pick, never a wrong one.
+ */
+static struct walt_placement_cache walt_pcache;
+static atomic_t walt_pcache_gen = ATOMIC_INIT(1);
+static DEFINE_RAW_SPINLOCK(walt_pcache_lock);
+
+void walt_placement_cache_invalidate(void)
+{
+	atomic_inc(&walt_pcache_gen);
+}
+
+const struct walt_placement_cache *walt_placement_cache_get(void)
+{
+	unsigned int gen = atomic_read(&walt_pcache_gen);
+	unsigned long flags;
+	int cpu;
+
+	if (likely(READ_ONCE(walt_pcache.gen) == gen))
+		return &walt_pcache;
+
+	if (!raw_spin_trylock_irqsave(&walt_pcache_lock, flags))
+		return &walt_pcache;
+
+	cpumask_andnot(&walt_pcache.usable_cpus, cpu_active_mask,
+		       cpu_isolated_mask);
+	cpumask_copy(&walt_pcache.candidate_cpus, &walt_pcache.usable_cpus);
+	for_each_cpu(cpu, &walt_pcache.usable_cpus) {
+		if (sched_cpu_high_irqload(cpu))
+			cpumask_clear_cpu(cpu, &walt_pcache.candidate_cpus);
+	}
+	WRITE_ONCE(walt_pcache.gen, gen);
+	raw_spin_unlock_irqrestore(&walt_pcache_lock, flags);
+
+	return &walt_pcache;
+}
+
 void clear_top_tasks_bitmap(unsigned long *bitmap)
 {
 	memset(bitmap, 0, top_tasks_bitmap_size);
 	__set_bit(NUM_LOAD_INDICES, bitmap);
 }
 
-static inline void clear_top_tasks_table(u8 *table)
+/*
+ * Reset a top task table and its bitmaps. Only the table entries whose
+ * bits are set can be non-zero, so walk the summary instead of clearing
+ * the whole table.
+ */
+static void clear_top_tasks(struct rq *rq, u8 table)
 {
-	memset(table, 0, NUM_LOAD_INDICES * sizeof(u8));
+	unsigned long *bitmap = rq->wrq.top_tasks_bitmap[table];
+	unsigned long summary = rq->wrq.top_tasks_summary[table];
+	u8 *tt = rq->wrq.top_tasks[table];
+	unsigned long word, bit;
+
+	for_each_set_bit(word, &summary, TOP_TASKS_BITMAP_WORDS) {
+		unsigned long bits = bitmap[word];
+
+		for_each_set_bit(bit, &bits, BITS_PER_LONG) {
+			unsigned long pos = word * BITS_PER_LONG + bit;
+
+			if (pos < NUM_LOAD_INDICES)
+				tt[NUM_LOAD_INDICES - 1 - pos] = 0;
+		}
+		bitmap[word] = 0;
+	}
+
+	__set_bit(NUM_LOAD_INDICES, bitmap);
+	rq->wrq.top_tasks_summary[table] = BIT(BIT_WORD(NUM_LOAD_INDICES));
 }
 
 static void update_top_tasks(struct task_struct *p, struct rq *rq,
@@ -1342,12 +1913,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (!curr_table[old_index])
-			__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_clear_bit(rq, curr, old_index);
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 
 		return;
 	}
@@ -1374,8 +1943,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 		}
 
 		if (prev_table[update_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - update_index - 1,
-				rq->wrq.top_tasks_bitmap[prev]);
+			top_tasks_set_bit(rq, prev, update_index);
 	} else {
 		zero_index_update = !old_curr_window && prev_window;
 		if (old_index != update_index || zero_index_update) {
@@ -1388,12 +1956,10 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 				rq->wrq.prev_top = update_index;
 
 			if (!prev_table[old_index])
-				__clear_bit(NUM_LOAD_INDICES - old_index - 1,
-						rq->wrq.top_tasks_bitmap[prev]);
+				top_tasks_clear_bit(rq, prev, old_index);
 
 			if (prev_table[update_index] == 1)
-				__set_bit(NUM_LOAD_INDICES - update_index - 1,
-						rq->wrq.top_tasks_bitmap[prev]);
+				top_tasks_set_bit(rq, prev, update_index);
 		}
 	}
 
@@ -1404,8 +1970,7 @@ static void update_top_tasks(struct task_struct *p, struct rq *rq,
 			rq->wrq.curr_top = new_index;
 
 		if (curr_table[new_index] == 1)
-			__set_bit(NUM_LOAD_INDICES - new_index - 1,
-				rq->wrq.top_tasks_bitmap[curr]);
+			top_tasks_set_bit(rq, curr, new_index);
 	}
 }
 
@@ -1415,14 +1980,11 @@ static void rollover_top_tasks(struct rq *rq, bool full_window)
 	u8 prev_table = 1 - curr_table;
 	int curr_top = rq->wrq.curr_top;
 
-	clear_top_tasks_table(rq->wrq.top_tasks[prev_table]);
-	clear_top_tasks_bitmap(rq->wrq.top_tasks_bitmap[prev_table]);
+	clear_top_tasks(rq, prev_table);
 
 	if (full_window) {
 		curr_top = 0;
-		clear_top_tasks_table(rq->wrq.top_tasks[curr_table]);
-		clear_top_tasks_bitmap(
-				rq->wrq.top_tasks_bitmap[curr_table]);
+		clear_top_tasks(rq, curr_table);
 	}
 
 	rq->wrq.curr_table = prev_table;
@@ -1804,17 +2366,10 @@ static void update_cpu_busy_time(struct task_struct *p, struct rq *rq,
 static inline u32 predict_and_update_buckets(
 			struct task_struct *p, u32 runtime) {
 
-	int bidx;
-	u32 pred_demand;
-
 	if (!sched_predl)
 		return 0;
 
-	bidx = busy_to_bucket(runtime);
-	pred_demand = get_pred_busy(p, bidx, runtime);
-	bucket_increase(p->wts.busy_buckets, bidx);
-
-	return pred_demand;
+	return task_predictor(p)->update(p, runtime);
 }
 
 static int
@@ -2225,6 +2780,10 @@ void init_new_task_load(struct task_struct *p)
 	p->wts.active_time = 0;
 	for (i = 0; i < NUM_BUSY_BUCKETS; ++i)
 		p->wts.busy_buckets[i] = 0;
+	p->wts.pred_ewma = 0;
+	p->wts.pred_burst = 0;
+	p->wts.pred_period = 0;
+	p->wts.pred_nr_wakeups = 0;
 
 	p->wts.cpu_cycles = 0;
 
@@ -2297,6 +2856,10 @@ void reset_task_stats(struct task_struct *p)
 	p->wts.pred_demand = 0;
 	for (i = 0; i < NUM_BUSY_BUCKETS; ++i)
 		p->wts.busy_buckets[i] = 0;
+	p->wts.pred_ewma = 0;
+	p->wts.pred_burst = 0;
+	p->wts.pred_period = 0;
+	p->wts.pred_nr_wakeups = 0;
 	p->wts.demand_scaled = 0;
 	p->wts.pred_demand_scaled = 0;
 	p->wts.active_time = 0;
@@ -2697,6 +3260,7 @@ static int cpufreq_notifier_trans(struct notifier_block *nb,
 		cluster->cur_freq = new_freq;
 		cpumask_andnot(&policy_cpus, &policy_cpus, &cluster->cpus);
 	}
+	walt_placement_cache_invalidate();
 
 	return NOTIFY_OK;
 }
@@ -3205,6 +3769,7 @@ void sched_update_cpu_freq_min_max(const cpumask_t *cpus, u32 fmin, u32 fmax)
 
 void note_task_waking(struct task_struct *p, u64 wallclock)
 {
+	update_pred_period(p, wallclock);
 	p->wts.last_wake_ts = wallclock;
 }
 
@@ -3442,6 +4007,200 @@ static void walt_update_irqload(struct rq *rq)
 		rq->wrq.high_irqload = 0;
 }
 
+static void walt_update_psi_floor(void)
+{
+	struct walt_sched_cluster *cluster;
+	unsigned int thresh = sysctl_sched_walt_psi_mem_thresh_pct;
+	int cpu;
+
+	for_each_sched_cluster(cluster) {
+		unsigned int stall_pct = 0;
+		bool floor;
+
+		for_each_cpu(cpu, &cluster->cpus) {
+			struct rq *rq = cpu_rq(cpu);
+			u32 now = psi_cpu_memstall_time(cpu);
+			u32 delta = now - rq->wrq.last_memstall_time;
+
+			rq->wrq.last_memstall_time = now;
+			stall_pct = max_t(unsigned int, stall_pct,
+					  div64_u64((u64)delta * 100,
+						    sched_ravg_window));
+		}
+
+		floor = thresh && stall_pct >= thresh;
+		if (floor || cluster->psi_floor)
+			trace_sched_walt_psi_floor(cluster->id, stall_pct,
+					floor, sysctl_sched_walt_psi_mem_floor_pct);
+		cluster->psi_floor = floor;
+	}
+}
+
+static void walt_update_aggr_grp_load(u64 total_grp_load,
+				      u64 min_cluster_grp_load,
+				      const struct cpumask *freq_match_cpus)
+{
+	int cpu;
+
+	if (total_grp_load) {
+		if (cpumask_weight(freq_match_cpus)) {
+			u64 big_grp_load =
+					  total_grp_load - min_cluster_grp_load;
+
+			for_each_cpu(cpu, freq_match_cpus)
+				cpu_cluster(cpu)->aggr_grp_load = big_grp_load;
+		}
+		rtgb_active = is_rtgb_active();
+	} else {
+		rtgb_active = false;
+	}
+}
+
+/*
+ * Kick cpufreq for all online CPUs. @lock_rq is set when the caller does not
+ * already hold the rq locks, in which case each rq is locked only around its
+ * own update.
+ */
+static void walt_irq_work_update_freq(bool is_migration,
+				      bool is_asym_migration,
+				      const struct cpumask *freq_match_cpus,
+				      bool lock_rq)
+{
+	struct walt_sched_cluster *cluster;
+	struct rq *rq;
+	int cpu;
+
+	for_each_sched_cluster(cluster) {
+		cpumask_t cluster_online_cpus;
+		unsigned int num_cpus, i = 1;
+
+		cpumask_and(&cluster_online_cpus, &cluster->cpus,
+						cpu_online_mask);
+		num_cpus = cpumask_weight(&cluster_online_cpus);
+		for_each_cpu(cpu, &cluster_online_cpus) {
+			int flag = SCHED_CPUFREQ_WALT;
+
+			rq = cpu_rq(cpu);
+			if (lock_rq)
+				raw_spin_lock(&rq->lock);
+
+			if (is_migration) {
+				if (rq->wrq.notif_pending) {
+					flag |= SCHED_CPUFREQ_INTERCLUSTER_MIG;
+					rq->wrq.notif_pending = false;
+				}
+			}
+
+			if (is_asym_migration && cpumask_test_cpu(cpu,
+							freq_match_cpus))
+				flag |= SCHED_CPUFREQ_INTERCLUSTER_MIG;
+
+			if (i == num_cpus)
+				cpufreq_update_util(cpu_rq(cpu), flag);
+			else
+				cpufreq_update_util(cpu_rq(cpu), flag |
+							SCHED_CPUFREQ_CONTINUE);
+			i++;
+
+			if (!is_migration)
+				walt_update_irqload(rq);
+
+			if (lock_rq)
+				raw_spin_unlock(&rq->lock);
+		}
+	}
+}
+
+/*
+ * Lock-free flavour of walt_irq_work(). Every CPU is rolled over under its
+ * own rq lock only and publishes its window snapshot. Cluster aggregation
+ * and the cross-CPU reads done for frequency selection then work off the
+ * published snapshots, so no more than one rq lock is held at a time.
+ */
+static void walt_irq_work_lockless(bool is_migration,
+				   const struct cpumask *freq_match_cpus)
+{
+	struct walt_sched_cluster *cluster;
+	struct walt_window_snapshot snap;
+	bool is_asym_migration = false;
+	u64 total_grp_load = 0, min_cluster_grp_load = 0;
+	struct rq *rq;
+	int cpu, i;
+
+	walt_load_reported_window = atomic64_read(&walt_irq_work_lastq_ws);
+	for_each_sched_cluster(cluster) {
+		u64 class_demand[NR_WALT_DEMAND_CLASSES] = { 0 };
+		u64 aggr_grp_load = 0;
+
+		/*
+		 * Deferred subtractions target the siblings; apply them for
+		 * the whole cluster before any CPU consumes its load_subs.
+		 */
+		for_each_cpu(cpu, &cluster->cpus) {
+			rq = cpu_rq(cpu);
+
+			if (!READ_ONCE(rq->wrq.nr_deferred_subs))
+				continue;
+
+			raw_spin_lock(&rq->lock);
+			raw_spin_lock(&cluster->load_lock);
+			flush_deferred_subtractions(rq);
+			raw_spin_unlock(&cluster->load_lock);
+			raw_spin_unlock(&rq->lock);
+		}
+
+		for_each_cpu(cpu, &cluster->cpus) {
+			rq = cpu_rq(cpu);
+
+			raw_spin_lock(&rq->lock);
+			raw_spin_lock(&cluster->load_lock);
+			if (rq->curr) {
+				walt_update_task_ravg(rq->curr, rq,
+						TASK_UPDATE,
+						sched_ktime_clock(), 0);
+				account_load_subtractions(rq);
+			}
+			walt_publish_window_snapshot(rq);
+			raw_spin_unlock(&cluster->load_lock);
+
+			if (is_migration && rq->wrq.notif_pending &&
+				cpumask_test_cpu(cpu, freq_match_cpus)) {
+				is_asym_migration = true;
+				rq->wrq.notif_pending = false;
+			}
+			raw_spin_unlock(&rq->lock);
+
+			walt_read_window_snapshot(cpu, &snap);
+			aggr_grp_load += snap.grp_prev_runnable_sum;
+			for (i = 0; i < NR_WALT_DEMAND_CLASSES; i++)
+				class_demand[i] += snap.class_demand_scaled[i];
+		}
+
+		raw_spin_lock(&cluster->load_lock);
+		cluster->aggr_grp_load = aggr_grp_load;
+		memcpy(cluster->class_demand_scaled, class_demand,
+		       sizeof(class_demand));
+		raw_spin_unlock(&cluster->load_lock);
+
+		total_grp_load += aggr_grp_load;
+		if (is_min_capacity_cluster(cluster))
+			min_cluster_grp_load = aggr_grp_load;
+	}
+
+	walt_update_aggr_grp_load(total_grp_load, min_cluster_grp_load,
+				  freq_match_cpus);
+
+	if (!is_migration && sysctl_sched_user_hint && time_after(jiffies,
+						sched_user_hint_reset_time))
+		sysctl_sched_user_hint = 0;
+
+	walt_irq_work_update_freq(is_migration, is_asym_migration,
+				  freq_match_cpus, true);
+
+	if (!is_migration)
+		core_ctl_check(this_rq()->wrq.window_start);
+}
+
 /*
  * Runs in hard-irq context. This should ideally run just after the latest
  * window roll-over.
@@ -3450,7 +4209,7 @@ void walt_irq_work(struct irq_work *irq_work)
 {
 	struct walt_sched_cluster *cluster;
 	struct rq *rq;
-	int cpu;
+	int cpu, i;
 	u64 wc;
 	bool is_migration = false, is_asym_migration = false;
 	u64 total_grp_load = 0, min_cluster_grp_load = 0;
@@ -3468,6 +4227,20 @@ void walt_irq_work(struct irq_work *irq_work)
 	/* Am I the window rollover work or the migration work? */
 	if (irq_work == &walt_migration_irq_work)
 		is_migration = true;
+	else {
+		walt_placement_cache_invalidate();
+		walt_update_psi_floor();
+	}
+
+	/*
+	 * A pending window size change needs all rq locks; take the
+	 * regular path for it.
+	 */
+	if (sysctl_sched_walt_lockless_rollover &&
+	    (is_migration || sched_ravg_window == new_sched_ravg_window)) {
+		walt_irq_work_lockless(is_migration, &freq_match_cpus);
+		return;
+	}
 
 	for_each_cpu(cpu, cpu_possible_mask) {
 		if (level == 0)
@@ -3485,6 +4258,11 @@ void walt_irq_work(struct irq_work *irq_work)
 
 		raw_spin_lock(&cluster->load_lock);
 
+		for_each_cpu(cpu, &cluster->cpus)
+			flush_deferred_subtractions(cpu_rq(cpu));
+
+		memset(cluster->class_demand_scaled, 0,
+		       sizeof(cluster->class_demand_scaled));
 		for_each_cpu(cpu, &cluster->cpus) {
 			rq = cpu_rq(cpu);
 			if (rq->curr) {
@@ -3494,6 +4272,10 @@ void walt_irq_work(struct irq_work *irq_work)
 				aggr_grp_load +=
 					rq->wrq.grp_time.prev_runnable_sum;
 			}
+			walt_publish_window_snapshot(rq);
+			for (i = 0; i < NR_WALT_DEMAND_CLASSES; i++)
+				cluster->class_demand_scaled[i] +=
+				rq->wrq.walt_stats.class_demand_scaled[i];
 			if (is_migration && rq->wrq.notif_pending &&
 				cpumask_test_cpu(cpu, &freq_match_cpus)) {
 				is_asym_migration = true;
@@ -3509,57 +4291,15 @@ void walt_irq_work(struct irq_work *irq_work)
 		raw_spin_unlock(&cluster->load_lock);
 	}
 
-	if (total_grp_load) {
-		if (cpumask_weight(&freq_match_cpus)) {
-			u64 big_grp_load =
-					  total_grp_load - min_cluster_grp_load;
-
-			for_each_cpu(cpu, &freq_match_cpus)
-				cpu_cluster(cpu)->aggr_grp_load = big_grp_load;
-		}
-		rtgb_active = is_rtgb_active();
-	} else {
-		rtgb_active = false;
-	}
+	walt_update_aggr_grp_load(total_grp_load, min_cluster_grp_load,
+				  &freq_match_cpus);
 
 	if (!is_migration && sysctl_sched_user_hint && time_after(jiffies,
 						sched_user_hint_reset_time))
 		sysctl_sched_user_hint = 0;
 
-	for_each_sched_cluster(cluster) {
-		cpumask_t cluster_online_cpus;
-		unsigned int num_cpus, i = 1;
-
-		cpumask_and(&cluster_online_cpus, &cluster->cpus,
-						cpu_online_mask);
-		num_cpus = cpumask_weight(&cluster_online_cpus);
-		for_each_cpu(cpu, &cluster_online_cpus) {
-			int flag = SCHED_CPUFREQ_WALT;
-
-			rq = cpu_rq(cpu);
-
-			if (is_migration) {
-				if (rq->wrq.notif_pending) {
-					flag |= SCHED_CPUFREQ_INTERCLUSTER_MIG;
-					rq->wrq.notif_pending = false;
-				}
-			}
-
-			if (is_asym_migration && cpumask_test_cpu(cpu,
-							&freq_match_cpus))
-				flag |= SCHED_CPUFREQ_INTERCLUSTER_MIG;
-
-			if (i == num_cpus)
-				cpufreq_update_util(cpu_rq(cpu), flag);
-			else
-				cpufreq_update_util(cpu_rq(cpu), flag |
-							SCHED_CPUFREQ_CONTINUE);
-			i++;
-
-			if (!is_migration)
-				walt_update_irqload(rq);
-		}
-	}
+	walt_irq_work_update_freq(is_migration, is_asym_migration,
+				  &freq_match_cpus, false);
 
 	/*
 	 * If the window change request is in pending, good place to
@@ -3790,6 +4530,7 @@ void walt_sched_init_rq(struct rq *rq)
 	rq->wrq.curr_top = 0;
 	rq->wrq.last_cc_update = 0;
 	rq->wrq.cycles = 0;
+	rq->wrq.nr_deferred_subs = 0;
 	for (j = 0; j < NUM_TRACKED_WINDOWS; j++) {
 		memset(&rq->wrq.load_subs[j], 0,
 				sizeof(struct load_subtractions));
@@ -3798,9 +4539,15 @@ void walt_sched_init_rq(struct rq *rq)
 		/* No other choice */
 		BUG_ON(!rq->wrq.top_tasks[j]);
 		clear_top_tasks_bitmap(rq->wrq.top_tasks_bitmap[j]);
+		rq->wrq.top_tasks_summary[j] =
+				BIT(BIT_WORD(NUM_LOAD_INDICES));
 	}
 	rq->wrq.cum_window_demand_scaled = 0;
 	rq->wrq.notif_pending = false;
+	memset(rq->wrq.walt_stats.class_demand_scaled, 0,
+	       sizeof(rq->wrq.walt_stats.class_demand_scaled));
+	seqcount_init(&rq->wrq.snap_seq);
+	memset(&rq->wrq.snap, 0, sizeof(rq->wrq.snap));
 }
 
 int walt_proc_user_hint_handler(struct ctl_table *table,
@@ -32,12 +32,44 @@ fixup_cumulative_runnable_avg(struct walt_sched_stats *stats,
 	BUG_ON((s64)stats->pred_demands_sum_scaled < 0);
 }
 
+#ifdef CONFIG_UCLAMP_TASK_GROUP
+static inline u8 walt_task_demand_class(struct task_struct *p)
+{
+	struct task_group *tg = task_group(p);
+
+	return tg ? tg->wtg.demand_class : WALT_DEMAND_CLASS_OTHER;
+}
+#else
+static inline u8 walt_task_demand_class(struct task_struct *p)
+{
+	return WALT_DEMAND_CLASS_OTHER;
+}
+#endif /* CONFIG_UCLAMP_TASK_GROUP */
+
+static inline void
+fixup_class_demand(struct walt_sched_stats *stats, struct task_struct *p,
+		   s64 demand_scaled_delta)
+{
+	u64 *class_demand = &stats->class_demand_scaled[p->wts.demand_class];
+
+	*class_demand += demand_scaled_delta;
+	BUG_ON((s64)*class_demand < 0);
+}
+
 static inline void
 walt_inc_cumulative_runnable_avg(struct rq *rq, struct task_struct *p)
 {
 	fixup_cumulative_runnable_avg(&rq->wrq.walt_stats, p->wts.demand_scaled,
 					p->wts.pred_demand_scaled);
 
+	/*
+	 * Latch the demand class at enqueue so that the matching dequeue
+	 * subtracts from the same accumulator even if the cgroup's class
+	 * is changed in between.
+	 */
+	p->wts.demand_class = walt_task_demand_class(p);
+	fixup_class_demand(&rq->wrq.walt_stats, p, p->wts.demand_scaled);
+
 	/*
 	 * Add a task's contribution to the cumulative window demand when
 	 *
@@ -55,6 +87,7 @@ walt_dec_cumulative_runnable_avg(struct rq *rq, struct task_struct *p)
 	fixup_cumulative_runnable_avg(&rq->wrq.walt_stats,
 				      -(s64)p->wts.demand_scaled,
 				      -(s64)p->wts.pred_demand_scaled);
+	fixup_class_demand(&rq->wrq.walt_stats, p, -(s64)p->wts.demand_scaled);
 
 	/*
 	 * on_rq will be 1 for sleeping tasks. So check if the task
@@ -174,6 +207,23 @@ static inline bool walt_should_kick_upmigrate(struct task_struct *p, int cpu)
 
 extern bool is_rtgb_active(void);
 extern u64 get_rtgb_active_time(void);
+extern void walt_read_window_snapshot(int cpu,
+				      struct walt_window_snapshot *snap);
+
+/*
+ * CPUs worth visiting in walt_find_best_target(), cached between window
+ * rollovers, frequency transitions and isolation changes.
+ */
+struct walt_placement_cache {
+	unsigned int	gen;
+	cpumask_t	usable_cpus;		/* active and not isolated */
+	cpumask_t	candidate_cpus;		/* usable and not irq loaded */
+};
+
+extern void walt_placement_cache_invalidate(void);
+extern void walt_telemetry_tick(struct rq *rq);
+extern void walt_irq_balance_kick(void);
+extern const struct walt_placement_cache *walt_placement_cache_get(void);
 
 /* utility function to update walt signals at wakeup */
 static inline void walt_try_to_wake_up(struct task_struct *p)
@@ -236,6 +286,9 @@ static inline void init_new_task_load(struct task_struct *p)
 static inline void mark_task_starting(struct task_struct *p) { }
 static inline void set_window_start(struct rq *rq) { }
 static inline int sched_cpu_high_irqload(int cpu) { return 0; }
+static inline void walt_placement_cache_invalidate(void) { }
+static inline void walt_telemetry_tick(struct rq *rq) { }
+static inline void walt_irq_balance_kick(void) { }
 
 static inline void sched_account_irqstart(int cpu, struct task_struct *curr,
 					  u64 wallclock)
@@ -1255,6 +1255,16 @@ static inline void tick_nohz_irq_enter(void)
 	if (!ts->idle_active && !ts->tick_stopped)
 		return;
 	now = ktime_get();
+	/*
+	 * An isolated CPU should only leave idle for its own timers. Count
+	 * every other interruption so residual wakeup sources show up in
+	 * /proc/timer_list.
+	 */
+	if (ts->idle_active && cpu_isolated(smp_processor_id())) {
+		ts->iso_wakeups++;
+		if (ts->tick_stopped && now < ts->idle_expires)
+			ts->iso_early_wakeups++;
+	}
 	if (ts->idle_active)
 		tick_nohz_stop_idle(ts, now);
 	if (ts->tick_stopped)
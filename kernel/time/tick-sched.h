@@ -48,6 +48,9 @@ enum tick_nohz_mode {
  * @timer_expires:	Anticipated timer expiration time (in case sched tick is stopped)
  * @timer_expires_base:	Base time clock monotonic for @timer_expires
  * @next_timer:		Expiry time of next expiring timer for debugging purpose only
+ * @iso_wakeups:	Number of idle interruptions while the CPU was isolated
+ * @iso_early_wakeups:	Isolated idle interruptions before @idle_expires, i.e.
+ *			by an interrupt or IPI rather than the next timer
  * @tick_dep_mask:	Tick dependency mask - is set, if someone needs the tick
  */
 struct tick_sched {
@@ -76,6 +79,8 @@ struct tick_sched {
 	u64				timer_expires_base;
 	u64				next_timer;
 	ktime_t				idle_expires;
+	unsigned long			iso_wakeups;
+	unsigned long			iso_early_wakeups;
 	atomic_t			tick_dep_mask;
 };
 
@@ -21,6 +21,7 @@
 #include <linux/completion.h>
 #include <linux/sched/clock.h>
 #include <linux/ipc_logging.h>
+#include <asm/sections.h>
 #include <soc/qcom/minidump.h>
 
 #include "ipc_logging_private.h"
@@ -30,6 +31,9 @@
 #define MAX_MINIDUMP_BUFFERS CONFIG_IPC_LOG_MINIDUMP_BUFFERS
 /*16th bit is used for minidump feature*/
 #define FEATURE_MASK 0x10000
+/*17th bit is used for deferred string formatting*/
+#define BINARY_FEATURE_MASK 0x20000
+#define BIN_MSG_WORDS (MAX_MSG_SIZE / sizeof(u32))
 
 static int minidump_buf_cnt;
 static LIST_HEAD(ipc_log_context_list);
@@ -132,7 +136,7 @@ static struct ipc_log_page *get_next_page(struct ipc_log_context *ilctxt,
 }
 
 static void register_minidump(u64 vaddr, u64 size,
-			      const char *buf_name, int index)
+			      const char *buf_name, int index, char *md_name)
 {
 	struct md_region md_entry;
 	int ret;
@@ -154,8 +158,43 @@ static void register_minidump(u64 vaddr, u64 size,
 			return;
 		}
 		minidump_buf_cnt++;
+		if (md_name)
+			strlcpy(md_name, md_entry.name, MAX_NAME_LENGTH);
 	}
 }
+
+/*
+ * Pages that were never written hold nothing but the header, which the
+ * extraction tool still needs to walk the page list. Dump only that
+ * much of them, so that large, mostly idle logs stay cheap in minidump.
+ */
+static int ipc_log_minidump_panic(struct notifier_block *nb,
+				  unsigned long event, void *ptr)
+{
+	struct ipc_log_context *ctxt;
+	struct ipc_log_page_header *hdr;
+
+	if (!read_trylock(&context_list_lock_lha1))
+		return NOTIFY_DONE;
+
+	list_for_each_entry(ctxt, &ipc_log_context_list, list) {
+		list_for_each_entry(hdr, &ctxt->page_list, list) {
+			if (!hdr->md_name[0] || hdr->start_time ||
+			    hdr->write_offset)
+				continue;
+			msm_minidump_trim_region(hdr->md_name,
+					sizeof(struct ipc_log_page_header));
+		}
+	}
+	read_unlock(&context_list_lock_lha1);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block ipc_log_minidump_nb = {
+	.notifier_call = ipc_log_minidump_panic,
+};
+
 /**
  * ipc_log_read - do non-destructive read of the log
  *
@@ -519,9 +558,49 @@ int tsv_byte_array_write(struct encode_context *ectxt,
 }
 EXPORT_SYMBOL(tsv_byte_array_write);
 
+/*
+ * Log a string without formatting it: store the format pointer and the
+ * arguments in the binary form of vbin_printf(), and leave the formatting
+ * to the reader. Arguments that are dereferenced (%s, most %p extensions)
+ * are captured by value, so only the format string has to outlive the
+ * message; only formats in the kernel image's .rodata qualify, since module
+ * data may be gone by the time the log is read.
+ *
+ * @ilctxt ipc_log_context created using ipc_log_context_create()
+ * @fmt Data specified using format specifiers
+ * @args Arguments for @fmt
+ *
+ * returns 0 on success, -E2BIG if the arguments do not fit a message
+ */
+static int ipc_log_bin_string(void *ilctxt, const char *fmt, va_list args)
+{
+	struct encode_context ectxt;
+	u32 bin[BIN_MSG_WORDS];
+	int avail_words, len, hdr_size = sizeof(struct tsv_header);
+
+	if (!is_kernel_rodata((unsigned long)fmt))
+		return -EINVAL;
+
+	msg_encode_start(&ectxt, TSV_TYPE_BIN_STRING);
+	tsv_timestamp_write(&ectxt);
+	tsv_qtimer_write(&ectxt);
+	tsv_pointer_write(&ectxt, (void *)fmt);
+	avail_words = (MAX_MSG_SIZE - (ectxt.offset + hdr_size)) / sizeof(u32);
+	len = vbin_printf(bin, avail_words, fmt, args);
+	if (len > avail_words)
+		return -E2BIG;
+	tsv_byte_array_write(&ectxt, bin, len * sizeof(u32));
+	msg_encode_end(&ectxt);
+	ipc_log_write(ilctxt, &ectxt);
+	return 0;
+}
+
 /*
  * Helper function to log a string
  *
+ * The string is formatted right away, unless the context has deferred
+ * formatting enabled and the message qualifies for ipc_log_bin_string().
+ *
  * @ilctxt ipc_log_context created using ipc_log_context_create()
  * @fmt Data specified using format specifiers
  */
@@ -534,6 +613,16 @@ int ipc_log_string(void *ilctxt, const char *fmt, ...)
 	if (!ilctxt)
 		return -EINVAL;
 
+	if (READ_ONCE(((struct ipc_log_context *)ilctxt)->binary)) {
+		int ret;
+
+		va_start(arg_list, fmt);
+		ret = ipc_log_bin_string(ilctxt, fmt, arg_list);
+		va_end(arg_list);
+		if (!ret)
+			return 0;
+	}
+
 	msg_encode_start(&ectxt, TSV_TYPE_STRING);
 	tsv_timestamp_write(&ectxt);
 	tsv_qtimer_write(&ectxt);
@@ -770,6 +859,42 @@ void tsv_byte_array_read(struct encode_context *ectxt,
 }
 EXPORT_SYMBOL(tsv_byte_array_read);
 
+/*
+ * Formats a message written by ipc_log_bin_string(), after its timestamps
+ * have been read. The output is limited to what ipc_log_string() would
+ * have stored for the same message.
+ *
+ * @ectxt   context initialized by calling msg_read()
+ * @dctxt   deserialization context
+ */
+void tsv_bin_string_read(struct encode_context *ectxt,
+			 struct decode_context *dctxt)
+{
+	struct tsv_header hdr;
+	u32 bin[BIN_MSG_WORDS];
+	const char *fmt;
+	int len, size;
+
+	tsv_read_header(ectxt, &hdr);
+	if (WARN_ON(hdr.type != TSV_TYPE_POINTER))
+		return;
+	tsv_read_data(ectxt, &fmt, sizeof(fmt));
+
+	tsv_read_header(ectxt, &hdr);
+	if (WARN_ON(hdr.type != TSV_TYPE_BYTE_ARRAY || hdr.size > sizeof(bin)))
+		return;
+	tsv_read_data(ectxt, bin, hdr.size);
+
+	if (WARN_ON(!is_kernel_rodata((unsigned long)fmt)))
+		return;
+
+	size = min(dctxt->size, MAX_MSG_SIZE);
+	len = bstr_printf(dctxt->buff, size, fmt, bin);
+	len = min(len, size - 1);
+	dctxt->buff += len;
+	dctxt->size -= len;
+}
+
 int add_deserialization_func(void *ctxt, int type,
 			void (*dfunc)(struct encode_context *,
 				      struct decode_context *))
@@ -857,7 +982,7 @@ void *ipc_log_context_create(int max_num_pages,
 	spin_lock_irqsave(&ctxt->context_lock_lhb1, flags);
 	if (enable_minidump) {
 		register_minidump((u64)ctxt, sizeof(struct ipc_log_context),
-				  "ipc_ctxt", minidump_buf_cnt);
+				  "ipc_ctxt", minidump_buf_cnt, NULL);
 	}
 	spin_unlock_irqrestore(&ctxt->context_lock_lhb1, flags);
 
@@ -879,7 +1004,8 @@ void *ipc_log_context_create(int max_num_pages,
 
 		if (enable_minidump) {
 			register_minidump((u64)pg, sizeof(struct ipc_log_page),
-					  mod_name, minidump_buf_cnt);
+					  mod_name, minidump_buf_cnt,
+					  pg->hdr.md_name);
 		}
 		spin_unlock_irqrestore(&ctxt->context_lock_lhb1, flags);
 	}
@@ -897,6 +1023,7 @@ void *ipc_log_context_create(int max_num_pages,
 	ctxt->header_size = sizeof(struct ipc_log_page_header);
 	kref_init(&ctxt->refcount);
 	ctxt->destroyed = false;
+	ctxt->binary = !!(feature_version & BINARY_FEATURE_MASK);
 	create_ctx_debugfs(ctxt, mod_name);
 
 	/* set magic last to signal context init is complete */
@@ -978,7 +1105,9 @@ static int __init ipc_logging_init(void)
 	check_and_create_debugfs();
 
 	register_minidump((u64)&ipc_log_context_list, sizeof(struct list_head),
-			  "ipc_log_ctxt_list", minidump_buf_cnt);
+			  "ipc_log_ctxt_list", minidump_buf_cnt, NULL);
+	atomic_notifier_chain_register(&panic_notifier_list,
+				       &ipc_log_minidump_nb);
 
 	return 0;
 }
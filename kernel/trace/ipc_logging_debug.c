@@ -154,6 +154,23 @@ static void dfunc_string(struct encode_context *ectxt,
 	}
 }
 
+static void dfunc_bin_string(struct encode_context *ectxt,
+			     struct decode_context *dctxt)
+{
+	tsv_timestamp_read(ectxt, dctxt, "");
+	tsv_qtimer_read(ectxt, dctxt, " ");
+	tsv_bin_string_read(ectxt, dctxt);
+
+	/* add trailing \n if necessary */
+	if (*(dctxt->buff - 1) != '\n') {
+		if (dctxt->size) {
+			++dctxt->buff;
+			--dctxt->size;
+		}
+		*(dctxt->buff - 1) = '\n';
+	}
+}
+
 void check_and_create_debugfs(void)
 {
 	mutex_lock(&ipc_log_debugfs_init_lock);
@@ -183,9 +200,13 @@ void create_ctx_debugfs(struct ipc_log_context *ctxt,
 				     ctxt, &debug_ops);
 			debug_create("log_cont", 0444, ctxt->dent,
 				     ctxt, &debug_ops_cont);
+			debugfs_create_bool("binary", 0644, ctxt->dent,
+					    &ctxt->binary);
 		}
 	}
 	add_deserialization_func((void *)ctxt,
 				 TSV_TYPE_STRING, dfunc_string);
+	add_deserialization_func((void *)ctxt,
+				 TSV_TYPE_BIN_STRING, dfunc_bin_string);
 }
 EXPORT_SYMBOL(create_ctx_debugfs);
@@ -6,6 +6,7 @@
 #define _IPC_LOGGING_PRIVATE_H
 
 #include <linux/ipc_logging.h>
+#include <soc/qcom/minidump.h>
 
 #define IPC_LOG_VERSION 0x0003
 #define IPC_LOG_MAX_CONTEXT_NAME_LEN 32
@@ -26,6 +27,7 @@
  *
  * @list:  Linked list of pages that make up a log
  * @nd_read_offset:  Non-destructive read offset used for debugfs
+ * @md_name:  Minidump region name of the page, empty if not registered
  *
  * The first part of the structure defines data that is used to extract the
  * logs from a memory dump and elements in this section should not be changed
@@ -46,6 +48,7 @@ struct ipc_log_page_header {
 	/* add local data structures after this point */
 	struct list_head list;
 	uint16_t nd_read_offset;
+	char md_name[MAX_NAME_LENGTH];
 };
 
 /**
@@ -87,6 +90,8 @@ struct ipc_log_page {
  * @dfunc_info_list:  List of deserialization functions
  * @context_lock_lhb1:  Lock for entire structure
  * @read_avail:  Completed when new data is added to the log
+ * @binary:  Store ipc_log_string() arguments unformatted, see
+ *	     ipc_log_bin_string()
  */
 struct ipc_log_context {
 	uint32_t magic;
@@ -113,6 +118,7 @@ struct ipc_log_context {
 	struct completion read_avail;
 	struct kref refcount;
 	bool destroyed;
+	bool binary;
 };
 
 struct dfunc_info {
@@ -148,6 +154,9 @@ static inline void ipc_log_context_put(struct ipc_log_context *ilctxt)
 	kref_put(&ilctxt->refcount, ipc_log_context_free);
 }
 
+void tsv_bin_string_read(struct encode_context *ectxt,
+			 struct decode_context *dctxt);
+
 #if (defined(CONFIG_DEBUG_FS))
 void check_and_create_debugfs(void);
 
@@ -28,6 +28,8 @@
 
 #define RTB_COMPAT_STR	"qcom,msm-rtb"
 
+#define RTB_LOG_TYPES	16
+
 /* Write
  * 1) 3 bytes sentinel
  * 2) 1 bytes of log type
@@ -50,15 +52,26 @@ struct msm_rtb_layout {
 } __attribute__ ((__packed__));
 
 
+/*
+ * With CONFIG_QCOM_RTB_SEPARATE_CPUS the buffer is split into one
+ * contiguous segment of nentries_cpu entries per CPU, CPU n at entry
+ * n * nentries_cpu. Each CPU only ever writes its own segment and bumps
+ * its own index, so logging needs no shared atomic and two CPUs never
+ * write the same cache line. The minidump region still covers the whole
+ * buffer.
+ */
 struct msm_rtb_state {
 	struct msm_rtb_layout *rtb;
 	phys_addr_t phys;
 	int nentries;
+	int nentries_cpu;
 	int size;
 	int enabled;
 	int initialized;
 	uint32_t filter;
-	int step_size;
+	unsigned int sample[RTB_LOG_TYPES];
+	unsigned long addr_mask[RTB_LOG_TYPES];
+	unsigned long addr_match[RTB_LOG_TYPES];
 };
 
 #if defined(CONFIG_QCOM_RTB_SEPARATE_CPUS)
@@ -66,6 +79,7 @@ DEFINE_PER_CPU(atomic_t, msm_rtb_idx_cpu);
 #else
 static atomic_t msm_rtb_idx;
 #endif
+static DEFINE_PER_CPU(unsigned int [RTB_LOG_TYPES], msm_rtb_sample_cnt);
 
 static struct msm_rtb_state msm_rtb = {
 	.filter = 1 << LOGK_LOGBUF,
@@ -75,6 +89,15 @@ static struct msm_rtb_state msm_rtb = {
 module_param_named(filter, msm_rtb.filter, uint, 0644);
 module_param_named(enable, msm_rtb.enabled, int, 0644);
 
+/*
+ * Per log type: sample logs one in every N events of the type, 0 or 1
+ * logs all of them. An event is only logged when its data, the address
+ * for register accesses, satisfies (data & addr_mask) == addr_match.
+ */
+module_param_array_named(sample, msm_rtb.sample, uint, NULL, 0644);
+module_param_array_named(addr_mask, msm_rtb.addr_mask, ulong, NULL, 0644);
+module_param_array_named(addr_match, msm_rtb.addr_match, ulong, NULL, 0644);
+
 static int msm_rtb_panic_notifier(struct notifier_block *this,
 					unsigned long event, void *ptr)
 {
@@ -87,10 +110,26 @@ static struct notifier_block msm_rtb_panic_blk = {
 	.priority = INT_MAX,
 };
 
-static int notrace msm_rtb_event_should_log(enum logk_event_type log_type)
+static int notrace msm_rtb_event_should_log(enum logk_event_type log_type,
+					    void *data)
 {
-	return msm_rtb.initialized && msm_rtb.enabled &&
-		((1 << (log_type & ~LOGTYPE_NOPC)) & msm_rtb.filter);
+	unsigned int type = log_type & ~LOGTYPE_NOPC;
+	unsigned int sample;
+
+	if (!msm_rtb.initialized || !msm_rtb.enabled ||
+	    type >= RTB_LOG_TYPES || !((1 << type) & msm_rtb.filter))
+		return 0;
+
+	if (((unsigned long)data & msm_rtb.addr_mask[type]) !=
+	    msm_rtb.addr_match[type])
+		return 0;
+
+	sample = READ_ONCE(msm_rtb.sample[type]);
+	if (sample > 1 &&
+	    this_cpu_inc_return(msm_rtb_sample_cnt[type]) % sample)
+		return 0;
+
+	return 1;
 }
 
 static void msm_rtb_emit_sentinel(struct msm_rtb_layout *start)
@@ -132,12 +171,25 @@ static void msm_rtb_write_cyclecount(struct msm_rtb_layout *start)
 	start->cycle_count = get_cycles();
 }
 
+#if defined(CONFIG_QCOM_RTB_SEPARATE_CPUS)
+static struct msm_rtb_layout *msm_rtb_entry(int idx)
+{
+	return &msm_rtb.rtb[smp_processor_id() * msm_rtb.nentries_cpu +
+			    (idx & (msm_rtb.nentries_cpu - 1))];
+}
+#else
+static struct msm_rtb_layout *msm_rtb_entry(int idx)
+{
+	return &msm_rtb.rtb[idx & (msm_rtb.nentries - 1)];
+}
+#endif
+
 static void uncached_logk_pc_idx(enum logk_event_type log_type, uint64_t caller,
 				 uint64_t data, int idx)
 {
 	struct msm_rtb_layout *start;
 
-	start = &msm_rtb.rtb[idx & (msm_rtb.nentries - 1)];
+	start = msm_rtb_entry(idx);
 
 	msm_rtb_emit_sentinel(start);
 	msm_rtb_write_type(log_type, start);
@@ -161,29 +213,21 @@ static void uncached_logk_timestamp(int idx)
 }
 
 #if defined(CONFIG_QCOM_RTB_SEPARATE_CPUS)
+/*
+ * Called with preemption disabled. The index is only touched by its own
+ * CPU, this_cpu_inc_return() merely keeps it safe against interrupts
+ * logging on top of us.
+ */
 static int msm_rtb_get_idx(void)
 {
-	int cpu, i, offset;
-	atomic_t *index;
-
-	/*
-	 * ideally we would use get_cpu but this is a close enough
-	 * approximation for our purposes.
-	 */
-	cpu = raw_smp_processor_id();
-
-	index = &per_cpu(msm_rtb_idx_cpu, cpu);
+	int i;
 
-	i = atomic_add_return(msm_rtb.step_size, index);
-	i -= msm_rtb.step_size;
+	i = this_cpu_inc_return(msm_rtb_idx_cpu.counter) - 1;
 
-	/* Check if index has wrapped around */
-	offset = (i & (msm_rtb.nentries - 1)) -
-		 ((i - msm_rtb.step_size) & (msm_rtb.nentries - 1));
-	if (offset < 0) {
+	/* Mark each wrap of this CPU's segment with a timestamp */
+	if (i && !(i & (msm_rtb.nentries_cpu - 1))) {
 		uncached_logk_timestamp(i);
-		i = atomic_add_return(msm_rtb.step_size, index);
-		i -= msm_rtb.step_size;
+		i = this_cpu_inc_return(msm_rtb_idx_cpu.counter) - 1;
 	}
 
 	return i;
@@ -214,12 +258,16 @@ int notrace uncached_logk_pc(enum logk_event_type log_type, void *caller,
 {
 	int i;
 
-	if (!msm_rtb_event_should_log(log_type))
+	preempt_disable_notrace();
+	if (!msm_rtb_event_should_log(log_type, data)) {
+		preempt_enable_notrace();
 		return 0;
+	}
 
 	i = msm_rtb_get_idx();
 	uncached_logk_pc_idx(log_type, (uint64_t)((unsigned long) caller),
 				(uint64_t)((unsigned long) data), i);
+	preempt_enable_notrace();
 
 	return 1;
 }
@@ -235,9 +283,6 @@ static int msm_rtb_probe(struct platform_device *pdev)
 {
 	struct msm_rtb_platform_data *d = pdev->dev.platform_data;
 	struct md_region md_entry;
-#if defined(CONFIG_QCOM_RTB_SEPARATE_CPUS)
-	unsigned int cpu;
-#endif
 	int ret;
 
 	if (!pdev->dev.of_node) {
@@ -294,15 +339,22 @@ static int msm_rtb_probe(struct platform_device *pdev)
 		pr_info("Failed to add RTB in Minidump\n");
 
 #if defined(CONFIG_QCOM_RTB_SEPARATE_CPUS)
-	for_each_possible_cpu(cpu) {
-		atomic_t *a = &per_cpu(msm_rtb_idx_cpu, cpu);
-
-		atomic_set(a, cpu);
+	/*
+	 * Every segment is a power of 2 entries and has to start on a cache
+	 * line, so that no line is shared between two CPUs.
+	 */
+	if (msm_rtb.nentries >= nr_cpu_ids)
+		msm_rtb.nentries_cpu =
+			__rounddown_pow_of_two(msm_rtb.nentries / nr_cpu_ids);
+	if (!msm_rtb.nentries_cpu ||
+	    (msm_rtb.nentries_cpu * sizeof(struct msm_rtb_layout)) %
+	    SMP_CACHE_BYTES) {
+		dma_free_coherent(&pdev->dev, msm_rtb.size, msm_rtb.rtb,
+				  msm_rtb.phys);
+		return -EINVAL;
 	}
-	msm_rtb.step_size = num_possible_cpus();
 #else
 	atomic_set(&msm_rtb_idx, 0);
-	msm_rtb.step_size = 1;
 #endif
 
 	atomic_notifier_chain_register(&panic_notifier_list,
@@ -326,6 +326,9 @@ struct trace_array {
 #ifdef CONFIG_TRACER_SNAPSHOT
 	struct cond_snapshot	*cond_snapshot;
 #endif
+#ifdef CONFIG_TRACE_COMPRESS
+	struct trace_compress	*compress;
+#endif
 };
 
 enum {
@@ -703,6 +706,15 @@ void tracing_reset_current(int cpu);
 void tracing_reset_all_online_cpus(void);
 int tracing_open_generic(struct inode *inode, struct file *filp);
 int tracing_open_generic_tr(struct inode *inode, struct file *filp);
+
+#ifdef CONFIG_TRACE_COMPRESS
+extern const struct file_operations trace_compress_kb_fops;
+extern const struct file_operations trace_compress_stats_fops;
+extern const struct file_operations trace_compress_pipe_fops;
+void trace_compress_free(struct trace_array *tr);
+#else
+static inline void trace_compress_free(struct trace_array *tr) { }
+#endif
 bool tracing_is_disabled(void);
 bool tracer_tracing_is_on(struct trace_array *tr);
 void tracer_tracing_on(struct trace_array *tr);
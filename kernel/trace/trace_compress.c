@@ -0,0 +1,467 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Compressed trace history
+ *
+ * Always-on field tracing wants hours of history, but the ring buffer is
+ * sized for seconds. When enabled for an instance, a low priority thread
+ * takes every full page out of the ring buffer, LZ4 compresses it and keeps
+ * it in a per CPU archive bounded by a memory budget; the oldest pages are
+ * dropped first. The page still being written is never touched, so the
+ * live readers see the tail of the trace and the archive holds the rest.
+ *
+ * Interface, per instance:
+ *   compressed_kb                   - archive budget in KB, 0 disables
+ *                                     and frees the archive
+ *   compressed_stats                - per CPU pages, raw and compressed
+ *                                     bytes, ratio and dropped pages
+ *   per_cpu/cpuN/trace_pipe_compressed - consuming read of the archive,
+ *                                     one decompressed page at a time in
+ *                                     the trace_pipe_raw format
+ */
+
+#include <linux/kthread.h>
+#include <linux/list.h>
+#include <linux/lz4.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/tracefs.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include "trace.h"
+
+#define TRACE_COMPRESS_INTERVAL_MS	100
+
+struct trace_compress_page {
+	struct list_head	list;
+	unsigned int		len;
+	char			data[];
+};
+
+struct trace_compress_cpu {
+	spinlock_t		lock;
+	struct list_head	pages;
+	unsigned long		bytes;
+	unsigned long		nr_pages;
+	unsigned long		raw_total;
+	unsigned long		comp_total;
+	unsigned long		dropped;
+};
+
+struct trace_compress {
+	struct task_struct	*thread;
+	unsigned long		budget;
+	void			*wrkmem;
+	char			*dst;
+	struct trace_compress_cpu cpus[];
+};
+
+/* Serializes enabling, disabling and freeing of tr->compress */
+static DEFINE_MUTEX(trace_compress_mutex);
+
+/* See tracing_get_cpu() */
+static inline int trace_compress_get_cpu(struct inode *inode)
+{
+	if (inode->i_cdev)
+		return (long)inode->i_cdev - 1;
+	return RING_BUFFER_ALL_CPUS;
+}
+
+static void trace_compress_drop(struct trace_compress_cpu *tcc)
+{
+	struct trace_compress_page *tcp;
+
+	tcp = list_first_entry(&tcc->pages, struct trace_compress_page, list);
+	list_del(&tcp->list);
+	tcc->bytes -= tcp->len;
+	tcc->nr_pages--;
+	tcc->dropped++;
+	kfree(tcp);
+}
+
+static void trace_compress_store(struct trace_compress *tc, int cpu,
+				 const char *src)
+{
+	struct trace_compress_cpu *tcc = &tc->cpus[cpu];
+	unsigned long budget = READ_ONCE(tc->budget) / num_possible_cpus();
+	struct trace_compress_page *tcp;
+	int len;
+
+	len = LZ4_compress_default(src, tc->dst, PAGE_SIZE,
+				   LZ4_compressBound(PAGE_SIZE), tc->wrkmem);
+	if (len <= 0)
+		return;
+
+	tcp = kmalloc(sizeof(*tcp) + len, GFP_KERNEL | __GFP_NOWARN);
+	if (!tcp) {
+		spin_lock(&tcc->lock);
+		tcc->dropped++;
+		spin_unlock(&tcc->lock);
+		return;
+	}
+	tcp->len = len;
+	memcpy(tcp->data, tc->dst, len);
+
+	spin_lock(&tcc->lock);
+	list_add_tail(&tcp->list, &tcc->pages);
+	tcc->bytes += len;
+	tcc->nr_pages++;
+	tcc->raw_total += PAGE_SIZE;
+	tcc->comp_total += len;
+	while (tcc->bytes > budget && tcc->nr_pages > 1)
+		trace_compress_drop(tcc);
+	spin_unlock(&tcc->lock);
+}
+
+/*
+ * With full set, ring_buffer_read_page() only hands out a page once the
+ * writer has moved past it, so a partially filled page stays in the ring
+ * for the regular readers.
+ */
+static void trace_compress_drain_cpu(struct trace_array *tr,
+				     struct trace_compress *tc, int cpu)
+{
+	struct ring_buffer *buffer = tr->trace_buffer.buffer;
+	void *page;
+
+	page = ring_buffer_alloc_read_page(buffer, cpu);
+	if (IS_ERR(page))
+		return;
+
+	while (!kthread_should_stop() &&
+	       ring_buffer_read_page(buffer, &page, PAGE_SIZE, cpu, 1) >= 0) {
+		trace_compress_store(tc, cpu, page);
+		cond_resched();
+	}
+
+	ring_buffer_free_read_page(buffer, cpu, page);
+}
+
+static int trace_compress_thread(void *data)
+{
+	struct trace_array *tr = data;
+	struct trace_compress *tc = tr->compress;
+	int cpu;
+
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		for_each_tracing_cpu(cpu)
+			trace_compress_drain_cpu(tr, tc, cpu);
+
+		schedule_timeout_interruptible(
+			msecs_to_jiffies(TRACE_COMPRESS_INTERVAL_MS));
+	}
+
+	return 0;
+}
+
+static void trace_compress_clear(struct trace_compress *tc)
+{
+	struct trace_compress_cpu *tcc;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		tcc = &tc->cpus[cpu];
+
+		spin_lock(&tcc->lock);
+		while (!list_empty(&tcc->pages))
+			trace_compress_drop(tcc);
+		tcc->dropped = 0;
+		tcc->raw_total = 0;
+		tcc->comp_total = 0;
+		spin_unlock(&tcc->lock);
+	}
+}
+
+static struct trace_compress *trace_compress_alloc(void)
+{
+	struct trace_compress *tc;
+	int cpu;
+
+	tc = kzalloc(struct_size(tc, cpus, nr_cpu_ids), GFP_KERNEL);
+	if (!tc)
+		return NULL;
+
+	tc->wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	tc->dst = vmalloc(LZ4_compressBound(PAGE_SIZE));
+	if (!tc->wrkmem || !tc->dst) {
+		vfree(tc->wrkmem);
+		vfree(tc->dst);
+		kfree(tc);
+		return NULL;
+	}
+
+	for_each_possible_cpu(cpu) {
+		spin_lock_init(&tc->cpus[cpu].lock);
+		INIT_LIST_HEAD(&tc->cpus[cpu].pages);
+	}
+
+	return tc;
+}
+
+static int trace_compress_set(struct trace_array *tr, unsigned long kb)
+{
+	struct trace_compress *tc;
+	struct task_struct *thread;
+	int ret = 0;
+
+	mutex_lock(&trace_compress_mutex);
+	tc = tr->compress;
+
+	if (!kb) {
+		if (tc && tc->thread) {
+			kthread_stop(tc->thread);
+			tc->thread = NULL;
+			trace_compress_clear(tc);
+		}
+		goto out;
+	}
+
+	if (!tc) {
+		tc = trace_compress_alloc();
+		if (!tc) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		tr->compress = tc;
+	}
+
+	WRITE_ONCE(tc->budget, kb << 10);
+	if (!tc->thread) {
+		thread = kthread_run(trace_compress_thread, tr,
+				     "trace_compress/%s", tr->name ?: "top");
+		if (IS_ERR(thread)) {
+			ret = PTR_ERR(thread);
+			goto out;
+		}
+		tc->thread = thread;
+	}
+ out:
+	mutex_unlock(&trace_compress_mutex);
+	return ret;
+}
+
+void trace_compress_free(struct trace_array *tr)
+{
+	struct trace_compress *tc;
+
+	trace_compress_set(tr, 0);
+
+	mutex_lock(&trace_compress_mutex);
+	tc = tr->compress;
+	tr->compress = NULL;
+	mutex_unlock(&trace_compress_mutex);
+
+	if (!tc)
+		return;
+
+	vfree(tc->wrkmem);
+	vfree(tc->dst);
+	kfree(tc);
+}
+
+static ssize_t
+trace_compress_kb_read(struct file *filp, char __user *ubuf,
+		       size_t cnt, loff_t *ppos)
+{
+	struct trace_array *tr = filp->private_data;
+	struct trace_compress *tc;
+	unsigned long kb = 0;
+	char buf[32];
+	int r;
+
+	mutex_lock(&trace_compress_mutex);
+	tc = tr->compress;
+	if (tc && tc->thread)
+		kb = tc->budget >> 10;
+	mutex_unlock(&trace_compress_mutex);
+
+	r = scnprintf(buf, sizeof(buf), "%lu\n", kb);
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, r);
+}
+
+static ssize_t
+trace_compress_kb_write(struct file *filp, const char __user *ubuf,
+			size_t cnt, loff_t *ppos)
+{
+	struct trace_array *tr = filp->private_data;
+	unsigned long val;
+	int ret;
+
+	ret = kstrtoul_from_user(ubuf, cnt, 10, &val);
+	if (ret)
+		return ret;
+
+	ret = trace_compress_set(tr, val);
+	if (ret)
+		return ret;
+
+	*ppos += cnt;
+	return cnt;
+}
+
+static int trace_compress_open_tr(struct inode *inode, struct file *filp)
+{
+	struct trace_array *tr = inode->i_private;
+	int ret;
+
+	ret = tracing_check_open_get_tr(tr);
+	if (ret)
+		return ret;
+
+	filp->private_data = tr;
+	return 0;
+}
+
+static int trace_compress_release_tr(struct inode *inode, struct file *filp)
+{
+	trace_array_put(inode->i_private);
+	return 0;
+}
+
+const struct file_operations trace_compress_kb_fops = {
+	.open		= trace_compress_open_tr,
+	.read		= trace_compress_kb_read,
+	.write		= trace_compress_kb_write,
+	.llseek		= generic_file_llseek,
+	.release	= trace_compress_release_tr,
+};
+
+static int trace_compress_stats_show(struct seq_file *m, void *v)
+{
+	struct trace_array *tr = m->private;
+	struct trace_compress_cpu tcc;
+	struct trace_compress *tc;
+	int cpu;
+
+	mutex_lock(&trace_compress_mutex);
+	tc = tr->compress;
+	if (!tc)
+		goto out;
+
+	seq_printf(m, "%-5s %10s %12s %12s %12s %8s %10s\n", "cpu", "pages",
+		   "bytes", "raw_total", "comp_total", "ratio", "dropped");
+
+	for_each_tracing_cpu(cpu) {
+		spin_lock(&tc->cpus[cpu].lock);
+		tcc = tc->cpus[cpu];
+		spin_unlock(&tc->cpus[cpu].lock);
+
+		/* Ratio in hundredths, raw over compressed */
+		seq_printf(m, "%-5d %10lu %12lu %12lu %12lu %5lu.%02lu %10lu\n",
+			   cpu, tcc.nr_pages, tcc.bytes, tcc.raw_total,
+			   tcc.comp_total,
+			   tcc.comp_total ? tcc.raw_total / tcc.comp_total : 0,
+			   tcc.comp_total ?
+			   (tcc.raw_total * 100 / tcc.comp_total) % 100 : 0,
+			   tcc.dropped);
+	}
+ out:
+	mutex_unlock(&trace_compress_mutex);
+	return 0;
+}
+
+static int trace_compress_stats_open(struct inode *inode, struct file *filp)
+{
+	struct trace_array *tr = inode->i_private;
+	int ret;
+
+	ret = tracing_check_open_get_tr(tr);
+	if (ret)
+		return ret;
+
+	ret = single_open(filp, trace_compress_stats_show, tr);
+	if (ret)
+		trace_array_put(tr);
+	return ret;
+}
+
+static int trace_compress_stats_release(struct inode *inode, struct file *filp)
+{
+	trace_array_put(inode->i_private);
+	return single_release(inode, filp);
+}
+
+const struct file_operations trace_compress_stats_fops = {
+	.open		= trace_compress_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= trace_compress_stats_release,
+};
+
+/*
+ * Every read returns exactly one page, oldest first, so the output can be
+ * fed to the same parser as trace_pipe_raw. Reads shorter than a page are
+ * refused rather than splitting a page across calls.
+ */
+static ssize_t
+trace_compress_pipe_read(struct file *filp, char __user *ubuf,
+			 size_t cnt, loff_t *ppos)
+{
+	struct inode *inode = file_inode(filp);
+	struct trace_array *tr = filp->private_data;
+	int cpu = trace_compress_get_cpu(inode);
+	struct trace_compress_page *tcp = NULL;
+	struct trace_compress_cpu *tcc;
+	struct trace_compress *tc;
+	char *page;
+	ssize_t ret;
+
+	if (cnt < PAGE_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&trace_compress_mutex);
+	tc = tr->compress;
+	if (tc) {
+		tcc = &tc->cpus[cpu];
+		spin_lock(&tcc->lock);
+		tcp = list_first_entry_or_null(&tcc->pages,
+					       struct trace_compress_page,
+					       list);
+		if (tcp) {
+			list_del(&tcp->list);
+			tcc->bytes -= tcp->len;
+			tcc->nr_pages--;
+		}
+		spin_unlock(&tcc->lock);
+	}
+	mutex_unlock(&trace_compress_mutex);
+
+	if (!tcp)
+		return 0;
+
+	page = (char *)__get_free_page(GFP_KERNEL);
+	if (!page) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = LZ4_decompress_safe(tcp->data, page, tcp->len, PAGE_SIZE);
+	if (ret != PAGE_SIZE) {
+		ret = -EIO;
+		goto out_page;
+	}
+
+	if (copy_to_user(ubuf, page, PAGE_SIZE)) {
+		ret = -EFAULT;
+		goto out_page;
+	}
+	ret = PAGE_SIZE;
+
+ out_page:
+	free_page((unsigned long)page);
+ out:
+	kfree(tcp);
+	return ret;
+}
+
+const struct file_operations trace_compress_pipe_fops = {
+	.open		= trace_compress_open_tr,
+	.read		= trace_compress_pipe_read,
+	.llseek		= no_llseek,
+	.release	= trace_compress_release_tr,
+};
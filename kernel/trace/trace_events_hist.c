@@ -306,6 +306,7 @@ enum hist_field_flags {
 	HIST_FIELD_FL_VAR_REF		= 1 << 14,
 	HIST_FIELD_FL_CPU		= 1 << 15,
 	HIST_FIELD_FL_ALIAS		= 1 << 16,
+	HIST_FIELD_FL_LOG2HIST		= 1 << 17,
 };
 
 struct var_defs {
@@ -323,6 +324,7 @@ struct hist_trigger_attrs {
 	bool		pause;
 	bool		cont;
 	bool		clear;
+	bool		percpu;
 	bool		ts_in_usecs;
 	unsigned int	map_bits;
 
@@ -2232,6 +2234,8 @@ parse_hist_trigger_attrs(struct trace_array *tr, char *trigger_str)
 			attrs->cont = true;
 		else if (strcmp(str, "clear") == 0)
 			attrs->clear = true;
+		else if (strcmp(str, "percpu") == 0)
+			attrs->percpu = true;
 		else {
 			ret = parse_action(str, attrs);
 			if (ret)
@@ -2364,6 +2368,8 @@ static const char *get_hist_field_flags(struct hist_field *hist_field)
 		flags_str = "syscall";
 	else if (hist_field->flags & HIST_FIELD_FL_LOG2)
 		flags_str = "log2";
+	else if (hist_field->flags & HIST_FIELD_FL_LOG2HIST)
+		flags_str = "log2hist";
 	else if (hist_field->flags & HIST_FIELD_FL_TIMESTAMP_USECS)
 		flags_str = "usecs";
 
@@ -2872,6 +2878,8 @@ parse_field(struct hist_trigger_data *hist_data, struct trace_event_file *file,
 			*flags |= HIST_FIELD_FL_SYSCALL;
 		else if (strcmp(modifier, "log2") == 0)
 			*flags |= HIST_FIELD_FL_LOG2;
+		else if (strcmp(modifier, "log2hist") == 0)
+			*flags |= HIST_FIELD_FL_LOG2HIST;
 		else if (strcmp(modifier, "usecs") == 0)
 			*flags |= HIST_FIELD_FL_TIMESTAMP_USECS;
 		else {
@@ -4699,6 +4707,14 @@ static int create_key_field(struct hist_trigger_data *hist_data,
 			goto out;
 		}
 
+		if (hist_field->flags & HIST_FIELD_FL_LOG2HIST) {
+			hist_err(tr, HIST_ERR_BAD_FIELD_MODIFIER,
+				 errpos(field_str));
+			destroy_hist_field(hist_field, 0);
+			ret = -EINVAL;
+			goto out;
+		}
+
 		key_size = hist_field->size;
 	}
 
@@ -5254,7 +5270,9 @@ static int create_tracing_map_fields(struct hist_trigger_data *hist_data)
 			idx = tracing_map_add_key_field(map,
 							hist_field->offset,
 							cmp_fn);
-		} else if (!(hist_field->flags & HIST_FIELD_FL_VAR))
+		} else if (hist_field->flags & HIST_FIELD_FL_LOG2HIST)
+			idx = tracing_map_add_hist_field(map);
+		else if (!(hist_field->flags & HIST_FIELD_FL_VAR))
 			idx = tracing_map_add_sum_field(map);
 
 		if (idx < 0)
@@ -5312,6 +5330,9 @@ create_hist_data(unsigned int map_bits,
 		goto free;
 	}
 
+	if (attrs->percpu)
+		tracing_map_set_percpu(hist_data->map);
+
 	ret = create_tracing_map_fields(hist_data);
 	if (ret)
 		goto free;
@@ -5348,7 +5369,10 @@ static void hist_trigger_elt_update(struct hist_trigger_data *hist_data,
 			tracing_map_set_var(elt, var_idx, hist_val);
 			continue;
 		}
-		tracing_map_update_sum(elt, i, hist_val);
+		if (hist_field->flags & HIST_FIELD_FL_LOG2HIST)
+			tracing_map_update_hist(elt, i, hist_val);
+		else
+			tracing_map_update_sum(elt, i, hist_val);
 	}
 
 	for_each_hist_key_field(i, hist_data) {
@@ -5554,6 +5578,37 @@ static void hist_trigger_print_key(struct seq_file *m,
 	seq_puts(m, "}");
 }
 
+static void hist_trigger_buckets_print(struct seq_file *m,
+				       struct hist_trigger_data *hist_data,
+				       struct tracing_map_elt *elt)
+{
+	const char *field_name;
+	unsigned int i, b;
+	u64 count;
+
+	for (i = 1; i < hist_data->n_vals; i++) {
+		if (!(hist_data->fields[i]->flags & HIST_FIELD_FL_LOG2HIST))
+			continue;
+
+		field_name = hist_field_name(hist_data->fields[i], 0);
+		seq_printf(m, "\n    %s.log2hist:", field_name);
+
+		for (b = 0; b < TRACING_MAP_HIST_BUCKETS; b++) {
+			count = tracing_map_read_hist(elt, i, b);
+			if (!count)
+				continue;
+
+			if (!b)
+				seq_printf(m, " [0]: %llu", count);
+			else if (b == TRACING_MAP_HIST_BUCKETS - 1)
+				seq_printf(m, " [2^%u,...): %llu", b - 1, count);
+			else
+				seq_printf(m, " [2^%u,2^%u): %llu",
+					   b - 1, b, count);
+		}
+	}
+}
+
 static void hist_trigger_entry_print(struct seq_file *m,
 				     struct hist_trigger_data *hist_data,
 				     void *key,
@@ -5585,6 +5640,9 @@ static void hist_trigger_entry_print(struct seq_file *m,
 
 	print_actions(m, hist_data, elt);
 
+	if (hist_data->map->n_hists)
+		hist_trigger_buckets_print(m, hist_data, elt);
+
 	seq_puts(m, "\n");
 }
 
@@ -5632,8 +5690,8 @@ static void hist_trigger_show(struct seq_file *m,
 	track_data_snapshot_print(m, hist_data);
 
 	seq_printf(m, "\nTotals:\n    Hits: %llu\n    Entries: %u\n    Dropped: %llu\n",
-		   (u64)atomic64_read(&hist_data->map->hits),
-		   n_entries, (u64)atomic64_read(&hist_data->map->drops));
+		   tracing_map_read_hits(hist_data->map),
+		   n_entries, tracing_map_read_drops(hist_data->map));
 }
 
 static int hist_show(struct seq_file *m, void *v)
@@ -5798,6 +5856,8 @@ static int event_hist_trigger_print(struct seq_file *m,
 			seq_puts(m, ".descending");
 	}
 	seq_printf(m, ":size=%u", (1 << hist_data->map->map_bits));
+	if (hist_data->map->percpu)
+		seq_puts(m, ":percpu");
 	if (hist_data->enable_timestamps)
 		seq_printf(m, ":clock=%s", hist_data->attrs->clock);
 
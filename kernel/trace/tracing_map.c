@@ -13,6 +13,7 @@
 
 #include <linux/vmalloc.h>
 #include <linux/jhash.h>
+#include <linux/percpu.h>
 #include <linux/slab.h>
 #include <linux/sort.h>
 
@@ -37,7 +38,10 @@
  */
 void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
 {
-	atomic64_add(n, &elt->fields[i].sum);
+	if (elt->pcpu_sums)
+		this_cpu_add(elt->pcpu_sums[i], n);
+	else
+		atomic64_add(n, &elt->fields[i].sum);
 }
 
 /**
@@ -54,7 +58,101 @@ void tracing_map_update_sum(struct tracing_map_elt *elt, unsigned int i, u64 n)
  */
 u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i)
 {
-	return (u64)atomic64_read(&elt->fields[i].sum);
+	u64 sum = 0;
+	int cpu;
+
+	if (!elt->pcpu_sums)
+		return (u64)atomic64_read(&elt->fields[i].sum);
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu_ptr(elt->pcpu_sums, cpu)[i];
+
+	return sum;
+}
+
+static inline unsigned int tracing_map_hist_bucket(u64 n)
+{
+	return min_t(unsigned int, fls64(n), TRACING_MAP_HIST_BUCKETS - 1);
+}
+
+/**
+ * tracing_map_update_hist - Account a value in a tracing_map_elt's histogram
+ * @elt: The tracing_map_elt
+ * @i: The index of the histogram field associated with the tracing_map_elt
+ * @n: The value to account
+ *
+ * Add n to the sum i and count it in the log2 bucket it falls into.
+ * The index i is the index returned by the call to
+ * tracing_map_add_hist_field() when the tracing map was set up.
+ */
+void tracing_map_update_hist(struct tracing_map_elt *elt, unsigned int i,
+			     u64 n)
+{
+	unsigned int b = elt->fields[i].hist_idx * TRACING_MAP_HIST_BUCKETS +
+			 tracing_map_hist_bucket(n);
+
+	tracing_map_update_sum(elt, i, n);
+
+	if (elt->pcpu_buckets)
+		this_cpu_inc(elt->pcpu_buckets[b]);
+	else
+		atomic64_inc(&elt->buckets[b]);
+}
+
+/**
+ * tracing_map_read_hist - Return one bucket of a tracing_map_elt's histogram
+ * @elt: The tracing_map_elt
+ * @i: The index of the histogram field associated with the tracing_map_elt
+ * @bucket: The bucket, below TRACING_MAP_HIST_BUCKETS
+ *
+ * Return: The number of values counted in the bucket, summed over all
+ * CPUs for a per-CPU map.
+ */
+u64 tracing_map_read_hist(struct tracing_map_elt *elt, unsigned int i,
+			  unsigned int bucket)
+{
+	unsigned int b = elt->fields[i].hist_idx * TRACING_MAP_HIST_BUCKETS +
+			 bucket;
+	u64 count = 0;
+	int cpu;
+
+	if (!elt->pcpu_buckets)
+		return (u64)atomic64_read(&elt->buckets[b]);
+
+	for_each_possible_cpu(cpu)
+		count += per_cpu_ptr(elt->pcpu_buckets, cpu)[b];
+
+	return count;
+}
+
+/**
+ * tracing_map_read_hits - Return the number of successful map insertions
+ * @map: The tracing_map
+ */
+u64 tracing_map_read_hits(struct tracing_map *map)
+{
+	u64 hits = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		hits += per_cpu_ptr(map->stats, cpu)->hits;
+
+	return hits;
+}
+
+/**
+ * tracing_map_read_drops - Return the number of failed map insertions
+ * @map: The tracing_map
+ */
+u64 tracing_map_read_drops(struct tracing_map *map)
+{
+	u64 drops = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		drops += per_cpu_ptr(map->stats, cpu)->drops;
+
+	return drops;
 }
 
 /**
@@ -205,12 +303,25 @@ static int tracing_map_add_field(struct tracing_map *map,
 
 	if (map->n_fields < TRACING_MAP_FIELDS_MAX) {
 		ret = map->n_fields;
+		map->fields[map->n_fields].hist_idx = -1;
 		map->fields[map->n_fields++].cmp_fn = cmp_fn;
 	}
 
 	return ret;
 }
 
+/**
+ * tracing_map_set_percpu - Keep the sums of a tracing_map per CPU
+ * @map: The tracing_map
+ *
+ * Must be called before tracing_map_init().  See the overview in
+ * tracing_map.h.
+ */
+void tracing_map_set_percpu(struct tracing_map *map)
+{
+	map->percpu = true;
+}
+
 /**
  * tracing_map_add_sum_field - Add a field describing a tracing_map sum
  * @map: The tracing_map
@@ -228,6 +339,30 @@ int tracing_map_add_sum_field(struct tracing_map *map)
 	return tracing_map_add_field(map, tracing_map_cmp_atomic64);
 }
 
+/**
+ * tracing_map_add_hist_field - Add a field describing a tracing_map histogram
+ * @map: The tracing_map
+ *
+ * Add a sum field that also keeps a fixed log2 histogram of the values
+ * added to it.  Values are accounted with tracing_map_update_hist(),
+ * the total is read with tracing_map_read_sum() and the buckets with
+ * tracing_map_read_hist().
+ *
+ * Return: The index identifying the field in the map and associated
+ * tracing_map_elts, or -EINVAL on error.
+ */
+int tracing_map_add_hist_field(struct tracing_map *map)
+{
+	int idx = tracing_map_add_field(map, tracing_map_cmp_atomic64);
+
+	if (idx < 0)
+		return idx;
+
+	map->fields[idx].hist_idx = map->n_hists++;
+
+	return idx;
+}
+
 /**
  * tracing_map_add_var - Add a field describing a tracing_map var
  * @map: The tracing_map
@@ -354,12 +489,26 @@ struct tracing_map_array *tracing_map_array_alloc(unsigned int n_elts,
 
 static void tracing_map_elt_clear(struct tracing_map_elt *elt)
 {
+	unsigned int n_buckets = elt->map->n_hists * TRACING_MAP_HIST_BUCKETS;
 	unsigned i;
+	int cpu;
 
 	for (i = 0; i < elt->map->n_fields; i++)
 		if (elt->fields[i].cmp_fn == tracing_map_cmp_atomic64)
 			atomic64_set(&elt->fields[i].sum, 0);
 
+	for_each_possible_cpu(cpu) {
+		if (elt->pcpu_sums)
+			memset(per_cpu_ptr(elt->pcpu_sums, cpu), 0,
+			       elt->map->n_fields * sizeof(u64));
+		if (elt->pcpu_buckets)
+			memset(per_cpu_ptr(elt->pcpu_buckets, cpu), 0,
+			       n_buckets * sizeof(u64));
+	}
+
+	for (i = 0; elt->buckets && i < n_buckets; i++)
+		atomic64_set(&elt->buckets[i], 0);
+
 	for (i = 0; i < elt->map->n_vars; i++) {
 		atomic64_set(&elt->vars[i], 0);
 		elt->var_set[i] = false;
@@ -377,6 +526,7 @@ static void tracing_map_elt_init_fields(struct tracing_map_elt *elt)
 
 	for (i = 0; i < elt->map->n_fields; i++) {
 		elt->fields[i].cmp_fn = elt->map->fields[i].cmp_fn;
+		elt->fields[i].hist_idx = elt->map->fields[i].hist_idx;
 
 		if (elt->fields[i].cmp_fn != tracing_map_cmp_atomic64)
 			elt->fields[i].offset = elt->map->fields[i].offset;
@@ -391,6 +541,9 @@ static void tracing_map_elt_free(struct tracing_map_elt *elt)
 	if (elt->map->ops && elt->map->ops->elt_free)
 		elt->map->ops->elt_free(elt);
 	kfree(elt->fields);
+	free_percpu(elt->pcpu_sums);
+	free_percpu(elt->pcpu_buckets);
+	kfree(elt->buckets);
 	kfree(elt->vars);
 	kfree(elt->var_set);
 	kfree(elt->key);
@@ -420,6 +573,32 @@ static struct tracing_map_elt *tracing_map_elt_alloc(struct tracing_map *map)
 		goto free;
 	}
 
+	if (map->percpu) {
+		elt->pcpu_sums = __alloc_percpu(map->n_fields * sizeof(u64),
+						sizeof(u64));
+		if (!elt->pcpu_sums) {
+			err = -ENOMEM;
+			goto free;
+		}
+	}
+
+	if (map->n_hists && map->percpu) {
+		elt->pcpu_buckets = __alloc_percpu(map->n_hists *
+						   TRACING_MAP_HIST_BUCKETS *
+						   sizeof(u64), sizeof(u64));
+		if (!elt->pcpu_buckets) {
+			err = -ENOMEM;
+			goto free;
+		}
+	} else if (map->n_hists) {
+		elt->buckets = kcalloc(map->n_hists * TRACING_MAP_HIST_BUCKETS,
+				       sizeof(*elt->buckets), GFP_KERNEL);
+		if (!elt->buckets) {
+			err = -ENOMEM;
+			goto free;
+		}
+	}
+
 	elt->vars = kcalloc(map->n_vars, sizeof(*elt->vars), GFP_KERNEL);
 	if (!elt->vars) {
 		err = -ENOMEM;
@@ -532,7 +711,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 			if (val &&
 			    keys_match(key, val->key, map->key_size)) {
 				if (!lookup_only)
-					atomic64_inc(&map->hits);
+					this_cpu_inc(map->stats->hits);
 				return val;
 			} else if (unlikely(!val)) {
 				/*
@@ -549,7 +728,7 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 
 				dup_try++;
 				if (dup_try > map->map_size) {
-					atomic64_inc(&map->drops);
+					this_cpu_inc(map->stats->drops);
 					break;
 				}
 				continue;
@@ -565,14 +744,14 @@ __tracing_map_insert(struct tracing_map *map, void *key, bool lookup_only)
 
 				elt = get_free_elt(map);
 				if (!elt) {
-					atomic64_inc(&map->drops);
+					this_cpu_inc(map->stats->drops);
 					entry->key = 0;
 					break;
 				}
 
 				memcpy(elt->key, key, map->key_size);
 				entry->val = elt;
-				atomic64_inc(&map->hits);
+				this_cpu_inc(map->stats->hits);
 
 				return entry->val;
 			} else {
@@ -673,6 +852,7 @@ void tracing_map_destroy(struct tracing_map *map)
 	tracing_map_free_elts(map);
 
 	tracing_map_array_free(map->map);
+	free_percpu(map->stats);
 	kfree(map);
 }
 
@@ -690,10 +870,11 @@ void tracing_map_destroy(struct tracing_map *map)
 void tracing_map_clear(struct tracing_map *map)
 {
 	unsigned int i;
+	int cpu;
 
 	atomic_set(&map->next_elt, -1);
-	atomic64_set(&map->hits, 0);
-	atomic64_set(&map->drops, 0);
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(map->stats, cpu), 0, sizeof(*map->stats));
 
 	tracing_map_array_clear(map->map);
 
@@ -701,6 +882,21 @@ void tracing_map_clear(struct tracing_map *map)
 		tracing_map_elt_clear(*(TRACING_MAP_ELT(map->elts, i)));
 }
 
+/*
+ * Merge the per-CPU sums of a per-CPU map into the shared sum fields so
+ * that the sort comparators can use them.  Racing updates may leave the
+ * folded value slightly behind, which only affects the sort order.
+ */
+static void tracing_map_elt_fold(struct tracing_map_elt *elt)
+{
+	unsigned int i;
+
+	for (i = 0; i < elt->map->n_fields; i++)
+		if (elt->fields[i].cmp_fn == tracing_map_cmp_atomic64)
+			atomic64_set(&elt->fields[i].sum,
+				     tracing_map_read_sum(elt, i));
+}
+
 static void set_sort_key(struct tracing_map *map,
 			 struct tracing_map_sort_key *sort_key)
 {
@@ -782,6 +978,10 @@ struct tracing_map *tracing_map_create(unsigned int map_bits,
 
 	map->private_data = private_data;
 
+	map->stats = alloc_percpu(struct tracing_map_stats);
+	if (!map->stats)
+		goto free;
+
 	map->map = tracing_map_array_alloc(map->map_size,
 					   sizeof(struct tracing_map_entry));
 	if (!map->map)
@@ -1078,6 +1278,9 @@ int tracing_map_sort_entries(struct tracing_map *map,
 		if (!entry->key || !entry->val)
 			continue;
 
+		if (map->percpu)
+			tracing_map_elt_fold(entry->val);
+
 		entries[n_entries] = create_sort_entry(entry->val->key,
 						       entry->val);
 		if (!entries[n_entries++]) {
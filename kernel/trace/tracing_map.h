@@ -12,6 +12,7 @@
 					 TRACING_MAP_VALS_MAX)
 #define TRACING_MAP_VARS_MAX		16
 #define TRACING_MAP_SORT_KEYS_MAX	2
+#define TRACING_MAP_HIST_BUCKETS	32
 
 typedef int (*tracing_map_cmp_fn_t) (void *val_a, void *val_b);
 
@@ -125,6 +126,18 @@ typedef int (*tracing_map_cmp_fn_t) (void *val_a, void *val_b);
  * user, tracing_map_sort_entry objects contain a number of additional
  * fields which are used for caching and internal purposes and can
  * safely be ignored.
+ *
+ * A map can be made per-CPU with tracing_map_set_percpu() before
+ * tracing_map_init().  The hash table and the elements stay shared, so
+ * a key is still claimed once, but every sum and histogram bucket of an
+ * element is a per-CPU counter that the update path bumps without any
+ * atomic operation.  The per-CPU copies are only merged when the map is
+ * read, by tracing_map_read_sum() and tracing_map_sort_entries().
+ *
+ * A histogram field, added with tracing_map_add_hist_field(), is a sum
+ * field that additionally counts each value in one of
+ * TRACING_MAP_HIST_BUCKETS fixed log2 buckets: bucket 0 holds 0, bucket
+ * b holds [2^(b-1), 2^b) and the last bucket everything above.
 */
 
 struct tracing_map_field {
@@ -133,11 +146,15 @@ struct tracing_map_field {
 		atomic64_t			sum;
 		unsigned int			offset;
 	};
+	int				hist_idx;
 };
 
 struct tracing_map_elt {
 	struct tracing_map		*map;
 	struct tracing_map_field	*fields;
+	u64 __percpu			*pcpu_sums;
+	atomic64_t			*buckets;
+	u64 __percpu			*pcpu_buckets;
 	atomic64_t			*vars;
 	bool				*var_set;
 	void				*key;
@@ -180,6 +197,11 @@ struct tracing_map_array {
 #define TRACING_MAP_ELT(array, idx)					\
 	((struct tracing_map_elt **)TRACING_MAP_ARRAY_ELT(array, idx))
 
+struct tracing_map_stats {
+	u64				hits;
+	u64				drops;
+};
+
 struct tracing_map {
 	unsigned int			key_size;
 	unsigned int			map_bits;
@@ -196,8 +218,9 @@ struct tracing_map {
 	unsigned int			n_keys;
 	struct tracing_map_sort_key	sort_key;
 	unsigned int			n_vars;
-	atomic64_t			hits;
-	atomic64_t			drops;
+	unsigned int			n_hists;
+	bool				percpu;
+	struct tracing_map_stats __percpu *stats;
 };
 
 /**
@@ -244,7 +267,9 @@ tracing_map_create(unsigned int map_bits,
 		   void *private_data);
 extern int tracing_map_init(struct tracing_map *map);
 
+extern void tracing_map_set_percpu(struct tracing_map *map);
 extern int tracing_map_add_sum_field(struct tracing_map *map);
+extern int tracing_map_add_hist_field(struct tracing_map *map);
 extern int tracing_map_add_var(struct tracing_map *map);
 extern int tracing_map_add_key_field(struct tracing_map *map,
 				     unsigned int offset,
@@ -269,6 +294,12 @@ extern void tracing_map_set_var(struct tracing_map_elt *elt,
 				unsigned int i, u64 n);
 extern bool tracing_map_var_set(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_sum(struct tracing_map_elt *elt, unsigned int i);
+extern void tracing_map_update_hist(struct tracing_map_elt *elt,
+				    unsigned int i, u64 n);
+extern u64 tracing_map_read_hist(struct tracing_map_elt *elt,
+				 unsigned int i, unsigned int bucket);
+extern u64 tracing_map_read_hits(struct tracing_map *map);
+extern u64 tracing_map_read_drops(struct tracing_map *map);
 extern u64 tracing_map_read_var(struct tracing_map_elt *elt, unsigned int i);
 extern u64 tracing_map_read_var_once(struct tracing_map_elt *elt, unsigned int i);
 
@@ -1385,7 +1385,8 @@ static int wq_select_unbound_cpu(int cpu)
 	int new_cpu;
 
 	if (likely(!wq_debug_force_rr_cpu)) {
-		if (cpumask_test_cpu(cpu, wq_unbound_cpumask))
+		if (cpumask_test_cpu(cpu, wq_unbound_cpumask) &&
+		    !cpu_isolated(cpu))
 			return cpu;
 	} else if (!printed_dbg_warning) {
 		pr_warn("workqueue: round-robin CPU selection forced, expect performance impact\n");
@@ -1395,10 +1396,20 @@ static int wq_select_unbound_cpu(int cpu)
 	if (cpumask_empty(wq_unbound_cpumask))
 		return cpu;
 
+	/*
+	 * Skip CPUs isolated by core_ctl so work queued from or aimed at
+	 * them lands on a CPU that is awake anyway.
+	 */
 	new_cpu = __this_cpu_read(wq_rr_cpu_last);
-	new_cpu = cpumask_next_and(new_cpu, wq_unbound_cpumask, cpu_online_mask);
+	do {
+		new_cpu = cpumask_next_and(new_cpu, wq_unbound_cpumask,
+					   cpu_online_mask);
+	} while (new_cpu < nr_cpu_ids && cpu_isolated(new_cpu));
 	if (unlikely(new_cpu >= nr_cpu_ids)) {
 		new_cpu = cpumask_first_and(wq_unbound_cpumask, cpu_online_mask);
+		while (new_cpu < nr_cpu_ids && cpu_isolated(new_cpu))
+			new_cpu = cpumask_next_and(new_cpu, wq_unbound_cpumask,
+						   cpu_online_mask);
 		if (unlikely(new_cpu >= nr_cpu_ids))
 			return cpu;
 	}
@@ -73,6 +73,25 @@ extern unsigned int __do_page_cache_readahead(struct address_space *mapping,
 		struct file *filp, pgoff_t offset, unsigned long nr_to_read,
 		unsigned long lookahead_size);
 
+#ifdef CONFIG_READAHEAD_PROFILE
+extern struct pid *ra_profile_pid;
+void __ra_profile_miss(struct address_space *mapping, pgoff_t index,
+		       unsigned long nr);
+
+/* Record a page cache miss while an app launch is being profiled */
+static inline void ra_profile_miss(struct address_space *mapping,
+				   pgoff_t index, unsigned long nr)
+{
+	if (unlikely(READ_ONCE(ra_profile_pid)))
+		__ra_profile_miss(mapping, index, nr);
+}
+#else
+static inline void ra_profile_miss(struct address_space *mapping,
+				   pgoff_t index, unsigned long nr)
+{
+}
+#endif
+
 /*
  * Submit IO for the read-ahead request in file_ra_state.
  */
@@ -223,6 +242,7 @@ struct compact_control {
 	bool whole_zone;		/* Whole zone should/has been scanned */
 	bool contended;			/* Signal lock or sched contention */
 	bool rescan;			/* Rescanning the same pageblock */
+	bool proactive_compaction;	/* kcompactd proactive compaction */
 };
 
 /*
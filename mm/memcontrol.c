@@ -4002,6 +4002,57 @@ static int memcg_stat_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+#ifdef CONFIG_MEMCG_WORKINGSET
+static ssize_t memcg_ws_age_write(struct kernfs_open_file *of, char *buf,
+				  size_t nbytes, loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	struct memcg_working_set *mws = &memcg->working_set;
+	unsigned long ws[2], scanned, refaults, elapsed;
+
+	if (mutex_lock_interruptible(&mws->lock))
+		return -EINTR;
+
+	mem_cgroup_age_working_set(memcg, ws, &scanned);
+	if (fatal_signal_pending(current)) {
+		mutex_unlock(&mws->lock);
+		return -EINTR;
+	}
+
+	refaults = memcg_page_state(memcg, WORKINGSET_REFAULT);
+	elapsed = jiffies - mws->last_age;
+	if (mws->last_age && elapsed)
+		mws->refault_rate = (refaults - mws->refaults) * HZ / elapsed;
+	mws->refaults = refaults;
+	mws->last_age = jiffies;
+	mws->ws[0] = ws[0];
+	mws->ws[1] = ws[1];
+	mws->scanned = scanned;
+	mutex_unlock(&mws->lock);
+
+	return nbytes;
+}
+
+static int memcg_ws_stat_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+	struct memcg_working_set *mws = &memcg->working_set;
+
+	mutex_lock(&mws->lock);
+	seq_printf(m, "ws_anon %llu\n", (u64)mws->ws[0] * PAGE_SIZE);
+	seq_printf(m, "ws_file %llu\n", (u64)mws->ws[1] * PAGE_SIZE);
+	seq_printf(m, "scanned %llu\n", (u64)mws->scanned * PAGE_SIZE);
+	seq_printf(m, "refault %lu\n",
+		   memcg_page_state(memcg, WORKINGSET_REFAULT));
+	seq_printf(m, "refault_rate %lu\n", mws->refault_rate);
+	seq_printf(m, "age_ms %u\n", mws->last_age ?
+		   jiffies_to_msecs(jiffies - mws->last_age) : 0);
+	mutex_unlock(&mws->lock);
+
+	return 0;
+}
+#endif
+
 static u64 mem_cgroup_swappiness_read(struct cgroup_subsys_state *css,
 				      struct cftype *cft)
 {
@@ -4868,6 +4919,16 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.name = "force_empty",
 		.write = mem_cgroup_force_empty_write,
 	},
+#ifdef CONFIG_MEMCG_WORKINGSET
+	{
+		.name = "ws_age",
+		.write = memcg_ws_age_write,
+	},
+	{
+		.name = "ws_stat",
+		.seq_show = memcg_ws_stat_show,
+	},
+#endif
 	{
 		.name = "use_hierarchy",
 		.write_u64 = mem_cgroup_hierarchy_write,
@@ -5149,6 +5210,9 @@ static struct mem_cgroup *mem_cgroup_alloc(void)
 	INIT_LIST_HEAD(&memcg->event_list);
 	spin_lock_init(&memcg->event_list_lock);
 	memcg->socket_pressure = jiffies;
+#ifdef CONFIG_MEMCG_WORKINGSET
+	mutex_init(&memcg->working_set.lock);
+#endif
 #ifdef CONFIG_MEMCG_KMEM
 	memcg->kmemcg_id = -1;
 #endif
@@ -6338,6 +6402,18 @@ static struct cftype memory_files[] = {
 		.flags = CFTYPE_NOT_ON_ROOT,
 		.seq_show = memory_stat_show,
 	},
+#ifdef CONFIG_MEMCG_WORKINGSET
+	{
+		.name = "ws_age",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.write = memcg_ws_age_write,
+	},
+	{
+		.name = "ws_stat",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memcg_ws_stat_show,
+	},
+#endif
 	{
 		.name = "oom.group",
 		.flags = CFTYPE_NOT_ON_ROOT | CFTYPE_NS_DELEGATABLE,
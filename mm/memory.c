@@ -4355,6 +4355,31 @@ static vm_fault_t __handle_mm_fault(struct vm_area_struct *vma,
  * hodling the mmap_sem.
  */
 
+/*
+ * Account why a speculative page fault fell back to the mmap_sem path.
+ */
+static inline int spf_abort(enum vm_event_item reason)
+{
+	count_vm_event(reason);
+	return VM_FAULT_RETRY;
+}
+
+/*
+ * File-backed mappings are only handled speculatively for read faults on
+ * page cache backed files, which is what the ART boot image, oat/vdex and
+ * APK mappings fault on during app startup. Drivers' ->fault() handlers
+ * may rely on the mmap_sem, and write faults have to go through
+ * ->page_mkwrite(), so anything else takes the regular path.
+ */
+static bool spf_file_supported(struct vm_area_struct *vma, unsigned int flags)
+{
+	if (flags & FAULT_FLAG_WRITE)
+		return false;
+
+	return vma->vm_ops && vma->vm_ops->fault &&
+		vma->vm_ops->map_pages == filemap_map_pages;
+}
+
 /*
  * Tries to handle the page fault in a speculative way, without grabbing the
  * mmap_sem.
@@ -4379,15 +4404,17 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	flags &= ~(FAULT_FLAG_ALLOW_RETRY|FAULT_FLAG_KILLABLE);
 	flags |= FAULT_FLAG_SPECULATIVE;
 
+	atomic_long_inc(&mm->spf_attempt);
+
 	*vma = get_vma(mm, address);
 	if (!*vma)
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_VMA);
 	vmf.vma = *vma;
 
 	/* rmb <-> seqlock,vma_rb_erase() */
 	seq = raw_read_seqcount(&vmf.vma->vm_sequence);
 	if (seq & 1)
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_SEQ);
 
 	/*
 	 * __anon_vma_prepare() requires the mmap_sem to be held
@@ -4399,14 +4426,17 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 			!(vmf.vma->vm_flags & VM_SHARED) &&
 			(flags & FAULT_FLAG_WRITE) &&
 			!vmf.vma->anon_vma)))
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_ANON_VMA);
+
+	if (!vma_is_anonymous(vmf.vma) && !spf_file_supported(vmf.vma, flags))
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_FILE);
 
 	vmf.vma_flags = READ_ONCE(vmf.vma->vm_flags);
 	vmf.vma_page_prot = READ_ONCE(vmf.vma->vm_page_prot);
 
 	/* Can't call userland page fault handler in the speculative path */
 	if (unlikely(vmf.vma_flags & VM_UFFD_MISSING))
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_OTHER);
 
 	if (vmf.vma_flags & VM_GROWSDOWN || vmf.vma_flags & VM_GROWSUP)
 		/*
@@ -4414,11 +4444,11 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 		 * boundaries but we want to trace it as not supported instead
 		 * of changed.
 		 */
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_OTHER);
 
 	if (address < READ_ONCE(vmf.vma->vm_start)
 	    || READ_ONCE(vmf.vma->vm_end) <= address)
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_VMA);
 
 	if (!arch_vma_access_permitted(vmf.vma, flags & FAULT_FLAG_WRITE,
 				       flags & FAULT_FLAG_INSTRUCTION,
@@ -4445,7 +4475,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 		pol = get_task_policy(current);
 	if (!pol)
 		if (pol && pol->mode == MPOL_INTERLEAVE)
-			return VM_FAULT_RETRY;
+			return spf_abort(SPECULATIVE_PGFAULT_ABORT_OTHER);
 #endif
 
 	/*
@@ -4518,7 +4548,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	 * we might have a false positive on the bounds.
 	 */
 	if (read_seqcount_retry(&vmf.vma->vm_sequence, seq))
-		return VM_FAULT_RETRY;
+		return spf_abort(SPECULATIVE_PGFAULT_ABORT_SEQ);
 
 	mem_cgroup_enter_user_fault();
 	ret = handle_pte_fault(&vmf);
@@ -4527,7 +4557,10 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 	/*
 	 * If there is no need to retry, don't return the vma to the caller.
 	 */
-	if (ret != VM_FAULT_RETRY) {
+	if (ret == VM_FAULT_RETRY) {
+		count_vm_event(SPECULATIVE_PGFAULT_ABORT_FAULT);
+	} else {
+		atomic_long_inc(&mm->spf_success);
 		check_sync_rss_stat(current);
 		if (vma_is_anonymous(vmf.vma))
 			count_vm_event(SPECULATIVE_PGFAULT_ANON);
@@ -4549,7 +4582,7 @@ int __handle_speculative_fault(struct mm_struct *mm, unsigned long address,
 
 out_walk:
 	local_irq_enable();
-	return VM_FAULT_RETRY;
+	return spf_abort(SPECULATIVE_PGFAULT_ABORT_WALK);
 
 out_segv:
 	/*
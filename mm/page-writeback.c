@@ -108,6 +108,12 @@ EXPORT_SYMBOL_GPL(dirty_writeback_interval);
  */
 unsigned int dirty_expire_interval = 30 * 100; /* centiseconds */
 
+/*
+ * The longest time background writeback is held back in a row while
+ * foreground IO on the device misses its latency target
+ */
+unsigned int dirty_defer_interval = 1 * 100; /* centiseconds */
+
 /*
  * Flag that makes the machine dump writes/reads and block dirtyings.
  */
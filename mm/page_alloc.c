@@ -76,6 +76,7 @@
 #include <asm/div64.h>
 #include "internal.h"
 #include "shuffle.h"
+#include "page_alloc_sample.h"
 
 /* prevent >1 _updater_ of zone percpu pageset ->high and ->batch fields */
 static DEFINE_MUTEX(pcp_batch_high_lock);
@@ -2877,6 +2878,87 @@ static struct list_head *get_populated_pcp_list(struct zone *zone,
 	return list;
 }
 
+#ifdef CONFIG_PCP_HIGH_ORDER
+/*
+ * High-order blocks on the pcp lists are refilled and drained in batches
+ * that hold about as many pages as an order-0 batch.
+ */
+static inline int pcp_high_order_batch(struct per_cpu_pages *pcp)
+{
+	return max(READ_ONCE(pcp->batch) >> PCP_HIGH_ORDER, 1);
+}
+
+static inline bool pcp_has_pages(struct per_cpu_pages *pcp)
+{
+	return pcp->count || pcp->high_order_count;
+}
+
+/* Return up to count high-order blocks to the buddy allocator */
+static void free_pcppages_high_order(struct zone *zone, int count,
+				     struct per_cpu_pages *pcp)
+{
+	int migratetype = 0;
+	bool isolated_pageblocks;
+	struct page *page, *tmp;
+	LIST_HEAD(head);
+
+	count = min(pcp->high_order_count, count);
+	__count_vm_events(PCP_HIGH_ORDER_DRAIN, count);
+	while (count) {
+		struct list_head *list = &pcp->high_order_lists[migratetype];
+
+		if (list_empty(list)) {
+			migratetype++;
+			continue;
+		}
+
+		page = list_last_entry(list, struct page, lru);
+		list_move_tail(&page->lru, &head);
+		pcp->high_order_count--;
+		count--;
+	}
+
+	spin_lock(&zone->lock);
+	isolated_pageblocks = has_isolate_pageblock(zone);
+
+	list_for_each_entry_safe(page, tmp, &head, lru) {
+		int mt = get_pcppage_migratetype(page);
+
+		/* Pageblock could have been isolated meanwhile */
+		if (unlikely(isolated_pageblocks))
+			mt = get_pageblock_migratetype(page);
+
+		__free_one_page(page, page_to_pfn(page), zone, PCP_HIGH_ORDER,
+				mt);
+		trace_mm_page_pcpu_drain(page, PCP_HIGH_ORDER, mt);
+	}
+	spin_unlock(&zone->lock);
+}
+
+static struct list_head *get_populated_pcp_high_order_list(struct zone *zone,
+			struct per_cpu_pages *pcp, int migratetype,
+			unsigned int alloc_flags)
+{
+	struct list_head *list = &pcp->high_order_lists[migratetype];
+
+	if (list_empty(list)) {
+		__count_vm_event(PCP_HIGH_ORDER_REFILL);
+		pcp->high_order_count += rmqueue_bulk(zone, PCP_HIGH_ORDER,
+				pcp_high_order_batch(pcp), list,
+				migratetype, alloc_flags);
+
+		if (list_empty(list))
+			list = NULL;
+	}
+	return list;
+}
+#else
+static inline bool pcp_has_pages(struct per_cpu_pages *pcp)
+{
+	return pcp->count;
+}
+#endif /* CONFIG_PCP_HIGH_ORDER */
+
 #ifdef CONFIG_NUMA
 /*
  * Called from the vmstat counter updater to drain pagesets of this
@@ -2919,6 +3001,10 @@ static void drain_pages_zone(unsigned int cpu, struct zone *zone)
 	pcp = &pset->pcp;
 	if (pcp->count)
 		free_pcppages_bulk(zone, pcp->count, pcp);
+#ifdef CONFIG_PCP_HIGH_ORDER
+	if (pcp->high_order_count)
+		free_pcppages_high_order(zone, pcp->high_order_count, pcp);
+#endif
 	local_irq_restore(flags);
 }
 
@@ -3020,12 +3106,12 @@ void drain_all_pages(struct zone *zone)
 
 		if (zone) {
 			pcp = per_cpu_ptr(zone->pageset, cpu);
-			if (pcp->pcp.count)
+			if (pcp_has_pages(&pcp->pcp))
 				has_pcps = true;
 		} else {
 			for_each_populated_zone(z) {
 				pcp = per_cpu_ptr(z->pageset, cpu);
-				if (pcp->pcp.count) {
+				if (pcp_has_pages(&pcp->pcp)) {
 					has_pcps = true;
 					break;
 				}
@@ -3151,6 +3237,48 @@ static void free_unref_page_commit(struct page *page, unsigned long pfn)
 	}
 }
 
+#ifdef CONFIG_PCP_HIGH_ORDER
+/*
+ * Free a PCP_HIGH_ORDER block. Unlike order-0 pages the block is fully
+ * checked here, so draining it needs no further checks.
+ */
+static void free_unref_page_high_order(struct page *page)
+{
+	struct zone *zone = page_zone(page);
+	unsigned long pfn = page_to_pfn(page);
+	struct per_cpu_pages *pcp;
+	unsigned long flags;
+	int migratetype;
+
+	if (!free_pages_prepare(page, PCP_HIGH_ORDER, true))
+		return;
+
+	migratetype = get_pfnblock_migratetype(page, pfn);
+	set_pcppage_migratetype(page, migratetype);
+
+	local_irq_save(flags);
+	__count_vm_events(PGFREE, 1 << PCP_HIGH_ORDER);
+
+	/* See free_unref_page_commit() */
+	if (migratetype >= MIGRATE_PCPTYPES) {
+		if (unlikely(is_migrate_isolate(migratetype))) {
+			free_one_page(zone, page, pfn, PCP_HIGH_ORDER,
+				      migratetype);
+			goto out;
+		}
+		migratetype = MIGRATE_MOVABLE;
+	}
+
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	list_add(&page->lru, &pcp->high_order_lists[migratetype]);
+	pcp->high_order_count++;
+	if (pcp->high_order_count >= 2 * pcp_high_order_batch(pcp))
+		free_pcppages_high_order(zone, pcp_high_order_batch(pcp), pcp);
+out:
+	local_irq_restore(flags);
+}
+#endif
+
 /*
  * Free a 0-order page
  */
@@ -3361,8 +3489,52 @@ static struct page *rmqueue_pcplist(struct zone *preferred_zone,
 	return page;
 }
 
+#ifdef CONFIG_PCP_HIGH_ORDER
+/* Lock and remove a PCP_HIGH_ORDER block from the per-cpu list */
+static struct page *rmqueue_pcplist_high_order(struct zone *preferred_zone,
+			struct zone *zone, gfp_t gfp_flags,
+			int migratetype, unsigned int alloc_flags)
+{
+	struct per_cpu_pages *pcp;
+	struct list_head *list;
+	struct page *page;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	pcp = &this_cpu_ptr(zone->pageset)->pcp;
+	do {
+		list = NULL;
+		/* First try to get CMA pages */
+		if (migratetype == MIGRATE_MOVABLE && gfp_flags & __GFP_CMA)
+			list = get_populated_pcp_high_order_list(zone, pcp,
+					get_cma_migrate_type(), alloc_flags);
+		if (!list)
+			list = get_populated_pcp_high_order_list(zone, pcp,
+					migratetype, alloc_flags);
+		if (!list) {
+			page = NULL;
+			break;
+		}
+
+		page = list_first_entry(list, struct page, lru);
+		list_del(&page->lru);
+		pcp->high_order_count--;
+	} while (check_new_pages(page, PCP_HIGH_ORDER));
+
+	if (page) {
+		__count_zid_vm_events(PGALLOC, page_zonenum(page),
+				      1 << PCP_HIGH_ORDER);
+		__count_vm_event(PCP_HIGH_ORDER_ALLOC);
+		zone_statistics(preferred_zone, zone);
+	}
+	local_irq_restore(flags);
+	return page;
+}
+#endif
+
 /*
- * Allocate a page from the given zone. Use pcplists for order-0 allocations.
+ * Allocate a page from the given zone. Use pcplists for order-0 allocations,
+ * and for PCP_HIGH_ORDER allocations if enabled.
  */
 static inline
 struct page *rmqueue(struct zone *preferred_zone,
@@ -3379,6 +3551,15 @@ struct page *rmqueue(struct zone *preferred_zone,
 		goto out;
 	}
 
+#ifdef CONFIG_PCP_HIGH_ORDER
+	if (order == PCP_HIGH_ORDER && !(alloc_flags & ALLOC_HARDER)) {
+		page = rmqueue_pcplist_high_order(preferred_zone, zone,
+					gfp_flags, migratetype, alloc_flags);
+		if (page)
+			goto out;
+	}
+#endif
+
 	/*
 	 * We most definitely don't want callers attempting to
 	 * allocate greater than order-1 page units with __GFP_NOFAIL.
@@ -4887,6 +5068,7 @@ __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order, int preferred_nid,
 	unsigned int alloc_flags = ALLOC_WMARK_LOW;
 	gfp_t alloc_mask; /* The gfp_t that was actually used for allocation */
 	struct alloc_context ac = { };
+	struct alloc_sample as;
 
 	/*
 	 * There are several places where we assume that the order value is sane
@@ -4903,6 +5085,7 @@ __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order, int preferred_nid,
 		return NULL;
 
 	finalise_ac(gfp_mask, &ac);
+	page_alloc_sample_begin(&as);
 
 	/*
 	 * Forbid the first pass from falling back to types that fragment
@@ -4931,6 +5114,7 @@ __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order, int preferred_nid,
 	if (unlikely(ac.nodemask != nodemask))
 		ac.nodemask = nodemask;
 
+	page_alloc_sample_slowpath(&as);
 	page = __alloc_pages_slowpath(alloc_mask, order, &ac);
 
 out:
@@ -4940,6 +5124,7 @@ __alloc_pages_nodemask(gfp_t gfp_mask, unsigned int order, int preferred_nid,
 		page = NULL;
 	}
 
+	page_alloc_sample_end(&as, gfp_mask, order, page);
 	trace_mm_page_alloc(page, order, alloc_mask, ac.migratetype);
 
 	return page;
@@ -4972,6 +5157,10 @@ static inline void free_the_page(struct page *page, unsigned int order)
 {
 	if (order == 0)		/* Via pcp? */
 		free_unref_page(page);
+#ifdef CONFIG_PCP_HIGH_ORDER
+	else if (order == PCP_HIGH_ORDER)
+		free_unref_page_high_order(page);
+#endif
 	else
 		__free_pages_ok(page, order);
 }
@@ -6294,6 +6483,10 @@ static void pageset_init(struct per_cpu_pageset *p)
 	pcp = &p->pcp;
 	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
 		INIT_LIST_HEAD(&pcp->lists[migratetype]);
+#ifdef CONFIG_PCP_HIGH_ORDER
+	for (migratetype = 0; migratetype < MIGRATE_PCPTYPES; migratetype++)
+		INIT_LIST_HEAD(&pcp->high_order_lists[migratetype]);
+#endif
 }
 
 static void setup_pageset(struct per_cpu_pageset *p, unsigned long batch)
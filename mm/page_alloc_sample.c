@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Sampled page allocation latency
+ *
+ * page_owner keeps a stack for every page, which is too expensive outside
+ * of debug builds. This only looks at a sample of allocations: every Nth
+ * one on each CPU, and every one whose slow path took longer than a
+ * threshold. A sample records the order, gfp flags, latency and stack in
+ * a bounded ring, and is folded into a per call stack summary that shows
+ * which callers allocate high orders and which of them stall.
+ *
+ * Interface, <debugfs>/page_alloc_sample/:
+ *   every     - sample every Nth allocation per CPU, 0 disables
+ *   slow_us   - sample allocations slower than this, 0 disables
+ *   min_order - ignore allocations below this order
+ *   samples   - the most recent samples, oldest first
+ *   callsites - per stack count, slow count, latency and highest order
+ * Writing anything to samples or callsites clears both.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/gfp.h>
+#include <linux/jhash.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/stacktrace.h>
+
+#include "page_alloc_sample.h"
+
+#define SAMPLE_STACK_DEPTH	12
+#define SAMPLE_RING_SIZE	512
+#define SAMPLE_SITES		256
+#define SAMPLE_SITE_OTHER	SAMPLE_SITES
+
+struct alloc_sample_site {
+	u32 hash;
+	unsigned int nr_entries;
+	unsigned long entries[SAMPLE_STACK_DEPTH];
+	unsigned long count;
+	unsigned long slow;
+	unsigned int max_order;
+	u64 total_ns;
+	u64 max_ns;
+};
+
+struct alloc_sample_rec {
+	u64 ts;
+	u64 latency_ns;
+	gfp_t gfp_mask;
+	unsigned short order;
+	unsigned short site;
+	bool failed;
+	pid_t pid;
+	char comm[TASK_COMM_LEN];
+};
+
+DEFINE_STATIC_KEY_FALSE(page_alloc_sample_key);
+DEFINE_PER_CPU(unsigned int, page_alloc_sample_count);
+unsigned int page_alloc_sample_every;
+static unsigned int page_alloc_sample_slow_us;
+static unsigned int page_alloc_sample_min_order;
+static DEFINE_MUTEX(page_alloc_sample_mutex);
+
+static DEFINE_SPINLOCK(sample_lock);
+static struct alloc_sample_site sample_sites[SAMPLE_SITES + 1];
+static struct alloc_sample_rec sample_ring[SAMPLE_RING_SIZE];
+static unsigned long sample_head;
+
+static unsigned int sample_site_get(unsigned long *entries,
+				    unsigned int nr_entries)
+{
+	u32 hash = jhash(entries, nr_entries * sizeof(*entries), 0);
+	struct alloc_sample_site *site;
+	unsigned int i, idx;
+
+	for (i = 0; i < SAMPLE_SITES; i++) {
+		idx = (hash + i) % SAMPLE_SITES;
+		site = &sample_sites[idx];
+
+		if (!site->nr_entries) {
+			site->hash = hash;
+			site->nr_entries = nr_entries;
+			memcpy(site->entries, entries,
+			       nr_entries * sizeof(*entries));
+			return idx;
+		}
+		if (site->hash == hash && site->nr_entries == nr_entries &&
+		    !memcmp(site->entries, entries,
+			    nr_entries * sizeof(*entries)))
+			return idx;
+	}
+
+	return SAMPLE_SITE_OTHER;
+}
+
+void __page_alloc_sample(struct alloc_sample *as, gfp_t gfp_mask,
+			 unsigned int order, struct page *page)
+{
+	u64 latency = local_clock() - as->start;
+	unsigned int slow_us = READ_ONCE(page_alloc_sample_slow_us);
+	bool slow = slow_us && latency >= (u64)slow_us * NSEC_PER_USEC;
+	unsigned long entries[SAMPLE_STACK_DEPTH];
+	struct alloc_sample_site *site;
+	struct alloc_sample_rec *rec;
+	unsigned int nr_entries, idx;
+	unsigned long flags;
+
+	if (!as->nth && !slow)
+		return;
+	if (order < READ_ONCE(page_alloc_sample_min_order))
+		return;
+
+	/* Skip this function and the allocator entry */
+	nr_entries = stack_trace_save(entries, ARRAY_SIZE(entries), 2);
+
+	spin_lock_irqsave(&sample_lock, flags);
+	idx = sample_site_get(entries, nr_entries);
+	site = &sample_sites[idx];
+	site->count++;
+	if (slow)
+		site->slow++;
+	site->max_order = max(site->max_order, order);
+	site->total_ns += latency;
+	site->max_ns = max(site->max_ns, latency);
+
+	rec = &sample_ring[sample_head++ % SAMPLE_RING_SIZE];
+	rec->ts = as->start;
+	rec->latency_ns = latency;
+	rec->gfp_mask = gfp_mask;
+	rec->order = order;
+	rec->site = idx;
+	rec->failed = !page;
+	rec->pid = current->pid;
+	memcpy(rec->comm, current->comm, TASK_COMM_LEN);
+	spin_unlock_irqrestore(&sample_lock, flags);
+}
+
+static void sample_update_key(void)
+{
+	if (page_alloc_sample_every || page_alloc_sample_slow_us)
+		static_branch_enable(&page_alloc_sample_key);
+	else
+		static_branch_disable(&page_alloc_sample_key);
+}
+
+static int sample_every_set(void *data, u64 val)
+{
+	mutex_lock(&page_alloc_sample_mutex);
+	WRITE_ONCE(page_alloc_sample_every, val);
+	sample_update_key();
+	mutex_unlock(&page_alloc_sample_mutex);
+
+	return 0;
+}
+
+static int sample_every_get(void *data, u64 *val)
+{
+	*val = page_alloc_sample_every;
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(sample_every_fops, sample_every_get,
+			 sample_every_set, "%llu\n");
+
+static int sample_slow_set(void *data, u64 val)
+{
+	mutex_lock(&page_alloc_sample_mutex);
+	WRITE_ONCE(page_alloc_sample_slow_us, val);
+	sample_update_key();
+	mutex_unlock(&page_alloc_sample_mutex);
+
+	return 0;
+}
+
+static int sample_slow_get(void *data, u64 *val)
+{
+	*val = page_alloc_sample_slow_us;
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(sample_slow_fops, sample_slow_get,
+			 sample_slow_set, "%llu\n");
+
+/*
+ * The readers copy one entry at a time under the lock so that sampling
+ * is never held off for the duration of a read.
+ */
+static int samples_show(struct seq_file *m, void *v)
+{
+	struct alloc_sample_rec rec;
+	unsigned long head, i;
+
+	spin_lock_irq(&sample_lock);
+	head = sample_head;
+	spin_unlock_irq(&sample_lock);
+
+	i = head > SAMPLE_RING_SIZE ? head - SAMPLE_RING_SIZE : 0;
+	for (; i < head; i++) {
+		spin_lock_irq(&sample_lock);
+		rec = sample_ring[i % SAMPLE_RING_SIZE];
+		spin_unlock_irq(&sample_lock);
+
+		seq_printf(m, "%llu pid=%d comm=%s order=%u gfp=%#x(%pGg) latency_us=%llu site=%u%s\n",
+			   rec.ts, rec.pid, rec.comm, rec.order,
+			   rec.gfp_mask, &rec.gfp_mask,
+			   div_u64(rec.latency_ns, NSEC_PER_USEC), rec.site,
+			   rec.failed ? " failed" : "");
+	}
+
+	return 0;
+}
+
+static int callsites_show(struct seq_file *m, void *v)
+{
+	struct alloc_sample_site site;
+	unsigned int i, j;
+
+	for (i = 0; i <= SAMPLE_SITES; i++) {
+		spin_lock_irq(&sample_lock);
+		site = sample_sites[i];
+		spin_unlock_irq(&sample_lock);
+
+		if (!site.count)
+			continue;
+
+		seq_printf(m, "site=%u count=%lu slow=%lu max_order=%u avg_us=%llu max_us=%llu\n",
+			   i, site.count, site.slow, site.max_order,
+			   div64_u64(site.total_ns,
+				     (u64)site.count * NSEC_PER_USEC),
+			   div_u64(site.max_ns, NSEC_PER_USEC));
+		if (i == SAMPLE_SITE_OTHER)
+			seq_puts(m, "  <other>\n");
+		for (j = 0; j < site.nr_entries; j++)
+			seq_printf(m, "  %pS\n", (void *)site.entries[j]);
+	}
+
+	return 0;
+}
+
+static ssize_t sample_clear_write(struct file *file, const char __user *ubuf,
+				  size_t count, loff_t *ppos)
+{
+	spin_lock_irq(&sample_lock);
+	memset(sample_sites, 0, sizeof(sample_sites));
+	memset(sample_ring, 0, sizeof(sample_ring));
+	sample_head = 0;
+	spin_unlock_irq(&sample_lock);
+
+	return count;
+}
+
+static int samples_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, samples_show, NULL);
+}
+
+static int callsites_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, callsites_show, NULL);
+}
+
+static const struct file_operations samples_fops = {
+	.open		= samples_open,
+	.read		= seq_read,
+	.write		= sample_clear_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static const struct file_operations callsites_fops = {
+	.open		= callsites_open,
+	.read		= seq_read,
+	.write		= sample_clear_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init page_alloc_sample_init(void)
+{
+	struct dentry *dir;
+
+	dir = debugfs_create_dir("page_alloc_sample", NULL);
+	debugfs_create_file_unsafe("every", 0600, dir, NULL,
+				   &sample_every_fops);
+	debugfs_create_file_unsafe("slow_us", 0600, dir, NULL,
+				   &sample_slow_fops);
+	debugfs_create_u32("min_order", 0600, dir,
+			   &page_alloc_sample_min_order);
+	debugfs_create_file("samples", 0600, dir, NULL, &samples_fops);
+	debugfs_create_file("callsites", 0600, dir, NULL, &callsites_fops);
+
+	return 0;
+}
+late_initcall(page_alloc_sample_init);
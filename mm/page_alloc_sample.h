@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _MM_PAGE_ALLOC_SAMPLE_H
+#define _MM_PAGE_ALLOC_SAMPLE_H
+#include <linux/jump_label.h>
+#include <linux/percpu.h>
+#include <linux/sched/clock.h>
+
+/*
+ * An allocation is sampled either because it is the Nth one on its CPU,
+ * in which case it is timed from the start, or because it entered the
+ * slow path, which is always timed while sampling is on and recorded if
+ * it took longer than the threshold.
+ */
+struct alloc_sample {
+	u64 start;
+	bool nth;
+};
+
+#ifdef CONFIG_PAGE_ALLOC_SAMPLE
+DECLARE_STATIC_KEY_FALSE(page_alloc_sample_key);
+DECLARE_PER_CPU(unsigned int, page_alloc_sample_count);
+extern unsigned int page_alloc_sample_every;
+extern void __page_alloc_sample(struct alloc_sample *as, gfp_t gfp_mask,
+				unsigned int order, struct page *page);
+
+static __always_inline void page_alloc_sample_begin(struct alloc_sample *as)
+{
+	unsigned int every;
+
+	as->start = 0;
+	as->nth = false;
+	if (!static_branch_unlikely(&page_alloc_sample_key))
+		return;
+
+	every = READ_ONCE(page_alloc_sample_every);
+	if (every && !(this_cpu_inc_return(page_alloc_sample_count) % every)) {
+		as->nth = true;
+		as->start = local_clock();
+	}
+}
+
+static __always_inline void page_alloc_sample_slowpath(struct alloc_sample *as)
+{
+	if (static_branch_unlikely(&page_alloc_sample_key) && !as->start)
+		as->start = local_clock();
+}
+
+static __always_inline void page_alloc_sample_end(struct alloc_sample *as,
+						  gfp_t gfp_mask,
+						  unsigned int order,
+						  struct page *page)
+{
+	if (unlikely(as->start))
+		__page_alloc_sample(as, gfp_mask, order, page);
+}
+#else
+static inline void page_alloc_sample_begin(struct alloc_sample *as)
+{
+}
+
+static inline void page_alloc_sample_slowpath(struct alloc_sample *as)
+{
+}
+
+static inline void page_alloc_sample_end(struct alloc_sample *as,
+					 gfp_t gfp_mask, unsigned int order,
+					 struct page *page)
+{
+}
+#endif
+#endif /* _MM_PAGE_ALLOC_SAMPLE_H */
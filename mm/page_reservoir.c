@@ -0,0 +1,441 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Reservoir of pre-zeroed, cache-clean pages for device allocators
+ *
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * GPU and ION allocations must hand zeroed memory to non-coherent devices,
+ * so every page taken from the buddy allocator is cleared and cleaned out
+ * of the CPU caches in the allocating thread. For large buffers allocated
+ * at scene transitions this costs several milliseconds. The reservoir does
+ * that work ahead of time from a SCHED_IDLE kthread, which only runs when
+ * the CPUs have nothing else to do, and stops refilling while the CPUs are
+ * thermally limited or memory is low.
+ */
+
+#define pr_fmt(fmt) "page_reservoir: " fmt
+
+#include <linux/cpufreq.h>
+#include <linux/dma-noncoherent.h>
+#include <linux/freezer.h>
+#include <linux/highmem.h>
+#include <linux/kthread.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/page_reservoir.h>
+#include <linux/sched.h>
+#include <linux/shrinker.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+#include <linux/vmstat.h>
+#include <linux/wait.h>
+#include <uapi/linux/sched/types.h>
+
+#include "internal.h"
+
+/* Refill is held off for this long after the shrinker took pages back */
+#define RESERVOIR_SHRINK_BACKOFF	(2 * HZ)
+/* Retry interval while refill is not allowed */
+#define RESERVOIR_RETRY_INTERVAL	(HZ / 2)
+/* Wake the refill thread once a reservoir drops below this percentage */
+#define RESERVOIR_LOW_PCT		50
+
+static const unsigned int reservoir_orders[] = {8, 4, 0};
+#define NR_RESERVOIR_ORDERS ARRAY_SIZE(reservoir_orders)
+
+/**
+ * struct page_reservoir - Zeroed pages of a single order
+ * @order: Order of the pages held here
+ * @lock: Protects @pages and @count
+ * @pages: List of zeroed and cleaned non-compound pages
+ * @count: Number of entries on @pages
+ * @target: Number of entries the refill thread tries to keep
+ */
+struct page_reservoir {
+	unsigned int order;
+	spinlock_t lock;
+	struct list_head pages;
+	unsigned int count;
+	unsigned int target;
+};
+
+static struct page_reservoir reservoirs[NR_RESERVOIR_ORDERS];
+
+static unsigned long reservoir_target_kb = CONFIG_PAGE_RESERVOIR_KB;
+static unsigned long reservoir_last_shrink;
+static atomic_long_t reservoir_hits = ATOMIC_LONG_INIT(0);
+static atomic_long_t reservoir_misses = ATOMIC_LONG_INIT(0);
+
+static DECLARE_WAIT_QUEUE_HEAD(reservoir_wait);
+static struct task_struct *reservoir_thread;
+
+static struct page_reservoir *reservoir_for_order(unsigned int order)
+{
+	int i;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++)
+		if (reservoirs[i].order == order)
+			return &reservoirs[i];
+
+	return NULL;
+}
+
+/* Split the total target evenly in bytes across the orders */
+static void reservoir_set_targets(unsigned long target_kb)
+{
+	unsigned long per_order = (target_kb << 10) / NR_RESERVOIR_ORDERS;
+	int i;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++)
+		WRITE_ONCE(reservoirs[i].target,
+			per_order / (PAGE_SIZE << reservoirs[i].order));
+}
+
+static bool reservoir_below(struct page_reservoir *res, unsigned int pct)
+{
+	return READ_ONCE(res->count) * 100 < READ_ONCE(res->target) * pct;
+}
+
+static bool reservoir_needs_refill(void)
+{
+	int i;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++)
+		if (reservoir_below(&reservoirs[i], 100))
+			return true;
+
+	return false;
+}
+
+static bool reservoir_thermal_limited(void)
+{
+	struct cpufreq_policy *policy;
+	bool limited = false;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		policy = cpufreq_cpu_get(cpu);
+		if (!policy)
+			continue;
+
+		limited = policy->max < policy->cpuinfo.max_freq;
+		/* Skip the remaining CPUs of this policy */
+		cpu = cpumask_last(policy->related_cpus);
+		cpufreq_cpu_put(policy);
+
+		if (limited)
+			break;
+	}
+
+	return limited;
+}
+
+/*
+ * Don't let a refill push any zone below its high watermark, it would
+ * only wake kswapd to take the pages straight back.
+ */
+static bool reservoir_watermark_ok(unsigned int order)
+{
+	enum zone_type classzone_idx = gfp_zone(GFP_HIGHUSER);
+	struct zonelist *zonelist;
+	struct zoneref *z;
+	struct zone *zone;
+
+	zonelist = node_zonelist(numa_node_id(), GFP_HIGHUSER);
+	for_each_zone_zonelist(zone, z, zonelist, classzone_idx) {
+		unsigned long mark = high_wmark_pages(zone) + (1 << order);
+
+		if (!zone_watermark_ok_safe(zone, order, mark, classzone_idx))
+			return false;
+	}
+
+	return true;
+}
+
+static bool reservoir_refill_ok(void)
+{
+	if (time_before(jiffies, READ_ONCE(reservoir_last_shrink) +
+			RESERVOIR_SHRINK_BACKOFF))
+		return false;
+
+	return !reservoir_thermal_limited();
+}
+
+static void reservoir_add(struct page_reservoir *res, struct page *page)
+{
+	spin_lock(&res->lock);
+	list_add_tail(&page->lru, &res->pages);
+	res->count++;
+	spin_unlock(&res->lock);
+
+	mod_node_page_state(page_pgdat(page), NR_KERNEL_MISC_RECLAIMABLE,
+			1 << res->order);
+}
+
+static struct page *reservoir_remove(struct page_reservoir *res)
+{
+	struct page *page;
+
+	spin_lock(&res->lock);
+	page = list_first_entry_or_null(&res->pages, struct page, lru);
+	if (page) {
+		list_del(&page->lru);
+		res->count--;
+	}
+	spin_unlock(&res->lock);
+
+	if (page)
+		mod_node_page_state(page_pgdat(page),
+				NR_KERNEL_MISC_RECLAIMABLE, -(1 << res->order));
+
+	return page;
+}
+
+/* Add a single zeroed page to @res, returns false if none could be had */
+static bool reservoir_refill_one(struct page_reservoir *res)
+{
+	gfp_t gfp = (GFP_HIGHUSER | __GFP_NOWARN | __GFP_NORETRY) &
+			~__GFP_DIRECT_RECLAIM;
+	struct page *page;
+	int i;
+
+	if (!reservoir_watermark_ok(res->order))
+		return false;
+
+	page = alloc_pages(gfp, res->order);
+	if (!page)
+		return false;
+
+	for (i = 0; i < (1 << res->order); i++)
+		clear_highpage(nth_page(page, i));
+
+	arch_dma_prep_coherent(page, PAGE_SIZE << res->order);
+
+	reservoir_add(res, page);
+	return true;
+}
+
+static int page_reservoir_thread(void *data)
+{
+	set_freezable();
+
+	while (!kthread_should_stop()) {
+		bool progress = false;
+		int i;
+
+		wait_event_freezable(reservoir_wait,
+			reservoir_needs_refill() || kthread_should_stop());
+
+		if (kthread_should_stop())
+			break;
+
+		if (!reservoir_refill_ok()) {
+			schedule_timeout_interruptible(RESERVOIR_RETRY_INTERVAL);
+			continue;
+		}
+
+		/* Round robin so that every order makes progress */
+		for (i = 0; i < NR_RESERVOIR_ORDERS; i++) {
+			struct page_reservoir *res = &reservoirs[i];
+
+			if (reservoir_below(res, 100) &&
+					reservoir_refill_one(res))
+				progress = true;
+		}
+
+		if (!progress)
+			schedule_timeout_interruptible(RESERVOIR_RETRY_INTERVAL);
+		else
+			cond_resched();
+	}
+
+	return 0;
+}
+
+struct page *page_reservoir_alloc(unsigned int order, gfp_t gfp_mask)
+{
+	struct page_reservoir *res = reservoir_for_order(order);
+	struct page *page;
+
+	if (!res || !READ_ONCE(res->target))
+		return NULL;
+
+	page = reservoir_remove(res);
+
+	if (reservoir_below(res, RESERVOIR_LOW_PCT))
+		wake_up(&reservoir_wait);
+
+	if (page && !(gfp_mask & __GFP_HIGHMEM) && PageHighMem(page)) {
+		reservoir_add(res, page);
+		page = NULL;
+	}
+
+	if (!page) {
+		atomic_long_inc(&reservoir_misses);
+		return NULL;
+	}
+
+	if (order && (gfp_mask & __GFP_COMP))
+		prep_compound_page(page, order);
+
+	atomic_long_inc(&reservoir_hits);
+	return page;
+}
+EXPORT_SYMBOL_GPL(page_reservoir_alloc);
+
+static unsigned long reservoir_total_pages(void)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++)
+		total += (unsigned long)READ_ONCE(reservoirs[i].count) <<
+				reservoirs[i].order;
+
+	return total;
+}
+
+/* Release down to @nr_pages base pages, starting with the largest order */
+static unsigned long reservoir_release(unsigned long nr_pages)
+{
+	unsigned long freed = 0;
+	int i;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS && freed < nr_pages; i++) {
+		struct page_reservoir *res = &reservoirs[i];
+		struct page *page;
+
+		while (freed < nr_pages && (page = reservoir_remove(res))) {
+			__free_pages(page, res->order);
+			freed += 1 << res->order;
+		}
+	}
+
+	return freed;
+}
+
+static unsigned long reservoir_shrink_count(struct shrinker *shrinker,
+					    struct shrink_control *sc)
+{
+	return reservoir_total_pages();
+}
+
+static unsigned long reservoir_shrink_scan(struct shrinker *shrinker,
+					   struct shrink_control *sc)
+{
+	WRITE_ONCE(reservoir_last_shrink, jiffies);
+
+	return reservoir_release(sc->nr_to_scan);
+}
+
+static struct shrinker reservoir_shrinker = {
+	.count_objects = reservoir_shrink_count,
+	.scan_objects = reservoir_shrink_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+#ifdef CONFIG_SYSFS
+static ssize_t target_kb_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", READ_ONCE(reservoir_target_kb));
+}
+
+static ssize_t target_kb_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	unsigned long target_kb;
+	int i;
+
+	if (kstrtoul(buf, 10, &target_kb))
+		return -EINVAL;
+
+	WRITE_ONCE(reservoir_target_kb, target_kb);
+	reservoir_set_targets(target_kb);
+
+	/* Give back whatever is now above the new targets */
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++) {
+		struct page_reservoir *res = &reservoirs[i];
+		struct page *page;
+
+		while (READ_ONCE(res->count) > READ_ONCE(res->target) &&
+				(page = reservoir_remove(res)))
+			__free_pages(page, res->order);
+	}
+
+	wake_up(&reservoir_wait);
+
+	return count;
+}
+static struct kobj_attribute target_kb_attr = __ATTR_RW(target_kb);
+
+static ssize_t pages_show(struct kobject *kobj,
+			  struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", reservoir_total_pages());
+}
+static struct kobj_attribute pages_attr = __ATTR_RO(pages);
+
+static ssize_t hits_show(struct kobject *kobj,
+			 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%ld\n", atomic_long_read(&reservoir_hits));
+}
+static struct kobj_attribute hits_attr = __ATTR_RO(hits);
+
+static ssize_t misses_show(struct kobject *kobj,
+			   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%ld\n", atomic_long_read(&reservoir_misses));
+}
+static struct kobj_attribute misses_attr = __ATTR_RO(misses);
+
+static struct attribute *reservoir_attrs[] = {
+	&target_kb_attr.attr,
+	&pages_attr.attr,
+	&hits_attr.attr,
+	&misses_attr.attr,
+	NULL,
+};
+
+static const struct attribute_group reservoir_attr_group = {
+	.attrs = reservoir_attrs,
+	.name = "page_reservoir",
+};
+#endif /* CONFIG_SYSFS */
+
+static int __init page_reservoir_init(void)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	int i, err;
+
+	for (i = 0; i < NR_RESERVOIR_ORDERS; i++) {
+		reservoirs[i].order = reservoir_orders[i];
+		spin_lock_init(&reservoirs[i].lock);
+		INIT_LIST_HEAD(&reservoirs[i].pages);
+	}
+	reservoir_set_targets(reservoir_target_kb);
+
+	err = register_shrinker(&reservoir_shrinker);
+	if (err)
+		return err;
+
+#ifdef CONFIG_SYSFS
+	err = sysfs_create_group(mm_kobj, &reservoir_attr_group);
+	if (err)
+		pr_err("register sysfs failed\n");
+#endif
+
+	reservoir_thread = kthread_run(page_reservoir_thread, NULL,
+			"page_reservoird");
+	if (IS_ERR(reservoir_thread)) {
+		pr_err("creating kthread failed\n");
+		return PTR_ERR(reservoir_thread);
+	}
+
+	sched_setscheduler_nocheck(reservoir_thread, SCHED_IDLE, &param);
+
+	return 0;
+}
+late_initcall(page_reservoir_init);
@@ -0,0 +1,421 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Profile-guided readahead for app launch
+ *
+ * The readahead window ramps up slowly for the random access pattern of
+ * mmap'd APK and OAT files, so a cold app launch spends much of its time
+ * in single page reads. While a launch is recorded, every page cache miss
+ * of the recorded process is logged as a (file, range) entry. Userspace
+ * reads the profile back and stores it with the app. On a later launch it
+ * writes the profile back, and the recorded ranges are read ahead as
+ * merged asynchronous reads before the app faults on them.
+ *
+ * Interface, /sys/kernel/mm/ra_profile/:
+ *   record  - write a pid to record its thread group, 0 to stop
+ *   profile - read: the recorded profile, sorted and merged
+ *             write: entries to read ahead
+ * Both use arrays of struct ra_profile_entry. The inode number, generation
+ * and byte range match F2FS_IOC_RA_HINTS, so a profile of f2fs files can
+ * be replayed through f2fs as well.
+ */
+
+#define pr_fmt(fmt) "ra_profile: " fmt
+
+#include <linux/blkdev.h>
+#include <linux/exportfs.h>
+#include <linux/fs.h>
+#include <linux/kdev_t.h>
+#include <linux/mm.h>
+#include <linux/pagemap.h>
+#include <linux/pid.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+
+#include "internal.h"
+
+#define RA_PROFILE_MAX_ENTRIES	8192
+/* Recent entries checked for a range the new miss extends */
+#define RA_PROFILE_MERGE_LOOKBACK	8
+/* Size of a single readahead call while replaying */
+#define RA_PROFILE_CHUNK	((2 * 1024 * 1024) / PAGE_SIZE)
+
+/**
+ * struct ra_profile_entry - A range of a file missed in the page cache
+ * @ino:	Inode number
+ * @generation:	i_generation of the inode, 0 to not check it on replay
+ * @start:	Start of the range in bytes
+ * @len:	Length of the range in bytes
+ * @dev:	Device of the file system, new_encode_dev() format
+ * @flags:	Must be zero
+ */
+struct ra_profile_entry {
+	u32 ino;
+	u32 generation;
+	u64 start;
+	u64 len;
+	u32 dev;
+	u32 flags;
+};
+
+/* The thread group being recorded, only compared and never dereferenced */
+struct pid *ra_profile_pid __read_mostly;
+
+static DEFINE_MUTEX(ra_profile_mutex);
+static DEFINE_SPINLOCK(ra_profile_lock);
+static struct ra_profile_entry *ra_profile;
+static unsigned int ra_profile_nr;
+
+void __ra_profile_miss(struct address_space *mapping, pgoff_t index,
+		       unsigned long nr)
+{
+	struct inode *inode = mapping->host;
+	struct ra_profile_entry *e;
+	u64 start, end;
+	u32 dev;
+	int i;
+
+	if (task_tgid(current) != READ_ONCE(ra_profile_pid))
+		return;
+
+	/* Only files that can be found again by inode number on replay */
+	if (!S_ISREG(inode->i_mode) || !inode->i_sb->s_export_op ||
+	    !inode->i_sb->s_bdev)
+		return;
+
+	dev = new_encode_dev(inode->i_sb->s_dev);
+	start = (u64)index << PAGE_SHIFT;
+	end = start + ((u64)nr << PAGE_SHIFT);
+
+	spin_lock(&ra_profile_lock);
+	/* Recording may have stopped meanwhile, the profile is being sorted */
+	if (!ra_profile || task_tgid(current) != ra_profile_pid)
+		goto unlock;
+
+	for (i = ra_profile_nr - 1;
+	     i >= 0 && i >= (int)ra_profile_nr - RA_PROFILE_MERGE_LOOKBACK;
+	     i--) {
+		e = &ra_profile[i];
+		if (e->ino != inode->i_ino || e->dev != dev)
+			continue;
+		if (end < e->start || start > e->start + e->len)
+			continue;
+
+		end = max(end, e->start + e->len);
+		e->start = min(start, e->start);
+		e->len = end - e->start;
+		goto unlock;
+	}
+
+	if (ra_profile_nr == RA_PROFILE_MAX_ENTRIES)
+		goto unlock;
+
+	e = &ra_profile[ra_profile_nr++];
+	e->ino = inode->i_ino;
+	e->generation = inode->i_generation;
+	e->start = start;
+	e->len = end - start;
+	e->dev = dev;
+	e->flags = 0;
+unlock:
+	spin_unlock(&ra_profile_lock);
+}
+
+static int ra_profile_cmp(const void *a, const void *b)
+{
+	const struct ra_profile_entry *ea = a, *eb = b;
+
+	if (ea->dev != eb->dev)
+		return ea->dev < eb->dev ? -1 : 1;
+	if (ea->ino != eb->ino)
+		return ea->ino < eb->ino ? -1 : 1;
+	if (ea->start != eb->start)
+		return ea->start < eb->start ? -1 : 1;
+	return 0;
+}
+
+/* Sort the profile by file and offset, and merge overlapping ranges. */
+static void ra_profile_finish(void)
+{
+	struct ra_profile_entry *prev = NULL, *e;
+	unsigned int i, nr = 0;
+
+	sort(ra_profile, ra_profile_nr, sizeof(*ra_profile), ra_profile_cmp,
+	     NULL);
+
+	for (i = 0; i < ra_profile_nr; i++) {
+		e = &ra_profile[i];
+		if (prev && prev->dev == e->dev && prev->ino == e->ino &&
+		    e->start <= prev->start + prev->len) {
+			prev->len = max(prev->len,
+					e->start + e->len - prev->start);
+			continue;
+		}
+		prev = &ra_profile[nr++];
+		*prev = *e;
+	}
+	ra_profile_nr = nr;
+}
+
+static int ra_profile_start(pid_t nr)
+{
+	struct ra_profile_entry *buf;
+	struct pid *pid;
+
+	pid = find_get_pid(nr);
+	if (!pid)
+		return -ESRCH;
+
+	buf = kvmalloc_array(RA_PROFILE_MAX_ENTRIES, sizeof(*buf), GFP_KERNEL);
+	if (!buf) {
+		put_pid(pid);
+		return -ENOMEM;
+	}
+
+	spin_lock(&ra_profile_lock);
+	swap(ra_profile, buf);
+	ra_profile_nr = 0;
+	spin_unlock(&ra_profile_lock);
+	kvfree(buf);
+
+	WRITE_ONCE(ra_profile_pid, pid);
+
+	return 0;
+}
+
+static void ra_profile_stop(void)
+{
+	struct pid *pid = ra_profile_pid;
+
+	if (!pid)
+		return;
+
+	/* Misses in flight see the cleared pid once they take the lock */
+	spin_lock(&ra_profile_lock);
+	WRITE_ONCE(ra_profile_pid, NULL);
+	spin_unlock(&ra_profile_lock);
+	put_pid(pid);
+
+	ra_profile_finish();
+	pr_info("recorded %u ranges\n", ra_profile_nr);
+}
+
+static void ra_profile_readahead(struct address_space *mapping, pgoff_t index,
+				 unsigned long nr)
+{
+	unsigned long chunk;
+
+	while (nr) {
+		chunk = min_t(unsigned long, nr, RA_PROFILE_CHUNK);
+		__do_page_cache_readahead(mapping, NULL, index, chunk, 0);
+		index += chunk;
+		nr -= chunk;
+	}
+}
+
+static struct dentry *ra_profile_get_dentry(struct super_block *sb,
+					    struct ra_profile_entry *e)
+{
+	const struct export_operations *ops = sb->s_export_op;
+	struct fid fid;
+
+	if (!ops || !ops->fh_to_dentry)
+		return ERR_PTR(-EOPNOTSUPP);
+
+	fid.i32.ino = e->ino;
+	fid.i32.gen = e->generation;
+	fid.i32.parent_ino = 0;
+
+	return ops->fh_to_dentry(sb, &fid, 2, FILEID_INO32_GEN);
+}
+
+/*
+ * Read ahead the ranges of a profile. Consecutive entries of the same file
+ * share the inode lookup, and overlapping or adjacent ones are merged into
+ * a single read. Pages already in the page cache are skipped, as are files
+ * that no longer exist or whose inode number has been reused.
+ */
+static void ra_profile_replay(struct ra_profile_entry *ents, unsigned int nr)
+{
+	struct super_block *sb = NULL;
+	struct dentry *dentry = NULL;
+	struct address_space *mapping = NULL;
+	u32 dev = 0, ino = 0;
+	pgoff_t start = 0, end = 0;
+	bool pending = false;
+	unsigned int i;
+
+	for (i = 0; i <= nr; i++) {
+		struct ra_profile_entry *e = i < nr ? &ents[i] : NULL;
+		pgoff_t s, n;
+
+		if (e && (e->flags || !e->len || e->start + e->len < e->start))
+			continue;
+
+		s = e ? e->start >> PAGE_SHIFT : 0;
+		n = e ? (e->start + e->len - 1) >> PAGE_SHIFT : 0;
+
+		if (pending && e && e->dev == dev && e->ino == ino &&
+		    s <= end + 1) {
+			end = max(end, n);
+			continue;
+		}
+
+		if (pending && mapping)
+			ra_profile_readahead(mapping, start, end - start + 1);
+		pending = false;
+
+		if (!e)
+			break;
+
+		if (!sb || e->dev != dev) {
+			struct block_device *bdev;
+
+			if (dentry)
+				dput(dentry);
+			dentry = NULL;
+			if (sb)
+				drop_super(sb);
+			sb = NULL;
+
+			dev = e->dev;
+			bdev = bdget(new_decode_dev(dev));
+			if (bdev) {
+				sb = get_super(bdev);
+				bdput(bdev);
+			}
+			ino = 0;
+		}
+
+		if (e->ino != ino || !dentry) {
+			if (dentry)
+				dput(dentry);
+			dentry = NULL;
+			mapping = NULL;
+			ino = e->ino;
+
+			if (sb) {
+				dentry = ra_profile_get_dentry(sb, e);
+				if (IS_ERR_OR_NULL(dentry))
+					dentry = NULL;
+				else if (S_ISREG(d_inode(dentry)->i_mode))
+					mapping = d_inode(dentry)->i_mapping;
+			}
+		}
+
+		start = s;
+		end = n;
+		pending = true;
+		cond_resched();
+	}
+
+	if (dentry)
+		dput(dentry);
+	if (sb)
+		drop_super(sb);
+}
+
+static ssize_t record_show(struct kobject *kobj, struct kobj_attribute *attr,
+			   char *buf)
+{
+	pid_t nr;
+
+	mutex_lock(&ra_profile_mutex);
+	nr = pid_vnr(ra_profile_pid);
+	mutex_unlock(&ra_profile_mutex);
+
+	return sprintf(buf, "%d\n", nr);
+}
+
+static ssize_t record_store(struct kobject *kobj, struct kobj_attribute *attr,
+			    const char *buf, size_t count)
+{
+	pid_t nr;
+	int ret = 0;
+
+	if (kstrtoint(buf, 10, &nr) || nr < 0)
+		return -EINVAL;
+
+	mutex_lock(&ra_profile_mutex);
+	ra_profile_stop();
+	if (nr)
+		ret = ra_profile_start(nr);
+	mutex_unlock(&ra_profile_mutex);
+
+	return ret ? ret : count;
+}
+
+static struct kobj_attribute record_attr = __ATTR_RW(record);
+
+static ssize_t profile_read(struct file *filp, struct kobject *kobj,
+			    struct bin_attribute *attr, char *buf,
+			    loff_t off, size_t count)
+{
+	size_t size;
+	ssize_t ret = 0;
+
+	mutex_lock(&ra_profile_mutex);
+	if (ra_profile_pid) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	size = ra_profile_nr * sizeof(*ra_profile);
+	if (off < size) {
+		ret = min_t(size_t, count, size - off);
+		memcpy(buf, (char *)ra_profile + off, ret);
+	}
+unlock:
+	mutex_unlock(&ra_profile_mutex);
+
+	return ret;
+}
+
+static ssize_t profile_write(struct file *filp, struct kobject *kobj,
+			     struct bin_attribute *attr, char *buf,
+			     loff_t off, size_t count)
+{
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (count % sizeof(struct ra_profile_entry))
+		return -EINVAL;
+
+	ra_profile_replay((struct ra_profile_entry *)buf,
+			  count / sizeof(struct ra_profile_entry));
+
+	return count;
+}
+
+static struct bin_attribute profile_attr =
+	__BIN_ATTR(profile, 0600, profile_read, profile_write, 0);
+
+static struct attribute *ra_profile_attrs[] = {
+	&record_attr.attr,
+	NULL,
+};
+
+static struct bin_attribute *ra_profile_bin_attrs[] = {
+	&profile_attr,
+	NULL,
+};
+
+static const struct attribute_group ra_profile_attr_group = {
+	.attrs = ra_profile_attrs,
+	.bin_attrs = ra_profile_bin_attrs,
+	.name = "ra_profile",
+};
+
+static int __init ra_profile_init(void)
+{
+	int err;
+
+	err = sysfs_create_group(mm_kobj, &ra_profile_attr_group);
+	if (err)
+		pr_err("register sysfs failed\n");
+
+	return err;
+}
+late_initcall(ra_profile_init);
@@ -510,6 +510,8 @@ void page_cache_sync_readahead(struct address_space *mapping,
 			       struct file_ra_state *ra, struct file *filp,
 			       pgoff_t offset, unsigned long req_size)
 {
+	ra_profile_miss(mapping, offset, req_size);
+
 	/* no read-ahead */
 	if (!ra->ra_pages)
 		return;
@@ -51,6 +51,13 @@ static void reactivate_swap_slots_cache(void);
 #define SLOTS_CACHE 0x1
 #define SLOTS_CACHE_RET 0x2
 
+/*
+ * Slots of synchronous devices like zram pin their compressed data until
+ * the device is notified, so return them to the global pool in smaller
+ * batches than the other slots.
+ */
+#define SWAP_SLOTS_SYNC_BATCH 16
+
 static void deactivate_swap_slots_cache(void)
 {
 	mutex_lock(&swap_slots_cache_mutex);
@@ -282,15 +289,16 @@ int free_swap_slot(swp_entry_t entry)
 
 	si = swp_swap_info(entry);
 	cache = raw_cpu_ptr(&swp_slots);
-	if ((si && !(si->flags & SWP_SYNCHRONOUS_IO)) &&
-				use_swap_slot_cache && cache->slots_ret) {
+	if (si && use_swap_slot_cache && cache->slots_ret) {
 		spin_lock_irq(&cache->free_lock);
 		/* Swap slots cache may be deactivated before acquiring lock */
 		if (!use_swap_slot_cache || !cache->slots_ret) {
 			spin_unlock_irq(&cache->free_lock);
 			goto direct_free;
 		}
-		if (cache->n_ret >= SWAP_SLOTS_CACHE_SIZE) {
+		if (cache->n_ret >= SWAP_SLOTS_CACHE_SIZE ||
+		    ((si->flags & SWP_SYNCHRONOUS_IO) &&
+		     cache->n_ret >= SWAP_SLOTS_SYNC_BATCH)) {
 			/*
 			 * Return slots to global pool.
 			 * The current swap_map value is SWAP_HAS_CACHE.
@@ -39,6 +39,7 @@
 #include <linux/export.h>
 #include <linux/swap_slots.h>
 #include <linux/sort.h>
+#include <linux/debugfs.h>
 
 #include <asm/pgtable.h>
 #include <asm/tlbflush.h>
@@ -713,7 +714,7 @@ static void add_to_avail_list(struct swap_info_struct *p)
 }
 
 static void swap_range_free(struct swap_info_struct *si, unsigned long offset,
-			    unsigned int nr_entries)
+			    unsigned int nr_entries, bool notify)
 {
 	unsigned long end = offset + nr_entries - 1;
 	void (*swap_slot_free_notify)(struct block_device *, unsigned long);
@@ -729,7 +730,7 @@ static void swap_range_free(struct swap_info_struct *si, unsigned long offset,
 	}
 	atomic_long_add(nr_entries, &nr_swap_pages);
 	si->inuse_pages -= nr_entries;
-	if (si->flags & SWP_BLKDEV)
+	if (notify && (si->flags & SWP_BLKDEV))
 		swap_slot_free_notify =
 			si->bdev->bd_disk->fops->swap_slot_free_notify;
 	else
@@ -984,7 +985,7 @@ static void swap_free_cluster(struct swap_info_struct *si, unsigned long idx)
 	cluster_set_count_flag(ci, 0, 0);
 	free_cluster(si, idx);
 	unlock_cluster(ci);
-	swap_range_free(si, offset, SWAPFILE_CLUSTER);
+	swap_range_free(si, offset, SWAPFILE_CLUSTER, true);
 }
 
 static unsigned long scan_swap_map(struct swap_info_struct *si,
@@ -1002,11 +1003,38 @@ static unsigned long scan_swap_map(struct swap_info_struct *si,
 
 }
 
+static inline void swap_lock_stat_alloc(struct swap_info_struct *si,
+					u64 locked_at)
+{
+	struct swap_lock_stat *st = &si->lock_stat;
+	u64 held = local_clock() - locked_at;
+
+	/* scan_swap_map_slots() may drop the lock, this is an upper bound */
+	st->alloc_nr++;
+	st->alloc_ns += held;
+	if (held > st->alloc_max_ns)
+		st->alloc_max_ns = held;
+}
+
+static inline void swap_lock_stat_free(struct swap_info_struct *si,
+				       u64 locked_at, unsigned int nr)
+{
+	struct swap_lock_stat *st = &si->lock_stat;
+	u64 held = local_clock() - locked_at;
+
+	st->free_nr++;
+	st->free_ns += held;
+	st->free_slots += nr;
+	if (held > st->free_max_ns)
+		st->free_max_ns = held;
+}
+
 int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 {
 	unsigned long size = swap_entry_size(entry_size);
 	struct swap_info_struct *si, *next;
 	long avail_pgs;
+	u64 locked_at;
 	int n_ret = 0;
 	int node;
 
@@ -1050,12 +1078,14 @@ int get_swap_pages(int n_goal, swp_entry_t swp_entries[], int entry_size)
 			spin_unlock(&si->lock);
 			goto nextsi;
 		}
+		locked_at = local_clock();
 		if (size == SWAPFILE_CLUSTER) {
 			if (si->flags & SWP_BLKDEV)
 				n_ret = swap_alloc_cluster(si, swp_entries);
 		} else
 			n_ret = scan_swap_map_slots(si, SWAP_HAS_CACHE,
 						    n_goal, swp_entries);
+		swap_lock_stat_alloc(si, locked_at);
 		spin_unlock(&si->lock);
 		if (n_ret || size == SWAPFILE_CLUSTER)
 			goto check_out;
@@ -1171,22 +1201,6 @@ static struct swap_info_struct *swap_info_get(swp_entry_t entry)
 	return p;
 }
 
-static struct swap_info_struct *swap_info_get_cont(swp_entry_t entry,
-					struct swap_info_struct *q)
-{
-	struct swap_info_struct *p;
-
-	p = _swap_info_get(entry);
-
-	if (p != q) {
-		if (q != NULL)
-			spin_unlock(&q->lock);
-		if (p != NULL)
-			spin_lock(&p->lock);
-	}
-	return p;
-}
-
 static unsigned char __swap_entry_free_locked(struct swap_info_struct *p,
 					      unsigned long offset,
 					      unsigned char usage)
@@ -1316,7 +1330,7 @@ static void swap_entry_free(struct swap_info_struct *p, swp_entry_t entry)
 	unlock_cluster(ci);
 
 	mem_cgroup_uncharge_swap(entry, 1);
-	swap_range_free(p, offset, 1);
+	swap_range_free(p, offset, 1, false);
 }
 
 /*
@@ -1406,9 +1420,51 @@ static int swp_entry_cmp(const void *ent1, const void *ent2)
 	return (int)swp_type(*e1) - (int)swp_type(*e2);
 }
 
+#define SWAP_NOTIFY_BATCH	16
+
+/*
+ * Tell the block device, e.g. zram, that the data of these slots is gone.
+ * Their swap count is zero and SWAP_HAS_CACHE keeps them from being
+ * allocated again until swap_entry_free(), so unlike the notification in
+ * swap_range_free() this does not need si->lock, which keeps the cost of
+ * freeing the compressed data out of the lock hold time. @entries are
+ * sorted by swap device.
+ */
+static void swap_slots_free_notify(swp_entry_t *entries, int n)
+{
+	const struct block_device_operations *fops;
+	unsigned long offsets[SWAP_NOTIFY_BATCH];
+	struct swap_info_struct *si;
+	unsigned int nr;
+	int i = 0;
+
+	while (i < n) {
+		si = swp_swap_info(entries[i]);
+		if (!si || !(si->flags & SWP_BLKDEV)) {
+			i++;
+			continue;
+		}
+
+		fops = si->bdev->bd_disk->fops;
+		for (nr = 0; i < n && nr < SWAP_NOTIFY_BATCH &&
+		     swp_type(entries[i]) == si->type; i++)
+			offsets[nr++] = swp_offset(entries[i]);
+
+		if (fops->swap_slots_free_notify) {
+			fops->swap_slots_free_notify(si->bdev, offsets, nr);
+		} else if (fops->swap_slot_free_notify) {
+			while (nr)
+				fops->swap_slot_free_notify(si->bdev,
+							    offsets[--nr]);
+		}
+	}
+}
+
 void swapcache_free_entries(swp_entry_t *entries, int n)
 {
 	struct swap_info_struct *p, *prev;
+	unsigned int nr = 0;
+	u64 locked_at = 0;
 	int i;
 
 	if (n <= 0)
@@ -1424,14 +1480,30 @@ void swapcache_free_entries(swp_entry_t *entries, int n)
 	 */
 	if (nr_swapfiles > 1)
 		sort(entries, n, sizeof(entries[0]), swp_entry_cmp, NULL);
+	swap_slots_free_notify(entries, n);
 	for (i = 0; i < n; ++i) {
-		p = swap_info_get_cont(entries[i], prev);
-		if (p)
+		p = _swap_info_get(entries[i]);
+		if (p != prev) {
+			if (prev) {
+				swap_lock_stat_free(prev, locked_at, nr);
+				spin_unlock(&prev->lock);
+			}
+			if (p) {
+				spin_lock(&p->lock);
+				locked_at = local_clock();
+				nr = 0;
+			}
+		}
+		if (p) {
 			swap_entry_free(p, entries[i]);
+			nr++;
+		}
 		prev = p;
 	}
-	if (p)
+	if (p) {
+		swap_lock_stat_free(p, locked_at, nr);
 		spin_unlock(&p->lock);
+	}
 }
 
 /*
@@ -2825,6 +2897,46 @@ static int __init procswaps_init(void)
 __initcall(procswaps_init);
 #endif /* CONFIG_PROC_FS */
 
+#ifdef CONFIG_DEBUG_FS
+static int swap_lock_stat_show(struct seq_file *m, void *v)
+{
+	struct swap_info_struct *si;
+	struct swap_lock_stat *st;
+	int type;
+
+	seq_printf(m, "%-5s %12s %12s %10s %12s %12s %10s %12s\n", "type",
+		   "alloc_nr", "alloc_us", "alloc_max", "free_nr", "free_us",
+		   "free_max", "free_slots");
+
+	mutex_lock(&swapon_mutex);
+	for (type = 0; type < nr_swapfiles; type++) {
+		si = swap_info[type];
+		if (!(si->flags & SWP_USED) || !si->swap_map)
+			continue;
+
+		st = &si->lock_stat;
+		seq_printf(m, "%-5d %12llu %12llu %10llu %12llu %12llu %10llu %12llu\n",
+			   type, st->alloc_nr, div_u64(st->alloc_ns, NSEC_PER_USEC),
+			   div_u64(st->alloc_max_ns, NSEC_PER_USEC), st->free_nr,
+			   div_u64(st->free_ns, NSEC_PER_USEC),
+			   div_u64(st->free_max_ns, NSEC_PER_USEC),
+			   st->free_slots);
+	}
+	mutex_unlock(&swapon_mutex);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(swap_lock_stat);
+
+static int __init swap_lock_stat_init(void)
+{
+	debugfs_create_file("swap_lock_stat", 0400, NULL, NULL,
+			    &swap_lock_stat_fops);
+	return 0;
+}
+late_initcall(swap_lock_stat_init);
+#endif /* CONFIG_DEBUG_FS */
+
 #ifdef MAX_SWAPFILES_CHECK
 static int __init max_swapfiles_check(void)
 {
@@ -2874,6 +2986,7 @@ static struct swap_info_struct *alloc_swap_info(void)
 		 */
 	}
 	p->swap_extent_root = RB_ROOT;
+	memset(&p->lock_stat, 0, sizeof(p->lock_stat));
 	plist_node_init(&p->list, 0);
 	for_each_node(i)
 		plist_node_init(&p->avail_lists[i], 0);
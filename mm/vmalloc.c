@@ -35,6 +35,9 @@
 #include <linux/bitops.h>
 #include <linux/rbtree_augmented.h>
 #include <linux/overflow.h>
+#include <linux/io.h>
+#include <linux/debugfs.h>
+#include <linux/sched/clock.h>
 
 #include <linux/uaccess.h>
 #include <asm/tlbflush.h>
@@ -348,8 +351,14 @@ struct page *vmalloc_to_page(const void *vmalloc_addr)
 	if (pud_none(*pud) || pud_bad(*pud))
 		return NULL;
 	pmd = pmd_offset(pud, addr);
+	if (pmd_none(*pmd))
+		return NULL;
+	/* A block mapping of vmalloc_huge() memory does have pages */
+	if (IS_ENABLED(CONFIG_HAVE_ARCH_HUGE_VMAP) && pmd_bad(*pmd) &&
+	    pfn_valid(pmd_pfn(*pmd)))
+		return pmd_page(*pmd) + ((addr & ~PMD_MASK) >> PAGE_SHIFT);
 	WARN_ON_ONCE(pmd_bad(*pmd));
-	if (pmd_none(*pmd) || pmd_bad(*pmd))
+	if (pmd_bad(*pmd))
 		return NULL;
 
 	ptep = pte_offset_map(pmd, addr);
@@ -1275,6 +1284,20 @@ static atomic_long_t vmap_lazy_nr = ATOMIC_LONG_INIT(0);
  */
 static DEFINE_MUTEX(vmap_purge_lock);
 
+/*
+ * Lazy purge latency, updated under vmap_purge_lock. wait_ns is the time
+ * purge_vmap_area_lazy() callers spent waiting for that lock.
+ */
+static struct vmap_purge_stat {
+	unsigned long purges;
+	unsigned long areas;
+	unsigned long pages;
+	u64 total_ns;
+	u64 max_ns;
+	u64 wait_ns;
+	u64 max_wait_ns;
+} vmap_purge_stat;
+
 /* for per-CPU blocks */
 static void purge_fragmented_blocks_allcpus(void);
 
@@ -1296,6 +1319,8 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 	struct llist_node *valist;
 	struct vmap_area *va;
 	struct vmap_area *n_va;
+	unsigned long nr_areas = 0, nr_pages = 0;
+	u64 begin, delta;
 
 	lockdep_assert_held(&vmap_purge_lock);
 
@@ -1303,6 +1328,8 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 	if (unlikely(valist == NULL))
 		return false;
 
+	begin = local_clock();
+
 	/*
 	 * First make sure the mappings are removed from all page-tables
 	 * before they are freed.
@@ -1336,11 +1363,21 @@ static bool __purge_vmap_area_lazy(unsigned long start, unsigned long end)
 			&free_vmap_area_root, &free_vmap_area_list);
 
 		atomic_long_sub(nr, &vmap_lazy_nr);
+		nr_areas++;
+		nr_pages += nr;
 
 		if (atomic_long_read(&vmap_lazy_nr) < resched_threshold)
 			cond_resched_lock(&vmap_area_lock);
 	}
 	spin_unlock(&vmap_area_lock);
+
+	delta = local_clock() - begin;
+	vmap_purge_stat.purges++;
+	vmap_purge_stat.areas += nr_areas;
+	vmap_purge_stat.pages += nr_pages;
+	vmap_purge_stat.total_ns += delta;
+	if (delta > vmap_purge_stat.max_ns)
+		vmap_purge_stat.max_ns = delta;
 	return true;
 }
 
@@ -1361,7 +1398,13 @@ static void try_purge_vmap_area_lazy(void)
  */
 static void purge_vmap_area_lazy(void)
 {
+	u64 begin = local_clock(), wait;
+
 	mutex_lock(&vmap_purge_lock);
+	wait = local_clock() - begin;
+	vmap_purge_stat.wait_ns += wait;
+	if (wait > vmap_purge_stat.max_wait_ns)
+		vmap_purge_stat.max_wait_ns = wait;
 	purge_fragmented_blocks_allcpus();
 	__purge_vmap_area_lazy(ULONG_MAX, 0);
 	mutex_unlock(&vmap_purge_lock);
@@ -2477,6 +2520,51 @@ void *vmap(struct page **pages, unsigned int count,
 }
 EXPORT_SYMBOL(vmap);
 
+#define VMALLOC_HUGE_ORDER	(PMD_SHIFT - PAGE_SHIFT)
+
+static bool vmap_pages_contiguous(struct page **pages, unsigned int nr)
+{
+	unsigned long pfn = page_to_pfn(pages[0]);
+	unsigned int i;
+
+	for (i = 1; i < nr; i++)
+		if (page_to_pfn(pages[i]) != pfn + i)
+			return false;
+	return true;
+}
+
+/*
+ * Map a VM_HUGE_PMD area. Each PMD sized chunk that is backed by one
+ * physically contiguous block gets a block mapping through the ioremap
+ * code, which already knows how to build those; the rest gets ptes.
+ */
+static int vmap_huge_area(struct vm_struct *area, pgprot_t prot)
+{
+	unsigned long start = (unsigned long)area->addr;
+	unsigned long addr = start;
+	unsigned int chunk = 1U << VMALLOC_HUGE_ORDER;
+	unsigned int i, nr;
+	int err;
+
+	for (i = 0; i < area->nr_pages; i += nr, addr += nr << PAGE_SHIFT) {
+		nr = min(chunk, area->nr_pages - i);
+
+		if (nr == chunk && vmap_pages_contiguous(&area->pages[i], nr))
+			err = ioremap_page_range(addr, addr + PMD_SIZE,
+						 page_to_phys(area->pages[i]),
+						 prot);
+		else
+			err = vmap_page_range_noflush(addr,
+						      addr + (nr << PAGE_SHIFT),
+						      prot, &area->pages[i]);
+		if (err < 0)
+			return err;
+	}
+
+	flush_cache_vmap(start, addr);
+	return 0;
+}
+
 static void *__vmalloc_node(unsigned long size, unsigned long align,
 			    gfp_t gfp_mask, pgprot_t prot,
 			    int node, const void *caller);
@@ -2484,7 +2572,8 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 				 pgprot_t prot, int node)
 {
 	struct page **pages;
-	unsigned int nr_pages, array_size, i;
+	unsigned int nr_pages, array_size, i, nr;
+	bool huge = area->flags & VM_HUGE_PMD;
 	const gfp_t nested_gfp = (gfp_mask & GFP_RECLAIM_MASK) | __GFP_ZERO;
 	const gfp_t alloc_mask = gfp_mask | __GFP_NOWARN;
 	const gfp_t highmem_mask = (gfp_mask & (GFP_DMA | GFP_DMA32)) ?
@@ -2511,13 +2600,38 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 	area->pages = pages;
 	area->nr_pages = nr_pages;
 
-	for (i = 0; i < area->nr_pages; i++) {
-		struct page *page;
+	for (i = 0; i < area->nr_pages; i += nr) {
+		struct page *page = NULL;
+		unsigned int j;
 
-		if (node == NUMA_NO_NODE)
-			page = alloc_page(alloc_mask|highmem_mask);
-		else
-			page = alloc_pages_node(node, alloc_mask|highmem_mask, 0);
+		/*
+		 * Try a PMD sized block while whole ones are left, without
+		 * working hard for it; once one fails, the rest of the area
+		 * is allocated page by page.
+		 */
+		nr = 1U << VMALLOC_HUGE_ORDER;
+		if (huge && area->nr_pages - i >= nr) {
+			const gfp_t huge_mask = alloc_mask | highmem_mask |
+						__GFP_NORETRY;
+
+			if (node == NUMA_NO_NODE)
+				page = alloc_pages(huge_mask, VMALLOC_HUGE_ORDER);
+			else
+				page = alloc_pages_node(node, huge_mask,
+							VMALLOC_HUGE_ORDER);
+			if (page)
+				split_page(page, VMALLOC_HUGE_ORDER);
+			else
+				huge = false;
+		}
+
+		if (!page) {
+			nr = 1;
+			if (node == NUMA_NO_NODE)
+				page = alloc_page(alloc_mask|highmem_mask);
+			else
+				page = alloc_pages_node(node, alloc_mask|highmem_mask, 0);
+		}
 
 		if (unlikely(!page)) {
 			/* Successfully allocated i pages, free them in __vunmap() */
@@ -2525,14 +2639,19 @@ static void *__vmalloc_area_node(struct vm_struct *area, gfp_t gfp_mask,
 			atomic_long_add(area->nr_pages, &nr_vmalloc_pages);
 			goto fail;
 		}
-		area->pages[i] = page;
+		for (j = 0; j < nr; j++)
+			area->pages[i + j] = page + j;
 		if (gfpflags_allow_blocking(gfp_mask|highmem_mask))
 			cond_resched();
 	}
 	atomic_long_add(area->nr_pages, &nr_vmalloc_pages);
 
-	if (map_vm_area(area, prot, pages))
+	if (area->flags & VM_HUGE_PMD) {
+		if (vmap_huge_area(area, prot))
+			goto fail;
+	} else if (map_vm_area(area, prot, pages)) {
 		goto fail;
+	}
 	return area->addr;
 
 fail:
@@ -2574,6 +2693,18 @@ void *__vmalloc_node_range(unsigned long size, unsigned long align,
 	if (!size || (size >> PAGE_SHIFT) > totalram_pages())
 		goto fail;
 
+	/*
+	 * Block mappings cannot have their permissions changed piecewise,
+	 * so they are only used for plain data of at least one PMD.
+	 */
+	if (vm_flags & VM_HUGE_PMD) {
+		if (!IS_ENABLED(CONFIG_HAVE_ARCH_HUGE_VMAP) || size < PMD_SIZE ||
+		    (vm_flags & VM_FLUSH_RESET_PERMS))
+			vm_flags &= ~VM_HUGE_PMD;
+		else
+			align = max_t(unsigned long, align, PMD_SIZE);
+	}
+
 	area = __get_vm_area_node(size, align, VM_ALLOC | VM_UNINITIALIZED |
 				vm_flags, start, end, node, gfp_mask, caller);
 	if (!area)
@@ -2683,6 +2814,27 @@ void *vmalloc(unsigned long size)
 }
 EXPORT_SYMBOL(vmalloc);
 
+/**
+ * vmalloc_huge - allocate virtually contiguous memory, mapped with blocks
+ * @size:	allocation size
+ * @gfp_mask:	flags for the page level allocator
+ *
+ * Like vmalloc(), but backs each PMD sized chunk with a physically
+ * contiguous block when one is readily available and maps it with a
+ * single PMD entry, saving page table memory and TLB misses for large
+ * buffers. Falls back to pages silently. The memory must not have its
+ * permissions changed with set_memory_*().
+ *
+ * Return: pointer to the allocated memory or %NULL on error
+ */
+void *vmalloc_huge(unsigned long size, gfp_t gfp_mask)
+{
+	return __vmalloc_node_range(size, 1, VMALLOC_START, VMALLOC_END,
+				    gfp_mask, PAGE_KERNEL, VM_HUGE_PMD,
+				    NUMA_NO_NODE, __builtin_return_address(0));
+}
+EXPORT_SYMBOL_GPL(vmalloc_huge);
+
 /**
  * vzalloc - allocate virtually contiguous memory with zero fill
  * @size:    allocation size
@@ -3631,6 +3783,9 @@ static int s_show(struct seq_file *m, void *p)
 	if (v->flags & VM_LOWMEM)
 		seq_puts(m, " lowmem");
 
+	if (v->flags & VM_HUGE_PMD)
+		seq_puts(m, " huge");
+
 	show_numa_info(m, v);
 	seq_putc(m, '\n');
 
@@ -3666,3 +3821,36 @@ static int __init proc_vmalloc_init(void)
 module_init(proc_vmalloc_init);
 
 #endif
+
+#ifdef CONFIG_DEBUG_FS
+static int vmap_purge_stat_show(struct seq_file *m, void *v)
+{
+	struct vmap_purge_stat st;
+
+	mutex_lock(&vmap_purge_lock);
+	st = vmap_purge_stat;
+	mutex_unlock(&vmap_purge_lock);
+
+	seq_printf(m, "purges %lu\n", st.purges);
+	seq_printf(m, "areas %lu\n", st.areas);
+	seq_printf(m, "pages %lu\n", st.pages);
+	seq_printf(m, "total_us %llu\n", div_u64(st.total_ns, NSEC_PER_USEC));
+	seq_printf(m, "max_us %llu\n", div_u64(st.max_ns, NSEC_PER_USEC));
+	seq_printf(m, "lock_wait_us %llu\n",
+		   div_u64(st.wait_ns, NSEC_PER_USEC));
+	seq_printf(m, "lock_wait_max_us %llu\n",
+		   div_u64(st.max_wait_ns, NSEC_PER_USEC));
+	seq_printf(m, "lazy_pages %ld\n", atomic_long_read(&vmap_lazy_nr));
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(vmap_purge_stat);
+
+static int __init vmap_purge_stat_init(void)
+{
+	debugfs_create_file("vmap_purge_stat", 0400, NULL, NULL,
+			    &vmap_purge_stat_fops);
+	return 0;
+}
+late_initcall(vmap_purge_stat_init);
+#endif /* CONFIG_DEBUG_FS */
@@ -51,6 +51,7 @@
 #include <linux/printk.h>
 #include <linux/dax.h>
 #include <linux/psi.h>
+#include <linux/page_idle.h>
 
 #include <asm/tlbflush.h>
 #include <asm/div64.h>
@@ -2265,6 +2266,105 @@ unsigned long reclaim_pages(struct list_head *page_list)
 	return nr_reclaimed;
 }
 
+#ifdef CONFIG_MEMCG_WORKINGSET
+/*
+ * Age one LRU list for working set estimation. A page belongs to the
+ * working set if it was accessed since the previous pass, i.e. if it
+ * lost its idle flag; it is marked idle again for the next one. Unlike
+ * shrink_active_list() nothing is deactivated, and the young bits
+ * harvested from the page tables are kept in the page so that reclaim
+ * still sees them.
+ */
+static void age_lru_list(struct lruvec *lruvec, enum lru_list lru,
+			 unsigned long *ws, unsigned long *scanned)
+{
+	struct pglist_data *pgdat = lruvec_pgdat(lruvec);
+	struct mem_cgroup *memcg = lruvec_memcg(lruvec);
+	unsigned long nr_to_scan = lruvec_lru_size(lruvec, lru, MAX_NR_ZONES);
+	int file = is_file_lru(lru);
+	struct scan_control sc = {
+		.gfp_mask = GFP_KERNEL,
+		.target_mem_cgroup = memcg,
+		.reclaim_idx = MAX_NR_ZONES - 1,
+		.may_unmap = 1,
+	};
+
+	while (nr_to_scan && !fatal_signal_pending(current)) {
+		unsigned long nr_taken, nr_scanned, vm_flags;
+		LIST_HEAD(l_hold);
+		struct page *page;
+
+		spin_lock_irq(&pgdat->lru_lock);
+		nr_taken = isolate_lru_pages(min(nr_to_scan, SWAP_CLUSTER_MAX),
+					     lruvec, &l_hold, &nr_scanned,
+					     &sc, lru);
+		__mod_node_page_state(pgdat, NR_ISOLATED_ANON + file, nr_taken);
+		spin_unlock_irq(&pgdat->lru_lock);
+
+		if (!nr_scanned)
+			break;
+		nr_to_scan -= min(nr_to_scan, nr_scanned);
+		*scanned += nr_scanned;
+
+		list_for_each_entry(page, &l_hold, lru) {
+			if (page_referenced(page, 0, memcg, &vm_flags))
+				set_page_young(page);
+			if (!page_is_idle(page))
+				ws[file] += hpage_nr_pages(page);
+			set_page_idle(page);
+		}
+
+		/* Isolated from the tail, put back at the head: a rotation. */
+		spin_lock_irq(&pgdat->lru_lock);
+		move_pages_to_lru(lruvec, &l_hold);
+		__mod_node_page_state(pgdat, NR_ISOLATED_ANON + file, -nr_taken);
+		spin_unlock_irq(&pgdat->lru_lock);
+
+		mem_cgroup_uncharge_list(&l_hold);
+		free_unref_page_list(&l_hold);
+		cond_resched();
+	}
+}
+
+/**
+ * mem_cgroup_age_working_set - run an aging pass over a memcg subtree
+ * @memcg: the root of the subtree
+ * @ws: anon and file pages referenced since the previous pass
+ * @scanned: pages scanned
+ *
+ * The first pass over a memcg only primes the idle flags, so it reports
+ * everything as referenced.
+ */
+void mem_cgroup_age_working_set(struct mem_cgroup *memcg, unsigned long *ws,
+				unsigned long *scanned)
+{
+	struct mem_cgroup *iter;
+	enum lru_list lru;
+	int nid;
+
+	ws[0] = ws[1] = 0;
+	*scanned = 0;
+
+	lru_add_drain_all();
+
+	iter = mem_cgroup_iter(memcg, NULL, NULL);
+	do {
+		for_each_node_state(nid, N_MEMORY) {
+			struct lruvec *lruvec;
+
+			lruvec = mem_cgroup_lruvec(NODE_DATA(nid), iter);
+			for_each_evictable_lru(lru)
+				age_lru_list(lruvec, lru, ws, scanned);
+		}
+
+		if (fatal_signal_pending(current)) {
+			mem_cgroup_iter_break(memcg, iter);
+			break;
+		}
+	} while ((iter = mem_cgroup_iter(memcg, iter, NULL)));
+}
+#endif
+
 /*
  * The inactive anon list should be small enough that the VM never has
  * to do too much work.
@@ -1082,6 +1082,24 @@ int fragmentation_index(struct zone *zone, unsigned int order)
 	fill_contig_page_info(zone, order, &info);
 	return __fragmentation_index(order, &info);
 }
+
+/*
+ * Calculates external fragmentation within a zone wrt the given order.
+ * It is defined as the percentage of pages found in blocks of size
+ * less than 1 << order. It returns values in range [0, 100].
+ */
+unsigned int extfrag_for_order(struct zone *zone, unsigned int order)
+{
+	struct contig_page_info info;
+
+	fill_contig_page_info(zone, order, &info);
+	if (info.free_pages == 0)
+		return 0;
+
+	return div_u64((info.free_pages -
+			(info.free_blocks_suitable << order)) * 100,
+			info.free_pages);
+}
 #endif
 
 #if defined(CONFIG_PROC_FS) || defined(CONFIG_SYSFS) || defined(CONFIG_NUMA)
@@ -1245,6 +1263,8 @@ const char * const vmstat_text[] = {
 	"compact_daemon_wake",
 	"compact_daemon_migrate_scanned",
 	"compact_daemon_free_scanned",
+	"compact_daemon_proactive_wake",
+	"compact_daemon_proactive_abort",
 #endif
 
 #ifdef CONFIG_HUGETLB_PAGE
@@ -1303,6 +1323,18 @@ const char * const vmstat_text[] = {
 #ifdef CONFIG_SPECULATIVE_PAGE_FAULT
 	"speculative_pgfault_anon",
 	"speculative_pgfault_file",
+	"speculative_pgfault_abort_vma",
+	"speculative_pgfault_abort_seq",
+	"speculative_pgfault_abort_anon_vma",
+	"speculative_pgfault_abort_file",
+	"speculative_pgfault_abort_walk",
+	"speculative_pgfault_abort_fault",
+	"speculative_pgfault_abort_other",
+#endif
+#ifdef CONFIG_PCP_HIGH_ORDER
+	"pcp_high_order_alloc",
+	"pcp_high_order_refill",
+	"pcp_high_order_drain",
 #endif
 #endif /* CONFIG_VM_EVENT_COUNTERS */
 };
@@ -1637,6 +1669,10 @@ static void zoneinfo_show_print(struct seq_file *m, pg_data_t *pgdat,
 			   pageset->pcp.count,
 			   pageset->pcp.high,
 			   pageset->pcp.batch);
+#ifdef CONFIG_PCP_HIGH_ORDER
+		seq_printf(m, "\n  order-%d count: %i", PCP_HIGH_ORDER,
+			   pageset->pcp.high_order_count);
+#endif
 #ifdef CONFIG_SMP
 		seq_printf(m, "\n  vm stats threshold: %d",
 				pageset->stat_threshold);
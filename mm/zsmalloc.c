@@ -57,6 +57,8 @@
 #include <linux/wait.h>
 #include <linux/pagemap.h>
 #include <linux/fs.h>
+#include <linux/tick.h>
+#include <linux/workqueue.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -197,6 +199,25 @@ static struct vfsmount *zsmalloc_mnt;
 static const int fullness_threshold_frac = 4;
 static size_t huge_class_size;
 
+#ifdef CONFIG_ZSMALLOC_BG_COMPACTION
+/*
+ * Background compaction: every zs_bg_compact_interval_ms, if the online CPUs
+ * were at least zs_bg_compact_idle_pct idle since the last run, compact the
+ * classes that have at least zs_bg_compact_frag_pct of their pages freeable,
+ * most fragmented first, until zs_bg_compact_budget pages have been freed.
+ */
+static unsigned int zs_bg_compact_interval_ms = 10000;
+module_param(zs_bg_compact_interval_ms, uint, 0644);
+static unsigned int zs_bg_compact_idle_pct = 50;
+module_param(zs_bg_compact_idle_pct, uint, 0644);
+static unsigned int zs_bg_compact_frag_pct = 20;
+module_param(zs_bg_compact_frag_pct, uint, 0644);
+static unsigned int zs_bg_compact_budget = 256;
+module_param(zs_bg_compact_budget, uint, 0644);
+
+static struct workqueue_struct *zs_compact_wq;
+#endif
+
 struct size_class {
 	spinlock_t lock;
 	struct list_head fullness_list[NR_ZS_FULLNESS];
@@ -266,6 +287,15 @@ struct zs_pool {
 #ifdef CONFIG_ZSMALLOC_STAT
 	struct dentry *stat_dentry;
 #endif
+#ifdef CONFIG_ZSMALLOC_BG_COMPACTION
+	struct delayed_work bg_compact_work;
+	/* CPU idle and wall time summed over the online CPUs at the last run */
+	u64 bg_idle_us;
+	u64 bg_wall_us;
+	unsigned long bg_runs;
+	unsigned long bg_skipped;
+	unsigned long bg_pages_compacted;
+#endif
 #ifdef CONFIG_COMPACTION
 	struct inode *inode;
 	struct work_struct free_work;
@@ -582,6 +612,7 @@ static void __exit zs_stat_exit(void)
 }
 
 static unsigned long zs_can_compact(struct size_class *class);
+static unsigned int zs_frag_pct(struct size_class *class);
 
 static int zs_stats_size_show(struct seq_file *s, void *v)
 {
@@ -642,6 +673,65 @@ static int zs_stats_size_show(struct seq_file *s, void *v)
 }
 DEFINE_SHOW_ATTRIBUTE(zs_stats_size);
 
+#define ZS_FRAG_BUCKETS	10
+
+/*
+ * For each class, how full its zspages are: the number of zspages with
+ * 0-9%, 10-19%, ... 90-99% of their objects in use, and full ones.
+ */
+static int zs_frag_show(struct seq_file *s, void *v)
+{
+	struct zs_pool *pool = s->private;
+	unsigned long hist[ZS_FRAG_BUCKETS];
+	enum fullness_group fg;
+	struct size_class *class;
+	struct zspage *zspage;
+	unsigned long full;
+	unsigned int frag;
+	int i, b;
+
+#ifdef CONFIG_ZSMALLOC_BG_COMPACTION
+	seq_printf(s, "background runs %lu skipped %lu pages_compacted %lu\n\n",
+		   pool->bg_runs, pool->bg_skipped, pool->bg_pages_compacted);
+#endif
+	seq_printf(s, " %5s %5s %5s", "class", "size", "frag%");
+	for (b = 0; b < ZS_FRAG_BUCKETS; b++)
+		seq_printf(s, " %5d%%", b * 100 / ZS_FRAG_BUCKETS);
+	seq_printf(s, " %6s\n", "full");
+
+	for (i = 0; i < ZS_SIZE_CLASSES; i++) {
+		class = pool->size_class[i];
+
+		if (class->index != i)
+			continue;
+
+		memset(hist, 0, sizeof(hist));
+		spin_lock(&class->lock);
+		for (fg = ZS_ALMOST_EMPTY; fg <= ZS_ALMOST_FULL; fg++) {
+			list_for_each_entry(zspage, &class->fullness_list[fg],
+					    list) {
+				b = get_zspage_inuse(zspage) * ZS_FRAG_BUCKETS /
+					class->objs_per_zspage;
+				hist[min(b, ZS_FRAG_BUCKETS - 1)]++;
+			}
+		}
+		full = zs_stat_get(class, CLASS_FULL);
+		frag = zs_frag_pct(class);
+		spin_unlock(&class->lock);
+
+		if (!full && !memchr_inv(hist, 0, sizeof(hist)))
+			continue;
+
+		seq_printf(s, " %5u %5u %5u", i, class->size, frag);
+		for (b = 0; b < ZS_FRAG_BUCKETS; b++)
+			seq_printf(s, " %6lu", hist[b]);
+		seq_printf(s, " %6lu\n", full);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(zs_frag);
+
 static void zs_pool_stat_create(struct zs_pool *pool, const char *name)
 {
 	if (!zs_stat_root) {
@@ -653,6 +743,8 @@ static void zs_pool_stat_create(struct zs_pool *pool, const char *name)
 
 	debugfs_create_file("classes", S_IFREG | 0444, pool->stat_dentry, pool,
 			    &zs_stats_size_fops);
+	debugfs_create_file("fragmentation", S_IFREG | 0444, pool->stat_dentry,
+			    pool, &zs_frag_fops);
 }
 
 static void zs_pool_stat_destroy(struct zs_pool *pool)
@@ -2216,8 +2308,26 @@ static unsigned long zs_can_compact(struct size_class *class)
 	return obj_wasted * class->pages_per_zspage;
 }
 
+#if defined(CONFIG_ZSMALLOC_STAT) || defined(CONFIG_ZSMALLOC_BG_COMPACTION)
+/* Percentage of the pages of a class that compaction could free */
+static unsigned int zs_frag_pct(struct size_class *class)
+{
+	unsigned long obj_allocated = zs_stat_get(class, OBJ_ALLOCATED);
+	unsigned long pages_used;
+
+	pages_used = obj_allocated / class->objs_per_zspage *
+			class->pages_per_zspage;
+	if (!pages_used)
+		return 0;
+
+	return zs_can_compact(class) * 100 / pages_used;
+}
+#endif
+
+/* Compact @class until no more pages can be freed or @budget pages were */
 static unsigned long __zs_compact(struct zs_pool *pool,
-				  struct size_class *class)
+				  struct size_class *class,
+				  unsigned long budget)
 {
 	struct zs_compact_control cc;
 	struct zspage *src_zspage;
@@ -2254,6 +2364,10 @@ static unsigned long __zs_compact(struct zs_pool *pool,
 			free_zspage(pool, class, src_zspage);
 			pages_freed += class->pages_per_zspage;
 		}
+		if (pages_freed >= budget) {
+			src_zspage = NULL;
+			break;
+		}
 		spin_unlock(&class->lock);
 		cond_resched();
 		spin_lock(&class->lock);
@@ -2279,7 +2393,7 @@ unsigned long zs_compact(struct zs_pool *pool)
 			continue;
 		if (class->index != i)
 			continue;
-		pages_freed += __zs_compact(pool, class);
+		pages_freed += __zs_compact(pool, class, ULONG_MAX);
 	}
 	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
 
@@ -2287,6 +2401,132 @@ unsigned long zs_compact(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_compact);
 
+#ifdef CONFIG_ZSMALLOC_BG_COMPACTION
+/*
+ * Whether the online CPUs were idle enough since the last run. Without
+ * NO_HZ there is no idle time accounting to go by, so assume they were.
+ */
+static bool zs_bg_compact_idle(struct zs_pool *pool)
+{
+	u64 idle = 0, wall = 0, cpu_idle, cpu_wall, d_idle, d_wall;
+	int cpu;
+
+	for_each_online_cpu(cpu) {
+		cpu_idle = get_cpu_idle_time_us(cpu, &cpu_wall);
+		if (cpu_idle == -1ULL)
+			return true;
+		idle += cpu_idle;
+		wall += cpu_wall;
+	}
+
+	d_idle = idle - pool->bg_idle_us;
+	d_wall = wall - pool->bg_wall_us;
+	pool->bg_idle_us = idle;
+	pool->bg_wall_us = wall;
+
+	/* CPUs went on or offline since the last run, try again next time */
+	if (!d_wall || d_idle > d_wall)
+		return false;
+
+	return d_idle * 100 >= d_wall * zs_bg_compact_idle_pct;
+}
+
+static struct size_class *zs_most_fragmented_class(struct zs_pool *pool,
+						   unsigned long *done)
+{
+	struct size_class *class, *best = NULL;
+	unsigned int frag, best_frag = 0;
+	int i;
+
+	for (i = ZS_SIZE_CLASSES - 1; i >= 0; i--) {
+		class = pool->size_class[i];
+		if (!class || class->index != i || test_bit(i, done))
+			continue;
+
+		frag = zs_frag_pct(class);
+		if (frag >= zs_bg_compact_frag_pct && frag > best_frag) {
+			best = class;
+			best_frag = frag;
+		}
+	}
+
+	return best;
+}
+
+static void zs_bg_compact_work(struct work_struct *work)
+{
+	struct zs_pool *pool = container_of(to_delayed_work(work),
+					    struct zs_pool, bg_compact_work);
+	DECLARE_BITMAP(done, ZS_SIZE_CLASSES);
+	unsigned long budget = zs_bg_compact_budget;
+	unsigned long pages_freed = 0;
+	struct size_class *class;
+
+	if (!atomic_long_read(&pool->pages_allocated))
+		goto out;
+
+	if (!zs_bg_compact_idle(pool)) {
+		pool->bg_skipped++;
+		goto out;
+	}
+
+	bitmap_zero(done, ZS_SIZE_CLASSES);
+	while (pages_freed < budget) {
+		class = zs_most_fragmented_class(pool, done);
+		if (!class)
+			break;
+
+		__set_bit(class->index, done);
+		pages_freed += __zs_compact(pool, class, budget - pages_freed);
+	}
+
+	atomic_long_add(pages_freed, &pool->stats.pages_compacted);
+	pool->bg_pages_compacted += pages_freed;
+	pool->bg_runs++;
+out:
+	queue_delayed_work(zs_compact_wq, &pool->bg_compact_work,
+			   msecs_to_jiffies(zs_bg_compact_interval_ms));
+}
+
+static void zs_bg_compact_start(struct zs_pool *pool)
+{
+	if (!zs_compact_wq)
+		return;
+
+	/* deferrable, so that an idle system isn't woken up for it */
+	INIT_DEFERRABLE_WORK(&pool->bg_compact_work, zs_bg_compact_work);
+	queue_delayed_work(zs_compact_wq, &pool->bg_compact_work,
+			   msecs_to_jiffies(zs_bg_compact_interval_ms));
+}
+
+static void zs_bg_compact_stop(struct zs_pool *pool)
+{
+	if (zs_compact_wq && pool->bg_compact_work.work.func)
+		cancel_delayed_work_sync(&pool->bg_compact_work);
+}
+
+static void __init zs_bg_compact_init(void)
+{
+	/* WQ_SYSFS so that its cpumask can be set from userspace */
+	zs_compact_wq = alloc_workqueue("zs_compact",
+					WQ_UNBOUND | WQ_FREEZABLE | WQ_SYSFS,
+					1);
+	if (!zs_compact_wq)
+		pr_warn("no workqueue, background compaction disabled\n");
+}
+
+static void __exit zs_bg_compact_exit(void)
+{
+	if (zs_compact_wq)
+		destroy_workqueue(zs_compact_wq);
+}
+#else
+static inline void zs_bg_compact_start(struct zs_pool *pool) {}
+static inline void zs_bg_compact_stop(struct zs_pool *pool) {}
+static inline void zs_bg_compact_init(void) {}
+static inline void zs_bg_compact_exit(void) {}
+#endif /* CONFIG_ZSMALLOC_BG_COMPACTION */
+
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
 {
 	memcpy(stats, &pool->stats, sizeof(struct zs_pool_stats));
@@ -2465,6 +2705,8 @@ struct zs_pool *zs_create_pool(const char *name)
 	 */
 	zs_register_shrinker(pool);
 
+	zs_bg_compact_start(pool);
+
 	return pool;
 
 err:
@@ -2477,6 +2719,7 @@ void zs_destroy_pool(struct zs_pool *pool)
 {
 	int i;
 
+	zs_bg_compact_stop(pool);
 	zs_unregister_shrinker(pool);
 	zs_unregister_migration(pool);
 	zs_pool_stat_destroy(pool);
@@ -2524,6 +2767,7 @@ static int __init zs_init(void)
 #endif
 
 	zs_stat_init();
+	zs_bg_compact_init();
 
 	return 0;
 
@@ -2541,6 +2785,7 @@ static void __exit zs_exit(void)
 	zsmalloc_unmount();
 	cpuhp_remove_state(CPUHP_MM_ZS_PREPARE);
 
+	zs_bg_compact_exit();
 	zs_stat_exit();
 }
 
@@ -75,6 +75,7 @@
 #include <linux/capability.h>
 #include <linux/user_namespace.h>
 #include <linux/indirect_call_wrapper.h>
+#include <linux/jump_label.h>
 #include <trace/hooks/net.h>
 
 #include "datagram.h"
@@ -156,6 +157,96 @@ static void *__kmalloc_reserve(size_t size, gfp_t flags, int node,
 	return obj;
 }
 
+/*
+ * Per CPU recycle cache of sk_buff heads. Receive paths that opt in with
+ * SKB_ALLOC_RECYCLE take their heads from the cache of the local CPU, and
+ * while at least one user is registered, heads freed on a CPU are parked
+ * in its cache instead of going back to the slab. The linear data of such
+ * skbs comes from the page fragment caches, which already reuse their page
+ * once every fragment of it has been freed. Hits and misses are reported
+ * in /proc/net/softnet_stat.
+ */
+#define SKB_RECYCLE_CACHE_SIZE	64
+
+struct skb_recycle_cache {
+	unsigned int count;
+	struct sk_buff *skbs[SKB_RECYCLE_CACHE_SIZE];
+};
+
+static DEFINE_PER_CPU(struct skb_recycle_cache, skb_recycle_cache);
+static DEFINE_STATIC_KEY_FALSE(skb_recycle_key);
+
+/**
+ *	skb_recycle_register - start recycling freed skb heads
+ *
+ *	Called by receive paths that allocate with SKB_ALLOC_RECYCLE when
+ *	they start up; skb heads are only parked while there are users.
+ */
+void skb_recycle_register(void)
+{
+	static_branch_inc(&skb_recycle_key);
+}
+EXPORT_SYMBOL(skb_recycle_register);
+
+void skb_recycle_unregister(void)
+{
+	static_branch_dec(&skb_recycle_key);
+}
+EXPORT_SYMBOL(skb_recycle_unregister);
+
+static struct sk_buff *skb_recycle_get(void)
+{
+	struct skb_recycle_cache *rc;
+	struct sk_buff *skb = NULL;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	rc = this_cpu_ptr(&skb_recycle_cache);
+	if (rc->count) {
+		skb = rc->skbs[--rc->count];
+		__this_cpu_inc(softnet_data.skb_recycle_hit);
+	} else {
+		__this_cpu_inc(softnet_data.skb_recycle_miss);
+	}
+	local_irq_restore(flags);
+
+	return skb;
+}
+
+static bool skb_recycle_put(struct sk_buff *skb)
+{
+	struct skb_recycle_cache *rc;
+	unsigned long flags;
+	bool parked = false;
+
+	if (!static_branch_unlikely(&skb_recycle_key))
+		return false;
+
+	local_irq_save(flags);
+	rc = this_cpu_ptr(&skb_recycle_cache);
+	if (rc->count < SKB_RECYCLE_CACHE_SIZE) {
+		rc->skbs[rc->count++] = skb;
+		parked = true;
+	}
+	local_irq_restore(flags);
+
+	return parked;
+}
+
+static struct sk_buff *skb_head_alloc(struct kmem_cache *cache, gfp_t gfp_mask,
+				      int flags, int node)
+{
+	struct sk_buff *skb;
+
+	if ((flags & SKB_ALLOC_RECYCLE) && cache == skbuff_head_cache) {
+		skb = skb_recycle_get();
+		if (skb)
+			return skb;
+	}
+
+	return kmem_cache_alloc_node(cache, gfp_mask & ~__GFP_DMA, node);
+}
+
 /* 	Allocate a new skbuff. We do this ourselves so we can fill in a few
  *	'private' fields and also do memory statistics to find all the
  *	[BEEP] leaks.
@@ -170,6 +261,8 @@ static void *__kmalloc_reserve(size_t size, gfp_t flags, int node,
  *		instead of head cache and allocate a cloned (child) skb.
  *		If SKB_ALLOC_RX is set, __GFP_MEMALLOC will be used for
  *		allocations in case the data is required for writeback
+ *		If SKB_ALLOC_RECYCLE is set, the head is taken from the per
+ *		CPU recycle cache when possible
  *	@node: numa node to allocate memory on
  *
  *	Allocate a new &sk_buff. The returned buffer has no headroom and a
@@ -195,7 +288,7 @@ struct sk_buff *__alloc_skb(unsigned int size, gfp_t gfp_mask,
 		gfp_mask |= __GFP_MEMALLOC;
 
 	/* Get the HEAD */
-	skb = kmem_cache_alloc_node(cache, gfp_mask & ~__GFP_DMA, node);
+	skb = skb_head_alloc(cache, gfp_mask, flags, node);
 	if (!skb)
 		goto out;
 	prefetchw(skb);
@@ -304,11 +397,13 @@ static struct sk_buff *__build_skb_around(struct sk_buff *skb,
  *  before giving packet to stack.
  *  RX rings only contains data buffers, not full skbs.
  */
-struct sk_buff *__build_skb(void *data, unsigned int frag_size)
+static struct sk_buff *__build_skb_flags(void *data, unsigned int frag_size,
+					 int flags)
 {
 	struct sk_buff *skb;
 
-	skb = kmem_cache_alloc(skbuff_head_cache, GFP_ATOMIC);
+	skb = skb_head_alloc(skbuff_head_cache, GFP_ATOMIC, flags,
+			     NUMA_NO_NODE);
 	if (unlikely(!skb))
 		return NULL;
 
@@ -317,6 +412,11 @@ struct sk_buff *__build_skb(void *data, unsigned int frag_size)
 	return __build_skb_around(skb, data, frag_size);
 }
 
+struct sk_buff *__build_skb(void *data, unsigned int frag_size)
+{
+	return __build_skb_flags(data, frag_size, 0);
+}
+
 /* build_skb() is wrapper over __build_skb(), that specifically
  * takes care of skb->head and skb->pfmemalloc
  * This means that if @frag_size is not zero, then @data must be backed
@@ -409,21 +509,9 @@ void *netdev_alloc_frag(unsigned int fragsz)
 }
 EXPORT_SYMBOL(netdev_alloc_frag);
 
-/**
- *	__netdev_alloc_skb - allocate an skbuff for rx on a specific device
- *	@dev: network device to receive on
- *	@len: length to allocate
- *	@gfp_mask: get_free_pages mask, passed to alloc_skb
- *
- *	Allocate a new &sk_buff and assign it a usage count of one. The
- *	buffer has NET_SKB_PAD headroom built in. Users should allocate
- *	the headroom they think they need without accounting for the
- *	built in space. The built in space is used for optimisations.
- *
- *	%NULL is returned if there is no free memory.
- */
-struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
-				   gfp_t gfp_mask)
+static struct sk_buff *netdev_alloc_skb_flags(struct net_device *dev,
+					      unsigned int len, gfp_t gfp_mask,
+					      int flags)
 {
 	struct page_frag_cache *nc;
 	struct sk_buff *skb;
@@ -438,7 +526,8 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 	if (len <= SKB_WITH_OVERHEAD(1024) ||
 	    len > SKB_WITH_OVERHEAD(PAGE_SIZE) ||
 	    (gfp_mask & (__GFP_DIRECT_RECLAIM | GFP_DMA))) {
-		skb = __alloc_skb(len, gfp_mask, SKB_ALLOC_RX, NUMA_NO_NODE);
+		skb = __alloc_skb(len, gfp_mask, SKB_ALLOC_RX | flags,
+				  NUMA_NO_NODE);
 		if (!skb)
 			goto skb_fail;
 		goto skb_success;
@@ -465,7 +554,7 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 	if (unlikely(!data))
 		return NULL;
 
-	skb = __build_skb(data, len);
+	skb = __build_skb_flags(data, len, flags);
 	if (unlikely(!skb)) {
 		skb_free_frag(data);
 		return NULL;
@@ -483,8 +572,43 @@ struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
 skb_fail:
 	return skb;
 }
+
+/**
+ *	__netdev_alloc_skb - allocate an skbuff for rx on a specific device
+ *	@dev: network device to receive on
+ *	@len: length to allocate
+ *	@gfp_mask: get_free_pages mask, passed to alloc_skb
+ *
+ *	Allocate a new &sk_buff and assign it a usage count of one. The
+ *	buffer has NET_SKB_PAD headroom built in. Users should allocate
+ *	the headroom they think they need without accounting for the
+ *	built in space. The built in space is used for optimisations.
+ *
+ *	%NULL is returned if there is no free memory.
+ */
+struct sk_buff *__netdev_alloc_skb(struct net_device *dev, unsigned int len,
+				   gfp_t gfp_mask)
+{
+	return netdev_alloc_skb_flags(dev, len, gfp_mask, 0);
+}
 EXPORT_SYMBOL(__netdev_alloc_skb);
 
+/**
+ *	__netdev_alloc_skb_recycle - allocate an rx skbuff from the recycle cache
+ *	@dev: network device to receive on
+ *	@len: length to allocate
+ *	@gfp_mask: get_free_pages mask, passed to alloc_skb
+ *
+ *	Like __netdev_alloc_skb(), but takes the head from the per CPU recycle
+ *	cache when possible. Users should call skb_recycle_register() first.
+ */
+struct sk_buff *__netdev_alloc_skb_recycle(struct net_device *dev,
+					   unsigned int len, gfp_t gfp_mask)
+{
+	return netdev_alloc_skb_flags(dev, len, gfp_mask, SKB_ALLOC_RECYCLE);
+}
+EXPORT_SYMBOL(__netdev_alloc_skb_recycle);
+
 /**
  *	__napi_alloc_skb - allocate skbuff for rx in a specific NAPI instance
  *	@napi: napi instance this buffer was allocated for
@@ -630,7 +754,8 @@ static void kfree_skbmem(struct sk_buff *skb)
 
 	switch (skb->fclone) {
 	case SKB_FCLONE_UNAVAILABLE:
-		kmem_cache_free(skbuff_head_cache, skb);
+		if (!skb_recycle_put(skb))
+			kmem_cache_free(skbuff_head_cache, skb);
 		return;
 
 	case SKB_FCLONE_ORIG:
@@ -289,6 +289,8 @@ static const struct snmp_mib snmp4_net_list[] = {
 	SNMP_MIB_ITEM("TCPRcvQDrop", LINUX_MIB_TCPRCVQDROP),
 	SNMP_MIB_ITEM("TCPWqueueTooBig", LINUX_MIB_TCPWQUEUETOOBIG),
 	SNMP_MIB_ITEM("TCPFastOpenPassiveAltKey", LINUX_MIB_TCPFASTOPENPASSIVEALTKEY),
+	SNMP_MIB_ITEM("TCPPacingTimer", LINUX_MIB_TCPPACINGTIMER),
+	SNMP_MIB_ITEM("TCPPacingTimerDelayUs", LINUX_MIB_TCPPACINGTIMERDELAYUS),
 	SNMP_MIB_SENTINEL
 };
 
@@ -438,10 +438,55 @@ static void tcp_grow_window(struct sock *sk, const struct sk_buff *skb)
 /* 3. Try to fixup all. It is made immediately after connection enters
  *    established state.
  */
+/* Size the receive buffer for the bandwidth-delay product of the link when
+ * its driver or userspace published a capacity estimate, using the same
+ * factors as tcp_rcv_space_adjust(). Without this, fast links only open the
+ * window after a few round trips of autotuning, by which time short
+ * transfers are over. Returns the window to open up front, or 0.
+ */
+static u32 tcp_link_capacity_seed(struct sock *sk)
+{
+	const struct dst_entry *dst = __sk_dst_get(sk);
+	struct tcp_sock *tp = tcp_sk(sk);
+	struct net *net = sock_net(sk);
+	int rcvmem, rcvbuf;
+	unsigned int kbps;
+	u64 rcvwin;
+
+	if (!dst || !dst->dev || !tp->srtt_us)
+		return 0;
+
+	kbps = READ_ONCE(dst->dev->link_capacity_kbps);
+	if (!kbps)
+		return 0;
+
+	if (!net->ipv4.sysctl_tcp_moderate_rcvbuf ||
+	    (sk->sk_userlocks & SOCK_RCVBUF_LOCK))
+		return 0;
+
+	/* Bytes in flight over one smoothed RTT at the link rate */
+	rcvwin = (u64)kbps * (1000 / 8) * (tp->srtt_us >> 3);
+	do_div(rcvwin, USEC_PER_SEC);
+	rcvwin = (rcvwin << 1) + 16 * tp->advmss;
+
+	rcvmem = SKB_TRUESIZE(tp->advmss + MAX_TCP_HEADER);
+	while (tcp_win_from_space(sk, rcvmem) < tp->advmss)
+		rcvmem += 128;
+
+	rcvbuf = min_t(u64, div_u64(rcvwin, tp->advmss) * rcvmem,
+		       net->ipv4.sysctl_tcp_rmem[2]);
+	if (rcvbuf > sk->sk_rcvbuf)
+		WRITE_ONCE(sk->sk_rcvbuf, rcvbuf);
+
+	tp->rcv_link_kbps = kbps;
+	return min_t(u64, rcvwin, tcp_win_from_space(sk, sk->sk_rcvbuf));
+}
+
 void tcp_init_buffer_space(struct sock *sk)
 {
 	int tcp_app_win = sock_net(sk)->ipv4.sysctl_tcp_app_win;
 	struct tcp_sock *tp = tcp_sk(sk);
+	u32 seed;
 	int maxwin;
 
 	if (!(sk->sk_userlocks & SOCK_SNDBUF_LOCK))
@@ -451,6 +496,7 @@ void tcp_init_buffer_space(struct sock *sk)
 	tp->rcvq_space.time = tp->tcp_mstamp;
 	tp->rcvq_space.seq = tp->copied_seq;
 
+	seed = tcp_link_capacity_seed(sk);
 	maxwin = tcp_full_space(sk);
 
 	if (tp->window_clamp >= maxwin) {
@@ -469,6 +515,10 @@ void tcp_init_buffer_space(struct sock *sk)
 		tp->window_clamp = max(2 * tp->advmss, maxwin - tp->advmss);
 
 	tp->rcv_ssthresh = min(tp->rcv_ssthresh, tp->window_clamp);
+	/* Let the window open to the link's BDP without waiting for growth */
+	if (seed)
+		tp->rcv_ssthresh = min(max(tp->rcv_ssthresh, seed),
+				       tp->window_clamp);
 	tp->snd_cwnd_stamp = tcp_jiffies32;
 	tp->rcvq_space.space = min3(tp->rcv_ssthresh, tp->rcv_wnd,
 				    (u32)TCP_INIT_CWND * tp->advmss);
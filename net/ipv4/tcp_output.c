@@ -974,7 +974,12 @@ enum hrtimer_restart tcp_pace_kick(struct hrtimer *timer)
 {
 	struct tcp_sock *tp = container_of(timer, struct tcp_sock, pacing_timer);
 	struct sock *sk = (struct sock *)tp;
+	s64 delay = ktime_to_ns(ktime_sub(hrtimer_cb_get_time(timer),
+					  hrtimer_get_softexpires(timer)));
 
+	if (delay > 0)
+		__NET_ADD_STATS(sock_net(sk), LINUX_MIB_TCPPACINGTIMERDELAYUS,
+				div_u64(delay, NSEC_PER_USEC));
 	tcp_tsq_handler(sk);
 	sock_put(sk);
 
@@ -2248,10 +2253,20 @@ static bool tcp_pacing_check(struct sock *sk)
 		return false;
 
 	if (!hrtimer_is_queued(&tp->pacing_timer)) {
-		hrtimer_start(&tp->pacing_timer,
-			      ns_to_ktime(tp->tcp_wstamp_ns),
-			      HRTIMER_MODE_ABS_PINNED_SOFT);
+		u64 slack = (u64)sock_net(sk)->ipv4.sysctl_tcp_pacing_slack_us *
+			    NSEC_PER_USEC;
+
+		/* Slack lets the pacing timers of many flows on this CPU
+		 * expire together. A send is never delayed by more than the
+		 * gap it waits for, and tcp_update_skb_after_send() credits
+		 * part of the delay back.
+		 */
+		slack = min(slack, tp->tcp_wstamp_ns - tp->tcp_clock_cache);
+		hrtimer_start_range_ns(&tp->pacing_timer,
+				       ns_to_ktime(tp->tcp_wstamp_ns), slack,
+				       HRTIMER_MODE_ABS_PINNED_SOFT);
 		sock_hold(sk);
+		NET_INC_STATS(sock_net(sk), LINUX_MIB_TCPPACINGTIMER);
 	}
 	return true;
 }
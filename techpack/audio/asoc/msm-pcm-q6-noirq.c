@@ -14,6 +14,8 @@
 #include <linux/of_device.h>
 #include <linux/dma-mapping.h>
 #include <linux/dma-buf.h>
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 
 #include <sound/core.h>
 #include <sound/soc.h>
@@ -191,6 +193,39 @@ static void event_handler(uint32_t opcode,
 	}
 }
 
+/*
+ * Streams using read/write instead of mmap still move their data through the
+ * shared circular buffer, without a command per buffer to the DSP. The DSP
+ * does not signal period boundaries in this mode, so a local timer provides
+ * the period wakeups those clients block on.
+ */
+static void msm_pcm_period_work(struct work_struct *work)
+{
+	struct msm_audio *prtd = container_of(work, struct msm_audio,
+					      period_work);
+
+	if (atomic_read(&prtd->start))
+		snd_pcm_period_elapsed(prtd->substream);
+}
+
+static enum hrtimer_restart msm_pcm_period_timer(struct hrtimer *timer)
+{
+	struct msm_audio *prtd = container_of(timer, struct msm_audio,
+					      period_timer);
+
+	queue_work(system_highpri_wq, &prtd->period_work);
+	hrtimer_forward_now(timer, prtd->period_time);
+
+	return HRTIMER_RESTART;
+}
+
+static bool msm_pcm_needs_period_timer(struct snd_pcm_substream *substream)
+{
+	struct msm_audio *prtd = substream->runtime->private_data;
+
+	return !prtd->mmap_flag && !substream->runtime->no_period_wakeup;
+}
+
 static int msm_pcm_open(struct snd_pcm_substream *substream)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
@@ -266,6 +301,9 @@ static int msm_pcm_open(struct snd_pcm_substream *substream)
 	}
 	prtd->dsp_cnt = 0;
 	prtd->set_channel_map = false;
+	hrtimer_init(&prtd->period_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	prtd->period_timer.function = msm_pcm_period_timer;
+	INIT_WORK(&prtd->period_work, msm_pcm_period_work);
 	runtime->private_data = prtd;
 	return 0;
 
@@ -432,10 +470,14 @@ static int msm_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
 		if (ret)
 			break;
 		atomic_set(&prtd->start, 1);
+		if (msm_pcm_needs_period_timer(substream))
+			hrtimer_start(&prtd->period_timer, prtd->period_time,
+				      HRTIMER_MODE_REL);
 		break;
 	case SNDRV_PCM_TRIGGER_STOP:
 		pr_debug("%s: SNDRV_PCM_TRIGGER_STOP\n", __func__);
 		atomic_set(&prtd->start, 0);
+		hrtimer_cancel(&prtd->period_timer);
 		q6asm_cmd(prtd->audio_client, CMD_PAUSE);
 		q6asm_cmd(prtd->audio_client, CMD_FLUSH);
 		buf = q6asm_shared_io_buf(prtd->audio_client, dir);
@@ -451,6 +493,7 @@ static int msm_pcm_trigger(struct snd_pcm_substream *substream, int cmd)
 		pr_debug("%s: SNDRV_PCM_TRIGGER_PAUSE\n", __func__);
 		ret = q6asm_cmd_nowait(prtd->audio_client, CMD_PAUSE);
 		atomic_set(&prtd->start, 0);
+		hrtimer_cancel(&prtd->period_timer);
 		break;
 	default:
 		ret = -EINVAL;
@@ -586,12 +629,6 @@ static snd_pcm_uframes_t msm_pcm_pointer(struct snd_pcm_substream *substream)
 	return (hw_ptr/period_size) * period_size;
 }
 
-static int msm_pcm_copy(struct snd_pcm_substream *substream, int a,
-	 unsigned long hwoff, void __user *buf, unsigned long fbytes)
-{
-	return -EINVAL;
-}
-
 static int msm_pcm_mmap(struct snd_pcm_substream *substream,
 				struct vm_area_struct *vma)
 {
@@ -632,9 +669,12 @@ static int msm_pcm_prepare(struct snd_pcm_substream *substream)
 		.rampingcurve = SOFT_VOLUME_CURVE_LINEAR,
 	};
 
-	if (!prtd || !prtd->mmap_flag)
+	if (!prtd)
 		return -EIO;
 
+	prtd->period_time = ns_to_ktime(div_u64((u64)runtime->period_size *
+						NSEC_PER_SEC, runtime->rate));
+
 	if (prtd->audio_client) {
 		rc = q6asm_set_softvolume_v2(prtd->audio_client,
 						&softvol, SOFT_VOLUME_INSTANCE_1);
@@ -675,6 +715,9 @@ static int msm_pcm_close(struct snd_pcm_substream *substream)
 		return -ENODEV;
 	}
 
+	hrtimer_cancel(&prtd->period_timer);
+	cancel_work_sync(&prtd->period_work);
+
 	mutex_lock(&pdata->lock);
 	if (ac) {
 		if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK)
@@ -1405,7 +1448,6 @@ static int msm_asoc_pcm_new(struct snd_soc_pcm_runtime *rtd)
 static const struct snd_pcm_ops msm_pcm_ops = {
 	.open           = msm_pcm_open,
 	.prepare        = msm_pcm_prepare,
-	.copy_user      = msm_pcm_copy,
 	.hw_params	= msm_pcm_hw_params,
 	.ioctl          = msm_pcm_ioctl,
 #if IS_ENABLED(CONFIG_COMPAT) && IS_ENABLED(CONFIG_AUDIO_QGKI)
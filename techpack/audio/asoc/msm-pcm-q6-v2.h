@@ -7,6 +7,8 @@
 
 #ifndef _MSM_PCM_H
 #define _MSM_PCM_H
+#include <linux/hrtimer.h>
+#include <linux/workqueue.h>
 #include <dsp/apr_audio-v2.h>
 #include <dsp/q6asm-v2.h>
 #include "msm-pcm-routing-v2.h"
@@ -99,6 +101,10 @@ struct msm_audio {
 	bool meta_data_mode;
 	uint32_t volume;
 	bool compress_enable;
+	/* period wakeups for read/write streams on a shared ring */
+	struct hrtimer period_timer;
+	struct work_struct period_work;
+	ktime_t period_time;
 	/* array of frame info */
 	struct msm_audio_in_frame_info in_frame_info[CAPTURE_MAX_NUM_PERIODS];
 };
@@ -11,6 +11,9 @@
 #include <linux/mutex.h>
 #include <linux/of_device.h>
 #include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
 #include <sound/core.h>
 #include <sound/soc.h>
 #include <sound/soc-dapm.h>
@@ -2298,6 +2301,288 @@ int msm_pcm_routing_set_channel_mixer_runtime(int be_id, int session_id,
 }
 EXPORT_SYMBOL(msm_pcm_routing_set_channel_mixer_runtime);
 
+/*
+ * Low latency playback streams (touch tones, game effects) are opened and
+ * closed in quick succession. Once the last stream on such a COPP closes,
+ * the COPP is parked on its backend for copp_park_ms instead of being
+ * closed on the DSP. A stream that opens on the same backend with the same
+ * configuration within that window takes the parked COPP over and skips
+ * the ADM open, calibration and topology load. Parked COPPs that do not
+ * match a new request are closed first, so ADM never shares a COPP with
+ * a different channel count or device. Closing the backend releases
+ * everything parked on it.
+ */
+#define MSM_ROUTING_COPP_CACHE_SIZE	8
+
+static unsigned int copp_park_ms = 500;
+module_param(copp_park_ms, uint, 0644);
+MODULE_PARM_DESC(copp_park_ms,
+		 "Time in ms to keep a low latency playback COPP open after its last stream closed, 0 to disable");
+
+struct msm_routing_copp_cfg {
+	int port_id;
+	int perf_mode;
+	int topology;
+	int app_type;
+	int acdb_dev_id;
+	u32 sample_rate;
+	u32 channels;
+	u16 bits_per_sample;
+	u32 copp_token;
+};
+
+struct msm_routing_copp_cache {
+	bool used;
+	bool parked;
+	int be_id;
+	int copp_idx;
+	int users;
+	unsigned long expires;
+	struct msm_routing_copp_cfg cfg;
+};
+
+static struct msm_routing_copp_cache copp_cache[MSM_ROUTING_COPP_CACHE_SIZE];
+
+enum {
+	ROUTING_SETUP_ADM_OPEN,
+	ROUTING_SETUP_PP,
+	ROUTING_SETUP_MATRIX,
+	ROUTING_SETUP_CHMIX,
+	ROUTING_SETUP_TOTAL,
+	ROUTING_SETUP_MAX,
+};
+
+static const char * const routing_setup_names[ROUTING_SETUP_MAX] = {
+	"adm_open", "pp", "matrix", "chmix", "total",
+};
+
+struct msm_routing_setup_stat {
+	u64 count;
+	u64 total_us;
+	u32 max_us;
+};
+
+/* All protected by routing_lock */
+static struct msm_routing_setup_stat routing_setup_stats[ROUTING_SETUP_MAX];
+static u64 copp_cache_hits;
+static u64 copp_cache_parks;
+static u64 copp_cache_releases;
+
+static void msm_routing_copp_cache_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(copp_cache_work, msm_routing_copp_cache_work_fn);
+
+static void msm_routing_setup_account(int phase, ktime_t start)
+{
+	struct msm_routing_setup_stat *st = &routing_setup_stats[phase];
+	u64 us = ktime_us_delta(ktime_get(), start);
+
+	st->count++;
+	st->total_us += us;
+	if (us > st->max_us)
+		st->max_us = min_t(u64, us, U32_MAX);
+}
+
+static bool msm_routing_copp_cacheable(int session_type, int perf_mode)
+{
+	return READ_ONCE(copp_park_ms) && session_type == SESSION_TYPE_RX &&
+	       perf_mode == LOW_LATENCY_PCM_MODE;
+}
+
+static bool msm_routing_copp_cfg_match(const struct msm_routing_copp_cfg *a,
+				       const struct msm_routing_copp_cfg *b)
+{
+	return a->port_id == b->port_id && a->perf_mode == b->perf_mode &&
+	       a->topology == b->topology && a->app_type == b->app_type &&
+	       a->acdb_dev_id == b->acdb_dev_id &&
+	       a->sample_rate == b->sample_rate &&
+	       a->channels == b->channels &&
+	       a->bits_per_sample == b->bits_per_sample &&
+	       a->copp_token == b->copp_token;
+}
+
+static void msm_routing_copp_cache_release(struct msm_routing_copp_cache *c)
+{
+	int topology;
+
+	if (c->parked) {
+		topology = adm_get_topology_for_port_copp_idx(c->cfg.port_id,
+							      c->copp_idx);
+		pr_debug("%s: be %d copp %d\n", __func__, c->be_id,
+			 c->copp_idx);
+		msm_routing_unload_topology(topology);
+		adm_close(c->cfg.port_id, c->cfg.perf_mode, c->copp_idx);
+		copp_cache_releases++;
+	}
+	memset(c, 0, sizeof(*c));
+}
+
+/* Take over a parked COPP matching @cfg, or return a negative errno */
+static int msm_routing_copp_cache_get(int be_id,
+				      const struct msm_routing_copp_cfg *cfg)
+{
+	struct msm_routing_copp_cache *c, *hit = NULL;
+	int i;
+
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++) {
+		c = &copp_cache[i];
+		if (!c->used || c->be_id != be_id || !c->parked)
+			continue;
+		if (!hit && msm_routing_copp_cfg_match(&c->cfg, cfg))
+			hit = c;
+		else
+			msm_routing_copp_cache_release(c);
+	}
+
+	if (!hit)
+		return -ENOENT;
+
+	hit->parked = false;
+	hit->users = 1;
+	copp_cache_hits++;
+	return hit->copp_idx;
+}
+
+static void msm_routing_copp_cache_add(int be_id, int copp_idx,
+				       const struct msm_routing_copp_cfg *cfg)
+{
+	struct msm_routing_copp_cache *c, *slot = NULL;
+	int i;
+
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++) {
+		c = &copp_cache[i];
+		if (!c->used) {
+			if (!slot)
+				slot = c;
+			continue;
+		}
+		if (c->be_id == be_id && c->copp_idx == copp_idx &&
+		    !c->parked) {
+			c->users++;
+			return;
+		}
+	}
+
+	/* Untracked COPPs are simply closed as before */
+	if (!slot)
+		return;
+
+	slot->used = true;
+	slot->be_id = be_id;
+	slot->copp_idx = copp_idx;
+	slot->users = 1;
+	slot->cfg = *cfg;
+}
+
+/*
+ * Drop a stream's reference on a tracked COPP. Returns true if the COPP
+ * was parked, in which case the caller must not close it.
+ */
+static bool msm_routing_copp_cache_put(int be_id, int copp_idx,
+				       int session_type, int perf_mode)
+{
+	struct msm_routing_copp_cache *c;
+	unsigned int park_ms = READ_ONCE(copp_park_ms);
+	int i;
+
+	if (session_type != SESSION_TYPE_RX)
+		return false;
+
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++) {
+		c = &copp_cache[i];
+		if (c->used && !c->parked && c->be_id == be_id &&
+		    c->copp_idx == copp_idx && c->cfg.perf_mode == perf_mode)
+			break;
+	}
+	if (i == MSM_ROUTING_COPP_CACHE_SIZE)
+		return false;
+
+	if (--c->users > 0)
+		return false;
+
+	if (!park_ms) {
+		memset(c, 0, sizeof(*c));
+		return false;
+	}
+
+	c->parked = true;
+	c->expires = jiffies + msecs_to_jiffies(park_ms);
+	copp_cache_parks++;
+	schedule_delayed_work(&copp_cache_work, msecs_to_jiffies(park_ms));
+	return true;
+}
+
+/* Release parked COPPs and forget tracked ones on a backend going away */
+static void msm_routing_copp_cache_flush(int be_id)
+{
+	int i;
+
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++)
+		if (copp_cache[i].used && copp_cache[i].be_id == be_id)
+			msm_routing_copp_cache_release(&copp_cache[i]);
+}
+
+static void msm_routing_copp_cache_work_fn(struct work_struct *work)
+{
+	struct msm_routing_copp_cache *c;
+	unsigned long next = 0;
+	int i;
+
+	mutex_lock(&routing_lock);
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++) {
+		c = &copp_cache[i];
+		if (!c->used || !c->parked)
+			continue;
+		if (time_after_eq(jiffies, c->expires))
+			msm_routing_copp_cache_release(c);
+		else if (!next || time_before(c->expires, next))
+			next = c->expires;
+	}
+	if (next)
+		schedule_delayed_work(&copp_cache_work,
+				      time_after(next, jiffies) ?
+				      next - jiffies : 0);
+	mutex_unlock(&routing_lock);
+}
+
+static int msm_routing_setup_stats_show(struct seq_file *m, void *unused)
+{
+	struct msm_routing_setup_stat *st;
+	int i, parked = 0;
+
+	mutex_lock(&routing_lock);
+	for (i = 0; i < ROUTING_SETUP_MAX; i++) {
+		st = &routing_setup_stats[i];
+		seq_printf(m, "%-8s count %llu avg %llu us max %u us\n",
+			   routing_setup_names[i], st->count,
+			   st->count ? div64_u64(st->total_us, st->count) : 0,
+			   st->max_us);
+	}
+	for (i = 0; i < MSM_ROUTING_COPP_CACHE_SIZE; i++)
+		if (copp_cache[i].used && copp_cache[i].parked)
+			parked++;
+	seq_printf(m, "copp cache: hits %llu parks %llu releases %llu parked %d\n",
+		   copp_cache_hits, copp_cache_parks, copp_cache_releases,
+		   parked);
+	mutex_unlock(&routing_lock);
+
+	return 0;
+}
+
+static int msm_routing_setup_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, msm_routing_setup_stats_show,
+			   inode->i_private);
+}
+
+static const struct file_operations msm_routing_setup_stats_fops = {
+	.open = msm_routing_setup_stats_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static struct dentry *msm_routing_setup_dentry;
+
 int msm_pcm_routing_reg_phy_stream(int fedai_id, int perf_mode,
 					int dspst_id, int stream_type)
 {
@@ -2308,6 +2593,7 @@ int msm_pcm_routing_reg_phy_stream(int fedai_id, int perf_mode,
 	uint32_t passthr_mode = LEGACY_PCM;
 	int ret = 0;
 	uint32_t copp_token = 0;
+	ktime_t begin = ktime_get(), start;
 
 	if (fedai_id >= MSM_FRONTEND_DAI_MM_MAX_ID) {
 		/* bad ID assigned in machine driver */
@@ -2341,6 +2627,8 @@ int msm_pcm_routing_reg_phy_stream(int fedai_id, int perf_mode,
 		   (test_bit(fedai_id, &msm_bedais[i].fe_sessions[0]))) {
 			int app_type, app_type_idx, copp_idx, acdb_dev_id;
 			int port_id = get_port_id(msm_bedais[i].port_id);
+			struct msm_routing_copp_cfg cfg;
+			bool cacheable;
 
 			/*
 			 * check if ADM needs to be configured with different
@@ -2411,12 +2699,40 @@ int msm_pcm_routing_reg_phy_stream(int fedai_id, int perf_mode,
 						&ec_ref_chmix_cfg[fedai_id]);
 				/* reset ec_ref config */
 				ec_ref_chmix_cfg[fedai_id].output_channel = 0;
-			} else
-				copp_idx = adm_open(port_id, path_type,
-					    sample_rate, channels, topology,
-					    perf_mode, bits_per_sample,
-					    app_type, acdb_dev_id,
-					    session_type, passthr_mode, copp_token);
+			} else {
+				cacheable = msm_routing_copp_cacheable(
+						session_type, perf_mode);
+				copp_idx = -ENOENT;
+				if (cacheable) {
+					memset(&cfg, 0, sizeof(cfg));
+					cfg.port_id = port_id;
+					cfg.perf_mode = perf_mode;
+					cfg.topology = topology;
+					cfg.app_type = app_type;
+					cfg.acdb_dev_id = acdb_dev_id;
+					cfg.sample_rate = sample_rate;
+					cfg.channels = channels;
+					cfg.bits_per_sample = bits_per_sample;
+					cfg.copp_token = copp_token;
+					copp_idx = msm_routing_copp_cache_get(i,
+									      &cfg);
+				}
+				if (copp_idx < 0) {
+					start = ktime_get();
+					copp_idx = adm_open(port_id, path_type,
+						sample_rate, channels, topology,
+						perf_mode, bits_per_sample,
+						app_type, acdb_dev_id,
+						session_type, passthr_mode,
+						copp_token);
+					msm_routing_setup_account(
+						ROUTING_SETUP_ADM_OPEN, start);
+					if (cacheable && copp_idx >= 0 &&
+					    copp_idx < MAX_COPPS_PER_PORT)
+						msm_routing_copp_cache_add(i,
+							copp_idx, &cfg);
+				}
+			}
 			if ((copp_idx < 0) ||
 				(copp_idx >= MAX_COPPS_PER_PORT)) {
 				pr_err("%s: adm open failed copp_idx:%d\n",
@@ -2456,20 +2772,29 @@ int msm_pcm_routing_reg_phy_stream(int fedai_id, int perf_mode,
 					num_copps++;
 				}
 			}
-			if (perf_mode == LEGACY_PCM_MODE)
+			if (perf_mode == LEGACY_PCM_MODE) {
+				start = ktime_get();
 				msm_pcm_routing_cfg_pp(port_id, copp_idx,
 						       topology, channels);
+				msm_routing_setup_account(ROUTING_SETUP_PP,
+							  start);
+			}
 		}
 	}
 	if (num_copps) {
 		payload.num_copps = num_copps;
 		payload.session_id = fe_dai_map[fedai_id][session_type].strm_id;
+		start = ktime_get();
 		adm_matrix_map(fedai_id, path_type, payload, perf_mode, passthr_mode);
 		msm_pcm_routng_cfg_matrix_map_pp(payload, path_type, perf_mode);
+		msm_routing_setup_account(ROUTING_SETUP_MATRIX, start);
 	}
 
+	start = ktime_get();
 	ret = msm_pcm_routing_channel_mixer(fedai_id, perf_mode,
 				dspst_id, stream_type);
+	msm_routing_setup_account(ROUTING_SETUP_CHMIX, start);
+	msm_routing_setup_account(ROUTING_SETUP_TOTAL, begin);
 	mutex_unlock(&routing_lock);
 	return ret;
 }
@@ -2535,8 +2860,11 @@ void msm_pcm_routing_dereg_phy_stream(int fedai_id, int stream_type)
 			port_id = get_port_id(msm_bedais[i].port_id);
 			topology = adm_get_topology_for_port_copp_idx(
 					port_id, idx);
-			msm_routing_unload_topology(topology);
-			adm_close(port_id, fdai->perf_mode, idx);
+			if (!msm_routing_copp_cache_put(i, idx, session_type,
+							fdai->perf_mode)) {
+				msm_routing_unload_topology(topology);
+				adm_close(port_id, fdai->perf_mode, idx);
+			}
 			pr_debug("%s:copp:%ld,idx bit fe:%d,type:%d,be:%d\n",
 				 __func__, copp, fedai_id, session_type, i);
 			clear_bit(idx,
@@ -2761,8 +3089,11 @@ static void msm_pcm_routing_process_audio(u16 reg, u16 val, int set)
 			port_id = get_port_id(msm_bedais[reg].port_id);
 			topology = adm_get_topology_for_port_copp_idx(port_id,
 								      idx);
-			msm_routing_unload_topology(topology);
-			adm_close(port_id, fdai->perf_mode, idx);
+			if (!msm_routing_copp_cache_put(reg, idx, session_type,
+							fdai->perf_mode)) {
+				msm_routing_unload_topology(topology);
+				adm_close(port_id, fdai->perf_mode, idx);
+			}
 			pr_debug("%s: copp: %ld, reset idx bit fe:%d, type: %d, be:%d topology=0x%x\n",
 				 __func__, copp, val, session_type, reg,
 				 topology);
@@ -41379,6 +41710,7 @@ static int msm_pcm_routing_close(struct snd_pcm_substream *substream)
 		path_type = ADM_PATH_LIVE_REC;
 
 	mutex_lock(&routing_lock);
+	msm_routing_copp_cache_flush(be_id);
 	for_each_set_bit(i, &bedai->fe_sessions[0], MSM_FRONTEND_DAI_MAX) {
 		if (!is_mm_lsm_fe_id(i))
 			continue;
@@ -43268,11 +43600,17 @@ int __init msm_soc_routing_platform_init(void)
 
 	asrc_drift_init();
 
+	msm_routing_setup_dentry = debugfs_create_file("msm_pcm_routing_setup",
+					0444, NULL, NULL,
+					&msm_routing_setup_stats_fops);
+
 	return platform_driver_register(&msm_routing_pcm_driver);
 }
 
 void msm_soc_routing_platform_exit(void)
 {
+	debugfs_remove(msm_routing_setup_dentry);
+	cancel_delayed_work_sync(&copp_cache_work);
 	asrc_drift_deinit();
 	msm_routing_delete_cal_data();
 	memset(&be_dai_name_table, 0, sizeof(be_dai_name_table));
@@ -24,6 +24,7 @@
 #include <linux/delay.h>
 #include <linux/slab.h>
 #include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/time.h>
 #include <linux/atomic.h>
 #include <linux/mm.h>
@@ -97,11 +98,49 @@ struct asm_mmap {
 
 static struct asm_mmap this_mmap;
 
+#define ASM_LAT_MAX_BUFS		64
+#define ASM_LAT_HIST_BUCKETS		8
+#define ASM_LAT_HIST_BASE_US		500
+#define ASM_LAT_UNDERRUN_LOG		8
+
+struct asm_latency_underrun {
+	u64 time_ns;
+	u32 last_ack_us;
+	u32 inflight;
+};
+
+/*
+ * Per session latency tracker, protected by the session lock.
+ *
+ * ack:    host write command sent -> DSP write done, per buffer
+ * dsp_ts: age of the DSP render timestamp (AVTimer) when it reaches the host
+ *
+ * Histogram bucket n counts samples below ASM_LAT_HIST_BASE_US << n, the
+ * last bucket everything above.
+ */
+struct asm_latency {
+	u64 sent_ns[ASM_LAT_MAX_BUFS];
+	u32 inflight;
+	u32 last_ack_us;
+	u32 ack_hist[ASM_LAT_HIST_BUCKETS];
+	u64 ack_count;
+	u64 ack_total_us;
+	u32 ack_max_us;
+	u32 dsp_ts_hist[ASM_LAT_HIST_BUCKETS];
+	u64 dsp_ts_count;
+	u32 dsp_ts_max_us;
+	u32 underruns;
+	u32 underruns_slow_ack;
+	u32 underrun_head;
+	struct asm_latency_underrun underrun_log[ASM_LAT_UNDERRUN_LOG];
+};
+
 struct audio_session {
 	struct audio_client *ac;
 	spinlock_t session_lock;
 	struct mutex mutex_lock_per_session;
 	bool ignore;
+	struct asm_latency lat;
 };
 /* session id: 0 reserved */
 static struct audio_session session[ASM_ACTIVE_STREAMS_ALLOWED + 1];
@@ -257,6 +296,84 @@ static inline int q6asm_get_flag_from_token(union asm_token_struct *asm_token,
 }
 
 
+static int q6asm_latency_bucket(u32 us)
+{
+	return min_t(int, fls(us / ASM_LAT_HIST_BASE_US),
+		     ASM_LAT_HIST_BUCKETS - 1);
+}
+
+static void q6asm_latency_write_sent(struct audio_client *ac, int buf_index)
+{
+	struct asm_latency *lat;
+	unsigned long flags;
+
+	if (ac->session <= 0 || ac->session > ASM_ACTIVE_STREAMS_ALLOWED ||
+	    buf_index >= ASM_LAT_MAX_BUFS)
+		return;
+
+	lat = &session[ac->session].lat;
+	spin_lock_irqsave(&session[ac->session].session_lock, flags);
+	if (!lat->sent_ns[buf_index])
+		lat->inflight++;
+	lat->sent_ns[buf_index] = ktime_get_ns();
+	spin_unlock_irqrestore(&session[ac->session].session_lock, flags);
+}
+
+/* Called with the session lock held */
+static void q6asm_latency_write_done(struct asm_latency *lat, int buf_index)
+{
+	u32 us;
+
+	if (buf_index >= ASM_LAT_MAX_BUFS || !lat->sent_ns[buf_index])
+		return;
+
+	us = div_u64(ktime_get_ns() - lat->sent_ns[buf_index], NSEC_PER_USEC);
+	lat->sent_ns[buf_index] = 0;
+	lat->inflight--;
+
+	lat->last_ack_us = us;
+	lat->ack_hist[q6asm_latency_bucket(us)]++;
+	lat->ack_count++;
+	lat->ack_total_us += us;
+	lat->ack_max_us = max(lat->ack_max_us, us);
+}
+
+/* Called with the session lock held */
+static void q6asm_latency_dsp_ts(struct asm_latency *lat, uint64_t abs_time)
+{
+	uint64_t now;
+	u32 us;
+
+	if (!abs_time || avcs_core_query_timer(&now) || now < abs_time)
+		return;
+
+	us = min_t(uint64_t, now - abs_time, U32_MAX);
+	lat->dsp_ts_hist[q6asm_latency_bucket(us)]++;
+	lat->dsp_ts_count++;
+	lat->dsp_ts_max_us = max(lat->dsp_ts_max_us, us);
+}
+
+/*
+ * Called with the session lock held. An underrun is correlated with a slow
+ * DSP ack when the last ack took more than twice the session average.
+ */
+static void q6asm_latency_underrun(struct asm_latency *lat)
+{
+	struct asm_latency_underrun *u;
+	u64 avg_us;
+
+	u = &lat->underrun_log[lat->underrun_head++ % ASM_LAT_UNDERRUN_LOG];
+	u->time_ns = ktime_get_ns();
+	u->last_ack_us = lat->last_ack_us;
+	u->inflight = lat->inflight;
+
+	lat->underruns++;
+	avg_us = lat->ack_count ?
+		 div64_u64(lat->ack_total_us, lat->ack_count) : 0;
+	if (avg_us && lat->last_ack_us > 2 * avg_us)
+		lat->underruns_slow_ack++;
+}
+
 #ifdef CONFIG_DEBUG_FS
 #define OUT_BUFFER_SIZE 56
 #define IN_BUFFER_SIZE 24
@@ -499,8 +616,84 @@ static void config_debug_fs_write(struct audio_buffer *ab)
 		}
 	}
 }
+static void q6asm_latency_show_hist(struct seq_file *m, const char *name,
+				    const u32 *hist)
+{
+	int i;
+
+	seq_printf(m, "  %-7s", name);
+	for (i = 0; i < ASM_LAT_HIST_BUCKETS; i++)
+		seq_printf(m, " %8u", hist[i]);
+	seq_puts(m, "\n");
+}
+
+static int q6asm_latency_show(struct seq_file *m, void *unused)
+{
+	struct asm_latency *lat;
+	struct asm_latency_underrun *u;
+	unsigned long flags;
+	int n, i, cnt;
+
+	lat = kmalloc(sizeof(*lat), GFP_KERNEL);
+	if (!lat)
+		return -ENOMEM;
+
+	seq_printf(m, "histogram upper bounds (us):");
+	for (i = 0; i < ASM_LAT_HIST_BUCKETS - 1; i++)
+		seq_printf(m, " %u", ASM_LAT_HIST_BASE_US << i);
+	seq_puts(m, " inf\n");
+
+	for (n = 1; n <= ASM_ACTIVE_STREAMS_ALLOWED; n++) {
+		spin_lock_irqsave(&session[n].session_lock, flags);
+		if (!session[n].ac) {
+			spin_unlock_irqrestore(&session[n].session_lock, flags);
+			continue;
+		}
+		*lat = session[n].lat;
+		spin_unlock_irqrestore(&session[n].session_lock, flags);
+
+		seq_printf(m, "session %d: acks %llu avg %llu us max %u us, inflight %u\n",
+			   n, lat->ack_count,
+			   lat->ack_count ?
+			   div64_u64(lat->ack_total_us, lat->ack_count) : 0,
+			   lat->ack_max_us, lat->inflight);
+		q6asm_latency_show_hist(m, "ack", lat->ack_hist);
+		seq_printf(m, "  dsp_ts %llu max %u us\n",
+			   lat->dsp_ts_count, lat->dsp_ts_max_us);
+		q6asm_latency_show_hist(m, "dsp_ts", lat->dsp_ts_hist);
+		seq_printf(m, "  underruns %u, after slow ack %u\n",
+			   lat->underruns, lat->underruns_slow_ack);
+
+		cnt = min_t(u32, lat->underruns, ASM_LAT_UNDERRUN_LOG);
+		for (i = 0; i < cnt; i++) {
+			u = &lat->underrun_log[(lat->underrun_head - cnt + i) %
+					       ASM_LAT_UNDERRUN_LOG];
+			seq_printf(m, "    at %llu ns: last ack %u us, inflight %u\n",
+				   u->time_ns, u->last_ack_us, u->inflight);
+		}
+	}
+
+	kfree(lat);
+	return 0;
+}
+
+static int q6asm_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, q6asm_latency_show, inode->i_private);
+}
+
+static const struct file_operations q6asm_latency_fops = {
+	.open = q6asm_latency_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static void config_debug_fs_init(void)
 {
+	debugfs_create_file("q6asm_latency", 0444, NULL, NULL,
+			    &q6asm_latency_fops);
+
 	out_buffer = kzalloc(OUT_BUFFER_SIZE, GFP_KERNEL);
 	if (out_buffer == NULL)
 		goto outbuf_fail;
@@ -578,6 +771,7 @@ static int q6asm_session_alloc(struct audio_client *ac)
 
 	for (n = 1; n <= ASM_ACTIVE_STREAMS_ALLOWED; n++) {
 		if (!(session[n].ac)) {
+			memset(&session[n].lat, 0, sizeof(session[n].lat));
 			session[n].ac = ac;
 			return n;
 		}
@@ -658,6 +852,7 @@ static int q6asm_session_try_next(struct audio_client *ac)
 		if (!session[s].ignore && !session[s].ac) {
 			q6asm_session_deregister(ac);
 			session[ac->session].ac = NULL;
+			memset(&session[s].lat, 0, sizeof(session[s].lat));
 			session[s].ac = ac;
 			ac->session = s;
 			return q6asm_session_register(ac);
@@ -2022,6 +2217,9 @@ static void q6asm_process_mtmx_get_param_rsp(struct audio_client *ac,
 				dev_warn_ratelimited(ac->dev,
 						     "%s: recv inval tstmp\n",
 						     __func__);
+			else
+				q6asm_latency_dsp_ts(&session[ac->session].lat,
+						     ac->dsp_ts.abs_time_stamp);
 			if (atomic_cmpxchg(&ac->time_flag, 1, 0))
 				wake_up(&ac->time_wait);
 
@@ -2370,6 +2568,8 @@ static int32_t q6asm_callback(struct apr_client_data *data, void *priv)
 			port->buf[buf_index].used = 1;
 			spin_unlock_irqrestore(&port->dsp_lock, dsp_flags);
 
+			q6asm_latency_write_done(&session[session_id].lat,
+						 buf_index);
 			config_debug_fs_write_cb();
 
 			for (i = 0; i < port->max_buf_cnt; i++)
@@ -2504,6 +2704,7 @@ static int32_t q6asm_callback(struct apr_client_data *data, void *priv)
 				__func__, ac->session,
 				data->opcode, data->token,
 				data->src_port, data->dest_port);
+		q6asm_latency_underrun(&session[session_id].lat);
 		break;
 	case ASM_SESSION_CMDRSP_GET_SESSIONTIME_V3:
 		if (data->payload_size >= 3 * sizeof(uint32_t)) {
@@ -10033,6 +10234,7 @@ int q6asm_write(struct audio_client *ac, uint32_t len, uint32_t msw_ts,
 		mutex_unlock(&port->lock);
 
 		config_debug_fs_write(ab);
+		q6asm_latency_write_sent(ac, dsp_buf);
 
 		rc = apr_send_pkt(ac->apr, (uint32_t *) &write);
 		if (rc < 0) {
@@ -10125,6 +10327,8 @@ int q6asm_write_nolock(struct audio_client *ac, uint32_t len, uint32_t msw_ts,
 				write.buf_size,
 				write.mem_map_handle);
 
+		q6asm_latency_write_sent(ac, write.seq_id);
+
 		rc = apr_send_pkt(ac->apr, (uint32_t *) &write);
 		if (rc < 0) {
 			pr_err("%s: write op[0x%x]rc[%d]\n",
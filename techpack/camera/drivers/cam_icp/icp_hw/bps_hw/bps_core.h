@@ -10,10 +10,16 @@
 #include <linux/io.h>
 #include <linux/of.h>
 #include <linux/platform_device.h>
+#include <linux/ktime.h>
+
+#include "cam_soc_util.h"
 
 #define BPS_COLLAPSE_MASK 0x1
 #define BPS_PWR_ON_MASK   0x2
 
+/* Pixels the core retires per clock, used to turn workloads into rates */
+#define BPS_WORKLOAD_PIXELS_PER_CLK 4
+
 struct cam_bps_device_hw_info {
 	uint32_t hw_idx;
 	uint32_t pwr_ctrl;
@@ -21,11 +27,28 @@ struct cam_bps_device_hw_info {
 	uint32_t reserved;
 };
 
+/**
+ * struct cam_bps_device_core_info
+ * @bps_hw_info:       power control register offsets
+ * @cpas_handle:       cpas client handle
+ * @cpas_start:        cpas has been started
+ * @clk_enable:        core clocks are on
+ * @clk_level:         clock level currently voted
+ * @clk_level_ts:      time @clk_level was entered
+ * @clk_residency_us:  time spent at each clock level
+ * @workload_votes:    per request workload votes
+ * @workload_prevotes: votes raised for the request queued next
+ */
 struct cam_bps_device_core_info {
 	struct cam_bps_device_hw_info *bps_hw_info;
 	uint32_t cpas_handle;
 	bool cpas_start;
 	bool clk_enable;
+	int32_t clk_level;
+	ktime_t clk_level_ts;
+	uint64_t clk_residency_us[CAM_MAX_VOTE];
+	uint32_t workload_votes;
+	uint32_t workload_prevotes;
 };
 
 int cam_bps_init_hw(void *device_priv,
@@ -31,6 +31,7 @@ enum cam_icp_bps_cmd_type {
 	CAM_ICP_BPS_CMD_UPDATE_CLK,
 	CAM_ICP_BPS_CMD_DISABLE_CLK,
 	CAM_ICP_BPS_CMD_RESET,
+	CAM_ICP_BPS_CMD_WORKLOAD_CLK,
 	CAM_ICP_BPS_CMD_MAX,
 };
 
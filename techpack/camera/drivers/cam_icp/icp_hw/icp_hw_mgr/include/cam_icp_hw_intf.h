@@ -6,6 +6,8 @@
 #ifndef CAM_ICP_HW_INTF_H
 #define CAM_ICP_HW_INTF_H
 
+#include <linux/math64.h>
+
 #define CAM_ICP_CMD_BUF_MAX_SIZE     128
 #define CAM_ICP_MSG_BUF_MAX_SIZE     CAM_ICP_CMD_BUF_MAX_SIZE
 
@@ -61,4 +63,72 @@ struct cam_icp_clk_update_cmd {
 	int32_t clk_level;
 };
 
+/**
+ * struct cam_icp_workload_desc - Processing load of one ICP request
+ *
+ * @request_id:      request the workload belongs to, 0 if unused
+ * @pixel_count:     pixels processed in one pass
+ * @num_passes:      number of passes over the frame
+ * @bits_per_pixel:  average fetched plus written bits per pixel
+ * @ubwc_ratio_pct:  compressed to uncompressed size in percent,
+ *                   0 or 100 for linear formats
+ * @budget_ns:       time the request has to complete in
+ */
+struct cam_icp_workload_desc {
+	uint64_t  request_id;
+	uint32_t  pixel_count;
+	uint32_t  num_passes;
+	uint32_t  bits_per_pixel;
+	uint32_t  ubwc_ratio_pct;
+	uint64_t  budget_ns;
+};
+
+/**
+ * struct cam_icp_workload_clk_cmd - Payload for per request clk voting
+ *
+ * @curr:              workload of the request being submitted
+ * @next:              workload of the request queued behind it, voted
+ *                     ahead so its clock is in place when it starts
+ * @ipe_bps_pc_enable: power collpase enable flag
+ * @clk_rate:          clk rate that was voted, populated as output
+ * @clk_level:         clk level of @clk_rate, populated as output
+ */
+struct cam_icp_workload_clk_cmd {
+	struct cam_icp_workload_desc curr;
+	struct cam_icp_workload_desc next;
+	bool  ipe_bps_pc_enable;
+	uint32_t clk_rate;
+	int32_t clk_level;
+};
+
+static inline uint64_t cam_icp_workload_clk_rate(
+	struct cam_icp_workload_desc *desc, uint32_t pixels_per_clk)
+{
+	uint64_t cycles;
+
+	if (!desc->budget_ns || !pixels_per_clk)
+		return 0;
+
+	cycles = (uint64_t)desc->pixel_count * max(desc->num_passes, 1u);
+	return div64_u64(cycles * NSEC_PER_SEC,
+		(uint64_t)pixels_per_clk * desc->budget_ns);
+}
+
+static inline uint64_t cam_icp_workload_bw(struct cam_icp_workload_desc *desc)
+{
+	uint64_t bytes;
+	uint32_t ratio = desc->ubwc_ratio_pct;
+
+	if (!desc->budget_ns)
+		return 0;
+
+	if (!ratio || ratio > 100)
+		ratio = 100;
+
+	bytes = (uint64_t)desc->pixel_count * max(desc->num_passes, 1u) *
+		desc->bits_per_pixel / BITS_PER_BYTE;
+	return div64_u64(bytes * ratio * (NSEC_PER_SEC / 100),
+		desc->budget_ns);
+}
+
 #endif
@@ -31,6 +31,7 @@ enum cam_icp_ipe_cmd_type {
 	CAM_ICP_IPE_CMD_UPDATE_CLK,
 	CAM_ICP_IPE_CMD_DISABLE_CLK,
 	CAM_ICP_IPE_CMD_RESET,
+	CAM_ICP_IPE_CMD_WORKLOAD_CLK,
 	CAM_ICP_IPE_CMD_MAX,
 };
 
@@ -102,6 +102,7 @@ int cam_ipe_init_hw(void *device_priv,
 			core_info->cpas_start = false;
 	} else {
 		core_info->clk_enable = true;
+		cam_ipe_clk_residency_update(core_info, CAM_SVS_VOTE);
 	}
 
 error:
@@ -133,6 +134,8 @@ int cam_ipe_deinit_hw(void *device_priv,
 	if (rc)
 		CAM_ERR(CAM_ICP, "soc disable is failed : %d", rc);
 	core_info->clk_enable = false;
+	cam_ipe_clk_residency_update(core_info, CAM_SUSPEND_VOTE);
+	cam_ipe_clk_residency_dump(core_info);
 
 	if (core_info->cpas_start) {
 		if (cam_cpas_stop(core_info->cpas_handle))
@@ -343,13 +346,175 @@ static int cam_ipe_cmd_reset(struct cam_hw_soc_info *soc_info,
 	return rc;
 }
 
+static void cam_ipe_clk_residency_update(
+	struct cam_ipe_device_core_info *core_info, int32_t clk_level)
+{
+	ktime_t now = ktime_get();
+
+	if ((core_info->clk_level >= 0) &&
+		(core_info->clk_level < CAM_MAX_VOTE))
+		core_info->clk_residency_us[core_info->clk_level] +=
+			ktime_us_delta(now, core_info->clk_level_ts);
+
+	core_info->clk_level = clk_level;
+	core_info->clk_level_ts = now;
+}
+
+static void cam_ipe_clk_residency_dump(
+	struct cam_ipe_device_core_info *core_info)
+{
+	int i;
+
+	for (i = 0; i < CAM_MAX_VOTE; i++) {
+		if (!core_info->clk_residency_us[i])
+			continue;
+		CAM_DBG(CAM_PERF, "IPE level %d residency %llu us",
+			i, core_info->clk_residency_us[i]);
+	}
+	CAM_DBG(CAM_PERF, "IPE workload votes %u prevotes %u",
+		core_info->workload_votes, core_info->workload_prevotes);
+}
+
+static int cam_ipe_update_clk(struct cam_hw_info *ipe_dev,
+	uint32_t *clk_rate, bool pc_enable, int32_t *clk_level)
+{
+	struct cam_hw_soc_info *soc_info = &ipe_dev->soc_info;
+	struct cam_ipe_device_core_info *core_info = ipe_dev->core_info;
+	struct cam_ipe_device_hw_info *hw_info = core_info->ipe_hw_info;
+	struct cam_ahb_vote ahb_vote;
+	int32_t err = 0;
+	int rc = 0;
+
+	CAM_DBG(CAM_PERF, "ipe_src_clk rate = %d", (int)*clk_rate);
+	if (!core_info->clk_enable) {
+		if (pc_enable) {
+			cam_ipe_handle_pc(ipe_dev);
+			cam_cpas_reg_write(core_info->cpas_handle,
+				CAM_CPAS_REG_CPASTOP,
+				hw_info->pwr_ctrl, true, 0x0);
+		}
+		rc = cam_ipe_toggle_clk(soc_info, true);
+		if (rc)
+			CAM_ERR(CAM_ICP, "Enable failed");
+		else
+			core_info->clk_enable = true;
+		if (pc_enable) {
+			rc = cam_ipe_handle_resume(ipe_dev);
+			if (rc)
+				CAM_ERR(CAM_ICP, "bps resume failed");
+		}
+	}
+	CAM_DBG(CAM_PERF, "clock rate %d", *clk_rate);
+
+	rc = cam_ipe_update_clk_rate(soc_info, clk_rate);
+	if (rc)
+		CAM_ERR(CAM_PERF, "Failed to update clk %d", *clk_rate);
+
+	err = cam_soc_util_get_clk_level(soc_info,
+		*clk_rate, soc_info->src_clk_idx,
+		clk_level);
+
+	if (!err) {
+		ahb_vote.type = CAM_VOTE_ABSOLUTE;
+		ahb_vote.vote.level = *clk_level;
+		cam_cpas_update_ahb_vote(
+			core_info->cpas_handle,
+			&ahb_vote);
+		cam_ipe_clk_residency_update(core_info, *clk_level);
+	}
+
+	return rc;
+}
+
+/* Lowest clock corner that covers @rate, or the highest one there is */
+static int32_t cam_ipe_workload_clk_level(struct cam_hw_soc_info *soc_info,
+	uint64_t rate)
+{
+	int32_t src_clk_idx = soc_info->src_clk_idx;
+	int32_t i, level = -1;
+
+	for (i = 0; i < CAM_MAX_VOTE; i++) {
+		if (!soc_info->clk_level_valid[i] ||
+			!soc_info->clk_rate[i][src_clk_idx])
+			continue;
+		level = i;
+		if (soc_info->clk_rate[i][src_clk_idx] >= rate)
+			break;
+	}
+
+	return level;
+}
+
+static int cam_ipe_workload_clk(struct cam_hw_info *ipe_dev,
+	struct cam_icp_workload_clk_cmd *cmd)
+{
+	struct cam_hw_soc_info *soc_info = &ipe_dev->soc_info;
+	struct cam_ipe_device_core_info *core_info = ipe_dev->core_info;
+	struct cam_axi_vote axi_vote = {0};
+	uint64_t curr_rate, next_rate, rate, bw;
+	int32_t level;
+	int rc;
+
+	curr_rate = cam_icp_workload_clk_rate(&cmd->curr,
+		IPE_WORKLOAD_PIXELS_PER_CLK);
+	next_rate = cam_icp_workload_clk_rate(&cmd->next,
+		IPE_WORKLOAD_PIXELS_PER_CLK);
+	if (!curr_rate && !next_rate)
+		return -EINVAL;
+
+	/*
+	 * Vote for the heavier of this request and the one behind it, so
+	 * a heavy frame never starts on the clock of a light one while
+	 * the ramp down waits until both are light.
+	 */
+	rate = max(curr_rate, next_rate);
+	core_info->workload_votes++;
+	if (next_rate > curr_rate)
+		core_info->workload_prevotes++;
+
+	level = cam_ipe_workload_clk_level(soc_info, rate);
+	if (level >= 0)
+		rate = soc_info->clk_rate[level][soc_info->src_clk_idx];
+	cmd->clk_rate = (uint32_t)min_t(uint64_t, rate, U32_MAX);
+
+	rc = cam_ipe_update_clk(ipe_dev, &cmd->clk_rate,
+		cmd->ipe_bps_pc_enable, &cmd->clk_level);
+	if (rc)
+		return rc;
+
+	bw = max(cam_icp_workload_bw(&cmd->curr),
+		cam_icp_workload_bw(&cmd->next));
+	if (bw) {
+		axi_vote.num_paths = 1;
+		axi_vote.axi_path[0].path_data_type =
+			CAM_IPE_DEFAULT_AXI_PATH;
+		axi_vote.axi_path[0].transac_type =
+			CAM_IPE_DEFAULT_AXI_TRANSAC;
+		axi_vote.axi_path[0].camnoc_bw = bw;
+		axi_vote.axi_path[0].mnoc_ab_bw = bw;
+		axi_vote.axi_path[0].mnoc_ib_bw = bw;
+		axi_vote.axi_path[0].ddr_ab_bw = bw;
+		axi_vote.axi_path[0].ddr_ib_bw = bw;
+		rc = cam_cpas_update_axi_vote(core_info->cpas_handle,
+			&axi_vote);
+		if (rc)
+			CAM_ERR(CAM_PERF, "axi vote failed: %d", rc);
+	}
+
+	CAM_DBG(CAM_PERF,
+		"IPE req %llu next %llu clk %u level %d bw %llu",
+		cmd->curr.request_id, cmd->next.request_id,
+		cmd->clk_rate, cmd->clk_level, bw);
+
+	return rc;
+}
+
 int cam_ipe_process_cmd(void *device_priv, uint32_t cmd_type,
 	void *cmd_args, uint32_t arg_size)
 {
 	struct cam_hw_info *ipe_dev = device_priv;
 	struct cam_hw_soc_info *soc_info = NULL;
 	struct cam_ipe_device_core_info *core_info = NULL;
-	struct cam_ipe_device_hw_info *hw_info = NULL;
 	int rc = 0;
 
 	if (!device_priv) {
@@ -364,7 +529,6 @@ int cam_ipe_process_cmd(void *device_priv, uint32_t cmd_type,
 
 	soc_info = &ipe_dev->soc_info;
 	core_info = (struct cam_ipe_device_core_info *)ipe_dev->core_info;
-	hw_info = core_info->ipe_hw_info;
 
 	switch (cmd_type) {
 	case CAM_ICP_IPE_CMD_VOTE_CPAS: {
@@ -405,53 +569,26 @@ int cam_ipe_process_cmd(void *device_priv, uint32_t cmd_type,
 		break;
 	case CAM_ICP_IPE_CMD_UPDATE_CLK: {
 		struct cam_icp_clk_update_cmd *clk_upd_cmd = cmd_args;
-		struct cam_ahb_vote ahb_vote;
 		uint32_t clk_rate = clk_upd_cmd->curr_clk_rate;
-		int32_t clk_level  = 0, err = 0;
-
-		CAM_DBG(CAM_PERF, "ipe_src_clk rate = %d", (int)clk_rate);
-		if (!core_info->clk_enable) {
-			if (clk_upd_cmd->ipe_bps_pc_enable) {
-				cam_ipe_handle_pc(ipe_dev);
-				cam_cpas_reg_write(core_info->cpas_handle,
-					CAM_CPAS_REG_CPASTOP,
-					hw_info->pwr_ctrl, true, 0x0);
-			}
-			rc = cam_ipe_toggle_clk(soc_info, true);
-			if (rc)
-				CAM_ERR(CAM_ICP, "Enable failed");
-			else
-				core_info->clk_enable = true;
-			if (clk_upd_cmd->ipe_bps_pc_enable) {
-				rc = cam_ipe_handle_resume(ipe_dev);
-				if (rc)
-					CAM_ERR(CAM_ICP, "bps resume failed");
-			}
-		}
-		CAM_DBG(CAM_PERF, "clock rate %d", clk_rate);
-
-		rc = cam_ipe_update_clk_rate(soc_info, &clk_rate);
-		if (rc)
-			CAM_ERR(CAM_PERF, "Failed to update clk %d", clk_rate);
-
-		err = cam_soc_util_get_clk_level(soc_info,
-			clk_rate, soc_info->src_clk_idx,
-			&clk_level);
+		int32_t clk_level = 0;
 
-		if (!err) {
+		rc = cam_ipe_update_clk(ipe_dev, &clk_rate,
+			clk_upd_cmd->ipe_bps_pc_enable, &clk_level);
+		if (clk_level >= 0)
 			clk_upd_cmd->clk_level = clk_level;
-			ahb_vote.type = CAM_VOTE_ABSOLUTE;
-			ahb_vote.vote.level = clk_level;
-			cam_cpas_update_ahb_vote(
-				core_info->cpas_handle,
-				&ahb_vote);
-		}
 		break;
 	}
+	case CAM_ICP_IPE_CMD_WORKLOAD_CLK:
+		if (!cmd_args)
+			return -EINVAL;
+
+		rc = cam_ipe_workload_clk(ipe_dev, cmd_args);
+		break;
 	case CAM_ICP_IPE_CMD_DISABLE_CLK:
 		if (core_info->clk_enable == true)
 			cam_ipe_toggle_clk(soc_info, false);
 		core_info->clk_enable = false;
+		cam_ipe_clk_residency_update(core_info, CAM_SUSPEND_VOTE);
 		break;
 	case CAM_ICP_IPE_CMD_RESET:
 		rc = cam_ipe_cmd_reset(soc_info, core_info);
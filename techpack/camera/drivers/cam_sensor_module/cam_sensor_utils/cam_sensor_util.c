@@ -4,6 +4,8 @@
  */
 
 #include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
 #include <clocksource/arm_arch_timer.h>
 #include "cam_sensor_util.h"
 #include "cam_mem_mgr.h"
@@ -15,6 +17,10 @@
 #define VALIDATE_VOLTAGE(min, max, config_val) ((config_val) && \
 	(config_val >= min) && (config_val <= max))
 
+/* Shortest run of consecutive registers sent as one burst, 0 disables */
+static uint cam_sensor_burst_min = 4;
+module_param(cam_sensor_burst_min, uint, 0644);
+
 static struct i2c_settings_list*
 	cam_sensor_get_i2c_ptr(struct i2c_settings_array *i2c_reg_settings,
 		uint32_t size)
@@ -830,17 +836,114 @@ int cam_sensor_i2c_command_parser(
 	return rc;
 }
 
+/*
+ * Register j and j + 1 can go out in one burst: the address auto
+ * increments by the data width and neither needs a delay or a mask.
+ */
+static bool cam_sensor_i2c_reg_burstable(
+	struct cam_sensor_i2c_reg_setting *setting, uint32_t j)
+{
+	struct cam_sensor_i2c_reg_array *reg = &setting->reg_setting[j];
+
+	return !reg[0].delay && !reg[0].data_mask &&
+		!reg[1].delay && !reg[1].data_mask &&
+		(reg[1].reg_addr == reg[0].reg_addr + setting->data_type);
+}
+
+static int32_t cam_sensor_i2c_write_span(
+	struct camera_io_master *io_master_info,
+	struct cam_sensor_i2c_reg_setting *setting,
+	uint32_t start, uint32_t count, bool burst)
+{
+	struct cam_sensor_i2c_reg_setting span = *setting;
+
+	span.reg_setting = &setting->reg_setting[start];
+	span.size = count;
+	/* the table delay belongs after its last register only */
+	if (start + count != setting->size)
+		span.delay = 0;
+
+	if (burst)
+		return camera_io_dev_write_continuous(io_master_info,
+			&span, 1);
+
+	return camera_io_dev_write(io_master_info, &span);
+}
+
+/*
+ * Random write tables from mode and init settings are mostly long runs
+ * of consecutive registers. Send those runs as burst transactions and
+ * everything in between as random writes, in the original order.
+ */
+static int32_t cam_sensor_i2c_write_random_batched(
+	struct camera_io_master *io_master_info,
+	struct cam_sensor_i2c_reg_setting *setting, uint32_t *num_xfers)
+{
+	uint32_t min_run = cam_sensor_burst_min;
+	uint32_t size = setting->size;
+	uint32_t i = 0, pending = 0, run;
+	int32_t rc = 0;
+
+	*num_xfers = 0;
+	if ((min_run < 2) || (size < min_run) ||
+		(setting->data_type <= CAMERA_SENSOR_I2C_TYPE_INVALID) ||
+		(setting->data_type >= CAMERA_SENSOR_I2C_TYPE_MAX)) {
+		*num_xfers = 1;
+		return camera_io_dev_write(io_master_info, setting);
+	}
+
+	while (i < size) {
+		run = 1;
+		while ((i + run < size) &&
+			cam_sensor_i2c_reg_burstable(setting, i + run - 1))
+			run++;
+
+		if (run < min_run) {
+			i += run;
+			continue;
+		}
+
+		if (i > pending) {
+			rc = cam_sensor_i2c_write_span(io_master_info,
+				setting, pending, i - pending, false);
+			if (rc < 0)
+				return rc;
+			(*num_xfers)++;
+		}
+
+		rc = cam_sensor_i2c_write_span(io_master_info, setting,
+			i, run, true);
+		if (rc < 0)
+			return rc;
+		(*num_xfers)++;
+
+		i += run;
+		pending = i;
+	}
+
+	if (pending < size) {
+		rc = cam_sensor_i2c_write_span(io_master_info, setting,
+			pending, size - pending, false);
+		if (rc < 0)
+			return rc;
+		(*num_xfers)++;
+	}
+
+	return rc;
+}
+
 int cam_sensor_util_i2c_apply_setting(
 	struct camera_io_master *io_master_info,
 	struct i2c_settings_list *i2c_list)
 {
 	int32_t rc = 0;
-	uint32_t i, size;
+	uint32_t i, size, num_xfers = 1;
+	ktime_t start = ktime_get();
 
 	switch (i2c_list->op_code) {
 	case CAM_SENSOR_I2C_WRITE_RANDOM: {
-		rc = camera_io_dev_write(io_master_info,
-			&(i2c_list->i2c_settings));
+		rc = cam_sensor_i2c_write_random_batched(io_master_info,
+			&(i2c_list->i2c_settings), &num_xfers);
 		if (rc < 0) {
 			CAM_ERR(CAM_SENSOR,
 				"Failed to random write I2C settings: %d",
@@ -872,6 +975,7 @@ int cam_sensor_util_i2c_apply_setting(
 	break;
 	}
 	case CAM_SENSOR_I2C_POLL: {
+		num_xfers = 0;
 		size = i2c_list->i2c_settings.size;
 		for (i = 0; i < size; i++) {
 			rc = camera_io_dev_poll(
@@ -896,6 +1000,11 @@ int cam_sensor_util_i2c_apply_setting(
 	break;
 	}
 
+	if (num_xfers)
+		CAM_DBG(CAM_SENSOR, "op %d regs %u in %u xfers took %lld us",
+			i2c_list->op_code, i2c_list->i2c_settings.size,
+			num_xfers, ktime_us_delta(ktime_get(), start));
+
 	return rc;
 }
 
@@ -12,10 +12,13 @@
 #include <linux/dma-mapping.h>
 #include <linux/of_address.h>
 #include <linux/msm_dma_iommu_mapping.h>
+#include <linux/msm_ion.h>
 #include <linux/workqueue.h>
 #include <linux/genalloc.h>
 #include <linux/debugfs.h>
 #include <linux/dma-iommu.h>
+#include <linux/hashtable.h>
+#include <linux/rbtree.h>
 
 #include <soc/qcom/secure_buffer.h>
 
@@ -38,6 +41,8 @@
 #define HANDLE_INIT (-1)
 #define CAM_SMMU_CB_MAX 6
 #define CAM_SMMU_SHARED_HDL_MAX 6
+#define CAM_SMMU_PREFILL_HINTS_MAX 4
+#define CAM_SMMU_BUF_HASH_BITS 6
 
 #define GET_SMMU_HDL(x, y) (((x) << COOKIE_SIZE) | ((y) & COOKIE_MASK))
 #define GET_SMMU_TABLE_IDX(x) (((x) >> COOKIE_SIZE) & COOKIE_MASK)
@@ -170,6 +175,24 @@ struct cam_context_bank_info {
 
 	atomic64_t  monitor_head;
 	struct cam_smmu_monitor monitor_entries[CAM_SMMU_MONITOR_MAX_ENTRIES];
+
+	/* buffers the clients of this cb allocate once it's attached */
+	struct ion_prefill_hint prefill_hints[CAM_SMMU_PREFILL_HINTS_MAX];
+	int num_prefill_hints;
+
+	/* bumped on every unmap, invalidates cached iova lookups */
+	atomic_t unmap_gen;
+
+	/*
+	 * Lookup index over the non-secure mappings, kept in sync with
+	 * smmu_buf_list (iova_tree, fd_hash) and smmu_buf_kernel_list
+	 * (kbuf_hash) under @lock.
+	 */
+	struct rb_root iova_tree;
+	DECLARE_HASHTABLE(fd_hash, CAM_SMMU_BUF_HASH_BITS);
+	DECLARE_HASHTABLE(kbuf_hash, CAM_SMMU_BUF_HASH_BITS);
+	atomic64_t lookup_hit;
+	atomic64_t lookup_miss;
 };
 
 struct cam_iommu_cb_set {
@@ -203,6 +226,8 @@ struct cam_dma_buff_info {
 	int ref_count;
 	dma_addr_t paddr;
 	struct list_head list;
+	struct rb_node iova_node;
+	struct hlist_node hash_node;
 	int ion_fd;
 	size_t len;
 	size_t phys_len;
@@ -633,57 +658,177 @@ static void cam_smmu_print_table(void)
 				iommu_cb_set.cb_info[i].name[j]);
 		}
 		CAM_ERR(CAM_SMMU, "dev = %pK", iommu_cb_set.cb_info[i].dev);
+		CAM_ERR(CAM_SMMU, "lookups hit %lld miss %lld",
+			atomic64_read(&iommu_cb_set.cb_info[i].lookup_hit),
+			atomic64_read(&iommu_cb_set.cb_info[i].lookup_miss));
 	}
 }
 
+static void cam_smmu_index_add(struct cam_context_bank_info *cb,
+	struct cam_dma_buff_info *mapping, bool kernel)
+{
+	struct rb_node **link, *parent = NULL;
+	struct cam_dma_buff_info *entry;
+
+	if (kernel) {
+		RB_CLEAR_NODE(&mapping->iova_node);
+		hash_add(cb->kbuf_hash, &mapping->hash_node,
+			(unsigned long)mapping->buf);
+		return;
+	}
+
+	link = &cb->iova_tree.rb_node;
+	while (*link) {
+		parent = *link;
+		entry = rb_entry(parent, struct cam_dma_buff_info, iova_node);
+		if (mapping->paddr < entry->paddr)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&mapping->iova_node, parent, link);
+	rb_insert_color(&mapping->iova_node, &cb->iova_tree);
+
+	hash_add(cb->fd_hash, &mapping->hash_node, mapping->ion_fd);
+}
+
+static void cam_smmu_index_del(struct cam_context_bank_info *cb,
+	struct cam_dma_buff_info *mapping)
+{
+	if (!RB_EMPTY_NODE(&mapping->iova_node))
+		rb_erase(&mapping->iova_node, &cb->iova_tree);
+	hash_del(&mapping->hash_node);
+}
+
+static void cam_smmu_index_reset(struct cam_context_bank_info *cb)
+{
+	cb->iova_tree = RB_ROOT;
+	hash_init(cb->fd_hash);
+	hash_init(cb->kbuf_hash);
+	atomic64_set(&cb->lookup_hit, 0);
+	atomic64_set(&cb->lookup_miss, 0);
+}
+
+static inline void cam_smmu_index_count(struct cam_context_bank_info *cb,
+	void *found)
+{
+	if (found)
+		atomic64_inc(&cb->lookup_hit);
+	else
+		atomic64_inc(&cb->lookup_miss);
+}
+
+static struct cam_dma_buff_info *cam_smmu_index_find_fd(
+	struct cam_context_bank_info *cb, int ion_fd)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(cb->fd_hash, mapping, hash_node, ion_fd) {
+		if (mapping->ion_fd == ion_fd) {
+			cam_smmu_index_count(cb, mapping);
+			return mapping;
+		}
+	}
+
+	cam_smmu_index_count(cb, NULL);
+	return NULL;
+}
+
+static struct cam_dma_buff_info *cam_smmu_index_find_kbuf(
+	struct cam_context_bank_info *cb, struct dma_buf *buf)
+{
+	struct cam_dma_buff_info *mapping;
+
+	hash_for_each_possible(cb->kbuf_hash, mapping, hash_node,
+		(unsigned long)buf) {
+		if (mapping->buf == buf) {
+			cam_smmu_index_count(cb, mapping);
+			return mapping;
+		}
+	}
+
+	cam_smmu_index_count(cb, NULL);
+	return NULL;
+}
+
+/* Mapping with the highest iova not above @iova */
+static struct cam_dma_buff_info *cam_smmu_index_floor(
+	struct cam_context_bank_info *cb, dma_addr_t iova)
+{
+	struct rb_node *node = cb->iova_tree.rb_node;
+	struct cam_dma_buff_info *entry, *floor = NULL;
+
+	while (node) {
+		entry = rb_entry(node, struct cam_dma_buff_info, iova_node);
+		if (iova < entry->paddr) {
+			node = node->rb_left;
+		} else {
+			floor = entry;
+			node = node->rb_right;
+		}
+	}
+
+	return floor;
+}
+
 static uint32_t cam_smmu_find_closest_mapping(int idx, void *vaddr)
 {
-	struct cam_dma_buff_info *mapping, *closest_mapping =  NULL;
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	struct cam_dma_buff_info *closest_mapping = NULL, *floor, *ceil;
+	struct rb_node *next;
 	unsigned long start_addr, end_addr, current_addr;
 	uint32_t buf_handle = 0;
-
-	long delta = 0, lowest_delta = 0;
+	unsigned long floor_delta = ULONG_MAX, ceil_delta = ULONG_MAX;
 
 	current_addr = (unsigned long)vaddr;
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		start_addr = (unsigned long)mapping->paddr;
-		end_addr = (unsigned long)mapping->paddr + mapping->len;
 
-		if (start_addr <= current_addr && current_addr <= end_addr) {
-			closest_mapping = mapping;
+	/*
+	 * Mappings never overlap, so the only candidates are the ones
+	 * right below and right above the faulting address.
+	 */
+	floor = cam_smmu_index_floor(cb, (dma_addr_t)current_addr);
+	if (floor) {
+		start_addr = (unsigned long)floor->paddr;
+		end_addr = (unsigned long)floor->paddr + floor->len;
+		if (current_addr <= end_addr) {
+			closest_mapping = floor;
 			CAM_INFO(CAM_SMMU,
 				"Found va 0x%lx in:0x%lx-0x%lx, fd %d cb:%s",
 				current_addr, start_addr,
-				end_addr, mapping->ion_fd,
-				iommu_cb_set.cb_info[idx].name[0]);
+				end_addr, floor->ion_fd, cb->name[0]);
 			goto end;
-		} else {
-			if (start_addr > current_addr)
-				delta =  start_addr - current_addr;
-			else
-				delta = current_addr - end_addr - 1;
-
-			if (delta < lowest_delta || lowest_delta == 0) {
-				lowest_delta = delta;
-				closest_mapping = mapping;
-			}
-			CAM_DBG(CAM_SMMU,
-				"approx va %lx not in range: %lx-%lx fd = %0x",
-				current_addr, start_addr,
-				end_addr, mapping->ion_fd);
 		}
+		floor_delta = current_addr - end_addr - 1;
+		next = rb_next(&floor->iova_node);
+	} else {
+		next = rb_first(&cb->iova_tree);
+	}
+
+	ceil = next ? rb_entry(next, struct cam_dma_buff_info, iova_node) :
+		NULL;
+	if (ceil)
+		ceil_delta = (unsigned long)ceil->paddr - current_addr;
+
+	if (floor || ceil) {
+		closest_mapping = (floor_delta <= ceil_delta) ? floor : ceil;
+		CAM_DBG(CAM_SMMU,
+			"approx va %lx not in range: %lx-%lx fd = %0x",
+			current_addr, (unsigned long)closest_mapping->paddr,
+			(unsigned long)closest_mapping->paddr +
+			closest_mapping->len, closest_mapping->ion_fd);
 	}
 
 end:
+	cam_smmu_index_count(cb, closest_mapping);
 	if (closest_mapping) {
 		buf_handle = GET_MEM_HANDLE(idx, closest_mapping->ion_fd);
 		CAM_INFO(CAM_SMMU,
-			"Closest map fd %d 0x%lx %llu-%llu 0x%lx-0x%lx buf=%pK mem %0x",
+			"Closest map fd %d 0x%lx %zu 0x%lx-0x%lx buf=%pK mem %0x",
 			closest_mapping->ion_fd, current_addr,
-			mapping->len, closest_mapping->len,
+			closest_mapping->len,
 			(unsigned long)closest_mapping->paddr,
-			(unsigned long)closest_mapping->paddr + mapping->len,
+			(unsigned long)closest_mapping->paddr +
+			closest_mapping->len,
 			closest_mapping->buf,
 			buf_handle);
 	} else
@@ -911,6 +1056,7 @@ void cam_smmu_reset_iommu_table(enum cam_smmu_init_dir ops)
 		iommu_cb_set.cb_info[i].handle = HANDLE_INIT;
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_list);
 		INIT_LIST_HEAD(&iommu_cb_set.cb_info[i].smmu_buf_kernel_list);
+		cam_smmu_index_reset(&iommu_cb_set.cb_info[i]);
 		iommu_cb_set.cb_info[i].state = CAM_SMMU_DETACH;
 		iommu_cb_set.cb_info[i].dev = NULL;
 		iommu_cb_set.cb_info[i].cb_count = 0;
@@ -1144,15 +1290,17 @@ static int cam_smmu_free_scratch_va(struct scratch_mapping *mapping,
 static struct cam_dma_buff_info *cam_smmu_find_mapping_by_virt_address(int idx,
 	dma_addr_t virt_addr)
 {
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping, &iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->paddr == virt_addr) {
-			CAM_DBG(CAM_SMMU, "Found virtual address %lx",
-				 (unsigned long)virt_addr);
-			return mapping;
-		}
+	mapping = cam_smmu_index_floor(cb, virt_addr);
+	if (mapping && mapping->paddr != virt_addr)
+		mapping = NULL;
+	cam_smmu_index_count(cb, mapping);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "Found virtual address %lx",
+			 (unsigned long)virt_addr);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find virtual address %lx by index %d",
@@ -1170,13 +1318,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_ion_index(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_list,
-			list) {
-		if (mapping->ion_fd == ion_fd) {
-			CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
-			return mapping;
-		}
+	mapping = cam_smmu_index_find_fd(&iommu_cb_set.cb_info[idx], ion_fd);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find ion_fd %d", ion_fd);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -1194,13 +1339,10 @@ static struct cam_dma_buff_info *cam_smmu_find_mapping_by_dma_buf(int idx,
 		return NULL;
 	}
 
-	list_for_each_entry(mapping,
-			&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list,
-			list) {
-		if (mapping->buf == buf) {
-			CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
-			return mapping;
-		}
+	mapping = cam_smmu_index_find_kbuf(&iommu_cb_set.cb_info[idx], buf);
+	if (mapping) {
+		CAM_DBG(CAM_SMMU, "find dma_buf %pK", buf);
+		return mapping;
 	}
 
 	CAM_ERR(CAM_SMMU, "Error: Cannot find entry by index %d", idx);
@@ -1296,6 +1438,24 @@ static void cam_smmu_clean_kernel_buffer_list(int idx)
 	}
 }
 
+static void cam_smmu_prefill(int idx)
+{
+	struct cam_context_bank_info *cb = &iommu_cb_set.cb_info[idx];
+	int i, rc;
+
+	if (!cb->num_prefill_hints)
+		return;
+
+	for (i = 0; i < cb->num_prefill_hints; i++)
+		cb->prefill_hints[i].cached = iommu_cb_set.force_cache_allocs;
+
+	rc = msm_ion_heap_prefill(ION_SYSTEM_HEAP_ID, cb->prefill_hints,
+		cb->num_prefill_hints);
+	if (rc)
+		CAM_DBG(CAM_SMMU, "[%s] prefill not done, rc = %d",
+			cb->name[0], rc);
+}
+
 static int cam_smmu_attach(int idx)
 {
 	int ret;
@@ -1309,6 +1469,7 @@ static int cam_smmu_attach(int idx)
 			return -ENODEV;
 		}
 		iommu_cb_set.cb_info[idx].state = CAM_SMMU_ATTACH;
+		cam_smmu_prefill(idx);
 		ret = 0;
 	} else {
 		CAM_ERR(CAM_SMMU, "Error: Not detach/attach: %d",
@@ -1752,6 +1913,23 @@ int cam_smmu_get_io_region_info(int32_t smmu_hdl,
 	return 0;
 }
 
+int cam_smmu_get_unmap_gen(int32_t smmu_hdl, uint32_t *gen)
+{
+	int32_t idx;
+
+	if (!gen || (smmu_hdl == HANDLE_INIT))
+		return -EINVAL;
+
+	idx = GET_SMMU_TABLE_IDX(smmu_hdl);
+	if (idx < 0 || idx >= iommu_cb_set.cb_num ||
+		iommu_cb_set.cb_info[idx].handle != smmu_hdl)
+		return -EINVAL;
+
+	*gen = atomic_read(&iommu_cb_set.cb_info[idx].unmap_gen);
+
+	return 0;
+}
+
 int cam_smmu_get_region_info(int32_t smmu_hdl,
 	enum cam_smmu_region_id region_id,
 	struct cam_smmu_region_info *region_info)
@@ -2208,6 +2386,7 @@ static int cam_smmu_map_buffer_and_add_to_list(int idx, int ion_fd,
 	/* add to the list */
 	list_add(&mapping_info->list,
 		&iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_index_add(&iommu_cb_set.cb_info[idx], mapping_info, false);
 
 	cam_smmu_update_monitor_array(&iommu_cb_set.cb_info[idx], true,
 		mapping_info);
@@ -2236,6 +2415,7 @@ static int cam_smmu_map_kernel_buffer_and_add_to_list(int idx,
 	/* add to the list */
 	list_add(&mapping_info->list,
 		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list);
+	cam_smmu_index_add(&iommu_cb_set.cb_info[idx], mapping_info, true);
 
 	cam_smmu_update_monitor_array(&iommu_cb_set.cb_info[idx], true,
 		mapping_info);
@@ -2328,6 +2508,8 @@ static int cam_smmu_unmap_buf_and_remove_from_list(
 	mapping_info->buf = NULL;
 
 	list_del_init(&mapping_info->list);
+	cam_smmu_index_del(&iommu_cb_set.cb_info[idx], mapping_info);
+	atomic_inc(&iommu_cb_set.cb_info[idx].unmap_gen);
 
 	/* free one buffer */
 	kfree(mapping_info);
@@ -2340,14 +2522,12 @@ static enum cam_smmu_buf_state cam_smmu_check_fd_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_index_find_fd(&iommu_cb_set.cb_info[idx], ion_fd);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2359,15 +2539,13 @@ static enum cam_smmu_buf_state cam_smmu_user_reuse_fd_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_list, list) {
-		if (mapping->ion_fd == ion_fd) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			*ts_mapping = &mapping->ts;
-			mapping->ref_count++;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_index_find_fd(&iommu_cb_set.cb_info[idx], ion_fd);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		*ts_mapping = &mapping->ts;
+		mapping->ref_count++;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2378,13 +2556,11 @@ static enum cam_smmu_buf_state cam_smmu_check_dma_buf_in_list(int idx,
 {
 	struct cam_dma_buff_info *mapping;
 
-	list_for_each_entry(mapping,
-		&iommu_cb_set.cb_info[idx].smmu_buf_kernel_list, list) {
-		if (mapping->buf == buf) {
-			*paddr_ptr = mapping->paddr;
-			*len_ptr = mapping->len;
-			return CAM_SMMU_BUFF_EXIST;
-		}
+	mapping = cam_smmu_index_find_kbuf(&iommu_cb_set.cb_info[idx], buf);
+	if (mapping) {
+		*paddr_ptr = mapping->paddr;
+		*len_ptr = mapping->len;
+		return CAM_SMMU_BUFF_EXIST;
 	}
 
 	return CAM_SMMU_BUFF_NOT_EXIST;
@@ -2593,6 +2769,7 @@ static int cam_smmu_alloc_scratch_buffer_add_to_list(int idx,
 		mapping_info->len, mapping_info->phys_len);
 
 	list_add(&mapping_info->list, &iommu_cb_set.cb_info[idx].smmu_buf_list);
+	cam_smmu_index_add(&iommu_cb_set.cb_info[idx], mapping_info, false);
 
 	*virt_addr = (dma_addr_t)iova;
 
@@ -2654,6 +2831,8 @@ static int cam_smmu_free_scratch_buffer_remove_from_list(
 	sg_free_table(mapping_info->table);
 	kfree(mapping_info->table);
 	list_del_init(&mapping_info->list);
+	cam_smmu_index_del(&iommu_cb_set.cb_info[idx], mapping_info);
+	atomic_inc(&iommu_cb_set.cb_info[idx].unmap_gen);
 
 	kfree(mapping_info);
 	mapping_info = NULL;
@@ -3002,6 +3181,7 @@ static int cam_smmu_secure_unmap_buf_and_remove_from_list(
 	mapping_info->buf = NULL;
 
 	list_del_init(&mapping_info->list);
+	atomic_inc(&iommu_cb_set.cb_info[idx].unmap_gen);
 
 	CAM_DBG(CAM_SMMU, "unmap fd: %d, idx : %d", mapping_info->ion_fd, idx);
 
@@ -3860,6 +4040,34 @@ static int cam_smmu_get_discard_memory_regions(struct device_node *of_node,
 	return 0;
 }
 
+static void cam_smmu_get_prefill_hints(struct device_node *of_node,
+	struct cam_context_bank_info *cb)
+{
+	u32 vals[CAM_SMMU_PREFILL_HINTS_MAX * 2];
+	int num_vals, i;
+
+	/* optional <size count> pairs of buffers allocated after attach */
+	num_vals = of_property_count_u32_elems(of_node, "qcom,prefill-buffers");
+	if (num_vals <= 0)
+		return;
+
+	if ((num_vals % 2) || num_vals > ARRAY_SIZE(vals)) {
+		CAM_WARN(CAM_SMMU, "[%s] invalid prefill-buffers count %d",
+			cb->name[0], num_vals);
+		return;
+	}
+
+	if (of_property_read_u32_array(of_node, "qcom,prefill-buffers",
+		vals, num_vals))
+		return;
+
+	for (i = 0; i < num_vals / 2; i++) {
+		cb->prefill_hints[i].size = vals[2 * i];
+		cb->prefill_hints[i].count = vals[2 * i + 1];
+	}
+	cb->num_prefill_hints = num_vals / 2;
+}
+
 static int cam_smmu_get_memory_regions_info(struct device_node *of_node,
 	struct cam_context_bank_info *cb)
 {
@@ -4164,6 +4372,8 @@ static int cam_populate_smmu_context_banks(struct device *dev,
 			cam_smmu_iommu_fault_handler,
 			(void *)cb->name[0]);
 
+	cam_smmu_get_prefill_hints(dev->of_node, cb);
+
 	if (!dev->dma_parms)
 		dev->dma_parms = devm_kzalloc(dev,
 			sizeof(*dev->dma_parms), GFP_KERNEL);
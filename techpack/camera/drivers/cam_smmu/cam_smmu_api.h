@@ -399,6 +399,17 @@ int cam_smmu_alloc_qdss(int32_t smmu_hdl,
  */
 int cam_smmu_dealloc_qdss(int32_t smmu_hdl);
 
+/**
+ * @brief Get the unmap generation of a given cb, it changes whenever a
+ *        buffer is unmapped from the cb
+ *
+ * @param smmu_hdl: SMMU handle identifying the context bank
+ * @param gen: Current unmap generation
+ *
+ * @return Status of operation. Negative in case of error. Zero otherwise.
+ */
+int cam_smmu_get_unmap_gen(int32_t smmu_hdl, uint32_t *gen);
+
 /**
  * @brief Get start addr & len of I/O region for a given cb
  *
@@ -5,10 +5,72 @@
 
 #include <linux/types.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/spinlock.h>
 
 #include "cam_mem_mgr.h"
 #include "cam_packet_util.h"
 #include "cam_debug_util.h"
+#include "cam_smmu_api.h"
+
+#define CAM_PACKET_IOVA_CACHE_BITS 8
+
+/*
+ * Patches of consecutive requests keep resolving the same handles, cache
+ * their iova per smmu handle so each lookup skips the smmu mapping list.
+ * An entry is valid only as long as nothing was unmapped from its cb.
+ */
+struct cam_packet_iova_cache_entry {
+	int32_t    mmu_hdl;
+	uint32_t   buf_hdl;
+	uint32_t   unmap_gen;
+	dma_addr_t iova;
+	size_t     buf_size;
+};
+
+static struct cam_packet_iova_cache_entry
+	g_iova_cache[1 << CAM_PACKET_IOVA_CACHE_BITS];
+static DEFINE_SPINLOCK(g_iova_cache_lock);
+
+static int cam_packet_util_get_cached_iova(int32_t mmu_hdl,
+	uint32_t buf_hdl, dma_addr_t *iova, size_t *buf_size)
+{
+	struct cam_packet_iova_cache_entry *entry;
+	uint32_t gen;
+	bool cacheable;
+	int rc;
+
+	entry = &g_iova_cache[hash_32(buf_hdl ^ (uint32_t)mmu_hdl,
+		CAM_PACKET_IOVA_CACHE_BITS)];
+	cacheable = !cam_smmu_get_unmap_gen(mmu_hdl, &gen);
+
+	if (cacheable) {
+		spin_lock(&g_iova_cache_lock);
+		if (entry->buf_hdl == buf_hdl && entry->mmu_hdl == mmu_hdl &&
+			entry->unmap_gen == gen && entry->iova) {
+			*iova = entry->iova;
+			*buf_size = entry->buf_size;
+			spin_unlock(&g_iova_cache_lock);
+			return 0;
+		}
+		spin_unlock(&g_iova_cache_lock);
+	}
+
+	rc = cam_mem_get_io_buf(buf_hdl, mmu_hdl, iova, buf_size);
+	if (rc < 0 || !cacheable)
+		return rc;
+
+	/* gen was sampled before the lookup, a racing unmap stales it */
+	spin_lock(&g_iova_cache_lock);
+	entry->mmu_hdl = mmu_hdl;
+	entry->buf_hdl = buf_hdl;
+	entry->unmap_gen = gen;
+	entry->iova = *iova;
+	entry->buf_size = *buf_size;
+	spin_unlock(&g_iova_cache_lock);
+
+	return rc;
+}
 
 #define CAM_UNIQUE_SRC_HDL_MAX 50
 
@@ -251,7 +313,7 @@ static int cam_packet_util_get_patch_iova(
 	if (!is_found) {
 		CAM_DBG(CAM_UTIL, "src_hdl 0x%x not found in table entries",
 			buf_hdl);
-		rc = cam_mem_get_io_buf(buf_hdl, hdl,
+		rc = cam_packet_util_get_cached_iova(hdl, buf_hdl,
 			&iova_addr, &src_buf_size);
 		if (rc < 0) {
 			CAM_ERR(CAM_UTIL,
@@ -7152,8 +7152,7 @@ static int ipa3_lan_poll(struct napi_struct *napi, int budget)
 {
 	int rcvd_pkts = 0;
 
-	rcvd_pkts = ipa3_lan_rx_poll(ipa3_ctx->clnt_hdl_data_in,
-							NAPI_WEIGHT);
+	rcvd_pkts = ipa3_lan_rx_poll(ipa3_ctx->clnt_hdl_data_in, budget);
 	return rcvd_pkts;
 }
 
@@ -7804,6 +7803,9 @@ static int ipa3_pre_init(const struct ipa3_plat_drv_res *resource_p,
 	}
 	mutex_init(&ipa3_ctx->app_clock_vote.mutex);
 
+	/* RX skb heads are taken from the skb recycle cache */
+	skb_recycle_register();
+
 	return 0;
 
 fail_rmnet_ctl_init:
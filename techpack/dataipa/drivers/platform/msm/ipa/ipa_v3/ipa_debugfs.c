@@ -1414,23 +1414,75 @@ static ssize_t ipa3_read_odlstats(struct file *file, char __user *ubuf,
 static ssize_t ipa3_read_page_recycle_stats(struct file *file,
 		char __user *ubuf, size_t count, loff_t *ppos)
 {
+	static const char * const names[] = { "COAL", "DEF " };
+	struct ipa3_page_recycle_stats *stats;
 	int nbytes;
 	int cnt = 0;
+	int i;
 
-	nbytes = scnprintf(dbg_buff, IPA_MAX_MSG_LEN,
-			"COAL : Total number of packets replenished =%llu\n"
-			"COAL : Number of tmp alloc packets  =%llu\n"
-			"DEF  : Total number of packets replenished =%llu\n"
-			"DEF  : Number of tmp alloc packets  =%llu\n",
-			ipa3_ctx->stats.page_recycle_stats[0].total_replenished,
-			ipa3_ctx->stats.page_recycle_stats[0].tmp_alloc,
-			ipa3_ctx->stats.page_recycle_stats[1].total_replenished,
-			ipa3_ctx->stats.page_recycle_stats[1].tmp_alloc);
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		stats = &ipa3_ctx->stats.page_recycle_stats[i];
+		nbytes = scnprintf(dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"%s : Total number of packets replenished =%llu\n"
+			"%s : Number of tmp alloc packets  =%llu\n"
+			"%s : Number of recycled packets  =%llu (%llu%%)\n"
+			"%s : Recycle head page busy  =%llu\n"
+			"%s : Recycled past busy head  =%llu\n"
+			"%s : Tmp alloc ring empty  =%llu\n",
+			names[i], stats->total_replenished,
+			names[i], stats->tmp_alloc,
+			names[i], stats->recycled,
+			stats->total_replenished ?
+			div64_u64(stats->recycled * 100,
+				  stats->total_replenished) : 0,
+			names[i], stats->head_busy,
+			names[i], stats->lookahead_hit,
+			names[i], stats->repl_empty);
+		cnt += nbytes;
+	}
 
-	cnt += nbytes;
+	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
+}
+static ssize_t ipa3_read_napi_stats(struct file *file,
+		char __user *ubuf, size_t count, loff_t *ppos)
+{
+	struct ipa3_sys_context *sys;
+	int nbytes;
+	int cnt = 0;
+	int i, j;
+
+	for (i = 0; i < ipa3_ctx->ipa_num_pipes; i++) {
+		if (!ipa3_ctx->ep[i].valid)
+			continue;
+
+		sys = ipa3_ctx->ep[i].sys;
+		if (!sys || !sys->napi_obj)
+			continue;
+
+		nbytes = scnprintf(dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"%s: weight=%u shrink=%u grow=%u busy_poll=%u\n"
+			"  ring occupancy (%% of pool posted):",
+			ipa_clients_strings[ipa3_ctx->ep[i].client],
+			sys->napi_weight, sys->napi_weight_shrink,
+			sys->napi_weight_grow, sys->napi_busy_poll_cnt);
+		cnt += nbytes;
+
+		for (j = 0; j < IPA_NAPI_OCC_BUCKETS; j++) {
+			nbytes = scnprintf(dbg_buff + cnt,
+				IPA_MAX_MSG_LEN - cnt, " <%d:%u",
+				(j + 1) * 100 / IPA_NAPI_OCC_BUCKETS,
+				sys->napi_occ_hist[j]);
+			cnt += nbytes;
+		}
+
+		nbytes = scnprintf(dbg_buff + cnt, IPA_MAX_MSG_LEN - cnt,
+			"\n");
+		cnt += nbytes;
+	}
 
 	return simple_read_from_buffer(ubuf, count, ppos, dbg_buff, cnt);
 }
+
 static ssize_t ipa3_read_wstats(struct file *file, char __user *ubuf,
 		size_t count, loff_t *ppos)
 {
@@ -2898,6 +2950,10 @@ static const struct ipa3_debugfs_file debugfs_files[] = {
 		"page_recycle_stats", IPA_READ_ONLY_MODE, NULL, {
 			.read = ipa3_read_page_recycle_stats,
 		}
+	}, {
+		"napi_stats", IPA_READ_ONLY_MODE, NULL, {
+			.read = ipa3_read_napi_stats,
+		}
 	}, {
 		"wdi", IPA_READ_ONLY_MODE, NULL, {
 			.read = ipa3_read_wdi,
@@ -10,6 +10,7 @@
 #include <linux/list.h>
 #include <linux/netdevice.h>
 #include <linux/msm_gsi.h>
+#include <linux/sched/clock.h>
 #include <net/sock.h>
 #include "gsi.h"
 #include "ipa_i.h"
@@ -23,6 +24,9 @@
 #define IPA_LAN_AGGR_PKT_CNT 1
 #define IPA_LAN_NAPI_MAX_FRAMES (NAPI_WEIGHT / IPA_LAN_AGGR_PKT_CNT)
 #define IPA_LAST_DESC_CNT 0xFFFF
+#define IPA_NAPI_MIN_WEIGHT 8
+#define IPA_NAPI_POLL_MAX_NS (500 * NSEC_PER_USEC)
+#define IPA_NAPI_LOW_OCC_DIV 4
 #define POLLING_INACTIVITY_RX 40
 #define POLLING_MIN_SLEEP_RX 1010
 #define POLLING_MAX_SLEEP_RX 1050
@@ -78,6 +82,11 @@
 #define IPA_DEFAULT_SYS_YELLOW_WM 32
 #define IPA_REPL_XFER_THRESH 20
 #define IPA_REPL_XFER_MAX 36
+/*
+ * Number of page recycle cache entries past the head that are checked for
+ * an idle page before falling back to a temporary page allocation.
+ */
+#define IPA_PAGE_RECYCLE_LOOKAHEAD 16
 
 #define IPA_TX_SEND_COMPL_NOP_DELAY_NS (2 * 1000 * 1000)
 
@@ -1219,6 +1228,7 @@ int ipa3_setup_sys_pipe(struct ipa_sys_connect_params *sys_in, u32 *clnt_hdl)
 	ep->client = sys_in->client;
 	ep->client_notify = sys_in->notify;
 	ep->sys->napi_obj = sys_in->napi_obj;
+	ep->sys->napi_weight = NAPI_WEIGHT;
 	ep->priv = sys_in->priv;
 	ep->keep_ipa_awake = sys_in->keep_ipa_awake;
 	atomic_set(&ep->avail_fifo_desc,
@@ -2163,6 +2173,42 @@ static inline void __trigger_repl_work(struct ipa3_sys_context *sys)
 }
 
 
+/*
+ * Pages in the recycle cache hold one reference owned by the cache, so a
+ * page whose count is back to one has been released by the stack and can
+ * be posted again. If the page at the head is still held, typically by a
+ * socket receive queue, look a few entries further for an idle one and
+ * swap it into the head slot rather than giving up on recycling.
+ */
+static bool ipa3_page_recycle_find_idle(struct ipa3_sys_context *sys,
+	u32 curr, u32 stats_i)
+{
+	struct ipa3_page_recycle_stats *stats =
+		&ipa3_ctx->stats.page_recycle_stats[stats_i];
+	struct ipa3_rx_pkt_wrapper **cache = sys->page_recycle_repl->cache;
+	u32 capacity = sys->page_recycle_repl->capacity;
+	u32 i, next;
+
+	if (page_ref_count(cache[curr]->page_data.page) == 1) {
+		stats->recycled++;
+		return true;
+	}
+
+	stats->head_busy++;
+	next = curr;
+	for (i = 0; i < IPA_PAGE_RECYCLE_LOOKAHEAD && i < capacity - 1; i++) {
+		next = (next + 1 == capacity) ? 0 : next + 1;
+		if (page_ref_count(cache[next]->page_data.page) == 1) {
+			swap(cache[curr], cache[next]);
+			stats->recycled++;
+			stats->lookahead_hit++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
 static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys)
 {
 	struct ipa3_rx_pkt_wrapper *rx_pkt;
@@ -2186,20 +2232,24 @@ static void ipa3_replenish_rx_page_recycle(struct ipa3_sys_context *sys)
 	curr_wq = atomic_read(&sys->repl->head_idx);
 
 	while (rx_len_cached < sys->rx_pool_sz) {
-		cur_page = sys->page_recycle_repl->cache[curr]->page_data.page;
 		/* Found an idle page that can be used */
-		if (page_ref_count(cur_page) == 1) {
+		if (ipa3_page_recycle_find_idle(sys, curr, stats_i)) {
+			cur_page =
+				sys->page_recycle_repl->cache[curr]->page_data.page;
 			page_ref_inc(cur_page);
 			rx_pkt = sys->page_recycle_repl->cache[curr];
 			curr = (++curr == sys->page_recycle_repl->capacity) ?
 								0 : curr;
 		} else {
 			/*
-			 * Could not find idle page at curr index.
+			 * Could not find idle page near curr index.
 			 * Allocate a new one.
 			 */
-			if (curr_wq == atomic_read(&sys->repl->tail_idx))
+			if (curr_wq == atomic_read(&sys->repl->tail_idx)) {
+				ipa3_ctx->stats.page_recycle_stats[stats_i]
+					.repl_empty++;
 				break;
+			}
 			ipa3_ctx->stats.page_recycle_stats[stats_i].tmp_alloc++;
 			rx_pkt = sys->repl->cache[curr_wq];
 			curr_wq = (++curr_wq == sys->repl->capacity) ?
@@ -3421,7 +3471,7 @@ static int ipa3_wan_rx_pyld_hdlr(struct sk_buff *skb,
 
 static struct sk_buff *ipa3_get_skb_ipa_rx(unsigned int len, gfp_t flags)
 {
-	return __dev_alloc_skb(len, flags);
+	return __dev_alloc_skb_recycle(len, flags);
 }
 
 static void ipa3_free_skb_rx(struct sk_buff *skb)
@@ -3658,7 +3708,8 @@ static struct sk_buff *handle_page_completion(struct gsi_chan_xfer_notify
 	/* Check added for handling LAN consumer packet without EOT flag */
 	if (notify->evt_id == GSI_CHAN_EVT_EOT ||
 		sys->ep->client == IPA_CLIENT_APPS_LAN_CONS) {
-		rx_skb = alloc_skb(0, GFP_ATOMIC);
+		rx_skb = __alloc_skb(0, GFP_ATOMIC, SKB_ALLOC_RECYCLE,
+				     NUMA_NO_NODE);
 		if (unlikely(!rx_skb)) {
 			IPAERR("skb alloc failure, free all pending pages\n");
 			list_for_each_entry_safe(rx_pkt, tmp, head, link) {
@@ -5248,6 +5299,49 @@ static int ipa_poll_gsi_n_pkt(struct ipa3_sys_context *sys,
 	*actual_num = idx + poll_num;
 	return ret;
 }
+static void ipa3_napi_record_occupancy(struct ipa3_sys_context *sys)
+{
+	u32 bucket = 0;
+
+	if (sys->rx_pool_sz)
+		bucket = min_t(u32, sys->len * IPA_NAPI_OCC_BUCKETS /
+			sys->rx_pool_sz, IPA_NAPI_OCC_BUCKETS - 1);
+
+	IPA_STATS_INC_CNT(sys->napi_occ_hist[bucket]);
+}
+
+/**
+ * ipa3_napi_adapt_weight() - Resize the NAPI budget of a pipe
+ * @sys: [in] pipe which was just polled
+ * @weight: [in] budget used for this poll
+ * @cnt: [in] work done in this poll
+ * @start: [in] sched_clock() at the start of this poll
+ * @min_weight: [in] smallest budget the pipe can make progress with
+ *
+ * Polls that run too long, or leave the ring short of posted buffers,
+ * halve the budget so the replenish handler runs more often. Bursts that
+ * use up the whole budget double it again, up to NAPI_WEIGHT.
+ */
+static void ipa3_napi_adapt_weight(struct ipa3_sys_context *sys,
+	int weight, int cnt, u64 start, u32 min_weight)
+{
+	u32 new_weight = sys->napi_weight;
+
+	min_weight = max_t(u32, min_weight, IPA_NAPI_MIN_WEIGHT);
+	if (sched_clock() - start > IPA_NAPI_POLL_MAX_NS ||
+		sys->len < sys->rx_pool_sz / IPA_NAPI_LOW_OCC_DIV)
+		new_weight = max_t(u32, new_weight / 2, min_weight);
+	else if (cnt >= weight)
+		new_weight = min_t(u32, new_weight * 2, NAPI_WEIGHT);
+
+	if (new_weight < sys->napi_weight)
+		IPA_STATS_INC_CNT(sys->napi_weight_shrink);
+	else if (new_weight > sys->napi_weight)
+		IPA_STATS_INC_CNT(sys->napi_weight_grow);
+
+	sys->napi_weight = new_weight;
+}
+
 /**
  * ipa3_lan_rx_poll() - Poll the LAN rx packets from IPA HW.
  * This function is executed in the softirq context
@@ -5255,21 +5349,27 @@ static int ipa_poll_gsi_n_pkt(struct ipa3_sys_context *sys,
  * if input budget is zero, the driver switches back to
  * interrupt mode.
  *
+ * Only the adaptive share of @budget is used in a poll. When that share
+ * is used up the whole @budget is reported so that NAPI keeps polling.
+ *
  * return number of polled packets, on error 0(zero)
  */
-int ipa3_lan_rx_poll(u32 clnt_hdl, int weight)
+int ipa3_lan_rx_poll(u32 clnt_hdl, int budget)
 {
 	struct ipa3_ep_context *ep;
 	int ret;
 	int cnt = 0;
+	int weight;
 	int remain_aggr_weight;
 	struct gsi_chan_xfer_notify notify;
+	u64 start = sched_clock();
 
 	if (unlikely(clnt_hdl >= ipa3_ctx->ipa_num_pipes ||
 		ipa3_ctx->ep[clnt_hdl].valid == 0)) {
 		IPAERR("bad param 0x%x\n", clnt_hdl);
 		return cnt;
 	}
+	weight = min_t(int, budget, ipa3_ctx->ep[clnt_hdl].sys->napi_weight);
 	remain_aggr_weight = weight / IPA_LAN_AGGR_PKT_CNT;
 	if (unlikely(remain_aggr_weight > IPA_LAN_NAPI_MAX_FRAMES)) {
 		IPAERR("NAPI weight is higher than expected\n");
@@ -5279,6 +5379,7 @@ int ipa3_lan_rx_poll(u32 clnt_hdl, int weight)
 	}
 	ep = &ipa3_ctx->ep[clnt_hdl];
 	trace_ipa3_napi_poll_entry(ep->client);
+	ipa3_napi_record_occupancy(ep->sys);
 
 start_poll:
 	/*
@@ -5318,6 +5419,10 @@ int ipa3_lan_rx_poll(u32 clnt_hdl, int weight)
 		IPA_ACTIVE_CLIENTS_DEC_EP_NO_BLOCK(ep->client);
 	}
 
+	ipa3_napi_adapt_weight(ep->sys, weight, cnt, start,
+		IPA_LAN_AGGR_PKT_CNT);
+	if (cnt >= weight)
+		cnt = budget;
 	trace_ipa3_napi_poll_exit(ep->client, cnt, ep->sys->len);
 	return cnt;
 }
@@ -5329,17 +5434,26 @@ int ipa3_lan_rx_poll(u32 clnt_hdl, int weight)
  * if input budget is zero, the driver switches back to
  * interrupt mode.
  *
+ * Only the adaptive share of @budget is used in a poll. When that share
+ * is used up the whole @budget is reported so that NAPI keeps polling.
+ *
+ * This may also be called from socket busy poll, with the pipe possibly
+ * still in interrupt mode. In that case nothing is polled, and the pipe
+ * only goes back to interrupt mode once NAPI really completes.
+ *
  * return number of polled packets, on error 0(zero)
  */
-int ipa3_rx_poll(u32 clnt_hdl, int weight)
+int ipa3_rx_poll(u32 clnt_hdl, int budget)
 {
 	struct ipa3_ep_context *ep;
 	struct ipa3_sys_context *wan_def_sys;
 	int ret;
 	int cnt = 0;
 	int num = 0;
+	int weight;
 	int remain_aggr_weight;
 	int ipa_ep_idx;
+	u64 start = sched_clock();
 	struct ipa_active_client_logging_info log;
 	static struct gsi_chan_xfer_notify notify[IPA_WAN_NAPI_MAX_FRAMES];
 
@@ -5360,9 +5474,23 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 	}
 	ep = &ipa3_ctx->ep[clnt_hdl];
 
+	/*
+	 * Busy poll can own NAPI while the pipe is in interrupt mode, in
+	 * which case we hold no clock vote and must not touch the HW.
+	 */
+	if (!atomic_read(&ep->sys->curr_polling_state)) {
+		napi_complete_done(ep->sys->napi_obj, 0);
+		return 0;
+	}
+
+	if (test_bit(NAPI_STATE_IN_BUSY_POLL, &ep->sys->napi_obj->state))
+		IPA_STATS_INC_CNT(ep->sys->napi_busy_poll_cnt);
+
 	trace_ipa3_napi_poll_entry(ep->client);
+	ipa3_napi_record_occupancy(ep->sys);
 
 	wan_def_sys = ipa3_ctx->ep[ipa_ep_idx].sys;
+	weight = min_t(int, budget, ep->sys->napi_weight);
 	remain_aggr_weight = weight / ipa3_ctx->ipa_wan_aggr_pkt_cnt;
 	if (remain_aggr_weight > IPA_WAN_NAPI_MAX_FRAMES) {
 		IPAERR("NAPI weight is higher than expected\n");
@@ -5409,18 +5537,29 @@ int ipa3_rx_poll(u32 clnt_hdl, int weight)
 	 */
 	if (cnt < weight && ep->sys->len > IPA_DEFAULT_SYS_YELLOW_WM &&
 		wan_def_sys->len > IPA_DEFAULT_SYS_YELLOW_WM) {
-		napi_complete(ep->sys->napi_obj);
-		IPA_STATS_INC_CNT(ep->sys->napi_comp_cnt);
-		ret = ipa3_rx_switch_to_intr_mode(ep->sys);
-		if (ret == -GSI_STATUS_PENDING_IRQ &&
-				napi_reschedule(ep->sys->napi_obj))
-			goto start_poll;
-		IPA_ACTIVE_CLIENTS_DEC_EP_NO_BLOCK(ep->client);
+		/*
+		 * NAPI does not complete while busy polling or when it was
+		 * scheduled again meanwhile. Stay in polling mode, we will
+		 * be called again.
+		 */
+		if (napi_complete(ep->sys->napi_obj)) {
+			IPA_STATS_INC_CNT(ep->sys->napi_comp_cnt);
+			ret = ipa3_rx_switch_to_intr_mode(ep->sys);
+			if (ret == -GSI_STATUS_PENDING_IRQ &&
+					napi_reschedule(ep->sys->napi_obj))
+				goto start_poll;
+			IPA_ACTIVE_CLIENTS_DEC_EP_NO_BLOCK(ep->client);
+		}
 	} else {
 		cnt = weight;
 		IPADBG_LOW("Client = %d not replenished free descripotrs\n",
 				ep->client);
 	}
+
+	ipa3_napi_adapt_weight(ep->sys, weight, cnt, start,
+		ipa3_ctx->ipa_wan_aggr_pkt_cnt);
+	if (cnt >= weight)
+		cnt = budget;
 	trace_ipa3_napi_poll_exit(ep->client, cnt, ep->sys->len);
 	return cnt;
 }
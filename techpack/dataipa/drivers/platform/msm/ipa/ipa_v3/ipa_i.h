@@ -78,6 +78,7 @@
 #define IPA_MAX_NUM_REQ_CACHE 10
 
 #define NAPI_WEIGHT 64
+#define IPA_NAPI_OCC_BUCKETS 8
 
 #define NAPI_TX_WEIGHT 64
 
@@ -1062,6 +1063,12 @@ struct ipa3_repl_ctx {
  * @napi_tx: napi for eot write done handle (tx_complete) - to replace tasklet
  * @in_napi_context: an atomic variable used for non-blocking locking,
  * preventing from multiple napi_sched to be called.
+ * @napi_weight: current adaptive NAPI budget of the pipe
+ * @napi_occ_hist: histogram of posted rx buffers (in 1/8 of the pool) seen
+ * at the start of each NAPI poll
+ * @napi_weight_shrink: number of times the NAPI budget was reduced
+ * @napi_weight_grow: number of times the NAPI budget was increased
+ * @napi_busy_poll_cnt: number of polls done on behalf of socket busy poll
  *
  * IPA context specific to the GPI pipes a.k.a LAN IN/OUT and WAN
  */
@@ -1099,6 +1106,11 @@ struct ipa3_sys_context {
 	u32 eob_drop_cnt;
 	struct napi_struct napi_tx;
 	atomic_t in_napi_context;
+	u32 napi_weight;
+	u32 napi_occ_hist[IPA_NAPI_OCC_BUCKETS];
+	u32 napi_weight_shrink;
+	u32 napi_weight_grow;
+	u32 napi_busy_poll_cnt;
 
 	/* ordering is important - mutable fields go above */
 	struct ipa3_ep_context *ep;
@@ -1418,9 +1430,22 @@ enum ipa3_config_this_ep {
 	IPA_DO_NOT_CONFIGURE_THIS_EP,
 };
 
+/**
+ * struct ipa3_page_recycle_stats - page recycle cache statistics
+ * @total_replenished: buffers posted to the pipe
+ * @tmp_alloc: buffers posted from a temporary page, i.e. recycle misses
+ * @recycled: buffers posted from an idle page of the recycle cache
+ * @head_busy: times the page at the cache head was still held by the stack
+ * @lookahead_hit: recycle hits found past a busy head
+ * @repl_empty: misses that found the temporary page ring empty as well
+ */
 struct ipa3_page_recycle_stats {
 	u64 total_replenished;
 	u64 tmp_alloc;
+	u64 recycled;
+	u64 head_busy;
+	u64 lookahead_hit;
+	u64 repl_empty;
 };
 struct ipa3_stats {
 	u32 tx_sw_pkts;
@@ -3111,7 +3136,7 @@ int ipa3_setup_apps_low_lat_cons_pipe(void);
 int ipa3_teardown_apps_low_lat_pipes(void);
 const char *ipa_hw_error_str(enum ipa3_hw_errors err_type);
 int ipa_gsi_ch20_wa(void);
-int ipa3_lan_rx_poll(u32 clnt_hdl, int weight);
+int ipa3_lan_rx_poll(u32 clnt_hdl, int budget);
 int ipa3_smmu_map_peer_reg(phys_addr_t phys_addr, bool map,
 	enum ipa_smmu_cb_type cb_type);
 int ipa3_smmu_map_peer_buff(u64 iova, u32 size, bool map, struct sg_table *sgt,
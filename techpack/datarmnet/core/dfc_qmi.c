@@ -15,6 +15,7 @@
 #include "rmnet_qmi.h"
 #include "qmi_rmnet.h"
 #include "dfc_defs.h"
+#include "rmnet_genl.h"
 
 #define CREATE_TRACE_POINTS
 #include "dfc.h"
@@ -923,6 +924,16 @@ int dfc_bearer_flow_ctl(struct net_device *dev,
 
 	enable = bearer->grant_size ? true : false;
 
+	if (!enable && !bearer->fc_stop_time) {
+		bearer->fc_stop_time = ktime_get();
+		qmi_rmnet_fc_trace(RMNET_CORE_DFC_TRACE_STOP, qos, bearer, 0);
+	} else if (enable && bearer->fc_stop_time) {
+		qmi_rmnet_fc_trace(RMNET_CORE_DFC_TRACE_START, qos, bearer,
+				   ktime_us_delta(ktime_get(),
+						  bearer->fc_stop_time));
+		bearer->fc_stop_time = 0;
+	}
+
 	qmi_rmnet_flow_control(dev, bearer->mq_idx, enable);
 
 	/* Do not flow disable tcp ack q in tcp bidir */
@@ -955,6 +966,7 @@ static int dfc_all_bearer_flow_ctl(struct net_device *dev,
 		bearer->last_seq = fc_info->seq_num;
 		bearer->last_adjusted_grant = fc_info->num_bytes;
 
+		qmi_rmnet_fc_trace(RMNET_CORE_DFC_TRACE_GRANT, qos, bearer, 0);
 		dfc_bearer_flow_ctl(dev, bearer, qos);
 	}
 
@@ -1054,6 +1066,8 @@ static int dfc_update_fc_map(struct net_device *dev, struct qos_info *qos,
 		itm->last_seq = fc_info->seq_num;
 		itm->last_adjusted_grant = adjusted_grant;
 
+		qmi_rmnet_fc_trace(RMNET_CORE_DFC_TRACE_GRANT, qos, itm, 0);
+
 		if (action)
 			rc = dfc_bearer_flow_ctl(dev, itm, qos);
 	}
@@ -1129,6 +1143,45 @@ void dfc_do_burst_flow_control(struct dfc_qmi_data *dfc,
 	rcu_read_unlock();
 }
 
+/*
+ * Apply recorded grants as if they came from the modem, one indication per
+ * grant. Acks are never requested so the modem does not see the replay.
+ */
+int dfc_qmi_replay(void *dfc_data, struct rmnet_core_dfc_replay_req *req,
+		   u32 *applied)
+{
+	struct dfc_qmi_data *dfc = (struct dfc_qmi_data *)dfc_data;
+	struct dfc_flow_status_ind_msg_v01 *ind;
+	struct dfc_flow_status_info_type_v01 *flow_status;
+	struct rmnet_core_dfc_grant *grant;
+	u16 i;
+
+	ind = kzalloc(sizeof(*ind), GFP_KERNEL);
+	if (!ind)
+		return -ENOMEM;
+
+	ind->flow_status_valid = 1;
+	ind->flow_status_len = 1;
+	flow_status = &ind->flow_status[0];
+
+	for (i = 0; i < req->list_len; i++) {
+		grant = &req->list[i];
+
+		flow_status->mux_id = grant->mux_id;
+		flow_status->bearer_id = grant->bearer_id;
+		flow_status->num_bytes = grant->num_bytes;
+		flow_status->seq_num = grant->seq;
+		flow_status->rx_bytes_valid = grant->rx_bytes_valid;
+		flow_status->rx_bytes = grant->rx_bytes;
+
+		dfc_do_burst_flow_control(dfc, ind, grant->is_query);
+		(*applied)++;
+	}
+
+	kfree(ind);
+	return 0;
+}
+
 static void dfc_update_tx_link_status(struct net_device *dev,
 				      struct qos_info *qos, u8 tx_status,
 				      struct dfc_bearer_info_type_v01 *binfo)
@@ -16,6 +16,7 @@
 #include "qmi_rmnet.h"
 #include "rmnet_qmi.h"
 #include "dfc.h"
+#include "rmnet_genl.h"
 #include <linux/rtnetlink.h>
 #include <uapi/linux/rtnetlink.h>
 #include <net/pkt_sched.h>
@@ -220,6 +221,127 @@ int qmi_rmnet_flow_control(struct net_device *dev, u32 mq_idx, int enable)
 	return 0;
 }
 
+/* Flow control trace ring, drained through rmnet_genl */
+#define FC_TRACE_LEN 1024
+#define FC_TRACE_MASK (FC_TRACE_LEN - 1)
+
+static struct rmnet_core_dfc_trace_rec fc_trace[FC_TRACE_LEN];
+static u32 fc_trace_head;
+static u32 fc_trace_tail;
+static u32 fc_trace_dropped;
+static DEFINE_SPINLOCK(fc_trace_lock);
+
+/**
+ * qmi_rmnet_fc_trace - record a grant or queue state change of a bearer
+ * Needs to be called with qos_lock
+ */
+void qmi_rmnet_fc_trace(u8 event, struct qos_info *qos,
+			struct rmnet_bearer_map *bearer, u32 stop_us)
+{
+	struct rmnet_core_dfc_trace_rec *rec;
+	unsigned long flags;
+
+	spin_lock_irqsave(&fc_trace_lock, flags);
+
+	if (fc_trace_head - fc_trace_tail >= FC_TRACE_LEN) {
+		fc_trace_tail++;
+		fc_trace_dropped++;
+	}
+
+	rec = &fc_trace[fc_trace_head & FC_TRACE_MASK];
+	rec->timestamp = ktime_get_ns();
+	rec->grant = bearer->grant_size;
+	rec->bytes_in_flight = bearer->bytes_in_flight;
+	rec->stop_us = stop_us;
+	rec->seq = bearer->seq;
+	rec->mux_id = qos->mux_id;
+	rec->bearer_id = bearer->bearer_id;
+	rec->event = event;
+	fc_trace_head++;
+
+	spin_unlock_irqrestore(&fc_trace_lock, flags);
+}
+
+void qmi_rmnet_fc_trace_get(struct rmnet_core_dfc_trace_resp *resp)
+{
+	unsigned long flags;
+	u16 i = 0;
+
+	spin_lock_irqsave(&fc_trace_lock, flags);
+
+	while (fc_trace_tail != fc_trace_head &&
+	       i < RMNET_CORE_GENL_MAX_FC_RECS) {
+		resp->list[i++] = fc_trace[fc_trace_tail & FC_TRACE_MASK];
+		fc_trace_tail++;
+	}
+
+	resp->dropped = fc_trace_dropped;
+	fc_trace_dropped = 0;
+
+	spin_unlock_irqrestore(&fc_trace_lock, flags);
+
+	resp->list_len = i;
+	resp->timestamp = ktime_get_ns();
+}
+
+/**
+ * qmi_rmnet_dfc_replay - feed recorded grants to the DFC client of a port
+ * @net: namespace of the requester
+ * @req: grants to apply and the device whose port they go to
+ * @elapsed_ns: time spent in the flow control logic
+ * @applied: number of grants applied
+ *
+ * The grants are applied back to back @req->repeat times to measure the
+ * flow control logic under a peak burst of indications. They hit the live
+ * bearer state, so this is meant for the lab, not for a device in use.
+ */
+int qmi_rmnet_dfc_replay(struct net *net,
+			 struct rmnet_core_dfc_replay_req *req,
+			 u64 *elapsed_ns, u32 *applied)
+{
+	struct net_device *dev;
+	struct qmi_info *qmi;
+	void *port, *dfc;
+	u64 start;
+	u16 pass;
+	int rc = -ENODEV;
+
+	*elapsed_ns = 0;
+	*applied = 0;
+
+	if (!req->list_len || req->list_len > RMNET_CORE_GENL_MAX_FC_RECS)
+		return -EINVAL;
+
+	rtnl_lock();
+
+	/* Only rmnet devices carry a port to look up */
+	dev = __dev_get_by_name(net, req->ifname);
+	if (!dev || !dev->rtnl_link_ops ||
+	    strcmp(dev->rtnl_link_ops->kind, "rmnet"))
+		goto out;
+
+	port = rmnet_get_rmnet_port(dev);
+	if (!port)
+		goto out;
+
+	qmi = (struct qmi_info *)rmnet_get_qmi_pt(port);
+	dfc = qmi_rmnet_has_dfc_client(qmi);
+	if (!dfc)
+		goto out;
+
+	start = ktime_get_ns();
+	for (pass = 0; pass < max_t(u16, req->repeat, 1); pass++) {
+		rc = dfc_qmi_replay(dfc, req, applied);
+		if (rc)
+			break;
+	}
+	*elapsed_ns = ktime_get_ns() - start;
+
+out:
+	rtnl_unlock();
+	return rc;
+}
+
 static void qmi_rmnet_reset_txq(struct net_device *dev, unsigned int txq)
 {
 	struct Qdisc *qdisc;
@@ -20,6 +20,9 @@
 #define CONFIG_QTI_QMI_DFC  1
 #define CONFIG_QTI_QMI_POWER_COLLAPSE 1
 
+struct rmnet_core_dfc_trace_resp;
+struct rmnet_core_dfc_replay_req;
+
 struct qmi_rmnet_ps_ind {
 	void (*ps_on_handler)(void *port);
 	void (*ps_off_handler)(void *port);
@@ -62,6 +65,10 @@ void qmi_rmnet_qos_exit_post(void);
 void qmi_rmnet_burst_fc_check(struct net_device *dev,
 			      int ip_type, u32 mark, unsigned int len);
 int qmi_rmnet_get_queue(struct net_device *dev, struct sk_buff *skb);
+void qmi_rmnet_fc_trace_get(struct rmnet_core_dfc_trace_resp *resp);
+int qmi_rmnet_dfc_replay(struct net *net,
+			 struct rmnet_core_dfc_replay_req *req,
+			 u64 *elapsed_ns, u32 *applied);
 #else
 static inline void *
 qmi_rmnet_qos_init(struct net_device *real_dev,
@@ -89,6 +96,18 @@ static inline int qmi_rmnet_get_queue(struct net_device *dev,
 {
 	return 0;
 }
+
+static inline void
+qmi_rmnet_fc_trace_get(struct rmnet_core_dfc_trace_resp *resp)
+{
+}
+
+static inline int qmi_rmnet_dfc_replay(struct net *net,
+				       struct rmnet_core_dfc_replay_req *req,
+				       u64 *elapsed_ns, u32 *applied)
+{
+	return -EINVAL;
+}
 #endif
 
 #ifdef CONFIG_QTI_QMI_POWER_COLLAPSE
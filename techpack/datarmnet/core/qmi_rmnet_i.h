@@ -38,6 +38,7 @@ extern int dfc_mode;
 extern int dfc_qmap;
 
 struct qos_info;
+struct rmnet_core_dfc_replay_req;
 
 struct rmnet_bearer_map {
 	struct list_head list;
@@ -54,6 +55,7 @@ struct rmnet_bearer_map {
 	bool tcp_bidir;
 	bool rat_switch;
 	bool tx_off;
+	ktime_t fc_stop_time;
 	u32 ack_txid;
 	u32 mq_idx;
 	u32 ack_mq_idx;
@@ -169,6 +171,12 @@ void qmi_rmnet_watchdog_add(struct rmnet_bearer_map *bearer);
 
 void qmi_rmnet_watchdog_remove(struct rmnet_bearer_map *bearer);
 
+void qmi_rmnet_fc_trace(u8 event, struct qos_info *qos,
+			struct rmnet_bearer_map *bearer, u32 stop_us);
+
+int dfc_qmi_replay(void *dfc_data, struct rmnet_core_dfc_replay_req *req,
+		   u32 *applied);
+
 #else
 static inline struct rmnet_flow_map *
 qmi_rmnet_get_flow_map(struct qos_info *qos_info,
@@ -24,6 +24,7 @@
 #include "rmnet_map.h"
 #include "rmnet_descriptor.h"
 #include "rmnet_genl.h"
+#include "rmnet_steer.h"
 #include "rmnet_qmi.h"
 #include "qmi_rmnet.h"
 #define CONFIG_QTI_QMI_RMNET 1
@@ -97,6 +98,7 @@ static int rmnet_unregister_real_device(struct net_device *real_dev,
 	rmnet_map_tx_aggregate_exit(port);
 
 	rmnet_descriptor_deinit(port);
+	skb_recycle_unregister();
 
 	kfree(port);
 
@@ -142,6 +144,9 @@ static int rmnet_register_real_device(struct net_device *real_dev)
 	rmnet_map_tx_aggregate_init(port);
 	rmnet_map_cmd_init(port);
 
+	/* Downlink skbs are built by rmnet_alloc_skb() from the recycle cache */
+	skb_recycle_register();
+
 	netdev_dbg(real_dev, "registered with rmnet\n");
 	return 0;
 }
@@ -752,13 +757,18 @@ static int __init rmnet_init(void)
 {
 	int rc;
 
+	rmnet_steer_init();
+
 	rc = register_netdevice_notifier(&rmnet_dev_notifier);
-	if (rc != 0)
+	if (rc != 0) {
+		rmnet_steer_exit();
 		return rc;
+	}
 
 	rc = rtnl_link_register(&rmnet_link_ops);
 	if (rc != 0) {
 		unregister_netdevice_notifier(&rmnet_dev_notifier);
+		rmnet_steer_exit();
 		return rc;
 	}
 
@@ -773,6 +783,7 @@ static void __exit rmnet_exit(void)
 	unregister_netdevice_notifier(&rmnet_dev_notifier);
 	rtnl_link_unregister(&rmnet_link_ops);
 	rmnet_core_genl_deinit();
+	rmnet_steer_exit();
 
 	module_put(THIS_MODULE);
 }
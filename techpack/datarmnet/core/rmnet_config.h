@@ -15,6 +15,7 @@
 
 #include <linux/skbuff.h>
 #include <net/gro_cells.h>
+#include <net/xdp.h>
 
 #ifndef _RMNET_CONFIG_H_
 #define _RMNET_CONFIG_H_
@@ -31,6 +32,9 @@ struct rmnet_endpoint {
 struct rmnet_agg_stats {
 	u64 ul_agg_reuse;
 	u64 ul_agg_alloc;
+	u64 ul_agg_ll_pkts;
+	u64 ul_agg_time_shrink;
+	u64 ul_agg_time_grow;
 };
 
 struct rmnet_port_priv_stats {
@@ -89,6 +93,10 @@ struct rmnet_port {
 	u8 agg_size_order;
 	struct list_head agg_list;
 	struct rmnet_agg_page *agg_head;
+	/* Flush timer currently in use, bounded by egress_agg_params */
+	u32 agg_time_cur;
+	/* Last time an interactive UL packet was seen, in jiffies */
+	unsigned long agg_ll_last;
 
 	void *qmi_info;
 
@@ -144,6 +152,11 @@ struct rmnet_coal_stats {
 	u64 coal_tcp_bytes;
 	u64 coal_udp;
 	u64 coal_udp_bytes;
+	u64 coal_csum_sw_close_coal;
+	u64 coal_csum_sw_close_hw;
+	u64 coal_csum_sw_err;
+	u64 coal_csum_sw_zero;
+	u64 coal_desc_merged;
 };
 
 struct rmnet_priv_stats {
@@ -159,6 +172,12 @@ struct rmnet_priv_stats {
 	u64 csum_hw;
 	struct rmnet_coal_stats coal;
 	u64 ul_prio;
+	u64 xdp_pass;
+	u64 xdp_drop;
+	u64 xdp_tx;
+	u64 xdp_redirect;
+	u64 xdp_aborted;
+	u64 xdp_skipped;
 };
 
 struct rmnet_priv {
@@ -168,6 +187,8 @@ struct rmnet_priv {
 	struct gro_cells gro_cells;
 	struct rmnet_priv_stats stats;
 	void __rcu *qos_info;
+	struct bpf_prog __rcu *xdp_prog;
+	struct xdp_rxq_info xdp_rxq;
 };
 
 enum rmnet_dl_marker_prio {
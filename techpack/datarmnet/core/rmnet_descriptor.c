@@ -13,10 +13,14 @@
  *
  */
 
+#include <linux/bpf.h>
+#include <linux/filter.h>
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <net/ipv6.h>
 #include <net/ip6_checksum.h>
+#include <net/xdp.h>
+#include <trace/events/xdp.h>
 #include "rmnet_config.h"
 #include "rmnet_descriptor.h"
 #include "rmnet_handlers.h"
@@ -26,6 +30,8 @@
 #include "qmi_rmnet.h"
 
 #define RMNET_FRAG_DESCRIPTOR_POOL_SIZE 64
+#define RMNET_FRAG_GRO_MAX_LEN 65535
+#define RMNET_FRAG_GRO_HDR_MAX (sizeof(struct ipv6hdr) + 15 * 4)
 #define RMNET_DL_IND_HDR_SIZE (sizeof(struct rmnet_map_dl_ind_hdr) + \
 			       sizeof(struct rmnet_map_header) + \
 			       sizeof(struct rmnet_map_control_command_header))
@@ -597,6 +603,9 @@ static int rmnet_frag_deaggregate_one(struct sk_buff *skb,
 	if (!frag_desc)
 		return -1;
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	frag_desc->napi_id = skb->napi_id;
+#endif
 	pkt_len += sizeof(*maph);
 	if (port->data_format & RMNET_FLAGS_INGRESS_MAP_CKSUMV4) {
 		pkt_len += sizeof(struct rmnet_map_dl_csum_trailer);
@@ -758,8 +767,9 @@ static struct sk_buff *rmnet_alloc_skb(struct rmnet_frag_descriptor *frag_desc,
 	if (frag_desc->hdrs_valid) {
 		u16 hdr_len = frag_desc->ip_len + frag_desc->trans_len;
 
-		head_skb = alloc_skb(hdr_len + RMNET_MAP_DEAGGR_HEADROOM,
-				     GFP_ATOMIC);
+		head_skb = __alloc_skb(hdr_len + RMNET_MAP_DEAGGR_HEADROOM,
+				       GFP_ATOMIC, SKB_ALLOC_RECYCLE,
+				       NUMA_NO_NODE);
 		if (!head_skb)
 			return NULL;
 
@@ -783,8 +793,9 @@ static struct sk_buff *rmnet_alloc_skb(struct rmnet_frag_descriptor *frag_desc,
 		/* Allocate enough space to avoid penalties in the stack
 		 * from __pskb_pull_tail()
 		 */
-		head_skb = alloc_skb(256 + RMNET_MAP_DEAGGR_HEADROOM,
-				     GFP_ATOMIC);
+		head_skb = __alloc_skb(256 + RMNET_MAP_DEAGGR_HEADROOM,
+				       GFP_ATOMIC, SKB_ALLOC_RECYCLE,
+				       NUMA_NO_NODE);
 		if (!head_skb)
 			return NULL;
 
@@ -811,7 +822,8 @@ static struct sk_buff *rmnet_alloc_skb(struct rmnet_frag_descriptor *frag_desc,
 			}
 		} else {
 			/* Alloc a new skb and try again */
-			skb = alloc_skb(0, GFP_ATOMIC);
+			skb = __alloc_skb(0, GFP_ATOMIC, SKB_ALLOC_RECYCLE,
+					  NUMA_NO_NODE);
 			if (!skb)
 				break;
 
@@ -928,6 +940,11 @@ static struct sk_buff *rmnet_alloc_skb(struct rmnet_frag_descriptor *frag_desc,
 	if (frag_desc->flush_shs)
 		head_skb->cb[0] = 1;
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	/* Let sockets busy poll the NAPI context of the HW */
+	head_skb->napi_id = frag_desc->napi_id;
+#endif
+
 	/* Handle coalesced packets */
 	if (frag_desc->gso_segs > 1)
 		rmnet_frag_gso_stamp(head_skb, frag_desc);
@@ -948,6 +965,204 @@ void rmnet_frag_deliver(struct rmnet_frag_descriptor *frag_desc,
 }
 EXPORT_SYMBOL(rmnet_frag_deliver);
 
+static __be32 rmnet_frag_gro_flag_word(struct rmnet_frag_descriptor *frag_desc,
+				       struct tcphdr *th)
+{
+	__be32 flag_word = tcp_flag_word(th);
+
+	/* Pick up any flags cleared during segmentation */
+	if (frag_desc->tcp_flags_set)
+		*((__be16 *)&flag_word) = frag_desc->tcp_flags;
+
+	return flag_word;
+}
+
+static u32 rmnet_frag_gro_seq(struct rmnet_frag_descriptor *frag_desc,
+			      struct tcphdr *th)
+{
+	return ntohl(frag_desc->tcp_seq_set ? frag_desc->tcp_seq : th->seq);
+}
+
+static u32 rmnet_frag_gro_nr_frags(struct rmnet_frag_descriptor *frag_desc)
+{
+	struct rmnet_fragment *frag;
+	u32 nr_frags = 0;
+
+	list_for_each_entry(frag, &frag_desc->frags, list)
+		nr_frags++;
+
+	return nr_frags;
+}
+
+/* Check if more TCP segments can be appended to this descriptor. It must
+ * be a checksum validated, full sized, pure ACK segment without IP options
+ * or extension headers, and GRO must be enabled on the device since the
+ * stack would have merged the segments back together anyway.
+ */
+static bool rmnet_frag_gro_can_hold(struct rmnet_frag_descriptor *frag_desc)
+{
+	struct tcphdr *th, __th;
+	u32 dlen;
+
+	if (!frag_desc->hdrs_valid || !frag_desc->csum_valid ||
+	    frag_desc->trans_proto != IPPROTO_TCP || !frag_desc->gso_size ||
+	    !(frag_desc->dev->features & NETIF_F_GRO))
+		return false;
+
+	if (frag_desc->ip_len != ((frag_desc->ip_proto == 4) ?
+				  sizeof(struct iphdr) :
+				  sizeof(struct ipv6hdr)))
+		return false;
+
+	dlen = frag_desc->len - frag_desc->ip_len - frag_desc->trans_len;
+	if (dlen != frag_desc->gso_size * frag_desc->gso_segs)
+		return false;
+
+	th = rmnet_frag_header_ptr(frag_desc, frag_desc->ip_len, sizeof(*th),
+				   &__th);
+	if (!th)
+		return false;
+
+	return (rmnet_frag_gro_flag_word(frag_desc, th) &
+		(TCP_FLAG_CWR | TCP_FLAG_ECE | TCP_FLAG_URG | TCP_FLAG_ACK |
+		 TCP_FLAG_PSH | TCP_FLAG_RST | TCP_FLAG_SYN | TCP_FLAG_FIN)) ==
+	       TCP_FLAG_ACK;
+}
+
+/* Try to append the payload of frag_desc to the held descriptor. This
+ * follows the same rules tcp_gro_receive() uses to decide if two segments
+ * belong together, so the resulting skb is what GRO would have built.
+ */
+static bool rmnet_frag_gro_merge(struct rmnet_frag_descriptor *held,
+				 struct rmnet_frag_descriptor *frag_desc,
+				 struct rmnet_port *port)
+{
+	u8 __held_hdr[RMNET_FRAG_GRO_HDR_MAX], __hdr[RMNET_FRAG_GRO_HDR_MAX];
+	u32 hlen = held->ip_len + held->trans_len;
+	u32 held_len = held->len, dlen;
+	struct tcphdr *held_th, *th;
+	__be32 held_flags, flags;
+	u8 *held_hdr, *hdr;
+
+	if (frag_desc->dev != held->dev || !frag_desc->hdrs_valid ||
+	    !frag_desc->csum_valid ||
+	    frag_desc->trans_proto != held->trans_proto ||
+	    frag_desc->ip_proto != held->ip_proto ||
+	    frag_desc->ip_len != held->ip_len ||
+	    frag_desc->trans_len != held->trans_len ||
+	    frag_desc->gso_size != held->gso_size ||
+	    frag_desc->len <= hlen)
+		return false;
+
+	dlen = frag_desc->len - hlen;
+	if (held->len + dlen > RMNET_FRAG_GRO_MAX_LEN ||
+	    held->gso_segs + frag_desc->gso_segs > U16_MAX ||
+	    rmnet_frag_gro_nr_frags(held) +
+	    rmnet_frag_gro_nr_frags(frag_desc) > MAX_SKB_FRAGS)
+		return false;
+
+	held_hdr = rmnet_frag_header_ptr(held, 0, hlen, __held_hdr);
+	hdr = rmnet_frag_header_ptr(frag_desc, 0, hlen, __hdr);
+	if (!held_hdr || !hdr)
+		return false;
+
+	if (held->ip_proto == 4) {
+		struct iphdr *held_iph = (struct iphdr *)held_hdr;
+		struct iphdr *iph = (struct iphdr *)hdr;
+
+		if (held_iph->saddr != iph->saddr ||
+		    held_iph->daddr != iph->daddr ||
+		    held_iph->tos != iph->tos ||
+		    held_iph->ttl != iph->ttl ||
+		    held_iph->frag_off != iph->frag_off)
+			return false;
+	} else {
+		struct ipv6hdr *held_ip6h = (struct ipv6hdr *)held_hdr;
+		struct ipv6hdr *ip6h = (struct ipv6hdr *)hdr;
+
+		/* Version, traffic class and flow label */
+		if (*(__be32 *)held_ip6h != *(__be32 *)ip6h ||
+		    held_ip6h->hop_limit != ip6h->hop_limit ||
+		    !ipv6_addr_equal(&held_ip6h->saddr, &ip6h->saddr) ||
+		    !ipv6_addr_equal(&held_ip6h->daddr, &ip6h->daddr))
+			return false;
+	}
+
+	held_th = (struct tcphdr *)(held_hdr + held->ip_len);
+	th = (struct tcphdr *)(hdr + frag_desc->ip_len);
+	held_flags = rmnet_frag_gro_flag_word(held, held_th);
+	flags = rmnet_frag_gro_flag_word(frag_desc, th);
+
+	/* Only PSH and FIN are allowed to show up on the last segment */
+	if (held_th->source != th->source || held_th->dest != th->dest ||
+	    held_th->ack_seq != th->ack_seq ||
+	    ((held_flags ^ flags) & ~(TCP_FLAG_PSH | TCP_FLAG_FIN)) ||
+	    memcmp(held_th + 1, th + 1, held->trans_len - sizeof(*th)))
+		return false;
+
+	if (rmnet_frag_gro_seq(held, held_th) + held->len - hlen !=
+	    rmnet_frag_gro_seq(frag_desc, th))
+		return false;
+
+	if (rmnet_frag_descriptor_add_frags_from(held, frag_desc, hlen,
+						 dlen) < 0) {
+		/* Drop anything we managed to attach */
+		rmnet_frag_trim(held, port, held_len);
+		return false;
+	}
+
+	if (flags & (TCP_FLAG_PSH | TCP_FLAG_FIN)) {
+		held->tcp_flags_set = 1;
+		held->tcp_flags = *((__be16 *)&flags);
+	}
+
+	held->gso_segs += frag_desc->gso_segs;
+	held->flush_shs |= frag_desc->flush_shs;
+	return true;
+}
+
+/* Deliver a descriptor, merging consecutive segments of the same TCP flow
+ * into the held descriptor instead of building an skb for each of them.
+ */
+static void rmnet_frag_gro_deliver(struct rmnet_frag_descriptor *frag_desc,
+				   struct rmnet_port *port,
+				   struct rmnet_frag_descriptor **held)
+{
+	if (*held) {
+		if (rmnet_frag_gro_merge(*held, frag_desc, port)) {
+			struct rmnet_priv *priv = netdev_priv(frag_desc->dev);
+
+			priv->stats.coal.coal_desc_merged++;
+			rmnet_recycle_frag_descriptor(frag_desc, port);
+			if (!rmnet_frag_gro_can_hold(*held)) {
+				rmnet_frag_deliver(*held, port);
+				*held = NULL;
+			}
+
+			return;
+		}
+
+		rmnet_frag_deliver(*held, port);
+		*held = NULL;
+	}
+
+	if (rmnet_frag_gro_can_hold(frag_desc)) {
+		*held = frag_desc;
+		return;
+	}
+
+	rmnet_frag_deliver(frag_desc, port);
+}
+
+static void rmnet_frag_gro_flush(struct rmnet_port *port,
+				 struct rmnet_frag_descriptor **held)
+{
+	if (*held) {
+		rmnet_frag_deliver(*held, port);
+		*held = NULL;
+	}
+}
+
 static void __rmnet_frag_segment_data(struct rmnet_frag_descriptor *coal_desc,
 				      struct rmnet_port *port,
 				      struct list_head *list, u8 pkt_id,
@@ -1212,16 +1427,23 @@ rmnet_frag_segment_coal_data(struct rmnet_frag_descriptor *coal_desc,
 
 	coal_desc->hdrs_valid = 1;
 
-	if (rmnet_map_v5_csum_buggy(&coal_hdr) && !zero_csum) {
-		/* Mark the checksum as valid if it checks out */
-		if (rmnet_frag_validate_csum(coal_desc))
-			coal_desc->csum_valid = true;
-
-		coal_desc->gso_size = ntohs(coal_hdr.nl_pairs[0].pkt_len);
-		coal_desc->gso_size -= coal_desc->ip_len + coal_desc->trans_len;
-		coal_desc->gso_segs = coal_hdr.nl_pairs[0].num_packets;
-		list_add_tail(&coal_desc->list, list);
-		return;
+	if (rmnet_map_v5_csum_buggy(&coal_hdr)) {
+		rmnet_map_v5_csum_sw_stats(priv, &coal_hdr, zero_csum);
+		if (!zero_csum) {
+			/* Mark the checksum as valid if it checks out */
+			if (rmnet_frag_validate_csum(coal_desc))
+				coal_desc->csum_valid = true;
+			else
+				priv->stats.coal.coal_csum_sw_err++;
+
+			coal_desc->gso_size =
+				ntohs(coal_hdr.nl_pairs[0].pkt_len);
+			coal_desc->gso_size -= coal_desc->ip_len +
+					       coal_desc->trans_len;
+			coal_desc->gso_segs = coal_hdr.nl_pairs[0].num_packets;
+			list_add_tail(&coal_desc->list, list);
+			return;
+		}
 	}
 
 	/* Fast-forward the case where we have 1 NLO (i.e. 1 packet length),
@@ -1468,18 +1690,165 @@ int rmnet_frag_process_next_hdr_packet(struct rmnet_frag_descriptor *frag_desc,
 	return rc;
 }
 
+/* XDP_TX sends the packet back out of the rmnet device, i.e. uplink */
+static int rmnet_frag_xdp_tx(struct net_device *dev, struct xdp_buff *xdp)
+{
+	u32 len = xdp->data_end - xdp->data;
+	struct sk_buff *skb;
+
+	skb = netdev_alloc_skb(dev, len);
+	if (!skb)
+		return -ENOMEM;
+
+	skb_put_data(skb, xdp->data, len);
+	skb_reset_network_header(skb);
+	switch (skb->data[0] & 0xF0) {
+	case 0x40:
+		skb->protocol = htons(ETH_P_IP);
+		break;
+	case 0x60:
+		skb->protocol = htons(ETH_P_IPV6);
+		break;
+	default:
+		kfree_skb(skb);
+		return -EINVAL;
+	}
+
+	dev_queue_xmit(skb);
+	return 0;
+}
+
+/* Redirect targets may build an skb around the buffer or hold on to it past
+ * this NAPI poll, so the packet gets a page of its own with the standard
+ * headroom and room for the shared info.
+ */
+static int rmnet_frag_xdp_redirect(struct net_device *dev,
+				   struct bpf_prog *prog,
+				   struct xdp_buff *xdp)
+{
+	u32 len = xdp->data_end - xdp->data;
+	struct xdp_buff copy;
+	struct page *page;
+	int rc;
+
+	if (len > PAGE_SIZE - XDP_PACKET_HEADROOM -
+		  SKB_DATA_ALIGN(sizeof(struct skb_shared_info)))
+		return -E2BIG;
+
+	page = dev_alloc_page();
+	if (!page)
+		return -ENOMEM;
+
+	copy.data_hard_start = page_address(page);
+	copy.data = copy.data_hard_start + XDP_PACKET_HEADROOM;
+	copy.data_end = copy.data + len;
+	xdp_set_data_meta_invalid(&copy);
+	copy.rxq = xdp->rxq;
+	memcpy(copy.data, xdp->data, len);
+
+	rc = xdp_do_redirect(dev, &copy, prog);
+	if (rc)
+		put_page(page);
+
+	return rc;
+}
+
+/* Run the XDP program of the rmnet device on a descriptor before any skb is
+ * built for it. Only linear packets are offered: coalesced segments keep
+ * their headers in a separate fragment and only get them rewritten when the
+ * skb is built, so they are passed up as they are.
+ *
+ * The packet is left in the aggregation buffer, which it shares with its
+ * neighbours, so the program gets no headroom.
+ *
+ * Returns the descriptor to deliver, or NULL if it was consumed.
+ */
+static struct rmnet_frag_descriptor *
+rmnet_frag_xdp(struct rmnet_frag_descriptor *frag_desc,
+	       struct rmnet_port *port)
+{
+	struct rmnet_priv *priv = netdev_priv(frag_desc->dev);
+	struct bpf_prog *prog;
+	struct xdp_buff xdp;
+	void *data;
+	u32 act, len;
+
+	prog = rcu_dereference(priv->xdp_prog);
+	if (!prog)
+		return frag_desc;
+
+	if (!list_is_singular(&frag_desc->frags) || frag_desc->hdrs_valid) {
+		priv->stats.xdp_skipped++;
+		return frag_desc;
+	}
+
+	data = rmnet_frag_data_ptr(frag_desc);
+	xdp.data_hard_start = data;
+	xdp.data = data;
+	xdp.data_end = data + frag_desc->len;
+	xdp_set_data_meta_invalid(&xdp);
+	xdp.rxq = &priv->xdp_rxq;
+
+	act = bpf_prog_run_xdp(prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		priv->stats.xdp_pass++;
+
+		/* Apply any head or tail adjustment made by the program */
+		len = xdp.data_end - xdp.data;
+		if (xdp.data != data &&
+		    !rmnet_frag_pull(frag_desc, port, xdp.data - data))
+			return NULL;
+
+		if (len != frag_desc->len &&
+		    !rmnet_frag_trim(frag_desc, port, len))
+			return NULL;
+
+		return frag_desc;
+	case XDP_TX:
+		if (rmnet_frag_xdp_tx(frag_desc->dev, &xdp))
+			goto xdp_abort;
+
+		priv->stats.xdp_tx++;
+		break;
+	case XDP_REDIRECT:
+		if (rmnet_frag_xdp_redirect(frag_desc->dev, prog, &xdp))
+			goto xdp_abort;
+
+		priv->stats.xdp_redirect++;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+xdp_abort:
+		trace_xdp_exception(frag_desc->dev, prog, act);
+		priv->stats.xdp_aborted++;
+		break;
+	case XDP_DROP:
+		priv->stats.xdp_drop++;
+		break;
+	}
+
+	rmnet_recycle_frag_descriptor(frag_desc, port);
+	return NULL;
+}
+
 /* Perf hook handler */
 rmnet_perf_desc_hook_t rmnet_perf_desc_entry __rcu __read_mostly;
 EXPORT_SYMBOL(rmnet_perf_desc_entry);
 
 static void
 __rmnet_frag_ingress_handler(struct rmnet_frag_descriptor *frag_desc,
-			     struct rmnet_port *port)
+			     struct rmnet_port *port,
+			     struct rmnet_frag_descriptor **held)
 {
 	rmnet_perf_desc_hook_t rmnet_perf_ingress;
 	struct rmnet_map_header *qmap, __qmap;
 	struct rmnet_endpoint *ep;
 	struct rmnet_frag_descriptor *frag, *tmp;
+	struct rmnet_priv *priv;
+	LIST_HEAD(xdp_segs);
 	LIST_HEAD(segs);
 	u16 len, pad;
 	u8 mux_id;
@@ -1493,6 +1862,8 @@ __rmnet_frag_ingress_handler(struct rmnet_frag_descriptor *frag_desc,
 	len = ntohs(qmap->pkt_len) - pad;
 
 	if (qmap->cd_bit) {
+		/* Keep data ordered against any markers */
+		rmnet_frag_gro_flush(port, held);
 		qmi_rmnet_set_dl_msg_active(port);
 		if (port->data_format & RMNET_INGRESS_FORMAT_DL_MARKER) {
 			rmnet_frag_flow_command(frag_desc, port, len);
@@ -1536,8 +1907,20 @@ __rmnet_frag_ingress_handler(struct rmnet_frag_descriptor *frag_desc,
 		qmi_rmnet_work_maybe_restart(port);
 
 	rcu_read_lock();
+	priv = netdev_priv(ep->egress_dev);
+	if (rcu_access_pointer(priv->xdp_prog)) {
+		list_for_each_entry_safe(frag, tmp, &segs, list) {
+			list_del_init(&frag->list);
+			frag = rmnet_frag_xdp(frag, port);
+			if (frag)
+				list_add_tail(&frag->list, &xdp_segs);
+		}
+		list_splice(&xdp_segs, &segs);
+	}
+
 	rmnet_perf_ingress = rcu_dereference(rmnet_perf_desc_entry);
 	if (rmnet_perf_ingress) {
+		rmnet_frag_gro_flush(port, held);
 		list_for_each_entry_safe(frag, tmp, &segs, list) {
 			list_del_init(&frag->list);
 			rmnet_perf_ingress(frag, port);
@@ -1549,7 +1932,7 @@ __rmnet_frag_ingress_handler(struct rmnet_frag_descriptor *frag_desc,
 
 	list_for_each_entry_safe(frag, tmp, &segs, list) {
 		list_del_init(&frag->list);
-		rmnet_frag_deliver(frag, port);
+		rmnet_frag_gro_deliver(frag, port, held);
 	}
 	return;
 
@@ -1565,6 +1948,7 @@ void rmnet_frag_ingress_handler(struct sk_buff *skb,
 				struct rmnet_port *port)
 {
 	rmnet_perf_chain_hook_t rmnet_perf_opt_chain_end;
+	struct rmnet_frag_descriptor *held = NULL;
 	LIST_HEAD(desc_list);
 
 	/* Deaggregation and freeing of HW originating
@@ -1580,7 +1964,8 @@ void rmnet_frag_ingress_handler(struct sk_buff *skb,
 			list_for_each_entry_safe(frag_desc, tmp, &desc_list,
 						 list) {
 				list_del_init(&frag_desc->list);
-				__rmnet_frag_ingress_handler(frag_desc, port);
+				__rmnet_frag_ingress_handler(frag_desc, port,
+							     &held);
 			}
 		}
 
@@ -1590,6 +1975,11 @@ void rmnet_frag_ingress_handler(struct sk_buff *skb,
 		skb = skb_frag;
 	}
 
+	rmnet_frag_gro_flush(port, &held);
+
+	/* Send out anything XDP redirected, a no-op otherwise */
+	xdp_do_flush_map();
+
 	rcu_read_lock();
 	rmnet_perf_opt_chain_end = rcu_dereference(rmnet_perf_chain_end);
 	if (rmnet_perf_opt_chain_end)
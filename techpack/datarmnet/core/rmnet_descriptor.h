@@ -38,6 +38,7 @@ struct rmnet_frag_descriptor {
 	struct net_device *dev;
 	u32 len;
 	u32 hash;
+	u32 napi_id;
 	__be32 tcp_seq;
 	__be16 ip_id;
 	__be16 tcp_flags;
@@ -6,6 +6,7 @@
  */
 
 #include "rmnet_genl.h"
+#include "qmi_rmnet.h"
 #include <net/sock.h>
 #include <linux/skbuff.h>
 
@@ -21,6 +22,12 @@ static struct nla_policy rmnet_genl_attr_policy[RMNET_CORE_GENL_ATTR_MAX +
 				sizeof(struct rmnet_core_pid_boost_req) },
 	[RMNET_CORE_GENL_ATTR_STR]  = { .type = NLA_NUL_STRING, .len =
 				RMNET_CORE_GENL_MAX_STR_LEN },
+	[RMNET_CORE_GENL_ATTR_DFC_TRACE] = { .type = NLA_EXACT_LEN, .len =
+				sizeof(struct rmnet_core_dfc_trace_resp) },
+	[RMNET_CORE_GENL_ATTR_DFC_REPLAY] = { .type = NLA_EXACT_LEN, .len =
+				sizeof(struct rmnet_core_dfc_replay_req) },
+	[RMNET_CORE_GENL_ATTR_DFC_REPLAY_RESP] = { .type = NLA_EXACT_LEN,
+				.len = sizeof(struct rmnet_core_dfc_replay_resp) },
 };
 
 #define RMNET_CORE_GENL_OP(_cmd, _func)			\
@@ -36,6 +43,15 @@ static const struct genl_ops rmnet_core_genl_ops[] = {
 			   rmnet_core_genl_pid_bps_req_hdlr),
 	RMNET_CORE_GENL_OP(RMNET_CORE_GENL_CMD_PID_BOOST_REQ,
 			   rmnet_core_genl_pid_boost_req_hdlr),
+	RMNET_CORE_GENL_OP(RMNET_CORE_GENL_CMD_DFC_TRACE_REQ,
+			   rmnet_core_genl_dfc_trace_req_hdlr),
+	{
+		/* Replay drives the live flow control state */
+		.cmd	= RMNET_CORE_GENL_CMD_DFC_REPLAY_REQ,
+		.doit	= rmnet_core_genl_dfc_replay_req_hdlr,
+		.dumpit	= NULL,
+		.flags	= GENL_ADMIN_PERM,
+	},
 };
 
 struct genl_family rmnet_core_genl_family = {
@@ -381,6 +397,106 @@ int rmnet_core_genl_pid_boost_req_hdlr(struct sk_buff *skb_2,
 	return RMNET_GENL_SUCCESS;
 }
 
+static int rmnet_core_genl_send_attr(struct genl_info *info, u8 cmd,
+				     int attr, int len, void *data)
+{
+	struct sk_buff *skb;
+	void *msg_head;
+	int rc;
+
+	skb = genlmsg_new(len, GFP_KERNEL);
+	if (!skb)
+		return RMNET_GENL_FAILURE;
+
+	msg_head = genlmsg_put(skb, 0, info->snd_seq + 1,
+			       &rmnet_core_genl_family, 0, cmd);
+	if (!msg_head)
+		goto free_skb;
+
+	if (nla_put(skb, attr, len, data))
+		goto free_skb;
+
+	genlmsg_end(skb, msg_head);
+
+	rc = genlmsg_unicast(genl_info_net(info), skb, info->snd_portid);
+	if (rc != 0) {
+		rm_err("CORE_GNL: failed to send cmd %d: %d\n", cmd, rc);
+		return RMNET_GENL_FAILURE;
+	}
+
+	return RMNET_GENL_SUCCESS;
+
+free_skb:
+	nlmsg_free(skb);
+	return RMNET_GENL_FAILURE;
+}
+
+int rmnet_core_genl_dfc_trace_req_hdlr(struct sk_buff *skb_2,
+				       struct genl_info *info)
+{
+	struct rmnet_core_dfc_trace_resp *trace_resp;
+	int rc;
+
+	if (!info)
+		return RMNET_GENL_FAILURE;
+
+	/* Too big for the stack */
+	trace_resp = kzalloc(sizeof(*trace_resp), GFP_KERNEL);
+	if (!trace_resp)
+		return -ENOMEM;
+
+	qmi_rmnet_fc_trace_get(trace_resp);
+	trace_resp->valid = 1;
+
+	rc = rmnet_core_genl_send_attr(info, RMNET_CORE_GENL_CMD_DFC_TRACE_REQ,
+				       RMNET_CORE_GENL_ATTR_DFC_TRACE,
+				       sizeof(*trace_resp), trace_resp);
+	kfree(trace_resp);
+
+	return rc;
+}
+
+int rmnet_core_genl_dfc_replay_req_hdlr(struct sk_buff *skb_2,
+					struct genl_info *info)
+{
+	struct rmnet_core_dfc_replay_req *replay_req;
+	struct rmnet_core_dfc_replay_resp replay_resp;
+	struct nlattr *na;
+	int rc;
+
+	if (!info)
+		return RMNET_GENL_FAILURE;
+
+	na = info->attrs[RMNET_CORE_GENL_ATTR_DFC_REPLAY];
+	if (!na) {
+		rm_err("CORE_GNL: no info->attrs %d\n",
+		       RMNET_CORE_GENL_ATTR_DFC_REPLAY);
+		return RMNET_GENL_FAILURE;
+	}
+
+	replay_req = kzalloc(sizeof(*replay_req), GFP_KERNEL);
+	if (!replay_req)
+		return -ENOMEM;
+
+	nla_memcpy(replay_req, na, sizeof(*replay_req));
+	replay_req->ifname[IFNAMSIZ - 1] = '\0';
+
+	memset(&replay_resp, 0, sizeof(replay_resp));
+	if (replay_req->valid &&
+	    !qmi_rmnet_dfc_replay(genl_info_net(info), replay_req,
+				  &replay_resp.elapsed_ns,
+				  &replay_resp.grants_applied))
+		replay_resp.valid = 1;
+	kfree(replay_req);
+
+	rc = rmnet_core_genl_send_attr(info,
+				       RMNET_CORE_GENL_CMD_DFC_REPLAY_REQ,
+				       RMNET_CORE_GENL_ATTR_DFC_REPLAY_RESP,
+				       sizeof(replay_resp), &replay_resp);
+
+	return rc;
+}
+
 /* register new rmnet core driver generic netlink family */
 int rmnet_core_genl_init(void)
 {
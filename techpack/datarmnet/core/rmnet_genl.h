@@ -20,6 +20,7 @@
 #define RMNET_CORE_GENL_FAMILY_NAME "RMNET_CORE"
 
 #define RMNET_CORE_GENL_MAX_PIDS 32
+#define RMNET_CORE_GENL_MAX_FC_RECS 64
 
 #define RMNET_GENL_SUCCESS (0)
 #define RMNET_GENL_FAILURE (-1)
@@ -30,6 +31,8 @@ enum {
 	RMNET_CORE_GENL_CMD_UNSPEC,
 	RMNET_CORE_GENL_CMD_PID_BPS_REQ,
 	RMNET_CORE_GENL_CMD_PID_BOOST_REQ,
+	RMNET_CORE_GENL_CMD_DFC_TRACE_REQ,
+	RMNET_CORE_GENL_CMD_DFC_REPLAY_REQ,
 	__RMNET_CORE_GENL_CMD_MAX,
 };
 
@@ -39,6 +42,9 @@ enum {
 	RMNET_CORE_GENL_ATTR_INT,
 	RMNET_CORE_GENL_ATTR_PID_BPS,
 	RMNET_CORE_GENL_ATTR_PID_BOOST,
+	RMNET_CORE_GENL_ATTR_DFC_TRACE,
+	RMNET_CORE_GENL_ATTR_DFC_REPLAY,
+	RMNET_CORE_GENL_ATTR_DFC_REPLAY_RESP,
 	__RMNET_CORE_GENL_ATTR_MAX,
 };
 
@@ -78,6 +84,63 @@ struct rmnet_core_pid_boost_req {
 	u8 valid;
 };
 
+/* DFC flow control trace events */
+enum {
+	RMNET_CORE_DFC_TRACE_GRANT = 1,
+	RMNET_CORE_DFC_TRACE_STOP,
+	RMNET_CORE_DFC_TRACE_START,
+};
+
+struct rmnet_core_dfc_trace_rec {
+	/* Monotonic time of the event in ns */
+	u64 timestamp;
+	/* Grant after the event was applied */
+	u32 grant;
+	u32 bytes_in_flight;
+	/* Time the queue was stopped, START events only */
+	u32 stop_us;
+	u16 seq;
+	u8 mux_id;
+	u8 bearer_id;
+	u8 event;
+};
+
+struct rmnet_core_dfc_trace_resp {
+	struct rmnet_core_dfc_trace_rec list[RMNET_CORE_GENL_MAX_FC_RECS];
+	u64 timestamp;
+	/* Records overwritten since the last request */
+	u32 dropped;
+	u16 list_len;
+	u8 valid;
+};
+
+struct rmnet_core_dfc_grant {
+	u32 num_bytes;
+	u32 rx_bytes;
+	u16 seq;
+	u8 mux_id;
+	u8 bearer_id;
+	u8 rx_bytes_valid;
+	/* Apply as a query response rather than an indication */
+	u8 is_query;
+};
+
+struct rmnet_core_dfc_replay_req {
+	/* Any rmnet device on the port to replay against */
+	char ifname[IFNAMSIZ];
+	struct rmnet_core_dfc_grant list[RMNET_CORE_GENL_MAX_FC_RECS];
+	/* Number of back to back passes over the list */
+	u16 repeat;
+	u16 list_len;
+	u8 valid;
+};
+
+struct rmnet_core_dfc_replay_resp {
+	u64 elapsed_ns;
+	u32 grants_applied;
+	u8 valid;
+};
+
 /* Function Prototypes */
 int rmnet_core_genl_pid_bps_req_hdlr(struct sk_buff *skb_2,
 				     struct genl_info *info);
@@ -85,6 +148,12 @@ int rmnet_core_genl_pid_bps_req_hdlr(struct sk_buff *skb_2,
 int rmnet_core_genl_pid_boost_req_hdlr(struct sk_buff *skb_2,
 				       struct genl_info *info);
 
+int rmnet_core_genl_dfc_trace_req_hdlr(struct sk_buff *skb_2,
+				       struct genl_info *info);
+
+int rmnet_core_genl_dfc_replay_req_hdlr(struct sk_buff *skb_2,
+					struct genl_info *info);
+
 /* Called by vnd select queue */
 void rmnet_update_pid_and_check_boost(pid_t pid, unsigned int len,
 				      int *boost_enable, u64 *boost_period);
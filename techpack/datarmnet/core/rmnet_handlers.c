@@ -26,6 +26,7 @@
 #include "rmnet_map.h"
 #include "rmnet_handlers.h"
 #include "rmnet_descriptor.h"
+#include "rmnet_steer.h"
 
 #include "rmnet_qmi.h"
 #include "qmi_rmnet.h"
@@ -119,7 +120,8 @@ rmnet_deliver_skb(struct sk_buff *skb, struct rmnet_port *port)
 	}
 	rcu_read_unlock();
 
-	netif_receive_skb(skb);
+	if (!rmnet_steer_skb(skb))
+		netif_receive_skb(skb);
 }
 EXPORT_SYMBOL(rmnet_deliver_skb);
 
@@ -153,9 +155,10 @@ rmnet_deliver_skb_wq(struct sk_buff *skb, struct rmnet_port *port,
 	}
 	rcu_read_unlock();
 
-	if (ctx == RMNET_NET_RX_CTX)
-		netif_receive_skb(skb);
-	else
+	if (ctx == RMNET_NET_RX_CTX) {
+		if (!rmnet_steer_skb(skb))
+			netif_receive_skb(skb);
+	} else
 		gro_cells_receive(&priv->gro_cells, skb);
 }
 EXPORT_SYMBOL(rmnet_deliver_skb_wq);
@@ -318,6 +321,7 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 {
 	int required_headroom, additional_header_len, csum_type;
 	struct rmnet_map_header *map_header;
+	int low_lat;
 
 	additional_header_len = 0;
 	required_headroom = sizeof(struct rmnet_map_header);
@@ -357,7 +361,8 @@ static int rmnet_map_egress_handler(struct sk_buff *skb,
 		if (rmnet_map_tx_agg_skip(skb, required_headroom))
 			goto done;
 
-		rmnet_map_tx_aggregate(skb, port);
+		low_lat = rmnet_map_tx_agg_low_latency(skb, required_headroom);
+		rmnet_map_tx_aggregate(skb, port, low_lat);
 		return -EINPROGRESS;
 	}
 
@@ -17,6 +17,7 @@
 #include <linux/ip.h>
 #include <linux/ipv6.h>
 #include <net/ip6_checksum.h>
+#include <net/dsfield.h>
 #include "rmnet_config.h"
 #include "rmnet_map.h"
 #include "rmnet_private.h"
@@ -399,6 +400,10 @@ struct sk_buff *rmnet_map_deaggregate(struct sk_buff *skb,
 
 	pskb_pull(skb, packet_len);
 
+#ifdef CONFIG_NET_RX_BUSY_POLL
+	/* Let sockets busy poll the NAPI context of the HW */
+	skbn->napi_id = skb->napi_id;
+#endif
 	return skbn;
 }
 
@@ -598,6 +603,21 @@ bool rmnet_map_v5_csum_buggy(struct rmnet_map_v5_coal_header *coal_hdr)
 	return false;
 }
 
+/* Account why the HW checksum result of a coalesced frame is not used.
+ * Must only be called when rmnet_map_v5_csum_buggy() returned true.
+ */
+void rmnet_map_v5_csum_sw_stats(struct rmnet_priv *priv,
+				struct rmnet_map_v5_coal_header *coal_hdr,
+				bool zero_csum)
+{
+	if (zero_csum)
+		priv->stats.coal.coal_csum_sw_zero++;
+	else if (coal_hdr->close_type == RMNET_MAP_COAL_CLOSE_COAL)
+		priv->stats.coal.coal_csum_sw_close_coal++;
+	else
+		priv->stats.coal.coal_csum_sw_close_hw++;
+}
+
 static void rmnet_map_move_headers(struct sk_buff *skb)
 {
 	struct iphdr *iph;
@@ -978,14 +998,19 @@ static void rmnet_map_segment_coal_skb(struct sk_buff *coal_skb,
 		return;
 	}
 
-	if (rmnet_map_v5_csum_buggy(coal_hdr) && !zero_csum) {
-		rmnet_map_move_headers(coal_skb);
-		/* Mark as valid if it checks out */
-		if (rmnet_map_validate_csum(coal_skb, &coal_meta))
-			coal_skb->ip_summed = CHECKSUM_UNNECESSARY;
-
-		__skb_queue_tail(list, coal_skb);
-		return;
+	if (rmnet_map_v5_csum_buggy(coal_hdr)) {
+		rmnet_map_v5_csum_sw_stats(priv, coal_hdr, zero_csum);
+		if (!zero_csum) {
+			rmnet_map_move_headers(coal_skb);
+			/* Mark as valid if it checks out */
+			if (rmnet_map_validate_csum(coal_skb, &coal_meta))
+				coal_skb->ip_summed = CHECKSUM_UNNECESSARY;
+			else
+				priv->stats.coal.coal_csum_sw_err++;
+
+			__skb_queue_tail(list, coal_skb);
+			return;
+		}
 	}
 
 	/* Fast-forward the case where we have 1 NLO (i.e. 1 packet length),
@@ -1217,6 +1242,16 @@ int rmnet_map_process_next_hdr_packet(struct sk_buff *skb,
 
 long rmnet_agg_time_limit __read_mostly = 1000000L;
 long rmnet_agg_bypass_time __read_mostly = 10000000L;
+/* Shortest flush timer used while interactive traffic is present */
+long rmnet_agg_time_min __read_mostly = 100000L;
+/* Packets at or below this size count as interactive */
+long rmnet_agg_small_pkt __read_mostly = 128;
+
+#define RMNET_AGG_DSCP_EF 46
+/* How long interactive traffic keeps the port in low latency mode */
+#define RMNET_AGG_LL_HOLD (HZ / 10)
+/* A timer flush with this many packets or fewer means a shallow queue */
+#define RMNET_AGG_SHALLOW_COUNT 4
 
 int rmnet_map_tx_agg_skip(struct sk_buff *skb, int offset)
 {
@@ -1246,6 +1281,52 @@ int rmnet_map_tx_agg_skip(struct sk_buff *skb, int offset)
 	return is_icmp;
 }
 
+/* Small packets and anything marked Expedited Forwarding are treated as
+ * interactive and steer the UL aggregation timer towards low latency.
+ */
+int rmnet_map_tx_agg_low_latency(struct sk_buff *skb, int offset)
+{
+	u8 *packet_start = skb->data + offset;
+	u8 dscp = 0;
+
+	if (skb->len - offset <= rmnet_agg_small_pkt)
+		return 1;
+
+	if (skb->protocol == htons(ETH_P_IP))
+		dscp = ipv4_get_dsfield((struct iphdr *)packet_start) >> 2;
+	else if (skb->protocol == htons(ETH_P_IPV6))
+		dscp = ipv6_get_dsfield((struct ipv6hdr *)packet_start) >> 2;
+
+	return dscp == RMNET_AGG_DSCP_EF;
+}
+
+/* Called with agg_lock held just before the current aggregate is flushed.
+ * A timer flush of a nearly empty aggregate while interactive traffic is
+ * around halves the flush timer, while an aggregate that filled up doubles
+ * it again, up to the limit configured by the modem. With no interactive
+ * traffic the configured timer is used unchanged.
+ */
+static void rmnet_map_tx_agg_adapt(struct rmnet_port *port, bool timeout)
+{
+	u32 limit = port->egress_agg_params.agg_time;
+	u32 floor = min_t(u32, rmnet_agg_time_min, limit);
+	u32 cur = port->agg_time_cur;
+
+	if (!time_before(jiffies, port->agg_ll_last + RMNET_AGG_LL_HOLD))
+		cur = limit;
+	else if (!timeout)
+		cur = min_t(u64, (u64)cur << 1, limit);
+	else if (port->agg_count <= RMNET_AGG_SHALLOW_COUNT)
+		cur = max_t(u32, cur >> 1, floor);
+
+	if (cur < port->agg_time_cur)
+		port->stats.agg.ul_agg_time_shrink++;
+	else if (cur > port->agg_time_cur)
+		port->stats.agg.ul_agg_time_grow++;
+
+	port->agg_time_cur = cur;
+}
+
 static void rmnet_map_flush_tx_packet_work(struct work_struct *work)
 {
 	struct sk_buff *skb = NULL;
@@ -1258,6 +1339,7 @@ static void rmnet_map_flush_tx_packet_work(struct work_struct *work)
 	if (likely(port->agg_state == -EINPROGRESS)) {
 		/* Buffer may have already been shipped out */
 		if (likely(port->agg_skb)) {
+			rmnet_map_tx_agg_adapt(port, true);
 			skb = port->agg_skb;
 			port->agg_skb = NULL;
 			port->agg_count = 0;
@@ -1443,7 +1525,8 @@ static void rmnet_map_send_agg_skb(struct rmnet_port *port, unsigned long flags)
 	dev_queue_xmit(agg_skb);
 }
 
-void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port)
+void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port,
+			    int low_lat)
 {
 	struct timespec64 diff, last;
 	int size;
@@ -1454,6 +1537,13 @@ void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port)
 	memcpy(&last, &port->agg_last, sizeof(last));
 	ktime_get_real_ts64(&port->agg_last);
 
+	if (low_lat) {
+		port->agg_ll_last = jiffies;
+		port->stats.agg.ul_agg_ll_pkts++;
+		/* Only count the packet once if we loop below */
+		low_lat = 0;
+	}
+
 	if ((port->data_format & RMNET_EGRESS_FORMAT_PRIORITY) &&
 	    skb->priority) {
 		/* Send out any aggregated SKBs we have */
@@ -1504,6 +1594,7 @@ void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port)
 	if (skb->len > size ||
 	    port->agg_count >= port->egress_agg_params.agg_count ||
 	    diff.tv_sec > 0 || diff.tv_nsec > rmnet_agg_time_limit) {
+		rmnet_map_tx_agg_adapt(port, false);
 		rmnet_map_send_agg_skb(port, flags);
 		goto new_packet;
 	}
@@ -1516,7 +1607,7 @@ void rmnet_map_tx_aggregate(struct sk_buff *skb, struct rmnet_port *port)
 	if (port->agg_state != -EINPROGRESS) {
 		port->agg_state = -EINPROGRESS;
 		hrtimer_start(&port->hrtimer,
-			      ns_to_ktime(port->egress_agg_params.agg_time),
+			      ns_to_ktime(port->agg_time_cur),
 			      HRTIMER_MODE_REL);
 	}
 	spin_unlock_irqrestore(&port->agg_lock, flags);
@@ -1530,6 +1621,7 @@ void rmnet_map_update_ul_agg_config(struct rmnet_port *port, u16 size,
 	spin_lock_irqsave(&port->agg_lock, irq_flags);
 	port->egress_agg_params.agg_count = count;
 	port->egress_agg_params.agg_time = time;
+	port->agg_time_cur = time;
 	port->egress_agg_params.agg_size = size;
 	port->egress_agg_params.agg_features = features;
 
@@ -1560,6 +1652,7 @@ void rmnet_map_tx_aggregate_init(struct rmnet_port *port)
 	port->hrtimer.function = rmnet_map_flush_tx_packet_queue;
 	spin_lock_init(&port->agg_lock);
 	INIT_LIST_HEAD(&port->agg_list);
+	port->agg_ll_last = jiffies - RMNET_AGG_LL_HOLD;
 
 	/* Since PAGE_SIZE - 1 is specified here, no pages are pre-allocated.
 	 * This is done to reduce memory usage in cases where
@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * RMNET ingress flow steering
+ *
+ * Spreads ingress packets over a set of CPUs without relying on RPS or
+ * the shs module. Flows are hashed into buckets, and each bucket is
+ * bound to the least loaded steering CPU when it is first used. A bucket
+ * only moves once it has been idle long enough for its old backlog to
+ * have drained, so packets of a flow are never reordered. Each steering
+ * CPU has a backlog queue drained by its own NAPI instance, and a CPU is
+ * only sent an IPI when its queue goes from idle to busy, so a burst of
+ * packets costs one IPI per CPU instead of one per packet.
+ */
+
+#include <linux/module.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+#include <linux/smp.h>
+#include <linux/jiffies.h>
+#include <linux/sched/stat.h>
+#include "rmnet_steer.h"
+
+#define RMNET_STEER_BUCKETS	256
+/* A bucket may only move to another CPU after being idle this long */
+#define RMNET_STEER_IDLE_MS	50
+/* How often the CPU load samples are refreshed */
+#define RMNET_STEER_LOAD_MS	10
+/* Packets queued to a single CPU before new ones are dropped */
+#define RMNET_STEER_BACKLOG_MAX	1000
+
+static unsigned int rmnet_steer_cpus;
+module_param(rmnet_steer_cpus, uint, 0644);
+MODULE_PARM_DESC(rmnet_steer_cpus,
+		 "Mask of CPUs ingress flows are steered to, 0 disables");
+
+struct rmnet_steer_cpu {
+	struct sk_buff_head input;
+	struct napi_struct napi;
+	call_single_data_t csd;
+	atomic_t kicked;
+	unsigned int load;
+} ____cacheline_aligned_in_smp;
+
+struct rmnet_steer_bucket {
+	unsigned long last;
+	int cpu;
+};
+
+static DEFINE_PER_CPU(struct rmnet_steer_cpu, rmnet_steer_cpu);
+static struct rmnet_steer_bucket rmnet_steer_table[RMNET_STEER_BUCKETS];
+static unsigned long rmnet_steer_load_stamp;
+static struct net_device rmnet_steer_dev;
+static bool rmnet_steer_ready;
+
+static unsigned int rmnet_steer_cpu_util(int cpu)
+{
+#ifdef CONFIG_SCHED_WALT
+	return sched_get_cpu_util(cpu);
+#else
+	return 0;
+#endif
+}
+
+static bool rmnet_steer_cpu_ok(unsigned long mask, int cpu)
+{
+	return cpu >= 0 && cpu < BITS_PER_LONG && (mask & BIT(cpu)) &&
+	       cpu_online(cpu);
+}
+
+/* Choose the steering CPU with the lowest WALT busy % plus backlog */
+static int rmnet_steer_pick_cpu(unsigned long mask)
+{
+	struct rmnet_steer_cpu *sc;
+	unsigned int cost, best_cost = UINT_MAX;
+	bool sample;
+	int cpu, best = -1;
+
+	sample = time_after_eq(jiffies, rmnet_steer_load_stamp +
+			       msecs_to_jiffies(RMNET_STEER_LOAD_MS));
+	if (sample)
+		rmnet_steer_load_stamp = jiffies;
+
+	for_each_set_bit(cpu, &mask, min_t(int, nr_cpu_ids, BITS_PER_LONG)) {
+		if (!cpu_online(cpu))
+			continue;
+
+		sc = &per_cpu(rmnet_steer_cpu, cpu);
+		if (sample)
+			sc->load = rmnet_steer_cpu_util(cpu);
+
+		cost = sc->load + skb_queue_len(&sc->input) * 100 /
+				  RMNET_STEER_BACKLOG_MAX;
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = cpu;
+		}
+	}
+
+	return best;
+}
+
+/**
+ * rmnet_steer_skb() - Hand an ingress packet to its flow's CPU
+ * @skb: packet ready for netif_receive_skb()
+ *
+ * Return: true if the packet was consumed, false if the caller should
+ * deliver it on the current CPU.
+ */
+bool rmnet_steer_skb(struct sk_buff *skb)
+{
+	unsigned long mask = READ_ONCE(rmnet_steer_cpus);
+	struct rmnet_steer_bucket *bucket;
+	struct rmnet_steer_cpu *sc;
+	int cpu;
+
+	if (!mask || !READ_ONCE(rmnet_steer_ready))
+		return false;
+
+	bucket = &rmnet_steer_table[skb_get_hash(skb) % RMNET_STEER_BUCKETS];
+	cpu = READ_ONCE(bucket->cpu);
+	if (!rmnet_steer_cpu_ok(mask, cpu) ||
+	    time_after(jiffies, READ_ONCE(bucket->last) +
+		       msecs_to_jiffies(RMNET_STEER_IDLE_MS))) {
+		cpu = rmnet_steer_pick_cpu(mask);
+		if (cpu < 0)
+			return false;
+
+		WRITE_ONCE(bucket->cpu, cpu);
+	}
+	WRITE_ONCE(bucket->last, jiffies);
+
+	if (cpu == smp_processor_id())
+		return false;
+
+	sc = &per_cpu(rmnet_steer_cpu, cpu);
+	if (skb_queue_len(&sc->input) >= RMNET_STEER_BACKLOG_MAX) {
+		atomic_long_inc(&skb->dev->rx_dropped);
+		kfree_skb(skb);
+		return true;
+	}
+
+	skb_queue_tail(&sc->input, skb);
+	if (!atomic_xchg(&sc->kicked, 1))
+		smp_call_function_single_async(cpu, &sc->csd);
+
+	return true;
+}
+EXPORT_SYMBOL(rmnet_steer_skb);
+
+static void rmnet_steer_ipi(void *data)
+{
+	struct rmnet_steer_cpu *sc = data;
+
+	napi_schedule(&sc->napi);
+}
+
+static int rmnet_steer_poll(struct napi_struct *napi, int budget)
+{
+	struct rmnet_steer_cpu *sc = container_of(napi, struct rmnet_steer_cpu,
+						  napi);
+	struct sk_buff_head local;
+	struct sk_buff *skb;
+	int work = 0;
+
+	/* Anything queued after this point sends a new IPI */
+	atomic_set(&sc->kicked, 0);
+	smp_mb();
+
+	__skb_queue_head_init(&local);
+	spin_lock_irq(&sc->input.lock);
+	skb_queue_splice_tail_init(&sc->input, &local);
+	spin_unlock_irq(&sc->input.lock);
+
+	while (work < budget && (skb = __skb_dequeue(&local))) {
+		netif_receive_skb(skb);
+		work++;
+	}
+
+	if (!skb_queue_empty(&local)) {
+		spin_lock_irq(&sc->input.lock);
+		skb_queue_splice(&local, &sc->input);
+		spin_unlock_irq(&sc->input.lock);
+		return budget;
+	}
+
+	napi_complete_done(napi, work);
+	return work;
+}
+
+void rmnet_steer_init(void)
+{
+	struct rmnet_steer_cpu *sc;
+	int i;
+
+	for (i = 0; i < RMNET_STEER_BUCKETS; i++)
+		rmnet_steer_table[i].cpu = -1;
+
+	init_dummy_netdev(&rmnet_steer_dev);
+	for_each_possible_cpu(i) {
+		sc = &per_cpu(rmnet_steer_cpu, i);
+		skb_queue_head_init(&sc->input);
+		sc->csd.func = rmnet_steer_ipi;
+		sc->csd.info = sc;
+		netif_napi_add(&rmnet_steer_dev, &sc->napi, rmnet_steer_poll,
+			       NAPI_POLL_WEIGHT);
+		napi_enable(&sc->napi);
+	}
+
+	WRITE_ONCE(rmnet_steer_ready, true);
+}
+
+void rmnet_steer_exit(void)
+{
+	struct rmnet_steer_cpu *sc;
+	int i;
+
+	WRITE_ONCE(rmnet_steer_ready, false);
+	synchronize_net();
+	/* Wait for any IPI still in flight from before */
+	kick_all_cpus_sync();
+
+	for_each_possible_cpu(i) {
+		sc = &per_cpu(rmnet_steer_cpu, i);
+		napi_disable(&sc->napi);
+		netif_napi_del(&sc->napi);
+		skb_queue_purge(&sc->input);
+	}
+}
@@ -0,0 +1,17 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * RMNET ingress flow steering
+ *
+ */
+
+#ifndef _RMNET_STEER_H_
+#define _RMNET_STEER_H_
+
+#include <linux/skbuff.h>
+
+bool rmnet_steer_skb(struct sk_buff *skb);
+void rmnet_steer_init(void);
+void rmnet_steer_exit(void);
+
+#endif /* _RMNET_STEER_H_ */
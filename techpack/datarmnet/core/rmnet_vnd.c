@@ -14,6 +14,7 @@
  *
  */
 
+#include <linux/bpf.h>
 #include <linux/etherdevice.h>
 #include <linux/if_arp.h>
 #include <linux/ip.h>
@@ -112,12 +113,27 @@ static int rmnet_vnd_init(struct net_device *dev)
 		return -ENOMEM;
 
 	err = gro_cells_init(&priv->gro_cells, dev);
-	if (err) {
-		free_percpu(priv->pcpu_stats);
-		return err;
-	}
+	if (err)
+		goto free_stats;
+
+	err = xdp_rxq_info_reg(&priv->xdp_rxq, dev, 0);
+	if (err)
+		goto destroy_gro;
+
+	err = xdp_rxq_info_reg_mem_model(&priv->xdp_rxq, MEM_TYPE_PAGE_SHARED,
+					 NULL);
+	if (err)
+		goto unreg_rxq;
 
 	return 0;
+
+unreg_rxq:
+	xdp_rxq_info_unreg(&priv->xdp_rxq);
+destroy_gro:
+	gro_cells_destroy(&priv->gro_cells);
+free_stats:
+	free_percpu(priv->pcpu_stats);
+	return err;
 }
 
 static void rmnet_vnd_uninit(struct net_device *dev)
@@ -125,6 +141,7 @@ static void rmnet_vnd_uninit(struct net_device *dev)
 	struct rmnet_priv *priv = netdev_priv(dev);
 	void *qos;
 
+	xdp_rxq_info_unreg(&priv->xdp_rxq);
 	gro_cells_destroy(&priv->gro_cells);
 	free_percpu(priv->pcpu_stats);
 
@@ -208,6 +225,40 @@ static u16 rmnet_vnd_select_queue(struct net_device *dev,
 	return (txq < dev->real_num_tx_queues) ? txq : 0;
 }
 
+/* The program runs on the frag descriptors of the downlink path, see
+ * rmnet_frag_xdp(). The old program is released after a grace period by
+ * bpf_prog_put(), so the datapath can keep using it until then.
+ */
+static int rmnet_vnd_xdp_setup(struct net_device *dev, struct bpf_prog *prog)
+{
+	struct rmnet_priv *priv = netdev_priv(dev);
+	struct bpf_prog *old;
+
+	old = rtnl_dereference(priv->xdp_prog);
+	rcu_assign_pointer(priv->xdp_prog, prog);
+	if (old)
+		bpf_prog_put(old);
+
+	return 0;
+}
+
+static int rmnet_vnd_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+	struct rmnet_priv *priv = netdev_priv(dev);
+	struct bpf_prog *prog;
+
+	switch (bpf->command) {
+	case XDP_SETUP_PROG:
+		return rmnet_vnd_xdp_setup(dev, bpf->prog);
+	case XDP_QUERY_PROG:
+		prog = rtnl_dereference(priv->xdp_prog);
+		bpf->prog_id = prog ? prog->aux->id : 0;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops rmnet_vnd_ops = {
 	.ndo_start_xmit = rmnet_vnd_start_xmit,
 	.ndo_change_mtu = rmnet_vnd_change_mtu,
@@ -218,6 +269,7 @@ static const struct net_device_ops rmnet_vnd_ops = {
 	.ndo_uninit     = rmnet_vnd_uninit,
 	.ndo_get_stats64 = rmnet_get_stats64,
 	.ndo_select_queue = rmnet_vnd_select_queue,
+	.ndo_bpf = rmnet_vnd_bpf,
 };
 
 static const char rmnet_gstrings_stats[][ETH_GSTRING_LEN] = {
@@ -256,7 +308,18 @@ static const char rmnet_gstrings_stats[][ETH_GSTRING_LEN] = {
 	"Coalescing TCP bytes",
 	"Coalescing UDP frames",
 	"Coalescing UDP bytes",
+	"Coalescing sw checksum on FIN/PSH close",
+	"Coalescing sw checksum on HW limit close",
+	"Coalescing sw checksum errors",
+	"Coalescing sw checksum skipped on zero UDP checksum",
+	"Coalescing descriptors merged",
 	"Uplink priority packets",
+	"XDP pass",
+	"XDP drop",
+	"XDP tx",
+	"XDP redirect",
+	"XDP aborted",
+	"XDP skipped on nonlinear packet",
 };
 
 static const char rmnet_port_gstrings_stats[][ETH_GSTRING_LEN] = {
@@ -274,6 +337,9 @@ static const char rmnet_port_gstrings_stats[][ETH_GSTRING_LEN] = {
 	"DL trailer pkts received",
 	"UL agg reuse",
 	"UL agg alloc",
+	"UL agg low latency pkts",
+	"UL agg timer shrink",
+	"UL agg timer grow",
 };
 
 static void rmnet_get_strings(struct net_device *dev, u32 stringset, u8 *buf)
@@ -5,6 +5,8 @@
 #include <linux/proc_fs.h>
 #include <linux/string.h>
 #include <linux/syscalls.h>
+#include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 #include <drm/drm_anakin.h>
 
 #include "dsi_anakin.h"
@@ -147,7 +149,7 @@ static int dsi_anakin_tx_cmd_set(struct dsi_panel *panel,
 	int rc = 0, i = 0;
 	ssize_t len;
 	struct dsi_cmd_desc *cmds;
-	u32 count;
+	u32 count, batch_len = 0;
 	enum dsi_cmd_set_state state;
 	struct dsi_display_mode *mode;
 	const struct mipi_dsi_host_ops *ops = panel->host->ops;
@@ -171,8 +173,11 @@ static int dsi_anakin_tx_cmd_set(struct dsi_panel *panel,
 		if (state == DSI_CMD_SET_STATE_LP)
 			cmds->msg.flags |= MIPI_DSI_MSG_USE_LPM;
 
-		if (cmds->last_command)
+		if (dsi_panel_cmd_ends_batch(panel, cmds, count - i,
+					     &batch_len))
 			cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+		else
+			cmds->msg.flags &= ~MIPI_DSI_MSG_LASTCOMMAND;
 
 		if (type == DSI_CMD_SET_VID_TO_CMD_SWITCH)
 			cmds->msg.flags |= MIPI_DSI_MSG_ASYNC_OVERRIDE;
@@ -745,6 +750,56 @@ void dsi_anakin_frame_commit_cnt(struct drm_crtc *crtc)
 	}
 }
 
+// wake hint: power up MDSS ahead of the unblank commit
+static DEFINE_MUTEX(wake_hint_lock);
+static bool wake_hint_held;
+static unsigned int wake_hint_ms;
+
+static void dsi_anakin_wake_put_work(struct work_struct *work)
+{
+	mutex_lock(&wake_hint_lock);
+	if (wake_hint_held) {
+		pm_runtime_put_sync(g_display->drm_dev->dev);
+		wake_hint_held = false;
+	}
+	mutex_unlock(&wake_hint_lock);
+}
+static DECLARE_DELAYED_WORK(wake_hint_put_work, dsi_anakin_wake_put_work);
+
+static void dsi_anakin_wake_get_work(struct work_struct *work)
+{
+	struct device *dev = g_display->drm_dev->dev;
+
+	mutex_lock(&wake_hint_lock);
+	if (!wake_hint_held) {
+		if (pm_runtime_get_sync(dev) < 0) {
+			pm_runtime_put_noidle(dev);
+			goto unlock;
+		}
+		wake_hint_held = true;
+	}
+	mod_delayed_work(system_wq, &wake_hint_put_work,
+			msecs_to_jiffies(READ_ONCE(wake_hint_ms)));
+unlock:
+	mutex_unlock(&wake_hint_lock);
+}
+static DECLARE_WORK(wake_hint_get_work, dsi_anakin_wake_get_work);
+
+static int dsi_anakin_wake_notify(struct notifier_block *nb,
+		unsigned long action, void *data)
+{
+	if (!g_display || !g_display->drm_dev || g_display->panel->panel_is_on)
+		return NOTIFY_DONE;
+
+	WRITE_ONCE(wake_hint_ms, *(unsigned int *)data);
+	queue_work(system_highpri_wq, &wake_hint_get_work);
+	return NOTIFY_OK;
+}
+
+static struct notifier_block dsi_anakin_wake_nb = {
+	.notifier_call = dsi_anakin_wake_notify,
+};
+
 // to initial asus display parameters
 void dsi_anakin_display_init(struct dsi_display *display)
 {
@@ -767,6 +822,8 @@ void dsi_anakin_display_init(struct dsi_display *display)
 	proc_create(GLOBAL_HBM_MODE, 0666, NULL, &global_hbm_mode_ops);
 	proc_create(DIMMING_SPEED, 0666, NULL, &dimming_speed_ops);
 	proc_create(LCD_BACKLIGNTNESS, 0666, NULL, &lcd_brightness_ops);
+
+	anakin_drm_register_wake_notifier(&dsi_anakin_wake_nb);
 }
 
 // to parse panel_vendor_id from panel dtsi
@@ -11,6 +11,7 @@
 #include <video/mipi_display.h>
 
 #include "dsi_panel.h"
+#include "dsi_ctrl.h"
 #include "dsi_ctrl_hw.h"
 #include "dsi_parser.h"
 #include "sde_dbg.h"
@@ -520,13 +521,78 @@ static int dsi_panel_power_off(struct dsi_panel *panel)
 #endif
 	return rc;
 }
+#define DSI_PANEL_CMD_BATCH_MAX_BYTES	SZ_1K
+
+static bool dsi_panel_cmd_is_read(const struct dsi_cmd_desc *cmd)
+{
+	switch (cmd->msg.type) {
+	case MIPI_DSI_DCS_READ:
+	case MIPI_DSI_GENERIC_READ_REQUEST_0_PARAM:
+	case MIPI_DSI_GENERIC_READ_REQUEST_1_PARAM:
+	case MIPI_DSI_GENERIC_READ_REQUEST_2_PARAM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static u32 dsi_panel_cmd_dma_len(const struct dsi_cmd_desc *cmd)
+{
+	/* packet header plus payload padded to a dword, see dsi_ctrl */
+	return ALIGN(cmd->msg.tx_len + 4, 4);
+}
+
+/**
+ * dsi_panel_cmd_ends_batch() - whether a command of a set is the last of
+ *				a DMA transfer
+ * @panel:	Display panel.
+ * @cmd:	Command about to be sent.
+ * @remaining:	Number of commands left in the set, including @cmd.
+ * @batch_len:	Bytes queued in the current transfer, updated here.
+ *
+ * dsi_ctrl packs messages into its command buffer and triggers the DMA
+ * only for one flagged MIPI_DSI_MSG_LASTCOMMAND. Panel DT usually marks
+ * every command as last, which costs one trigger and one completion wait
+ * per command. On command mode panels, chain commands that don't need a
+ * delay after them so a whole set goes out in one transfer. Reads,
+ * commands asking for an ack and commands too long for embedded mode
+ * still end a transfer.
+ */
+bool dsi_panel_cmd_ends_batch(struct dsi_panel *panel,
+		struct dsi_cmd_desc *cmd, u32 remaining, u32 *batch_len)
+{
+	struct dsi_cmd_desc *next = cmd + 1;
+	u32 len = dsi_panel_cmd_dma_len(cmd);
+
+	/* already chained in DT */
+	if (!cmd->last_command) {
+		*batch_len += len;
+		return false;
+	}
+
+	if (panel->panel_mode != DSI_OP_CMD_MODE || remaining <= 1 ||
+	    cmd->post_wait_ms || (cmd->msg.flags & MIPI_DSI_MSG_REQ_ACK) ||
+	    dsi_panel_cmd_is_read(cmd) ||
+	    dsi_panel_cmd_is_read(next) ||
+	    len > DSI_EMBEDDED_MODE_DMA_MAX_SIZE_BYTES ||
+	    dsi_panel_cmd_dma_len(next) > DSI_EMBEDDED_MODE_DMA_MAX_SIZE_BYTES ||
+	    *batch_len + len + dsi_panel_cmd_dma_len(next) >
+				DSI_PANEL_CMD_BATCH_MAX_BYTES) {
+		*batch_len = 0;
+		return true;
+	}
+
+	*batch_len += len;
+	return false;
+}
+
 static int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 				enum dsi_cmd_set_type type)
 {
 	int rc = 0, i = 0;
 	ssize_t len;
 	struct dsi_cmd_desc *cmds;
-	u32 count;
+	u32 count, batch_len = 0;
 	enum dsi_cmd_set_state state;
 	struct dsi_display_mode *mode;
 	const struct mipi_dsi_host_ops *ops = panel->host->ops;
@@ -560,8 +626,11 @@ static int dsi_panel_tx_cmd_set(struct dsi_panel *panel,
 		if (state == DSI_CMD_SET_STATE_LP)
 			cmds->msg.flags |= MIPI_DSI_MSG_USE_LPM;
 
-		if (cmds->last_command)
+		if (dsi_panel_cmd_ends_batch(panel, cmds, count - i,
+					     &batch_len))
 			cmds->msg.flags |= MIPI_DSI_MSG_LASTCOMMAND;
+		else
+			cmds->msg.flags &= ~MIPI_DSI_MSG_LASTCOMMAND;
 
 		if (type == DSI_CMD_SET_VID_TO_CMD_SWITCH)
 			cmds->msg.flags |= MIPI_DSI_MSG_ASYNC_OVERRIDE;
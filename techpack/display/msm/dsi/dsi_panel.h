@@ -394,6 +394,9 @@ int dsi_panel_mode_switch_to_vid(struct dsi_panel *panel);
 
 int dsi_panel_switch(struct dsi_panel *panel);
 
+bool dsi_panel_cmd_ends_batch(struct dsi_panel *panel,
+		struct dsi_cmd_desc *cmd, u32 remaining, u32 *batch_len);
+
 int dsi_panel_post_switch(struct dsi_panel *panel);
 
 void dsi_dsc_pclk_param_calc(struct msm_display_dsc_info *dsc, int intf_width);
@@ -697,6 +697,7 @@ void sde_connector_set_qsync_params(struct drm_connector *connector)
 	struct sde_connector *c_conn;
 	struct sde_connector_state *c_state;
 	u32 qsync_propval = 0;
+	u32 content_fps;
 	bool prop_dirty;
 
 	if (!connector)
@@ -705,6 +706,7 @@ void sde_connector_set_qsync_params(struct drm_connector *connector)
 	c_conn = to_sde_connector(connector);
 	c_state = to_sde_connector_state(connector->state);
 	c_conn->qsync_updated = false;
+	c_conn->content_fps_updated = false;
 
 	prop_dirty = msm_property_is_dirty(&c_conn->property_info,
 					&c_state->property_state,
@@ -719,6 +721,35 @@ void sde_connector_set_qsync_params(struct drm_connector *connector)
 			c_conn->qsync_mode = qsync_propval;
 		}
 	}
+
+	prop_dirty = msm_property_is_dirty(&c_conn->property_info,
+					&c_state->property_state,
+					CONNECTOR_PROP_CONTENT_FPS);
+	if (prop_dirty) {
+		content_fps = sde_connector_get_property(c_conn->base.state,
+						CONNECTOR_PROP_CONTENT_FPS);
+		if (content_fps != c_conn->content_fps) {
+			SDE_DEBUG("updated content fps %d -> %d\n",
+					c_conn->content_fps, content_fps);
+			c_conn->content_fps = content_fps;
+
+			/*
+			 * The content rate only moves the qsync min fps; it
+			 * is reprogrammed in the encoder without resending
+			 * the panel qsync commands.
+			 */
+			if (!c_conn->qsync_updated && c_conn->qsync_mode ==
+					SDE_RM_QSYNC_CONTINUOUS_MODE) {
+				c_conn->qsync_updated = true;
+				c_conn->content_fps_updated = true;
+			}
+		}
+	}
+
+	if (c_conn->qsync_updated)
+		SDE_EVT32(connector->base.id, c_conn->qsync_mode,
+				c_conn->content_fps,
+				c_conn->content_fps_updated);
 }
 
 void sde_connector_complete_qsync_commit(struct drm_connector *conn,
@@ -905,7 +936,7 @@ int sde_connector_prepare_commit(struct drm_connector *connector)
 
 	memset(&params, 0, sizeof(params));
 
-	if (c_conn->qsync_updated) {
+	if (c_conn->qsync_updated && !c_conn->content_fps_updated) {
 		params.qsync_mode = c_conn->qsync_mode;
 		params.qsync_update = true;
 	}
@@ -1541,6 +1572,7 @@ static int sde_connector_atomic_set_property(struct drm_connector *connector,
 			SDE_ERROR_CONN(c_conn, "cannot set hdr info %d\n", rc);
 		break;
 	case CONNECTOR_PROP_QSYNC_MODE:
+	case CONNECTOR_PROP_CONTENT_FPS:
 		msm_property_set_dirty(&c_conn->property_info,
 				&c_state->property_state, idx);
 		break;
@@ -2788,12 +2820,18 @@ static int _sde_connector_install_properties(struct drm_device *dev,
 			CONNECTOR_PROP_AUTOREFRESH);
 
 	if (connector_type == DRM_MODE_CONNECTOR_DSI) {
-		if (sde_kms->catalog->has_qsync && display_info->qsync_min_fps)
+		if (sde_kms->catalog->has_qsync &&
+				display_info->qsync_min_fps) {
 			msm_property_install_enum(&c_conn->property_info,
 					"qsync_mode", 0, 0, e_qsync_mode,
 					ARRAY_SIZE(e_qsync_mode), 0,
 					CONNECTOR_PROP_QSYNC_MODE);
 
+			msm_property_install_range(&c_conn->property_info,
+					"content_fps", 0x0, 0, U8_MAX, 0,
+					CONNECTOR_PROP_CONTENT_FPS);
+		}
+
 		if (display_info->capabilities & MSM_DISPLAY_CAP_CMD_MODE)
 			msm_property_install_enum(&c_conn->property_info,
 				"frame_trigger_mode", 0, 0,
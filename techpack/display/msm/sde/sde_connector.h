@@ -485,6 +485,8 @@ struct sde_connector_dyn_hdr_metadata {
  * @allow_bl_update: Flag to indicate if BL update is allowed currently or not
  * @qsync_mode: Cached Qsync mode, 0=disabled, 1=continuous mode
  * @qsync_updated: Qsync settings were updated
+ * @content_fps: Cached content frame rate hint, 0 if no hint is given
+ * @content_fps_updated: Only the content frame rate changed this frame
  * @colorspace_updated: Colorspace property was updated
  * @last_cmd_tx_sts: status of the last command transfer
  * @hdr_capable: external hdr support present
@@ -555,6 +557,8 @@ struct sde_connector {
 	u8 hdr_plus_app_ver;
 	u32 qsync_mode;
 	bool qsync_updated;
+	u32 content_fps;
+	bool content_fps_updated;
 
 	bool colorspace_updated;
 
@@ -606,6 +610,23 @@ struct sde_connector {
 #define sde_connector_get_qsync_mode(C) \
 	((C) ? to_sde_connector((C))->qsync_mode : 0)
 
+/**
+ * sde_connector_get_content_fps - get sde connector's content fps hint
+ * @C: Pointer to drm connector structure
+ * Returns: Cached content frame rate, 0 if not hinted
+ */
+#define sde_connector_get_content_fps(C) \
+	((C) ? to_sde_connector((C))->content_fps : 0)
+
+/**
+ * sde_connector_is_content_fps_updated - indicates if only the content fps
+ *	hint changed in the connector's qsync settings
+ * @C: Pointer to drm connector structure
+ * Returns: True if the qsync min fps needs reprogramming; false otherwise
+ */
+#define sde_connector_is_content_fps_updated(C) \
+	((C) ? to_sde_connector((C))->content_fps_updated : 0)
+
 /**
  * sde_connector_get_propinfo - get sde connector's property info pointer
  * @C: Pointer to drm connector structure
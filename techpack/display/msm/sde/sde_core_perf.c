@@ -912,16 +912,184 @@ static void _sde_core_perf_crtc_update_check(struct drm_crtc *crtc,
 	}
 }
 
+static void _sde_core_perf_history_add(struct sde_crtc *sde_crtc)
+{
+	struct sde_core_perf_history *hist = &sde_crtc->perf_history;
+
+	memcpy(&hist->frame[hist->idx], &sde_crtc->new_perf,
+			sizeof(struct sde_core_perf_params));
+	hist->idx = (hist->idx + 1) % SDE_PERF_HISTORY_LEN;
+}
+
+/*
+ * Hold the votes at the peak of the last frames, so a single light frame
+ * between heavy ones doesn't cause a drop and a ramp back up.
+ */
+static void _sde_core_perf_history_max(struct sde_crtc *sde_crtc,
+		struct sde_core_perf_params *perf)
+{
+	struct sde_core_perf_history *hist = &sde_crtc->perf_history;
+	struct sde_core_perf_params *frame;
+	int i, j;
+
+	for (i = 0; i < SDE_PERF_HISTORY_LEN; i++) {
+		frame = &hist->frame[i];
+
+		for (j = 0; j < SDE_POWER_HANDLE_DBUS_ID_MAX; j++) {
+			perf->bw_ctl[j] = max(perf->bw_ctl[j],
+					frame->bw_ctl[j]);
+			perf->max_per_pipe_ib[j] = max(perf->max_per_pipe_ib[j],
+					frame->max_per_pipe_ib[j]);
+		}
+		perf->core_clk_rate = max(perf->core_clk_rate,
+				frame->core_clk_rate);
+	}
+}
+
+/*
+ * Send the bus votes selected by @update_bus and, if @update_clk, the core
+ * clock rate.  Function assumes that caller has already acquired the
+ * "sde_core_perf_lock".
+ */
+static int _sde_core_perf_crtc_vote(struct sde_kms *kms,
+		struct drm_crtc *crtc, int update_bus, int update_clk,
+		int params_changed)
+{
+	struct msm_drm_private *priv = kms->dev->dev_private;
+	struct sde_crtc_state *sde_cstate = to_sde_crtc_state(crtc->state);
+	u64 clk_rate;
+	int ret, i;
+
+	for (i = 0; i < SDE_POWER_HANDLE_DBUS_ID_MAX; i++) {
+		if (update_bus & BIT(i))
+			_sde_core_perf_crtc_update_bus(kms, crtc, i);
+	}
+
+	if (kms->perf.bw_vote_mode == DISP_RSC_MODE &&
+	    ((get_sde_rsc_current_state(SDE_RSC_INDEX) != SDE_RSC_CLK_STATE
+	      && params_changed) ||
+	    (get_sde_rsc_current_state(SDE_RSC_INDEX) == SDE_RSC_CLK_STATE)))
+		sde_rsc_client_trigger_vote(sde_cstate->rsc_client,
+				update_bus ? true : false);
+
+	/*
+	 * Update the clock after bandwidth vote to ensure
+	 * bandwidth is available before clock rate is increased.
+	 */
+	if (update_clk) {
+		clk_rate = _sde_core_perf_get_core_clk_rate(kms);
+
+		SDE_EVT32(kms->dev, clk_rate, params_changed);
+		ret = sde_power_clk_set_rate(&priv->phandle,
+				kms->perf.clk_name, clk_rate);
+		if (ret) {
+			SDE_ERROR("failed to set %s clock rate %llu\n",
+					kms->perf.clk_name, clk_rate);
+			return ret;
+		}
+
+		kms->perf.core_clk_rate = clk_rate;
+		SDE_DEBUG("update clk rate = %lld HZ\n", clk_rate);
+	}
+
+	return 0;
+}
+
+void sde_core_perf_crtc_prevote(struct drm_crtc *crtc)
+{
+	struct sde_crtc *sde_crtc;
+	struct msm_drm_private *priv;
+	struct sde_kms *kms;
+
+	if (!crtc || !crtc->state) {
+		SDE_ERROR("invalid crtc\n");
+		return;
+	}
+
+	kms = _sde_crtc_get_kms(crtc);
+	if (!kms || !kms->catalog) {
+		SDE_ERROR("invalid kms\n");
+		return;
+	}
+	priv = kms->dev->dev_private;
+	sde_crtc = to_sde_crtc(crtc);
+
+	/* the enable path votes before the hardware is powered up anyway */
+	if (!kms->perf.predictive ||
+			kms->perf.perf_tune.mode != SDE_PERF_MODE_NORMAL ||
+			!_sde_core_perf_crtc_is_power_on(crtc) ||
+			drm_atomic_crtc_needs_modeset(crtc->state) ||
+			crtc->index >= ARRAY_SIZE(priv->event_thread))
+		return;
+
+	mutex_lock(&sde_core_perf_lock);
+	memcpy(&sde_crtc->prevote_perf,
+			&to_sde_crtc_state(crtc->state)->new_perf,
+			sizeof(struct sde_core_perf_params));
+	mutex_unlock(&sde_core_perf_lock);
+
+	kthread_queue_work(&priv->event_thread[crtc->index].worker,
+			&sde_crtc->perf_prevote_work);
+}
+
+void sde_core_perf_crtc_prevote_work(struct kthread_work *work)
+{
+	struct sde_crtc *sde_crtc = container_of(work, struct sde_crtc,
+			perf_prevote_work);
+	struct drm_crtc *crtc = &sde_crtc->base;
+	struct sde_core_perf_params *old = &sde_crtc->cur_perf;
+	struct sde_core_perf_params *pre = &sde_crtc->prevote_perf;
+	int update_bus = 0, update_clk = 0;
+	struct sde_kms *kms;
+	int i;
+
+	kms = _sde_crtc_get_kms(crtc);
+	if (!kms || !kms->catalog)
+		return;
+
+	SDE_ATRACE_BEGIN("sde_core_perf_prevote");
+	mutex_lock(&sde_core_perf_lock);
+
+	if (!_sde_core_perf_crtc_is_power_on(crtc))
+		goto exit;
+
+	/* lowering is left to the post kickoff update and its history */
+	for (i = 0; i < SDE_POWER_HANDLE_DBUS_ID_MAX; i++) {
+		if (pre->bw_ctl[i] > old->bw_ctl[i]) {
+			old->bw_ctl[i] = pre->bw_ctl[i];
+			update_bus |= BIT(i);
+		}
+
+		if (pre->max_per_pipe_ib[i] > old->max_per_pipe_ib[i]) {
+			old->max_per_pipe_ib[i] = pre->max_per_pipe_ib[i];
+			update_bus |= BIT(i);
+		}
+	}
+
+	if (pre->core_clk_rate > old->core_clk_rate) {
+		old->core_clk_rate = pre->core_clk_rate;
+		update_clk = 1;
+	}
+
+	SDE_EVT32(DRMID(crtc), update_bus, update_clk, pre->core_clk_rate,
+		GET_H32(pre->bw_ctl[SDE_POWER_HANDLE_DBUS_ID_MNOC]),
+		GET_L32(pre->bw_ctl[SDE_POWER_HANDLE_DBUS_ID_MNOC]));
+
+	if (update_bus || update_clk)
+		_sde_core_perf_crtc_vote(kms, crtc, update_bus, update_clk, 1);
+
+exit:
+	mutex_unlock(&sde_core_perf_lock);
+	SDE_ATRACE_END("sde_core_perf_prevote");
+}
+
 void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		int params_changed, bool stop_req)
 {
 	struct sde_core_perf_params *new, *old;
 	int update_bus = 0, update_clk = 0;
-	u64 clk_rate = 0;
 	struct sde_crtc *sde_crtc;
 	struct sde_crtc_state *sde_cstate;
-	int ret, i;
-	struct msm_drm_private *priv;
 	struct sde_kms *kms;
 
 	if (!crtc) {
@@ -934,7 +1102,6 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		SDE_ERROR("invalid kms\n");
 		return;
 	}
-	priv = kms->dev->dev_private;
 	sde_crtc = to_sde_crtc(crtc);
 	sde_cstate = to_sde_crtc_state(crtc->state);
 
@@ -948,9 +1115,14 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 	 * crtc kickoff, so the same numbers are used during the
 	 * perf update that happens post kickoff.
 	 */
-	if (params_changed)
+	if (params_changed) {
 		memcpy(&sde_crtc->new_perf, &sde_cstate->new_perf,
 			sizeof(struct sde_core_perf_params));
+		_sde_core_perf_history_add(sde_crtc);
+	} else if (kms->perf.predictive &&
+			kms->perf.perf_tune.mode == SDE_PERF_MODE_NORMAL) {
+		_sde_core_perf_history_max(sde_crtc, &sde_crtc->new_perf);
+	}
 
 	old = &sde_crtc->cur_perf;
 	new = &sde_crtc->new_perf;
@@ -962,6 +1134,8 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		SDE_DEBUG("crtc=%d disable\n", crtc->base.id);
 		memset(old, 0, sizeof(*old));
 		memset(new, 0, sizeof(*new));
+		memset(&sde_crtc->perf_history, 0,
+				sizeof(sde_crtc->perf_history));
 		update_bus = ~0;
 		update_clk = 1;
 	}
@@ -975,39 +1149,12 @@ void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		new->core_clk_rate, stop_req,
 		update_bus, update_clk, params_changed);
 
-	for (i = 0; i < SDE_POWER_HANDLE_DBUS_ID_MAX; i++) {
-		if (update_bus & BIT(i))
-			_sde_core_perf_crtc_update_bus(kms, crtc, i);
-	}
-
-	if (kms->perf.bw_vote_mode == DISP_RSC_MODE &&
-	    ((get_sde_rsc_current_state(SDE_RSC_INDEX) != SDE_RSC_CLK_STATE
-	      && params_changed) ||
-	    (get_sde_rsc_current_state(SDE_RSC_INDEX) == SDE_RSC_CLK_STATE)))
-		sde_rsc_client_trigger_vote(sde_cstate->rsc_client,
-				update_bus ? true : false);
-
-	/*
-	 * Update the clock after bandwidth vote to ensure
-	 * bandwidth is available before clock rate is increased.
-	 */
-	if (update_clk) {
-		clk_rate = _sde_core_perf_get_core_clk_rate(kms);
-
-		SDE_EVT32(kms->dev, stop_req, clk_rate, params_changed,
+	if (update_clk)
+		SDE_EVT32(kms->dev, stop_req, params_changed,
 			old->core_clk_rate, new->core_clk_rate);
-		ret = sde_power_clk_set_rate(&priv->phandle,
-				kms->perf.clk_name, clk_rate);
-		if (ret) {
-			SDE_ERROR("failed to set %s clock rate %llu\n",
-					kms->perf.clk_name, clk_rate);
-			mutex_unlock(&sde_core_perf_lock);
-			return;
-		}
 
-		kms->perf.core_clk_rate = clk_rate;
-		SDE_DEBUG("update clk rate = %lld HZ\n", clk_rate);
-	}
+	_sde_core_perf_crtc_vote(kms, crtc, update_bus, update_clk,
+			params_changed);
 	mutex_unlock(&sde_core_perf_lock);
 
 }
@@ -1226,6 +1373,8 @@ int sde_core_perf_debugfs_init(struct sde_core_perf *perf,
 			&perf->fix_core_ab_vote);
 	debugfs_create_bool("idle_sys_cache_enable", 0600, perf->debugfs_root,
 			&perf->idle_sys_cache_enabled);
+	debugfs_create_bool("predictive_vote", 0600, perf->debugfs_root,
+			&perf->predictive);
 
 	debugfs_create_u32("uidle_perf_cnt", 0600, perf->debugfs_root,
 			&sde_kms->catalog->uidle_cfg.debugfs_perf);
@@ -1296,6 +1445,7 @@ int sde_core_perf_init(struct sde_core_perf *perf,
 		perf->max_core_clk_rate = SDE_PERF_DEFAULT_MAX_CORE_CLK_RATE;
 	}
 	perf->idle_sys_cache_enabled = true;
+	perf->predictive = true;
 
 	return 0;
 
@@ -9,6 +9,7 @@
 #include <linux/types.h>
 #include <linux/dcache.h>
 #include <linux/mutex.h>
+#include <linux/kthread.h>
 #include <drm/drm_crtc.h>
 
 #include "sde_hw_catalog.h"
@@ -16,6 +17,9 @@
 
 #define SDE_PERF_DEFAULT_MAX_CORE_CLK_RATE	320000000
 
+/* frames a predictive vote is held for before it is lowered */
+#define SDE_PERF_HISTORY_LEN			4
+
 /**
  *  uidle performance counters mode
  * @SDE_PERF_UIDLE_DISABLE: Disable logging (default)
@@ -42,6 +46,16 @@ struct sde_core_perf_params {
 	bool llcc_active[SDE_SYS_CACHE_MAX];
 };
 
+/**
+ * struct sde_core_perf_history - requirements of the last frames of a crtc
+ * @frame: ring of the committed per frame requirements
+ * @idx: next entry of @frame to fill
+ */
+struct sde_core_perf_history {
+	struct sde_core_perf_params frame[SDE_PERF_HISTORY_LEN];
+	u32 idx;
+};
+
 /**
  * struct sde_core_perf_tune - definition of performance tuning control
  * @mode: performance mode
@@ -78,6 +92,8 @@ struct sde_core_perf_tune {
  * @uidle_enabled: indicates if uidle is already enabled
  * @idle_sys_cache_enabled: override system cache enable state
  *                          for idle usecase
+ * @predictive: raise votes ahead of the commit and lower them only once
+ *              the last SDE_PERF_HISTORY_LEN frames needed less
  */
 struct sde_core_perf {
 	struct drm_device *dev;
@@ -99,6 +115,7 @@ struct sde_core_perf {
 	bool llcc_active[SDE_SYS_CACHE_MAX];
 	bool uidle_enabled;
 	bool idle_sys_cache_enabled;
+	bool predictive;
 };
 
 /**
@@ -125,6 +142,21 @@ int sde_core_perf_crtc_check(struct drm_crtc *crtc,
 void sde_core_perf_crtc_update(struct drm_crtc *crtc,
 		int params_changed, bool stop_req);
 
+/**
+ * sde_core_perf_crtc_prevote - raise the votes of a crtc for its next frame
+ * @crtc: Pointer to crtc, with the checked state of the next frame swapped in
+ *
+ * Only votes up, from the crtc event thread, so the bus and clock requests
+ * travel while the commit still waits for its fences.
+ */
+void sde_core_perf_crtc_prevote(struct drm_crtc *crtc);
+
+/**
+ * sde_core_perf_crtc_prevote_work - worker applying a queued prevote
+ * @work: Pointer to the perf_prevote_work of a sde crtc
+ */
+void sde_core_perf_crtc_prevote_work(struct kthread_work *work);
+
 /**
  * sde_core_perf_crtc_release_bw - release bandwidth of the given crtc
  * @crtc: Pointer to crtc
@@ -21,11 +21,14 @@
 #include <linux/sort.h>
 #include <linux/debugfs.h>
 #include <linux/ktime.h>
+#include <linux/thermal_frame.h>
 #include <drm/sde_drm.h>
 #include <drm/drm_mode.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_probe_helper.h>
+#include <drm/drm_damage_helper.h>
 #include <drm/drm_flip_work.h>
+#include <drm/drm_anakin.h>
 
 #include "sde_kms.h"
 #include "sde_hw_lm.h"
@@ -40,8 +43,12 @@
 #include "sde_vbif.h"
 #include "sde_power_handle.h"
 #include "sde_core_perf.h"
+#include "sde_reg_dma.h"
 #include "sde_trace.h"
 #include "sde_vm.h"
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+#include <soc/qcom/boot_stats.h>
+#endif
 
 /* ASUS BSP Display +++ */
 #include "../dsi/dsi_anakin.h"
@@ -448,6 +455,7 @@ static void sde_crtc_destroy(struct drm_crtc *crtc)
 
 	sde_fence_deinit(sde_crtc->output_fence);
 	_sde_crtc_deinit_events(sde_crtc);
+	sde_reg_dma_batch_free(sde_crtc->reg_dma_batch);
 
 	drm_crtc_cleanup(crtc);
 	mutex_destroy(&sde_crtc->crtc_lock);
@@ -644,6 +652,41 @@ bool sde_crtc_is_crtc_roi_dirty(struct drm_crtc_state *state)
 			&cstate->property_state, CRTC_PROP_ROI_V1);
 }
 
+bool sde_crtc_is_roi_changed(struct drm_crtc_state *state)
+{
+	if (!state)
+		return false;
+
+	return to_sde_crtc_state(state)->roi_changed;
+}
+
+bool sde_crtc_crop_to_damage_roi(struct drm_crtc_state *state,
+		struct sde_rect *src, struct sde_rect *dst)
+{
+	struct sde_crtc_state *cstate;
+	struct sde_rect crop;
+
+	if (!state || !src || !dst)
+		return true;
+
+	cstate = to_sde_crtc_state(state);
+	if (!cstate->damage_roi || sde_kms_rect_is_null(&cstate->crtc_roi))
+		return true;
+
+	sde_kms_rect_intersect(&cstate->crtc_roi, dst, &crop);
+	if (sde_kms_rect_is_null(&crop))
+		return false;
+
+	/* planes with a damage roi are unscaled, move src along with dst */
+	src->x += crop.x - dst->x;
+	src->y += crop.y - dst->y;
+	src->w = crop.w;
+	src->h = crop.h;
+	*dst = crop;
+
+	return true;
+}
+
 static int _sde_crtc_set_roi_v1(struct drm_crtc_state *state,
 		void __user *usr_ptr)
 {
@@ -1033,7 +1076,8 @@ static int _sde_crtc_check_planes_within_crtc_roi(struct drm_crtc *crtc,
 	crtc_state = to_sde_crtc_state(state);
 	crtc_roi = &crtc_state->crtc_roi;
 
-	if (sde_kms_rect_is_null(crtc_roi))
+	/* planes are cropped to a damage derived roi instead */
+	if (sde_kms_rect_is_null(crtc_roi) || crtc_state->damage_roi)
 		return 0;
 
 	drm_atomic_crtc_state_for_each_plane_state(plane, pstate, state) {
@@ -1067,6 +1111,298 @@ static int _sde_crtc_check_planes_within_crtc_roi(struct drm_crtc *crtc,
 	return 0;
 }
 
+/*
+ * Whether the fetch of a plane can be limited to a partial update roi by
+ * moving its source rectangle along: it has to be unscaled, unrotated and
+ * RGB, and own its sspp rect.
+ */
+static bool _sde_crtc_plane_is_croppable(const struct drm_plane_state *state)
+{
+	struct sde_plane_state *pstate = to_sde_plane_state(state);
+	const struct msm_format *msm_fmt;
+
+	if (!state->fb)
+		return false;
+
+	msm_fmt = msm_framebuffer_format(state->fb);
+	if (!msm_fmt || SDE_FORMAT_IS_YUV(to_sde_format(msm_fmt)))
+		return false;
+
+	return !(pstate->rotation & ~DRM_MODE_ROTATE_0) &&
+		!pstate->scaler3_cfg.enable &&
+		pstate->multirect_mode == SDE_SSPP_MULTIRECT_NONE &&
+		sde_kms_rect_is_null(&pstate->excl_rect) &&
+		state->crtc_x >= 0 && state->crtc_y >= 0 &&
+		!(state->src_x & 0xffff) && !(state->src_y & 0xffff) &&
+		(state->src_w >> 16) == state->crtc_w &&
+		(state->src_h >> 16) == state->crtc_h;
+}
+
+static void _sde_crtc_rect_union(struct sde_rect *res,
+		const struct sde_rect *r)
+{
+	u32 x2, y2;
+
+	if (sde_kms_rect_is_null(r))
+		return;
+
+	if (sde_kms_rect_is_null(res)) {
+		*res = *r;
+		return;
+	}
+
+	x2 = max((u32)res->x + res->w, (u32)r->x + r->w);
+	y2 = max((u32)res->y + res->h, (u32)r->y + r->h);
+	res->x = min(res->x, r->x);
+	res->y = min(res->y, r->y);
+	res->w = x2 - res->x;
+	res->h = y2 - res->y;
+}
+
+/*
+ * Add the part of the crtc a plane changes in this commit to @damage.  The
+ * damage clips only describe framebuffer content: a plane that moved, or
+ * had any other property changed, is damaged as a whole.
+ */
+static void _sde_crtc_add_plane_damage(const struct drm_plane_state *old,
+		const struct drm_plane_state *new, struct sde_rect *damage)
+{
+	struct sde_plane_state *pstate = to_sde_plane_state(new);
+	const struct drm_mode_rect *clips;
+	struct sde_rect dst, rect;
+	u32 src_x = new->src_x >> 16, src_y = new->src_y >> 16;
+	u32 i, count;
+
+	dst.x = new->crtc_x;
+	dst.y = new->crtc_y;
+	dst.w = new->crtc_w;
+	dst.h = new->crtc_h;
+
+	count = drm_plane_get_damage_clips_count(new);
+	if (!count || !old->fb || !list_empty(&pstate->property_state.dirty_list) ||
+			old->crtc_x != new->crtc_x || old->crtc_y != new->crtc_y ||
+			old->crtc_w != new->crtc_w || old->crtc_h != new->crtc_h ||
+			old->src_x != new->src_x || old->src_y != new->src_y ||
+			old->src_w != new->src_w || old->src_h != new->src_h ||
+			old->fb->format != new->fb->format ||
+			old->fb->modifier != new->fb->modifier) {
+		if (old->crtc == new->crtc && old->crtc_x >= 0 &&
+				old->crtc_y >= 0) {
+			rect.x = old->crtc_x;
+			rect.y = old->crtc_y;
+			rect.w = old->crtc_w;
+			rect.h = old->crtc_h;
+			_sde_crtc_rect_union(damage, &rect);
+		}
+		_sde_crtc_rect_union(damage, &dst);
+		return;
+	}
+
+	clips = drm_plane_get_damage_clips(new);
+	for (i = 0; i < count; i++) {
+		s32 x1 = clamp_t(s32, clips[i].x1, src_x, src_x + dst.w);
+		s32 x2 = clamp_t(s32, clips[i].x2, src_x, src_x + dst.w);
+		s32 y1 = clamp_t(s32, clips[i].y1, src_y, src_y + dst.h);
+		s32 y2 = clamp_t(s32, clips[i].y2, src_y, src_y + dst.h);
+
+		if (x2 <= x1 || y2 <= y1)
+			continue;
+
+		rect.x = dst.x + x1 - src_x;
+		rect.y = dst.y + y1 - src_y;
+		rect.w = x2 - x1;
+		rect.h = y2 - y1;
+		_sde_crtc_rect_union(damage, &rect);
+	}
+}
+
+/*
+ * Collect the damage of a frame on a command mode panel from the
+ * FB_DAMAGE_CLIPS of its planes.  Returns false if the whole frame has to
+ * be updated instead.
+ */
+static bool _sde_crtc_get_damage(struct drm_crtc *crtc,
+		struct drm_crtc_state *state, struct sde_rect *damage)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_state *cstate = to_sde_crtc_state(state);
+	struct drm_plane_state *old_pstate, *new_pstate;
+	const struct drm_plane_state *pstate;
+	struct drm_plane *plane;
+	int i;
+
+	if (drm_atomic_crtc_needs_modeset(state) || state->color_mgmt_changed ||
+			state->plane_mask != crtc->state->plane_mask ||
+			cstate->num_ds_enabled || cstate->num_dim_layers ||
+			!list_empty(&sde_crtc->dirty_list))
+		return false;
+
+	drm_atomic_crtc_state_for_each_plane_state(plane, pstate, state) {
+		if (IS_ERR_OR_NULL(pstate) ||
+				!_sde_crtc_plane_is_croppable(pstate))
+			return false;
+	}
+
+	memset(damage, 0, sizeof(*damage));
+	for_each_oldnew_plane_in_state(state->state, plane, old_pstate,
+			new_pstate, i) {
+		if (new_pstate->crtc != crtc)
+			continue;
+
+		_sde_crtc_add_plane_damage(old_pstate, new_pstate, damage);
+	}
+
+	return !sde_kms_rect_is_null(damage);
+}
+
+/*
+ * Grow a damage rectangle to what the panel accepts as a partial update
+ * roi.  Returns false if that ends up as the full frame anyway.
+ */
+static bool _sde_crtc_align_damage_roi(struct sde_crtc *sde_crtc,
+		struct sde_crtc_state *cstate,
+		const struct msm_roi_alignment *align, struct sde_rect *roi,
+		u32 hdisplay, u32 vdisplay)
+{
+	u32 x1 = roi->x, y1 = roi->y;
+	u32 x2 = roi->x + roi->w, y2 = roi->y + roi->h;
+
+	if (align->xstart_pix_align)
+		x1 = rounddown(x1, align->xstart_pix_align);
+	if (align->ystart_pix_align)
+		y1 = rounddown(y1, align->ystart_pix_align);
+	if (align->width_pix_align)
+		x2 = x1 + roundup(x2 - x1, align->width_pix_align);
+	if (align->height_pix_align)
+		y2 = y1 + roundup(y2 - y1, align->height_pix_align);
+	x2 = max(x2, x1 + align->min_width);
+	y2 = max(y2, y1 + align->min_height);
+
+	/* split displays need the roi centered on the split */
+	if (cstate->is_ppsplit ||
+			sde_crtc->num_mixers >= CRTC_DUAL_MIXERS_ONLY) {
+		x1 = min(x1, x2 < hdisplay ? hdisplay - x2 : 0);
+		x2 = hdisplay - x1;
+		if ((align->xstart_pix_align &&
+				x1 % align->xstart_pix_align) ||
+				(align->width_pix_align &&
+				(x2 - x1) % align->width_pix_align))
+			return false;
+	}
+
+	if (x2 > hdisplay || y2 > vdisplay ||
+			(!x1 && !y1 && x2 == hdisplay && y2 == vdisplay))
+		return false;
+
+	roi->x = x1;
+	roi->y = y1;
+	roi->w = x2 - x1;
+	roi->h = y2 - y1;
+
+	return true;
+}
+
+/*
+ * Derive the crtc and connector rois from plane damage when user space
+ * doesn't set any, so a command mode panel is only sent, and the sspps only
+ * fetch, what changed.
+ */
+static int _sde_crtc_set_damage_roi(struct drm_crtc *crtc,
+		struct drm_crtc_state *state)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_state *cstate = to_sde_crtc_state(state);
+	struct msm_mode_info mode_info;
+	struct msm_roi_list rois;
+	struct sde_rect roi;
+	bool partial;
+	int i;
+
+	/* user space manages the rois itself */
+	if (sde_crtc_is_crtc_roi_dirty(state) ||
+			(!cstate->damage_roi && cstate->user_roi_list.num_rects)) {
+		cstate->damage_roi = false;
+		return 0;
+	}
+
+	partial = cstate->num_connectors &&
+			_sde_crtc_get_damage(crtc, state, &roi);
+
+	for (i = 0; partial && i < cstate->num_connectors; i++) {
+		struct drm_connector *conn = cstate->connectors[i];
+
+		if (!conn || !conn->state ||
+				sde_connector_state_get_mode_info(conn->state,
+					&mode_info) ||
+				!mode_info.roi_caps.enabled ||
+				!mode_info.roi_caps.num_roi) {
+			partial = false;
+			break;
+		}
+
+		partial = _sde_crtc_align_damage_roi(sde_crtc, cstate,
+				&mode_info.roi_caps.align, &roi,
+				state->adjusted_mode.hdisplay,
+				state->adjusted_mode.vdisplay);
+	}
+
+	/* no roi derived for the previous frame, and none for this one */
+	if (!partial && !cstate->damage_roi)
+		return 0;
+
+	memset(&rois, 0, sizeof(rois));
+	if (partial) {
+		rois.num_rects = 1;
+		rois.roi[0].x1 = roi.x;
+		rois.roi[0].y1 = roi.y;
+		rois.roi[0].x2 = roi.x + roi.w;
+		rois.roi[0].y2 = roi.y + roi.h;
+	}
+
+	for (i = 0; i < cstate->num_connectors; i++) {
+		struct drm_connector_state *conn_state;
+
+		conn_state = drm_atomic_get_connector_state(state->state,
+				cstate->connectors[i]);
+		if (IS_ERR(conn_state))
+			return PTR_ERR(conn_state);
+
+		to_sde_connector_state(conn_state)->rois = rois;
+	}
+
+	cstate->user_roi_list = rois;
+	cstate->damage_roi = partial;
+
+	SDE_DEBUG("%s: damage roi (%d,%d,%d,%d)\n", sde_crtc->name,
+			partial ? roi.x : 0, partial ? roi.y : 0,
+			partial ? roi.w : 0, partial ? roi.h : 0);
+	SDE_EVT32_VERBOSE(DRMID(crtc), partial, partial ? roi.x : 0,
+			partial ? roi.y : 0, partial ? roi.w : 0,
+			partial ? roi.h : 0);
+
+	return 0;
+}
+
+static void _sde_crtc_clear_damage_roi(struct drm_crtc *crtc,
+		struct drm_crtc_state *state)
+{
+	struct sde_crtc_state *cstate = to_sde_crtc_state(state);
+	struct drm_connector_state *conn_state;
+	struct drm_connector *conn;
+	int i;
+
+	for_each_new_connector_in_state(state->state, conn, conn_state, i) {
+		if (conn_state->crtc != crtc)
+			continue;
+
+		memset(&to_sde_connector_state(conn_state)->rois, 0,
+				sizeof(struct msm_roi_list));
+	}
+
+	memset(&cstate->user_roi_list, 0, sizeof(cstate->user_roi_list));
+	cstate->damage_roi = false;
+}
+
 static int _sde_crtc_check_rois(struct drm_crtc *crtc,
 		struct drm_crtc_state *state)
 {
@@ -1424,8 +1760,9 @@ static void _sde_crtc_blend_setup_mixer(struct drm_crtc *crtc,
 	struct sde_hw_ctl *ctl;
 	struct sde_hw_mixer *lm;
 	struct sde_hw_stage_cfg *stage_cfg;
-	struct sde_rect plane_crtc_roi;
+	struct sde_rect plane_crtc_roi, plane_src;
 	uint32_t stage_idx, lm_idx, layout_idx;
+	u64 fetch_bytes = 0;
 	int zpos_cnt[MAX_LAYOUTS_PER_CRTC][SDE_STAGE_MAX + 1];
 	int i, mode, cnt = 0;
 	bool bg_alpha_enable = false;
@@ -1458,6 +1795,16 @@ static void _sde_crtc_blend_setup_mixer(struct drm_crtc *crtc,
 		plane_crtc_roi.w = state->crtc_w;
 		plane_crtc_roi.h = state->crtc_h;
 
+		plane_src.x = state->src_x >> 16;
+		plane_src.y = state->src_y >> 16;
+		plane_src.w = state->src_w >> 16;
+		plane_src.h = state->src_h >> 16;
+
+		/* planes outside a damage derived roi are not fetched */
+		if (!sde_crtc_crop_to_damage_roi(crtc->state, &plane_src,
+				&plane_crtc_roi))
+			continue;
+
 		pstate = to_sde_plane_state(state);
 		fb = state->fb;
 
@@ -1480,6 +1827,8 @@ static void _sde_crtc_blend_setup_mixer(struct drm_crtc *crtc,
 			goto end;
 		}
 
+		fetch_bytes += (u64)plane_src.w * plane_src.h * format->bpp;
+
 		blend_type = sde_plane_get_property(pstate,
 					PLANE_PROP_BLEND_OP);
 
@@ -1548,6 +1897,12 @@ static void _sde_crtc_blend_setup_mixer(struct drm_crtc *crtc,
 		cnt++;
 	}
 
+	sde_crtc->fetch_bytes_last = fetch_bytes;
+	sde_crtc->fetch_bytes_total += fetch_bytes;
+	sde_crtc->frame_cnt++;
+	if (cstate->damage_roi)
+		sde_crtc->partial_frame_cnt++;
+
 	/* blend config update */
 	_sde_crtc_setup_blend_cfg_by_stage(mixer, sde_crtc->num_mixers,
 			pstates, cnt);
@@ -2212,6 +2567,142 @@ static void _sde_crtc_dest_scaler_setup(struct drm_crtc *crtc)
 	}
 }
 
+static inline struct sde_crtc_frame_timing *_sde_crtc_timing_entry(
+		struct sde_crtc *sde_crtc, u32 seq)
+{
+	return &sde_crtc->timing[seq & (SDE_CRTC_TIMING_RING_SIZE - 1)];
+}
+
+/**
+ * _sde_crtc_timing_start - open the timing entry of a newly prepared frame
+ * @sde_crtc: Pointer to sde crtc structure
+ * @cstate: Pointer to the sde crtc state being committed
+ */
+static void _sde_crtc_timing_start(struct sde_crtc *sde_crtc,
+		struct sde_crtc_state *cstate)
+{
+	struct sde_crtc_frame_timing *timing;
+	unsigned long flags;
+
+	spin_lock_irqsave(&sde_crtc->timing_lock, flags);
+	/* sequence 0 marks an unused entry */
+	if (!++sde_crtc->timing_seq)
+		sde_crtc->timing_seq++;
+	cstate->timing_seq = sde_crtc->timing_seq;
+
+	timing = _sde_crtc_timing_entry(sde_crtc, cstate->timing_seq);
+	memset(timing, 0, sizeof(*timing));
+	timing->seq = cstate->timing_seq;
+	timing->ts[SDE_CRTC_TIMING_CHECK] = cstate->check_ts;
+	timing->ts[SDE_CRTC_TIMING_PREPARE] = ktime_get();
+	spin_unlock_irqrestore(&sde_crtc->timing_lock, flags);
+}
+
+/**
+ * _sde_crtc_timing_mark - stamp a commit thread point of a frame
+ * @sde_crtc: Pointer to sde crtc structure
+ * @seq: frame sequence number from the committed crtc state
+ * @point: enum sde_crtc_timing_point to record
+ */
+static void _sde_crtc_timing_mark(struct sde_crtc *sde_crtc, u32 seq,
+		enum sde_crtc_timing_point point)
+{
+	struct sde_crtc_frame_timing *timing;
+	unsigned long flags;
+
+	if (!seq)
+		return;
+
+	spin_lock_irqsave(&sde_crtc->timing_lock, flags);
+	timing = _sde_crtc_timing_entry(sde_crtc, seq);
+	if (timing->seq == seq) {
+		timing->ts[point] = ktime_get();
+		if (point == SDE_CRTC_TIMING_KICKOFF)
+			sde_crtc->timing_kicked = seq;
+	}
+	spin_unlock_irqrestore(&sde_crtc->timing_lock, flags);
+}
+
+/**
+ * _sde_crtc_timing_complete - stamp a completion point of the oldest frame
+ * @sde_crtc: Pointer to sde crtc structure
+ * @completed: last completed sequence number for @point, updated
+ * @point: SDE_CRTC_TIMING_PP_DONE or SDE_CRTC_TIMING_RETIRE
+ * @ts: ktime of the completion event
+ *
+ * Frames complete in kickoff order, so each event is attributed to the
+ * oldest kicked off frame not yet completed. Events lost over a recovery
+ * or a power collapse are skipped once more frames are outstanding than
+ * the hardware can queue.
+ *
+ * Return: the completed timing entry or NULL, called with timing_lock held
+ */
+static struct sde_crtc_frame_timing *_sde_crtc_timing_complete(
+		struct sde_crtc *sde_crtc, u32 *completed,
+		enum sde_crtc_timing_point point, ktime_t ts)
+{
+	struct sde_crtc_frame_timing *timing;
+	u32 seq;
+
+	if ((s32)(sde_crtc->timing_kicked - *completed) <= 0)
+		return NULL;
+
+	if ((s32)(sde_crtc->timing_kicked - *completed) >
+			SDE_CRTC_TIMING_MAX_PENDING)
+		*completed = sde_crtc->timing_kicked -
+				SDE_CRTC_TIMING_MAX_PENDING;
+
+	seq = ++(*completed);
+	timing = _sde_crtc_timing_entry(sde_crtc, seq);
+	if (timing->seq != seq)
+		return NULL;
+
+	timing->ts[point] = ts;
+
+	return timing;
+}
+
+static void _sde_crtc_timing_frame_event(struct drm_crtc *crtc, u32 event)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_crtc_frame_timing *timing;
+	ktime_t *ts, now = ktime_get();
+	unsigned long flags;
+
+	spin_lock_irqsave(&sde_crtc->timing_lock, flags);
+	if (event & SDE_ENCODER_FRAME_EVENT_DONE)
+		_sde_crtc_timing_complete(sde_crtc,
+				&sde_crtc->timing_done_seq,
+				SDE_CRTC_TIMING_PP_DONE, now);
+
+	if (!(event & SDE_ENCODER_FRAME_EVENT_SIGNAL_RETIRE_FENCE)) {
+		spin_unlock_irqrestore(&sde_crtc->timing_lock, flags);
+		return;
+	}
+
+	thermal_frame_retired(now);
+
+	timing = _sde_crtc_timing_complete(sde_crtc,
+			&sde_crtc->timing_retire_seq,
+			SDE_CRTC_TIMING_RETIRE, now);
+	if (timing && timing->ts[SDE_CRTC_TIMING_CHECK]) {
+		ts = timing->ts;
+		trace_sde_crtc_frame_timing(DRMID(crtc), timing->seq,
+			ktime_us_delta(ts[SDE_CRTC_TIMING_PREPARE],
+					ts[SDE_CRTC_TIMING_CHECK]),
+			ktime_us_delta(ts[SDE_CRTC_TIMING_KICKOFF],
+					ts[SDE_CRTC_TIMING_CHECK]),
+			ktime_us_delta(ts[SDE_CRTC_TIMING_ENC_KICKOFF],
+					ts[SDE_CRTC_TIMING_CHECK]),
+			ts[SDE_CRTC_TIMING_PP_DONE] ?
+			ktime_us_delta(ts[SDE_CRTC_TIMING_PP_DONE],
+					ts[SDE_CRTC_TIMING_CHECK]) : -1,
+			ktime_us_delta(ts[SDE_CRTC_TIMING_RETIRE],
+					ts[SDE_CRTC_TIMING_CHECK]));
+	}
+	spin_unlock_irqrestore(&sde_crtc->timing_lock, flags);
+}
+
 static void sde_crtc_frame_event_cb(void *data, u32 event)
 {
 	struct drm_crtc *crtc = (struct drm_crtc *)data;
@@ -2280,6 +2771,8 @@ static void sde_crtc_frame_event_cb(void *data, u32 event)
 		sysfs_notify_dirent(sde_crtc->retire_frame_event_sf);
 	}
 
+	_sde_crtc_timing_frame_event(crtc, event);
+
 	fevent->event = event;
 	fevent->crtc = crtc;
 	fevent->connector = cb_data->connector;
@@ -2331,6 +2824,11 @@ void sde_crtc_prepare_commit(struct drm_crtc *crtc,
 
 	/* prepare main output fence */
 	sde_fence_prepare(sde_crtc->output_fence);
+
+	_sde_crtc_timing_start(sde_crtc, cstate);
+
+	/* start ramping clocks and bandwidth while fences are pending */
+	sde_core_perf_crtc_prevote(crtc);
 	SDE_ATRACE_END("sde_crtc_prepare_commit");
 }
 
@@ -2445,6 +2943,7 @@ static void sde_crtc_vblank_cb(void *data)
 
 	sde_crtc->vblank_last_cb_time = ktime_get();
 	sysfs_notify_dirent(sde_crtc->vsync_event_sf);
+	anakin_drm_notify_vsync(sde_crtc->vblank_last_cb_time);
 
 	drm_crtc_handle_vblank(crtc);
 	DRM_DEBUG_VBL("crtc%d\n", crtc->base.id);
@@ -2504,6 +3003,18 @@ static void sde_crtc_frame_event_work(struct kthread_work *work)
 	in_clone_mode = (fevent->event & SDE_ENCODER_FRAME_EVENT_CWB_DONE) ?
 			true : false;
 
+#ifdef CONFIG_QGKI_MSM_BOOT_TIME_MARKER
+	if (fevent->event & SDE_ENCODER_FRAME_EVENT_DONE) {
+		static bool first_frame_done;
+
+		if (!first_frame_done) {
+			first_frame_done = true;
+			boot_event_record(BOOT_EVENT_DISPLAY, "first frame",
+					  boot_event_start());
+		}
+	}
+#endif
+
 	if (!in_clone_mode && (fevent->event & (SDE_ENCODER_FRAME_EVENT_ERROR
 					| SDE_ENCODER_FRAME_EVENT_PANEL_DEAD
 					| SDE_ENCODER_FRAME_EVENT_DONE))) {
@@ -3260,6 +3771,57 @@ static void _sde_crtc_clear_all_blend_stages(struct sde_crtc *sde_crtc)
 	}
 }
 
+/*
+ * Collect the sspp and layer mixer writes of the commit, so they go out as
+ * one reg dma submission on the crtc's ctl instead of one mmio write each.
+ */
+static void _sde_crtc_reg_dma_batch_begin(struct drm_crtc *crtc,
+		struct sde_kms *sde_kms)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct drm_plane *plane;
+	int i;
+
+	if (!sde_crtc->reg_dma_batch || !sde_crtc->reg_dma_batch_en ||
+			!sde_crtc->mixers[0].hw_ctl)
+		return;
+
+	/* the batch is triggered by the reg dma flush of a single ctl */
+	for (i = 1; i < sde_crtc->num_mixers; i++)
+		if (sde_crtc->mixers[i].hw_ctl != sde_crtc->mixers[0].hw_ctl)
+			return;
+
+	sde_reg_dma_batch_begin(sde_crtc->reg_dma_batch, sde_kms->mmio);
+
+	for (i = 0; i < sde_crtc->num_mixers; i++)
+		if (sde_crtc->mixers[i].hw_lm)
+			sde_crtc->mixers[i].hw_lm->hw.batch =
+					sde_crtc->reg_dma_batch;
+
+	drm_atomic_crtc_for_each_plane(plane, crtc)
+		sde_plane_set_reg_dma_batch(plane, sde_crtc->reg_dma_batch);
+}
+
+static void _sde_crtc_reg_dma_batch_end(struct drm_crtc *crtc)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct drm_plane *plane;
+	int i;
+
+	if (!sde_crtc->reg_dma_batch || !sde_crtc->reg_dma_batch->active)
+		return;
+
+	for (i = 0; i < sde_crtc->num_mixers; i++)
+		if (sde_crtc->mixers[i].hw_lm)
+			sde_crtc->mixers[i].hw_lm->hw.batch = NULL;
+
+	drm_atomic_crtc_for_each_plane(plane, crtc)
+		sde_plane_set_reg_dma_batch(plane, NULL);
+
+	sde_reg_dma_batch_submit(sde_crtc->reg_dma_batch,
+			sde_crtc->mixers[0].hw_ctl);
+}
+
 static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 		struct drm_crtc_state *old_state)
 {
@@ -3324,6 +3886,7 @@ static void sde_crtc_atomic_begin(struct drm_crtc *crtc,
 	if (unlikely(!sde_crtc->num_mixers))
 		goto end;
 
+	_sde_crtc_reg_dma_batch_begin(crtc, sde_kms);
 	_sde_crtc_blend_setup(crtc, old_state, true);
 	_sde_crtc_dest_scaler_setup(crtc);
 
@@ -3403,6 +3966,9 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 	dev = crtc->dev;
 	priv = dev->dev_private;
 
+	/* new content, the unchanged frame count starts over */
+	kthread_cancel_delayed_work_sync(&sde_crtc->static_cache_auto_work);
+
 	if ((sde_crtc->cache_state == CACHE_STATE_PRE_CACHE) &&
 			sde_crtc_get_property(cstate, CRTC_PROP_CACHE_STATE))
 		sde_crtc_static_img_control(crtc, CACHE_STATE_FRAME_WRITE,
@@ -3466,6 +4032,9 @@ static void sde_crtc_atomic_flush(struct drm_crtc *crtc,
 		sde_plane_flush(plane);
 	}
 
+	/* queue the batched writes ahead of the reg dma flush at kickoff */
+	_sde_crtc_reg_dma_batch_end(crtc);
+
 	/* Kickoff will be scheduled by outer layer */
 	SDE_ATRACE_END("sde_crtc_atomic_flush");
 }
@@ -3754,6 +4323,8 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 		return;
 
 	SDE_ATRACE_BEGIN("crtc_commit");
+	_sde_crtc_timing_mark(sde_crtc, cstate->timing_seq,
+			SDE_CRTC_TIMING_KICKOFF);
 
 	/* ASUS BSP Display +++ */
 	anakin_crtc_display_commit(crtc);
@@ -3824,6 +4395,8 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 		sde_encoder_kickoff(encoder, false, true);
 	}
 	sde_crtc->kickoff_in_progress = false;
+	_sde_crtc_timing_mark(sde_crtc, cstate->timing_seq,
+			SDE_CRTC_TIMING_ENC_KICKOFF);
 
 	/* store the event after frame trigger */
 	if (sde_crtc->event) {
@@ -3835,6 +4408,7 @@ void sde_crtc_commit_kickoff(struct drm_crtc *crtc,
 	}
 
 	_sde_crtc_schedule_idle_notify(crtc);
+	_sde_crtc_schedule_static_cache(crtc);
 
 	/* ASUS BSP Display +++ */
 	dsi_anakin_frame_commit_cnt(crtc);
@@ -4188,6 +4762,7 @@ static void sde_crtc_disable(struct drm_crtc *crtc)
 	mutex_lock(&sde_crtc->crtc_lock);
 
 	kthread_cancel_delayed_work_sync(&sde_crtc->static_cache_read_work);
+	kthread_cancel_delayed_work_sync(&sde_crtc->static_cache_auto_work);
 	kthread_cancel_delayed_work_sync(&sde_crtc->idle_notify_work);
 
 	SDE_EVT32(DRMID(crtc), sde_crtc->enabled, crtc->state->active,
@@ -5096,18 +5671,42 @@ static int sde_crtc_atomic_check(struct drm_crtc *crtc,
 		goto end;
 	}
 
+	rc = _sde_crtc_set_damage_roi(crtc, state);
+	if (rc) {
+		SDE_DEBUG("crtc%d failed to set damage roi %d\n",
+				crtc->base.id, rc);
+		goto end;
+	}
+
 	rc = _sde_crtc_check_rois(crtc, state);
+	if (rc && cstate->damage_roi) {
+		/* damage is only a hint, fall back to a full frame update */
+		SDE_DEBUG("crtc%d damage roi rejected %d\n", crtc->base.id, rc);
+		_sde_crtc_clear_damage_roi(crtc, state);
+		rc = _sde_crtc_check_rois(crtc, state);
+	}
 	if (rc) {
 		SDE_ERROR("crtc%d failed roi check %d\n", crtc->base.id, rc);
 		goto end;
 	}
 
+	/* planes not in this commit need their rects reprogrammed too */
+	cstate->roi_changed = !sde_kms_rect_is_equal(&cstate->crtc_roi,
+			&to_sde_crtc_state(crtc->state)->crtc_roi);
+	if (cstate->roi_changed) {
+		rc = drm_atomic_add_affected_planes(state->state, crtc);
+		if (rc)
+			goto end;
+	}
+
 	rc = sde_cp_crtc_check_properties(crtc, state);
 	if (rc) {
 		SDE_ERROR("crtc%d failed cp properties check %d\n",
 				crtc->base.id, rc);
 		goto end;
 	}
+
+	cstate->check_ts = ktime_get();
 end:
 	kfree(pstates);
 	kfree(multirect_plane);
@@ -6203,6 +6802,80 @@ static int sde_crtc_debugfs_state_show(struct seq_file *s, void *v)
 }
 DEFINE_SDE_DEBUGFS_SEQ_FOPS(sde_crtc_debugfs_state);
 
+static int sde_crtc_debugfs_fetch_bytes_show(struct seq_file *s, void *v)
+{
+	struct sde_crtc *sde_crtc = s->private;
+
+	seq_printf(s, "last_frame: %llu\n", sde_crtc->fetch_bytes_last);
+	seq_printf(s, "total: %llu\n", sde_crtc->fetch_bytes_total);
+	seq_printf(s, "frames: %llu\n", sde_crtc->frame_cnt);
+	seq_printf(s, "partial_frames: %llu\n", sde_crtc->partial_frame_cnt);
+
+	return 0;
+}
+DEFINE_SDE_DEBUGFS_SEQ_FOPS(sde_crtc_debugfs_fetch_bytes);
+
+static int sde_crtc_debugfs_frame_timing_show(struct seq_file *s, void *v)
+{
+	struct sde_crtc *sde_crtc = s->private;
+	struct sde_crtc_frame_timing *timing, *frames;
+	unsigned long flags;
+	ktime_t *ts;
+	u32 seq, i;
+	int j;
+
+	frames = kcalloc(SDE_CRTC_TIMING_RING_SIZE, sizeof(*frames),
+			GFP_KERNEL);
+	if (!frames)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&sde_crtc->timing_lock, flags);
+	memcpy(frames, sde_crtc->timing, sizeof(sde_crtc->timing));
+	seq = sde_crtc->timing_seq;
+	spin_unlock_irqrestore(&sde_crtc->timing_lock, flags);
+
+	seq_puts(s, "usecs from atomic check, -1 if not reached\n");
+	seq_printf(s, "%10s %10s %10s %10s %10s %10s\n", "seq", "prepare",
+			"kickoff", "enc_kick", "pp_done", "retire");
+
+	for (i = 1; i <= SDE_CRTC_TIMING_RING_SIZE; i++) {
+		timing = &frames[(seq + i) & (SDE_CRTC_TIMING_RING_SIZE - 1)];
+		ts = timing->ts;
+		if (!timing->seq || !ts[SDE_CRTC_TIMING_CHECK])
+			continue;
+
+		seq_printf(s, "%10u", timing->seq);
+		for (j = SDE_CRTC_TIMING_PREPARE; j < SDE_CRTC_TIMING_MAX; j++)
+			seq_printf(s, " %10lld", ts[j] ? ktime_us_delta(ts[j],
+					ts[SDE_CRTC_TIMING_CHECK]) : -1);
+		seq_puts(s, "\n");
+	}
+
+	kfree(frames);
+
+	return 0;
+}
+DEFINE_SDE_DEBUGFS_SEQ_FOPS(sde_crtc_debugfs_frame_timing);
+
+static int sde_crtc_debugfs_static_cache_show(struct seq_file *s, void *v)
+{
+	struct sde_crtc *sde_crtc = s->private;
+	u64 read_us = sde_crtc->static_cache_read_us;
+
+	if (sde_crtc->cache_state == CACHE_STATE_FRAME_READ)
+		read_us += ktime_us_delta(ktime_get(),
+				sde_crtc->static_cache_read_ts);
+
+	seq_printf(s, "cache_state: %d\n", sde_crtc->cache_state);
+	seq_printf(s, "auto_frames: %u\n", sde_crtc->static_cache_auto_frames);
+	seq_printf(s, "auto_cached: %llu\n", sde_crtc->static_cache_auto_cnt);
+	seq_printf(s, "read_entries: %llu\n", sde_crtc->static_cache_read_cnt);
+	seq_printf(s, "read_residency_us: %llu\n", read_us);
+
+	return 0;
+}
+DEFINE_SDE_DEBUGFS_SEQ_FOPS(sde_crtc_debugfs_static_cache);
+
 static int _sde_debugfs_fence_status_show(struct seq_file *s, void *data)
 {
 	struct drm_crtc *crtc;
@@ -6339,6 +7012,26 @@ static int _sde_crtc_init_debugfs(struct drm_crtc *crtc)
 					sde_crtc, &debugfs_fps_fops);
 	debugfs_create_file("fence_status", 0400, sde_crtc->debugfs_root,
 					sde_crtc, &debugfs_fence_fops);
+	debugfs_create_file("fetch_bytes", 0400, sde_crtc->debugfs_root,
+					sde_crtc, &sde_crtc_debugfs_fetch_bytes_fops);
+	debugfs_create_file("frame_timing", 0400, sde_crtc->debugfs_root,
+					sde_crtc, &sde_crtc_debugfs_frame_timing_fops);
+	debugfs_create_file("static_cache", 0400, sde_crtc->debugfs_root,
+					sde_crtc, &sde_crtc_debugfs_static_cache_fops);
+	debugfs_create_u32("static_cache_auto_frames", 0600,
+			sde_crtc->debugfs_root,
+			&sde_crtc->static_cache_auto_frames);
+	if (sde_crtc->reg_dma_batch) {
+		debugfs_create_bool("reg_dma_batch", 0600,
+				sde_crtc->debugfs_root,
+				&sde_crtc->reg_dma_batch_en);
+		debugfs_create_u32("reg_dma_batch_submitted", 0400,
+				sde_crtc->debugfs_root,
+				&sde_crtc->reg_dma_batch->submitted);
+		debugfs_create_u32("reg_dma_batch_fallback", 0400,
+				sde_crtc->debugfs_root,
+				&sde_crtc->reg_dma_batch->fallback);
+	}
 
 	return 0;
 }
@@ -6544,6 +7237,14 @@ void sde_crtc_static_img_control(struct drm_crtc *crtc,
 		return;
 	}
 
+	if (sde_crtc->cache_state == CACHE_STATE_FRAME_READ)
+		sde_crtc->static_cache_read_us += ktime_us_delta(ktime_get(),
+				sde_crtc->static_cache_read_ts);
+	if (state == CACHE_STATE_FRAME_READ) {
+		sde_crtc->static_cache_read_ts = ktime_get();
+		sde_crtc->static_cache_read_cnt++;
+	}
+
 	sde_crtc->cache_state = state;
 	drm_atomic_crtc_for_each_plane(plane, crtc)
 		sde_plane_static_img_control(plane, state);
@@ -6627,6 +7328,99 @@ void sde_crtc_static_cache_read_kickoff(struct drm_crtc *crtc)
 			msecs_to_jiffies(msecs_fps));
 }
 
+/*
+ * __sde_crtc_static_cache_auto_work - cache a frame left unchanged
+ *
+ * Refetches the current frame with the planes writing into the display
+ * system cache, then moves to the cache read state on the next vblank
+ * the same way a user space requested pre-cache does.
+ */
+static void __sde_crtc_static_cache_auto_work(struct kthread_work *work)
+{
+	struct sde_crtc *sde_crtc = container_of(work, struct sde_crtc,
+			static_cache_auto_work.work);
+	struct drm_crtc *crtc = &sde_crtc->base;
+	struct sde_hw_ctl *ctl = sde_crtc->mixers[0].hw_ctl;
+	struct drm_encoder *enc, *drm_enc = NULL;
+	struct drm_plane *plane;
+
+	if (sde_crtc->cache_state != CACHE_STATE_NORMAL ||
+			!crtc->state->active)
+		return;
+
+	drm_for_each_encoder_mask(enc, crtc->dev, crtc->state->encoder_mask) {
+		drm_enc = enc;
+		if (sde_encoder_in_clone_mode(drm_enc))
+			return;
+	}
+
+	if (!drm_enc || !ctl || !sde_crtc->num_mixers)
+		return;
+
+	SDE_EVT32(DRMID(crtc), SDE_EVTLOG_FUNC_ENTRY);
+
+	sde_crtc_static_img_control(crtc, CACHE_STATE_PRE_CACHE, false);
+	sde_crtc_static_img_control(crtc, CACHE_STATE_FRAME_WRITE, false);
+	if (sde_crtc->cache_state != CACHE_STATE_FRAME_WRITE)
+		return;
+
+	sde_crtc->new_perf.llcc_active[SDE_SYS_CACHE_DISP] = false;
+	drm_atomic_crtc_for_each_plane(plane, crtc) {
+		if (sde_plane_is_cache_required(plane, SDE_SYS_CACHE_DISP))
+			sde_crtc->new_perf.llcc_active[SDE_SYS_CACHE_DISP] =
+					true;
+	}
+	sde_core_perf_crtc_update_llcc(crtc);
+
+	if (ctl->ops.clear_pending_flush)
+		ctl->ops.clear_pending_flush(ctl);
+
+	drm_atomic_crtc_for_each_plane(plane, crtc)
+		sde_plane_ctl_flush(plane, ctl, true);
+
+	/* refetch the unchanged frame once to fill the cache */
+	sde_encoder_kickoff(drm_enc, false, false);
+	sde_encoder_wait_for_event(drm_enc, MSM_ENC_VBLANK);
+
+	sde_crtc->static_cache_auto_cnt++;
+	sde_crtc_static_cache_read_kickoff(crtc);
+
+	SDE_EVT32(DRMID(crtc), sde_crtc->static_cache_auto_cnt,
+			SDE_EVTLOG_FUNC_EXIT);
+}
+
+static void _sde_crtc_schedule_static_cache(struct drm_crtc *crtc)
+{
+	struct sde_crtc *sde_crtc = to_sde_crtc(crtc);
+	struct sde_kms *sde_kms = _sde_crtc_get_kms(crtc);
+	struct msm_drm_private *priv;
+	u32 fps, delay_ms;
+
+	if (!sde_kms || !sde_kms->catalog || !sde_kms->dev ||
+			!sde_kms->dev->dev_private)
+		return;
+
+	priv = sde_kms->dev->dev_private;
+	fps = sde_crtc_get_fps_mode(crtc);
+
+	if (!sde_crtc->static_cache_auto_frames || !fps ||
+			!sde_kms->catalog->syscache_supported ||
+			!sde_kms->catalog->sc_cfg[SDE_SYS_CACHE_DISP].has_sys_cache ||
+			!sde_encoder_check_curr_mode(sde_crtc->mixers[0].encoder,
+						MSM_DISPLAY_VIDEO_MODE) ||
+			(crtc->index >= ARRAY_SIZE(priv->disp_thread)) ||
+			(sde_crtc->cache_state != CACHE_STATE_NORMAL))
+		return;
+
+	delay_ms = DIV_ROUND_UP(sde_crtc->static_cache_auto_frames * 1000,
+			fps);
+
+	/* runs on the display thread, serialized with the commits */
+	kthread_mod_delayed_work(&priv->disp_thread[crtc->index].worker,
+			&sde_crtc->static_cache_auto_work,
+			msecs_to_jiffies(delay_ms));
+}
+
 /*
  * __sde_crtc_idle_notify_work - signal idle timeout to user space
  */
@@ -6676,6 +7470,7 @@ struct drm_crtc *sde_crtc_init(struct drm_device *dev, struct drm_plane *plane)
 	mutex_init(&sde_crtc->crtc_lock);
 	spin_lock_init(&sde_crtc->spin_lock);
 	spin_lock_init(&sde_crtc->fevent_spin_lock);
+	spin_lock_init(&sde_crtc->timing_lock);
 	atomic_set(&sde_crtc->frame_pending, 0);
 
 	sde_crtc->enabled = false;
@@ -6748,8 +7543,16 @@ struct drm_crtc *sde_crtc_init(struct drm_device *dev, struct drm_plane *plane)
 
 	kthread_init_delayed_work(&sde_crtc->idle_notify_work,
 					__sde_crtc_idle_notify_work);
+	kthread_init_work(&sde_crtc->perf_prevote_work,
+			sde_core_perf_crtc_prevote_work);
+
+	sde_crtc->reg_dma_batch = sde_reg_dma_batch_alloc();
+	sde_crtc->reg_dma_batch_en = true;
 	kthread_init_delayed_work(&sde_crtc->static_cache_read_work,
 			__sde_crtc_static_cache_read_work);
+	kthread_init_delayed_work(&sde_crtc->static_cache_auto_work,
+			__sde_crtc_static_cache_auto_work);
+	sde_crtc->static_cache_auto_frames = SDE_CRTC_STATIC_CACHE_AUTO_FRAMES;
 
 	SDE_DEBUG("crtc=%d new_llcc=%d, old_llcc=%d\n",
 		crtc->base.id,
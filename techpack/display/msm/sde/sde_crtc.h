@@ -130,6 +130,44 @@ struct sde_crtc_mixer {
 	u32 mixer_op_mode;
 };
 
+/* frames kept in the per crtc timing ring, must be a power of 2 */
+#define SDE_CRTC_TIMING_RING_SIZE	64
+
+/* kicked off frames that can still complete out of the timing ring */
+#define SDE_CRTC_TIMING_MAX_PENDING	3
+
+/* default unchanged frames before the static image cache kicks in */
+#define SDE_CRTC_STATIC_CACHE_AUTO_FRAMES	120
+
+/**
+ * enum sde_crtc_timing_point - points of a frame's way to the panel
+ * @SDE_CRTC_TIMING_CHECK: atomic check of the frame's state completed
+ * @SDE_CRTC_TIMING_PREPARE: commit prepared, output fences created
+ * @SDE_CRTC_TIMING_KICKOFF: sde_crtc_commit_kickoff started
+ * @SDE_CRTC_TIMING_ENC_KICKOFF: encoders flushed and triggered the frame
+ * @SDE_CRTC_TIMING_PP_DONE: frame done event from the pingpong
+ * @SDE_CRTC_TIMING_RETIRE: retire fence signal event
+ */
+enum sde_crtc_timing_point {
+	SDE_CRTC_TIMING_CHECK,
+	SDE_CRTC_TIMING_PREPARE,
+	SDE_CRTC_TIMING_KICKOFF,
+	SDE_CRTC_TIMING_ENC_KICKOFF,
+	SDE_CRTC_TIMING_PP_DONE,
+	SDE_CRTC_TIMING_RETIRE,
+	SDE_CRTC_TIMING_MAX,
+};
+
+/**
+ * struct sde_crtc_frame_timing - timestamps of a single frame
+ * @seq: frame sequence number, 0 for an unused entry
+ * @ts: ktime of each enum sde_crtc_timing_point, 0 if not reached
+ */
+struct sde_crtc_frame_timing {
+	u32 seq;
+	ktime_t ts[SDE_CRTC_TIMING_MAX];
+};
+
 /**
  * struct sde_crtc_frame_event: stores crtc frame event for crtc processing
  * @work:	base work structure
@@ -279,6 +317,9 @@ struct sde_crtc_misr_info {
  * @idle_notify_work: delayed worker to notify idle timeout to user space
  * @power_event   : registered power event handle
  * @cur_perf      : current performance committed to clock/bandwidth driver
+ * @prevote_perf  : performance of the next frame, pending a predictive vote
+ * @perf_history  : performance of the last committed frames
+ * @perf_prevote_work: event thread work applying @prevote_perf
  * @plane_mask_old: keeps track of the planes used in the previous commit
  * @frame_trigger_mode: frame trigger mode
  * @cp_pu_feature_mask: mask indicating cp feature enable for partial update
@@ -295,9 +336,27 @@ struct sde_crtc_misr_info {
  * @src_bpp         : source bpp used to calculate compression ratio
  * @target_bpp      : target bpp used to calculate compression ratio
  * @static_cache_read_work: delayed worker to transition cache state to read
+ * @static_cache_auto_work: delayed worker caching an unchanged frame
+ * @static_cache_auto_frames: unchanged frames before caching, 0 to disable
+ * @static_cache_auto_cnt : frames cached by @static_cache_auto_work
+ * @static_cache_read_cnt : transitions to the cache read state
+ * @static_cache_read_us : time spent fetching from the cache
+ * @static_cache_read_ts : ktime the current cache read state started
  * @cache_state     : Current static image cache state
  * @dspp_blob_info  : blob containing dspp hw capability information
  * @cached_encoder_mask : cached encoder_mask for vblank work
+ * @reg_dma_batch   : reg dma batch for the sspp and lm writes of a commit
+ * @reg_dma_batch_en : debug control, false to program sspp and lm by the cpu
+ * @fetch_bytes_last : bytes fetched by the sspps for the last frame
+ * @fetch_bytes_total : bytes fetched by the sspps since crtc init
+ * @frame_cnt      : frames committed since crtc init
+ * @partial_frame_cnt : frames committed with a damage derived roi
+ * @timing_lock     : spinlock around the frame timing ring
+ * @timing          : ring of the timestamps of the last frames
+ * @timing_seq      : sequence number of the last prepared frame
+ * @timing_kicked   : sequence number of the last kicked off frame
+ * @timing_done_seq : sequence number of the last frame done
+ * @timing_retire_seq : sequence number of the last frame retired
  */
 struct sde_crtc {
 	struct drm_crtc base;
@@ -365,6 +424,9 @@ struct sde_crtc {
 
 	struct sde_core_perf_params cur_perf;
 	struct sde_core_perf_params new_perf;
+	struct sde_core_perf_params prevote_perf;
+	struct sde_core_perf_history perf_history;
+	struct kthread_work perf_prevote_work;
 
 	u32 plane_mask_old;
 
@@ -390,10 +452,30 @@ struct sde_crtc {
 	int target_bpp;
 
 	struct kthread_delayed_work static_cache_read_work;
+	struct kthread_delayed_work static_cache_auto_work;
+	u32 static_cache_auto_frames;
+	u64 static_cache_auto_cnt;
+	u64 static_cache_read_cnt;
+	u64 static_cache_read_us;
+	ktime_t static_cache_read_ts;
 	enum sde_crtc_cache_state cache_state;
 
 	struct drm_property_blob *dspp_blob_info;
 	u32 cached_encoder_mask;
+	struct sde_reg_dma_batch *reg_dma_batch;
+	bool reg_dma_batch_en;
+
+	u64 fetch_bytes_last;
+	u64 fetch_bytes_total;
+	u64 frame_cnt;
+	u64 partial_frame_cnt;
+
+	spinlock_t timing_lock;
+	struct sde_crtc_frame_timing timing[SDE_CRTC_TIMING_RING_SIZE];
+	u32 timing_seq;
+	u32 timing_kicked;
+	u32 timing_done_seq;
+	u32 timing_retire_seq;
 };
 
 enum sde_crtc_dirty_flags {
@@ -421,6 +503,9 @@ enum sde_crtc_dirty_flags {
  *                  Origin top left of CRTC.
  * @user_roi_list : List of user's requested ROIs as from set property
  * @cached_user_roi_list : Copy of user_roi_list from previous PU frame
+ * @damage_roi    : user_roi_list and connector rois were derived from the
+ *                  FB_DAMAGE_CLIPS of the planes, not set by user space
+ * @roi_changed   : crtc_roi differs from the one of the previous frame
  * @property_state: Local storage for msm_prop properties
  * @property_values: Current crtc property values
  * @input_fence_timeout_ns : Cached input fence timeout, in ns
@@ -432,6 +517,8 @@ enum sde_crtc_dirty_flags {
  * @ds_cfg: Destination scaler config
  * @scl3_lut_cfg: QSEED3 lut config
  * @new_perf: new performance state being requested
+ * @check_ts: ktime the atomic check of the state completed
+ * @timing_seq: frame timing sequence number of the committed state
  */
 struct sde_crtc_state {
 	struct drm_crtc_state base;
@@ -448,6 +535,8 @@ struct sde_crtc_state {
 	struct sde_rect lm_bounds[MAX_MIXERS_PER_CRTC];
 	struct sde_rect lm_roi[MAX_MIXERS_PER_CRTC];
 	struct msm_roi_list user_roi_list, cached_user_roi_list;
+	bool damage_roi;
+	bool roi_changed;
 
 	struct msm_property_state property_state;
 	struct msm_property_value property_values[CRTC_PROP_COUNT];
@@ -462,6 +551,8 @@ struct sde_crtc_state {
 	struct sde_hw_scaler3_lut_cfg scl3_lut_cfg;
 
 	struct sde_core_perf_params new_perf;
+	ktime_t check_ts;
+	u32 timing_seq;
 };
 
 enum sde_crtc_irq_state {
@@ -773,6 +864,26 @@ void sde_crtc_get_crtc_roi(struct drm_crtc_state *state,
  */
 bool sde_crtc_is_crtc_roi_dirty(struct drm_crtc_state *state);
 
+/**
+ * sde_crtc_is_roi_changed - whether crtc_roi differs from the previous frame,
+ *	whether set by user space or derived from plane damage
+ * @crtc_state: Pointer to crtc state
+ * Return: true if the planes need to reprogram their output rects
+ */
+bool sde_crtc_is_roi_changed(struct drm_crtc_state *state);
+
+/**
+ * sde_crtc_crop_to_damage_roi - crop a plane to a roi derived from damage
+ *	Planes are not required to lie within such a roi, fetching is limited
+ *	to the part of the plane inside it instead.
+ * @crtc_state: Pointer to crtc state
+ * @src: Plane source rectangle in framebuffer pixels, cropped on return
+ * @dst: Plane destination rectangle in crtc pixels, cropped on return
+ * Return: false if the plane lies outside the roi and isn't fetched
+ */
+bool sde_crtc_crop_to_damage_roi(struct drm_crtc_state *state,
+		struct sde_rect *src, struct sde_rect *dst);
+
 /** sde_crt_get_secure_level - retrieve the secure level from the give state
  *	object, this is used to determine the secure state of the crtc
  * @crtc : Pointer to drm crtc structure
@@ -270,6 +270,15 @@ static int _sde_encoder_wait_timeout(int32_t drm_id, int32_t hw_id,
 	return rc;
 }
 
+static void _sde_encoder_wait_hist_add(struct drm_encoder *drm_enc, s64 us)
+{
+	struct sde_encoder_virt *sde_enc = to_sde_encoder_virt(drm_enc);
+	int bucket = us > 0 ? fls64(us) : 0;
+
+	atomic_inc(&sde_enc->wait_hist[min(bucket,
+			SDE_ENC_WAIT_HIST_BUCKETS - 1)]);
+}
+
 u32 sde_encoder_get_display_type(struct drm_encoder *drm_enc)
 {
 	struct sde_encoder_virt *sde_enc = to_sde_encoder_virt(drm_enc);
@@ -313,6 +322,7 @@ int sde_encoder_helper_wait_for_irq(struct sde_encoder_phys *phys_enc,
 		struct sde_encoder_wait_info *wait_info)
 {
 	struct sde_encoder_irq *irq;
+	ktime_t wait_start;
 	u32 irq_status;
 	int ret, i;
 
@@ -354,6 +364,7 @@ int sde_encoder_helper_wait_for_irq(struct sde_encoder_phys *phys_enc,
 	 * It is handled by split the wait timer in two halves.
 	 */
 
+	wait_start = ktime_get();
 	for (i = 0; i < EVT_TIME_OUT_SPLIT; i++) {
 		ret = _sde_encoder_wait_timeout(DRMID(phys_enc->parent),
 				irq->hw_idx,
@@ -362,6 +373,8 @@ int sde_encoder_helper_wait_for_irq(struct sde_encoder_phys *phys_enc,
 		if (ret)
 			break;
 	}
+	_sde_encoder_wait_hist_add(phys_enc->parent,
+			ktime_us_delta(ktime_get(), wait_start));
 
 	if (ret <= 0) {
 		irq_status = sde_core_irq_read(phys_enc->sde_kms,
@@ -3279,6 +3292,39 @@ static void sde_encoder_frame_done_callback(
 	}
 }
 
+/**
+ * _sde_encoder_apply_content_fps - raise the qsync min fps to a multiple of
+ *	the hinted content frame rate
+ * @sde_enc: Pointer to sde encoder structure
+ * @qsync_fps: Panel qsync min fps, updated
+ * @vrr_fps: Current refresh rate, 0 to use the cached mode's
+ *
+ * With a content rate hint the panel is stretched to the lowest multiple of
+ * the content rate it supports, so 24 and 30 fps content keeps an even
+ * cadence at a low refresh instead of following the panel's min fps.
+ */
+static void _sde_encoder_apply_content_fps(struct sde_encoder_virt *sde_enc,
+	u32 *qsync_fps, u32 vrr_fps)
+{
+	u32 content_fps, target_fps;
+
+	content_fps = sde_connector_get_content_fps(
+			sde_enc->cur_master->connector);
+	if (!vrr_fps)
+		vrr_fps = sde_enc->cur_master->cached_mode.vrefresh;
+
+	if (!content_fps || !*qsync_fps || content_fps >= vrr_fps)
+		return;
+
+	target_fps = content_fps * DIV_ROUND_UP(*qsync_fps, content_fps);
+	if (target_fps >= vrr_fps)
+		return;
+
+	SDE_DEBUG_ENC(sde_enc, "content fps %d min fps %d -> %d\n",
+			content_fps, *qsync_fps, target_fps);
+	*qsync_fps = target_fps;
+}
+
 static void sde_encoder_get_qsync_fps_callback(
 	struct drm_encoder *drm_enc,
 	u32 *qsync_fps, u32 vrr_fps)
@@ -3325,6 +3371,9 @@ static void sde_encoder_get_qsync_fps_callback(
 		}
 		*qsync_fps = rc;
 	}
+
+	if (sde_enc->cur_master)
+		_sde_encoder_apply_content_fps(sde_enc, qsync_fps, vrr_fps);
 }
 
 int sde_encoder_idle_request(struct drm_encoder *drm_enc)
@@ -4527,6 +4576,32 @@ static int _sde_encoder_debugfs_status_open(struct inode *inode,
 	return single_open(file, _sde_encoder_status_show, inode->i_private);
 }
 
+static int _sde_encoder_wait_hist_show(struct seq_file *s, void *data)
+{
+	struct sde_encoder_virt *sde_enc;
+	int i;
+
+	if (!s || !s->private)
+		return -EINVAL;
+
+	sde_enc = s->private;
+
+	for (i = 0; i < SDE_ENC_WAIT_HIST_BUCKETS - 1; i++)
+		seq_printf(s, "<%8uus: %u\n", 1U << i,
+				atomic_read(&sde_enc->wait_hist[i]));
+	seq_printf(s, ">=%7uus: %u\n", 1U << (i - 1),
+			atomic_read(&sde_enc->wait_hist[i]));
+
+	return 0;
+}
+
+static int _sde_encoder_debugfs_wait_hist_open(struct inode *inode,
+		struct file *file)
+{
+	return single_open(file, _sde_encoder_wait_hist_show,
+			inode->i_private);
+}
+
 static ssize_t _sde_encoder_misr_setup(struct file *file,
 		const char __user *user_buf, size_t count, loff_t *ppos)
 {
@@ -4681,6 +4756,13 @@ static int _sde_encoder_init_debugfs(struct drm_encoder *drm_enc)
 		.write = _sde_encoder_misr_setup,
 	};
 
+	static const struct file_operations debugfs_wait_hist_fops = {
+		.open =		_sde_encoder_debugfs_wait_hist_open,
+		.read =		seq_read,
+		.llseek =	seq_lseek,
+		.release =	single_release,
+	};
+
 	char name[SDE_NAME_SIZE];
 
 	if (!drm_enc) {
@@ -4710,6 +4792,9 @@ static int _sde_encoder_init_debugfs(struct drm_encoder *drm_enc)
 	debugfs_create_file("misr_data", 0600,
 		sde_enc->debugfs_root, sde_enc, &debugfs_misr_fops);
 
+	debugfs_create_file("wait_hist", 0400,
+		sde_enc->debugfs_root, sde_enc, &debugfs_wait_hist_fops);
+
 	debugfs_create_bool("idle_power_collapse", 0600, sde_enc->debugfs_root,
 			&sde_enc->idle_pc_enabled);
 
@@ -116,6 +116,9 @@ struct sde_encoder_ops {
 			u32 controller_id, void *phys_init_params);
 };
 
+/* buckets of the wait duration histogram, 1us to 16ms and longer */
+#define SDE_ENC_WAIT_HIST_BUCKETS	16
+
 /**
  * struct sde_encoder_virt - virtual encoder. Container of one or more physical
  *	encoders. Virtual encoder manages one "logical" display. Physical
@@ -193,6 +196,9 @@ struct sde_encoder_ops {
  *				of esd attack to ensure esd workqueue detects
  *				the previous frame transfer completion before
  *				next update is triggered.
+ * @wait_hist:			log2 histogram of the irq wait durations in
+ *				microseconds, the last bucket collecting all
+ *				longer waits
  */
 struct sde_encoder_virt {
 	struct drm_encoder base;
@@ -261,6 +267,7 @@ struct sde_encoder_virt {
 	struct cpumask valid_cpu_mask;
 	struct msm_mode_info mode_info;
 	bool delay_kickoff;
+	atomic_t wait_hist[SDE_ENC_WAIT_HIST_BUCKETS];
 };
 
 #define to_sde_encoder_virt(x) container_of(x, struct sde_encoder_virt, base)
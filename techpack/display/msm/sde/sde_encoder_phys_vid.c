@@ -1165,9 +1165,24 @@ static void sde_encoder_phys_vid_prepare_for_commit(
 		return;
 	}
 
-	if (!msm_is_mode_seamless_vrr(&crtc->state->adjusted_mode)
-			&& sde_connector_is_qsync_updated(phys_enc->connector))
-		_sde_encoder_phys_vid_avr_ctrl(phys_enc);
+	if (msm_is_mode_seamless_vrr(&crtc->state->adjusted_mode)
+			|| !sde_connector_is_qsync_updated(phys_enc->connector))
+		return;
+
+	/* new content rate, extend the porch up to the new min fps */
+	if (sde_connector_is_content_fps_updated(phys_enc->connector)) {
+		u32 qsync_min_fps = 0;
+
+		if (phys_enc->parent_ops.get_qsync_fps)
+			phys_enc->parent_ops.get_qsync_fps(phys_enc->parent,
+				&qsync_min_fps, phys_enc->cached_mode.vrefresh);
+		if (qsync_min_fps)
+			_sde_encoder_phys_vid_setup_avr(phys_enc,
+					qsync_min_fps);
+		return;
+	}
+
+	_sde_encoder_phys_vid_avr_ctrl(phys_enc);
 
 }
 
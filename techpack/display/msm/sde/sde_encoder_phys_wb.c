@@ -5,6 +5,7 @@
 
 #define pr_fmt(fmt)	"[drm:%s:%d] " fmt, __func__, __LINE__
 #include <linux/debugfs.h>
+#include <linux/dma-resv.h>
 #include <drm/sde_drm.h>
 
 #include "sde_encoder_phys.h"
@@ -15,6 +16,9 @@
 #include "sde_wb.h"
 #include "sde_vbif.h"
 #include "sde_crtc.h"
+#include "sde_connector.h"
+#include "sde_fence.h"
+#include "msm_gem.h"
 
 #define to_sde_encoder_phys_wb(x) \
 	container_of(x, struct sde_encoder_phys_wb, base)
@@ -306,6 +310,49 @@ void sde_encoder_phys_setup_cdm(struct sde_encoder_phys *phys_enc,
  * @fb:		Pointer to output framebuffer
  * @wb_roi:	Pointer to output region of interest
  */
+/**
+ * _sde_encoder_phys_wb_attach_fence - publish the writeback completion on
+ *	the output buffer so an importer, e.g. a video encoder, can consume
+ *	it straight from the reservation object
+ * @phys_enc:	Pointer to physical encoder
+ * @fb:		Pointer to output framebuffer
+ */
+static void _sde_encoder_phys_wb_attach_fence(
+		struct sde_encoder_phys *phys_enc, struct drm_framebuffer *fb)
+{
+	struct sde_connector *c_conn = to_sde_connector(phys_enc->connector);
+	struct drm_gem_object *obj, *prev = NULL;
+	struct msm_gem_object *msm_obj;
+	struct dma_fence *fence;
+	int i;
+
+	if (phys_enc->enable_state == SDE_ENC_DISABLING)
+		return;
+
+	for (i = 0; i < fb->format->num_planes; i++) {
+		obj = msm_framebuffer_bo(fb, i);
+		if (!obj || obj == prev || !obj->import_attach)
+			continue;
+		prev = obj;
+		msm_obj = to_msm_bo(obj);
+
+		/* retire fence of this commit signals on writeback done */
+		fence = sde_fence_create_object(c_conn->retire_fence, 0);
+		if (IS_ERR(fence)) {
+			SDE_ERROR("failed to create wb fence %ld\n",
+					PTR_ERR(fence));
+			return;
+		}
+
+		dma_resv_lock(msm_obj->resv, NULL);
+		dma_resv_add_excl_fence(msm_obj->resv, fence);
+		dma_resv_unlock(msm_obj->resv);
+		dma_fence_put(fence);
+
+		SDE_EVT32(DRMID(phys_enc->parent), fb->base.id, i);
+	}
+}
+
 static void sde_encoder_phys_wb_setup_fb(struct sde_encoder_phys *phys_enc,
 		struct drm_framebuffer *fb, struct sde_rect *wb_roi)
 {
@@ -361,6 +408,8 @@ static void sde_encoder_phys_wb_setup_fb(struct sde_encoder_phys *phys_enc,
 	wb_enc->wb_aspace = aspace;
 	drm_framebuffer_get(fb);
 
+	_sde_encoder_phys_wb_attach_fence(phys_enc, fb);
+
 	format = msm_framebuffer_format(fb);
 	if (!format) {
 		SDE_DEBUG("invalid format for fb\n");
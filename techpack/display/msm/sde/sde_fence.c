@@ -178,6 +178,46 @@ static struct dma_fence_ops sde_fence_ops = {
 	.timeline_value_str = sde_fence_timeline_value_str,
 };
 
+static struct sde_fence *_sde_fence_alloc(struct sde_fence_context *ctx,
+		uint32_t val)
+{
+	struct sde_fence *sde_fence;
+
+	sde_fence = kzalloc(sizeof(*sde_fence), GFP_KERNEL);
+	if (!sde_fence)
+		return NULL;
+
+	sde_fence->ctx = ctx;
+	sde_fence->fd = -1;
+	snprintf(sde_fence->name, SDE_FENCE_NAME_SIZE, "sde_fence:%s:%u",
+						sde_fence->ctx->name, val);
+	dma_fence_init(&sde_fence->base, &sde_fence_ops, &ctx->lock,
+		ctx->context, val);
+	kref_get(&ctx->kref);
+
+	return sde_fence;
+}
+
+/* hands the caller's fence reference over to the timeline */
+static void _sde_fence_add(struct sde_fence_context *ctx,
+		struct sde_fence *sde_fence)
+{
+	struct sde_fence *pos;
+
+	/*
+	 * Keep the list in seqno order so signaling can stop at the first
+	 * pending fence; a fence offset change is the only reason a new
+	 * fence does not simply go to the tail.
+	 */
+	spin_lock(&ctx->list_lock);
+	list_for_each_entry_reverse(pos, &ctx->fence_list_head, fence_list) {
+		if ((int)(pos->base.seqno - sde_fence->base.seqno) <= 0)
+			break;
+	}
+	list_add(&sde_fence->fence_list, &pos->fence_list);
+	spin_unlock(&ctx->list_lock);
+}
+
 /**
  * _sde_fence_create_fd - create fence object and return an fd for it
  * This function is NOT thread-safe.
@@ -197,17 +237,10 @@ static int _sde_fence_create_fd(void *fence_ctx, uint32_t val)
 		goto exit;
 	}
 
-	sde_fence = kzalloc(sizeof(*sde_fence), GFP_KERNEL);
+	sde_fence = _sde_fence_alloc(ctx, val);
 	if (!sde_fence)
 		return -ENOMEM;
 
-	sde_fence->ctx = fence_ctx;
-	snprintf(sde_fence->name, SDE_FENCE_NAME_SIZE, "sde_fence:%s:%u",
-						sde_fence->ctx->name, val);
-	dma_fence_init(&sde_fence->base, &sde_fence_ops, &ctx->lock,
-		ctx->context, val);
-	kref_get(&ctx->kref);
-
 	/* create fd */
 	fd = get_unused_fd_flags(0);
 	if (fd < 0) {
@@ -230,9 +263,7 @@ static int _sde_fence_create_fd(void *fence_ctx, uint32_t val)
 	fd_install(fd, sync_file->file);
 	sde_fence->fd = fd;
 
-	spin_lock(&ctx->list_lock);
-	list_add_tail(&sde_fence->fence_list, &ctx->fence_list_head);
-	spin_unlock(&ctx->list_lock);
+	_sde_fence_add(ctx, sde_fence);
 
 exit:
 	return fd;
@@ -293,7 +324,10 @@ static void _sde_fence_trigger(struct sde_fence_context *ctx, bool error)
 {
 	unsigned long flags;
 	struct sde_fence *fc, *next;
-	bool is_signaled = false;
+	LIST_HEAD(signaled);
+	ktime_t start;
+	u64 irqoff_ns;
+	u32 count = 0;
 
 	kref_get(&ctx->kref);
 
@@ -303,20 +337,40 @@ static void _sde_fence_trigger(struct sde_fence_context *ctx, bool error)
 		goto end;
 	}
 
+	/* signal every ready fence in one irqs disabled section */
+	spin_lock_irqsave(&ctx->lock, flags);
+	start = ktime_get();
 	list_for_each_entry_safe(fc, next, &ctx->fence_list_head, fence_list) {
-		spin_lock_irqsave(&ctx->lock, flags);
 		if (error)
 			dma_fence_set_error(&fc->base, -EBUSY);
-		is_signaled = dma_fence_is_signaled_locked(&fc->base);
-		spin_unlock_irqrestore(&ctx->lock, flags);
+		else if (!sde_fence_signaled(&fc->base))
+			break;
 
-		if (is_signaled) {
-			list_del_init(&fc->fence_list);
-			dma_fence_put(&fc->base);
+		if (dma_fence_is_signaled_locked(&fc->base)) {
+			list_move_tail(&fc->fence_list, &signaled);
+			count++;
 		}
 	}
+	irqoff_ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	if (count) {
+		ctx->batch_count++;
+		ctx->batch_max = max(ctx->batch_max, count);
+		ctx->irqoff_total_ns += irqoff_ns;
+		ctx->irqoff_max_ns = max(ctx->irqoff_max_ns, irqoff_ns);
+	}
+	spin_unlock_irqrestore(&ctx->lock, flags);
 end:
 	spin_unlock(&ctx->list_lock);
+
+	/* drop the timeline references with irqs and the list unlocked */
+	list_for_each_entry_safe(fc, next, &signaled, fence_list) {
+		list_del_init(&fc->fence_list);
+		dma_fence_put(&fc->base);
+	}
+
+	if (count)
+		SDE_EVT32_VERBOSE(ctx->drm_id, count, irqoff_ns);
 	kref_put(&ctx->kref, sde_fence_destroy);
 }
 
@@ -356,6 +410,35 @@ int sde_fence_create(struct sde_fence_context *ctx, uint64_t *val,
 	return rc;
 }
 
+struct dma_fence *sde_fence_create_object(struct sde_fence_context *ctx,
+							uint32_t offset)
+{
+	struct sde_fence *sde_fence;
+	uint32_t trigger_value;
+	unsigned long flags;
+
+	if (!ctx) {
+		SDE_ERROR("invalid context\n");
+		return ERR_PTR(-EINVAL);
+	}
+
+	spin_lock_irqsave(&ctx->lock, flags);
+	trigger_value = ctx->commit_count + offset;
+	spin_unlock_irqrestore(&ctx->lock, flags);
+
+	sde_fence = _sde_fence_alloc(ctx, trigger_value);
+	if (!sde_fence)
+		return ERR_PTR(-ENOMEM);
+
+	/* one reference for the caller, the other one stays on the list */
+	dma_fence_get(&sde_fence->base);
+	_sde_fence_add(ctx, sde_fence);
+
+	SDE_EVT32(ctx->drm_id, trigger_value);
+
+	return &sde_fence->base;
+}
+
 void sde_fence_signal(struct sde_fence_context *ctx, ktime_t ts,
 		enum sde_fence_event fence_event)
 {
@@ -470,6 +553,9 @@ void sde_debugfs_timeline_dump(struct sde_fence_context *ctx,
 	seq_printf(*s, "drm obj:%s id:%d type:0x%x done_count:%d commit_count:%d\n",
 		obj_name, drm_obj->id, drm_obj->type, ctx->done_count,
 		ctx->commit_count);
+	seq_printf(*s, "signal batches:%u max_batch:%u irqoff_ns total:%llu max:%llu\n",
+		ctx->batch_count, ctx->batch_max, ctx->irqoff_total_ns,
+		ctx->irqoff_max_ns);
 
 	spin_lock(&ctx->list_lock);
 	list_for_each_entry_safe(fc, next, &ctx->fence_list_head, fence_list) {
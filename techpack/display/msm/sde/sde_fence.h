@@ -25,8 +25,13 @@
  * @lock: spinlock for fence counter protection
  * @list_lock: spinlock for timeline protection
  * @context: fence context
- * @list_head: fence list to hold all the fence created on this context
+ * @list_head: fence list to hold all the fence created on this context,
+ *	in signaling order
  * @name: name of fence context/timeline
+ * @batch_count: Number of timeline advances that signaled fences
+ * @batch_max: Most fences signaled by a single timeline advance
+ * @irqoff_total_ns: Total time fences were signaled with irqs disabled
+ * @irqoff_max_ns: Longest single irqs disabled signaling section
  */
 struct sde_fence_context {
 	unsigned int commit_count;
@@ -38,6 +43,10 @@ struct sde_fence_context {
 	u64 context;
 	struct list_head fence_list_head;
 	char name[SDE_FENCE_NAME_SIZE];
+	u32 batch_count;
+	u32 batch_max;
+	u64 irqoff_total_ns;
+	u64 irqoff_max_ns;
 };
 
 /**
@@ -127,6 +136,15 @@ void sde_fence_prepare(struct sde_fence_context *fence);
 int sde_fence_create(struct sde_fence_context *fence, uint64_t *val,
 							uint32_t offset);
 
+/**
+ * sde_fence_create_object - create an output fence without an fd
+ * @fence: Pointer fence container
+ * @offset: Fence signal commit offset, e.g., +1 to signal on next commit
+ * Returns: Referenced dma fence on success, or error pointer
+ */
+struct dma_fence *sde_fence_create_object(struct sde_fence_context *fence,
+							uint32_t offset);
+
 /**
  * sde_fence_signal - advance fence timeline to signal outstanding fences
  * @fence: Pointer fence container
@@ -214,6 +232,12 @@ static inline int sde_fence_create(struct sde_fence_context *fence,
 	return 0;
 }
 
+static inline struct dma_fence *sde_fence_create_object(
+		struct sde_fence_context *fence, uint32_t offset)
+{
+	return ERR_PTR(-EINVAL);
+}
+
 static inline void sde_fence_timeline_status(struct sde_fence_context *ctx,
 					struct drm_mode_object *drm_obj);
 {
@@ -839,6 +839,7 @@ int init_v12(struct sde_hw_reg_dma *cfg)
 	v1_supported[SPR_PU_CFG] = (GRP_DSPP_HW_BLK_SELECT |
 			GRP_MDSS_HW_BLK_SELECT);
 	v1_supported[DEMURA_CFG] = MDSS | DSPP0 | DSPP1;
+	v1_supported[BLK_CFG] = GRP_MDSS_HW_BLK_SELECT;
 
 	return 0;
 }
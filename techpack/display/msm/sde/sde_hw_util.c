@@ -9,6 +9,7 @@
 #include "sde_kms.h"
 #include "sde_hw_mdss.h"
 #include "sde_hw_util.h"
+#include "sde_reg_dma.h"
 
 /* using a file static variables for debugfs access */
 static u32 sde_hw_util_log_mask = SDE_DBG_MASK_NONE;
@@ -78,12 +79,21 @@ void sde_reg_write(struct sde_hw_blk_reg_map *c,
 		SDE_DEBUG_DRIVER("[%s:0x%X] <= 0x%X\n",
 				name, c->blk_off + reg_off, val);
 	SDE_EVT32_REGWRITE(c->blk_off + reg_off, val, GET_REG_BLK_ID(c));
-	writel_relaxed(val, c->base_off + c->blk_off + reg_off);
+	if (!c->batch ||
+			!sde_reg_dma_batch_write(c->batch, c->blk_off + reg_off, val))
+		writel_relaxed(val, c->base_off + c->blk_off + reg_off);
 	SDE_REG_LOG(GET_REG_BLK_ID(c), val, c->blk_off + reg_off);
 }
 
 int sde_reg_read(struct sde_hw_blk_reg_map *c, u32 reg_off)
 {
+	u32 val;
+
+	/* read-modify-write sequences have to see pending batched writes */
+	if (c->batch &&
+			sde_reg_dma_batch_read(c->batch, c->blk_off + reg_off, &val))
+		return val;
+
 	return readl_relaxed(c->base_off + c->blk_off + reg_off);
 }
 
@@ -18,6 +18,7 @@
 #define LP_DDR4_TYPE			0x7
 
 struct sde_format_extended;
+struct sde_reg_dma_batch;
 
 /*
  * This is the common struct maintained by each sub block
@@ -28,6 +29,7 @@ struct sde_format_extended;
  * @length        length of register block offset
  * @xin_id        xin id
  * @hwversion     mdss hw version number
+ * @batch         reg dma batch collecting the writes to the block, if any
  */
 struct sde_hw_blk_reg_map {
 	void __iomem *base_off;
@@ -36,6 +38,7 @@ struct sde_hw_blk_reg_map {
 	u32 xin_id;
 	u32 hwversion;
 	u32 log_mask;
+	struct sde_reg_dma_batch *batch;
 };
 
 /**
@@ -22,6 +22,7 @@
 #include <linux/dma-buf.h>
 #include <drm/sde_drm.h>
 #include <drm/msm_drm_pp.h>
+#include <drm/drm_damage_helper.h>
 
 #include "msm_prop.h"
 #include "msm_drv.h"
@@ -3018,6 +3019,12 @@ static void _sde_plane_update_roi_config(struct drm_plane *plane,
 		src.y &= ~0x1;
 	}
 
+	/* only fetch the part of the plane inside a damage derived roi */
+	if (!sde_crtc_crop_to_damage_roi(crtc->state, &src, &dst)) {
+		SDE_DEBUG_PLANE(psde, "outside of damage roi\n");
+		return;
+	}
+
 	/*
 	 * adjust layer mixer position of the sspp in the presence
 	 * of a partial update to the active lm origin
@@ -3319,7 +3326,8 @@ static int sde_plane_sspp_atomic_update(struct drm_plane *plane,
 								old_state);
 
 	/* re-program the output rects always if partial update roi changed */
-	if (sde_crtc_is_crtc_roi_dirty(crtc->state))
+	if (sde_crtc_is_crtc_roi_dirty(crtc->state) ||
+			sde_crtc_is_roi_changed(crtc->state))
 		pstate->dirty |= SDE_PLANE_DIRTY_RECTS;
 
 	if (pstate->dirty & SDE_PLANE_DIRTY_RECTS)
@@ -3437,6 +3445,19 @@ void sde_plane_restore(struct drm_plane *plane)
 	sde_plane_atomic_update(plane, plane->state);
 }
 
+void sde_plane_set_reg_dma_batch(struct drm_plane *plane,
+		struct sde_reg_dma_batch *batch)
+{
+	struct sde_plane *psde;
+
+	if (!plane)
+		return;
+
+	psde = to_sde_plane(plane);
+	if (psde->pipe_hw)
+		psde->pipe_hw->hw.batch = batch;
+}
+
 bool sde_plane_is_cache_required(struct drm_plane *plane,
 		enum sde_sys_cache_type type)
 {
@@ -4740,6 +4761,7 @@ struct drm_plane *sde_plane_init(struct drm_device *dev,
 			sizeof(struct sde_plane_state));
 
 	_sde_plane_install_properties(plane, kms->catalog, master_plane_id);
+	drm_plane_enable_fb_damage_clips(plane);
 
 	/* save user friendly pipe name for later */
 	snprintf(psde->pipe_name, SDE_NAME_SIZE, "plane%u", plane->base.id);
@@ -195,6 +195,14 @@ void sde_plane_ctl_flush(struct drm_plane *plane, struct sde_hw_ctl *ctl,
  */
 void sde_plane_restore(struct drm_plane *plane);
 
+/**
+ * sde_plane_set_reg_dma_batch - collect the sspp writes of a plane in a batch
+ * @plane: Pointer to drm plane structure
+ * @batch: Pointer to the reg dma batch, or NULL to write through the cpu
+ */
+void sde_plane_set_reg_dma_batch(struct drm_plane *plane,
+		struct sde_reg_dma_batch *batch);
+
 /**
  * sde_plane_flush - final plane operations before commit flush
  * @plane: Pointer to drm plane structure
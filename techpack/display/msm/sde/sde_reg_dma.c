@@ -13,6 +13,13 @@
 #define REG_DMA_VER_1_2 0x00010002
 #define REG_DMA_VER_2_0 0x00020000
 
+/* reg dma addresses the mdss block with a 20 bit offset */
+#define REG_DMA_BATCH_MAX_OFF (BIT(20) - 1)
+
+/* worst case of one decode select and one single write per register */
+#define REG_DMA_BATCH_BUF_SZ \
+	(sizeof(u32) * (2 + 2 * SDE_REG_DMA_BATCH_MAX_WRITES))
+
 static int default_check_support(enum sde_reg_dma_features feature,
 		     enum sde_reg_dma_blk blk,
 		     bool *is_supported)
@@ -144,6 +151,187 @@ struct sde_hw_reg_dma_ops *sde_reg_dma_get_ops(void)
 	return &reg_dma.ops;
 }
 
+struct sde_reg_dma_batch *sde_reg_dma_batch_alloc(void)
+{
+	struct sde_reg_dma_batch *batch;
+	bool supported = false;
+	int rc;
+
+	rc = reg_dma.ops.check_support(BLK_CFG, MDSS, &supported);
+	if (rc || !supported)
+		return NULL;
+
+	batch = kvzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return NULL;
+
+	batch->buf = reg_dma.ops.alloc_reg_dma_buf(REG_DMA_BATCH_BUF_SZ);
+	if (IS_ERR_OR_NULL(batch->buf)) {
+		DRM_DEBUG("failed to allocate batch buffer\n");
+		kvfree(batch);
+		return NULL;
+	}
+
+	return batch;
+}
+
+void sde_reg_dma_batch_free(struct sde_reg_dma_batch *batch)
+{
+	if (!batch)
+		return;
+
+	reg_dma.ops.dealloc_reg_dma(batch->buf);
+	kvfree(batch);
+}
+
+void sde_reg_dma_batch_begin(struct sde_reg_dma_batch *batch,
+		void __iomem *base)
+{
+	if (!batch || !base)
+		return;
+
+	batch->base = base;
+	batch->count = 0;
+	batch->active = true;
+}
+
+static void _sde_reg_dma_batch_write_out(struct sde_reg_dma_batch *batch)
+{
+	u32 i;
+
+	for (i = 0; i < batch->count; i++)
+		writel_relaxed(batch->val[i], batch->base + batch->off[i]);
+
+	batch->count = 0;
+	batch->fallback++;
+}
+
+bool sde_reg_dma_batch_write(struct sde_reg_dma_batch *batch, u32 off,
+		u32 val)
+{
+	if (!batch->active || off > REG_DMA_BATCH_MAX_OFF)
+		return false;
+
+	/* keep the write order across the switch to cpu writes */
+	if (batch->count == SDE_REG_DMA_BATCH_MAX_WRITES) {
+		_sde_reg_dma_batch_write_out(batch);
+		batch->active = false;
+		return false;
+	}
+
+	batch->off[batch->count] = off;
+	batch->val[batch->count] = val;
+	batch->count++;
+
+	return true;
+}
+
+bool sde_reg_dma_batch_read(struct sde_reg_dma_batch *batch, u32 off,
+		u32 *val)
+{
+	u32 i;
+
+	if (!batch->active)
+		return false;
+
+	for (i = batch->count; i > 0; i--) {
+		if (batch->off[i - 1] == off) {
+			*val = batch->val[i - 1];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int _sde_reg_dma_batch_encode(struct sde_reg_dma_batch *batch)
+{
+	struct sde_reg_dma_setup_ops_cfg cfg;
+	u32 i, j;
+	int rc;
+
+	rc = reg_dma.ops.reset_reg_dma_buf(batch->buf);
+	if (rc)
+		return rc;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.blk = MDSS;
+	cfg.feature = BLK_CFG;
+	cfg.dma_buf = batch->buf;
+	cfg.ops = HW_BLK_SELECT;
+	rc = reg_dma.ops.setup_payload(&cfg);
+	if (rc)
+		return rc;
+
+	/* registers written back to back go out as one auto increment write */
+	for (i = 0; i < batch->count; i = j) {
+		for (j = i + 1; j < batch->count &&
+				batch->off[j] == batch->off[j - 1] +
+				sizeof(u32); j++)
+			;
+
+		cfg.ops = (j - i > 1) ? REG_BLK_WRITE_SINGLE :
+				REG_SINGLE_WRITE;
+		cfg.blk_offset = batch->off[i];
+		cfg.data = &batch->val[i];
+		cfg.data_size = (j - i) * sizeof(u32);
+		rc = reg_dma.ops.setup_payload(&cfg);
+		if (rc)
+			return rc;
+	}
+
+	return 0;
+}
+
+int sde_reg_dma_batch_submit(struct sde_reg_dma_batch *batch,
+		struct sde_hw_ctl *ctl)
+{
+	struct sde_reg_dma_kickoff_cfg kick_off;
+	int rc;
+
+	if (!batch || !batch->active)
+		return 0;
+
+	batch->active = false;
+	if (!batch->count)
+		return 0;
+
+	rc = ctl ? _sde_reg_dma_batch_encode(batch) : -EINVAL;
+	if (!rc) {
+		memset(&kick_off, 0, sizeof(kick_off));
+		kick_off.ctl = ctl;
+		kick_off.op = REG_DMA_WRITE;
+		kick_off.dma_buf = batch->buf;
+		kick_off.trigger_mode = WRITE_TRIGGER;
+		kick_off.queue_select = DMA_CTL_QUEUE0;
+		kick_off.dma_type = REG_DMA_TYPE_DB;
+		kick_off.feature = BLK_CFG;
+		rc = reg_dma.ops.kick_off(&kick_off);
+	}
+
+	SDE_EVT32(batch->count, rc);
+	if (rc) {
+		DRM_DEBUG("batch of %u writes not queued, rc %d\n",
+				batch->count, rc);
+		_sde_reg_dma_batch_write_out(batch);
+		return rc;
+	}
+
+	batch->count = 0;
+	batch->submitted++;
+
+	return 0;
+}
+
+void sde_reg_dma_batch_discard(struct sde_reg_dma_batch *batch)
+{
+	if (!batch)
+		return;
+
+	batch->active = false;
+	batch->count = 0;
+}
+
 void sde_reg_dma_deinit(void)
 {
 	if (!reg_dma.drm_dev || !reg_dma.caps)
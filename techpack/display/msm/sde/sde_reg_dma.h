@@ -61,6 +61,7 @@ enum sde_reg_dma_read_sel {
  * @LTM_VLUT: LTM VLUT
  * @RC_DATA: Rounded corner data
  * @DEMURA_CFG: Demura feature
+ * @BLK_CFG: per commit sspp and layer mixer programming
  * @REG_DMA_FEATURES_MAX: invalid selection
  */
 enum sde_reg_dma_features {
@@ -83,6 +84,7 @@ enum sde_reg_dma_features {
 	LTM_VLUT,
 	RC_DATA,
 	DEMURA_CFG,
+	BLK_CFG,
 	REG_DMA_FEATURES_MAX,
 };
 
@@ -358,6 +360,91 @@ struct sde_hw_reg_dma {
 	void __iomem *addr;
 };
 
+/* register writes a single batch can hold */
+#define SDE_REG_DMA_BATCH_MAX_WRITES 1024
+
+/**
+ * struct sde_reg_dma_batch - register writes of a commit collected for one
+ *                            reg dma submission
+ * @buf: reg dma buffer the writes are encoded into at submission
+ * @base: mdss register base, for writing the batch out by the cpu
+ * @off: register offsets relative to @base, in write order
+ * @val: values written to @off
+ * @count: number of writes collected
+ * @active: writes are being collected
+ * @submitted: number of batches handed to the reg dma engine
+ * @fallback: number of batches written out by the cpu instead
+ */
+struct sde_reg_dma_batch {
+	struct sde_reg_dma_buffer *buf;
+	void __iomem *base;
+	u32 off[SDE_REG_DMA_BATCH_MAX_WRITES];
+	u32 val[SDE_REG_DMA_BATCH_MAX_WRITES];
+	u32 count;
+	bool active;
+	u32 submitted;
+	u32 fallback;
+};
+
+/**
+ * sde_reg_dma_batch_alloc() - allocate a write batch, if the reg dma engine
+ *                             can program sspp and layer mixer blocks
+ * Returns NULL if batching is not supported on the platform
+ */
+struct sde_reg_dma_batch *sde_reg_dma_batch_alloc(void);
+
+/**
+ * sde_reg_dma_batch_free() - free a write batch
+ * @batch: batch to free
+ */
+void sde_reg_dma_batch_free(struct sde_reg_dma_batch *batch);
+
+/**
+ * sde_reg_dma_batch_begin() - start collecting register writes
+ * @batch: batch to collect into
+ * @base: mdss register base the collected offsets are relative to
+ */
+void sde_reg_dma_batch_begin(struct sde_reg_dma_batch *batch,
+		void __iomem *base);
+
+/**
+ * sde_reg_dma_batch_write() - add a register write to a batch
+ * @batch: batch collecting the writes
+ * @off: register offset relative to the mdss base
+ * @val: value to write
+ * Returns false if the caller has to write the register itself
+ */
+bool sde_reg_dma_batch_write(struct sde_reg_dma_batch *batch, u32 off,
+		u32 val);
+
+/**
+ * sde_reg_dma_batch_read() - look up the pending value of a register
+ * @batch: batch collecting the writes
+ * @off: register offset relative to the mdss base
+ * @val: pointer to the pending value
+ * Returns true if the register has a write pending in the batch
+ */
+bool sde_reg_dma_batch_read(struct sde_reg_dma_batch *batch, u32 off,
+		u32 *val);
+
+/**
+ * sde_reg_dma_batch_submit() - stop collecting and queue the writes on the
+ *                              reg dma queue of a ctl, triggered along with
+ *                              the next reg dma flush of the ctl.  If the
+ *                              writes can't be queued, they are written out
+ *                              by the cpu.
+ * @batch: batch collecting the writes
+ * @ctl: ctl whose flush latches the written registers
+ */
+int sde_reg_dma_batch_submit(struct sde_reg_dma_batch *batch,
+		struct sde_hw_ctl *ctl);
+
+/**
+ * sde_reg_dma_batch_discard() - stop collecting and drop pending writes
+ * @batch: batch collecting the writes
+ */
+void sde_reg_dma_batch_discard(struct sde_reg_dma_batch *batch);
+
 /**
  * sde_reg_dma_init() - function called to initialize reg dma during sde
  *                         drm driver probe. If reg dma is supported by sde
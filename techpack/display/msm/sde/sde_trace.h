@@ -390,6 +390,40 @@ TRACE_EVENT(sde_perf_uidle_status,
 			)
 );
 
+TRACE_EVENT(sde_crtc_frame_timing,
+	TP_PROTO(u32 crtc, u32 seq, s64 prepare_us, s64 kickoff_us,
+			s64 enc_kickoff_us, s64 pp_done_us, s64 retire_us),
+	TP_ARGS(crtc, seq, prepare_us, kickoff_us, enc_kickoff_us,
+			pp_done_us, retire_us),
+	TP_STRUCT__entry(
+			__field(u32, crtc)
+			__field(u32, seq)
+			__field(s64, prepare_us)
+			__field(s64, kickoff_us)
+			__field(s64, enc_kickoff_us)
+			__field(s64, pp_done_us)
+			__field(s64, retire_us)
+	),
+	TP_fast_assign(
+			__entry->crtc = crtc;
+			__entry->seq = seq;
+			__entry->prepare_us = prepare_us;
+			__entry->kickoff_us = kickoff_us;
+			__entry->enc_kickoff_us = enc_kickoff_us;
+			__entry->pp_done_us = pp_done_us;
+			__entry->retire_us = retire_us;
+	),
+	TP_printk(
+		"crtc=%u seq=%u prepare=%lld kickoff=%lld enc_kickoff=%lld pp_done=%lld retire=%lld",
+			__entry->crtc,
+			__entry->seq,
+			__entry->prepare_us,
+			__entry->kickoff_us,
+			__entry->enc_kickoff_us,
+			__entry->pp_done_us,
+			__entry->retire_us)
+);
+
 #define sde_atrace trace_tracing_mark_write
 
 #define SDE_ATRACE_END(name) sde_atrace('E', current, name, 0)
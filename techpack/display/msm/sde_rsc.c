@@ -472,6 +472,40 @@ static int sde_rsc_resource_enable(struct sde_rsc_priv *rsc)
 	return rc;
 }
 
+/*
+ * The solver mode is a software setting of the rpmh controller, so a vote
+ * for the mode already in place only costs a trip through rpmh.
+ */
+static void sde_rsc_solver_set(struct sde_rsc_priv *rsc, bool enable)
+{
+	if (rsc->solver_mode == enable) {
+		rsc->solver_votes_skipped++;
+		return;
+	}
+
+	rpmh_mode_solver_set(rsc->rpmh_dev, enable);
+	rsc->solver_mode = enable;
+}
+
+static void sde_rsc_lat_record(struct sde_rsc_priv *rsc,
+		enum sde_rsc_state state, ktime_t start)
+{
+	struct sde_rsc_lat_stats *stats;
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int bucket;
+
+	if (state >= SDE_RSC_STATE_MAX || us < 0)
+		return;
+
+	stats = &rsc->lat_stats[state];
+	bucket = min_t(int, fls64(us), SDE_RSC_LAT_BUCKETS - 1);
+	stats->buckets[bucket]++;
+	stats->count++;
+	stats->total_us += us;
+	if (us > stats->max_us)
+		stats->max_us = us;
+}
+
 static int sde_rsc_switch_to_cmd(struct sde_rsc_priv *rsc,
 	struct sde_rsc_cmd_config *config,
 	struct sde_rsc_client *caller_client,
@@ -519,7 +553,7 @@ static int sde_rsc_switch_to_cmd(struct sde_rsc_priv *rsc,
 	if (rsc->hw_ops.state_update) {
 		rc = rsc->hw_ops.state_update(rsc, SDE_RSC_CMD_STATE);
 		if (!rc)
-			rpmh_mode_solver_set(rsc->rpmh_dev, true);
+			sde_rsc_solver_set(rsc, true);
 	}
 
 	/* vsync wait not needed during VID->CMD switch (rev 4+ HW only) */
@@ -579,7 +613,7 @@ static int sde_rsc_switch_to_clk(struct sde_rsc_priv *rsc,
 	if (rsc->hw_ops.state_update) {
 		rc = rsc->hw_ops.state_update(rsc, SDE_RSC_CLK_STATE);
 		if (!rc)
-			rpmh_mode_solver_set(rsc->rpmh_dev, false);
+			sde_rsc_solver_set(rsc, false);
 	}
 
 	/* indicate wait for vsync for cmd/vid to clk state switch */
@@ -666,7 +700,7 @@ static int sde_rsc_switch_to_vid(struct sde_rsc_priv *rsc,
 	if (rsc->hw_ops.state_update) {
 		rc = rsc->hw_ops.state_update(rsc, SDE_RSC_VID_STATE);
 		if (!rc)
-			rpmh_mode_solver_set(rsc->rpmh_dev,
+			sde_rsc_solver_set(rsc,
 				rsc->version >= SDE_RSC_REV_3);
 	}
 
@@ -752,7 +786,7 @@ static int sde_rsc_switch_to_idle(struct sde_rsc_priv *rsc,
 		rc = rsc->hw_ops.state_update(rsc, SDE_RSC_IDLE_STATE);
 		rsc->post_poms = false;
 		if (!rc)
-			rpmh_mode_solver_set(rsc->rpmh_dev, true);
+			sde_rsc_solver_set(rsc, true);
 	}
 
 	return rc;
@@ -880,6 +914,7 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 {
 	int rc = 0;
 	struct sde_rsc_priv *rsc;
+	ktime_t start;
 
 	if (!caller_client) {
 		pr_err("invalid client for rsc state update\n");
@@ -927,6 +962,7 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 		goto end;
 	}
 
+	start = ktime_get();
 	if (rsc->current_state == SDE_RSC_IDLE_STATE)
 		sde_rsc_resource_enable(rsc);
 
@@ -982,6 +1018,8 @@ int sde_rsc_client_state_update(struct sde_rsc_client *caller_client,
 	SDE_ATRACE_INT("rsc_state", state);
 	SDE_EVT32(caller_client->id, caller_client->current_state,
 			state, rsc->current_state, SDE_EVTLOG_FUNC_EXIT);
+	if (rsc->current_state != state)
+		sde_rsc_lat_record(rsc, state, start);
 	rsc->current_state = state;
 	rsc->update_tcs_content = true;
 
@@ -1182,6 +1220,43 @@ static int _sde_debugfs_status_open(struct inode *inode, struct file *file)
 	return single_open(file, _sde_debugfs_status_show, inode->i_private);
 }
 
+static int _sde_debugfs_latency_show(struct seq_file *s, void *data)
+{
+	static const char * const state_names[SDE_RSC_STATE_MAX] = {
+		[SDE_RSC_IDLE_STATE] = "idle",
+		[SDE_RSC_CLK_STATE] = "clk",
+		[SDE_RSC_CMD_STATE] = "cmd",
+		[SDE_RSC_VID_STATE] = "vid",
+	};
+	struct sde_rsc_priv *rsc = s->private;
+	struct sde_rsc_lat_stats *stats;
+	int i, j;
+
+	if (!rsc)
+		return -EINVAL;
+
+	mutex_lock(&rsc->client_lock);
+	seq_printf(s, "solver votes skipped:%u\n", rsc->solver_votes_skipped);
+	seq_puts(s, "state count avg_us max_us histogram(<2^n us)\n");
+	for (i = 0; i < SDE_RSC_STATE_MAX; i++) {
+		stats = &rsc->lat_stats[i];
+		seq_printf(s, "%s %u %llu %u", state_names[i], stats->count,
+			stats->count ? div_u64(stats->total_us, stats->count) : 0,
+			stats->max_us);
+		for (j = 0; j < SDE_RSC_LAT_BUCKETS; j++)
+			seq_printf(s, " %u", stats->buckets[j]);
+		seq_puts(s, "\n");
+	}
+	mutex_unlock(&rsc->client_lock);
+
+	return 0;
+}
+
+static int _sde_debugfs_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, _sde_debugfs_latency_show, inode->i_private);
+}
+
 static int _sde_debugfs_counters_show(struct seq_file *s, void *data)
 {
 	struct sde_rsc_priv *rsc = s->private;
@@ -1521,6 +1596,13 @@ static const struct file_operations debugfs_status_fops = {
 	.release =	single_release,
 };
 
+static const struct file_operations latency_fops = {
+	.open =		_sde_debugfs_latency_open,
+	.read =		seq_read,
+	.llseek =	seq_lseek,
+	.release =	single_release,
+};
+
 static const struct file_operations mode_control_fops = {
 	.open =		_sde_debugfs_generic_noseek_open,
 	.read =		_sde_debugfs_mode_ctrl_read,
@@ -1557,6 +1639,8 @@ static void _sde_rsc_init_debugfs(struct sde_rsc_priv *rsc, char *name)
 							&debugfs_status_fops);
 	debugfs_create_file("mode_control", 0600, rsc->debugfs_root, rsc,
 							&mode_control_fops);
+	debugfs_create_file("transition_latency", 0400, rsc->debugfs_root,
+							rsc, &latency_fops);
 	debugfs_create_file("vsync_mode", 0600, rsc->debugfs_root, rsc,
 							&vsync_status_fops);
 	if (rsc->profiling_supp) {
@@ -1774,6 +1858,7 @@ static int sde_rsc_probe(struct platform_device *pdev)
 	mutex_init(&rsc->client_lock);
 	init_waitqueue_head(&rsc->rsc_vsync_waitq);
 	atomic_set(&rsc->resource_refcount, 0);
+	rsc->solver_mode = -1;
 
 	pr_info("sde rsc index:%d probed successfully\n",
 				SDE_RSC_INDEX + counter);
@@ -29,6 +29,9 @@
 #define SDE_RSC_REV_3			0x3
 #define SDE_RSC_REV_4			0x4
 
+#define SDE_RSC_STATE_MAX		(SDE_RSC_VID_STATE + 1)
+#define SDE_RSC_LAT_BUCKETS		12
+
 #define SDE_RSC_HW_MAJOR_MINOR_STEP(major, minor, step) \
 	(((major & 0xff) << 16) |\
 	((minor & 0xff) << 8) | \
@@ -147,6 +150,22 @@ struct sde_rsc_bw_config {
 	u64	new_ab_vote[SDE_POWER_HANDLE_DBUS_ID_MAX];
 	u64	new_ib_vote[SDE_POWER_HANDLE_DBUS_ID_MAX];
 };
+/**
+ * struct sde_rsc_lat_stats: state transition latency for one target state
+ *
+ * @count:	number of completed transitions into the state
+ * @total_us:	sum of all transition times in micro seconds
+ * @max_us:	longest transition time in micro seconds
+ * @buckets:	log2 histogram of transition times, bucket n counts
+ *		transitions shorter than 2^n micro seconds
+ */
+struct sde_rsc_lat_stats {
+	u32 count;
+	u64 total_us;
+	u32 max_us;
+	u32 buckets[SDE_RSC_LAT_BUCKETS];
+};
+
 /**
  * struct sde_rsc_priv: sde resource state coordinator(rsc) private handle
  * @version:		rsc sequence version
@@ -194,6 +213,9 @@ struct sde_rsc_bw_config {
  * profiling_supp:	Indicates if HW has support for profiling counters
  * profiling_en:	Flag for rsc lpm profiling counters, true=enabled
  * post_poms:		bool if a panel mode change occurred
+ * solver_mode:		last rpmh solver mode vote, -1 until the first vote
+ * solver_votes_skipped: solver votes dropped because the mode was unchanged
+ * lat_stats:		state transition latency, indexed by target state
  */
 struct sde_rsc_priv {
 	u32 version;
@@ -239,6 +261,10 @@ struct sde_rsc_priv {
 	bool profiling_en;
 
 	bool post_poms;
+
+	int solver_mode;
+	u32 solver_votes_skipped;
+	struct sde_rsc_lat_stats lat_stats[SDE_RSC_STATE_MAX];
 };
 
 /**
@@ -9,6 +9,17 @@
 #include "msm_vidc_debug.h"
 #include "msm_vidc_resources.h"
 
+/* Internal buffers released by a session stay mapped this long */
+#define MSM_VIDC_BUF_POOL_IDLE_MS 5000
+#define MSM_VIDC_BUF_POOL_MAX_BYTES SZ_128M
+
+struct msm_vidc_pool_buf {
+	struct list_head list;
+	struct msm_smem smem;
+	u32 session_type;
+	unsigned long released;
+};
+
 static int msm_dma_get_device_address(struct dma_buf *dbuf, unsigned long align,
 	dma_addr_t *iova, unsigned long *buffer_size,
 	unsigned long flags, enum hal_buffer buffer_type,
@@ -523,6 +534,215 @@ int msm_smem_free(struct msm_smem *smem, u32 sid)
 	return rc;
 };
 
+/*
+ * Decoders that are created and torn down back to back, as in a feed of
+ * autoplaying clips, ask for the same scratch and DPB sizes every time.
+ * Keep the buffers a session releases allocated and mapped in the core,
+ * and hand them to the next session asking for the same type in the same
+ * context bank. Contents are not preserved in any meaningful way: only
+ * types the firmware fully writes before reading are pooled.
+ */
+static bool msm_smem_pool_type(enum hal_buffer buffer_type)
+{
+	switch (buffer_type) {
+	case HAL_BUFFER_OUTPUT:
+	case HAL_BUFFER_OUTPUT2:
+	case HAL_BUFFER_INTERNAL_SCRATCH:
+	case HAL_BUFFER_INTERNAL_SCRATCH_1:
+	case HAL_BUFFER_INTERNAL_SCRATCH_2:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void msm_smem_pool_release(struct msm_vidc_buf_pool *pool,
+	struct msm_vidc_pool_buf *pbuf)
+{
+	list_del(&pbuf->list);
+	pool->count--;
+	pool->bytes -= pbuf->smem.size;
+	free_dma_mem(&pbuf->smem, DEFAULT_SID);
+	kfree(pbuf);
+}
+
+bool msm_smem_pool_get(struct msm_vidc_core *core, size_t size, u32 flags,
+	enum hal_buffer buffer_type, u32 session_type,
+	struct msm_smem *smem)
+{
+	struct msm_vidc_buf_pool *pool;
+	struct msm_vidc_pool_buf *pbuf, *best = NULL;
+
+	if (!core || !smem || !msm_smem_pool_type(buffer_type))
+		return false;
+
+	pool = &core->buf_pool;
+	size = ALIGN(size, SZ_4K);
+
+	/* a size class is anything up to an eighth larger than the request */
+	mutex_lock(&pool->lock);
+	list_for_each_entry(pbuf, &pool->list, list) {
+		if (pbuf->smem.buffer_type != buffer_type ||
+			pbuf->smem.flags != flags ||
+			pbuf->session_type != session_type ||
+			pbuf->smem.size < size ||
+			pbuf->smem.size > size + size / 8)
+			continue;
+		if (!best || pbuf->smem.size < best->smem.size)
+			best = pbuf;
+	}
+
+	if (!best) {
+		pool->misses++;
+		mutex_unlock(&pool->lock);
+		return false;
+	}
+
+	list_del(&best->list);
+	pool->count--;
+	pool->bytes -= best->smem.size;
+	pool->hits++;
+	mutex_unlock(&pool->lock);
+
+	*smem = best->smem;
+	kfree(best);
+
+	d_vpr_h("%s: reuse %#x size %u type %#x\n", __func__,
+		smem->device_addr, smem->size, smem->buffer_type);
+
+	return true;
+}
+
+bool msm_smem_pool_put(struct msm_vidc_core *core, u32 session_type,
+	struct msm_smem *smem)
+{
+	struct msm_vidc_buf_pool *pool;
+	struct msm_vidc_pool_buf *pbuf;
+
+	if (!core || !smem || !smem->dma_buf || !smem->device_addr ||
+		smem->kvaddr || !msm_smem_pool_type(smem->buffer_type))
+		return false;
+
+	pbuf = kzalloc(sizeof(*pbuf), GFP_KERNEL);
+	if (!pbuf)
+		return false;
+
+	pbuf->smem = *smem;
+	pbuf->session_type = session_type;
+	pbuf->released = jiffies;
+
+	pool = &core->buf_pool;
+	mutex_lock(&pool->lock);
+	if (pool->bytes + smem->size > MSM_VIDC_BUF_POOL_MAX_BYTES) {
+		mutex_unlock(&pool->lock);
+		kfree(pbuf);
+		return false;
+	}
+	list_add_tail(&pbuf->list, &pool->list);
+	pool->count++;
+	pool->bytes += smem->size;
+	mutex_unlock(&pool->lock);
+
+	memset(smem, 0, sizeof(*smem));
+	mod_delayed_work(system_wq, &pool->idle_work,
+		msecs_to_jiffies(MSM_VIDC_BUF_POOL_IDLE_MS));
+
+	return true;
+}
+
+static void msm_smem_pool_idle_handler(struct work_struct *work)
+{
+	struct msm_vidc_buf_pool *pool = container_of(to_delayed_work(work),
+		struct msm_vidc_buf_pool, idle_work);
+	struct msm_vidc_pool_buf *pbuf, *next;
+	unsigned long timeout = msecs_to_jiffies(MSM_VIDC_BUF_POOL_IDLE_MS);
+	unsigned long next_expiry = 0;
+
+	mutex_lock(&pool->lock);
+	list_for_each_entry_safe(pbuf, next, &pool->list, list) {
+		if (time_before(jiffies, pbuf->released + timeout)) {
+			next_expiry = pbuf->released + timeout;
+			break;
+		}
+		msm_smem_pool_release(pool, pbuf);
+	}
+	mutex_unlock(&pool->lock);
+
+	if (next_expiry)
+		schedule_delayed_work(&pool->idle_work,
+			next_expiry - jiffies);
+}
+
+static unsigned long msm_smem_pool_count(struct shrinker *shrinker,
+	struct shrink_control *sc)
+{
+	struct msm_vidc_buf_pool *pool = container_of(shrinker,
+		struct msm_vidc_buf_pool, shrinker);
+
+	return READ_ONCE(pool->count);
+}
+
+static unsigned long msm_smem_pool_scan(struct shrinker *shrinker,
+	struct shrink_control *sc)
+{
+	struct msm_vidc_buf_pool *pool = container_of(shrinker,
+		struct msm_vidc_buf_pool, shrinker);
+	struct msm_vidc_pool_buf *pbuf, *next;
+	unsigned long freed = 0;
+
+	if (!mutex_trylock(&pool->lock))
+		return SHRINK_STOP;
+
+	list_for_each_entry_safe(pbuf, next, &pool->list, list) {
+		if (freed >= sc->nr_to_scan)
+			break;
+		msm_smem_pool_release(pool, pbuf);
+		freed++;
+	}
+	mutex_unlock(&pool->lock);
+
+	return freed;
+}
+
+int msm_smem_pool_init(struct msm_vidc_core *core)
+{
+	struct msm_vidc_buf_pool *pool = &core->buf_pool;
+
+	mutex_init(&pool->lock);
+	INIT_LIST_HEAD(&pool->list);
+	INIT_DELAYED_WORK(&pool->idle_work, msm_smem_pool_idle_handler);
+	pool->shrinker.count_objects = msm_smem_pool_count;
+	pool->shrinker.scan_objects = msm_smem_pool_scan;
+	pool->shrinker.seeks = DEFAULT_SEEKS;
+
+	return register_shrinker(&pool->shrinker);
+}
+
+bool msm_smem_pool_drain(struct msm_vidc_core *core)
+{
+	struct msm_vidc_buf_pool *pool = &core->buf_pool;
+	struct msm_vidc_pool_buf *pbuf, *next;
+	bool drained;
+
+	mutex_lock(&pool->lock);
+	drained = !list_empty(&pool->list);
+	list_for_each_entry_safe(pbuf, next, &pool->list, list)
+		msm_smem_pool_release(pool, pbuf);
+	mutex_unlock(&pool->lock);
+
+	return drained;
+}
+
+void msm_smem_pool_deinit(struct msm_vidc_core *core)
+{
+	struct msm_vidc_buf_pool *pool = &core->buf_pool;
+
+	unregister_shrinker(&pool->shrinker);
+	cancel_delayed_work_sync(&pool->idle_work);
+	msm_smem_pool_drain(core);
+	mutex_destroy(&pool->lock);
+}
+
 int msm_smem_cache_operations(struct dma_buf *dbuf,
 	enum smem_cache_ops cache_op, unsigned long offset,
 	unsigned long size, u32 sid)
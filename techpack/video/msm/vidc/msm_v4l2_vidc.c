@@ -553,6 +553,13 @@ static int msm_vidc_probe_vidc_device(struct platform_device *pdev)
 		d_vpr_e("%s: create core workq failed\n", __func__);
 		goto err_core_workq;
 	}
+
+	rc = msm_smem_pool_init(core);
+	if (rc) {
+		d_vpr_e("%s: buffer pool init failed\n", __func__);
+		goto err_buf_pool;
+	}
+
 	mutex_lock(&vidc_driver->lock);
 	list_add_tail(&core->list, &vidc_driver->cores);
 	mutex_unlock(&vidc_driver->lock);
@@ -579,6 +586,8 @@ static int msm_vidc_probe_vidc_device(struct platform_device *pdev)
 	return rc;
 
 err_fail_sub_device_probe:
+	msm_smem_pool_deinit(core);
+err_buf_pool:
 	if (core->vidc_core_workq)
 		destroy_workqueue(core->vidc_core_workq);
 err_core_workq:
@@ -662,6 +671,7 @@ static int msm_vidc_remove(struct platform_device *pdev)
 	video_unregister_device(&core->vdev[MSM_VIDC_DECODER].vdev);
 	v4l2_device_unregister(&core->v4l2_dev);
 
+	msm_smem_pool_deinit(core);
 	msm_vidc_free_platform_resources(&core->resources);
 	sysfs_remove_group(&pdev->dev.kobj, &msm_vidc_core_attr_group);
 	dev_set_drvdata(&pdev->dev, NULL);
@@ -616,19 +616,62 @@ int msm_vidc_get_encoder_internal_buffer_sizes(struct msm_vidc_inst *inst)
 	return 0;
 }
 
+/*
+ * Internal buffers are allocated from the system heap right after their sizes
+ * are known, tell the heap about them so its pools are filled by then.
+ */
+static void msm_vidc_prefill_internal_buffers(struct msm_vidc_inst *inst)
+{
+	struct ion_prefill_hint hints[HAL_BUFFER_MAX];
+	int i, nr_hints = 0, rc;
+
+	if (inst->flags & VIDC_SECURE)
+		return;
+
+	for (i = 0; i < HAL_BUFFER_MAX; i++) {
+		struct hal_buffer_requirements *req = &inst->buff_req.buffer[i];
+
+		if (!is_internal_buffer(req->buffer_type) ||
+			!req->buffer_size || !req->buffer_count_actual)
+			continue;
+		/* encoder persist buffers come from the secure heap */
+		if (req->buffer_type == HAL_BUFFER_INTERNAL_PERSIST &&
+			inst->session_type == MSM_VIDC_ENCODER)
+			continue;
+
+		hints[nr_hints].size = req->buffer_size;
+		hints[nr_hints].count = req->buffer_count_actual;
+		hints[nr_hints].cached = false;
+		nr_hints++;
+	}
+
+	if (!nr_hints)
+		return;
+
+	rc = msm_ion_heap_prefill(ION_SYSTEM_HEAP_ID, hints, nr_hints);
+	if (rc)
+		s_vpr_l(inst->sid, "%s: prefill not done, ret: %d\n",
+			__func__, rc);
+}
+
 int msm_vidc_calculate_internal_buffer_sizes(struct msm_vidc_inst *inst)
 {
+	int rc = 0;
+
 	if (!inst) {
 		d_vpr_e("%s: Instance is null!", __func__);
 		return -EINVAL;
 	}
 
 	if (inst->session_type == MSM_VIDC_DECODER)
-		return msm_vidc_get_decoder_internal_buffer_sizes(inst);
+		rc = msm_vidc_get_decoder_internal_buffer_sizes(inst);
 	else if (inst->session_type == MSM_VIDC_ENCODER)
-		return msm_vidc_get_encoder_internal_buffer_sizes(inst);
+		rc = msm_vidc_get_encoder_internal_buffer_sizes(inst);
 
-	return 0;
+	if (!rc)
+		msm_vidc_prefill_internal_buffers(inst);
+
+	return rc;
 }
 
 void msm_vidc_init_buffer_size_calculators(struct msm_vidc_inst *inst)
@@ -183,6 +183,76 @@ static inline bool is_active_session(u64 prev, u64 curr)
 			MSM_VIDC_SESSION_INACTIVE_THRESHOLD_MS);
 }
 
+static void msm_vidc_bw_filter(u32 sample, u32 *avg, u32 *err)
+{
+	u32 delta;
+
+	if (!*avg) {
+		*avg = sample;
+		*err = 0;
+		return;
+	}
+
+	delta = sample > *avg ? sample - *avg : *avg - sample;
+	*err = *err - (*err >> 3) + (delta >> 3);
+	*avg = *avg - (*avg >> 3) + (sample >> 3);
+}
+
+/*
+ * Feed one frame's measured ratios to the closed loop filter, a zero
+ * sample leaves that ratio untouched.
+ */
+void msm_vidc_update_bw_stats(struct msm_vidc_inst *inst,
+	u32 cr, u32 cf, u32 input_cr)
+{
+	struct msm_vidc_bw_stats *stats = &inst->bw_stats;
+
+	mutex_lock(&inst->ubwc_stats_lock);
+	if (cr)
+		msm_vidc_bw_filter(cr, &stats->cr, &stats->cr_err);
+	if (cf)
+		msm_vidc_bw_filter(cf, &stats->cf, &stats->cf_err);
+	if (input_cr)
+		msm_vidc_bw_filter(input_cr, &stats->input_cr,
+			&stats->input_cr_err);
+	stats->samples++;
+	mutex_unlock(&inst->ubwc_stats_lock);
+}
+
+/*
+ * The open loop model votes the worst ratio seen on any reference or input
+ * buffer, and the input list keeps every buffer index the client ever
+ * queued. One bad frame early in a recording then pins DDR for the rest
+ * of it. Vote the smoothed measurement instead, one deviation toward the
+ * worst case, never beyond the open loop value.
+ */
+static void msm_vidc_bw_closed_loop_vote(struct msm_vidc_inst *inst,
+	u32 *cr, u32 *cf, u32 *input_cr)
+{
+	struct msm_vidc_bw_stats *stats = &inst->bw_stats;
+
+	mutex_lock(&inst->ubwc_stats_lock);
+	stats->worst_cr = *cr;
+	stats->worst_cf = *cf;
+	stats->worst_input_cr = *input_cr;
+
+	if (!msm_vidc_bw_closed_loop || !stats->samples)
+		goto unlock;
+
+	if (stats->cr)
+		*cr = clamp_t(u32, stats->cr - min(stats->cr, stats->cr_err),
+			*cr, MSM_VIDC_MAX_UBWC_COMPRESSION_RATIO);
+	if (stats->cf)
+		*cf = clamp_t(u32, stats->cf + stats->cf_err,
+			MSM_VIDC_MIN_UBWC_COMPLEXITY_FACTOR, *cf);
+	if (stats->input_cr)
+		*input_cr = clamp_t(u32, stats->input_cr -
+			min(stats->input_cr, stats->input_cr_err),
+			*input_cr, MSM_VIDC_MAX_UBWC_COMPRESSION_RATIO);
+unlock:
+	mutex_unlock(&inst->ubwc_stats_lock);
+}
+
 void update_recon_stats(struct msm_vidc_inst *inst,
 	struct recon_stats_type *recon_stats)
 {
@@ -207,6 +277,7 @@ void update_recon_stats(struct msm_vidc_inst *inst,
 		CF = recon_stats->complexity_number / frame_size;
 	else
 		CF = MSM_VIDC_MAX_UBWC_COMPLEXITY_FACTOR;
+	msm_vidc_update_bw_stats(inst, CR, CF, 0);
 	mutex_lock(&inst->refbufs.lock);
 	list_for_each_entry(binfo, &inst->refbufs.list, list) {
 		if (binfo->buffer_index ==
@@ -273,6 +344,8 @@ static int fill_dynamic_stats(struct msm_vidc_inst *inst,
 	min_input_cr = max_t(u32,
 		min_input_cr, MSM_VIDC_MIN_UBWC_COMPRESSION_RATIO);
 
+	msm_vidc_bw_closed_loop_vote(inst, &min_cr, &max_cf, &min_input_cr);
+
 	vote_data->compression_ratio = min_cr;
 	vote_data->complexity_factor = max_cf;
 	vote_data->input_cr = min_input_cr;
@@ -590,6 +663,9 @@ void msm_comm_update_input_cr(struct msm_vidc_inst *inst,
 	}
 exit:
 	mutex_unlock(&inst->input_crs.lock);
+
+	if (cr)
+		msm_vidc_update_bw_stats(inst, 0, 0, cr);
 }
 
 static unsigned long msm_vidc_calc_freq_ar50_lt(struct msm_vidc_inst *inst,
@@ -928,13 +1004,102 @@ int msm_vidc_set_clocks(struct msm_vidc_core *core, u32 sid)
 	return rc;
 }
 
+/*
+ * Decoder bitstream size varies frame to frame: intra frames are several
+ * times larger than the inter frames around them. Sizing the vote on the
+ * largest buffer with the firmware keeps the clock up for every P/B frame
+ * queued behind an I frame. Vote on the running average of inter frame
+ * sizes instead, and spread the excess of an intra frame over the frames
+ * the firmware holds, which is the cushion the pipeline has to absorb it.
+ */
+static u32 msm_dcvs_frame_bytes(struct msm_vidc_inst *inst,
+		u32 curr_len, bool curr_intra, u32 pending)
+{
+	struct clock_data *dcvs = &inst->clk_data;
+	u32 avg = dcvs->frame_bytes_avg;
+	u64 bytes;
+
+	if (!dcvs->frame_corr)
+		dcvs->frame_corr = DCVS_DEC_CORR_DEF;
+
+	if (curr_len && !curr_intra && avg &&
+			curr_len > avg * DCVS_DEC_INTRA_RATIO)
+		curr_intra = true;
+
+	if (curr_len && !curr_intra) {
+		avg = avg ? avg - (avg >> 3) + (curr_len >> 3) : curr_len;
+		dcvs->frame_bytes_avg = avg;
+	}
+
+	if (!avg)
+		bytes = curr_len;
+	else if (curr_intra)
+		bytes = avg + (curr_len - min(curr_len, avg)) /
+			max_t(u32, pending, 1);
+	else
+		bytes = max(avg, curr_len);
+
+	bytes = div_u64(bytes * dcvs->frame_corr, 100);
+
+	s_vpr_p(inst->sid,
+		"DCVS: frame len %u intra %d pending %u avg %u corr %u -> %llu\n",
+		curr_len, curr_intra, pending, avg, dcvs->frame_corr, bytes);
+
+	return (u32)bytes;
+}
+
+/*
+ * History correction for msm_dcvs_frame_bytes(). The time the firmware
+ * spends on each input, from the later of its ETB and the previous EBD,
+ * is compared against the frame period. Consistently close to the period
+ * means the estimate is low for this stream, well under it means the clock
+ * has headroom.
+ */
+void msm_dcvs_frame_done(struct msm_vidc_inst *inst,
+		struct msm_vidc_buffer *mbuf)
+{
+	struct clock_data *dcvs;
+	u64 now, start, svc, period;
+	int fps;
+
+	if (!inst || !mbuf || !is_decode_session(inst))
+		return;
+
+	dcvs = &inst->clk_data;
+	now = ktime_get_ns();
+	if (!mbuf->etb_ns || !dcvs->dcvs_mode)
+		goto exit;
+
+	fps = msm_vidc_get_fps(inst);
+	if (fps <= 0 || !dcvs->frame_corr)
+		goto exit;
+
+	start = max(mbuf->etb_ns, dcvs->last_ebd_ns);
+	svc = now > start ? now - start : 0;
+	dcvs->frame_svc_ns = dcvs->frame_svc_ns ?
+		dcvs->frame_svc_ns - (dcvs->frame_svc_ns >> 3) + (svc >> 3) :
+		svc;
+
+	period = div_u64(NSEC_PER_SEC, fps);
+	if (dcvs->frame_svc_ns * 100 > period * DCVS_DEC_SVC_HIGH)
+		dcvs->frame_corr = min_t(u32, DCVS_DEC_CORR_MAX,
+			dcvs->frame_corr + DCVS_DEC_CORR_STEP);
+	else if (dcvs->frame_svc_ns * 100 < period * DCVS_DEC_SVC_LOW)
+		dcvs->frame_corr = max_t(u32, DCVS_DEC_CORR_MIN,
+			dcvs->frame_corr - DCVS_DEC_CORR_STEP);
+
+exit:
+	dcvs->last_ebd_ns = now;
+	mbuf->etb_ns = 0;
+}
+
 int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 {
 	struct msm_vidc_buffer *temp, *next;
 	unsigned long freq = 0;
-	u32 filled_len = 0;
+	u32 filled_len = 0, curr_len = 0, pending = 0;
 	u32 device_addr = 0;
-	bool is_turbo = false;
+	bool is_turbo = false, curr_intra = false;
 
 	if (!inst || !inst->core) {
 		d_vpr_e("%s: Invalid args: Inst = %pK\n", __func__, inst);
@@ -949,6 +1114,14 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 			if (temp->vvb.flags & V4L2_BUF_FLAG_PERF_MODE)
 				is_turbo = true;
 			device_addr = temp->smem[0].device_addr;
+			/* the one about to be queued is not with fw yet */
+			if (temp->flags & MSM_VIDC_FLAG_QUEUED) {
+				pending++;
+			} else {
+				curr_len = temp->vvb.vb2_buf.planes[0].bytesused;
+				curr_intra = !!(temp->vvb.flags &
+					V4L2_BUF_FLAG_KEYFRAME);
+			}
 		}
 	}
 	mutex_unlock(&inst->registeredbufs.lock);
@@ -967,6 +1140,9 @@ int msm_comm_scale_clocks(struct msm_vidc_inst *inst)
 		inst->clk_data.min_freq = msm_vidc_clock_voting;
 		inst->clk_data.dcvs_flags = 0;
 	} else {
+		if (is_decode_session(inst) && inst->clk_data.dcvs_mode)
+			filled_len = msm_dcvs_frame_bytes(inst, curr_len,
+				curr_intra, pending);
 		freq = call_core_op(inst->core, calc_freq, inst, filled_len);
 		inst->clk_data.min_freq = freq;
 		msm_dcvs_scale_clocks(inst, freq);
@@ -1073,6 +1249,10 @@ void msm_dcvs_reset(struct msm_vidc_inst *inst)
 		(dcvs->dcvs_window / 2) : 0);
 
 	dcvs->dcvs_flags = 0;
+	dcvs->frame_bytes_avg = 0;
+	dcvs->frame_corr = DCVS_DEC_CORR_DEF;
+	dcvs->frame_svc_ns = 0;
+	dcvs->last_ebd_ns = 0;
 
 	s_vpr_p(inst->sid, "DCVS: Th[%d %d %d] Flag %#x\n",
 		dcvs->min_threshold,
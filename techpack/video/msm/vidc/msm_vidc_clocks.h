@@ -33,6 +33,8 @@ void msm_print_core_status(struct msm_vidc_core *core, u32 core_id, u32 sid);
 void msm_comm_free_input_cr_table(struct msm_vidc_inst *inst);
 void msm_comm_update_input_cr(struct msm_vidc_inst *inst, u32 index,
 	u32 cr);
+void msm_vidc_update_bw_stats(struct msm_vidc_inst *inst,
+	u32 cr, u32 cf, u32 input_cr);
 void update_recon_stats(struct msm_vidc_inst *inst,
 	struct recon_stats_type *recon_stats);
 void msm_vidc_init_core_clk_ops(struct msm_vidc_core *core);
@@ -42,4 +44,6 @@ bool res_is_less_than(u32 width, u32 height,
 		u32 ref_width, u32 ref_height);
 int msm_vidc_set_bse_vpp_delay(struct msm_vidc_inst *inst);
 bool is_vpp_delay_allowed(struct msm_vidc_inst *inst);
+void msm_dcvs_frame_done(struct msm_vidc_inst *inst,
+	struct msm_vidc_buffer *mbuf);
 #endif
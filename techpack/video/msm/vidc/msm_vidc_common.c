@@ -3,6 +3,8 @@
  * Copyright (c) 2012-2021, The Linux Foundation. All rights reserved.
  */
 
+#include <linux/dma-buf.h>
+#include <linux/dma-resv.h>
 #include <soc/qcom/subsystem_restart.h>
 #include "msm_vidc_common.h"
 #include "vidc_hfi_api.h"
@@ -31,6 +33,7 @@ static void msm_vidc_print_running_insts(struct msm_vidc_core *core);
 #define SSR_SUB_CLIENT_ID_SHIFT 4
 #define SSR_ADDR_ID 0xFFFFFFFF00000000
 #define SSR_ADDR_SHIFT 32
+#define INPUT_FENCE_TIMEOUT_MS 100
 
 int msm_comm_g_ctrl_for_id(struct msm_vidc_inst *inst, int id)
 {
@@ -2510,6 +2513,7 @@ static void handle_ebd(enum hal_command_response cmd, void *data)
 		vb->planes[1].bytesused = vb->planes[1].length;
 
 	update_recon_stats(inst, &empty_buf_done->recon_stats);
+	msm_dcvs_frame_done(inst, mbuf);
 	inst->clk_data.buffer_counter++;
 	/*
 	 * dma cache operations need to be performed before dma_unmap
@@ -2706,6 +2710,12 @@ static void handle_fbd(enum hal_command_response cmd, void *data)
 		if (frame_size)
 			inst->ubwc_stats.worst_cf /= frame_size;
 		mutex_unlock(&inst->ubwc_stats_lock);
+
+		if (fill_buf_done->ubwc_cr_stat.is_valid)
+			msm_vidc_update_bw_stats(inst,
+				inst->ubwc_stats.worst_cr,
+				inst->ubwc_stats.worst_cf,
+				inst->ubwc_stats.worst_cr);
 	}
 
 	/*
@@ -4530,8 +4540,10 @@ static int msm_comm_qbuf_to_hfi(struct msm_vidc_inst *inst,
 	msm_vidc_debugfs_update(inst, e);
 
 	if (mbuf->vvb.vb2_buf.type == INPUT_MPLANE &&
-			is_decode_session(inst))
+			is_decode_session(inst)) {
+		mbuf->etb_ns = ktime_get_ns();
 		rc = msm_comm_check_window_bitrate(inst, &frame_data);
+	}
 
 err_bad_input:
 	return rc;
@@ -4718,6 +4730,35 @@ static int msm_comm_qbuf_in_rbr(struct msm_vidc_inst *inst,
 	return rc;
 }
 
+/*
+ * Encoder input written by another device, e.g. a display writeback, carries
+ * the producer's fence in the dma-buf reservation object. Wait for it so the
+ * buffer can be queued before the producer has finished with it.
+ */
+static int msm_comm_wait_input_fence(struct msm_vidc_inst *inst,
+		struct msm_vidc_buffer *mbuf)
+{
+	struct dma_buf *dbuf;
+	long rc;
+
+	if (!is_encode_session(inst) ||
+			mbuf->vvb.vb2_buf.type != INPUT_MPLANE)
+		return 0;
+
+	dbuf = (struct dma_buf *)mbuf->smem[0].dma_buf;
+	if (!dbuf || !dbuf->resv)
+		return 0;
+
+	rc = dma_resv_wait_timeout_rcu(dbuf->resv, false, true,
+			msecs_to_jiffies(INPUT_FENCE_TIMEOUT_MS));
+	if (!rc) {
+		s_vpr_e(inst->sid, "%s: input fence timeout\n", __func__);
+		return -ETIMEDOUT;
+	}
+
+	return rc < 0 ? rc : 0;
+}
+
 int msm_comm_qbuf(struct msm_vidc_inst *inst, struct msm_vidc_buffer *mbuf)
 {
 	int rc = 0;
@@ -4745,6 +4786,11 @@ int msm_comm_qbuf(struct msm_vidc_inst *inst, struct msm_vidc_buffer *mbuf)
 	if (rc)
 		s_vpr_e(inst->sid, "%s: scale clock & bw failed\n", __func__);
 
+	/* a late producer costs a frame, not the whole session */
+	if (msm_comm_wait_input_fence(inst, mbuf))
+		print_vidc_buffer(VIDC_ERR, "input fence wait failed",
+			inst, mbuf);
+
 	print_vidc_buffer(VIDC_HIGH|VIDC_PERF, "qbuf", inst, mbuf);
 	ctrl = get_ctrl(inst, V4L2_CID_MPEG_VIDC_SUPERFRAME);
 	if (ctrl->val)
@@ -6339,9 +6385,17 @@ int msm_comm_smem_alloc(struct msm_vidc_inst *inst,
 		d_vpr_e("%s: invalid inst: %pK\n", __func__, inst);
 		return -EINVAL;
 	}
+	if (!map_kernel && msm_smem_pool_get(inst->core, size, flags,
+			buffer_type, inst->session_type, smem))
+		return 0;
 	rc = msm_smem_alloc(size, align, flags, buffer_type, map_kernel,
 				&(inst->core->resources), inst->session_type,
 				smem, inst->sid);
+	/* pooled buffers may be what is holding the heap, secure ones often */
+	if (rc == -ENOMEM && msm_smem_pool_drain(inst->core))
+		rc = msm_smem_alloc(size, align, flags, buffer_type,
+				map_kernel, &(inst->core->resources),
+				inst->session_type, smem, inst->sid);
 	return rc;
 }
 
@@ -6352,6 +6406,8 @@ void msm_comm_smem_free(struct msm_vidc_inst *inst, struct msm_smem *mem)
 			__func__, inst, mem);
 		return;
 	}
+	if (msm_smem_pool_put(inst->core, inst->session_type, mem))
+		return;
 	msm_smem_free(mem, inst->sid);
 }
 
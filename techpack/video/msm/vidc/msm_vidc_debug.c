@@ -24,6 +24,7 @@ bool msm_vidc_syscache_disable = !true;
 bool msm_vidc_cvp_usage = true;
 int msm_vidc_err_recovery_disable = !1;
 int msm_vidc_vpp_delay;
+bool msm_vidc_bw_closed_loop = true;
 
 #define MAX_DBG_BUF_SIZE 4096
 
@@ -243,7 +244,8 @@ struct dentry *msm_vidc_debugfs_init_drv(void)
 			&msm_vidc_lossless_encode) &&
 	__debugfs_create(u32, "disable_err_recovery",
 			&msm_vidc_err_recovery_disable) &&
-	__debugfs_create(u32, "vpp_delay", &msm_vidc_vpp_delay);
+	__debugfs_create(u32, "vpp_delay", &msm_vidc_vpp_delay) &&
+	__debugfs_create(bool, "bw_closed_loop", &msm_vidc_bw_closed_loop);
 
 #undef __debugfs_create
 
@@ -446,6 +448,23 @@ static ssize_t inst_info_read(struct file *file, char __user *buf,
 	cur += write_str(cur, end - cur, "EBD Count: %d\n", inst->count.ebd);
 	cur += write_str(cur, end - cur, "FTB Count: %d\n", inst->count.ftb);
 	cur += write_str(cur, end - cur, "FBD Count: %d\n", inst->count.fbd);
+	cur += write_str(cur, end - cur, "-----------Bandwidth-----------\n");
+	cur += write_str(cur, end - cur, "closed loop: %d samples: %u\n",
+		msm_vidc_bw_closed_loop, inst->bw_stats.samples);
+	cur += write_str(cur, end - cur, "vote ddr: %lu llcc: %lu\n",
+		inst->bus_data.calc_bw_ddr, inst->bus_data.calc_bw_llcc);
+	cur += write_str(cur, end - cur,
+		"recon cr: vote %#x worst %#x avg %#x err %#x\n",
+		inst->bus_data.compression_ratio, inst->bw_stats.worst_cr,
+		inst->bw_stats.cr, inst->bw_stats.cr_err);
+	cur += write_str(cur, end - cur,
+		"recon cf: vote %#x worst %#x avg %#x err %#x\n",
+		inst->bus_data.complexity_factor, inst->bw_stats.worst_cf,
+		inst->bw_stats.cf, inst->bw_stats.cf_err);
+	cur += write_str(cur, end - cur,
+		"input cr: vote %#x worst %#x avg %#x err %#x\n",
+		inst->bus_data.input_cr, inst->bw_stats.worst_input_cr,
+		inst->bw_stats.input_cr, inst->bw_stats.input_cr_err);
 
 	publish_unreleased_reference(inst, &cur, end);
 	len = simple_read_from_buffer(buf, count, ppos,
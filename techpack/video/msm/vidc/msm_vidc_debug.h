@@ -102,6 +102,7 @@ extern bool msm_vidc_lossless_encode;
 extern bool msm_vidc_cvp_usage;
 extern int msm_vidc_err_recovery_disable;
 extern int msm_vidc_vpp_delay;
+extern bool msm_vidc_bw_closed_loop;
 
 #define dprintk(__level, sid, __fmt, ...)	\
 	do { \
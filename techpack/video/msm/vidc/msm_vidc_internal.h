@@ -14,6 +14,7 @@
 #include <media/videobuf2-core.h>
 #include <media/videobuf2-v4l2.h>
 #include <linux/interconnect.h>
+#include <linux/shrinker.h>
 #include "msm_vidc.h"
 #include "vidc/media/msm_media_info.h"
 #include "vidc_hfi_api.h"
@@ -45,6 +46,16 @@
 
 /* Maintains the number of FTB's between each FBD over a window */
 #define DCVS_FTB_WINDOW 16
+/* Decoder input larger than this multiple of the average is an intra frame */
+#define DCVS_DEC_INTRA_RATIO 3
+/* Complexity correction, in percent of the bitstream based estimate */
+#define DCVS_DEC_CORR_DEF 100
+#define DCVS_DEC_CORR_MIN 85
+#define DCVS_DEC_CORR_MAX 150
+#define DCVS_DEC_CORR_STEP 5
+/* Input service time window, in percent of the frame period */
+#define DCVS_DEC_SVC_LOW 60
+#define DCVS_DEC_SVC_HIGH 95
 /* Superframe can have maximum of 32 frames */
 #define VIDC_SUPERFRAME_MAX 32
 #define COLOR_RANGE_UNSPECIFIED (-1)
@@ -167,6 +178,24 @@ struct vidc_input_cr_data {
 	u32 input_cr;
 };
 
+/*
+ * UBWC stats filtered for closed loop bandwidth voting, Q16 like the
+ * samples. *_err is the smoothed deviation of the samples from the
+ * average, worst_* the value the open loop model would have voted.
+ */
+struct msm_vidc_bw_stats {
+	u32 cr;
+	u32 cr_err;
+	u32 cf;
+	u32 cf_err;
+	u32 input_cr;
+	u32 input_cr_err;
+	u32 worst_cr;
+	u32 worst_cf;
+	u32 worst_input_cr;
+	u32 samples;
+};
+
 struct recon_buf {
 	struct list_head list;
 	u32 buffer_index;
@@ -423,6 +452,10 @@ struct clock_data {
 	u32 work_route;
 	u32 dcvs_flags;
 	u32 frame_rate;
+	u32 frame_bytes_avg;
+	u32 frame_corr;
+	u64 frame_svc_ns;
+	u64 last_ebd_ns;
 };
 
 struct vidc_bus_vote_data {
@@ -484,6 +517,28 @@ struct msm_vidc_ssr {
 	u32 test_addr;
 };
 
+/**
+ * struct msm_vidc_buf_pool - internal buffers kept mapped between sessions
+ * @lock: protects @list and the counters
+ * @list: struct msm_vidc_pool_buf, most recently released last
+ * @count: buffers in @list
+ * @bytes: total size of the buffers in @list
+ * @hits: allocations served from the pool
+ * @misses: allocations of a pooled type that went to ion
+ * @idle_work: frees buffers unused for MSM_VIDC_BUF_POOL_IDLE_MS
+ * @shrinker: gives the pool back under memory pressure
+ */
+struct msm_vidc_buf_pool {
+	struct mutex lock;
+	struct list_head list;
+	u32 count;
+	size_t bytes;
+	u32 hits;
+	u32 misses;
+	struct delayed_work idle_work;
+	struct shrinker shrinker;
+};
+
 struct msm_vidc_core {
 	struct list_head list;
 	struct mutex lock;
@@ -509,6 +564,7 @@ struct msm_vidc_core {
 	unsigned long curr_freq;
 	struct msm_vidc_core_ops *core_ops;
 	bool pm_suspended;
+	struct msm_vidc_buf_pool buf_pool;
 };
 
 struct msm_vidc_inst;
@@ -597,6 +653,7 @@ struct msm_vidc_inst {
 	int full_range;
 	struct mutex ubwc_stats_lock;
 	struct msm_vidc_ubwc_stats ubwc_stats;
+	struct msm_vidc_bw_stats bw_stats;
 	u32 bse_vpp_delay;
 	u32 first_reconfig_done;
 	u64 last_qbuf_time_ns;
@@ -643,6 +700,7 @@ struct msm_vidc_buffer {
 	struct msm_smem smem[VIDEO_MAX_PLANES];
 	struct vb2_v4l2_buffer vvb;
 	enum msm_vidc_flags flags;
+	u64 etb_ns;
 };
 
 void msm_comm_handle_thermal_event(void);
@@ -650,6 +708,14 @@ int msm_smem_alloc(size_t size, u32 align, u32 flags,
 	enum hal_buffer buffer_type, int map_kernel,
 	void  *res, u32 session_type, struct msm_smem *smem, u32 sid);
 int msm_smem_free(struct msm_smem *smem, u32 sid);
+int msm_smem_pool_init(struct msm_vidc_core *core);
+void msm_smem_pool_deinit(struct msm_vidc_core *core);
+bool msm_smem_pool_drain(struct msm_vidc_core *core);
+bool msm_smem_pool_get(struct msm_vidc_core *core, size_t size, u32 flags,
+	enum hal_buffer buffer_type, u32 session_type,
+	struct msm_smem *smem);
+bool msm_smem_pool_put(struct msm_vidc_core *core, u32 session_type,
+	struct msm_smem *smem);
 
 struct context_bank_info *msm_smem_get_context_bank(u32 session_type,
 	bool is_secure, struct msm_vidc_platform_resources *res,
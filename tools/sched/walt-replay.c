@@ -0,0 +1,731 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * walt-replay: replay a recorded sched_switch trace through a userspace
+ * model of WALT window accounting, for offline A/B testing of tunables.
+ *
+ * The model follows kernel/sched/walt/walt.c for the parts that decide
+ * the frequency request:
+ *  - busy time per window, scaled by CPU capacity and current frequency
+ *  - task demand from the last sched_ravg_hist_size windows
+ *    (max of average and most recent, the default policy)
+ *  - predicted demand, using either the busy bucket or the EWMA predictor
+ *  - cross-cluster migration fixup of the window busy time
+ *  - per-cluster request from the busiest CPU or top task of the window
+ *
+ * It reads the text output of ftrace (trace or trace_pipe) with at least
+ * the sched_switch event enabled. cpu_frequency events, when present, are
+ * used for frequency scaling; without them all CPUs run at their maximum.
+ *
+ * Usage:
+ *	walt-replay [-w window_ms] [-H hist_size] [-p buckets|ewma]
+ *		    [-c cpus:capacity:max_khz[,...]] [-t] [trace]
+ *
+ * e.g. for a 4+3+1 system:
+ *	walt-replay -w 8 -c 0-3:325:1804800,4-6:828:2419200,7:1024:2841600
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_CPUS		32
+#define MAX_CLUSTERS		8
+#define RAVG_HIST_SIZE_MAX	5
+#define NUM_BUSY_BUCKETS	10
+#define CAPACITY_SCALE		1024
+
+/* Same constants as walt.c */
+#define INC_STEP		8
+#define DEC_STEP		2
+#define CONSISTENT_THRES	16
+#define INC_STEP_BIG		16
+#define NEW_TASK_ACTIVE_TIME	100000000ULL
+#define PRED_EWMA_SHIFT		2
+/* schedutil headroom: request 1.25x the utilization */
+#define FREQ_HEADROOM(x)	((x) + ((x) >> 2))
+
+enum predictor {
+	PRED_BUCKETS,
+	PRED_EWMA,
+};
+
+enum event_type {
+	EV_SWITCH,
+	EV_FREQ,
+	NR_EVENT_TYPES,
+};
+
+static const char * const event_names[NR_EVENT_TYPES] = {
+	"sched_switch", "cpu_frequency",
+};
+
+struct task {
+	int		pid;
+	int		cpu;
+	uint64_t	first_seen;
+	uint64_t	last_win;
+	uint32_t	curr_window;
+	uint32_t	prev_window;
+	uint32_t	sum_history[RAVG_HIST_SIZE_MAX];
+	uint32_t	nr_samples;
+	uint32_t	demand;
+	uint32_t	pred_demand;
+	uint32_t	pred_at_window_start;
+	uint32_t	pred_ewma;
+	uint8_t		busy_buckets[NUM_BUSY_BUCKETS];
+	struct task	*next_dirty;
+	int		dirty;
+};
+
+struct cpu {
+	int		cluster;
+	int		curr_pid;
+	uint64_t	last_ts;
+	uint64_t	curr_runnable_sum;
+	uint64_t	prev_runnable_sum;
+	uint32_t	top_task;
+	unsigned int	cur_freq;
+};
+
+struct cluster {
+	int		first_cpu;
+	unsigned int	capacity;
+	unsigned int	max_freq;
+	uint64_t	req_sum;
+	uint64_t	nr_windows;
+	uint64_t	nr_max_windows;
+};
+
+struct cost {
+	uint64_t	nr;
+	uint64_t	total_ns;
+	uint64_t	max_ns;
+	uint64_t	hist[32];
+};
+
+static uint64_t window = 16000000;
+static unsigned int hist_size = RAVG_HIST_SIZE_MAX;
+static enum predictor predictor = PRED_BUCKETS;
+static int print_timeline;
+
+static struct cpu cpus[MAX_CPUS];
+static struct cluster clusters[MAX_CLUSTERS];
+static int nr_clusters;
+
+static uint64_t window_start;
+static uint64_t window_idx;
+static int started;
+
+static struct task **tasks;
+static size_t tasks_size;
+static size_t nr_tasks;
+static struct task *dirty_list;
+
+static uint64_t nr_pred_samples;
+static uint64_t pred_abs_err;
+static int64_t pred_bias;
+static struct cost costs[NR_EVENT_TYPES];
+
+static void die(const char *msg)
+{
+	fprintf(stderr, "walt-replay: %s\n", msg);
+	exit(1);
+}
+
+/* ------------------------------------------------------------------ */
+/* Task table */
+
+static struct task *task_lookup(int pid, uint64_t ts)
+{
+	size_t i, mask;
+	struct task *t;
+
+	if (nr_tasks * 2 >= tasks_size) {
+		struct task **old = tasks;
+		size_t old_size = tasks_size, j;
+
+		tasks_size = tasks_size ? tasks_size * 2 : 1024;
+		tasks = calloc(tasks_size, sizeof(*tasks));
+		if (!tasks)
+			die("out of memory");
+		for (j = 0; j < old_size; j++) {
+			if (!old[j])
+				continue;
+			i = (unsigned int)old[j]->pid & (tasks_size - 1);
+			while (tasks[i])
+				i = (i + 1) & (tasks_size - 1);
+			tasks[i] = old[j];
+		}
+		free(old);
+	}
+
+	mask = tasks_size - 1;
+	for (i = (unsigned int)pid & mask; tasks[i]; i = (i + 1) & mask)
+		if (tasks[i]->pid == pid)
+			return tasks[i];
+
+	t = calloc(1, sizeof(*t));
+	if (!t)
+		die("out of memory");
+	t->pid = pid;
+	t->cpu = -1;
+	t->first_seen = ts;
+	t->last_win = window_idx;
+	tasks[i] = t;
+	nr_tasks++;
+
+	return t;
+}
+
+/* Catch up with windows the task slept through */
+static void task_sync(struct task *t)
+{
+	if (t->last_win == window_idx)
+		return;
+
+	t->prev_window = t->last_win + 1 == window_idx ? t->curr_window : 0;
+	t->curr_window = 0;
+	t->last_win = window_idx;
+}
+
+/* ------------------------------------------------------------------ */
+/* Predictors, mirroring walt.c */
+
+static int busy_to_bucket(uint32_t runtime)
+{
+	int bidx = (uint64_t)runtime * NUM_BUSY_BUCKETS / window;
+
+	if (bidx > NUM_BUSY_BUCKETS - 1)
+		bidx = NUM_BUSY_BUCKETS - 1;
+
+	return bidx ? bidx : 1;
+}
+
+static void bucket_increase(uint8_t *buckets, int idx)
+{
+	int i, step;
+
+	for (i = 0; i < NUM_BUSY_BUCKETS; i++) {
+		if (idx != i) {
+			buckets[i] = buckets[i] > DEC_STEP ?
+				     buckets[i] - DEC_STEP : 0;
+		} else {
+			step = buckets[i] >= CONSISTENT_THRES ?
+			       INC_STEP_BIG : INC_STEP;
+			buckets[i] = buckets[i] > 255 - step ?
+				     255 : buckets[i] + step;
+		}
+	}
+}
+
+static uint32_t get_pred_busy(struct task *t, uint64_t ts, int start,
+			      uint32_t runtime)
+{
+	int i, first = NUM_BUSY_BUCKETS, final;
+	uint32_t dmin, dmax, ret = runtime;
+
+	if (ts - t->first_seen < NEW_TASK_ACTIVE_TIME)
+		return runtime;
+
+	for (i = start; i < NUM_BUSY_BUCKETS; i++) {
+		if (t->busy_buckets[i]) {
+			first = i;
+			break;
+		}
+	}
+	if (first >= NUM_BUSY_BUCKETS)
+		return runtime;
+
+	final = first;
+	if (final < 2) {
+		dmin = 0;
+		final = 1;
+	} else {
+		dmin = (uint64_t)final * window / NUM_BUSY_BUCKETS;
+	}
+	dmax = (uint64_t)(final + 1) * window / NUM_BUSY_BUCKETS;
+
+	for (i = 0; i < (int)hist_size; i++) {
+		if (t->sum_history[i] >= dmin && t->sum_history[i] < dmax) {
+			ret = t->sum_history[i];
+			break;
+		}
+	}
+	if (ret < dmin)
+		ret = (dmin + dmax) / 2;
+
+	return ret > runtime ? ret : runtime;
+}
+
+static uint32_t predictor_update(struct task *t, uint64_t ts,
+				 uint32_t runtime)
+{
+	uint32_t pred;
+	int bidx;
+
+	switch (predictor) {
+	case PRED_EWMA:
+		t->pred_ewma += ((int64_t)runtime - t->pred_ewma) /
+				(1 << PRED_EWMA_SHIFT);
+		return runtime > t->pred_ewma ? runtime : t->pred_ewma;
+	case PRED_BUCKETS:
+	default:
+		bidx = busy_to_bucket(runtime);
+		pred = get_pred_busy(t, ts, bidx, runtime);
+		bucket_increase(t->busy_buckets, bidx);
+		return pred;
+	}
+}
+
+static uint32_t predictor_pred_busy(struct task *t, uint64_t ts,
+				    uint32_t curr_window)
+{
+	if (predictor == PRED_EWMA)
+		return curr_window;
+
+	return get_pred_busy(t, ts, busy_to_bucket(curr_window), curr_window);
+}
+
+/* ------------------------------------------------------------------ */
+/* Window accounting */
+
+static void update_history(struct task *t, uint64_t ts, uint32_t runtime)
+{
+	uint64_t sum = 0;
+	uint32_t avg;
+	int i;
+
+	if (t->nr_samples) {
+		int64_t err = (int64_t)t->pred_at_window_start - runtime;
+
+		nr_pred_samples++;
+		pred_bias += err;
+		pred_abs_err += err < 0 ? -err : err;
+	}
+
+	for (i = hist_size - 1; i > 0; i--)
+		t->sum_history[i] = t->sum_history[i - 1];
+	t->sum_history[0] = runtime;
+	for (i = 0; i < (int)hist_size; i++)
+		sum += t->sum_history[i];
+
+	avg = sum / hist_size;
+	t->demand = avg > runtime ? avg : runtime;
+	t->pred_demand = predictor_update(t, ts, runtime);
+	t->pred_at_window_start = t->pred_demand;
+	t->nr_samples++;
+}
+
+static void account_busy(struct cpu *c, uint64_t ts)
+{
+	struct cluster *cl = &clusters[c->cluster];
+	uint64_t delta, scaled;
+	struct task *t;
+
+	if (ts <= c->last_ts)
+		return;
+
+	delta = ts - c->last_ts;
+	c->last_ts = ts;
+	if (!c->curr_pid)
+		return;
+
+	scaled = delta * cl->capacity / CAPACITY_SCALE;
+	if (c->cur_freq && cl->max_freq)
+		scaled = scaled * c->cur_freq / cl->max_freq;
+
+	t = task_lookup(c->curr_pid, ts);
+	task_sync(t);
+	t->curr_window += scaled;
+	c->curr_runnable_sum += scaled;
+
+	if (t->pred_demand < t->curr_window)
+		t->pred_demand = predictor_pred_busy(t, ts, t->curr_window);
+
+	if (!t->dirty) {
+		t->dirty = 1;
+		t->next_dirty = dirty_list;
+		dirty_list = t;
+	}
+}
+
+static void report_window(uint64_t end)
+{
+	int i, cpu;
+
+	for (i = 0; i < nr_clusters; i++) {
+		struct cluster *cl = &clusters[i];
+		uint64_t load = 0, util, req;
+
+		for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+			struct cpu *c = &cpus[cpu];
+			uint64_t l;
+
+			if (c->cluster != i)
+				continue;
+			l = c->prev_runnable_sum > c->top_task ?
+			    c->prev_runnable_sum : c->top_task;
+			if (l > load)
+				load = l;
+		}
+
+		util = load * CAPACITY_SCALE / window;
+		req = cl->max_freq ? FREQ_HEADROOM(util) * cl->max_freq /
+				     cl->capacity : util;
+		if (cl->max_freq && req >= cl->max_freq) {
+			req = cl->max_freq;
+			cl->nr_max_windows++;
+		}
+		cl->req_sum += req;
+		cl->nr_windows++;
+
+		if (print_timeline)
+			printf("%llu.%06llu cluster=%d util=%llu req=%llu\n",
+			       (unsigned long long)(end / 1000000000),
+			       (unsigned long long)(end % 1000000000 / 1000),
+			       i, (unsigned long long)util,
+			       (unsigned long long)req);
+	}
+}
+
+static void rollover(uint64_t end)
+{
+	struct task *t;
+	int cpu;
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++) {
+		cpus[cpu].prev_runnable_sum = cpus[cpu].curr_runnable_sum;
+		cpus[cpu].curr_runnable_sum = 0;
+		cpus[cpu].top_task = 0;
+	}
+
+	while ((t = dirty_list)) {
+		dirty_list = t->next_dirty;
+		t->dirty = 0;
+		if (t->cpu >= 0 && t->curr_window > cpus[t->cpu].top_task)
+			cpus[t->cpu].top_task = t->curr_window;
+		update_history(t, end, t->curr_window);
+	}
+
+	window_idx++;
+	window_start = end;
+	report_window(end);
+}
+
+static void advance(uint64_t ts)
+{
+	int cpu;
+
+	if (!started) {
+		window_start = ts - ts % window;
+		for (cpu = 0; cpu < MAX_CPUS; cpu++)
+			cpus[cpu].last_ts = ts;
+		started = 1;
+		return;
+	}
+
+	while (ts >= window_start + window) {
+		uint64_t end = window_start + window;
+
+		for (cpu = 0; cpu < MAX_CPUS; cpu++)
+			account_busy(&cpus[cpu], end);
+		rollover(end);
+	}
+}
+
+/* Move the window busy time along with a task changing cluster */
+static void migrate(struct task *t, int new_cpu)
+{
+	struct cpu *src, *dst;
+
+	if (t->cpu < 0 || t->cpu == new_cpu)
+		goto out;
+
+	src = &cpus[t->cpu];
+	dst = &cpus[new_cpu];
+	if (src->cluster == dst->cluster)
+		goto out;
+
+	task_sync(t);
+	src->curr_runnable_sum -= t->curr_window < src->curr_runnable_sum ?
+				  t->curr_window : src->curr_runnable_sum;
+	src->prev_runnable_sum -= t->prev_window < src->prev_runnable_sum ?
+				  t->prev_window : src->prev_runnable_sum;
+	dst->curr_runnable_sum += t->curr_window;
+	dst->prev_runnable_sum += t->prev_window;
+out:
+	t->cpu = new_cpu;
+}
+
+/* ------------------------------------------------------------------ */
+/* Trace parsing */
+
+static int parse_header(const char *line, const char *event, int *cpu,
+			uint64_t *ts)
+{
+	const char *p = strstr(line, event), *q;
+	unsigned long long sec, usec;
+
+	if (!p)
+		return -1;
+
+	q = strchr(line, '[');
+	if (!q || q > p || sscanf(q, "[%d]", cpu) != 1)
+		return -1;
+	if (*cpu < 0 || *cpu >= MAX_CPUS)
+		return -1;
+
+	/* timestamp is the last "sec.usec:" token before the event name */
+	for (q = p - 2; q > line && *q != ' '; q--)
+		;
+	if (sscanf(q, " %llu.%llu:", &sec, &usec) != 2)
+		return -1;
+
+	*ts = sec * 1000000000ULL + usec * 1000ULL;
+	return 0;
+}
+
+static void handle_switch(const char *line, int cpu, uint64_t ts)
+{
+	const char *p = strstr(line, "next_pid=");
+	struct task *t;
+	int next_pid;
+
+	if (!p || sscanf(p, "next_pid=%d", &next_pid) != 1)
+		return;
+
+	account_busy(&cpus[cpu], ts);
+	cpus[cpu].curr_pid = next_pid;
+	if (!next_pid)
+		return;
+
+	t = task_lookup(next_pid, ts);
+	migrate(t, cpu);
+}
+
+static void handle_freq(const char *line, uint64_t ts)
+{
+	const char *p = strstr(line, "state=");
+	unsigned int freq;
+	int cpu;
+
+	if (!p || sscanf(p, "state=%u cpu_id=%d", &freq, &cpu) != 2)
+		return;
+	if (cpu < 0 || cpu >= MAX_CPUS)
+		return;
+
+	account_busy(&cpus[cpu], ts);
+	cpus[cpu].cur_freq = freq;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+static void account_cost(enum event_type type, uint64_t ns)
+{
+	struct cost *c = &costs[type];
+	int b = 0;
+
+	c->nr++;
+	c->total_ns += ns;
+	if (ns > c->max_ns)
+		c->max_ns = ns;
+	while (b < 31 && (1ULL << (b + 1)) <= ns)
+		b++;
+	c->hist[b]++;
+}
+
+static uint64_t cost_percentile(const struct cost *c, unsigned int pct)
+{
+	uint64_t target = (c->nr * pct + 99) / 100, seen = 0;
+	int b;
+
+	for (b = 0; b < 32; b++) {
+		seen += c->hist[b];
+		if (seen >= target)
+			return 2ULL << b;
+	}
+	return c->max_ns;
+}
+
+static void replay(FILE *f)
+{
+	char line[4096];
+	uint64_t ts, start;
+	int cpu;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (!parse_header(line, "sched_switch:", &cpu, &ts)) {
+			start = now_ns();
+			advance(ts);
+			handle_switch(line, cpu, ts);
+			account_cost(EV_SWITCH, now_ns() - start);
+		} else if (!parse_header(line, "cpu_frequency:", &cpu, &ts)) {
+			start = now_ns();
+			advance(ts);
+			handle_freq(line, ts);
+			account_cost(EV_FREQ, now_ns() - start);
+		}
+	}
+}
+
+/* ------------------------------------------------------------------ */
+/* Setup and report */
+
+static void parse_clusters(char *spec)
+{
+	char *tok, *save = NULL;
+	int cpu;
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++)
+		cpus[cpu].cluster = -1;
+
+	for (tok = strtok_r(spec, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		struct cluster *cl;
+		int first, last, n;
+		unsigned int cap, freq;
+
+		if (nr_clusters == MAX_CLUSTERS)
+			die("too many clusters");
+
+		n = sscanf(tok, "%d-%d:%u:%u", &first, &last, &cap, &freq);
+		if (n != 4) {
+			n = sscanf(tok, "%d:%u:%u", &first, &cap, &freq);
+			if (n != 3)
+				die("bad cluster spec, want cpus:capacity:max_khz");
+			last = first;
+		}
+		if (first < 0 || last >= MAX_CPUS || first > last || !cap)
+			die("bad cluster spec");
+
+		cl = &clusters[nr_clusters];
+		cl->first_cpu = first;
+		cl->capacity = cap;
+		cl->max_freq = freq;
+		for (cpu = first; cpu <= last; cpu++)
+			cpus[cpu].cluster = nr_clusters;
+		nr_clusters++;
+	}
+
+	for (cpu = 0; cpu < MAX_CPUS; cpu++)
+		if (cpus[cpu].cluster < 0)
+			cpus[cpu].cluster = 0;
+}
+
+static void report(void)
+{
+	int i;
+
+	printf("\nwindow=%llu us hist_size=%u predictor=%s\n",
+	       (unsigned long long)(window / 1000), hist_size,
+	       predictor == PRED_EWMA ? "ewma" : "buckets");
+
+	printf("\nfrequency requests:\n");
+	for (i = 0; i < nr_clusters; i++) {
+		struct cluster *cl = &clusters[i];
+
+		if (!cl->nr_windows)
+			continue;
+		printf("  cluster%d: windows=%llu avg_req=%llu at_max=%llu%%\n",
+		       i, (unsigned long long)cl->nr_windows,
+		       (unsigned long long)(cl->req_sum / cl->nr_windows),
+		       (unsigned long long)(cl->nr_max_windows * 100 /
+					    cl->nr_windows));
+	}
+
+	printf("\nprediction (predicted - actual busy time per window):\n");
+	if (nr_pred_samples)
+		printf("  samples=%llu mean_abs_err=%.2f%% bias=%+.2f%%\n",
+		       (unsigned long long)nr_pred_samples,
+		       100.0 * pred_abs_err / nr_pred_samples / window,
+		       100.0 * pred_bias / (int64_t)nr_pred_samples / window);
+	else
+		printf("  no samples\n");
+
+	printf("\nper-event cost:\n");
+	for (i = 0; i < NR_EVENT_TYPES; i++) {
+		struct cost *c = &costs[i];
+
+		if (!c->nr)
+			continue;
+		printf("  %-14s nr=%llu avg=%lluns p50<%lluns p99<%lluns max=%lluns\n",
+		       event_names[i], (unsigned long long)c->nr,
+		       (unsigned long long)(c->total_ns / c->nr),
+		       (unsigned long long)cost_percentile(c, 50),
+		       (unsigned long long)cost_percentile(c, 99),
+		       (unsigned long long)c->max_ns);
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"usage: walt-replay [-w window_ms] [-H hist_size] [-p buckets|ewma]\n"
+		"                   [-c cpus:capacity:max_khz[,...]] [-t] [trace]\n");
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	char default_spec[] = "0-31:1024:0";
+	char *spec = default_spec;
+	FILE *f = stdin;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "w:H:p:c:th")) != -1) {
+		switch (opt) {
+		case 'w':
+			window = strtoull(optarg, NULL, 0) * 1000000ULL;
+			if (!window)
+				usage();
+			break;
+		case 'H':
+			hist_size = strtoul(optarg, NULL, 0);
+			if (!hist_size || hist_size > RAVG_HIST_SIZE_MAX)
+				usage();
+			break;
+		case 'p':
+			if (!strcmp(optarg, "buckets"))
+				predictor = PRED_BUCKETS;
+			else if (!strcmp(optarg, "ewma"))
+				predictor = PRED_EWMA;
+			else
+				usage();
+			break;
+		case 'c':
+			spec = optarg;
+			break;
+		case 't':
+			print_timeline = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (optind < argc) {
+		f = fopen(argv[optind], "r");
+		if (!f) {
+			fprintf(stderr, "walt-replay: %s: %s\n", argv[optind],
+				strerror(errno));
+			return 1;
+		}
+	}
+
+	parse_clusters(spec);
+	replay(f);
+	report();
+
+	if (f != stdin)
+		fclose(f);
+	return 0;
+}
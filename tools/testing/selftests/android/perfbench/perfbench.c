@@ -0,0 +1,954 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * perfbench: microbenchmarks for the vendor kernel hot paths, driven only
+ * through existing syscalls, ioctls and device nodes.
+ *
+ * Every result is printed as one CSV line, in the same format as
+ * drivers/gpu/kgsl/kgsl_bench, so run_perfbench.sh can merge both into a
+ * single report:
+ *
+ *	test,param,iterations,avg_ns,min_ns,max_ns,ops_per_sec
+ *
+ * Lines starting with '#' are comments. A test whose device or privilege
+ * is missing prints a "skip" comment and does not count as a failure.
+ *
+ * Usage:
+ *	perfbench [-n iterations] [-t tests] [-f file] [-D dir]
+ *		  [-a addr] [-p port]
+ *	perfbench -S [-p port]
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <linux/android/binder.h>
+#include <linux/android/binderfs.h>
+#include <linux/ion.h>
+#include <linux/msm_ion.h>
+
+#define TEST_PREFIX	"android/perfbench"
+#define KSFT_SKIP	77
+
+#define SZ_4K		0x00001000UL
+#define SZ_64K		0x00010000UL
+#define SZ_1M		0x00100000UL
+#define SZ_8M		0x00800000UL
+
+#define TEST_WAKEUP	(1 << 0)
+#define TEST_TIMER	(1 << 1)
+#define TEST_BINDER	(1 << 2)
+#define TEST_ION	(1 << 3)
+#define TEST_BLK	(1 << 4)
+#define TEST_NET	(1 << 5)
+#define TEST_FILES	(1 << 6)
+#define TEST_ALL	(TEST_WAKEUP | TEST_TIMER | TEST_BINDER | TEST_ION | \
+			 TEST_BLK | TEST_NET | TEST_FILES)
+
+/* Period of the cyclictest-like timer loop, in ns */
+#define TIMER_PERIOD	1000000
+
+/* Deepest queue depth of the random read test */
+#define BLK_MAX_QD	32
+
+#define BINDER_MAP_SIZE	(128 * 1024)
+
+#define NET_PORT	5201
+#define NET_CHUNK	SZ_64K
+
+struct bench_stat {
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+	unsigned long count;
+};
+
+static long page_size;
+static unsigned long iterations = 1000;
+static const char *blk_file;
+static const char *files_dir;
+static const char *net_addr;
+static int net_port = NET_PORT;
+static int failures;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void stat_init(struct bench_stat *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->min = UINT64_MAX;
+}
+
+static void stat_add(struct bench_stat *s, uint64_t ns)
+{
+	s->total += ns;
+	s->count++;
+	if (ns < s->min)
+		s->min = ns;
+	if (ns > s->max)
+		s->max = ns;
+}
+
+static void stat_merge(struct bench_stat *s, const struct bench_stat *o)
+{
+	s->total += o->total;
+	s->count += o->count;
+	if (o->min < s->min)
+		s->min = o->min;
+	if (o->max > s->max)
+		s->max = o->max;
+}
+
+static void stat_print(const char *test, const char *param,
+		struct bench_stat *s)
+{
+	uint64_t avg;
+
+	if (!s->count) {
+		printf("# %s %s: no samples\n", test, param);
+		return;
+	}
+
+	avg = s->total / s->count;
+	printf("%s,%s,%lu,%llu,%llu,%llu,%.1f\n", test, param, s->count,
+		(unsigned long long)avg, (unsigned long long)s->min,
+		(unsigned long long)s->max,
+		s->total ? s->count * 1e9 / s->total : 0.0);
+	fflush(stdout);
+}
+
+static void fail(const char *what)
+{
+	printf("# %s: %s failed: %s\n", TEST_PREFIX, what, strerror(errno));
+	failures++;
+}
+
+static void skip(const char *test, const char *why)
+{
+	printf("# %s: skip %s: %s\n", TEST_PREFIX, test, why);
+}
+
+static void set_fifo(void)
+{
+	struct sched_param sp = { .sched_priority = 50 };
+
+	sched_setscheduler(0, SCHED_FIFO, &sp);
+}
+
+/*
+ * Wakeup latency: two threads bounce a byte over a pair of pipes, so
+ * every iteration is two sleeps and two cross-CPU wakeups. Run once as
+ * CFS tasks and once as SCHED_FIFO when the privilege is there.
+ */
+struct pingpong {
+	int to_peer[2];
+	int from_peer[2];
+	bool fifo;
+};
+
+static void *wakeup_peer(void *arg)
+{
+	struct pingpong *pp = arg;
+	char c;
+
+	if (pp->fifo)
+		set_fifo();
+
+	while (read(pp->to_peer[0], &c, 1) == 1)
+		if (write(pp->from_peer[1], &c, 1) != 1)
+			break;
+
+	return NULL;
+}
+
+static void bench_wakeup_one(bool fifo)
+{
+	struct sched_param sp = { 0 };
+	struct bench_stat st;
+	struct pingpong pp;
+	pthread_t thread;
+	unsigned long i;
+	uint64_t t;
+	char c = 0;
+
+	if (fifo) {
+		sp.sched_priority = 50;
+		if (sched_setscheduler(0, SCHED_FIFO, &sp)) {
+			skip("wakeup", "no SCHED_FIFO");
+			return;
+		}
+	}
+
+	if (pipe(pp.to_peer)) {
+		fail("pipe");
+		goto out_sched;
+	}
+	if (pipe(pp.from_peer)) {
+		fail("pipe");
+		goto out_to;
+	}
+	pp.fifo = fifo;
+
+	if (pthread_create(&thread, NULL, wakeup_peer, &pp)) {
+		fail("pthread_create");
+		goto out_from;
+	}
+
+	stat_init(&st);
+	for (i = 0; i < iterations; i++) {
+		t = now_ns();
+		if (write(pp.to_peer[1], &c, 1) != 1 ||
+		    read(pp.from_peer[0], &c, 1) != 1) {
+			fail("pingpong");
+			break;
+		}
+		stat_add(&st, now_ns() - t);
+	}
+
+	/* EOF on the pipe stops the peer */
+	close(pp.to_peer[1]);
+	pp.to_peer[1] = -1;
+	pthread_join(thread, NULL);
+	stat_print("wakeup", fifo ? "pipe_rt" : "pipe_cfs", &st);
+
+out_from:
+	close(pp.from_peer[0]);
+	close(pp.from_peer[1]);
+out_to:
+	close(pp.to_peer[0]);
+	if (pp.to_peer[1] >= 0)
+		close(pp.to_peer[1]);
+out_sched:
+	if (fifo) {
+		sp.sched_priority = 0;
+		sched_setscheduler(0, SCHED_OTHER, &sp);
+	}
+}
+
+static void bench_wakeup(void)
+{
+	bench_wakeup_one(false);
+	bench_wakeup_one(true);
+}
+
+/*
+ * Timer wakeup latency, cyclictest style: sleep to an absolute deadline
+ * every TIMER_PERIOD and record how late the thread got to run.
+ */
+static void bench_timer(void)
+{
+	struct sched_param sp = { .sched_priority = 80 };
+	struct timespec next;
+	struct bench_stat st;
+	bool fifo;
+	unsigned long i;
+	uint64_t target;
+
+	fifo = !sched_setscheduler(0, SCHED_FIFO, &sp);
+
+	stat_init(&st);
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (i = 0; i < iterations; i++) {
+		next.tv_nsec += TIMER_PERIOD;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		target = (uint64_t)next.tv_sec * 1000000000ULL + next.tv_nsec;
+
+		if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				    &next, NULL)) {
+			fail("clock_nanosleep");
+			break;
+		}
+		stat_add(&st, now_ns() - target);
+	}
+
+	if (fifo) {
+		sp.sched_priority = 0;
+		sched_setscheduler(0, SCHED_OTHER, &sp);
+	}
+
+	stat_print("timer", fifo ? "1ms_rt" : "1ms_cfs", &st);
+}
+
+/*
+ * Binder round trip on a private binderfs instance: a child process
+ * becomes the context manager and replies to every transaction, the
+ * parent times BC_TRANSACTION until BR_REPLY.
+ */
+struct binder_txn {
+	uint32_t cmd;
+	struct binder_transaction_data txn;
+} __attribute__((packed));
+
+struct binder_free {
+	uint32_t cmd;
+	binder_uintptr_t buffer;
+} __attribute__((packed));
+
+static int binder_open_dev(const char *path, void **map)
+{
+	int fd = open(path, O_RDWR | O_CLOEXEC);
+
+	if (fd < 0)
+		return -1;
+
+	*map = mmap(NULL, BINDER_MAP_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (*map == MAP_FAILED) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static int binder_write(int fd, void *data, size_t len)
+{
+	struct binder_write_read bwr = {
+		.write_size = len,
+		.write_buffer = (binder_uintptr_t)data,
+	};
+
+	return ioctl(fd, BINDER_WRITE_READ, &bwr);
+}
+
+/*
+ * Read until a BR_TRANSACTION or BR_REPLY shows up and return its
+ * buffer in *buffer. Returns the command or -1 on error.
+ */
+static int binder_wait(int fd, binder_uintptr_t *buffer)
+{
+	uint32_t rbuf[64];
+	struct binder_write_read bwr;
+	struct binder_transaction_data *txn;
+	char *ptr, *end;
+	uint32_t cmd;
+
+	for (;;) {
+		memset(&bwr, 0, sizeof(bwr));
+		bwr.read_size = sizeof(rbuf);
+		bwr.read_buffer = (binder_uintptr_t)rbuf;
+		if (ioctl(fd, BINDER_WRITE_READ, &bwr) < 0)
+			return -1;
+
+		ptr = (char *)rbuf;
+		end = ptr + bwr.read_consumed;
+		while (ptr < end) {
+			memcpy(&cmd, ptr, sizeof(cmd));
+			ptr += sizeof(cmd);
+
+			switch (cmd) {
+			case BR_NOOP:
+			case BR_TRANSACTION_COMPLETE:
+			case BR_SPAWN_LOOPER:
+				break;
+			case BR_TRANSACTION:
+			case BR_REPLY:
+				txn = (struct binder_transaction_data *)ptr;
+				*buffer = txn->data.ptr.buffer;
+				return cmd;
+			default:
+				errno = EPROTO;
+				return -1;
+			}
+		}
+	}
+}
+
+static void binder_server(const char *path, int ready)
+{
+	struct binder_free fb = { .cmd = BC_FREE_BUFFER };
+	struct binder_txn reply = { .cmd = BC_REPLY };
+	uint32_t looper = BC_ENTER_LOOPER;
+	binder_uintptr_t buffer;
+	void *map;
+	char c = 0;
+	int fd;
+
+	fd = binder_open_dev(path, &map);
+	if (fd < 0 || ioctl(fd, BINDER_SET_CONTEXT_MGR, 0) < 0 ||
+	    binder_write(fd, &looper, sizeof(looper)) < 0)
+		c = 1;
+
+	if (write(ready, &c, 1) != 1 || c)
+		_exit(1);
+
+	while (binder_wait(fd, &buffer) == BR_TRANSACTION) {
+		fb.buffer = buffer;
+		if (binder_write(fd, &fb, sizeof(fb)) < 0 ||
+		    binder_write(fd, &reply, sizeof(reply)) < 0)
+			break;
+	}
+
+	_exit(0);
+}
+
+static void bench_binder(void)
+{
+	char root[] = "/tmp/perfbench-binderfs-XXXXXX";
+	struct binderfs_device dev = { .name = "perfbench" };
+	struct binder_free fb = { .cmd = BC_FREE_BUFFER };
+	struct binder_txn tr = { .cmd = BC_TRANSACTION };
+	uint32_t payload[16] = { 0 };
+	binder_uintptr_t buffer;
+	struct bench_stat st;
+	char path[128];
+	int ready[2], ctl, fd = -1;
+	unsigned long i;
+	void *map;
+	pid_t pid;
+	uint64_t t;
+	char c;
+
+	if (!mkdtemp(root)) {
+		fail("mkdtemp");
+		return;
+	}
+
+	if (mount(NULL, root, "binder", 0, NULL)) {
+		skip("binder", "cannot mount binderfs");
+		rmdir(root);
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/binder-control", root);
+	ctl = open(path, O_RDONLY | O_CLOEXEC);
+	if (ctl < 0 || ioctl(ctl, BINDER_CTL_ADD, &dev) < 0) {
+		fail("BINDER_CTL_ADD");
+		goto out_umount;
+	}
+	snprintf(path, sizeof(path), "%s/%s", root, dev.name);
+
+	if (pipe(ready)) {
+		fail("pipe");
+		goto out_ctl;
+	}
+
+	pid = fork();
+	if (pid < 0) {
+		fail("fork");
+		goto out_pipe;
+	}
+	if (!pid)
+		binder_server(path, ready[1]);
+
+	if (read(ready[0], &c, 1) != 1 || c) {
+		fail("binder context manager");
+		goto out_child;
+	}
+
+	fd = binder_open_dev(path, &map);
+	if (fd < 0) {
+		fail("binder open");
+		goto out_child;
+	}
+
+	tr.txn.target.handle = 0;
+	tr.txn.code = 1;
+	tr.txn.data_size = sizeof(payload);
+	tr.txn.data.ptr.buffer = (binder_uintptr_t)payload;
+
+	stat_init(&st);
+	for (i = 0; i < iterations; i++) {
+		t = now_ns();
+		if (binder_write(fd, &tr, sizeof(tr)) < 0 ||
+		    binder_wait(fd, &buffer) != BR_REPLY) {
+			fail("binder transaction");
+			break;
+		}
+		stat_add(&st, now_ns() - t);
+
+		fb.buffer = buffer;
+		if (binder_write(fd, &fb, sizeof(fb)) < 0) {
+			fail("BC_FREE_BUFFER");
+			break;
+		}
+	}
+	stat_print("binder", "roundtrip_64b", &st);
+
+	munmap(map, BINDER_MAP_SIZE);
+	close(fd);
+out_child:
+	kill(pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+out_pipe:
+	close(ready[0]);
+	close(ready[1]);
+out_ctl:
+	if (ctl >= 0)
+		close(ctl);
+out_umount:
+	umount2(root, MNT_DETACH);
+	rmdir(root);
+}
+
+/*
+ * ION/dma-buf: allocation from the system heap, then mapping and
+ * touching every page of the buffer, by size.
+ */
+static void bench_ion(void)
+{
+	static const size_t sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_8M };
+	struct ion_allocation_data alloc;
+	struct bench_stat a, m;
+	unsigned long i, n;
+	char param[32];
+	unsigned int s;
+	size_t off;
+	uint64_t t;
+	char *p;
+	int ion;
+
+	ion = open("/dev/ion", O_RDONLY | O_CLOEXEC);
+	if (ion < 0) {
+		skip("ion", "no /dev/ion");
+		return;
+	}
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		n = sizes[s] >= SZ_1M ? (iterations + 9) / 10 : iterations;
+		stat_init(&a);
+		stat_init(&m);
+
+		for (i = 0; i < n; i++) {
+			memset(&alloc, 0, sizeof(alloc));
+			alloc.len = sizes[s];
+			alloc.heap_id_mask = ION_HEAP(ION_SYSTEM_HEAP_ID);
+
+			t = now_ns();
+			if (ioctl(ion, ION_IOC_ALLOC, &alloc) < 0) {
+				fail("ION_IOC_ALLOC");
+				goto out;
+			}
+			stat_add(&a, now_ns() - t);
+
+			t = now_ns();
+			p = mmap(NULL, sizes[s], PROT_READ | PROT_WRITE,
+				 MAP_SHARED, alloc.fd, 0);
+			if (p == MAP_FAILED) {
+				fail("dma-buf mmap");
+				close(alloc.fd);
+				goto out;
+			}
+			for (off = 0; off < sizes[s]; off += page_size)
+				p[off] = 1;
+			munmap(p, sizes[s]);
+			stat_add(&m, now_ns() - t);
+
+			close(alloc.fd);
+		}
+
+		snprintf(param, sizeof(param), "alloc_%zuk", sizes[s] >> 10);
+		stat_print("ion", param, &a);
+		snprintf(param, sizeof(param), "map_%zuk", sizes[s] >> 10);
+		stat_print("ion", param, &m);
+	}
+out:
+	close(ion);
+}
+
+/*
+ * Random 4K O_DIRECT reads from a file or block device (-f), at queue
+ * depth 1 and BLK_MAX_QD. The queue depth is one thread per slot, the
+ * same way fio's psync engine gets there.
+ */
+struct blk_worker {
+	pthread_t thread;
+	int fd;
+	off_t blocks;
+	unsigned long count;
+	unsigned int seed;
+	struct bench_stat st;
+	int err;
+};
+
+static void *blk_worker_fn(void *arg)
+{
+	struct blk_worker *w = arg;
+	unsigned long i;
+	off_t off;
+	uint64_t t;
+	void *buf;
+
+	if (posix_memalign(&buf, SZ_4K, SZ_4K)) {
+		w->err = ENOMEM;
+		return NULL;
+	}
+
+	stat_init(&w->st);
+	for (i = 0; i < w->count; i++) {
+		off = ((off_t)rand_r(&w->seed) % w->blocks) * SZ_4K;
+		t = now_ns();
+		if (pread(w->fd, buf, SZ_4K, off) != SZ_4K) {
+			w->err = errno ? errno : EIO;
+			break;
+		}
+		stat_add(&w->st, now_ns() - t);
+	}
+
+	free(buf);
+	return NULL;
+}
+
+static void bench_blk_qd(int fd, off_t blocks, unsigned int qd)
+{
+	struct blk_worker workers[BLK_MAX_QD];
+	struct bench_stat st, total;
+	unsigned int i;
+	char param[32];
+	uint64_t t;
+
+	stat_init(&st);
+	t = now_ns();
+	for (i = 0; i < qd; i++) {
+		workers[i].fd = fd;
+		workers[i].blocks = blocks;
+		workers[i].count = iterations;
+		workers[i].seed = i + 1;
+		workers[i].err = 0;
+		pthread_create(&workers[i].thread, NULL, blk_worker_fn,
+			       &workers[i]);
+	}
+	for (i = 0; i < qd; i++) {
+		pthread_join(workers[i].thread, NULL);
+		if (workers[i].err) {
+			errno = workers[i].err;
+			fail("pread");
+		}
+		stat_merge(&st, &workers[i].st);
+	}
+	t = now_ns() - t;
+
+	snprintf(param, sizeof(param), "randread_4k_qd%u", qd);
+	stat_print("blk", param, &st);
+
+	/* IOPS across all slots, the per-I/O line above gives latency */
+	stat_init(&total);
+	total.count = st.count;
+	total.total = t;
+	total.min = total.max = st.count ? t / st.count : 0;
+	snprintf(param, sizeof(param), "randread_4k_qd%u_iops", qd);
+	stat_print("blk", param, &total);
+}
+
+static void bench_blk(void)
+{
+	off_t size;
+	int fd;
+
+	if (!blk_file) {
+		skip("blk", "no -f file or device");
+		return;
+	}
+
+	fd = open(blk_file, O_RDONLY | O_DIRECT | O_CLOEXEC);
+	if (fd < 0) {
+		fail("open -f");
+		return;
+	}
+
+	size = lseek(fd, 0, SEEK_END);
+	if (size < (off_t)SZ_1M) {
+		skip("blk", "-f is smaller than 1M");
+		close(fd);
+		return;
+	}
+
+	bench_blk_qd(fd, size / SZ_4K, 1);
+	bench_blk_qd(fd, size / SZ_4K, BLK_MAX_QD);
+
+	close(fd);
+}
+
+/*
+ * TCP stream to a perfbench -S sink. run_perfbench.sh puts the sink
+ * behind a veth pair with GRO enabled, which is the rmnet receive path
+ * minus the modem.
+ */
+static void net_sink(void)
+{
+	struct sockaddr_in sin = {
+		.sin_family = AF_INET,
+		.sin_port = htons(net_port),
+		.sin_addr.s_addr = htonl(INADDR_ANY),
+	};
+	static char buf[NET_CHUNK];
+	int one = 1, ls, s;
+
+	ls = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (ls < 0 ||
+	    setsockopt(ls, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) ||
+	    bind(ls, (struct sockaddr *)&sin, sizeof(sin)) || listen(ls, 4)) {
+		perror("sink");
+		exit(1);
+	}
+
+	for (;;) {
+		s = accept(ls, NULL, NULL);
+		if (s < 0)
+			continue;
+		while (read(s, buf, sizeof(buf)) > 0)
+			;
+		close(s);
+	}
+}
+
+static void bench_net(void)
+{
+	struct sockaddr_in sin = {
+		.sin_family = AF_INET,
+		.sin_port = htons(net_port),
+	};
+	static char buf[NET_CHUNK];
+	struct bench_stat st;
+	unsigned long i;
+	char param[32];
+	ssize_t done;
+	size_t left;
+	uint64_t t;
+	int s;
+
+	if (!net_addr) {
+		skip("net", "no -a sink address");
+		return;
+	}
+
+	if (inet_pton(AF_INET, net_addr, &sin.sin_addr) != 1) {
+		errno = EINVAL;
+		fail("-a");
+		return;
+	}
+
+	s = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (s < 0 || connect(s, (struct sockaddr *)&sin, sizeof(sin))) {
+		fail("connect");
+		if (s >= 0)
+			close(s);
+		return;
+	}
+
+	stat_init(&st);
+	for (i = 0; i < iterations * 10; i++) {
+		t = now_ns();
+		for (left = sizeof(buf); left; left -= done) {
+			done = write(s, buf + sizeof(buf) - left, left);
+			if (done <= 0) {
+				fail("send");
+				goto out;
+			}
+		}
+		stat_add(&st, now_ns() - t);
+	}
+out:
+	snprintf(param, sizeof(param), "tcp_stream_%luk", NET_CHUNK >> 10);
+	stat_print("net", param, &st);
+	close(s);
+}
+
+/*
+ * Small file creation in a directory on the filesystem under test (-D),
+ * with and without fsync. f2fs is the interesting one on device.
+ */
+static void bench_files_one(const char *dir, bool sync)
+{
+	struct bench_stat c, u;
+	static char data[SZ_4K];
+	char path[256];
+	unsigned long i;
+	uint64_t t;
+	int fd;
+
+	stat_init(&c);
+	for (i = 0; i < iterations; i++) {
+		snprintf(path, sizeof(path), "%s/f%lu", dir, i);
+		t = now_ns();
+		fd = open(path, O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0600);
+		if (fd < 0 || write(fd, data, sizeof(data)) != sizeof(data) ||
+		    (sync && fsync(fd))) {
+			fail("create");
+			if (fd >= 0)
+				close(fd);
+			break;
+		}
+		close(fd);
+		stat_add(&c, now_ns() - t);
+	}
+
+	stat_init(&u);
+	while (i--) {
+		snprintf(path, sizeof(path), "%s/f%lu", dir, i);
+		t = now_ns();
+		if (unlink(path)) {
+			fail("unlink");
+			break;
+		}
+		stat_add(&u, now_ns() - t);
+	}
+
+	stat_print("files", sync ? "create_4k_fsync" : "create_4k", &c);
+	stat_print("files", sync ? "unlink_fsync" : "unlink", &u);
+}
+
+static void bench_files(void)
+{
+	char dir[256];
+
+	if (!files_dir) {
+		skip("files", "no -D directory");
+		return;
+	}
+
+	snprintf(dir, sizeof(dir), "%s/perfbench.%d", files_dir, getpid());
+	if (mkdir(dir, 0700)) {
+		fail("mkdir -D");
+		return;
+	}
+
+	bench_files_one(dir, false);
+	bench_files_one(dir, true);
+
+	rmdir(dir);
+}
+
+static unsigned int parse_tests(char *str)
+{
+	unsigned int tests = 0;
+	char *tok;
+
+	for (tok = strtok(str, ","); tok; tok = strtok(NULL, ",")) {
+		if (!strcmp(tok, "wakeup"))
+			tests |= TEST_WAKEUP;
+		else if (!strcmp(tok, "timer"))
+			tests |= TEST_TIMER;
+		else if (!strcmp(tok, "binder"))
+			tests |= TEST_BINDER;
+		else if (!strcmp(tok, "ion"))
+			tests |= TEST_ION;
+		else if (!strcmp(tok, "blk"))
+			tests |= TEST_BLK;
+		else if (!strcmp(tok, "net"))
+			tests |= TEST_NET;
+		else if (!strcmp(tok, "files"))
+			tests |= TEST_FILES;
+		else
+			return 0;
+	}
+
+	return tests;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [-n iterations] [-t tests] [-f file] [-D dir] [-a addr] [-p port]\n"
+		"       %s -S [-p port]\n"
+		"  -n  iterations per measurement (default 1000)\n"
+		"  -t  comma separated list of wakeup,timer,binder,ion,blk,net,files\n"
+		"  -f  file or block device for the random read test\n"
+		"  -D  directory for the small file test\n"
+		"  -a  IPv4 address of a perfbench -S sink for the net test\n"
+		"  -p  TCP port of the sink (default %d)\n"
+		"  -S  run as the net test sink\n",
+		name, name, NET_PORT);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int tests = TEST_ALL;
+	bool sink = false;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:t:f:D:a:p:Sh")) != -1) {
+		switch (c) {
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			tests = parse_tests(optarg);
+			break;
+		case 'f':
+			blk_file = optarg;
+			break;
+		case 'D':
+			files_dir = optarg;
+			break;
+		case 'a':
+			net_addr = optarg;
+			break;
+		case 'p':
+			net_port = atoi(optarg);
+			break;
+		case 'S':
+			sink = true;
+			break;
+		default:
+			usage(argv[0]);
+			return c == 'h' ? 0 : 1;
+		}
+	}
+
+	if (sink) {
+		net_sink();
+		return 0;
+	}
+
+	if (!iterations || !tests) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("# %s iterations=%lu\n", TEST_PREFIX, iterations);
+	printf("test,param,iterations,avg_ns,min_ns,max_ns,ops_per_sec\n");
+
+	if (tests & TEST_WAKEUP)
+		bench_wakeup();
+	if (tests & TEST_TIMER)
+		bench_timer();
+	if (tests & TEST_BINDER)
+		bench_binder();
+	if (tests & TEST_ION)
+		bench_ion();
+	if (tests & TEST_BLK)
+		bench_blk();
+	if (tests & TEST_NET)
+		bench_net();
+	if (tests & TEST_FILES)
+		bench_files();
+
+	if (failures) {
+		printf("%s: [FAIL,%d errors]\n", TEST_PREFIX, failures);
+		return 1;
+	}
+
+	printf("%s: [PASS]\n", TEST_PREFIX);
+	return 0;
+}
@@ -0,0 +1,104 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPL-2.0
+#
+# Run perfbench and kgsl_bench and merge their CSV output into one JSON
+# report, the artifact performance gating compares between kernels.
+#
+# Usage: run_perfbench.sh [-o report.json] [-n iterations] [-f file]
+#			  [-D dir] [-k kgsl_bench]
+#
+#   -f  file or block device for the UFS random read test, e.g. a large
+#       file on /data or a read-only partition such as /dev/block/sda
+#   -D  directory for the small file create test, e.g. /data/local/tmp
+#
+# The net test runs over a veth pair into a private network namespace
+# with GRO enabled on the receiving side. It is skipped when ip(8) or the
+# privilege to create namespaces is missing.
+
+DIR=$(dirname "$0")
+OUT=perfbench.json
+ITER=1000
+FILE=
+FILES_DIR=
+KGSL_BENCH=
+NS=perfbench$$
+TMP=${TMPDIR:-/tmp}/perfbench.$$.csv
+
+while getopts "o:n:f:D:k:h" opt; do
+	case $opt in
+	o) OUT=$OPTARG ;;
+	n) ITER=$OPTARG ;;
+	f) FILE=$OPTARG ;;
+	D) FILES_DIR=$OPTARG ;;
+	k) KGSL_BENCH=$OPTARG ;;
+	*) sed -n '7,16s/^# \{0,1\}//p' "$0"; exit 1 ;;
+	esac
+done
+
+if [ -z "$KGSL_BENCH" ]; then
+	for k in "$DIR/kgsl_bench" "$DIR/../../drivers/gpu/kgsl/kgsl_bench"; do
+		[ -x "$k" ] && KGSL_BENCH=$k && break
+	done
+fi
+
+net_setup()
+{
+	command -v ip > /dev/null || return 1
+	ip netns add $NS 2> /dev/null || return 1
+	ip link add pb0 type veth peer name pb1 netns $NS || return 1
+	ip addr add 10.200.0.1/24 dev pb0
+	ip link set pb0 up
+	ip -n $NS addr add 10.200.0.2/24 dev pb1
+	ip -n $NS link set pb1 up
+	ip -n $NS link set lo up
+	ethtool -K pb1 gro on > /dev/null 2>&1 ||
+		ip netns exec $NS ethtool -K pb1 gro on > /dev/null 2>&1
+	ip netns exec $NS "$DIR/perfbench" -S &
+	SINK=$!
+	sleep 1
+}
+
+net_cleanup()
+{
+	[ -n "$SINK" ] && kill $SINK 2> /dev/null
+	ip link del pb0 2> /dev/null
+	ip netns del $NS 2> /dev/null
+}
+
+trap 'net_cleanup; rm -f "$TMP"' EXIT
+
+set -- -n "$ITER"
+[ -n "$FILE" ] && set -- "$@" -f "$FILE"
+[ -n "$FILES_DIR" ] && set -- "$@" -D "$FILES_DIR"
+net_setup && set -- "$@" -a 10.200.0.2
+
+"$DIR/perfbench" "$@" > "$TMP"
+ret=$?
+if [ -n "$KGSL_BENCH" ]; then
+	"$KGSL_BENCH" -n "$ITER" | sed 's/^/kgsl_/' >> "$TMP"
+	kret=$?
+	[ $kret -ne 0 ] && [ $kret -ne 77 ] && ret=$kret
+fi
+
+# Turn every result line into one JSON object, comments are dropped
+{
+	printf '{\n  "kernel": "%s",\n  "machine": "%s",\n' \
+		"$(uname -r)" "$(uname -m)"
+	printf '  "iterations": %s,\n  "results": [' "$ITER"
+	sep=
+	grep -v -e '^#' -e '^test,' -e '^kgsl_#' -e '^kgsl_test,' \
+		-e ': \[' "$TMP" |
+	while IFS=, read -r test param n avg min max ops; do
+		printf '%s\n    { "test": "%s", "param": "%s", "iterations": %s, ' \
+			"$sep" "$test" "$param" "$n"
+		printf '"avg_ns": %s, "min_ns": %s, "max_ns": %s, ' \
+			"$avg" "$min" "$max"
+		printf '"ops_per_sec": %s }' "$ops"
+		sep=,
+	done
+	printf '\n  ]\n}\n'
+} > "$OUT"
+
+grep -e '^#' -e ': \[' "$TMP"
+echo "report: $OUT"
+exit $ret
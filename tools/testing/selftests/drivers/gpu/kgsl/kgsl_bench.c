@@ -0,0 +1,612 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * kgsl_bench: microbenchmarks for the kgsl allocation, mapping, submission
+ * and timeline paths, driven through the regular kgsl ioctls.
+ *
+ * Every result is printed as one CSV line so that runs can be diffed or
+ * loaded into a spreadsheet:
+ *
+ *	test,param,iterations,avg_ns,min_ns,max_ns,ops_per_sec
+ *
+ * Lines starting with '#' are comments. The program exits with 77 (skip)
+ * if no kgsl device can be opened.
+ *
+ * Usage:
+ *	kgsl_bench [-d device] [-n iterations] [-t alloc,map,submit,timeline]
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/msm_kgsl.h>
+
+#define TEST_PREFIX	"drivers/gpu/kgsl/kgsl_bench"
+#define KSFT_SKIP	77
+
+#define SZ_4K		0x00001000UL
+#define SZ_64K		0x00010000UL
+#define SZ_1M		0x00100000UL
+#define SZ_2M		0x00200000UL
+#define SZ_8M		0x00800000UL
+
+#define TEST_ALLOC	(1 << 0)
+#define TEST_MAP	(1 << 1)
+#define TEST_SUBMIT	(1 << 2)
+#define TEST_TIMELINE	(1 << 3)
+#define TEST_ALL	(TEST_ALLOC | TEST_MAP | TEST_SUBMIT | TEST_TIMELINE)
+
+/* Wait timeout for a single GPU timestamp or timeline value, in ms */
+#define WAIT_TIMEOUT	2000
+
+struct bench_stat {
+	uint64_t total;
+	uint64_t min;
+	uint64_t max;
+	unsigned long count;
+};
+
+static int kgsl_fd = -1;
+static long page_size;
+static unsigned long iterations = 1000;
+static int failures;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void stat_init(struct bench_stat *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->min = UINT64_MAX;
+}
+
+static void stat_add(struct bench_stat *s, uint64_t ns)
+{
+	s->total += ns;
+	s->count++;
+	if (ns < s->min)
+		s->min = ns;
+	if (ns > s->max)
+		s->max = ns;
+}
+
+static void stat_print(const char *test, const char *param,
+		struct bench_stat *s)
+{
+	uint64_t avg;
+
+	if (!s->count) {
+		printf("# %s %s: no samples\n", test, param);
+		return;
+	}
+
+	avg = s->total / s->count;
+	printf("%s,%s,%lu,%llu,%llu,%llu,%.1f\n", test, param, s->count,
+		(unsigned long long)avg, (unsigned long long)s->min,
+		(unsigned long long)s->max,
+		s->total ? s->count * 1e9 / s->total : 0.0);
+	fflush(stdout);
+}
+
+static void fail(const char *what)
+{
+	printf("# %s: %s failed: %s\n", TEST_PREFIX, what, strerror(errno));
+	failures++;
+}
+
+static int gpumem_alloc(size_t size, unsigned int flags,
+		struct kgsl_gpumem_alloc_id *alloc)
+{
+	memset(alloc, 0, sizeof(*alloc));
+	alloc->size = size;
+	alloc->flags = flags;
+
+	return ioctl(kgsl_fd, IOCTL_KGSL_GPUMEM_ALLOC_ID, alloc);
+}
+
+static int gpumem_free(unsigned int id)
+{
+	struct kgsl_gpumem_free_id free_id = { .id = id };
+
+	return ioctl(kgsl_fd, IOCTL_KGSL_GPUMEM_FREE_ID, &free_id);
+}
+
+/* Allocation and free throughput by size and alignment order */
+static void bench_alloc(void)
+{
+	static const size_t sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_2M, SZ_8M };
+	static const unsigned int aligns[] = { 12, 16, 21 };
+	struct kgsl_gpumem_alloc_id alloc;
+	struct bench_stat a, f;
+	unsigned long i, n;
+	unsigned int s, o;
+	char param[64];
+	uint64_t t;
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		/* Keep the big sizes from taking forever */
+		n = sizes[s] >= SZ_2M ? (iterations + 9) / 10 : iterations;
+
+		for (o = 0; o < sizeof(aligns) / sizeof(aligns[0]); o++) {
+			unsigned int flags = aligns[o] << KGSL_MEMALIGN_SHIFT;
+
+			stat_init(&a);
+			stat_init(&f);
+
+			for (i = 0; i < n; i++) {
+				t = now_ns();
+				if (gpumem_alloc(sizes[s], flags, &alloc)) {
+					fail("IOCTL_KGSL_GPUMEM_ALLOC_ID");
+					break;
+				}
+				stat_add(&a, now_ns() - t);
+
+				t = now_ns();
+				if (gpumem_free(alloc.id)) {
+					fail("IOCTL_KGSL_GPUMEM_FREE_ID");
+					break;
+				}
+				stat_add(&f, now_ns() - t);
+			}
+
+			snprintf(param, sizeof(param), "size=%zu align=%u",
+				sizes[s], aligns[o]);
+			stat_print("gpumem_alloc", param, &a);
+			stat_print("gpumem_free", param, &f);
+		}
+	}
+}
+
+/*
+ * GPU map/unmap latency for user memory, and CPU map/unmap latency for
+ * a kgsl allocation including the faults needed to touch every page
+ */
+static void bench_map(void)
+{
+	static const size_t sizes[] = { SZ_64K, SZ_1M, SZ_8M };
+	struct kgsl_gpumem_alloc_id alloc;
+	struct bench_stat m, u, c;
+	unsigned long i, n;
+	char param[64];
+	unsigned int s;
+	size_t off;
+	uint64_t t;
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		void *buf;
+
+		n = sizes[s] >= SZ_2M ? (iterations + 9) / 10 : iterations;
+
+		buf = mmap(NULL, sizes[s], PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+		if (buf == MAP_FAILED) {
+			fail("mmap anonymous");
+			continue;
+		}
+
+		stat_init(&m);
+		stat_init(&u);
+
+		for (i = 0; i < n; i++) {
+			struct kgsl_map_user_mem map = {
+				.fd = -1,
+				.len = sizes[s],
+				.hostptr = (unsigned long)buf,
+				.memtype = KGSL_USER_MEM_TYPE_ADDR,
+			};
+			struct kgsl_sharedmem_free unmap;
+
+			t = now_ns();
+			if (ioctl(kgsl_fd, IOCTL_KGSL_MAP_USER_MEM, &map)) {
+				fail("IOCTL_KGSL_MAP_USER_MEM");
+				break;
+			}
+			stat_add(&m, now_ns() - t);
+
+			unmap.gpuaddr = map.gpuaddr;
+
+			t = now_ns();
+			if (ioctl(kgsl_fd, IOCTL_KGSL_SHAREDMEM_FREE, &unmap)) {
+				fail("IOCTL_KGSL_SHAREDMEM_FREE");
+				break;
+			}
+			stat_add(&u, now_ns() - t);
+		}
+
+		munmap(buf, sizes[s]);
+
+		snprintf(param, sizeof(param), "size=%zu", sizes[s]);
+		stat_print("gpu_map_usermem", param, &m);
+		stat_print("gpu_unmap_usermem", param, &u);
+
+		if (gpumem_alloc(sizes[s], 0, &alloc)) {
+			fail("IOCTL_KGSL_GPUMEM_ALLOC_ID");
+			continue;
+		}
+
+		stat_init(&c);
+
+		for (i = 0; i < n; i++) {
+			volatile uint8_t *ptr;
+
+			t = now_ns();
+			ptr = mmap(NULL, alloc.mmapsize, PROT_READ | PROT_WRITE,
+				MAP_SHARED, kgsl_fd, (off_t)alloc.id * page_size);
+			if (ptr == MAP_FAILED) {
+				fail("mmap gpumem");
+				break;
+			}
+
+			for (off = 0; off < alloc.mmapsize; off += page_size)
+				ptr[off] = 0;
+
+			munmap((void *)ptr, alloc.mmapsize);
+			stat_add(&c, now_ns() - t);
+		}
+
+		gpumem_free(alloc.id);
+		stat_print("cpu_map_touch_unmap", param, &c);
+	}
+}
+
+static int wait_timestamp(unsigned int context, unsigned int timestamp)
+{
+	struct kgsl_device_waittimestamp_ctxtid wait = {
+		.context_id = context,
+		.timestamp = timestamp,
+		.timeout = WAIT_TIMEOUT,
+	};
+
+	return ioctl(kgsl_fd, IOCTL_KGSL_DEVICE_WAITTIMESTAMP_CTXTID, &wait);
+}
+
+static int submit_marker(unsigned int context, unsigned int *timestamp)
+{
+	struct kgsl_gpu_command cmd = {
+		.flags = KGSL_CMDBATCH_MARKER,
+		.context_id = context,
+	};
+
+	if (ioctl(kgsl_fd, IOCTL_KGSL_GPU_COMMAND, &cmd))
+		return -1;
+
+	*timestamp = cmd.timestamp;
+	return 0;
+}
+
+/*
+ * Drawobj submission rate through the dispatcher. Markers carry no IBs so
+ * this measures the kernel side of a submission and the retire path.
+ */
+static void bench_submit(void)
+{
+	struct kgsl_drawctxt_create create = {
+		.flags = KGSL_CONTEXT_NO_GMEM_ALLOC | KGSL_CONTEXT_PREAMBLE |
+			(KGSL_CONTEXT_TYPE_GL << KGSL_CONTEXT_TYPE_SHIFT),
+	};
+	struct kgsl_drawctxt_destroy destroy;
+	unsigned int timestamp = 0;
+	struct bench_stat s, r, b;
+	unsigned long i;
+	char param[64];
+	uint64_t t;
+
+	if (ioctl(kgsl_fd, IOCTL_KGSL_DRAWCTXT_CREATE, &create)) {
+		fail("IOCTL_KGSL_DRAWCTXT_CREATE");
+		return;
+	}
+
+	/* Back to back submissions, waiting only for the last one */
+	stat_init(&s);
+	stat_init(&b);
+
+	t = now_ns();
+	for (i = 0; i < iterations; i++) {
+		uint64_t t1 = now_ns();
+
+		if (submit_marker(create.drawctxt_id, &timestamp)) {
+			fail("IOCTL_KGSL_GPU_COMMAND");
+			break;
+		}
+		stat_add(&s, now_ns() - t1);
+	}
+
+	if (i && wait_timestamp(create.drawctxt_id, timestamp))
+		fail("IOCTL_KGSL_DEVICE_WAITTIMESTAMP_CTXTID");
+	else if (i)
+		stat_add(&b, (now_ns() - t) / i);
+
+	snprintf(param, sizeof(param), "marker");
+	stat_print("submit", param, &s);
+	stat_print("submit_batch_retire", param, &b);
+
+	/* Submit and wait for each one to retire */
+	stat_init(&r);
+
+	for (i = 0; i < iterations; i++) {
+		t = now_ns();
+		if (submit_marker(create.drawctxt_id, &timestamp)) {
+			fail("IOCTL_KGSL_GPU_COMMAND");
+			break;
+		}
+
+		if (wait_timestamp(create.drawctxt_id, timestamp)) {
+			fail("IOCTL_KGSL_DEVICE_WAITTIMESTAMP_CTXTID");
+			break;
+		}
+		stat_add(&r, now_ns() - t);
+	}
+
+	stat_print("submit_retire", param, &r);
+
+	destroy.drawctxt_id = create.drawctxt_id;
+	ioctl(kgsl_fd, IOCTL_KGSL_DRAWCTXT_DESTROY, &destroy);
+}
+
+static int timeline_create(unsigned int *id)
+{
+	struct kgsl_timeline_create create = { 0 };
+
+	if (ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_CREATE, &create))
+		return -1;
+
+	*id = create.id;
+	return 0;
+}
+
+static int timeline_signal(unsigned int id, uint64_t seqno)
+{
+	struct kgsl_timeline_val val = { .seqno = seqno, .timeline = id };
+	struct kgsl_timeline_signal signal = {
+		.timelines = (uint64_t)(uintptr_t)&val,
+		.count = 1,
+		.timelines_size = sizeof(val),
+	};
+
+	return ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_SIGNAL, &signal);
+}
+
+static int timeline_wait(unsigned int id, uint64_t seqno)
+{
+	struct kgsl_timeline_val val = { .seqno = seqno, .timeline = id };
+	struct kgsl_timeline_wait wait = {
+		.tv_sec = WAIT_TIMEOUT / 1000,
+		.timelines = (uint64_t)(uintptr_t)&val,
+		.count = 1,
+		.timelines_size = sizeof(val),
+		.flags = KGSL_TIMELINE_WAIT_ALL,
+	};
+
+	return ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_WAIT, &wait);
+}
+
+struct pong {
+	unsigned int ping, pong;
+	unsigned long count;
+	int ret;
+};
+
+/* Wait for each value on the ping timeline and echo it on the pong timeline */
+static void *pong_thread(void *data)
+{
+	struct pong *p = data;
+	unsigned long i;
+
+	for (i = 1; i <= p->count; i++) {
+		p->ret = timeline_wait(p->ping, i);
+		if (!p->ret)
+			p->ret = timeline_signal(p->pong, i);
+		if (p->ret)
+			break;
+	}
+
+	return NULL;
+}
+
+/*
+ * Timeline signal cost, signal to wakeup latency (half of a ping-pong round
+ * trip between two threads) and the cost of reading the timeline value
+ * with the query ioctl or from the shadow page if the kernel exports one.
+ */
+static void bench_timeline(void)
+{
+	struct kgsl_shadowprop shadow = { 0 };
+	struct kgsl_device_getproperty prop = {
+		.type = KGSL_PROP_TIMELINE_SHADOW,
+		.value = &shadow,
+		.sizebytes = sizeof(shadow),
+	};
+	struct bench_stat s, w, q;
+	struct pong p = { 0 };
+	pthread_t thread;
+	unsigned int id;
+	unsigned long i;
+	uint64_t t;
+
+	if (timeline_create(&id)) {
+		fail("IOCTL_KGSL_TIMELINE_CREATE");
+		return;
+	}
+
+	stat_init(&s);
+	for (i = 1; i <= iterations; i++) {
+		t = now_ns();
+		if (timeline_signal(id, i)) {
+			fail("IOCTL_KGSL_TIMELINE_SIGNAL");
+			break;
+		}
+		stat_add(&s, now_ns() - t);
+	}
+	stat_print("timeline_signal", "nowaiter", &s);
+
+	stat_init(&q);
+	for (i = 0; i < iterations; i++) {
+		struct kgsl_timeline_val val = { .timeline = id };
+
+		t = now_ns();
+		if (ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_QUERY, &val)) {
+			fail("IOCTL_KGSL_TIMELINE_QUERY");
+			break;
+		}
+		stat_add(&q, now_ns() - t);
+	}
+	stat_print("timeline_query", "ioctl", &q);
+
+	if (!ioctl(kgsl_fd, IOCTL_KGSL_DEVICE_GETPROPERTY, &prop) &&
+		(shadow.flags & KGSL_FLAGS_INITIALIZED) &&
+		id < shadow.size / sizeof(uint64_t)) {
+		volatile uint64_t *page;
+
+		page = mmap(NULL, shadow.size, PROT_READ, MAP_SHARED, kgsl_fd,
+			shadow.gpuaddr);
+		if (page != MAP_FAILED) {
+			stat_init(&q);
+			for (i = 0; i < iterations; i++) {
+				t = now_ns();
+				(void)page[id];
+				stat_add(&q, now_ns() - t);
+			}
+			munmap((void *)page, shadow.size);
+			stat_print("timeline_query", "shadow", &q);
+		} else {
+			fail("mmap timeline shadow");
+		}
+	}
+
+	ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_DESTROY, &id);
+
+	if (timeline_create(&p.ping) || timeline_create(&p.pong)) {
+		fail("IOCTL_KGSL_TIMELINE_CREATE");
+		return;
+	}
+
+	p.count = iterations;
+	if (pthread_create(&thread, NULL, pong_thread, &p)) {
+		printf("# %s: pthread_create failed\n", TEST_PREFIX);
+		failures++;
+		goto out;
+	}
+
+	stat_init(&w);
+	for (i = 1; i <= iterations; i++) {
+		t = now_ns();
+		if (timeline_signal(p.ping, i) || timeline_wait(p.pong, i)) {
+			fail("timeline ping-pong");
+			break;
+		}
+		stat_add(&w, (now_ns() - t) / 2);
+	}
+
+	/* Unblock the other thread if we bailed out early */
+	if (i <= iterations)
+		timeline_signal(p.ping, iterations);
+
+	pthread_join(thread, NULL);
+	stat_print("timeline_signal_wakeup", "pingpong", &w);
+
+out:
+	ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_DESTROY, &p.ping);
+	ioctl(kgsl_fd, IOCTL_KGSL_TIMELINE_DESTROY, &p.pong);
+}
+
+static unsigned int parse_tests(char *str)
+{
+	unsigned int tests = 0;
+	char *tok;
+
+	for (tok = strtok(str, ","); tok; tok = strtok(NULL, ",")) {
+		if (!strcmp(tok, "alloc"))
+			tests |= TEST_ALLOC;
+		else if (!strcmp(tok, "map"))
+			tests |= TEST_MAP;
+		else if (!strcmp(tok, "submit"))
+			tests |= TEST_SUBMIT;
+		else if (!strcmp(tok, "timeline"))
+			tests |= TEST_TIMELINE;
+		else
+			return 0;
+	}
+
+	return tests;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [-d device] [-n iterations] [-t tests]\n"
+		"  -d  kgsl device node (default /dev/kgsl-3d0)\n"
+		"  -n  iterations per measurement (default 1000)\n"
+		"  -t  comma separated list of alloc,map,submit,timeline\n",
+		name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *device = "/dev/kgsl-3d0";
+	unsigned int tests = TEST_ALL;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:n:t:h")) != -1) {
+		switch (c) {
+		case 'd':
+			device = optarg;
+			break;
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 't':
+			tests = parse_tests(optarg);
+			break;
+		default:
+			usage(argv[0]);
+			return c == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!iterations || !tests) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	page_size = sysconf(_SC_PAGESIZE);
+
+	kgsl_fd = open(device, O_RDWR);
+	if (kgsl_fd < 0) {
+		printf("%s: [skip,no-kgsl]\n", TEST_PREFIX);
+		return KSFT_SKIP;
+	}
+
+	printf("# %s iterations=%lu\n", TEST_PREFIX, iterations);
+	printf("test,param,iterations,avg_ns,min_ns,max_ns,ops_per_sec\n");
+
+	if (tests & TEST_ALLOC)
+		bench_alloc();
+	if (tests & TEST_MAP)
+		bench_map();
+	if (tests & TEST_SUBMIT)
+		bench_submit();
+	if (tests & TEST_TIMELINE)
+		bench_timeline();
+
+	close(kgsl_fd);
+
+	if (failures) {
+		printf("%s: [FAIL,%d errors]\n", TEST_PREFIX, failures);
+		return 1;
+	}
+
+	printf("%s: [PASS]\n", TEST_PREFIX);
+	return 0;
+}